@@ -97,6 +97,16 @@ void CleanupTextures()
 	s_textures.clear();
 }
 
+const std::vector<std::shared_ptr<void>>& GetTextures()
+{
+	return s_textures;
+}
+
+void KeepTexture(const std::shared_ptr<void>& texture)
+{
+	s_textures.push_back(texture);
+}
+
 bool ImageButtonWithAspectAndTextDOWN(texture_info info, const std::string& name, const ImVec2& texture_size,
 									  const ImVec2& image_size, const ImVec2& _uv0, const ImVec2& _uv1,
 									  int frame_padding, const ImVec4& bg_col, const ImVec4& tint_col)
@@ -8,12 +8,17 @@
 #include "imgui_user/imgui_user.h"
 #include "imguizmo/imguizmo.h"
 #include <memory>
+#include <vector>
 namespace gui
 {
 using namespace ImGui;
 
 void CleanupTextures();
 
+// The textures drawn since the last cleanup, kept alive until the next one.
+const std::vector<std::shared_ptr<void>>& GetTextures();
+void KeepTexture(const std::shared_ptr<void>& texture);
+
 struct texture_info
 {
 	std::shared_ptr<void> texture;
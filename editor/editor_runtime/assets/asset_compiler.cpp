@@ -1,16 +1,25 @@
 #include "asset_compiler.h"
 #include "asset_extensions.h"
+#include "build_cache.h"
+#include "import_settings.h"
 #include "mesh_importer.h"
+#include "shared_cache.h"
 
+#include <bimg/bimg.h>
+#include <bimg/decode.h>
+#include <bx/allocator.h>
 #include <bx/error.h>
+#include <bx/file.h>
 #include <bx/process.h>
 #include <bx/string.h>
 
 #include <core/audio/loaders/loader.h>
 #include <core/audio/sound.h>
+#include <core/filesystem/archive.h>
 #include <core/filesystem/filesystem.h>
 #include <core/graphics/graphics.h>
 #include <core/graphics/shader.h>
+#include <core/graphics/shader_pack.h>
 #include <core/graphics/texture.h>
 #include <core/logging/logging.h>
 #include <core/serialization/associative_archive.h>
@@ -22,23 +31,166 @@
 #include <core/string_utils/string_utils.h>
 #include <core/uuid/uuid.hpp>
 
+#include <runtime/assets/asset_manifest.h>
+#include <runtime/assets/flat_animation.h>
+#include <runtime/assets/flat_mesh.h>
 #include <runtime/ecs/constructs/prefab.h>
 #include <runtime/ecs/constructs/scene.h>
+#include <runtime/ecs/constructs/utils.h>
 #include <runtime/meta/animation/animation.hpp>
 #include <runtime/meta/audio/sound.hpp>
 #include <runtime/meta/rendering/material.hpp>
 #include <runtime/meta/rendering/mesh.hpp>
+#include <runtime/meta/rendering/standard_material.hpp>
+#include <runtime/rendering/texture_arrays.h>
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
 #include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <tuple>
 
 namespace asset_compiler
 {
+/// bumped when what the compilers in here write changes
+constexpr std::uint32_t compiler_version = 7;
+
+/// the faces of every simplified level of detail of a mesh to those of the mesh
+constexpr std::array<float, 3> mesh_lod_ratios = {{0.5f, 0.25f, 0.125f}};
+
+/// the fewest faces a simplified level of detail is made for
+constexpr std::uint32_t mesh_lod_min_faces = 256;
+
+/// oggs at least this long are kept compressed and decoded while they play, in seconds
+constexpr double stream_min_duration = 10.0;
+
+// copies the compiled temp next to the output and renames it over the old
+// one, a reader that has the old output mapped keeps it whole
+static void replace_output(const fs::path& temp, const fs::path& output)
+{
+	fs::error_code err;
+	fs::path part = output;
+	part += "." + uuids::random_uuid().to_string() + ".part";
+	if(!fs::copy_file(temp, part, fs::copy_options::overwrite_existing, err) || err)
+	{
+		APPLOG_ERROR("Failed writing {0} with error: {1}", output.string(), err.message());
+		fs::remove(part, err);
+		return;
+	}
+
+	fs::rename(part, output, err);
+	if(err)
+	{
+		APPLOG_ERROR("Failed writing {0} with error: {1}", output.string(), err.message());
+		fs::remove(part, err);
+	}
+}
+
 static std::string escape_str(const std::string& str)
 {
 	return "\"" + str + "\"";
 }
 
+// the cache of an output compiled from the asset and its meta
+static build_cache get_build_cache(const fs::path& absolute_meta_key, const fs::path& absolute_key,
+								   const fs::path& output, const std::string& settings = {},
+								   std::vector<fs::path> inputs = {})
+{
+	inputs.insert(std::begin(inputs), {absolute_key, absolute_meta_key});
+	return build_cache(output, std::move(inputs), std::to_string(compiler_version) + " " + settings);
+}
+
+// the hash of the contents of a tool next to the executable, once per run
+static std::string get_tool_hash(const std::string& process)
+{
+	static std::mutex mutex;
+	static std::map<std::string, std::uint64_t> hashes;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = hashes.find(process);
+	if(it == std::end(hashes))
+	{
+		const auto hash = build_cache::hash_file(fs::resolve_protocol("binary:/") / process);
+		it = hashes.emplace(process, hash).first;
+	}
+	return process + " " + std::to_string(it->second);
+}
+
+// copies the output compiled elsewhere from the same contents and settings
+static bool fetch_shared(build_cache& cache, std::uint64_t key, const fs::path& output,
+						 const std::string& str_input)
+{
+	if(!shared_cache::fetch(key, output))
+	{
+		return false;
+	}
+
+	cache.store();
+	APPLOG_INFO("Fetched {0} from the shared cache", str_input);
+	return true;
+}
+
+/*
+ * process_slot; one of the compile processes that may run at once, the
+ * compilations past those wait for one to end instead of all running
+ * their process together.
+ */
+class process_slot
+{
+public:
+	process_slot()
+	{
+		std::unique_lock<std::mutex> lock(get_mutex());
+		get_cv().wait(lock, []() { return get_used() < get_max(); });
+		++get_used();
+	}
+
+	~process_slot()
+	{
+		{
+			std::lock_guard<std::mutex> lock(get_mutex());
+			--get_used();
+		}
+		get_cv().notify_one();
+	}
+
+	process_slot(const process_slot&) = delete;
+	process_slot& operator=(const process_slot&) = delete;
+
+private:
+	static std::size_t get_max()
+	{
+		static const std::size_t max = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+		return max;
+	}
+
+	static std::size_t& get_used()
+	{
+		static std::size_t used = 0;
+		return used;
+	}
+
+	static std::mutex& get_mutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	static std::condition_variable& get_cv()
+	{
+		static std::condition_variable cv;
+		return cv;
+	}
+};
+
 static bool run_compile_process(const std::string& process, const std::vector<std::string>& args_array,
 								std::string& err)
 {
@@ -60,6 +212,7 @@ static bool run_compile_process(const std::string& process, const std::vector<st
 			args += " ";
 	}
 
+	process_slot slot;
 	bx::Error error;
 	bx::ProcessReader process_reader;
 
@@ -98,6 +251,180 @@ static bool run_compile_process(const std::string& process, const std::vector<st
 	}
 }
 
+// the variants a shader source declares, e.g. the lines
+//     // variants: SKINNED INSTANCED ALPHA_TEST
+//     // exclusive: SKINNED INSTANCED
+// for the three features and their combinations but those with both of the
+// exclusive ones
+struct shader_manifest
+{
+	std::vector<std::string> features;
+	std::vector<std::uint32_t> exclusive;
+};
+
+/// the most features of a manifest, their combinations are compiled
+constexpr std::size_t shader_max_features = 8;
+
+static shader_manifest read_shader_manifest(const fs::path& source)
+{
+	shader_manifest manifest;
+	std::ifstream stream(source.string());
+	std::vector<std::vector<std::string>> exclusive;
+	std::string line;
+	while(std::getline(stream, line))
+	{
+		std::istringstream words(line);
+		std::string comment;
+		std::string tag;
+		if(!(words >> comment >> tag) || comment != "//" || (tag != "variants:" && tag != "exclusive:"))
+		{
+			continue;
+		}
+
+		std::vector<std::string> names;
+		std::string name;
+		while(words >> name)
+		{
+			names.emplace_back(std::move(name));
+		}
+		if(tag == "variants:")
+		{
+			manifest.features.insert(std::end(manifest.features), std::begin(names), std::end(names));
+		}
+		else
+		{
+			exclusive.emplace_back(std::move(names));
+		}
+	}
+
+	if(manifest.features.size() > shader_max_features)
+	{
+		APPLOG_WARNING("Shader {0} declares more than {1} variant features, the rest are ignored.",
+					   source.string(), shader_max_features);
+		manifest.features.resize(shader_max_features);
+	}
+	for(const auto& names : exclusive)
+	{
+		std::uint32_t mask = 0;
+		for(const auto& name : names)
+		{
+			auto it = std::find(std::begin(manifest.features), std::end(manifest.features), name);
+			if(it != std::end(manifest.features))
+			{
+				mask |= 1u << std::distance(std::begin(manifest.features), it);
+			}
+		}
+		manifest.exclusive.push_back(mask);
+	}
+	return manifest;
+}
+
+// the features the materials of the project use, all of them when the
+// project does not list them
+static bool read_used_shader_features(std::set<std::string>& used)
+{
+	const auto key = fs::resolve_protocol("app:/settings/shader_features");
+	std::ifstream stream(key.string());
+	if(fs::resolve_protocol("app:/").empty() || !stream.is_open())
+	{
+		return false;
+	}
+	std::string name;
+	while(stream >> name)
+	{
+		used.insert(name);
+	}
+	return true;
+}
+
+// the masks of the variants to compile, the exclusive features never together
+// and those nothing uses pruned
+static std::vector<std::uint32_t> get_shader_permutations(const shader_manifest& manifest,
+														  const std::set<std::string>* used)
+{
+	std::uint32_t allowed = 0;
+	for(std::size_t i = 0; i < manifest.features.size(); ++i)
+	{
+		if(used == nullptr || used->count(manifest.features[i]) > 0)
+		{
+			allowed |= 1u << i;
+		}
+	}
+
+	std::vector<std::uint32_t> masks;
+	const auto count = std::uint32_t(1) << manifest.features.size();
+	for(std::uint32_t mask = 0; mask < count; ++mask)
+	{
+		const bool excluded = (mask & ~allowed) != 0 ||
+							  std::any_of(std::begin(manifest.exclusive), std::end(manifest.exclusive),
+										  [mask](std::uint32_t exclusive) {
+											  const auto both = mask & exclusive;
+											  return (both & (both - 1)) != 0;
+										  });
+		if(!excluded)
+		{
+			masks.push_back(mask);
+		}
+	}
+	return masks;
+}
+
+// the defines of a variant separated by ';', as shaderc takes them
+static std::string get_shader_defines(const shader_manifest& manifest, std::uint32_t mask)
+{
+	std::string defines;
+	for(std::size_t i = 0; i < manifest.features.size(); ++i)
+	{
+		if(mask & (1u << i))
+		{
+			defines += (defines.empty() ? "" : ";") + manifest.features[i];
+		}
+	}
+	return defines;
+}
+
+// compiles every variant and packs them into the output
+static bool compile_shader_variants(const shader_manifest& manifest, const std::vector<std::uint32_t>& masks,
+									const std::vector<std::string>& args_array, const fs::path& temp,
+									std::string& error)
+{
+	std::vector<gfx::shader_pack::variant> variants;
+	for(const auto mask : masks)
+	{
+		fs::error_code err;
+		fs::path variant_temp = temp;
+		variant_temp += "." + std::to_string(mask);
+		auto args = args_array;
+		// the output is the argument after -o
+		auto it = std::find(std::begin(args), std::end(args), "-o");
+		*std::next(it) = variant_temp.string();
+		const auto defines = get_shader_defines(manifest, mask);
+		if(!defines.empty())
+		{
+			args.insert(std::end(args), {"--define", defines});
+		}
+		{
+			std::ofstream output_file(variant_temp.string());
+			(void)output_file;
+		}
+
+		const bool compiled = run_compile_process("shaderc", args, error);
+		std::ifstream stream(variant_temp.string(), std::ios::in | std::ios::binary);
+		std::vector<char> binary((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+		stream.close();
+		fs::remove(variant_temp, err);
+		if(!compiled)
+		{
+			error = "variant '" + defines + "': " + error;
+			return false;
+		}
+		variants.emplace_back(mask, std::move(binary));
+	}
+
+	std::ofstream stream(temp.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+	return gfx::shader_pack::write(stream, manifest.features, variants);
+}
+
 template <>
 void compile<gfx::shader>(const fs::path& absolute_meta_key, const fs::path& output)
 {
@@ -167,25 +494,248 @@ void compile<gfx::shader>(const fs::path& absolute_meta_key, const fs::path& out
 		"--platform", str_platform, "-p", str_profile, "--type", str_type,	"-O",			  "3",
 	};
 
-	std::string error;
+	const auto manifest = read_shader_manifest(absolute_key);
+	std::set<std::string> used;
+	const bool listed = !manifest.features.empty() && read_used_shader_features(used);
+	const auto masks = get_shader_permutations(manifest, listed ? &used : nullptr);
+	std::string variant_settings;
+	for(const auto mask : masks)
+	{
+		variant_settings += " variant " + get_shader_defines(manifest, mask);
+	}
 
+	// the includes by their size and time, they are not hashed
+	std::string settings = build_cache::get_tool_settings("shaderc") + variant_settings;
+	for(const auto& arg : args_array)
+	{
+		settings += " " + arg;
+	}
+	fs::recursive_directory_iterator includes(include, err);
+	for(const auto& entry : includes)
 	{
-		std::ofstream output_file(str_output);
-		(void)output_file;
+		const auto& p = entry.path();
+		settings += " " + p.generic_string() + " " + std::to_string(fs::file_size(p, err)) + " " +
+					std::to_string(fs::last_write_time(p, err).time_since_epoch().count());
 	}
 
-	if(!run_compile_process("shaderc", args_array, error))
+	auto cache = get_build_cache(absolute_meta_key, absolute_key, output, settings, {varying});
+	if(cache.is_up_to_date())
+	{
+		APPLOG_TRACE("Up to date {0}", str_input);
+		return;
+	}
+
+	// without the paths, and the includes by their contents in order
+	const bool shared = shared_cache::is_enabled();
+	std::uint64_t shared_key = 0;
+	if(shared)
+	{
+		std::string shared_settings = std::to_string(compiler_version) + " " + get_tool_hash("shaderc") +
+									  " " + str_platform + " " + str_profile + " " + str_type + " -O 3" +
+									  variant_settings;
+		std::set<std::string> include_files;
+		for(const auto& entry : fs::recursive_directory_iterator(include, err))
+		{
+			include_files.insert(fs::relative(entry.path(), include, err).generic_string());
+		}
+		std::uint64_t includes_hash = 0;
+		for(const auto& file : include_files)
+		{
+			includes_hash = build_cache::hash_file(include / file, includes_hash);
+		}
+		shared_settings += " " + std::to_string(includes_hash);
+
+		shared_key = cache.get_shared_key(shared_settings);
+		if(fetch_shared(cache, shared_key, output, str_input))
+		{
+			return;
+		}
+	}
+
+	std::string error;
+	bool compiled = false;
+	if(manifest.features.empty())
+	{
+		{
+			std::ofstream output_file(str_output);
+			(void)output_file;
+		}
+		compiled = run_compile_process("shaderc", args_array, error);
+	}
+	else
+	{
+		compiled = compile_shader_variants(manifest, masks, args_array, temp, error);
+	}
+
+	if(!compiled)
 	{
 		APPLOG_ERROR("Failed compilation of {0} with error: {1}", str_input, error);
 	}
 	else
 	{
 		APPLOG_INFO("Successful compilation of {0}", str_input);
-		fs::copy_file(temp, output, fs::copy_options::overwrite_existing, err);
+		replace_output(temp, output);
+		cache.store();
+		if(shared)
+		{
+			shared_cache::store(shared_key, output);
+		}
 	}
 	fs::remove(temp, err);
 }
 
+// the box filter of 2x2 bgra8 pixels into one, the last row or column of an
+// odd size repeated. The colors are srgb and are averaged linear, as
+// texturec does, so the mips keep the brightness of the image. The alpha
+// is averaged as it is.
+static void downsample_bgra8(const std::uint8_t* src, std::uint32_t src_width, std::uint32_t src_height,
+							 std::uint8_t* dst, std::uint32_t dst_width, std::uint32_t dst_height)
+{
+	static const auto to_linear = []() {
+		std::array<float, 256> table;
+		for(std::size_t i = 0; i < table.size(); ++i)
+		{
+			const float c = float(i) / 255.0f;
+			table[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+		return table;
+	}();
+	const auto to_srgb = [](float c) {
+		const float g = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+		return std::uint8_t(std::min(std::max(g, 0.0f), 1.0f) * 255.0f + 0.5f);
+	};
+
+	for(std::uint32_t y = 0; y < dst_height; ++y)
+	{
+		const std::uint32_t rows[2] = {std::min(y * 2, src_height - 1), std::min(y * 2 + 1, src_height - 1)};
+		for(std::uint32_t x = 0; x < dst_width; ++x)
+		{
+			const std::uint32_t columns[2] = {std::min(x * 2, src_width - 1),
+											  std::min(x * 2 + 1, src_width - 1)};
+			float colors[3] = {0.0f, 0.0f, 0.0f};
+			std::uint32_t alpha = 2;
+			for(auto row : rows)
+			{
+				for(auto column : columns)
+				{
+					const auto pixel = src + (row * src_width + column) * 4;
+					for(std::uint32_t c = 0; c < 3; ++c)
+					{
+						colors[c] += to_linear[pixel[c]];
+					}
+					alpha += pixel[3];
+				}
+			}
+
+			const auto pixel = dst + (y * dst_width + x) * 4;
+			for(std::uint32_t c = 0; c < 3; ++c)
+			{
+				pixel[c] = to_srgb(colors[c] * 0.25f);
+			}
+			pixel[3] = std::uint8_t(alpha / 4);
+		}
+	}
+}
+
+// the arguments of texturec for the settings, after those of the files
+static std::vector<std::string> get_texture_options(const texture_import_settings& import,
+													 const texture_platform_settings& platform)
+{
+	static const std::array<const char*, 7> formats = {
+		{"BGRA8", "BC1", "BC3", "BC5", "BC7", "ETC2", "ETC2A"}};
+	static const std::array<const char*, 3> qualities = {{"f", "d", "h"}};
+
+	std::vector<std::string> options;
+	if(import.mips != mip_filter::none)
+	{
+		options.emplace_back("-m");
+	}
+	if(import.mips == mip_filter::box_linear)
+	{
+		options.emplace_back("--linear");
+	}
+	if(import.normal_map)
+	{
+		options.emplace_back("-n");
+	}
+	options.emplace_back("-t");
+	options.emplace_back(formats[std::size_t(platform.compression)]);
+	if(platform.quality != texture_quality::standard)
+	{
+		options.emplace_back("-q");
+		options.emplace_back(qualities[std::size_t(platform.quality)]);
+	}
+	if(platform.max_size > 0)
+	{
+		options.emplace_back("--max");
+		options.emplace_back(std::to_string(platform.max_size));
+	}
+	return options;
+}
+
+// what texturec does for an uncompressed texture with a box filter, on the
+// calling thread instead of in a process. Only for 2d images, handled is
+// false for the others and for what bimg cannot parse.
+static bool compile_texture_in_process(const fs::path& input, const fs::path& output, bool mips,
+									   bool& handled, std::string& error)
+{
+	handled = false;
+	std::ifstream stream(input.string(), std::ios::in | std::ios::binary);
+	if(!stream.is_open())
+	{
+		return false;
+	}
+	const auto data = fs::read_stream(stream);
+
+	bx::DefaultAllocator allocator;
+	bx::Error err;
+	auto image = bimg::imageParse(&allocator, data.data(), std::uint32_t(data.size()),
+								  bimg::TextureFormat::BGRA8, &err);
+	if(image == nullptr)
+	{
+		return false;
+	}
+	if(image->m_cubeMap || image->m_depth > 1 || image->m_numLayers > 1)
+	{
+		bimg::imageFree(image);
+		return false;
+	}
+	handled = true;
+
+	auto texture = bimg::imageAlloc(&allocator, bimg::TextureFormat::BGRA8, std::uint16_t(image->m_width),
+									std::uint16_t(image->m_height), 1, 1, false, mips);
+	bimg::ImageMip src;
+	bimg::ImageMip dst;
+	bimg::imageGetRawData(*image, 0, 0, image->m_data, image->m_size, src);
+	bimg::imageGetRawData(*texture, 0, 0, texture->m_data, texture->m_size, dst);
+	std::memcpy(const_cast<std::uint8_t*>(dst.m_data), src.m_data, std::min(src.m_size, dst.m_size));
+	bimg::imageFree(image);
+
+	for(std::uint8_t lod = 1; lod < texture->m_numMips; ++lod)
+	{
+		bimg::imageGetRawData(*texture, 0, lod - 1, texture->m_data, texture->m_size, src);
+		bimg::imageGetRawData(*texture, 0, lod, texture->m_data, texture->m_size, dst);
+		downsample_bgra8(src.m_data, src.m_width, src.m_height, const_cast<std::uint8_t*>(dst.m_data),
+						 dst.m_width, dst.m_height);
+	}
+
+	bx::FileWriter writer;
+	bool written = bx::open(&writer, output.string().c_str(), false, &err);
+	if(written)
+	{
+		bimg::imageWriteKtx(&writer, *texture, texture->m_data, texture->m_size, &err);
+		bx::close(&writer);
+		written = err.isOk();
+	}
+	bimg::imageFree(texture);
+
+	if(!written)
+	{
+		error = std::string(err.getMessage().getPtr());
+	}
+	return written;
+}
+
 template <>
 void compile<gfx::texture>(const fs::path& absolute_meta_key, const fs::path& output)
 {
@@ -200,25 +750,72 @@ void compile<gfx::texture>(const fs::path& absolute_meta_key, const fs::path& ou
 
 	std::string str_output = temp.string();
 
-	const std::vector<std::string> args_array = {
-		"-f", str_input, "-o", str_output, "--as", "ktx", "-m", "-t", "BGRA8",
-	};
+	texture_import_settings import;
+	import_settings::load(absolute_meta_key, import);
+	const auto& platform = import.get(import_settings::get_target_platform());
+	const auto options = get_texture_options(import, platform);
+	std::vector<std::string> args_array = {"-f", str_input, "-o", str_output, "--as", "ktx"};
+	args_array.insert(std::end(args_array), std::begin(options), std::end(options));
 
-	std::string error;
+	// either of the in process compilation and texturec may write it
+	auto bimg_version = " bimg " + std::to_string(BIMG_API_VERSION) + " ktx";
+	for(const auto& option : options)
+	{
+		bimg_version += " " + option;
+	}
+	const auto settings = build_cache::get_tool_settings("texturec") + bimg_version;
+	auto cache = get_build_cache(absolute_meta_key, absolute_key, output, settings);
+	if(cache.is_up_to_date())
+	{
+		APPLOG_TRACE("Up to date {0}", str_input);
+		return;
+	}
+
+	const bool shared = shared_cache::is_enabled();
+	std::uint64_t shared_key = 0;
+	if(shared)
+	{
+		const auto tool = get_tool_hash("texturec");
+		shared_key = cache.get_shared_key(std::to_string(compiler_version) + " " + tool + bimg_version);
+		if(fetch_shared(cache, shared_key, output, str_input))
+		{
+			return;
+		}
+	}
 
+	std::string error;
+	bool handled = false;
+	bool compiled = false;
+	// what the box filter in here does not do is left to texturec
+	const bool in_process = platform.compression == texture_compression::none && platform.max_size == 0 &&
+							!import.normal_map && import.mips != mip_filter::box_linear;
+	if(in_process)
 	{
-		std::ofstream output_file(str_output);
-		(void)output_file;
+		const bool mips = import.mips == mip_filter::box;
+		compiled = compile_texture_in_process(absolute_key, temp, mips, handled, error);
+	}
+	if(!handled)
+	{
+		{
+			std::ofstream output_file(str_output);
+			(void)output_file;
+		}
+		compiled = run_compile_process("texturec", args_array, error);
 	}
 
-	if(!run_compile_process("texturec", args_array, error))
+	if(!compiled)
 	{
 		APPLOG_ERROR("Failed compilation of {0} with error: {1}", str_input, error);
 	}
 	else
 	{
 		APPLOG_INFO("Successful compilation of {0}", str_input);
-		fs::copy_file(temp, output, fs::copy_options::overwrite_existing, err);
+		replace_output(temp, output);
+		cache.store();
+		if(shared)
+		{
+			shared_cache::store(shared_key, output);
+		}
 	}
 	fs::remove(temp, err);
 }
@@ -232,6 +829,13 @@ void compile<mesh>(const fs::path& absolute_meta_key, const fs::path& output)
 	absolute_key.replace_extension();
 	std::string str_input = absolute_key.string();
 
+	auto cache = get_build_cache(absolute_meta_key, absolute_key, output);
+	if(cache.is_up_to_date())
+	{
+		APPLOG_TRACE("Up to date {0}", str_input);
+		return;
+	}
+
 	fs::path temp = fs::temp_directory_path(err);
 	temp /= uuids::random_uuid(str_input).to_string() + ".buildtemp";
 
@@ -245,15 +849,50 @@ void compile<mesh>(const fs::path& absolute_meta_key, const fs::path& output)
 
 	if(!data.vertex_data.empty())
 	{
+		// a skin splits the triangles by their bones when loaded, so only
+		// rigid meshes are culled by cluster
+		const auto write_mesh = [&](const fs::path& mesh_output) {
+			if(!data.skin_data.has_bones())
+			{
+				mesh::build_clusters(data);
+			}
+
+			{
+				std::ofstream soutput(temp.string(), std::ios::out | std::ios::binary);
+				runtime::flat_mesh::write(soutput, data);
+			}
+			replace_output(temp, mesh_output);
+			fs::remove(temp, err);
+		};
+
+		// the levels of detail are simplified each from the one before, after
+		// the mesh is written, and are found by the count it is written with
+		const auto faces = std::uint32_t(data.triangle_data.size());
+		data.lod_count = 0;
+		for(const auto ratio : mesh_lod_ratios)
 		{
-			std::ofstream soutput(temp.string(), std::ios::out | std::ios::binary);
-			cereal::oarchive_binary_t ar(soutput);
-			try_save(ar, cereal::make_nvp("mesh", data));
+			if(std::uint32_t(float(faces) * ratio) >= mesh_lod_min_faces)
+			{
+				data.lod_count++;
+			}
 		}
-		fs::copy_file(temp, output, fs::copy_options::overwrite_existing, err);
-		fs::remove(temp, err);
-
+		write_mesh(output);
 		APPLOG_INFO("Successful compilation of {0}", str_input);
+
+		const auto lod_count = data.lod_count;
+		data.lod_count = 0;
+		for(std::uint32_t lod = 1; lod <= lod_count; ++lod)
+		{
+			const auto target = std::uint32_t(float(faces) * mesh_lod_ratios[lod - 1]);
+			const auto lod_faces = mesh::simplify(data, target);
+			fs::path lod_output = output;
+			lod_output.replace_extension();
+			lod_output += "_lod" + std::to_string(lod) + output.extension().string();
+			write_mesh(lod_output);
+
+			APPLOG_INFO("Successful compilation of {0} level of detail {1} with {2} faces", str_input, lod,
+						lod_faces);
+		}
 	}
 	{
 		fs::path file = absolute_key.stem();
@@ -270,12 +909,13 @@ void compile<mesh>(const fs::path& absolute_meta_key, const fs::path& output)
 			}
 			fs::path anim_output = (dir / file).string() + "_" + animation.name + ".anim";
 
-			fs::copy_file(temp, anim_output, fs::copy_options::overwrite_existing, err);
+			replace_output(temp, anim_output);
 			fs::remove(temp, err);
 
 			APPLOG_INFO("Successful compilation of animation {0}", animation.name);
 		}
 	}
+	cache.store();
 }
 
 template <>
@@ -287,6 +927,18 @@ void compile<runtime::animation>(const fs::path& absolute_meta_key, const fs::pa
 	absolute_key.replace_extension();
 	std::string str_input = absolute_key.string();
 
+	const runtime::animation_compression compression{};
+	const auto settings = std::to_string(runtime::flat_animation::version) + " " +
+						  std::to_string(compression.position_error) + " " +
+						  std::to_string(compression.rotation_error) + " " +
+						  std::to_string(compression.scaling_error);
+	auto cache = get_build_cache(absolute_meta_key, absolute_key, output, settings);
+	if(cache.is_up_to_date())
+	{
+		APPLOG_TRACE("Up to date {0}", str_input);
+		return;
+	}
+
 	bool has_loaded = false;
 	runtime::animation anim;
 	{
@@ -303,14 +955,20 @@ void compile<runtime::animation>(const fs::path& absolute_meta_key, const fs::pa
 
 	if(has_loaded)
 	{
-		std::ofstream stream(output.string(), std::ios::binary);
-		if(stream.good())
-		{
-			cereal::oarchive_binary_t ar(stream);
+		anim.clip = runtime::animation_clip::build(anim, compression);
 
-			try_save(ar, cereal::make_nvp("animation", anim));
+		std::size_t keys = 0;
+		for(const auto& channel : anim.channels)
+		{
+			keys += channel.position_keys.size() + channel.rotation_keys.size() + channel.scaling_keys.size();
+		}
 
-			APPLOG_INFO("Successful compilation of {0}", str_input);
+		std::ofstream stream(output.string(), std::ios::binary);
+		if(stream.good() && runtime::flat_animation::write(stream, anim))
+		{
+			cache.store();
+			APPLOG_INFO("Successful compilation of {0}, {1} of {2} keys kept", str_input,
+						anim.clip.times.size(), keys);
 		}
 	}
 }
@@ -325,6 +983,13 @@ void compile<audio::sound>(const fs::path& absolute_meta_key, const fs::path& ou
 
 	std::string str_input = absolute_key.string();
 
+	auto cache = get_build_cache(absolute_meta_key, absolute_key, output);
+	if(cache.is_up_to_date())
+	{
+		APPLOG_TRACE("Up to date {0}", str_input);
+		return;
+	}
+
 	fs::path temp = fs::temp_directory_path(err);
 	temp /= uuids::random_uuid(str_input).to_string() + ".buildtemp";
 
@@ -344,11 +1009,22 @@ void compile<audio::sound>(const fs::path& absolute_meta_key, const fs::path& ou
 	if(ext == ".ogg")
 	{
 		std::string load_err;
-		if(!audio::load_ogg_from_memory(file_data.data(), file_data.size(), data, load_err))
+		if(!audio::open_ogg_from_memory(file_data.data(), file_data.size(), data, load_err))
 		{
 			APPLOG_ERROR("Failed compilation of {0} with error : {1}", str_input, load_err);
 			return;
 		}
+
+		// short sounds are decoded once, they start at once and play on many sources
+		if(data.info.get_duration() < stream_min_duration)
+		{
+			data.encoded.clear();
+			if(!audio::load_ogg_from_memory(file_data.data(), file_data.size(), data, load_err))
+			{
+				APPLOG_ERROR("Failed compilation of {0} with error : {1}", str_input, load_err);
+				return;
+			}
+		}
 	}
 	else if(ext == ".wav")
 	{
@@ -370,8 +1046,9 @@ void compile<audio::sound>(const fs::path& absolute_meta_key, const fs::path& ou
 		cereal::oarchive_binary_t ar(soutput);
 		try_save(ar, cereal::make_nvp("sound", data));
 	}
-	fs::copy_file(temp, output, fs::copy_options::overwrite_existing, err);
+	replace_output(temp, output);
 	fs::remove(temp, err);
+	cache.store();
 
 	APPLOG_INFO("Successful compilation of {0}", str_input);
 }
@@ -385,6 +1062,13 @@ void compile<material>(const fs::path& absolute_meta_key, const fs::path& output
 	absolute_key.replace_extension();
 	std::string str_input = absolute_key.string();
 
+	auto cache = get_build_cache(absolute_meta_key, absolute_key, output);
+	if(cache.is_up_to_date())
+	{
+		APPLOG_TRACE("Up to date {0}", str_input);
+		return;
+	}
+
 	std::shared_ptr<::material> material;
 	{
 		std::ifstream stream(absolute_key.string());
@@ -404,31 +1088,390 @@ void compile<material>(const fs::path& absolute_meta_key, const fs::path& output
 			cereal::oarchive_binary_t ar(stream);
 
 			try_save(ar, cereal::make_nvp("material", material));
+			cache.store();
 
 			APPLOG_INFO("Successful compilation of {0}", str_input);
 		}
 	}
 }
 
-template <>
-void compile<prefab>(const fs::path& absolute_meta_key, const fs::path& output)
+/// the most layers of an array the compiler writes, bgfx backends take as many
+constexpr std::size_t texture_array_max_layers = 256;
+
+// the compiled images of the maps of a size, format and mips, packed in arrays
+struct texture_array_group
+{
+	std::vector<std::string> keys;
+	std::vector<bimg::ImageContainer*> images;
+};
+
+// the keys of the color and normal maps of the standard materials of the
+// project, those with a virtual color map left out
+static std::set<std::string> find_array_maps()
+{
+	std::set<std::string> keys;
+	fs::error_code err;
+	const auto data_dir = fs::resolve_protocol("app:/data");
+	for(const auto& entry : fs::recursive_directory_iterator(data_dir, err))
+	{
+		const auto& file_path = entry.path();
+		if(!fs::is_regular_file(file_path, err) || !ex::is_format<material>(file_path.extension().string()))
+		{
+			continue;
+		}
+
+		std::shared_ptr<::material> loaded;
+		{
+			std::ifstream stream(file_path.string());
+			if(!stream.good())
+			{
+				continue;
+			}
+			cereal::iarchive_associative_t ar(stream);
+			try_load(ar, cereal::make_nvp("material", loaded));
+		}
+
+		auto standard = std::dynamic_pointer_cast<standard_material>(loaded);
+		if(!standard || standard->get_virtual_color_map())
+		{
+			continue;
+		}
+		const auto color = standard->get_color_map();
+		const auto normal = standard->get_normal_map();
+		if(color && normal)
+		{
+			keys.insert(color.id());
+			keys.insert(normal.id());
+		}
+	}
+	return keys;
+}
+
+static bool write_texture_array(const texture_array_group& group, std::size_t begin, std::size_t end,
+								const fs::path& output, std::string& error)
+{
+	const auto& first = *group.images[begin];
+	bx::DefaultAllocator allocator;
+	bx::Error err;
+	auto texture = bimg::imageAlloc(&allocator, first.m_format, std::uint16_t(first.m_width),
+									std::uint16_t(first.m_height), 1, std::uint16_t(end - begin), false,
+									first.m_numMips > 1);
+	for(auto i = begin; i < end; ++i)
+	{
+		const auto& image = *group.images[i];
+		const auto layer = std::uint16_t(i - begin);
+		const auto mips = std::min(image.m_numMips, texture->m_numMips);
+		for(std::uint8_t lod = 0; lod < mips; ++lod)
+		{
+			bimg::ImageMip src;
+			bimg::ImageMip dst;
+			bimg::imageGetRawData(image, 0, lod, image.m_data, image.m_size, src);
+			bimg::imageGetRawData(*texture, layer, lod, texture->m_data, texture->m_size, dst);
+			std::memcpy(const_cast<std::uint8_t*>(dst.m_data), src.m_data, std::min(src.m_size, dst.m_size));
+		}
+	}
+
+	bx::FileWriter writer;
+	bool written = bx::open(&writer, output.string().c_str(), false, &err);
+	if(written)
+	{
+		bimg::imageWriteKtx(&writer, *texture, texture->m_data, texture->m_size, &err);
+		bx::close(&writer);
+		written = err.isOk();
+	}
+	bimg::imageFree(texture);
+
+	if(!written)
+	{
+		error = std::string(err.getMessage().getPtr());
+	}
+	return written;
+}
+
+bool build_texture_arrays()
 {
 	fs::error_code err;
+	if(fs::resolve_protocol("app:/").empty())
+	{
+		return false;
+	}
+
+	// the compiled maps grouped by what an array needs its layers to share
+	bx::DefaultAllocator allocator;
+	std::map<std::tuple<int, std::uint32_t, std::uint32_t, std::uint8_t>, texture_array_group> groups;
+	for(const auto& key : find_array_maps())
+	{
+		auto compiled = fs::replace(key, ":/data", ":/cache");
+		compiled += ".asset";
+		std::ifstream stream(fs::resolve_protocol(compiled).string(), std::ios::in | std::ios::binary);
+		if(!stream.is_open())
+		{
+			continue;
+		}
+		const auto data = fs::read_stream(stream);
+
+		bx::Error parse_err;
+		auto image = bimg::imageParse(&allocator, data.data(), std::uint32_t(data.size()),
+									  bimg::TextureFormat::Count, &parse_err);
+		if(image == nullptr)
+		{
+			continue;
+		}
+		if(image->m_cubeMap || image->m_depth > 1 || image->m_numLayers > 1)
+		{
+			bimg::imageFree(image);
+			continue;
+		}
+
+		auto& group = groups[std::make_tuple(int(image->m_format), image->m_width, image->m_height,
+											 image->m_numMips)];
+		group.keys.push_back(key);
+		group.images.push_back(image);
+	}
+
+	// the version, then every array as its key, its count of layers and the
+	// keys of the maps in its layers, a line each
+	std::ostringstream table;
+	table << texture_arrays::table_version << "\n";
+	const auto dir = fs::resolve_protocol("app:/cache/texture_arrays");
+	fs::remove_all(dir, err);
+	fs::create_directories(dir, err);
+	std::size_t arrays = 0;
+	std::size_t layers = 0;
+	for(const auto& pair : groups)
+	{
+		const auto& group = pair.second;
+		// a map alone is sampled as it is
+		for(std::size_t begin = 0; group.images.size() > 1 && begin < group.images.size();
+			begin += texture_array_max_layers)
+		{
+			const auto end = std::min(group.images.size(), begin + texture_array_max_layers);
+			const auto& first = *group.images[begin];
+			const auto name = std::string(bimg::getName(first.m_format)) + "_" +
+							  std::to_string(first.m_width) + "x" + std::to_string(first.m_height) + "_" +
+							  std::to_string(begin) + ".ktx";
+
+			std::string error;
+			if(!write_texture_array(group, begin, end, dir / (name + ".asset"), error))
+			{
+				APPLOG_ERROR("Failed writing the texture array {0} with error: {1}", name, error);
+				continue;
+			}
+
+			table << "app:/data/texture_arrays/" << name << "\n" << (end - begin) << "\n";
+			for(auto i = begin; i < end; ++i)
+			{
+				table << group.keys[i] << "\n";
+			}
+			++arrays;
+			layers += end - begin;
+		}
+		for(auto image : group.images)
+		{
+			bimg::imageFree(image);
+		}
+	}
+
+	std::ofstream stream(fs::resolve_protocol(texture_arrays::table_key).string(),
+						 std::ios::out | std::ios::binary | std::ios::trunc);
+	stream << table.str();
+	if(!stream.good())
+	{
+		APPLOG_ERROR("Failed writing the table of the texture arrays.");
+		return false;
+	}
+
+	APPLOG_INFO("Successful packing of {0} maps in {1} texture arrays", layers, arrays);
+	return true;
+}
+
+static std::string read_text(const fs::path& file_path)
+{
+	std::ifstream stream(file_path.string(), std::ios::binary);
+	std::stringstream buffer;
+	buffer << stream.rdbuf();
+	return buffer.str();
+}
+
+// the string values of the "id" members of serialized json, the asset links
+// are saved as those
+static std::vector<std::string> find_link_keys(const std::string& json)
+{
+	std::vector<std::string> keys;
+	const std::string member = "\"id\"";
+	for(auto pos = json.find(member); pos != std::string::npos; pos = json.find(member, pos))
+	{
+		pos = json.find_first_not_of(" \t\r\n", pos + member.size());
+		if(pos == std::string::npos || json[pos] != ':')
+		{
+			continue;
+		}
+
+		pos = json.find_first_not_of(" \t\r\n", pos + 1);
+		if(pos == std::string::npos || json[pos] != '"')
+		{
+			continue;
+		}
+
+		std::string key;
+		for(++pos; pos < json.size() && json[pos] != '"'; ++pos)
+		{
+			if(json[pos] == '\\' && pos + 1 < json.size())
+			{
+				++pos;
+			}
+			key += json[pos];
+		}
+		keys.push_back(key);
+	}
+	return keys;
+}
+
+template <typename T>
+static bool add_dependency(runtime::asset_manifest& manifest, runtime::asset_manifest::asset_type type,
+						   const std::string& key)
+{
+	if(!ex::is_format<T>(fs::path(key).extension().string()))
+	{
+		return false;
+	}
+
+	manifest.dependencies.push_back({type, key});
+	return true;
+}
+
+// the assets the links of serialized entities need, with the textures of
+// their materials
+static runtime::asset_manifest make_manifest(const fs::path& absolute_key)
+{
+	using asset_type = runtime::asset_manifest::asset_type;
+
+	runtime::asset_manifest manifest;
+	std::set<std::string> visited;
+	std::vector<std::string> keys = find_link_keys(read_text(absolute_key));
+	while(!keys.empty())
+	{
+		const auto key = keys.back();
+		keys.pop_back();
+		if(!fs::has_known_protocol(key) || !visited.insert(key).second)
+		{
+			continue;
+		}
+
+		if(add_dependency<material>(manifest, asset_type::material, key))
+		{
+			const auto material_keys = find_link_keys(read_text(fs::resolve_protocol(key)));
+			keys.insert(std::end(keys), std::begin(material_keys), std::end(material_keys));
+		}
+		else if(!add_dependency<gfx::texture>(manifest, asset_type::texture, key) &&
+				!add_dependency<mesh>(manifest, asset_type::mesh, key) &&
+				!add_dependency<audio::sound>(manifest, asset_type::sound, key))
+		{
+			add_dependency<runtime::animation>(manifest, asset_type::animation, key);
+		}
+	}
+	return manifest;
+}
+
+// the entities in the compact form of what is saved, behind the manifest of
+// their dependencies
+// the side of the cells a scene is split into along x and z, to be streamed
+// around the cameras
+constexpr float scene_cell_size = 128.0f;
+
+// cell_size 0 keeps the entities whole, as prefabs are
+static void compile_entities(const fs::path& absolute_meta_key, const fs::path& output, float cell_size)
+{
 	fs::path absolute_key = fs::convert_to_protocol(absolute_meta_key);
 	absolute_key = fs::resolve_protocol(fs::replace(absolute_key, ":/meta", ":/data"));
 	absolute_key.replace_extension();
-	fs::copy_file(absolute_key, output, fs::copy_options::overwrite_existing, err);
-	APPLOG_INFO("Successful compilation of {0}", absolute_key.string());
+	std::string str_input = absolute_key.string();
+
+	// the manifest follows the linked materials, it is part of what is cached
+	const auto manifest = make_manifest(absolute_key);
+	std::string settings;
+	for(const auto& dependency : manifest.dependencies)
+	{
+		settings += std::to_string(int(dependency.type)) + dependency.key + "\n";
+	}
+	if(cell_size > 0.0f)
+	{
+		settings += "cells " + std::to_string(cell_size) + "\n";
+	}
+
+	auto cache = get_build_cache(absolute_meta_key, absolute_key, output, settings);
+	if(cache.is_up_to_date())
+	{
+		APPLOG_TRACE("Up to date {0}", str_input);
+		return;
+	}
+
+	std::ifstream input(str_input, std::ios::binary);
+	std::ofstream stream(output.string(), std::ios::binary | std::ios::trunc);
+	if(input.good() && stream.good())
+	{
+		std::ostringstream compact;
+		if(!ecs::utils::compact_data(input, compact))
+		{
+			APPLOG_ERROR("Failed compilation of {0} with error : Invalid data", str_input);
+			return;
+		}
+
+		// the assets of a scene in cells load with the cells, not all with it
+		std::ostringstream cells;
+		const bool partitioned = ecs::utils::partition_data(compact.str(), cell_size, cells);
+		(partitioned ? runtime::asset_manifest{} : manifest).write(stream);
+		const auto data = partitioned ? cells.str() : compact.str();
+		stream.write(data.data(), std::streamsize(data.size()));
+		cache.store();
+
+		APPLOG_INFO("Successful compilation of {0} with {1} dependencies{2}", str_input,
+					manifest.dependencies.size(), partitioned ? " in cells" : "");
+	}
+}
+
+template <>
+void compile<prefab>(const fs::path& absolute_meta_key, const fs::path& output)
+{
+	compile_entities(absolute_meta_key, output, 0.0f);
 }
 
 template <>
 void compile<scene>(const fs::path& absolute_meta_key, const fs::path& output)
 {
+	compile_entities(absolute_meta_key, output, scene_cell_size);
+}
+
+std::string get_index_settings()
+{
+	return std::to_string(compiler_version) + " " + build_cache::get_tool_settings("shaderc") + " " +
+		   build_cache::get_tool_settings("texturec") + " bimg " + std::to_string(BIMG_API_VERSION);
+}
+
+bool pack(const fs::path& cache_directory, const fs::path& output)
+{
+	fs::archive_writer writer;
 	fs::error_code err;
-	fs::path absolute_key = fs::convert_to_protocol(absolute_meta_key);
-	absolute_key = fs::resolve_protocol(fs::replace(absolute_key, ":/meta", ":/data"));
-	absolute_key.replace_extension();
-	fs::copy_file(absolute_key, output, fs::copy_options::overwrite_existing, err);
-	APPLOG_INFO("Successful compilation of {0}", absolute_key.string());
+	fs::recursive_directory_iterator it(cache_directory, err);
+	for(const auto& entry : it)
+	{
+		const auto& file_path = entry.path();
+		if(!fs::is_regular_file(file_path, err) || file_path.extension() != ".asset")
+		{
+			continue;
+		}
+
+		writer.add_file(fs::relative(file_path, cache_directory, err).generic_string(), file_path);
+	}
+
+	std::string write_err;
+	if(!writer.write(output, write_err))
+	{
+		APPLOG_ERROR("Failed packing {0} : {1}", output.string(), write_err);
+		return false;
+	}
+
+	APPLOG_INFO("Successful packing of {0} assets to {1}", writer.get_files_count(), output.string());
+	return true;
 }
 }
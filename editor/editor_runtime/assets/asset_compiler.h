@@ -1,9 +1,40 @@
 #pragma once
 #include <core/filesystem/filesystem.h>
 
+#include <string>
+
 namespace asset_compiler
 {
 
 template <typename T>
 extern void compile(const fs::path& absolute_meta_key, const fs::path& output);
+
+//-----------------------------------------------------------------------------
+//  Name : get_index_settings ()
+/// <summary>
+/// What the outputs of every compiler in here depend on besides their inputs,
+/// an asset_index saved with other settings is not used.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::string get_index_settings();
+
+//-----------------------------------------------------------------------------
+//  Name : pack ()
+/// <summary>
+/// Packs every compiled asset under the cache directory into an archive,
+/// keyed by their path relative to it, to be mounted over the cache.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool pack(const fs::path& cache_directory, const fs::path& output);
+
+//-----------------------------------------------------------------------------
+//  Name : build_texture_arrays ()
+/// <summary>
+/// Packs the compiled color and normal maps of the standard materials of the
+/// project into texture arrays, those of the same size, format and mips in
+/// one, and writes the table of their layers next to them. From a worker,
+/// the materials are loaded with their maps.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool build_texture_arrays();
 };
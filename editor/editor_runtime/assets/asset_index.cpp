@@ -0,0 +1,163 @@
+#include "asset_index.h"
+
+#include <fstream>
+
+namespace asset_compiler
+{
+namespace
+{
+/// bumped when the index changes
+constexpr std::uint32_t index_version = 1;
+}
+
+bool asset_index::load(const fs::path& path, const std::string& settings)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	entries_.clear();
+	settings_ = settings;
+
+	std::ifstream stream(path.string());
+	std::uint32_t version = 0;
+	std::string saved_settings;
+	if(!(stream >> version) || version != index_version || !stream.ignore() ||
+	   !std::getline(stream, saved_settings) || saved_settings != settings)
+	{
+		return false;
+	}
+
+	std::string key;
+	while(std::getline(stream, key))
+	{
+		std::size_t inputs = 0;
+		std::size_t outputs = 0;
+		if(!(stream >> inputs >> outputs))
+		{
+			break;
+		}
+
+		entry e;
+		e.inputs.resize(inputs);
+		e.outputs.resize(outputs);
+		bool read = true;
+		for(auto& t : e.inputs)
+		{
+			read = read && (stream >> t.size >> t.time);
+		}
+		for(auto& t : e.outputs)
+		{
+			read = read && (stream >> t.size >> t.time);
+		}
+		if(!read || !stream.ignore())
+		{
+			break;
+		}
+		entries_[key] = std::move(e);
+	}
+	return true;
+}
+
+bool asset_index::save(const fs::path& path) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	fs::error_code err;
+	fs::create_directories(path.parent_path(), err);
+
+	std::ofstream stream(path.string(), std::ios::trunc);
+	stream << index_version << "\n" << settings_ << "\n";
+	for(const auto& pair : entries_)
+	{
+		const auto& e = pair.second;
+		if(!e.used)
+		{
+			continue;
+		}
+
+		stream << pair.first << "\n" << e.inputs.size() << " " << e.outputs.size();
+		for(const auto& t : e.inputs)
+		{
+			stream << " " << t.size << " " << t.time;
+		}
+		for(const auto& t : e.outputs)
+		{
+			stream << " " << t.size << " " << t.time;
+		}
+		stream << "\n";
+	}
+	return bool(stream);
+}
+
+bool asset_index::is_up_to_date(const fs::path& key, const std::vector<fs::path>& inputs,
+								const std::vector<fs::path>& outputs)
+{
+	std::vector<file_time> input_times;
+	std::vector<file_time> output_times;
+	if(!get_times(inputs, input_times) || !get_times(outputs, output_times))
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = entries_.find(key.generic_string());
+	if(it == std::end(entries_))
+	{
+		return false;
+	}
+
+	auto& e = it->second;
+	e.used = e.inputs == input_times && e.outputs == output_times;
+	return e.used;
+}
+
+void asset_index::record(const fs::path& key, const std::vector<fs::path>& inputs,
+						 const std::vector<fs::path>& outputs)
+{
+	entry e;
+	e.used = get_times(inputs, e.inputs) && get_times(outputs, e.outputs);
+	for(const auto& output : e.outputs)
+	{
+		for(const auto& input : e.inputs)
+		{
+			e.used = e.used && output.time >= input.time;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	if(e.used)
+	{
+		entries_[key.generic_string()] = std::move(e);
+	}
+	else
+	{
+		entries_.erase(key.generic_string());
+	}
+}
+
+void asset_index::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	entries_.clear();
+}
+
+bool asset_index::get_times(const std::vector<fs::path>& paths, std::vector<file_time>& times)
+{
+	times.clear();
+	times.reserve(paths.size());
+	for(const auto& path : paths)
+	{
+		fs::error_code err;
+		file_time t;
+		t.size = fs::file_size(path, err);
+		if(err)
+		{
+			return false;
+		}
+		t.time = std::int64_t(fs::last_write_time(path, err).time_since_epoch().count());
+		if(err)
+		{
+			return false;
+		}
+		times.push_back(t);
+	}
+	return true;
+}
+}
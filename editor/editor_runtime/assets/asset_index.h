@@ -0,0 +1,94 @@
+#pragma once
+#include <core/filesystem/filesystem.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace asset_compiler
+{
+/*
+ * asset_index; what the last session knew of the compiled assets of a
+ * directory, so that opening it again does not look at every output.
+ *
+ *      An entry is kept for every asset whose outputs were compiled from its
+ *      inputs as they are, with the size and the write time of the inputs
+ *      and the write time of the outputs. It is saved when the directory is
+ *      closed and loaded when it opens. An entry only counts while every
+ *      file still has the size and the time it had, anything touched since,
+ *      by this editor or not, goes through the build cache as before and
+ *      that hashes the contents. The entries not looked at in a session are
+ *      not saved again, and the whole index is dropped when the settings of
+ *      the compilers change.
+ */
+class asset_index
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : load ()
+	/// <summary>
+	/// Reads the index saved with the same settings, it is left empty
+	/// otherwise.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool load(const fs::path& path, const std::string& settings);
+
+	//-----------------------------------------------------------------------------
+	//  Name : save ()
+	/// <summary>
+	/// Writes the entries looked at or recorded since the load.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool save(const fs::path& path) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_up_to_date ()
+	/// <summary>
+	/// Whether the inputs and the outputs of the key are as they were recorded.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool is_up_to_date(const fs::path& key, const std::vector<fs::path>& inputs,
+					   const std::vector<fs::path>& outputs);
+
+	//-----------------------------------------------------------------------------
+	//  Name : record ()
+	/// <summary>
+	/// Records the files of the key after a compilation. Outputs missing or
+	/// older than an input, as left by a compilation that failed, remove the
+	/// entry instead.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void record(const fs::path& key, const std::vector<fs::path>& inputs,
+				const std::vector<fs::path>& outputs);
+
+	void clear();
+
+private:
+	struct file_time
+	{
+		std::uintmax_t size = 0;
+		std::int64_t time = 0;
+
+		bool operator==(const file_time& rhs) const
+		{
+			return size == rhs.size && time == rhs.time;
+		}
+	};
+
+	struct entry
+	{
+		std::vector<file_time> inputs;
+		std::vector<file_time> outputs;
+		/// looked at or recorded in this session
+		bool used = false;
+	};
+
+	static bool get_times(const std::vector<fs::path>& paths, std::vector<file_time>& times);
+
+	mutable std::mutex mutex_;
+	std::string settings_;
+	std::unordered_map<std::string, entry> entries_;
+};
+}
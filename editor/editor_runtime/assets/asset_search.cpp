@@ -0,0 +1,386 @@
+#include "asset_search.h"
+#include "asset_extensions.h"
+
+#include <core/string_utils/string_utils.h>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iterator>
+
+namespace editor
+{
+namespace
+{
+/// bumped when the saved index changes
+constexpr std::uint32_t search_version = 1;
+/// the changes applied under one lock, so that a search waits little for a
+/// listing
+constexpr std::size_t changes_per_lock = 256;
+/// removed entries kept before the index is compacted
+constexpr std::size_t min_compact = 1024;
+
+// in the order of ex::get_all_formats
+const std::string& get_type(const std::string& ext)
+{
+	static const std::array<std::string, 8> names = {
+		{"texture", "mesh", "animation", "sound", "shader", "material", "prefab", "scene"}};
+	static const std::string none;
+
+	const auto& formats = ex::get_all_formats();
+	for(std::size_t i = 0; i < formats.size() && i < names.size(); ++i)
+	{
+		if(std::find(std::begin(formats[i]), std::end(formats[i]), ext) != std::end(formats[i]))
+		{
+			return names[i];
+		}
+	}
+	return none;
+}
+
+std::uint32_t get_trigram(const std::string& text, std::size_t i)
+{
+	return std::uint32_t(std::uint8_t(text[i])) | (std::uint32_t(std::uint8_t(text[i + 1])) << 8) |
+		   (std::uint32_t(std::uint8_t(text[i + 2])) << 16);
+}
+}
+
+asset_search::~asset_search()
+{
+	unwatch();
+}
+
+bool asset_search::load(const fs::path& path)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	entries_.clear();
+	ids_.clear();
+	trigrams_.clear();
+	removed_ = 0;
+	++version_;
+
+	std::ifstream stream(path.string());
+	std::uint32_t version = 0;
+	if(!(stream >> version) || version != search_version || !stream.ignore())
+	{
+		return false;
+	}
+
+	std::string key;
+	while(std::getline(stream, key))
+	{
+		add(key);
+	}
+	return true;
+}
+
+bool asset_search::save(const fs::path& path) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	fs::error_code err;
+	fs::create_directories(path.parent_path(), err);
+
+	std::ofstream stream(path.string(), std::ios::trunc);
+	stream << search_version << "\n";
+	for(const auto& e : entries_)
+	{
+		if(!e.removed)
+		{
+			stream << e.key << "\n";
+		}
+	}
+	return bool(stream);
+}
+
+void asset_search::watch(const fs::path& dir, fs::watcher::clock_t::duration debounce)
+{
+	using namespace std::literals;
+	unwatch();
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		++listing_;
+	}
+
+	const auto id = fs::watcher::watch(
+		(dir / "*").make_preferred(), true, true, 500ms, debounce,
+		[this](const auto& entries, bool is_initial_list) { on_changes(entries, is_initial_list); });
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	watch_id_ = id;
+	// the listing is through, what it did not find went while nobody watched
+	for(auto& e : entries_)
+	{
+		if(!e.removed && e.seen != listing_)
+		{
+			ids_.erase(e.key);
+			e.removed = true;
+			++removed_;
+			++version_;
+		}
+	}
+	compact();
+}
+
+void asset_search::unwatch()
+{
+	std::uint64_t id = 0;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::swap(id, watch_id_);
+	}
+	if(id != 0)
+	{
+		fs::watcher::unwatch(id);
+	}
+}
+
+void asset_search::on_changes(const std::vector<fs::watcher::entry>& entries, bool /*is_initial_list*/)
+{
+	std::size_t i = 0;
+	while(i < entries.size())
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		for(const auto end = std::min(i + changes_per_lock, entries.size()); i < end; ++i)
+		{
+			const auto& entry = entries[i];
+			if(entry.type != fs::file_type::regular)
+			{
+				continue;
+			}
+
+			const auto key = fs::convert_to_protocol(entry.path).generic_string();
+			if(entry.status == fs::watcher::entry_status::removed)
+			{
+				remove(key);
+			}
+			else if(entry.status == fs::watcher::entry_status::renamed)
+			{
+				remove(fs::convert_to_protocol(entry.last_path).generic_string());
+				add(key);
+			}
+			else
+			{
+				add(key);
+			}
+		}
+	}
+}
+
+bool asset_search::add(const std::string& key)
+{
+	auto it = ids_.find(key);
+	if(it != std::end(ids_))
+	{
+		entries_[it->second].seen = listing_;
+		return true;
+	}
+
+	const fs::path path(key);
+	const auto ext = string_utils::to_lower(path.extension().string());
+	const auto& type = get_type(ext);
+	if(type.empty())
+	{
+		return false;
+	}
+
+	auto name = path.filename();
+	while(name.has_extension())
+	{
+		name = name.stem();
+	}
+
+	entry e;
+	e.key = key;
+	e.name = name.string();
+	e.type = type;
+	e.text = string_utils::to_lower(e.name) + " " + type + " " + ext.substr(1);
+	e.seen = listing_;
+
+	const auto id = std::uint32_t(entries_.size());
+	entries_.emplace_back(std::move(e));
+	ids_.emplace(key, id);
+	index(id);
+	++version_;
+	return true;
+}
+
+void asset_search::remove(const std::string& key)
+{
+	auto it = ids_.find(key);
+	if(it == std::end(ids_))
+	{
+		return;
+	}
+
+	entries_[it->second].removed = true;
+	ids_.erase(it);
+	++removed_;
+	++version_;
+	compact();
+}
+
+void asset_search::compact()
+{
+	if(removed_ < min_compact || removed_ * 2 < entries_.size())
+	{
+		return;
+	}
+
+	auto entries = std::move(entries_);
+	entries_.clear();
+	ids_.clear();
+	trigrams_.clear();
+	removed_ = 0;
+	for(auto& e : entries)
+	{
+		if(e.removed)
+		{
+			continue;
+		}
+
+		const auto id = std::uint32_t(entries_.size());
+		ids_.emplace(e.key, id);
+		entries_.emplace_back(std::move(e));
+		index(id);
+	}
+}
+
+void asset_search::index(std::uint32_t id)
+{
+	const auto& text = entries_[id].text;
+	for(std::size_t i = 0; i + 3 <= text.size(); ++i)
+	{
+		// the ids are added in order, a trigram met twice is listed once
+		auto& ids = trigrams_[get_trigram(text, i)];
+		if(ids.empty() || ids.back() != id)
+		{
+			ids.push_back(id);
+		}
+	}
+}
+
+std::size_t asset_search::find(const std::string& search, std::size_t max_results,
+							   std::vector<result>& results) const
+{
+	results.clear();
+	const auto words = string_utils::tokenize(string_utils::to_lower(search), " ");
+	if(words.empty())
+	{
+		return 0;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	// the lists of the trigrams of the longer words, the shortest first
+	std::vector<const std::vector<std::uint32_t>*> lists;
+	for(const auto& word : words)
+	{
+		for(std::size_t i = 0; i + 3 <= word.size(); ++i)
+		{
+			auto it = trigrams_.find(get_trigram(word, i));
+			if(it == std::end(trigrams_))
+			{
+				return 0;
+			}
+			lists.push_back(&it->second);
+		}
+	}
+	std::sort(std::begin(lists), std::end(lists),
+			  [](const auto* lhs, const auto* rhs) { return lhs->size() < rhs->size(); });
+
+	std::vector<std::uint32_t> candidates;
+	if(!lists.empty())
+	{
+		candidates = *lists.front();
+		std::vector<std::uint32_t> common;
+		for(std::size_t i = 1; i < lists.size() && !candidates.empty(); ++i)
+		{
+			common.clear();
+			std::set_intersection(std::begin(candidates), std::end(candidates), std::begin(*lists[i]),
+								  std::end(*lists[i]), std::back_inserter(common));
+			candidates.swap(common);
+		}
+	}
+
+	// the trigrams may be in the text apart, every word is checked whole
+	std::vector<std::uint32_t> matches;
+	const auto check = [&](std::uint32_t id) {
+		const auto& e = entries_[id];
+		if(e.removed)
+		{
+			return;
+		}
+		for(const auto& word : words)
+		{
+			if(e.text.find(word) == std::string::npos)
+			{
+				return;
+			}
+		}
+		matches.push_back(id);
+	};
+	if(!lists.empty())
+	{
+		for(const auto id : candidates)
+		{
+			check(id);
+		}
+	}
+	else
+	{
+		for(std::uint32_t id = 0; id < std::uint32_t(entries_.size()); ++id)
+		{
+			check(id);
+		}
+	}
+
+	const auto& first = words.front();
+	const auto count = std::min(max_results, matches.size());
+	std::partial_sort(std::begin(matches), std::begin(matches) + std::ptrdiff_t(count), std::end(matches),
+					  [&](std::uint32_t lhs, std::uint32_t rhs) {
+						  const auto& l = entries_[lhs];
+						  const auto& r = entries_[rhs];
+						  const bool l_starts = l.text.compare(0, first.size(), first) == 0;
+						  const bool r_starts = r.text.compare(0, first.size(), first) == 0;
+						  if(l_starts != r_starts)
+						  {
+							  return l_starts;
+						  }
+						  if(l.name.size() != r.name.size())
+						  {
+							  return l.name.size() < r.name.size();
+						  }
+						  return l.key < r.key;
+					  });
+
+	results.reserve(count);
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		const auto& e = entries_[matches[i]];
+		results.push_back({e.key, e.name, e.type});
+	}
+	return matches.size();
+}
+
+std::uint64_t asset_search::get_version() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return version_;
+}
+
+std::size_t asset_search::size() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return entries_.size() - removed_;
+}
+
+void asset_search::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	entries_.clear();
+	ids_.clear();
+	trigrams_.clear();
+	removed_ = 0;
+	++version_;
+}
+}
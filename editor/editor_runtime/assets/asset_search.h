@@ -0,0 +1,121 @@
+#pragma once
+#include <core/filesystem/filesystem.h>
+#include <core/filesystem/filesystem_watcher.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace editor
+{
+/*
+ * asset_search; the assets of a directory by the runs of three characters
+ * of their names and types, for the project dock to find them as the search
+ * is typed.
+ *
+ *      The name, the type and the extension of every asset are lowered and
+ *      cut in trigrams, each trigram lists the assets it is in by the order
+ *      they were added. A word of a search is looked up by intersecting the
+ *      lists of its trigrams, shorter words are only checked against what
+ *      the longer ones left, or against every asset when the search has no
+ *      longer word. The directory is listed when it is watched, on a worker,
+ *      and the watcher keeps the index up to date from then. The index is
+ *      saved next to the asset_index when the project closes, so that the
+ *      next session searches before its listing is through, which drops
+ *      what is no longer there.
+ */
+class asset_search
+{
+public:
+	struct result
+	{
+		/// the protocol path of the asset
+		std::string key;
+		/// the name and the type, as they were matched
+		std::string name;
+		std::string type;
+	};
+
+	~asset_search();
+
+	//-----------------------------------------------------------------------------
+	//  Name : load ()
+	/// <summary>
+	/// Reads the index saved by the last session, it is left empty when there
+	/// is none.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool load(const fs::path& path);
+
+	//-----------------------------------------------------------------------------
+	//  Name : save ()
+	/// <summary>
+	/// Writes the assets of the index.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool save(const fs::path& path) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : watch ()
+	/// <summary>
+	/// Lists the directory and watches it. Blocks for the listing, so it is
+	/// called on a worker, and the assets indexed before it and not found by
+	/// it are dropped.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void watch(const fs::path& dir, fs::watcher::clock_t::duration debounce);
+
+	void unwatch();
+
+	//-----------------------------------------------------------------------------
+	//  Name : find ()
+	/// <summary>
+	/// The assets with every word of the search in their name, type or
+	/// extension, those whose name starts with the first word before the
+	/// others, then the shorter names. At most max_results of them, the
+	/// count of all the matches is returned.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t find(const std::string& search, std::size_t max_results, std::vector<result>& results) const;
+
+	/// changes with every asset added or removed
+	std::uint64_t get_version() const;
+
+	std::size_t size() const;
+
+	void clear();
+
+private:
+	struct entry
+	{
+		std::string key;
+		std::string name;
+		std::string type;
+		/// what the words are looked for in
+		std::string text;
+		/// the listing that found it last
+		std::uint64_t seen = 0;
+		bool removed = false;
+	};
+
+	void on_changes(const std::vector<fs::watcher::entry>& entries, bool is_initial_list);
+	/// false for a file that is not of an asset type
+	bool add(const std::string& key);
+	void remove(const std::string& key);
+	/// the entries again without the removed ones, once they are most of it
+	void compact();
+	void index(std::uint32_t id);
+
+	mutable std::mutex mutex_;
+	std::vector<entry> entries_;
+	std::unordered_map<std::string, std::uint32_t> ids_;
+	/// the ids of the entries with every trigram, ascending
+	std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> trigrams_;
+	std::size_t removed_ = 0;
+	std::uint64_t version_ = 0;
+	std::uint64_t listing_ = 0;
+	std::uint64_t watch_id_ = 0;
+};
+}
@@ -0,0 +1,199 @@
+#include "build_cache.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+
+namespace asset_compiler
+{
+namespace
+{
+/// bumped when the stamps change
+constexpr std::uint32_t stamp_version = 1;
+
+// fnv-1a
+void hash_bytes(std::uint64_t& result, const char* data, std::size_t size)
+{
+	for(std::size_t i = 0; i < size; ++i)
+	{
+		result ^= std::uint8_t(data[i]);
+		result *= 0x100000001b3ull;
+	}
+}
+
+constexpr std::uint64_t hash_seed = 0xcbf29ce484222325ull;
+
+fs::path get_stamp_path(const fs::path& output)
+{
+	const auto key = fs::convert_to_protocol(output);
+	if(!fs::has_known_protocol(key))
+	{
+		return output.string() + ".stamp";
+	}
+	return fs::resolve_protocol(fs::replace(key, ":/cache", ":/build")).string() + ".stamp";
+}
+}
+
+build_cache::build_cache(const fs::path& output, std::vector<fs::path> inputs, const std::string& settings)
+	: output_(output)
+	, stamp_path_(get_stamp_path(output))
+	, inputs_(std::move(inputs))
+	, settings_(hash_seed)
+{
+	hash_bytes(settings_, settings.data(), settings.size());
+	for(const auto& input : inputs_)
+	{
+		const auto name = input.generic_string();
+		hash_bytes(settings_, name.data(), name.size() + 1);
+	}
+}
+
+bool build_cache::is_up_to_date()
+{
+	fs::error_code err;
+	if(!fs::exists(output_, err))
+	{
+		return false;
+	}
+
+	stamp s;
+	if(!read_stamp(s) || s.settings != settings_)
+	{
+		return false;
+	}
+
+	// a time as new as the stamp could be of a write after it in the same tick
+	auto times = get_input_times();
+	const auto stamp_time = std::int64_t(fs::last_write_time(stamp_path_, err).time_since_epoch().count());
+	const bool older = std::all_of(std::begin(times), std::end(times),
+								   [stamp_time](const input_time& t) { return t.time < stamp_time; });
+	if(times == s.inputs && older)
+	{
+		return true;
+	}
+
+	// touched, but maybe not changed
+	if(get_contents_hash() != s.contents)
+	{
+		return false;
+	}
+
+	s.inputs = std::move(times);
+	write_stamp(s);
+	return true;
+}
+
+void build_cache::store()
+{
+	stamp s;
+	s.settings = settings_;
+	s.inputs = get_input_times();
+	s.contents = get_contents_hash();
+	write_stamp(s);
+}
+
+std::uint64_t build_cache::get_shared_key(const std::string& settings) const
+{
+	auto result = get_contents_hash();
+	hash_bytes(result, settings.data(), settings.size());
+	return result;
+}
+
+std::uint64_t build_cache::hash_file(const fs::path& path, std::uint64_t seed)
+{
+	std::uint64_t result = seed == 0 ? hash_seed : seed;
+	std::array<char, 64 * 1024> buffer;
+	std::ifstream stream(path.string(), std::ios::binary);
+	while(stream)
+	{
+		stream.read(buffer.data(), std::streamsize(buffer.size()));
+		hash_bytes(result, buffer.data(), std::size_t(stream.gcount()));
+	}
+	return result;
+}
+
+void build_cache::invalidate(const fs::path& output)
+{
+	fs::error_code err;
+	fs::remove(get_stamp_path(output), err);
+}
+
+std::string build_cache::get_tool_settings(const std::string& process)
+{
+	const auto executable = fs::resolve_protocol("binary:/") / process;
+	fs::error_code err;
+	const auto size = fs::file_size(executable, err);
+	const auto time = fs::last_write_time(executable, err).time_since_epoch().count();
+	return process + " " + std::to_string(size) + " " + std::to_string(time);
+}
+
+bool build_cache::read_stamp(stamp& result) const
+{
+	std::ifstream stream(stamp_path_.string());
+	std::uint32_t version = 0;
+	std::size_t count = 0;
+	if(!(stream >> version >> result.settings >> result.contents >> count) || version != stamp_version ||
+	   count != inputs_.size())
+	{
+		return false;
+	}
+
+	result.inputs.resize(count);
+	for(auto& input : result.inputs)
+	{
+		if(!(stream >> input.size >> input.time))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void build_cache::write_stamp(const stamp& s) const
+{
+	fs::error_code err;
+	fs::create_directories(stamp_path_.parent_path(), err);
+
+	std::ofstream stream(stamp_path_.string(), std::ios::trunc);
+	stream << stamp_version << " " << s.settings << " " << s.contents << " " << s.inputs.size() << "\n";
+	for(const auto& input : s.inputs)
+	{
+		stream << input.size << " " << input.time << "\n";
+	}
+}
+
+std::vector<build_cache::input_time> build_cache::get_input_times() const
+{
+	std::vector<input_time> times;
+	times.reserve(inputs_.size());
+	for(const auto& input : inputs_)
+	{
+		fs::error_code err;
+		input_time t;
+		t.size = fs::file_size(input, err);
+		t.time = std::int64_t(fs::last_write_time(input, err).time_since_epoch().count());
+		times.push_back(t);
+	}
+	return times;
+}
+
+std::uint64_t build_cache::get_contents_hash() const
+{
+	if(has_contents_)
+	{
+		return contents_;
+	}
+
+	std::uint64_t result = hash_seed;
+	for(const auto& input : inputs_)
+	{
+		result = hash_file(input, result);
+		// a boundary, so moving bytes between two inputs changes the hash
+		hash_bytes(result, "", 1);
+	}
+
+	contents_ = result;
+	has_contents_ = true;
+	return result;
+}
+}
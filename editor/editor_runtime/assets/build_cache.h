@@ -0,0 +1,123 @@
+#pragma once
+#include <core/filesystem/filesystem.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace asset_compiler
+{
+/*
+ * build_cache; tells whether a compiled output is still the one of its
+ * inputs, so that unchanged assets are not compiled again.
+ *
+ *      A stamp is kept for every output under :/build next to :/cache, with
+ *      the hash of what else the compilation depends on (the compiler
+ *      version, the tools, the settings), the size and the write time of
+ *      every input and the hash of their contents. The contents are only
+ *      hashed when a size or a time differs, e.g. after a branch switch
+ *      touched a file without changing it, or when a time is not older than
+ *      the stamp.
+ */
+class build_cache
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : build_cache ()
+	/// <summary>
+	/// The cache of the output compiled from the inputs, where the settings are
+	/// whatever else changes the result.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	build_cache(const fs::path& output, std::vector<fs::path> inputs, const std::string& settings);
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_up_to_date ()
+	/// <summary>
+	/// Whether the output exists and was compiled from the inputs as they are
+	/// with the same settings.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool is_up_to_date();
+
+	//-----------------------------------------------------------------------------
+	//  Name : store ()
+	/// <summary>
+	/// Records that the output was compiled from the inputs as they are.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void store();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_shared_key ()
+	/// <summary>
+	/// The key of the output in a cache shared between machines, the hash of
+	/// the contents of the inputs and of the settings, which must not depend
+	/// on the machine, e.g. no paths or times.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint64_t get_shared_key(const std::string& settings) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : hash_file ()
+	/// <summary>
+	/// Hashes the contents of a file after the seed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static std::uint64_t hash_file(const fs::path& path, std::uint64_t seed = 0);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_tool_settings ()
+	/// <summary>
+	/// What identifies a build of a tool next to the executable, its size and
+	/// write time.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static std::string get_tool_settings(const std::string& process);
+
+	//-----------------------------------------------------------------------------
+	//  Name : invalidate ()
+	/// <summary>
+	/// Forgets how the output was compiled, the next compilation of it is not
+	/// skipped whatever the inputs.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void invalidate(const fs::path& output);
+
+private:
+	struct input_time
+	{
+		std::uintmax_t size = 0;
+		std::int64_t time = 0;
+
+		bool operator==(const input_time& rhs) const
+		{
+			return size == rhs.size && time == rhs.time;
+		}
+	};
+
+	struct stamp
+	{
+		std::uint64_t settings = 0;
+		std::vector<input_time> inputs;
+		std::uint64_t contents = 0;
+	};
+
+	bool read_stamp(stamp& result) const;
+	void write_stamp(const stamp& s) const;
+	std::vector<input_time> get_input_times() const;
+	std::uint64_t get_contents_hash() const;
+
+	/// the compiled file
+	fs::path output_;
+	/// the stamp of the output
+	fs::path stamp_path_;
+	/// the files the output is compiled from
+	std::vector<fs::path> inputs_;
+	/// the hash of the settings
+	std::uint64_t settings_ = 0;
+	/// the hash of the contents, once computed
+	mutable std::uint64_t contents_ = 0;
+	mutable bool has_contents_ = false;
+};
+}
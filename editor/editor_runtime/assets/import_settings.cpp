@@ -0,0 +1,162 @@
+#include "import_settings.h"
+#include "asset_extensions.h"
+#include "../meta/assets/import_settings.hpp"
+
+#include <core/serialization/associative_archive.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+namespace asset_compiler
+{
+namespace
+{
+std::atomic<std::uint8_t>& get_platform()
+{
+	static std::atomic<std::uint8_t> platform{std::uint8_t(target_platform::desktop)};
+	return platform;
+}
+
+const char* get_compression_name(texture_compression compression)
+{
+	static const std::array<const char*, 7> names = {{"none", "BC1", "BC3", "BC5", "BC7", "ETC2", "ETC2A"}};
+	return names[std::size_t(compression)];
+}
+}
+
+void import_settings::set_target_platform(target_platform platform)
+{
+	get_platform() = std::uint8_t(platform);
+}
+
+target_platform import_settings::get_target_platform()
+{
+	return target_platform(get_platform().load());
+}
+
+bool import_settings::load(const fs::path& absolute_meta_key, texture_import_settings& settings)
+{
+	std::ifstream stream(absolute_meta_key.string());
+	// the metas written before the settings only hold a tag
+	stream >> std::ws;
+	if(stream.peek() != '{')
+	{
+		return false;
+	}
+
+	try
+	{
+		cereal::iarchive_associative_t ar(stream);
+		try_load(ar, cereal::make_nvp("texture", settings));
+	}
+	catch(...)
+	{
+		return false;
+	}
+	return true;
+}
+
+bool import_settings::save(const fs::path& absolute_meta_key, const texture_import_settings& settings)
+{
+	std::ofstream stream(absolute_meta_key.string(), std::ofstream::trunc);
+	if(!stream.is_open())
+	{
+		return false;
+	}
+	{
+		cereal::oarchive_associative_t ar(stream);
+		try_save(ar, cereal::make_nvp("texture", settings));
+	}
+	return stream.good();
+}
+
+void import_settings::write_texture_budget(std::ostream& report, std::uint64_t budget_bytes, std::size_t rows)
+{
+	struct texture
+	{
+		std::string key;
+		std::uint64_t bytes = 0;
+	};
+
+	const auto platform = get_target_platform();
+	const auto& formats = ex::get_suported_formats<gfx::texture>();
+	std::array<std::uint64_t, 7> bytes = {};
+	std::array<std::size_t, 7> counts = {};
+	std::vector<texture> uncompressed;
+
+	for(const auto& protocol : {"engine", "editor", "app"})
+	{
+		const auto meta_dir = fs::resolve_protocol(std::string(protocol) + ":/meta");
+		const auto cache_dir = fs::resolve_protocol(std::string(protocol) + ":/cache");
+		fs::error_code err;
+		if(meta_dir.empty() || !fs::exists(meta_dir, err))
+		{
+			continue;
+		}
+
+		for(const auto& entry : fs::recursive_directory_iterator(meta_dir, err))
+		{
+			const auto& meta = entry.path();
+			const auto format = meta.stem().extension().string();
+			if(meta.extension() != ".meta" ||
+			   std::find(std::begin(formats), std::end(formats), format) == std::end(formats))
+			{
+				continue;
+			}
+
+			auto output = (cache_dir / fs::relative(meta, meta_dir, err)).replace_extension();
+			output += ".asset";
+			const auto size = fs::file_size(output, err);
+			if(err)
+			{
+				continue;
+			}
+
+			texture_import_settings settings;
+			load(meta, settings);
+			const auto compression = std::size_t(settings.get(platform).compression);
+			bytes[compression] += size;
+			++counts[compression];
+			if(settings.get(platform).compression == texture_compression::none)
+			{
+				uncompressed.push_back({fs::convert_to_protocol(output).generic_string(), size});
+			}
+		}
+	}
+
+	const auto to_mb = [](std::uint64_t b) { return double(b) / (1024.0 * 1024.0); };
+	std::uint64_t total = 0;
+	report << std::fixed << std::setprecision(2);
+	report << "compression, textures, MB\n";
+	for(std::size_t i = 0; i < bytes.size(); ++i)
+	{
+		total += bytes[i];
+		if(counts[i] > 0)
+		{
+			report << get_compression_name(texture_compression(i)) << ", " << counts[i] << ", "
+				   << to_mb(bytes[i]) << "\n";
+		}
+	}
+	report << "total " << to_mb(total) << "MB of a budget of " << to_mb(budget_bytes) << "MB"
+		   << (total > budget_bytes ? ", over it" : "") << "\n";
+
+	std::sort(std::begin(uncompressed), std::end(uncompressed),
+			  [](const texture& lhs, const texture& rhs) { return lhs.bytes > rhs.bytes; });
+	if(rows < uncompressed.size())
+	{
+		uncompressed.resize(rows);
+	}
+	if(!uncompressed.empty())
+	{
+		report << "the largest not block compressed, MB\n";
+	}
+	for(const auto& t : uncompressed)
+	{
+		report << t.key << ", " << to_mb(t.bytes) << "\n";
+	}
+}
+}
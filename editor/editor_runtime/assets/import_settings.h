@@ -0,0 +1,113 @@
+#pragma once
+#include <core/filesystem/filesystem.h>
+
+#include <cstdint>
+#include <ostream>
+
+namespace asset_compiler
+{
+/// the platforms the assets are compiled for, with settings of their own
+enum class target_platform : std::uint8_t
+{
+	desktop,
+	mobile,
+};
+
+/// what the texels are stored as, the block formats are those bimg encodes
+enum class texture_compression : std::uint8_t
+{
+	none,
+	bc1,
+	bc3,
+	bc5,
+	bc7,
+	etc2,
+	etc2a,
+};
+
+/// the time the encoder spends searching for the blocks
+enum class texture_quality : std::uint8_t
+{
+	fastest,
+	standard,
+	highest,
+};
+
+/// how the mips are made, box_linear averages the texels as linear colors
+enum class mip_filter : std::uint8_t
+{
+	none,
+	box,
+	box_linear,
+};
+
+struct texture_platform_settings
+{
+	texture_compression compression = texture_compression::none;
+	texture_quality quality = texture_quality::standard;
+	/// the largest width or height, 0 for any
+	std::uint32_t max_size = 0;
+};
+
+/*
+ * texture_import_settings; how a texture is compiled, kept in its meta.
+ *
+ *      The compression, the quality and the size are chosen per platform,
+ *      the assets are compiled for the target platform only. A normal map
+ *      has its normals renormalized in every mip.
+ */
+struct texture_import_settings
+{
+	texture_platform_settings desktop;
+	texture_platform_settings mobile;
+	mip_filter mips = mip_filter::box;
+	bool normal_map = false;
+
+	const texture_platform_settings& get(target_platform platform) const
+	{
+		return platform == target_platform::mobile ? mobile : desktop;
+	}
+};
+
+class import_settings
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : set_target_platform ()
+	/// <summary>
+	/// Sets the platform whose settings the assets are compiled with.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void set_target_platform(target_platform platform);
+
+	static target_platform get_target_platform();
+
+	//-----------------------------------------------------------------------------
+	//  Name : load ()
+	/// <summary>
+	/// Reads the settings of a texture from its meta, false when the meta has
+	/// none and they are left as they are.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool load(const fs::path& absolute_meta_key, texture_import_settings& settings);
+
+	//-----------------------------------------------------------------------------
+	//  Name : save ()
+	/// <summary>
+	/// Writes the settings of a texture to its meta, which has the texture
+	/// compiled again with them.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool save(const fs::path& absolute_meta_key, const texture_import_settings& settings);
+
+	//-----------------------------------------------------------------------------
+	//  Name : write_texture_budget ()
+	/// <summary>
+	/// Reports the bytes of the compiled textures of the engine, the editor
+	/// and the project per compression against a budget, with the largest
+	/// textures that are not block compressed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void write_texture_budget(std::ostream& report, std::uint64_t budget_bytes, std::size_t rows);
+};
+}
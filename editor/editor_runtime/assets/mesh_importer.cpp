@@ -3,12 +3,15 @@
 #include <core/graphics/graphics.h>
 #include <core/logging/logging.h>
 #include <core/math/math_includes.h>
+#include <core/system/subsystem.h>
+#include <core/tasks/task_group.h>
 
 #include <runtime/rendering/mesh.h>
 
 #include <editor_core/mesh_import/mesh_import.h>
 
 #include <algorithm>
+#include <vector>
 
 math::transform process_matrix(const aiMatrix4x4& assimp_matrix)
 {
@@ -37,7 +40,8 @@ math::transform process_matrix(const aiMatrix4x4& assimp_matrix)
 	return matrix;
 }
 
-void process_vertices(aiMesh* mesh, mesh::load_data& load_data)
+// the vertices of a mesh packed in their range of the vertex data, from the first vertex
+void process_vertices(aiMesh* mesh, std::uint32_t first_vertex, mesh::load_data& load_data)
 {
 	// Determine the correct offset to any relevant elements in the vertex
 	bool has_position = load_data.vertex_format.has(gfx::attribute::Position);
@@ -47,11 +51,7 @@ void process_vertices(aiMesh* mesh, mesh::load_data& load_data)
 	bool has_texcoord0 = load_data.vertex_format.has(gfx::attribute::TexCoord0);
 	auto vertex_stride = load_data.vertex_format.getStride();
 
-	std::uint32_t current_vertex = load_data.vertex_count;
-	load_data.vertex_count += mesh->mNumVertices;
-	load_data.vertex_data.resize(load_data.vertex_count * vertex_stride);
-
-	std::uint8_t* current_vertex_ptr = &load_data.vertex_data[0] + current_vertex * vertex_stride;
+	std::uint8_t* current_vertex_ptr = &load_data.vertex_data[0] + first_vertex * vertex_stride;
 
 	for(size_t i = 0; i < mesh->mNumVertices; ++i, current_vertex_ptr += vertex_stride)
 	{
@@ -125,18 +125,16 @@ void process_vertices(aiMesh* mesh, mesh::load_data& load_data)
 	}
 }
 
-void process_faces(aiMesh* mesh, std::uint32_t subset_offset, mesh::load_data& load_data)
+// the faces of a mesh in their range of the triangles, from the first face
+void process_faces(aiMesh* mesh, std::uint32_t subset_offset, std::size_t first_face,
+				   mesh::load_data& load_data)
 {
-	load_data.triangle_count += mesh->mNumFaces;
-
 	for(size_t i = 0; i < mesh->mNumFaces; ++i)
 	{
-		aiFace face = mesh->mFaces[i];
-
-		mesh::triangle triangle;
+		const aiFace& face = mesh->mFaces[i];
 
+		auto& triangle = load_data.triangle_data[first_face + i];
 		triangle.data_group_id = mesh->mMaterialIndex;
-		load_data.material_count = std::max(load_data.material_count, triangle.data_group_id + 1);
 
 		auto num_indices = std::min<size_t>(face.mNumIndices, 3);
 
@@ -144,8 +142,6 @@ void process_faces(aiMesh* mesh, std::uint32_t subset_offset, mesh::load_data& l
 		{
 			triangle.indices[j] = face.mIndices[j] + subset_offset;
 		}
-
-		load_data.triangle_data.push_back(triangle);
 	}
 }
 
@@ -197,20 +193,83 @@ void process_bones(aiMesh* mesh, std::uint32_t subset_offset, mesh::load_data& l
 	}
 }
 
-void process_mesh(aiMesh* mesh, mesh::load_data& load_data)
+// the faces of a mesh, which the import ordered for the vertex cache, ordered against overdraw.
+// The vertices are prepared in the order the faces first use them when the mesh is loaded.
+void process_overdraw(std::size_t first_face, std::size_t face_count, mesh::load_data& load_data)
+{
+	auto& triangles = load_data.triangle_data;
+
+	std::vector<std::uint32_t> indices;
+	indices.reserve(face_count * 3);
+	for(size_t i = first_face; i < first_face + face_count; ++i)
+	{
+		indices.insert(std::end(indices), std::begin(triangles[i].indices), std::end(triangles[i].indices));
+	}
+
+	mesh::optimize_overdraw(indices.data(), static_cast<std::uint32_t>(face_count),
+							load_data.vertex_data.data(), load_data.vertex_format);
+
+	for(size_t i = 0; i < face_count; ++i)
+	{
+		std::copy_n(&indices[i * 3], 3, triangles[first_face + i].indices);
+	}
+}
+
+void process_mesh(aiMesh* mesh, std::uint32_t first_vertex, std::size_t first_face,
+				  mesh::load_data& load_data)
 {
-	const auto mesh_vertices_offset = load_data.vertex_count;
-	process_faces(mesh, mesh_vertices_offset, load_data);
-	process_bones(mesh, mesh_vertices_offset, load_data);
-	process_vertices(mesh, load_data);
+	process_faces(mesh, first_vertex, first_face, load_data);
+	process_vertices(mesh, first_vertex, load_data);
+	process_overdraw(first_face, mesh->mNumFaces, load_data);
 }
 
+// Every mesh has its ranges of the vertices and triangles, which are sized
+// up front, so the meshes are processed in parallel into them. The bones
+// are merged by name across the meshes after, in order.
 void process_meshes(const aiScene* scene, mesh::load_data& load_data)
 {
+	std::vector<aiMesh*> meshes;
+	std::vector<std::uint32_t> first_vertices;
+	std::vector<std::size_t> first_faces;
 	for(size_t i = 0; i < scene->mNumMeshes; ++i)
 	{
 		aiMesh* mesh = scene->mMeshes[i];
-		process_mesh(mesh, load_data);
+
+		// points and lines are sorted in meshes of their own
+		if(mesh->mPrimitiveTypes != aiPrimitiveType_TRIANGLE)
+		{
+			continue;
+		}
+
+		meshes.push_back(mesh);
+		first_vertices.push_back(load_data.vertex_count);
+		first_faces.push_back(load_data.triangle_data.size());
+		load_data.vertex_count += mesh->mNumVertices;
+		load_data.triangle_data.resize(load_data.triangle_data.size() + mesh->mNumFaces);
+		load_data.material_count = std::max(load_data.material_count, mesh->mMaterialIndex + 1);
+	}
+	load_data.triangle_count = static_cast<std::uint32_t>(load_data.triangle_data.size());
+	load_data.vertex_data.resize(load_data.vertex_count * load_data.vertex_format.getStride());
+
+	const auto process = [&](std::size_t i) {
+		process_mesh(meshes[i], first_vertices[i], first_faces[i], load_data);
+	};
+	if(core::has_subsystems<core::task_system>())
+	{
+		auto& ts = core::get_subsystem<core::task_system>();
+		core::parallel_for(ts, std::size_t(0), meshes.size(), std::size_t(1), process);
+	}
+	else
+	{
+		for(std::size_t i = 0; i < meshes.size(); ++i)
+		{
+			process(i);
+		}
+	}
+
+	for(std::size_t i = 0; i < meshes.size(); ++i)
+	{
+		process_bones(meshes[i], first_vertices[i], load_data);
 	}
 }
 
@@ -336,11 +395,14 @@ bool importer::load_mesh_data_from_file(const std::string& path, mesh::load_data
 	Assimp::Importer importer;
 	importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, aiComponent_CAMERAS | aiComponent_LIGHTS);
 
+	// The identical vertices are joined and the faces ordered for the vertex
+	// cache here, the loading prepares the meshes without welding and
+	// optimizing. Large meshes are not split, the indices are 32 bits.
 	const aiScene* scene = importer.ReadFile(
 		path, aiProcess_ConvertToLeftHanded | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals |
 				  aiProcess_JoinIdenticalVertices | aiProcess_ImproveCacheLocality |
 				  aiProcess_LimitBoneWeights | aiProcess_RemoveRedundantMaterials |
-				  aiProcess_SplitLargeMeshes | aiProcess_Triangulate | aiProcess_GenUVCoords |
+				  aiProcess_Triangulate | aiProcess_GenUVCoords |
 				  aiProcess_SortByPType | aiProcess_FindDegenerates | aiProcess_FindInvalidData |
 				  aiProcess_FindInstances | aiProcess_ValidateDataStructure | aiProcess_OptimizeMeshes);
 
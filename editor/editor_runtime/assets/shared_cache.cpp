@@ -0,0 +1,95 @@
+#include "shared_cache.h"
+
+#include <core/uuid/uuid.hpp>
+
+#include <cstdio>
+#include <mutex>
+
+namespace asset_compiler
+{
+namespace
+{
+std::mutex& get_mutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
+fs::path& get_directory()
+{
+	static fs::path directory;
+	return directory;
+}
+
+fs::path get_entry_path(std::uint64_t key)
+{
+	char name[17] = {};
+	std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+
+	std::lock_guard<std::mutex> lock(get_mutex());
+	return get_directory() / std::string(name, 2) / name;
+}
+
+// copies under a temporary name next to the destination and renames it
+bool copy_whole(const fs::path& from, const fs::path& to)
+{
+	fs::error_code err;
+	fs::create_directories(to.parent_path(), err);
+
+	fs::path temp = to;
+	temp += "." + uuids::random_uuid().to_string() + ".part";
+	if(!fs::copy_file(from, temp, fs::copy_options::overwrite_existing, err) || err)
+	{
+		fs::remove(temp, err);
+		return false;
+	}
+
+	fs::rename(temp, to, err);
+	if(err)
+	{
+		fs::remove(temp, err);
+		return false;
+	}
+	return true;
+}
+}
+
+void shared_cache::set_directory(const fs::path& directory)
+{
+	std::lock_guard<std::mutex> lock(get_mutex());
+	get_directory() = directory;
+}
+
+bool shared_cache::is_enabled()
+{
+	std::lock_guard<std::mutex> lock(get_mutex());
+	return !get_directory().empty();
+}
+
+bool shared_cache::fetch(std::uint64_t key, const fs::path& output)
+{
+	if(!is_enabled())
+	{
+		return false;
+	}
+
+	const auto entry = get_entry_path(key);
+	fs::error_code err;
+	return fs::exists(entry, err) && copy_whole(entry, output);
+}
+
+void shared_cache::store(std::uint64_t key, const fs::path& output)
+{
+	if(!is_enabled())
+	{
+		return;
+	}
+
+	const auto entry = get_entry_path(key);
+	fs::error_code err;
+	if(!fs::exists(entry, err))
+	{
+		copy_whole(output, entry);
+	}
+}
+}
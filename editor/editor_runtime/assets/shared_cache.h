@@ -0,0 +1,55 @@
+#pragma once
+#include <core/filesystem/filesystem.h>
+
+#include <cstdint>
+
+namespace asset_compiler
+{
+/*
+ * shared_cache; compiled outputs by the key of what they were compiled
+ * from, in a directory shared by the machines that compile the same
+ * assets, e.g. on a network drive, so that one of them compiles an asset
+ * and the others copy it.
+ *
+ *      An output is stored at <directory>/<first two digits>/<key> with the
+ *      key in hex. It is copied in under a temporary name and renamed, so
+ *      an output in there is always whole.
+ */
+class shared_cache
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : set_directory ()
+	/// <summary>
+	/// Sets the shared directory, empty to not use one.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void set_directory(const fs::path& directory);
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_enabled ()
+	/// <summary>
+	/// Whether there is a shared directory.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool is_enabled();
+
+	//-----------------------------------------------------------------------------
+	//  Name : fetch ()
+	/// <summary>
+	/// Copies the output of the key to the output path, false when the cache
+	/// does not have it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool fetch(std::uint64_t key, const fs::path& output);
+
+	//-----------------------------------------------------------------------------
+	//  Name : store ()
+	/// <summary>
+	/// Copies the compiled output into the cache under the key unless another
+	/// machine already did.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void store(std::uint64_t key, const fs::path& output);
+};
+}
@@ -0,0 +1,284 @@
+#include "thumbnail_cache.h"
+#include "build_cache.h"
+
+#include <bimg/bimg.h>
+#include <bimg/decode.h>
+#include <bx/allocator.h>
+#include <bx/error.h>
+
+#include <core/graphics/graphics.h>
+#include <core/logging/logging.h>
+#include <core/system/subsystem.h>
+#include <core/tasks/task_system.h>
+#include <core/uuid/uuid.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace editor
+{
+constexpr std::uint32_t thumbnail_cache::thumbnail_size;
+constexpr std::uint32_t thumbnail_cache::version;
+
+namespace
+{
+/// what a preview file starts with
+const char thumbnail_tag[4] = {'t', 'h', 'm', 'b'};
+
+struct thumbnail
+{
+	std::uint32_t width = 0;
+	std::uint32_t height = 0;
+	/// bgra8, row after row
+	std::vector<std::uint8_t> pixels;
+};
+
+// averages the source pixels every destination pixel covers
+void scale_down_bgra8(const std::uint8_t* src, std::uint32_t src_width, std::uint32_t src_height,
+					  thumbnail& dst)
+{
+	dst.pixels.resize(std::size_t(dst.width) * dst.height * 4);
+	for(std::uint32_t y = 0; y < dst.height; ++y)
+	{
+		const auto row_begin = y * src_height / dst.height;
+		const auto row_end = std::max(row_begin + 1, (y + 1) * src_height / dst.height);
+		for(std::uint32_t x = 0; x < dst.width; ++x)
+		{
+			const auto column_begin = x * src_width / dst.width;
+			const auto column_end = std::max(column_begin + 1, (x + 1) * src_width / dst.width);
+
+			std::uint64_t sum[4] = {};
+			for(auto row = row_begin; row < row_end; ++row)
+			{
+				const auto* pixel = src + (std::size_t(row) * src_width + column_begin) * 4;
+				for(auto column = column_begin; column < column_end; ++column, pixel += 4)
+				{
+					sum[0] += pixel[0];
+					sum[1] += pixel[1];
+					sum[2] += pixel[2];
+					sum[3] += pixel[3];
+				}
+			}
+
+			const auto count = std::uint64_t(row_end - row_begin) * (column_end - column_begin);
+			auto* out = &dst.pixels[(std::size_t(y) * dst.width + x) * 4];
+			for(std::size_t c = 0; c < 4; ++c)
+			{
+				out[c] = std::uint8_t(sum[c] / count);
+			}
+		}
+	}
+}
+
+bool make_thumbnail(const fs::path& image_path, thumbnail& result)
+{
+	std::ifstream stream(image_path.string(), std::ios::in | std::ios::binary);
+	if(!stream.is_open())
+	{
+		return false;
+	}
+	const auto data = fs::read_stream(stream);
+
+	bx::DefaultAllocator allocator;
+	bx::Error err;
+	auto image = bimg::imageParse(&allocator, data.data(), std::uint32_t(data.size()),
+								  bimg::TextureFormat::BGRA8, &err);
+	if(image == nullptr)
+	{
+		return false;
+	}
+
+	bimg::ImageMip mip;
+	const bool has_mip = bimg::imageGetRawData(*image, 0, 0, image->m_data, image->m_size, mip);
+	if(has_mip && mip.m_width > 0 && mip.m_height > 0)
+	{
+		const auto biggest = std::max(mip.m_width, mip.m_height);
+		const auto size = std::min(biggest, thumbnail_cache::thumbnail_size);
+		result.width = std::max(1u, mip.m_width * size / biggest);
+		result.height = std::max(1u, mip.m_height * size / biggest);
+		scale_down_bgra8(mip.m_data, mip.m_width, mip.m_height, result);
+	}
+	bimg::imageFree(image);
+	return !result.pixels.empty();
+}
+
+bool read_thumbnail(const fs::path& path, thumbnail& result)
+{
+	std::ifstream stream(path.string(), std::ios::in | std::ios::binary);
+	char tag[4] = {};
+	stream.read(tag, sizeof(tag));
+	stream.read(reinterpret_cast<char*>(&result.width), sizeof(result.width));
+	stream.read(reinterpret_cast<char*>(&result.height), sizeof(result.height));
+	if(!stream || std::memcmp(tag, thumbnail_tag, sizeof(tag)) != 0 || result.width == 0 ||
+	   result.height == 0 || result.width > thumbnail_cache::thumbnail_size ||
+	   result.height > thumbnail_cache::thumbnail_size)
+	{
+		return false;
+	}
+
+	result.pixels.resize(std::size_t(result.width) * result.height * 4);
+	stream.read(reinterpret_cast<char*>(result.pixels.data()), std::streamsize(result.pixels.size()));
+	return bool(stream);
+}
+
+// writes under a temporary name and renames it, so a preview on disk is
+// always whole even with two editors on the project
+void write_thumbnail(const fs::path& path, const thumbnail& t)
+{
+	fs::error_code err;
+	fs::create_directories(path.parent_path(), err);
+
+	fs::path temp = path;
+	temp += "." + uuids::random_uuid().to_string() + ".part";
+	{
+		std::ofstream stream(temp.string(), std::ios::out | std::ios::binary);
+		stream.write(thumbnail_tag, sizeof(thumbnail_tag));
+		stream.write(reinterpret_cast<const char*>(&t.width), sizeof(t.width));
+		stream.write(reinterpret_cast<const char*>(&t.height), sizeof(t.height));
+		stream.write(reinterpret_cast<const char*>(t.pixels.data()), std::streamsize(t.pixels.size()));
+		if(!stream)
+		{
+			stream.close();
+			fs::remove(temp, err);
+			return;
+		}
+	}
+
+	fs::rename(temp, path, err);
+	if(err)
+	{
+		fs::remove(temp, err);
+	}
+}
+
+fs::path get_thumbnail_path(std::uint64_t key)
+{
+	char name[17] = {};
+	std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+	return fs::resolve_protocol("app:/thumbnails") / std::string(name, 2) / name;
+}
+}
+
+struct thumbnail_cache::state
+{
+	struct entry
+	{
+		/// what the file was when the preview was started
+		std::uintmax_t size = 0;
+		fs::file_time_type time;
+		/// made on a worker, waiting for its texture
+		std::unique_ptr<thumbnail> ready;
+		bool pending = false;
+		asset_handle<gfx::texture> texture;
+	};
+
+	std::mutex mutex;
+	std::unordered_map<std::string, entry> entries;
+};
+
+thumbnail_cache::thumbnail_cache()
+	: state_(std::make_shared<state>())
+{
+}
+
+thumbnail_cache::~thumbnail_cache() = default;
+
+asset_handle<gfx::texture> thumbnail_cache::get_texture_thumbnail(const fs::path& absolute_path,
+																   bool& is_loading)
+{
+	is_loading = false;
+	fs::error_code err;
+	const auto size = fs::file_size(absolute_path, err);
+	const auto time = fs::last_write_time(absolute_path, err);
+	if(err)
+	{
+		return {};
+	}
+
+	std::unique_ptr<thumbnail> ready;
+	{
+		std::lock_guard<std::mutex> lock(state_->mutex);
+		auto& e = state_->entries[absolute_path.string()];
+		const bool changed = e.size != size || e.time != time;
+		if(!changed || e.pending)
+		{
+			if(!e.ready)
+			{
+				is_loading = e.pending;
+				return e.texture;
+			}
+			ready = std::move(e.ready);
+		}
+		else
+		{
+			e.size = size;
+			e.time = time;
+			e.pending = true;
+
+			// the key hashes the contents, made on the worker as well
+			std::weak_ptr<state> weak_state = state_;
+			const auto key = absolute_path.string();
+			auto& ts = core::get_subsystem<core::task_system>();
+			ts.push_on_worker_thread_with_priority(core::task_priority::background, [weak_state, key]() {
+				const auto seed = std::uint64_t(version) << 32 | thumbnail_size;
+				const auto hash = asset_compiler::build_cache::hash_file(key, seed);
+				const auto thumbnail_path = get_thumbnail_path(hash);
+
+				auto made = std::make_unique<thumbnail>();
+				bool ok = read_thumbnail(thumbnail_path, *made);
+				if(!ok)
+				{
+					made = std::make_unique<thumbnail>();
+					ok = make_thumbnail(key, *made);
+					if(ok)
+					{
+						write_thumbnail(thumbnail_path, *made);
+					}
+				}
+
+				auto s = weak_state.lock();
+				if(!s)
+				{
+					return;
+				}
+				std::lock_guard<std::mutex> lock(s->mutex);
+				auto it = s->entries.find(key);
+				if(it == std::end(s->entries))
+				{
+					return;
+				}
+				it->second.pending = false;
+				if(ok)
+				{
+					it->second.ready = std::move(made);
+				}
+			});
+			is_loading = true;
+			return e.texture;
+		}
+	}
+
+	// created here, the thread the dock renders on
+	const auto* memory = gfx::copy(ready->pixels.data(), std::uint32_t(ready->pixels.size()));
+	auto texture = std::make_shared<gfx::texture>(
+		std::uint16_t(ready->width), std::uint16_t(ready->height), false, 1, gfx::texture_format::BGRA8,
+		BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP, memory);
+
+	std::lock_guard<std::mutex> lock(state_->mutex);
+	auto& e = state_->entries[absolute_path.string()];
+	// a new handle, the previous one may still be drawn from
+	e.texture = asset_handle<gfx::texture>();
+	e.texture = texture;
+	return e.texture;
+}
+
+void thumbnail_cache::clear()
+{
+	std::lock_guard<std::mutex> lock(state_->mutex);
+	state_->entries.clear();
+}
+}
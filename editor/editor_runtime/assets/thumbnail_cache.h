@@ -0,0 +1,58 @@
+#pragma once
+#include <core/filesystem/filesystem.h>
+#include <core/graphics/texture.h>
+#include <runtime/assets/asset_handle.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace editor
+{
+/*
+ * thumbnail_cache; small previews of the images of the project, for the
+ * project dock to not draw the full textures.
+ *
+ *      A preview is made on a worker from the source image, scaled down to
+ *      fit thumbnail_size, and kept on disk under :/thumbnails by the hash
+ *      of the contents of the image, so that it is made once per contents
+ *      and found again after a rename or a restart. Textures are created on
+ *      the calling thread from the previews that are ready, only for what
+ *      is asked for, i.e. what is on screen.
+ */
+class thumbnail_cache
+{
+public:
+	/// the size the previews fit in
+	static constexpr std::uint32_t thumbnail_size = 128;
+	/// the version of the files on disk, bumped when they change
+	static constexpr std::uint32_t version = 1;
+
+	thumbnail_cache();
+	~thumbnail_cache();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_texture_thumbnail ()
+	/// <summary>
+	/// The preview of the image file, an empty handle while it is being made,
+	/// which is_loading tells, or when it can't be. Starts making it the first
+	/// time it is asked for and again after the file changed, the previous one
+	/// is returned meanwhile.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	asset_handle<gfx::texture> get_texture_thumbnail(const fs::path& absolute_path, bool& is_loading);
+
+	//-----------------------------------------------------------------------------
+	//  Name : clear ()
+	/// <summary>
+	/// Releases the previews in memory, those on disk are kept.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void clear();
+
+private:
+	struct state;
+	/// shared with the workers, which may outlive the cache
+	std::shared_ptr<state> state_;
+};
+}
@@ -1,36 +1,32 @@
 #include "console_log.h"
 #include <map>
 
+constexpr std::uint64_t console_log::capacity;
+constexpr std::size_t console_log::max_message_size;
+
 void console_log::_sink_it(const logging::details::log_msg& msg)
 {
-	{
-		std::lock_guard<std::recursive_mutex> lock(entries_mutex_);
-		entries_.push_back({msg.formatted.c_str(), msg.level});
-	}
-	has_new_entries_ = true;
-}
+	const auto sequence = next_.fetch_add(1, std::memory_order_relaxed);
+	auto& s = slots_[sequence % capacity];
 
-void console_log::_flush()
-{
+	// odd while written, so that a reader of the slot sees it changed
+	s.stamp.store(2 * sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	const auto size = std::min<std::size_t>(msg.formatted.size(), s.text.size());
+	std::memcpy(s.text.data(), msg.formatted.data(), size);
+	s.size = std::uint32_t(size);
+	s.level = msg.level;
+	s.stamp.store(2 * (sequence + 1), std::memory_order_release);
 }
 
-console_log::entries_t console_log::get_items()
+void console_log::_flush()
 {
-	entries_t items_copy;
-	{
-		std::lock_guard<std::recursive_mutex> lock(entries_mutex_);
-		items_copy = entries_;
-	}
-	return items_copy;
 }
 
 void console_log::clear_log()
 {
-	{
-		std::lock_guard<std::recursive_mutex> lock(entries_mutex_);
-		entries_.clear();
-	}
-	has_new_entries_ = false;
+	cleared_.store(next_.load(std::memory_order_acquire), std::memory_order_release);
 }
 
 const std::array<float, 4>& console_log::get_level_colorization(logging::level::level_enum level)
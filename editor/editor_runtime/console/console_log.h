@@ -3,24 +3,41 @@
 #include <core/common/nonstd/ring_buffer.hpp>
 #include <core/console/console.h>
 #include <core/logging/logging.h>
+#include <spdlog/details/null_mutex.h>
 
+#include <algorithm>
 #include <array>
 #include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <string>
 
-class console_log : public logging::sinks::base_sink<std::mutex>, public console
+/*
+ * console_log; the sink of the log messages the console shows.
+ *
+ *      The messages are copied into a fixed pool of slots, the last
+ *      capacity of them, without a lock and without allocating. Every
+ *      message has a sequence number, the readers ask for what came after
+ *      the last one they read, so nothing is copied twice. A slot is
+ *      stamped before and after it is written, which a reader checks to
+ *      skip a slot overwritten while it was read.
+ */
+class console_log : public logging::sinks::base_sink<logging::details::null_mutex>, public console
 {
 public:
 	template <typename T>
 	using ring_buffer = nonstd::stack_ringbuffer<T, 150>;
 	using entries_t = ring_buffer<std::pair<std::string, logging::level::level_enum>>;
 
+	/// the messages kept, a power of two
+	static constexpr std::uint64_t capacity = 1024;
+	/// the longest message kept, longer ones are cut
+	static constexpr std::size_t max_message_size = 1024;
+
 	//-----------------------------------------------------------------------------
 	//  Name : _sink_it ()
 	/// <summary>
-	///
-	///
-	///
+	/// Copies the message into the next slot, from any thread.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void _sink_it(const logging::details::log_msg& msg) override;
@@ -36,56 +53,100 @@ public:
 	void _flush() override;
 
 	//-----------------------------------------------------------------------------
-	//  Name : get_items ()
+	//  Name : read ()
 	/// <summary>
-	///
-	///
-	///
+	/// Calls fn(sequence, level, text, size) for the messages from the sequence
+	/// on which are still kept and not cleared, in order, and returns the
+	/// sequence to read from the next time. The text is only valid in the call.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	entries_t get_items();
+	template <typename F>
+	std::uint64_t read(std::uint64_t sequence, F&& fn) const;
 
 	//-----------------------------------------------------------------------------
 	//  Name : clearLog ()
 	/// <summary>
-	///
-	///
-	///
+	/// Hides the messages logged so far from the reads.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void clear_log();
 
 	//-----------------------------------------------------------------------------
-	//  Name : get_pending_entries ()
+	//  Name : get_cleared_sequence ()
 	/// <summary>
-	///
-	///
-	///
+	/// The sequence of the first message after the last clear.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	inline bool has_new_entries() const
+	inline std::uint64_t get_cleared_sequence() const
 	{
-		return has_new_entries_;
+		return cleared_.load(std::memory_order_acquire);
 	}
 
-	const std::array<float, 4>& get_level_colorization(logging::level::level_enum level);
 	//-----------------------------------------------------------------------------
-	//  Name : set_pending_entries ()
+	//  Name : get_sequence ()
 	/// <summary>
-	///
-	///
-	///
+	/// The sequence the next message will take.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	inline void set_has_new_entries(bool val)
+	inline std::uint64_t get_sequence() const
 	{
-		has_new_entries_ = val;
+		return next_.load(std::memory_order_acquire);
 	}
 
+	const std::array<float, 4>& get_level_colorization(logging::level::level_enum level);
+
 private:
-	std::recursive_mutex entries_mutex_;
-	///
-	entries_t entries_;
-	///
-	std::atomic<bool> has_new_entries_ = {false};
+	struct slot
+	{
+		/// 2 * (sequence + 1) once written, odd while being written
+		std::atomic<std::uint64_t> stamp = {0};
+		logging::level::level_enum level = logging::level::info;
+		std::uint32_t size = 0;
+		std::array<char, max_message_size> text;
+	};
+
+	/// the sequence the next message takes
+	std::atomic<std::uint64_t> next_ = {0};
+	std::atomic<std::uint64_t> cleared_ = {0};
+	std::array<slot, capacity> slots_;
 };
+
+template <typename F>
+std::uint64_t console_log::read(std::uint64_t sequence, F&& fn) const
+{
+	const auto end = next_.load(std::memory_order_acquire);
+	auto begin = std::max(sequence, get_cleared_sequence());
+	if(end > capacity)
+	{
+		begin = std::max(begin, end - capacity);
+	}
+
+	std::array<char, max_message_size> text;
+	for(auto at = begin; at < end; ++at)
+	{
+		const auto& s = slots_[at % capacity];
+		const auto written = 2 * (at + 1);
+		const auto before = s.stamp.load(std::memory_order_acquire);
+		if(before < written)
+		{
+			// taken but not written yet, read from it the next time
+			return at;
+		}
+		if(before != written)
+		{
+			// overwritten by a later message
+			continue;
+		}
+
+		const auto level = s.level;
+		const auto size = std::min<std::size_t>(s.size, text.size());
+		std::memcpy(text.data(), s.text.data(), size);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if(s.stamp.load(std::memory_order_relaxed) != written)
+		{
+			continue;
+		}
+		fn(at, level, text.data(), size);
+	}
+	return end;
+}
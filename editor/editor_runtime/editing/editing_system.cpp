@@ -1,6 +1,7 @@
 #include "editing_system.h"
 
 #include <core/graphics/texture.h>
+#include <core/logging/logging.h>
 #include <core/system/subsystem.h>
 
 #include <runtime/assets/asset_manager.h>
@@ -8,11 +9,15 @@
 #include <runtime/ecs/components/camera_component.h>
 #include <runtime/ecs/components/transform_component.h>
 #include <runtime/ecs/constructs/utils.h>
+#include <runtime/ecs/systems/scene_graph.h>
 #include <runtime/rendering/material.h>
 #include <runtime/rendering/mesh.h>
 #include <runtime/rendering/render_window.h>
 #include <runtime/system/events.h>
 
+#include <algorithm>
+#include <chrono>
+
 namespace editor
 {
 
@@ -43,6 +48,8 @@ editing_system::editing_system()
 	icons["sound"] = am.load<gfx::texture>("editor:/data/icons/sound.png").get();
 }
 
+editing_system::~editing_system() = default;
+
 void editing_system::save_editor_camera()
 {
 	if(camera)
@@ -80,6 +87,51 @@ void editing_system::load_editor_camera()
 void editing_system::select(rttr::variant object)
 {
 	selection_data.object = object;
+	selection_data.others.clear();
+}
+
+void editing_system::toggle_select(runtime::entity e)
+{
+	auto& object = selection_data.object;
+	auto& others = selection_data.others;
+	if(!object || !object.is_type<runtime::entity>())
+	{
+		select(e);
+		return;
+	}
+
+	if(object.get_value<runtime::entity>() == e)
+	{
+		if(others.empty())
+		{
+			unselect();
+			return;
+		}
+		object = others.back();
+		others.pop_back();
+		return;
+	}
+
+	auto it = std::find(std::begin(others), std::end(others), e);
+	if(it != std::end(others))
+	{
+		others.erase(it);
+		return;
+	}
+	others.emplace_back(object.get_value<runtime::entity>());
+	object = e;
+}
+
+bool editing_system::is_selected(runtime::entity e) const
+{
+	const auto& object = selection_data.object;
+	if(!object || !object.is_type<runtime::entity>())
+	{
+		return false;
+	}
+	const auto& others = selection_data.others;
+	return object.get_value<runtime::entity>() == e ||
+		   std::find(std::begin(others), std::end(others), e) != std::end(others);
 }
 
 void editing_system::unselect()
@@ -89,8 +141,69 @@ void editing_system::unselect()
 	imguizmo::enable(true);
 }
 
+void editing_system::play()
+{
+	if(playing_)
+	{
+		return;
+	}
+
+	auto& sg = core::get_subsystem<runtime::scene_graph>();
+	std::vector<runtime::entity> roots;
+	for(const auto& root : sg.get_roots())
+	{
+		if(root.valid() && root != camera)
+		{
+			roots.emplace_back(root);
+		}
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	auto snapshot = std::make_unique<ecs::utils::snapshot>();
+	if(!snapshot->take(roots))
+	{
+		APPLOG_ERROR("The scene can't be kept, play mode was not entered.");
+		return;
+	}
+	playing_ = std::move(snapshot);
+	// the scene played is not edited, its edits can't be undone after it
+	undo.clear();
+
+	const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+	APPLOG_INFO("Entered play mode in {0:.2f} ms.", elapsed.count());
+}
+
+void editing_system::stop()
+{
+	if(!playing_)
+	{
+		return;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+	unselect();
+	save_editor_camera();
+	ecs.dispose();
+	load_editor_camera();
+	playing_->restore();
+	playing_.reset();
+	undo.clear();
+
+	const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+	APPLOG_INFO("Left play mode in {0:.2f} ms.", elapsed.count());
+}
+
+void editing_system::discard_play()
+{
+	playing_.reset();
+}
+
 void editing_system::close_project()
 {
+	// the scene of the project is let go, not brought back
+	discard_play();
+	undo.clear();
 	save_editor_camera();
 	unselect();
 	scene.clear();
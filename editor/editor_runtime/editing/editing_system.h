@@ -1,13 +1,24 @@
 #pragma once
 #include "../interface/docks/imguidock.h"
+#include "undo_stack.h"
 
 #include <core/math/math_includes.h>
 
 #include <runtime/assets/asset_handle.h>
 #include <runtime/ecs/ecs.h>
 
+#include <memory>
+
 class render_window;
 
+namespace ecs
+{
+namespace utils
+{
+class snapshot;
+}
+}
+
 namespace gfx
 {
 struct texture;
@@ -20,6 +31,9 @@ struct editing_system
 	struct selection
 	{
 		rttr::variant object;
+		/// the entities selected along with an entity object, edited
+		/// together with it
+		std::vector<runtime::entity> others;
 	};
 
 	struct snap
@@ -32,7 +46,7 @@ struct editing_system
 		float scale_snap = 0.1f;
 	};
 	editing_system();
-	~editing_system() = default;
+	~editing_system();
 
 	//-----------------------------------------------------------------------------
 	//  Name : save_editor_camera ()
@@ -70,6 +84,23 @@ struct editing_system
 	//-----------------------------------------------------------------------------
 	void unselect();
 
+	//-----------------------------------------------------------------------------
+	//  Name : toggle_select ()
+	/// <summary>
+	/// Adds the entity to the selection of entities, or takes it out when it
+	/// is in. The entity added last is the object of the selection.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void toggle_select(runtime::entity e);
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_selected ()
+	/// <summary>
+	/// Whether the entity is the object of the selection or one of the others.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool is_selected(runtime::entity e) const;
+
 	//-----------------------------------------------------------------------------
 	//  Name : try_unselect ()
 	/// <summary>
@@ -87,12 +118,44 @@ struct editing_system
 
 	void close_project();
 
+	//-----------------------------------------------------------------------------
+	//  Name : play ()
+	/// <summary>
+	/// Enters play mode, the scene is kept in a snapshot in memory.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void play();
+
+	//-----------------------------------------------------------------------------
+	//  Name : stop ()
+	/// <summary>
+	/// Leaves play mode and brings the scene back as it was when it entered.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void stop();
+
+	//-----------------------------------------------------------------------------
+	//  Name : discard_play ()
+	/// <summary>
+	/// Leaves play mode without bringing the scene back, for a scene that is
+	/// replaced. The snapshot is dropped.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void discard_play();
+
+	bool is_playing() const
+	{
+		return playing_ != nullptr;
+	}
+
 	/// editor camera
 	runtime::entity camera;
 	/// current scene
 	std::string scene;
 	/// enable editor grid
 	bool show_grid = true;
+	/// draw the bounds of every model in view, not only the selected one
+	bool show_all_bounds = false;
 	/// enable wireframe selection
 	bool wireframe_selection = true;
 	/// current manipulation gizmo operation.
@@ -105,5 +168,11 @@ struct editing_system
 	snap snap_data;
 	/// editor icons lookup map
 	std::unordered_map<std::string, asset_handle<gfx::texture>> icons;
+	/// the edits of the open scene, dropped with the entities they were made on
+	undo_stack undo;
+
+private:
+	/// the scene as it was before play mode, null out of it
+	std::unique_ptr<ecs::utils::snapshot> playing_;
 };
 }
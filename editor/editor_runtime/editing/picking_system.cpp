@@ -10,6 +10,7 @@
 #include <runtime/ecs/components/camera_component.h>
 #include <runtime/ecs/components/model_component.h>
 #include <runtime/ecs/components/transform_component.h>
+#include <runtime/ecs/systems/bounds_system.h>
 #include <runtime/input/input.h>
 #include <runtime/rendering/camera.h>
 #include <runtime/rendering/material.h>
@@ -61,6 +62,12 @@ void picking_system::frame_render(delta_t dt)
 											 pick_at, true))
 			return;
 
+		if(mode_ == pick_mode::cpu)
+		{
+			pick_cpu(pick_eye, pick_at - pick_eye);
+			return;
+		}
+
 		reading_ = 0;
 		start_readback_ = true;
 
@@ -81,35 +88,33 @@ void picking_system::frame_render(delta_t dt)
 		pass.set_view_proj(pick_view, pick_proj);
 		pass.bind(surface_.get());
 
-		ecs.for_each<transform_component, model_component>(
-			[this, &pass, &pick_frustum](runtime::entity e, transform_component& transform_comp_ref,
-										 model_component& model_comp_ref) {
-				auto& model = model_comp_ref.get_model();
-				if(!model.is_valid())
-					return;
-
-				const auto& world_transform = transform_comp_ref.get_transform();
-
-				auto mesh = model.get_lod(0);
-				if(!mesh)
-					return;
+		// Test the bounding boxes of the meshes
+		auto& bounds = core::get_subsystem<runtime::bounds_system>();
+		bounds.refresh();
+		std::vector<std::uint64_t> visible;
+		bounds.cull(pick_frustum, visible);
 
-				const auto& bounds = mesh->get_bounds();
-
-				// Test the bounding box of the mesh
-				if(!math::frustum::test_obb(pick_frustum, bounds, world_transform))
-					return;
-
-				auto entity_index = e.id().index();
-				std::uint32_t rr = (entity_index)&0xff;
-				std::uint32_t gg = (entity_index >> 8) & 0xff;
-				std::uint32_t bb = (entity_index >> 16) & 0xff;
-				math::vec4 color_id = {rr / 255.0f, gg / 255.0f, bb / 255.0f, 1.0f};
+		for(std::size_t i = 0; i < bounds.size(); ++i)
+		{
+			if(!runtime::bounds_system::is_visible(visible, i))
+				continue;
 
-				const auto& bone_transforms = model_comp_ref.get_bone_transforms();
-				model.render(pass.id, world_transform, bone_transforms, true, true, true, 0, 0,
-							 program_.get(), [&color_id](auto& p) { p.set_uniform("u_id", &color_id); });
-			});
+			auto& transform_comp_ref = *bounds.get_transform(i);
+			auto& model_comp_ref = *bounds.get_model(i);
+			auto& model = model_comp_ref.get_model();
+			const auto& world_transform = transform_comp_ref.get_transform();
+
+			auto entity_index = bounds.get_entity(i).id().index();
+			std::uint32_t rr = (entity_index)&0xff;
+			std::uint32_t gg = (entity_index >> 8) & 0xff;
+			std::uint32_t bb = (entity_index >> 16) & 0xff;
+			math::vec4 color_id = {rr / 255.0f, gg / 255.0f, bb / 255.0f, 1.0f};
+
+			const auto& bone_transforms = model_comp_ref.get_bone_transforms();
+			// the picking program reads the positions alone
+			model.render(pass.id, world_transform, bone_transforms, true, true, true, 0, 0, program_.get(),
+						 [&color_id](auto& p) { p.set_uniform("u_id", &color_id); }, true);
+		}
 	}
 
 	// If the user previously clicked, and we're done reading data from GPU, look at ID buffer on CPU
@@ -196,6 +201,52 @@ void picking_system::frame_render(delta_t dt)
 	}
 }
 
+void picking_system::pick_cpu(const math::vec3& origin, const math::vec3& segment)
+{
+	auto& es = core::get_subsystem<editing_system>();
+	auto& bounds = core::get_subsystem<runtime::bounds_system>();
+
+	const auto length = math::length(segment);
+	if(length <= 0.0f)
+		return;
+
+	bounds.refresh();
+	bounds.raycast(origin, segment / length, length, hits_);
+
+	// the fraction along the segment is kept by the transforms, so the nearest
+	// hit is compared across the meshes in their own spaces
+	float best = 1.0f;
+	runtime::entity picked;
+	for(const auto& box_hit : hits_)
+	{
+		// the boxes are nearest first, none further can hold a nearer triangle
+		if(box_hit.distance > best * length)
+			break;
+
+		auto& model = bounds.get_model(box_hit.entry)->get_model();
+		auto lod = model.get_lod(0);
+		if(!lod)
+			continue;
+
+		const auto& world_transform = bounds.get_transform(box_hit.entry)->get_transform();
+		const auto local_origin = world_transform.inverse_transform_coord(origin);
+		const auto local_segment = world_transform.inverse_transform_normal(segment);
+
+		math::triangle_bvh::hit triangle_hit;
+		if(lod->get_triangle_bvh().raycast(local_origin, local_segment, triangle_hit) &&
+		   triangle_hit.fraction < best)
+		{
+			best = triangle_hit.fraction;
+			picked = bounds.get_entity(box_hit.entry);
+		}
+	}
+
+	if(picked)
+		es.select(picked);
+	else
+		es.unselect();
+}
+
 picking_system::picking_system()
 {
 	runtime::on_frame_render.connect(this, &picking_system::frame_render);
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <core/common/basetypes.hpp>
+#include <core/math/math_includes.h>
 #include <runtime/assets/asset_handle.h>
+#include <runtime/ecs/systems/bounds_system.h>
 #include <runtime/rendering/gpu_program.h>
 
 namespace gfx
@@ -19,6 +21,27 @@ public:
 	~picking_system();
 
 	constexpr static int tex_id_dim = 1;
+
+	enum class pick_mode
+	{
+		/// the ray is tested against the triangles of the meshes, the pick
+		/// is known in the frame of the click
+		cpu,
+		/// the meshes are rendered into an id buffer which is read back,
+		/// picks what the shaders draw, skinned poses included
+		gpu
+	};
+
+	void set_pick_mode(pick_mode mode)
+	{
+		mode_ = mode;
+	}
+
+	pick_mode get_pick_mode() const
+	{
+		return mode_;
+	}
+
 	//-----------------------------------------------------------------------------
 	//  Name : frame_render ()
 	/// <summary>
@@ -30,6 +53,19 @@ public:
 	void frame_render(delta_t dt);
 
 private:
+	//-----------------------------------------------------------------------------
+	//  Name : pick_cpu ()
+	/// <summary>
+	/// Selects the entity whose triangles the segment goes through nearest to
+	/// its origin, unselects when there is none.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void pick_cpu(const math::vec3& origin, const math::vec3& segment);
+
+	/// how the clicks are picked
+	pick_mode mode_ = pick_mode::cpu;
+	/// the boxes the ray hits, kept between the clicks
+	std::vector<runtime::bounds_system::ray_hit> hits_;
 	/// surface used to render into
 	std::shared_ptr<gfx::frame_buffer> surface_;
 	///
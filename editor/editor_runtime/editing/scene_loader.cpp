@@ -0,0 +1,177 @@
+#include "scene_loader.h"
+#include "editing_system.h"
+
+#include <core/filesystem/filesystem.h>
+#include <core/logging/logging.h>
+#include <core/system/subsystem.h>
+
+#include <runtime/assets/asset_manager.h>
+#include <runtime/ecs/constructs/scene.h>
+#include <runtime/ecs/constructs/utils.h>
+#include <runtime/system/events.h>
+
+#include <iterator>
+
+namespace editor
+{
+scene_loader::scene_loader()
+{
+	runtime::on_frame_update.connect(this, &scene_loader::frame_update);
+}
+
+scene_loader::~scene_loader()
+{
+	runtime::on_frame_update.disconnect(this, &scene_loader::frame_update);
+}
+
+void scene_loader::load(const std::string& key)
+{
+	cancel();
+
+	auto& am = core::get_subsystem<runtime::asset_manager>();
+	key_ = key;
+	start_ = std::chrono::steady_clock::now();
+	scene_ = am.load<scene>(key);
+	stage_ = stage::assets;
+}
+
+void scene_loader::cancel()
+{
+	if(stage_ == stage::entities)
+	{
+		auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+		auto& es = core::get_subsystem<editing_system>();
+		es.unselect();
+		es.undo.clear();
+		ecs.destroy_many(entities_);
+		// the half of a scene must not be saved over the whole
+		es.scene.clear();
+		APPLOG_INFO("Opening the scene {0} was cancelled.", key_);
+	}
+
+	stage_ = stage::idle;
+	scene_ = {};
+	parsed_ = {};
+	loader_.reset();
+	entities_.clear();
+
+	// what only the last scene used is let go
+	core::get_subsystem<runtime::asset_manager>().request_sweep();
+}
+
+float scene_loader::get_progress() const
+{
+	if(stage_ != stage::entities || !loader_ || loader_->get_parts_count() == 0)
+	{
+		return 0.0f;
+	}
+	return float(loader_->get_parts_loaded()) / float(loader_->get_parts_count());
+}
+
+void scene_loader::frame_update(delta_t /*dt*/)
+{
+	if(stage_ == stage::assets)
+	{
+		if(!scene_.is_ready())
+		{
+			return;
+		}
+
+		auto handle = scene_.get();
+		if(!handle || !handle->data)
+		{
+			APPLOG_ERROR("Failed to open the scene {0}.", key_);
+			cancel();
+			return;
+		}
+
+		// copied here, the stream of the asset is not for the workers to read
+		auto& stream = *handle->data;
+		std::string data(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>{});
+		stream.clear();
+		stream.seekg(0);
+
+		auto& ts = core::get_subsystem<core::task_system>();
+		parsed_ = ts.push_on_worker_thread(
+			[data]() mutable -> std::shared_ptr<ecs::utils::data_loader> {
+				auto loader = std::make_shared<ecs::utils::data_loader>();
+				if(!loader->open(std::move(data)))
+				{
+					return nullptr;
+				}
+				return loader;
+			});
+		stage_ = stage::parse;
+		return;
+	}
+
+	if(stage_ == stage::parse)
+	{
+		if(!parsed_.is_ready())
+		{
+			return;
+		}
+
+		loader_ = parsed_.get();
+		parsed_ = {};
+		if(!loader_)
+		{
+			APPLOG_ERROR("Failed to read the scene {0}.", key_);
+			cancel();
+			return;
+		}
+
+		// only now is the open scene let go
+		auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+		auto& es = core::get_subsystem<editing_system>();
+		// play mode ends, there is no scene to go back to after this
+		es.discard_play();
+		es.unselect();
+		es.undo.clear();
+		es.save_editor_camera();
+		ecs.dispose();
+		es.load_editor_camera();
+		es.scene = fs::resolve_protocol(key_).string();
+		stage_ = stage::entities;
+	}
+
+	if(stage_ == stage::entities)
+	{
+		const auto frame_start = std::chrono::steady_clock::now();
+		while(loader_->load_next(entities_))
+		{
+			if(std::chrono::steady_clock::now() - frame_start >= budget_)
+			{
+				break;
+			}
+		}
+
+		if(loader_->is_done())
+		{
+			finish();
+		}
+	}
+}
+
+void scene_loader::finish()
+{
+	// the entities hold the assets they need now
+	auto handle = scene_.get();
+	if(handle)
+	{
+		handle->dependencies.clear();
+	}
+
+	const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_);
+	APPLOG_INFO("Opened the scene {0} with {1} entities in {2:.1f} ms.", key_, entities_.size(),
+				elapsed.count());
+
+	stage_ = stage::idle;
+	scene_ = {};
+	loader_.reset();
+	entities_.clear();
+
+	// what only the last scene used is let go
+	core::get_subsystem<runtime::asset_manager>().request_sweep();
+}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <core/common/basetypes.hpp>
+#include <core/tasks/task_system.h>
+
+#include <runtime/assets/asset_handle.h>
+#include <runtime/ecs/ecs.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct scene;
+
+namespace ecs
+{
+namespace utils
+{
+class data_loader;
+}
+}
+
+namespace editor
+{
+/*
+ * scene_loader; opens a scene in the editor without stopping it.
+ *
+ *      The scene asset and the assets it depends on load in the background,
+ *      then its data is parsed on a worker. Only then is the open scene let
+ *      go and the entities created, a part of the data at a time for as long
+ *      as the budget of a frame allows. Cancelling before the entities are
+ *      created keeps the open scene, after that it leaves an empty one.
+ */
+class scene_loader
+{
+public:
+	enum class stage
+	{
+		idle,
+		assets,
+		parse,
+		entities
+	};
+
+	scene_loader();
+	~scene_loader();
+
+	//-----------------------------------------------------------------------------
+	//  Name : load ()
+	/// <summary>
+	/// Starts opening the scene of the asset key, cancelling the one being
+	/// opened if any.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void load(const std::string& key);
+
+	void cancel();
+
+	bool is_loading() const
+	{
+		return stage_ != stage::idle;
+	}
+
+	stage get_stage() const
+	{
+		return stage_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_progress ()
+	/// <summary>
+	/// The part of the data whose entities are created, from 0 to 1.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	float get_progress() const;
+
+	const std::string& get_key() const
+	{
+		return key_;
+	}
+
+	/// the time of a frame spent creating entities, at least a part of the
+	/// data is loaded every frame
+	void set_frame_budget(std::chrono::microseconds budget)
+	{
+		budget_ = budget;
+	}
+
+private:
+	void frame_update(delta_t dt);
+	void finish();
+
+	stage stage_ = stage::idle;
+	std::string key_;
+	std::chrono::microseconds budget_ = std::chrono::microseconds(8000);
+	std::chrono::steady_clock::time_point start_;
+	core::task_future<asset_handle<scene>> scene_;
+	core::task_future<std::shared_ptr<ecs::utils::data_loader>> parsed_;
+	std::shared_ptr<ecs::utils::data_loader> loader_;
+	/// the entities created so far
+	std::vector<runtime::entity> entities_;
+};
+}
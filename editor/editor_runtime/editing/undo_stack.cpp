@@ -0,0 +1,154 @@
+#include "undo_stack.h"
+
+#include <algorithm>
+#include <string>
+
+namespace editor
+{
+namespace
+{
+bool is_same_target(const undo_stack::change& lhs, const undo_stack::change& rhs)
+{
+	return lhs.entity == rhs.entity && lhs.component_type == rhs.component_type &&
+		   lhs.property == rhs.property;
+}
+
+std::size_t get_value_bytes(const rttr::variant& value)
+{
+	std::size_t bytes = value.get_type().get_sizeof();
+	if(value.is_type<std::string>())
+	{
+		bytes += value.get_value<std::string>().capacity();
+	}
+	return bytes;
+}
+}
+
+void undo_stack::record(std::vector<change> changes)
+{
+	if(changes.empty())
+	{
+		return;
+	}
+
+	// what was undone is gone once something else is done
+	while(actions_.size() > done_)
+	{
+		bytes_ -= actions_.back().bytes;
+		actions_.pop_back();
+	}
+
+	if(open_ && !actions_.empty())
+	{
+		auto& last = actions_.back();
+		const bool same = last.changes.size() == changes.size() &&
+						  std::equal(std::begin(changes), std::end(changes), std::begin(last.changes),
+									 is_same_target);
+		if(same)
+		{
+			for(std::size_t i = 0; i < changes.size(); ++i)
+			{
+				last.changes[i].after = std::move(changes[i].after);
+			}
+			bytes_ -= last.bytes;
+			last.bytes = get_bytes(last.changes);
+			bytes_ += last.bytes;
+			return;
+		}
+	}
+
+	action a;
+	a.changes = std::move(changes);
+	a.bytes = get_bytes(a.changes);
+	bytes_ += a.bytes;
+	actions_.emplace_back(std::move(a));
+	done_ = actions_.size();
+	open_ = true;
+	trim();
+}
+
+bool undo_stack::undo()
+{
+	if(!can_undo())
+	{
+		return false;
+	}
+	open_ = false;
+	--done_;
+	apply(actions_[done_].changes, true);
+	return true;
+}
+
+bool undo_stack::redo()
+{
+	if(!can_redo())
+	{
+		return false;
+	}
+	open_ = false;
+	apply(actions_[done_].changes, false);
+	++done_;
+	return true;
+}
+
+void undo_stack::clear()
+{
+	actions_.clear();
+	done_ = 0;
+	bytes_ = 0;
+	open_ = false;
+}
+
+void undo_stack::set_memory_budget(std::size_t bytes)
+{
+	budget_ = bytes;
+	trim();
+}
+
+std::size_t undo_stack::get_bytes(const std::vector<change>& changes)
+{
+	std::size_t bytes = sizeof(action) + changes.capacity() * sizeof(change);
+	for(const auto& c : changes)
+	{
+		bytes += get_value_bytes(c.before) + get_value_bytes(c.after);
+	}
+	return bytes;
+}
+
+void undo_stack::apply(const std::vector<change>& changes, bool undo)
+{
+	// the last written is the first put back
+	const auto count = changes.size();
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		const auto& c = changes[undo ? count - 1 - i : i];
+		if(!c.entity.valid())
+		{
+			continue;
+		}
+
+		for(const auto& component_ptr : c.entity.all_components())
+		{
+			auto component = component_ptr.lock();
+			if(component && rttr::type::get(*component) == c.component_type)
+			{
+				rttr::variant component_var = component.get();
+				rttr::instance object = component_var;
+				c.property.set_value(object, undo ? c.before : c.after);
+				break;
+			}
+		}
+	}
+}
+
+void undo_stack::trim()
+{
+	// the action just recorded is kept whatever its size
+	while(bytes_ > budget_ && actions_.size() > 1)
+	{
+		bytes_ -= actions_.front().bytes;
+		actions_.pop_front();
+		done_ = done_ > 0 ? done_ - 1 : 0;
+	}
+}
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <core/reflection/reflection.h>
+
+#include <runtime/ecs/ecs.h>
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+namespace editor
+{
+/*
+ * undo_stack; the edits of the properties of components, undone and redone
+ * one action at a time.
+ *
+ *      An action is the properties written together, e.g. a field of the
+ *      inspector over every selected entity, each with the value it had and
+ *      the value it was given. Undo and redo only write those properties
+ *      back. The actions recorded until the stack is sealed, e.g. every frame
+ *      of a gizmo drag, are one action as long as they write the same
+ *      properties. The oldest actions are dropped past the memory budget.
+ */
+class undo_stack
+{
+public:
+	struct change
+	{
+		runtime::entity entity;
+		rttr::type component_type;
+		rttr::property property;
+		rttr::variant before;
+		rttr::variant after;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : record ()
+	/// <summary>
+	/// Records the changes of an action, after they were made. The actions
+	/// that were undone can't be redone after this.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void record(std::vector<change> changes);
+
+	//-----------------------------------------------------------------------------
+	//  Name : seal ()
+	/// <summary>
+	/// Ends the action being recorded, the next record starts another.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void seal()
+	{
+		open_ = false;
+	}
+
+	bool undo();
+	bool redo();
+
+	bool can_undo() const
+	{
+		return done_ > 0;
+	}
+
+	bool can_redo() const
+	{
+		return done_ < actions_.size();
+	}
+
+	void clear();
+
+	void set_memory_budget(std::size_t bytes);
+
+	std::size_t get_memory_used() const
+	{
+		return bytes_;
+	}
+
+private:
+	struct action
+	{
+		std::vector<change> changes;
+		std::size_t bytes = 0;
+	};
+
+	static std::size_t get_bytes(const std::vector<change>& changes);
+	static void apply(const std::vector<change>& changes, bool undo);
+	void trim();
+
+	/// the oldest first, the first done_ of them can be undone
+	std::deque<action> actions_;
+	std::size_t done_ = 0;
+	std::size_t bytes_ = 0;
+	std::size_t budget_ = 16 * 1024 * 1024;
+	/// the last action takes the next record of the same properties
+	bool open_ = false;
+};
+}
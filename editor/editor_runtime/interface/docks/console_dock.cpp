@@ -1,5 +1,4 @@
 #include "console_dock.h"
-#include "../../console/console_log.h"
 
 console_dock::console_dock(const std::string& dtitle, bool close_button, const ImVec2& min_size,
 						   const std::shared_ptr<console_log>& log)
@@ -43,9 +42,19 @@ void console_dock::render(const ImVec2&)
 	}
 	gui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(4, 1)); // Tighten spacing
 
-	const auto items = console_log_->get_items();
+	// only what was logged since the last frame is copied
+	if(cleared_ != console_log_->get_cleared_sequence())
+	{
+		cleared_ = console_log_->get_cleared_sequence();
+		entries_.clear();
+	}
+	const auto last_sequence = sequence_;
+	const auto on_entry = [this](std::uint64_t, logging::level::level_enum level, const char* text,
+								 std::size_t size) { entries_.push_back({std::string(text, size), level}); };
+	sequence_ = console_log_->read(sequence_, on_entry);
+	const bool has_new_entries = sequence_ != last_sequence;
 
-	for(const auto& pair_msg : items)
+	for(const auto& pair_msg : entries_)
 	{
 		const char* item_cstr = pair_msg.first.c_str();
 		if(!filter.PassFilter(item_cstr))
@@ -56,11 +65,9 @@ void console_dock::render(const ImVec2&)
 		gui::TextWrapped("%s", item_cstr);
 		gui::PopStyleColor();
 	}
-	if(console_log_->has_new_entries())
+	if(has_new_entries)
 		gui::SetScrollHereY();
 
-	console_log_->set_has_new_entries(false);
-
 	gui::PopStyleVar();
 	gui::EndChild();
 	gui::Separator();
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "imguidock.h"
+#include "../../console/console_log.h"
+
+#include <cstdint>
 #include <memory>
 
-class console_log;
 struct console_dock : public imguidock::dock
 {
 	console_dock(const std::string& dtitle, bool close_button, const ImVec2& min_size,
@@ -13,4 +15,10 @@ struct console_dock : public imguidock::dock
 
 private:
 	std::shared_ptr<console_log> console_log_;
+	/// the messages read from the log so far, the last ones of them
+	console_log::entries_t entries_;
+	/// the sequence of the next message to read
+	std::uint64_t sequence_ = 0;
+	/// the clear of the log the entries are after
+	std::uint64_t cleared_ = 0;
 };
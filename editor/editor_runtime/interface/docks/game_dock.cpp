@@ -28,6 +28,7 @@ void game_dock::render(const ImVec2&)
 			const auto surface = render_view.get_output_fbo(viewport_size);
 			auto tex = surface->get_attachment(0).texture;
 			gui::Image(gui::get_info(tex), size);
+			camera_comp.present();
 		}
 
 	});
@@ -0,0 +1,66 @@
+#include "heap_dock.h"
+
+#include <core/profiling/memory_tracker.h>
+
+namespace
+{
+double to_mb(std::uint64_t bytes)
+{
+	return double(bytes) / (1024.0 * 1024.0);
+}
+}
+
+heap_dock::heap_dock(const std::string& dtitle, bool close_button, const ImVec2& min_size)
+{
+	initialize(dtitle, close_button, min_size, std::bind(&heap_dock::render, this, std::placeholders::_1));
+}
+
+void heap_dock::render(const ImVec2& /*unused*/)
+{
+	if(!core::memory_tracker::is_enabled())
+	{
+		gui::TextUnformatted("Build with ETH_MEMORY_TRACKING to track the allocations.");
+		return;
+	}
+
+	const auto stats = core::memory_tracker::get_stats();
+	if(stats.spike)
+	{
+		gui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "FRAME: %llu allocations, %0.2f MB, SPIKE",
+						 static_cast<unsigned long long>(stats.frame_allocations), to_mb(stats.frame_bytes));
+	}
+	else
+	{
+		gui::Text("FRAME: %llu allocations, %0.2f MB",
+				  static_cast<unsigned long long>(stats.frame_allocations), to_mb(stats.frame_bytes));
+	}
+	gui::Text("%0.0f allocations a frame on average, %llu spikes", stats.average_allocations,
+			  static_cast<unsigned long long>(stats.spikes));
+
+	gui::PushFont("default");
+	gui::BeginColumns("heap_memory_tags", 6);
+	for(const char* header : {"Tag", "MB", "Peak MB", "Allocations", "Frame", "Frame KB"})
+	{
+		gui::TextUnformatted(header);
+		gui::NextColumn();
+	}
+	gui::Separator();
+	for(std::size_t i = 0; i < stats.tags.size(); ++i)
+	{
+		const auto& tag = stats.tags[i];
+		gui::TextUnformatted(core::get_memory_tag_name(core::memory_tag(i)));
+		gui::NextColumn();
+		gui::Text("%0.2f", to_mb(tag.live_bytes));
+		gui::NextColumn();
+		gui::Text("%0.2f", to_mb(tag.peak_bytes));
+		gui::NextColumn();
+		gui::Text("%llu", static_cast<unsigned long long>(tag.live_allocations));
+		gui::NextColumn();
+		gui::Text("%llu", static_cast<unsigned long long>(tag.frame_allocations));
+		gui::NextColumn();
+		gui::Text("%0.1f", double(tag.frame_bytes) / 1024.0);
+		gui::NextColumn();
+	}
+	gui::EndColumns();
+	gui::PopFont();
+}
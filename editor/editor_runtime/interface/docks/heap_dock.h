@@ -0,0 +1,10 @@
+#pragma once
+
+#include "imguidock.h"
+
+struct heap_dock : public imguidock::dock
+{
+	heap_dock(const std::string& dtitle, bool close_button, const ImVec2& min_size);
+
+	void render(const ImVec2& area);
+};
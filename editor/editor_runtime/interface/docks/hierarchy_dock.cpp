@@ -20,6 +20,11 @@
 #include <runtime/ecs/systems/scene_graph.h>
 #include <runtime/input/input.h>
 #include <runtime/rendering/mesh.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
 namespace
 {
 math::bbox calc_bounds(runtime::entity entity)
@@ -417,8 +422,9 @@ static void check_drag(runtime::entity entity)
 	}
 }
 
-void hierarchy_dock::draw_entity(runtime::entity entity)
+void hierarchy_dock::draw_row(const row& r)
 {
+	auto entity = r.entity;
 	if(!entity)
 	{
 		return;
@@ -436,11 +442,14 @@ void hierarchy_dock::draw_entity(runtime::entity entity)
 	{
 		is_selected = selected.get_value<runtime::entity>() == entity;
 	}
+	bool in_selection = is_selected || es.is_selected(entity);
 
 	std::string name = entity.to_string();
-	ImGuiTreeNodeFlags flags = 0 | ImGuiTreeNodeFlags_AllowItemOverlap | ImGuiTreeNodeFlags_OpenOnArrow;
+	// the rows are drawn flat, the tree is pushed by the indent of a row
+	ImGuiTreeNodeFlags flags = 0 | ImGuiTreeNodeFlags_AllowItemOverlap | ImGuiTreeNodeFlags_OpenOnArrow |
+							   ImGuiTreeNodeFlags_NoTreePushOnOpen;
 
-	if(is_selected)
+	if(in_selection)
 	{
 		flags |= ImGuiTreeNodeFlags_Selected;
 	}
@@ -457,21 +466,30 @@ void hierarchy_dock::draw_entity(runtime::entity entity)
 		}
 	}
 	auto trans_comp = entity.get_component<transform_component>().lock();
-	bool no_children = true;
-	if(trans_comp)
-	{
-		no_children = trans_comp->get_children().empty();
-	}
-
-	if(no_children)
+	if(!r.has_children)
 	{
 		flags |= ImGuiTreeNodeFlags_Leaf;
 	}
 
+	gui::SetCursorPosX(gui::GetCursorPosX() + float(r.depth) * gui::GetStyle().IndentSpacing);
 	auto pos = gui::GetCursorScreenPos();
 	gui::AlignTextToFramePadding();
 
+	const bool was_open = open_.count(entity) != 0;
+	gui::SetNextTreeNodeOpen(was_open);
 	bool opened = gui::TreeNodeEx(name.c_str(), flags);
+	if(r.has_children && opened != was_open)
+	{
+		if(opened)
+		{
+			open_.insert(entity);
+		}
+		else
+		{
+			open_.erase(entity);
+		}
+		rows_dirty_ = true;
+	}
 	if(!edit_label_)
 	{
 		check_drag(entity);
@@ -493,6 +511,7 @@ void hierarchy_dock::draw_entity(runtime::entity entity)
 		{
 			entity.set_name(input_buff.data());
 			edit_label_ = false;
+			names_dirty_ = true;
 		}
 
 		gui::PopItemWidth();
@@ -520,7 +539,16 @@ void hierarchy_dock::draw_entity(runtime::entity entity)
 			{
 				edit_label_ = false;
 			}
-			es.select(entity);
+			// ctrl adds the entity to the ones edited together
+			if(gui::GetIO().KeyCtrl)
+			{
+				edit_label_ = false;
+				es.toggle_select(entity);
+			}
+			else
+			{
+				es.select(entity);
+			}
 		}
 
 		if(gui::IsMouseDoubleClicked(0))
@@ -539,23 +567,6 @@ void hierarchy_dock::draw_entity(runtime::entity entity)
 		}
 	}
 
-	if(opened)
-	{
-		if(!no_children)
-		{
-			const auto& children = trans_comp->get_children();
-			for(auto& child : children)
-			{
-				if(child.valid())
-				{
-					draw_entity(child);
-				}
-			}
-		}
-
-		gui::TreePop();
-	}
-
 	gui::PopID();
 	gui::PopID();
 }
@@ -566,10 +577,43 @@ void hierarchy_dock::render(const ImVec2& /*unused*/)
 	auto& sg = core::get_subsystem<runtime::scene_graph>();
 	auto& input = core::get_subsystem<runtime::input>();
 
-	auto& roots = sg.get_roots();
 	auto& editor_camera = es.camera;
 	auto& selected = es.selection_data.object;
 
+	std::array<char, 64> search_buff;
+	search_buff.fill(0);
+	std::memcpy(search_buff.data(), search_.c_str(), std::min(search_.size(), search_buff.size() - 1));
+	if(gui::InputText("SEARCH", search_buff.data(), search_buff.size()))
+	{
+		search_ = string_utils::to_lower(search_buff.data());
+		rows_dirty_ = true;
+	}
+
+	// a selection made elsewhere, e.g. by picking, is shown in the tree
+	runtime::entity selected_entity;
+	if(selected && selected.is_type<runtime::entity>())
+	{
+		selected_entity = selected.get_value<runtime::entity>();
+	}
+	if(selected_entity != revealed_)
+	{
+		revealed_ = selected_entity;
+		if(selected_entity && search_.empty())
+		{
+			reveal(selected_entity);
+			refresh_rows();
+			for(std::size_t i = 0; i < rows_.size(); ++i)
+			{
+				if(rows_[i].entity == selected_entity)
+				{
+					scroll_to_ = int(i);
+					break;
+				}
+			}
+		}
+	}
+	refresh_rows();
+
 	ImGuiWindowFlags flags = ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoMove |
 							 ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoSavedSettings;
 
@@ -629,30 +673,164 @@ void hierarchy_dock::render(const ImVec2& /*unused*/)
 			}
 		}
 
-		if(editor_camera.valid())
+		if(editor_camera.valid() && search_.empty())
 		{
-			draw_entity(editor_camera);
+			row camera_row;
+			camera_row.entity = editor_camera;
+			draw_row(camera_row);
 			gui::Separator();
 		}
 
-		for(auto& root : roots)
+		const auto list_top = gui::GetCursorPosY();
+		if(scroll_to_ >= 0 && row_height_ > 0.0f)
 		{
-			if(root.valid())
+			const auto row_top = list_top + float(scroll_to_) * row_height_;
+			const auto scroll = gui::GetScrollY();
+			const auto height = gui::GetWindowHeight();
+			if(row_top < scroll || row_top + row_height_ > scroll + height)
 			{
-				if(root != editor_camera)
-				{
-					draw_entity(root);
-				}
+				gui::SetScrollY(std::max(0.0f, row_top - height * 0.5f));
+			}
+			scroll_to_ = -1;
+		}
+
+		// only the rows on screen are drawn, the rest are skipped over
+		ImGuiListClipper clipper(int(rows_.size()));
+		while(clipper.Step())
+		{
+			for(int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+			{
+				draw_row(rows_[std::size_t(i)]);
 			}
 		}
+		if(clipper.ItemsHeight > 0.0f)
+		{
+			row_height_ = clipper.ItemsHeight;
+		}
 	}
 	gui::EndChild();
 	process_drag_drop_target({});
 }
 
+void hierarchy_dock::refresh_rows()
+{
+	auto& es = core::get_subsystem<editor::editing_system>();
+	auto& sg = core::get_subsystem<runtime::scene_graph>();
+	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+
+	if(sg.get_version() != rows_version_)
+	{
+		rows_version_ = sg.get_version();
+		rows_dirty_ = true;
+		names_dirty_ = true;
+	}
+	if(ecs.get_names_version() != names_version_)
+	{
+		names_version_ = ecs.get_names_version();
+		names_dirty_ = true;
+		rows_dirty_ |= !search_.empty();
+	}
+	if(!rows_dirty_)
+	{
+		return;
+	}
+	rows_dirty_ = false;
+	rows_.clear();
+
+	if(!search_.empty())
+	{
+		if(names_dirty_)
+		{
+			std::vector<runtime::entity_name> names;
+			ecs.get_entity_names(names);
+			names_.clear();
+			names_.reserve(names.size());
+			for(const auto& name : names)
+			{
+				names_.push_back({name, string_utils::to_lower(name.str())});
+			}
+			names_dirty_ = false;
+		}
+
+		// the names are matched once each, their entities come from the index
+		std::vector<runtime::entity> found;
+		for(const auto& entry : names_)
+		{
+			if(entry.lower.find(search_) != std::string::npos)
+			{
+				ecs.find_entities_named(entry.name, found);
+			}
+		}
+		for(const auto entity : found)
+		{
+			if(entity != es.camera)
+			{
+				row r;
+				r.entity = entity;
+				rows_.push_back(r);
+			}
+		}
+		return;
+	}
+
+	// the destroyed entities are forgotten
+	for(auto it = std::begin(open_); it != std::end(open_);)
+	{
+		it = it->valid() ? std::next(it) : open_.erase(it);
+	}
+
+	for(const auto& root : sg.get_roots())
+	{
+		if(root.valid() && root != es.camera)
+		{
+			add_rows(root, 0);
+		}
+	}
+}
+
+void hierarchy_dock::add_rows(runtime::entity entity, std::uint32_t depth)
+{
+	row r;
+	r.entity = entity;
+	r.depth = depth;
+	auto trans_comp = entity.get_component<transform_component>().lock();
+	r.has_children = trans_comp && !trans_comp->get_children().empty();
+	rows_.push_back(r);
+
+	if(r.has_children && open_.count(entity) != 0)
+	{
+		for(const auto& child : trans_comp->get_children())
+		{
+			if(child.valid())
+			{
+				add_rows(child, depth + 1);
+			}
+		}
+	}
+}
+
+void hierarchy_dock::reveal(runtime::entity entity)
+{
+	auto trans_comp = entity.get_component<transform_component>().lock();
+	while(trans_comp)
+	{
+		const auto parent = trans_comp->get_parent();
+		if(!parent.valid())
+		{
+			break;
+		}
+		if(open_.insert(parent).second)
+		{
+			rows_dirty_ = true;
+		}
+		trans_comp = parent.get_component<transform_component>().lock();
+	}
+}
+
 hierarchy_dock::hierarchy_dock(const std::string& dtitle, bool close_button, const ImVec2& min_size)
 {
 
 	initialize(dtitle, close_button, min_size,
 			   std::bind(&hierarchy_dock::render, this, std::placeholders::_1));
+	cached = true;
 }
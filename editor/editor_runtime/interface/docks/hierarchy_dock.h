@@ -4,15 +4,82 @@
 
 #include <runtime/ecs/ecs.h>
 
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/*
+ * hierarchy_dock; the tree of the entities of the scene.
+ *
+ *      The rows the open nodes show are flattened into a list which is only
+ *      rebuilt when the hierarchy, the open nodes or the search change, and
+ *      only the rows on screen are drawn from it.
+ */
 struct hierarchy_dock : public imguidock::dock
 {
 	hierarchy_dock(const std::string& dtitle, bool close_button, const ImVec2& min_size);
 
 	void render(const ImVec2& area);
 
-	void draw_entity(runtime::entity entity);
-
 private:
+	struct row
+	{
+		runtime::entity entity;
+		/// how many parents the entity has under its root
+		std::uint32_t depth = 0;
+		bool has_children = false;
+	};
+
+	/// a name in use and the same in lower case, for the search
+	struct name_entry
+	{
+		runtime::entity_name name;
+		std::string lower;
+	};
+
+	void draw_row(const row& r);
+
+	//-----------------------------------------------------------------------------
+	//  Name : refresh_rows ()
+	/// <summary>
+	/// Rebuilds the rows if the hierarchy, the names being searched for, the
+	/// open nodes or the search changed since they were built.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void refresh_rows();
+	void add_rows(runtime::entity entity, std::uint32_t depth);
+
+	//-----------------------------------------------------------------------------
+	//  Name : reveal ()
+	/// <summary>
+	/// Opens the parents of the entity, so that it has a row.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void reveal(runtime::entity entity);
+
 	bool edit_label_ = false;
 	ImGuiID id_ = 0;
+
+	/// the rows of the open nodes, or of what was found
+	std::vector<row> rows_;
+	bool rows_dirty_ = true;
+	/// the versions of the scene graph and of the names the rows were built at
+	std::uint64_t rows_version_ = 0;
+	std::uint64_t names_version_ = 0;
+	/// the entities whose children are shown
+	std::unordered_set<runtime::entity> open_;
+
+	/// the names the entities have, each once, built when a search needs them
+	std::vector<name_entry> names_;
+	bool names_dirty_ = true;
+	/// what is searched for, in lower case, empty when nothing is
+	std::string search_;
+
+	/// the selection the rows were last revealed for
+	runtime::entity revealed_;
+	/// the row to scroll to in the next frame, -1 for none
+	int scroll_to_ = -1;
+	/// the height of a row, as the clipper measured it
+	float row_height_ = 0.0f;
 };
@@ -9,6 +9,10 @@
 #include <runtime/input/input.h>
 #include <runtime/rendering/renderer.h>
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
 namespace imguidock
 {
 dockspace::dockspace()
@@ -341,7 +345,7 @@ void dockspace::render_container(uint32_t& idgen, node* container, ImVec2 size,
 		screen_cursor_pos.y -= tabbar_height;
 
 		ImGui::BeginChild(idname.c_str(), calculated_size, false, ImGuiWindowFlags_AlwaysUseWindowPadding);
-		container->active_dock->draw_function(calculated_size);
+		container->active_dock->draw(calculated_size);
 		container->active_dock->last_size = calculated_size;
 
 		ImGui::EndChild();
@@ -988,4 +992,177 @@ void dock::initialize(const std::string& dtitle, bool close_btn, const ImVec2& m
 	min_size = ImVec2(std::max(min_size.x, min_sz.x), std::max(min_size.y, min_sz.y));
 	draw_function = ddrawFunction;
 }
+
+void dock::draw(const ImVec2& size)
+{
+	if(!cached)
+	{
+		draw_function(size);
+		return;
+	}
+
+	const auto pos = ImGui::GetWindowPos();
+	if(!needs_draw(pos, size))
+	{
+		cache.replay();
+		return;
+	}
+
+	auto draw_list = ImGui::GetWindowDrawList();
+	const auto index_begin = static_cast<std::uint32_t>(draw_list->IdxBuffer.Size);
+	const auto texture_begin = gui::GetTextures().size();
+	draw_function(size);
+
+	cache.valid = cache.capture(index_begin, texture_begin);
+	cache.pos = pos;
+	cache.size = size;
+	cache.hovered = ImGui::IsMouseHoveringRect(pos, pos + size, false);
+	cache.time = std::chrono::steady_clock::now();
+}
+
+bool dock::needs_draw(const ImVec2& pos, const ImVec2& size) const
+{
+	if(!cache.valid || cache.hovered || cache.pos.x != pos.x || cache.pos.y != pos.y ||
+	   cache.size.x != size.x || cache.size.y != size.y)
+	{
+		return true;
+	}
+
+	if(std::chrono::steady_clock::now() - cache.time >= refresh_interval)
+	{
+		return true;
+	}
+
+	const auto& io = ImGui::GetIO();
+	if(ImGui::IsMouseHoveringRect(pos, pos + size, false) || io.MouseWheel != 0.0f || io.WantTextInput)
+	{
+		return true;
+	}
+
+	const auto any_down = [](const bool* begin, const bool* end) {
+		return std::find(begin, end, true) != end;
+	};
+	if(any_down(std::begin(io.MouseDown), std::end(io.MouseDown)) ||
+	   any_down(std::begin(io.KeysDown), std::end(io.KeysDown)))
+	{
+		return true;
+	}
+
+	// the popups and the drags of the dock only last while it is drawn
+	const auto& context = *ImGui::GetCurrentContext();
+	if(ImGui::IsAnyItemActive() || context.OpenPopupStack.Size > 0 || context.DragDropActive)
+	{
+		return true;
+	}
+
+	// the indices are 16 bit, what does not fit is drawn anew
+	const auto draw_list = ImGui::GetWindowDrawList();
+	const auto max_vertices = std::size_t(1) << (sizeof(ImDrawIdx) * 8);
+	return draw_list->_VtxCurrentIdx + cache.vertices.size() >= max_vertices;
+}
+
+bool draw_cache::capture(std::uint32_t index_begin, std::size_t texture_begin)
+{
+	clear();
+	const auto& drawn = gui::GetTextures();
+	textures.assign(std::begin(drawn) + static_cast<std::ptrdiff_t>(std::min(texture_begin, drawn.size())),
+					std::end(drawn));
+
+	auto window = ImGui::GetCurrentWindow();
+	std::vector<std::pair<ImGuiWindow*, std::uint32_t>> windows = {{window, index_begin}};
+	// the child windows are drawn after the window they are in, in order
+	for(std::size_t i = 0; i < windows.size(); ++i)
+	{
+		auto current = windows[i].first;
+		for(auto child : current->DC.ChildWindows)
+		{
+			if(child->Active)
+			{
+				windows.emplace_back(child, 0);
+			}
+		}
+	}
+
+	for(const auto& entry : windows)
+	{
+		const auto draw_list = entry.first->DrawList;
+		std::uint32_t offset = 0;
+		for(const auto& cmd : draw_list->CmdBuffer)
+		{
+			if(cmd.UserCallback != nullptr)
+			{
+				clear();
+				return false;
+			}
+
+			const auto begin = std::max(offset, entry.second);
+			const auto end = offset + cmd.ElemCount;
+			offset = end;
+			if(begin >= end)
+			{
+				continue;
+			}
+
+			const auto first = draw_list->IdxBuffer.Data + begin;
+			const auto last = draw_list->IdxBuffer.Data + end;
+			const auto range = std::minmax_element(first, last);
+			const std::uint32_t min_index = *range.first;
+			const std::uint32_t max_index = *range.second;
+
+			command c;
+			c.clip_rect = cmd.ClipRect;
+			c.texture = cmd.TextureId;
+			c.vertex_begin = static_cast<std::uint32_t>(vertices.size());
+			c.vertex_count = max_index - min_index + 1;
+			c.index_begin = static_cast<std::uint32_t>(indices.size());
+			c.index_count = end - begin;
+			commands.emplace_back(c);
+
+			vertices.insert(std::end(vertices), draw_list->VtxBuffer.Data + min_index,
+							draw_list->VtxBuffer.Data + max_index + 1);
+			std::transform(first, last, std::back_inserter(indices),
+						   [min_index](ImDrawIdx index) { return ImDrawIdx(index - min_index); });
+		}
+	}
+
+	return true;
+}
+
+void draw_cache::replay() const
+{
+	for(const auto& texture : textures)
+	{
+		gui::KeepTexture(texture);
+	}
+
+	auto draw_list = ImGui::GetWindowDrawList();
+	for(const auto& c : commands)
+	{
+		draw_list->PushClipRect(ImVec2(c.clip_rect.x, c.clip_rect.y), ImVec2(c.clip_rect.z, c.clip_rect.w));
+		draw_list->PushTextureID(c.texture);
+		draw_list->PrimReserve(static_cast<int>(c.index_count), static_cast<int>(c.vertex_count));
+
+		const auto base = draw_list->_VtxCurrentIdx;
+		std::memcpy(draw_list->_VtxWritePtr, vertices.data() + c.vertex_begin,
+					c.vertex_count * sizeof(ImDrawVert));
+		for(std::uint32_t i = 0; i < c.index_count; ++i)
+		{
+			draw_list->_IdxWritePtr[i] = ImDrawIdx(base + indices[c.index_begin + i]);
+		}
+		draw_list->_VtxWritePtr += c.vertex_count;
+		draw_list->_IdxWritePtr += c.index_count;
+		draw_list->_VtxCurrentIdx += c.vertex_count;
+
+		draw_list->PopTextureID();
+		draw_list->PopClipRect();
+	}
+}
+
+void draw_cache::clear()
+{
+	vertices.clear();
+	indices.clear();
+	commands.clear();
+	textures.clear();
+}
 }
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -57,6 +60,57 @@ struct node
 	float size = 0;
 };
 
+/*
+ * draw_cache; what a dock drew, the vertices of its window and of the
+ * windows in it, to be drawn again as they are.
+ */
+struct draw_cache
+{
+	struct command
+	{
+		ImVec4 clip_rect;
+		ImTextureID texture = nullptr;
+		std::uint32_t vertex_begin = 0;
+		std::uint32_t vertex_count = 0;
+		std::uint32_t index_begin = 0;
+		std::uint32_t index_count = 0;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : capture ()
+	/// <summary>
+	/// Keeps what the current window drew from the index it had when the
+	/// dock began drawing, all of its child windows and the textures drawn
+	/// since the texture begin. Fails
+	/// for draw callbacks, which can't be drawn again.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool capture(std::uint32_t index_begin, std::size_t texture_begin);
+
+	//-----------------------------------------------------------------------------
+	//  Name : replay ()
+	/// <summary>
+	/// Draws what was kept to the current window.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void replay() const;
+
+	void clear();
+
+	std::vector<ImDrawVert> vertices;
+	std::vector<ImDrawIdx> indices;
+	std::vector<command> commands;
+	/// the textures are kept alive for the commands to draw them
+	std::vector<std::shared_ptr<void>> textures;
+	/// where and how big the dock was
+	ImVec2 pos;
+	ImVec2 size;
+	/// the mouse was over the dock, it is drawn once more when the mouse leaves
+	bool hovered = false;
+	bool valid = false;
+	std::chrono::steady_clock::time_point time;
+};
+
 struct dock
 {
 	void initialize(const std::string& dtitle, bool close_btn, const ImVec2& min_sz,
@@ -64,6 +118,26 @@ struct dock
 
 	virtual ~dock() = default;
 
+	//-----------------------------------------------------------------------------
+	//  Name : draw ()
+	/// <summary>
+	/// Draws the dock in the current window, or what it drew last when it is
+	/// cached and nothing it shows may have changed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void draw(const ImVec2& size);
+
+	//-----------------------------------------------------------------------------
+	//  Name : invalidate ()
+	/// <summary>
+	/// Draws a cached dock again in the next frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void invalidate()
+	{
+		cache.valid = false;
+	}
+
 	// Container *parent = nullptr;
 	node* container = nullptr;
 	dockspace* redock_from = nullptr;
@@ -81,6 +155,16 @@ struct dock
 	std::string title;
 	std::function<void(const ImVec2&)> draw_function;
 	std::function<bool(void)> on_close_func;
+
+	/// the dock is only drawn again under the mouse, while anything is input
+	/// or held, or after the refresh interval, what it drew last is shown
+	/// otherwise. For docks that show nothing changing on its own.
+	bool cached = false;
+	std::chrono::milliseconds refresh_interval = std::chrono::milliseconds(250);
+	draw_cache cache;
+
+private:
+	bool needs_draw(const ImVec2& pos, const ImVec2& size) const;
 };
 
 class dockspace
@@ -4,6 +4,66 @@
 
 #include <core/system/subsystem.h>
 
+#include <runtime/ecs/ecs.h>
+
+namespace
+{
+void show_ecs_memory()
+{
+	if(!gui::CollapsingHeader(ICON_FA_DATABASE "\tECS Memory"))
+	{
+		return;
+	}
+
+	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+	const auto report = ecs.get_memory_report();
+
+	gui::PushFont("default");
+	gui::Text("Entities %zu / %zu, total %zu bytes", report.entities, report.capacity,
+			  report.get_total_bytes());
+	gui::Text("Masks %zu, versions %zu, free list %zu", report.mask_bytes, report.version_bytes,
+			  report.free_list_bytes);
+	gui::Text("Alive mask %zu, names %zu", report.alive_mask_bytes, report.name_bytes);
+	gui::Text("Asset links %zu, %zu bytes pooled", report.asset_links, report.asset_link_bytes);
+	gui::Separator();
+
+	gui::BeginColumns("ecs_memory", 6);
+	for(const char* header : {"Component", "Count", "Objects", "Control", "Slack", "Storage"})
+	{
+		gui::Text("%s", header);
+		gui::NextColumn();
+	}
+	gui::Separator();
+	for(const auto& stats : report.components)
+	{
+		gui::Text("%s", stats.name.empty() ? "<empty>" : stats.name.c_str());
+		gui::NextColumn();
+		gui::Text("%zu", stats.count);
+		gui::NextColumn();
+		gui::Text("%zu", stats.object_bytes);
+		gui::NextColumn();
+		if(stats.pooled)
+		{
+			gui::Text("%zu", stats.control_block_bytes);
+			gui::NextColumn();
+			gui::Text("%zu", stats.pool_slack_bytes);
+			gui::NextColumn();
+		}
+		else
+		{
+			gui::Text("-");
+			gui::NextColumn();
+			gui::Text("-");
+			gui::NextColumn();
+		}
+		gui::Text("%zu", stats.storage_bytes);
+		gui::NextColumn();
+	}
+	gui::EndColumns();
+	gui::PopFont();
+}
+}
+
 void inspector_dock::render(const ImVec2&)
 {
 	auto& es = core::get_subsystem<editor::editing_system>();
@@ -13,6 +73,10 @@ void inspector_dock::render(const ImVec2&)
 	{
 		inspect_var(selected);
 	}
+	else
+	{
+		show_ecs_memory();
+	}
 }
 
 inspector_dock::inspector_dock(const std::string& dtitle, bool close_button, const ImVec2& min_size)
@@ -20,4 +84,5 @@ inspector_dock::inspector_dock(const std::string& dtitle, bool close_button, con
 
 	initialize(dtitle, close_button, min_size,
 			   std::bind(&inspector_dock::render, this, std::placeholders::_1));
+	cached = true;
 }
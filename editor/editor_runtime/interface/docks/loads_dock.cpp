@@ -0,0 +1,191 @@
+#include "loads_dock.h"
+
+#include <core/system/subsystem.h>
+
+#include <runtime/assets/asset_manager.h>
+
+#include <algorithm>
+#include <array>
+#include <string>
+
+namespace
+{
+using stats_t = runtime::asset_load_stats;
+
+const std::array<ImU32, std::size_t(stats_t::stage::count)>& get_stage_colors()
+{
+	static const std::array<ImU32, std::size_t(stats_t::stage::count)> colors = {
+		{IM_COL32(90, 160, 230, 255), IM_COL32(230, 180, 60, 255), IM_COL32(110, 200, 110, 255)}};
+	return colors;
+}
+
+// the value a column sorts by, the text ones compare apart
+double get_column_value(const stats_t::sample& s, int column)
+{
+	switch(column)
+	{
+		case 2:
+		case 3:
+		case 4:
+			return s.stage_ms[std::size_t(column - 2)];
+		case 5:
+			return s.total_ms;
+		case 6:
+			return double(s.bytes);
+		default:
+			return 0.0;
+	}
+}
+}
+
+loads_dock::loads_dock(const std::string& dtitle, bool close_button, const ImVec2& min_size)
+{
+	initialize(dtitle, close_button, min_size, std::bind(&loads_dock::render, this, std::placeholders::_1));
+}
+
+void loads_dock::render(const ImVec2& /*unused*/)
+{
+	auto& am = core::get_subsystem<runtime::asset_manager>();
+	auto& stats = am.get_load_stats();
+
+	bool enabled = stats.is_enabled();
+	if(gui::Checkbox("RECORD", &enabled))
+	{
+		stats.set_enabled(enabled);
+	}
+	gui::SameLine();
+	if(gui::Button("CLEAR"))
+	{
+		stats.clear();
+	}
+
+	auto samples = stats.get_samples();
+	gui::SameLine();
+	gui::Text("%zu loads", samples.size());
+	gui::SameLine();
+	gui::PushItemWidth(150.0f);
+	gui::SliderFloat("PX/MS", &timeline_scale_, 0.01f, 20.0f, "%.2f", 3.0f);
+	gui::PopItemWidth();
+
+	const auto& uploads = am.get_upload_queue();
+	const auto backlog = uploads.get_backlog();
+	gui::Text("UPLOADS: %zu queued, %zu ready (%zu KB), %zu KB this frame", backlog.count,
+			  backlog.ready_count, backlog.ready_bytes / 1024, uploads.get_frame_bytes() / 1024);
+
+	gui::PushFont("default");
+	draw_timeline(samples);
+	draw_table(samples);
+	gui::PopFont();
+}
+
+void loads_dock::draw_table(samples_t& samples)
+{
+	std::stable_sort(std::begin(samples), std::end(samples),
+					 [this](const stats_t::sample& a, const stats_t::sample& b) {
+						 if(sort_column_ == 0 || sort_column_ == 1)
+						 {
+							 const auto& lhs = sort_column_ == 0 ? a.type : a.key;
+							 const auto& rhs = sort_column_ == 0 ? b.type : b.key;
+							 return descending_ ? rhs < lhs : lhs < rhs;
+						 }
+						 const auto lhs = get_column_value(a, sort_column_);
+						 const auto rhs = get_column_value(b, sort_column_);
+						 return descending_ ? rhs < lhs : lhs < rhs;
+					 });
+
+	gui::BeginChild("asset_loads_table");
+	gui::BeginColumns("asset_loads", 7);
+	int column = 0;
+	for(const char* header : {"Type", "Key", "Read ms", "Process ms", "Upload ms", "Total ms", "KB"})
+	{
+		// a click on a header sorts by it, a second one flips the order
+		const auto label = std::string(header) + (column == sort_column_ ? (descending_ ? " v" : " ^") : "");
+		if(gui::Selectable(label.c_str(), column == sort_column_))
+		{
+			descending_ = column == sort_column_ ? !descending_ : true;
+			sort_column_ = column;
+		}
+		gui::NextColumn();
+		++column;
+	}
+	gui::Separator();
+	for(const auto& s : samples)
+	{
+		gui::Text("%s", s.type.c_str());
+		gui::NextColumn();
+		gui::Text("%s", s.key.c_str());
+		gui::NextColumn();
+		for(const auto ms : s.stage_ms)
+		{
+			gui::Text("%0.2f", ms);
+			gui::NextColumn();
+		}
+		if(s.done)
+		{
+			gui::Text("%0.2f", s.total_ms);
+		}
+		else
+		{
+			gui::TextDisabled("%0.2f..", s.total_ms);
+		}
+		gui::NextColumn();
+		gui::Text("%0.1f", double(s.bytes) / 1024.0);
+		gui::NextColumn();
+	}
+	gui::EndColumns();
+	gui::EndChild();
+}
+
+void loads_dock::draw_timeline(const samples_t& samples)
+{
+	const float row_height = 6.0f;
+	const float rows_shown = 24.0f;
+	double end_ms = 0.0;
+	for(const auto& s : samples)
+	{
+		end_ms = std::max(end_ms, s.start_ms + s.total_ms);
+	}
+
+	gui::BeginChild("asset_loads_timeline", ImVec2(0.0f, row_height * rows_shown + 16.0f), true,
+					ImGuiWindowFlags_HorizontalScrollbar);
+
+	// every load is a row, its wall time a line and its stages bars on it
+	const auto origin = gui::GetCursorScreenPos();
+	const auto width = float(end_ms) * timeline_scale_;
+	gui::Dummy(ImVec2(std::max(width, 1.0f), row_height * float(samples.size())));
+
+	auto draw_list = gui::GetWindowDrawList();
+	const auto& colors = get_stage_colors();
+	const auto mouse = gui::GetMousePos();
+	for(std::size_t i = 0; i < samples.size(); ++i)
+	{
+		const auto& s = samples[i];
+		const auto top = origin.y + row_height * float(i);
+		const auto x = origin.x + float(s.start_ms) * timeline_scale_;
+		const auto x_end = x + std::max(float(s.total_ms) * timeline_scale_, 1.0f);
+		draw_list->AddLine(ImVec2(x, top + row_height * 0.5f), ImVec2(x_end, top + row_height * 0.5f),
+						   IM_COL32(160, 160, 160, 255));
+		for(std::size_t stage = 0; stage < s.stage_ms.size(); ++stage)
+		{
+			if(s.stage_ms[stage] <= 0.0)
+			{
+				continue;
+			}
+
+			const auto stage_x = x + float(s.stage_start_ms[stage]) * timeline_scale_;
+			const auto stage_end = stage_x + std::max(float(s.stage_ms[stage]) * timeline_scale_, 1.0f);
+			draw_list->AddRectFilled(ImVec2(stage_x, top + 1.0f), ImVec2(stage_end, top + row_height - 1.0f),
+									 colors[stage]);
+		}
+
+		if(gui::IsWindowHovered() && mouse.y >= top && mouse.y < top + row_height && mouse.x >= x &&
+		   mouse.x <= x_end)
+		{
+			gui::SetTooltip("%s\n%s\nread %0.2f ms, process %0.2f ms, upload %0.2f ms\ntotal %0.2f ms",
+							s.type.c_str(), s.key.c_str(), s.stage_ms[0], s.stage_ms[1], s.stage_ms[2],
+							s.total_ms);
+		}
+	}
+
+	gui::EndChild();
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "imguidock.h"
+
+#include <runtime/assets/asset_load_stats.h>
+
+#include <vector>
+
+struct loads_dock : public imguidock::dock
+{
+	loads_dock(const std::string& dtitle, bool close_button, const ImVec2& min_size);
+
+	void render(const ImVec2& area);
+
+private:
+	using samples_t = std::vector<runtime::asset_load_stats::sample>;
+
+	void draw_table(samples_t& samples);
+	void draw_timeline(const samples_t& samples);
+
+	/// the column the table is sorted by and whether the highest go first
+	int sort_column_ = 5;
+	bool descending_ = true;
+	/// pixels a millisecond takes on the timeline
+	float timeline_scale_ = 1.0f;
+};
@@ -0,0 +1,114 @@
+#include "memory_dock.h"
+
+#include <core/graphics/destroy_queue.h>
+#include <core/graphics/gpu_memory.h>
+#include <core/system/subsystem.h>
+
+#include <runtime/ecs/components/camera_component.h>
+#include <runtime/ecs/components/reflection_probe_component.h>
+#include <runtime/ecs/ecs.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace
+{
+double to_mb(std::uint64_t bytes)
+{
+	return double(bytes) / (1024.0 * 1024.0);
+}
+
+struct view_memory
+{
+	std::string name;
+	const char* kind;
+	std::uint64_t bytes;
+};
+}
+
+memory_dock::memory_dock(const std::string& dtitle, bool close_button, const ImVec2& min_size)
+{
+	initialize(dtitle, close_button, min_size, std::bind(&memory_dock::render, this, std::placeholders::_1));
+}
+
+void memory_dock::render(const ImVec2& /*unused*/)
+{
+	const auto queue = gfx::destroy_queue::get_stats();
+	gui::Text("TOTAL: %0.1f MB, %llu handles waiting for destroy", to_mb(gfx::gpu_memory::get_total_bytes()),
+			  static_cast<unsigned long long>(queue.pending));
+
+	gui::PushFont("default");
+	draw_categories();
+	gui::Separator();
+	draw_views();
+	gui::PopFont();
+}
+
+void memory_dock::draw_categories()
+{
+	const auto stats = gfx::gpu_memory::get_stats();
+
+	gui::BeginColumns("gpu_memory_categories", 5);
+	for(const char* header : {"Category", "MB", "Peak MB", "Resources", "Created"})
+	{
+		gui::TextUnformatted(header);
+		gui::NextColumn();
+	}
+	gui::Separator();
+	for(std::size_t i = 0; i < stats.size(); ++i)
+	{
+		const auto& category = stats[i];
+		gui::TextUnformatted(gfx::get_memory_category_name(gfx::memory_category(i)));
+		gui::NextColumn();
+		gui::Text("%0.2f", to_mb(category.bytes));
+		gui::NextColumn();
+		gui::Text("%0.2f", to_mb(category.peak_bytes));
+		gui::NextColumn();
+		gui::Text("%llu", static_cast<unsigned long long>(category.count));
+		gui::NextColumn();
+		gui::Text("%llu", static_cast<unsigned long long>(category.created));
+		gui::NextColumn();
+	}
+	gui::EndColumns();
+}
+
+void memory_dock::draw_views()
+{
+	// the targets kept by every camera and probe, the largest first
+	std::vector<view_memory> views;
+	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+	ecs.each<camera_component>([&views](runtime::entity e, camera_component& camera_comp) {
+		views.push_back({e.to_string(), "camera", camera_comp.get_render_view().get_memory_size()});
+	});
+	ecs.each<reflection_probe_component>([&views](runtime::entity e, reflection_probe_component& probe_comp) {
+		std::uint64_t bytes = 0;
+		for(std::size_t i = 0; i < 6; ++i)
+		{
+			bytes += probe_comp.get_render_view(i).get_memory_size();
+		}
+		views.push_back({e.to_string(), "probe", bytes});
+	});
+	std::sort(std::begin(views), std::end(views),
+			  [](const view_memory& a, const view_memory& b) { return a.bytes > b.bytes; });
+
+	gui::BeginChild("gpu_memory_views");
+	gui::BeginColumns("gpu_memory_views", 3);
+	for(const char* header : {"Entity", "View", "MB"})
+	{
+		gui::TextUnformatted(header);
+		gui::NextColumn();
+	}
+	gui::Separator();
+	for(const auto& view : views)
+	{
+		gui::TextUnformatted(view.name.c_str());
+		gui::NextColumn();
+		gui::TextUnformatted(view.kind);
+		gui::NextColumn();
+		gui::Text("%0.2f", to_mb(view.bytes));
+		gui::NextColumn();
+	}
+	gui::EndColumns();
+	gui::EndChild();
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "imguidock.h"
+
+struct memory_dock : public imguidock::dock
+{
+	memory_dock(const std::string& dtitle, bool close_button, const ImVec2& min_size);
+
+	void render(const ImVec2& area);
+
+private:
+	void draw_categories();
+	void draw_views();
+};
@@ -0,0 +1,91 @@
+#include "profiler_dock.h"
+
+#include <core/filesystem/filesystem.h>
+#include <core/graphics/graphics.h>
+#include <core/logging/logging.h>
+#include <core/system/subsystem.h>
+
+#include <editor_core/nativefd/filedialog.h>
+
+#include <runtime/rendering/renderer.h>
+
+#include <fstream>
+
+profiler_dock::profiler_dock(const std::string& dtitle, bool close_button, const ImVec2& min_size)
+{
+	initialize(dtitle, close_button, min_size,
+			   std::bind(&profiler_dock::render, this, std::placeholders::_1));
+}
+
+void profiler_dock::render(const ImVec2& /*unused*/)
+{
+	const auto& rend = core::get_subsystem<runtime::renderer>();
+	const auto stats = gfx::get_stats();
+	profiler_.update(stats, rend.get_render_frame());
+
+	if(gui::Button("EXPORT CSV"))
+	{
+		export_csv();
+	}
+	gui::SameLine();
+	if(gui::Button("RESET"))
+	{
+		profiler_.clear();
+	}
+	gui::SameLine();
+	gui::Text("Last %zu frames", profiler_.get_window());
+
+	gui::PushFont("default");
+	if(!stats || stats->numViews == 0)
+	{
+		gui::Text("Profiler is not enabled, enable it in the scene statistics.");
+	}
+
+	const auto& entries = profiler_.get_entries();
+	gui::BeginColumns("pass_profiler", 8);
+	for(const char* header :
+		{"Pass", "Views", "CPU min", "CPU avg", "CPU max", "GPU min", "GPU avg", "GPU max"})
+	{
+		gui::Text("%s", header);
+		gui::NextColumn();
+	}
+	gui::Separator();
+	for(const auto& e : entries)
+	{
+		gui::Text("%s", e.name.empty() ? "<unnamed>" : e.name.c_str());
+		gui::NextColumn();
+		gui::Text("%u", e.views);
+		gui::NextColumn();
+		for(const auto& t : {e.cpu, e.gpu})
+		{
+			for(const auto ms : {t.min_ms, t.avg_ms, t.max_ms})
+			{
+				gui::Text("%0.3f", ms);
+				gui::NextColumn();
+			}
+		}
+	}
+	gui::EndColumns();
+	gui::PopFont();
+}
+
+void profiler_dock::export_csv()
+{
+	std::string path;
+	if(!native::save_file_dialog("csv", fs::resolve_protocol("app:/").string(), path))
+	{
+		return;
+	}
+
+	if(!fs::path(path).has_extension())
+		path += ".csv";
+
+	std::ofstream output(path);
+	if(!output)
+	{
+		APPLOG_ERROR("Could not write the pass timings to {0}.", path);
+		return;
+	}
+	profiler_.write_csv(output);
+	APPLOG_INFO("Pass timings written to {0}.", path);
+}
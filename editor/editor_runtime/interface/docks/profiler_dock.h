@@ -0,0 +1,18 @@
+#pragma once
+
+#include "imguidock.h"
+
+#include <runtime/rendering/pass_profiler.h>
+
+struct profiler_dock : public imguidock::dock
+{
+	profiler_dock(const std::string& dtitle, bool close_button, const ImVec2& min_size);
+
+	void render(const ImVec2& area);
+
+private:
+	void export_csv();
+
+	/// times of the render passes over the last frames
+	pass_profiler profiler_;
+};
@@ -1,6 +1,9 @@
 #include "project_dock.h"
 #include "../../assets/asset_extensions.h"
+#include "../../assets/asset_search.h"
 #include "../../editing/editing_system.h"
+#include "../../editing/scene_loader.h"
+#include "../../system/project_manager.h"
 
 #include <core/audio/sound.h>
 #include <core/graphics/shader.h>
@@ -21,7 +24,10 @@
 
 #include <editor_core/nativefd/filedialog.h>
 
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstring>
 
 using namespace std::literals;
 
@@ -399,6 +405,20 @@ void project_dock::render(const ImVec2& /*area*/)
 	}
 	gui::PopItemWidth();
 
+	gui::SameLine();
+	gui::PushItemWidth(150.0f);
+	std::array<char, 64> search_buff;
+	search_buff.fill(0);
+	std::memcpy(search_buff.data(), search_.c_str(), std::min(search_.size(), search_buff.size() - 1));
+	if(gui::InputText("SEARCH", search_buff.data(), search_buff.size()))
+	{
+		search_ = string_utils::to_lower(search_buff.data());
+	}
+	gui::PopItemWidth();
+	update_search();
+	// the assets found anywhere in the project rather than the folder
+	const bool searching = !search_.empty();
+
 	const auto hierarchy = fs::split_until(cache_.get_path(), root_path);
 
 	int id = 0;
@@ -452,9 +472,9 @@ void project_dock::render(const ImVec2& /*area*/)
 
 		auto process_cache_entry = [&](const auto& cache_entry) {
 			const auto& absolute_path = cache_entry.entry.path();
-			const auto& name = cache_entry.stem;
-			const auto& relative = cache_entry.protocol_path;
-			const auto& file_ext = cache_entry.extension;
+			const auto& name = cache_entry.stem();
+			const auto& relative = cache_entry.protocol_path();
+			const auto& file_ext = cache_entry.extension();
 
 			const auto on_rename = [&](const std::string& new_name) {
 				fs::path new_absolute_path = absolute_path;
@@ -471,7 +491,7 @@ void project_dock::render(const ImVec2& /*area*/)
 				es.unselect();
 			};
 
-			if(fs::is_directory(cache_entry.entry.status()))
+			if(cache_entry.is_directory)
 			{
 
 				using entry_t = fs::path;
@@ -512,8 +532,11 @@ void project_dock::render(const ImVec2& /*area*/)
 				{
 					entry = entry_future.get();
 				}
-				const auto& icon = entry ? entry : loading_preview;
-				bool is_loading = !entry;
+				// the full texture only when no preview can be made of it
+				bool is_loading = false;
+				const auto thumbnail = thumbnails_.get_texture_thumbnail(absolute_path, is_loading);
+				is_loading |= !entry;
+				const auto& icon = thumbnail ? thumbnail : (is_loading ? loading_preview : entry);
 				is_popup_opened |= draw_entry(icon, is_loading, name, absolute_path, is_selected(entry), size,
 											  [&]() // on_click
 											  { es.select(entry); },
@@ -670,9 +693,8 @@ void project_dock::render(const ImVec2& /*area*/)
 													  return;
 												  }
 
-												  entry->instantiate(scene::mode::standard);
-												  es.scene = fs::resolve_protocol(entry.id()).string();
-												  es.load_editor_camera();
+												  auto& loader = core::get_subsystem<editor::scene_loader>();
+												  loader.load(entry.id());
 											  },
 											  on_rename, on_delete);
 				return;
@@ -684,7 +706,7 @@ void project_dock::render(const ImVec2& /*area*/)
 		auto item_size = size + style.ItemSpacing.x;
 		auto items_per_line_exact = avail / item_size;
 		auto items_per_line_floor = ImFloor(items_per_line_exact);
-		auto count = cache_.size();
+		auto count = searching ? found_.size() : cache_.size();
 		auto items_per_line = std::min(size_t(items_per_line_floor), count);
 		auto extra = ((items_per_line_exact - items_per_line_floor) * item_size) /
 					 std::max(1.0f, items_per_line_floor - 1);
@@ -699,7 +721,7 @@ void project_dock::render(const ImVec2& /*area*/)
 				auto end = start + std::min(count - start, items_per_line);
 				for(size_t j = start; j < end; ++j)
 				{
-					const auto& cache_entry = cache_[j];
+					const auto& cache_entry = searching ? found_[j] : cache_[j];
 
 					gui::PushID(int(j));
 
@@ -788,6 +810,38 @@ void project_dock::set_cache_path(const fs::path& path)
 	}
 	cache_.set_path(path);
 	cache_path_with_protocol_ = fs::convert_to_protocol(path).generic_string();
+	// the previews of the folder left are made again from disk if it is back
+	thumbnails_.clear();
+}
+
+void project_dock::update_search()
+{
+	const auto& search = core::get_subsystem<editor::project_manager>().get_asset_search();
+	if(search_.empty() || !search)
+	{
+		found_search_.clear();
+		found_.clear();
+		return;
+	}
+
+	const auto version = search->get_version();
+	if(search_ == found_search_ && version == found_version_)
+	{
+		return;
+	}
+	found_search_ = search_;
+	found_version_ = version;
+
+	// more than a screen of them is not looked through, the search is refined
+	constexpr std::size_t max_found = 256;
+	std::vector<editor::asset_search::result> results;
+	search->find(search_, max_found, results);
+	found_.clear();
+	found_.reserve(results.size());
+	for(const auto& result : results)
+	{
+		found_.emplace_back(fs::directory_entry(fs::resolve_protocol(result.key)));
+	}
 }
 
 void project_dock::import()
@@ -816,4 +870,5 @@ void project_dock::import()
 project_dock::project_dock(const std::string& dtitle, bool close_button, const ImVec2& min_size)
 {
 	initialize(dtitle, close_button, min_size, std::bind(&project_dock::render, this, std::placeholders::_1));
+	cached = true;
 }
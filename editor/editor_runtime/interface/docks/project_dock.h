@@ -1,8 +1,13 @@
 #pragma once
 #include "imguidock.h"
+#include "../../assets/thumbnail_cache.h"
 
 #include <core/filesystem/filesystem_cache.hpp>
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 class project_dock : public imguidock::dock
 {
 public:
@@ -15,9 +20,19 @@ private:
 	void context_create_menu();
 	void set_cache_path(const fs::path& path);
 	void import();
+	/// finds the assets of the search again when it or the index changed
+	void update_search();
 
 	fs::directory_cache cache_;
+	/// the previews of the images
+	editor::thumbnail_cache thumbnails_;
 	fs::path cache_path_with_protocol_;
 	fs::path root_;
 	float scale_ = 0.75f;
+	/// the search typed, lowered, and the assets found for it in the index
+	/// of the version
+	std::string search_;
+	std::string found_search_;
+	std::uint64_t found_version_ = 0;
+	std::vector<fs::directory_cache::cache_entry> found_;
 };
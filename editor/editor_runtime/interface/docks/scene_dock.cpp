@@ -15,6 +15,7 @@
 #include <runtime/ecs/components/transform_component.h>
 #include <runtime/ecs/constructs/prefab.h>
 #include <runtime/ecs/constructs/utils.h>
+#include <runtime/ecs/systems/deferred_rendering.h>
 #include <runtime/input/input.h>
 #include <runtime/rendering/camera.h>
 #include <runtime/rendering/mesh.h>
@@ -99,6 +100,19 @@ void scene_dock::show_statistics(const ImVec2& area, unsigned int fps, bool& sho
 			gui::Text("Submit CPU %0.3f, GPU %0.3f (L: %d)",
 					  double(stats->cpuTimeEnd - stats->cpuTimeBegin) * to_cpu_ms,
 					  double(stats->gpuTimeEnd - stats->gpuTimeBegin) * to_gpu_ms, stats->maxGpuLatency);
+
+			const auto& threads = core::get_subsystem<runtime::renderer>().get_render_thread_stats();
+			if(threads.threaded)
+			{
+				gui::Text("Wait Render %0.3f, Submit %0.3f", double(threads.wait_render_ms),
+						  double(threads.wait_submit_ms));
+			}
+			else
+			{
+				gui::Text("Render Thread off");
+			}
+			gui::Text("Input to Photon %0.3f, Vsync %s", double(threads.input_to_photon_ms),
+					  threads.vsync ? "on" : "off");
 			if(-std::numeric_limits<std::int64_t>::max() != stats->gpuMemoryUsed)
 			{
 				char tmp0[64];
@@ -265,6 +279,18 @@ void scene_dock::show_statistics(const ImVec2& area, unsigned int fps, bool& sho
 
 		gui::Separator();
 		gui::Checkbox("SHOW G-BUFFER", &show_gbuffer);
+
+		auto& resolution = core::get_subsystem<runtime::deferred_rendering>().get_dynamic_resolution();
+		bool dynamic_resolution = resolution.is_enabled();
+		if(gui::Checkbox("DYNAMIC RESOLUTION", &dynamic_resolution))
+		{
+			resolution.set_enabled(dynamic_resolution);
+		}
+		if(dynamic_resolution)
+		{
+			gui::Text("Scale %0.2f, GPU %0.3f / %0.3f [ms]", double(resolution.get_scale()),
+					  resolution.get_average_ms(), resolution.get_target_ms());
+		}
 	}
 	gui::End();
 }
@@ -291,6 +317,8 @@ void draw_selected_camera(const ImVec2& size)
 			float factor =
 				std::min(size.x / float(viewport_size.width), size.y / float(viewport_size.height)) / 4.0f;
 			ImVec2 bounds(viewport_size.width * factor, viewport_size.height * factor);
+			// the preview renders at the size it is drawn at
+			selected_camera->present(factor);
 			auto p = gui::GetWindowPos();
 			p.x += size.x - bounds.x - 20.0f;
 			p.y += size.y - bounds.y - 40.0f;
@@ -382,7 +410,19 @@ void manipulation_gizmos()
 			imguizmo::manipulate(camera.get_view(), camera.get_projection(), operation, mode,
 								 math::value_ptr(output), nullptr, snap);
 
-			transform_comp->set_transform(output);
+			if(imguizmo::is_using())
+			{
+				// a whole drag is undone at once, it is sealed when let go
+				static const auto local_prop = rttr::type::get<transform_component>().get_property("local");
+				rttr::variant before = transform_comp->get_local_transform();
+				transform_comp->set_transform(output);
+				rttr::variant after = transform_comp->get_local_transform();
+				es.undo.record({{sel, rttr::type::get<transform_component>(), local_prop, before, after}});
+			}
+			else
+			{
+				transform_comp->set_transform(output);
+			}
 
 //						if(sel.has_component<model_component>())
 //						{
@@ -715,10 +755,13 @@ void scene_dock::render(const ImVec2& area)
 
 		const auto& camera = camera_comp->get_camera();
 		auto& render_view = camera_comp->get_render_view();
+		// the g-buffer shown below must not be shared with the other views
+		render_view.set_alias_transients(!show_gbuffer);
 		const auto& viewport_size = camera.get_viewport_size();
 		const auto surface = render_view.get_output_fbo(viewport_size);
 		auto tex = surface->get_attachment(0).texture;
 		gui::Image(gui::get_info(tex), size);
+		camera_comp->present();
 
 		if(gui::IsItemClicked(1) || gui::IsItemClicked(2))
 		{
@@ -3,6 +3,7 @@
 style_dock::style_dock(const std::string& dtitle, bool close_button, const ImVec2& min_size)
 {
 	initialize(dtitle, close_button, min_size, std::bind(&style_dock::render, this, std::placeholders::_1));
+	cached = true;
 	auto& style = get_gui_style();
 	style.load_style();
 	auto& setup = style.setup;
@@ -468,10 +468,19 @@ void gui_system::pop_context()
 	imgui_set_context(initial_context_);
 }
 
+std::chrono::steady_clock::duration gui_system::get_time_since_event() const
+{
+	return std::chrono::steady_clock::now() - last_event_;
+}
+
 void gui_system::platform_events(const std::pair<std::uint32_t, bool>& info,
 								 const std::vector<mml::platform_event>& events)
 {
 	const auto window_id = info.first;
+	if(!events.empty())
+	{
+		last_event_ = std::chrono::steady_clock::now();
+	}
 	push_context(window_id);
 	for(const auto& e : events)
 	{
@@ -7,6 +7,7 @@
 
 #include <editor_core/gui/gui.h>
 
+#include <chrono>
 #include <map>
 #include <memory>
 
@@ -39,12 +40,21 @@ struct gui_system
 	void draw_end();
 	void pop_context();
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_time_since_event ()
+	/// <summary>
+	/// How long ago any window had an event, input or otherwise.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::chrono::steady_clock::duration get_time_since_event() const;
+
 private:
 	void platform_events(const window_info& info, const std::vector<mml::platform_event>&);
 
 	std::map<uint32_t, ImGuiContext*> contexts_;
 	ImFontAtlas atlas_;
 	ImGuiContext* initial_context_ = nullptr;
+	std::chrono::steady_clock::time_point last_event_ = std::chrono::steady_clock::now();
 };
 
 namespace gui
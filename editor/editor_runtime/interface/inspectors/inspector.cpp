@@ -56,6 +56,31 @@ property_layout::property_layout(const rttr::property& prop, bool columns /*= tr
 	gui::PushItemWidth(gui::GetContentRegionAvailWidth());
 }
 
+property_layout::property_layout(const reflection::property_info& info, bool columns /*= true*/)
+{
+	if(columns)
+	{
+		if(gui::GetColumnsCount() > 1)
+		{
+			gui::EndColumns();
+		}
+		gui::BeginColumns("properties", 2, ImGuiColumnsFlags_NoBorder | ImGuiColumnsFlags_NoResize);
+	}
+
+	gui::AlignTextToFramePadding();
+	gui::TextUnformatted(info.pretty_name.c_str());
+
+	if(!info.tooltip.empty())
+	{
+		Tooltip(info.tooltip);
+	}
+
+	gui::NextColumn();
+
+	gui::PushID(info.pretty_name.c_str());
+	gui::PushItemWidth(gui::GetContentRegionAvailWidth());
+}
+
 property_layout::property_layout(const std::string& name, bool columns /*= true*/)
 {
 	if(columns)
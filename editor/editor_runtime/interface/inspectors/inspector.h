@@ -1,5 +1,6 @@
 #pragma once
 
+#include <core/reflection/property_table.h>
 #include <core/reflection/reflection.h>
 #include <core/reflection/registration.h>
 
@@ -20,6 +21,8 @@ struct property_layout
 {
 	property_layout(const rttr::property& prop, bool columns = true);
 
+	property_layout(const reflection::property_info& info, bool columns = true);
+
 	property_layout(const std::string& name, bool columns = true);
 
 	property_layout(const std::string& name, const std::string& tooltip, bool columns = true);
@@ -2,6 +2,7 @@
 #include "inspectors.h"
 
 #include "../../assets/asset_extensions.h"
+#include "../../assets/import_settings.h"
 #include "../../editing/editing_system.h"
 
 #include <core/audio/sound.h>
@@ -59,6 +60,32 @@ static bool process_drag_drop_target(asset_handle<asset_t>& entry)
 	;
 }
 
+// the settings in the meta of the texture, read again when another one is
+// inspected and written when applied
+static void inspect_texture_import(const std::string& key)
+{
+	static std::string inspected;
+	static asset_compiler::texture_import_settings settings;
+
+	const auto meta = fs::resolve_protocol(fs::replace(key, ":/data", ":/meta").string() + ".meta");
+	if(inspected != key)
+	{
+		settings = {};
+		asset_compiler::import_settings::load(meta, settings);
+		inspected = key;
+	}
+
+	rttr::variant var = settings;
+	if(inspect_var(var))
+	{
+		settings = var.get_value<asset_compiler::texture_import_settings>();
+	}
+	if(gui::Button("APPLY", ImVec2(-1, 0)))
+	{
+		asset_compiler::import_settings::save(meta, settings);
+	}
+}
+
 bool inspector_asset_handle_texture::inspect(rttr::variant& var, bool read_only,
 											 const meta_getter& get_metadata)
 {
@@ -177,7 +204,10 @@ bool inspector_asset_handle_texture::inspect(rttr::variant& var, bool read_only,
 		}
 		if(gui::BeginTabItem("\tImport\t"))
 		{
-			gui::TextUnformatted("Import options");
+			if(!data.id().empty())
+			{
+				inspect_texture_import(data.id());
+			}
 			ImGui::EndTabItem();
 		}
 		gui::EndTabBar();
@@ -1,5 +1,67 @@
 #include "inspector_entity.h"
 #include "inspectors.h"
+#include "../../editing/editing_system.h"
+
+#include <core/system/subsystem.h>
+
+#include <unordered_map>
+
+namespace
+{
+using component_handles = std::vector<runtime::chandle<runtime::component>>;
+
+const std::string& get_pretty_name(const rttr::type& component_type)
+{
+	static std::unordered_map<rttr::type, std::string> names;
+	auto it = names.find(component_type);
+	if(it != std::end(names))
+	{
+		return it->second;
+	}
+
+	std::string name = component_type.get_name().data();
+	auto meta_id = component_type.get_metadata("pretty_name");
+	if(meta_id)
+	{
+		name = meta_id.to_string();
+	}
+	return names.emplace(component_type, std::move(name)).first->second;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : get_others ()
+/// <summary>
+/// The components of the entities selected along with the inspected one, by
+/// their type.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::unordered_map<rttr::type, component_handles> get_others(const runtime::entity& data,
+															  std::vector<runtime::entity>& entities)
+{
+	std::unordered_map<rttr::type, component_handles> others;
+	auto& es = core::get_subsystem<editor::editing_system>();
+	const auto& selected = es.selection_data.object;
+	if(!selected.is_type<runtime::entity>() || selected.get_value<runtime::entity>() != data)
+	{
+		return others;
+	}
+
+	for(const auto& e : es.selection_data.others)
+	{
+		if(!e.valid() || e == data)
+		{
+			continue;
+		}
+		entities.emplace_back(e);
+		for(auto& component_ptr : e.all_components())
+		{
+			auto component = component_ptr.lock();
+			others[rttr::type::get(*component)].emplace_back(component_ptr);
+		}
+	}
+	return others;
+}
+}
 
 bool inspector_entity::inspect(rttr::variant& var, bool read_only, const meta_getter& get_metadata)
 {
@@ -18,8 +80,26 @@ bool inspector_entity::inspect(rttr::variant& var, bool read_only, const meta_ge
 			data.set_name(var_name.to_string());
 		}
 	}
+	std::vector<runtime::entity> entities;
+	const auto others = get_others(data, entities);
+	if(!entities.empty())
+	{
+		gui::AlignTextToFramePadding();
+		gui::Text("Editing %zu more entities", entities.size());
+	}
 	ImGui::Separator();
 
+	// every property written this frame is undone together
+	std::vector<editor::undo_stack::change> writes;
+	auto on_write = [&writes](const rttr::instance& object, const rttr::property& prop,
+							  const rttr::variant& before, const rttr::variant& after) {
+		auto component = object.try_convert<runtime::component>();
+		if(component)
+		{
+			writes.push_back({component->get_entity(), object.get_derived_type(), prop, before, after});
+		}
+	};
+
 	auto components = data.all_components();
 	for(auto& component_ptr : components)
 	{
@@ -27,12 +107,8 @@ bool inspector_entity::inspect(rttr::variant& var, bool read_only, const meta_ge
 		auto component = component_ptr.lock().get();
 		auto component_type = rttr::type::get(*component);
 
-		std::string name = component_type.get_name().data();
-		auto meta_id = component_type.get_metadata("pretty_name");
-		if(meta_id)
-		{
-			name = meta_id.to_string();
-		}
+		const auto& name = get_pretty_name(component_type);
+		auto other_it = others.find(component_type);
 		gui::PushID(component);
 		gui::SetNextTreeNodeOpen(true, ImGuiCond_FirstUseEver);
 		if(gui::CollapsingHeader(name.c_str(), &opened))
@@ -40,8 +116,18 @@ bool inspector_entity::inspect(rttr::variant& var, bool read_only, const meta_ge
 			gui::PushStyleVar(ImGuiStyleVar_IndentSpacing, 8.0f);
 			gui::TreePush(name.c_str());
 
+			// a collapsed component is not read at all
+			std::vector<rttr::variant> other_vars;
+			if(other_it != std::end(others))
+			{
+				other_vars.reserve(other_it->second.size());
+				for(const auto& other : other_it->second)
+				{
+					other_vars.emplace_back(other.lock().get());
+				}
+			}
 			rttr::variant component_var = component;
-			changed |= inspect_var(component_var);
+			changed |= inspect_batch(component_var, other_vars, false, on_write);
 
 			gui::TreePop();
 			gui::PopStyleVar();
@@ -50,9 +136,23 @@ bool inspector_entity::inspect(rttr::variant& var, bool read_only, const meta_ge
 		if(!opened)
 		{
 			component->get_entity().remove(component_ptr.lock());
+			if(other_it != std::end(others))
+			{
+				for(const auto& other : other_it->second)
+				{
+					auto other_ptr = other.lock();
+					other_ptr->get_entity().remove(other_ptr);
+				}
+			}
 		}
 	}
 
+	if(!writes.empty())
+	{
+		auto& es = core::get_subsystem<editor::editing_system>();
+		es.undo.record(std::move(writes));
+	}
+
 	gui::Separator();
 	if(gui::Button("+COMPONENT"))
 	{
@@ -75,12 +175,7 @@ bool inspector_entity::inspect(rttr::variant& var, bool read_only, const meta_ge
 			auto cstructor = component_type.get_constructor();
 			if(cstructor)
 			{
-				std::string name = component_type.get_name().data();
-				auto meta_id = component_type.get_metadata("pretty_name");
-				if(meta_id)
-				{
-					name = meta_id.to_string();
-				}
+				const auto& name = get_pretty_name(component_type);
 				if(!filter.PassFilter(name.c_str()))
 					continue;
 
@@ -92,6 +187,13 @@ bool inspector_entity::inspect(rttr::variant& var, bool read_only, const meta_ge
 					if(c_ptr)
 						data.assign(c_ptr);
 
+					for(auto& e : entities)
+					{
+						auto other = cstructor.invoke().get_value<std::shared_ptr<runtime::component>>();
+						if(other)
+							e.assign(other);
+					}
+
 					gui::CloseCurrentPopup();
 				}
 			}
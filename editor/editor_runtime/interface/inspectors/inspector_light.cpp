@@ -33,6 +33,9 @@ bool inspector_light_component::inspect(rttr::variant& var, bool read_only, cons
 			light_val.directional_data = v.get_value<light::directional>();
 	}
 
+	// the properties of the component, the layers it is on
+	changed |= inspect_var(var, true, read_only);
+
 	if(changed)
 	{
 		data->set_light(light_val);
@@ -69,6 +72,8 @@ bool inspector_reflection_probe_component::inspect(rttr::variant& var, bool read
 			probe.sphere_data = v.get_value<reflection_probe::sphere>();
 	}
 
+	changed |= inspect_var(var, true, read_only);
+
 	if(changed)
 	{
 		data->set_probe(probe);
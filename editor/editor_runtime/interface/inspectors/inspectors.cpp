@@ -27,7 +27,87 @@ struct inspector_registry
 std::shared_ptr<inspector> get_inspector(rttr::type type)
 {
 	static inspector_registry registry;
-	return registry.type_map[type];
+	auto it = registry.type_map.find(type);
+	if(it == std::end(registry.type_map))
+	{
+		return nullptr;
+	}
+	return it->second;
+}
+
+namespace
+{
+//-----------------------------------------------------------------------------
+//  Name : inspect_property ()
+/// <summary>
+/// Draws a property of the object, the changed value is left in prop_var.
+/// A property of the type it is registered with is only read when it is
+/// drawn, not under a closed tree node.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool inspect_property(const rttr::instance& object, const reflection::property_info& info,
+					  rttr::variant& prop_var)
+{
+	const auto& prop = info.prop;
+	bool is_readonly = info.read_only;
+	bool is_enum = info.is_enum;
+	bool read = false;
+	// only a pointer or a wrapper may hold a type other than its own
+	bool has_inspector = false;
+	if(info.static_type)
+	{
+		has_inspector = !!get_inspector(prop.get_type());
+	}
+	else
+	{
+		prop_var = prop.get_value(object);
+		read = true;
+		rttr::instance prop_object = prop_var;
+		has_inspector = !!get_inspector(prop_object.get_derived_type());
+	}
+	bool details = !has_inspector && !is_enum;
+	property_layout layout(info);
+	if(details)
+	{
+		gui::AlignTextToFramePadding();
+		if(!gui::TreeNode("details"))
+		{
+			return false;
+		}
+	}
+
+	if(!read)
+	{
+		prop_var = prop.get_value(object);
+	}
+
+	bool prop_changed = false;
+	auto get_meta = [&prop](const rttr::variant& name) -> rttr::variant { return prop.get_metadata(name); };
+	if(prop_var.is_sequential_container())
+	{
+		prop_changed |= inspect_array(prop_var, is_readonly, get_meta);
+	}
+	else if(prop_var.is_associative_container())
+	{
+		prop_changed |= inspect_associative_container(prop_var, is_readonly);
+	}
+	else if(is_enum)
+	{
+		auto enumeration = prop.get_enumeration();
+		prop_changed |= inspect_enum(prop_var, enumeration, is_readonly);
+	}
+	else
+	{
+		prop_changed |= inspect_var(prop_var, false, is_readonly, get_meta);
+	}
+
+	if(details)
+	{
+		gui::TreePop();
+	}
+
+	return prop_changed;
+}
 }
 
 bool inspect_var(rttr::variant& var, bool skip_custom, bool read_only,
@@ -35,7 +115,7 @@ bool inspect_var(rttr::variant& var, bool skip_custom, bool read_only,
 {
 	rttr::instance object = var;
 	auto type = object.get_derived_type();
-	auto properties = type.get_properties();
+	const auto& properties = reflection::get_properties(type);
 
 	bool changed = false;
 
@@ -54,59 +134,87 @@ bool inspect_var(rttr::variant& var, bool skip_custom, bool read_only,
 	}
 	else
 	{
-		for(auto& prop : properties)
+		for(const auto& info : properties)
 		{
-			bool prop_changed = false;
-			auto prop_var = prop.get_value(object);
-			bool is_readonly = prop.is_readonly();
-			bool is_array = prop_var.is_sequential_container();
-			bool is_associative_container = prop_var.is_associative_container();
-			bool is_enum = prop.is_enumeration();
-			rttr::instance prop_object = prop_var;
-			bool has_inspector = !!get_inspector(prop_object.get_derived_type());
-			bool details = !has_inspector && !is_enum;
-			property_layout layout(prop);
-			bool open = true;
-			if(details)
+			rttr::variant prop_var;
+			bool prop_changed = inspect_property(object, info, prop_var);
+			if(prop_changed && !info.read_only)
 			{
-				gui::AlignTextToFramePadding();
-				open = gui::TreeNode("details");
+				info.prop.set_value(object, prop_var);
 			}
 
-			if(open)
+			changed |= prop_changed;
+		}
+	}
+
+	return changed;
+}
+
+bool inspect_batch(rttr::variant& var, const std::vector<rttr::variant>& others, bool read_only,
+				   const property_observer& on_write)
+{
+	rttr::instance object = var;
+	auto type = object.get_derived_type();
+	const auto& properties = reflection::get_properties(type);
+	if(get_inspector(type))
+	{
+		if(!on_write)
+		{
+			return inspect_var(var, false, read_only);
+		}
+
+		// what such an inspector writes is not known, every property is told
+		std::vector<rttr::variant> before;
+		before.reserve(properties.size());
+		for(const auto& info : properties)
+		{
+			before.emplace_back(info.read_only ? rttr::variant() : info.prop.get_value(object));
+		}
+
+		bool changed = inspect_var(var, false, read_only);
+		if(changed)
+		{
+			for(std::size_t i = 0; i < properties.size(); ++i)
 			{
-				auto get_meta = [&prop](const rttr::variant& name) -> rttr::variant {
-					return prop.get_metadata(name);
-				};
-				if(is_array)
-				{
-					prop_changed |= inspect_array(prop_var, is_readonly, get_meta);
-				}
-				else if(is_associative_container)
+				const auto& info = properties[i];
+				if(!info.read_only)
 				{
-					prop_changed |= inspect_associative_container(prop_var, is_readonly);
+					on_write(object, info.prop, before[i], info.prop.get_value(object));
 				}
-				else if(is_enum)
-				{
-					auto enumeration = prop.get_enumeration();
-					prop_changed |= inspect_enum(prop_var, enumeration, is_readonly);
-				}
-				else
-				{
-					prop_changed |= inspect_var(prop_var, false, is_readonly, get_meta);
-				}
-
-				if(details && open)
-					gui::TreePop();
 			}
+		}
+		return changed;
+	}
+
+	if(others.empty() && !on_write)
+	{
+		return inspect_var(var, false, read_only);
+	}
 
-			if(prop_changed && !is_readonly)
+	bool changed = false;
+	for(const auto& info : properties)
+	{
+		rttr::variant prop_var;
+		bool prop_changed = inspect_property(object, info, prop_var);
+		if(prop_changed && !info.read_only && !read_only)
+		{
+			if(on_write)
 			{
-				prop.set_value(object, prop_var);
+				on_write(object, info.prop, info.prop.get_value(object), prop_var);
+			}
+			info.prop.set_value(object, prop_var);
+			for(const auto& other : others)
+			{
+				rttr::instance other_object = other;
+				if(on_write)
+				{
+					on_write(other_object, info.prop, info.prop.get_value(other_object), prop_var);
+				}
+				info.prop.set_value(other_object, prop_var);
 			}
-
-			changed |= prop_changed;
 		}
+
+		changed |= prop_changed;
 	}
 
 	return changed;
@@ -148,10 +256,11 @@ bool inspect_array(rttr::variant& var, bool read_only, const inspector::meta_get
 
 		property_layout layout(element.data());
 
-		changed |= inspect_var(value, false, read_only, get_metadata);
-
-		if(changed)
+		if(inspect_var(value, false, read_only, get_metadata))
+		{
 			view.set_value(i, value);
+			changed = true;
+		}
 	}
 
 	return changed;
@@ -2,9 +2,29 @@
 
 #include "inspector.h"
 
+#include <functional>
+#include <vector>
+
 rttr::variant get_meta_empty(const rttr::variant& other);
 bool inspect_var(rttr::variant& var, bool skip_custom = false, bool read_only = false,
 				 const inspector::meta_getter& get_metadata = get_meta_empty);
+
+using property_observer = std::function<void(const rttr::instance& object, const rttr::property& prop,
+											 const rttr::variant& before, const rttr::variant& after)>;
+
+//-----------------------------------------------------------------------------
+//  Name : inspect_batch ()
+/// <summary>
+/// Inspects an object edited along with others of its type. A property
+/// changed is written to the others as well, the ones left alone keep the
+/// values they have. A type with an inspector of its own only edits the
+/// object. Every property written is given to on_write with the value it
+/// had and the one it was given, all of them for a type with an inspector
+/// of its own.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool inspect_batch(rttr::variant& var, const std::vector<rttr::variant>& others, bool read_only = false,
+				   const property_observer& on_write = nullptr);
 bool inspect_array(rttr::variant& var, bool read_only = false,
 				   const inspector::meta_getter& get_metadata = get_meta_empty);
 bool inspect_associative_container(rttr::variant& var, bool read_only = false);
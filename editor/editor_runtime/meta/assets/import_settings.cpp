@@ -0,0 +1,70 @@
+#include "import_settings.hpp"
+
+#include <core/serialization/associative_archive.h>
+
+namespace asset_compiler
+{
+REFLECT(texture_import_settings)
+{
+	rttr::registration::enumeration<texture_compression>("texture_compression")(
+		rttr::value("None", texture_compression::none), rttr::value("BC1", texture_compression::bc1),
+		rttr::value("BC3", texture_compression::bc3), rttr::value("BC5", texture_compression::bc5),
+		rttr::value("BC7", texture_compression::bc7), rttr::value("ETC2", texture_compression::etc2),
+		rttr::value("ETC2A", texture_compression::etc2a));
+	rttr::registration::enumeration<texture_quality>("texture_quality")(
+		rttr::value("Fastest", texture_quality::fastest), rttr::value("Standard", texture_quality::standard),
+		rttr::value("Highest", texture_quality::highest));
+	rttr::registration::enumeration<mip_filter>("mip_filter")(
+		rttr::value("None", mip_filter::none), rttr::value("Box", mip_filter::box),
+		rttr::value("Box Linear", mip_filter::box_linear));
+
+	rttr::registration::class_<texture_platform_settings>("texture_platform_settings")
+		.property("compression", &texture_platform_settings::compression)(
+			rttr::metadata("pretty_name", "Compression"))
+		.property("quality", &texture_platform_settings::quality)(rttr::metadata("pretty_name", "Quality"))
+		.property("max_size", &texture_platform_settings::max_size)(
+			rttr::metadata("pretty_name", "Max Size"), rttr::metadata("min", 0), rttr::metadata("max", 16384),
+			rttr::metadata("tooltip", "The largest width or height, 0 for any."));
+
+	rttr::registration::class_<texture_import_settings>("texture_import_settings")
+		.property("desktop", &texture_import_settings::desktop)(rttr::metadata("pretty_name", "Desktop"))
+		.property("mobile", &texture_import_settings::mobile)(rttr::metadata("pretty_name", "Mobile"))
+		.property("mips", &texture_import_settings::mips)(rttr::metadata("pretty_name", "Mips"))
+		.property("normal_map", &texture_import_settings::normal_map)(
+			rttr::metadata("pretty_name", "Normal Map"));
+}
+
+SAVE(texture_platform_settings)
+{
+	try_save(ar, cereal::make_nvp("compression", obj.compression));
+	try_save(ar, cereal::make_nvp("quality", obj.quality));
+	try_save(ar, cereal::make_nvp("max_size", obj.max_size));
+}
+SAVE_INSTANTIATE(texture_platform_settings, cereal::oarchive_associative_t);
+
+LOAD(texture_platform_settings)
+{
+	try_load(ar, cereal::make_nvp("compression", obj.compression));
+	try_load(ar, cereal::make_nvp("quality", obj.quality));
+	try_load(ar, cereal::make_nvp("max_size", obj.max_size));
+}
+LOAD_INSTANTIATE(texture_platform_settings, cereal::iarchive_associative_t);
+
+SAVE(texture_import_settings)
+{
+	try_save(ar, cereal::make_nvp("desktop", obj.desktop));
+	try_save(ar, cereal::make_nvp("mobile", obj.mobile));
+	try_save(ar, cereal::make_nvp("mips", obj.mips));
+	try_save(ar, cereal::make_nvp("normal_map", obj.normal_map));
+}
+SAVE_INSTANTIATE(texture_import_settings, cereal::oarchive_associative_t);
+
+LOAD(texture_import_settings)
+{
+	try_load(ar, cereal::make_nvp("desktop", obj.desktop));
+	try_load(ar, cereal::make_nvp("mobile", obj.mobile));
+	try_load(ar, cereal::make_nvp("mips", obj.mips));
+	try_load(ar, cereal::make_nvp("normal_map", obj.normal_map));
+}
+LOAD_INSTANTIATE(texture_import_settings, cereal::iarchive_associative_t);
+}
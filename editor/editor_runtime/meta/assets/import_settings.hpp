@@ -0,0 +1,15 @@
+#pragma once
+
+#include "../../assets/import_settings.h"
+
+#include <core/reflection/reflection.h>
+#include <core/serialization/serialization.h>
+
+namespace asset_compiler
+{
+REFLECT_EXTERN(texture_import_settings);
+SAVE_EXTERN(texture_platform_settings);
+LOAD_EXTERN(texture_platform_settings);
+SAVE_EXTERN(texture_import_settings);
+LOAD_EXTERN(texture_import_settings);
+}
@@ -3,3 +3,4 @@
 
 #include "interface/gui_system.hpp"
 #include "system/project_manager.hpp"
+#include "assets/import_settings.hpp"
@@ -3,9 +3,11 @@
 
 #include <core/graphics/debugdraw.h>
 #include <core/graphics/render_pass.h>
+#include <core/graphics/vertex_decl.h>
 #include <core/system/subsystem.h>
 
 #include <runtime/assets/asset_manager.h>
+#include <runtime/ecs/systems/bounds_system.h>
 #include <runtime/ecs/components/camera_component.h>
 #include <runtime/ecs/components/light_component.h>
 #include <runtime/ecs/components/model_component.h>
@@ -17,16 +19,165 @@
 #include <runtime/rendering/model.h>
 #include <runtime/system/events.h>
 
+#include <algorithm>
+
 namespace editor
 {
+namespace
+{
+// the edges of a box between its corners, bit 0 of a corner picks the max x,
+// bit 1 the max y and bit 2 the max z
+const std::uint16_t box_edges[] = {0, 1, 2, 3, 4, 5, 6, 7, 0, 2, 1, 3, 4, 6, 5, 7, 0, 4, 1, 5, 2, 6, 3, 7};
+
+void add_corners(gfx::dd_batch& batch, const math::vec3* corners, std::uint32_t abgr)
+{
+	float positions[8 * 3];
+	for(std::size_t i = 0; i < 8; ++i)
+	{
+		positions[i * 3 + 0] = corners[i].x;
+		positions[i * 3 + 1] = corners[i].y;
+		positions[i * 3 + 2] = corners[i].z;
+	}
+	batch.add(gfx::dd_batch::primitive::lines, true, positions, 8, box_edges, 24, abgr);
+}
+
+void add_box(gfx::dd_batch& batch, const math::bbox& bounds, const math::transform& world, std::uint32_t abgr)
+{
+	math::vec3 corners[8];
+	for(std::size_t i = 0; i < 8; ++i)
+	{
+		const math::vec3 local((i & 1) ? bounds.max.x : bounds.min.x, (i & 2) ? bounds.max.y : bounds.min.y,
+							   (i & 4) ? bounds.max.z : bounds.min.z);
+		corners[i] = world.transform_coord(local);
+	}
+	add_corners(batch, corners, abgr);
+}
+
+// the corners of the clip space box brought back to world space
+void add_frustum(gfx::dd_batch& batch, const math::transform& view_proj, std::uint32_t abgr)
+{
+	const auto inv = math::inverse(view_proj.get_matrix());
+	const float near_z = gfx::is_homogeneous_depth() ? -1.0f : 0.0f;
+	math::vec3 corners[8];
+	for(std::size_t i = 0; i < 8; ++i)
+	{
+		const math::vec4 clip((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : near_z, 1.0f);
+		const auto p = inv * clip;
+		corners[i] = math::vec3(p) / p.w;
+	}
+	add_corners(batch, corners, abgr);
+}
+
+// a circle on each axis plane
+void add_rings(gfx::dd_batch& batch, const math::vec3& center, float radius, std::uint32_t abgr)
+{
+	constexpr std::uint32_t segments = 32;
+	float positions[segments * 3];
+	std::uint16_t indices[segments * 2];
+	for(std::uint32_t axis = 0; axis < 3; ++axis)
+	{
+		for(std::uint32_t i = 0; i < segments; ++i)
+		{
+			const auto angle = math::two_pi<float>() * float(i) / float(segments);
+			math::vec3 p = center;
+			p[(axis + 1) % 3] += math::cos(angle) * radius;
+			p[(axis + 2) % 3] += math::sin(angle) * radius;
+			positions[i * 3 + 0] = p.x;
+			positions[i * 3 + 1] = p.y;
+			positions[i * 3 + 2] = p.z;
+			indices[i * 2 + 0] = std::uint16_t(i);
+			indices[i * 2 + 1] = std::uint16_t((i + 1) % segments);
+		}
+		batch.add(gfx::dd_batch::primitive::lines, true, positions, segments, indices, segments * 2, abgr);
+	}
+}
+
+// the circles of a cone or a cylinder around the axis, joined by four lines,
+// to the apex of a cone when the end radius is zero
+void add_tube(gfx::dd_batch& batch, const math::vec3& from, const math::vec3& to, float from_radius,
+			  float to_radius, std::uint32_t abgr)
+{
+	const auto axis = to - from;
+	if(math::length(axis) <= 0.0f)
+	{
+		return;
+	}
+
+	const auto n = math::normalize(axis);
+	const auto helper = math::abs(n.y) < 0.99f ? math::vec3(0.0f, 1.0f, 0.0f) : math::vec3(1.0f, 0.0f, 0.0f);
+	const auto u = math::normalize(math::cross(helper, n));
+	const auto v = math::cross(n, u);
+
+	constexpr std::uint32_t segments = 32;
+	constexpr std::uint32_t spokes = 4;
+	float positions[segments * 2 * 3];
+	std::uint16_t indices[segments * 2 * 2 + spokes * 2];
+	std::uint32_t index_count = 0;
+	const std::uint32_t rings = to_radius > 0.0f ? 2 : 1;
+	for(std::uint32_t ring = 0; ring < 2; ++ring)
+	{
+		const auto& center = ring == 0 ? from : to;
+		const auto radius = ring == 0 ? from_radius : to_radius;
+		for(std::uint32_t i = 0; i < segments; ++i)
+		{
+			const auto angle = math::two_pi<float>() * float(i) / float(segments);
+			const auto p = center + (u * math::cos(angle) + v * math::sin(angle)) * radius;
+			const auto vertex = ring * segments + i;
+			positions[vertex * 3 + 0] = p.x;
+			positions[vertex * 3 + 1] = p.y;
+			positions[vertex * 3 + 2] = p.z;
+			if(ring < rings)
+			{
+				indices[index_count++] = std::uint16_t(vertex);
+				indices[index_count++] = std::uint16_t(ring * segments + (i + 1) % segments);
+			}
+		}
+	}
+	for(std::uint32_t i = 0; i < spokes; ++i)
+	{
+		const auto at = i * segments / spokes;
+		indices[index_count++] = std::uint16_t(at);
+		// every vertex of the second ring is the apex of a cone
+		indices[index_count++] = std::uint16_t(segments + at);
+	}
+	batch.add(gfx::dd_batch::primitive::lines, true, positions, segments * 2, indices, index_count, abgr);
+}
+
+std::uint32_t get_last_touched(const runtime::entity& e, std::uint32_t& components)
+{
+	std::uint32_t last_touched = 0;
+	std::uint32_t bit = 1;
+	auto check = [&](const std::shared_ptr<runtime::component>& component) {
+		if(component)
+		{
+			components |= bit;
+			last_touched = std::max(last_touched, component->get_last_touched());
+		}
+		bit <<= 1;
+	};
+	check(e.get_component<transform_component>().lock());
+	check(e.get_component<camera_component>().lock());
+	check(e.get_component<light_component>().lock());
+	check(e.get_component<reflection_probe_component>().lock());
+	check(e.get_component<model_component>().lock());
+	return last_touched;
+}
+
+// the bit of a component in what get_last_touched gives
+constexpr std::uint32_t camera_bit = 1 << 1;
+constexpr std::uint32_t model_bit = 1 << 4;
+}
+
 void debugdraw_system::frame_render(delta_t)
 {
 	auto& es = core::get_subsystem<editing_system>();
 	auto& editor_camera = es.camera;
-	auto& selected = es.selection_data.object;
 	if(!editor_camera || !editor_camera.has_component<camera_component>())
 		return;
 
+	if(!batch_program_ || !batch_program_->begin())
+		return;
+
 	const auto camera_comp = editor_camera.get_component<camera_component>();
 	const auto camera_comp_ptr = camera_comp.lock().get();
 	auto& render_view = camera_comp_ptr->get_render_view();
@@ -35,70 +186,173 @@ void debugdraw_system::frame_render(delta_t)
 	const auto& proj = camera.get_projection();
 	const auto& viewport_size = camera.get_viewport_size();
 	const auto surface = render_view.get_output_fbo(viewport_size);
-	const auto camera_posiiton = camera.get_position();
 
 	gfx::render_pass pass("debug_draw_pass");
 	pass.bind(surface.get());
 	pass.set_view_proj(view, proj);
-	gfx::dd_raii dd(pass.id);
 
 	if(es.show_grid)
 	{
-		auto draw_grid = [&](std::uint32_t grid_color, float height, float height_intervals,
-							 std::uint32_t size_intervals, std::uint32_t iteration,
-							 std::uint32_t max_iterations) {
-			bool should_render = true;
-			if(iteration + 1 != max_iterations)
+		draw_grid(pass.id, camera);
+	}
+
+	const auto& frustum = camera.get_frustum();
+	if(es.show_all_bounds)
+	{
+		auto& bounds = core::get_subsystem<runtime::bounds_system>();
+		bounds.cull(frustum, visible_);
+		for(std::size_t i = 0; i < bounds.size(); ++i)
+		{
+			if(runtime::bounds_system::is_visible(visible_, i))
 			{
-				const auto iterationHeight = height_intervals * float(iteration + 1);
-				const float factor = math::clamp(height, 0.0f, iterationHeight) / iterationHeight;
-				std::uint32_t r = (grid_color)&0xff;
-				std::uint32_t g = (grid_color >> 8) & 0xff;
-				std::uint32_t b = (grid_color >> 16) & 0xff;
-				std::uint32_t a = (grid_color >> 24) & 0xff;
-				a = static_cast<std::uint32_t>(math::lerp(255.0f, 0.0f, factor));
-				if(a < 10)
-					should_render = false;
-
-				grid_color = r + (g << 8) + (b << 16) + (a << 24);
+				add_box(batch_, bounds.get_bounds(i), math::transform::identity(), 0xff808080);
 			}
+		}
+		batch_.submit(pass.id, batch_program_->native_handle());
+	}
 
-			if(should_render)
+	refresh_selected();
+	if(selected_valid_)
+	{
+		selected_batch_.submit(pass.id, batch_program_->native_handle(), true);
+	}
+
+	batch_program_->end();
+}
+
+void debugdraw_system::create_grid()
+{
+	static const std::uint32_t divison = 5;
+	static const std::uint32_t iterations = 3;
+
+	std::vector<gfx::pos_color0_vertex> vertices;
+	std::vector<std::uint16_t> indices;
+	const auto grid_size = static_cast<std::uint32_t>(math::pow(divison, iterations));
+	for(std::uint32_t iteration = 0; iteration < iterations; ++iteration)
+	{
+		const auto step = static_cast<std::uint32_t>(
+			math::pow<int>(static_cast<int>(divison), static_cast<int>(iteration)));
+		const auto size = grid_size / step;
+		// as many lines as the debug draw grid of the size had
+		const auto lines = (size / 2) * 2 + 1;
+		const auto extent = float(size / 2) * float(step);
+
+		grid_level level;
+		level.index_begin = static_cast<std::uint32_t>(indices.size());
+		for(std::uint32_t i = 0; i < lines; ++i)
+		{
+			const auto offset = -extent + float(i) * float(step);
+			const float ends[4][2] = {
+				{-extent, offset}, {extent, offset}, {offset, -extent}, {offset, extent}};
+			for(const auto& end : ends)
 			{
-				const auto step = static_cast<std::uint32_t>(
-					math::pow<int>(static_cast<int>(size_intervals), static_cast<int>(iteration)));
-				const auto grid_size = static_cast<std::uint32_t>(math::pow(size_intervals, max_iterations));
-				const auto sz = grid_size / step;
-
-				dd.encoder.push();
-				dd.encoder.setState(true, false, true);
-				dd.encoder.setColor(grid_color);
-				math::vec3 center = {0.0f, 0.0f, 0.0f};
-				math::vec3 normal = {0.0f, 1.0f, 0.0f};
-
-				dd.encoder.drawGrid({normal.x, normal.y, normal.z}, {center.x, center.y, center.z}, sz,
-									float(step));
-				dd.encoder.pop();
+				gfx::pos_color0_vertex v;
+				v.x = end[0];
+				v.z = end[1];
+				v.abgr = 0xff808080;
+				indices.push_back(static_cast<std::uint16_t>(vertices.size()));
+				vertices.push_back(v);
 			}
-		};
+		}
+		level.index_count = static_cast<std::uint32_t>(indices.size()) - level.index_begin;
+		grid_levels_.push_back(level);
+	}
 
-		static const auto divison = 5;
-		static const auto iterations = 3;
-		static const auto height = 40.0f;
+	const auto& layout = gfx::pos_color0_vertex::get_layout();
+	grid_vertices_ = std::make_unique<gfx::vertex_buffer>(
+		gfx::copy(vertices.data(), static_cast<std::uint32_t>(vertices.size() * layout.getStride())),
+		layout);
+	grid_indices_ = std::make_unique<gfx::index_buffer>(
+		gfx::copy(indices.data(), static_cast<std::uint32_t>(indices.size() * sizeof(std::uint16_t))));
+}
 
-		for(std::uint32_t i = 0; i < iterations; ++i)
+void debugdraw_system::draw_grid(gfx::view_id id, const camera& camera)
+{
+	if(!grid_vertices_)
+	{
+		create_grid();
+	}
+
+	static const auto height_intervals = 40.0f;
+	const auto height = math::abs(camera.get_position().y);
+	const auto levels = static_cast<std::uint32_t>(grid_levels_.size());
+	for(std::uint32_t iteration = 0; iteration < levels; ++iteration)
+	{
+		std::uint32_t a = 255;
+		if(iteration + 1 != levels)
 		{
-			draw_grid(0xff808080, math::abs(camera_posiiton.y), height, divison, i, iterations);
+			const auto iteration_height = height_intervals * float(iteration + 1);
+			const float factor = math::clamp(height, 0.0f, iteration_height) / iteration_height;
+			a = static_cast<std::uint32_t>(math::lerp(255.0f, 0.0f, factor));
+			if(a < 10)
+				continue;
 		}
+
+		// the fade is the blend factor, the buffers stay as they are
+		const std::uint64_t state =
+			BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_MSAA | BGFX_STATE_PT_LINES |
+			BGFX_STATE_LINEAA | BGFX_STATE_DEPTH_TEST_LESS |
+			BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_FACTOR, BGFX_STATE_BLEND_INV_FACTOR);
+		const auto& level = grid_levels_[iteration];
+		gfx::set_vertex_buffer(0, grid_vertices_->native_handle(), 0, ~std::uint32_t(0));
+		gfx::set_index_buffer(grid_indices_->native_handle(), level.index_begin, level.index_count);
+		gfx::set_state(state, a * 0x01010101u);
+		gfx::submit(id, batch_program_->native_handle());
 	}
+}
 
+void debugdraw_system::refresh_selected()
+{
+	auto& es = core::get_subsystem<editing_system>();
+	auto& selected = es.selection_data.object;
 	if(!selected || !selected.is_type<runtime::entity>())
+	{
+		selected_valid_ = false;
 		return;
+	}
 
 	auto selected_entity = selected.get_value<runtime::entity>();
-
 	if(!selected_entity || !selected_entity.has_component<transform_component>())
+	{
+		selected_valid_ = false;
 		return;
+	}
+
+	std::uint32_t components = 0;
+	const auto last_touched = get_last_touched(selected_entity, components);
+	bool changed = !selected_valid_ || selected_entity != selected_ || components != selected_components_ ||
+				   last_touched >= selected_built_;
+
+	auto& bounds = core::get_subsystem<runtime::bounds_system>();
+	if((components & model_bit) != 0)
+	{
+		changed |= bounds.get_version() != selected_bounds_version_;
+	}
+
+	if((components & camera_bit) != 0 && selected_entity != es.camera)
+	{
+		const auto camera_comp = selected_entity.get_component<camera_component>().lock();
+		changed |= camera_comp->get_camera().get_view_projection().get_matrix() != selected_view_proj_;
+	}
+
+	if(!changed)
+	{
+		return;
+	}
+
+	build_selected(selected_entity);
+	selected_ = selected_entity;
+	selected_components_ = components;
+	selected_built_ = static_cast<std::uint32_t>(ecs::get_frame());
+	selected_bounds_version_ = bounds.get_version();
+	selected_valid_ = true;
+}
+
+void debugdraw_system::build_selected(runtime::entity selected_entity)
+{
+	auto& es = core::get_subsystem<editing_system>();
+	auto& editor_camera = es.camera;
+	selected_batch_.clear();
 
 	const auto transform_comp = selected_entity.get_component<transform_component>().lock();
 	const auto transform_comp_ptr = transform_comp.get();
@@ -110,29 +364,15 @@ void debugdraw_system::frame_render(delta_t)
 		const auto selected_camera_comp_ptr = selected_camera_comp.lock().get();
 		auto& selected_camera = selected_camera_comp_ptr->get_camera();
 		const auto view_proj = selected_camera.get_view_projection();
-		const auto bounds = selected_camera.get_local_bounding_box();
-		dd.encoder.push();
-		dd.encoder.setColor(0xffffffff);
-		dd.encoder.setWireframe(true);
+		selected_view_proj_ = view_proj.get_matrix();
 		if(selected_camera.get_projection_mode() == projection_mode::perspective)
 		{
-			dd.encoder.drawFrustum(&view_proj);
+			add_frustum(selected_batch_, view_proj, 0xffffffff);
 		}
 		else
 		{
-			Aabb aabb;
-			aabb.m_min.x = bounds.min.x;
-			aabb.m_min.y = bounds.min.y;
-			aabb.m_min.z = bounds.min.z;
-			aabb.m_max.x = bounds.max.x;
-			aabb.m_max.y = bounds.max.y;
-			aabb.m_max.z = bounds.max.z;
-			dd.encoder.pushTransform(&world_transform);
-			dd.encoder.draw(aabb);
-			dd.encoder.popTransform();
+			add_box(selected_batch_, selected_camera.get_local_bounding_box(), world_transform, 0xffffffff);
 		}
-
-		dd.encoder.pop();
 	}
 
 	if(selected_entity.has_component<light_component>())
@@ -140,61 +380,28 @@ void debugdraw_system::frame_render(delta_t)
 		const auto light_comp = selected_entity.get_component<light_component>();
 		const auto light_comp_ptr = light_comp.lock().get();
 		const auto& light = light_comp_ptr->get_light();
+		const math::vec3 position = transform_comp_ptr->get_position();
+		const math::vec3 z_axis = math::normalize(transform_comp_ptr->get_z_axis());
 		if(light.type == light_type::spot)
 		{
-			auto adjacent = light.spot_data.get_range();
-			{
-				auto tan_angle = math::tan(math::radians(light.spot_data.get_outer_angle() * 0.5f));
-				// oposite = tan * adjacent
-				auto oposite = tan_angle * adjacent;
-				dd.encoder.push();
-				dd.encoder.setColor(0xff00ff00);
-				dd.encoder.setWireframe(true);
-				dd.encoder.setLod(3);
-				math::vec3 from = transform_comp_ptr->get_position();
-				math::vec3 to = from + transform_comp_ptr->get_z_axis() * adjacent;
-				dd.encoder.drawCone({to.x, to.y, to.z}, {from.x, from.y, from.z}, oposite);
-				dd.encoder.pop();
-			}
-			{
-				auto tan_angle = math::tan(math::radians(light.spot_data.get_inner_angle() * 0.5f));
-				// oposite = tan * adjacent
-				auto oposite = tan_angle * adjacent;
-				dd.encoder.push();
-				dd.encoder.setColor(0xff00ffff);
-				dd.encoder.setWireframe(true);
-				dd.encoder.setLod(3);
-				math::vec3 from = transform_comp_ptr->get_position();
-				math::vec3 to = from + transform_comp_ptr->get_z_axis() * adjacent;
-				dd.encoder.drawCone({to.x, to.y, to.z}, {from.x, from.y, from.z}, oposite);
-				dd.encoder.pop();
-			}
+			const auto adjacent = light.spot_data.get_range();
+			const math::vec3 to = position + z_axis * adjacent;
+			// oposite = tan * adjacent
+			const auto outer = math::tan(math::radians(light.spot_data.get_outer_angle() * 0.5f)) * adjacent;
+			const auto inner = math::tan(math::radians(light.spot_data.get_inner_angle() * 0.5f)) * adjacent;
+			add_tube(selected_batch_, to, position, outer, 0.0f, 0xff00ff00);
+			add_tube(selected_batch_, to, position, inner, 0.0f, 0xff00ffff);
 		}
 		else if(light.type == light_type::point)
 		{
-			auto radius = light.point_data.range;
-			dd.encoder.push();
-			dd.encoder.setColor(0xff00ff00);
-			dd.encoder.setWireframe(true);
-			math::vec3 center = transform_comp_ptr->get_position();
-			dd.encoder.drawCircle(Axis::X, center.x, center.y, center.z, radius);
-			dd.encoder.drawCircle(Axis::Y, center.x, center.y, center.z, radius);
-			dd.encoder.drawCircle(Axis::Z, center.x, center.y, center.z, radius);
-			dd.encoder.pop();
+			add_rings(selected_batch_, position, light.point_data.range, 0xff00ff00);
 		}
 		else if(light.type == light_type::directional)
 		{
-			dd.encoder.push();
-			dd.encoder.setLod(255);
-			dd.encoder.setColor(0xff00ff00);
-			dd.encoder.setWireframe(true);
-			math::vec3 from1 = transform_comp_ptr->get_position();
-			math::vec3 to1 = from1 + transform_comp_ptr->get_z_axis() * 2.0f;
-			dd.encoder.drawCylinder({from1.x, from1.y, from1.z}, {to1.x, to1.y, to1.z}, 0.1f);
-			math::vec3 from2 = to1;
-			math::vec3 to2 = from2 + transform_comp_ptr->get_z_axis() * 1.5f;
-			dd.encoder.drawCone({from2.x, from2.y, from2.z}, {to2.x, to2.y, to2.z}, 0.5f);
-			dd.encoder.pop();
+			const math::vec3 to1 = position + z_axis * 2.0f;
+			const math::vec3 to2 = to1 + z_axis * 1.5f;
+			add_tube(selected_batch_, position, to1, 0.1f, 0.1f, 0xff00ff00);
+			add_tube(selected_batch_, to1, to2, 0.5f, 0.0f, 0xff00ff00);
 		}
 	}
 
@@ -205,92 +412,22 @@ void debugdraw_system::frame_render(delta_t)
 		const auto& probe = probe_comp_ptr->get_probe();
 		if(probe.type == probe_type::box)
 		{
-			dd.encoder.push();
-			dd.encoder.setColor(0xff00ff00);
-			dd.encoder.setWireframe(true);
-			dd.encoder.pushTransform(&world_transform);
-			Aabb aabb;
-			aabb.m_min.x = -probe.box_data.extents.x;
-			aabb.m_min.y = -probe.box_data.extents.y;
-			aabb.m_min.z = -probe.box_data.extents.z;
-			aabb.m_max.x = probe.box_data.extents.x;
-			aabb.m_max.y = probe.box_data.extents.y;
-			aabb.m_max.z = probe.box_data.extents.z;
-			dd.encoder.draw(aabb);
-			dd.encoder.popTransform();
-			dd.encoder.pop();
+			const math::bbox bounds(-probe.box_data.extents, probe.box_data.extents);
+			add_box(selected_batch_, bounds, world_transform, 0xff00ff00);
 		}
 		else
 		{
-			auto radius = probe.sphere_data.range;
-			dd.encoder.push();
-			dd.encoder.setColor(0xff00ff00);
-			dd.encoder.setWireframe(true);
-			math::vec3 center = transform_comp_ptr->get_position();
-			dd.encoder.drawCircle(Axis::X, center.x, center.y, center.z, radius);
-			dd.encoder.drawCircle(Axis::Y, center.x, center.y, center.z, radius);
-			dd.encoder.drawCircle(Axis::Z, center.x, center.y, center.z, radius);
-			dd.encoder.pop();
+			const math::vec3 center = transform_comp_ptr->get_position();
+			add_rings(selected_batch_, center, probe.sphere_data.range, 0xff00ff00);
 		}
 	}
 
-	if(selected_entity.has_component<model_component>())
+	// the world bounds the bounds system keeps, none until the mesh is loaded
+	auto& bounds = core::get_subsystem<runtime::bounds_system>();
+	const auto entry = bounds.find(selected_entity);
+	if(entry != runtime::bounds_system::no_entry)
 	{
-		const auto model_comp = selected_entity.get_component<model_component>();
-		const auto model_comp_ptr = model_comp.lock().get();
-		const auto& model = model_comp_ptr->get_model();
-		if(!model.is_valid())
-			return;
-
-		const auto mesh = model.get_lod(0);
-		if(!mesh)
-			return;
-		const auto& frustum = camera.get_frustum();
-		const auto& bounds = mesh->get_bounds();
-		// Test the bounding box of the mesh
-		if(math::frustum::test_obb(frustum, bounds, world_transform))
-		{
-			// if(es->wireframe_selection)
-			//{
-			//	const float u_params[8] =
-			//	{
-			//		1.0f, 1.0f, 0.0f, 0.7f, //r,g,b,a
-			//		1.0f, 0.0f, 0.0f, 0.0f  //thickness, unused, unused, unused
-			//	};
-			//	if (!_program)
-			//		return;
-			//
-			//	model.render(
-			//		pass.id,
-			//		world_transform,
-			//		false,
-			//		false,
-			//		false,
-			//		BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA),
-			//		0,
-			//		_program.get(), [&u_params](program& p)
-			//	{
-			//		p.set_uniform("u_params", &u_params, 2);
-			//	});
-			//}
-			// else
-			{
-				dd.encoder.push();
-				dd.encoder.setColor(0xff00ff00);
-				dd.encoder.setWireframe(true);
-				dd.encoder.pushTransform(&world_transform);
-				Aabb aabb;
-				aabb.m_min.x = bounds.min.x;
-				aabb.m_min.y = bounds.min.y;
-				aabb.m_min.z = bounds.min.z;
-				aabb.m_max.x = bounds.max.x;
-				aabb.m_max.y = bounds.max.y;
-				aabb.m_max.z = bounds.max.z;
-				dd.encoder.draw(aabb);
-				dd.encoder.popTransform();
-				dd.encoder.pop();
-			}
-		}
+		add_box(selected_batch_, bounds.get_bounds(entry), math::transform::identity(), 0xff00ff00);
 	}
 }
 
@@ -311,12 +448,19 @@ debugdraw_system::debugdraw_system()
 		},
 		vs_wf_wireframe, fs_wf_wireframe);
 
-	ddInit();
+	auto vs_debug_draw = am.load<gfx::shader>("editor:/data/shaders/vs_debug_draw.sc");
+	auto fs_debug_draw = am.load<gfx::shader>("editor:/data/shaders/fs_debug_draw.sc");
+	vs_debug_draw.wait();
+	fs_debug_draw.wait();
+	ts.push_or_execute_on_owner_thread(
+		[this](asset_handle<gfx::shader> vs, asset_handle<gfx::shader> fs) {
+			batch_program_ = std::make_unique<gpu_program>(vs, fs);
+		},
+		vs_debug_draw, fs_debug_draw);
 }
 
 debugdraw_system::~debugdraw_system()
 {
-	ddShutdown();
 	runtime::on_frame_render.disconnect(this, &debugdraw_system::frame_render);
 }
 } // namespace editor
@@ -1,9 +1,18 @@
 #pragma once
 
 #include <core/common/basetypes.hpp>
+#include <core/graphics/debugdraw.h>
+#include <core/graphics/index_buffer.h>
+#include <core/graphics/vertex_buffer.h>
+#include <core/math/math_includes.h>
 
+#include <runtime/ecs/ecs.h>
+
+#include <cstdint>
 #include <memory>
+#include <vector>
 
+class camera;
 class gpu_program;
 
 namespace editor
@@ -25,7 +34,57 @@ public:
 	void frame_render(delta_t dt);
 
 private:
+	/// the lines of a grid, the levels are in one index buffer
+	struct grid_level
+	{
+		std::uint32_t index_begin = 0;
+		std::uint32_t index_count = 0;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : draw_grid ()
+	/// <summary>
+	/// Draws the levels of the grid from the static buffers, created in the
+	/// first frame, fading the finer ones out as the camera rises.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void draw_grid(gfx::view_id id, const camera& camera);
+	void create_grid();
+
+	//-----------------------------------------------------------------------------
+	//  Name : refresh_selected ()
+	/// <summary>
+	/// Builds the bounds and gizmos of the selected entity again if it is
+	/// another one, or any of the components they are made from changed
+	/// since they were built.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void refresh_selected();
+	void build_selected(runtime::entity selected_entity);
+
 	///
 	std::unique_ptr<gpu_program> program_;
+	/// draws the batch, positions and colors without a model transform
+	std::unique_ptr<gpu_program> batch_program_;
+	/// the wire shapes of the frame, drawn with a submit per depth mode
+	gfx::dd_batch batch_;
+	/// the bounds in the editor camera when all bounds are shown
+	std::vector<std::uint64_t> visible_;
+
+	std::unique_ptr<gfx::vertex_buffer> grid_vertices_;
+	std::unique_ptr<gfx::index_buffer> grid_indices_;
+	std::vector<grid_level> grid_levels_;
+
+	/// the wire shapes of the selected entity, kept while it does not change
+	gfx::dd_batch selected_batch_;
+	runtime::entity selected_;
+	/// the frame they were built in, what was touched in it may have changed after
+	std::uint32_t selected_built_ = 0;
+	/// which of the components the shapes are made from the entity had
+	std::uint32_t selected_components_ = 0;
+	std::uint64_t selected_bounds_version_ = 0;
+	/// the view projection of a selected camera, which follows its viewport
+	math::mat4 selected_view_proj_;
+	bool selected_valid_ = false;
 };
 }
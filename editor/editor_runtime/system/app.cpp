@@ -1,12 +1,20 @@
 #include "app.h"
+#include "../assets/asset_compiler.h"
+#include "../assets/import_settings.h"
+#include "../assets/shared_cache.h"
 #include "../console/console_log.h"
 #include "../editing/editing_system.h"
 #include "../editing/picking_system.h"
+#include "../editing/scene_loader.h"
 #include "../interface/docks/console_dock.h"
 #include "../interface/docks/docking.h"
 #include "../interface/docks/game_dock.h"
+#include "../interface/docks/heap_dock.h"
 #include "../interface/docks/hierarchy_dock.h"
 #include "../interface/docks/inspector_dock.h"
+#include "../interface/docks/loads_dock.h"
+#include "../interface/docks/memory_dock.h"
+#include "../interface/docks/profiler_dock.h"
 #include "../interface/docks/project_dock.h"
 #include "../interface/docks/scene_dock.h"
 #include "../interface/docks/style_dock.h"
@@ -15,7 +23,12 @@
 #include "../system/project_manager.h"
 
 #include <core/filesystem/filesystem.h>
+#include <core/graphics/gpu_memory.h>
 #include <core/logging/logging.h>
+#include <core/profiling/memory_tracker.h>
+#include <core/profiling/profiler.h>
+#include <core/simulation/simulation.h>
+#include <core/tasks/task_system.h>
 
 #include <runtime/assets/asset_manager.h>
 #include <runtime/ecs/components/camera_component.h>
@@ -25,13 +38,19 @@
 #include <runtime/ecs/components/transform_component.h>
 #include <runtime/ecs/constructs/scene.h>
 #include <runtime/ecs/constructs/utils.h>
+#include <runtime/ecs/systems/deferred_rendering.h>
 #include <runtime/ecs/systems/scene_graph.h>
+#include <runtime/ecs/systems/system_scheduler.h>
 #include <runtime/input/input.h>
 #include <runtime/rendering/renderer.h>
+#include <runtime/rendering/texture_arrays.h>
 #include <runtime/system/events.h>
+#include <runtime/system/startup_phases.h>
 
 #include <editor_core/nativefd/filedialog.h>
 
+#include <fstream>
+
 namespace editor
 {
 namespace
@@ -182,27 +201,24 @@ auto create_new_scene()
 {
 	auto& es = core::get_subsystem<editor::editing_system>();
 	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+	es.discard_play();
+	es.undo.clear();
 	es.save_editor_camera();
 	ecs.dispose();
 	es.load_editor_camera();
 	default_scene();
 	es.scene.clear();
+	core::get_subsystem<runtime::asset_manager>().request_sweep();
 }
 
 auto open_scene()
 {
-	auto& es = core::get_subsystem<editor::editing_system>();
-	auto& am = core::get_subsystem<runtime::asset_manager>();
-	es.save_editor_camera();
+	auto& loader = core::get_subsystem<editor::scene_loader>();
 
 	std::string path;
 	if(native::open_file_dialog("sgr", fs::resolve_protocol("app:/data").string(), path))
 	{
-		auto scene_path = fs::convert_to_protocol(path);
-		auto scene = am.load<::scene>(scene_path.string()).get();
-		scene->instantiate(::scene::mode::standard);
-		es.load_editor_camera();
-		es.scene = path;
+		loader.load(fs::convert_to_protocol(path).string());
 	}
 }
 
@@ -236,6 +252,18 @@ void save_scene_as()
 
 	es.save_editor_camera();
 }
+
+void pack_assets()
+{
+	std::string path;
+	if(native::save_file_dialog("pak", fs::resolve_protocol("app:/").string(), path))
+	{
+		if(!fs::path(path).has_extension())
+			path += ".pak";
+
+		asset_compiler::pack(fs::resolve_protocol("app:/cache"), path);
+	}
+}
 }
 
 void app::draw_menubar(render_window& window)
@@ -269,6 +297,22 @@ void app::draw_menubar(render_window& window)
 		{
 			create_new_scene();
 		}
+
+		if(input.is_key_pressed(mml::keyboard::Z))
+		{
+			if(input.is_key_down(mml::keyboard::LShift))
+			{
+				es.undo.redo();
+			}
+			else
+			{
+				es.undo.undo();
+			}
+		}
+		else if(input.is_key_pressed(mml::keyboard::Y))
+		{
+			es.undo.redo();
+		}
 	}
 	if(gui::BeginMainMenuBar())
 	{
@@ -306,15 +350,27 @@ void app::draw_menubar(render_window& window)
 				save_scene_as();
 			}
 
+			if(gui::MenuItem("PACK ASSETS..", nullptr, false, current_project != ""))
+			{
+				pack_assets();
+			}
+
+			if(gui::MenuItem("REIMPORT ASSETS", nullptr, false, !pm.is_reimporting()))
+			{
+				pm.reimport_assets(false);
+			}
+
 			gui::EndMenu();
 		}
 		if(gui::BeginMenu("EDIT"))
 		{
-			if(gui::MenuItem("UNDO", "CTRL+Z"))
+			if(gui::MenuItem("UNDO", "CTRL+Z", false, es.undo.can_undo()))
 			{
+				es.undo.undo();
 			}
-			if(gui::MenuItem("REDO", "CTRL+Y", false, false))
+			if(gui::MenuItem("REDO", "CTRL+Y", false, es.undo.can_redo()))
 			{
+				es.undo.redo();
 			}
 			gui::Separator();
 			if(gui::MenuItem("CUT", "CTRL+X"))
@@ -354,6 +410,22 @@ void app::draw_menubar(render_window& window)
 			{
 				create_window_with_dock<style_dock>("STYLE");
 			}
+			if(gui::MenuItem("PROFILER"))
+			{
+				create_window_with_dock<profiler_dock>("PROFILER");
+			}
+			if(gui::MenuItem("ASSET LOADS"))
+			{
+				create_window_with_dock<loads_dock>("ASSET LOADS");
+			}
+			if(gui::MenuItem("GPU MEMORY"))
+			{
+				create_window_with_dock<memory_dock>("GPU MEMORY");
+			}
+			if(gui::MenuItem("HEAP MEMORY"))
+			{
+				create_window_with_dock<heap_dock>("HEAP MEMORY");
+			}
 			gui::EndMenu();
 		}
 		float offset = gui::GetWindowHeight();
@@ -406,10 +478,24 @@ void app::draw_toolbar()
 	{
 		es.wireframe_selection = !es.wireframe_selection;
 	}
+	gui::SameLine(0.0f);
+	if(gui::ToolbarButton(icons["mesh"].get(), "SHOW ALL BOUNDS", es.show_all_bounds))
+	{
+		es.show_all_bounds = !es.show_all_bounds;
+	}
 
 	gui::SameLine(width / 2.0f - 36.0f);
-	if(gui::ToolbarButton(icons["play"].get(), "PLAY", false))
+	const bool playing = es.is_playing();
+	if(gui::ToolbarButton(icons[playing ? "stop" : "play"].get(), playing ? "STOP" : "PLAY", playing))
 	{
+		if(playing)
+		{
+			es.stop();
+		}
+		else
+		{
+			es.play();
+		}
 	}
 	gui::SameLine(0.0f);
 	if(gui::ToolbarButton(icons["pause"].get(), "PAUSE", false))
@@ -427,6 +513,13 @@ void app::setup(cmd_line::parser& parser)
 {
 	runtime::app::setup(parser);
 
+	parser.set_optional<std::string>("d", "shared_cache", "",
+									 "Directory of a compile cache shared with other machines.");
+	parser.set_optional<int>("q", "idle_fps", 10,
+							 "Maximum frames per second while nothing is input or changes. 0 to disable.");
+	parser.set_optional<std::string>("tp", "texture_platform", "desktop",
+									 "Platform whose texture settings are compiled, desktop or mobile.");
+
 	runtime::on_frame_ui_render.connect(this, &editor::app::draw_docks);
 }
 
@@ -439,15 +532,41 @@ void app::start(cmd_line::parser& parser)
 
 	runtime::app::start(parser);
 
+	int idle_fps = 10;
+	parser.try_get("idle_fps", idle_fps);
+	auto& sim = core::get_subsystem<core::simulation>();
+	sim.set_max_idle_fps(static_cast<std::uint32_t>(std::max(idle_fps, 0)));
+
+	runtime::startup_phases phases;
+	// before the project manager compiles anything
+	std::string shared_cache_dir;
+	parser.try_get("shared_cache", shared_cache_dir);
+	asset_compiler::shared_cache::set_directory(shared_cache_dir);
+	std::string texture_platform = "desktop";
+	parser.try_get("texture_platform", texture_platform);
+	asset_compiler::import_settings::set_target_platform(texture_platform == "mobile"
+															 ? asset_compiler::target_platform::mobile
+															 : asset_compiler::target_platform::desktop);
+
+	phases.next("gui");
 	core::add_subsystem<gui_system>();
 	core::add_subsystem<docking_system>();
+	phases.next("editing");
 	core::add_subsystem<editing_system>();
 	core::add_subsystem<picking_system>();
+	core::add_subsystem<scene_loader>();
 	core::add_subsystem<debugdraw_system>();
+	phases.next("project_scan");
 	core::add_subsystem<project_manager>();
 
+	// the cameras render only while a dock shows them
+	core::get_subsystem<runtime::deferred_rendering>().set_presented_only(true);
+	gpu_capture_.set_scene_getter([]() { return core::get_subsystem<editing_system>().scene; });
+
+	phases.next("docks");
 	create_docks();
 	register_console_commands();
+	phases.log("Editor started");
 }
 
 void app::create_docks()
@@ -465,6 +584,10 @@ void app::create_docks()
 	auto project = std::make_unique<project_dock>("PROJECT", true, ImVec2(200.0f, 200.0f));
 	auto console = std::make_unique<console_dock>("CONSOLE", true, ImVec2(200.0f, 200.0f), console_log_);
 	auto style = std::make_unique<style_dock>("STYLE", true, ImVec2(300.0f, 200.0f));
+	auto profiler = std::make_unique<profiler_dock>("PROFILER", true, ImVec2(300.0f, 200.0f));
+	auto loads = std::make_unique<loads_dock>("ASSET LOADS", true, ImVec2(300.0f, 200.0f));
+	auto memory = std::make_unique<memory_dock>("GPU MEMORY", true, ImVec2(300.0f, 200.0f));
+	auto heap = std::make_unique<heap_dock>("HEAP MEMORY", true, ImVec2(300.0f, 200.0f));
 
 	auto& docking = core::get_subsystem<docking_system>();
 	auto& dockspace = docking.get_dockspace(main_window->get_id());
@@ -475,6 +598,10 @@ void app::create_docks()
 	dockspace.dock_to(console.get(), imguidock::slot::bottom, 300, true);
 	dockspace.dock_with(project.get(), console.get(), imguidock::slot::tab, 250, true);
 	dockspace.dock_with(style.get(), project.get(), imguidock::slot::right, 400, true);
+	dockspace.dock_with(profiler.get(), style.get(), imguidock::slot::tab, 400, false);
+	dockspace.dock_with(loads.get(), style.get(), imguidock::slot::tab, 400, false);
+	dockspace.dock_with(memory.get(), style.get(), imguidock::slot::tab, 400, false);
+	dockspace.dock_with(heap.get(), style.get(), imguidock::slot::tab, 400, false);
 
 	docking.register_dock(std::move(scene));
 	docking.register_dock(std::move(game));
@@ -483,6 +610,10 @@ void app::create_docks()
 	docking.register_dock(std::move(console));
 	docking.register_dock(std::move(project));
 	docking.register_dock(std::move(style));
+	docking.register_dock(std::move(profiler));
+	docking.register_dock(std::move(loads));
+	docking.register_dock(std::move(memory));
+	docking.register_dock(std::move(heap));
 }
 
 void app::register_console_commands()
@@ -490,6 +621,225 @@ void app::register_console_commands()
 	std::function<void()> log_version = []() { APPLOG_INFO("Version 1.0"); };
 	console_log_->register_command("version", "Returns the current version of the Editor.", {}, {},
 								   log_version);
+
+	std::function<void()> log_ecs_memory = []() {
+		std::stringstream report;
+		core::get_subsystem<runtime::entity_component_system>().get_memory_report().write(report);
+		std::string line;
+		while(std::getline(report, line))
+		{
+			APPLOG_INFO(line);
+		}
+	};
+	std::function<void(int)> reimport_assets = [](int force) {
+		core::get_subsystem<project_manager>().reimport_assets(force != 0);
+	};
+	console_log_->register_command("reimport", "Compiles the assets again, all of them when forced (1).",
+								   {"force"}, {"0"}, reimport_assets);
+
+	std::function<void(int, int)> log_texture_budget = [](int budget_mb, int rows) {
+		std::stringstream report;
+		const auto budget = std::uint64_t(std::max(budget_mb, 0)) * 1024 * 1024;
+		asset_compiler::import_settings::write_texture_budget(report, budget, std::size_t(std::max(rows, 0)));
+		std::string line;
+		while(std::getline(report, line))
+		{
+			APPLOG_INFO(line);
+		}
+	};
+	console_log_->register_command("texture_budget",
+								   "Logs the compiled texture bytes per compression against a budget in MB.",
+								   {"budget_mb", "rows"}, {"256", "10"}, log_texture_budget);
+
+	console_log_->register_command("ecs_memory", "Logs the memory used by the entities and components.", {},
+								   {}, log_ecs_memory);
+
+	std::function<void()> log_systems = []() {
+		using ms_t = std::chrono::duration<double, std::milli>;
+		const auto& scheduler = core::get_subsystem<runtime::system_scheduler>();
+		APPLOG_INFO("Systems budget: {0:.2f}ms", ms_t(scheduler.get_budget()).count());
+		for(const auto& stats : scheduler.get_stats())
+		{
+			const auto rate =
+				stats.rate > 0.0f ? ", " + std::to_string(int(stats.rate)) + "Hz" : std::string();
+			APPLOG_INFO("{0}: {1:.3f}ms average, {2:.3f}ms last, {3} runs, {4} deferred{5}{6}", stats.name,
+						ms_t(stats.average_cost).count(), ms_t(stats.last_cost).count(), stats.runs,
+						stats.deferrals, rate, stats.is_deferrable ? ", deferrable" : "");
+		}
+	};
+	console_log_->register_command("systems", "Logs the cost of the ecs systems and their deferrals.", {}, {},
+								   log_systems);
+
+	std::function<void(int)> log_asset_loads = [](int rows) {
+		std::stringstream report;
+		auto& stats = core::get_subsystem<runtime::asset_manager>().get_load_stats();
+		stats.write_report(report, std::size_t(rows > 0 ? rows : 0));
+		std::string line;
+		while(std::getline(report, line))
+		{
+			APPLOG_INFO(line);
+		}
+	};
+	console_log_->register_command("asset_loads", "Logs the load times per asset type and the slowest loads.",
+								   {"rows"}, {"20"}, log_asset_loads);
+
+	std::function<void()> sweep_assets = []() {
+		const auto evicted = core::get_subsystem<runtime::asset_manager>().sweep();
+		APPLOG_INFO("Unloaded {0} assets nothing referenced.", evicted);
+	};
+	console_log_->register_command("asset_sweep", "Unloads the assets only the manager references.", {}, {},
+								   sweep_assets);
+
+	std::function<void(int)> log_asset_usage = [](int rows) {
+		std::stringstream report;
+		auto& am = core::get_subsystem<runtime::asset_manager>();
+		am.write_usage_report(report, std::size_t(rows > 0 ? rows : 0));
+		std::string line;
+		while(std::getline(report, line))
+		{
+			APPLOG_INFO(line);
+		}
+		APPLOG_INFO("{0} dependencies between the assets are recorded for the reloads.",
+					am.get_dependents_count());
+	};
+	console_log_->register_command("asset_usage", "Logs the loaded assets, what holds them and the largest.",
+								   {"rows"}, {"20"}, log_asset_usage);
+
+	std::function<void()> log_gpu_memory = []() {
+		const auto to_mb = [](std::uint64_t bytes) { return double(bytes) / (1024.0 * 1024.0); };
+		const auto stats = gfx::gpu_memory::get_stats();
+		APPLOG_INFO("GPU memory: {0:.2f}MB", to_mb(gfx::gpu_memory::get_total_bytes()));
+		for(std::size_t i = 0; i < stats.size(); ++i)
+		{
+			const auto& category = stats[i];
+			APPLOG_INFO("{0}: {1:.2f}MB in {2} resources, peak {3:.2f}MB, {4} created",
+						gfx::get_memory_category_name(gfx::memory_category(i)), to_mb(category.bytes),
+						category.count, to_mb(category.peak_bytes), category.created);
+		}
+
+		auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+		ecs.each<camera_component>([&to_mb](runtime::entity e, camera_component& camera_comp) {
+			APPLOG_INFO("camera {0}: {1:.2f}MB", e.to_string(),
+						to_mb(camera_comp.get_render_view().get_memory_size()));
+		});
+		ecs.each<reflection_probe_component>([&to_mb](runtime::entity e, reflection_probe_component& probe) {
+			std::uint64_t bytes = 0;
+			for(std::size_t i = 0; i < 6; ++i)
+			{
+				bytes += probe.get_render_view(i).get_memory_size();
+			}
+			APPLOG_INFO("probe {0}: {1:.2f}MB", e.to_string(), to_mb(bytes));
+		});
+	};
+	console_log_->register_command("gpu_memory", "Logs the gpu memory per category, camera and probe.", {},
+								   {}, log_gpu_memory);
+
+	std::function<void()> log_heap_memory = []() {
+		if(!core::memory_tracker::is_enabled())
+		{
+			APPLOG_INFO("The build does not track the allocations, enable ETH_MEMORY_TRACKING.");
+			return;
+		}
+		const auto to_mb = [](std::uint64_t bytes) { return double(bytes) / (1024.0 * 1024.0); };
+		const auto stats = core::memory_tracker::get_stats();
+		APPLOG_INFO("Heap: {0} allocations, {1:.2f}MB in the last frame, {2:.0f} on average, {3} spikes",
+					stats.frame_allocations, to_mb(stats.frame_bytes), stats.average_allocations,
+					stats.spikes);
+		for(std::size_t i = 0; i < stats.tags.size(); ++i)
+		{
+			const auto& tag = stats.tags[i];
+			APPLOG_INFO("{0}: {1:.2f}MB in {2} allocations, peak {3:.2f}MB, {4} allocations in the frame",
+						core::get_memory_tag_name(core::memory_tag(i)), to_mb(tag.live_bytes),
+						tag.live_allocations, to_mb(tag.peak_bytes), tag.frame_allocations);
+		}
+	};
+	console_log_->register_command("heap_memory", "Logs the heap memory and the allocations per tag.", {}, {},
+								   log_heap_memory);
+
+	std::function<void()> profile_start = []() { profiling::set_enabled(true); };
+	console_log_->register_command("profile_start", "Starts recording the cpu profiling zones.", {}, {},
+								   profile_start);
+
+	std::function<void(std::string)> profile_write = [](const std::string& file) {
+		const auto path = fs::resolve_protocol(file);
+		std::ofstream stream(path.string(), std::ios::out | std::ios::trunc);
+		profiling::write_chrome_trace(stream);
+		profiling::set_enabled(false);
+		APPLOG_INFO("Wrote the profile to {0}, open it in chrome://tracing.", path.string());
+	};
+	console_log_->register_command("profile_write", "Stops recording the cpu zones and writes them.",
+								   {"file"}, {"app:/profile.json"}, profile_write);
+
+	std::function<void()> log_frame_times = [this]() {
+		using ms_t = std::chrono::duration<double, std::milli>;
+		const auto& sim = core::get_subsystem<core::simulation>();
+		const auto stats = sim.get_frame_time_stats();
+		APPLOG_INFO("Frame times over {0} frames: p50 {1:.2f}ms, p95 {2:.2f}ms, p99 {3:.2f}ms, max {4:.2f}ms",
+					stats.frames, ms_t(stats.p50).count(), ms_t(stats.p95).count(), ms_t(stats.p99).count(),
+					ms_t(stats.max).count());
+		const auto pacing = sim.get_pacing_stats();
+		APPLOG_INFO("Pacing error over {0} frames: mean {1:.2f}ms, p99 {2:.2f}ms, max {3:.2f}ms",
+					pacing.frames, ms_t(pacing.mean_error).count(), ms_t(pacing.p99_error).count(),
+					ms_t(pacing.max_error).count());
+		APPLOG_INFO("Hitches: {0}", sim.get_hitch_count());
+		APPLOG_INFO("Input latency of the last frame: {0:.2f}ms",
+					ms_t(platform_events_.get_latency()).count());
+	};
+	console_log_->register_command("frame_times", "Logs the frame time percentiles and the pacing error.", {},
+								   {}, log_frame_times);
+
+	std::function<void(std::string)> write_hitches = [](const std::string& dir) {
+		using ms_t = std::chrono::duration<double, std::milli>;
+		auto& sim = core::get_subsystem<core::simulation>();
+		const auto path = fs::resolve_protocol(dir);
+		fs::error_code err;
+		fs::create_directories(path, err);
+		for(const auto& hitch : sim.get_hitches())
+		{
+			APPLOG_INFO("Hitch at frame {0}: {1:.2f}ms", hitch.frame, ms_t(hitch.duration).count());
+			if(!hitch.trace.empty())
+			{
+				const auto file = path / ("hitch_" + std::to_string(hitch.frame) + ".json");
+				std::ofstream stream(file.string(), std::ios::out | std::ios::trunc);
+				stream << hitch.trace;
+			}
+		}
+		APPLOG_INFO("Wrote the profiles of the hitches to {0}", path.string());
+		sim.clear_hitches();
+	};
+	console_log_->register_command("hitches", "Logs the last hitches and writes their profiles.", {"dir"},
+								   {"app:/hitches"}, write_hitches);
+
+	std::function<void(std::string)> gpu_capture = [this](const std::string& label) {
+		if(!gpu_capture_.is_loaded())
+		{
+			APPLOG_WARNING("RenderDoc is not loaded, run with --gpu_capture or from RenderDoc.");
+		}
+		else if(!gpu_capture_.capture(label))
+		{
+			APPLOG_WARNING("A gpu capture is still being taken.");
+		}
+	};
+	console_log_->register_command("capture", "Takes a RenderDoc capture of the next frame.", {"label"},
+								   {"console"}, gpu_capture);
+
+	std::function<void()> build_texture_arrays = []() {
+		if(!core::has_subsystems<texture_arrays>())
+		{
+			APPLOG_WARNING("The texture arrays are not sampled, run with --texture_arrays.");
+			return;
+		}
+		// the materials are loaded with their maps, off the owner thread
+		auto& ts = core::get_subsystem<core::task_system>();
+		auto task = ts.push_on_worker_thread_with_priority(core::task_priority::background, [&ts]() {
+			if(asset_compiler::build_texture_arrays())
+			{
+				auto reload = ts.push_on_owner_thread([]() { core::get_subsystem<texture_arrays>().load(); });
+			}
+		});
+	};
+	console_log_->register_command("texture_arrays", "Packs the material maps into texture arrays.", {}, {},
+								   build_texture_arrays);
 }
 
 void app::stop()
@@ -505,6 +855,7 @@ void app::draw_docks(delta_t dt)
 	auto& docking = core::get_subsystem<docking_system>();
 	auto& renderer = core::get_subsystem<runtime::renderer>();
 	const auto& windows = renderer.get_windows();
+	bool is_editing = false;
 
 	for(std::size_t i = 0; i < windows.size(); ++i)
 	{
@@ -529,10 +880,30 @@ void app::draw_docks(delta_t dt)
 
 		handle_drag_and_drop();
 
+		is_editing |= gui::IsAnyItemActive() || imguizmo::is_using();
+
 		gui::PopFont();
 		gui.draw_end();
 		gui.pop_context();
 	}
+
+	// an edit is over once nothing is held in any window, the next one is
+	// undone apart
+	auto& es = core::get_subsystem<editing_system>();
+	if(!is_editing)
+	{
+		es.undo.seal();
+	}
+
+	// the editor slows down once nothing was input for a while and nothing
+	// changes on its own
+	auto& sim = core::get_subsystem<core::simulation>();
+	auto& loader = core::get_subsystem<scene_loader>();
+	auto& am = core::get_subsystem<runtime::asset_manager>();
+	auto& pm = core::get_subsystem<project_manager>();
+	const bool idle = !is_editing && !es.is_playing() && !loader.is_loading() && !pm.is_reimporting() &&
+					  am.get_queued_requests() == 0 && gui.get_time_since_event() >= idle_delay_;
+	sim.set_idle(idle);
 }
 
 void app::draw_header(render_window& window)
@@ -567,29 +938,71 @@ void app::draw_footer(render_window&, imguidock::dockspace& dockspace)
 
 	auto& ts = core::get_subsystem<core::task_system>();
 	const auto tasks_info = ts.get_info();
-	const auto items = console_log_->get_items();
+	// only the last message is shown, those before it are skipped
+	const auto sequence = console_log_->get_sequence();
+	const auto from = sequence > footer_read_ ? std::max(footer_read_, sequence - 1) : footer_read_;
+	footer_read_ = console_log_->read(from, [this](std::uint64_t read, logging::level::level_enum level,
+												   const char* text, std::size_t size) {
+		footer_text_.assign(text, size);
+		footer_level_ = level;
+		footer_sequence_ = read + 1;
+	});
+	const bool has_footer = footer_sequence_ > console_log_->get_cleared_sequence();
 
 	const auto total_width = gui::GetContentRegionAvailWidth();
 	gui::BeginColumns("footer", 2, ImGuiColumnsFlags_NoBorder | ImGuiColumnsFlags_NoResize);
 	gui::SetColumnWidth(0, total_width * 0.8f);
 
-	if(items.size() > 0)
+	if(has_footer)
 	{
-		const auto& last_item = items.back();
-		const auto& colorization = console_log_->get_level_colorization(last_item.second);
+		const auto& colorization = console_log_->get_level_colorization(footer_level_);
 		ImVec4 col = {colorization[0], colorization[1], colorization[2], colorization[3]};
 
 		gui::SetCursorPosY(ImGui::GetCursorPosY());
 		gui::PushStyleColor(ImGuiCol_Text, col);
 		gui::AlignTextToFramePadding();
-		if(gui::Selectable(last_item.first.c_str(), false, 0, ImVec2(0, gui::GetTextLineHeight())))
+		if(gui::Selectable(footer_text_.c_str(), false, 0, ImVec2(0, gui::GetTextLineHeight())))
 		{
 			dockspace.activate_dock(console_dock_name_);
 		}
 		gui::PopStyleColor();
 	}
 	gui::NextColumn();
-	if(tasks_info.pending_tasks > 0)
+	auto& loader = core::get_subsystem<scene_loader>();
+	auto& pm = core::get_subsystem<project_manager>();
+	if(loader.is_loading())
+	{
+		const bool creating = loader.get_stage() == scene_loader::stage::entities;
+		const char* label = creating ? nullptr : "Loading the scene";
+		gui::AlignTextToFramePadding();
+		const ImVec2 bar_size(gui::GetContentRegionAvailWidth() * 0.7f, 0.0f);
+		gui::ProgressBar(loader.get_progress(), bar_size, label);
+		if(gui::IsItemHovered())
+		{
+			gui::SetTooltip("%s", loader.get_key().c_str());
+		}
+		gui::SameLine();
+		if(gui::SmallButton("CANCEL"))
+		{
+			loader.cancel();
+		}
+	}
+	else if(pm.is_reimporting())
+	{
+		gui::AlignTextToFramePadding();
+		const ImVec2 bar_size(gui::GetContentRegionAvailWidth() * 0.7f, 0.0f);
+		gui::ProgressBar(pm.get_reimport_progress(), bar_size);
+		if(gui::IsItemHovered())
+		{
+			gui::SetTooltip("Reimporting the assets");
+		}
+		gui::SameLine();
+		if(gui::SmallButton("CANCEL"))
+		{
+			pm.cancel_reimport();
+		}
+	}
+	else if(tasks_info.pending_tasks > 0)
 	{
 		gui::PushFont("icons");
 		gui::AlignTextToFramePadding();
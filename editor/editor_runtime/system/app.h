@@ -1,7 +1,10 @@
 #pragma once
 
+#include <core/logging/logging.h>
 #include <runtime/system/app.h>
 
+#include <chrono>
+#include <cstdint>
 #include <string>
 
 namespace imguidock
@@ -39,7 +42,15 @@ private:
 	bool show_start_page_ = true;
 	///
 	std::shared_ptr<console_log> console_log_;
+	/// the last message of the log, shown in the footer
+	std::string footer_text_;
+	logging::level::level_enum footer_level_ = logging::level::info;
+	/// the sequences of the next message to read and of the footer message
+	std::uint64_t footer_read_ = 0;
+	std::uint64_t footer_sequence_ = 0;
 	///
 	std::string console_dock_name_;
+	/// how long nothing is input before the editor is idle
+	std::chrono::milliseconds idle_delay_ = std::chrono::milliseconds(1000);
 };
 }
@@ -1,7 +1,11 @@
 #include "project_manager.h"
 #include "../assets/asset_compiler.h"
 #include "../assets/asset_extensions.h"
+#include "../assets/asset_index.h"
+#include "../assets/asset_search.h"
+#include "../assets/build_cache.h"
 #include "../editing/editing_system.h"
+#include "../editing/scene_loader.h"
 #include "../meta/system/project_manager.hpp"
 
 #include <core/filesystem/filesystem_watcher.h>
@@ -13,8 +17,12 @@
 
 #include <runtime/assets/asset_manager.h>
 #include <runtime/ecs/ecs.h>
+#include <runtime/rendering/texture_arrays.h>
 #include <runtime/system/events.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <fstream>
 
 namespace editor
@@ -41,8 +49,29 @@ static void unwatch(std::vector<uint64_t>& watchers)
 	watchers.clear();
 };
 
+// the asset a meta is of, as the compilers find it
+static fs::path get_source_path(const fs::path& absolute_meta_key)
+{
+	auto absolute_key = fs::convert_to_protocol(absolute_meta_key);
+	absolute_key = fs::resolve_protocol(fs::replace(absolute_key, ":/meta", ":/data"));
+	absolute_key.replace_extension();
+	return absolute_key;
+}
+
+// next to the stamps of the build cache
+static fs::path get_index_path(const std::string& protocol)
+{
+	return fs::resolve_protocol(protocol + ":/build/asset_index");
+}
+
+static fs::path get_search_path(const std::string& protocol)
+{
+	return fs::resolve_protocol(protocol + ":/build/asset_search");
+}
+
 template <typename T>
-static std::uint64_t watch_assets(const fs::path& dir, const std::string& wildcard, bool reload_async)
+static std::uint64_t watch_assets(const fs::path& dir, const std::string& wildcard, bool reload_async,
+								  fs::watcher::clock_t::duration debounce)
 {
 	auto& am = core::get_subsystem<runtime::asset_manager>();
 	auto& ts = core::get_subsystem<core::task_system>();
@@ -50,7 +79,9 @@ static std::uint64_t watch_assets(const fs::path& dir, const std::string& wildca
 	fs::path watch_dir = (dir / wildcard).make_preferred();
 
 	return fs::watcher::watch(
-		watch_dir, true, true, 500ms, [&am, &ts](const auto& entries, bool is_initial_list) {
+		watch_dir, true, true, 500ms, debounce, [&am, &ts](const auto& entries, bool is_initial_list) {
+			using namespace runtime;
+			std::vector<std::string> loads;
 			for(const auto& entry : entries)
 			{
 				auto p = fs::reduce_trailing_extensions(entry.path);
@@ -74,40 +105,73 @@ static std::uint64_t watch_assets(const fs::path& dir, const std::string& wildca
 					}
 					else
 					{
-						using namespace runtime;
-						load_flags flags = is_initial_list ? load_flags::standard : load_flags::reload;
-
 						// created or modified
-						auto task = ts.push_on_worker_thread([flags, key, &am]() { am.load<T>(key, flags); });
+						loads.emplace_back(std::move(key));
 					}
 				}
 			}
+
+			if(loads.empty())
+			{
+				return;
+			}
+
+			// the loads of a batch go as one task, the initial ones behind the
+			// frame work and the reloads of the assets in use first. A reload
+			// reloads what was loaded from the asset, not everything.
+			auto priority = is_initial_list ? core::task_priority::background : core::task_priority::frame;
+			auto load_all = [is_initial_list, loads, &am]() mutable {
+				std::stable_partition(std::begin(loads), std::end(loads), [&am](const auto& key) {
+					return am.find_asset_entry<T>(key).valid();
+				});
+				std::size_t dependents = 0;
+				for(const auto& key : loads)
+				{
+					if(is_initial_list)
+					{
+						am.load<T>(key, load_flags::standard);
+					}
+					else
+					{
+						dependents += am.reload<T>(key);
+					}
+				}
+				if(dependents > 0)
+				{
+					APPLOG_INFO("Reloaded {0} assets made of the {1} changed.", dependents, loads.size());
+				}
+			};
+			auto task = ts.push_on_worker_thread_with_priority(priority, std::move(load_all));
 		});
 }
 
 template <typename T>
 static void add_to_syncer(std::vector<uint64_t>& watchers, fs::syncer& syncer, const fs::path& dir,
 						  const fs::syncer::on_entry_removed_t& on_removed,
-						  const fs::syncer::on_entry_renamed_t& on_renamed)
+						  const fs::syncer::on_entry_renamed_t& on_renamed,
+						  fs::watcher::clock_t::duration debounce, const asset_index_ptr& index)
 {
 	auto& ts = core::get_subsystem<core::task_system>();
-	auto on_modified = [&ts](const auto& ref_path, const auto& synced_paths, bool is_initial_listing) {
-		auto task = ts.push_on_worker_thread(
-			[ref_path, synced_paths = remove_meta_tag(synced_paths), is_initial_listing]() {
-				fs::path output = synced_paths.front();
-				fs::error_code err;
-				if(is_initial_listing && fs::exists(output, err))
-				{
-					return;
-				}
+	// the build cache skips what is up to date, the initial listing included.
+	// What the index vouches for is not even looked at.
+	auto on_modified = [&ts, index](const auto& ref_path, const auto& synced_paths, bool is_initial_listing) {
+		std::vector<fs::path> inputs = {get_source_path(ref_path), ref_path};
+		fs::path output = remove_meta_tag(synced_paths).front();
+		if(is_initial_listing && index->is_up_to_date(ref_path, inputs, {output}))
+		{
+			return;
+		}
+		auto task = ts.push_on_worker_thread_with_priority(
+			core::task_priority::background, [ref_path, inputs, output, index]() {
 				asset_compiler::compile<T>(ref_path, output);
+				index->record(ref_path, inputs, {output});
 			});
 	};
 
 	for(const auto& type : ex::get_suported_formats<T>())
 	{
 		syncer.set_mapping(type + ".meta", {".asset"}, on_modified, on_modified, on_removed, on_renamed);
-		const auto watch_id = watch_assets<T>(dir, "*" + type, true);
+		const auto watch_id = watch_assets<T>(dir, "*" + type, true, debounce);
 		watchers.push_back(watch_id);
 	}
 }
@@ -115,33 +179,34 @@ static void add_to_syncer(std::vector<uint64_t>& watchers, fs::syncer& syncer, c
 template <>
 void add_to_syncer<gfx::shader>(std::vector<uint64_t>& watchers, fs::syncer& syncer, const fs::path& dir,
 								const fs::syncer::on_entry_removed_t& on_removed,
-								const fs::syncer::on_entry_renamed_t& on_renamed)
+								const fs::syncer::on_entry_renamed_t& on_renamed,
+								fs::watcher::clock_t::duration debounce, const asset_index_ptr& index)
 {
 	auto& ts = core::get_subsystem<core::task_system>();
 
-	auto on_modified = [&ts](const auto& ref_path, const auto& synced_paths, bool is_initial_listing) {
-		auto task = ts.push_on_worker_thread(
-			[ref_path, synced_paths = remove_meta_tag(synced_paths), is_initial_listing]() {
-				const auto& renderer_extension = gfx::get_renderer_filename_extension();
-				auto it = std::find_if(std::begin(synced_paths), std::end(synced_paths),
-									   [&renderer_extension](const auto& key) {
-										   return key.stem().extension() == renderer_extension;
-									   });
-
-				if(it == std::end(synced_paths))
-				{
-					return;
-				}
+	auto on_modified = [&ts, index](const auto& ref_path, const auto& synced_paths, bool is_initial_listing) {
+		const auto outputs = remove_meta_tag(synced_paths);
+		const auto& renderer_extension = gfx::get_renderer_filename_extension();
+		auto it = std::find_if(std::begin(outputs), std::end(outputs),
+							   [&renderer_extension](const auto& key) {
+								   return key.stem().extension() == renderer_extension;
+							   });
 
-				fs::path output = *it;
-
-				fs::error_code err;
-				if(is_initial_listing && fs::exists(output, err))
-				{
-					return;
-				}
+		if(it == std::end(outputs))
+		{
+			return;
+		}
 
+		std::vector<fs::path> inputs = {get_source_path(ref_path), ref_path};
+		fs::path output = *it;
+		if(is_initial_listing && index->is_up_to_date(ref_path, inputs, {output}))
+		{
+			return;
+		}
+		auto task = ts.push_on_worker_thread_with_priority(
+			core::task_priority::background, [ref_path, inputs, output, index]() {
 				asset_compiler::compile<gfx::shader>(ref_path, output);
+				index->record(ref_path, inputs, {output});
 			});
 	};
 
@@ -150,22 +215,272 @@ void add_to_syncer<gfx::shader>(std::vector<uint64_t>& watchers, fs::syncer& syn
 		syncer.set_mapping(type + ".meta", {".dx11.asset", ".dx12.asset", ".gl.asset"}, on_modified,
 						   on_modified, on_removed, on_renamed);
 
-		const auto watch_id = watch_assets<gfx::shader>(dir, "*" + type, true);
+		const auto watch_id = watch_assets<gfx::shader>(dir, "*" + type, true, debounce);
 		watchers.push_back(watch_id);
 	}
 }
 
+namespace
+{
+// what the reimport compiles, in the stage after that of what it is made of
+struct reimport_type
+{
+	const char* name;
+	void (*compile)(const fs::path&, const fs::path&);
+	const std::vector<std::string>& formats;
+	std::size_t stage;
+	/// compiled for the renderer in use only
+	bool per_renderer;
+};
+
+const std::vector<reimport_type>& get_reimport_types()
+{
+	static const std::vector<reimport_type> types = {
+		{"texture", &asset_compiler::compile<gfx::texture>, ex::get_suported_formats<gfx::texture>(), 0,
+		 false},
+		{"shader", &asset_compiler::compile<gfx::shader>, ex::get_suported_formats<gfx::shader>(), 0, true},
+		{"sound", &asset_compiler::compile<audio::sound>, ex::get_suported_formats<audio::sound>(), 0,
+		 false},
+		{"mesh", &asset_compiler::compile<mesh>, ex::get_suported_formats<mesh>(), 0, false},
+		{"animation", &asset_compiler::compile<runtime::animation>,
+		 ex::get_suported_formats<runtime::animation>(), 0, false},
+		{"material", &asset_compiler::compile<material>, ex::get_suported_formats<material>(), 1, false},
+		{"prefab", &asset_compiler::compile<prefab>, ex::get_suported_formats<prefab>(), 2, false},
+		{"scene", &asset_compiler::compile<scene>, ex::get_suported_formats<scene>(), 2, false},
+	};
+	return types;
+}
+}
+
+struct project_manager::reimport
+{
+	using clock = std::chrono::steady_clock;
+
+	struct job
+	{
+		fs::path meta;
+		fs::path output;
+		std::size_t type = 0;
+		asset_index_ptr index;
+	};
+
+	struct type_times
+	{
+		std::size_t count = 0;
+		clock::duration total{};
+		clock::duration longest{};
+		fs::path slowest;
+	};
+
+	std::array<std::vector<job>, 3> stages;
+	std::size_t stage = 0;
+	/// the compilations of the stage
+	std::vector<core::task_future<void>> tasks;
+	std::size_t total = 0;
+	std::atomic<std::size_t> done{0};
+	std::mutex mutex;
+	std::vector<type_times> times;
+	clock::time_point start;
+	std::atomic<bool> cancelled{false};
+};
+
+void project_manager::reimport_assets(bool force)
+{
+	if(reimport_)
+	{
+		return;
+	}
+
+	auto state = std::make_shared<reimport>();
+	const auto& types = get_reimport_types();
+	state->times.resize(types.size());
+
+	const auto& renderer_extension = gfx::get_renderer_filename_extension();
+	const auto add_protocol = [&](const std::string& protocol, const asset_index_ptr& index) {
+		const auto meta_dir = fs::resolve_protocol(protocol + ":/meta");
+		const auto cache_dir = fs::resolve_protocol(protocol + ":/cache");
+		fs::error_code err;
+		if(meta_dir.empty() || !fs::exists(meta_dir, err))
+		{
+			return;
+		}
+
+		for(const auto& entry : fs::recursive_directory_iterator(meta_dir, err))
+		{
+			const auto& meta = entry.path();
+			if(!fs::is_regular_file(meta, err) || meta.extension() != ".meta")
+			{
+				continue;
+			}
+			const auto format = meta.stem().extension().string();
+			auto it = std::find_if(std::begin(types), std::end(types), [&format](const reimport_type& t) {
+				return std::find(std::begin(t.formats), std::end(t.formats), format) != std::end(t.formats);
+			});
+			if(it == std::end(types) || !fs::exists(get_source_path(meta), err))
+			{
+				continue;
+			}
+
+			// where the cache syncer puts it
+			auto output = (cache_dir / fs::relative(meta, meta_dir, err)).replace_extension();
+			output += it->per_renderer ? renderer_extension + ".asset" : std::string(".asset");
+			if(force)
+			{
+				asset_compiler::build_cache::invalidate(output);
+			}
+
+			reimport::job job;
+			job.meta = meta;
+			job.output = std::move(output);
+			job.type = std::size_t(std::distance(std::begin(types), it));
+			job.index = index;
+			state->stages[it->stage].emplace_back(std::move(job));
+			++state->total;
+		}
+	};
+	add_protocol("engine", engine_index_);
+	add_protocol("editor", editor_index_);
+	if(!fs::resolve_protocol("app:/").empty())
+	{
+		add_protocol("app", app_index_);
+	}
+
+	APPLOG_INFO("Reimporting {0} assets{1}.", state->total, force ? ", forced" : "");
+	state->start = reimport::clock::now();
+	reimport_ = std::move(state);
+	start_reimport_stage();
+}
+
+void project_manager::cancel_reimport()
+{
+	if(!reimport_)
+	{
+		return;
+	}
+	// the compilations started finish, the others return at once
+	for(auto& stage : reimport_->stages)
+	{
+		stage.clear();
+	}
+	reimport_->cancelled = true;
+}
+
+float project_manager::get_reimport_progress() const
+{
+	if(!reimport_ || reimport_->total == 0)
+	{
+		return 0.0f;
+	}
+	return float(reimport_->done.load()) / float(reimport_->total);
+}
+
+void project_manager::frame_update(delta_t /*dt*/)
+{
+	if(!reimport_)
+	{
+		return;
+	}
+
+	const auto& tasks = reimport_->tasks;
+	const bool stage_done =
+		std::all_of(std::begin(tasks), std::end(tasks), [](const auto& task) { return task.is_ready(); });
+	if(!stage_done)
+	{
+		return;
+	}
+
+	// what the next stage is made of is compiled now
+	++reimport_->stage;
+	start_reimport_stage();
+}
+
+void project_manager::start_reimport_stage()
+{
+	auto& state = *reimport_;
+	state.tasks.clear();
+	while(state.stage < state.stages.size() && state.stages[state.stage].empty())
+	{
+		++state.stage;
+	}
+	if(state.stage >= state.stages.size())
+	{
+		finish_reimport();
+		return;
+	}
+
+	// the external compilers are bounded by the process slots of the compiler
+	auto& ts = core::get_subsystem<core::task_system>();
+	auto shared_state = reimport_;
+	for(const auto& job : state.stages[state.stage])
+	{
+		state.tasks.emplace_back(ts.push_on_worker_thread_with_priority(
+			core::task_priority::background, [shared_state, job]() {
+				if(shared_state->cancelled)
+				{
+					return;
+				}
+				const auto begin = reimport::clock::now();
+				get_reimport_types()[job.type].compile(job.meta, job.output);
+				const auto elapsed = reimport::clock::now() - begin;
+				job.index->record(job.meta, {get_source_path(job.meta), job.meta}, {job.output});
+
+				std::lock_guard<std::mutex> lock(shared_state->mutex);
+				auto& times = shared_state->times[job.type];
+				++times.count;
+				times.total += elapsed;
+				if(elapsed > times.longest)
+				{
+					times.longest = elapsed;
+					times.slowest = job.meta;
+				}
+				++shared_state->done;
+			}));
+	}
+	state.stages[state.stage].clear();
+}
+
+void project_manager::finish_reimport()
+{
+	using ms_t = std::chrono::duration<double, std::milli>;
+	auto& state = *reimport_;
+	const auto elapsed = ms_t(reimport::clock::now() - state.start);
+	APPLOG_INFO("Reimported {0} of {1} assets in {2:.1f} ms{3}.", state.done.load(), state.total,
+				elapsed.count(), state.cancelled.load() ? ", cancelled" : "");
+
+	const auto& types = get_reimport_types();
+	for(std::size_t i = 0; i < types.size(); ++i)
+	{
+		const auto& times = state.times[i];
+		if(times.count == 0)
+		{
+			continue;
+		}
+		APPLOG_INFO("{0}: {1} in {2:.1f} ms, the slowest {3} in {4:.1f} ms", types[i].name, times.count,
+					ms_t(times.total).count(), fs::convert_to_protocol(times.slowest).generic_string(),
+					ms_t(times.longest).count());
+	}
+	reimport_.reset();
+}
+
 void project_manager::close_project()
 {
 	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
 	auto& am = core::get_subsystem<runtime::asset_manager>();
 	auto& es = core::get_subsystem<editing_system>();
+	core::get_subsystem<scene_loader>().cancel();
+	cancel_reimport();
 	es.close_project();
 	ecs.dispose();
 	am.clear("app:/data");
 	unwatch(app_watchers_);
 	app_meta_syncer_.unsync();
 	app_cache_syncer_.unsync();
+	close_search();
+	if(!fs::resolve_protocol("app:/").empty())
+	{
+		app_index_->save(get_index_path("app"));
+	}
+	app_index_->clear();
 	load_config();
 }
 
@@ -186,9 +501,25 @@ bool project_manager::open_project(const fs::path& project_path)
 
 	save_config();
 
+	app_index_->load(get_index_path("app"), asset_compiler::get_index_settings());
 	setup_meta_syncer(app_meta_syncer_, fs::resolve_protocol("app:/data"), fs::resolve_protocol("app:/meta"));
 	setup_cache_syncer(app_watchers_, app_cache_syncer_, fs::resolve_protocol("app:/meta"),
-					   fs::resolve_protocol("app:/cache"));
+					   fs::resolve_protocol("app:/cache"), app_index_);
+	if(core::has_subsystems<texture_arrays>())
+	{
+		// the arrays of the project in place of those of the last one
+		core::get_subsystem<texture_arrays>().load();
+	}
+
+	// searched from what the last session saved while the project is listed
+	auto& ts = core::get_subsystem<core::task_system>();
+	app_search_scan_ = ts.push_on_worker_thread_with_priority(
+		core::task_priority::background,
+		[search = app_search_, path = get_search_path("app"), dir = fs::resolve_protocol("app:/data"),
+		 debounce = get_watch_debounce()]() {
+			search->load(path);
+			search->watch(dir, debounce);
+		});
 
 	auto& es = core::get_subsystem<editing_system>();
 	es.load_editor_camera();
@@ -268,6 +599,7 @@ void project_manager::setup_meta_syncer(fs::syncer& syncer, const fs::path& data
 										const fs::path& meta_dir)
 {
 	setup_directory(syncer);
+	syncer.set_debounce(get_watch_debounce());
 
 	const auto on_file_removed = [](const auto& /*ref_path*/, const auto& synced_paths) {
 		for(const auto& synced_path : synced_paths)
@@ -290,9 +622,15 @@ void project_manager::setup_meta_syncer(fs::syncer& syncer, const fs::path& data
 		for(const auto& synced_path : synced_paths)
 		{
 			fs::error_code err;
-			if(is_initial_listing && fs::exists(synced_path, err))
+			if(fs::exists(synced_path, err))
 			{
-				return;
+				// the import settings in it are kept, it is touched for the
+				// asset to be compiled again
+				if(!is_initial_listing)
+				{
+					fs::last_write_time(synced_path, fs::now(), err);
+				}
+				continue;
 			}
 			std::ofstream output(synced_path.string(), std::ofstream::trunc);
 			output.write("metadata", 8);
@@ -314,9 +652,12 @@ void project_manager::setup_meta_syncer(fs::syncer& syncer, const fs::path& data
 }
 
 void project_manager::setup_cache_syncer(std::vector<uint64_t>& watchers, fs::syncer& syncer,
-										 const fs::path& meta_dir, const fs::path& cache_dir)
+										 const fs::path& meta_dir, const fs::path& cache_dir,
+										 const asset_index_ptr& index)
 {
 	setup_directory(syncer);
+	const auto debounce = get_watch_debounce();
+	syncer.set_debounce(debounce);
 
 	auto on_removed = [](const auto& /*ref_path*/, const auto& synced_paths) {
 		for(const auto& synced_path : synced_paths)
@@ -337,18 +678,40 @@ void project_manager::setup_cache_syncer(std::vector<uint64_t>& watchers, fs::sy
 		}
 	};
 
-	add_to_syncer<gfx::texture>(watchers, syncer, cache_dir, on_removed, on_renamed);
-	add_to_syncer<gfx::shader>(watchers, syncer, cache_dir, on_removed, on_renamed);
-	add_to_syncer<mesh>(watchers, syncer, cache_dir, on_removed, on_renamed);
-	add_to_syncer<audio::sound>(watchers, syncer, cache_dir, on_removed, on_renamed);
-	add_to_syncer<material>(watchers, syncer, cache_dir, on_removed, on_renamed);
-	add_to_syncer<runtime::animation>(watchers, syncer, cache_dir, on_removed, on_renamed);
-	add_to_syncer<prefab>(watchers, syncer, cache_dir, on_removed, on_renamed);
-	add_to_syncer<scene>(watchers, syncer, cache_dir, on_removed, on_renamed);
+	add_to_syncer<gfx::texture>(watchers, syncer, cache_dir, on_removed, on_renamed, debounce, index);
+	add_to_syncer<gfx::shader>(watchers, syncer, cache_dir, on_removed, on_renamed, debounce, index);
+	add_to_syncer<mesh>(watchers, syncer, cache_dir, on_removed, on_renamed, debounce, index);
+	add_to_syncer<audio::sound>(watchers, syncer, cache_dir, on_removed, on_renamed, debounce, index);
+	add_to_syncer<material>(watchers, syncer, cache_dir, on_removed, on_renamed, debounce, index);
+	add_to_syncer<runtime::animation>(watchers, syncer, cache_dir, on_removed, on_renamed, debounce, index);
+	add_to_syncer<prefab>(watchers, syncer, cache_dir, on_removed, on_renamed, debounce, index);
+	add_to_syncer<scene>(watchers, syncer, cache_dir, on_removed, on_renamed, debounce, index);
 
 	syncer.sync(meta_dir, cache_dir);
 }
 
+void project_manager::close_search()
+{
+	if(!app_search_scan_.valid())
+	{
+		return;
+	}
+
+	app_search_scan_.wait();
+	app_search_scan_ = {};
+	app_search_->unwatch();
+	if(!fs::resolve_protocol("app:/").empty())
+	{
+		app_search_->save(get_search_path("app"));
+	}
+	app_search_->clear();
+}
+
+std::chrono::steady_clock::duration project_manager::get_watch_debounce() const
+{
+	return std::chrono::milliseconds(options_.watch_debounce_ms);
+}
+
 void project_manager::save_config()
 {
 	auto& rp = options_.recent_project_paths;
@@ -369,23 +732,49 @@ void project_manager::save_config()
 }
 
 project_manager::project_manager()
+	: app_index_(std::make_shared<asset_compiler::asset_index>())
+	, app_search_(std::make_shared<asset_search>())
+	, editor_index_(std::make_shared<asset_compiler::asset_index>())
+	, engine_index_(std::make_shared<asset_compiler::asset_index>())
 {
+	runtime::on_frame_update.connect(this, &project_manager::frame_update);
 	load_config();
+	const auto index_settings = asset_compiler::get_index_settings();
+	editor_index_->load(get_index_path("editor"), index_settings);
+	engine_index_->load(get_index_path("engine"), index_settings);
+
+	// the editor directories have nothing to do with the engine ones, they are
+	// scanned on a worker meanwhile
+	auto& ts = core::get_subsystem<core::task_system>();
+	auto editor_scan = ts.push_or_execute_on_worker_thread([this]() {
+		setup_meta_syncer(editor_meta_syncer_, fs::resolve_protocol("editor:/data"),
+						  fs::resolve_protocol("editor:/meta"));
+		setup_cache_syncer(editor_watchers_, editor_cache_syncer_, fs::resolve_protocol("editor:/meta"),
+						   fs::resolve_protocol("editor:/cache"), editor_index_);
+	});
 	setup_meta_syncer(engine_meta_syncer_, fs::resolve_protocol("engine:/data"),
 					  fs::resolve_protocol("engine:/meta"));
 	setup_cache_syncer(engine_watchers_, engine_cache_syncer_, fs::resolve_protocol("engine:/meta"),
-					   fs::resolve_protocol("engine:/cache"));
-	setup_meta_syncer(editor_meta_syncer_, fs::resolve_protocol("editor:/data"),
-					  fs::resolve_protocol("editor:/meta"));
-	setup_cache_syncer(editor_watchers_, editor_cache_syncer_, fs::resolve_protocol("editor:/meta"),
-					   fs::resolve_protocol("editor:/cache"));
+					   fs::resolve_protocol("engine:/cache"), engine_index_);
+	editor_scan.wait();
 }
 
 project_manager::~project_manager()
 {
+	runtime::on_frame_update.disconnect(this, &project_manager::frame_update);
+	if(reimport_)
+	{
+		cancel_reimport();
+		for(const auto& task : reimport_->tasks)
+		{
+			task.wait();
+		}
+	}
+
 	save_config();
 
 	unwatch(app_watchers_);
+	close_search();
 
 	app_meta_syncer_.unsync();
 	app_cache_syncer_.unsync();
@@ -399,5 +788,12 @@ project_manager::~project_manager()
 
 	engine_meta_syncer_.unsync();
 	engine_cache_syncer_.unsync();
+
+	if(!fs::resolve_protocol("app:/").empty())
+	{
+		app_index_->save(get_index_path("app"));
+	}
+	editor_index_->save(get_index_path("editor"));
+	engine_index_->save(get_index_path("engine"));
 }
 } // namespace editor
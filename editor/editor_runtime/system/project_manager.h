@@ -1,12 +1,23 @@
 #pragma once
+#include <core/common/basetypes.hpp>
 #include <core/filesystem/filesystem_syncer.h>
 #include <core/math/math_includes.h>
+#include <core/tasks/task_system.h>
 
 #include <deque>
+#include <memory>
 #include <mutex>
 
+namespace asset_compiler
+{
+class asset_index;
+}
+
 namespace editor
 {
+class asset_search;
+using asset_index_ptr = std::shared_ptr<asset_compiler::asset_index>;
+
 class project_manager
 {
 public:
@@ -14,6 +25,9 @@ public:
 	{
 		///
 		std::deque<std::string> recent_project_paths;
+		/// how long a watched file must not change before it is compiled or
+		/// reloaded, so that one saved in parts is handled once
+		std::uint32_t watch_debounce_ms = 300;
 	};
 
 	project_manager();
@@ -107,11 +121,63 @@ public:
 		return options_;
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : reimport_assets ()
+	/// <summary>
+	/// Compiles every asset of the engine, the editor and the project again on
+	/// the workers, those the others are made of first: the textures, shaders,
+	/// sounds, meshes and animations, then the materials, then the prefabs and
+	/// the scenes. What is up to date is still skipped unless forced. The
+	/// times per asset type are logged at the end.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void reimport_assets(bool force);
+
+	//-----------------------------------------------------------------------------
+	//  Name : cancel_reimport ()
+	/// <summary>
+	/// Drops the compilations of the reimport not started yet.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void cancel_reimport();
+
+	bool is_reimporting() const
+	{
+		return reimport_ != nullptr;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_reimport_progress ()
+	/// <summary>
+	/// The part of the assets of the reimport compiled so far.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	float get_reimport_progress() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_asset_search ()
+	/// <summary>
+	/// The search over the assets of the project, empty without one open.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const std::shared_ptr<asset_search>& get_asset_search() const
+	{
+		return app_search_;
+	}
+
 private:
+	struct reimport;
+
+	void frame_update(delta_t dt);
+	void start_reimport_stage();
+	void finish_reimport();
+	/// waits for the listing of the search and saves it
+	void close_search();
+	std::chrono::steady_clock::duration get_watch_debounce() const;
 	void setup_directory(fs::syncer& syncer);
 	void setup_meta_syncer(fs::syncer& syncer, const fs::path& data_dir, const fs::path& meta_dir);
 	void setup_cache_syncer(std::vector<uint64_t>& watchers, fs::syncer& syncer, const fs::path& meta_dir,
-							const fs::path& cache_dir);
+							const fs::path& cache_dir, const asset_index_ptr& index);
 	/// Project options
 	options options_;
 	/// Current project name
@@ -120,13 +186,23 @@ private:
 	fs::syncer app_meta_syncer_;
 	fs::syncer app_cache_syncer_;
 	std::vector<std::uint64_t> app_watchers_;
+	/// what the sessions compiled, so that opening the next one is quick
+	asset_index_ptr app_index_;
+	/// the names of the assets, listed and watched on a worker
+	std::shared_ptr<asset_search> app_search_;
+	core::task_future<void> app_search_scan_;
 
 	fs::syncer editor_meta_syncer_;
 	fs::syncer editor_cache_syncer_;
 	std::vector<std::uint64_t> editor_watchers_;
+	asset_index_ptr editor_index_;
 
 	fs::syncer engine_meta_syncer_;
 	fs::syncer engine_cache_syncer_;
 	std::vector<std::uint64_t> engine_watchers_;
+	asset_index_ptr engine_index_;
+
+	/// shared with its compilations, which may outlive a cancel
+	std::shared_ptr<reimport> reimport_;
 };
 } // namespace editor
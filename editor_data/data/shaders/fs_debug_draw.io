@@ -0,0 +1 @@
+vec4 v_color0 : COLOR0 = vec4(1.0, 1.0, 1.0, 1.0);
\ No newline at end of file
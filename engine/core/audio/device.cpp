@@ -36,6 +36,30 @@ void device::disable()
     }
 }
 
+void device::suspend_updates()
+{
+    if(impl_)
+    {
+        impl_->suspend_updates();
+    }
+}
+
+void device::process_updates()
+{
+    if(impl_)
+    {
+        impl_->process_updates();
+    }
+}
+
+void device::submit()
+{
+    if(impl_)
+    {
+        impl_->submit();
+    }
+}
+
 bool device::is_valid() const
 {
     return impl_ && impl_->is_valid();
@@ -41,6 +41,32 @@ public:
     //-----------------------------------------------------------------------------
     void disable();
 
+    //-----------------------------------------------------------------------------
+    //  Name : suspend_updates ()
+    /// <summary>
+    /// Defers the changes to the sources and the listener until
+    /// process_updates, so that they are applied at once.
+    /// </summary>
+    //-----------------------------------------------------------------------------
+    void suspend_updates();
+
+    //-----------------------------------------------------------------------------
+    //  Name : process_updates ()
+    /// <summary>
+    /// Applies the changes deferred since suspend_updates.
+    /// </summary>
+    //-----------------------------------------------------------------------------
+    void process_updates();
+
+    //-----------------------------------------------------------------------------
+    //  Name : submit ()
+    /// <summary>
+    /// Wakes the audio thread to apply the changes queued by the deferred
+    /// sources now rather than on its next tick.
+    /// </summary>
+    //-----------------------------------------------------------------------------
+    void submit();
+
     //-----------------------------------------------------------------------------
     //  Name : is_valid ()
     /// <summary>
@@ -0,0 +1,258 @@
+#include "audio_thread.h"
+#include "check.h"
+#include "sound_stream.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace audio
+{
+namespace priv
+{
+
+namespace
+{
+/// how often the played buffers are refilled, a chunk lasts far longer
+constexpr auto tick_interval = std::chrono::milliseconds(20);
+
+/// a power of two, enough for the changes of several frames of many voices
+constexpr std::size_t queue_capacity = 4096;
+
+void apply(const source_command& command)
+{
+    const auto& v = command.values;
+    switch(command.type)
+    {
+        case source_command::kind::volume:
+            al_check(alSourcef(command.source, AL_GAIN, v[0]));
+            break;
+        case source_command::kind::pitch:
+            al_check(alSourcef(command.source, AL_PITCH, v[0]));
+            break;
+        case source_command::kind::position:
+            al_check(alSourcefv(command.source, AL_POSITION, v));
+            break;
+        case source_command::kind::velocity:
+            al_check(alSourcefv(command.source, AL_VELOCITY, v));
+            break;
+        case source_command::kind::orientation:
+            al_check(alSourcefv(command.source, AL_ORIENTATION, v));
+            break;
+        case source_command::kind::rolloff:
+            al_check(alSourcef(command.source, AL_ROLLOFF_FACTOR, v[0]));
+            break;
+        case source_command::kind::distance:
+            al_check(alSourcef(command.source, AL_REFERENCE_DISTANCE, v[0]));
+            al_check(alSourcef(command.source, AL_MAX_DISTANCE, v[1]));
+            break;
+    }
+}
+
+struct state
+{
+    ~state()
+    {
+        stop();
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        cv.notify_all();
+
+        if(thread.joinable())
+        {
+            thread.join();
+        }
+    }
+
+    bool push(const source_command& command)
+    {
+        const auto t = tail.load(std::memory_order_relaxed);
+        if(t - head.load(std::memory_order_acquire) == queue_capacity)
+        {
+            return false;
+        }
+        queue[t & (queue_capacity - 1)] = command;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    void apply_queued()
+    {
+        auto h = head.load(std::memory_order_relaxed);
+        const auto t = tail.load(std::memory_order_acquire);
+        if(h == t)
+        {
+            return;
+        }
+
+        const bool deferred = defer_updates != nullptr && process_updates != nullptr;
+        if(deferred)
+        {
+            defer_updates();
+        }
+        for(; h != t; ++h)
+        {
+            apply(queue[h & (queue_capacity - 1)]);
+            head.store(h + 1, std::memory_order_release);
+        }
+        if(deferred)
+        {
+            process_updates();
+        }
+    }
+
+    void run()
+    {
+        while(true)
+        {
+            apply_queued();
+
+            {
+                std::vector<std::shared_ptr<sound_stream>> current;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    current = streams;
+                }
+
+                for(auto& stream : current)
+                {
+                    stream->update();
+                }
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait_for(lock, tick_interval, [this]() { return !running || woken; });
+            woken = false;
+            if(!running)
+            {
+                return;
+            }
+        }
+    }
+
+    std::array<source_command, queue_capacity> queue;
+    /// the next command to apply, written by the thread
+    std::atomic<std::size_t> head = {0};
+    /// the next free slot, written by the poster
+    std::atomic<std::size_t> tail = {0};
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::shared_ptr<sound_stream>> streams;
+    bool woken = false;
+    std::atomic<bool> running = {false};
+    std::thread thread;
+
+    LPALDEFERUPDATESSOFT defer_updates = nullptr;
+    LPALPROCESSUPDATESSOFT process_updates = nullptr;
+};
+
+state& get_state()
+{
+    static state s;
+    return s;
+}
+}
+
+void audio_thread::start(LPALDEFERUPDATESSOFT defer_updates, LPALPROCESSUPDATESSOFT process_updates)
+{
+    auto& s = get_state();
+    if(s.thread.joinable())
+    {
+        return;
+    }
+
+    s.defer_updates = defer_updates;
+    s.process_updates = process_updates;
+    s.running = true;
+    s.thread = std::thread([&s]() { s.run(); });
+}
+
+void audio_thread::stop()
+{
+    auto& s = get_state();
+    s.stop();
+    s.apply_queued();
+}
+
+void audio_thread::add_stream(std::shared_ptr<sound_stream> stream)
+{
+    auto& s = get_state();
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.streams.push_back(std::move(stream));
+    }
+    submit();
+}
+
+void audio_thread::remove_stream(const sound_stream* stream)
+{
+    auto& s = get_state();
+
+    // released after the lock, the last owner deletes the stream
+    std::shared_ptr<sound_stream> removed;
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+    auto it = std::find_if(std::begin(s.streams), std::end(s.streams),
+                           [stream](const auto& item) { return item.get() == stream; });
+    if(it != std::end(s.streams))
+    {
+        removed = std::move(*it);
+        s.streams.erase(it);
+    }
+}
+
+void audio_thread::post(const source_command& command)
+{
+    auto& s = get_state();
+    if(!s.running)
+    {
+        apply(command);
+        return;
+    }
+
+    // full, the thread has to catch up to keep the order
+    while(!s.push(command))
+    {
+        submit();
+        std::this_thread::yield();
+    }
+}
+
+void audio_thread::submit()
+{
+    auto& s = get_state();
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.woken = true;
+    }
+    s.cv.notify_one();
+}
+
+void audio_thread::drain()
+{
+    auto& s = get_state();
+    if(!s.running)
+    {
+        return;
+    }
+
+    submit();
+    while(s.head.load(std::memory_order_acquire) != s.tail.load(std::memory_order_relaxed))
+    {
+        std::this_thread::yield();
+    }
+}
+}
+}
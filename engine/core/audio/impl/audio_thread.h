@@ -0,0 +1,89 @@
+#pragma once
+
+#include <AL/al.h>
+#include <AL/alext.h>
+#include <cstdint>
+#include <memory>
+
+namespace audio
+{
+namespace priv
+{
+class sound_stream;
+
+struct source_command
+{
+    enum class kind : std::uint8_t
+    {
+        volume,
+        pitch,
+        position,
+        velocity,
+        orientation,
+        rolloff,
+        distance
+    };
+
+    ALuint source = 0;
+    kind type = kind::volume;
+    float values[6] = {};
+};
+
+/*
+ * audio_thread; the thread of the device, refilling the streams and
+ * applying the queued changes of the sources on its own tick, so that
+ * neither depends on the frame rate.
+ *
+ *      The changes are queued without a lock by one thread at a time and
+ *      applied in order, at once when the deferred updates are supported.
+ */
+class audio_thread
+{
+public:
+    //-----------------------------------------------------------------------------
+    //  Name : start ()
+    /// <summary>
+    /// Starts the thread once the context is current, the functions are null
+    /// when updates can't be deferred.
+    /// </summary>
+    //-----------------------------------------------------------------------------
+    static void start(LPALDEFERUPDATESSOFT defer_updates, LPALPROCESSUPDATESSOFT process_updates);
+
+    //-----------------------------------------------------------------------------
+    //  Name : stop ()
+    /// <summary>
+    /// Applies what is queued and joins the thread, before the context goes.
+    /// </summary>
+    //-----------------------------------------------------------------------------
+    static void stop();
+
+    static void add_stream(std::shared_ptr<sound_stream> stream);
+    static void remove_stream(const sound_stream* stream);
+
+    //-----------------------------------------------------------------------------
+    //  Name : post ()
+    /// <summary>
+    /// Queues a change of a source. It is applied at once when the thread
+    /// doesn't run.
+    /// </summary>
+    //-----------------------------------------------------------------------------
+    static void post(const source_command& command);
+
+    //-----------------------------------------------------------------------------
+    //  Name : submit ()
+    /// <summary>
+    /// Wakes the thread to apply the queued changes before its next tick.
+    /// </summary>
+    //-----------------------------------------------------------------------------
+    static void submit();
+
+    //-----------------------------------------------------------------------------
+    //  Name : drain ()
+    /// <summary>
+    /// Waits until the queued changes are applied.
+    /// </summary>
+    //-----------------------------------------------------------------------------
+    static void drain();
+};
+}
+}
@@ -1,4 +1,5 @@
 #include "device_impl.h"
+#include "audio_thread.h"
 
 #include "check.h"
 #include "../logger.h"
@@ -138,9 +139,21 @@ device_impl::device_impl(int devnum)
     log_info("Using audio playback device: " + device_id_);
 
     al_check(alDistanceModel(AL_LINEAR_DISTANCE));
+
+    // suspending the context does nothing on most implementations
+    if(alIsExtensionPresent("AL_SOFT_deferred_updates") == AL_TRUE)
+    {
+        defer_updates_ = reinterpret_cast<LPALDEFERUPDATESSOFT>(alGetProcAddress("alDeferUpdatesSOFT"));
+        process_updates_ = reinterpret_cast<LPALPROCESSUPDATESSOFT>(alGetProcAddress("alProcessUpdatesSOFT"));
+    }
+
+    audio_thread::start(defer_updates_, process_updates_);
 }
 
-device_impl::~device_impl() = default;
+device_impl::~device_impl()
+{
+    audio_thread::stop();
+}
 
 void device_impl::enable()
 {
@@ -152,6 +165,31 @@ void device_impl::disable()
     al_check(alcMakeContextCurrent(nullptr));
 }
 
+void device_impl::suspend_updates()
+{
+    if(defer_updates_ != nullptr && process_updates_ != nullptr)
+    {
+        defer_updates_();
+        return;
+    }
+    alcSuspendContext(context_.get());
+}
+
+void device_impl::process_updates()
+{
+    if(defer_updates_ != nullptr && process_updates_ != nullptr)
+    {
+        process_updates_();
+        return;
+    }
+    alcProcessContext(context_.get());
+}
+
+void device_impl::submit()
+{
+    audio_thread::submit();
+}
+
 bool device_impl::is_valid() const
 {
     return (device_ != nullptr) && (context_ != nullptr);
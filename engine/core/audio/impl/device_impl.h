@@ -3,7 +3,9 @@
 #include <string>
 #include <vector>
 
+#include <AL/al.h>
 #include <AL/alc.h>
+#include <AL/alext.h>
 #include <map>
 
 namespace audio
@@ -19,6 +21,10 @@ public:
     void enable();
     void disable();
 
+    void suspend_updates();
+    void process_updates();
+    void submit();
+
     bool is_valid() const;
 
     const std::string& get_device_id() const;
@@ -44,6 +50,10 @@ private:
     std::string version_;
     std::string vendor_;
     std::string extensions_;
+
+    /// AL_SOFT_deferred_updates, null when the context is suspended instead
+    LPALDEFERUPDATESSOFT defer_updates_ = nullptr;
+    LPALPROCESSUPDATESSOFT process_updates_ = nullptr;
 };
 }
 }
@@ -63,9 +63,10 @@ static ALenum get_format_for_channels(std::uint32_t channels, std::uint32_t byte
 
 static const size_t CHUNK_SIZE = 64 * 1024; // size of buffer if streaming
 
-sound_impl::sound_impl(std::vector<std::uint8_t>&& buffer, const sound_info& info, bool stream /*= false*/)
-    : buf_(std::move(buffer))
-    ,  buf_info_(info)
+sound_impl::sound_impl(sound_data&& data, bool stream /*= false*/)
+    : buf_(std::move(data.data))
+    , buf_info_(data.info)
+    , encoded_(std::move(data.encoded))
 {
     if(buf_.empty())
     {
@@ -135,7 +136,23 @@ sound_impl::~sound_impl()
 
 bool sound_impl::is_valid() const
 {
-    return !handles_.empty();
+    return !handles_.empty() || is_streamed();
+}
+
+bool sound_impl::is_streamed() const
+{
+    return !encoded_.empty();
+}
+
+std::size_t sound_impl::get_memory_size() const
+{
+    if(is_streamed())
+    {
+        return encoded_.size();
+    }
+
+    const auto samples = std::size_t(buf_info_.get_duration() * buf_info_.sample_rate);
+    return samples * buf_info_.channels * buf_info_.bytes_per_sample;
 }
 
 void sound_impl::bind_to_source(source_impl* source)
@@ -178,6 +195,9 @@ void sound_impl::cleanup()
     }
 
     unbind_from_all_sources();
+
+    // only once no source decodes it
+    std::vector<std::uint8_t>().swap(encoded_);
 }
 }
 }
@@ -17,7 +17,7 @@ public:
 
     sound_impl();
     ~sound_impl();
-    sound_impl(std::vector<std::uint8_t>&& buffer, const sound_info& info, bool stream = false);
+    sound_impl(sound_data&& data, bool stream = false);
 
     sound_impl(sound_impl&& rhs) = delete;
     sound_impl& operator=(sound_impl&& rhs) = delete;
@@ -25,6 +25,8 @@ public:
     sound_impl& operator=(const sound_impl& rhs) = delete;
 
     bool is_valid() const;
+    bool is_streamed() const;
+    std::size_t get_memory_size() const;
 
     const std::vector<native_handle_type>& native_handles() const {
         return handles_;
@@ -49,6 +51,9 @@ private:
     size_t buf_ptr_ = 0;
     sound_info buf_info_;
 
+    // the compressed data every bound source decodes while it plays
+    std::vector<std::uint8_t> encoded_;
+
     /// openal doesn't let us destroy sounds that are
     /// binded, so we have to keep this bookkeeping
     std::mutex mutex_;
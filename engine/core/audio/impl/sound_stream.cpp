@@ -0,0 +1,272 @@
+#include "sound_stream.h"
+#include "../logger.h"
+#include "audio_thread.h"
+#include "check.h"
+#include "stb_vorbis.h"
+
+#include <algorithm>
+
+namespace audio
+{
+namespace priv
+{
+
+constexpr std::size_t sound_stream::buffer_count;
+constexpr std::size_t sound_stream::chunk_size;
+
+std::shared_ptr<sound_stream> sound_stream::open(const std::vector<std::uint8_t>& encoded,
+                                                 const sound_info& info, native_handle_type source)
+{
+    int err = 0;
+    auto decoder = stb_vorbis_open_memory(encoded.data(), int(encoded.size()), &err, nullptr);
+    if(decoder == nullptr)
+    {
+        log_error("Cannot open the sound stream. Vorbis error code : " + std::to_string(err));
+        return nullptr;
+    }
+
+    const auto channels = stb_vorbis_get_info(decoder).channels;
+    ALenum format = 0;
+    switch(channels)
+    {
+        case 1:
+            format = AL_FORMAT_MONO16;
+            break;
+        case 2:
+            format = AL_FORMAT_STEREO16;
+            break;
+        default:
+            log_error("Unsupported channel count of the sound stream.");
+            stb_vorbis_close(decoder);
+            return nullptr;
+    }
+
+    std::shared_ptr<sound_stream> stream(new sound_stream());
+    stream->decoder_ = decoder;
+    stream->source_ = source;
+    stream->format_ = format;
+    stream->info_ = info;
+    stream->info_.channels = std::uint32_t(channels);
+    stream->total_frames_ = stb_vorbis_stream_length_in_samples(decoder);
+    stream->pcm_.resize(chunk_size / sizeof(std::int16_t));
+    al_check(alGenBuffers(ALsizei(buffer_count), stream->buffers_.data()));
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex_);
+        stream->rewind(0);
+    }
+
+    audio_thread::add_stream(stream);
+    return stream;
+}
+
+sound_stream::~sound_stream()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    release();
+}
+
+void sound_stream::close()
+{
+    audio_thread::remove_stream(this);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    release();
+}
+
+void sound_stream::set_loop(bool on)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    loop_ = on;
+    if(loop_ && ended_ && decoder_ != nullptr)
+    {
+        // the rest is queued, keep decoding from the start after it
+        ended_ = false;
+        stb_vorbis_seek_start(decoder_);
+    }
+}
+
+bool sound_stream::is_looping() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return loop_;
+}
+
+void sound_stream::play()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(decoder_ == nullptr)
+    {
+        return;
+    }
+
+    ALint state = AL_INITIAL;
+    al_check(alGetSourcei(source_, AL_SOURCE_STATE, &state));
+    if(state == AL_STOPPED)
+    {
+        rewind(0);
+    }
+
+    playing_ = true;
+    al_check(alSourcePlay(source_));
+}
+
+void sound_stream::stop()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    playing_ = false;
+    if(decoder_ != nullptr)
+    {
+        al_check(alSourceStop(source_));
+    }
+}
+
+void sound_stream::seek(float seconds)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(decoder_ == nullptr || total_frames_ == 0)
+    {
+        return;
+    }
+
+    ALint state = AL_INITIAL;
+    al_check(alGetSourcei(source_, AL_SOURCE_STATE, &state));
+
+    const auto frame = std::uint32_t(std::max(seconds, 0.0f) * float(info_.sample_rate));
+    rewind(std::min(frame, total_frames_ - 1));
+
+    if(state == AL_PLAYING)
+    {
+        al_check(alSourcePlay(source_));
+    }
+}
+
+float sound_stream::get_offset() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(decoder_ == nullptr || total_frames_ == 0 || info_.sample_rate == 0)
+    {
+        return 0.0f;
+    }
+
+    ALint offset = 0;
+    al_check(alGetSourcei(source_, AL_SAMPLE_OFFSET, &offset));
+    const auto frame = (queued_start_ + std::uint32_t(offset)) % total_frames_;
+    return float(frame) / float(info_.sample_rate);
+}
+
+void sound_stream::update()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    // a stopped source keeps what it has queued until it is played again
+    if(decoder_ == nullptr || !playing_)
+    {
+        return;
+    }
+
+    ALint processed = 0;
+    al_check(alGetSourcei(source_, AL_BUFFERS_PROCESSED, &processed));
+    while(processed-- > 0 && !queued_frames_.empty())
+    {
+        native_handle_type buffer = 0;
+        al_check(alSourceUnqueueBuffers(source_, 1, &buffer));
+
+        queued_start_ = (queued_start_ + queued_frames_.front()) % std::max(total_frames_, 1u);
+        queued_frames_.pop_front();
+
+        if(!ended_ && fill(buffer))
+        {
+            al_check(alSourceQueueBuffers(source_, 1, &buffer));
+        }
+    }
+
+    ALint state = AL_INITIAL;
+    al_check(alGetSourcei(source_, AL_SOURCE_STATE, &state));
+    if(state == AL_STOPPED)
+    {
+        if(queued_frames_.empty())
+        {
+            playing_ = false;
+        }
+        else
+        {
+            // ran out of buffers before they were refilled
+            al_check(alSourcePlay(source_));
+        }
+    }
+}
+
+void sound_stream::release()
+{
+    if(decoder_ == nullptr)
+    {
+        return;
+    }
+
+    unqueue_all();
+    al_check(alDeleteBuffers(ALsizei(buffer_count), buffers_.data()));
+    stb_vorbis_close(decoder_);
+
+    decoder_ = nullptr;
+    source_ = 0;
+    playing_ = false;
+    std::vector<std::int16_t>().swap(pcm_);
+}
+
+bool sound_stream::fill(native_handle_type buffer)
+{
+    const auto channels = int(info_.channels);
+    auto frames = stb_vorbis_get_samples_short_interleaved(decoder_, channels, pcm_.data(), int(pcm_.size()));
+    if(frames <= 0 && loop_ && total_frames_ > 0)
+    {
+        stb_vorbis_seek_start(decoder_);
+        frames = stb_vorbis_get_samples_short_interleaved(decoder_, channels, pcm_.data(), int(pcm_.size()));
+    }
+
+    if(frames <= 0)
+    {
+        ended_ = true;
+        return false;
+    }
+
+    const auto size = std::size_t(frames) * std::size_t(channels) * sizeof(std::int16_t);
+    al_check(alBufferData(buffer, format_, pcm_.data(), ALsizei(size), ALsizei(info_.sample_rate)));
+    queued_frames_.push_back(std::uint32_t(frames));
+    return true;
+}
+
+void sound_stream::rewind(std::uint32_t frame)
+{
+    unqueue_all();
+
+    if(frame == 0)
+    {
+        stb_vorbis_seek_start(decoder_);
+    }
+    else
+    {
+        stb_vorbis_seek(decoder_, frame);
+    }
+    queued_start_ = frame;
+    ended_ = false;
+
+    for(auto buffer : buffers_)
+    {
+        if(!fill(buffer))
+        {
+            break;
+        }
+        al_check(alSourceQueueBuffers(source_, 1, &buffer));
+    }
+
+    // initial rather than stopped, so that playing doesn't rewind again
+    al_check(alSourceRewind(source_));
+}
+
+void sound_stream::unqueue_all()
+{
+    al_check(alSourceStop(source_));
+    al_check(alSourcei(source_, AL_BUFFER, 0));
+    queued_frames_.clear();
+}
+}
+}
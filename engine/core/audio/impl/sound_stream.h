@@ -0,0 +1,127 @@
+#pragma once
+
+#include "../sound_info.h"
+#include <AL/al.h>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct stb_vorbis;
+
+namespace audio
+{
+namespace priv
+{
+
+/*
+ * sound_stream; decodes a compressed sound for one source while it plays.
+ *
+ *      The stream owns a small ring of buffers queued on the source. The
+ *      audio thread unqueues the ones that were played, decodes the
+ *      next chunk into them and queues them again, so only the compressed
+ *      data and the ring are kept in memory. Looping is done by the stream,
+ *      the source itself never loops.
+ */
+class sound_stream
+{
+public:
+    using native_handle_type = ALuint;
+
+    //-----------------------------------------------------------------------------
+    //  Name : open ()
+    /// <summary>
+    /// Opens a stream of the encoded data for the source and queues the first
+    /// chunks. The encoded data must outlive the stream, null when it can't
+    /// be decoded.
+    /// </summary>
+    //-----------------------------------------------------------------------------
+    static std::shared_ptr<sound_stream> open(const std::vector<std::uint8_t>& encoded,
+                                              const sound_info& info, native_handle_type source);
+
+    ~sound_stream();
+
+    sound_stream(sound_stream&& rhs) = delete;
+    sound_stream& operator=(sound_stream&& rhs) = delete;
+
+    sound_stream(const sound_stream& rhs) = delete;
+    sound_stream& operator=(const sound_stream& rhs) = delete;
+
+    //-----------------------------------------------------------------------------
+    //  Name : close ()
+    /// <summary>
+    /// Stops the source, unqueues and deletes the buffers and the decoder.
+    /// Nothing is decoded after it returns.
+    /// </summary>
+    //-----------------------------------------------------------------------------
+    void close();
+
+    void set_loop(bool on);
+    bool is_looping() const;
+
+    //-----------------------------------------------------------------------------
+    //  Name : play ()
+    /// <summary>
+    /// Plays the source, from the start again when it was stopped.
+    /// </summary>
+    //-----------------------------------------------------------------------------
+    void play();
+    void stop();
+
+    //-----------------------------------------------------------------------------
+    //  Name : seek ()
+    /// <summary>
+    /// Decodes from the offset in seconds, keeping the source playing if it was.
+    /// </summary>
+    //-----------------------------------------------------------------------------
+    void seek(float seconds);
+    float get_offset() const;
+
+    //-----------------------------------------------------------------------------
+    //  Name : update ()
+    /// <summary>
+    /// Refills the buffers that were played. Called by the audio thread.
+    /// </summary>
+    //-----------------------------------------------------------------------------
+    void update();
+
+    /// the buffers of the ring, enough to cover the update interval several times
+    static constexpr std::size_t buffer_count = 4;
+    /// the bytes of pcm decoded into a buffer at once
+    static constexpr std::size_t chunk_size = 64 * 1024;
+
+private:
+    sound_stream() = default;
+
+    void release();
+    bool fill(native_handle_type buffer);
+    void rewind(std::uint32_t frame);
+    void unqueue_all();
+
+    mutable std::mutex mutex_;
+
+    stb_vorbis* decoder_ = nullptr;
+    native_handle_type source_ = 0;
+    std::array<native_handle_type, buffer_count> buffers_ = {};
+    ALenum format_ = 0;
+    sound_info info_;
+
+    /// the frames of every queued buffer, in the order they play
+    std::deque<std::uint32_t> queued_frames_;
+    /// the frame of the sound the first queued buffer starts at
+    std::uint32_t queued_start_ = 0;
+    std::uint32_t total_frames_ = 0;
+
+    /// the chunk being decoded, reused by every fill
+    std::vector<std::int16_t> pcm_;
+
+    bool loop_ = false;
+    /// played and not stopped, a source that ran out of buffers is resumed
+    bool playing_ = false;
+    /// the decoder reached the end and doesn't loop
+    bool ended_ = false;
+};
+}
+}
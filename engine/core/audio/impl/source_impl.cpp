@@ -3,12 +3,30 @@
 #include "check.h"
 #include "../exception.h"
 #include "../logger.h"
+#include "audio_thread.h"
 #include "sound_impl.h"
+#include "sound_stream.h"
+
+#include <algorithm>
+#include <initializer_list>
 
 namespace audio
 {
 namespace priv
 {
+namespace
+{
+void post(source_impl::native_handle_type source, source_command::kind type,
+          std::initializer_list<float> values)
+{
+    source_command command;
+    command.source = source;
+    command.type = type;
+    std::copy(std::begin(values), std::end(values), command.values);
+    audio_thread::post(command);
+}
+}
+
 source_impl::source_impl()
 {
     if (!create())
@@ -45,15 +63,33 @@ bool source_impl::bind(sound_impl* sound)
 
     bind_sound(sound);
 
-    const auto& handles = sound->native_handles();
-
     al_check(alSourcei(handle_, AL_SOURCE_RELATIVE, AL_FALSE));
     al_check(alSourcei(handle_, AL_BUFFER, 0));
-    alSourceQueueBuffers(handle_, ALsizei(handles.size()), handles.data());
 
-    // optional info
     ALint channels = 1;
-    al_check(alGetBufferi(handles.front(), AL_CHANNELS, &channels));
+    if(sound->is_streamed())
+    {
+        // the queue is refilled while playing, it must not loop by itself
+        al_check(alSourcei(handle_, AL_LOOPING, AL_FALSE));
+
+        stream_ = sound_stream::open(sound->encoded_, sound->buf_info_, handle_);
+        if(!stream_)
+        {
+            unbind_sound();
+            return false;
+        }
+        stream_->set_loop(loop_);
+        channels = ALint(sound->buf_info_.channels);
+    }
+    else
+    {
+        const auto& handles = sound->native_handles();
+        al_check(alSourcei(handle_, AL_LOOPING, loop_ ? AL_TRUE : AL_FALSE));
+        alSourceQueueBuffers(handle_, ALsizei(handles.size()), handles.data());
+        al_check(alGetBufferi(handles.front(), AL_CHANNELS, &channels));
+    }
+
+    // optional info
     if(channels > 1)
     {
         log_info("Sound is not mono. 3D Attenuation will not work.");
@@ -64,6 +100,11 @@ bool source_impl::bind(sound_impl* sound)
 
 bool source_impl::has_binded_sound() const
 {
+    if(stream_)
+    {
+        return true;
+    }
+
     ALint buffer = 0;
     al_check(alGetSourcei(handle_, AL_BUFFER, &buffer));
     return buffer != 0;
@@ -73,6 +114,12 @@ void source_impl::unbind()
 {
     stop();
 
+    if(stream_)
+    {
+        stream_->close();
+        stream_.reset();
+    }
+
     ALint queued;
     al_check(alGetSourcei(handle_, AL_BUFFERS_QUEUED, &queued));
     while (queued--)
@@ -93,6 +140,12 @@ void source_impl::purge()
 
     unbind();
 
+    // nothing queued may reach the name once it is reused
+    if(deferred_)
+    {
+        audio_thread::drain();
+    }
+
     al_check(alDeleteSources(1, &handle_));
 
     handle_ = 0;
@@ -100,6 +153,12 @@ void source_impl::purge()
 
 void source_impl::set_playing_offset(float seconds)
 {
+    if(stream_)
+    {
+        stream_->seek(seconds);
+        return;
+    }
+
     // temporary load the whole sound here
     // until we figure out a good way to load until the position we need it
     if (bound_sound_)
@@ -112,6 +171,11 @@ void source_impl::set_playing_offset(float seconds)
 
 float source_impl::get_playing_offset() const
 {
+    if(stream_)
+    {
+        return stream_->get_offset();
+    }
+
     ALfloat seconds = 0.0f;
     al_check(alGetSourcef(handle_, AL_SEC_OFFSET, &seconds));
     return static_cast<float>(seconds);
@@ -128,11 +192,29 @@ float source_impl::get_playing_duration() const
 
 void source_impl::play() const
 {
+    // heard with the changes queued before
+    if(deferred_)
+    {
+        audio_thread::drain();
+    }
+
+    if(stream_)
+    {
+        stream_->play();
+        return;
+    }
+
     al_check(alSourcePlay(handle_));
 }
 
 void source_impl::stop() const
 {
+    if(stream_)
+    {
+        stream_->stop();
+        return;
+    }
+
     al_check(alSourceStop(handle_));
 }
 
@@ -164,6 +246,11 @@ bool source_impl::is_stopped() const
 
 bool source_impl::is_binded() const
 {
+    if(stream_)
+    {
+        return true;
+    }
+
     ALint buffer = 0;
     al_check(alGetSourcei(handle_, AL_BUFFER, &buffer));
     return (buffer != 0);
@@ -171,44 +258,94 @@ bool source_impl::is_binded() const
 
 void source_impl::set_loop(bool on)
 {
+    loop_ = on;
+    if(stream_)
+    {
+        stream_->set_loop(on);
+        return;
+    }
+
     al_check(alSourcei(handle_, AL_LOOPING, on ? AL_TRUE : AL_FALSE));
 }
 
 void source_impl::set_volume(float volume)
 {
+    if(deferred_)
+    {
+        post(handle_, source_command::kind::volume, {volume});
+        return;
+    }
+
     al_check(alSourcef(handle_, AL_GAIN, volume));
 }
 
 /* pitch, speed stretching */
 void source_impl::set_pitch(float pitch)
 {
+    if(deferred_)
+    {
+        post(handle_, source_command::kind::pitch, {pitch});
+        return;
+    }
+
     // if pitch == 0.f pitch = 0.0001f;
     al_check(alSourcef(handle_, AL_PITCH, pitch));
 }
 
 void source_impl::set_position(const float3& position)
 {
+    if(deferred_)
+    {
+        post(handle_, source_command::kind::position, {position[0], position[1], position[2]});
+        return;
+    }
+
     al_check(alSourcefv(handle_, AL_POSITION, position.data()));
 }
 
 void source_impl::set_velocity(const float3& velocity)
 {
+    if(deferred_)
+    {
+        post(handle_, source_command::kind::velocity, {velocity[0], velocity[1], velocity[2]});
+        return;
+    }
+
     al_check(alSourcefv(handle_, AL_VELOCITY, velocity.data()));
 }
 
 void source_impl::set_orientation(const float3& direction, const float3& up)
 {
+    if(deferred_)
+    {
+        post(handle_, source_command::kind::orientation,
+             {-direction[0], -direction[1], -direction[2], up[0], up[1], up[2]});
+        return;
+    }
+
     float orientation6[] = {-direction[0], -direction[1], -direction[2], up[0], up[1], up[2]};
     al_check(alSourcefv(handle_, AL_ORIENTATION, orientation6));
 }
 
 void source_impl::set_volume_rolloff(float rolloff)
 {
+    if(deferred_)
+    {
+        post(handle_, source_command::kind::rolloff, {rolloff});
+        return;
+    }
+
     al_check(alSourcef(handle_, AL_ROLLOFF_FACTOR, rolloff));
 }
 
 void source_impl::set_distance(float mind, float maxd)
 {
+    if(deferred_)
+    {
+        post(handle_, source_command::kind::distance, {mind, maxd});
+        return;
+    }
+
 
     // The distance that the source will be the loudest (if the listener is
     // closer, it won't be any louder than if they were at this distance)
@@ -219,6 +356,15 @@ void source_impl::set_distance(float mind, float maxd)
     al_check(alSourcef(handle_, AL_MAX_DISTANCE, maxd));
 }
 
+void source_impl::set_deferred(bool on)
+{
+    if(deferred_ && !on)
+    {
+        audio_thread::drain();
+    }
+    deferred_ = on;
+}
+
 bool source_impl::is_valid() const
 {
     return handle_ != 0;
@@ -226,6 +372,11 @@ bool source_impl::is_valid() const
 
 bool source_impl::is_looping() const
 {
+    if(stream_)
+    {
+        return stream_->is_looping();
+    }
+
     ALint loop;
     al_check(alGetSourcei(handle_, AL_LOOPING, &loop));
     return loop != 0;
@@ -233,7 +384,8 @@ bool source_impl::is_looping() const
 
 void source_impl::update_stream()
 {
-    if (bound_sound_)
+    // a streamed sound is refilled by the streaming thread
+    if (bound_sound_ && !stream_)
     {
         bound_sound_->load_buffer();
     }
@@ -3,6 +3,7 @@
 #include "../types.h"
 #include <AL/al.h>
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -11,6 +12,7 @@ namespace audio
 namespace priv
 {
 class sound_impl;
+class sound_stream;
 
 class source_impl
 {
@@ -39,6 +41,7 @@ public:
 
     void set_volume_rolloff(float rolloff);
     void set_distance(float mind, float maxd);
+    void set_deferred(bool on);
     void set_playing_offset(float seconds);
     float get_playing_offset() const;
     float get_playing_duration() const;
@@ -68,6 +71,15 @@ private:
 
     /// non owning
     sound_impl* bound_sound_ = nullptr;
+
+    /// the decoding of the bound sound when it is streamed
+    std::shared_ptr<sound_stream> stream_;
+
+    /// a streamed sound loops in the stream rather than the source
+    bool loop_ = false;
+
+    /// the parameters are queued to the audio thread
+    bool deferred_ = false;
 };
 }
 }
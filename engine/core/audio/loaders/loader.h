@@ -5,6 +5,9 @@ namespace audio
 
 bool load_ogg_from_memory(const std::uint8_t* data, std::size_t data_size, sound_data& result,
                           std::string& err);
+// keeps the ogg compressed in result.encoded, to be decoded while it plays
+bool open_ogg_from_memory(const std::uint8_t* data, std::size_t data_size, sound_data& result,
+                          std::string& err);
 bool load_wav_from_memory(const std::uint8_t* data, std::size_t data_size, sound_data& result,
                           std::string& err);
 }
@@ -8,7 +8,7 @@ sound::sound() = default;
 sound::~sound() = default;
 
 sound::sound(sound_data&& data, bool stream)
-    : impl_(std::make_unique<priv::sound_impl>(std::move(data.data), data.info, stream))
+    : impl_(std::make_unique<priv::sound_impl>(std::move(data), stream))
     , info_(std::move(data.info))
 {
 }
@@ -26,6 +26,16 @@ const sound_info& sound::get_info() const
     return info_;
 }
 
+bool sound::is_streamed() const
+{
+    return impl_ && impl_->is_streamed();
+}
+
+std::size_t sound::get_memory_size() const
+{
+    return impl_ ? impl_->get_memory_size() : 0;
+}
+
 bool sound::load_buffer()
 {
     return impl_ && impl_->load_buffer();
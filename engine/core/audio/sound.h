@@ -47,6 +47,22 @@ public:
     //-----------------------------------------------------------------------------
     const sound_info& get_info() const;
 
+    //-----------------------------------------------------------------------------
+    //  Name : is_streamed ()
+    /// <summary>
+    /// Checks whether the sound is kept compressed and decoded while it plays.
+    /// </summary>
+    //-----------------------------------------------------------------------------
+    bool is_streamed() const;
+
+    //-----------------------------------------------------------------------------
+    //  Name : get_memory_size ()
+    /// <summary>
+    /// Gets the bytes the sound takes, the compressed data when streamed.
+    /// </summary>
+    //-----------------------------------------------------------------------------
+    std::size_t get_memory_size() const;
+
     bool load_buffer();
 
     //-----------------------------------------------------------------------------
@@ -7,6 +7,12 @@ namespace audio
 
 void sound_data::convert_to_mono()
 {
+    if(!encoded.empty())
+    {
+        log_error("Does not support mono conversion of compressed sounds");
+        return;
+    }
+
     if(info.channels == 2)
     {
         data = utils::convert_to_mono(data, info.bytes_per_sample);
@@ -20,6 +26,12 @@ void sound_data::convert_to_mono()
 
 void sound_data::convert_to_stereo()
 {
+    if(!encoded.empty())
+    {
+        log_error("Does not support stereo conversion of compressed sounds");
+        return;
+    }
+
     if(info.channels == 1)
     {
         data = utils::convert_to_stereo(data, info.bytes_per_sample);
@@ -33,5 +33,9 @@ struct sound_data
 
     /// data buffer of pcm sound stored in uint8_t buffer
     std::vector<std::uint8_t> data;
+
+    /// the compressed ogg vorbis stream of a sound decoded while it plays,
+    /// the pcm data is empty then
+    std::vector<std::uint8_t> encoded;
 };
 }
@@ -123,6 +123,14 @@ void source::set_orientation(const float3& direction, const float3& up)
     }
 }
 
+void source::set_deferred(bool on)
+{
+    if(is_valid())
+    {
+        impl_->set_deferred(on);
+    }
+}
+
 void source::set_volume_rolloff(float rolloff)
 {
     if(is_valid())
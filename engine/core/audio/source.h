@@ -99,6 +99,16 @@ public:
     //-----------------------------------------------------------------------------
     void set_orientation(const float3& direction, const float3& up);
 
+    //-----------------------------------------------------------------------------
+    //  Name : set_deferred ()
+    /// <summary>
+    /// When on the volume, pitch, position, velocity, orientation, rolloff and
+    /// distance are queued to the audio thread and applied in order on its
+    /// tick. The source must then be changed from one thread at a time.
+    /// </summary>
+    //-----------------------------------------------------------------------------
+    void set_deferred(bool on);
+
     //-----------------------------------------------------------------------------
     //  Name : set_volume_rolloff ()
     /// <summary>
@@ -1,10 +1,66 @@
 #include "utils.h"
 #include "logger.h"
+#include <algorithm>
 #include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIO_UTILS_SSE
+#endif
+
 namespace audio
 {
 namespace utils
 {
+namespace
+{
+// the truncated average of each left and right pair, as (left + right) / 2
+void average_pairs(const std::uint8_t* input, std::uint8_t* output, std::size_t frames)
+{
+    std::size_t i = 0;
+#if defined(AUDIO_UTILS_SSE)
+    const __m128i ones = _mm_set1_epi16(1);
+    for(; i + 8 <= frames; i += 8)
+    {
+        const auto first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 4));
+        const auto second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 4 + 16));
+        // left + right widened to 32 bits, rounded toward zero when halved
+        auto low = _mm_madd_epi16(first, ones);
+        auto high = _mm_madd_epi16(second, ones);
+        low = _mm_srai_epi32(_mm_add_epi32(low, _mm_srli_epi32(low, 31)), 1);
+        high = _mm_srai_epi32(_mm_add_epi32(high, _mm_srli_epi32(high, 31)), 1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 2), _mm_packs_epi32(low, high));
+    }
+#endif
+    for(; i < frames; ++i)
+    {
+        std::int16_t pair[2];
+        std::memcpy(pair, input + i * 4, sizeof(pair));
+        const auto mono_sample = std::int16_t((int(pair[0]) + pair[1]) / 2);
+        std::memcpy(output + i * 2, &mono_sample, sizeof(mono_sample));
+    }
+}
+
+// each sample twice
+void duplicate_samples(const std::uint8_t* input, std::uint8_t* output, std::size_t samples)
+{
+    std::size_t i = 0;
+#if defined(AUDIO_UTILS_SSE)
+    for(; i + 8 <= samples; i += 8)
+    {
+        const auto value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4), _mm_unpacklo_epi16(value, value));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4 + 16), _mm_unpackhi_epi16(value, value));
+    }
+#endif
+    for(; i < samples; ++i)
+    {
+        std::memcpy(output + i * 4, input + i * 2, 2);
+        std::memcpy(output + i * 4 + 2, input + i * 2, 2);
+    }
+}
+}
+
 std::vector<std::uint8_t> convert_to_mono(const std::vector<std::uint8_t>& input,
                                           std::uint8_t bytes_per_sample)
 {
@@ -14,33 +70,19 @@ std::vector<std::uint8_t> convert_to_mono(const std::vector<std::uint8_t>& input
         return input;
     }
 
-    std::vector<std::uint8_t> output;
-    output.reserve(input.size() / 2);
+    const std::size_t frames = input.size() / (2 * std::size_t(bytes_per_sample));
+    std::vector<std::uint8_t> output(frames * bytes_per_sample);
 
     if(bytes_per_sample == 1)
     {
-        for(std::size_t i = 0, sz = input.size(); i < sz; i += 2 * bytes_per_sample)
+        for(std::size_t i = 0; i < frames; ++i)
         {
-            const std::uint8_t left = input[i];
-            const std::uint8_t right = input[i + bytes_per_sample];
-            const auto mono_sample = std::uint8_t((int(left) + right) / 2);
-
-            output.push_back(mono_sample);
+            output[i] = std::uint8_t((int(input[i * 2]) + input[i * 2 + 1]) / 2);
         }
     }
     else if(bytes_per_sample == 2)
     {
-        for(std::size_t i = 0, sz = input.size(); i < sz; i += 2 * bytes_per_sample)
-        {
-            const std::int16_t left = *reinterpret_cast<const std::int16_t*>(&input[i]);
-            const std::int16_t right = *reinterpret_cast<const std::int16_t*>(&input[i + bytes_per_sample]);
-            const auto mono_sample = std::int16_t((int(left) + right) / 2);
-
-            const auto sample_part1 = std::uint8_t(mono_sample >> 0);
-            const auto sample_part2 = std::uint8_t(mono_sample >> 8);
-            output.push_back(sample_part1);
-            output.push_back(sample_part2);
-        }
+        average_pairs(input.data(), output.data(), frames);
     }
     return output;
 }
@@ -54,14 +96,20 @@ std::vector<std::uint8_t> convert_to_stereo(const std::vector<std::uint8_t>& inp
         return input;
     }
 
-    std::vector<std::uint8_t> output;
-    output.resize(input.size() * 2, 0);
+    const std::size_t samples = input.size() / std::max<std::size_t>(bytes_per_sample, 1);
+    std::vector<std::uint8_t> output(samples * 2 * bytes_per_sample);
 
-    for(std::size_t i = 0, sz = input.size(); i < sz; i += bytes_per_sample)
+    if(bytes_per_sample == 1)
+    {
+        for(std::size_t i = 0; i < samples; ++i)
+        {
+            output[i * 2] = input[i];
+            output[i * 2 + 1] = input[i];
+        }
+    }
+    else if(bytes_per_sample == 2)
     {
-        const std::size_t dst_idx = i * 2;
-        std::memcpy(output.data() + dst_idx, input.data() + i, bytes_per_sample);
-        std::memcpy(output.data() + dst_idx + bytes_per_sample, input.data() + i, bytes_per_sample);
+        duplicate_samples(input.data(), output.data(), samples);
     }
 
     return output;
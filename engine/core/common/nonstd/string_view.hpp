@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace nonstd
+{
+/*
+ * string_view; a range of chars owned elsewhere, the part of std::string_view
+ * the engine needs until it is on c++17.
+ */
+class string_view
+{
+public:
+	using const_iterator = const char*;
+
+	constexpr string_view() noexcept = default;
+
+	constexpr string_view(const char* data, std::size_t size) noexcept
+		: data_(data)
+		, size_(size)
+	{
+	}
+
+	string_view(const char* str) noexcept
+		: data_(str)
+		, size_(std::strlen(str))
+	{
+	}
+
+	string_view(const std::string& str) noexcept
+		: data_(str.data())
+		, size_(str.size())
+	{
+	}
+
+	constexpr const char* data() const noexcept
+	{
+		return data_;
+	}
+
+	constexpr std::size_t size() const noexcept
+	{
+		return size_;
+	}
+
+	constexpr bool empty() const noexcept
+	{
+		return size_ == 0;
+	}
+
+	constexpr const_iterator begin() const noexcept
+	{
+		return data_;
+	}
+
+	constexpr const_iterator end() const noexcept
+	{
+		return data_ + size_;
+	}
+
+	constexpr char operator[](std::size_t pos) const noexcept
+	{
+		return data_[pos];
+	}
+
+	/// the part from pos of up to count chars, pos is at most size()
+	string_view substr(std::size_t pos, std::size_t count = std::size_t(-1)) const noexcept
+	{
+		const auto left = size_ - pos;
+		return string_view(data_ + pos, count < left ? count : left);
+	}
+
+	std::string to_string() const
+	{
+		return std::string(data_, size_);
+	}
+
+	friend bool operator==(string_view lhs, string_view rhs) noexcept
+	{
+		return lhs.size_ == rhs.size_ &&
+			   (lhs.size_ == 0 || std::memcmp(lhs.data_, rhs.data_, lhs.size_) == 0);
+	}
+
+	friend bool operator!=(string_view lhs, string_view rhs) noexcept
+	{
+		return !(lhs == rhs);
+	}
+
+private:
+	const char* data_ = nullptr;
+	std::size_t size_ = 0;
+};
+}
@@ -2,7 +2,9 @@
 
 #include "config.hpp"
 
+#include <cstdint>
 #include <thread>
+#include <vector>
 
 // An attempt at making a wrapper to deal with many Linuxes as well as Windows. Please edit as needed.
 #if ETH_ON(ETH_PLATFORM_WINDOWS) && ETH_ON(ETH_COMPILER_MSVC)
@@ -57,13 +59,126 @@ inline void set_thread_name(std::thread& thread, const char* threadName)
 	DWORD threadId = ::GetThreadId(reinterpret_cast<HANDLE>(thread.native_handle()));
 	set_thread_name(threadId, threadName);
 }
+
+// Restricts the thread to the logical cpus set in the mask (cpu i is bit i).
+inline bool set_thread_affinity(std::thread& thread, std::uint64_t mask)
+{
+	return ::SetThreadAffinityMask(reinterpret_cast<HANDLE>(thread.native_handle()),
+								   static_cast<DWORD_PTR>(mask)) != 0;
+}
+
+// Logical cpus grouped by the physical core they belong to.
+inline std::vector<std::vector<std::uint32_t>> get_cpu_cores()
+{
+	std::vector<std::vector<std::uint32_t>> cores;
+
+	DWORD length = 0;
+	::GetLogicalProcessorInformation(nullptr, &length);
+	std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> infos(length /
+															sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+	if(infos.empty() || !::GetLogicalProcessorInformation(infos.data(), &length))
+	{
+		return cores;
+	}
+
+	for(const auto& info : infos)
+	{
+		if(info.Relationship != RelationProcessorCore)
+		{
+			continue;
+		}
+
+		cores.emplace_back();
+		for(std::uint32_t cpu = 0; cpu < sizeof(ULONG_PTR) * 8; ++cpu)
+		{
+			if(info.ProcessorMask & (ULONG_PTR(1) << cpu))
+			{
+				cores.back().push_back(cpu);
+			}
+		}
+	}
+	return cores;
+}
 }
 #else
+#include <pthread.h>
+
+#include <cstdio>
+#include <utility>
+
 namespace platform
 {
 inline void set_thread_name(std::thread& thread, const char* threadName)
 {
 	pthread_setname_np(thread.native_handle(), threadName);
 }
+
+// Restricts the thread to the logical cpus set in the mask (cpu i is bit i).
+inline bool set_thread_affinity(std::thread& thread, std::uint64_t mask)
+{
+#if ETH_ON(ETH_PLATFORM_LINUX)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for(std::uint32_t cpu = 0; cpu < 64; ++cpu)
+	{
+		if(mask & (std::uint64_t(1) << cpu))
+		{
+			CPU_SET(cpu, &set);
+		}
+	}
+	return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+	(void)thread;
+	(void)mask;
+	return false;
+#endif
+}
+
+// Logical cpus grouped by the physical core they belong to.
+inline std::vector<std::vector<std::uint32_t>> get_cpu_cores()
+{
+	std::vector<std::vector<std::uint32_t>> cores;
+#if ETH_ON(ETH_PLATFORM_LINUX)
+	// (package id, core id) of every logical cpu as reported by sysfs
+	std::vector<std::pair<long, long>> ids;
+	for(std::uint32_t cpu = 0;; ++cpu)
+	{
+		const auto read_id = [cpu](const char* name) {
+			char path[128];
+			std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/%s", cpu, name);
+			long id = -1;
+			if(auto file = std::fopen(path, "r"))
+			{
+				if(std::fscanf(file, "%ld", &id) != 1)
+				{
+					id = -1;
+				}
+				std::fclose(file);
+			}
+			return id;
+		};
+
+		const auto core_id = read_id("core_id");
+		if(core_id < 0)
+		{
+			break;
+		}
+		const auto key = std::make_pair(read_id("physical_package_id"), core_id);
+
+		std::size_t core = 0;
+		while(core < ids.size() && ids[core] != key)
+		{
+			++core;
+		}
+		if(core == ids.size())
+		{
+			ids.push_back(key);
+			cores.emplace_back();
+		}
+		cores[core].push_back(cpu);
+	}
+#endif
+	return cores;
+}
 }
 #endif
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "config.hpp"
+
+#if ETH_ON(ETH_PLATFORM_WINDOWS)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <mmsystem.h>
+
+#ifdef min
+#undef min
+#endif
+
+#ifdef max
+#undef max
+#endif
+#endif
+
+namespace platform
+{
+//-----------------------------------------------------------------------------
+//  Name : set_high_timer_resolution ()
+/// <summary>
+/// Asks the os to wake the sleeping threads with a 1ms precision. The 15.6ms
+/// default of windows makes a sleep overshoot by that much, the other
+/// platforms are already precise and it does nothing there. Calls to
+/// enable and disable have to be paired.
+/// </summary>
+//-----------------------------------------------------------------------------
+inline void set_high_timer_resolution(bool enabled)
+{
+#if ETH_ON(ETH_PLATFORM_WINDOWS)
+	if(enabled)
+	{
+		timeBeginPeriod(1);
+	}
+	else
+	{
+		timeEndPeriod(1);
+	}
+#else
+	(void)enabled;
+#endif
+}
+}
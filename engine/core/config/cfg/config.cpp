@@ -18,39 +18,58 @@ config::~config()
 {
 }
 
-bool config::has_value(const std::string& section, const std::string& name) const
+config::key config::get_key(const std::string& section, const std::string& name)
+{
+	auto& keys = keys_[section];
+	auto it = keys.find(name);
+	if(it != keys.end())
+	{
+		return it->second;
+	}
+
+	const auto k = static_cast<key>(entries_.size());
+	entries_.emplace_back();
+	entries_.back().section = section;
+	entries_.back().name = name;
+	keys.emplace(name, k);
+	return k;
+}
+
+const config::entry* config::find(const std::string& section, const std::string& name) const
 {
-	auto si = values_.find(section);
-	if(si != values_.end())
+	auto si = keys_.find(section);
+	if(si != keys_.end())
 	{
 		auto vi = si->second.find(name);
-		if(vi != si->second.end())
+		if(vi != si->second.end() && entries_[vi->second].is_set)
 		{
-			return true;
+			return &entries_[vi->second];
 		}
 	}
-	return false;
+	return nullptr;
+}
+
+bool config::has_value(const std::string& section, const std::string& name) const
+{
+	return find(section, name) != nullptr;
 }
 
 const std::string& config::get(const std::string& section, const std::string& name) const
 {
-	auto si = values_.find(section);
-	if(si != values_.end())
+	const auto e = find(section, name);
+	if(e != nullptr)
 	{
-		auto vi = si->second.find(name);
-		if(vi != si->second.end())
-		{
-			return vi->second;
-		}
+		return e->value;
 	}
 	throw std::logic_error("Value " + section + ":" + name + " does not exist.");
 }
 
-bool isalnum(const std::string& name)
+// what the parser reads as an identifier
+bool is_identifier(const std::string& name)
 {
 	for(char c : name)
 	{
-		if(std::isalnum(c) == 0)
+		if(std::isalnum(static_cast<unsigned char>(c)) == 0 && c != '_' && c != '-')
 		{
 			return false;
 		}
@@ -60,7 +79,8 @@ bool isalnum(const std::string& name)
 
 bool is_number(const std::string& token)
 {
-	return std::regex_match(token, std::regex("((\\+|-)?[[:digit:]]+)(\\.(([[:digit:]]+)?))?"));
+	static const std::regex number("((\\+|-)?[[:digit:]]+)(\\.(([[:digit:]]+)?))?");
+	return std::regex_match(token, number);
 }
 
 const std::string& config::get_value(const std::string& section, const std::string& name,
@@ -76,16 +96,40 @@ const std::string& config::get_value(const std::string& section, const std::stri
 
 void config::set(const std::string& section, const std::string& name, const std::string& value)
 {
-	if(!isalnum(section))
+	if(!is_identifier(section))
 	{
 		throw std::invalid_argument("Section is not an identifier.");
 	}
-	if(!isalnum(name))
+	if(!is_identifier(name))
 	{
 		throw std::invalid_argument("Name is not an identifier.");
 	}
 
-	values_[section][name] = value;
+	set(get_key(section, name), value);
+}
+
+void config::set(key k, const std::string& value)
+{
+	auto& e = entries_[k];
+	if(e.is_set && e.value == value)
+	{
+		return;
+	}
+
+	e.value = value;
+	e.is_set = true;
+	++e.version;
+	// a callback may add keys, which moves the entries
+	const auto callbacks = e.callbacks;
+	for(const auto& callback : callbacks)
+	{
+		callback(k);
+	}
+}
+
+void config::on_changed(key k, on_changed_t callback)
+{
+	entries_[k].callbacks.emplace_back(std::move(callback));
 }
 
 std::string escape(const std::string& value)
@@ -153,12 +197,22 @@ void config::save(const std::string& file)
 		throw std::runtime_error("Failed to open " + file + " for writing.");
 	}
 
-	for(auto& section : values_)
+	for(auto& section : keys_)
 	{
-		out << "[" << section.first << "]" << std::endl;
-		for(auto& value : section.second)
+		bool header = false;
+		for(auto& name : section.second)
 		{
-			out << value.first << " = " << escape(value.second) << std::endl;
+			const auto& e = entries_[name.second];
+			if(!e.is_set)
+			{
+				continue;
+			}
+			if(!header)
+			{
+				out << "[" << section.first << "]" << std::endl;
+				header = true;
+			}
+			out << name.first << " = " << escape(e.value) << std::endl;
 		}
 	}
 }
@@ -1,25 +1,54 @@
 #ifndef CFG_CONFIG_H
 #define CFG_CONFIG_H
 
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <sstream>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 namespace cfg
 {
 class config
 {
 public:
+	/// a section and name interned by get_key, valid as long as the config
+	using key = std::uint32_t;
+	using on_changed_t = std::function<void(key)>;
+
+	template <typename T>
+	class cached;
+
 	config();
 
 	~config();
 
+	/// the key of the value, made the first time it is asked for
+	key get_key(const std::string& section, const std::string& name);
+
 	bool has_value(const std::string& section, const std::string& name) const;
 
+	bool has_value(key k) const
+	{
+		return entries_[k].is_set;
+	}
+
 	const std::string& get(const std::string& section, const std::string& name) const;
 
+	const std::string& get(key k) const
+	{
+		return entries_[k].value;
+	}
+
+	/// changes whenever the value is set
+	std::uint32_t get_version(key k) const
+	{
+		return entries_[k].version;
+	}
+
 	const std::string& get_value(const std::string& section, const std::string& name,
 								 const std::string& defaultValue);
 
@@ -31,15 +60,14 @@ public:
 			return defaultValue;
 		}
 
-		const auto& value = get(section, name);
-
-		typename std::decay<T>::type result;
-		std::istringstream(value) >> result;
-		return result;
+		return parse<T>(get(section, name));
 	}
 
 	void set(const std::string& section, const std::string& name, const std::string& value);
 
+	/// the callbacks of the key are called when the value changes
+	void set(key k, const std::string& value);
+
 	template <typename T>
 	void set_value(const std::string& section, const std::string& name, const T& value)
 	{
@@ -48,14 +76,89 @@ public:
 		set(section, name, stream.str());
 	}
 
+	/// called after the value of the key changed, by set or load
+	void on_changed(key k, on_changed_t callback);
+
+	/// a typed accessor of the value, parsed again only after it changes
+	template <typename T>
+	cached<T> get_cached(const std::string& section, const std::string& name, const T& defaultValue)
+	{
+		return cached<T>(*this, get_key(section, name), defaultValue);
+	}
+
 	void save(const std::string& file);
 
 	void load(const std::string& file);
 
+	template <typename T>
+	static T parse(const std::string& value)
+	{
+		typename std::decay<T>::type result;
+		std::istringstream(value) >> result;
+		return result;
+	}
+
+private:
+	struct entry
+	{
+		std::string section;
+		std::string name;
+		std::string value;
+		bool is_set = false;
+		std::uint32_t version = 0;
+		std::vector<on_changed_t> callbacks;
+	};
+
+	const entry* find(const std::string& section, const std::string& name) const;
+
+	typedef std::map<std::string, key> section_type;
+	/// the keys by section and name, sorted for the save
+	std::map<std::string, section_type> keys_;
+	std::vector<entry> entries_;
+};
+
+template <typename T>
+class config::cached
+{
+public:
+	cached(const config& c, key k, const T& defaultValue)
+		: config_(&c)
+		, key_(k)
+		, default_(defaultValue)
+		, value_(defaultValue)
+	{
+	}
+
+	const T& get() const
+	{
+		const auto version = config_->get_version(key_);
+		if(version != version_)
+		{
+			version_ = version;
+			value_ = config_->has_value(key_) ? parse<T>(config_->get(key_)) : default_;
+		}
+		return value_;
+	}
+
+	key get_key() const
+	{
+		return key_;
+	}
+
 private:
-	typedef std::map<std::string, std::string> section_type;
-	std::map<std::string, section_type> values_;
+	const config* config_;
+	key key_;
+	T default_;
+	mutable T value_;
+	/// none of the versions, the first get parses
+	mutable std::uint32_t version_ = std::uint32_t(-1);
 };
+
+template <>
+inline std::string config::parse<std::string>(const std::string& value)
+{
+	return value;
+}
 }
 
 #endif
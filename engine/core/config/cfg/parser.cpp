@@ -1,6 +1,7 @@
 #include "parser.h"
 #include "config.h"
 
+#include <iterator>
 #include <sstream>
 #include <stdexcept>
 
@@ -9,7 +10,6 @@ namespace cfg
 
 parser::parser(config& c)
 	: conf_(c)
-	, in_(nullptr)
 	, line_(0)
 	, next_token_(NO_TOKEN)
 {
@@ -21,7 +21,16 @@ parser::~parser()
 
 void parser::parse(std::istream& i, const std::string& f, unsigned int l)
 {
-	in_ = &i;
+	// read at once, the lexer walks the buffer
+	std::string buffer((std::istreambuf_iterator<char>(i)), std::istreambuf_iterator<char>());
+	parse(buffer.data(), buffer.size(), f, l);
+}
+
+void parser::parse(const char* data, std::size_t size, const std::string& f, unsigned int l)
+{
+	data_ = data;
+	size_ = size;
+	pos_ = 0;
 	file_ = f;
 	line_ = l;
 
@@ -43,10 +52,23 @@ void parser::parse(std::istream& i, const std::string& f, unsigned int l)
 	}
 }
 
+int parser::get()
+{
+	// one past the end reads as EOF, as many times as it is asked for
+	const int c = pos_ < size_ ? static_cast<unsigned char>(data_[pos_]) : EOF;
+	++pos_;
+	return c;
+}
+
+void parser::unget()
+{
+	--pos_;
+}
+
 parser::Token parser::get_next_token(std::string& value)
 {
 	Token token = next_token_;
-	value = next_value_;
+	value.swap(next_value_);
 
 	next_token_ = lex_token(next_value_);
 	while(next_token_ == WHITESPACE || next_token_ == COMMENT)
@@ -60,7 +82,7 @@ parser::Token parser::get_next_token(std::string& value)
 parser::Token parser::lex_token(std::string& value)
 {
 	value.clear();
-	int c = in_->get();
+	int c = get();
 	switch(c)
 	{
 		case ' ':
@@ -165,7 +187,7 @@ parser::Token parser::lex_token(std::string& value)
 
 parser::Token parser::lex_whitespace(std::string& value)
 {
-	int c = in_->get();
+	int c = get();
 	while(true)
 	{
 		switch(c)
@@ -176,16 +198,16 @@ parser::Token parser::lex_whitespace(std::string& value)
 				value.push_back(std::string::value_type(c));
 				break;
 			default:
-				in_->unget();
+				unget();
 				return WHITESPACE;
 		}
-		c = in_->get();
+		c = get();
 	}
 }
 
 parser::Token parser::lex_newline(std::string& value)
 {
-	int c = in_->get();
+	int c = get();
 	line_++;
 	switch(c)
 	{
@@ -199,18 +221,18 @@ parser::Token parser::lex_newline(std::string& value)
 			else
 			{
 				// treat \n \n as two newline, obviously
-				in_->unget();
+				unget();
 			}
 			return NEWLINE;
 		default:
-			in_->unget();
+			unget();
 			return NEWLINE;
 	}
 }
 
 parser::Token parser::lex_number(std::string& value)
 {
-	int c = in_->get();
+	int c = get();
 	while(true)
 	{
 		// NOTE: not validating the actual format
@@ -230,16 +252,16 @@ parser::Token parser::lex_number(std::string& value)
 				value.push_back(std::string::value_type(c));
 				break;
 			default:
-				in_->unget();
+				unget();
 				return NUMBER;
 		}
-		c = in_->get();
+		c = get();
 	}
 }
 
 parser::Token parser::lex_identifier(std::string& value)
 {
-	int c = in_->get();
+	int c = get();
 	while(true)
 	{
 		switch(c)
@@ -311,16 +333,16 @@ parser::Token parser::lex_identifier(std::string& value)
 				value.push_back(std::string::value_type(c));
 				break;
 			default:
-				in_->unget();
+				unget();
 				return IDENTIFIER;
 		}
-		c = in_->get();
+		c = get();
 	}
 }
 
 parser::Token parser::lex_string(std::string& value)
 {
-	int c = in_->get();
+	int c = get();
 	while(true)
 	{
 		switch(c)
@@ -333,7 +355,7 @@ parser::Token parser::lex_string(std::string& value)
 				error("Unexpected newline in string.");
 				return ERROR;
 			case '\\':
-				c = in_->get();
+				c = get();
 				switch(c)
 				{
 					case '\'':
@@ -375,13 +397,13 @@ parser::Token parser::lex_string(std::string& value)
 				value.push_back(std::string::value_type(c));
 				break;
 		}
-		c = in_->get();
+		c = get();
 	}
 }
 
 parser::Token parser::lex_comment(std::string& value)
 {
-	int c = in_->get();
+	int c = get();
 	while(true)
 	{
 		switch(c)
@@ -394,7 +416,7 @@ parser::Token parser::lex_comment(std::string& value)
 				value.push_back(std::string::value_type(c));
 				break;
 		}
-		c = in_->get();
+		c = get();
 	}
 }
 
@@ -467,7 +489,7 @@ void parser::parse_value_pair()
 		error("Expected identifier or string.");
 	}
 
-	conf_.set_value(section_, name, value);
+	conf_.set(section_, name, value);
 
 	t = get_next_token(value);
 	if(t != NEWLINE && t != FILE_END)
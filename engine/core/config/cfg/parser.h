@@ -1,6 +1,7 @@
 #ifndef CFG_PARSER_H
 #define CFG_PARSER_H
 
+#include <cstddef>
 #include <iostream>
 #include <string>
 
@@ -22,6 +23,16 @@ public:
 	 **/
 	void parse(std::istream& in_, const std::string& file_ = "", unsigned int line_ = 1);
 
+	/**
+	 * Parse a buffer in one pass.
+	 *
+	 * @param data the text to parse, not null terminated
+	 * @param size the size of the text
+	 * @param file the file that is parsed, for error purposes
+	 * @param line the initial line
+	 **/
+	void parse(const char* data, std::size_t size, const std::string& file_ = "", unsigned int line_ = 1);
+
 private:
 	enum Token
 	{
@@ -40,13 +51,17 @@ private:
 	};
 
 	config& conf_;
-	std::istream* in_;
+	const char* data_ = nullptr;
+	std::size_t size_ = 0;
+	std::size_t pos_ = 0;
 	std::string file_;
 	unsigned int line_;
 	Token next_token_;
 	std::string next_value_;
 	std::string section_;
 
+	int get();
+	void unget();
 	Token get_next_token(std::string& value);
 	Token lex_token(std::string& value);
 	Token lex_whitespace(std::string& value);
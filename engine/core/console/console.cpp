@@ -1,12 +1,17 @@
 #include "console.h"
+#include "../filesystem/mapped_file.h"
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <string>
 
+constexpr unsigned int console::max_script_depth;
+
 console::console()
 {
 	register_help_command();
+	register_exec_command();
 }
 
 console::~console()
@@ -43,58 +48,142 @@ void console::register_alias(const std::string& alias, const std::string& comman
  */
 std::string console::process_input(const std::string& line)
 {
-	print_buffer.str(std::string()); // clear()
-	std::vector<std::string> tokens = tokenize_line(line);
+	output_.clear();
+	process_line(line.data(), line.data() + line.size());
+	return output_;
+}
+
+std::string console::run_script(const fs::path& path)
+{
+	output_.clear();
+	run_script_lines(path);
+	return output_;
+}
+
+void console::run_script_lines(const fs::path& path)
+{
+	if(script_depth_ >= max_script_depth)
+	{
+		print("Scripts nested too deep.");
+		return;
+	}
 
-	if(tokens.empty())
+	fs::mapped_file file(path);
+	if(!file.is_open())
 	{
-		return "";
+		print("Could not open the script \"" + path.string() + "\".");
+		return;
 	}
 
-	std::string identifier = tokens.at(0);
+	++script_depth_;
+	const auto* it = reinterpret_cast<const char*>(file.data());
+	const auto* end = it + file.size();
+	while(it < end)
+	{
+		const auto* line_end = std::find(it, end, '\n');
+		const auto* next = line_end == end ? end : line_end + 1;
+		if(line_end > it && line_end[-1] == '\r')
+		{
+			--line_end;
+		}
+		while(it < line_end && (*it == ' ' || *it == '\t'))
+		{
+			++it;
+		}
 
-	tokens.erase(tokens.begin());
-	auto it = commands_.find(identifier);
+		if(it < line_end && *it != '#')
+		{
+			const auto output_size = output_.size();
+			process_line(it, line_end);
+			if(output_.size() != output_size && output_.back() != '\n')
+			{
+				output_ += '\n';
+			}
+		}
+		it = next;
+	}
+	--script_depth_;
+}
+
+/**
+ * @brief Runs a line, appending to the output
+ *
+ * The line is copied into a buffer kept from line to line and split in
+ * place, the tokens are views of it and the arguments are parsed from
+ * them, so a command of numbers runs without allocating.
+ */
+void console::process_line(const char* begin, const char* end)
+{
+	line_.assign(begin, end);
+	tokenize_line(line_, tokens_);
+
+	if(tokens_.empty())
+	{
+		return;
+	}
+
+	identifier_.assign(tokens_.front().data(), tokens_.front().size());
+	auto it = commands_.find(identifier_);
 	if(it != commands_.end())
 	{
-		it->second->call(tokens);
+		// the arguments are parsed before the command runs, it may run
+		// other lines
+		it->second->call(tokens_.data() + 1, tokens_.size() - 1);
 	}
 	else
 	{
 		// TODO: we might want a more flexible way to give feedback
-		print("Unknown command \"" + identifier + "\".");
+		print("Unknown command \"" + identifier_ + "\".");
 	}
-	return print_buffer.str();
 }
 
 /**
  * @brief Separate a string by spaces into words
  *
- * TODO:
- * - Find if there is a better way to tokenize a string.
+ * The words are unquoted and unescaped in place, each one is followed by a
+ * nul, the tokens are views of the line.
  */
-std::vector<std::string> console::tokenize_line(const std::string& line)
+void console::tokenize_line(std::string& line, std::vector<nonstd::string_view>& tokens)
 {
-	std::vector<std::string> out;
-	std::string currWord;
+	tokens.clear();
+	if(line.empty())
+	{
+		return;
+	}
+
+	// the unescaped words are written over the line, never ahead of the read
+	char* write = &line[0];
+	char* word = nullptr;
+	const auto put = [&](char c) {
+		if(word == nullptr)
+		{
+			word = write;
+		}
+		*write++ = c;
+	};
+	const auto finish_word = [&]() {
+		tokens.emplace_back(word, std::size_t(write - word));
+		*write++ = '\0';
+		word = nullptr;
+	};
+
 	bool insideQuotes = false;
 	bool escapingQuotes = false;
-	// TODO: and with auto?
 	// TODO: we might want to use getwc() to correctly read unicode characters
-	for(const auto& c : line)
+	for(std::size_t i = 0, size = line.size(); i < size; ++i)
 	{
+		const char c = line[i];
 		if(c == ' ' && !insideQuotes)
 		{
 			// keep spaces inside of quoted text
-			if(currWord.empty())
+			if(word == nullptr)
 			{
 				// ignore leading spaces
 				continue;
 			}
 
 			// finish off word
-			out.push_back(currWord);
-			currWord.clear();
+			finish_word();
 		}
 		else if(!escapingQuotes && c == '\\')
 		{
@@ -104,9 +193,9 @@ std::vector<std::string> console::tokenize_line(const std::string& line)
 		{
 			if(c != '"' && c != '\\')
 			{
-				currWord += '\\';
+				put('\\');
 			}
-			currWord += c;
+			put(c);
 			escapingQuotes = false;
 		}
 		else if(c == '"')
@@ -114,8 +203,11 @@ std::vector<std::string> console::tokenize_line(const std::string& line)
 			// finish off word or start quoted text
 			if(insideQuotes)
 			{
-				out.push_back(currWord);
-				currWord.clear();
+				if(word == nullptr)
+				{
+					word = write;
+				}
+				finish_word();
 				insideQuotes = false;
 			}
 			else
@@ -125,15 +217,15 @@ std::vector<std::string> console::tokenize_line(const std::string& line)
 		}
 		else
 		{
-			currWord += c;
+			put(c);
 		}
 	}
 	// add the last word
-	if(!currWord.empty())
+	if(word != nullptr)
 	{
-		out.push_back(currWord);
+		tokens.emplace_back(word, std::size_t(write - word));
+		*write = '\0';
 	}
-	return out;
 }
 
 void console::register_help_command()
@@ -142,6 +234,15 @@ void console::register_help_command()
 					 std::function<void(std::string)>([this](std::string term) { help_command(term); }));
 }
 
+void console::register_exec_command()
+{
+	std::function<void(std::string)> exec = [this](std::string file) {
+		const auto path = fs::has_known_protocol(file) ? fs::resolve_protocol(file) : fs::path(file);
+		run_script_lines(path);
+	};
+	register_command("exec", "Runs the commands of a script file, a command per line.", {"file"}, {}, exec);
+}
+
 /**
  * TODO:
  * - if the commands will ever be case insensitive, the filter should also be
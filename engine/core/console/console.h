@@ -3,13 +3,19 @@
 
 #include <cassert>
 
+#include "../common/nonstd/string_view.hpp"
 #include "../common/nonstd/type_index.hpp"
+#include "../filesystem/filesystem.h"
+#include <cerrno>
+#include <cstdlib>
 #include <functional>
 #include <memory>
 #include <set>
-#include <sstream>
 #include <string>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 class console
@@ -36,6 +42,15 @@ public:
 	void register_alias(const std::string& alias, const std::string& command);
 
 	std::string process_input(const std::string& line);
+
+	/**
+	 * @brief Runs the commands of a script file, a command per line.
+	 *
+	 * The file is mapped and read in place. Empty lines and the lines
+	 * starting with # are skipped. Returns the output of the commands.
+	 */
+	std::string run_script(const fs::path& path);
+
 	std::vector<std::string> list_of_commands(const std::string& filter = "");
 
 private:
@@ -46,7 +61,8 @@ private:
 		const unsigned int num_arguments;
 		const std::vector<std::string> argument_names;
 		const std::vector<std::string> default_arguments;
-		std::function<void(std::vector<std::string>&)> call;
+		/// parses the arguments into their types and calls the callback
+		std::function<void(const nonstd::string_view* arguments, std::size_t count)> call;
 		std::function<std::string(void)> get_usage;
 
 		explicit command(const std::string& name, const std::string& description, unsigned int numArguments,
@@ -69,19 +85,20 @@ private:
 	std::set<std::string> names_;
 	void register_help_command();
 	void help_command(const std::string& term);
+	void register_exec_command();
 
+	/**
+	 * Parses an argument into its type, the text is followed by a nul.
+	 */
 	template <typename T>
-	struct argumentConverter
-	{
-		static inline T convert(const std::string& s);
-	};
+	struct argument_parser;
+
+	template <typename Tuple, std::size_t... I>
+	static bool parse_arguments(Tuple& values, const nonstd::string_view* arguments, std::size_t first,
+								std::size_t count, std::index_sequence<I...>);
 
-	static inline std::function<void()> bind_callback(std::function<void()> callback,
-													  const std::vector<std::string>& arguments,
-													  int argumentIndex);
-	template <typename T, typename... Args>
-	static std::function<void()> bind_callback(std::function<void(T, Args...)> callback,
-											   const std::vector<std::string>& arguments, int argumentIndex);
+	template <typename Callback, typename Tuple, std::size_t... I>
+	static void invoke(const Callback& callback, Tuple& values, std::index_sequence<I...>);
 
 	template <typename... Args>
 	struct NameArguments
@@ -90,14 +107,27 @@ private:
 									  unsigned int requiredArguments);
 	};
 
-	std::stringstream print_buffer;
-	void print(const std::string& output)
+	/// the output of the commands run, its capacity is kept
+	std::string output_;
+	void print(nonstd::string_view output)
 	{
-		print_buffer << output; // << "\n";
+		output_.append(output.data(), output.size());
 	}
 
+	void process_line(const char* begin, const char* end);
+	void run_script_lines(const fs::path& path);
+
+	static constexpr unsigned int max_script_depth = 8;
+
+	/// the line being run and its tokens, their capacity is kept
+	std::string line_;
+	std::vector<nonstd::string_view> tokens_;
+	std::string identifier_;
+	/// the scripts being run, for a script to not run itself forever
+	unsigned int script_depth_ = 0;
+
 private:
-	static std::vector<std::string> tokenize_line(const std::string& line);
+	static void tokenize_line(std::string& line, std::vector<nonstd::string_view>& tokens);
 };
 
 template <typename... Args>
@@ -116,38 +146,40 @@ void console::register_command(const std::string& name, const std::string& descr
 										 argumentNames, defaultArguments);
 	auto commandRaw = cmd.get();
 
-	cmd->call = [this, commandRaw, callback, argCount](std::vector<std::string>& arguments) {
-
-		// add the arguments checks and set the default arguments
-		auto requiredArguments = argCount - commandRaw->default_arguments.size();
-
+	// the defaults are parsed once, into the last values
+	using values_t = std::tuple<typename std::decay<Args>::type...>;
+	const auto sequence = std::index_sequence_for<Args...>{};
+	const auto requiredArguments = argCount - defaultArguments.size();
+	std::vector<nonstd::string_view> defaults(std::begin(cmd->default_arguments),
+											  std::end(cmd->default_arguments));
+	values_t defaultValues;
+	const bool defaultsParsed =
+		parse_arguments(defaultValues, defaults.data(), requiredArguments, defaults.size(), sequence);
+	assert(defaultsParsed && "the default arguments do not parse into their types");
+	(void)defaultsParsed;
+
+	cmd->call = [this, commandRaw, callback, argCount, requiredArguments, defaultValues,
+				 sequence](const nonstd::string_view* arguments, std::size_t count) {
 		// make sure the number of arguments matches
-		if(arguments.size() < requiredArguments)
+		if(count < requiredArguments)
 		{
 			print("Too few arguments.");
 		}
-		else if(arguments.size() > argCount)
+		else if(count > argCount)
 		{
 			print("Too many arguments.");
 		}
 		else
 		{
-			// append default arguments as necessary
-			const auto offset = int(arguments.size() - requiredArguments);
-			arguments.insert(arguments.end(), commandRaw->default_arguments.begin() + offset,
-							 commandRaw->default_arguments.end());
-			assert(arguments.size() == argCount);
-
-			bool failed = false;
-			std::function<void()> boundCallback = bind_callback(callback, arguments, 0);
-
-			if(!failed)
+			// the missing arguments keep their default
+			values_t values = defaultValues;
+			if(parse_arguments(values, arguments, 0, count, sequence))
 			{
 				// actually execute the command
-				boundCallback();
-
+				invoke(callback, values, sequence);
 				return;
 			}
+			print("Invalid argument.");
 		}
 
 		// if we end up here, something went wrong
@@ -166,67 +198,80 @@ void console::register_command(const std::string& name, const std::string& descr
 }
 
 /**
- * bindCallback, base case
+ * Parses the arguments [first, first + count) of the values, the text of the
+ * value I is arguments[I - first]. Stops at the first that does not parse.
  */
-inline std::function<void()> console::bind_callback(std::function<void()> callback,
-													const std::vector<std::string>& /*unused*/,
-													int /*unused*/)
+template <typename Tuple, std::size_t... I>
+bool console::parse_arguments(Tuple& values, const nonstd::string_view* arguments, std::size_t first,
+							  std::size_t count, std::index_sequence<I...>)
 {
-	return callback;
+	bool parsed = true;
+	using expand = int[];
+	(void)expand{0, (parsed = parsed && (I < first || I >= first + count ||
+										 argument_parser<typename std::tuple_element<I, Tuple>::type>::parse(
+											 arguments[I - first], std::get<I>(values))),
+					 0)...};
+	return parsed;
 }
 
-/**
- * bindCallback, recursion step.
- *
- * Run the "bind" code for each argument.
- */
-template <typename T, typename... Args>
-std::function<void()> console::bind_callback(std::function<void(T, Args...)> callback,
-											 const std::vector<std::string>& arguments, int argumentIndex)
+template <typename Callback, typename Tuple, std::size_t... I>
+void console::invoke(const Callback& callback, Tuple& values, std::index_sequence<I...>)
 {
-	T value = argumentConverter<T>::convert(arguments.at(argumentIndex));
-	std::function<void(Args...)> nextCallback = [callback, value](Args... args) { callback(value, args...); };
-	return bind_callback(nextCallback, arguments, argumentIndex + 1);
+	callback(std::move(std::get<I>(values))...);
 }
 
 /**
- * default argument converter: fail if none of the specific converters
- * has been run
- */
-// template <typename T>
-// inline T console::argumentConverter<T>::convert(const std::string&)
-//{
-//	static_assert(false, "console commands may only take "
-//										  "arguments of type int, float or "
-//										  "std::string.");
-//}
-
-/**
- * convert arguments from string to int
+ * parse arguments to int
  */
 template <>
-inline int console::argumentConverter<int>::convert(const std::string& s)
+struct console::argument_parser<int>
 {
-	return std::stoi(s);
-}
+	static bool parse(nonstd::string_view s, int& value)
+	{
+		char* end = nullptr;
+		errno = 0;
+		const long parsed = std::strtol(s.data(), &end, 10);
+		if(s.empty() || end != s.end() || errno == ERANGE)
+		{
+			return false;
+		}
+		value = static_cast<int>(parsed);
+		return true;
+	}
+};
 
 /**
- * convert arguments from string to float
+ * parse arguments to float
  */
 template <>
-inline float console::argumentConverter<float>::convert(const std::string& s)
+struct console::argument_parser<float>
 {
-	return std::stof(s);
-}
+	static bool parse(nonstd::string_view s, float& value)
+	{
+		char* end = nullptr;
+		errno = 0;
+		const float parsed = std::strtof(s.data(), &end);
+		if(s.empty() || end != s.end() || errno == ERANGE)
+		{
+			return false;
+		}
+		value = parsed;
+		return true;
+	}
+};
 
 /**
- *  (dummy)convert arguments from string to string
+ * the arguments are strings already
  */
 template <>
-inline std::string console::argumentConverter<std::string>::convert(const std::string& s)
+struct console::argument_parser<std::string>
 {
-	return s;
-}
+	static bool parse(nonstd::string_view s, std::string& value)
+	{
+		value.assign(s.data(), s.size());
+		return true;
+	}
+};
 
 /**
  * Return the list of the arguments of a command pretty printed. Base case.
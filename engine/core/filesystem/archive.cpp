@@ -0,0 +1,354 @@
+#include "archive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+
+namespace fs
+{
+namespace
+{
+struct mount
+{
+	std::string mount_point;
+	std::shared_ptr<const archive> pack;
+};
+
+std::mutex& get_mounts_mutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
+std::vector<mount>& get_mounts()
+{
+	static std::vector<mount> mounts;
+	return mounts;
+}
+
+/// the bytes mounted by path, ordered so a directory is unmounted at once
+std::map<std::string, mapped_range>& get_memory_mounts()
+{
+	static std::map<std::string, mapped_range> mounts;
+	return mounts;
+}
+
+std::string to_mount_point(const std::string& str)
+{
+	auto result = path(str).generic_string();
+	if(!result.empty() && result.back() != '/')
+	{
+		result += '/';
+	}
+	return result;
+}
+
+bool write_padding(std::ofstream& stream, std::uint64_t& offset)
+{
+	static const char zeros[archive::alignment] = {};
+	const auto padding = (archive::alignment - offset % archive::alignment) % archive::alignment;
+	stream.write(zeros, std::streamsize(padding));
+	offset += padding;
+	return bool(stream);
+}
+}
+
+constexpr std::uint32_t archive::magic;
+constexpr std::uint32_t archive::version;
+constexpr std::uint64_t archive::alignment;
+
+std::uint64_t archive::hash(const std::string& key)
+{
+	std::uint64_t result = 0xcbf29ce484222325ull;
+	for(auto c : key)
+	{
+		result ^= std::uint8_t(c);
+		result *= 0x100000001b3ull;
+	}
+	return result;
+}
+
+archive::archive(const path& file_path)
+	: file_(std::make_shared<mapped_file>(file_path))
+{
+	if(!file_->is_open() || file_->size() < sizeof(header))
+	{
+		return;
+	}
+
+	const auto data = file_->data();
+	const auto size = std::uint64_t(file_->size());
+	header h;
+	std::memcpy(&h, data, sizeof(header));
+	if(h.magic != magic || h.version != version)
+	{
+		return;
+	}
+
+	const auto entries_size = std::uint64_t(h.entries_count) * sizeof(entry);
+	if(h.entries_offset % alignof(entry) != 0 || h.entries_offset > size ||
+	   entries_size > size - h.entries_offset || h.keys_offset > size || h.keys_size > size - h.keys_offset)
+	{
+		return;
+	}
+
+	auto entries = reinterpret_cast<const entry*>(data + h.entries_offset);
+	for(std::uint32_t i = 0; i < h.entries_count; ++i)
+	{
+		const auto& e = entries[i];
+		if(e.offset > size || e.stored_size > size - e.offset ||
+		   std::uint64_t(e.key_offset) + e.key_size > h.keys_size)
+		{
+			return;
+		}
+	}
+
+	entries_ = entries;
+	entries_count_ = h.entries_count;
+	keys_ = reinterpret_cast<const char*>(data + h.keys_offset);
+}
+
+const archive::entry* archive::find(const std::string& key) const
+{
+	const auto key_hash = hash(key);
+	const auto end = entries_ + entries_count_;
+	auto it = std::lower_bound(entries_, end, key_hash,
+							   [](const entry& e, std::uint64_t value) { return e.hash < value; });
+	for(; it != end && it->hash == key_hash; ++it)
+	{
+		if(key.compare(0, std::string::npos, keys_ + it->key_offset, it->key_size) == 0)
+		{
+			return it;
+		}
+	}
+	return nullptr;
+}
+
+mapped_range archive::get_data(const entry& e) const
+{
+	mapped_range result;
+	if(e.compressed != compression::none)
+	{
+		return result;
+	}
+
+	result.owner = file_;
+	result.data = file_->data() + e.offset;
+	result.size = std::size_t(e.size);
+	return result;
+}
+
+void archive_writer::add_file(const std::string& key, const path& file_path)
+{
+	files_.push_back({key, file_path});
+}
+
+bool archive_writer::write(const path& file_path, std::string& err) const
+{
+	struct pending
+	{
+		archive::entry e;
+		const file_info* info = nullptr;
+	};
+
+	std::vector<pending> pendings;
+	pendings.reserve(files_.size());
+	std::string keys;
+	for(const auto& info : files_)
+	{
+		if(info.key.size() > 0xffff)
+		{
+			err = "The key " + info.key + " is too long.";
+			return false;
+		}
+
+		fs::error_code ec;
+		const auto file_size = fs::file_size(info.file_path, ec);
+		if(ec)
+		{
+			err = "Could not read " + info.file_path.string() + ".";
+			return false;
+		}
+
+		pending p;
+		p.e.hash = archive::hash(info.key);
+		p.e.stored_size = file_size;
+		p.e.size = file_size;
+		p.e.key_offset = std::uint32_t(keys.size());
+		p.e.key_size = std::uint16_t(info.key.size());
+		p.info = &info;
+		pendings.push_back(p);
+		keys += info.key;
+	}
+
+	std::sort(std::begin(pendings), std::end(pendings),
+			  [](const pending& a, const pending& b) { return a.e.hash < b.e.hash; });
+	for(std::size_t i = 1; i < pendings.size(); ++i)
+	{
+		if(pendings[i - 1].e.hash == pendings[i].e.hash)
+		{
+			err = "The keys " + pendings[i - 1].info->key + " and " + pendings[i].info->key +
+				  " have the same hash.";
+			return false;
+		}
+	}
+
+	archive::header h;
+	h.magic = archive::magic;
+	h.version = archive::version;
+	h.entries_count = std::uint32_t(pendings.size());
+	h.keys_size = std::uint32_t(keys.size());
+	h.entries_offset = sizeof(archive::header);
+	h.keys_offset = h.entries_offset + pendings.size() * sizeof(archive::entry);
+
+	// the data goes after the index, every entry on a boundary
+	auto offset = h.keys_offset + keys.size();
+	for(auto& p : pendings)
+	{
+		offset += (archive::alignment - offset % archive::alignment) % archive::alignment;
+		p.e.offset = offset;
+		offset += p.e.stored_size;
+	}
+
+	std::ofstream stream{file_path.string(), std::ios::out | std::ios::binary | std::ios::trunc};
+	stream.write(reinterpret_cast<const char*>(&h), sizeof(h));
+	for(const auto& p : pendings)
+	{
+		stream.write(reinterpret_cast<const char*>(&p.e), sizeof(p.e));
+	}
+	stream.write(keys.data(), std::streamsize(keys.size()));
+
+	offset = h.keys_offset + keys.size();
+	for(const auto& p : pendings)
+	{
+		if(!write_padding(stream, offset))
+		{
+			break;
+		}
+
+		if(p.e.size > 0)
+		{
+			mapped_file file(p.info->file_path);
+			if(!file.is_open() || file.size() != p.e.size)
+			{
+				err = "Could not read " + p.info->file_path.string() + ".";
+				return false;
+			}
+			stream.write(reinterpret_cast<const char*>(file.data()), std::streamsize(file.size()));
+		}
+		offset += p.e.stored_size;
+	}
+
+	if(!stream)
+	{
+		err = "Could not write " + file_path.string() + ".";
+		return false;
+	}
+	return true;
+}
+
+bool mount_archive(const std::string& mount_point, const path& archive_path)
+{
+	auto pack = std::make_shared<archive>(archive_path);
+	if(!pack->is_open())
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(get_mounts_mutex());
+	get_mounts().push_back({to_mount_point(mount_point), std::move(pack)});
+	return true;
+}
+
+void unmount_archives()
+{
+	std::lock_guard<std::mutex> lock(get_mounts_mutex());
+	get_mounts().clear();
+}
+
+mapped_range find_mounted(const path& key)
+{
+	const auto key_string = key.generic_string();
+
+	std::lock_guard<std::mutex> lock(get_mounts_mutex());
+	const auto& memory = get_memory_mounts();
+	const auto in_memory = memory.find(key_string);
+	if(in_memory != std::end(memory))
+	{
+		return in_memory->second;
+	}
+
+	const auto& mounts = get_mounts();
+	for(auto it = mounts.rbegin(); it != mounts.rend(); ++it)
+	{
+		const auto& mount_point = it->mount_point;
+		if(key_string.compare(0, mount_point.size(), mount_point) != 0)
+		{
+			continue;
+		}
+
+		const auto e = it->pack->find(key_string.substr(mount_point.size()));
+		if(e)
+		{
+			return it->pack->get_data(*e);
+		}
+	}
+	return {};
+}
+
+bool exists_mounted(const path& key)
+{
+	return bool(find_mounted(key));
+}
+
+mapped_range make_memory_range(std::vector<std::uint8_t> buffer)
+{
+	auto owner = std::make_shared<std::vector<std::uint8_t>>(std::move(buffer));
+	mapped_range result;
+	result.data = owner->data();
+	result.size = owner->size();
+	result.owner = std::move(owner);
+	return result;
+}
+
+mapped_range make_memory_range(const std::uint8_t* data, std::size_t size, std::function<void()> release)
+{
+	mapped_range result;
+	result.data = data;
+	result.size = size;
+	// the deleter is the release, there is nothing to delete
+	result.owner = std::shared_ptr<const void>(data, [release = std::move(release)](const void*) {
+		if(release)
+		{
+			release();
+		}
+	});
+	return result;
+}
+
+void mount_memory(const path& key, mapped_range data)
+{
+	std::lock_guard<std::mutex> lock(get_mounts_mutex());
+	get_memory_mounts()[key.generic_string()] = std::move(data);
+}
+
+void unmount_memory(const std::string& prefix)
+{
+	const auto key_prefix = path(prefix).generic_string();
+
+	// the ranges are released outside the lock, a release may take long
+	std::vector<mapped_range> released;
+	{
+		std::lock_guard<std::mutex> lock(get_mounts_mutex());
+		auto& memory = get_memory_mounts();
+		auto it = memory.lower_bound(key_prefix);
+		while(it != std::end(memory) && it->first.compare(0, key_prefix.size(), key_prefix) == 0)
+		{
+			released.push_back(std::move(it->second));
+			it = memory.erase(it);
+		}
+	}
+}
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include "filesystem.h"
+#include "mapped_file.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fs
+{
+/*
+ * mapped_range; bytes in place in a mapping, of a loose file or of an entry
+ * of an archive, or in a buffer in memory, keeping what holds them alive
+ * while it is held.
+ */
+struct mapped_range
+{
+	explicit operator bool() const
+	{
+		return data != nullptr;
+	}
+
+	/// the mapped file or the buffer
+	std::shared_ptr<const void> owner;
+	const std::uint8_t* data = nullptr;
+	std::size_t size = 0;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : make_memory_range ()
+/// <summary>
+/// A range over the whole buffer, which it takes and frees with its last
+/// copy.
+/// </summary>
+//-----------------------------------------------------------------------------
+mapped_range make_memory_range(std::vector<std::uint8_t> buffer);
+
+//-----------------------------------------------------------------------------
+//  Name : make_memory_range ()
+/// <summary>
+/// A range over bytes held elsewhere, the release is called once the last
+/// copy of the range is gone.
+/// </summary>
+//-----------------------------------------------------------------------------
+mapped_range make_memory_range(const std::uint8_t* data, std::size_t size, std::function<void()> release);
+
+/*
+ * archive; a pack of files mapped whole, read in place by their key.
+ *
+ *      The file is a header, the index of the entries sorted by the hash of
+ *      their key, the keys, and then the data of every entry aligned to
+ *      4096 bytes, so an entry starts on a page and a sector of its own. The
+ *      keys are kept to tell apart keys of the same hash. The integers are
+ *      little endian.
+ */
+class archive
+{
+public:
+	enum class compression : std::uint8_t
+	{
+		/// the field is there so compressed entries can be added without
+		/// changing the version
+		none
+	};
+
+	struct header
+	{
+		std::uint32_t magic = 0;
+		std::uint32_t version = 0;
+		std::uint32_t entries_count = 0;
+		std::uint32_t keys_size = 0;
+		std::uint64_t entries_offset = 0;
+		std::uint64_t keys_offset = 0;
+	};
+
+	struct entry
+	{
+		std::uint64_t hash = 0;
+		std::uint64_t offset = 0;
+		/// size in the archive and once read, they differ when compressed
+		std::uint64_t stored_size = 0;
+		std::uint64_t size = 0;
+		std::uint32_t key_offset = 0;
+		std::uint16_t key_size = 0;
+		compression compressed = compression::none;
+		std::uint8_t reserved = 0;
+	};
+
+	static constexpr std::uint32_t magic = 0x4b415045; // EPAK
+	static constexpr std::uint32_t version = 1;
+	static constexpr std::uint64_t alignment = 4096;
+
+	//-----------------------------------------------------------------------------
+	//  Name : hash ()
+	/// <summary>
+	/// The hash of a key in the index, fnv-1a of its bytes.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static std::uint64_t hash(const std::string& key);
+
+	//-----------------------------------------------------------------------------
+	//  Name : archive ()
+	/// <summary>
+	/// Maps the archive and checks its header and index, check is_open for
+	/// whether it is one.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	explicit archive(const path& file_path);
+
+	bool is_open() const
+	{
+		return entries_ != nullptr;
+	}
+
+	std::size_t get_entries_count() const
+	{
+		return entries_count_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : find ()
+	/// <summary>
+	/// The entry of the key, null if the archive does not have it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const entry* find(const std::string& key) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_data ()
+	/// <summary>
+	/// The data of an entry in place, empty for a compression it can not read.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	mapped_range get_data(const entry& e) const;
+
+private:
+	std::shared_ptr<mapped_file> file_;
+	const entry* entries_ = nullptr;
+	std::size_t entries_count_ = 0;
+	const char* keys_ = nullptr;
+};
+
+/*
+ * archive_writer; gathers files by key and writes them into an archive.
+ */
+class archive_writer
+{
+public:
+	void add_file(const std::string& key, const path& file_path);
+
+	//-----------------------------------------------------------------------------
+	//  Name : write ()
+	/// <summary>
+	/// Writes the added files to an archive, false with the reason when a
+	/// file could not be read or two keys have the same hash.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool write(const path& file_path, std::string& err) const;
+
+	std::size_t get_files_count() const
+	{
+		return files_.size();
+	}
+
+private:
+	struct file_info
+	{
+		std::string key;
+		path file_path;
+	};
+
+	std::vector<file_info> files_;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : mount_archive ()
+/// <summary>
+/// Mounts an archive over a protocol directory i.e. "app:/cache", its keys
+/// are the paths relative to it. Mounted later is looked in first.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool mount_archive(const std::string& mount_point, const path& archive_path);
+
+//-----------------------------------------------------------------------------
+//  Name : unmount_archives ()
+/// <summary>
+/// Unmounts every archive, the data still held stays mapped until released.
+/// </summary>
+//-----------------------------------------------------------------------------
+void unmount_archives();
+
+//-----------------------------------------------------------------------------
+//  Name : find_mounted ()
+/// <summary>
+/// The data of a protocol path i.e. "app:/cache/textures/a.png.asset" in
+/// the mounted archives, empty if none has it. Safe to call from any thread.
+/// </summary>
+//-----------------------------------------------------------------------------
+mapped_range find_mounted(const path& key);
+
+//-----------------------------------------------------------------------------
+//  Name : mount_memory ()
+/// <summary>
+/// Mounts the bytes of a single protocol path, found before the archives
+/// and in place of the file until unmounted. The range is held meanwhile.
+/// </summary>
+//-----------------------------------------------------------------------------
+void mount_memory(const path& key, mapped_range data);
+
+//-----------------------------------------------------------------------------
+//  Name : unmount_memory ()
+/// <summary>
+/// Unmounts the bytes mounted under the protocol directory or path.
+/// </summary>
+//-----------------------------------------------------------------------------
+void unmount_memory(const std::string& prefix);
+
+bool exists_mounted(const path& key);
+}
@@ -23,10 +23,10 @@ bool begins_with(const std::string& str, const std::string& value)
 
 	return s1.compare(value) == 0;
 }
-static std::string replace_seq(const std::string& str, const std::string& old_sequence,
+// the string is taken by value, the temporary of path::string() is moved in
+static std::string replace_seq(std::string s, const std::string& old_sequence,
 							   const std::string& new_sequence)
 {
-	std::string s = str;
 	std::string::size_type location = 0;
 	std::string::size_type old_length = old_sequence.length();
 	std::string::size_type new_length = new_sequence.length();
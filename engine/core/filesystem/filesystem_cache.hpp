@@ -1,7 +1,9 @@
 #pragma once
 
 #include "filesystem_watcher.h"
+#include <algorithm>
 #include <chrono>
+#include <mutex>
 #include <type_traits>
 #include <vector>
 
@@ -30,9 +32,11 @@ public:
 	}
 
 	cache(const cache& rhs)
-		: path_(rhs.path)
+		: path_(rhs.path_)
 		, scan_frequency_(rhs.scan_frequency_)
 		, entries_(rhs.entries_)
+		, changes_(rhs.get_changes())
+		, has_changes_(rhs.has_changes_.load())
 		, should_refresh_(rhs.should_refresh_.load())
 	{
 		watch();
@@ -42,6 +46,8 @@ public:
 		: path_(std::move(rhs.path_))
 		, scan_frequency_(std::move(rhs.scan_frequency_))
 		, entries_(std::move(rhs.entries_))
+		, changes_(rhs.get_changes())
+		, has_changes_(rhs.has_changes_.load())
 		, should_refresh_(rhs.should_refresh_.load())
 	{
 		watch();
@@ -53,6 +59,7 @@ public:
 		path_ = rhs.path_;
 		scan_frequency_ = rhs.scan_frequency_;
 		entries_ = rhs.entries_;
+		set_changes(rhs.get_changes());
 		should_refresh_ = rhs.should_refresh_.load();
 		watch();
 
@@ -65,6 +72,7 @@ public:
 		path_ = std::move(rhs.path_);
 		scan_frequency_ = std::move(rhs.scan_frequency_);
 		entries_ = std::move(rhs.entries_);
+		set_changes(rhs.get_changes());
 		should_refresh_ = rhs.should_refresh_.load();
 		watch();
 
@@ -84,10 +92,7 @@ public:
 	//-----------------------------------------------------------------------------
 	decltype(auto) begin() const
 	{
-		if(should_refresh())
-		{
-			refresh();
-		}
+		update();
 		return entries_.begin();
 	}
 
@@ -110,10 +115,7 @@ public:
 	//-----------------------------------------------------------------------------
 	decltype(auto) size() const
 	{
-		if(should_refresh())
-		{
-			refresh();
-		}
+		update();
 		return entries_.size();
 	}
 
@@ -135,39 +137,26 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : refresh ()
 	/// <summary>
-	/// Refreshes the cache and updates the timestamp of the last refresh.
-	/// This operation is slow so try to not call it often. By default it is called
-	/// only if iterated and marked by the dir watcher
-	/// since its last refresh.
+	/// Lists the whole directory again. This operation is slow so try to not
+	/// call it often. By default it is called only when the path changes, the
+	/// changes the dir watcher reports after are applied one by one.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void refresh() const
 	{
+		// what changed before the listing is in it
+		get_changes(true);
 		entries_.clear();
 
 		fs::error_code err;
 		iterator_t it(path_, err);
 		for(const auto& p : it)
 		{
-			entries_.emplace_back();
-			auto& cache_entry = entries_.back();
-			cache_entry.entry = p;
-			const auto& absolute_path = cache_entry.entry.path();
-            auto filename = absolute_path.filename();
-			cache_entry.protocol_path = fs::convert_to_protocol(absolute_path).generic_string();
-            cache_entry.filename = absolute_path.filename().string();
-			cache_entry.extension = filename.extension().string();
-			cache_entry.stem = filename.string();
-
-			while(filename.has_extension())
-			{
-				filename = filename.stem();
-				cache_entry.stem = filename.string();
-			}
+			entries_.emplace_back(p);
 		}
 
 		std::sort(std::begin(entries_), std::end(entries_), [](const auto& lhs, const auto& rhs) {
-			return fs::is_directory(lhs.entry.status()) > fs::is_directory(rhs.entry.status());
+			return cache_entry::less(lhs, rhs.is_directory, rhs.filename, rhs.entry.path());
 		});
 
 		should_refresh_ = false;
@@ -203,13 +192,76 @@ public:
 	}
 
 
+	/*
+	 * cache_entry; an entry of the directory, the strings shown for it are
+	 * derived the first time they are asked for.
+	 */
 	struct cache_entry
 	{
+		cache_entry() = default;
+		explicit cache_entry(const directory_entry& e)
+			: entry(e)
+			, filename(e.path().filename().string())
+			, is_directory(fs::is_directory(e.status()))
+		{
+		}
+
+		const std::string& stem() const
+		{
+			derive();
+			return stem_;
+		}
+
+		const std::string& extension() const
+		{
+			derive();
+			return extension_;
+		}
+
+		const std::string& protocol_path() const
+		{
+			derive();
+			return protocol_path_;
+		}
+
+		/// the directories first, then by name and path
+		static bool less(const cache_entry& lhs, bool is_dir, const std::string& name, const fs::path& path)
+		{
+			if(lhs.is_directory != is_dir)
+			{
+				return lhs.is_directory;
+			}
+			const int compare = lhs.filename.compare(name);
+			return compare != 0 ? compare < 0 : lhs.entry.path() < path;
+		}
+
 		directory_entry entry;
-        std::string filename;
-        std::string stem;
-        std::string extension;
-        std::string protocol_path;
+		std::string filename;
+		bool is_directory = false;
+
+	private:
+		void derive() const
+		{
+			if(derived_)
+			{
+				return;
+			}
+
+			auto name = entry.path().filename();
+			protocol_path_ = fs::convert_to_protocol(entry.path()).generic_string();
+			extension_ = name.extension().string();
+			while(name.has_extension())
+			{
+				name = name.stem();
+			}
+			stem_ = name.string();
+			derived_ = true;
+		}
+
+		mutable bool derived_ = false;
+		mutable std::string stem_;
+		mutable std::string extension_;
+		mutable std::string protocol_path_;
 	};
 
 private:
@@ -224,13 +276,128 @@ private:
 		return should_refresh_;
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : update ()
+	/// <summary>
+	/// Lists the directory when never listed, otherwise applies the changes
+	/// the watcher reported since the last update.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void update() const
+	{
+		if(should_refresh())
+		{
+			refresh();
+			return;
+		}
+
+		if(!has_changes_)
+		{
+			return;
+		}
+
+		for(const auto& change : get_changes(true))
+		{
+			switch(change.status)
+			{
+				case watcher::entry_status::created:
+				case watcher::entry_status::modified:
+					insert(change.path);
+					break;
+				case watcher::entry_status::removed:
+					erase(change.path, change.type == fs::file_type::directory);
+					break;
+				case watcher::entry_status::renamed:
+					erase(change.last_path, change.type == fs::file_type::directory);
+					insert(change.path);
+					break;
+				default:
+					break;
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : find ()
+	/// <summary>
+	/// Returns where the entry is or would be in the sorted entries.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	typename std::vector<cache_entry>::iterator find(const fs::path& path, bool is_dir,
+													 const std::string& filename) const
+	{
+		return std::lower_bound(std::begin(entries_), std::end(entries_), path,
+								[is_dir, &filename](const cache_entry& lhs, const fs::path& rhs) {
+									return cache_entry::less(lhs, is_dir, filename, rhs);
+								});
+	}
+
+	/// adds the entry or replaces it when already listed
+	void insert(const fs::path& path) const
+	{
+		fs::error_code err;
+		directory_entry e(path, err);
+		if(err)
+		{
+			return;
+		}
+
+		cache_entry added(e);
+		auto it = find(path, added.is_directory, added.filename);
+		if(it != std::end(entries_) && it->entry.path() == path)
+		{
+			*it = std::move(added);
+		}
+		else
+		{
+			entries_.insert(it, std::move(added));
+		}
+	}
+
+	void erase(const fs::path& path, bool is_dir) const
+	{
+		auto it = find(path, is_dir, path.filename().string());
+		if(it != std::end(entries_) && it->entry.path() == path)
+		{
+			entries_.erase(it);
+		}
+	}
+
+	std::vector<watcher::entry> get_changes(bool clear = false) const
+	{
+		std::lock_guard<std::mutex> lock(changes_mutex_);
+		std::vector<watcher::entry> changes;
+		if(clear)
+		{
+			changes.swap(changes_);
+			has_changes_ = false;
+		}
+		else
+		{
+			changes = changes_;
+		}
+		return changes;
+	}
+
+	void set_changes(std::vector<watcher::entry> changes)
+	{
+		std::lock_guard<std::mutex> lock(changes_mutex_);
+		changes_ = std::move(changes);
+		has_changes_ = !changes_.empty();
+	}
+
 	void watch()
 	{
 		using namespace std::literals;
 		constexpr bool is_recursive = std::is_same<iterator_t, recursive_directory_iterator>::value;
 
 		watch_id_ = watcher::watch(path_ / "*", is_recursive, false, scan_frequency_,
-								   [this](const auto&, bool) { should_refresh_ = true; });
+								   [this](const auto& entries, bool) {
+									   std::lock_guard<std::mutex> lock(changes_mutex_);
+									   changes_.insert(std::end(changes_), std::begin(entries),
+													   std::end(entries));
+									   has_changes_ = true;
+								   });
 	}
 	void unwatch()
 	{
@@ -243,6 +410,12 @@ private:
 	clock_t::duration scan_frequency_ = std::chrono::milliseconds(500);
 	///
 	mutable std::vector<cache_entry> entries_;
+	/// the changes reported by the watcher and not applied yet
+	mutable std::vector<watcher::entry> changes_;
+	///
+	mutable std::mutex changes_mutex_;
+	///
+	mutable std::atomic_bool has_changes_ = {false};
 	///
 	mutable std::atomic_bool should_refresh_ = {true};
 	///
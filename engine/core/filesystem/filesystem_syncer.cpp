@@ -1,6 +1,9 @@
 #include "filesystem_syncer.h"
 #include "filesystem_watcher.h"
 
+#include <algorithm>
+#include <unordered_set>
+
 namespace fs
 {
 static void ensure_directory_exists(const fs::path& path)
@@ -16,6 +19,18 @@ static void ensure_directory_exists(const fs::path& path)
 	}
 }
 
+static std::string get_full_extension(const fs::path& path)
+{
+	auto entry_path = path;
+	std::string entry_extension;
+	while(entry_path.has_extension())
+	{
+		entry_extension = entry_path.extension().string() + entry_extension;
+		entry_path.replace_extension();
+	}
+	return entry_extension;
+}
+
 syncer::~syncer()
 {
 	unsync();
@@ -49,6 +64,12 @@ void syncer::set_directory_mapping(syncer::on_entry_created_t on_entry_created,
 	mapping.on_entry_renamed = std::move(on_entry_renamed);
 }
 
+void syncer::set_debounce(std::chrono::steady_clock::duration debounce)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	debounce_ = debounce;
+}
+
 void syncer::unsync()
 {
 	fs::watcher::unwatch(watch_id_);
@@ -101,16 +122,16 @@ void syncer::sync(const fs::path& reference_dir, const fs::path& synced_dir)
 	}
 
 	const auto on_change = [this](const auto& entries, bool is_initial_listing) {
+		if(is_initial_listing)
+		{
+			this->on_initial_listing(entries);
+			return;
+		}
+
 		for(const auto& entry : entries)
 		{
 			bool is_directory = (entry.type == fs::file_type::directory);
-			auto entry_path = entry.path;
-			std::string entry_extension;
-			while(entry_path.has_extension())
-			{
-				entry_extension = entry_path.extension().string() + entry_extension;
-				entry_path.replace_extension();
-			}
+			const auto entry_extension = get_full_extension(entry.path);
 			switch(entry.status)
 			{
 				case fs::watcher::entry_status::created:
@@ -181,7 +202,85 @@ void syncer::sync(const fs::path& reference_dir, const fs::path& synced_dir)
 	};
 	using namespace std::literals;
 	const fs::path watch_dir = get_watch_path();
-	watch_id_ = fs::watcher::watch(watch_dir, true, true, 500ms, on_change);
+	std::chrono::steady_clock::duration debounce;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		debounce = debounce_;
+	}
+	watch_id_ = fs::watcher::watch(watch_dir, true, true, 500ms, debounce, on_change);
+}
+
+void syncer::on_initial_listing(const std::vector<watcher::entry>& entries)
+{
+	std::vector<std::pair<std::string, std::size_t>> order;
+	order.reserve(entries.size());
+	for(std::size_t i = 0; i < entries.size(); ++i)
+	{
+		order.emplace_back(get_full_extension(entries[i].path), i);
+	}
+	// in the order they were listed within an extension
+	std::stable_sort(std::begin(order), std::end(order),
+					 [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+	fs::path reference_dir;
+	fs::path synced_dir;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		reference_dir = reference_dir_;
+		synced_dir = synced_dir_;
+	}
+
+	std::unordered_set<std::string> made_directories;
+	std::vector<fs::path> synced_entries;
+	auto first = std::begin(order);
+	while(first != std::end(order))
+	{
+		const auto last = std::find_if(first, std::end(order),
+									   [&first](const auto& e) { return e.first != first->first; });
+		const auto mapping = get_mapping(first->first);
+
+		for(auto it = first; it != last; ++it)
+		{
+			const auto& entry = entries[it->second];
+			const bool is_directory = (entry.type == fs::file_type::directory);
+			// the type is known, the entry is not looked at again
+			auto synced_directory = fs::replace(entry.path, reference_dir, synced_dir);
+			if(!is_directory && entry.path.has_extension())
+			{
+				synced_directory = synced_directory.parent_path();
+			}
+
+			synced_entries.clear();
+			if(is_directory)
+			{
+				synced_entries.emplace_back(synced_directory);
+			}
+			else
+			{
+				for(const auto& synced_ext : mapping.extensions)
+				{
+					fs::path file = synced_directory / entry.path.filename();
+					file.concat(synced_ext);
+					synced_entries.emplace_back(std::move(file));
+				}
+			}
+
+			for(const auto& synced_entry : synced_entries)
+			{
+				const auto& dir = synced_entry.has_extension() ? synced_entry.parent_path() : synced_entry;
+				if(made_directories.insert(dir.string()).second)
+				{
+					ensure_directory_exists(synced_entry);
+				}
+			}
+
+			if(mapping.on_entry_created)
+			{
+				mapping.on_entry_created(entry.path, synced_entries, true);
+			}
+		}
+		first = last;
+	}
 }
 
 std::vector<fs::path> syncer::get_synced_entries(const fs::path& path, bool is_directory)
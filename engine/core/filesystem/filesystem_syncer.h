@@ -1,7 +1,9 @@
 #pragma once
 
 #include "filesystem.h"
+#include "filesystem_watcher.h"
 #include <atomic>
+#include <chrono>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -49,6 +51,15 @@ public:
 	void set_directory_mapping(on_entry_created_t on_entry_created, on_entry_modified_t on_entry_modified,
 							   on_entry_removed_t on_entry_removed, on_entry_renamed_t on_entry_renamed);
 
+	//-----------------------------------------------------------------------------
+	//  Name : set_debounce ()
+	/// <summary>
+	/// Sets how long an entry must not change before it is reported, so that a
+	/// file saved in parts is reported once. Applies from the next sync.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_debounce(std::chrono::steady_clock::duration debounce);
+
 	//-----------------------------------------------------------------------------
 	//  Name : sync ()
 	/// <summary>
@@ -73,6 +84,16 @@ private:
 	on_entry_modified_t get_on_modified_callback(const std::string& ext);
 	on_entry_removed_t get_on_removed_callback(const std::string& ext);
 	on_entry_renamed_t get_on_renamed_callback(const std::string& ext);
+
+	//-----------------------------------------------------------------------------
+	//  Name : on_initial_listing ()
+	/// <summary>
+	/// Reports the entries found when the sync starts, all of them created.
+	/// They are taken by extension, the mapping of each is looked up once and
+	/// each synced directory is made once.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void on_initial_listing(const std::vector<watcher::entry>& entries);
 	//-----------------------------------------------------------------------------
 	//  Name : get_synced_directory ()
 	/// <summary>
@@ -105,6 +126,8 @@ private:
 	fs::path reference_dir_;
 	/// Directory to be synced with the reference one.
 	fs::path synced_dir_;
+	/// How long an entry must not change before it is reported.
+	std::chrono::steady_clock::duration debounce_ = std::chrono::steady_clock::duration(0);
 
 	std::atomic<std::uint64_t> watch_id_ = {0};
 };
@@ -1,6 +1,16 @@
+#include <list>
+#include <set>
 #include <utility>
 
+#include "../common/platform/config.hpp"
 #include "filesystem_watcher.h"
+
+#if ETH_ON(ETH_PLATFORM_LINUX)
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
 namespace fs
 {
 using namespace std::literals;
@@ -30,6 +40,13 @@ static std::pair<path, std::string> get_path_filter_pair(const fs::path& path)
 	return std::make_pair(p, filter);
 }
 
+// whether a path matches the part before and after the wild card
+static bool matches_wild_card(const std::string& current, const std::string& before, const std::string& after)
+{
+	return (current.find(before) != std::string::npos || before.empty()) &&
+		   (current.find(after) != std::string::npos || after.empty());
+}
+
 static std::pair<path, std::string> visit_wild_card_path(const fs::path& path, bool recursive,
 														 bool visit_empty,
 														 const std::function<bool(const fs::path&)>& visitor)
@@ -52,11 +69,7 @@ static std::pair<path, std::string> visit_wild_card_path(const fs::path& path, b
 			const auto iterate = [&](auto& it) {
 				for(const auto& entry : it)
 				{
-					std::string current = entry.path().string();
-					size_t before_pos = current.find(before);
-					size_t after_pos = current.find(after);
-					if((before_pos != std::string::npos || before.empty()) &&
-					   (after_pos != std::string::npos || after.empty()))
+					if(matches_wild_card(entry.path().string(), before, after))
 					{
 						if(visitor(entry.path()))
 						{
@@ -81,6 +94,222 @@ static std::pair<path, std::string> visit_wild_card_path(const fs::path& path, b
 	return path_filter;
 }
 
+//-----------------------------------------------------------------------------
+//  Name : native_notifier (Class)
+/// <summary>
+/// The changes under a directory as the system reports them, with inotify on
+/// linux. Elsewhere it is never open and the watch keeps polling.
+/// </summary>
+//-----------------------------------------------------------------------------
+class native_notifier
+{
+public:
+	struct changes
+	{
+		/// paths changed, created or removed, a directory stands for what
+		/// it had as well
+		std::set<std::string> paths;
+		/// the system dropped changes, everything has to be polled
+		bool overflow = false;
+	};
+
+#if ETH_ON(ETH_PLATFORM_LINUX)
+	native_notifier(const fs::path& root, bool recursive)
+		: recursive_(recursive)
+	{
+		fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if(fd_ >= 0 && !add_directory(root, nullptr))
+		{
+			close();
+		}
+	}
+
+	~native_notifier()
+	{
+		close();
+	}
+
+	native_notifier(const native_notifier&) = delete;
+	native_notifier& operator=(const native_notifier&) = delete;
+
+	bool is_open() const
+	{
+		return fd_ >= 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : read ()
+	/// <summary>
+	/// Adds the changes since the last read, false if the notifier broke e.g.
+	/// out of watches, it is closed then.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool read(changes& result)
+	{
+		alignas(inotify_event) char buffer[64 * 1024];
+		for(;;)
+		{
+			const auto size = ::read(fd_, buffer, sizeof(buffer));
+			if(size < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if(size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			{
+				return true;
+			}
+			if(size <= 0)
+			{
+				close();
+				return false;
+			}
+
+			for(ssize_t offset = 0; offset < size;)
+			{
+				const auto e = reinterpret_cast<const inotify_event*>(buffer + offset);
+				offset += ssize_t(sizeof(inotify_event) + e->len);
+				if(!process(*e, result))
+				{
+					close();
+					return false;
+				}
+			}
+		}
+	}
+
+private:
+	void close()
+	{
+		if(fd_ >= 0)
+		{
+			::close(fd_);
+		}
+		fd_ = -1;
+		dirs_.clear();
+	}
+
+	bool process(const inotify_event& e, changes& result)
+	{
+		if((e.mask & IN_Q_OVERFLOW) != 0)
+		{
+			result.overflow = true;
+			return true;
+		}
+
+		auto it = dirs_.find(e.wd);
+		if(it == dirs_.end())
+		{
+			return true;
+		}
+		if((e.mask & IN_IGNORED) != 0)
+		{
+			dirs_.erase(it);
+			return true;
+		}
+
+		const auto p = e.len > 0 ? it->second / e.name : it->second;
+		result.paths.insert(p.string());
+		if(!recursive_ || (e.mask & IN_ISDIR) == 0)
+		{
+			return true;
+		}
+
+		// a directory moved out is no longer watched, one made or moved in
+		// is watched along with what it has by now
+		if((e.mask & IN_MOVED_FROM) != 0)
+		{
+			remove_directory(p);
+		}
+		if((e.mask & (IN_CREATE | IN_MOVED_TO)) != 0)
+		{
+			return add_directory(p, &result);
+		}
+		return true;
+	}
+
+	bool add_watch(const fs::path& dir)
+	{
+		const std::uint32_t mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+								   IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+		const int wd = inotify_add_watch(fd_, dir.string().c_str(), mask);
+		if(wd < 0)
+		{
+			// gone already, its removal is reported by the parent
+			return errno == ENOENT || errno == ENOTDIR;
+		}
+		dirs_[wd] = dir;
+		return true;
+	}
+
+	bool add_directory(const fs::path& dir, changes* result)
+	{
+		if(!add_watch(dir))
+		{
+			return false;
+		}
+		if(!recursive_)
+		{
+			return true;
+		}
+
+		fs::error_code err;
+		fs::recursive_directory_iterator it(dir, err);
+		for(fs::recursive_directory_iterator end; !err && it != end; it.increment(err))
+		{
+			if(result)
+			{
+				result->paths.insert(it->path().string());
+			}
+
+			fs::error_code type_err;
+			if(it->is_directory(type_err) && !add_watch(it->path()))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void remove_directory(const fs::path& dir)
+	{
+		const auto key = dir.string();
+		const auto prefix = key + char(fs::path::preferred_separator);
+		for(auto it = dirs_.begin(); it != dirs_.end();)
+		{
+			const auto current = it->second.string();
+			if(current == key || current.compare(0, prefix.size(), prefix) == 0)
+			{
+				inotify_rm_watch(fd_, it->first);
+				it = dirs_.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	int fd_ = -1;
+	bool recursive_ = false;
+	/// watched directories by their watch descriptor
+	std::map<int, fs::path> dirs_;
+#else
+	native_notifier(const fs::path& /*root*/, bool /*recursive*/)
+	{
+	}
+
+	bool is_open() const
+	{
+		return false;
+	}
+
+	bool read(changes& /*result*/)
+	{
+		return false;
+	}
+#endif
+};
+
 class filesystem_watcher::impl
 {
 public:
@@ -93,10 +322,11 @@ public:
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	impl(const fs::path& path, const std::string& filter, bool recursive, bool initial_list,
-		 clock_t::duration poll_interval, notify_callback list_callback)
+		 clock_t::duration poll_interval, clock_t::duration debounce, notify_callback list_callback)
 		: filter_(filter)
 		, callback_(std::move(list_callback))
 		, poll_interval_(poll_interval)
+		, debounce_(debounce)
 		, recursive_(recursive)
 	{
 		root_ = path;
@@ -106,6 +336,13 @@ public:
 		// make sure we store all initial write time
 		if(!filter_.empty())
 		{
+			// started first so nothing changing during the walk is missed
+			auto notifier = std::make_unique<native_notifier>(root_, recursive_);
+			if(notifier->is_open())
+			{
+				notifier_ = std::move(notifier);
+			}
+
 			visit_wild_card_path(path / filter, recursive, false,
 								 [this, &entries, &created, &modified](const fs::path& p) {
 									 poll_entry(p, entries, created, modified);
@@ -142,21 +379,55 @@ public:
 		std::vector<filesystem_watcher::entry> entries;
 		std::vector<size_t> created;
 		std::vector<size_t> modified;
+		native_notifier::changes changes;
+		if(notifier_ && !notifier_->read(changes))
+		{
+			// polled from now on
+			notifier_.reset();
+			changes.overflow = true;
+		}
+
+		// only what the system reported changed is checked
+		if(notifier_ && !changes.overflow)
+		{
+			const auto full = (root_ / filter_).string();
+			const auto wildcard_pos = full.find('*');
+			const auto before = full.substr(0, wildcard_pos);
+			const auto after = full.substr(wildcard_pos + 1);
+			for(const auto& changed : changes.paths)
+			{
+				fs::error_code err;
+				if(matches_wild_card(changed, before, after) && fs::exists(changed, err))
+				{
+					poll_entry(changed, entries, created, modified);
+				}
+			}
+
+			process_modifications(entries, created, modified, &changes.paths);
+		}
 		// otherwise we check the whole parent directory
-		if(!filter_.empty())
+		else if(!filter_.empty())
 		{
 			visit_wild_card_path(root_ / filter_, recursive_, false,
 								 [this, &entries, &created, &modified](const fs::path& p) {
 									 poll_entry(p, entries, created, modified);
 									 return false;
 								 });
+			process_modifications(entries, created, modified, nullptr);
 		}
 		else
 		{
 			poll_entry(root_, entries, created, modified);
+			process_modifications(entries, created, modified, nullptr);
 		}
 
-		process_modifications(entries, created, modified);
+		if(debounce_ > clock_t::duration(0))
+		{
+			const auto now = clock_t::now();
+			coalesce(entries, now);
+			entries.clear();
+			take_settled(entries, now);
+		}
 
 		if(!entries.empty() && callback_)
 		{
@@ -164,54 +435,190 @@ public:
 		}
 	}
 
-	void process_modifications(std::vector<filesystem_watcher::entry>& entries,
-							   const std::vector<size_t>& created, const std::vector<size_t>& /*unused*/)
+	//-----------------------------------------------------------------------------
+	//  Name : coalesce ()
+	/// <summary>
+	/// Merges the changes into the pending ones of their path. A path keeps the
+	/// status it has for whoever was told last, created and then modified is
+	/// created, modified again is dropped, removed and created again is
+	/// modified and created and then removed is nothing.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void coalesce(const std::vector<filesystem_watcher::entry>& entries, clock_t::time_point now)
 	{
-		using namespace std::literals;
-
-		auto it = std::begin(entries_);
-		while(it != std::end(entries_))
+		for(auto e : entries)
 		{
-			auto& fi = it->second;
-			fs::error_code err;
-			if(!fs::exists(fi.path, err))
+			if(e.status == filesystem_watcher::entry_status::renamed)
 			{
-				bool was_removed = true;
-				for(auto idx : created)
+				auto old = pending_index_.find(e.last_path.string());
+				if(old == std::end(pending_index_))
 				{
-					auto& e = entries[idx];
-					if(e.size == fi.size)
-					{
-						//using sys_clock = std::chrono::system_clock;
-						//std::chrono::microseconds tolerance = 1000us;
-						//auto diff = sys_clock::from_time_t(e.last_mod_time - fi.last_mod_time);
-						//auto d = std::chrono::time_point_cast<std::chrono::microseconds>(diff);
-						if(e.last_mod_time == fi.last_mod_time)
-						{
+					pending_.push_back({e, now});
+					continue;
+				}
 
-							e.status = filesystem_watcher::entry_status::renamed;
-							e.last_path = fi.path;
-							was_removed = false;
-							break;
-						}
-					}
+				const auto old_status = old->second->e.status;
+				pending_.erase(old->second);
+				pending_index_.erase(old);
+				if(old_status == filesystem_watcher::entry_status::created)
+				{
+					// nobody knew the old path, it is created where it is now
+					e.status = filesystem_watcher::entry_status::created;
+					e.last_path = e.path;
+				}
+				else if(old_status == filesystem_watcher::entry_status::modified)
+				{
+					// renamed and then modified where it is now
+					pending_.push_back({e, now});
+					e.status = filesystem_watcher::entry_status::modified;
+					e.last_path = e.path;
+				}
+				else
+				{
+					pending_.push_back({e, now});
+					continue;
 				}
+			}
 
-				if(was_removed)
+			const auto key = e.path.string();
+			auto it = pending_index_.find(key);
+			if(it == std::end(pending_index_))
+			{
+				pending_index_[key] = pending_.insert(std::end(pending_), {e, now});
+				continue;
+			}
+
+			auto& p = *it->second;
+			auto status = p.e.status;
+			if(e.status == filesystem_watcher::entry_status::removed)
+			{
+				if(status == filesystem_watcher::entry_status::created)
 				{
-					fi.status = filesystem_watcher::entry_status::removed;
-					entries.push_back(fi);
+					pending_.erase(it->second);
+					pending_index_.erase(it);
+					continue;
 				}
+				status = filesystem_watcher::entry_status::removed;
+			}
+			else if(status == filesystem_watcher::entry_status::removed)
+			{
+				status = filesystem_watcher::entry_status::modified;
+			}
+
+			p.e = e;
+			p.e.status = status;
+			p.last_change = now;
+		}
+	}
 
-				it = entries_.erase(it);
+	//-----------------------------------------------------------------------------
+	//  Name : take_settled ()
+	/// <summary>
+	/// Moves the pending changes of the paths that did not change for the
+	/// debounce window to the entries, in the order they first changed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void take_settled(std::vector<filesystem_watcher::entry>& entries, clock_t::time_point now)
+	{
+		auto it = std::begin(pending_);
+		while(it != std::end(pending_))
+		{
+			if(now - it->last_change < debounce_)
+			{
+				++it;
+				continue;
 			}
-			else
+
+			auto index = pending_index_.find(it->e.path.string());
+			if(index != std::end(pending_index_) && index->second == it)
 			{
-				it++;
+				pending_index_.erase(index);
 			}
+			entries.push_back(std::move(it->e));
+			it = pending_.erase(it);
 		}
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : process_modifications ()
+	/// <summary>
+	/// Finds the cached entries that no longer exist, renamed to a created one
+	/// or removed. Only the ones under the changed paths when given.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void process_modifications(std::vector<filesystem_watcher::entry>& entries,
+							   const std::vector<size_t>& created, const std::vector<size_t>& /*unused*/,
+							   const std::set<std::string>* changed)
+	{
+		if(changed == nullptr)
+		{
+			auto it = std::begin(entries_);
+			while(it != std::end(entries_))
+			{
+				it = check_removed(it, entries, created);
+			}
+			return;
+		}
+
+		for(const auto& key : *changed)
+		{
+			// the path itself and what was under it
+			auto it = entries_.lower_bound(key);
+			while(it != std::end(entries_) && it->first.compare(0, key.size(), key) == 0)
+			{
+				const auto separator = fs::path::value_type(fs::path::preferred_separator);
+				const bool under = it->first.size() == key.size() || it->first[key.size()] == separator;
+				it = under ? check_removed(it, entries, created) : std::next(it);
+			}
+		}
+	}
+
+	std::map<std::string, filesystem_watcher::entry>::iterator
+	check_removed(std::map<std::string, filesystem_watcher::entry>::iterator it,
+				  std::vector<filesystem_watcher::entry>& entries, const std::vector<size_t>& created)
+	{
+		auto& fi = it->second;
+		fs::error_code err;
+		if(fs::exists(fi.path, err))
+		{
+			return std::next(it);
+		}
+
+		bool was_removed = true;
+		for(auto idx : created)
+		{
+			auto& e = entries[idx];
+			// already the new path of another one
+			if(e.status == filesystem_watcher::entry_status::renamed)
+			{
+				continue;
+			}
+			if(e.size == fi.size)
+			{
+				//using sys_clock = std::chrono::system_clock;
+				//std::chrono::microseconds tolerance = 1000us;
+				//auto diff = sys_clock::from_time_t(e.last_mod_time - fi.last_mod_time);
+				//auto d = std::chrono::time_point_cast<std::chrono::microseconds>(diff);
+				if(e.last_mod_time == fi.last_mod_time)
+				{
+
+					e.status = filesystem_watcher::entry_status::renamed;
+					e.last_path = fi.path;
+					was_removed = false;
+					break;
+				}
+			}
+		}
+
+		if(was_removed)
+		{
+			fi.status = filesystem_watcher::entry_status::removed;
+			entries.push_back(fi);
+		}
+
+		return entries_.erase(it);
+	}
+
 	//-----------------------------------------------------------------------------
 	//  Name : poll_entry ()
 	/// <summary>
@@ -278,10 +685,24 @@ protected:
 	std::map<std::string, filesystem_watcher::entry> entries_;
 	///
 	clock_t::duration poll_interval_ = 500ms;
+	/// how long a path must not change for its changes to be reported
+	clock_t::duration debounce_ = clock_t::duration(0);
+
+	struct pending_entry
+	{
+		filesystem_watcher::entry e;
+		clock_t::time_point last_change;
+	};
+	/// the changes not reported yet in the order their paths first changed
+	std::list<pending_entry> pending_;
+	/// the pending changes by path, except the renames
+	std::map<std::string, std::list<pending_entry>::iterator> pending_index_;
 
 	clock_t::time_point last_poll_ = clock_t::now();
 	///
 	bool recursive_ = false;
+	/// the changes from the system, null when polling
+	std::unique_ptr<native_notifier> notifier_;
 };
 
 static filesystem_watcher& get_watcher()
@@ -294,7 +715,14 @@ static filesystem_watcher& get_watcher()
 std::uint64_t filesystem_watcher::watch(const fs::path& path, bool recursive, bool initial_list,
 										clock_t::duration poll_interval, notify_callback callback)
 {
-	return watch_impl(path, recursive, initial_list, poll_interval, callback);
+	return watch_impl(path, recursive, initial_list, poll_interval, clock_t::duration(0), callback);
+}
+
+std::uint64_t filesystem_watcher::watch(const fs::path& path, bool recursive, bool initial_list,
+										clock_t::duration poll_interval, clock_t::duration debounce,
+										notify_callback callback)
+{
+	return watch_impl(path, recursive, initial_list, poll_interval, debounce, callback);
 }
 
 void filesystem_watcher::unwatch(std::uint64_t key)
@@ -394,12 +822,13 @@ void filesystem_watcher::start()
 }
 
 std::uint64_t filesystem_watcher::watch_impl(const fs::path& path, bool recursive, bool initial_list,
-											 clock_t::duration poll_interval,
+											 clock_t::duration poll_interval, clock_t::duration debounce,
 											 notify_callback& list_callback)
 {
 	auto& wd = get_watcher();
-	// and start its thread
-	if(!wd.watching_)
+	// and start its thread, once when several threads watch at the same time
+	bool watching = false;
+	if(wd.watching_.compare_exchange_strong(watching, true))
 	{
 		wd.start();
 	}
@@ -434,8 +863,8 @@ std::uint64_t filesystem_watcher::watch_impl(const fs::path& path, bool recursiv
 		{
 			// we do it like this because if initial_list is true we don't want
 			// to call a user callback on a locked mutex
-			auto imp =
-				std::make_shared<impl>(p, filter, recursive, initial_list, poll_interval, std::move(list_callback));
+			auto imp = std::make_shared<impl>(p, filter, recursive, initial_list, poll_interval, debounce,
+											  std::move(list_callback));
 			std::lock_guard<std::mutex> lock(wd.mutex_);
 			wd.watchers_.emplace(key, std::move(imp));
 		}
@@ -49,12 +49,27 @@ public:
 	/// Watches a file or directory for modification and call back the specified
 	/// std::function. A list of modified files or directory is passed as argument
 	/// of the callback. Use this version only if you are watching multiple files
-	/// or a directory.
+	/// or a directory. A directory is watched with the change notifications of
+	/// the system where there are some and polled otherwise, the changes are
+	/// gathered every poll interval either way.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	static std::uint64_t watch(const fs::path& path, bool recursive, bool initial_list,
 							   clock_t::duration poll_interval, notify_callback callback);
 
+	//-----------------------------------------------------------------------------
+	//  Name : watch ()
+	/// <summary>
+	/// Watches like the other version but holds the changes of a path back
+	/// until it did not change for the debounce window, so a file written in
+	/// parts is reported once. The changes of a path are merged into one and
+	/// the ones settled by the same poll are reported together.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static std::uint64_t watch(const fs::path& path, bool recursive, bool initial_list,
+							   clock_t::duration poll_interval, clock_t::duration debounce,
+							   notify_callback callback);
+
 	//-----------------------------------------------------------------------------
 	//  Name : unwatch ()
 	/// <summary>
@@ -123,7 +138,8 @@ protected:
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	static std::uint64_t watch_impl(const fs::path& path, bool recursive, bool initialList,
-									clock_t::duration poll_interval, notify_callback& listCallback);
+									clock_t::duration poll_interval, clock_t::duration debounce,
+									notify_callback& listCallback);
 
 	static void unwatch_impl(std::uint64_t key);
 
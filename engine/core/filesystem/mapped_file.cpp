@@ -0,0 +1,161 @@
+#include "mapped_file.h"
+#include "../common/platform/config.hpp"
+
+#if ETH_ON(ETH_PLATFORM_WINDOWS)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs
+{
+#if ETH_ON(ETH_PLATFORM_WINDOWS)
+mapped_file::mapped_file(const path& file_path)
+{
+	// shared for delete so that a rename can replace the file while it is mapped
+	const DWORD share = FILE_SHARE_READ | FILE_SHARE_DELETE;
+	HANDLE file = CreateFileW(file_path.wstring().c_str(), GENERIC_READ, share, nullptr, OPEN_EXISTING,
+							  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+
+	LARGE_INTEGER file_size;
+	if(GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0)
+	{
+		mapping_ = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(mapping_)
+		{
+			data_ = static_cast<const std::uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+			size_ = data_ ? std::size_t(file_size.QuadPart) : 0;
+		}
+	}
+
+	// the mapping keeps the file open
+	CloseHandle(file);
+	if(!data_)
+	{
+		close();
+	}
+}
+
+void mapped_file::close()
+{
+	if(data_)
+	{
+		UnmapViewOfFile(data_);
+	}
+	if(mapping_)
+	{
+		CloseHandle(mapping_);
+	}
+	data_ = nullptr;
+	mapping_ = nullptr;
+	size_ = 0;
+}
+
+void mapped_file::prefetch() const
+{
+	if(!data_)
+	{
+		return;
+	}
+
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = const_cast<std::uint8_t*>(data_);
+	range.NumberOfBytes = size_;
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+#else
+mapped_file::mapped_file(const path& file_path)
+{
+	const int file = ::open(file_path.string().c_str(), O_RDONLY);
+	if(file < 0)
+	{
+		return;
+	}
+
+	struct stat file_stat;
+	if(::fstat(file, &file_stat) == 0 && file_stat.st_size > 0)
+	{
+		const auto file_size = std::size_t(file_stat.st_size);
+		void* data = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, file, 0);
+		if(data != MAP_FAILED)
+		{
+			data_ = static_cast<const std::uint8_t*>(data);
+			size_ = file_size;
+		}
+	}
+
+	// the mapping keeps the file open
+	::close(file);
+}
+
+void mapped_file::close()
+{
+	if(data_)
+	{
+		::munmap(const_cast<std::uint8_t*>(data_), size_);
+	}
+	data_ = nullptr;
+	size_ = 0;
+}
+
+void mapped_file::prefetch() const
+{
+	if(data_)
+	{
+		::madvise(const_cast<std::uint8_t*>(data_), size_, MADV_WILLNEED);
+	}
+}
+#endif
+
+mapped_file::~mapped_file()
+{
+	close();
+}
+
+memory_streambuf::memory_streambuf(const std::uint8_t* data, std::size_t size)
+{
+	// the get area is only read, the cast is what streambuf asks for
+	auto begin = reinterpret_cast<char*>(const_cast<std::uint8_t*>(data));
+	setg(begin, begin, begin + size);
+}
+
+memory_streambuf::pos_type memory_streambuf::seekoff(off_type off, std::ios_base::seekdir dir,
+													 std::ios_base::openmode which)
+{
+	if(!(which & std::ios_base::in))
+	{
+		return pos_type(off_type(-1));
+	}
+
+	off_type base = 0;
+	if(dir == std::ios_base::cur)
+	{
+		base = gptr() - eback();
+	}
+	else if(dir == std::ios_base::end)
+	{
+		base = egptr() - eback();
+	}
+
+	const auto target = base + off;
+	if(target < 0 || target > egptr() - eback())
+	{
+		return pos_type(off_type(-1));
+	}
+
+	setg(eback(), eback() + target, egptr());
+	return pos_type(target);
+}
+
+memory_streambuf::pos_type memory_streambuf::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+	return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "detail/filesystem_includes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <streambuf>
+
+namespace fs
+{
+/*
+ * mapped_file; a file mapped read only into the address space, its bytes
+ * are read from the disk as they are touched instead of copied up front.
+ */
+class mapped_file
+{
+public:
+	mapped_file() = default;
+
+	//-----------------------------------------------------------------------------
+	//  Name : mapped_file ()
+	/// <summary>
+	/// Maps the whole file, check is_open for whether it could be.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	explicit mapped_file(const path& file_path);
+	~mapped_file();
+
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+
+	bool is_open() const
+	{
+		return data_ != nullptr;
+	}
+
+	const std::uint8_t* data() const
+	{
+		return data_;
+	}
+
+	std::size_t size() const
+	{
+		return size_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : prefetch ()
+	/// <summary>
+	/// Asks the system to start reading the whole file in, ahead of the
+	/// first touch.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void prefetch() const;
+
+private:
+	void close();
+
+	const std::uint8_t* data_ = nullptr;
+	std::size_t size_ = 0;
+	/// the mapping object on windows
+	void* mapping_ = nullptr;
+};
+
+/*
+ * memory_streambuf; a stream buffer reading a block of memory in place, an
+ * istream over it deserializes from a mapped file without copying it. The
+ * memory must outlive the buffer.
+ */
+class memory_streambuf : public std::streambuf
+{
+public:
+	memory_streambuf(const std::uint8_t* data, std::size_t size);
+
+protected:
+	pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+	pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+};
+}
@@ -1,5 +1,9 @@
 #include "debugdraw.h"
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
 namespace gfx
 {
 dd_raii::dd_raii(view_id _viewId)
@@ -11,4 +15,120 @@ dd_raii::~dd_raii()
 {
 	encoder.end();
 }
+
+constexpr std::size_t dd_batch::depth_modes;
+constexpr std::uint32_t dd_batch::max_chunk_vertices;
+
+dd_batch::bucket& dd_batch::get_bucket(primitive type, bool depth_test)
+{
+	return buckets_[std::size_t(type) * depth_modes + (depth_test ? 1 : 0)];
+}
+
+void dd_batch::add(primitive type, bool depth_test, const float* positions, std::uint32_t vertex_count,
+				   const std::uint16_t* indices, std::uint32_t index_count, std::uint32_t abgr)
+{
+	if(vertex_count == 0 || index_count == 0 || vertex_count > max_chunk_vertices)
+	{
+		return;
+	}
+
+	auto& b = get_bucket(type, depth_test);
+	auto base = b.chunks.empty() ? max_chunk_vertices
+								 : std::uint32_t(b.vertices.size()) - b.chunks.back().vertex_begin;
+	if(base + vertex_count > max_chunk_vertices)
+	{
+		chunk c;
+		c.vertex_begin = std::uint32_t(b.vertices.size());
+		c.index_begin = std::uint32_t(b.indices.size());
+		b.chunks.push_back(c);
+		base = 0;
+	}
+
+	for(std::uint32_t i = 0; i < vertex_count; ++i)
+	{
+		pos_color0_vertex v;
+		v.x = positions[i * 3 + 0];
+		v.y = positions[i * 3 + 1];
+		v.z = positions[i * 3 + 2];
+		v.abgr = abgr;
+		b.vertices.push_back(v);
+	}
+
+	for(std::uint32_t i = 0; i < index_count; ++i)
+	{
+		b.indices.push_back(std::uint16_t(base + indices[i]));
+	}
+}
+
+void dd_batch::add_line(const float* from, const float* to, std::uint32_t abgr, bool depth_test)
+{
+	const float positions[] = {from[0], from[1], from[2], to[0], to[1], to[2]};
+	const std::uint16_t indices[] = {0, 1};
+	add(primitive::lines, depth_test, positions, 2, indices, 2, abgr);
+}
+
+void dd_batch::submit(view_id id, program_handle program, bool keep)
+{
+	submits_ = 0;
+	const auto& layout = pos_color0_vertex::get_layout();
+	for(std::size_t type = 0; type < std::size_t(primitive::count); ++type)
+	{
+		for(std::size_t mode = 0; mode < depth_modes; ++mode)
+		{
+			auto& b = get_bucket(primitive(type), mode != 0);
+			std::uint64_t state = BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_MSAA |
+								  BGFX_STATE_BLEND_ALPHA;
+			state |= primitive(type) == primitive::lines ? BGFX_STATE_PT_LINES | BGFX_STATE_LINEAA : 0;
+			state |= mode != 0 ? BGFX_STATE_DEPTH_TEST_LESS : 0;
+
+			for(std::size_t i = 0; i < b.chunks.size(); ++i)
+			{
+				const auto& c = b.chunks[i];
+				const auto vertex_end = i + 1 < b.chunks.size() ? b.chunks[i + 1].vertex_begin
+																: std::uint32_t(b.vertices.size());
+				const auto index_end = i + 1 < b.chunks.size() ? b.chunks[i + 1].index_begin
+															   : std::uint32_t(b.indices.size());
+				const auto vertex_count = vertex_end - c.vertex_begin;
+				const auto index_count = index_end - c.index_begin;
+
+				transient_vertex_buffer tvb;
+				transient_index_buffer tib;
+				if(!alloc_transient_buffers(&tvb, layout, vertex_count, &tib, index_count))
+				{
+					// out of transient memory for the frame, the rest is dropped
+					break;
+				}
+
+				std::memcpy(tvb.data, &b.vertices[c.vertex_begin], vertex_count * layout.getStride());
+				std::memcpy(tib.data, &b.indices[c.index_begin], index_count * sizeof(std::uint16_t));
+				set_vertex_buffer(0, &tvb, 0, vertex_count);
+				set_index_buffer(&tib, 0, index_count);
+				set_state(state);
+				gfx::submit(id, program);
+				++submits_;
+			}
+		}
+	}
+
+	if(!keep)
+	{
+		clear();
+	}
+}
+
+bool dd_batch::empty() const
+{
+	return std::all_of(std::begin(buckets_), std::end(buckets_),
+					   [](const bucket& b) { return b.indices.empty(); });
+}
+
+void dd_batch::clear()
+{
+	for(auto& b : buckets_)
+	{
+		b.vertices.clear();
+		b.indices.clear();
+		b.chunks.clear();
+	}
+}
 }
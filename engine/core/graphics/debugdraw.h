@@ -1,9 +1,11 @@
 #pragma once
 
 #include "graphics.h"
+#include "vertex_decl.h"
 //
 #include "common/debugdraw/debugdraw.h"
 #include <cstdint>
+#include <vector>
 
 namespace gfx
 {
@@ -15,4 +17,85 @@ struct dd_raii
 
 	DebugDrawEncoder encoder;
 };
+
+/*
+ * dd_batch; debug shapes already in world space gathered over a frame and
+ * drawn with a submit per primitive type and depth mode, instead of the
+ * immediate calls of the encoder.
+ *
+ *      The vertices and indices of a bucket go to transient buffers when it
+ *      is submitted. The indices are 16 bit, a bucket with more vertices
+ *      than they reach is split and takes a submit per 65536 vertices.
+ */
+class dd_batch
+{
+public:
+	enum class primitive : std::uint8_t
+	{
+		lines,
+		triangles,
+		count
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : add ()
+	/// <summary>
+	/// Adds a shape, positions are 3 floats a vertex and the indices are of
+	/// the positions, two a line or three a triangle.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void add(primitive type, bool depth_test, const float* positions, std::uint32_t vertex_count,
+			 const std::uint16_t* indices, std::uint32_t index_count, std::uint32_t abgr);
+
+	//-----------------------------------------------------------------------------
+	//  Name : add_line ()
+	/// <summary>
+	/// Adds a line from a to b, 3 floats each.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void add_line(const float* from, const float* to, std::uint32_t abgr, bool depth_test = true);
+
+	//-----------------------------------------------------------------------------
+	//  Name : submit ()
+	/// <summary>
+	/// Draws the buckets to the view with the program, a position and color0
+	/// one without a model transform, and clears them unless they are kept
+	/// to be drawn again.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void submit(view_id id, program_handle program, bool keep = false);
+
+	bool empty() const;
+
+	void clear();
+
+	/// submits of the last submit
+	std::uint32_t get_submits() const
+	{
+		return submits_;
+	}
+
+private:
+	struct chunk
+	{
+		std::uint32_t vertex_begin = 0;
+		std::uint32_t index_begin = 0;
+	};
+
+	struct bucket
+	{
+		std::vector<pos_color0_vertex> vertices;
+		std::vector<std::uint16_t> indices;
+		/// where the vertices of every 16 bit index range start
+		std::vector<chunk> chunks;
+	};
+
+	static constexpr std::size_t depth_modes = 2;
+	static constexpr std::uint32_t max_chunk_vertices = 1 << 16;
+
+	bucket& get_bucket(primitive type, bool depth_test);
+
+	bucket buckets_[std::size_t(primitive::count) * depth_modes];
+	std::uint32_t submits_ = 0;
+};
 }
@@ -0,0 +1,180 @@
+#include "destroy_queue.h"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace gfx
+{
+namespace destroy_queue
+{
+namespace
+{
+struct entry
+{
+	destroy_kind kind;
+	std::uint16_t idx;
+	/// the last frame submitted when it was queued
+	std::uint32_t frame;
+};
+
+std::mutex s_mutex;
+/// in the order queued, so by frame
+std::vector<entry> s_pending;
+std::vector<entry> s_due;
+std::uint32_t s_frame = 0;
+destroy_queue_stats s_stats;
+
+void push(destroy_kind kind, std::uint16_t idx)
+{
+	if(idx == invalid_handle)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+	s_pending.push_back({kind, idx, s_frame});
+	++s_stats.queued;
+	++s_stats.queued_by_kind[std::size_t(kind)];
+	s_stats.pending = s_pending.size();
+	s_stats.peak_pending = std::max(s_stats.peak_pending, s_stats.pending);
+}
+
+template <typename T>
+T make_handle(std::uint16_t idx)
+{
+	T handle = {idx};
+	return handle;
+}
+
+void destroy_entry(const entry& e)
+{
+	switch(e.kind)
+	{
+		case destroy_kind::index_buffer:
+			destroy(make_handle<index_buffer_handle>(e.idx));
+			break;
+		case destroy_kind::vertex_buffer:
+			destroy(make_handle<vertex_buffer_handle>(e.idx));
+			break;
+		case destroy_kind::dynamic_index_buffer:
+			destroy(make_handle<dynamic_index_buffer_handle>(e.idx));
+			break;
+		case destroy_kind::dynamic_vertex_buffer:
+			destroy(make_handle<dynamic_vertex_buffer_handle>(e.idx));
+			break;
+		case destroy_kind::frame_buffer:
+			destroy(make_handle<frame_buffer_handle>(e.idx));
+			break;
+		case destroy_kind::texture:
+			destroy(make_handle<texture_handle>(e.idx));
+			break;
+		case destroy_kind::program:
+			destroy(make_handle<program_handle>(e.idx));
+			break;
+		case destroy_kind::shader:
+			destroy(make_handle<shader_handle>(e.idx));
+			break;
+		case destroy_kind::uniform:
+			destroy(make_handle<uniform_handle>(e.idx));
+			break;
+		default:
+			break;
+	}
+}
+
+// the due entries are taken under the lock and destroyed outside of it,
+// they are only touched on the API thread
+void destroy_due()
+{
+	for(const auto& e : s_due)
+	{
+		destroy_entry(e);
+	}
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+	s_stats.destroyed += s_due.size();
+	s_due.clear();
+}
+}
+
+void push(index_buffer_handle _handle)
+{
+	push(destroy_kind::index_buffer, _handle.idx);
+}
+
+void push(vertex_buffer_handle _handle)
+{
+	push(destroy_kind::vertex_buffer, _handle.idx);
+}
+
+void push(dynamic_index_buffer_handle _handle)
+{
+	push(destroy_kind::dynamic_index_buffer, _handle.idx);
+}
+
+void push(dynamic_vertex_buffer_handle _handle)
+{
+	push(destroy_kind::dynamic_vertex_buffer, _handle.idx);
+}
+
+void push(frame_buffer_handle _handle)
+{
+	push(destroy_kind::frame_buffer, _handle.idx);
+}
+
+void push(texture_handle _handle)
+{
+	push(destroy_kind::texture, _handle.idx);
+}
+
+void push(program_handle _handle)
+{
+	push(destroy_kind::program, _handle.idx);
+}
+
+void push(shader_handle _handle)
+{
+	push(destroy_kind::shader, _handle.idx);
+}
+
+void push(uniform_handle _handle)
+{
+	push(destroy_kind::uniform, _handle.idx);
+}
+
+void process(std::uint32_t _frame)
+{
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		s_frame = _frame;
+		auto it = std::find_if(std::begin(s_pending), std::end(s_pending), [_frame](const entry& e) {
+			return _frame - e.frame < frames_in_flight;
+		});
+		s_due.insert(std::end(s_due), std::begin(s_pending), it);
+		s_pending.erase(std::begin(s_pending), it);
+		s_stats.pending = s_pending.size();
+	}
+
+	destroy_due();
+}
+
+void flush()
+{
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		s_due.insert(std::end(s_due), std::begin(s_pending), std::end(s_pending));
+		s_pending.clear();
+		s_stats.pending = 0;
+	}
+
+	destroy_due();
+}
+
+destroy_queue_stats get_stats()
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	return s_stats;
+}
+}
+}
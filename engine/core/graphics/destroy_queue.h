@@ -0,0 +1,92 @@
+#pragma once
+
+#include "graphics.h"
+
+#include <array>
+#include <cstdint>
+
+namespace gfx
+{
+enum class destroy_kind : std::uint8_t
+{
+	index_buffer,
+	vertex_buffer,
+	dynamic_index_buffer,
+	dynamic_vertex_buffer,
+	frame_buffer,
+	texture,
+	program,
+	shader,
+	uniform,
+	count
+};
+
+struct destroy_queue_stats
+{
+	/// the handles queued and destroyed since init
+	std::uint64_t queued = 0;
+	std::uint64_t destroyed = 0;
+	/// the handles waiting for their frames to end, and the most at once
+	std::uint64_t pending = 0;
+	std::uint64_t peak_pending = 0;
+	/// the handles queued since init, by kind
+	std::array<std::uint64_t, std::size_t(destroy_kind::count)> queued_by_kind{};
+};
+
+/*
+ * destroy_queue; the handles released by the resource wrappers and arenas.
+ *
+ *      The last reference to a resource can be dropped on any thread and in
+ *      the middle of a frame that still uses it. Its handle is queued instead
+ *      of destroyed and the queue is processed on the API thread once a
+ *      frame is submitted, destroying the handles queued frames_in_flight
+ *      frames before.
+ */
+namespace destroy_queue
+{
+/// the frames submitted after the one a handle was released in, before it
+/// is destroyed
+constexpr std::uint32_t frames_in_flight = 2;
+
+//-----------------------------------------------------------------------------
+//  Name : push ()
+/// <summary>
+/// Queues the handle for destroy. Safe to call from any thread.
+/// </summary>
+//-----------------------------------------------------------------------------
+void push(index_buffer_handle _handle);
+void push(vertex_buffer_handle _handle);
+void push(dynamic_index_buffer_handle _handle);
+void push(dynamic_vertex_buffer_handle _handle);
+void push(frame_buffer_handle _handle);
+void push(texture_handle _handle);
+void push(program_handle _handle);
+void push(shader_handle _handle);
+void push(uniform_handle _handle);
+
+//-----------------------------------------------------------------------------
+//  Name : process ()
+/// <summary>
+/// Destroys the handles queued frames_in_flight frames before _frame, the
+/// number gfx::frame returned. Called on the API thread after the submit.
+/// </summary>
+//-----------------------------------------------------------------------------
+void process(std::uint32_t _frame);
+
+//-----------------------------------------------------------------------------
+//  Name : flush ()
+/// <summary>
+/// Destroys every queued handle, for shutdown.
+/// </summary>
+//-----------------------------------------------------------------------------
+void flush();
+
+//-----------------------------------------------------------------------------
+//  Name : get_stats ()
+/// <summary>
+/// The counts since init.
+/// </summary>
+//-----------------------------------------------------------------------------
+destroy_queue_stats get_stats();
+}
+}
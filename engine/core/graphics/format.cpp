@@ -432,4 +432,30 @@ bool is_format_supported(uint16_t flags, texture_format format)
 	const std::uint32_t formatCaps = bgfx::getCaps()->formats[format];
 	return 0 != (formatCaps & flags);
 }
+
+std::uint32_t get_msaa_samples(std::uint64_t flags)
+{
+	// BGFX_TEXTURE_RT is 1, the msaa ones go from 2 for x2 to 5 for x16
+	const auto rt = (flags & BGFX_TEXTURE_RT_MASK) >> BGFX_TEXTURE_RT_SHIFT;
+	return rt >= 2 ? 1u << (rt - 1) : 1u;
+}
+
+std::uint64_t get_memory_size(std::uint16_t width, std::uint16_t height, std::uint16_t depth, bool cube_map,
+							  bool has_mips, std::uint16_t num_layers, texture_format format,
+							  std::uint64_t flags)
+{
+	bgfx::TextureInfo info;
+	bgfx::calcTextureSize(info, width, height, depth, cube_map, has_mips, num_layers, format);
+
+	const std::uint64_t size = info.storageSize;
+	const auto samples = get_msaa_samples(flags);
+	if(samples == 1)
+	{
+		return size;
+	}
+
+	// the samples, and the resolved texture unless only rendered to
+	const bool write_only = (flags & BGFX_TEXTURE_RT_WRITE_ONLY) == BGFX_TEXTURE_RT_WRITE_ONLY;
+	return size * samples + (write_only ? 0 : size);
+}
 }
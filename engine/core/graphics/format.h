@@ -32,4 +32,23 @@ bool is_format_supported(std::uint16_t flags, texture_format format);
 texture_format get_best_format(std::uint16_t type, std::uint32_t search_flags);
 
 std::uint64_t get_default_rt_sampler_flags();
+
+//-----------------------------------------------------------------------------
+//  Name : get_memory_size ()
+/// <summary>
+/// The bytes a texture of the format takes with its mips and layers or cube
+/// faces, with the samples of a multisampled render target and its resolve.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::uint64_t get_memory_size(std::uint16_t width, std::uint16_t height, std::uint16_t depth, bool cube_map,
+							  bool has_mips, std::uint16_t num_layers, texture_format format,
+							  std::uint64_t flags);
+
+//-----------------------------------------------------------------------------
+//  Name : get_msaa_samples ()
+/// <summary>
+/// The samples of a render target created with the flags, 1 without msaa.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::uint32_t get_msaa_samples(std::uint64_t flags);
 }
@@ -42,6 +42,12 @@ frame_buffer::frame_buffer(void* _nwh, uint16_t _width, uint16_t _height, textur
 {
 	handle = create_frame_buffer(_nwh, _width, _height, _format, _depth_format);
 
+	// the swap chain and its depth, the frame buffers of textures own none
+	const auto color = _format == texture_format::Count ? texture_format::RGBA8 : _format;
+	const auto depth = _depth_format == texture_format::Count ? texture_format::D24S8 : _depth_format;
+	track_memory(gfx::get_memory_size(_width, _height, 1, false, false, 1, color, 0) +
+				 gfx::get_memory_size(_width, _height, 1, false, false, 1, depth, 0));
+
 	cached_size_ = {_width, _height};
 	bbratio_ = backbuffer_ratio::Count;
 }
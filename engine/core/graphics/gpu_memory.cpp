@@ -0,0 +1,89 @@
+#include "gpu_memory.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace gfx
+{
+namespace
+{
+std::mutex s_mutex;
+memory_stats s_stats;
+thread_local memory_category s_current_category = memory_category::other;
+}
+
+const char* get_memory_category_name(memory_category category)
+{
+	switch(category)
+	{
+		case memory_category::other:
+			return "other";
+		case memory_category::assets:
+			return "assets";
+		case memory_category::render_views:
+			return "render views";
+		case memory_category::transients:
+			return "transients";
+		case memory_category::probes:
+			return "probes";
+		case memory_category::shadows:
+			return "shadows";
+		default:
+			return "";
+	}
+}
+
+namespace gpu_memory
+{
+void add(memory_category category, std::uint64_t bytes)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	auto& stats = s_stats[std::size_t(category)];
+	stats.bytes += bytes;
+	stats.peak_bytes = std::max(stats.peak_bytes, stats.bytes);
+	++stats.count;
+	++stats.created;
+}
+
+void remove(memory_category category, std::uint64_t bytes)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	auto& stats = s_stats[std::size_t(category)];
+	stats.bytes -= std::min(stats.bytes, bytes);
+	stats.count -= std::min<std::uint64_t>(stats.count, 1);
+}
+
+memory_stats get_stats()
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	return s_stats;
+}
+
+std::uint64_t get_total_bytes()
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	std::uint64_t total = 0;
+	for(const auto& stats : s_stats)
+	{
+		total += stats.bytes;
+	}
+	return total;
+}
+
+memory_category get_current_category()
+{
+	return s_current_category;
+}
+}
+
+scoped_memory_category::scoped_memory_category(memory_category category)
+	: previous_(s_current_category)
+{
+	s_current_category = category;
+}
+
+scoped_memory_category::~scoped_memory_category()
+{
+	s_current_category = previous_;
+}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace gfx
+{
+enum class memory_category : std::uint8_t
+{
+	/// created outside of a scoped_memory_category
+	other,
+	/// loaded textures and meshes
+	assets,
+	/// the targets the render views of the cameras keep
+	render_views,
+	/// the targets the render views share through the transient pool
+	transients,
+	/// the targets of the reflection probes
+	probes,
+	/// the shadow maps
+	shadows,
+	count
+};
+
+const char* get_memory_category_name(memory_category category);
+
+struct memory_category_stats
+{
+	/// the bytes and the resources alive
+	std::uint64_t bytes = 0;
+	std::uint64_t count = 0;
+	/// the most bytes alive at once
+	std::uint64_t peak_bytes = 0;
+	/// the resources created since init, for the churn
+	std::uint64_t created = 0;
+};
+
+using memory_stats = std::array<memory_category_stats, std::size_t(memory_category::count)>;
+
+/*
+ * gpu_memory; the bytes the gpu resources take, by category.
+ *
+ *      The resource wrappers add their size when they create their handle
+ *      and remove it when they dispose of it. A resource is counted in the
+ *      category of the innermost scoped_memory_category on the thread that
+ *      creates it.
+ */
+namespace gpu_memory
+{
+void add(memory_category category, std::uint64_t bytes);
+void remove(memory_category category, std::uint64_t bytes);
+
+//-----------------------------------------------------------------------------
+//  Name : get_stats ()
+/// <summary>
+/// A copy of the counts, safe to call from any thread.
+/// </summary>
+//-----------------------------------------------------------------------------
+memory_stats get_stats();
+
+//-----------------------------------------------------------------------------
+//  Name : get_total_bytes ()
+/// <summary>
+/// The bytes alive in every category.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::uint64_t get_total_bytes();
+
+memory_category get_current_category();
+}
+
+/// Counts the resources created on the thread while alive in the category.
+struct scoped_memory_category
+{
+	explicit scoped_memory_category(memory_category category);
+	~scoped_memory_category();
+	scoped_memory_category(const scoped_memory_category&) = delete;
+	scoped_memory_category& operator=(const scoped_memory_category&) = delete;
+
+private:
+	memory_category previous_;
+};
+}
@@ -1,4 +1,5 @@
 #include "graphics.h"
+#include "destroy_queue.h"
 #include <algorithm>
 #include <map>
 namespace gfx
@@ -99,7 +100,9 @@ void shutdown()
 {
 	if(s_initted)
 	{
+		destroy_queue::flush();
 		bgfx::shutdown();
+		s_initted = false;
 	}
 }
 
@@ -174,6 +177,41 @@ void reset(uint32_t _width, uint32_t _height, uint32_t _flags)
 	bgfx::reset(_width, _height, _flags);
 }
 
+namespace
+{
+/// the encoder the draw calls of a thread go to, none on the API thread
+thread_local encoder* s_thread_encoder = nullptr;
+}
+
+void set_thread_encoder(encoder* _encoder)
+{
+	s_thread_encoder = _encoder;
+}
+
+encoder* get_thread_encoder()
+{
+	return s_thread_encoder;
+}
+
+scoped_encoder::scoped_encoder()
+	: encoder_(begin())
+	, previous_(get_thread_encoder())
+{
+	if(encoder_)
+	{
+		set_thread_encoder(encoder_);
+	}
+}
+
+scoped_encoder::~scoped_encoder()
+{
+	if(encoder_)
+	{
+		set_thread_encoder(previous_);
+		end(encoder_);
+	}
+}
+
 encoder* begin()
 {
 	return bgfx::begin();
@@ -189,6 +227,11 @@ uint32_t frame(bool _capture)
 	return bgfx::frame(_capture);
 }
 
+void render_frame()
+{
+	bgfx::renderFrame();
+}
+
 renderer_type get_renderer_type()
 {
 	return bgfx::getRendererType();
@@ -224,6 +267,14 @@ const memory_view* make_ref(const void* _data, uint32_t _size, release_fn _relea
 	return bgfx::makeRef(_data, _size, _releaseFn, _userData);
 }
 
+const memory_view* make_ref(const void* _data, uint32_t _size, std::shared_ptr<const void> _owner)
+{
+	using holder_t = std::shared_ptr<const void>;
+	auto holder = new holder_t(std::move(_owner));
+	const auto release = [](void*, void* user_data) { delete static_cast<holder_t*>(user_data); };
+	return bgfx::makeRef(_data, _size, release, holder);
+}
+
 void set_debug(uint32_t _debug)
 {
 	bgfx::setDebug(_debug);
@@ -612,178 +663,345 @@ void reset_view(view_id _id)
 
 void set_marker(const char* _marker)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setMarker(_marker);
+		return;
+	}
 	bgfx::setMarker(_marker);
 }
 
 void set_state(uint64_t _state, uint32_t _rgba)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setState(_state, _rgba);
+		return;
+	}
 	bgfx::setState(_state, _rgba);
 }
 
 void set_condition(occlusion_query_handle _handle, bool _visible)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setCondition(_handle, _visible);
+		return;
+	}
 	bgfx::setCondition(_handle, _visible);
 }
 
 void set_stencil(uint32_t _fstencil, uint32_t _bstencil)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setStencil(_fstencil, _bstencil);
+		return;
+	}
 	bgfx::setStencil(_fstencil, _bstencil);
 }
 
 uint16_t set_scissor(uint16_t _x, uint16_t _y, uint16_t _width, uint16_t _height)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		return encoder->setScissor(_x, _y, _width, _height);
+	}
 	return bgfx::setScissor(_x, _y, _width, _height);
 }
 
 void set_scissor(uint16_t _cache)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setScissor(_cache);
+		return;
+	}
 	bgfx::setScissor(_cache);
 }
 
 uint32_t set_transform(const void* _mtx, uint16_t _num)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		return encoder->setTransform(_mtx, _num);
+	}
 	return bgfx::setTransform(_mtx, _num);
 }
 
 uint32_t alloc_transform(transform* _transform, uint16_t _num)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		return encoder->allocTransform(_transform, _num);
+	}
 	return bgfx::allocTransform(_transform, _num);
 }
 
 void set_transform(uint32_t _cache, uint16_t _num)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setTransform(_cache, _num);
+		return;
+	}
 	bgfx::setTransform(_cache, _num);
 }
 
 void set_uniform(uniform_handle _handle, const void* _value, uint16_t _num)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setUniform(_handle, _value, _num);
+		return;
+	}
 	bgfx::setUniform(_handle, _value, _num);
 }
 
 void set_index_buffer(index_buffer_handle _handle, uint32_t _firstIndex, uint32_t _numIndices)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setIndexBuffer(_handle, _firstIndex, _numIndices);
+		return;
+	}
 	bgfx::setIndexBuffer(_handle, _firstIndex, _numIndices);
 }
 
 void set_index_buffer(dynamic_index_buffer_handle _handle, uint32_t _firstIndex, uint32_t _numIndices)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setIndexBuffer(_handle, _firstIndex, _numIndices);
+		return;
+	}
 	bgfx::setIndexBuffer(_handle, _firstIndex, _numIndices);
 }
 
 void set_index_buffer(const transient_index_buffer* _tib, uint32_t _firstIndex, uint32_t _numIndices)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setIndexBuffer(_tib, _firstIndex, _numIndices);
+		return;
+	}
 	bgfx::setIndexBuffer(_tib, _firstIndex, _numIndices);
 }
 
 void set_vertex_buffer(uint8_t _stream, vertex_buffer_handle _handle, uint32_t _startVertex,
 					   uint32_t _numVertices)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setVertexBuffer(_stream, _handle, _startVertex, _numVertices);
+		return;
+	}
 	bgfx::setVertexBuffer(_stream, _handle, _startVertex, _numVertices);
 }
 
 void set_vertex_buffer(uint8_t _stream, dynamic_vertex_buffer_handle _handle, uint32_t _startVertex,
 					   uint32_t _numVertices)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setVertexBuffer(_stream, _handle, _startVertex, _numVertices);
+		return;
+	}
 	bgfx::setVertexBuffer(_stream, _handle, _startVertex, _numVertices);
 }
 
 void set_vertex_buffer(uint8_t _stream, const transient_vertex_buffer* _tvb, uint32_t _startVertex,
 					   uint32_t _numVertices)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setVertexBuffer(_stream, _tvb, _startVertex, _numVertices);
+		return;
+	}
 	bgfx::setVertexBuffer(_stream, _tvb, _startVertex, _numVertices);
 }
 
 void set_instance_data_buffer(const instance_data_buffer* _idb, uint32_t _start, uint32_t _num)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setInstanceDataBuffer(_idb, _start, _num);
+		return;
+	}
 	bgfx::setInstanceDataBuffer(_idb, _start, _num);
 }
 
 void set_instance_data_buffer(vertex_buffer_handle _handle, uint32_t _startVertex, uint32_t _num)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setInstanceDataBuffer(_handle, _startVertex, _num);
+		return;
+	}
 	bgfx::setInstanceDataBuffer(_handle, _startVertex, _num);
 }
 
 void set_instance_data_buffer(dynamic_vertex_buffer_handle _handle, uint32_t _startVertex, uint32_t _num)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setInstanceDataBuffer(_handle, _startVertex, _num);
+		return;
+	}
 	bgfx::setInstanceDataBuffer(_handle, _startVertex, _num);
 }
 
 void set_texture(uint8_t _stage, uniform_handle _sampler, texture_handle _handle, uint32_t _flags)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setTexture(_stage, _sampler, _handle, _flags);
+		return;
+	}
 	bgfx::setTexture(_stage, _sampler, _handle, _flags);
 }
 
 void touch(view_id _id)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->touch(_id);
+		return;
+	}
 	bgfx::touch(_id);
 }
 
 void submit(view_id _id, program_handle _handle, int32_t _depth, bool _preserveState)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->submit(_id, _handle, _depth, _preserveState);
+		return;
+	}
 	bgfx::submit(_id, _handle, _depth, _preserveState);
 }
 
 void submit(view_id _id, program_handle _program, occlusion_query_handle _occlusionQuery, int32_t _depth,
 			bool _preserveState)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->submit(_id, _program, _occlusionQuery, _depth, _preserveState);
+		return;
+	}
 	bgfx::submit(_id, _program, _occlusionQuery, _depth, _preserveState);
 }
 
 void submit(view_id _id, program_handle _handle, indirect_buffer_handle _indirectHandle, uint16_t _start,
 			uint16_t _num, int32_t _depth, bool _preserveState)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->submit(_id, _handle, _indirectHandle, _start, _num, _depth, _preserveState);
+		return;
+	}
 	bgfx::submit(_id, _handle, _indirectHandle, _start, _num, _depth, _preserveState);
 }
 
 void set_image(uint8_t _stage, texture_handle _handle, uint8_t _mip, access _access, texture_format _format)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setImage(_stage, _handle, _mip, _access, _format);
+		return;
+	}
 	bgfx::setImage(_stage, _handle, _mip, _access, _format);
 }
 
 void set_buffer(uint8_t _stage, index_buffer_handle _handle, access _access)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setBuffer(_stage, _handle, _access);
+		return;
+	}
 	bgfx::setBuffer(_stage, _handle, _access);
 }
 
 void set_buffer(uint8_t _stage, vertex_buffer_handle _handle, access _access)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setBuffer(_stage, _handle, _access);
+		return;
+	}
 	bgfx::setBuffer(_stage, _handle, _access);
 }
 
 void set_buffer(uint8_t _stage, dynamic_index_buffer_handle _handle, access _access)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setBuffer(_stage, _handle, _access);
+		return;
+	}
 	bgfx::setBuffer(_stage, _handle, _access);
 }
 
 void set_buffer(uint8_t _stage, dynamic_vertex_buffer_handle _handle, access _access)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setBuffer(_stage, _handle, _access);
+		return;
+	}
 	bgfx::setBuffer(_stage, _handle, _access);
 }
 
 void set_buffer(uint8_t _stage, indirect_buffer_handle _handle, access _access)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->setBuffer(_stage, _handle, _access);
+		return;
+	}
 	bgfx::setBuffer(_stage, _handle, _access);
 }
 
 void dispatch(view_id _id, program_handle _handle, uint32_t _numX, uint32_t _numY, uint32_t _numZ)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->dispatch(_id, _handle, _numX, _numY, _numZ);
+		return;
+	}
 	bgfx::dispatch(_id, _handle, _numX, _numY, _numZ);
 }
 
 void dispatch(view_id _id, program_handle _handle, indirect_buffer_handle _indirectHandle, uint16_t _start,
 			  uint16_t _num)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->dispatch(_id, _handle, _indirectHandle, _start, _num);
+		return;
+	}
 	bgfx::dispatch(_id, _handle, _indirectHandle, _start, _num);
 }
 
 void discard()
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->discard();
+		return;
+	}
 	bgfx::discard();
 }
 
 void blit(view_id _id, texture_handle _dst, uint16_t _dstX, uint16_t _dstY, texture_handle _src,
 		  uint16_t _srcX, uint16_t _srcY, uint16_t _width, uint16_t _height)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->blit(_id, _dst, _dstX, _dstY, _src, _srcX, _srcY, _width, _height);
+		return;
+	}
 	bgfx::blit(_id, _dst, _dstX, _dstY, _src, _srcX, _srcY, _width, _height);
 }
 
@@ -791,6 +1009,12 @@ void blit(view_id _id, texture_handle _dst, uint8_t _dstMip, uint16_t _dstX, uin
 		  texture_handle _src, uint8_t _srcMip, uint16_t _srcX, uint16_t _srcY, uint16_t _srcZ,
 		  uint16_t _width, uint16_t _height, uint16_t _depth)
 {
+	if(auto encoder = get_thread_encoder())
+	{
+		encoder->blit(_id, _dst, _dstMip, _dstX, _dstY, _dstZ, _src, _srcMip, _srcX, _srcY, _srcZ, _width,
+					  _height, _depth);
+		return;
+	}
 	bgfx::blit(_id, _dst, _dstMip, _dstX, _dstY, _dstZ, _src, _srcMip, _srcX, _srcY, _srcZ, _width, _height,
 			   _depth);
 }
@@ -8,6 +8,7 @@
 #include "vertex_decl.h"
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 
 namespace gfx
@@ -102,9 +103,38 @@ encoder* begin();
 /**/
 void end(encoder* _encoder);
 
+/// Routes the draw state and submit calls made on the calling thread to the
+/// encoder, nullptr goes back to the global API of the API thread.
+void set_thread_encoder(encoder* _encoder);
+
+/**/
+encoder* get_thread_encoder();
+
+/// Begins an encoder and routes the draw calls of the calling thread to it
+/// until destroyed. Has no encoder when bgfx runs out of them.
+struct scoped_encoder
+{
+	scoped_encoder();
+	~scoped_encoder();
+	scoped_encoder(const scoped_encoder&) = delete;
+	scoped_encoder& operator=(const scoped_encoder&) = delete;
+
+	encoder* get() const
+	{
+		return encoder_;
+	}
+
+private:
+	encoder* encoder_ = nullptr;
+	encoder* previous_ = nullptr;
+};
+
 /**/
 uint32_t frame(bool _capture = true);
 
+/**/
+void render_frame();
+
 /**/
 renderer_type get_renderer_type();
 
@@ -127,6 +157,10 @@ const memory_view* make_ref(const void* _data, uint32_t _size);
 const memory_view* make_ref(const void* _data, uint32_t _size, release_fn _releaseFn = nullptr,
 							void* _userData = nullptr);
 
+/// References memory that the owner keeps alive, e.g. a mapped file, bgfx
+/// reads it in place and lets go of the owner once it releases the memory.
+const memory_view* make_ref(const void* _data, uint32_t _size, std::shared_ptr<const void> _owner);
+
 /**/
 void set_debug(uint32_t _debug);
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "destroy_queue.h"
+#include "gpu_memory.h"
 #include "graphics.h"
 
 namespace gfx
@@ -17,11 +19,18 @@ public:
 		dispose();
 	}
 
+	// the handle may still be used by the frames in flight and the last
+	// reference may be dropped on any thread, it is destroyed by the queue
 	void dispose()
 	{
 		if(is_valid())
 		{
-			bgfx::destroy(handle);
+			destroy_queue::push(handle);
+		}
+		if(memory_size_ != 0)
+		{
+			gpu_memory::remove(memory_category_, memory_size_);
+			memory_size_ = 0;
 		}
 
 		handle = invalid_handle();
@@ -43,7 +52,37 @@ public:
 		return invalid;
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_memory_size ()
+	/// <summary>
+	/// The bytes of gpu memory the resource takes, 0 when it doesn't own it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint64_t get_memory_size() const
+	{
+		return memory_size_;
+	}
+
+	memory_category get_memory_category() const
+	{
+		return memory_category_;
+	}
+
 protected:
+	// counts the created handle in the current category of the thread
+	void track_memory(std::uint64_t size)
+	{
+		if(!is_valid() || size == 0)
+		{
+			return;
+		}
+		memory_category_ = gpu_memory::get_current_category();
+		memory_size_ = size;
+		gpu_memory::add(memory_category_, memory_size_);
+	}
+
 	T handle = invalid_handle();
+	std::uint64_t memory_size_ = 0;
+	memory_category memory_category_ = memory_category::other;
 };
 }
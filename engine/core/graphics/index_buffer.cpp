@@ -5,5 +5,6 @@ namespace gfx
 index_buffer::index_buffer(const memory_view* _mem, std::uint16_t _flags /*= BGFX_BUFFER_NONE*/)
 {
 	handle = create_index_buffer(_mem, _flags);
+	track_memory(_mem != nullptr ? _mem->size : 0);
 }
 }
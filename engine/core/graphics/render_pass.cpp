@@ -1,30 +1,80 @@
 #include "render_pass.h"
-#include <bitset>
-#include <limits>
+#include <algorithm>
+#include <numeric>
 namespace gfx
 {
+namespace
+{
+struct view_entry
+{
+	std::int32_t order = 0;
+	std::uint64_t merge_key = 0;
+};
 
-static gfx::view_id& get_counter()
+struct view_allocator
 {
-	static gfx::view_id id = 0;
-	return id;
+	/// the views taken in the frame, by their id
+	std::vector<view_entry> views;
+	render_pass::frame_stats stats;
+	render_pass::frame_stats last_stats;
+};
+
+view_allocator& get_allocator()
+{
+	static view_allocator allocator;
+	return allocator;
 }
-gfx::view_id generate_id()
+
+gfx::view_id generate_id(std::int32_t order)
 {
-	auto& counter = get_counter();
-	if(counter == MAX_RENDER_PASSES - 1)
+	auto& allocator = get_allocator();
+	if(allocator.views.size() == MAX_RENDER_PASSES - 1)
 	{
+		// the views of the frame so far run before the others
+		render_pass::submit_order();
 		frame();
-		counter = 0;
+		allocator.views.clear();
+		++allocator.stats.overflows;
 	}
-	gfx::view_id idx = counter++;
 
-	return idx;
+	view_entry entry;
+	entry.order = order;
+	allocator.views.push_back(entry);
+	++allocator.stats.views;
+	return gfx::view_id(allocator.views.size() - 1);
+}
+
+// the view of a pass of the same key and order taken in the frame
+bool find_merged(std::int32_t order, std::uint64_t merge_key, gfx::view_id& id)
+{
+	const auto& views = get_allocator().views;
+	for(std::size_t i = 0; i < views.size(); ++i)
+	{
+		if(views[i].merge_key == merge_key && views[i].order == order)
+		{
+			id = gfx::view_id(i);
+			return true;
+		}
+	}
+	return false;
+}
 }
 
 render_pass::render_pass(const std::string& n)
-    : id(generate_id())
+	: render_pass(n, 0)
+{
+}
+
+render_pass::render_pass(const std::string& n, std::int32_t order, std::uint64_t merge_key)
 {
+	if(merge_key != 0 && find_merged(order, merge_key, id))
+	{
+		++get_allocator().stats.merged;
+		return;
+	}
+
+	id = generate_id(order);
+	get_allocator().views[id].merge_key = merge_key;
 	reset_view(id);
 	set_view_name(id, n.c_str());
 }
@@ -49,6 +99,13 @@ void render_pass::bind(const frame_buffer* fb) const
 	touch();
 }
 
+void render_pass::set_rect(std::uint16_t _x, std::uint16_t _y, std::uint16_t _width,
+						   std::uint16_t _height) const
+{
+	set_view_rect(id, _x, _y, _width, _height);
+	set_view_scissor(id, _x, _y, _width, _height);
+}
+
 void render_pass::touch() const
 {
 	gfx::touch(id);
@@ -71,19 +128,47 @@ void render_pass::set_view_proj(const float* v, const float* p)
 	set_view_transform(id, v, p);
 }
 
+void render_pass::submit_order()
+{
+	const auto& views = get_allocator().views;
+	// the views of the default order run by their ids
+	const bool by_id = std::all_of(std::begin(views), std::end(views),
+								   [](const view_entry& entry) { return entry.order == 0; });
+	if(by_id)
+	{
+		set_view_order();
+		return;
+	}
+
+	std::vector<gfx::view_id> order(views.size());
+	std::iota(std::begin(order), std::end(order), gfx::view_id(0));
+	std::stable_sort(std::begin(order), std::end(order), [&views](gfx::view_id lhs, gfx::view_id rhs) {
+		return views[lhs].order < views[rhs].order;
+	});
+	set_view_order(0, std::uint16_t(order.size()), order.data());
+}
+
 void render_pass::reset()
 {
-	auto& count = get_counter();
-	count = 0;
+	auto& allocator = get_allocator();
+	allocator.views.clear();
+	allocator.last_stats = allocator.stats;
+	allocator.stats = {};
+}
+
+render_pass::frame_stats render_pass::get_frame_stats()
+{
+	return get_allocator().last_stats;
 }
 
 gfx::view_id render_pass::get_pass()
 {
-	auto counter = get_counter();
-	if(counter == 0)
-	{
-		counter = MAX_RENDER_PASSES;
-	}
-	return counter - 1;
+	const auto count = get_allocator().views.size();
+	return gfx::view_id(count == 0 ? MAX_RENDER_PASSES - 1 : count - 1);
+}
+
+gfx::view_id render_pass::get_next_id()
+{
+	return gfx::view_id(get_allocator().views.size());
 }
 }
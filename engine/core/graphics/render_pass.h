@@ -1,13 +1,35 @@
 #pragma once
 #include "frame_buffer.h"
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 namespace gfx
 {
+/*
+ * render_pass; a bgfx view taken for the frame.
+ *
+ *      The views are handed out from 0 every frame and run by their order,
+ *      then in the order they were taken: submit_order remaps them with
+ *      set_view_order before the frame is submitted. A pass made with the
+ *      merge key of one taken before in the frame, with the same order,
+ *      shares its view. The passes merged must bind the same frame buffer,
+ *      rect and transforms, only the first one clears. Running out of views
+ *      submits the frame early, which the stats count.
+ */
 struct render_pass
 {
+	struct frame_stats
+	{
+		/// the views taken
+		std::uint32_t views = 0;
+		/// the passes that shared the view of another
+		std::uint32_t merged = 0;
+		/// the times the views ran out and the frame was submitted early
+		std::uint32_t overflows = 0;
+	};
+
 	//-----------------------------------------------------------------------------
 	//  Name : render_pass ()
 	/// <summary>
@@ -18,6 +40,16 @@ struct render_pass
 	//-----------------------------------------------------------------------------
 	render_pass(const std::string& n);
 
+	//-----------------------------------------------------------------------------
+	//  Name : render_pass ()
+	/// <summary>
+	/// A pass running after those of a lower order, whenever it is made. A
+	/// merge key other than 0 has the passes of the same key and order in the
+	/// frame share one view.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	render_pass(const std::string& n, std::int32_t order, std::uint64_t merge_key = 0);
+
 	//-----------------------------------------------------------------------------
 	//  Name : bind ()
 	/// <summary>
@@ -28,6 +60,16 @@ struct render_pass
 	//-----------------------------------------------------------------------------
 	void bind(const frame_buffer* fb = nullptr) const;
 	void touch() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_rect ()
+	/// <summary>
+	/// Limits the view and its scissor to a part of the bound frame buffer,
+	/// call it after bind.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_rect(std::uint16_t _x, std::uint16_t _y, std::uint16_t _width, std::uint16_t _height) const;
+
 	//-----------------------------------------------------------------------------
 	//  Name : clear ()
 	/// <summary>
@@ -59,16 +101,31 @@ struct render_pass
 	//-----------------------------------------------------------------------------
 	void set_view_proj(const float* v, const float* p);
 
+	//-----------------------------------------------------------------------------
+	//  Name : submit_order ()
+	/// <summary>
+	/// Sets the order the views of the frame run in, by their orders. Call it
+	/// before the frame is submitted.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void submit_order();
+
 	//-----------------------------------------------------------------------------
 	//  Name : reset ()
 	/// <summary>
-	///
-	///
-	///
+	/// Starts the views of a new frame, after it was submitted.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	static void reset();
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_frame_stats ()
+	/// <summary>
+	/// The views of the last frame reset.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static frame_stats get_frame_stats();
+
 	//-----------------------------------------------------------------------------
 	//  Name : get_pass ()
 	/// <summary>
@@ -78,6 +135,15 @@ struct render_pass
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	static gfx::view_id get_pass();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_next_id ()
+	/// <summary>
+	/// The id the next render pass takes, the ids go up until the passes are
+	/// reset or run out.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static gfx::view_id get_next_id();
 	///
 	gfx::view_id id;
 };
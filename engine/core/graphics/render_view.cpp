@@ -1,7 +1,45 @@
 #include "render_view.h"
 
+#include <algorithm>
+
 namespace gfx
 {
+namespace
+{
+struct pooled_texture
+{
+	texture_key key;
+	std::shared_ptr<texture> tex;
+	/// taken or given back since the last collect
+	bool used = true;
+};
+
+render_tier& get_tier()
+{
+	static render_tier tier = render_tier::high;
+	return tier;
+}
+
+texture_format get_normal_format(render_tier tier)
+{
+	static const auto half =
+		get_best_format(BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER, format_search_flags::four_channels |
+																  format_search_flags::requires_alpha |
+																  format_search_flags::half_precision_float);
+	static const auto packed =
+		is_format_supported(BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER, texture_format::RGB10A2)
+			? texture_format::RGB10A2
+			: half;
+	return tier == render_tier::low ? packed : half;
+}
+
+/// the released transient targets of every view
+std::vector<pooled_texture>& get_transient_pool()
+{
+	static std::vector<pooled_texture> pool;
+	return pool;
+}
+}
 
 std::shared_ptr<texture> render_view::get_texture(const std::string& id, std::uint16_t _width,
 												  std::uint16_t _height, bool _hasMips,
@@ -24,6 +62,7 @@ std::shared_ptr<texture> render_view::get_texture(const std::string& id, std::ui
 	}
 	else
 	{
+		scoped_memory_category scope(memory_category_);
 		tex = std::make_shared<texture>(_width, _height, _hasMips, _numLayers, _format, _flags, _mem);
 		textures_[key] = std::pair<std::shared_ptr<texture>, bool>(tex, true);
 	}
@@ -54,6 +93,7 @@ std::shared_ptr<texture> render_view::get_texture(const std::string& id, backbuf
 	}
 	else
 	{
+		scoped_memory_category scope(memory_category_);
 		tex = std::make_shared<texture>(_ratio, _hasMips, _numLayers, _format, _flags);
 		textures_[key] = std::pair<std::shared_ptr<texture>, bool>(tex, true);
 	}
@@ -82,6 +122,7 @@ std::shared_ptr<texture> render_view::get_texture(const std::string& id, std::ui
 	}
 	else
 	{
+		scoped_memory_category scope(memory_category_);
 		tex = std::make_shared<texture>(_width, _height, _depth, _hasMips, _format, _flags, _mem);
 		textures_[key] = std::pair<std::shared_ptr<texture>, bool>(tex, true);
 	}
@@ -109,6 +150,7 @@ std::shared_ptr<texture> render_view::get_texture(const std::string& id, std::ui
 	}
 	else
 	{
+		scoped_memory_category scope(memory_category_);
 		tex = std::make_shared<texture>(_size, _hasMips, _numLayers, _format, _flags, _mem);
 		textures_[key] = std::pair<std::shared_ptr<texture>, bool>(tex, true);
 	}
@@ -168,19 +210,133 @@ std::shared_ptr<frame_buffer> render_view::get_g_buffer_fbo(const usize32_t& vie
 	static auto format =
 		get_best_format(BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER,
 						format_search_flags::four_channels | format_search_flags::requires_alpha);
-	static auto normal_format =
-		get_best_format(BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER, format_search_flags::four_channels |
-																  format_search_flags::requires_alpha |
-																  format_search_flags::half_precision_float);
+	// the octahedral normal and the roughness, 10 bits each fit them
+	const auto normal_format = get_normal_format(get_tier());
 	auto depth_buffer = get_depth_buffer(viewport_size);
-	auto buffer0 = get_texture("GBUFFER0", viewport_size.width, viewport_size.height, false, 1, format);
+	// the depth stays with the view, the output is drawn over it
+	auto buffer0 =
+		get_transient_texture("GBUFFER0", viewport_size.width, viewport_size.height, false, 1, format);
 	auto buffer1 =
-		get_texture("GBUFFER1", viewport_size.width, viewport_size.height, false, 1, normal_format);
-	auto buffer2 = get_texture("GBUFFER2", viewport_size.width, viewport_size.height, false, 1, format);
-	auto buffer3 = get_texture("GBUFFER3", viewport_size.width, viewport_size.height, false, 1, format);
+		get_transient_texture("GBUFFER1", viewport_size.width, viewport_size.height, false, 1, normal_format);
+	auto buffer2 =
+		get_transient_texture("GBUFFER2", viewport_size.width, viewport_size.height, false, 1, format);
+	auto buffer3 =
+		get_transient_texture("GBUFFER3", viewport_size.width, viewport_size.height, false, 1, format);
 	return get_fbo("GBUFFER", {buffer0, buffer1, buffer2, buffer3, depth_buffer});
 }
 
+void render_view::set_render_tier(render_tier tier)
+{
+	get_tier() = tier;
+}
+
+render_tier render_view::get_render_tier()
+{
+	return get_tier();
+}
+
+texture_format render_view::get_light_buffer_format()
+{
+	static const auto half =
+		get_best_format(BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER, format_search_flags::four_channels |
+																  format_search_flags::requires_alpha |
+																  format_search_flags::half_precision_float);
+	static const auto packed =
+		is_format_supported(BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER, texture_format::RG11B10F)
+			? texture_format::RG11B10F
+			: half;
+	return get_tier() == render_tier::low ? packed : half;
+}
+
+std::shared_ptr<texture> render_view::get_transient_texture(const std::string& id, std::uint16_t _width,
+															std::uint16_t _height, bool _hasMips,
+															std::uint16_t _numLayers, texture_format _format,
+															std::uint64_t _flags)
+{
+	if(!alias_transients_)
+	{
+		return get_texture(id, _width, _height, _hasMips, _numLayers, _format, _flags);
+	}
+
+	// the pool matches on everything but the id
+	texture_key key;
+	calc_texture_size(key.info, _width, _height, 1, false, _hasMips, _numLayers, _format);
+	key.flags = _flags;
+	key.ratio = backbuffer_ratio::Count;
+
+	auto it = transients_.find(id);
+	if(it != transients_.end())
+	{
+		if(it->second.first == key)
+		{
+			return it->second.second;
+		}
+
+		// asked again with another size or format, the old one is not needed
+		get_transient_pool().push_back({it->second.first, it->second.second, true});
+		transients_.erase(it);
+	}
+
+	auto& pool = get_transient_pool();
+	auto pooled = std::find_if(std::begin(pool), std::end(pool),
+							   [&key](const pooled_texture& entry) { return entry.key == key; });
+
+	std::shared_ptr<texture> tex;
+	if(pooled != std::end(pool))
+	{
+		tex = pooled->tex;
+		pool.erase(pooled);
+	}
+	else
+	{
+		scoped_memory_category scope(memory_category::transients);
+		tex = std::make_shared<texture>(_width, _height, _hasMips, _numLayers, _format, _flags);
+	}
+
+	transients_.emplace(id, std::make_pair(key, tex));
+	return tex;
+}
+
+void render_view::release_transient_textures()
+{
+	auto& pool = get_transient_pool();
+	for(auto& pair : transients_)
+	{
+		pool.push_back({pair.second.first, std::move(pair.second.second), true});
+	}
+	transients_.clear();
+}
+
+void render_view::collect_transient_textures()
+{
+	auto& pool = get_transient_pool();
+	pool.erase(std::remove_if(std::begin(pool), std::end(pool),
+							  [](const pooled_texture& entry) { return !entry.used; }),
+			   std::end(pool));
+	for(auto& entry : pool)
+	{
+		entry.used = false;
+	}
+}
+
+void render_view::set_render_scale(float scale)
+{
+	render_scale_ = scale > 0.0f && scale < 1.0f ? scale : 1.0f;
+}
+
+usize32_t render_view::get_render_size(const usize32_t& viewport_size) const
+{
+	if(render_scale_ >= 1.0f)
+	{
+		return viewport_size;
+	}
+
+	const auto scale = [this](std::uint32_t value) {
+		return std::max<std::uint32_t>(std::uint32_t(float(value) * render_scale_ + 0.5f), 1);
+	};
+	return usize32_t(scale(viewport_size.width), scale(viewport_size.height));
+}
+
 void render_view::release_unused_resources()
 {
 	auto check_resources = [](auto& associativie_container) {
@@ -207,4 +363,21 @@ void render_view::release_unused_resources()
 	check_resources(fbos_);
 	check_resources(textures_);
 }
+std::uint64_t render_view::get_memory_size() const
+{
+	std::uint64_t size = 0;
+	for(const auto& pair : textures_)
+	{
+		size += pair.second.first->get_memory_size();
+	}
+	for(const auto& pair : transients_)
+	{
+		size += pair.second.second->get_memory_size();
+	}
+	for(const auto& pair : fbos_)
+	{
+		size += pair.second.first->get_memory_size();
+	}
+	return size;
+}
 } // namespace gfx
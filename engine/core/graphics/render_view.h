@@ -7,10 +7,21 @@
 #include <chrono>
 #include <functional>
 #include <memory>
+#include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace gfx
 {
+/// how wide the targets of the views are, low for gpus bound by bandwidth
+enum class render_tier : std::uint8_t
+{
+	/// half float normals and light buffers
+	high,
+	/// 10 bit octahedral normals and R11G11B10F light buffers where supported
+	low,
+};
 
 class render_view
 {
@@ -37,16 +48,130 @@ public:
 	std::shared_ptr<frame_buffer> get_fbo(const std::string& id,
 										  const std::vector<std::shared_ptr<texture>>& bind_textures);
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_transient_texture ()
+	/// <summary>
+	/// A render target whose content is only needed until the view calls
+	/// release_transient_textures. Released targets go to a pool shared by
+	/// every view and are handed to the next one asking for the same size,
+	/// format and flags, so views that render one after the other share the
+	/// memory. The content of a target just taken is undefined.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<texture> get_transient_texture(const std::string& id, std::uint16_t _width,
+												   std::uint16_t _height, bool _hasMips,
+												   std::uint16_t _numLayers, texture_format _format,
+												   std::uint64_t _flags = get_default_rt_sampler_flags());
+
+	//-----------------------------------------------------------------------------
+	//  Name : release_transient_textures ()
+	/// <summary>
+	/// Gives the transient targets of the view back to the shared pool, call
+	/// it once the last pass reading them is submitted.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void release_transient_textures();
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_alias_transients ()
+	/// <summary>
+	/// With aliasing off the transient targets are kept by the view like the
+	/// others, e.g. to show them after the frame was rendered.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_alias_transients(bool alias)
+	{
+		alias_transients_ = alias;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : collect_transient_textures ()
+	/// <summary>
+	/// Destroys the pooled targets no view took since the last collect. Call
+	/// it once per frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void collect_transient_textures();
+
 	std::shared_ptr<texture> get_depth_stencil_buffer(const usize32_t& viewport_size);
 	std::shared_ptr<texture> get_depth_buffer(const usize32_t& viewport_size);
 	std::shared_ptr<texture> get_output_buffer(const usize32_t& viewport_size);
 	std::shared_ptr<frame_buffer> get_output_fbo(const usize32_t& viewport_size);
 	std::shared_ptr<frame_buffer> get_g_buffer_fbo(const usize32_t& viewport_size);
 
+	//-----------------------------------------------------------------------------
+	//  Name : set_render_tier ()
+	/// <summary>
+	/// The tier the targets of all the views are made for, the g-buffer keeps
+	/// its encoding across tiers, only the widths of the targets change.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void set_render_tier(render_tier tier);
+
+	static render_tier get_render_tier();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_light_buffer_format ()
+	/// <summary>
+	/// The format of the light and reflection buffers of the tier, read as
+	/// rgb only.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static texture_format get_light_buffer_format();
+
 	void release_unused_resources();
 
+	//-----------------------------------------------------------------------------
+	//  Name : set_render_scale ()
+	/// <summary>
+	/// Scale of the viewport the view renders at, the rest of its targets is
+	/// left untouched so a new scale doesn't recreate them.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_render_scale(float scale);
+
+	float get_render_scale() const
+	{
+		return render_scale_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_render_size ()
+	/// <summary>
+	/// Size of the top left part of targets of the viewport size the view
+	/// renders to, at least a pixel.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	usize32_t get_render_size(const usize32_t& viewport_size) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_memory_category ()
+	/// <summary>
+	/// The category the targets the view keeps are counted in, the transient
+	/// ones are counted as transients whatever view created them.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_memory_category(memory_category category)
+	{
+		memory_category_ = category;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_memory_size ()
+	/// <summary>
+	/// The bytes of the targets the view keeps and the transient ones it took.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint64_t get_memory_size() const;
+
 private:
 	std::unordered_map<texture_key, std::pair<std::shared_ptr<texture>, bool>> textures_;
 	std::unordered_map<fbo_key, std::pair<std::shared_ptr<frame_buffer>, bool>> fbos_;
+	/// transient targets taken from the shared pool and not released yet
+	std::unordered_map<std::string, std::pair<texture_key, std::shared_ptr<texture>>> transients_;
+	bool alias_transients_ = true;
+	/// part of the viewport rendered to, in (0, 1]
+	float render_scale_ = 1.0f;
+	memory_category memory_category_ = memory_category::render_views;
 };
 }
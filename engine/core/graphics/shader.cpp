@@ -1,5 +1,7 @@
 #include "shader.h"
 
+#include <utility>
+
 namespace gfx
 {
 shader::shader(const memory_view* mem)
@@ -29,4 +31,12 @@ shader::shader(handle_type_t hndl)
 		}
 	}
 }
+
+void shader::swap(shader& other)
+{
+	std::swap(handle, other.handle);
+	std::swap(uniforms, other.uniforms);
+	std::swap(memory_size_, other.memory_size_);
+	std::swap(memory_category_, other.memory_category_);
+}
 }
@@ -13,6 +13,16 @@ struct shader : public handle_impl<shader_handle>
 	shader(const embedded_shader* _es, const char* name);
 	shader(handle_type_t hndl);
 
+	//-----------------------------------------------------------------------------
+	//  Name : swap ()
+	/// <summary>
+	/// Exchanges the gpu shader and its uniforms with another, to change a
+	/// shader in place while it is referenced, i.e. when it is reloaded. The
+	/// programs made with it are made again as they see the new handle.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void swap(shader& other);
+
 	/// Uniforms for this shader
 	std::vector<std::shared_ptr<uniform>> uniforms;
 };
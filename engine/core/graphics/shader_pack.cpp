@@ -0,0 +1,126 @@
+#include "shader_pack.h"
+
+#include <cstring>
+
+namespace gfx
+{
+namespace
+{
+std::uint32_t count_bits(std::uint32_t mask)
+{
+	std::uint32_t count = 0;
+	for(; mask != 0; mask &= mask - 1)
+	{
+		++count;
+	}
+	return count;
+}
+}
+
+constexpr std::uint32_t shader_pack::magic;
+constexpr std::uint32_t shader_pack::version;
+
+bool shader_pack::is_pack(const std::uint8_t* data, std::size_t size)
+{
+	if(data == nullptr || size < sizeof(header))
+	{
+		return false;
+	}
+	header h;
+	std::memcpy(&h, data, sizeof(header));
+	return h.magic == magic && h.version == version;
+}
+
+bool shader_pack::find(const std::uint8_t* data, std::size_t size, const std::string& defines,
+					   std::size_t& offset, std::size_t& length)
+{
+	if(!is_pack(data, size))
+	{
+		return false;
+	}
+
+	header h;
+	std::memcpy(&h, data, sizeof(header));
+	const auto entries_offset = std::uint64_t(sizeof(header)) + h.features_size;
+	if(entries_offset + std::uint64_t(h.entries_count) * sizeof(entry) > size)
+	{
+		return false;
+	}
+
+	// the mask of the defines the shader has
+	std::uint32_t wanted = 0;
+	const char* name = reinterpret_cast<const char*>(data + sizeof(header));
+	const char* names_end = name + h.features_size;
+	for(std::uint32_t bit = 0; bit < h.features_count && name < names_end; ++bit)
+	{
+		const auto name_size = std::strlen(name);
+		for(std::size_t begin = 0; begin <= defines.size();)
+		{
+			auto end = defines.find(';', begin);
+			end = end == std::string::npos ? defines.size() : end;
+			if(defines.compare(begin, end - begin, name, name_size) == 0)
+			{
+				wanted |= 1u << bit;
+			}
+			begin = end + 1;
+		}
+		name += name_size + 1;
+	}
+
+	bool found = false;
+	std::uint32_t best = 0;
+	for(std::uint32_t i = 0; i < h.entries_count; ++i)
+	{
+		entry e;
+		std::memcpy(&e, data + entries_offset + i * sizeof(entry), sizeof(entry));
+		if((e.mask & ~wanted) != 0 || std::uint64_t(e.offset) + e.size > size)
+		{
+			continue;
+		}
+		if(!found || count_bits(e.mask) > count_bits(best))
+		{
+			found = true;
+			best = e.mask;
+			offset = e.offset;
+			length = e.size;
+		}
+	}
+	return found;
+}
+
+bool shader_pack::write(std::ostream& stream, const std::vector<std::string>& features,
+						const std::vector<variant>& variants)
+{
+	std::string names;
+	for(const auto& feature : features)
+	{
+		names += feature;
+		names += '\0';
+	}
+
+	header h;
+	h.magic = magic;
+	h.version = version;
+	h.features_count = std::uint32_t(features.size());
+	h.features_size = std::uint32_t(names.size());
+	h.entries_count = std::uint32_t(variants.size());
+
+	auto offset = std::uint32_t(sizeof(header) + names.size() + variants.size() * sizeof(entry));
+	stream.write(reinterpret_cast<const char*>(&h), sizeof(h));
+	stream.write(names.data(), std::streamsize(names.size()));
+	for(const auto& v : variants)
+	{
+		entry e;
+		e.mask = v.first;
+		e.offset = offset;
+		e.size = std::uint32_t(v.second.size());
+		offset += e.size;
+		stream.write(reinterpret_cast<const char*>(&e), sizeof(e));
+	}
+	for(const auto& v : variants)
+	{
+		stream.write(v.second.data(), std::streamsize(v.second.size()));
+	}
+	return bool(stream);
+}
+}
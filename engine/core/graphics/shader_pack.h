@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gfx
+{
+/*
+ * shader_pack; the variants of a shader compiled into one file, so that any
+ * of them loads with the one read.
+ *
+ *      A variant is the set of features of the manifest of the source it was
+ *      compiled with, as the bits of a mask in the order of the manifest.
+ *      The file is a header, the names of the features each ended by a zero,
+ *      the entries of the variants and then their binaries. The integers are
+ *      little endian.
+ */
+class shader_pack
+{
+public:
+	struct header
+	{
+		std::uint32_t magic = 0;
+		std::uint32_t version = 0;
+		std::uint32_t features_count = 0;
+		std::uint32_t features_size = 0;
+		std::uint32_t entries_count = 0;
+	};
+
+	struct entry
+	{
+		std::uint32_t mask = 0;
+		std::uint32_t offset = 0;
+		std::uint32_t size = 0;
+	};
+
+	using variant = std::pair<std::uint32_t, std::vector<char>>;
+
+	static constexpr std::uint32_t magic = 0x4b504853; // SHPK
+	static constexpr std::uint32_t version = 1;
+
+	static bool is_pack(const std::uint8_t* data, std::size_t size);
+
+	//-----------------------------------------------------------------------------
+	//  Name : find ()
+	/// <summary>
+	/// The binary of the variant of the defines, separated by ';'. The
+	/// defines that are not features of the shader are ignored, and when the
+	/// variant was pruned the one of the most of its features is taken.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool find(const std::uint8_t* data, std::size_t size, const std::string& defines,
+					 std::size_t& offset, std::size_t& length);
+
+	//-----------------------------------------------------------------------------
+	//  Name : write ()
+	/// <summary>
+	/// Writes the pack of the variants compiled for the features.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool write(std::ostream& stream, const std::vector<std::string>& features,
+					  const std::vector<variant>& variants);
+};
+}
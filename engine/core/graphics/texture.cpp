@@ -1,5 +1,7 @@
 #include "texture.h"
 
+#include <utility>
+
 namespace gfx
 {
 
@@ -18,6 +20,7 @@ texture::texture(const memory_view* _mem, std::uint64_t _flags,
 	{
 		info = *pInfo;
 	}
+	track_memory(info.storageSize);
 
 	flags = _flags;
 	ratio = backbuffer_ratio::Count;
@@ -30,6 +33,7 @@ texture::texture(std::uint16_t _width, std::uint16_t _height, bool _hasMips, std
 	handle = create_texture_2d(_width, _height, _hasMips, _numLayers, _format, _flags, _mem);
 
 	calc_texture_size(info, _width, _height, 1, false, _hasMips, _numLayers, _format);
+	track_memory(gfx::get_memory_size(_width, _height, 1, false, _hasMips, _numLayers, _format, _flags));
 
 	flags = _flags;
 	ratio = backbuffer_ratio::Count;
@@ -42,6 +46,7 @@ texture::texture(std::uint16_t _width, std::uint16_t _height, std::uint16_t _dep
 	handle = create_texture_3d(_width, _height, _depth, _hasMips, _format, _flags, _mem);
 
 	calc_texture_size(info, _width, _height, _depth, false, _hasMips, 1, _format);
+	track_memory(gfx::get_memory_size(_width, _height, _depth, false, _hasMips, 1, _format, _flags));
 
 	flags = _flags;
 	ratio = backbuffer_ratio::Count;
@@ -53,6 +58,7 @@ texture::texture(std::uint16_t _size, bool _hasMips, std::uint16_t _numLayers, t
 	handle = create_texture_cube(_size, _hasMips, _numLayers, _format, _flags, _mem);
 
 	calc_texture_size(info, _size, _size, _size, false, _hasMips, _numLayers, _format);
+	track_memory(gfx::get_memory_size(_size, _size, 1, true, _hasMips, _numLayers, _format, _flags));
 
 	flags = _flags;
 	ratio = backbuffer_ratio::Count;
@@ -67,6 +73,7 @@ texture::texture(backbuffer_ratio _ratio, bool _hasMips, std::uint16_t _numLayer
 	std::uint16_t _height = 0;
 	get_size_from_ratio(_ratio, _width, _height);
 	calc_texture_size(info, _width, _height, 1, false, _hasMips, _numLayers, _format);
+	track_memory(gfx::get_memory_size(_width, _height, 1, false, _hasMips, _numLayers, _format, _flags));
 
 	flags = _flags;
 	ratio = _ratio;
@@ -93,4 +100,14 @@ bool texture::is_render_target() const
 {
 	return 0 != (flags & BGFX_TEXTURE_RT_MASK);
 }
+
+void texture::swap(texture& other)
+{
+	std::swap(handle, other.handle);
+	std::swap(info, other.info);
+	std::swap(flags, other.flags);
+	std::swap(ratio, other.ratio);
+	std::swap(memory_size_, other.memory_size_);
+	std::swap(memory_category_, other.memory_category_);
+}
 }
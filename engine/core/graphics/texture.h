@@ -95,6 +95,15 @@ struct texture : public handle_impl<texture_handle>
 	//-----------------------------------------------------------------------------
 	bool is_render_target() const;
 
+	//-----------------------------------------------------------------------------
+	//  Name : swap ()
+	/// <summary>
+	/// Exchanges the gpu texture and its description with another, to change
+	/// a texture in place while it is referenced, i.e. with more mips.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void swap(texture& other);
+
 	/// Texture detail info.
 	texture_info info;
 	/// Creation flags.
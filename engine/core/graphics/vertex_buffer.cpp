@@ -7,5 +7,6 @@ vertex_buffer::vertex_buffer(const memory_view* _mem, const vertex_layout& _decl
 							 std::uint16_t _flags /*= BGFX_BUFFER_NONE*/)
 {
 	handle = create_vertex_buffer(_mem, _decl, _flags);
+	track_memory(_mem != nullptr ? _mem->size : 0);
 }
 }
@@ -23,6 +23,17 @@ void mesh_vertex::init(vertex_layout& decl)
 		.end();
 }
 
+void compact_mesh_vertex::init(vertex_layout& decl)
+{
+	decl.begin()
+		.add(attribute::Position, 3, attribute_type::Half)
+		.add(attribute::Normal, 3, attribute_type::Uint8, true, true)
+		.add(attribute::Tangent, 3, attribute_type::Uint8, true, true)
+		.add(attribute::Bitangent, 3, attribute_type::Uint8, true, true)
+		.add(attribute::TexCoord0, 2, attribute_type::Half)
+		.end();
+}
+
 void pos_texcoord0_color0_vertex::init(vertex_layout& decl)
 {
 	decl.begin()
@@ -31,4 +42,12 @@ void pos_texcoord0_color0_vertex::init(vertex_layout& decl)
 		.add(attribute::Color0, 4, attribute_type::Uint8, true)
 		.end();
 }
+
+void pos_color0_vertex::init(vertex_layout& decl)
+{
+	decl.begin()
+		.add(attribute::Position, 3, attribute_type::Float)
+		.add(attribute::Color0, 4, attribute_type::Uint8, true)
+		.end();
+}
 }
@@ -2,6 +2,8 @@
 
 #include "bgfx/bgfx.h"
 
+#include <cstdint>
+
 namespace gfx
 {
 
@@ -40,8 +42,26 @@ struct mesh_vertex : vertex<mesh_vertex>
 	static void init(vertex_layout& decl);
 };
 
+/// mesh_vertex with half positions and texture coordinates, a quarter smaller.
+/// Needs the half attribute caps, the mesh keeps the layout it is prepared with.
+struct compact_mesh_vertex : vertex<compact_mesh_vertex>
+{
+	static void init(vertex_layout& decl);
+};
+
 struct pos_texcoord0_color0_vertex : vertex<pos_texcoord0_color0_vertex>
 {
 	static void init(vertex_layout& decl);
 };
+
+struct pos_color0_vertex : vertex<pos_color0_vertex>
+{
+	float x = 0.0f;
+	float y = 0.0f;
+	float z = 0.0f;
+
+	std::uint32_t abgr = 0;
+
+	static void init(vertex_layout& decl);
+};
 }
@@ -0,0 +1,119 @@
+#include "async_file_sink.h"
+
+#include <algorithm>
+
+namespace logging
+{
+
+async_file_sink::async_file_sink(const std::string& filename, bool truncate, std::size_t queue_size,
+								 overflow_policy policy, std::chrono::milliseconds flush_interval)
+	: flush_interval_(flush_interval)
+	, policy_(policy)
+	, slots_(std::max<std::size_t>(queue_size, 1))
+{
+	file_ = std::fopen(filename.c_str(), truncate ? "wb" : "ab");
+	if(file_ == nullptr)
+	{
+		throw spdlog_ex("Failed opening file " + filename + " for writing");
+	}
+	thread_ = std::thread([this]() { run(); });
+}
+
+async_file_sink::~async_file_sink()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	has_messages_.notify_one();
+	thread_.join();
+	std::fclose(file_);
+}
+
+void async_file_sink::_sink_it(const details::log_msg& msg)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	if(count_ == slots_.size())
+	{
+		if(policy_.load(std::memory_order_relaxed) == overflow_policy::drop)
+		{
+			dropped_.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		has_room_.wait(lock, [this]() { return count_ < slots_.size(); });
+	}
+
+	slots_[(head_ + count_) % slots_.size()].assign(msg.formatted.data(), msg.formatted.size());
+	++count_;
+	++queued_;
+	lock.unlock();
+	has_messages_.notify_one();
+}
+
+void async_file_sink::_flush()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	const auto target = queued_;
+	flush_requested_ = true;
+	has_messages_.notify_one();
+	has_written_.wait(lock, [this, target]() { return flushed_ >= target; });
+}
+
+void async_file_sink::run()
+{
+	std::string batch;
+	std::uint64_t reported_dropped = 0;
+	auto last_flush = std::chrono::steady_clock::now();
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	for(;;)
+	{
+		has_messages_.wait_for(lock, flush_interval_,
+							   [this]() { return stop_ || flush_requested_ || count_ > 0; });
+
+		// everything queued is taken at once and written outside the lock
+		batch.clear();
+		for(; count_ > 0; --count_)
+		{
+			batch += slots_[head_];
+			head_ = (head_ + 1) % slots_.size();
+		}
+		const auto taken = queued_;
+		const bool stopping = stop_;
+		bool flush = flush_requested_ || stopping;
+		flush_requested_ = false;
+		lock.unlock();
+		has_room_.notify_all();
+
+		const auto dropped = dropped_.load(std::memory_order_relaxed);
+		if(dropped != reported_dropped)
+		{
+			batch += "[log] " + std::to_string(dropped - reported_dropped) + " messages dropped\n";
+			reported_dropped = dropped;
+		}
+		if(!batch.empty())
+		{
+			std::fwrite(batch.data(), 1, batch.size(), file_);
+		}
+
+		const auto now = std::chrono::steady_clock::now();
+		flush |= now - last_flush >= flush_interval_;
+		if(flush)
+		{
+			std::fflush(file_);
+			last_flush = now;
+		}
+
+		lock.lock();
+		if(flush)
+		{
+			flushed_ = taken;
+			has_written_.notify_all();
+		}
+		if(stopping && count_ == 0)
+		{
+			break;
+		}
+	}
+}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <spdlog/details/null_mutex.h>
+#include <spdlog/sinks/base_sink.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace logging
+{
+using namespace spdlog;
+
+enum class overflow_policy
+{
+	/// the logging thread waits for room in the queue, nothing is lost
+	block,
+	/// the message is dropped and counted, the logging thread never waits
+	drop
+};
+
+/*
+ * async_file_sink; writes the messages to a file from a thread of its own.
+ *
+ *      The logging threads only copy the formatted message into a bounded
+ *      queue of reused strings. The writer takes everything queued at once,
+ *      writes it with one call and flushes the file every flush_interval
+ *      or when asked to. Messages dropped by the drop policy are counted
+ *      and the count is written to the file in their place.
+ */
+class async_file_sink : public sinks::base_sink<details::null_mutex>
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : async_file_sink ()
+	/// <summary>
+	/// Opens the file, throws spdlog_ex when it can't.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	async_file_sink(const std::string& filename, bool truncate, std::size_t queue_size = 8192,
+					overflow_policy policy = overflow_policy::block,
+					std::chrono::milliseconds flush_interval = std::chrono::milliseconds(500));
+
+	//-----------------------------------------------------------------------------
+	//  Name : ~async_file_sink ()
+	/// <summary>
+	/// Writes what is still queued and closes the file.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	~async_file_sink() override;
+
+	void set_overflow_policy(overflow_policy policy)
+	{
+		policy_.store(policy, std::memory_order_relaxed);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_dropped_count ()
+	/// <summary>
+	/// The messages dropped since the sink was created.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint64_t get_dropped_count() const
+	{
+		return dropped_.load(std::memory_order_relaxed);
+	}
+
+protected:
+	void _sink_it(const details::log_msg& msg) override;
+
+	//-----------------------------------------------------------------------------
+	//  Name : _flush ()
+	/// <summary>
+	/// Waits for what was queued before the call to be written and flushed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void _flush() override;
+
+private:
+	void run();
+
+	std::FILE* file_ = nullptr;
+	std::chrono::milliseconds flush_interval_;
+	std::atomic<overflow_policy> policy_;
+	std::atomic<std::uint64_t> dropped_ = {0};
+
+	std::mutex mutex_;
+	std::condition_variable has_messages_;
+	std::condition_variable has_room_;
+	std::condition_variable has_written_;
+	/// the queue, a ring whose strings keep their capacity
+	std::vector<std::string> slots_;
+	std::size_t head_ = 0;
+	std::size_t count_ = 0;
+	/// the messages queued and the ones written and flushed, for _flush
+	std::uint64_t queued_ = 0;
+	std::uint64_t flushed_ = 0;
+	bool flush_requested_ = false;
+	bool stop_ = false;
+
+	std::thread thread_;
+};
+}
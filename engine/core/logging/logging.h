@@ -47,6 +47,22 @@ using platform_sink_st = stdout_sink_st;
 #endif
 #include <spdlog/sinks/dist_sink.h>
 #include <spdlog/sinks/file_sinks.h>
+
+#include "async_file_sink.h"
+
+// the lowest level of the calls compiled in, the ones below it are removed
+// with their arguments. trace and debug are left out of the release builds.
+#define APPLOG_LEVEL_TRACE 0
+#define APPLOG_LEVEL_DEBUG 1
+#define APPLOG_LEVEL_INFO 2
+#ifndef APPLOG_ACTIVE_LEVEL
+#if defined(NDEBUG)
+#define APPLOG_ACTIVE_LEVEL APPLOG_LEVEL_INFO
+#else
+#define APPLOG_ACTIVE_LEVEL APPLOG_LEVEL_TRACE
+#endif
+#endif
+
 namespace logging
 {
 using namespace spdlog;
@@ -57,7 +73,16 @@ inline std::shared_ptr<sinks::dist_sink_mt> get_mutable_logging_container()
 }
 #define APPLOG "Log"
 #define APPLOG_INFO(...) spdlog::get(APPLOG)->info(__VA_ARGS__)
+#if APPLOG_ACTIVE_LEVEL <= APPLOG_LEVEL_TRACE
 #define APPLOG_TRACE(...) spdlog::get(APPLOG)->trace(__VA_ARGS__)
+#else
+#define APPLOG_TRACE(...) (void)0
+#endif
+#if APPLOG_ACTIVE_LEVEL <= APPLOG_LEVEL_DEBUG
+#define APPLOG_DEBUG(...) spdlog::get(APPLOG)->debug(__VA_ARGS__)
+#else
+#define APPLOG_DEBUG(...) (void)0
+#endif
 #define APPLOG_ERROR(...) spdlog::get(APPLOG)->error(__VA_ARGS__)
 #define APPLOG_WARNING(...) spdlog::get(APPLOG)->warn(__VA_ARGS__)
 #define APPLOG_NOTICE(...) spdlog::get(APPLOG)->notice(__VA_ARGS__)
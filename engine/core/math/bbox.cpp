@@ -1035,18 +1035,10 @@ bbox& bbox::mul(const transform& t)
 //-----------------------------------------------------------------------------
 bbox bbox::mul(const bbox& bounds, const transform& t)
 {
-	const auto x_axis = t.x_axis();
-	const auto y_axis = t.y_axis();
-	const auto z_axis = t.z_axis();
-	auto xa = x_axis * bounds.min.x;
-	auto xb = x_axis * bounds.max.x;
-	auto ya = y_axis * bounds.min.y;
-	auto yb = y_axis * bounds.max.y;
-	auto za = z_axis * bounds.min.z;
-	auto zb = z_axis * bounds.max.z;
-
-	return bbox(math::min(xa, xb) + math::min(ya, yb) + math::min(za, zb) + t.get_position(),
-				math::max(xa, xb) + math::max(ya, yb) + math::max(za, zb) + t.get_position());
+	bbox result;
+	simd::transform_aabb(&t.get_matrix()[0][0], &bounds.min.x, &bounds.max.x, &result.min.x,
+						 &result.max.x);
+	return result;
 }
 
 //-----------------------------------------------------------------------------
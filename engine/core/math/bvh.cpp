@@ -0,0 +1,397 @@
+#include "bvh.h"
+#include <algorithm>
+
+namespace math
+{
+namespace
+{
+//-----------------------------------------------------------------------------
+//  Name : get_area ()
+/// <summary>
+/// Surface area of a box, the cost used to pick where a leaf is inserted.
+/// </summary>
+//-----------------------------------------------------------------------------
+float get_area(const bbox& bounds)
+{
+	const auto d = bounds.get_dimensions();
+	return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+bbox get_union(const bbox& a, const bbox& b)
+{
+	return bbox(glm::min(a.min, b.min), glm::max(a.max, b.max));
+}
+
+bool contains(const bbox& outer, const bbox& inner)
+{
+	return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+		   outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+}
+
+constexpr std::int32_t bvh::null_node;
+constexpr unsigned int bvh::all_planes;
+constexpr std::size_t bvh::max_views;
+constexpr std::uint32_t bvh::all_masks;
+
+//-----------------------------------------------------------------------------
+//  Name : bvh () (Constructor)
+/// <summary>
+/// bvh Class Constructor
+/// </summary>
+//-----------------------------------------------------------------------------
+bvh::bvh(float margin)
+	: margin_(margin)
+{
+}
+
+//-----------------------------------------------------------------------------
+//  Name : insert ()
+/// <summary>
+/// Adds a leaf for the box and returns its proxy.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::int32_t bvh::insert(const bbox& bounds, std::uint32_t user_data, std::uint32_t mask)
+{
+	const auto proxy = allocate_node();
+	auto& leaf = nodes_[std::size_t(proxy)];
+	leaf.bounds = get_fat(bounds);
+	leaf.user_data = user_data;
+	leaf.mask = mask;
+	leaf.height = 0;
+	insert_leaf(proxy);
+	++leaves_;
+	return proxy;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : remove ()
+/// <summary>
+/// Removes a leaf, the proxy may be handed out again.
+/// </summary>
+//-----------------------------------------------------------------------------
+void bvh::remove(std::int32_t proxy)
+{
+	remove_leaf(proxy);
+	free_node(proxy);
+	--leaves_;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : move ()
+/// <summary>
+/// Updates the box of a leaf, see the declaration.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool bvh::move(std::int32_t proxy, const bbox& bounds)
+{
+	auto& leaf = nodes_[std::size_t(proxy)];
+	if(contains(leaf.bounds, bounds))
+	{
+		// a volume that shrank a lot would keep a box far too big
+		if(get_area(get_fat(bounds)) * 4.0f > get_area(leaf.bounds))
+		{
+			return false;
+		}
+	}
+
+	remove_leaf(proxy);
+	nodes_[std::size_t(proxy)].bounds = get_fat(bounds);
+	insert_leaf(proxy);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : set_mask ()
+/// <summary>
+/// Changes the mask of a leaf and of the nodes above it.
+/// </summary>
+//-----------------------------------------------------------------------------
+void bvh::set_mask(std::int32_t proxy, std::uint32_t mask)
+{
+	auto& leaf = nodes_[std::size_t(proxy)];
+	if(leaf.mask == mask)
+	{
+		return;
+	}
+
+	leaf.mask = mask;
+	for(auto index = leaf.parent; index != null_node; index = nodes_[std::size_t(index)].parent)
+	{
+		auto& n = nodes_[std::size_t(index)];
+		n.mask = nodes_[std::size_t(n.left)].mask | nodes_[std::size_t(n.right)].mask;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//  Name : clear ()
+/// <summary>
+/// Removes every leaf.
+/// </summary>
+//-----------------------------------------------------------------------------
+void bvh::clear()
+{
+	nodes_.clear();
+	root_ = null_node;
+	free_list_ = null_node;
+	leaves_ = 0;
+}
+
+std::int32_t bvh::allocate_node()
+{
+	if(free_list_ == null_node)
+	{
+		nodes_.emplace_back();
+		return std::int32_t(nodes_.size() - 1);
+	}
+
+	const auto index = free_list_;
+	auto& n = nodes_[std::size_t(index)];
+	free_list_ = n.parent;
+	n = node();
+	return index;
+}
+
+void bvh::free_node(std::int32_t index)
+{
+	auto& n = nodes_[std::size_t(index)];
+	n.parent = free_list_;
+	n.left = null_node;
+	n.right = null_node;
+	n.height = -1;
+	free_list_ = index;
+}
+
+bbox bvh::get_fat(const bbox& bounds) const
+{
+	bbox fat = bounds;
+	fat.inflate(bounds.get_extents() * margin_);
+	return fat;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : insert_leaf ()
+/// <summary>
+/// Walks down to the sibling that grows the least in area and pairs the
+/// leaf with it under a new parent.
+/// </summary>
+//-----------------------------------------------------------------------------
+void bvh::insert_leaf(std::int32_t leaf)
+{
+	if(root_ == null_node)
+	{
+		root_ = leaf;
+		nodes_[std::size_t(leaf)].parent = null_node;
+		return;
+	}
+
+	const auto leaf_bounds = nodes_[std::size_t(leaf)].bounds;
+	auto index = root_;
+	while(!nodes_[std::size_t(index)].is_leaf())
+	{
+		const auto& n = nodes_[std::size_t(index)];
+		const auto area = get_area(n.bounds);
+		const auto combined_area = get_area(get_union(n.bounds, leaf_bounds));
+
+		// cost of making a new parent for this node and the leaf
+		const auto cost = 2.0f * combined_area;
+		// cost pushed down to the children
+		const auto inheritance_cost = 2.0f * (combined_area - area);
+
+		const auto get_cost = [&](std::int32_t child) {
+			const auto& c = nodes_[std::size_t(child)];
+			const auto child_area = get_area(get_union(leaf_bounds, c.bounds));
+			return c.is_leaf() ? child_area + inheritance_cost
+							   : child_area - get_area(c.bounds) + inheritance_cost;
+		};
+
+		const auto cost_left = get_cost(n.left);
+		const auto cost_right = get_cost(n.right);
+		if(cost < cost_left && cost < cost_right)
+		{
+			break;
+		}
+
+		index = cost_left < cost_right ? n.left : n.right;
+	}
+
+	const auto sibling = index;
+	const auto old_parent = nodes_[std::size_t(sibling)].parent;
+	// may grow the nodes, no reference is held across it
+	const auto new_parent = allocate_node();
+	auto& parent = nodes_[std::size_t(new_parent)];
+	parent.parent = old_parent;
+	parent.bounds = get_union(leaf_bounds, nodes_[std::size_t(sibling)].bounds);
+	parent.mask = nodes_[std::size_t(leaf)].mask | nodes_[std::size_t(sibling)].mask;
+	parent.height = nodes_[std::size_t(sibling)].height + 1;
+	parent.left = sibling;
+	parent.right = leaf;
+	nodes_[std::size_t(sibling)].parent = new_parent;
+	nodes_[std::size_t(leaf)].parent = new_parent;
+
+	if(old_parent == null_node)
+	{
+		root_ = new_parent;
+	}
+	else
+	{
+		auto& p = nodes_[std::size_t(old_parent)];
+		if(p.left == sibling)
+		{
+			p.left = new_parent;
+		}
+		else
+		{
+			p.right = new_parent;
+		}
+	}
+
+	refit_from(nodes_[std::size_t(leaf)].parent);
+}
+
+//-----------------------------------------------------------------------------
+//  Name : remove_leaf ()
+/// <summary>
+/// Unlinks a leaf, its sibling takes the place of their parent.
+/// </summary>
+//-----------------------------------------------------------------------------
+void bvh::remove_leaf(std::int32_t leaf)
+{
+	if(leaf == root_)
+	{
+		root_ = null_node;
+		return;
+	}
+
+	const auto parent = nodes_[std::size_t(leaf)].parent;
+	const auto grand_parent = nodes_[std::size_t(parent)].parent;
+	const auto sibling = nodes_[std::size_t(parent)].left == leaf ? nodes_[std::size_t(parent)].right
+																  : nodes_[std::size_t(parent)].left;
+
+	nodes_[std::size_t(sibling)].parent = grand_parent;
+	free_node(parent);
+	nodes_[std::size_t(leaf)].parent = null_node;
+
+	if(grand_parent == null_node)
+	{
+		root_ = sibling;
+		return;
+	}
+
+	auto& g = nodes_[std::size_t(grand_parent)];
+	if(g.left == parent)
+	{
+		g.left = sibling;
+	}
+	else
+	{
+		g.right = sibling;
+	}
+
+	refit_from(grand_parent);
+}
+
+//-----------------------------------------------------------------------------
+//  Name : refit_from ()
+/// <summary>
+/// Balances and refits the boxes and heights from a node up to the root.
+/// </summary>
+//-----------------------------------------------------------------------------
+void bvh::refit_from(std::int32_t index)
+{
+	while(index != null_node)
+	{
+		index = balance(index);
+
+		auto& n = nodes_[std::size_t(index)];
+		const auto& left = nodes_[std::size_t(n.left)];
+		const auto& right = nodes_[std::size_t(n.right)];
+		n.height = 1 + std::max(left.height, right.height);
+		n.bounds = get_union(left.bounds, right.bounds);
+		n.mask = left.mask | right.mask;
+
+		index = n.parent;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//  Name : balance ()
+/// <summary>
+/// Rotates the taller child of a node up when the heights of the children
+/// differ by more than one. Returns the node now in its place.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::int32_t bvh::balance(std::int32_t a_index)
+{
+	auto& a = nodes_[std::size_t(a_index)];
+	if(a.is_leaf() || a.height < 2)
+	{
+		return a_index;
+	}
+
+	const auto b_index = a.left;
+	const auto c_index = a.right;
+	const auto balance_factor = nodes_[std::size_t(c_index)].height - nodes_[std::size_t(b_index)].height;
+	if(balance_factor >= -1 && balance_factor <= 1)
+	{
+		return a_index;
+	}
+
+	// the taller child goes up, its taller child stays with it
+	const bool rotate_right = balance_factor > 1;
+	const auto up_index = rotate_right ? c_index : b_index;
+	const auto other_index = rotate_right ? b_index : c_index;
+	auto& up = nodes_[std::size_t(up_index)];
+	const auto f_index = up.left;
+	const auto g_index = up.right;
+	auto& f = nodes_[std::size_t(f_index)];
+	auto& g = nodes_[std::size_t(g_index)];
+
+	up.left = a_index;
+	up.parent = a.parent;
+	a.parent = up_index;
+
+	if(up.parent == null_node)
+	{
+		root_ = up_index;
+	}
+	else
+	{
+		auto& p = nodes_[std::size_t(up.parent)];
+		if(p.left == a_index)
+		{
+			p.left = up_index;
+		}
+		else
+		{
+			p.right = up_index;
+		}
+	}
+
+	const bool keep_f = f.height > g.height;
+	const auto kept_index = keep_f ? f_index : g_index;
+	const auto moved_index = keep_f ? g_index : f_index;
+	up.right = kept_index;
+	if(rotate_right)
+	{
+		a.right = moved_index;
+	}
+	else
+	{
+		a.left = moved_index;
+	}
+	nodes_[std::size_t(moved_index)].parent = a_index;
+
+	const auto& other = nodes_[std::size_t(other_index)];
+	const auto& moved = nodes_[std::size_t(moved_index)];
+	const auto& kept = nodes_[std::size_t(kept_index)];
+	a.bounds = get_union(other.bounds, moved.bounds);
+	a.mask = other.mask | moved.mask;
+	a.height = 1 + std::max(other.height, moved.height);
+	up.bounds = get_union(a.bounds, kept.bounds);
+	up.mask = a.mask | kept.mask;
+	up.height = 1 + std::max(a.height, kept.height);
+
+	return up_index;
+}
+}
@@ -0,0 +1,447 @@
+#pragma once
+
+#include "bbox.h"
+#include "frustum.h"
+#include "math_types.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace math
+{
+using namespace glm;
+
+//-----------------------------------------------------------------------------
+// Main class declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : bvh (Class)
+/// <summary>
+/// Dynamic bounding volume hierarchy of axis aligned boxes. Every leaf keeps
+/// a box grown by a margin, so a volume that moves a little only refits its
+/// entry instead of being reinserted. The tree is kept balanced by rotations
+/// on the way up from an insertion or a removal. Every leaf has a mask and
+/// every node the union of those below it, so the queries for a mask leave
+/// the subtrees without any of its bits.
+/// </summary>
+//-----------------------------------------------------------------------------
+class bvh
+{
+public:
+	static constexpr std::int32_t null_node = -1;
+	/// inside bits of a volume inside every plane of a frustum
+	static constexpr unsigned int all_planes = 0x3f;
+	/// the most frustums a multi view query takes
+	static constexpr std::size_t max_views = 8;
+	/// the mask of the leaves and queries that have every bit
+	static constexpr std::uint32_t all_masks = ~std::uint32_t(0);
+
+	/// the plane that last rejected each node, -1 if none. Kept by the caller
+	/// between frames for one view, a stale entry only costs a plane test.
+	using plane_cache = std::vector<std::int8_t>;
+
+	//-------------------------------------------------------------------------
+	// Constructors & Destructors
+	//-------------------------------------------------------------------------
+	/// margin is the fraction of its extents a leaf box is grown by.
+	explicit bvh(float margin = 0.1f);
+
+	//-------------------------------------------------------------------------
+	// Public Methods
+	//-------------------------------------------------------------------------
+	std::int32_t insert(const bbox& bounds, std::uint32_t user_data, std::uint32_t mask = all_masks);
+	void remove(std::int32_t proxy);
+	void set_mask(std::int32_t proxy, std::uint32_t mask);
+
+	//-------------------------------------------------------------------------
+	//  Name : move ()
+	/// <summary>
+	/// Updates the box of a leaf. Returns false when the new box still fits
+	/// in the grown box of the leaf and the tree was left as is.
+	/// </summary>
+	//-------------------------------------------------------------------------
+	bool move(std::int32_t proxy, const bbox& bounds);
+	void clear();
+
+	std::uint32_t get_user_data(std::int32_t proxy) const
+	{
+		return nodes_[std::size_t(proxy)].user_data;
+	}
+
+	void set_user_data(std::int32_t proxy, std::uint32_t user_data)
+	{
+		nodes_[std::size_t(proxy)].user_data = user_data;
+	}
+
+	const bbox& get_fat_bounds(std::int32_t proxy) const
+	{
+		return nodes_[std::size_t(proxy)].bounds;
+	}
+
+	std::size_t size() const
+	{
+		return leaves_;
+	}
+
+	std::int32_t get_height() const
+	{
+		return root_ == null_node ? 0 : nodes_[std::size_t(root_)].height;
+	}
+
+	//-------------------------------------------------------------------------
+	//  Name : query ()
+	/// <summary>
+	/// Calls callback(user_data, inside_bits) for the leaves whose grown box
+	/// is not outside the frustum, inside_bits being the planes the box is
+	/// inside of. A node inside the frustum accepts all of its leaves with
+	/// all_planes, without testing them. The children of a node skip the
+	/// planes the node is inside of. When a cache is given the plane that
+	/// rejected a node last time is tested first. A leaf reported without
+	/// all_planes may still be outside by the margin. Only the leaves sharing
+	/// a bit with the mask are reported.
+	/// </summary>
+	//-------------------------------------------------------------------------
+	template <typename F>
+	void query(const frustum& f, F&& callback, plane_cache* cache = nullptr,
+			   std::uint32_t mask = all_masks) const;
+
+	//-------------------------------------------------------------------------
+	//  Name : query ()
+	/// <summary>
+	/// Tests count frustums, at most max_views, in a single walk of the tree.
+	/// Calls callback(user_data, inside_views, partial_views, inside_bits) for
+	/// the leaves whose grown box is not outside all of them. Bit v of
+	/// inside_views is set for the frustums a node above the leaf or the leaf
+	/// itself is inside of. Bit v of partial_views is set for the ones the
+	/// grown box only intersects, inside_bits[v] being the planes of frustum v
+	/// it is inside of. A subtree is left once no frustum intersects it, and
+	/// every frustum skips the planes the nodes above are inside of. Only the
+	/// leaves sharing a bit with the mask are reported.
+	/// </summary>
+	//-------------------------------------------------------------------------
+	template <typename F>
+	void query(const frustum* frustums, std::size_t count, F&& callback,
+			   std::uint32_t mask = all_masks) const;
+
+	//-------------------------------------------------------------------------
+	//  Name : query ()
+	/// <summary>
+	/// Calls callback(user_data) for the leaves sharing a bit with the mask
+	/// whose grown box touches the sphere.
+	/// </summary>
+	//-------------------------------------------------------------------------
+	template <typename F>
+	void query(const vec3& center, float radius, F&& callback, std::uint32_t mask = all_masks) const;
+
+	//-------------------------------------------------------------------------
+	//  Name : raycast ()
+	/// <summary>
+	/// Calls callback(user_data, distance) for the leaves whose grown box is
+	/// hit by the ray within max_distance, distance being where the ray
+	/// enters the box. direction must be normalized. The leaves are not
+	/// reported in order.
+	/// </summary>
+	//-------------------------------------------------------------------------
+	template <typename F>
+	void raycast(const vec3& origin, const vec3& direction, float max_distance, F&& callback) const;
+
+private:
+	struct node
+	{
+		bool is_leaf() const
+		{
+			return left == null_node;
+		}
+
+		bbox bounds;
+		/// next free node when the node is not used
+		std::int32_t parent = null_node;
+		std::int32_t left = null_node;
+		std::int32_t right = null_node;
+		/// leaves are 0, free nodes are -1
+		std::int32_t height = -1;
+		std::uint32_t user_data = 0;
+		/// of the leaf, or the union of those below
+		std::uint32_t mask = all_masks;
+	};
+
+	//-------------------------------------------------------------------------
+	// Private Methods
+	//-------------------------------------------------------------------------
+	std::int32_t allocate_node();
+	void free_node(std::int32_t index);
+	void insert_leaf(std::int32_t leaf);
+	void remove_leaf(std::int32_t leaf);
+	void refit_from(std::int32_t index);
+	std::int32_t balance(std::int32_t index);
+	bbox get_fat(const bbox& bounds) const;
+
+	template <typename F>
+	void accept_subtree(std::int32_t index, std::uint32_t mask, std::vector<std::int32_t>& stack,
+						F&& callback) const;
+
+	//-------------------------------------------------------------------------
+	// Private Variables
+	//-------------------------------------------------------------------------
+	std::vector<node> nodes_;
+	std::int32_t root_ = null_node;
+	std::int32_t free_list_ = null_node;
+	std::size_t leaves_ = 0;
+	float margin_ = 0.1f;
+};
+
+template <typename F>
+inline void bvh::accept_subtree(std::int32_t index, std::uint32_t mask, std::vector<std::int32_t>& stack,
+								F&& callback) const
+{
+	const auto base = stack.size();
+	stack.push_back(index);
+	while(stack.size() > base)
+	{
+		const auto& n = nodes_[std::size_t(stack.back())];
+		stack.pop_back();
+		if((n.mask & mask) == 0)
+		{
+			continue;
+		}
+		if(n.is_leaf())
+		{
+			callback(n.user_data);
+			continue;
+		}
+		stack.push_back(n.left);
+		stack.push_back(n.right);
+	}
+}
+
+template <typename F>
+inline void bvh::query(const frustum& f, F&& callback, plane_cache* cache, std::uint32_t mask) const
+{
+	if(root_ == null_node)
+	{
+		return;
+	}
+
+	if(cache)
+	{
+		cache->resize(nodes_.size(), -1);
+	}
+
+	struct entry
+	{
+		std::int32_t index;
+		/// planes the parent is inside of
+		unsigned int inside_bits;
+	};
+
+	std::vector<entry> stack;
+	std::vector<std::int32_t> subtree;
+	stack.reserve(64);
+	stack.push_back({root_, 0u});
+	while(!stack.empty())
+	{
+		auto e = stack.back();
+		stack.pop_back();
+
+		const auto& n = nodes_[std::size_t(e.index)];
+		if((n.mask & mask) == 0)
+		{
+			continue;
+		}
+
+		int last_outside = cache ? (*cache)[std::size_t(e.index)] : -1;
+		const auto result = f.classify_aabb(n.bounds, e.inside_bits, last_outside);
+		if(cache)
+		{
+			(*cache)[std::size_t(e.index)] = std::int8_t(last_outside);
+		}
+
+		if(result == volume_query::outside)
+		{
+			continue;
+		}
+
+		if(result == volume_query::inside)
+		{
+			accept_subtree(e.index, mask, subtree, [&callback](std::uint32_t user_data) {
+				callback(user_data, all_planes);
+			});
+			continue;
+		}
+
+		if(n.is_leaf())
+		{
+			callback(n.user_data, e.inside_bits);
+			continue;
+		}
+
+		stack.push_back({n.left, e.inside_bits});
+		stack.push_back({n.right, e.inside_bits});
+	}
+}
+
+template <typename F>
+inline void bvh::query(const frustum* frustums, std::size_t count, F&& callback, std::uint32_t mask) const
+{
+	if(root_ == null_node || count == 0)
+	{
+		return;
+	}
+	if(count > max_views)
+	{
+		count = max_views;
+	}
+
+	struct entry
+	{
+		std::int32_t index;
+		/// frustums the parent is inside of
+		std::uint32_t inside_views;
+		/// frustums the parent intersects, with the planes it is inside of
+		std::uint32_t partial_views;
+		std::uint8_t inside_bits[max_views];
+	};
+
+	std::vector<entry> stack;
+	std::vector<std::int32_t> subtree;
+	stack.reserve(64);
+
+	entry root = {root_, 0u, (1u << count) - 1u, {}};
+	stack.push_back(root);
+	while(!stack.empty())
+	{
+		auto e = stack.back();
+		stack.pop_back();
+
+		const auto& n = nodes_[std::size_t(e.index)];
+		if((n.mask & mask) == 0)
+		{
+			continue;
+		}
+
+		auto partial = e.partial_views;
+		for(std::size_t v = 0; v < count; ++v)
+		{
+			if((partial & (1u << v)) == 0)
+			{
+				continue;
+			}
+
+			unsigned int bits = e.inside_bits[v];
+			int last_outside = -1;
+			const auto result = frustums[v].classify_aabb(n.bounds, bits, last_outside);
+			if(result == volume_query::intersect)
+			{
+				e.inside_bits[v] = std::uint8_t(bits);
+				continue;
+			}
+
+			partial &= ~(1u << v);
+			if(result == volume_query::inside)
+			{
+				e.inside_views |= 1u << v;
+			}
+		}
+		e.partial_views = partial;
+
+		if(e.inside_views == 0 && partial == 0)
+		{
+			continue;
+		}
+
+		if(partial == 0)
+		{
+			const auto inside_views = e.inside_views;
+			accept_subtree(e.index, mask, subtree,
+						   [&callback, &e, inside_views](std::uint32_t user_data) {
+							   callback(user_data, inside_views, 0u, e.inside_bits);
+						   });
+			continue;
+		}
+
+		if(n.is_leaf())
+		{
+			callback(n.user_data, e.inside_views, partial, e.inside_bits);
+			continue;
+		}
+
+		e.index = n.left;
+		stack.push_back(e);
+		e.index = n.right;
+		stack.push_back(e);
+	}
+}
+
+template <typename F>
+inline void bvh::query(const vec3& center, float radius, F&& callback, std::uint32_t mask) const
+{
+	if(root_ == null_node)
+	{
+		return;
+	}
+
+	const auto radius_sq = radius * radius;
+	std::vector<std::int32_t> stack;
+	stack.reserve(64);
+	stack.push_back(root_);
+	while(!stack.empty())
+	{
+		const auto& n = nodes_[std::size_t(stack.back())];
+		stack.pop_back();
+		if((n.mask & mask) == 0)
+		{
+			continue;
+		}
+
+		const auto offset = n.bounds.closest_point(center) - center;
+		if(dot(offset, offset) > radius_sq)
+		{
+			continue;
+		}
+
+		if(n.is_leaf())
+		{
+			callback(n.user_data);
+			continue;
+		}
+
+		stack.push_back(n.left);
+		stack.push_back(n.right);
+	}
+}
+
+template <typename F>
+inline void bvh::raycast(const vec3& origin, const vec3& direction, float max_distance, F&& callback) const
+{
+	if(root_ == null_node)
+	{
+		return;
+	}
+
+	// the box test works on the fraction of the segment
+	const auto segment = direction * max_distance;
+	std::vector<std::int32_t> stack;
+	stack.reserve(64);
+	stack.push_back(root_);
+	while(!stack.empty())
+	{
+		const auto& n = nodes_[std::size_t(stack.back())];
+		stack.pop_back();
+
+		float t = 0.0f;
+		if(!n.bounds.intersect(origin, segment, t, true))
+		{
+			continue;
+		}
+
+		if(n.is_leaf())
+		{
+			callback(n.user_data, t * max_distance);
+			continue;
+		}
+
+		stack.push_back(n.left);
+		stack.push_back(n.right);
+	}
+}
+}
@@ -1,5 +1,19 @@
 #include "frustum.h"
 
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define MATH_FRUSTUM_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MATH_FRUSTUM_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MATH_FRUSTUM_NEON
+#endif
+
 namespace math
 {
 ///////////////////////////////////////////////////////////////////////////////
@@ -491,19 +505,58 @@ bool frustum::test_aabb(const bbox& AABB) const
 	return true;
 }
 
+//-----------------------------------------------------------------------------
+//  Name : get_view_mask () (Static)
+/// <summary>
+/// Bit i is set when the box is not outside frustum i, for count frustums
+/// of at most 32.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::uint32_t frustum::get_view_mask(const frustum* frustums, std::size_t count, const bbox& bounds)
+{
+	std::uint32_t mask = 0;
+	for(std::size_t i = 0; i < count && i < 32; ++i)
+	{
+		if(frustums[i].classify_aabb(bounds) != volume_query::outside)
+		{
+			mask |= 1u << i;
+		}
+	}
+	return mask;
+}
+
 //-----------------------------------------------------------------------------
 //  Name : testAABB ()
 /// <summary>
 /// Determine whether or not the box passed is within the frustum.
 /// </summary>
 //-----------------------------------------------------------------------------
-bool frustum::test_obb(frustum frustum, const bbox& AABB, const transform& t)
+bool frustum::test_obb(const frustum& frustum, const bbox& AABB, const transform& t)
 {
-	transform invTransform = inverse(t);
+	// Bring the planes into the space of the box. Transforming a plane by the
+	// inverse transpose of the inverse is transforming it by the transpose,
+	// the scale normalize would apply doesn't change which side a point is on.
+	const auto& mtxT = transpose(t.get_matrix());
+	for(const auto& world_plane : frustum.planes)
+	{
+		const plane local_plane = mtxT * world_plane.data;
 
-	frustum.mul(invTransform);
+		// Calculate near extreme point
+		vec3 NearPoint;
+		NearPoint.x = local_plane.data.x > 0.0f ? AABB.min.x : AABB.max.x;
+		NearPoint.y = local_plane.data.y > 0.0f ? AABB.min.y : AABB.max.y;
+		NearPoint.z = local_plane.data.z > 0.0f ? AABB.min.z : AABB.max.z;
 
-	return frustum.test_aabb(AABB);
+		// If near extreme point is outside, then the AABB is totally outside the
+		// frustum
+		if(plane::dot_coord(local_plane, NearPoint) > 0.0f)
+		{
+			return false;
+		}
+	}
+
+	// Intersecting / inside
+	return true;
 }
 
 //-----------------------------------------------------------------------------
@@ -996,4 +1049,292 @@ bool frustum::operator==(const frustum& frustum) const
 	// Match
 	return true;
 }
+namespace
+{
+//-----------------------------------------------------------------------------
+//  Name : batch_planes (Struct)
+/// <summary>
+/// The frustum planes split per component together with the absolute value
+/// of their normals, ready to be broadcast by the batch tests.
+/// </summary>
+//-----------------------------------------------------------------------------
+struct batch_planes
+{
+	batch_planes(const std::array<plane, 6>& planes)
+	{
+		for(size_t i = 0; i < planes.size(); ++i)
+		{
+			const auto& data = planes[i].data;
+			nx[i] = data.x;
+			ny[i] = data.y;
+			nz[i] = data.z;
+			nw[i] = data.w;
+			ax[i] = std::abs(data.x);
+			ay[i] = std::abs(data.y);
+			az[i] = std::abs(data.z);
+		}
+	}
+
+	bool test_aabb(const aabb_soa& boxes, size_t i) const
+	{
+		for(size_t p = 0; p < 6; ++p)
+		{
+			// the signed distance of the corner nearest to the inside
+			const float distance = nx[p] * boxes.center_x[i] + ny[p] * boxes.center_y[i] +
+								   nz[p] * boxes.center_z[i] + nw[p] -
+								   (ax[p] * boxes.extent_x[i] + ay[p] * boxes.extent_y[i] +
+									az[p] * boxes.extent_z[i]);
+			if(distance > 0.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool test_sphere(const sphere_soa& spheres, size_t i) const
+	{
+		for(size_t p = 0; p < 6; ++p)
+		{
+			const float distance = nx[p] * spheres.center_x[i] + ny[p] * spheres.center_y[i] +
+								   nz[p] * spheres.center_z[i] + nw[p] - spheres.radius[i];
+			if(distance > 0.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	float nx[6];
+	float ny[6];
+	float nz[6];
+	float nw[6];
+	float ax[6];
+	float ay[6];
+	float az[6];
+};
+
+inline void set_visible(std::uint64_t* visible, size_t i, std::uint64_t bits)
+{
+	visible[i / 64] |= bits << (i % 64);
+}
+
+template <typename Test>
+void test_tail(size_t begin, size_t count, std::uint64_t* visible, Test&& test)
+{
+	for(size_t i = begin; i < count; ++i)
+	{
+		if(test(i))
+		{
+			set_visible(visible, i, 1);
+		}
+	}
+}
+}
+
+//-----------------------------------------------------------------------------
+//  Name : test_aabbs_scalar ()
+/// <summary>
+/// Reference version of test_aabbs, one box at a time.
+/// </summary>
+//-----------------------------------------------------------------------------
+void frustum::test_aabbs_scalar(const aabb_soa& boxes, std::uint64_t* visible) const
+{
+	std::fill(visible, visible + get_visibility_words(boxes.count), std::uint64_t(0));
+	const batch_planes bp(planes);
+	test_tail(0, boxes.count, visible, [&](size_t i) { return bp.test_aabb(boxes, i); });
+}
+
+//-----------------------------------------------------------------------------
+//  Name : test_spheres_scalar ()
+/// <summary>
+/// Reference version of test_spheres, one sphere at a time.
+/// </summary>
+//-----------------------------------------------------------------------------
+void frustum::test_spheres_scalar(const sphere_soa& spheres, std::uint64_t* visible) const
+{
+	std::fill(visible, visible + get_visibility_words(spheres.count), std::uint64_t(0));
+	const batch_planes bp(planes);
+	test_tail(0, spheres.count, visible, [&](size_t i) { return bp.test_sphere(spheres, i); });
+}
+
+//-----------------------------------------------------------------------------
+//  Name : test_aabbs ()
+/// <summary>
+/// Determine which of the boxes are within the frustum, several boxes are
+/// tested against a plane at once.
+/// </summary>
+//-----------------------------------------------------------------------------
+void frustum::test_aabbs(const aabb_soa& boxes, std::uint64_t* visible) const
+{
+	std::fill(visible, visible + get_visibility_words(boxes.count), std::uint64_t(0));
+	const batch_planes bp(planes);
+	size_t i = 0;
+
+#if defined(MATH_FRUSTUM_AVX)
+	for(; i + 8 <= boxes.count; i += 8)
+	{
+		const __m256 cx = _mm256_loadu_ps(boxes.center_x + i);
+		const __m256 cy = _mm256_loadu_ps(boxes.center_y + i);
+		const __m256 cz = _mm256_loadu_ps(boxes.center_z + i);
+		const __m256 ex = _mm256_loadu_ps(boxes.extent_x + i);
+		const __m256 ey = _mm256_loadu_ps(boxes.extent_y + i);
+		const __m256 ez = _mm256_loadu_ps(boxes.extent_z + i);
+		__m256 outside = _mm256_setzero_ps();
+		for(size_t p = 0; p < 6; ++p)
+		{
+			// same order of operations as the scalar test
+			__m256 distance = _mm256_mul_ps(_mm256_set1_ps(bp.nx[p]), cx);
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(bp.ny[p]), cy));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(bp.nz[p]), cz));
+			distance = _mm256_add_ps(distance, _mm256_set1_ps(bp.nw[p]));
+			__m256 reach = _mm256_mul_ps(_mm256_set1_ps(bp.ax[p]), ex);
+			reach = _mm256_add_ps(reach, _mm256_mul_ps(_mm256_set1_ps(bp.ay[p]), ey));
+			reach = _mm256_add_ps(reach, _mm256_mul_ps(_mm256_set1_ps(bp.az[p]), ez));
+			distance = _mm256_sub_ps(distance, reach);
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GT_OQ));
+		}
+		const auto inside = ~static_cast<std::uint64_t>(_mm256_movemask_ps(outside)) & 0xff;
+		set_visible(visible, i, inside);
+	}
+#elif defined(MATH_FRUSTUM_SSE)
+	for(; i + 4 <= boxes.count; i += 4)
+	{
+		const __m128 cx = _mm_loadu_ps(boxes.center_x + i);
+		const __m128 cy = _mm_loadu_ps(boxes.center_y + i);
+		const __m128 cz = _mm_loadu_ps(boxes.center_z + i);
+		const __m128 ex = _mm_loadu_ps(boxes.extent_x + i);
+		const __m128 ey = _mm_loadu_ps(boxes.extent_y + i);
+		const __m128 ez = _mm_loadu_ps(boxes.extent_z + i);
+		__m128 outside = _mm_setzero_ps();
+		for(size_t p = 0; p < 6; ++p)
+		{
+			// same order of operations as the scalar test
+			__m128 distance = _mm_mul_ps(_mm_set1_ps(bp.nx[p]), cx);
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(bp.ny[p]), cy));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(bp.nz[p]), cz));
+			distance = _mm_add_ps(distance, _mm_set1_ps(bp.nw[p]));
+			__m128 reach = _mm_mul_ps(_mm_set1_ps(bp.ax[p]), ex);
+			reach = _mm_add_ps(reach, _mm_mul_ps(_mm_set1_ps(bp.ay[p]), ey));
+			reach = _mm_add_ps(reach, _mm_mul_ps(_mm_set1_ps(bp.az[p]), ez));
+			distance = _mm_sub_ps(distance, reach);
+			outside = _mm_or_ps(outside, _mm_cmpgt_ps(distance, _mm_setzero_ps()));
+		}
+		const auto inside = ~static_cast<std::uint64_t>(_mm_movemask_ps(outside)) & 0xf;
+		set_visible(visible, i, inside);
+	}
+#elif defined(MATH_FRUSTUM_NEON)
+	const uint32x4_t lane_bits = {1, 2, 4, 8};
+	for(; i + 4 <= boxes.count; i += 4)
+	{
+		const float32x4_t cx = vld1q_f32(boxes.center_x + i);
+		const float32x4_t cy = vld1q_f32(boxes.center_y + i);
+		const float32x4_t cz = vld1q_f32(boxes.center_z + i);
+		const float32x4_t ex = vld1q_f32(boxes.extent_x + i);
+		const float32x4_t ey = vld1q_f32(boxes.extent_y + i);
+		const float32x4_t ez = vld1q_f32(boxes.extent_z + i);
+		uint32x4_t outside = vdupq_n_u32(0);
+		for(size_t p = 0; p < 6; ++p)
+		{
+			float32x4_t distance = vmulq_n_f32(cx, bp.nx[p]);
+			distance = vmlaq_n_f32(distance, cy, bp.ny[p]);
+			distance = vmlaq_n_f32(distance, cz, bp.nz[p]);
+			distance = vaddq_f32(distance, vdupq_n_f32(bp.nw[p]));
+			float32x4_t reach = vmulq_n_f32(ex, bp.ax[p]);
+			reach = vmlaq_n_f32(reach, ey, bp.ay[p]);
+			reach = vmlaq_n_f32(reach, ez, bp.az[p]);
+			distance = vsubq_f32(distance, reach);
+			outside = vorrq_u32(outside, vcgtq_f32(distance, vdupq_n_f32(0.0f)));
+		}
+		const uint32x4_t inside = vandq_u32(vmvnq_u32(outside), lane_bits);
+		const uint32x2_t half = vadd_u32(vget_low_u32(inside), vget_high_u32(inside));
+		set_visible(visible, i, vget_lane_u32(vpadd_u32(half, half), 0));
+	}
+#endif
+
+	test_tail(i, boxes.count, visible, [&](size_t j) { return bp.test_aabb(boxes, j); });
+}
+
+//-----------------------------------------------------------------------------
+//  Name : test_spheres ()
+/// <summary>
+/// Determine which of the spheres are within the frustum, several spheres
+/// are tested against a plane at once.
+/// </summary>
+//-----------------------------------------------------------------------------
+void frustum::test_spheres(const sphere_soa& spheres, std::uint64_t* visible) const
+{
+	std::fill(visible, visible + get_visibility_words(spheres.count), std::uint64_t(0));
+	const batch_planes bp(planes);
+	size_t i = 0;
+
+#if defined(MATH_FRUSTUM_AVX)
+	for(; i + 8 <= spheres.count; i += 8)
+	{
+		const __m256 cx = _mm256_loadu_ps(spheres.center_x + i);
+		const __m256 cy = _mm256_loadu_ps(spheres.center_y + i);
+		const __m256 cz = _mm256_loadu_ps(spheres.center_z + i);
+		const __m256 r = _mm256_loadu_ps(spheres.radius + i);
+		__m256 outside = _mm256_setzero_ps();
+		for(size_t p = 0; p < 6; ++p)
+		{
+			// same order of operations as the scalar test
+			__m256 distance = _mm256_mul_ps(_mm256_set1_ps(bp.nx[p]), cx);
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(bp.ny[p]), cy));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(bp.nz[p]), cz));
+			distance = _mm256_add_ps(distance, _mm256_set1_ps(bp.nw[p]));
+			distance = _mm256_sub_ps(distance, r);
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GT_OQ));
+		}
+		const auto inside = ~static_cast<std::uint64_t>(_mm256_movemask_ps(outside)) & 0xff;
+		set_visible(visible, i, inside);
+	}
+#elif defined(MATH_FRUSTUM_SSE)
+	for(; i + 4 <= spheres.count; i += 4)
+	{
+		const __m128 cx = _mm_loadu_ps(spheres.center_x + i);
+		const __m128 cy = _mm_loadu_ps(spheres.center_y + i);
+		const __m128 cz = _mm_loadu_ps(spheres.center_z + i);
+		const __m128 r = _mm_loadu_ps(spheres.radius + i);
+		__m128 outside = _mm_setzero_ps();
+		for(size_t p = 0; p < 6; ++p)
+		{
+			// same order of operations as the scalar test
+			__m128 distance = _mm_mul_ps(_mm_set1_ps(bp.nx[p]), cx);
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(bp.ny[p]), cy));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(bp.nz[p]), cz));
+			distance = _mm_add_ps(distance, _mm_set1_ps(bp.nw[p]));
+			distance = _mm_sub_ps(distance, r);
+			outside = _mm_or_ps(outside, _mm_cmpgt_ps(distance, _mm_setzero_ps()));
+		}
+		const auto inside = ~static_cast<std::uint64_t>(_mm_movemask_ps(outside)) & 0xf;
+		set_visible(visible, i, inside);
+	}
+#elif defined(MATH_FRUSTUM_NEON)
+	const uint32x4_t lane_bits = {1, 2, 4, 8};
+	for(; i + 4 <= spheres.count; i += 4)
+	{
+		const float32x4_t cx = vld1q_f32(spheres.center_x + i);
+		const float32x4_t cy = vld1q_f32(spheres.center_y + i);
+		const float32x4_t cz = vld1q_f32(spheres.center_z + i);
+		const float32x4_t r = vld1q_f32(spheres.radius + i);
+		uint32x4_t outside = vdupq_n_u32(0);
+		for(size_t p = 0; p < 6; ++p)
+		{
+			float32x4_t distance = vmulq_n_f32(cx, bp.nx[p]);
+			distance = vmlaq_n_f32(distance, cy, bp.ny[p]);
+			distance = vmlaq_n_f32(distance, cz, bp.nz[p]);
+			distance = vaddq_f32(distance, vdupq_n_f32(bp.nw[p]));
+			distance = vsubq_f32(distance, r);
+			outside = vorrq_u32(outside, vcgtq_f32(distance, vdupq_n_f32(0.0f)));
+		}
+		const uint32x4_t inside = vandq_u32(vmvnq_u32(outside), lane_bits);
+		const uint32x2_t half = vadd_u32(vget_low_u32(inside), vget_high_u32(inside));
+		set_visible(visible, i, vget_lane_u32(vpadd_u32(half, half), 0));
+	}
+#endif
+
+	test_tail(i, spheres.count, visible, [&](size_t j) { return bp.test_sphere(spheres, j); });
+}
 }
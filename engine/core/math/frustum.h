@@ -6,6 +6,8 @@
 #include "plane.h"
 #include "transform.h"
 #include <array>
+#include <cstddef>
+#include <cstdint>
 
 namespace math
 {
@@ -14,6 +16,50 @@ using namespace glm;
 //-----------------------------------------------------------------------------
 // Main class declarations
 //-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : aabb_soa (Struct)
+/// <summary>
+/// World space boxes given by their centers and half extents, one array per
+/// component so that several boxes can be loaded into a vector register.
+/// </summary>
+//-----------------------------------------------------------------------------
+struct aabb_soa
+{
+	const float* center_x = nullptr;
+	const float* center_y = nullptr;
+	const float* center_z = nullptr;
+	const float* extent_x = nullptr;
+	const float* extent_y = nullptr;
+	const float* extent_z = nullptr;
+	std::size_t count = 0;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : sphere_soa (Struct)
+/// <summary>
+/// World space spheres, one array per component.
+/// </summary>
+//-----------------------------------------------------------------------------
+struct sphere_soa
+{
+	const float* center_x = nullptr;
+	const float* center_y = nullptr;
+	const float* center_z = nullptr;
+	const float* radius = nullptr;
+	std::size_t count = 0;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : get_visibility_words ()
+/// <summary>
+/// Number of 64 bit words the batch tests write for count volumes.
+/// </summary>
+//-----------------------------------------------------------------------------
+inline std::size_t get_visibility_words(std::size_t count)
+{
+	return (count + 63) / 64;
+}
+
 //-----------------------------------------------------------------------------
 //  Name : frustum (Class)
 /// <summary>
@@ -43,6 +89,17 @@ public:
 	bool test_point(const vec3& point) const;
 	bool test_aabb(const bbox& bounds) const;
 
+	//-------------------------------------------------------------------------
+	// Batch tests, bit i of visible is set when volume i is inside or
+	// intersecting. visible must hold get_visibility_words(count) words.
+	// The vector path is used when the target supports it, the scalar one
+	// is the reference it must match.
+	//-------------------------------------------------------------------------
+	void test_aabbs(const aabb_soa& boxes, std::uint64_t* visible) const;
+	void test_aabbs_scalar(const aabb_soa& boxes, std::uint64_t* visible) const;
+	void test_spheres(const sphere_soa& spheres, std::uint64_t* visible) const;
+	void test_spheres_scalar(const sphere_soa& spheres, std::uint64_t* visible) const;
+
 	bool test_extruded_aabb(const bbox_extruded& box) const;
 	bool test_sphere(const vec3& center, float radius) const;
 	bool test_swept_sphere(const vec3& center, float radius, const vec3& sweepDirection) const;
@@ -53,7 +110,8 @@ public:
 	// Public Static Functions
 	//-------------------------------------------------------------------------
 	static frustum mul(frustum f, const transform& t);
-	static bool test_obb(frustum f, const bbox& bounds, const transform& t);
+	static bool test_obb(const frustum& f, const bbox& bounds, const transform& t);
+	static std::uint32_t get_view_mask(const frustum* frustums, std::size_t count, const bbox& bounds);
 	static bool test_extruded_obb(frustum f, const bbox_extruded& bounds, const transform& t);
 	static volume_query classify_obb(frustum f, const bbox& bounds, const transform& t);
 	static volume_query classify_obb(frustum f, const bbox& bounds, const transform& t,
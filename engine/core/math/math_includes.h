@@ -3,10 +3,12 @@
 #include "bbox.h"
 #include "bbox_extruded.h"
 #include "bsphere.h"
+#include "bvh.h"
 #include "frustum.h"
 #include "math_types.h"
 #include "plane.h"
 #include "transform.h"
+#include "triangle_bvh.h"
 #include <cstdint>
 #include <vector>
 namespace math
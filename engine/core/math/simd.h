@@ -0,0 +1,312 @@
+#pragma once
+
+#include "glm_includes.h"
+
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATH_SIMD_SSE
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MATH_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace math
+{
+namespace simd
+{
+/*
+ * float4; four floats in a register, what the kernels below are written
+ * against. SSE2 on x86, NEON on arm, a plain struct everywhere else.
+ */
+#if defined(MATH_SIMD_SSE)
+using float4 = __m128;
+
+inline float4 load(const float* p)
+{
+	return _mm_loadu_ps(p);
+}
+
+inline void store(float* p, float4 v)
+{
+	_mm_storeu_ps(p, v);
+}
+
+inline float4 splat(float s)
+{
+	return _mm_set1_ps(s);
+}
+
+inline float4 add(float4 a, float4 b)
+{
+	return _mm_add_ps(a, b);
+}
+
+inline float4 mul(float4 a, float4 b)
+{
+	return _mm_mul_ps(a, b);
+}
+
+inline float4 min(float4 a, float4 b)
+{
+	return _mm_min_ps(a, b);
+}
+
+inline float4 max(float4 a, float4 b)
+{
+	return _mm_max_ps(a, b);
+}
+#elif defined(MATH_SIMD_NEON)
+using float4 = float32x4_t;
+
+inline float4 load(const float* p)
+{
+	return vld1q_f32(p);
+}
+
+inline void store(float* p, float4 v)
+{
+	vst1q_f32(p, v);
+}
+
+inline float4 splat(float s)
+{
+	return vdupq_n_f32(s);
+}
+
+inline float4 add(float4 a, float4 b)
+{
+	return vaddq_f32(a, b);
+}
+
+inline float4 mul(float4 a, float4 b)
+{
+	return vmulq_f32(a, b);
+}
+
+inline float4 min(float4 a, float4 b)
+{
+	return vminq_f32(a, b);
+}
+
+inline float4 max(float4 a, float4 b)
+{
+	return vmaxq_f32(a, b);
+}
+#else
+struct float4
+{
+	float v[4];
+};
+
+inline float4 load(const float* p)
+{
+	return {{p[0], p[1], p[2], p[3]}};
+}
+
+inline void store(float* p, float4 a)
+{
+	p[0] = a.v[0];
+	p[1] = a.v[1];
+	p[2] = a.v[2];
+	p[3] = a.v[3];
+}
+
+inline float4 splat(float s)
+{
+	return {{s, s, s, s}};
+}
+
+inline float4 add(float4 a, float4 b)
+{
+	return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};
+}
+
+inline float4 mul(float4 a, float4 b)
+{
+	return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}};
+}
+
+inline float4 min(float4 a, float4 b)
+{
+	return {{a.v[0] < b.v[0] ? a.v[0] : b.v[0], a.v[1] < b.v[1] ? a.v[1] : b.v[1],
+			 a.v[2] < b.v[2] ? a.v[2] : b.v[2], a.v[3] < b.v[3] ? a.v[3] : b.v[3]}};
+}
+
+inline float4 max(float4 a, float4 b)
+{
+	return {{a.v[0] > b.v[0] ? a.v[0] : b.v[0], a.v[1] > b.v[1] ? a.v[1] : b.v[1],
+			 a.v[2] > b.v[2] ? a.v[2] : b.v[2], a.v[3] > b.v[3] ? a.v[3] : b.v[3]}};
+}
+#endif
+
+inline void store3(float* p, float4 a)
+{
+	float v[4];
+	store(v, a);
+	p[0] = v[0];
+	p[1] = v[1];
+	p[2] = v[2];
+}
+
+//-----------------------------------------------------------------------------
+//  Name : mul_mat4 ()
+/// <summary>
+/// out = a * b, the three of them column major 4x4 matrices. out may be a
+/// or b.
+/// </summary>
+//-----------------------------------------------------------------------------
+inline void mul_mat4(const float* a, const float* b, float* out)
+{
+	const float4 a0 = load(a);
+	const float4 a1 = load(a + 4);
+	const float4 a2 = load(a + 8);
+	const float4 a3 = load(a + 12);
+
+	float4 columns[4];
+	for(int i = 0; i < 4; ++i)
+	{
+		const float* c = b + i * 4;
+		columns[i] = add(add(mul(a0, splat(c[0])), mul(a1, splat(c[1]))),
+						 add(mul(a2, splat(c[2])), mul(a3, splat(c[3]))));
+	}
+	for(int i = 0; i < 4; ++i)
+	{
+		store(out + i * 4, columns[i]);
+	}
+}
+
+//-----------------------------------------------------------------------------
+//  Name : transform_aabb ()
+/// <summary>
+/// The box holding the box min, max transformed by the affine column major
+/// matrix m, by Arvo's method: every axis of the matrix scaled by the
+/// smaller and by the larger extent of the box adds its smaller and larger
+/// product to the corners.
+/// </summary>
+//-----------------------------------------------------------------------------
+inline void transform_aabb(const float* m, const float* min, const float* max, float* out_min,
+						   float* out_max)
+{
+	float4 lo = load(m + 12);
+	float4 hi = lo;
+	for(int i = 0; i < 3; ++i)
+	{
+		const float4 axis = load(m + i * 4);
+		const float4 a = mul(axis, splat(min[i]));
+		const float4 b = mul(axis, splat(max[i]));
+		lo = add(lo, simd::min(a, b));
+		hi = add(hi, simd::max(a, b));
+	}
+	store3(out_min, lo);
+	store3(out_max, hi);
+}
+
+//-----------------------------------------------------------------------------
+//  Name : transform_points ()
+/// <summary>
+/// Transforms count packed xyz points by the affine column major matrix m,
+/// without the divide by w. out may be in.
+/// </summary>
+//-----------------------------------------------------------------------------
+inline void transform_points(const float* m, const float* in, float* out, std::size_t count)
+{
+	const float4 c0 = load(m);
+	const float4 c1 = load(m + 4);
+	const float4 c2 = load(m + 8);
+	const float4 c3 = load(m + 12);
+
+	for(std::size_t i = 0; i < count; ++i, in += 3, out += 3)
+	{
+		const float4 p = add(add(mul(c0, splat(in[0])), mul(c1, splat(in[1]))),
+							 add(mul(c2, splat(in[2])), c3));
+		store3(out, p);
+	}
+}
+
+//-----------------------------------------------------------------------------
+//  Name : compose ()
+/// <summary>
+/// translate(position) * mat4_cast(rotation) * scale(scale) written out,
+/// without the two 4x4 products.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename T, glm::qualifier Q>
+inline glm::mat<4, 4, T, Q> compose(const glm::vec<3, T, Q>& position, const glm::tquat<T, Q>& rotation,
+									const glm::vec<3, T, Q>& scale)
+{
+	using vec4_t = glm::vec<4, T, Q>;
+
+	const T xx = rotation.x * rotation.x;
+	const T yy = rotation.y * rotation.y;
+	const T zz = rotation.z * rotation.z;
+	const T xy = rotation.x * rotation.y;
+	const T xz = rotation.x * rotation.z;
+	const T yz = rotation.y * rotation.z;
+	const T wx = rotation.w * rotation.x;
+	const T wy = rotation.w * rotation.y;
+	const T wz = rotation.w * rotation.z;
+
+	glm::mat<4, 4, T, Q> m;
+	m[0] = vec4_t(T(1) - T(2) * (yy + zz), T(2) * (xy + wz), T(2) * (xz - wy), T(0)) * scale.x;
+	m[1] = vec4_t(T(2) * (xy - wz), T(1) - T(2) * (xx + zz), T(2) * (yz + wx), T(0)) * scale.y;
+	m[2] = vec4_t(T(2) * (xz + wy), T(2) * (yz - wx), T(1) - T(2) * (xx + yy), T(0)) * scale.z;
+	m[3] = vec4_t(position, T(1));
+	return m;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : mul ()
+/// <summary>
+/// a * b, on the registers for float matrices.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename T, glm::qualifier Q>
+inline glm::mat<4, 4, T, Q> mul(const glm::mat<4, 4, T, Q>& a, const glm::mat<4, 4, T, Q>& b)
+{
+	return a * b;
+}
+
+template <glm::qualifier Q>
+inline glm::mat<4, 4, float, Q> mul(const glm::mat<4, 4, float, Q>& a, const glm::mat<4, 4, float, Q>& b)
+{
+	glm::mat<4, 4, float, Q> result;
+	mul_mat4(&a[0][0], &b[0][0], &result[0][0]);
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : transform_points ()
+/// <summary>
+/// Transforms count points by the affine matrix m, on the registers for
+/// packed float vectors. out may be in.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename T, glm::qualifier Q>
+inline void transform_points(const glm::mat<4, 4, T, Q>& m, const glm::vec<3, T, Q>* in,
+							 glm::vec<3, T, Q>* out, std::size_t count)
+{
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		out[i] = glm::vec<3, T, Q>(m * glm::vec<4, T, Q>(in[i], T(1)));
+	}
+}
+
+template <glm::qualifier Q>
+inline void transform_points(const glm::mat<4, 4, float, Q>& m, const glm::vec<3, float, Q>* in,
+							 glm::vec<3, float, Q>* out, std::size_t count)
+{
+	// aligned qualifiers pad vec3 to four floats
+	if(sizeof(glm::vec<3, float, Q>) == 3 * sizeof(float))
+	{
+		transform_points(&m[0][0], &in[0].x, &out[0].x, count);
+		return;
+	}
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		transform_points(&m[0][0], &in[i].x, &out[i].x, 1);
+	}
+}
+}
+}
@@ -3,6 +3,9 @@
 // transform Header Includes
 //-----------------------------------------------------------------------------
 #include "glm_includes.h"
+#include "simd.h"
+
+#include <cstddef>
 
 namespace math
 {
@@ -82,6 +85,15 @@ public:
 	static vec3_t transform_normal(const vec3_t& v, const transform_t& t);
 	static vec3_t inverse_transform_normal(const vec3_t& v, const transform_t& t);
 
+	//-------------------------------------------------------------------------
+	//  Name : transform_coords ()
+	/// <summary>
+	/// Transforms count points at once, for an affine transform, i.e. without
+	/// the divide by w of transform_coord. out may be in.
+	/// </summary>
+	//-------------------------------------------------------------------------
+	void transform_coords(const vec3_t* in, vec3_t* out, std::size_t count) const;
+
 	static const transform_t& identity();
 	//-------------------------------------------------------------------------
 	// Public Operator Overloads
@@ -126,11 +138,7 @@ private:
 	{
 		if(dirty_)
 		{
-			auto translation = glm::translate(position_);
-			auto rotation = glm::mat4_cast(rotation_);
-			auto scale = glm::scale(scale_);
-
-			matrix_ = translation * rotation * scale;
+			matrix_ = simd::compose(position_, rotation_, scale_);
 
 			dirty_ = false;
 		}
@@ -440,6 +448,13 @@ transform_t<T, Q>::inverse_transform_normal(const typename transform_t::vec3_t&
 	return result;
 }
 
+template <typename T, qualifier Q>
+inline void transform_t<T, Q>::transform_coords(const typename transform_t::vec3_t* in,
+												typename transform_t::vec3_t* out, std::size_t count) const
+{
+	simd::transform_points(get_matrix(), in, out, count);
+}
+
 template <typename T, qualifier Q>
 inline const transform_t<T, Q>& transform_t<T, Q>::identity()
 {
@@ -450,7 +465,7 @@ inline const transform_t<T, Q>& transform_t<T, Q>::identity()
 template <typename T, qualifier Q>
 inline transform_t<T, Q> transform_t<T, Q>::operator*(const transform_t& t) const
 {
-	transform_t result(get_matrix() * t.get_matrix());
+	transform_t result(simd::mul(get_matrix(), t.get_matrix()));
 	return result;
 }
 
@@ -0,0 +1,257 @@
+#include "triangle_bvh.h"
+#include <algorithm>
+#include <limits>
+
+namespace math
+{
+namespace
+{
+bbox get_union(const bbox& a, const bbox& b)
+{
+	return bbox(glm::min(a.min, b.min), glm::max(a.max, b.max));
+}
+
+//-----------------------------------------------------------------------------
+//  Name : intersect_slabs ()
+/// <summary>
+/// Where the segment enters the box as a fraction of it, false if it misses
+/// the box or enters it after max_fraction.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool intersect_slabs(const bbox& bounds, const vec3& origin, const vec3& inv_segment, float max_fraction,
+					 float& fraction)
+{
+	const auto t0 = (bounds.min - origin) * inv_segment;
+	const auto t1 = (bounds.max - origin) * inv_segment;
+	const auto near_t = glm::min(t0, t1);
+	const auto far_t = glm::max(t0, t1);
+	const auto enter = std::max(std::max(near_t.x, near_t.y), std::max(near_t.z, 0.0f));
+	const auto leave = std::min(std::min(far_t.x, far_t.y), std::min(far_t.z, max_fraction));
+	fraction = enter;
+	return enter <= leave;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : intersect_triangle ()
+/// <summary>
+/// Moller-Trumbore, both faces of the triangle are hit.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool intersect_triangle(const vec3* corners, const vec3& origin, const vec3& segment, float& fraction)
+{
+	const auto edge1 = corners[1] - corners[0];
+	const auto edge2 = corners[2] - corners[0];
+	const auto p = cross(segment, edge2);
+	const auto det = dot(edge1, p);
+	if(std::abs(det) < std::numeric_limits<float>::epsilon())
+	{
+		return false;
+	}
+
+	const auto inv_det = 1.0f / det;
+	const auto s = origin - corners[0];
+	const auto u = dot(s, p) * inv_det;
+	if(u < 0.0f || u > 1.0f)
+	{
+		return false;
+	}
+
+	const auto q = cross(s, edge1);
+	const auto v = dot(segment, q) * inv_det;
+	if(v < 0.0f || u + v > 1.0f)
+	{
+		return false;
+	}
+
+	fraction = dot(edge2, q) * inv_det;
+	return fraction >= 0.0f && fraction <= 1.0f;
+}
+}
+
+constexpr std::uint32_t triangle_bvh::leaf_size;
+
+//-----------------------------------------------------------------------------
+//  Name : build ()
+/// <summary>
+/// Builds the tree of the triangles, three indices of the positions each.
+/// </summary>
+//-----------------------------------------------------------------------------
+void triangle_bvh::build(const std::vector<vec3>& positions, const std::uint32_t* indices,
+						 std::size_t triangle_count)
+{
+	nodes_.clear();
+	corners_.clear();
+	triangles_.clear();
+	if(triangle_count == 0)
+	{
+		return;
+	}
+
+	std::vector<bbox> bounds(triangle_count);
+	std::vector<vec3> centers(triangle_count);
+	triangles_.resize(triangle_count);
+	for(std::size_t i = 0; i < triangle_count; ++i)
+	{
+		const auto& v0 = positions[indices[i * 3 + 0]];
+		const auto& v1 = positions[indices[i * 3 + 1]];
+		const auto& v2 = positions[indices[i * 3 + 2]];
+		bounds[i] = bbox(glm::min(v0, glm::min(v1, v2)), glm::max(v0, glm::max(v1, v2)));
+		centers[i] = (bounds[i].min + bounds[i].max) * 0.5f;
+		triangles_[i] = std::uint32_t(i);
+	}
+
+	nodes_.reserve(triangle_count * 2 / leaf_size + 1);
+	build_node(bounds, centers, 0, std::uint32_t(triangle_count));
+
+	corners_.resize(triangle_count * 3);
+	for(std::size_t i = 0; i < triangle_count; ++i)
+	{
+		const auto triangle = triangles_[i];
+		for(std::size_t corner = 0; corner < 3; ++corner)
+		{
+			corners_[i * 3 + corner] = positions[indices[triangle * 3 + corner]];
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+//  Name : build_node ()
+/// <summary>
+/// Adds the node of the triangles from begin to end and its children, and
+/// returns its index.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::uint32_t triangle_bvh::build_node(const std::vector<bbox>& bounds, const std::vector<vec3>& centers,
+									   std::uint32_t begin, std::uint32_t end)
+{
+	const auto index = std::uint32_t(nodes_.size());
+	nodes_.emplace_back();
+
+	bbox node_bounds = bounds[triangles_[begin]];
+	bbox center_bounds(centers[triangles_[begin]], centers[triangles_[begin]]);
+	for(auto i = begin + 1; i < end; ++i)
+	{
+		const auto triangle = triangles_[i];
+		node_bounds = get_union(node_bounds, bounds[triangle]);
+		center_bounds = get_union(center_bounds, bbox(centers[triangle], centers[triangle]));
+	}
+	nodes_[index].bounds = node_bounds;
+
+	const auto extents = center_bounds.max - center_bounds.min;
+	const auto bigger = [](float a, float b) { return a > b; };
+	const int axis = bigger(extents.x, extents.y) ? (bigger(extents.x, extents.z) ? 0 : 2)
+												  : (bigger(extents.y, extents.z) ? 1 : 2);
+	if(end - begin <= leaf_size || extents[axis] <= 0.0f)
+	{
+		nodes_[index].first = begin;
+		nodes_[index].count = end - begin;
+		return index;
+	}
+
+	const auto middle = begin + (end - begin) / 2;
+	std::nth_element(std::begin(triangles_) + begin, std::begin(triangles_) + middle,
+					 std::begin(triangles_) + end, [&centers, axis](std::uint32_t lhs, std::uint32_t rhs) {
+						 return centers[lhs][axis] < centers[rhs][axis];
+					 });
+
+	build_node(bounds, centers, begin, middle);
+	const auto second = build_node(bounds, centers, middle, end);
+	nodes_[index].first = second;
+	return index;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : raycast ()
+/// <summary>
+/// Finds the nearest triangle the segment goes through, from either side.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool triangle_bvh::raycast(const vec3& origin, const vec3& segment, hit& result) const
+{
+	if(nodes_.empty())
+	{
+		return false;
+	}
+
+	// a zero component gives infinities, which the slab test handles
+	const vec3 inv_segment(1.0f / segment.x, 1.0f / segment.y, 1.0f / segment.z);
+
+	bool found = false;
+	float best = 1.0f;
+	float fraction = 0.0f;
+	if(!intersect_slabs(nodes_[0].bounds, origin, inv_segment, best, fraction))
+	{
+		return false;
+	}
+
+	struct entry
+	{
+		std::uint32_t index;
+		/// where the segment enters the node
+		float fraction;
+	};
+
+	entry stack[64];
+	std::size_t size = 0;
+	stack[size++] = {0, fraction};
+	while(size > 0)
+	{
+		const auto e = stack[--size];
+		if(e.fraction > best)
+		{
+			continue;
+		}
+
+		const auto& n = nodes_[e.index];
+		if(n.count > 0)
+		{
+			for(auto i = n.first; i < n.first + n.count; ++i)
+			{
+				float t = 0.0f;
+				if(intersect_triangle(&corners_[i * 3], origin, segment, t) && t < best)
+				{
+					best = t;
+					result.triangle = triangles_[i];
+					result.fraction = t;
+					found = true;
+				}
+			}
+			continue;
+		}
+
+		const auto first = e.index + 1;
+		const auto second = n.first;
+		float first_fraction = 0.0f;
+		float second_fraction = 0.0f;
+		const bool first_hit =
+			intersect_slabs(nodes_[first].bounds, origin, inv_segment, best, first_fraction);
+		const bool second_hit =
+			intersect_slabs(nodes_[second].bounds, origin, inv_segment, best, second_fraction);
+
+		// the nearer child is popped first; a tree deeper than the stack is
+		// not built from the median splits of the meshes this is used for
+		if(first_hit && second_hit && size + 2 <= 64)
+		{
+			if(first_fraction < second_fraction)
+			{
+				stack[size++] = {second, second_fraction};
+				stack[size++] = {first, first_fraction};
+			}
+			else
+			{
+				stack[size++] = {first, first_fraction};
+				stack[size++] = {second, second_fraction};
+			}
+		}
+		else if(first_hit && size < 64)
+		{
+			stack[size++] = {first, first_fraction};
+		}
+		else if(second_hit && size < 64)
+		{
+			stack[size++] = {second, second_fraction};
+		}
+	}
+	return found;
+}
+}
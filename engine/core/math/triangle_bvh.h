@@ -0,0 +1,96 @@
+#pragma once
+
+#include "bbox.h"
+#include "math_types.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace math
+{
+using namespace glm;
+
+//-----------------------------------------------------------------------------
+// Main class declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : triangle_bvh (Class)
+/// <summary>
+/// Static bounding volume hierarchy of the triangles of a mesh, built once
+/// from top to bottom by splitting the longest axis of the centers of the
+/// triangles at their median. The triangles are kept in the order of the
+/// leaves, next to each other, for the ray tests.
+/// </summary>
+//-----------------------------------------------------------------------------
+class triangle_bvh
+{
+public:
+	/// the triangles a leaf holds at most
+	static constexpr std::uint32_t leaf_size = 4;
+
+	struct hit
+	{
+		/// the index of the triangle in what the tree was built from
+		std::uint32_t triangle = 0;
+		/// along the segment, 0 at its origin and 1 at its end
+		float fraction = 0.0f;
+	};
+
+	//-------------------------------------------------------------------------
+	// Public Methods
+	//-------------------------------------------------------------------------
+	//-------------------------------------------------------------------------
+	//  Name : build ()
+	/// <summary>
+	/// Builds the tree of the triangles, three indices of the positions each.
+	/// </summary>
+	//-------------------------------------------------------------------------
+	void build(const std::vector<vec3>& positions, const std::uint32_t* indices, std::size_t triangle_count);
+
+	//-------------------------------------------------------------------------
+	//  Name : raycast ()
+	/// <summary>
+	/// Finds the nearest triangle the segment from origin to origin + segment
+	/// goes through, from either side. The nearer children are visited first
+	/// and the ones beyond the nearest hit so far are skipped.
+	/// </summary>
+	//-------------------------------------------------------------------------
+	bool raycast(const vec3& origin, const vec3& segment, hit& result) const;
+
+	bool empty() const
+	{
+		return nodes_.empty();
+	}
+
+	const bbox& get_bounds() const
+	{
+		return nodes_.front().bounds;
+	}
+
+private:
+	struct node
+	{
+		bbox bounds;
+		/// the first triangle of a leaf, the second child of an inner node,
+		/// its first child follows it
+		std::uint32_t first = 0;
+		/// the triangles of a leaf, 0 for an inner node
+		std::uint32_t count = 0;
+	};
+
+	//-------------------------------------------------------------------------
+	// Private Methods
+	//-------------------------------------------------------------------------
+	std::uint32_t build_node(const std::vector<bbox>& bounds, const std::vector<vec3>& centers,
+							 std::uint32_t begin, std::uint32_t end);
+
+	//-------------------------------------------------------------------------
+	// Private Variables
+	//-------------------------------------------------------------------------
+	std::vector<node> nodes_;
+	/// the corners of the triangles, three each, in the order of the leaves
+	std::vector<vec3> corners_;
+	/// the index of every triangle in what the tree was built from
+	std::vector<std::uint32_t> triangles_;
+};
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace core
+{
+/*
+ * frame_arena; memory that lives until the end of the frame it was
+ * allocated in.
+ *
+ *      Every thread bumps through blocks of its own, so allocating takes no
+ *      lock. next_frame is called once the frame ends and a thread rewinds
+ *      its blocks the first time it allocates in a later frame. The blocks
+ *      a frame needed are merged into one, in the steady state a frame does
+ *      not touch the heap. Nothing allocated here may be kept past the frame,
+ *      by any thread.
+ */
+class frame_arena
+{
+public:
+	/// the smallest block a thread allocates
+	static constexpr std::size_t block_size = 256 * 1024;
+
+	//-----------------------------------------------------------------------------
+	//  Name : allocate ()
+	/// <summary>
+	/// Memory for the frame from the blocks of the calling thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void* allocate(std::size_t size, std::size_t alignment)
+	{
+		auto& arena = get_thread_arena();
+		const auto frame = get_frame_counter().load(std::memory_order_acquire);
+		if(arena.frame != frame)
+		{
+			arena.rewind();
+			arena.frame = frame;
+		}
+		return arena.allocate(size, alignment);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : next_frame ()
+	/// <summary>
+	/// Ends the frame, the memory allocated in it is reused from now on.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void next_frame()
+	{
+		get_frame_counter().fetch_add(1, std::memory_order_acq_rel);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_used_bytes ()
+	/// <summary>
+	/// The bytes the calling thread allocated in its current frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static std::size_t get_used_bytes()
+	{
+		return get_thread_arena().used;
+	}
+
+private:
+	struct block
+	{
+		std::unique_ptr<std::uint8_t[]> data;
+		std::size_t size = 0;
+	};
+
+	struct thread_arena
+	{
+		std::vector<block> blocks;
+		/// the block being bumped through and the offset in it
+		std::size_t current = 0;
+		std::size_t offset = 0;
+		std::size_t used = 0;
+		std::uint64_t frame = 0;
+
+		void rewind()
+		{
+			if(blocks.size() > 1)
+			{
+				std::size_t total = 0;
+				for(const auto& b : blocks)
+				{
+					total += b.size;
+				}
+				blocks.clear();
+				add_block(total);
+			}
+			current = 0;
+			offset = 0;
+			used = 0;
+		}
+
+		void add_block(std::size_t size)
+		{
+			block b;
+			b.size = size;
+			b.data.reset(new std::uint8_t[size]);
+			blocks.emplace_back(std::move(b));
+		}
+
+		void* allocate(std::size_t size, std::size_t alignment)
+		{
+			for(; current < blocks.size(); ++current, offset = 0)
+			{
+				auto& b = blocks[current];
+				const auto base = reinterpret_cast<std::uintptr_t>(b.data.get());
+				const auto aligned = (base + offset + alignment - 1) & ~std::uintptr_t(alignment - 1);
+				const auto end = aligned - base + size;
+				if(end <= b.size)
+				{
+					offset = end;
+					used += size;
+					return reinterpret_cast<void*>(aligned);
+				}
+			}
+
+			const std::size_t min_size = block_size;
+			add_block(std::max(min_size, size + alignment));
+			current = blocks.size() - 1;
+			offset = 0;
+			return allocate(size, alignment);
+		}
+	};
+
+	static thread_arena& get_thread_arena()
+	{
+		thread_local thread_arena arena;
+		return arena;
+	}
+
+	static std::atomic<std::uint64_t>& get_frame_counter()
+	{
+		static std::atomic<std::uint64_t> frame{0};
+		return frame;
+	}
+};
+
+/// An allocator of the frame arena, deallocate does nothing.
+template <typename T>
+struct frame_allocator
+{
+	using value_type = T;
+
+	frame_allocator() noexcept = default;
+	template <typename U>
+	frame_allocator(const frame_allocator<U>& /*other*/) noexcept
+	{
+	}
+
+	T* allocate(std::size_t n)
+	{
+		return static_cast<T*>(frame_arena::allocate(n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T* /*p*/, std::size_t /*n*/) noexcept
+	{
+	}
+};
+
+template <typename T, typename U>
+bool operator==(const frame_allocator<T>& /*lhs*/, const frame_allocator<U>& /*rhs*/) noexcept
+{
+	return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const frame_allocator<T>& /*lhs*/, const frame_allocator<U>& /*rhs*/) noexcept
+{
+	return false;
+}
+
+template <typename T>
+using frame_vector = std::vector<T, frame_allocator<T>>;
+}
@@ -0,0 +1,248 @@
+#include "memory_tracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+namespace core
+{
+namespace
+{
+struct tag_counters
+{
+	std::atomic<std::uint64_t> live_bytes{0};
+	std::atomic<std::uint64_t> live_allocations{0};
+	std::atomic<std::uint64_t> peak_bytes{0};
+	/// since init, the frame counts are the difference with the last frame
+	std::atomic<std::uint64_t> allocations{0};
+	std::atomic<std::uint64_t> bytes{0};
+};
+
+tag_counters s_counters[std::size_t(memory_tag::count)];
+thread_local memory_tag s_current_tag = memory_tag::untagged;
+
+std::mutex s_frame_mutex;
+memory_tracker_stats s_frame;
+std::uint64_t s_last_allocations[std::size_t(memory_tag::count)] = {};
+std::uint64_t s_last_bytes[std::size_t(memory_tag::count)] = {};
+std::uint64_t s_frames = 0;
+
+#ifdef ETH_MEMORY_TRACKING
+/// in front of every allocation, padded to keep the allocation aligned
+struct alignas(std::max_align_t) allocation_header
+{
+	std::size_t size;
+	memory_tag tag;
+};
+
+void* tracked_allocate(std::size_t size) noexcept
+{
+	auto header = static_cast<allocation_header*>(std::malloc(sizeof(allocation_header) + size));
+	if(header == nullptr)
+	{
+		return nullptr;
+	}
+	header->size = size;
+	header->tag = s_current_tag;
+
+	auto& counters = s_counters[std::size_t(header->tag)];
+	counters.allocations.fetch_add(1, std::memory_order_relaxed);
+	counters.bytes.fetch_add(size, std::memory_order_relaxed);
+	counters.live_allocations.fetch_add(1, std::memory_order_relaxed);
+	const auto live = counters.live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+	auto peak = counters.peak_bytes.load(std::memory_order_relaxed);
+	while(live > peak && !counters.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+	{
+	}
+	return header + 1;
+}
+
+void tracked_free(void* p) noexcept
+{
+	if(p == nullptr)
+	{
+		return;
+	}
+	auto header = static_cast<allocation_header*>(p) - 1;
+	auto& counters = s_counters[std::size_t(header->tag)];
+	counters.live_allocations.fetch_sub(1, std::memory_order_relaxed);
+	counters.live_bytes.fetch_sub(header->size, std::memory_order_relaxed);
+	std::free(header);
+}
+#endif
+}
+
+const char* get_memory_tag_name(memory_tag tag)
+{
+	switch(tag)
+	{
+		case memory_tag::untagged:
+			return "untagged";
+		case memory_tag::ecs:
+			return "ecs";
+		case memory_tag::assets:
+			return "assets";
+		case memory_tag::rendering:
+			return "rendering";
+		case memory_tag::audio:
+			return "audio";
+		case memory_tag::editor:
+			return "editor";
+		default:
+			return "";
+	}
+}
+
+namespace memory_tracker
+{
+bool is_enabled()
+{
+#ifdef ETH_MEMORY_TRACKING
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool next_frame()
+{
+	std::lock_guard<std::mutex> lock(s_frame_mutex);
+	s_frame.frame_allocations = 0;
+	s_frame.frame_bytes = 0;
+	for(std::size_t i = 0; i < std::size_t(memory_tag::count); ++i)
+	{
+		const auto allocations = s_counters[i].allocations.load(std::memory_order_relaxed);
+		const auto bytes = s_counters[i].bytes.load(std::memory_order_relaxed);
+		auto& tag = s_frame.tags[i];
+		tag.frame_allocations = allocations - s_last_allocations[i];
+		tag.frame_bytes = bytes - s_last_bytes[i];
+		s_last_allocations[i] = allocations;
+		s_last_bytes[i] = bytes;
+
+		s_frame.frame_allocations += tag.frame_allocations;
+		s_frame.frame_bytes += tag.frame_bytes;
+	}
+
+	// the first frames load everything, they only start the average
+	const auto allocations = double(s_frame.frame_allocations);
+	s_frame.spike = s_frames > 0 && s_frame.frame_allocations >= spike_min_allocations &&
+					allocations > spike_factor * s_frame.average_allocations;
+	if(s_frame.spike)
+	{
+		++s_frame.spikes;
+	}
+	else
+	{
+		s_frame.average_allocations = s_frames == 0 ? allocations
+													: s_frame.average_allocations * 0.95 + allocations * 0.05;
+	}
+	++s_frames;
+	return s_frame.spike;
+}
+
+memory_tracker_stats get_stats()
+{
+	memory_tracker_stats stats;
+	{
+		std::lock_guard<std::mutex> lock(s_frame_mutex);
+		stats = s_frame;
+	}
+	for(std::size_t i = 0; i < std::size_t(memory_tag::count); ++i)
+	{
+		auto& tag = stats.tags[i];
+		tag.live_bytes = s_counters[i].live_bytes.load(std::memory_order_relaxed);
+		tag.live_allocations = s_counters[i].live_allocations.load(std::memory_order_relaxed);
+		tag.peak_bytes = s_counters[i].peak_bytes.load(std::memory_order_relaxed);
+	}
+	return stats;
+}
+
+memory_tag get_current_tag()
+{
+	return s_current_tag;
+}
+}
+
+scoped_memory_tag::scoped_memory_tag(memory_tag tag)
+	: previous_(s_current_tag)
+{
+	s_current_tag = tag;
+}
+
+scoped_memory_tag::~scoped_memory_tag()
+{
+	s_current_tag = previous_;
+}
+}
+
+#ifdef ETH_MEMORY_TRACKING
+void* operator new(std::size_t size)
+{
+	for(;;)
+	{
+		if(auto p = core::tracked_allocate(size == 0 ? 1 : size))
+		{
+			return p;
+		}
+		auto handler = std::get_new_handler();
+		if(handler == nullptr)
+		{
+			throw std::bad_alloc();
+		}
+		handler();
+	}
+}
+
+void* operator new[](std::size_t size)
+{
+	return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t& /*tag*/) noexcept
+{
+	try
+	{
+		return ::operator new(size);
+	}
+	catch(...)
+	{
+		return nullptr;
+	}
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& /*tag*/) noexcept
+{
+	return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void* p) noexcept
+{
+	core::tracked_free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	core::tracked_free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t& /*tag*/) noexcept
+{
+	core::tracked_free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t& /*tag*/) noexcept
+{
+	core::tracked_free(p);
+}
+
+void operator delete(void* p, std::size_t /*size*/) noexcept
+{
+	core::tracked_free(p);
+}
+
+void operator delete[](void* p, std::size_t /*size*/) noexcept
+{
+	core::tracked_free(p);
+}
+#endif
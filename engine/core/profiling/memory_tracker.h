@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace core
+{
+enum class memory_tag : std::uint8_t
+{
+	/// allocated outside of a scoped_memory_tag
+	untagged,
+	ecs,
+	assets,
+	rendering,
+	audio,
+	editor,
+	count
+};
+
+const char* get_memory_tag_name(memory_tag tag);
+
+struct memory_tag_stats
+{
+	/// the bytes and the allocations alive
+	std::uint64_t live_bytes = 0;
+	std::uint64_t live_allocations = 0;
+	/// the most bytes alive at once
+	std::uint64_t peak_bytes = 0;
+	/// the allocations and their bytes in the last frame
+	std::uint64_t frame_allocations = 0;
+	std::uint64_t frame_bytes = 0;
+};
+
+struct memory_tracker_stats
+{
+	std::array<memory_tag_stats, std::size_t(memory_tag::count)> tags;
+	/// the allocations of the last frame in every tag
+	std::uint64_t frame_allocations = 0;
+	std::uint64_t frame_bytes = 0;
+	/// the average allocations of a frame, the spikes are measured against
+	double average_allocations = 0.0;
+	/// true when the last frame was a spike, and the spikes since init
+	bool spike = false;
+	std::uint64_t spikes = 0;
+};
+
+/*
+ * memory_tracker; the heap allocations by the tag of the code making them.
+ *
+ *      Only built in with ETH_MEMORY_TRACKING, which replaces the global
+ *      operator new and delete. Every allocation gets a header with its size
+ *      and the tag of the innermost scoped_memory_tag on the thread, a free
+ *      is counted in the tag it was allocated in. next_frame closes the
+ *      frame counts and flags the frames allocating far more than usual.
+ */
+namespace memory_tracker
+{
+/// a frame allocating this many times its average and at least
+/// spike_min_allocations is a spike
+constexpr double spike_factor = 4.0;
+constexpr std::uint64_t spike_min_allocations = 1000;
+
+//-----------------------------------------------------------------------------
+//  Name : is_enabled ()
+/// <summary>
+/// False when the build does not track the allocations, the stats stay 0.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool is_enabled();
+
+//-----------------------------------------------------------------------------
+//  Name : next_frame ()
+/// <summary>
+/// Closes the counts of the frame. Returns true if it was a spike.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool next_frame();
+
+//-----------------------------------------------------------------------------
+//  Name : get_stats ()
+/// <summary>
+/// The live counts and the ones of the last closed frame.
+/// </summary>
+//-----------------------------------------------------------------------------
+memory_tracker_stats get_stats();
+
+memory_tag get_current_tag();
+}
+
+/// Tags the allocations of the thread while alive.
+struct scoped_memory_tag
+{
+	explicit scoped_memory_tag(memory_tag tag);
+	~scoped_memory_tag();
+	scoped_memory_tag(const scoped_memory_tag&) = delete;
+	scoped_memory_tag& operator=(const scoped_memory_tag&) = delete;
+
+private:
+	memory_tag previous_;
+};
+}
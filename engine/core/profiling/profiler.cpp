@@ -0,0 +1,271 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace profiling
+{
+namespace detail
+{
+std::atomic<bool> enabled = {false};
+}
+
+namespace
+{
+struct zone
+{
+	/// 2 * (sequence + 1) once written, odd while being written
+	std::atomic<std::uint64_t> stamp = {0};
+	const char* name = nullptr;
+	clock_t::rep begin = 0;
+	clock_t::rep end = 0;
+};
+
+/*
+ * thread_ring; the last zones of a thread. Only the thread writes to it,
+ * the zones are stamped like the console slots so that a reader skips one
+ * overwritten while it was read.
+ */
+struct thread_ring
+{
+	/// the zones kept per thread, a power of two
+	static constexpr std::uint64_t capacity = 1 << 14;
+
+	/// the sequence the next zone takes
+	std::atomic<std::uint64_t> next = {0};
+	/// set under the registry mutex. the ring of a thread that exited is
+	/// taken by the next new thread, their zones share the track.
+	std::thread::id id;
+	bool in_use = false;
+	std::array<zone, capacity> zones;
+};
+
+constexpr std::uint64_t thread_ring::capacity;
+
+struct registry
+{
+	std::mutex mutex;
+	std::vector<std::unique_ptr<thread_ring>> rings;
+	std::unordered_map<std::thread::id, std::string> names;
+	/// a node set, the strings never move
+	std::unordered_set<std::string> interned;
+	std::atomic<clock_t::rep> origin = {0};
+};
+
+registry& get_registry()
+{
+	static registry r;
+	return r;
+}
+
+// gives the ring back when the thread exits
+struct ring_owner
+{
+	thread_ring* ring = nullptr;
+
+	~ring_owner()
+	{
+		if(ring != nullptr)
+		{
+			auto& r = get_registry();
+			std::lock_guard<std::mutex> lock(r.mutex);
+			ring->in_use = false;
+		}
+	}
+};
+
+thread_ring& acquire_ring()
+{
+	auto& r = get_registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	auto it = std::find_if(std::begin(r.rings), std::end(r.rings),
+						   [](const auto& ring) { return !ring->in_use; });
+	if(it == std::end(r.rings))
+	{
+		r.rings.emplace_back(std::make_unique<thread_ring>());
+		it = std::prev(std::end(r.rings));
+	}
+
+	auto& ring = **it;
+	ring.in_use = true;
+	ring.id = std::this_thread::get_id();
+	return ring;
+}
+
+// calls fn with the zones of the ring still kept that overlap [first, last)
+template <typename F>
+void for_each_zone(const thread_ring& ring, clock_t::rep first, clock_t::rep last, F&& fn)
+{
+	const auto end = ring.next.load(std::memory_order_acquire);
+	const auto begin = end > thread_ring::capacity ? end - thread_ring::capacity : 0;
+
+	for(auto at = begin; at < end; ++at)
+	{
+		const auto& z = ring.zones[at % thread_ring::capacity];
+		const auto written = 2 * (at + 1);
+		if(z.stamp.load(std::memory_order_acquire) != written)
+		{
+			continue;
+		}
+
+		const auto* name = z.name;
+		const auto zone_begin = z.begin;
+		const auto zone_end = z.end;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if(z.stamp.load(std::memory_order_relaxed) != written || zone_end < first || zone_begin >= last)
+		{
+			continue;
+		}
+
+		fn(name, zone_begin, zone_end);
+	}
+}
+
+void write_escaped(std::ostream& out, const std::string& text)
+{
+	for(const auto c : text)
+	{
+		if(c == '"' || c == '\\')
+		{
+			out << '\\';
+		}
+		out << c;
+	}
+}
+}
+
+namespace detail
+{
+void record(const char* name, clock_t::time_point begin, clock_t::time_point end)
+{
+	thread_local ring_owner owner;
+	if(owner.ring == nullptr)
+	{
+		owner.ring = &acquire_ring();
+	}
+
+	auto& ring = *owner.ring;
+	const auto sequence = ring.next.load(std::memory_order_relaxed);
+	auto& z = ring.zones[sequence % thread_ring::capacity];
+
+	z.stamp.store(2 * sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	z.name = name;
+	z.begin = begin.time_since_epoch().count();
+	z.end = end.time_since_epoch().count();
+	z.stamp.store(2 * (sequence + 1), std::memory_order_release);
+	ring.next.store(sequence + 1, std::memory_order_release);
+}
+}
+
+void set_enabled(bool enabled)
+{
+	if(enabled && !detail::enabled.load(std::memory_order_relaxed))
+	{
+		get_registry().origin = clock_t::now().time_since_epoch().count();
+	}
+	detail::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void set_thread_name(std::thread::id id, const std::string& name)
+{
+	auto& r = get_registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	r.names[id] = name;
+}
+
+const char* intern(const std::string& name)
+{
+	auto& r = get_registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	return r.interned.insert(name).first->c_str();
+}
+
+void write_chrome_trace(std::ostream& out)
+{
+	const auto origin = clock_t::time_point(clock_t::duration(get_registry().origin.load()));
+	write_chrome_trace(out, origin, clock_t::time_point::max());
+}
+
+void write_chrome_trace(std::ostream& out, clock_t::time_point range_begin, clock_t::time_point range_end)
+{
+	using us_t = std::chrono::duration<double, std::micro>;
+	const auto to_us = [](clock_t::rep ticks) {
+		return std::chrono::duration_cast<us_t>(clock_t::duration(ticks)).count();
+	};
+
+	auto& r = get_registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	const auto origin = range_begin.time_since_epoch().count();
+	const auto last = range_end.time_since_epoch().count();
+
+	out << "{\"traceEvents\":[";
+	bool first = true;
+	const auto separate = [&]() {
+		if(!first)
+		{
+			out << ",";
+		}
+		first = false;
+	};
+
+	for(std::size_t tid = 0; tid < r.rings.size(); ++tid)
+	{
+		const auto& ring = *r.rings[tid];
+		auto it = r.names.find(ring.id);
+		separate();
+		out << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << tid
+			<< ",\"args\":{\"name\":\"";
+		write_escaped(out, it != std::end(r.names) ? it->second : "thread_" + std::to_string(tid));
+		out << "\"}}";
+
+		const auto write_zone = [&](const char* name, clock_t::rep zone_begin, clock_t::rep zone_end) {
+			separate();
+			out << "\n{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << tid
+				<< ",\"ts\":" << to_us(std::max(zone_begin, origin) - origin)
+				<< ",\"dur\":" << to_us(zone_end - std::max(zone_begin, origin)) << "}";
+		};
+		for_each_zone(ring, origin, last, write_zone);
+	}
+
+	out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+std::vector<zone_total> get_zone_totals(clock_t::time_point range_begin, clock_t::time_point range_end)
+{
+	auto& r = get_registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	const auto first = range_begin.time_since_epoch().count();
+	const auto last = range_end.time_since_epoch().count();
+
+	// by the text, a literal may have a pointer per translation unit
+	std::unordered_map<std::string, std::size_t> indices;
+	std::vector<zone_total> totals;
+	for(const auto& ring : r.rings)
+	{
+		const auto add_zone = [&](const char* name, clock_t::rep zone_begin, clock_t::rep zone_end) {
+			auto it = indices.emplace(name, totals.size()).first;
+			if(it->second == totals.size())
+			{
+				totals.emplace_back();
+				totals.back().name = name;
+			}
+			auto& total = totals[it->second];
+			total.time += clock_t::duration(std::min(zone_end, last) - std::max(zone_begin, first));
+			++total.count;
+		};
+		for_each_zone(*ring, first, last, add_zone);
+	}
+
+	std::sort(std::begin(totals), std::end(totals),
+			  [](const zone_total& lhs, const zone_total& rhs) { return lhs.time > rhs.time; });
+	return totals;
+}
+}
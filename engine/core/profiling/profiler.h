@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * profiling; named zones of cpu time, for a whole frame to be seen across
+ * the threads in chrome://tracing (or anything reading its json format).
+ *
+ *      PROFILE_SCOPE("name") times the rest of the block it is in. While
+ *      the profiling is enabled every thread keeps its last zones in a ring
+ *      of its own, written without a lock or an allocation, and the rings
+ *      are read when the trace is written. Disabled, a zone costs a relaxed
+ *      load, and compiled without ETH_PROFILING nothing at all.
+ */
+namespace profiling
+{
+using clock_t = std::chrono::steady_clock;
+
+//-----------------------------------------------------------------------------
+//  Name : set_enabled ()
+/// <summary>
+/// Starts or stops recording the zones. Starting again forgets the zones
+/// recorded before.
+/// </summary>
+//-----------------------------------------------------------------------------
+void set_enabled(bool enabled);
+
+//-----------------------------------------------------------------------------
+//  Name : set_thread_name ()
+/// <summary>
+/// The name the thread is shown with in the trace.
+/// </summary>
+//-----------------------------------------------------------------------------
+void set_thread_name(std::thread::id id, const std::string& name);
+
+//-----------------------------------------------------------------------------
+//  Name : intern ()
+/// <summary>
+/// A copy of the name kept for the rest of the run, for the zones named at
+/// runtime. The same name gives the same pointer.
+/// </summary>
+//-----------------------------------------------------------------------------
+const char* intern(const std::string& name);
+
+//-----------------------------------------------------------------------------
+//  Name : write_chrome_trace ()
+/// <summary>
+/// Writes the zones recorded since the profiling was enabled and still kept
+/// by the rings, in the chrome://tracing json format, one track per thread.
+/// Can be called while recording.
+/// </summary>
+//-----------------------------------------------------------------------------
+void write_chrome_trace(std::ostream& out);
+
+//-----------------------------------------------------------------------------
+//  Name : write_chrome_trace ()
+/// <summary>
+/// Writes the zones still kept that overlap [begin, end), the timestamps
+/// relative to begin.
+/// </summary>
+//-----------------------------------------------------------------------------
+void write_chrome_trace(std::ostream& out, clock_t::time_point begin, clock_t::time_point end);
+
+/// the time spent in the zones of a name and how many there were
+struct zone_total
+{
+	const char* name = nullptr;
+	clock_t::duration time = clock_t::duration::zero();
+	std::uint32_t count = 0;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : get_zone_totals ()
+/// <summary>
+/// The zones still kept that overlap [begin, end) summed by name over every
+/// thread, the longest first. A zone is counted for its part in the range,
+/// the zones in it included.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::vector<zone_total> get_zone_totals(clock_t::time_point begin, clock_t::time_point end);
+
+namespace detail
+{
+extern std::atomic<bool> enabled;
+
+void record(const char* name, clock_t::time_point begin, clock_t::time_point end);
+}
+
+inline bool is_enabled()
+{
+	return detail::enabled.load(std::memory_order_relaxed);
+}
+
+/*
+ * scope; a zone from its construction to its destruction. The name is kept
+ * by pointer, it has to be a literal or interned.
+ */
+class scope
+{
+public:
+	explicit scope(const char* name)
+		: name_(name)
+	{
+		if(is_enabled())
+		{
+			begin_ = clock_t::now();
+		}
+	}
+
+	~scope()
+	{
+		if(begin_ != clock_t::time_point{})
+		{
+			detail::record(name_, begin_, clock_t::now());
+		}
+	}
+
+	scope(const scope&) = delete;
+	scope& operator=(const scope&) = delete;
+
+private:
+	const char* name_;
+	clock_t::time_point begin_;
+};
+}
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef ETH_PROFILING
+#define PROFILE_SCOPE(name) ::profiling::scope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) (void)0
+#endif
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "reflection.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace reflection
+{
+/*
+ * property_info; what is looked up of a property every time it is accessed,
+ * read from its registration once.
+ */
+struct property_info
+{
+	explicit property_info(const rttr::property& p)
+		: prop(p)
+		, name(p.get_name().to_string())
+		, read_only(p.is_readonly())
+		, is_enum(p.is_enumeration())
+	{
+		const auto type = p.get_type();
+		static_type = !type.is_pointer() && !type.is_wrapper();
+
+		pretty_name = name;
+		const auto meta_pretty_name = p.get_metadata("pretty_name");
+		if(meta_pretty_name)
+		{
+			pretty_name = meta_pretty_name.get_value<std::string>();
+		}
+
+		const auto meta_tooltip = p.get_metadata("tooltip");
+		if(meta_tooltip)
+		{
+			tooltip = meta_tooltip.to_string();
+		}
+	}
+
+	rttr::property prop;
+	std::string name;
+	/// the "pretty_name" metadata, the name when there is none
+	std::string pretty_name;
+	/// the "tooltip" metadata, empty when there is none
+	std::string tooltip;
+	bool read_only = false;
+	bool is_enum = false;
+	/// the value is of the type of the property, not a pointer or a wrapper
+	/// which may hold a derived type
+	bool static_type = false;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : get_properties ()
+/// <summary>
+/// The properties of the type with their metadata, built the first time the
+/// type is asked for and kept for the rest of the run. Types are registered
+/// before main, so the table never goes stale. Safe from any thread.
+/// </summary>
+//-----------------------------------------------------------------------------
+inline const std::vector<property_info>& get_properties(const rttr::type& type)
+{
+	static std::mutex mutex;
+	static std::unordered_map<rttr::type, std::vector<property_info>> tables;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = tables.find(type);
+	if(it != std::end(tables))
+	{
+		return it->second;
+	}
+
+	std::vector<property_info> table;
+	for(const auto& prop : type.get_properties())
+	{
+		table.emplace_back(prop);
+	}
+	return tables.emplace(type, std::move(table)).first->second;
+}
+}
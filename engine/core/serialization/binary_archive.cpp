@@ -0,0 +1,53 @@
+#include "binary_archive.h"
+
+#include <iterator>
+
+namespace cereal
+{
+constexpr std::size_t buffer_output_archive::flush_size;
+
+buffer_output_archive::buffer_output_archive(std::ostream& stream)
+	: OutputArchive<buffer_output_archive, AllowEmptyClassElision>(this)
+	, buffer_(owned_)
+	, stream_(&stream)
+{
+	buffer_.reserve(flush_size);
+}
+
+buffer_output_archive::buffer_output_archive(std::vector<std::uint8_t>& memory)
+	: OutputArchive<buffer_output_archive, AllowEmptyClassElision>(this)
+	, buffer_(memory)
+{
+}
+
+buffer_output_archive::~buffer_output_archive() noexcept
+{
+	flush();
+}
+
+void buffer_output_archive::flush()
+{
+	if(!stream_ || buffer_.empty())
+	{
+		return;
+	}
+
+	stream_->write(reinterpret_cast<const char*>(buffer_.data()), std::streamsize(buffer_.size()));
+	buffer_.clear();
+}
+
+buffer_input_archive::buffer_input_archive(const std::uint8_t* data, std::size_t size)
+	: InputArchive<buffer_input_archive, AllowEmptyClassElision>(this)
+	, at_(data)
+	, end_(data + size)
+{
+}
+
+buffer_input_archive::buffer_input_archive(std::istream& stream)
+	: InputArchive<buffer_input_archive, AllowEmptyClassElision>(this)
+{
+	owned_.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+	at_ = owned_.data();
+	end_ = owned_.data() + owned_.size();
+}
+}
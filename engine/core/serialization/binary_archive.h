@@ -7,9 +7,199 @@
 //    using iarchive_binary_t = PortableBinaryInputArchive;
 //}
 
-#include "cereal/archives/binary.hpp"
+#include "serialization.h"
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <vector>
+
 namespace cereal
 {
-using oarchive_binary_t = BinaryOutputArchive;
-using iarchive_binary_t = BinaryInputArchive;
+/*
+ * buffer_output_archive; a binary archive writing to a contiguous block of
+ * memory.
+ *
+ *      The bytes are appended to a vector, every write is a copy and a size
+ *      check instead of a call through a stream. Over a stream the block is
+ *      written in large chunks and what is left when the archive is destroyed.
+ *      The layout is the one of cereal's binary archive, and arrays of types of
+ *      serialization::is_bulk_serializable are written as one copy.
+ */
+class buffer_output_archive : public OutputArchive<buffer_output_archive, AllowEmptyClassElision>
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : buffer_output_archive ()
+	/// <summary>
+	/// Writes to the stream, buffered.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	explicit buffer_output_archive(std::ostream& stream);
+
+	//-----------------------------------------------------------------------------
+	//  Name : buffer_output_archive ()
+	/// <summary>
+	/// Appends to the memory, which must outlive the archive.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	explicit buffer_output_archive(std::vector<std::uint8_t>& memory);
+
+	~buffer_output_archive() noexcept;
+
+	void saveBinary(const void* data, std::size_t size)
+	{
+		const auto at = buffer_.size();
+		buffer_.resize(at + size);
+		std::memcpy(buffer_.data() + at, data, size);
+		if(stream_ && buffer_.size() >= flush_size)
+		{
+			flush();
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : flush ()
+	/// <summary>
+	/// Writes what is buffered to the stream, nothing when writing to memory.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void flush();
+
+private:
+	/// the bytes buffered before they are written to the stream
+	static constexpr std::size_t flush_size = 1 << 16;
+
+	std::vector<std::uint8_t> owned_;
+	std::vector<std::uint8_t>& buffer_;
+	std::ostream* stream_ = nullptr;
+};
+
+/*
+ * buffer_input_archive; a binary archive reading a contiguous block of
+ * memory in place.
+ *
+ *      Over a mapped file nothing is copied but the values read. Over a stream
+ *      what is left of it is read once into the archive.
+ */
+class buffer_input_archive : public InputArchive<buffer_input_archive, AllowEmptyClassElision>
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : buffer_input_archive ()
+	/// <summary>
+	/// Reads the memory in place, which must outlive the archive.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	buffer_input_archive(const std::uint8_t* data, std::size_t size);
+
+	//-----------------------------------------------------------------------------
+	//  Name : buffer_input_archive ()
+	/// <summary>
+	/// Reads the stream from where it is to its end.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	explicit buffer_input_archive(std::istream& stream);
+
+	~buffer_input_archive() noexcept = default;
+
+	void loadBinary(void* data, std::size_t size)
+	{
+		std::memcpy(data, read_in_place(size), size);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : read_in_place ()
+	/// <summary>
+	/// The next bytes without copying them, valid as long as the memory read.
+	/// Throws when there are not as many left.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const std::uint8_t* read_in_place(std::size_t size)
+	{
+		if(size > std::size_t(end_ - at_))
+		{
+			throw Exception("Failed to read " + std::to_string(size) + " bytes from input archive! " +
+							std::to_string(end_ - at_) + " left");
+		}
+		const auto data = at_;
+		at_ += size;
+		return data;
+	}
+
+private:
+	std::vector<std::uint8_t> owned_;
+	const std::uint8_t* at_ = nullptr;
+	const std::uint8_t* end_ = nullptr;
+};
+
+using oarchive_binary_t = buffer_output_archive;
+using iarchive_binary_t = buffer_input_archive;
+
+template <class T>
+inline typename std::enable_if<std::is_arithmetic<T>::value, void>::type
+CEREAL_SAVE_FUNCTION_NAME(buffer_output_archive& ar, T const& t)
+{
+	ar.saveBinary(std::addressof(t), sizeof(t));
+}
+
+template <class T>
+inline typename std::enable_if<std::is_arithmetic<T>::value, void>::type
+CEREAL_LOAD_FUNCTION_NAME(buffer_input_archive& ar, T& t)
+{
+	ar.loadBinary(std::addressof(t), sizeof(t));
 }
+
+template <class Archive, class T>
+inline CEREAL_ARCHIVE_RESTRICT(buffer_input_archive, buffer_output_archive)
+	CEREAL_SERIALIZE_FUNCTION_NAME(Archive& ar, NameValuePair<T>& t)
+{
+	ar(t.value);
+}
+
+template <class Archive, class T>
+inline CEREAL_ARCHIVE_RESTRICT(buffer_input_archive, buffer_output_archive)
+	CEREAL_SERIALIZE_FUNCTION_NAME(Archive& ar, SizeTag<T>& t)
+{
+	ar(t.size);
+}
+
+template <class T>
+inline void CEREAL_SAVE_FUNCTION_NAME(buffer_output_archive& ar, BinaryData<T> const& bd)
+{
+	ar.saveBinary(bd.data, static_cast<std::size_t>(bd.size));
+}
+
+template <class T>
+inline void CEREAL_LOAD_FUNCTION_NAME(buffer_input_archive& ar, BinaryData<T>& bd)
+{
+	ar.loadBinary(bd.data, static_cast<std::size_t>(bd.size));
+}
+
+// the size and the elements as one copy, the same bytes as one element after the other
+template <class T, class A>
+inline typename std::enable_if<serialization::is_bulk_serializable<T>::value && !std::is_arithmetic<T>::value,
+							   void>::type
+CEREAL_SAVE_FUNCTION_NAME(buffer_output_archive& ar, std::vector<T, A> const& vector)
+{
+	ar(make_size_tag(static_cast<size_type>(vector.size())));
+	ar.saveBinary(vector.data(), vector.size() * sizeof(T));
+}
+
+template <class T, class A>
+inline typename std::enable_if<serialization::is_bulk_serializable<T>::value && !std::is_arithmetic<T>::value,
+							   void>::type
+CEREAL_LOAD_FUNCTION_NAME(buffer_input_archive& ar, std::vector<T, A>& vector)
+{
+	size_type size;
+	ar(make_size_tag(size));
+
+	vector.resize(static_cast<std::size_t>(size));
+	ar.loadBinary(vector.data(), vector.size() * sizeof(T));
+}
+}
+
+CEREAL_REGISTER_ARCHIVE(cereal::buffer_output_archive)
+CEREAL_REGISTER_ARCHIVE(cereal::buffer_input_archive)
+CEREAL_SETUP_ARCHIVE_TRAITS(cereal::buffer_input_archive, cereal::buffer_output_archive)
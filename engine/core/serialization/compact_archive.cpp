@@ -0,0 +1,627 @@
+#include "compact_archive.h"
+
+#include <cstdlib>
+#include <iterator>
+#include <unordered_map>
+
+namespace cereal
+{
+constexpr std::uint32_t compact_tree::version;
+constexpr std::uint32_t compact_tree::invalid_index;
+
+namespace
+{
+/// deeper than any archive nests, what is read from a file is bounded by it
+constexpr std::size_t max_depth = 512;
+
+template <typename T>
+void put(std::vector<char>& out, T value)
+{
+	const auto at = out.size();
+	out.resize(at + sizeof(T));
+	std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+template <typename T>
+void patch(std::vector<char>& out, std::size_t at, T value)
+{
+	std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+// parses the json the associative archive writes and writes the values it
+// reads in the compact form right away
+class json_reader
+{
+public:
+	json_reader(std::vector<char>& out, std::vector<std::string>& strings)
+		: out_(out)
+		, strings_(strings)
+	{
+	}
+
+	bool read_document(const std::string& json)
+	{
+		at_ = json.data();
+		end_ = json.data() + json.size();
+		if(!read_value(0))
+		{
+			return false;
+		}
+		skip_space();
+		return at_ == end_;
+	}
+
+private:
+	void skip_space()
+	{
+		while(at_ != end_ && (*at_ == ' ' || *at_ == '\t' || *at_ == '\n' || *at_ == '\r'))
+		{
+			++at_;
+		}
+	}
+
+	bool take(char c)
+	{
+		skip_space();
+		if(at_ != end_ && *at_ == c)
+		{
+			++at_;
+			return true;
+		}
+		return false;
+	}
+
+	bool match(const char* word)
+	{
+		const auto size = std::strlen(word);
+		if(std::size_t(end_ - at_) < size || std::strncmp(at_, word, size) != 0)
+		{
+			return false;
+		}
+		at_ += size;
+		return true;
+	}
+
+	std::uint32_t intern(const std::string& str)
+	{
+		const auto it = indices_.find(str);
+		if(it != std::end(indices_))
+		{
+			return it->second;
+		}
+
+		const auto index = std::uint32_t(strings_.size());
+		indices_.emplace(str, index);
+		strings_.push_back(str);
+		return index;
+	}
+
+	static void append_utf8(std::string& str, std::uint32_t code)
+	{
+		if(code < 0x80)
+		{
+			str += char(code);
+		}
+		else if(code < 0x800)
+		{
+			str += char(0xc0 | (code >> 6));
+			str += char(0x80 | (code & 0x3f));
+		}
+		else if(code < 0x10000)
+		{
+			str += char(0xe0 | (code >> 12));
+			str += char(0x80 | ((code >> 6) & 0x3f));
+			str += char(0x80 | (code & 0x3f));
+		}
+		else
+		{
+			str += char(0xf0 | (code >> 18));
+			str += char(0x80 | ((code >> 12) & 0x3f));
+			str += char(0x80 | ((code >> 6) & 0x3f));
+			str += char(0x80 | (code & 0x3f));
+		}
+	}
+
+	bool read_hex(std::uint32_t& code)
+	{
+		if(end_ - at_ < 4)
+		{
+			return false;
+		}
+
+		code = 0;
+		for(int i = 0; i < 4; ++i, ++at_)
+		{
+			const char c = *at_;
+			code <<= 4;
+			if(c >= '0' && c <= '9')
+				code |= std::uint32_t(c - '0');
+			else if(c >= 'a' && c <= 'f')
+				code |= std::uint32_t(c - 'a' + 10);
+			else if(c >= 'A' && c <= 'F')
+				code |= std::uint32_t(c - 'A' + 10);
+			else
+				return false;
+		}
+		return true;
+	}
+
+	bool read_string(std::string& str)
+	{
+		if(!take('"'))
+		{
+			return false;
+		}
+
+		str.clear();
+		while(at_ != end_ && *at_ != '"')
+		{
+			const char c = *at_++;
+			if(c != '\\')
+			{
+				str += c;
+				continue;
+			}
+			if(at_ == end_)
+			{
+				return false;
+			}
+
+			const char escaped = *at_++;
+			switch(escaped)
+			{
+				case 'b':
+					str += '\b';
+					break;
+				case 'f':
+					str += '\f';
+					break;
+				case 'n':
+					str += '\n';
+					break;
+				case 'r':
+					str += '\r';
+					break;
+				case 't':
+					str += '\t';
+					break;
+				case 'u':
+				{
+					std::uint32_t code = 0;
+					if(!read_hex(code))
+					{
+						return false;
+					}
+					// the second half of a surrogate pair follows the first
+					std::uint32_t low = 0;
+					if(code >= 0xd800 && code < 0xdc00 && match("\\u") && read_hex(low))
+					{
+						code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+					}
+					append_utf8(str, code);
+					break;
+				}
+				default:
+					str += escaped;
+					break;
+			}
+		}
+		return take('"');
+	}
+
+	bool read_number()
+	{
+		const char* begin = at_;
+		bool integer = true;
+		while(at_ != end_ && *at_ != '\0' && std::strchr("+-0123456789.eE", *at_) != nullptr)
+		{
+			integer &= (*at_ != '.' && *at_ != 'e' && *at_ != 'E');
+			++at_;
+		}
+		if(at_ == begin)
+		{
+			return false;
+		}
+
+		const std::string text(begin, at_);
+		char* parsed = nullptr;
+		if(integer && text[0] == '-')
+		{
+			put(out_, compact_tree::node_type::int64);
+			put(out_, std::int64_t(std::strtoll(text.c_str(), &parsed, 10)));
+		}
+		else if(integer)
+		{
+			put(out_, compact_tree::node_type::uint64);
+			put(out_, std::uint64_t(std::strtoull(text.c_str(), &parsed, 10)));
+		}
+		else
+		{
+			put(out_, compact_tree::node_type::real);
+			put(out_, std::strtod(text.c_str(), &parsed));
+		}
+		return parsed == text.c_str() + text.size();
+	}
+
+	// the elements of an array or members of an object, their count written
+	// in front when it is known
+	template <typename F>
+	bool read_elements(char close, F&& read_element)
+	{
+		const auto count_at = out_.size();
+		put(out_, std::uint32_t(0));
+
+		std::uint32_t count = 0;
+		if(!take(close))
+		{
+			do
+			{
+				if(!read_element())
+				{
+					return false;
+				}
+				++count;
+			} while(take(','));
+
+			if(!take(close))
+			{
+				return false;
+			}
+		}
+		patch(out_, count_at, count);
+		return true;
+	}
+
+	bool read_value(std::size_t depth)
+	{
+		if(depth > max_depth)
+		{
+			return false;
+		}
+
+		skip_space();
+		if(at_ == end_)
+		{
+			return false;
+		}
+
+		switch(*at_)
+		{
+			case '{':
+				++at_;
+				put(out_, compact_tree::node_type::object);
+				return read_elements('}', [this, depth]() {
+					std::string name;
+					if(!read_string(name) || !take(':'))
+					{
+						return false;
+					}
+					put(out_, intern(name));
+					return read_value(depth + 1);
+				});
+			case '[':
+				++at_;
+				put(out_, compact_tree::node_type::array);
+				return read_elements(']', [this, depth]() { return read_value(depth + 1); });
+			case '"':
+			{
+				std::string str;
+				if(!read_string(str))
+				{
+					return false;
+				}
+				put(out_, compact_tree::node_type::string);
+				put(out_, intern(str));
+				return true;
+			}
+			case 't':
+				put(out_, compact_tree::node_type::boolean);
+				put(out_, std::uint8_t(1));
+				return match("true");
+			case 'f':
+				put(out_, compact_tree::node_type::boolean);
+				put(out_, std::uint8_t(0));
+				return match("false");
+			case 'n':
+				put(out_, compact_tree::node_type::null);
+				return match("null");
+			default:
+				return read_number();
+		}
+	}
+
+	std::vector<char>& out_;
+	std::vector<std::string>& strings_;
+	std::unordered_map<std::string, std::uint32_t> indices_;
+	const char* at_ = nullptr;
+	const char* end_ = nullptr;
+};
+}
+
+bool compact_tree::write(const std::vector<std::string>& documents, std::ostream& stream)
+{
+	std::vector<char> values;
+	std::vector<std::string> strings;
+	json_reader reader(values, strings);
+	for(const auto& document : documents)
+	{
+		if(!reader.read_document(document))
+		{
+			return false;
+		}
+	}
+
+	std::vector<char> out;
+	out.insert(std::end(out), std::begin(compact_tag), std::end(compact_tag));
+	put(out, version);
+	put(out, std::uint32_t(strings.size()));
+	for(const auto& str : strings)
+	{
+		put(out, std::uint32_t(str.size()));
+		// with its terminator, so the names are compared in place
+		out.insert(std::end(out), str.c_str(), str.c_str() + str.size() + 1);
+	}
+	put(out, std::uint32_t(documents.size()));
+	out.insert(std::end(out), std::begin(values), std::end(values));
+
+	stream.write(out.data(), std::streamsize(out.size()));
+	return stream.good();
+}
+
+bool compact_tree::read(std::istream& stream)
+{
+	buffer_.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+	at_ = 0;
+	strings_.clear();
+	string_sizes_.clear();
+	nodes_.clear();
+	documents_.clear();
+
+	char tag[sizeof(compact_tag)] = {};
+	std::uint32_t file_version = 0;
+	std::uint32_t strings_count = 0;
+	if(!get(tag) || std::memcmp(tag, compact_tag, sizeof(tag)) != 0 || !get(file_version) ||
+	   file_version != version || !get(strings_count))
+	{
+		return false;
+	}
+
+	strings_.reserve(strings_count);
+	string_sizes_.reserve(strings_count);
+	for(std::uint32_t i = 0; i < strings_count; ++i)
+	{
+		std::uint32_t size = 0;
+		if(!get(size) || buffer_.size() - at_ <= size || buffer_[at_ + size] != '\0')
+		{
+			return false;
+		}
+		strings_.push_back(buffer_.data() + at_);
+		string_sizes_.push_back(size);
+		at_ += size + 1;
+	}
+
+	std::uint32_t documents_count = 0;
+	if(!get(documents_count))
+	{
+		return false;
+	}
+
+	for(std::uint32_t i = 0; i < documents_count; ++i)
+	{
+		const auto root = std::uint32_t(nodes_.size());
+		nodes_.emplace_back();
+		documents_.push_back(root);
+		if(!read_value(root, 0))
+		{
+			return false;
+		}
+	}
+	return at_ == buffer_.size();
+}
+
+bool compact_tree::read_value(std::uint32_t index, std::size_t depth)
+{
+	node_type type = node_type::null;
+	if(depth > max_depth || !get(type))
+	{
+		return false;
+	}
+	nodes_[index].type = type;
+
+	switch(type)
+	{
+		case node_type::null:
+			return true;
+		case node_type::boolean:
+		{
+			std::uint8_t value = 0;
+			if(!get(value))
+			{
+				return false;
+			}
+			nodes_[index].bits = value;
+			return true;
+		}
+		case node_type::int64:
+		case node_type::uint64:
+		case node_type::real:
+		{
+			std::uint64_t bits = 0;
+			if(!get(bits))
+			{
+				return false;
+			}
+			nodes_[index].bits = bits;
+			return true;
+		}
+		case node_type::string:
+		{
+			std::uint32_t str = 0;
+			if(!get(str) || str >= strings_.size())
+			{
+				return false;
+			}
+			nodes_[index].bits = str;
+			return true;
+		}
+		case node_type::array:
+		case node_type::object:
+		{
+			std::uint32_t count = 0;
+			// every element takes at least its tag
+			if(!get(count) || count > buffer_.size() - at_)
+			{
+				return false;
+			}
+
+			// the elements are next to each other, theirs come after them
+			const auto first = std::uint32_t(nodes_.size());
+			nodes_[index].first = first;
+			nodes_[index].count = count;
+			nodes_.resize(nodes_.size() + count);
+			for(std::uint32_t i = 0; i < count; ++i)
+			{
+				if(type == node_type::object)
+				{
+					std::uint32_t name = 0;
+					if(!get(name) || name >= strings_.size())
+					{
+						return false;
+					}
+					nodes_[first + i].name = name;
+				}
+				if(!read_value(first + i, depth + 1))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+		default:
+			return false;
+	}
+}
+
+compact_input_archive::compact_input_archive(const compact_tree& tree, std::size_t document)
+	: InputArchive<compact_input_archive>(this)
+	, tree_(tree)
+{
+	const auto& root = tree_.get_node(tree.get_document(document));
+	stack_.push_back({root.first, root.first, root.first + root.count});
+}
+
+compact_input_archive::compact_input_archive(const compact_tree& tree, std::uint32_t first,
+											 std::uint32_t count)
+	: InputArchive<compact_input_archive>(this)
+	, tree_(tree)
+{
+	stack_.push_back({first, first, first + count});
+}
+
+void compact_input_archive::search()
+{
+	if(next_name_)
+	{
+		auto& top = stack_.back();
+		const auto name = getNodeName();
+		if(!name || std::strcmp(next_name_, name) != 0)
+		{
+			auto at = top.end;
+			for(auto i = top.begin; i < top.end; ++i)
+			{
+				const auto member = tree_.get_node(i).name;
+				if(member != compact_tree::invalid_index &&
+				   std::strcmp(next_name_, tree_.get_string(member)) == 0)
+				{
+					at = i;
+					break;
+				}
+			}
+			if(at == top.end)
+			{
+				throw Exception("Compact archive - provided NVP (" + std::string(next_name_) + ") not found");
+			}
+			top.at = at;
+		}
+	}
+	next_name_ = nullptr;
+}
+
+const compact_tree::node& compact_input_archive::get_value()
+{
+	search();
+	const auto& top = stack_.back();
+	if(top.at >= top.end)
+	{
+		throw Exception("No more objects in input");
+	}
+	return tree_.get_node(top.at);
+}
+
+const char* compact_input_archive::getNodeName() const
+{
+	const auto& top = stack_.back();
+	if(top.at >= top.end)
+	{
+		return nullptr;
+	}
+
+	const auto& n = tree_.get_node(top.at);
+	return n.name == compact_tree::invalid_index ? nullptr : tree_.get_string(n.name);
+}
+
+void compact_input_archive::startNode()
+{
+	const auto& n = get_value();
+	if(n.type != compact_tree::node_type::array && n.type != compact_tree::node_type::object)
+	{
+		throw Exception("Compact archive - an array or object was expected");
+	}
+	stack_.push_back({n.first, n.first, n.first + n.count});
+}
+
+void compact_input_archive::finishNode()
+{
+	stack_.pop_back();
+	next();
+}
+
+void compact_input_archive::loadValue(bool& value)
+{
+	const auto& n = get_value();
+	if(n.type != compact_tree::node_type::boolean)
+	{
+		throw Exception("Compact archive - a boolean was expected");
+	}
+	value = n.bits != 0;
+	next();
+}
+
+void compact_input_archive::loadValue(std::string& value)
+{
+	const auto& n = get_value();
+	if(n.type != compact_tree::node_type::string)
+	{
+		throw Exception("Compact archive - a string was expected");
+	}
+	const auto index = std::uint32_t(n.bits);
+	value.assign(tree_.get_string(index), tree_.get_string_size(index));
+	next();
+}
+
+void compact_input_archive::loadValue(std::nullptr_t&)
+{
+	const auto& n = get_value();
+	if(n.type != compact_tree::node_type::null)
+	{
+		throw Exception("Compact archive - a null was expected");
+	}
+	next();
+}
+
+void compact_input_archive::loadSize(size_type& size)
+{
+	const auto& top = stack_.back();
+	size = top.end - top.begin;
+}
+}
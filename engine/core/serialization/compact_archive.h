@@ -0,0 +1,334 @@
+#pragma once
+
+#include "serialization.h"
+
+#include "cereal/archives/json.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace cereal
+{
+/// what the compact form starts with, json can't start with a nul
+static const char compact_tag[4] = {'\0', 'c', 'm', 'p'};
+
+/*
+ * compact_tree; the documents of associative archives in their compact binary
+ * form, read into flat nodes.
+ *
+ *      The names, values and nesting of the json are kept: every value is a
+ *      tag followed by its bits, the index of its string or the number of its
+ *      elements, and the names and strings are indices into one table of them.
+ *      Reading it is one pass with no text to parse, the strings stay where
+ *      they are in the buffer of the tree.
+ */
+class compact_tree
+{
+public:
+	/// the version of the layout, bumped when it changes
+	static constexpr std::uint32_t version = 1;
+	static constexpr std::uint32_t invalid_index = std::uint32_t(-1);
+
+	enum class node_type : std::uint8_t
+	{
+		null,
+		boolean,
+		int64,
+		uint64,
+		real,
+		string,
+		array,
+		object
+	};
+
+	struct node
+	{
+		node_type type = node_type::null;
+		/// the string of the name of a member
+		std::uint32_t name = invalid_index;
+		/// the elements of an array or object, one after the other
+		std::uint32_t first = 0;
+		std::uint32_t count = 0;
+		/// the value of a number or boolean, the index of a string
+		std::uint64_t bits = 0;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : write ()
+	/// <summary>
+	/// Writes the json documents in the compact form, false when one of them
+	/// is not valid json.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool write(const std::vector<std::string>& documents, std::ostream& stream);
+
+	//-----------------------------------------------------------------------------
+	//  Name : read ()
+	/// <summary>
+	/// Reads the stream from where it is to its end, false when it is not in
+	/// the compact form of this version.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool read(std::istream& stream);
+
+	std::size_t get_documents_count() const
+	{
+		return documents_.size();
+	}
+
+	std::uint32_t get_document(std::size_t index) const
+	{
+		return documents_[index];
+	}
+
+	const node& get_node(std::uint32_t index) const
+	{
+		return nodes_[index];
+	}
+
+	const char* get_string(std::uint32_t index) const
+	{
+		return strings_[index];
+	}
+
+	std::size_t get_string_size(std::uint32_t index) const
+	{
+		return string_sizes_[index];
+	}
+
+private:
+	template <typename T>
+	bool get(T& value)
+	{
+		if(buffer_.size() - at_ < sizeof(value))
+		{
+			return false;
+		}
+		std::memcpy(&value, buffer_.data() + at_, sizeof(value));
+		at_ += sizeof(value);
+		return true;
+	}
+
+	bool read_value(std::uint32_t index, std::size_t depth);
+
+	std::vector<char> buffer_;
+	std::size_t at_ = 0;
+	std::vector<const char*> strings_;
+	std::vector<std::size_t> string_sizes_;
+	std::vector<node> nodes_;
+	/// the root node of every document
+	std::vector<std::uint32_t> documents_;
+};
+
+/*
+ * compact_input_archive; loads a document of a compact tree the way the json
+ * input archive loads the json it came from.
+ *
+ *      Members are matched by their names, in order when they are in order,
+ *      searched for when they are not, and a name which is not there throws.
+ *      Everything loadable from the associative archive loads from this one.
+ */
+class compact_input_archive : public InputArchive<compact_input_archive>, public traits::TextArchive
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : compact_input_archive ()
+	/// <summary>
+	/// Loads the document of the tree, which must outlive the archive.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	compact_input_archive(const compact_tree& tree, std::size_t document);
+
+	//-----------------------------------------------------------------------------
+	//  Name : compact_input_archive ()
+	/// <summary>
+	/// Loads count nodes from first as if they were the members of a document,
+	/// e.g. a few elements of an array, each loaded as a value in order.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	compact_input_archive(const compact_tree& tree, std::uint32_t first, std::uint32_t count);
+
+	~compact_input_archive() noexcept = default;
+
+	void startNode();
+	void finishNode();
+
+	void setNextName(const char* name)
+	{
+		next_name_ = name;
+	}
+
+	const char* getNodeName() const;
+
+	template <class T, traits::EnableIf<std::is_arithmetic<T>::value> = traits::sfinae>
+	void loadValue(T& value)
+	{
+		const auto& n = get_value();
+		switch(n.type)
+		{
+			case compact_tree::node_type::int64:
+				value = static_cast<T>(static_cast<std::int64_t>(n.bits));
+				break;
+			case compact_tree::node_type::uint64:
+				value = static_cast<T>(n.bits);
+				break;
+			case compact_tree::node_type::real:
+			{
+				double real = 0.0;
+				std::memcpy(&real, &n.bits, sizeof(real));
+				value = static_cast<T>(real);
+				break;
+			}
+			default:
+				throw Exception("Compact archive - a number was expected");
+		}
+		next();
+	}
+
+	void loadValue(bool& value);
+	void loadValue(std::string& value);
+	void loadValue(std::nullptr_t&);
+	void loadSize(size_type& size);
+
+private:
+	/// the elements of the node being loaded
+	struct frame
+	{
+		std::uint32_t begin = 0;
+		std::uint32_t at = 0;
+		std::uint32_t end = 0;
+	};
+
+	void search();
+	const compact_tree::node& get_value();
+	void next()
+	{
+		++stack_.back().at;
+	}
+
+	const compact_tree& tree_;
+	std::vector<frame> stack_;
+	const char* next_name_ = nullptr;
+};
+
+using iarchive_compact_t = compact_input_archive;
+
+template <class T>
+inline void prologue(compact_input_archive&, NameValuePair<T> const&)
+{
+}
+
+template <class T>
+inline void epilogue(compact_input_archive&, NameValuePair<T> const&)
+{
+}
+
+template <class T>
+inline void prologue(compact_input_archive&, SizeTag<T> const&)
+{
+}
+
+template <class T>
+inline void epilogue(compact_input_archive&, SizeTag<T> const&)
+{
+}
+
+// everything but what the json archive writes as a value opens a node
+template <class T,
+		  traits::EnableIf<!std::is_arithmetic<T>::value,
+						   !traits::has_minimal_base_class_serialization<
+							   T, traits::has_minimal_input_serialization, compact_input_archive>::value,
+						   !traits::has_minimal_input_serialization<T, compact_input_archive>::value> =
+			  traits::sfinae>
+inline void prologue(compact_input_archive& ar, T const&)
+{
+	ar.startNode();
+}
+
+template <class T,
+		  traits::EnableIf<!std::is_arithmetic<T>::value,
+						   !traits::has_minimal_base_class_serialization<
+							   T, traits::has_minimal_input_serialization, compact_input_archive>::value,
+						   !traits::has_minimal_input_serialization<T, compact_input_archive>::value> =
+			  traits::sfinae>
+inline void epilogue(compact_input_archive& ar, T const&)
+{
+	ar.finishNode();
+}
+
+inline void prologue(compact_input_archive&, std::nullptr_t const&)
+{
+}
+
+inline void epilogue(compact_input_archive&, std::nullptr_t const&)
+{
+}
+
+template <class T, traits::EnableIf<std::is_arithmetic<T>::value> = traits::sfinae>
+inline void prologue(compact_input_archive&, T const&)
+{
+}
+
+template <class T, traits::EnableIf<std::is_arithmetic<T>::value> = traits::sfinae>
+inline void epilogue(compact_input_archive&, T const&)
+{
+}
+
+template <class CharT, class Traits, class Alloc>
+inline void prologue(compact_input_archive&, std::basic_string<CharT, Traits, Alloc> const&)
+{
+}
+
+template <class CharT, class Traits, class Alloc>
+inline void epilogue(compact_input_archive&, std::basic_string<CharT, Traits, Alloc> const&)
+{
+}
+
+template <class T>
+inline void CEREAL_LOAD_FUNCTION_NAME(compact_input_archive& ar, NameValuePair<T>& t)
+{
+	ar.setNextName(t.name);
+	ar(t.value);
+}
+
+inline void CEREAL_LOAD_FUNCTION_NAME(compact_input_archive& ar, std::nullptr_t& t)
+{
+	ar.loadValue(t);
+}
+
+template <class T, traits::EnableIf<std::is_arithmetic<T>::value> = traits::sfinae>
+inline void CEREAL_LOAD_FUNCTION_NAME(compact_input_archive& ar, T& t)
+{
+	ar.loadValue(t);
+}
+
+inline void CEREAL_LOAD_FUNCTION_NAME(compact_input_archive& ar, std::string& str)
+{
+	ar.loadValue(str);
+}
+
+template <class T>
+inline void CEREAL_LOAD_FUNCTION_NAME(compact_input_archive& ar, SizeTag<T>& st)
+{
+	ar.loadSize(st.size);
+}
+
+namespace traits
+{
+namespace detail
+{
+// saved by the json archive, the input of which is taken
+template <>
+struct get_output_from_input<compact_input_archive>
+{
+	using type = JSONOutputArchive;
+};
+}
+}
+}
+
+CEREAL_REGISTER_ARCHIVE(cereal::compact_input_archive)
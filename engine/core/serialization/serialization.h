@@ -5,6 +5,7 @@
 #include "cereal/types/vector.hpp"
 #include <functional>
 #include <string>
+#include <type_traits>
 
 #define SERIALIZE_FUNCTION_NAME CEREAL_SERIALIZE_FUNCTION_NAME
 #define SAVE_FUNCTION_NAME CEREAL_SAVE_FUNCTION_NAME
@@ -16,6 +17,13 @@ using namespace cereal;
 
 void set_warning_logger(const std::function<void(const std::string&)>& logger);
 void log_warning(const std::string& log_msg);
+
+/// a type whose bytes are its serialized values one after the other, so the binary
+/// archives copy arrays of it at once
+template <typename T>
+struct is_bulk_serializable : std::is_arithmetic<T>
+{
+};
 }
 
 #define SERIALIZABLE(T)                                                                                      \
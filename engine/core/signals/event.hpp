@@ -2,40 +2,124 @@
 #ifndef EVENT_HPP
 #define EVENT_HPP
 
-#include "../common/nonstd/slot_map.hpp"
 #include "delegate.hpp"
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+namespace signals
+{
+namespace detail
+{
+class posted_event
+{
+public:
+	virtual void dispatch_posted() = 0;
+
+protected:
+	~posted_event() = default;
+};
+
+/// the events with posted emits, in the order they were first posted to
+struct posted_registry
+{
+	std::mutex mutex;
+	std::vector<posted_event*> pending;
+};
+
+inline posted_registry& get_posted_registry()
+{
+	static posted_registry registry;
+	return registry;
+}
+}
+
+//-----------------------------------------------------------------------------
+//  Name : dispatch_posted_events ()
+/// <summary>
+/// Emits what was posted to the events since the last call, on the calling
+/// thread, event by event in the order of their first post and every event
+/// in the order of its posts. Called by the owner thread once per frame.
+/// </summary>
+//-----------------------------------------------------------------------------
+inline void dispatch_posted_events()
+{
+	std::vector<detail::posted_event*> pending;
+	{
+		auto& registry = detail::get_posted_registry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		pending.swap(registry.pending);
+	}
+
+	for(auto* e : pending)
+	{
+		e->dispatch_posted();
+	}
+}
+}
+
 template <typename T>
 class event;
 
+/*
+ * event; calls the slots connected to it.
+ *
+ *      The slots are kept in an immutable list that a connect or disconnect
+ *      replaces with a changed copy, so an emit only counts itself in and
+ *      walks the list it found, without a lock or a copy. A replaced list is
+ *      freed once no emit is walking. A slot disconnected during an emit,
+ *      e.g. from a handler, is not called by it anymore, a slot connected
+ *      during an emit is called from the next one. Connecting and
+ *      disconnecting can be done from any thread. post queues an emit from
+ *      any thread for dispatch_posted_events to make on the owner thread.
+ */
 template <typename... Args>
-class event<void(Args...)>
+class event<void(Args...)> : public signals::detail::posted_event
 {
 public:
 	using slot_type = delegate<void(Args...)>;
-	using slot_container = nonstd::slot_map<slot_type>;
-	using slot_key = typename slot_container::key_type;
+	using slot_key = std::uint64_t;
+
+	event() = default;
+
+	~event()
+	{
+		{
+			auto& registry = signals::detail::get_posted_registry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			auto& pending = registry.pending;
+			pending.erase(std::remove(std::begin(pending), std::end(pending), this), std::end(pending));
+		}
+		delete slots_.load();
+	}
+
+	event(const event&) = delete;
+	event& operator=(const event&) = delete;
 
 	template <class C>
 	slot_key connect(C* const object_ptr, void (C::*const method_ptr)(Args...))
 	{
-		return slots_.emplace(object_ptr, method_ptr);
+		return add_slot(slot_type(object_ptr, method_ptr));
 	}
 
 	template <class C>
 	slot_key connect(C* const object_ptr, void (C::*const method_ptr)(Args...) const)
 	{
-		return slots_.emplace(object_ptr, method_ptr);
+		return add_slot(slot_type(object_ptr, method_ptr));
 	}
 
 	template <typename T, typename = typename std::enable_if<
 							  !std::is_same<event, typename std::decay<T>::type>::value>::type>
 	slot_key connect(T&& f)
 	{
-		return slots_.emplace(std::forward<T>(f));
+		return add_slot(slot_type(std::forward<T>(f)));
 	}
 
 	template <class C>
@@ -70,9 +154,19 @@ public:
 	/// \param args The arguments to emit to the slots connected to the signal
 	void emit(Args... args) const
 	{
-		for(auto& slot : slots_)
+		emit_guard guard(*this);
+		const auto* slots = slots_.load();
+		if(slots == nullptr)
 		{
-			slot(std::forward<Args>(args)...);
+			return;
+		}
+
+		for(const auto& slot : *slots)
+		{
+			if(slot->connected.load(std::memory_order_acquire))
+			{
+				slot->call(std::forward<Args>(args)...);
+			}
 		}
 	}
 
@@ -85,11 +179,40 @@ public:
 		emit(std::forward<Args>(args)...);
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : post ()
+	/// <summary>
+	/// Queues an emit with a copy of the arguments, made by the next
+	/// signals::dispatch_posted_events. Safe to call from any thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <typename... T>
+	void post(T&&... args)
+	{
+		bool first = false;
+		{
+			std::lock_guard<std::mutex> lock(posted_mutex_);
+			first = posted_.empty();
+			posted_.emplace_back(std::forward<T>(args)...);
+		}
+
+		if(first)
+		{
+			auto& registry = signals::detail::get_posted_registry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			auto& pending = registry.pending;
+			if(std::find(std::begin(pending), std::end(pending), this) == std::end(pending))
+			{
+				pending.push_back(this);
+			}
+		}
+	}
+
 	// comparision operators for sorting and comparing
 
 	bool operator==(const event& s) const
 	{
-		return slots_ == s.slots_;
+		return this == &s;
 	}
 
 	bool operator!=(const event& s) const
@@ -98,23 +221,152 @@ public:
 	}
 
 private:
-	void disconnect_by_value(const slot_type& slot)
+	struct slot_entry
+	{
+		template <typename... T>
+		void call(T&&... args) const
+		{
+			slot(std::forward<T>(args)...);
+		}
+
+		slot_key key = 0;
+		slot_type slot;
+		/// cleared on disconnect, for the emits walking a replaced list
+		std::atomic<bool> connected = {true};
+	};
+
+	using slot_list = std::vector<std::shared_ptr<slot_entry>>;
+	using posted_args = std::tuple<typename std::decay<Args>::type...>;
+
+	/// counts an emit in for its walk of the list
+	struct emit_guard
+	{
+		explicit emit_guard(const event& e)
+			: owner(e)
+		{
+			owner.emitting_.fetch_add(1);
+		}
+
+		~emit_guard()
+		{
+			if(owner.emitting_.fetch_sub(1) == 1 && owner.has_retired_.load(std::memory_order_relaxed))
+			{
+				// the last emit out frees the replaced lists, when a write is
+				// in progress they wait for the next one out
+				std::unique_lock<std::mutex> lock(owner.write_mutex_, std::try_to_lock);
+				if(lock.owns_lock())
+				{
+					owner.free_retired();
+				}
+			}
+		}
+
+		const event& owner;
+	};
+
+	slot_key add_slot(slot_type slot)
+	{
+		auto entry = std::make_shared<slot_entry>();
+		entry->slot = std::move(slot);
+
+		std::lock_guard<std::mutex> lock(write_mutex_);
+		entry->key = ++last_key_;
+		const auto* current = slots_.load();
+		auto next = current ? std::make_unique<slot_list>(*current) : std::make_unique<slot_list>();
+		next->emplace_back(entry);
+		publish(std::move(next));
+		return entry->key;
+	}
+
+	template <typename Predicate>
+	void remove_slot(Predicate&& predicate)
 	{
-		auto it = std::find_if(std::begin(slots_), std::end(slots_),
-							   [&slot](const slot_type& other) { return slot == other; });
+		std::lock_guard<std::mutex> lock(write_mutex_);
+		const auto* current = slots_.load();
+		if(current == nullptr)
+		{
+			return;
+		}
 
-		if(it != std::end(slots_))
+		auto it = std::find_if(std::begin(*current), std::end(*current), predicate);
+		if(it == std::end(*current))
 		{
-			slots_.erase(it);
+			return;
 		}
+
+		(*it)->connected.store(false, std::memory_order_release);
+		auto next = std::make_unique<slot_list>();
+		next->reserve(current->size() - 1);
+		std::copy_if(std::begin(*current), std::end(*current), std::back_inserter(*next),
+					 [&it](const auto& entry) { return entry != *it; });
+		publish(std::move(next));
+	}
+
+	// under the write mutex
+	void publish(std::unique_ptr<slot_list> next)
+	{
+		retired_.emplace_back(slots_.exchange(next.release()));
+		has_retired_.store(true, std::memory_order_relaxed);
+		if(emitting_.load() == 0)
+		{
+			free_retired();
+		}
+	}
+
+	// under the write mutex
+	void free_retired() const
+	{
+		// an emit that counts itself in from now on finds the current list
+		if(emitting_.load() == 0)
+		{
+			retired_.clear();
+			has_retired_.store(false, std::memory_order_relaxed);
+		}
+	}
+
+	void disconnect_by_value(const slot_type& slot)
+	{
+		remove_slot([&slot](const auto& entry) { return entry->slot == slot; });
 	}
 
 	void disconnect_by_key(const slot_key& key) noexcept
 	{
-		slots_.erase(key);
+		remove_slot([key](const auto& entry) { return entry->key == key; });
 	}
-	/// The slots connected to the signal
-	slot_container slots_;
+
+	void dispatch_posted() override
+	{
+		std::vector<posted_args> posted;
+		{
+			std::lock_guard<std::mutex> lock(posted_mutex_);
+			posted.swap(posted_);
+		}
+
+		for(auto& args : posted)
+		{
+			emit_posted(args, std::index_sequence_for<Args...>{});
+		}
+	}
+
+	template <std::size_t... I>
+	void emit_posted(posted_args& args, std::index_sequence<I...>)
+	{
+		emit(std::get<I>(args)...);
+	}
+
+	/// the current list, replaced whole by a connect or disconnect
+	std::atomic<slot_list*> slots_ = {nullptr};
+	/// the emits walking a list
+	mutable std::atomic<std::uint32_t> emitting_ = {0};
+	mutable std::atomic<bool> has_retired_ = {false};
+	/// the writes are serialized, the emits never wait on it
+	mutable std::mutex write_mutex_;
+	/// the replaced lists an emit may still walk
+	mutable std::vector<std::unique_ptr<slot_list>> retired_;
+	slot_key last_key_ = 0;
+
+	std::mutex posted_mutex_;
+	std::vector<posted_args> posted_;
 };
 
 #endif // EVENT_HPP
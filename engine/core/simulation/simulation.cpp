@@ -1,11 +1,17 @@
 #include "simulation.h"
+#include "../common/platform/timer.hpp"
+#include "../profiling/profiler.h"
 #include <algorithm>
+#include <sstream>
 #include <thread>
 
 namespace core
 {
 using namespace std::chrono_literals;
 
+constexpr std::size_t simulation::frame_history_size;
+constexpr std::size_t simulation::max_hitches;
+
 simulation::simulation()
 {
 	if(max_inactive_fps_ == 0)
@@ -14,6 +20,11 @@ simulation::simulation()
 	}
 }
 
+simulation::~simulation()
+{
+	set_frame_pacing(frame_pacing::sleep);
+}
+
 void simulation::run_one_frame(bool is_active)
 {
 	// perform waiting loop if maximum fps set
@@ -22,14 +33,32 @@ void simulation::run_one_frame(bool is_active)
 	{
 		max_fps = std::min(max_inactive_fps_, max_fps);
 	}
+	if(idle_ && max_idle_fps_ > 0)
+	{
+		max_fps = max_fps > 0 ? std::min(max_idle_fps_, max_fps) : max_idle_fps_;
+	}
 
 	duration_t elapsed = clock_t::now() - last_frame_timepoint_;
+	frame_work_time_ = std::max(elapsed, duration_t(0));
+	target_frame_time_ = duration_t::zero();
 	if(max_fps > 0)
 	{
 		duration_t target_duration = 1000ms / max_fps;
+		target_frame_time_ = target_duration;
+		const bool waits = elapsed >= duration_t(0) && elapsed < target_duration;
 
-		for(;;)
+		if(pacing_ == frame_pacing::precise)
 		{
+			wait_precise(last_frame_timepoint_ + target_duration);
+			elapsed = clock_t::now() - last_frame_timepoint_;
+		}
+
+		while(pacing_ == frame_pacing::sleep)
+		{
+			if(wait_work_)
+			{
+				wait_work_();
+			}
 			elapsed = clock_t::now() - last_frame_timepoint_;
 			if(elapsed >= target_duration)
 			{
@@ -53,13 +82,20 @@ void simulation::run_one_frame(bool is_active)
 				std::this_thread::sleep_for(sleep_time);
 			}
 		}
+
+		if(waits)
+		{
+			record_pacing_error(std::max(elapsed - target_duration, duration_t(0)));
+		}
 	}
 
 	if(elapsed < duration_t(0))
 	{
 		elapsed = duration_t(0);
 	}
+	const auto frame_begin = last_frame_timepoint_;
 	last_frame_timepoint_ = clock_t::now();
+	record_frame_time(elapsed, frame_begin, last_frame_timepoint_);
 
 	// if fps lower than minimum, clamp eplased time
 	if(min_fps_ > 0)
@@ -70,9 +106,32 @@ void simulation::run_one_frame(bool is_active)
 			elapsed = target_duration;
 		}
 	}
+	if(fixed_delta_ > duration_t::zero())
+	{
+		elapsed = fixed_delta_;
+	}
+	frame_delta_ = elapsed;
+
+	if(is_fixed_timestep())
+	{
+		fixed_accumulator_ += elapsed;
+		const auto steps = std::min<duration_t::rep>(fixed_accumulator_ / fixed_timestep_, max_fixed_steps_);
+		fixed_steps_ = static_cast<std::uint32_t>(steps);
+		fixed_accumulator_ -= fixed_timestep_ * steps;
+		if(fixed_accumulator_ >= fixed_timestep_)
+		{
+			// past the catch-up limit, only the phase is kept
+			fixed_accumulator_ %= fixed_timestep_;
+		}
+		interpolation_alpha_ = float(fixed_accumulator_.count()) / float(fixed_timestep_.count());
+	}
 
 	// perform time step smoothing
-	if(smoothing_step_ > 0)
+	if(fixed_delta_ > duration_t::zero())
+	{
+		timestep_ = fixed_delta_;
+	}
+	else if(smoothing_step_ > 0)
 	{
 		timestep_ = duration_t::zero();
 		previous_timesteps_.push_back(elapsed);
@@ -114,6 +173,39 @@ void simulation::set_max_inactive_fps(std::uint32_t fps)
 	max_inactive_fps_ = std::max<std::uint32_t>(fps, 0);
 }
 
+void simulation::set_fixed_delta(duration_t delta)
+{
+	fixed_delta_ = std::max(delta, duration_t::zero());
+}
+
+void simulation::set_max_idle_fps(std::uint32_t fps)
+{
+	max_idle_fps_ = fps;
+}
+
+void simulation::set_idle(bool idle)
+{
+	idle_ = idle;
+}
+
+void simulation::set_fixed_timestep(duration_t step)
+{
+	fixed_timestep_ = std::max(step, duration_t::zero());
+	fixed_accumulator_ = duration_t::zero();
+	fixed_steps_ = 1;
+	interpolation_alpha_ = 1.0f;
+}
+
+void simulation::set_max_fixed_steps(std::uint32_t steps)
+{
+	max_fixed_steps_ = std::max<std::uint32_t>(steps, 1);
+}
+
+std::chrono::duration<float> simulation::get_fixed_delta_time() const
+{
+	return std::chrono::duration_cast<std::chrono::duration<float>>(fixed_timestep_);
+}
+
 void simulation::set_time_smoothing_step(std::uint32_t step)
 {
 	smoothing_step_ = step;
@@ -135,4 +227,173 @@ std::chrono::duration<float> simulation::get_delta_time() const
 	auto dt = std::chrono::duration_cast<std::chrono::duration<float>>(timestep_);
 	return dt;
 }
+
+simulation::duration_t simulation::get_frame_work_time() const
+{
+	return frame_work_time_;
+}
+
+simulation::duration_t simulation::get_target_frame_time() const
+{
+	return target_frame_time_;
+}
+
+simulation::duration_t simulation::get_frame_time_left() const
+{
+	if(target_frame_time_ <= frame_work_time_)
+	{
+		return duration_t::zero();
+	}
+	return target_frame_time_ - frame_work_time_;
+}
+
+void simulation::set_frame_pacing(frame_pacing pacing)
+{
+	if(pacing == pacing_)
+	{
+		return;
+	}
+	platform::set_high_timer_resolution(pacing == frame_pacing::precise);
+	pacing_ = pacing;
+}
+
+void simulation::set_wait_work(std::function<void()> work)
+{
+	wait_work_ = std::move(work);
+}
+
+simulation::pacing_stats simulation::get_pacing_stats() const
+{
+	pacing_stats stats;
+	if(pacing_errors_.empty())
+	{
+		return stats;
+	}
+
+	auto sorted = pacing_errors_;
+	std::sort(std::begin(sorted), std::end(sorted));
+	duration_t sum = duration_t::zero();
+	for(const auto& error : sorted)
+	{
+		sum += error;
+	}
+	stats.mean_error = sum / static_cast<duration_t::rep>(sorted.size());
+	stats.p99_error = sorted[std::size_t(0.99 * double(sorted.size() - 1) + 0.5)];
+	stats.max_error = sorted.back();
+	stats.frames = sorted.size();
+	return stats;
+}
+
+void simulation::wait_precise(timepoint_t deadline)
+{
+	for(;;)
+	{
+		// before the sleep is timed
+		if(wait_work_)
+		{
+			wait_work_();
+		}
+		const auto before = clock_t::now();
+		// a sleep that may take longer than what is left would overshoot
+		if(deadline - before <= sleep_mean_ + 2 * sleep_deviation_)
+		{
+			break;
+		}
+
+		std::this_thread::sleep_for(1ms);
+		const auto took = clock_t::now() - before;
+		const auto deviation = took > sleep_mean_ ? took - sleep_mean_ : sleep_mean_ - took;
+		sleep_mean_ += (took - sleep_mean_) / 16;
+		sleep_deviation_ += (deviation - sleep_deviation_) / 16;
+	}
+
+	while(clock_t::now() < deadline)
+	{
+		std::this_thread::yield();
+	}
+}
+
+void simulation::record_pacing_error(duration_t error)
+{
+	if(pacing_errors_.size() < frame_history_size)
+	{
+		pacing_errors_.push_back(error);
+	}
+	else
+	{
+		pacing_errors_[next_pacing_error_] = error;
+		next_pacing_error_ = (next_pacing_error_ + 1) % frame_history_size;
+	}
+}
+
+simulation::frame_time_stats simulation::get_frame_time_stats() const
+{
+	frame_time_stats stats;
+	if(frame_times_.empty())
+	{
+		return stats;
+	}
+
+	auto sorted = frame_times_;
+	std::sort(std::begin(sorted), std::end(sorted));
+	const auto at = [&sorted](double percentile) {
+		return sorted[std::size_t(percentile * double(sorted.size() - 1) + 0.5)];
+	};
+	stats.p50 = at(0.5);
+	stats.p95 = at(0.95);
+	stats.p99 = at(0.99);
+	stats.max = sorted.back();
+	stats.frames = sorted.size();
+	return stats;
+}
+
+void simulation::set_hitch_threshold(duration_t threshold)
+{
+	hitch_threshold_ = std::max(threshold, duration_t::zero());
+}
+
+void simulation::clear_hitches()
+{
+	hitches_.clear();
+	hitch_count_ = 0;
+}
+
+void simulation::record_frame_time(duration_t frame_time, timepoint_t frame_begin, timepoint_t frame_end)
+{
+	if(frame_times_.size() < frame_history_size)
+	{
+		frame_times_.push_back(frame_time);
+	}
+	else
+	{
+		frame_times_[next_frame_time_] = frame_time;
+		next_frame_time_ = (next_frame_time_ + 1) % frame_history_size;
+	}
+
+	// the first frame is the launch, not a hitch
+	if(hitch_threshold_ == duration_t::zero() || frame_time <= hitch_threshold_ || frame_ == 0)
+	{
+		return;
+	}
+
+	++hitch_count_;
+	hitch h;
+	h.frame = frame_;
+	h.duration = frame_time;
+	h.begin = frame_begin;
+	h.end = frame_end;
+	if(profiling::is_enabled())
+	{
+		// the zones are still in the rings, the frame only just ended
+		std::ostringstream trace;
+		profiling::write_chrome_trace(trace, frame_begin, frame_end);
+		h.trace = trace.str();
+	}
+
+	hitches_.emplace_back(std::move(h));
+	if(hitches_.size() > max_hitches)
+	{
+		hitches_.pop_front();
+	}
+}
 }
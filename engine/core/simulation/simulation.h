@@ -1,6 +1,11 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
 #include <vector>
 
 namespace core
@@ -21,7 +26,58 @@ struct simulation
 	using timepoint_t = clock_t::time_point;
 	using duration_t = clock_t::duration;
 
+	/// the frames the frame time statistics are over
+	static constexpr std::size_t frame_history_size = 512;
+	/// the last hitches kept
+	static constexpr std::size_t max_hitches = 8;
+
+	struct frame_time_stats
+	{
+		duration_t p50 = duration_t::zero();
+		duration_t p95 = duration_t::zero();
+		duration_t p99 = duration_t::zero();
+		duration_t max = duration_t::zero();
+		/// the frames they are over, up to frame_history_size
+		std::size_t frames = 0;
+	};
+
+	enum class frame_pacing
+	{
+		/// sleeps in steps of a millisecond, precise to what the os sleep is
+		sleep,
+		/// sleeps while the time left is past what a sleep was seen to take,
+		/// spins the rest, and raises the timer resolution of the os
+		precise
+	};
+
+	/// how far past the target the frames that waited for it ended
+	struct pacing_stats
+	{
+		duration_t mean_error = duration_t::zero();
+		duration_t p99_error = duration_t::zero();
+		duration_t max_error = duration_t::zero();
+		/// the frames they are over, up to frame_history_size
+		std::size_t frames = 0;
+	};
+
+		/// a frame longer than the hitch threshold
+	struct hitch
+	{
+		std::uint64_t frame = 0;
+		duration_t duration = duration_t::zero();
+		/// when the frame began and ended
+		timepoint_t begin;
+		timepoint_t end;
+		/// the profiling zones of the frame in the chrome://tracing format,
+		/// empty when the profiling was not enabled
+		std::string trace;
+	};
+
 	simulation();
+	~simulation();
+
+	simulation(const simulation&) = delete;
+	simulation& operator=(const simulation&) = delete;
 
 	//-----------------------------------------------------------------------------
 	//  Name : run_one_frame ()
@@ -73,6 +129,59 @@ struct simulation
 	//-----------------------------------------------------------------------------
 	void set_max_inactive_fps(std::uint32_t fps);
 
+	//-----------------------------------------------------------------------------
+	//  Name : set_max_idle_fps ()
+	/// <summary>
+	/// Set maximum frames per second while the application says it is idle,
+	/// e.g. nothing is input and nothing changes. Zero disables it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_max_idle_fps(std::uint32_t fps);
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_idle ()
+	/// <summary>
+	/// Whether the next frames may run at the max idle fps.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_idle(bool idle);
+
+	inline bool is_idle() const
+	{
+		return idle_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_frame_pacing ()
+	/// <summary>
+	/// How the frame waits for the fps cap.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_frame_pacing(frame_pacing pacing);
+
+	inline frame_pacing get_frame_pacing() const
+	{
+		return pacing_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_wait_work ()
+	/// <summary>
+	/// Work done between the sleeps of the wait for the fps cap, such as
+	/// draining the events of the os while the frame has nothing else to do.
+	/// It is kept short, what it takes is part of the wait.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_wait_work(std::function<void()> work);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_pacing_stats ()
+	/// <summary>
+	/// The error of the last waits for the fps cap.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	pacing_stats get_pacing_stats() const;
+
 	//-----------------------------------------------------------------------------
 	//  Name : set_time_smoothing_step ()
 	/// <summary>
@@ -105,17 +214,182 @@ struct simulation
 	//-----------------------------------------------------------------------------
 	std::chrono::duration<float> get_delta_time() const;
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_frame_work_time ()
+	/// <summary>
+	/// Returns how long the previous frame worked before it started waiting
+	/// for the fps cap.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	duration_t get_frame_work_time() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_target_frame_time ()
+	/// <summary>
+	/// Returns the frame duration implied by the current fps cap or zero if
+	/// it is uncapped.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	duration_t get_target_frame_time() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_frame_time_left ()
+	/// <summary>
+	/// Returns the part of the target frame time the previous frame did not
+	/// use. Zero if uncapped or over budget.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	duration_t get_frame_time_left() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_fixed_timestep ()
+	/// <summary>
+	/// Updates in steps of this duration, as many per frame as the time that
+	/// passed holds, up to the max steps. Zero updates once per frame with
+	/// the frame delta time.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_fixed_timestep(duration_t step);
+
+	inline bool is_fixed_timestep() const
+	{
+		return fixed_timestep_ > duration_t::zero();
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_fixed_delta ()
+	/// <summary>
+	/// Steps every frame by this duration whatever the time that passed, with
+	/// no smoothing, for runs that must step the same every time, such as a
+	/// replay of the input. The frame time statistics still measure the time
+	/// that passed. Zero steps by the time that passed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_fixed_delta(duration_t delta);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_frame_delta ()
+	/// <summary>
+	/// The time the frame stepped by before the smoothing, what a replay is
+	/// given to step the same again.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline duration_t get_frame_delta() const
+	{
+		return frame_delta_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_max_fixed_steps ()
+	/// <summary>
+	/// The most fixed steps a frame catches up with, the time past them is
+	/// dropped and the simulation slows down instead of falling further
+	/// behind.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_max_fixed_steps(std::uint32_t steps);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_fixed_steps ()
+	/// <summary>
+	/// The fixed steps to update in this frame, possibly none.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline std::uint32_t get_fixed_steps() const
+	{
+		return fixed_steps_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_fixed_delta_time ()
+	/// <summary>
+	/// Returns the fixed step in seconds.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::chrono::duration<float> get_fixed_delta_time() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_interpolation_alpha ()
+	/// <summary>
+	/// How far the frame is between the last fixed step and the next one, in
+	/// [0, 1), for the rendering to blend the last two updated states. One
+	/// without a fixed timestep.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline float get_interpolation_alpha() const
+	{
+		return interpolation_alpha_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_frame_time_stats ()
+	/// <summary>
+	/// The percentiles of the last frame times, the wait for the fps cap
+	/// included.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	frame_time_stats get_frame_time_stats() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_hitch_threshold ()
+	/// <summary>
+	/// Frames longer than this are kept as hitches, with the profiling zones
+	/// of the frame when the profiling is enabled. Zero disables it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_hitch_threshold(duration_t threshold);
+
+	inline duration_t get_hitch_threshold() const
+	{
+		return hitch_threshold_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_hitches ()
+	/// <summary>
+	/// The last max_hitches hitches, the oldest first.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline const std::deque<hitch>& get_hitches() const
+	{
+		return hitches_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_hitch_count ()
+	/// <summary>
+	/// The hitches since the launch or the last clear, kept or not.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline std::uint64_t get_hitch_count() const
+	{
+		return hitch_count_;
+	}
+
+	void clear_hitches();
+
 protected:
+	void wait_precise(timepoint_t deadline);
+	void record_pacing_error(duration_t error);
+	void record_frame_time(duration_t frame_time, timepoint_t frame_begin, timepoint_t frame_end);
+
 	/// minimum/maximum frames per second
 	std::uint32_t min_fps_ = 0;
 	///
 	std::uint32_t max_fps_ = 200;
 	///
 	std::uint32_t max_inactive_fps_ = 20;
+	/// the cap while idle, zero for none
+	std::uint32_t max_idle_fps_ = 0;
+	bool idle_ = false;
 	/// previous time steps for smoothing in seconds
 	std::vector<duration_t> previous_timesteps_;
 	/// next frame time step in seconds
 	duration_t timestep_ = duration_t::zero();
+	/// time the previous frame spent working, excluding the fps cap wait
+	duration_t frame_work_time_ = duration_t::zero();
+	/// frame duration of the current fps cap, zero if uncapped
+	duration_t target_frame_time_ = duration_t::zero();
 	/// current frame
 	std::uint64_t frame_ = 0;
 	/// how many frames to average for the smoothed time step
@@ -124,5 +398,31 @@ protected:
 	timepoint_t last_frame_timepoint_ = clock_t::now();
 	/// time point when we launched
 	timepoint_t launch_timepoint_ = clock_t::now();
+	frame_pacing pacing_ = frame_pacing::sleep;
+	/// what a sleep of a millisecond takes, a moving mean and deviation
+	duration_t sleep_mean_ = std::chrono::milliseconds(2);
+	duration_t sleep_deviation_ = duration_t::zero();
+	/// the last pacing errors, a ring of frame_history_size
+	std::vector<duration_t> pacing_errors_;
+	std::size_t next_pacing_error_ = 0;
+	/// run between the sleeps of the wait
+	std::function<void()> wait_work_;
+	/// the fixed step, zero to update once per frame
+	duration_t fixed_timestep_ = duration_t::zero();
+	/// the time not yet updated in fixed steps
+	duration_t fixed_accumulator_ = duration_t::zero();
+	std::uint32_t max_fixed_steps_ = 5;
+	/// the step of every frame, zero for the time that passed
+	duration_t fixed_delta_ = duration_t::zero();
+	/// the step of the frame before the smoothing
+	duration_t frame_delta_ = duration_t::zero();
+	std::uint32_t fixed_steps_ = 1;
+	float interpolation_alpha_ = 1.0f;
+	/// the last frame times, a ring of frame_history_size
+	std::vector<duration_t> frame_times_;
+	std::size_t next_frame_time_ = 0;
+	duration_t hitch_threshold_ = duration_t::zero();
+	std::deque<hitch> hitches_;
+	std::uint64_t hitch_count_ = 0;
 };
 }
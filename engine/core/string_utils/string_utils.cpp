@@ -2,77 +2,115 @@
 #include <chrono>
 #include <thread>
 
-int string_utils::compare(const std::string& s1, const std::string& s2, bool ignore_case)
+namespace
 {
-	if(!ignore_case)
-	{
-		return s1.compare(s2);
-	}
-	return StrICmp()(s1, s2);
+inline char to_lower_ascii(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
 }
 
-std::string string_utils::trim(const std::string& str)
+inline bool is_blank(char c)
 {
-	std::string s = str;
-	std::string::size_type pos;
+	return c == ' ' || c == '\t';
+}
 
-	// Early out
-	if(s.empty())
-	{
-		return s;
-	}
+bool is_delimiter(char c, nonstd::string_view delimiters)
+{
+	return std::find(delimiters.begin(), delimiters.end(), c) != delimiters.end();
+}
+}
 
-	// Trim Left
-	pos = s.find_first_not_of(" \t");
-	if(pos != std::string::npos)
+int string_utils::compare(nonstd::string_view s1, nonstd::string_view s2, bool ignore_case)
+{
+	const auto count = std::min(s1.size(), s2.size());
+	for(std::size_t i = 0; i < count; ++i)
 	{
-		s.erase(0, pos);
+		const auto c1 = ignore_case ? to_lower_ascii(s1[i]) : s1[i];
+		const auto c2 = ignore_case ? to_lower_ascii(s2[i]) : s2[i];
+		if(c1 != c2)
+		{
+			return static_cast<unsigned char>(c1) < static_cast<unsigned char>(c2) ? -1 : 1;
+		}
 	}
-	else
+	if(s1.size() == s2.size())
 	{
-		s.clear();
+		return 0;
 	}
+	return s1.size() < s2.size() ? -1 : 1;
+}
 
-	// Early out
-	if(s.empty())
-	{
-		return s;
-	}
+bool string_utils::iequals(nonstd::string_view s1, nonstd::string_view s2)
+{
+	return s1.size() == s2.size() && compare(s1, s2, true) == 0;
+}
 
-	// Trim right
-	pos = s.find_last_not_of(" \t");
-	if(pos != std::string::npos)
+std::string string_utils::trim(const std::string& str)
+{
+	return trim_view(str).to_string();
+}
+
+nonstd::string_view string_utils::trim_view(nonstd::string_view str)
+{
+	std::size_t first = 0;
+	std::size_t last = str.size();
+	while(first < last && is_blank(str[first]))
 	{
-		s.erase(pos + 1);
+		++first;
 	}
-	else
+	while(last > first && is_blank(str[last - 1]))
 	{
-		s.clear();
+		--last;
 	}
-
-	return s;
+	return str.substr(first, last - first);
 }
 
+void string_utils::trim_in_place(std::string& str)
+{
+	const auto trimmed = trim_view(str);
+	if(trimmed.size() == str.size())
+	{
+		return;
+	}
+	const auto first = std::size_t(trimmed.data() - str.data());
+	str.erase(first + trimmed.size());
+	str.erase(0, first);
+}
 
-std::vector<std::string> tokenize(const std::string& str, const std::string& delimiters)
+std::vector<std::string> string_utils::tokenize(const std::string& str, const std::string& delimiters)
 {
-    std::vector<std::string> tokens;
-    // Skip delimiters at beginning.
-    auto last_pos = str.find_first_not_of(delimiters, 0);
-    // Find first "non-delimiter".
-    auto pos = str.find_first_of(delimiters, last_pos);
+	std::vector<nonstd::string_view> views;
+	tokenize(str, delimiters, views);
 
-    while (std::string::npos != pos || std::string::npos != last_pos)
-    {
-        // Found a token, add it to the vector.
-        tokens.emplace_back(str.substr(last_pos, pos - last_pos));
-        // Skip delimiters.  Note the "not_of"
-        last_pos = str.find_first_not_of(delimiters, pos);
-        // Find next "non-delimiter"
-        pos = str.find_first_of(delimiters, last_pos);
-    }
-
-    return tokens;
+	std::vector<std::string> tokens;
+	tokens.reserve(views.size());
+	for(const auto& v : views)
+	{
+		tokens.emplace_back(v.data(), v.size());
+	}
+	return tokens;
+}
+
+void string_utils::tokenize(nonstd::string_view str, nonstd::string_view delimiters,
+							std::vector<nonstd::string_view>& tokens)
+{
+	std::size_t pos = 0;
+	while(pos < str.size())
+	{
+		// Skip delimiters, then find the end of the token
+		while(pos < str.size() && is_delimiter(str[pos], delimiters))
+		{
+			++pos;
+		}
+		const auto first = pos;
+		while(pos < str.size() && !is_delimiter(str[pos], delimiters))
+		{
+			++pos;
+		}
+		if(pos > first)
+		{
+			tokens.emplace_back(str.substr(first, pos - first));
+		}
+	}
 }
 
 std::string string_utils::to_upper(const std::string& str)
@@ -88,17 +126,20 @@ std::string string_utils::to_upper(const std::string& str)
 std::string string_utils::to_lower(const std::string& str)
 {
 	std::string s(str);
-    std::transform(s.begin(), s.end(), s.begin(), [](char in)
-    {
-        return char(tolower(in));
-    });
+	to_lower_in_place(s);
 	return s;
 }
 
-bool string_utils::begins_with(const std::string& str, const std::string& value, bool ignore_case /*= false*/)
+void string_utils::to_lower_in_place(std::string& str)
+{
+	std::transform(str.begin(), str.end(), str.begin(), [](char in) { return char(tolower(in)); });
+}
+
+bool string_utils::begins_with(nonstd::string_view str, nonstd::string_view value,
+							   bool ignore_case /*= false*/)
 {
 	// Validate requirements
-	if(str.length() < value.length())
+	if(str.size() < value.size())
 	{
 		return false;
 	}
@@ -108,10 +149,11 @@ bool string_utils::begins_with(const std::string& str, const std::string& value,
 	}
 
 	// Do the subsets match?
-	return (compare(std::string(str.substr(0, value.length())), value, ignore_case) == 0);
+	return compare(str.substr(0, value.size()), value, ignore_case) == 0;
 }
 
-bool string_utils::ends_with(const std::string& str, const std::string& value, bool ignore_case /*= false*/)
+bool string_utils::ends_with(nonstd::string_view str, nonstd::string_view value,
+							 bool ignore_case /*= false*/)
 {
 	// Validate requirements
 	if(str.size() < value.size())
@@ -124,36 +166,41 @@ bool string_utils::ends_with(const std::string& str, const std::string& value, b
 	}
 
 	// Do the subsets match?
-	return (compare(std::string(str.substr(str.length() - value.length())), value, ignore_case) == 0);
+	return compare(str.substr(str.size() - value.size()), value, ignore_case) == 0;
 }
 
 std::string string_utils::replace(const std::string& str, const std::string& old_seq,
 								  const std::string& new_seq)
 {
 	std::string s = str;
-	std::string::size_type location = 0;
-	std::string::size_type old_length = old_seq.length();
-	std::string::size_type new_length = new_seq.length();
+	replace_in_place(s, old_seq, new_seq);
+	return s;
+}
 
-	// Search for all replace std::string occurances.
-	if(!s.empty())
+std::size_t string_utils::replace_in_place(std::string& str, nonstd::string_view old_seq,
+										   nonstd::string_view new_seq)
+{
+	if(str.empty() || old_seq.empty())
 	{
-		while(std::string::npos != (location = s.find(old_seq, location)))
-		{
-			s.replace(location, old_length, new_seq);
-			location += new_length;
-
-			// Break out if we're done
-			if(location >= s.length())
-			{
-				break;
-			}
-
-		} // Next
+		return 0;
+	}
 
-	} // End if not empty
+	std::size_t count = 0;
+	std::string::size_type location = 0;
+	// Search for all replace std::string occurances.
+	while(std::string::npos != (location = str.find(old_seq.data(), location, old_seq.size())))
+	{
+		str.replace(location, old_seq.size(), new_seq.data(), new_seq.size());
+		location += new_seq.size();
+		++count;
 
-	return s;
+		// Break out if we're done
+		if(location >= str.length())
+		{
+			break;
+		}
+	}
+	return count;
 }
 
 std::string string_utils::replace(const std::string& str, std::string::value_type old_char,
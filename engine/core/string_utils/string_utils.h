@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../common/nonstd/string_view.hpp"
+
 #include <algorithm>
 #include <cctype> // toupper / tolower
 #include <locale>
@@ -83,10 +85,20 @@ private:
 //-------------------------------------------------------------------------
 //  Name : compare ()
 /// <summary>
-/// Compare the two std::strings with optional case ignore.
+/// Compare the two std::strings with optional case ignore. The case is
+/// folded for ascii only, as the classic locale does.
 /// </summary>
 //-------------------------------------------------------------------------
-int compare(const std::string& s1, const std::string& s2, bool ignore_case);
+int compare(nonstd::string_view s1, nonstd::string_view s2, bool ignore_case);
+
+//-------------------------------------------------------------------------
+//  Name : iequals ()
+/// <summary>
+/// Whether the two strings are the same but for the case of ascii letters.
+/// </summary>
+//-------------------------------------------------------------------------
+bool iequals(nonstd::string_view s1, nonstd::string_view s2);
+
 //-------------------------------------------------------------------------
 //  Name : trim()
 /// <summary>
@@ -96,6 +108,22 @@ int compare(const std::string& s1, const std::string& s2, bool ignore_case);
 //-------------------------------------------------------------------------
 std::string trim(const std::string& str);
 
+//-------------------------------------------------------------------------
+//  Name : trim_view()
+/// <summary>
+/// The part of the string without the white space of its head and tail.
+/// </summary>
+//-------------------------------------------------------------------------
+nonstd::string_view trim_view(nonstd::string_view str);
+
+//-------------------------------------------------------------------------
+//  Name : trim_in_place()
+/// <summary>
+/// Strips the white space of the head and tail of the string itself.
+/// </summary>
+//-------------------------------------------------------------------------
+void trim_in_place(std::string& str);
+
 //-------------------------------------------------------------------------
 //  Name : tokenize()
 /// <summary>
@@ -103,6 +131,16 @@ std::string trim(const std::string& str);
 /// </summary>
 //-------------------------------------------------------------------------
 std::vector<std::string> tokenize(const std::string& str, const std::string& delimiters);
+
+//-------------------------------------------------------------------------
+//  Name : tokenize()
+/// <summary>
+/// Tokenize the string by the delimiters into views of it, the tokens are
+/// appended and valid as long as the string is.
+/// </summary>
+//-------------------------------------------------------------------------
+void tokenize(nonstd::string_view str, nonstd::string_view delimiters,
+			  std::vector<nonstd::string_view>& tokens);
 //-------------------------------------------------------------------------
 //  Name : to_upper()
 /// <summary>
@@ -121,13 +159,21 @@ std::string to_upper(const std::string& str);
 //-------------------------------------------------------------------------
 std::string to_lower(const std::string& str);
 
+//-------------------------------------------------------------------------
+//  Name : to_lower_in_place()
+/// <summary>
+/// Transforms the characters of the string itself to lower case.
+/// </summary>
+//-------------------------------------------------------------------------
+void to_lower_in_place(std::string& str);
+
 //-------------------------------------------------------------------------
 //  Name : begins_with ()
 /// <summary>
 /// Determine if this std::string begins with the std::string provided.
 /// </summary>
 //-------------------------------------------------------------------------
-bool begins_with(const std::string& str, const std::string& value, bool ignore_case = false);
+bool begins_with(nonstd::string_view str, nonstd::string_view value, bool ignore_case = false);
 
 //-------------------------------------------------------------------------
 //  Name : ends_with ()
@@ -135,7 +181,7 @@ bool begins_with(const std::string& str, const std::string& value, bool ignore_c
 /// Determine if this std::string ends with the std::string provided.
 /// </summary>
 //-------------------------------------------------------------------------
-bool ends_with(const std::string& str, const std::string& value, bool ignore_case = false);
+bool ends_with(nonstd::string_view str, nonstd::string_view value, bool ignore_case = false);
 
 //-------------------------------------------------------------------------
 //  Name : replace ()
@@ -146,6 +192,15 @@ bool ends_with(const std::string& str, const std::string& value, bool ignore_cas
 //-------------------------------------------------------------------------
 std::string replace(const std::string& str, const std::string& old_seq, const std::string& new_seq);
 
+//-------------------------------------------------------------------------
+//  Name : replace_in_place ()
+/// <summary>
+/// Replaces the occurences of the sequence in the string itself, which is
+/// not touched when there are none. Returns how many were replaced.
+/// </summary>
+//-------------------------------------------------------------------------
+std::size_t replace_in_place(std::string& str, nonstd::string_view old_seq, nonstd::string_view new_seq);
+
 //-------------------------------------------------------------------------
 //  Name : replace ()
 /// <summary>
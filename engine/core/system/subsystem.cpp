@@ -11,17 +11,14 @@ bool subsystem_context::initialize()
 
 void subsystem_context::dispose()
 {
-	for(auto iter = _orders.rbegin(); iter != _orders.rend(); iter++)
+	// the last added goes first, it may use the ones added before it
+	while(!_subsystems.empty())
 	{
-		auto found = _subsystems.find(*iter);
-		ensures(found != _subsystems.end());
-
-		found->second.reset();
-		_subsystems.erase(found);
+		auto& last = _subsystems.back();
+		last.instance.reset();
+		last.reset_slot();
+		_subsystems.pop_back();
 	}
-
-	_orders.clear();
-	ensures(_subsystems.empty());
 }
 
 namespace details
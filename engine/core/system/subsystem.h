@@ -5,7 +5,6 @@
 
 #include <algorithm>
 #include <memory>
-#include <unordered_map>
 #include <vector>
 
 namespace core
@@ -18,6 +17,10 @@ S& get_subsystem();
 template <typename S, typename... Args>
 S& add_subsystem(Args&&... args);
 
+// register an instance constructed elsewhere, e.g. on another thread
+template <typename S>
+S& insert_subsystem(std::shared_ptr<S> instance);
+
 // release and unregistered a subsystem from our context
 template <typename S>
 void remove_subsystem();
@@ -29,6 +32,17 @@ bool has_subsystems();
 struct subsystem_context;
 namespace details
 {
+// the instance of a subsystem type, set while it is registered, so the
+// lookup is a load of a static pointer
+template <typename S>
+struct subsystem_slot
+{
+	static S* instance;
+};
+
+template <typename S>
+S* subsystem_slot<S>::instance = nullptr;
+
 enum class internal_status : uint8_t
 {
 	idle,
@@ -108,6 +122,16 @@ struct subsystem_context
 	template <typename S, typename... Args>
 	S& add_subsystem(Args&&... args);
 
+	//-----------------------------------------------------------------------------
+	//  Name : insert_subsystem ()
+	/// <summary>
+	/// Registers an instance constructed elsewhere, it is disposed in the order
+	/// it is inserted like the added ones
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <typename S>
+	S& insert_subsystem(std::shared_ptr<S> instance);
+
 	//-----------------------------------------------------------------------------
 	//  Name : get_subsystem ()
 	/// <summary>
@@ -151,10 +175,17 @@ struct subsystem_context
 	bool has_subsystems() const;
 
 protected:
-	///
-	std::vector<std::size_t> _orders;
-	///
-	std::unordered_map<std::size_t, std::shared_ptr<void>> _subsystems;
+	struct entry
+	{
+		std::size_t index = 0;
+		std::shared_ptr<void> instance;
+		/// clears the slot of the subsystem type
+		void (*reset_slot)() = nullptr;
+	};
+
+	/// the registered subsystems, in the order they were added. Their slots
+	/// are static, so there is a single context, details::context()
+	std::vector<entry> _subsystems;
 };
 
 //
@@ -162,11 +193,24 @@ protected:
 template <typename S, typename... Args>
 S& subsystem_context::add_subsystem(Args&&... args)
 {
-	auto index = rtti::type_id<S>().hash_code();
 	expects(!has_subsystems<S>() && "duplicated subsystem");
 
-	_orders.push_back(index);
-	_subsystems.emplace(std::make_pair(index, std::make_unique<S>(std::forward<Args>(args)...)));
+	return insert_subsystem(std::make_shared<S>(std::forward<Args>(args)...));
+}
+
+template <typename S>
+S& subsystem_context::insert_subsystem(std::shared_ptr<S> instance)
+{
+	expects(!has_subsystems<S>() && "duplicated subsystem");
+	expects(instance && "null subsystem");
+
+	details::subsystem_slot<S>::instance = instance.get();
+
+	entry e;
+	e.index = rtti::type_id<S>().hash_code();
+	e.instance = std::move(instance);
+	e.reset_slot = []() { details::subsystem_slot<S>::instance = nullptr; };
+	_subsystems.emplace_back(std::move(e));
 
 	return get_subsystem<S>();
 }
@@ -175,8 +219,7 @@ template <typename S>
 S& subsystem_context::get_subsystem()
 {
 	expects(has_subsystems<S>() && "failed to find system");
-	const auto index = rtti::type_id<S>().hash_code();
-	return *reinterpret_cast<S*>(_subsystems[index].get());
+	return *details::subsystem_slot<S>::instance;
 }
 
 template <typename S>
@@ -184,16 +227,17 @@ void subsystem_context::remove_subsystem()
 {
 	expects(has_subsystems<S>() && "failed to find system");
 	const auto index = rtti::type_id<S>().hash_code();
-	_subsystems.erase(index);
-	_orders.erase(std::remove_if(std::begin(_orders), std::end(_orders),
-								 [index](const auto& el) { return index == el; }, std::end(_orders)));
+	auto it = std::find_if(std::begin(_subsystems), std::end(_subsystems),
+						   [index](const auto& el) { return index == el.index; });
+	it->instance.reset();
+	it->reset_slot();
+	_subsystems.erase(it);
 }
 
 template <typename S>
 bool subsystem_context::has_subsystems() const
 {
-	const auto index = rtti::type_id<S>().hash_code();
-	return _subsystems.find(index) != _subsystems.end();
+	return details::subsystem_slot<S>::instance != nullptr;
 }
 
 template <typename S1, typename S2, typename... Args>
@@ -216,6 +260,13 @@ S& add_subsystem(Args&&... args)
 	return details::context().add_subsystem<S>(std::forward<Args>(args)...);
 }
 
+template <typename S>
+S& insert_subsystem(std::shared_ptr<S> instance)
+{
+	expects(details::status() == details::internal_status::running && "details::context must be initialized");
+	return details::context().insert_subsystem(std::move(instance));
+}
+
 template <typename S>
 void remove_subsystem()
 {
@@ -0,0 +1,27 @@
+#include "cancellation_token.h"
+
+#include <utility>
+
+namespace core
+{
+namespace
+{
+thread_local cancellation_token s_current;
+}
+
+const cancellation_token& get_current_cancellation() noexcept
+{
+	return s_current;
+}
+
+scoped_cancellation::scoped_cancellation(cancellation_token token)
+	: previous_(std::move(s_current))
+{
+	s_current = std::move(token);
+}
+
+scoped_cancellation::~scoped_cancellation()
+{
+	s_current = std::move(previous_);
+}
+}
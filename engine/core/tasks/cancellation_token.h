@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+namespace core
+{
+/*
+ * cancellation_token; a flag shared by the tasks of some work and whoever may
+ * cancel all of it at once.
+ *
+ *      A task carries the token current on the thread that pushed it, and
+ *      the token is current while the task runs, so that what it pushes in
+ *      turn carries it too. A cancelled task is dropped when it is popped
+ *      and its future is broken. A running task is not interrupted, a long
+ *      one checks the current token at its own pace. The empty token is
+ *      never cancelled and costs nothing to carry.
+ */
+class cancellation_token
+{
+public:
+	cancellation_token() = default;
+
+	static cancellation_token create()
+	{
+		cancellation_token token;
+		token.flag_ = std::make_shared<std::atomic<bool>>(false);
+		return token;
+	}
+
+	void cancel() const
+	{
+		if(flag_)
+		{
+			flag_->store(true, std::memory_order_release);
+		}
+	}
+
+	bool is_cancelled() const noexcept
+	{
+		return flag_ && flag_->load(std::memory_order_acquire);
+	}
+
+	bool valid() const noexcept
+	{
+		return static_cast<bool>(flag_);
+	}
+
+private:
+	std::shared_ptr<std::atomic<bool>> flag_;
+};
+
+/// the token of the thread, of the task it runs or of the innermost
+/// scoped_cancellation
+const cancellation_token& get_current_cancellation() noexcept;
+
+/// Makes the token current on the thread while alive.
+struct scoped_cancellation
+{
+	explicit scoped_cancellation(cancellation_token token);
+	~scoped_cancellation();
+	scoped_cancellation(const scoped_cancellation&) = delete;
+	scoped_cancellation& operator=(const scoped_cancellation&) = delete;
+
+private:
+	cancellation_token previous_;
+};
+}
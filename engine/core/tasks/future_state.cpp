@@ -0,0 +1,65 @@
+#include "future_state.hpp"
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace core
+{
+namespace detail
+{
+namespace
+{
+constexpr std::size_t stripes_count = 64;
+
+struct wait_stripe
+{
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::atomic<std::size_t> waiters{0};
+};
+
+wait_stripe& get_stripe(const void* address)
+{
+	static std::array<wait_stripe, stripes_count> stripes;
+	const auto key = reinterpret_cast<std::uintptr_t>(address);
+	return stripes[(key >> 4) % stripes_count];
+}
+}
+
+bool wait_for_state_ready(const std::atomic<bool>& ready, const std::chrono::steady_clock::time_point* until)
+{
+	auto& stripe = get_stripe(&ready);
+	const auto is_ready = [&ready]() { return ready.load(); };
+
+	std::unique_lock<std::mutex> lock(stripe.mutex);
+	++stripe.waiters;
+	bool result = true;
+	if(until)
+	{
+		result = stripe.cv.wait_until(lock, *until, is_ready);
+	}
+	else
+	{
+		stripe.cv.wait(lock, is_ready);
+	}
+	--stripe.waiters;
+	return result;
+}
+
+void notify_state_ready(const std::atomic<bool>& ready)
+{
+	auto& stripe = get_stripe(&ready);
+	// the flag was stored before this load (both sequentially consistent) so a
+	// waiter that is not counted yet will see it before going to sleep.
+	if(stripe.waiters.load() == 0)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(stripe.mutex);
+	stripe.cv.notify_all();
+}
+}
+}
@@ -0,0 +1,353 @@
+#pragma once
+
+#include "task_memory.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace core
+{
+namespace detail
+{
+
+//-----------------------------------------------------------------------------
+//  Name : wait_for_state_ready ()
+/// <summary>
+/// Blocks until the flag becomes true or the time point is reached.
+/// Waiters park on a small striped table of condition variables keyed by
+/// the flag address instead of each state carrying its own.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool wait_for_state_ready(const std::atomic<bool>& ready, const std::chrono::steady_clock::time_point* until);
+
+//-----------------------------------------------------------------------------
+//  Name : notify_state_ready ()
+/// <summary>
+/// Wakes the threads waiting on the flag. Must be called after setting it.
+/// </summary>
+//-----------------------------------------------------------------------------
+void notify_state_ready(const std::atomic<bool>& ready);
+
+/*
+ * future_state_base; intrusive, pooled replacement for the shared state
+ * of std::packaged_task/std::shared_future.
+ */
+struct future_state_base : task_pooled
+{
+	future_state_base() = default;
+	future_state_base(const future_state_base&) = delete;
+	future_state_base& operator=(const future_state_base&) = delete;
+	virtual ~future_state_base() = default;
+
+	void add_ref() noexcept
+	{
+		refs_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void release() noexcept
+	{
+		if(refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			delete this;
+		}
+	}
+
+	bool is_ready() const noexcept
+	{
+		return ready_.load(std::memory_order_acquire);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_unique ()
+	/// <summary>
+	/// Checks if the caller holds the only reference. Nobody can start sharing
+	/// the state then, so the result may be moved out.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool is_unique() const noexcept
+	{
+		return refs_.load(std::memory_order_acquire) == 1;
+	}
+
+	void wait() const
+	{
+		if(!is_ready())
+		{
+			wait_for_state_ready(ready_, nullptr);
+		}
+	}
+
+	template <class Clock, class Dur>
+	std::future_status wait_until(const std::chrono::time_point<Clock, Dur>& abs_time) const
+	{
+		if(is_ready())
+		{
+			return std::future_status::ready;
+		}
+
+		const auto until = std::chrono::steady_clock::now() + (abs_time - Clock::now());
+		return wait_for_state_ready(ready_, &until) ? std::future_status::ready : std::future_status::timeout;
+	}
+
+	template <class Rep, class Per>
+	std::future_status wait_for(const std::chrono::duration<Rep, Per>& rel_time) const
+	{
+		if(is_ready())
+		{
+			return std::future_status::ready;
+		}
+
+		if(rel_time <= rel_time.zero())
+		{
+			return std::future_status::timeout;
+		}
+
+		return wait_until(std::chrono::steady_clock::now() + rel_time);
+	}
+
+	void set_exception(std::exception_ptr error) noexcept
+	{
+		error_ = std::move(error);
+		make_ready();
+	}
+
+	void set_broken_promise() noexcept
+	{
+		set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+	}
+
+	/// asks for the task of the state to be dropped if it has not started
+	void request_cancel() noexcept
+	{
+		cancelled_.store(true, std::memory_order_release);
+	}
+
+	bool is_cancel_requested() const noexcept
+	{
+		return cancelled_.load(std::memory_order_acquire);
+	}
+
+protected:
+	void make_ready() noexcept
+	{
+		ready_.store(true);
+		notify_state_ready(ready_);
+	}
+
+	void rethrow_if_error() const
+	{
+		if(error_)
+		{
+			std::rethrow_exception(error_);
+		}
+	}
+
+private:
+	std::atomic<std::uint32_t> refs_{1};
+	std::atomic<bool> ready_{false};
+	std::atomic<bool> cancelled_{false};
+	std::exception_ptr error_;
+};
+
+template <typename T>
+struct future_state : future_state_base
+{
+	~future_state() override
+	{
+		if(has_value_)
+		{
+			reinterpret_cast<T*>(&storage_)->~T();
+		}
+	}
+
+	template <typename U>
+	void set_value(U&& value)
+	{
+		new(&storage_) T(std::forward<U>(value));
+		has_value_ = true;
+		make_ready();
+	}
+
+	const T& get() const
+	{
+		wait();
+		rethrow_if_error();
+		return *reinterpret_cast<const T*>(&storage_);
+	}
+
+	T take()
+	{
+		wait();
+		rethrow_if_error();
+		return std::move(*reinterpret_cast<T*>(&storage_));
+	}
+
+private:
+	std::aligned_storage_t<sizeof(T), alignof(T)> storage_;
+	bool has_value_ = false;
+};
+
+template <typename T>
+struct future_state<T&> : future_state_base
+{
+	void set_value(T& value) noexcept
+	{
+		value_ = &value;
+		make_ready();
+	}
+
+	T& get() const
+	{
+		wait();
+		rethrow_if_error();
+		return *value_;
+	}
+
+private:
+	T* value_ = nullptr;
+};
+
+template <>
+struct future_state<void> : future_state_base
+{
+	void set_value() noexcept
+	{
+		make_ready();
+	}
+
+	void get() const
+	{
+		wait();
+		rethrow_if_error();
+	}
+};
+
+/*
+ * future_state_ptr; intrusive reference to a future_state.
+ */
+template <typename T>
+class future_state_ptr
+{
+public:
+	future_state_ptr() = default;
+
+	static future_state_ptr create()
+	{
+		future_state_ptr res;
+		res.state_ = new future_state<T>();
+		return res;
+	}
+
+	future_state_ptr(const future_state_ptr& other) noexcept
+		: state_(other.state_)
+	{
+		if(state_)
+		{
+			state_->add_ref();
+		}
+	}
+
+	future_state_ptr(future_state_ptr&& other) noexcept
+		: state_(other.state_)
+	{
+		other.state_ = nullptr;
+	}
+
+	future_state_ptr& operator=(future_state_ptr other) noexcept
+	{
+		std::swap(state_, other.state_);
+		return *this;
+	}
+
+	~future_state_ptr()
+	{
+		if(state_)
+		{
+			state_->release();
+		}
+	}
+
+	future_state<T>* operator->() const noexcept
+	{
+		return state_;
+	}
+
+	explicit operator bool() const noexcept
+	{
+		return state_ != nullptr;
+	}
+
+	bool is_unique() const noexcept
+	{
+		return state_ && state_->is_unique();
+	}
+
+private:
+	future_state<T>* state_ = nullptr;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : take_value ()
+/// <summary>
+/// Gets the result, moving it out of the state if this is the last reference
+/// to it and copying it otherwise.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename T,
+		  typename std::enable_if_t<!std::is_reference<T>::value && !std::is_void<T>::value>* = nullptr>
+inline T take_value(const future_state_ptr<T>& state)
+{
+	if(state.is_unique())
+	{
+		return state->take();
+	}
+	return state->get();
+}
+
+template <typename T,
+		  typename std::enable_if_t<std::is_reference<T>::value || std::is_void<T>::value>* = nullptr>
+inline decltype(auto) take_value(const future_state_ptr<T>& state)
+{
+	return state->get();
+}
+
+//-----------------------------------------------------------------------------
+//  Name : fulfill ()
+/// <summary>
+/// Invokes the callable and stores its result or exception in the state.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename T, typename F, typename std::enable_if_t<!std::is_void<T>::value>* = nullptr>
+inline void fulfill(future_state<T>& state, F&& f)
+{
+	try
+	{
+		state.set_value(f());
+	}
+	catch(...)
+	{
+		state.set_exception(std::current_exception());
+	}
+}
+
+template <typename T, typename F, typename std::enable_if_t<std::is_void<T>::value>* = nullptr>
+inline void fulfill(future_state<T>& state, F&& f)
+{
+	try
+	{
+		f();
+		state.set_value();
+	}
+	catch(...)
+	{
+		state.set_exception(std::current_exception());
+	}
+}
+}
+}
@@ -0,0 +1,164 @@
+#include "job_graph.h"
+
+#include "../common/assert.hpp"
+
+namespace core
+{
+
+job_graph::job_graph(task_system& ts)
+	: group_(std::make_unique<task_group>(ts))
+{
+}
+
+job_graph::~job_graph() = default;
+
+job_graph::node_id job_graph::add_node(job_t job, const std::string& name)
+{
+	expects(!is_running());
+
+	nodes_.emplace_back();
+	auto& n = nodes_.back();
+	n.job = std::move(job);
+	n.name = name;
+	return nodes_.size() - 1;
+}
+
+job_graph::node_id job_graph::add_owner_node(job_t job, const std::string& name)
+{
+	const auto id = add_node(std::move(job), name);
+	nodes_[id].on_owner_thread = true;
+	return id;
+}
+
+void job_graph::add_edge(node_id before, node_id after)
+{
+	expects(!is_running());
+	expects(before < nodes_.size() && after < nodes_.size() && before != after);
+
+	nodes_[before].successors.push_back(after);
+	nodes_[after].predecessors++;
+}
+
+void job_graph::submit()
+{
+	group_->wait();
+
+	if(remaining_size_ != nodes_.size())
+	{
+		remaining_size_ = nodes_.size();
+		remaining_ = std::make_unique<std::atomic<std::size_t>[]>(remaining_size_);
+	}
+
+	for(node_id id = 0; id < nodes_.size(); ++id)
+	{
+		remaining_[id].store(nodes_[id].predecessors, std::memory_order_relaxed);
+	}
+
+	for(node_id id = 0; id < nodes_.size(); ++id)
+	{
+		if(nodes_[id].predecessors == 0)
+		{
+			push_node(id);
+		}
+	}
+}
+
+void job_graph::wait()
+{
+	group_->wait();
+}
+
+void job_graph::run()
+{
+	submit();
+	wait();
+}
+
+void job_graph::clear()
+{
+	group_->wait();
+	nodes_.clear();
+}
+
+bool job_graph::is_running() const
+{
+	return group_->get_pending() > 0;
+}
+
+bool job_graph::is_acyclic() const
+{
+	// Kahn's algorithm, every node must be reachable through zero in-degree.
+	std::vector<std::size_t> in_degree(nodes_.size());
+	std::vector<node_id> ready;
+	for(node_id id = 0; id < nodes_.size(); ++id)
+	{
+		in_degree[id] = nodes_[id].predecessors;
+		if(in_degree[id] == 0)
+		{
+			ready.push_back(id);
+		}
+	}
+
+	std::size_t visited = 0;
+	while(!ready.empty())
+	{
+		const auto id = ready.back();
+		ready.pop_back();
+		++visited;
+		for(const auto successor : nodes_[id].successors)
+		{
+			if(--in_degree[successor] == 0)
+			{
+				ready.push_back(successor);
+			}
+		}
+	}
+
+	return visited == nodes_.size();
+}
+
+void job_graph::push_node(node_id id)
+{
+	if(nodes_[id].on_owner_thread)
+	{
+		group_->run_on_owner([this, id]() { execute_node(id); });
+	}
+	else
+	{
+		group_->run([this, id]() { execute_node(id); });
+	}
+}
+
+void job_graph::execute_node(node_id id)
+{
+	const auto& n = nodes_[id];
+
+	// successors are released even if the job throws, the group keeps the
+	// error and the submission still finishes.
+	try
+	{
+		if(n.job)
+		{
+			n.job();
+		}
+	}
+	catch(...)
+	{
+		release_successors(id);
+		throw;
+	}
+
+	release_successors(id);
+}
+
+void job_graph::release_successors(node_id id)
+{
+	for(const auto successor : nodes_[id].successors)
+	{
+		if(remaining_[successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			push_node(successor);
+		}
+	}
+}
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "task_group.h"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace core
+{
+
+/*
+ * job_graph; an explicit dependency graph of jobs that can be submitted
+ * again and again, e.g. once per frame.
+ *
+ *      Every node knows how many predecessors it has. On submit the counters
+ *      are reset, the nodes without predecessors are pushed and every finished
+ *      node decrements the counters of its successors, pushing the ones that
+ *      reach zero. Nothing is enqueued before it can run, so the queues never
+ *      have to be searched for ready tasks.
+ *
+ *      The graph must not be modified while it is running.
+ */
+class job_graph
+{
+public:
+	using node_id = std::size_t;
+	using job_t = std::function<void()>;
+
+	explicit job_graph(task_system& ts);
+
+	job_graph(const job_graph&) = delete;
+	job_graph& operator=(const job_graph&) = delete;
+
+	//-----------------------------------------------------------------------------
+	//  Name : ~job_graph ()
+	/// <summary>
+	/// Waits for a running submission to finish.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	~job_graph();
+
+	//-----------------------------------------------------------------------------
+	//  Name : add_node ()
+	/// <summary>
+	/// Adds a node executed on any worker thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	node_id add_node(job_t job, const std::string& name = {});
+
+	//-----------------------------------------------------------------------------
+	//  Name : add_owner_node ()
+	/// <summary>
+	/// Adds a node that must be executed on the owner thread. It runs while
+	/// the owner thread waits on the graph or runs its queue.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	node_id add_owner_node(job_t job, const std::string& name = {});
+
+	//-----------------------------------------------------------------------------
+	//  Name : add_edge ()
+	/// <summary>
+	/// Makes 'after' wait for 'before' to finish.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void add_edge(node_id before, node_id after);
+
+	//-----------------------------------------------------------------------------
+	//  Name : submit ()
+	/// <summary>
+	/// Starts executing the graph. Waits for the previous submission first.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void submit();
+
+	//-----------------------------------------------------------------------------
+	//  Name : wait ()
+	/// <summary>
+	/// Waits for the current submission while helping with the queued work.
+	/// Rethrows the first exception thrown by a node.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void wait();
+
+	//-----------------------------------------------------------------------------
+	//  Name : run ()
+	/// <summary>
+	/// Submits the graph and waits for it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void run();
+
+	//-----------------------------------------------------------------------------
+	//  Name : clear ()
+	/// <summary>
+	/// Removes all nodes and edges.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void clear();
+
+	bool is_running() const;
+
+	std::size_t get_nodes_count() const
+	{
+		return nodes_.size();
+	}
+
+	const std::string& get_node_name(node_id id) const
+	{
+		return nodes_[id].name;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_acyclic ()
+	/// <summary>
+	/// Checks that the edges do not form a cycle. A graph with a cycle would
+	/// never finish.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool is_acyclic() const;
+
+private:
+	void push_node(node_id id);
+	void execute_node(node_id id);
+	void release_successors(node_id id);
+
+	struct node
+	{
+		job_t job;
+		std::string name;
+		std::vector<node_id> successors;
+		std::size_t predecessors = 0;
+		bool on_owner_thread = false;
+	};
+
+	std::vector<node> nodes_;
+	/// remaining predecessors per node for the running submission.
+	std::unique_ptr<std::atomic<std::size_t>[]> remaining_;
+	std::size_t remaining_size_ = 0;
+	std::unique_ptr<task_group> group_;
+};
+}
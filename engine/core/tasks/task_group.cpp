@@ -0,0 +1,49 @@
+#include "task_group.h"
+
+namespace core
+{
+
+task_group::task_group(task_system& ts)
+	: ts_(ts)
+	, state_(std::make_shared<state>())
+{
+}
+
+task_group::~task_group()
+{
+	wait_impl();
+}
+
+void task_group::wait()
+{
+	wait_impl();
+
+	std::exception_ptr error;
+	{
+		std::lock_guard<std::mutex> lock(state_->mutex);
+		std::swap(error, state_->error);
+	}
+
+	if(error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+void task_group::wait_impl()
+{
+	using namespace std::literals;
+
+	while(state_->pending > 0)
+	{
+		if(ts_.try_run_one())
+		{
+			continue;
+		}
+
+		// nothing to help with, the remaining jobs are executing right now.
+		std::unique_lock<std::mutex> lock(state_->mutex);
+		state_->cv.wait_for(lock, 1ms, [this]() { return state_->pending == 0; });
+	}
+}
+}
@@ -0,0 +1,246 @@
+#pragma once
+
+#include "task_system.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace core
+{
+
+/*
+ * task_group; a set of fire and forget jobs executed on the worker queues.
+ *
+ *      Completion is tracked through one atomic counter for the whole group
+ *      instead of a future per job. wait() executes other tasks on the calling
+ *      thread until every job of the group has finished. The first exception
+ *      thrown by a job is rethrown from wait(). Jobs may push more jobs to
+ *      their own group, wait() covers those as well.
+ */
+class task_group
+{
+public:
+	explicit task_group(task_system& ts);
+
+	task_group(const task_group&) = delete;
+	task_group& operator=(const task_group&) = delete;
+
+	//-----------------------------------------------------------------------------
+	//  Name : ~task_group ()
+	/// <summary>
+	/// Waits for all the jobs. Exceptions are swallowed here, call wait
+	/// explicitly to get them.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	~task_group();
+
+	//-----------------------------------------------------------------------------
+	//  Name : run ()
+	/// <summary>
+	/// Pushes a job to one of the worker threads.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <typename F>
+	void run(F&& f)
+	{
+		ts_.push_job(jobs_pushed_++, make_job(std::forward<F>(f)));
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : run_on_owner ()
+	/// <summary>
+	/// Pushes a job to the owner thread. It is executed when the owner thread
+	/// waits on the group or runs its queue.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <typename F>
+	void run_on_owner(F&& f)
+	{
+		ts_.push_owner_job(make_job(std::forward<F>(f)));
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : wait ()
+	/// <summary>
+	/// Waits for all the jobs while helping with the queued work.
+	/// Rethrows the first exception thrown by a job.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void wait();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_pending ()
+	/// <summary>
+	/// Number of jobs that have not finished yet.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t get_pending() const
+	{
+		return state_->pending.load();
+	}
+
+private:
+	void wait_impl();
+
+	template <typename F>
+	task make_job(F&& f)
+	{
+		auto st = state_;
+		st->pending++;
+		return task::make_job_task([st, f = std::forward<F>(f)]() mutable {
+			try
+			{
+				f();
+			}
+			catch(...)
+			{
+				std::lock_guard<std::mutex> lock(st->mutex);
+				if(!st->error)
+				{
+					st->error = std::current_exception();
+				}
+			}
+
+			if(--st->pending == 0)
+			{
+				std::lock_guard<std::mutex> lock(st->mutex);
+				st->cv.notify_all();
+			}
+		});
+	}
+
+	struct state
+	{
+		std::atomic<std::size_t> pending{0};
+		std::mutex mutex;
+		std::condition_variable cv;
+		std::exception_ptr error;
+	};
+
+	task_system& ts_;
+	/// shared with the jobs so that the last one can safely signal.
+	std::shared_ptr<state> state_;
+	/// jobs may be pushed from within other jobs of the group.
+	std::atomic<std::size_t> jobs_pushed_{0};
+};
+
+//-----------------------------------------------------------------------------
+//  Name : get_chunks_count ()
+/// <summary>
+/// Number of chunks of at most grain elements needed for [begin, end).
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename Index>
+inline std::size_t get_chunks_count(Index begin, Index end, Index grain)
+{
+	if(end <= begin)
+	{
+		return 0;
+	}
+	const auto count = static_cast<std::size_t>(end - begin);
+	const auto step = static_cast<std::size_t>(std::max<Index>(grain, Index(1)));
+	return (count + step - 1) / step;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : parallel_for ()
+/// <summary>
+/// Calls fn(i) for every i in [begin, end). The range is split in chunks of
+/// grain elements which are executed on the worker threads. The calling
+/// thread runs the last chunk itself and helps until everything is finished.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename Index, typename F>
+inline void parallel_for(task_system& ts, Index begin, Index end, Index grain, F&& fn)
+{
+	const auto chunks = get_chunks_count(begin, end, grain);
+	if(chunks == 0)
+	{
+		return;
+	}
+
+	const auto step = std::max<Index>(grain, Index(1));
+	const auto run_chunk = [&fn, begin, end, step](std::size_t chunk) {
+		const auto chunk_begin = static_cast<Index>(begin + static_cast<Index>(chunk) * step);
+		const auto chunk_end = std::min<Index>(end, static_cast<Index>(chunk_begin + step));
+		for(Index i = chunk_begin; i < chunk_end; ++i)
+		{
+			fn(i);
+		}
+	};
+
+	if(chunks == 1)
+	{
+		run_chunk(0);
+		return;
+	}
+
+	task_group group(ts);
+	for(std::size_t chunk = 0; chunk < chunks - 1; ++chunk)
+	{
+		group.run([&run_chunk, chunk]() { run_chunk(chunk); });
+	}
+	run_chunk(chunks - 1);
+	group.wait();
+}
+
+//-----------------------------------------------------------------------------
+//  Name : parallel_reduce ()
+/// <summary>
+/// Maps every i in [begin, end) with map_fn(i) and folds the results with
+/// reduce_fn(lhs, rhs) starting from identity. Each chunk is reduced
+/// into its own slot, the slots are folded in order on the calling thread,
+/// so reduce_fn only needs to be associative.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename Index, typename T, typename MapF, typename ReduceF>
+inline T parallel_reduce(task_system& ts, Index begin, Index end, Index grain, T identity, MapF&& map_fn,
+						 ReduceF&& reduce_fn)
+{
+	const auto chunks = get_chunks_count(begin, end, grain);
+	if(chunks == 0)
+	{
+		return identity;
+	}
+
+	std::vector<T> partials(chunks, identity);
+	const auto step = std::max<Index>(grain, Index(1));
+	const auto run_chunk = [&, begin, end, step](std::size_t chunk) {
+		const auto chunk_begin = static_cast<Index>(begin + static_cast<Index>(chunk) * step);
+		const auto chunk_end = std::min<Index>(end, static_cast<Index>(chunk_begin + step));
+		auto& partial = partials[chunk];
+		for(Index i = chunk_begin; i < chunk_end; ++i)
+		{
+			partial = reduce_fn(partial, map_fn(i));
+		}
+	};
+
+	if(chunks > 1)
+	{
+		task_group group(ts);
+		for(std::size_t chunk = 0; chunk < chunks - 1; ++chunk)
+		{
+			group.run([&run_chunk, chunk]() { run_chunk(chunk); });
+		}
+		run_chunk(chunks - 1);
+		group.wait();
+	}
+	else
+	{
+		run_chunk(0);
+	}
+
+	T result = identity;
+	for(const auto& partial : partials)
+	{
+		result = reduce_fn(result, partial);
+	}
+	return result;
+}
+}
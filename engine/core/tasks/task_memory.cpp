@@ -0,0 +1,175 @@
+#include "task_memory.h"
+
+#include <array>
+#include <mutex>
+#include <new>
+
+namespace core
+{
+namespace detail
+{
+namespace
+{
+constexpr std::size_t size_classes_count = 4;
+constexpr std::array<std::size_t, size_classes_count> size_classes = {{64, 128, 256, 512}};
+// how many blocks a thread keeps before giving half of them back.
+constexpr std::size_t local_cache_limit = 256;
+// how many blocks are moved at once between the global and the local lists.
+constexpr std::size_t transfer_batch = 32;
+constexpr std::size_t invalid_class = size_classes_count;
+
+struct free_block
+{
+	free_block* next = nullptr;
+};
+
+struct block_list
+{
+	void push(free_block* block) noexcept
+	{
+		block->next = head;
+		head = block;
+		++count;
+	}
+
+	free_block* pop() noexcept
+	{
+		auto block = head;
+		if(block)
+		{
+			head = block->next;
+			--count;
+		}
+		return block;
+	}
+
+	free_block* head = nullptr;
+	std::size_t count = 0;
+};
+
+struct global_pool
+{
+	std::mutex mutex;
+	block_list blocks;
+};
+
+std::array<global_pool, size_classes_count>& get_global_pools()
+{
+	// never destroyed on purpose. thread local caches of other threads
+	// may hand their blocks back during static destruction.
+	static auto pools = new std::array<global_pool, size_classes_count>();
+	return *pools;
+}
+
+struct local_cache
+{
+	~local_cache()
+	{
+		for(std::size_t i = 0; i < size_classes_count; ++i)
+		{
+			give_back(i, lists[i].count);
+		}
+	}
+
+	void give_back(std::size_t class_idx, std::size_t count) noexcept
+	{
+		auto& pool = get_global_pools()[class_idx];
+		auto& list = lists[class_idx];
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			auto block = list.pop();
+			if(!block)
+			{
+				break;
+			}
+			pool.blocks.push(block);
+		}
+	}
+
+	void take(std::size_t class_idx) noexcept
+	{
+		auto& pool = get_global_pools()[class_idx];
+		auto& list = lists[class_idx];
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		for(std::size_t i = 0; i < transfer_batch; ++i)
+		{
+			auto block = pool.blocks.pop();
+			if(!block)
+			{
+				break;
+			}
+			list.push(block);
+		}
+	}
+
+	std::array<block_list, size_classes_count> lists;
+};
+
+local_cache& get_local_cache()
+{
+	thread_local local_cache cache;
+	return cache;
+}
+
+std::size_t get_size_class(std::size_t size) noexcept
+{
+	for(std::size_t i = 0; i < size_classes_count; ++i)
+	{
+		if(size <= size_classes[i])
+		{
+			return i;
+		}
+	}
+	return invalid_class;
+}
+}
+
+void* allocate_task_memory(std::size_t size)
+{
+	const auto class_idx = get_size_class(size);
+	if(class_idx == invalid_class)
+	{
+		return ::operator new(size);
+	}
+
+	auto& cache = get_local_cache();
+	auto& list = cache.lists[class_idx];
+	if(!list.head)
+	{
+		cache.take(class_idx);
+	}
+
+	if(auto block = list.pop())
+	{
+		return block;
+	}
+
+	return ::operator new(size_classes[class_idx]);
+}
+
+void deallocate_task_memory(void* ptr, std::size_t size) noexcept
+{
+	if(!ptr)
+	{
+		return;
+	}
+
+	const auto class_idx = get_size_class(size);
+	if(class_idx == invalid_class)
+	{
+		::operator delete(ptr);
+		return;
+	}
+
+	auto& cache = get_local_cache();
+	auto& list = cache.lists[class_idx];
+	list.push(new(ptr) free_block());
+
+	if(list.count > local_cache_limit)
+	{
+		cache.give_back(class_idx, local_cache_limit / 2);
+	}
+}
+}
+}
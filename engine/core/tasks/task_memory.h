@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+
+namespace core
+{
+namespace detail
+{
+//-----------------------------------------------------------------------------
+//  Name : allocate_task_memory ()
+/// <summary>
+/// Allocates a block for a task model or a future state. Requests are
+/// rounded up to a size class of 64, 128, 256 or 512 bytes and served from a
+/// thread local free list which is refilled from a global one, so steady
+/// state frames do not touch the heap. Bigger requests go to operator new.
+/// </summary>
+//-----------------------------------------------------------------------------
+void* allocate_task_memory(std::size_t size);
+
+//-----------------------------------------------------------------------------
+//  Name : deallocate_task_memory ()
+/// <summary>
+/// Returns a block obtained from allocate_task_memory with the same size.
+/// Blocks may be freed on a different thread than the one allocating them.
+/// </summary>
+//-----------------------------------------------------------------------------
+void deallocate_task_memory(void* ptr, std::size_t size) noexcept;
+
+/*
+ * task_pooled; base for types that should be allocated from the task
+ * memory pools. With a virtual destructor the sized operator delete
+ * receives the size of the most derived type.
+ */
+struct task_pooled
+{
+	static void* operator new(std::size_t size)
+	{
+		return allocate_task_memory(size);
+	}
+
+	static void operator delete(void* ptr, std::size_t size) noexcept
+	{
+		deallocate_task_memory(ptr, size);
+	}
+};
+}
+}
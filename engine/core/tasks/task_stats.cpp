@@ -0,0 +1,199 @@
+#include "task_stats.h"
+
+#include <algorithm>
+
+namespace core
+{
+
+thread_stats::duration_t thread_stats::get_latency_percentile(double percentile) const
+{
+	std::uint64_t total = 0;
+	for(const auto count : latency_histogram)
+	{
+		total += count;
+	}
+
+	if(total == 0)
+	{
+		return duration_t::zero();
+	}
+
+	const auto wanted = static_cast<std::uint64_t>(std::max(0.0, std::min(percentile, 1.0)) * double(total));
+	std::uint64_t seen = 0;
+	std::size_t bucket = 0;
+	for(; bucket < latency_buckets_count - 1; ++bucket)
+	{
+		seen += latency_histogram[bucket];
+		if(seen > wanted || seen == total)
+		{
+			break;
+		}
+	}
+
+	return std::chrono::duration_cast<duration_t>(std::chrono::microseconds(std::uint64_t(1) << bucket));
+}
+
+void thread_stats::merge(const thread_stats& other)
+{
+	tasks_executed += other.tasks_executed;
+	execution_time += other.execution_time;
+	idle_time += other.idle_time;
+	steals_succeeded += other.steals_succeeded;
+	steals_failed += other.steals_failed;
+	budget_overruns += other.budget_overruns;
+	budget_overrun_time += other.budget_overrun_time;
+	for(std::size_t i = 0; i < latency_buckets_count; ++i)
+	{
+		latency_histogram[i] += other.latency_histogram[i];
+	}
+}
+
+thread_stats scheduler_stats::get_total() const
+{
+	thread_stats total;
+	for(const auto& thread : threads)
+	{
+		total.merge(thread);
+	}
+	return total;
+}
+
+namespace detail
+{
+namespace
+{
+std::size_t get_latency_bucket(thread_stats::duration_t latency)
+{
+	const auto us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+	std::size_t bucket = 0;
+	for(auto v = us; v > 0 && bucket < latency_buckets_count - 1; v >>= 1)
+	{
+		++bucket;
+	}
+	return bucket;
+}
+}
+
+void thread_counters::add_execution(duration_t execution_time)
+{
+	tasks_executed_.fetch_add(1, std::memory_order_relaxed);
+	execution_time_.fetch_add(execution_time.count(), std::memory_order_relaxed);
+}
+
+void thread_counters::add_latency(duration_t latency)
+{
+	latency_histogram_[get_latency_bucket(latency)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void thread_counters::add_idle(duration_t idle_time)
+{
+	idle_time_.fetch_add(idle_time.count(), std::memory_order_relaxed);
+}
+
+void thread_counters::add_steal(bool succeeded)
+{
+	auto& counter = succeeded ? steals_succeeded_ : steals_failed_;
+	counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+void thread_counters::add_budget_overrun(duration_t overrun_time)
+{
+	budget_overruns_.fetch_add(1, std::memory_order_relaxed);
+	budget_overrun_time_.fetch_add(overrun_time.count(), std::memory_order_relaxed);
+}
+
+thread_stats thread_counters::get_stats() const
+{
+	thread_stats stats;
+	stats.tasks_executed = tasks_executed_.load(std::memory_order_relaxed);
+	stats.execution_time = duration_t(execution_time_.load(std::memory_order_relaxed));
+	stats.idle_time = duration_t(idle_time_.load(std::memory_order_relaxed));
+	stats.steals_succeeded = steals_succeeded_.load(std::memory_order_relaxed);
+	stats.steals_failed = steals_failed_.load(std::memory_order_relaxed);
+	stats.budget_overruns = budget_overruns_.load(std::memory_order_relaxed);
+	stats.budget_overrun_time = duration_t(budget_overrun_time_.load(std::memory_order_relaxed));
+	for(std::size_t i = 0; i < latency_buckets_count; ++i)
+	{
+		stats.latency_histogram[i] = latency_histogram_[i].load(std::memory_order_relaxed);
+	}
+	return stats;
+}
+
+void thread_counters::reset()
+{
+	tasks_executed_ = 0;
+	execution_time_ = 0;
+	idle_time_ = 0;
+	steals_succeeded_ = 0;
+	steals_failed_ = 0;
+	budget_overruns_ = 0;
+	budget_overrun_time_ = 0;
+	for(auto& count : latency_histogram_)
+	{
+		count = 0;
+	}
+}
+
+void trace_buffer::push(const trace_event& e)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if(events_.size() < max_events)
+	{
+		events_.push_back(e);
+	}
+}
+
+std::vector<trace_event> trace_buffer::get_events() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return events_;
+}
+
+void trace_buffer::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	events_.clear();
+}
+}
+
+void write_chrome_trace(std::ostream& out, const std::vector<std::string>& thread_names,
+						const std::vector<std::vector<detail::trace_event>>& thread_events,
+						std::chrono::steady_clock::time_point origin)
+{
+	using us_t = std::chrono::duration<double, std::micro>;
+	static const char* priority_names[] = {"critical", "frame", "background", "idle"};
+
+	out << "{\"traceEvents\":[";
+	bool first = true;
+	const auto separate = [&]() {
+		if(!first)
+		{
+			out << ",";
+		}
+		first = false;
+	};
+
+	for(std::size_t tid = 0; tid < thread_names.size(); ++tid)
+	{
+		separate();
+		out << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << tid
+			<< ",\"args\":{\"name\":\"" << thread_names[tid] << "\"}}";
+	}
+
+	for(std::size_t tid = 0; tid < thread_events.size(); ++tid)
+	{
+		for(const auto& e : thread_events[tid])
+		{
+			const auto priority = std::min<std::size_t>(e.priority, 3);
+			separate();
+			out << "\n{\"name\":\"task\",\"cat\":\"" << priority_names[priority]
+				<< "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << tid
+				<< ",\"ts\":" << std::chrono::duration_cast<us_t>(e.begin - origin).count()
+				<< ",\"dur\":" << std::chrono::duration_cast<us_t>(e.duration).count()
+				<< ",\"args\":{\"id\":" << e.task_id << "}}";
+		}
+	}
+
+	out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+}
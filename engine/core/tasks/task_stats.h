@@ -0,0 +1,139 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace core
+{
+/// bucket i counts latencies in [2^(i-1), 2^i) microseconds, bucket 0 the ones
+/// below one microsecond. the last bucket also takes everything above.
+constexpr std::size_t latency_buckets_count = 24;
+
+struct thread_stats
+{
+	using duration_t = std::chrono::steady_clock::duration;
+
+	/// tasks executed on the thread
+	std::uint64_t tasks_executed = 0;
+	/// time spent executing tasks
+	duration_t execution_time = duration_t::zero();
+	/// time spent waiting for tasks
+	duration_t idle_time = duration_t::zero();
+	/// tasks taken from other queues
+	std::uint64_t steals_succeeded = 0;
+	/// attempts to take tasks from other queues that found nothing
+	std::uint64_t steals_failed = 0;
+	/// owner thread only, frames where the task budget was exceeded
+	std::uint64_t budget_overruns = 0;
+	/// owner thread only, total time spent past the budget
+	duration_t budget_overrun_time = duration_t::zero();
+	/// enqueue to start latency of the executed tasks
+	std::array<std::uint64_t, latency_buckets_count> latency_histogram{};
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_latency_percentile ()
+	/// <summary>
+	/// Returns the upper bound of the histogram bucket holding the given
+	/// percentile [0, 1] of the enqueue to start latency.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	duration_t get_latency_percentile(double percentile) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : merge ()
+	/// <summary>
+	/// Adds the counters of another thread to this one.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void merge(const thread_stats& other);
+};
+
+struct scheduler_stats
+{
+	/// indexed like the task_system threads, the owner thread first
+	std::vector<thread_stats> threads;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_total ()
+	/// <summary>
+	/// Returns the counters of all the threads added together.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	thread_stats get_total() const;
+};
+
+namespace detail
+{
+/*
+ * thread_counters; the live counters behind a thread_stats. Mostly written by
+ * the thread they belong to, relaxed atomics so that they can be read and
+ * written from anywhere.
+ */
+struct thread_counters
+{
+	using duration_t = thread_stats::duration_t;
+
+	void add_execution(duration_t execution_time);
+	void add_latency(duration_t latency);
+	void add_idle(duration_t idle_time);
+	void add_steal(bool succeeded);
+	void add_budget_overrun(duration_t overrun_time);
+
+	thread_stats get_stats() const;
+	void reset();
+
+private:
+	std::atomic<std::uint64_t> tasks_executed_{0};
+	std::atomic<duration_t::rep> execution_time_{0};
+	std::atomic<duration_t::rep> idle_time_{0};
+	std::atomic<std::uint64_t> steals_succeeded_{0};
+	std::atomic<std::uint64_t> steals_failed_{0};
+	std::atomic<std::uint64_t> budget_overruns_{0};
+	std::atomic<duration_t::rep> budget_overrun_time_{0};
+	std::array<std::atomic<std::uint64_t>, latency_buckets_count> latency_histogram_{};
+};
+
+struct trace_event
+{
+	std::uint64_t task_id = 0;
+	std::uint8_t priority = 0;
+	std::chrono::steady_clock::time_point begin;
+	std::chrono::steady_clock::duration duration;
+};
+
+/*
+ * trace_buffer; bounded list of the tasks executed on a thread while tracing.
+ */
+struct trace_buffer
+{
+	/// events past this are dropped so a forgotten trace can't eat the memory
+	static constexpr std::size_t max_events = 1 << 16;
+
+	void push(const trace_event& e);
+	std::vector<trace_event> get_events() const;
+	void clear();
+
+private:
+	mutable std::mutex mutex_;
+	std::vector<trace_event> events_;
+};
+}
+
+//-----------------------------------------------------------------------------
+//  Name : write_chrome_trace ()
+/// <summary>
+/// Writes the events in the chrome://tracing json format, one track per
+/// thread. Timestamps are relative to the given origin.
+/// </summary>
+//-----------------------------------------------------------------------------
+void write_chrome_trace(std::ostream& out, const std::vector<std::string>& thread_names,
+						const std::vector<std::vector<detail::trace_event>>& thread_events,
+						std::chrono::steady_clock::time_point origin);
+}
@@ -1,6 +1,8 @@
 #include "task_system.h"
 #include "../common/platform/thread.hpp"
+#include "../profiling/profiler.h"
 #include <limits>
+#include <string>
 
 namespace core
 {
@@ -8,41 +10,131 @@ namespace core
 task::task_concept::~task_concept() noexcept = default;
 
 task::task_concept::task_concept() noexcept
+	: token_(get_current_cancellation())
 {
 	static std::atomic<std::uint64_t> id = {1};
 	id_ = id++;
 }
 
-void task_system::task_queue::sort()
+void task_system::task_queue::sort(std::deque<task>& lane)
 {
-	if(tasks_.size() > 1)
+	if(lane.size() > 1)
 	{
-		std::stable_partition(tasks_.begin(), tasks_.end(), [](const auto& task1) { return task1.ready(); });
+		std::stable_partition(lane.begin(), lane.end(), [](const auto& task1) { return task1.ready(); });
 	}
 }
 
+std::pair<bool, task> task_system::task_queue::pop_front_ready(std::deque<task>& lane, bool allow_sort)
+{
+	if(lane.empty())
+	{
+		return std::make_pair(false, task{});
+	}
+
+	if(!lane.front().ready())
+	{
+		if(!allow_sort)
+		{
+			return std::make_pair(false, task{});
+		}
+
+		sort(lane);
+
+		// try after sort
+		if(!lane.front().ready())
+		{
+			return std::make_pair(false, task{});
+		}
+	}
+
+	auto t = std::move(lane.front());
+	lane.pop_front();
+	return std::make_pair(true, std::move(t));
+}
+
+std::size_t task_system::task_queue::get_pending_tasks_locked() const
+{
+	std::size_t count = 0;
+	for(const auto& lane : tasks_)
+	{
+		count += lane.size();
+	}
+	return count;
+}
+
+task_system::task_queue::task_queue(queue_backend backend)
+	: backend_(backend)
+{
+}
+
 task_system::task_queue::task_queue(task_system::task_queue&& other) noexcept
 	: tasks_(std::move(other.tasks_))
 	, done_(other.done_.load())
+	, backend_(other.backend_)
+	, deques_(std::move(other.deques_))
+	, inbox_(other.inbox_.exchange(nullptr))
+	, waiting_(std::move(other.waiting_))
+	, pending_(other.pending_.exchange(0))
+	, discard_(other.discard_.load())
+	, owner_id_(other.owner_id_.load())
+{
+}
+
+task_system::task_queue::~task_queue()
+{
+	if(backend_ != queue_backend::lock_free)
+	{
+		return;
+	}
+
+	drain_inbox();
+	for(auto& deque : deques_)
+	{
+		task::task_concept* t = nullptr;
+		while(deque.pop(t))
+		{
+			task discarded(t);
+		}
+	}
+}
+
+void task_system::task_queue::set_owner(std::thread::id id)
 {
+	owner_id_.store(id);
 }
 
 std::size_t task_system::task_queue::get_pending_tasks() const
 {
+	if(backend_ == queue_backend::lock_free)
+	{
+		return discard_ ? 0 : pending_.load();
+	}
+
 	std::lock_guard<std::mutex> lock(mutex_);
-	return tasks_.size();
+	return get_pending_tasks_locked();
 }
 
 void task_system::task_queue::clear()
 {
+	if(backend_ == queue_backend::lock_free)
+	{
+		// the owner may be popping right now, so the tasks are
+		// destroyed with the queue once all threads are joined.
+		discard_ = true;
+		return;
+	}
+
 	std::unique_lock<std::mutex> lock(mutex_);
-	tasks_.clear();
+	for(auto& lane : tasks_)
+	{
+		lane.clear();
+	}
 }
 
 void task_system::task_queue::set_done()
 {
 	done_.store(true);
-	cv_.notify_all();
+	wake_up();
 }
 
 bool task_system::task_queue::is_done() const
@@ -52,25 +144,38 @@ bool task_system::task_queue::is_done() const
 
 std::pair<bool, task> task_system::task_queue::try_pop()
 {
+	if(backend_ == queue_backend::lock_free)
+	{
+		return try_pop_lock_free();
+	}
+
 	std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
 
-	if(!lock || tasks_.empty())
+	if(!lock)
 	{
 		return std::make_pair(false, task{});
 	}
-	if(tasks_.front().ready())
+
+	for(auto& lane : tasks_)
 	{
-		auto t = std::move(tasks_.front());
-		tasks_.pop_front();
-		return std::make_pair(true, std::move(t));
+		auto p = pop_front_ready(lane, true);
+		if(p.first)
+		{
+			return p;
+		}
 	}
 
-	sort();
 	return std::make_pair(false, task{});
 }
 
 bool task_system::task_queue::try_push(task& t)
 {
+	if(backend_ == queue_backend::lock_free)
+	{
+		push_lock_free(std::move(t));
+		return true;
+	}
+
 	{
 		std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
 		if(!lock)
@@ -78,19 +183,25 @@ bool task_system::task_queue::try_push(task& t)
 			return false;
 		}
 
-		tasks_.emplace_back(std::move(t));
+		const auto lane = static_cast<std::size_t>(t.get_priority());
+		tasks_[lane].emplace_back(std::move(t));
 	}
 
 	cv_.notify_one();
 	return true;
 }
 
-std::pair<bool, task> task_system::task_queue::pop(duration_t pop_timeout)
+std::pair<bool, task> task_system::task_queue::pop(duration_t pop_timeout, task_priority lowest)
 {
+	if(backend_ == queue_backend::lock_free)
+	{
+		return pop_lock_free(pop_timeout, lowest);
+	}
+
 	std::unique_lock<std::mutex> lock(mutex_);
 	bool wait = pop_timeout > duration_t(0);
 	bool timed_wait = pop_timeout != duration_t::max();
-	if(wait && tasks_.empty())
+	if(wait && get_pending_tasks_locked() == 0)
 	{
 		if(timed_wait)
 		{
@@ -102,64 +213,249 @@ std::pair<bool, task> task_system::task_queue::pop(duration_t pop_timeout)
 		}
 	}
 
-	if(tasks_.empty())
+	const auto lanes = static_cast<std::size_t>(lowest) + 1;
+	for(std::size_t lane = 0; lane < lanes; ++lane)
 	{
-		return std::make_pair(false, task{});
+		auto p = pop_front_ready(tasks_[lane], true);
+		if(p.first)
+		{
+			return p;
+		}
 	}
 
-	if(tasks_.front().ready())
+	return std::make_pair(false, task{});
+}
+
+void task_system::task_queue::push(task t)
+{
+	if(backend_ == queue_backend::lock_free)
 	{
-		auto t = std::move(tasks_.front());
-		tasks_.pop_front();
-		return std::make_pair(true, std::move(t));
+		push_lock_free(std::move(t));
+		return;
 	}
 
-	sort();
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		const auto lane = static_cast<std::size_t>(t.get_priority());
+		tasks_[lane].emplace_back(std::move(t));
+	}
+	cv_.notify_one();
+}
 
-	// try after sort
-	if(tasks_.front().ready())
+void task_system::task_queue::wake_up()
+{
+	if(backend_ == queue_backend::lock_free)
 	{
-		auto t = std::move(tasks_.front());
-		tasks_.pop_front();
-		return std::make_pair(true, std::move(t));
+		std::lock_guard<std::mutex> lock(mutex_);
 	}
+	cv_.notify_all();
+}
 
-	return std::make_pair(false, task{});
+void task_system::task_queue::push_inbox(task::task_concept* t)
+{
+	auto head = inbox_.load(std::memory_order_relaxed);
+	do
+	{
+		t->next_ = head;
+	} while(!inbox_.compare_exchange_weak(head, t, std::memory_order_release, std::memory_order_relaxed));
 }
 
-void task_system::task_queue::push(task t)
+void task_system::task_queue::drain_inbox()
 {
+	auto head = inbox_.exchange(nullptr, std::memory_order_acquire);
+
+	// the inbox is a stack, reverse it to keep the push order
+	task::task_concept* reversed = nullptr;
+	while(head)
 	{
-		std::unique_lock<std::mutex> lock(mutex_);
-		tasks_.emplace_back(std::move(t));
+		auto next = head->next_;
+		head->next_ = reversed;
+		reversed = head;
+		head = next;
+	}
+
+	while(reversed)
+	{
+		auto next = reversed->next_;
+		reversed->next_ = nullptr;
+		deques_[static_cast<std::size_t>(reversed->priority_)].push(reversed);
+		reversed = next;
 	}
-	cv_.notify_one();
 }
 
-void task_system::task_queue::wake_up()
+bool task_system::task_queue::has_work_lock_free() const
 {
-	cv_.notify_all();
+	if(inbox_.load() != nullptr)
+	{
+		return true;
+	}
+
+	return std::any_of(std::begin(deques_), std::end(deques_),
+					   [](const auto& deque) { return !deque.empty(); });
 }
 
-bool task_system::task_queue::cancel(uint64_t id)
+void task_system::task_queue::push_lock_free(task t)
 {
-	bool res = false;
+	pending_++;
+
+	if(owner_id_.load() == std::this_thread::get_id())
+	{
+		const auto lane = static_cast<std::size_t>(t.get_priority());
+		deques_[lane].push(t.release());
+	}
+	else
+	{
+		push_inbox(t.release());
+	}
+
+	if(sleepers_.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		cv_.notify_one();
+	}
+}
+
+std::pair<bool, task> task_system::task_queue::pop_ready_lock_free(task_priority lowest)
+{
+	drain_inbox();
+
+	// tasks that were not ready last time are checked individually,
+	// nothing gets moved around in the deques.
+	constexpr std::size_t none = std::numeric_limits<std::size_t>::max();
+	std::size_t best = none;
+	for(std::size_t i = 0; i < waiting_.size(); ++i)
+	{
+		const auto& t = waiting_[i];
+		if(t.get_priority() > lowest)
+		{
+			continue;
+		}
+
+		if((best == none || t.get_priority() < waiting_[best].get_priority()) && t.ready())
+		{
+			best = i;
+		}
+	}
+
+	const auto take_waiting = [this](std::size_t idx) {
+		auto t = std::move(waiting_[idx]);
+		waiting_.erase(std::begin(waiting_) + static_cast<std::ptrdiff_t>(idx));
+		pending_--;
+		return std::make_pair(true, std::move(t));
+	};
+
+	const auto lanes = static_cast<std::size_t>(lowest) + 1;
+	for(std::size_t lane = 0; lane < lanes; ++lane)
+	{
+		if(best != none && static_cast<std::size_t>(waiting_[best].get_priority()) <= lane)
+		{
+			return take_waiting(best);
+		}
+
+		task::task_concept* raw = nullptr;
+		while(deques_[lane].pop(raw))
+		{
+			task t(raw);
+			if(t.ready())
+			{
+				pending_--;
+				return std::make_pair(true, std::move(t));
+			}
+
+			waiting_.emplace_back(std::move(t));
+		}
+	}
+
+	if(best != none)
+	{
+		return take_waiting(best);
+	}
+
+	return std::make_pair(false, task{});
+}
+
+std::pair<bool, task> task_system::task_queue::pop_lock_free(duration_t pop_timeout, task_priority lowest)
+{
+	if(discard_)
+	{
+		return std::make_pair(false, task{});
+	}
+
+	auto p = pop_ready_lock_free(lowest);
+	if(p.first)
+	{
+		return p;
+	}
+
+	bool wait = pop_timeout > duration_t(0);
+	if(!wait)
+	{
+		return p;
+	}
+
+	// nothing signals when a waiting task becomes ready, so poll it
+	// at a reasonable rate instead of sleeping for the whole timeout.
+	using namespace std::literals;
+	if(!waiting_.empty())
+	{
+		pop_timeout = std::min<duration_t>(pop_timeout, 1ms);
+	}
+	bool timed_wait = pop_timeout != duration_t::max();
+
 	{
 		std::unique_lock<std::mutex> lock(mutex_);
-		tasks_.erase(std::remove_if(std::begin(tasks_), std::end(tasks_),
-									[id, &res](const auto& task) {
-										auto cmp = task.get_id() == id;
-										if(cmp)
-										{
-											res = true;
-										}
-										return cmp;
-									}),
-					 std::end(tasks_));
+		sleepers_++;
+		const auto wake_condition = [this]() { return has_work_lock_free() || is_done(); };
+		if(timed_wait)
+		{
+			cv_.wait_for(lock, pop_timeout, wake_condition);
+		}
+		else
+		{
+			cv_.wait(lock, wake_condition);
+		}
+		sleepers_--;
+	}
+
+	if(discard_)
+	{
+		return std::make_pair(false, task{});
 	}
-	cv_.notify_one();
 
-	return res;
+	return pop_ready_lock_free(lowest);
+}
+
+std::pair<bool, task> task_system::task_queue::try_pop_lock_free()
+{
+	if(discard_)
+	{
+		return std::make_pair(false, task{});
+	}
+
+	task::task_concept* raw = nullptr;
+	for(auto& deque : deques_)
+	{
+		if(deque.steal(raw))
+		{
+			break;
+		}
+	}
+
+	if(!raw)
+	{
+		return std::make_pair(false, task{});
+	}
+
+	task t(raw);
+	if(t.ready())
+	{
+		pending_--;
+		return std::make_pair(true, std::move(t));
+	}
+
+	// hand it back to the owner, it will keep track of it.
+	push_inbox(t.release());
+	return std::make_pair(false, task{});
 }
 
 void task_system::run(std::size_t idx, const std::function<bool()>& condition, duration_t pop_timeout)
@@ -179,7 +475,11 @@ void task_system::run(std::size_t idx, const std::function<bool()>& condition, d
 		if(idx != 0 && is_empty)
 		{
 			std::size_t steal_attempts = threads_count_;
-			const auto queue_idx = get_most_free_queue_idx(true);
+			// io and compute workers only steal within their own class so that
+			// compute tasks never end up behind blocking calls.
+			const auto queue_idx = is_io_thread_idx(idx)
+									   ? get_queue_idx_in_range(get_io_queues_begin(), threads_count_, true)
+									   : get_most_busy_queue_idx(true);
 			for(std::size_t k = 0; k < steal_attempts; ++k)
 			{
 				if(queue_index != queue_idx)
@@ -191,20 +491,147 @@ void task_system::run(std::size_t idx, const std::function<bool()>& condition, d
 					}
 				}
 			}
+
+			if(queue_index != queue_idx && is_instrumentation_enabled())
+			{
+				counters_[idx].add_steal(p.first);
+			}
 		}
 
 		if(!p.first)
 		{
-			p = queues_[queue_index].pop(pop_timeout);
+			if(is_instrumentation_enabled())
+			{
+				const auto wait_begin = std::chrono::steady_clock::now();
+				p = queues_[queue_index].pop(pop_timeout);
+				if(!p.first)
+				{
+					counters_[idx].add_idle(std::chrono::steady_clock::now() - wait_begin);
+				}
+			}
+			else
+			{
+				p = queues_[queue_index].pop(pop_timeout);
+			}
 		}
 
 		if(p.first)
 		{
-			p.second();
+			execute(idx, p.second);
 		}
 	}
 }
 
+void task_system::enqueue(std::size_t queue_index, task t)
+{
+	if(t.t_ && is_instrumentation_enabled())
+	{
+		t.t_->enqueue_time_ = std::chrono::steady_clock::now();
+	}
+
+	queues_[queue_index].push(std::move(t));
+}
+
+void task_system::execute(std::size_t thread_idx, task& t)
+{
+	if(t.cancelled())
+	{
+		// destroying it breaks its promise
+		t = task();
+		return;
+	}
+
+	PROFILE_SCOPE("task");
+	scoped_cancellation cancellation(t.t_ ? t.t_->token_ : cancellation_token());
+	if(!t.t_ || thread_idx >= threads_count_ || !is_instrumentation_enabled())
+	{
+		t();
+		return;
+	}
+
+	const auto id = t.t_->id_;
+	const auto priority = t.t_->priority_;
+	const auto enqueue_time = t.t_->enqueue_time_;
+	const auto begin = std::chrono::steady_clock::now();
+	auto& counters = counters_[thread_idx];
+
+	// tasks pushed before the instrumentation was enabled have no stamp.
+	if(enqueue_time != std::chrono::steady_clock::time_point{})
+	{
+		counters.add_latency(begin - enqueue_time);
+	}
+
+	t();
+
+	const auto end = std::chrono::steady_clock::now();
+	counters.add_execution(end - begin);
+	if(tracing_.load(std::memory_order_relaxed))
+	{
+		detail::trace_event e;
+		e.task_id = id;
+		e.priority = static_cast<std::uint8_t>(priority);
+		e.begin = begin;
+		e.duration = end - begin;
+		traces_[thread_idx].push(e);
+	}
+}
+
+void task_system::push_job(std::size_t job_index, task t)
+{
+	if(compute_workers_count_ == 0)
+	{
+		enqueue(get_owner_thread_idx(), std::move(t));
+		return;
+	}
+
+	const auto queue_index = 1 + (job_index % compute_workers_count_);
+	enqueue(queue_index, std::move(t));
+}
+
+void task_system::push_owner_job(task t)
+{
+	enqueue(get_owner_thread_idx(), std::move(t));
+}
+
+bool task_system::try_run_one()
+{
+	const auto this_thread_id = std::this_thread::get_id();
+
+	std::pair<bool, task> p = {false, task()};
+	// threads that are not ours are not accounted in the stats.
+	std::size_t thread_idx = threads_count_;
+	for(std::size_t i = 0; i < threads_count_; ++i)
+	{
+		if(get_thread_id(i) == this_thread_id)
+		{
+			thread_idx = i;
+			p = queues_[get_thread_queue_idx(i)].pop(duration_t(0));
+			break;
+		}
+	}
+
+	if(!p.first)
+	{
+		for(std::size_t i = 1; !p.first && i < get_io_queues_begin(); ++i)
+		{
+			p = queues_[i].try_pop();
+		}
+
+		if(thread_idx < threads_count_ && is_instrumentation_enabled())
+		{
+			counters_[thread_idx].add_steal(p.first);
+		}
+	}
+
+	if(p.first)
+	{
+		execute(thread_idx, p.second);
+		return true;
+	}
+
+	return false;
+}
+
 std::size_t task_system::get_thread_queue_idx(std::size_t idx, std::size_t seed)
 {
 	// if owner thread then just return
@@ -223,6 +650,22 @@ std::size_t task_system::get_thread_queue_idx(std::size_t idx, std::size_t seed)
 	return queue_index;
 }
 
+std::size_t task_system::get_queue_idx_in_range(std::size_t begin, std::size_t end, bool most_busy) const
+{
+	std::size_t result = begin;
+	std::size_t result_pending = queues_[begin].get_pending_tasks();
+	for(std::size_t idx = begin + 1; idx < end; ++idx)
+	{
+		const auto pending = queues_[idx].get_pending_tasks();
+		if(most_busy ? pending > result_pending : pending < result_pending)
+		{
+			result = idx;
+			result_pending = pending;
+		}
+	}
+	return result;
+}
+
 std::thread::id task_system::get_thread_id(std::size_t index)
 {
 	const auto& thread = threads_[index];
@@ -232,20 +675,48 @@ std::thread::id task_system::get_thread_id(std::size_t index)
 	return thread_id;
 }
 
+namespace
+{
+task_system::thread_config make_thread_config(std::size_t nthreads, task_system::queue_backend backend)
+{
+	// nthreads counts the owner thread as well.
+	task_system::thread_config config;
+	config.compute_workers = nthreads > 0 ? nthreads - 1 : 0;
+	config.backend = backend;
+	return config;
+}
+}
+
 task_system::task_system(bool wait_on_destruct)
 	: task_system(wait_on_destruct, std::thread::hardware_concurrency())
 {
 }
 
 task_system::task_system(bool wait_on_destruct, std::size_t nthreads)
-	: threads_count_{nthreads}
+	: task_system(wait_on_destruct, nthreads, queue_backend::locking)
+{
+}
+
+task_system::task_system(bool wait_on_destruct, std::size_t nthreads, queue_backend backend)
+	: task_system(wait_on_destruct, make_thread_config(nthreads, backend))
+{
+}
+
+task_system::task_system(bool wait_on_destruct, const thread_config& config)
+	: threads_count_{1 + config.compute_workers + config.io_workers}
+	, compute_workers_count_(config.compute_workers)
+	, io_workers_count_(config.io_workers)
 	, wait_on_destruct_(wait_on_destruct)
 {
+	counters_ = std::make_unique<detail::thread_counters[]>(threads_count_);
+	traces_ = std::make_unique<detail::trace_buffer[]>(threads_count_);
+
 	queues_.reserve(threads_count_);
-	queues_.emplace_back();
+	queues_.emplace_back(config.backend);
+	queues_.back().set_owner(owner_thread_id_);
 	for(std::size_t th = 1; th < threads_count_; ++th)
 	{
-		queues_.emplace_back();
+		queues_.emplace_back(config.backend);
 	}
 
 	// two seperate loops.
@@ -254,8 +725,63 @@ task_system::task_system(bool wait_on_destruct, std::size_t nthreads)
 	using namespace std::literals;
 	for(std::size_t th = 1; th < threads_count_; ++th)
 	{
-		threads_.emplace_back(&task_system::run, this, th, []() { return true; }, 50ms);
-		platform::set_thread_name(threads_.back(), "task_worker");
+		threads_.emplace_back([this, th]() {
+			queues_[th].set_owner(std::this_thread::get_id());
+			run(th, []() { return true; }, 50ms);
+		});
+	}
+
+	place_worker_threads(config);
+}
+
+void task_system::place_worker_threads(const thread_config& config)
+{
+	auto masks = config.affinity_masks;
+	if(masks.empty() && config.pin_compute_workers)
+	{
+		// one logical cpu of every core first, then their smt siblings.
+		const auto cores = platform::get_cpu_cores();
+		const auto first_core = std::min(config.reserved_cores, cores.size());
+		std::vector<std::uint32_t> cpus;
+		for(std::size_t sibling = 0;; ++sibling)
+		{
+			const auto cpus_count = cpus.size();
+			for(std::size_t core = first_core; core < cores.size(); ++core)
+			{
+				if(sibling < cores[core].size() && cores[core][sibling] < 64)
+				{
+					cpus.push_back(cores[core][sibling]);
+				}
+			}
+
+			if(cpus.size() == cpus_count)
+			{
+				break;
+			}
+		}
+
+		for(std::size_t i = 0; !cpus.empty() && i < compute_workers_count_; ++i)
+		{
+			masks.push_back(std::uint64_t(1) << cpus[i % cpus.size()]);
+		}
+	}
+
+	thread_names_.reserve(threads_count_);
+	thread_names_.emplace_back("owner");
+	profiling::set_thread_name(owner_thread_id_, thread_names_.back());
+	for(std::size_t th = 1; th < threads_count_; ++th)
+	{
+		const bool is_io = is_io_thread_idx(th);
+		const auto number = is_io ? th - get_io_queues_begin() : th - 1;
+		thread_names_.emplace_back(std::string(is_io ? "task_io_" : "task_worker_") + std::to_string(number));
+		platform::set_thread_name(threads_[th], thread_names_.back().c_str());
+		profiling::set_thread_name(threads_[th].get_id(), thread_names_.back());
+
+		const auto mask_idx = th - 1;
+		if(mask_idx < masks.size() && masks[mask_idx] != 0)
+		{
+			platform::set_thread_affinity(threads_[th], masks[mask_idx]);
+		}
 	}
 }
 
@@ -287,6 +813,8 @@ void task_system::run_on_owner_thread(duration_t max_duration)
 	auto now = std::chrono::steady_clock::now();
 	auto end = now + max_duration;
 
+	// set when a task finished past the end of the budget
+	bool overrun = false;
 	while(now < end)
 	{
 		auto p = queues_[queue_index].pop(0ms);
@@ -297,11 +825,86 @@ void task_system::run_on_owner_thread(duration_t max_duration)
 
 		if(p.first)
 		{
-			p.second();
+			execute(queue_index, p.second);
 		}
 
 		now = std::chrono::steady_clock::now();
+		overrun = now > end;
+	}
+
+	// out of budget, but critical work can't wait for the next frame.
+	for(;;)
+	{
+		auto p = queues_[queue_index].pop(0ms, task_priority::critical);
+		if(!p.first)
+		{
+			break;
+		}
+
+		execute(queue_index, p.second);
+		overrun = true;
+	}
+
+	if(overrun && is_instrumentation_enabled())
+	{
+		counters_[queue_index].add_budget_overrun(std::chrono::steady_clock::now() - end);
+	}
+}
+
+void task_system::set_instrumentation_enabled(bool enabled)
+{
+	instrumentation_enabled_ = enabled;
+	if(!enabled)
+	{
+		tracing_ = false;
+	}
+}
+
+scheduler_stats task_system::get_stats() const
+{
+	scheduler_stats stats;
+	stats.threads.reserve(threads_count_);
+	for(std::size_t i = 0; i < threads_count_; ++i)
+	{
+		stats.threads.emplace_back(counters_[i].get_stats());
+	}
+	return stats;
+}
+
+void task_system::reset_stats()
+{
+	for(std::size_t i = 0; i < threads_count_; ++i)
+	{
+		counters_[i].reset();
+	}
+}
+
+void task_system::start_trace()
+{
+	tracing_ = false;
+	for(std::size_t i = 0; i < threads_count_; ++i)
+	{
+		traces_[i].clear();
+	}
+	trace_origin_ = std::chrono::steady_clock::now();
+	instrumentation_enabled_ = true;
+	tracing_ = true;
+}
+
+void task_system::stop_trace()
+{
+	tracing_ = false;
+}
+
+void task_system::write_trace(std::ostream& out) const
+{
+	std::vector<std::vector<detail::trace_event>> events;
+	events.reserve(threads_count_);
+	for(std::size_t i = 0; i < threads_count_; ++i)
+	{
+		events.emplace_back(traces_[i].get_events());
 	}
+	write_chrome_trace(out, thread_names_, events, trace_origin_);
 }
 
 task_system::system_info task_system::get_info() const
@@ -1,8 +1,13 @@
 #ifndef TASK_SYSTEM_H
 #define TASK_SYSTEM_H
 
+#include "cancellation_token.h"
+#include "future_state.hpp"
 #include "future_traits.hpp"
+#include "task_stats.h"
+#include "work_stealing_deque.hpp"
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
@@ -13,6 +18,8 @@
 #include <future>
 #include <memory>
 #include <mutex>
+#include <ostream>
+#include <string>
 #include <thread>
 #include <type_traits>
 #include <utility>
@@ -22,25 +29,65 @@ namespace core
 {
 class task_system;
 
+//-----------------------------------------------------------------------------
+/// Priority classes of the tasks. Each queue serves them in this order.
+/// critical   - must run as soon as possible, ignores the owner thread budget.
+/// frame      - work needed for the current frames. The default.
+/// background - streaming and uploads that may be spread over many frames.
+/// idle       - only runs when nothing else is queued.
+//-----------------------------------------------------------------------------
+enum class task_priority : std::uint8_t
+{
+	critical,
+	frame,
+	background,
+	idle
+};
+constexpr std::size_t task_priorities_count = 4;
+
 template <typename T>
 class task_future
 {
 public:
-	decltype(auto) get() const
+	decltype(auto) get() const&
 	{
+		if(!state_)
+		{
+			throw std::future_error(std::future_errc::no_state);
+		}
+
 		wait();
 
-		return future_.get();
+		return state_->get();
 	}
 
-	decltype(auto) valid() const
+	//-----------------------------------------------------------------------------
+	//  Name : get ()
+	/// <summary>
+	/// Gets the result from an expiring future. The value is moved out when
+	/// this is the last reference to it, e.g. when an awaitable task consumes
+	/// the result of its only predecessor, and copied otherwise.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	decltype(auto) get() &&
 	{
-		return future_.valid();
+		if(!state_)
+		{
+			throw std::future_error(std::future_errc::no_state);
+		}
+
+		wait();
+
+		return detail::take_value(state_);
+	}
+
+	bool valid() const
+	{
+		return static_cast<bool>(state_);
 	}
 	bool is_ready() const
 	{
-		using namespace std::chrono_literals;
-		return valid() && wait_for(0s) == std::future_status::ready;
+		return valid() && state_->is_ready();
 	}
 
 	//-----------------------------------------------------------------------------
@@ -54,26 +101,34 @@ public:
 	//-----------------------------------------------------------------------------
 	void wait() const;
 
+	//-----------------------------------------------------------------------------
+	//  Name : cancel ()
+	/// <summary>
+	/// Asks for the task to be dropped when it is popped, which breaks the
+	/// future. Does not wait and does not look for the task in the queues, a
+	/// task already running or done is left to finish.
+	/// </summary>
+	//-----------------------------------------------------------------------------
 	void cancel() const;
 
 	template <class Rep, class Per>
 	std::future_status wait_for(const std::chrono::duration<Rep, Per>& rel_time) const
 	{
 		// wait for duration
-		return future_.wait_for(rel_time);
+		return state_->wait_for(rel_time);
 	}
 
 	template <class Clock, class Dur>
 	std::future_status wait_until(const std::chrono::time_point<Clock, Dur>& abs_time) const
 	{
 		// wait until time point
-		return future_.wait_until(abs_time);
+		return state_->wait_until(abs_time);
 	}
 
-	static task_future<T> from_shared_future(std::shared_future<T>&& fut, std::uint64_t id = 0)
+	static task_future<T> from_state(detail::future_state_ptr<T> state, std::uint64_t id = 0)
 	{
 		task_future<T> res;
-		res.future_ = std::move(fut);
+		res.state_ = std::move(state);
 		res.id_ = id;
 		return res;
 	}
@@ -90,19 +145,19 @@ public:
 
 private:
 	friend class task_system;
-	std::shared_future<T> future_;
+	detail::future_state_ptr<T> state_;
 	task_system* executor_ = nullptr;
 	std::uint64_t id_ = 0;
 };
 
 /*
- * awaitable_task; a type-erased, std::packaged_task that
+ * task; a type-erased callable with its result state that
  * also contains its own arguments.
  *
  * There are two forms of tasks: ready tasks and awaitable tasks.
  *
  *      Ready tasks are assumed to be immediately invokable; that is,
- *      invoking the underlying pakcaged_task with the provided arguments
+ *      invoking the underlying callable with the provided arguments
  *      will not block. This is contrasted with awaitable tasks where some or
  *      all of the provided arguments may be futures waiting on results of
  *      other tasks.
@@ -114,8 +169,12 @@ private:
  *
  * There are two helper methods for creating task objects:
  * make_ready_task and make_awaitable_task, both of which return a pair of
- * the newly constructed task and a std::future object to the
+ * the newly constructed task and a task_future object to the
  * return value.
+ *
+ * The models and the future states are allocated from the task memory
+ * pools, so pushing a task does not hit the heap once the pools are warm.
+ * A model that is destroyed without being invoked breaks its promise.
  */
 
 template <typename T>
@@ -123,12 +182,6 @@ using is_future = async::detail::is_future<T>;
 
 class task
 {
-	template <typename T>
-	using decay_future_t = async::detail::decay_future_t<T>;
-
-	template <class T>
-	using decay_if_future_t = typename std::conditional<is_future<T>::value, decay_future_t<T>, T>::type;
-
 	template <typename F, typename... Args>
 	using invoke_result_t = typename nonstd::function_traits<F>::result_type;
 
@@ -138,6 +191,9 @@ class task
 	struct awaitable_task_tag
 	{
 	};
+	struct job_task_tag
+	{
+	};
 
 public:
 	task() = default;
@@ -164,10 +220,12 @@ public:
 	{
 		using invoke_res = invoke_result_t<F, Args...>;
 		using pair_type = std::pair<task, task_future<invoke_res>>;
-		using model_type = ready_task_model<invoke_res(Args...)>;
+		using model_type = ready_task_model<std::decay_t<F>, invoke_res, Args...>;
 
-		task t(ready_task_tag(), std::forward<F>(f), std::forward<Args>(args)...);
-		auto fut = static_cast<model_type&>(*t.t_).get_future();
+		auto state = detail::future_state_ptr<invoke_res>::create();
+		auto model = new model_type(state, std::forward<F>(f), std::forward<Args>(args)...);
+		task t(model);
+		auto fut = task_future<invoke_res>::from_state(std::move(state), model->id_);
 		return pair_type(std::move(t), std::move(fut));
 	}
 
@@ -176,13 +234,29 @@ public:
 	{
 		using invoke_res = invoke_result_t<F, Args...>;
 		using pair_type = std::pair<task, task_future<invoke_res>>;
-		using model_type = awaitable_task_model<invoke_res(decay_if_future_t<Args>...), Args...>;
+		using model_type = awaitable_task_model<std::decay_t<F>, invoke_res, Args...>;
 
-		task t(awaitable_task_tag(), std::forward<F>(f), std::forward<Args>(args)...);
-		auto fut = static_cast<model_type&>(*t.t_).get_future();
+		auto state = detail::future_state_ptr<invoke_res>::create();
+		auto model = new model_type(state, std::forward<F>(f), std::forward<Args>(args)...);
+		task t(model);
+		auto fut = task_future<invoke_res>::from_state(std::move(state), model->id_);
 		return pair_type(std::move(t), std::move(fut));
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : make_job_task ()
+	/// <summary>
+	/// Creates a fire and forget task with no future attached. Used by
+	/// task_group and the parallel algorithms which track completion
+	/// themselves and don't want to pay for a shared state per item.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <class F>
+	static task make_job_task(F&& f)
+	{
+		return task(new job_task_model<std::decay_t<F>>(std::forward<F>(f)));
+	}
+
 	void operator()()
 	{
 		if(t_)
@@ -191,15 +265,21 @@ public:
 		}
 	}
 
+	/// a cancelled task is ready to be dropped
 	bool ready() const
 	{
 		if(t_)
 		{
-			return t_->ready_();
+			return t_->cancelled_() || t_->ready_();
 		}
 
 		return false;
 	}
+
+	bool cancelled() const
+	{
+		return t_ && t_->cancelled_();
+	}
 	std::uint64_t get_id() const
 	{
 		if(t_)
@@ -210,61 +290,156 @@ public:
 		return 0;
 	}
 
+	task_priority get_priority() const
+	{
+		if(t_)
+		{
+			return t_->priority_;
+		}
+
+		return task_priority::frame;
+	}
+
+	void set_priority(task_priority priority)
+	{
+		if(t_)
+		{
+			t_->priority_ = priority;
+		}
+	}
+
 private:
-	template <class F, class... Args>
-	task(ready_task_tag /*unused*/, F&& f, Args&&... args) noexcept
-		: t_(new ready_task_model<invoke_result_t<F, Args...>(Args...)>(std::forward<F>(f),
-																		std::forward<Args>(args)...))
+	friend class task_system;
+
+	struct task_concept;
+
+	explicit task(task_concept* t) noexcept
+		: t_(t)
 	{
 	}
 
-	template <class F, class... Args>
-	task(awaitable_task_tag /*unused*/, F&& f, Args&&... args) noexcept
-		: t_(new awaitable_task_model<invoke_result_t<F, Args...>(decay_if_future_t<Args>...), Args...>(
-			  std::forward<F>(f), std::forward<Args>(args)...))
+	task_concept* release() noexcept
 	{
+		return t_.release();
 	}
 
-	struct task_concept
+	struct task_concept : detail::task_pooled
 	{
 		task_concept() noexcept;
 		virtual ~task_concept() noexcept;
 		virtual void invoke_() = 0;
 		virtual bool ready_() const noexcept = 0;
+		virtual bool cancelled_() const noexcept
+		{
+			return token_.is_cancelled();
+		}
 		std::uint64_t id_ = 0;
+		/// the token current on the thread that created the task.
+		cancellation_token token_;
+		/// intrusive link used by the lock-free queues' inbox.
+		task_concept* next_ = nullptr;
+		task_priority priority_ = task_priority::frame;
+		/// set on push while the task_system instrumentation is enabled.
+		std::chrono::steady_clock::time_point enqueue_time_{};
 	};
 
-	template <class>
-	struct ready_task_model;
+	//-----------------------------------------------------------------------------
+	//  Name : result_task_model ()
+	/// <summary>
+	/// Common part of the models that produce a result. Owns a reference to
+	/// the future state and breaks the promise if never invoked.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <class R>
+	struct result_task_model : task_concept
+	{
+		explicit result_task_model(detail::future_state_ptr<R> state) noexcept
+			: state_(std::move(state))
+		{
+		}
+
+		~result_task_model() noexcept override
+		{
+			if(!invoked_)
+			{
+				state_->set_broken_promise();
+			}
+		}
+
+		template <class F>
+		void fulfill(F&& f)
+		{
+			invoked_ = true;
+			detail::fulfill(*state_.operator->(), std::forward<F>(f));
+			// leave the result to the futures so that a single consumer can move it.
+			state_ = {};
+		}
+
+		bool cancelled_() const noexcept override
+		{
+			return (state_ && state_->is_cancel_requested()) || task_concept::cancelled_();
+		}
+
+	private:
+		detail::future_state_ptr<R> state_;
+		bool invoked_ = false;
+	};
 
 	//-----------------------------------------------------------------------------
 	//  Name : ready_task_model ()
 	/// <summary>
 	/// Ready tasks are assumed to be immediately invokable, that is,
-	/// invoking the underlying pakcaged_task with the provided arguments
+	/// invoking the underlying callable with the provided arguments
 	/// will not block. This is contrasted with async tasks where some or all
 	/// of the provided arguments may be futures waiting on results of other
 	/// tasks.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	template <class R, class... Args>
-	struct ready_task_model<R(Args...)> : task_concept
+	template <class F, class R, class... Args>
+	struct ready_task_model : result_task_model<R>
 	{
-		template <class F>
-		explicit ready_task_model(F&& f, Args&&... args) noexcept
-			: f_(std::forward<F>(f))
+		template <class U>
+		explicit ready_task_model(detail::future_state_ptr<R> state, U&& f, Args&&... args) noexcept
+			: result_task_model<R>(std::move(state))
+			, f_(std::forward<U>(f))
 			, args_(std::forward<Args>(args)...)
 		{
 		}
 
-		task_future<R> get_future()
+		void invoke_() override
+		{
+			this->fulfill([this]() -> decltype(auto) { return nonstd::apply(f_, std::move(args_)); });
+		}
+
+		bool ready_() const noexcept override
+		{
+			return true;
+		}
+
+	private:
+		F f_;
+		std::tuple<nonstd::special_decay_t<Args>...> args_;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : job_task_model ()
+	/// <summary>
+	/// Job tasks are always ready and carry no result. Whoever pushes them is
+	/// responsible for tracking their completion.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <class F>
+	struct job_task_model : task_concept
+	{
+		template <class U>
+		explicit job_task_model(U&& f)
+			: f_(std::forward<U>(f))
 		{
-			return task_future<R>::from_shared_future(f_.get_future().share(), id_);
 		}
 
 		void invoke_() override
 		{
-			nonstd::apply(f_, args_);
+			f_();
 		}
 
 		bool ready_() const noexcept override
@@ -272,49 +447,41 @@ private:
 			return true;
 		}
 
+		// whoever tracks the job waits for it to run, it is never dropped
+		bool cancelled_() const noexcept override
+		{
+			return false;
+		}
+
 	private:
-		std::packaged_task<R(Args...)> f_;
-		std::tuple<nonstd::special_decay_t<Args>...> args_;
+		F f_;
 	};
 
-	template <class...>
-	struct awaitable_task_model;
-
 	//-----------------------------------------------------------------------------
 	//  Name : awaitable_task_model ()
 	/// <summary>
 	/// Async tasks are assumed to take arguments where some or all are
 	/// backed by futures waiting on results of other tasks. This is
 	/// contrasted with ready tasks that are assumed to be immediately
-	/// invokable.
+	/// invokable. An error in one of the awaited futures is forwarded to
+	/// this task's future.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	template <class R, class... CallArgs, class... FutArgs>
-	struct awaitable_task_model<R(CallArgs...), FutArgs...> : task_concept
+	template <class F, class R, class... FutArgs>
+	struct awaitable_task_model : result_task_model<R>
 	{
-		template <class F, class... Args>
-		explicit awaitable_task_model(F&& f, Args&&... args) noexcept
-			: f_(std::forward<F>(f))
+		template <class U, class... Args>
+		explicit awaitable_task_model(detail::future_state_ptr<R> state, U&& f, Args&&... args) noexcept
+			: result_task_model<R>(std::move(state))
+			, f_(std::forward<U>(f))
 			, args_(std::forward<Args>(args)...)
 		{
 		}
 
-		task_future<R> get_future()
-		{
-			return task_future<R>::from_shared_future(f_.get_future().share(), id_);
-		}
-
 		void invoke_() override
 		{
 			constexpr const std::size_t arity = sizeof...(FutArgs);
-			try
-			{
-				do_invoke_(std::make_index_sequence<arity>());
-			}
-			catch(const std::future_error& e)
-			{
-				(void)e;
-			}
+			this->fulfill([this]() -> decltype(auto) { return do_invoke_(std::make_index_sequence<arity>()); });
 		}
 
 		bool ready_() const noexcept override
@@ -333,20 +500,13 @@ private:
 		template <typename T, typename std::enable_if_t<is_future<T>::value>* = nullptr>
 		static inline decltype(auto) call_get(T&& t)
 		{
-			return t.get();
+			return std::forward<T>(t).get();
 		}
 
 		template <std::size_t... I>
-		inline void do_invoke_(std::index_sequence<I...> /*unused*/)
+		inline decltype(auto) do_invoke_(std::index_sequence<I...> /*unused*/)
 		{
-			try
-			{
-				nonstd::invoke(f_, call_get(std::get<I>(std::move(args_)))...);
-			}
-			catch(const std::future_error& e)
-			{
-				(void)e;
-			}
+			return nonstd::invoke(f_, call_get(std::get<I>(std::move(args_)))...);
 		}
 
 		template <typename T, typename std::enable_if_t<!is_future<T>::value>* = nullptr>
@@ -354,12 +514,11 @@ private:
 		{
 			return true;
 		}
-            
+
 		template <typename T, typename std::enable_if_t<is_future<T>::value>* = nullptr>
 		static inline bool call_ready(const T& t) noexcept
 		{
-			using namespace std::chrono_literals;
-			return t.valid() && t.wait_for(0s) == std::future_status::ready;
+			return t.is_ready();
 		}
 
 		template <std::size_t... I>
@@ -368,18 +527,21 @@ private:
 			return nonstd::check_all_true(call_ready(std::get<I>(args_))...);
 		}
 
-		std::packaged_task<R(CallArgs...)> f_;
+		F f_;
 		std::tuple<nonstd::special_decay_t<FutArgs>...> args_;
 	};
 
 	std::unique_ptr<task_concept> t_;
 };
 
+class task_group;
+
 class task_system
 {
 	using duration_t = std::chrono::steady_clock::duration;
 	template <typename T>
 	friend class task_future;
+	friend class task_group;
 
 public:
 	struct queue_info
@@ -392,10 +554,49 @@ public:
 		std::vector<queue_info> queue_infos;
 	};
 
+	//-----------------------------------------------------------------------------
+	/// The storage used by the per thread queues.
+	/// locking  - a std::deque guarded by a mutex.
+	/// lock_free - a Chase-Lev work stealing deque. The owning thread pushes and
+	///             pops at the bottom, thieves steal from the top and pushes from
+	///             other threads go through a lock-free inbox.
+	//-----------------------------------------------------------------------------
+	enum class queue_backend
+	{
+		locking,
+		lock_free
+	};
+
+	//-----------------------------------------------------------------------------
+	/// How many worker threads are created and where they are placed.
+	/// The queues are laid out as [owner, compute workers..., io workers...].
+	//-----------------------------------------------------------------------------
+	struct thread_config
+	{
+		/// workers executing cpu bound tasks, the owner thread is not counted.
+		std::size_t compute_workers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+		/// workers for blocking calls like file reads. they never run or steal
+		/// compute tasks and compute workers never steal from them.
+		std::size_t io_workers = 0;
+		queue_backend backend = queue_backend::locking;
+		/// pin every compute worker to a single logical cpu. the physical cores
+		/// are filled before their smt siblings.
+		bool pin_compute_workers = false;
+		/// physical cores left for the owner, render, audio etc. when pinning.
+		std::size_t reserved_cores = 1;
+		/// explicit affinity masks, compute workers first then io workers.
+		/// a zero mask leaves the thread as is. overrides pin_compute_workers.
+		std::vector<std::uint64_t> affinity_masks;
+	};
+
 	task_system(bool wait_on_destruct);
 
 	task_system(bool wait_on_destruct, std::size_t nthreads);
 
+	task_system(bool wait_on_destruct, std::size_t nthreads, queue_backend backend);
+
+	task_system(bool wait_on_destruct, const thread_config& config);
+
 	//-----------------------------------------------------------------------------
 	//  Name : ~task_system ()
 	/// <summary>
@@ -407,12 +608,67 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : run_on_owner_thread ()
 	/// <summary>
-	/// Process owner thread tasks
+	/// Process owner thread tasks in priority order while within max_duration.
+	/// Ready critical tasks are always processed, even past the budget.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void run_on_owner_thread(duration_t max_duration = duration_t(0));
 
 	system_info get_info() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_instrumentation_enabled ()
+	/// <summary>
+	/// Enables collecting the scheduler stats. It costs two clock reads per
+	/// task so it is disabled by default.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_instrumentation_enabled(bool enabled);
+
+	bool is_instrumentation_enabled() const
+	{
+		return instrumentation_enabled_.load(std::memory_order_relaxed);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_stats ()
+	/// <summary>
+	/// Returns a snapshot of the per thread scheduler counters.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	scheduler_stats get_stats() const;
+
+	void reset_stats();
+
+	//-----------------------------------------------------------------------------
+	//  Name : start_trace ()
+	/// <summary>
+	/// Starts recording every executed task, discarding a previous trace.
+	/// Enables the instrumentation as well.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void start_trace();
+
+	void stop_trace();
+
+	//-----------------------------------------------------------------------------
+	//  Name : write_trace ()
+	/// <summary>
+	/// Writes the recorded trace in the chrome://tracing json format.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void write_trace(std::ostream& out) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_thread_name ()
+	/// <summary>
+	/// Gets the name of the thread by index, as set for profilers.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const std::string& get_thread_name(std::size_t idx) const
+	{
+		return thread_names_[idx];
+	}
 	//-----------------------------------------------------------------------------
 	//  Name : get_owner_thread_idx ()
 	/// <summary>
@@ -438,6 +694,56 @@ public:
 		return get_most_free_queue_idx(true);
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_any_io_thread_idx ()
+	/// <summary>
+	/// Gets the least loaded io thread id. Falls back to a compute worker if
+	/// the system has no io threads.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t get_any_io_thread_idx() const
+	{
+		if(io_workers_count_ == 0)
+		{
+			return get_any_worker_thread_idx();
+		}
+
+		return get_queue_idx_in_range(get_io_queues_begin(), threads_count_, false);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_compute_workers_count ()
+	/// <summary>
+	/// Number of compute worker threads, the owner thread is not counted.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t get_compute_workers_count() const
+	{
+		return compute_workers_count_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_io_workers_count ()
+	/// <summary>
+	/// Number of io worker threads.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t get_io_workers_count() const
+	{
+		return io_workers_count_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_io_thread_idx ()
+	/// <summary>
+	/// Checks if the thread index belongs to an io worker.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool is_io_thread_idx(std::size_t idx) const
+	{
+		return idx >= get_io_queues_begin() && idx < threads_count_;
+	}
+
 	//-----------------------------------------------------------------------------
 	//  Name : get_most_busy_queue_idx ()
 	/// <summary>
@@ -447,19 +753,12 @@ public:
 	//-----------------------------------------------------------------------------
 	std::size_t get_most_busy_queue_idx(bool skip_owner) const
 	{
-		if(threads_count_ == 1)
+		if(compute_workers_count_ == 0)
 		{
 			return get_owner_thread_idx();
 		}
 
-		auto info = get_info();
-		auto begin_it = skip_owner ? std::begin(info.queue_infos) + 1 : std::begin(info.queue_infos);
-		auto end_it = std::end(info.queue_infos);
-		auto min_el = std::min_element(begin_it, end_it, [](const auto& lhs, const auto& rhs) {
-			return lhs.pending_tasks > rhs.pending_tasks;
-		});
-		const std::size_t idx = static_cast<std::size_t>(std::distance(std::begin(info.queue_infos), min_el));
-		return idx;
+		return get_queue_idx_in_range(skip_owner ? 1 : 0, get_io_queues_begin(), true);
 	}
 
 	//-----------------------------------------------------------------------------
@@ -471,19 +770,12 @@ public:
 	//-----------------------------------------------------------------------------
 	std::size_t get_most_free_queue_idx(bool skip_owner) const
 	{
-		if(threads_count_ == 1)
+		if(compute_workers_count_ == 0)
 		{
 			return get_owner_thread_idx();
 		}
 
-		auto info = get_info();
-		auto begin_it = skip_owner ? std::begin(info.queue_infos) + 1 : std::begin(info.queue_infos);
-		auto end_it = std::end(info.queue_infos);
-		auto min_el = std::min_element(begin_it, end_it, [](const auto& lhs, const auto& rhs) {
-			return lhs.pending_tasks < rhs.pending_tasks;
-		});
-		const std::size_t idx = static_cast<std::size_t>(std::distance(std::begin(info.queue_infos), min_el));
-		return idx;
+		return get_queue_idx_in_range(skip_owner ? 1 : 0, get_io_queues_begin(), false);
 	}
 	//-----------------------------------------------------------------------------
 	//  Name : push_on_thread ()
@@ -494,9 +786,54 @@ public:
 	//-----------------------------------------------------------------------------
 	template <class F, class... Args>
 	decltype(auto) push_on_thread(const std::size_t idx, F&& f, Args&&... args)
+	{
+		return push_on_thread_with_priority(task_priority::frame, idx, std::forward<F>(f),
+											std::forward<Args>(args)...);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : push_on_thread_with_priority ()
+	/// <summary>
+	/// Pushes a task with the given priority class to a specific thread to be
+	/// executed when it can. Either a ready task or an awaitable one
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <class F, class... Args>
+	decltype(auto) push_on_thread_with_priority(task_priority priority, const std::size_t idx, F&& f,
+												Args&&... args)
 	{
 		using is_ready_task = nonstd::conjunction<nonstd::negation<is_future<Args>>...>;
-		return push_impl(is_ready_task(), idx, false, std::forward<F>(f), std::forward<Args>(args)...);
+		return push_impl(is_ready_task(), idx, false, priority, std::forward<F>(f),
+						 std::forward<Args>(args)...);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : push_on_worker_thread_with_priority ()
+	/// <summary>
+	/// Pushes a task with the given priority class to a worker thread.
+	/// Either a ready task or an awaitable one
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <class F, class... Args>
+	decltype(auto) push_on_worker_thread_with_priority(task_priority priority, F&& f, Args&&... args)
+	{
+		const std::size_t idx = get_any_worker_thread_idx();
+		return push_on_thread_with_priority(priority, idx, std::forward<F>(f), std::forward<Args>(args)...);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : push_on_owner_thread_with_priority ()
+	/// <summary>
+	/// Pushes a task with the given priority class to the owner thread.
+	/// E.g. background for uploads that can be spread over several frames.
+	/// Either a ready task or an awaitable one
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <class F, class... Args>
+	decltype(auto) push_on_owner_thread_with_priority(task_priority priority, F&& f, Args&&... args)
+	{
+		const std::size_t idx = get_owner_thread_idx();
+		return push_on_thread_with_priority(priority, idx, std::forward<F>(f), std::forward<Args>(args)...);
 	}
 
 	//-----------------------------------------------------------------------------
@@ -513,6 +850,36 @@ public:
 		return push_on_thread(idx, std::forward<F>(f), std::forward<Args>(args)...);
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : push_on_io_thread ()
+	/// <summary>
+	/// Pushes a task to an io thread to be executed when it can. Meant for
+	/// tasks that block, e.g. reading a file, so that they do not occupy
+	/// the compute workers.
+	/// Either a ready task or an awaitable one
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <class F, class... Args>
+	decltype(auto) push_on_io_thread(F&& f, Args&&... args)
+	{
+		const std::size_t idx = get_any_io_thread_idx();
+		return push_on_thread(idx, std::forward<F>(f), std::forward<Args>(args)...);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : push_on_io_thread_with_priority ()
+	/// <summary>
+	/// Pushes a task with the given priority class to an io thread.
+	/// Either a ready task or an awaitable one
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <class F, class... Args>
+	decltype(auto) push_on_io_thread_with_priority(task_priority priority, F&& f, Args&&... args)
+	{
+		const std::size_t idx = get_any_io_thread_idx();
+		return push_on_thread_with_priority(priority, idx, std::forward<F>(f), std::forward<Args>(args)...);
+	}
+
 	//-----------------------------------------------------------------------------
 	//  Name : push_on_owner_thread ()
 	/// <summary>
@@ -543,7 +910,8 @@ public:
 	decltype(auto) push_or_execute_on_thread(const std::size_t idx, F&& f, Args&&... args)
 	{
 		using is_ready_task = nonstd::conjunction<nonstd::negation<is_future<Args>>...>;
-		return push_impl(is_ready_task(), idx, true, std::forward<F>(f), std::forward<Args>(args)...);
+		return push_impl(is_ready_task(), idx, true, task_priority::frame, std::forward<F>(f),
+						 std::forward<Args>(args)...);
 	}
 
 	//-----------------------------------------------------------------------------
@@ -581,6 +949,43 @@ public:
 	}
 
 private:
+	std::size_t get_io_queues_begin() const
+	{
+		return 1 + compute_workers_count_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_queue_idx_in_range ()
+	/// <summary>
+	/// Gets the most busy or the most free queue in [begin, end).
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t get_queue_idx_in_range(std::size_t begin, std::size_t end, bool most_busy) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : enqueue ()
+	/// <summary>
+	/// Pushes the task to the queue, stamping it for the latency stats.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void enqueue(std::size_t queue_index, task t);
+
+	//-----------------------------------------------------------------------------
+	//  Name : execute ()
+	/// <summary>
+	/// Executes the task on the calling thread, accounting it to the given thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void execute(std::size_t thread_idx, task& t);
+
+	//-----------------------------------------------------------------------------
+	//  Name : place_worker_threads ()
+	/// <summary>
+	/// Names the worker threads and applies the affinity of the config.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void place_worker_threads(const thread_config& config);
+
 	//-----------------------------------------------------------------------------
 	//  Name : push_impl ()
 	/// <summary>
@@ -593,11 +998,11 @@ private:
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	template <class F, class... Args>
-	decltype(auto) push_impl(std::true_type /*unused*/, std::size_t idx, bool execute_if_ready, F&& f,
-							 Args&&... args)
+	decltype(auto) push_impl(std::true_type /*unused*/, std::size_t idx, bool execute_if_ready,
+							 task_priority priority, F&& f, Args&&... args)
 	{
 		return push_task(task::make_ready_task(std::forward<F>(f), std::forward<Args>(args)...), idx,
-						 execute_if_ready);
+						 execute_if_ready, priority);
 	}
 
 	//-----------------------------------------------------------------------------
@@ -610,11 +1015,11 @@ private:
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	template <class F, class... Args>
-	decltype(auto) push_impl(std::false_type /*unused*/, std::size_t idx, bool execute_if_ready, F&& f,
-							 Args&&... args)
+	decltype(auto) push_impl(std::false_type /*unused*/, std::size_t idx, bool execute_if_ready,
+							 task_priority priority, F&& f, Args&&... args)
 	{
 		return push_task(task::make_awaitable_task(std::forward<F>(f), std::forward<Args>(args)...), idx,
-						 execute_if_ready);
+						 execute_if_ready, priority);
 	}
 
 	//-----------------------------------------------------------------------------
@@ -632,41 +1037,52 @@ private:
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	template <typename T>
-	auto push_task(T&& t, std::size_t idx, bool execute_if_ready) ->
+	auto push_task(T&& t, std::size_t idx, bool execute_if_ready, task_priority priority) ->
 		typename std::remove_reference<decltype(t.second)>::type
 	{
 		t.second.executor_ = this;
+		t.first.set_priority(priority);
 
 		const auto queue_index = get_thread_queue_idx(idx);
 		if(execute_if_ready && t.first.ready() &&
 		   ((get_thread_id(queue_index) == std::this_thread::get_id()) || (queue_index != 0)))
 		{
-			t.first();
+			execute(queue_index, t.first);
 
 			return std::move(t.second);
 		}
 
-		queues_[queue_index].push(std::move(t.first));
+		enqueue(queue_index, std::move(t.first));
 		return std::move(t.second);
 	}
 
-	bool cancel(std::uint64_t id)
-	{
-		bool cancelled = false;
-		for(std::size_t i = 0; i < threads_count_; ++i)
-		{
-			auto queue_index = get_thread_queue_idx(i, 0);
+	//-----------------------------------------------------------------------------
+	//  Name : push_job ()
+	/// <summary>
+	/// Pushes a job task without a future. The job_index is used to spread
+	/// consecutive jobs over the worker queues without querying their load.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void push_job(std::size_t job_index, task t);
 
-			auto& queue = queues_[queue_index];
-			if(queue.cancel(id))
-			{
-				cancelled = true;
-				break;
-			}
-		}
+	//-----------------------------------------------------------------------------
+	//  Name : push_owner_job ()
+	/// <summary>
+	/// Pushes a job task without a future to the owner thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void push_owner_job(task t);
+
+	//-----------------------------------------------------------------------------
+	//  Name : try_run_one ()
+	/// <summary>
+	/// Executes at most one task on the calling thread. Pops from the calling
+	/// thread's own queue if it is one of ours and otherwise tries to steal from
+	/// the worker queues. Returns true if a task was executed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool try_run_one();
 
-		return cancelled;
-	}
 	//-----------------------------------------------------------------------------
 	//  Name : processing_wait ()
 	/// <summary>
@@ -738,34 +1154,78 @@ private:
 	{
 
 	public:
-		task_queue() = default;
+		explicit task_queue(queue_backend backend = queue_backend::locking);
 		task_queue(task_queue const&) = delete;
 		task_queue(task_queue&& other) noexcept;
+		~task_queue();
 
 		std::size_t get_pending_tasks() const;
 		void set_done();
 		bool is_done() const;
 		std::pair<bool, task> try_pop();
 		bool try_push(task& t);
-		std::pair<bool, task> pop(duration_t pop_timeout = duration_t::max());
+		std::pair<bool, task> pop(duration_t pop_timeout = duration_t::max(),
+								  task_priority lowest = task_priority::idle);
 
 		void push(task t);
 		void wake_up();
 
-		bool cancel(std::uint64_t id);
 		void clear();
 
+		//-----------------------------------------------------------------------------
+		//  Name : set_owner ()
+		/// <summary>
+		/// Sets the thread that is allowed to push to and pop from the bottom of the
+		/// lock-free deque. Pushes from any other thread go through the inbox.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void set_owner(std::thread::id id);
+
 	private:
-		void sort();
-		std::deque<task> tasks_;
+		static void sort(std::deque<task>& lane);
+		static std::pair<bool, task> pop_front_ready(std::deque<task>& lane, bool allow_sort);
+		std::size_t get_pending_tasks_locked() const;
+
+		std::pair<bool, task> try_pop_lock_free();
+		std::pair<bool, task> pop_lock_free(duration_t pop_timeout, task_priority lowest);
+		void push_lock_free(task t);
+		void push_inbox(task::task_concept* t);
+		void drain_inbox();
+		std::pair<bool, task> pop_ready_lock_free(task_priority lowest);
+		bool has_work_lock_free() const;
+
+		/// one lane per priority class
+		std::array<std::deque<task>, task_priorities_count> tasks_;
 		std::condition_variable cv_;
 		mutable std::mutex mutex_;
 		std::atomic_bool done_{false};
+
+		queue_backend backend_ = queue_backend::locking;
+		/// lock-free backend. owner pushes/pops the bottom, thieves steal the top.
+		std::array<work_stealing_deque<task::task_concept*>, task_priorities_count> deques_;
+		/// lock-free backend. intrusive stack of tasks pushed by foreign threads.
+		std::atomic<task::task_concept*> inbox_{nullptr};
+		/// lock-free backend. owner only, tasks popped before they were ready.
+		std::vector<task> waiting_;
+		std::atomic<std::size_t> pending_{0};
+		std::atomic<std::size_t> sleepers_{0};
+		std::atomic_bool discard_{false};
+		std::atomic<std::thread::id> owner_id_{};
 	};
 
 	std::vector<task_queue> queues_;
 	std::vector<std::thread> threads_;
+	/// owner, compute and io threads
 	std::size_t threads_count_;
+	std::size_t compute_workers_count_ = 0;
+	std::size_t io_workers_count_ = 0;
+	std::vector<std::string> thread_names_;
+	/// per thread scheduler counters and trace events
+	std::unique_ptr<detail::thread_counters[]> counters_;
+	std::unique_ptr<detail::trace_buffer[]> traces_;
+	std::atomic_bool instrumentation_enabled_{false};
+	std::atomic_bool tracing_{false};
+	std::chrono::steady_clock::time_point trace_origin_{};
 	//
 	const std::thread::id owner_thread_id_ = std::this_thread::get_id();
 	bool wait_on_destruct_ = false;
@@ -786,7 +1246,7 @@ inline decltype(auto) task_future<T>::then_on_owner(F&& f)
 template <typename T>
 inline void task_future<T>::wait() const
 {
-	if(!future_.valid())
+	if(!state_)
 	{
 		return;
 	}
@@ -797,12 +1257,12 @@ inline void task_future<T>::wait() const
 		{
 			if(!executor_->processing_wait(*this))
 			{
-				future_.wait();
+				state_->wait();
 			}
 		}
 		else
 		{
-			future_.wait();
+			state_->wait();
 		}
 	}
 }
@@ -810,20 +1270,12 @@ inline void task_future<T>::wait() const
 template <typename T>
 inline void task_future<T>::cancel() const
 {
-	if(!future_.valid())
+	if(!state_)
 	{
 		return;
 	}
 
-	if(executor_)
-	{
-		bool cancelled = executor_->cancel(id_);
-
-		if(!cancelled)
-		{
-			wait();
-		}
-	}
+	state_->request_cancel();
 }
 } // namespace core
 
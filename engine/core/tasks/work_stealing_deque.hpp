@@ -0,0 +1,211 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace core
+{
+/*
+ * work_stealing_deque; a Chase-Lev lock-free deque.
+ *
+ *      The owner thread pushes and pops at the bottom (LIFO) while any
+ *      number of thief threads steal from the top (FIFO). Only the owner
+ *      may call push/pop, everyone may call steal.
+ *
+ *      The stored type must be trivially copyable (pointers or handles),
+ *      since slots are read speculatively by thieves before they win the
+ *      race on the top index.
+ *
+ *      The ring grows on demand. Old rings are kept alive until the deque
+ *      is destroyed because a thief may still be reading from them.
+ */
+template <typename T>
+class work_stealing_deque
+{
+	static_assert(std::is_trivially_copyable<T>::value, "work_stealing_deque requires trivially copyable T");
+
+	struct ring
+	{
+		explicit ring(std::int64_t cap)
+			: capacity(cap)
+			, mask(cap - 1)
+			, buffer(new std::atomic<T>[static_cast<std::size_t>(cap)])
+		{
+		}
+
+		T get(std::int64_t i) const noexcept
+		{
+			return buffer[static_cast<std::size_t>(i & mask)].load(std::memory_order_relaxed);
+		}
+
+		void put(std::int64_t i, T x) noexcept
+		{
+			buffer[static_cast<std::size_t>(i & mask)].store(x, std::memory_order_relaxed);
+		}
+
+		std::unique_ptr<ring> grow(std::int64_t bottom, std::int64_t top) const
+		{
+			auto r = std::make_unique<ring>(capacity * 2);
+			for(std::int64_t i = top; i != bottom; ++i)
+			{
+				r->put(i, get(i));
+			}
+			return r;
+		}
+
+		std::int64_t capacity;
+		std::int64_t mask;
+		std::unique_ptr<std::atomic<T>[]> buffer;
+	};
+
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : work_stealing_deque ()
+	/// <summary>
+	/// Constructs the deque. The capacity must be a power of two.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	explicit work_stealing_deque(std::int64_t capacity = 1024)
+	{
+		rings_.emplace_back(std::make_unique<ring>(capacity));
+		ring_.store(rings_.back().get(), std::memory_order_relaxed);
+	}
+
+	work_stealing_deque(const work_stealing_deque&) = delete;
+	work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+
+	//-----------------------------------------------------------------------------
+	//  Name : work_stealing_deque ()
+	/// <summary>
+	/// Move constructor. Only valid while no other thread touches either deque,
+	/// which is the case while the owning containers are being built.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	work_stealing_deque(work_stealing_deque&& other) noexcept
+		: top_(other.top_.load())
+		, bottom_(other.bottom_.load())
+		, ring_(other.ring_.load())
+		, rings_(std::move(other.rings_))
+	{
+		other.top_.store(0);
+		other.bottom_.store(0);
+		other.ring_.store(nullptr);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : push ()
+	/// <summary>
+	/// Pushes an element at the bottom. Owner thread only.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void push(T x)
+	{
+		const auto b = bottom_.load(std::memory_order_relaxed);
+		const auto t = top_.load(std::memory_order_acquire);
+		auto r = ring_.load(std::memory_order_relaxed);
+
+		if(b - t > r->capacity - 1)
+		{
+			rings_.emplace_back(r->grow(b, t));
+			r = rings_.back().get();
+			ring_.store(r, std::memory_order_release);
+		}
+
+		r->put(b, x);
+		std::atomic_thread_fence(std::memory_order_release);
+		bottom_.store(b + 1, std::memory_order_relaxed);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : pop ()
+	/// <summary>
+	/// Pops an element from the bottom. Owner thread only.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool pop(T& out)
+	{
+		const auto b = bottom_.load(std::memory_order_relaxed) - 1;
+		auto r = ring_.load(std::memory_order_relaxed);
+		bottom_.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		auto t = top_.load(std::memory_order_relaxed);
+
+		if(t > b)
+		{
+			// empty
+			bottom_.store(b + 1, std::memory_order_relaxed);
+			return false;
+		}
+
+		out = r->get(b);
+		if(t == b)
+		{
+			// last element, race against the thieves
+			const bool won =
+				top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+			bottom_.store(b + 1, std::memory_order_relaxed);
+			return won;
+		}
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : steal ()
+	/// <summary>
+	/// Steals an element from the top. Can be called from any thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool steal(T& out)
+	{
+		auto t = top_.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const auto b = bottom_.load(std::memory_order_acquire);
+
+		if(t >= b)
+		{
+			return false;
+		}
+
+		auto r = ring_.load(std::memory_order_acquire);
+		T x = r->get(t);
+		if(!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			// lost the race to another thief or to the owner
+			return false;
+		}
+
+		out = x;
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : size ()
+	/// <summary>
+	/// Approximate number of elements. Exact only when called by the owner
+	/// while no steal is in progress.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t size() const noexcept
+	{
+		const auto b = bottom_.load(std::memory_order_relaxed);
+		const auto t = top_.load(std::memory_order_relaxed);
+		return b > t ? static_cast<std::size_t>(b - t) : 0;
+	}
+
+	bool empty() const noexcept
+	{
+		return size() == 0;
+	}
+
+private:
+	std::atomic<std::int64_t> top_{0};
+	std::atomic<std::int64_t> bottom_{0};
+	std::atomic<ring*> ring_{nullptr};
+	/// owner only. keeps every ring ever allocated alive for the thieves.
+	std::vector<std::unique_ptr<ring>> rings_;
+};
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include "animation_clip.h"
 #include <core/math/math_includes.h>
 
 #include <chrono>
@@ -57,6 +58,10 @@ struct animation
 
 	/// The node animation channels. Each channel affects a single node.
 	std::vector<node_animation> channels;
+
+	/// The channels compressed for sampling. Built when the animation is
+	/// compiled, the channels of a loaded animation only have their names.
+	animation_clip clip;
 };
 
 // elapsed_time = math::modf(elapsed_time + dt , anim.duration);
@@ -0,0 +1,434 @@
+#include "animation_clip.h"
+#include "animation.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ANIMATION_CLIP_SSE
+#endif
+
+namespace runtime
+{
+namespace
+{
+/// the largest value of 16 bits
+constexpr float quantized_max = 65535.0f;
+/// the bound of the three smallest components of a unit quaternion, 1 / sqrt(2)
+constexpr float smallest_three_max = 0.707106781f;
+
+/// the tracks being reduced, longer spans are cut to bound the compile time
+constexpr std::size_t max_dropped_keys = 128;
+
+float max_error(const math::vec3& a, const math::vec3& b)
+{
+	return std::max({std::fabs(a.x - b.x), std::fabs(a.y - b.y), std::fabs(a.z - b.z)});
+}
+
+float max_error(const math::quat& a, const math::quat& b)
+{
+	// q and -q are the same rotation
+	const float sign = math::dot(a, b) < 0.0f ? -1.0f : 1.0f;
+	return std::max({std::fabs(a.x - sign * b.x), std::fabs(a.y - sign * b.y), std::fabs(a.z - sign * b.z),
+					 std::fabs(a.w - sign * b.w)});
+}
+
+math::vec3 interpolate(const math::vec3& a, const math::vec3& b, float factor)
+{
+	return a + (b - a) * factor;
+}
+
+// as the sampler does, the shortest way normalized
+math::quat interpolate(const math::quat& a, const math::quat& b, float factor)
+{
+	const auto to = math::dot(a, b) < 0.0f ? -b : b;
+	return math::normalize(a + (to - a) * factor);
+}
+
+// the keys kept of a track, the ones an interpolation of the kept ones misses by more than the tolerance
+template <typename T>
+std::vector<std::size_t> reduce_keys(const std::vector<node_animation::key<T>>& keys, float tolerance)
+{
+	std::vector<std::size_t> kept;
+	if(keys.empty())
+	{
+		return kept;
+	}
+
+	kept.emplace_back(0);
+	const bool constant = std::all_of(std::begin(keys), std::end(keys), [&](const node_animation::key<T>& k) {
+		return max_error(k.value, keys.front().value) <= tolerance;
+	});
+	if(constant)
+	{
+		return kept;
+	}
+
+	std::size_t anchor = 0;
+	for(std::size_t next = 2; next < keys.size(); ++next)
+	{
+		const auto& from = keys[anchor];
+		const auto& to = keys[next];
+		const auto span = to.time.count() - from.time.count();
+
+		bool fits = next - anchor <= max_dropped_keys;
+		for(auto i = anchor + 1; i < next && fits; ++i)
+		{
+			const auto factor = span > 0.0f ? (keys[i].time.count() - from.time.count()) / span : 0.0f;
+			fits = max_error(interpolate(from.value, to.value, factor), keys[i].value) <= tolerance;
+		}
+
+		if(!fits)
+		{
+			anchor = next - 1;
+			kept.emplace_back(anchor);
+		}
+	}
+
+	if(keys.size() > 1)
+	{
+		kept.emplace_back(keys.size() - 1);
+	}
+	return kept;
+}
+
+std::uint16_t quantize(float value, float scale)
+{
+	return std::uint16_t(math::clamp(std::round(value * scale), 0.0f, quantized_max));
+}
+
+animation_clip::packed_value pack(const math::vec3& value, const animation_clip::track& t)
+{
+	animation_clip::packed_value result;
+	const float v[3] = {value.x, value.y, value.z};
+	const float min[3] = {t.min.x, t.min.y, t.min.z};
+	const float scale[3] = {t.scale.x, t.scale.y, t.scale.z};
+	for(int i = 0; i < 3; ++i)
+	{
+		result.value[i] = scale[i] > 0.0f ? quantize(v[i] - min[i], 1.0f / scale[i]) : 0;
+	}
+	return result;
+}
+
+// the three smallest components and the index of the largest, which is made positive
+animation_clip::packed_value pack(const math::quat& value)
+{
+	const auto q = math::normalize(value);
+	const float v[4] = {q.x, q.y, q.z, q.w};
+	int largest = 0;
+	for(int i = 1; i < 4; ++i)
+	{
+		if(std::fabs(v[i]) > std::fabs(v[largest]))
+		{
+			largest = i;
+		}
+	}
+
+	animation_clip::packed_value result;
+	const float sign = v[largest] < 0.0f ? -1.0f : 1.0f;
+	const float scale = quantized_max / (2.0f * smallest_three_max);
+	for(int i = 0, j = 0; i < 4; ++i)
+	{
+		if(i != largest)
+		{
+			result.value[j++] = quantize(sign * v[i] + smallest_three_max, scale);
+		}
+	}
+	result.value[3] = std::uint16_t(largest);
+	return result;
+}
+
+animation_clip::track add_vector_track(animation_clip& clip,
+									   const std::vector<node_animation::key<math::vec3>>& keys,
+									   float tolerance)
+{
+	const auto kept = reduce_keys(keys, tolerance);
+
+	animation_clip::track result;
+	result.first = std::uint32_t(clip.times.size());
+	result.count = std::uint32_t(kept.size());
+	if(kept.empty())
+	{
+		return result;
+	}
+
+	auto min = keys[kept.front()].value;
+	auto max = min;
+	for(auto i : kept)
+	{
+		min = math::min(min, keys[i].value);
+		max = math::max(max, keys[i].value);
+	}
+	result.min = math::vec4(min, 0.0f);
+	result.scale = math::vec4((max - min) / quantized_max, 0.0f);
+
+	for(auto i : kept)
+	{
+		clip.times.emplace_back(quantize(keys[i].time.count(), clip.time_scale));
+		clip.values.emplace_back(pack(keys[i].value, result));
+	}
+	return result;
+}
+
+animation_clip::track add_rotation_track(animation_clip& clip,
+										 const std::vector<node_animation::key<math::quat>>& keys,
+										 float tolerance)
+{
+	const auto kept = reduce_keys(keys, tolerance);
+
+	animation_clip::track result;
+	result.first = std::uint32_t(clip.times.size());
+	result.count = std::uint32_t(kept.size());
+	for(auto i : kept)
+	{
+		clip.times.emplace_back(quantize(keys[i].time.count(), clip.time_scale));
+		clip.values.emplace_back(pack(keys[i].value));
+	}
+	return result;
+}
+
+template <typename T>
+float get_last_time(const std::vector<node_animation::key<T>>& keys)
+{
+	return keys.empty() ? 0.0f : keys.back().time.count();
+}
+
+#if defined(ANIMATION_CLIP_SSE)
+inline __m128 load(const math::vec4& v)
+{
+	return _mm_loadu_ps(&v.x);
+}
+
+inline math::vec4 store(__m128 v)
+{
+	math::vec4 result;
+	_mm_storeu_ps(&result.x, v);
+	return result;
+}
+
+// the 16 bit values as floats
+inline __m128 load(const animation_clip::packed_value& v)
+{
+	const auto raw = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(v.value));
+	return _mm_cvtepi32_ps(_mm_unpacklo_epi16(raw, _mm_setzero_si128()));
+}
+
+// the dot product in every lane
+inline __m128 dot(__m128 a, __m128 b)
+{
+	const auto m = _mm_mul_ps(a, b);
+	const auto s = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+inline __m128 lerp(__m128 a, __m128 b, float factor)
+{
+	return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(factor)));
+}
+
+inline math::vec4 lerp(const math::vec4& a, const math::vec4& b, float factor)
+{
+	return store(lerp(load(a), load(b), factor));
+}
+
+// the shortest way, normalized
+inline math::vec4 nlerp(const math::vec4& a, const math::vec4& b, float factor)
+{
+	const auto va = load(a);
+	auto vb = load(b);
+	const auto negative = _mm_cmplt_ps(dot(va, vb), _mm_setzero_ps());
+	vb = _mm_xor_ps(vb, _mm_and_ps(negative, _mm_set1_ps(-0.0f)));
+
+	const auto r = lerp(va, vb, factor);
+	const auto length_sq = dot(r, r);
+	if(_mm_cvtss_f32(length_sq) <= 0.0f)
+	{
+		return a;
+	}
+	return store(_mm_div_ps(r, _mm_sqrt_ps(length_sq)));
+}
+
+inline math::vec4 decode_vector(const animation_clip::packed_value& v, const animation_clip::track& t)
+{
+	return store(_mm_add_ps(load(t.min), _mm_mul_ps(load(v), load(t.scale))));
+}
+
+inline void decode_smallest_three(const animation_clip::packed_value& v, float result[4])
+{
+	const auto scale = _mm_set1_ps(2.0f * smallest_three_max / quantized_max);
+	const auto c = _mm_sub_ps(_mm_mul_ps(load(v), scale), _mm_set1_ps(smallest_three_max));
+	_mm_storeu_ps(result, c);
+}
+#else
+inline math::vec4 lerp(const math::vec4& a, const math::vec4& b, float factor)
+{
+	return a + (b - a) * factor;
+}
+
+inline math::vec4 nlerp(const math::vec4& a, const math::vec4& b, float factor)
+{
+	const auto to = math::dot(a, b) < 0.0f ? -b : b;
+	const auto r = a + (to - a) * factor;
+	const auto length_sq = math::dot(r, r);
+	if(length_sq <= 0.0f)
+	{
+		return a;
+	}
+	return r / std::sqrt(length_sq);
+}
+
+inline math::vec4 decode_vector(const animation_clip::packed_value& v, const animation_clip::track& t)
+{
+	const auto value = math::vec4(float(v.value[0]), float(v.value[1]), float(v.value[2]), 0.0f);
+	return t.min + value * t.scale;
+}
+
+inline void decode_smallest_three(const animation_clip::packed_value& v, float result[4])
+{
+	const float scale = 2.0f * smallest_three_max / quantized_max;
+	for(int i = 0; i < 4; ++i)
+	{
+		result[i] = float(v.value[i]) * scale - smallest_three_max;
+	}
+}
+#endif
+
+math::vec4 decode_rotation(const animation_clip::packed_value& v)
+{
+	float c[4];
+	decode_smallest_three(v, c);
+	const auto largest = std::sqrt(std::max(0.0f, 1.0f - c[0] * c[0] - c[1] * c[1] - c[2] * c[2]));
+
+	float q[4];
+	const auto index = v.value[3] & 3;
+	for(int i = 0, j = 0; i < 4; ++i)
+	{
+		q[i] = i == index ? largest : c[j++];
+	}
+	return math::vec4(q[0], q[1], q[2], q[3]);
+}
+}
+
+animation_clip animation_clip::build(const animation& anim, const animation_compression& settings)
+{
+	animation_clip clip;
+	clip.duration = anim.duration.count();
+	clip.channels.reserve(anim.channels.size());
+
+	// keys past the duration still get a time
+	auto span = clip.duration;
+	std::size_t keys = 0;
+	for(const auto& c : anim.channels)
+	{
+		span = std::max({span, get_last_time(c.position_keys), get_last_time(c.rotation_keys),
+						 get_last_time(c.scaling_keys)});
+		keys += c.position_keys.size() + c.rotation_keys.size() + c.scaling_keys.size();
+	}
+	clip.time_scale = span > 0.0f ? quantized_max / span : 0.0f;
+	clip.times.reserve(keys);
+	clip.values.reserve(keys);
+
+	for(const auto& c : anim.channels)
+	{
+		channel ch;
+		ch.node_name = c.node_name;
+		ch.position = add_vector_track(clip, c.position_keys, settings.position_error);
+		ch.rotation = add_rotation_track(clip, c.rotation_keys, settings.rotation_error);
+		ch.scaling = add_vector_track(clip, c.scaling_keys, settings.scaling_error);
+		clip.channels.emplace_back(std::move(ch));
+	}
+
+	clip.times.shrink_to_fit();
+	clip.values.shrink_to_fit();
+	return clip;
+}
+
+void animation_clip::sample(std::size_t index, float time, cursor& at, node_pose& out) const
+{
+	const auto& ch = channels[index];
+	if(ch.position.count > 0)
+	{
+		out.position = sample_vector(ch.position, time, at.position);
+	}
+	if(ch.rotation.count > 0)
+	{
+		out.rotation = sample_rotation(ch.rotation, time, at.rotation);
+	}
+	if(ch.scaling.count > 0)
+	{
+		out.scale = sample_vector(ch.scaling, time, at.scaling);
+	}
+}
+
+std::size_t animation_clip::get_memory_size() const
+{
+	auto result = sizeof(animation_clip) + channels.size() * sizeof(channel) +
+				  times.size() * sizeof(std::uint16_t) + values.size() * sizeof(packed_value);
+	for(const auto& c : channels)
+	{
+		result += c.node_name.size();
+	}
+	return result;
+}
+
+math::vec4 animation_clip::sample_vector(const track& t, float time, std::uint32_t& at) const
+{
+	float factor = 0.0f;
+	const auto key = t.first + seek(t, time, at, factor);
+	const auto from = decode_vector(values[key], t);
+	if(factor <= 0.0f)
+	{
+		return from;
+	}
+	return lerp(from, decode_vector(values[key + 1], t), factor);
+}
+
+math::vec4 animation_clip::sample_rotation(const track& t, float time, std::uint32_t& at) const
+{
+	float factor = 0.0f;
+	const auto key = t.first + seek(t, time, at, factor);
+	const auto from = decode_rotation(values[key]);
+	if(factor <= 0.0f)
+	{
+		return from;
+	}
+	return nlerp(from, decode_rotation(values[key + 1]), factor);
+}
+
+std::uint32_t animation_clip::seek(const track& t, float time, std::uint32_t& at, float& factor) const
+{
+	const auto* track_times = times.data() + t.first;
+	const auto quantized = time * time_scale;
+	auto key = at;
+	if(key >= t.count || float(track_times[key]) > quantized)
+	{
+		key = 0;
+	}
+
+	const auto last = t.count - 1;
+	while(key < last && float(track_times[key + 1]) <= quantized)
+	{
+		++key;
+	}
+	at = key;
+
+	factor = 0.0f;
+	if(key < last)
+	{
+		const auto span = float(track_times[key + 1]) - float(track_times[key]);
+		if(span > 0.0f)
+		{
+			factor = math::clamp((quantized - float(track_times[key])) / span, 0.0f, 1.0f);
+		}
+	}
+	return key;
+}
+
+void blend(node_pose& result, const node_pose& pose, float weight)
+{
+	result.position = lerp(result.position, pose.position, weight);
+	result.rotation = nlerp(result.rotation, pose.rotation, weight);
+	result.scale = lerp(result.scale, pose.scale, weight);
+}
+}
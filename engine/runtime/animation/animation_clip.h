@@ -0,0 +1,126 @@
+#pragma once
+#include <core/math/math_includes.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace runtime
+{
+struct animation;
+
+/// the local transform of a node sampled from a channel, the rotation as x y z w
+struct node_pose
+{
+	math::vec4 position = {0.0f, 0.0f, 0.0f, 0.0f};
+	math::vec4 rotation = {0.0f, 0.0f, 0.0f, 1.0f};
+	math::vec4 scale = {1.0f, 1.0f, 1.0f, 0.0f};
+};
+
+/// the largest error of a kept value a dropped key may have
+struct animation_compression
+{
+	float position_error = 0.001f;
+	float rotation_error = 0.0005f;
+	float scaling_error = 0.001f;
+};
+
+/*
+ * animation_clip; the keys of an animation compressed and laid out for
+ * sampling.
+ *
+ *      The keys a linear interpolation of their neighbours reproduces within
+ *      a tolerance are dropped. The times of every track are contiguous and
+ *      apart from the values, 16 bits over the length of the clip, so looking
+ *      for the keys of a time only touches the times. A value is 4 times 16
+ *      bits: the vectors over the bounds of their track, the rotations as
+ *      their three smallest components and the index of the largest one.
+ *      They are decoded and interpolated as one register when sampled.
+ */
+struct animation_clip
+{
+	struct packed_value
+	{
+		std::uint16_t value[4] = {};
+	};
+
+	/// the keys of a track, a range of the times and values
+	struct track
+	{
+		std::uint32_t first = 0;
+		std::uint32_t count = 0;
+		/// the value of a vector is min + value * scale
+		math::vec4 min = {0.0f, 0.0f, 0.0f, 0.0f};
+		math::vec4 scale = {0.0f, 0.0f, 0.0f, 0.0f};
+	};
+
+	struct channel
+	{
+		std::string node_name;
+		track position;
+		track rotation;
+		track scaling;
+	};
+
+	/// the key of every track of a channel at the time it was last sampled
+	struct cursor
+	{
+		std::uint32_t position = 0;
+		std::uint32_t rotation = 0;
+		std::uint32_t scaling = 0;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : build ()
+	/// <summary>
+	/// Compresses the keys of the animation.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static animation_clip build(const animation& anim, const animation_compression& settings = {});
+
+	//-----------------------------------------------------------------------------
+	//  Name : sample ()
+	/// <summary>
+	/// Samples a channel at the time in seconds. The cursor is moved forward
+	/// from where it was, so playing forward is a step per key instead of a
+	/// search, and is reset when the time is before it, e.g. after a loop.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void sample(std::size_t index, float time, cursor& at, node_pose& out) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_memory_size ()
+	/// <summary>
+	/// The bytes of the keys.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t get_memory_size() const;
+
+	bool empty() const
+	{
+		return channels.empty();
+	}
+
+	float duration = 0.0f;
+	/// from seconds to the 16 bits of the times
+	float time_scale = 0.0f;
+	std::vector<channel> channels;
+	/// the times of all tracks
+	std::vector<std::uint16_t> times;
+	/// the values of all tracks, at the same indices as the times
+	std::vector<packed_value> values;
+
+private:
+	math::vec4 sample_vector(const track& t, float time, std::uint32_t& at) const;
+	math::vec4 sample_rotation(const track& t, float time, std::uint32_t& at) const;
+	std::uint32_t seek(const track& t, float time, std::uint32_t& at, float& factor) const;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : blend ()
+/// <summary>
+/// Blends the pose into the result by the weight, 1 is the pose.
+/// </summary>
+//-----------------------------------------------------------------------------
+void blend(node_pose& result, const node_pose& pose, float weight);
+}
@@ -0,0 +1,37 @@
+#include "skeleton.h"
+
+#include <algorithm>
+
+namespace runtime
+{
+constexpr std::uint32_t skeleton::invalid_index;
+
+std::uint32_t skeleton::find_node(const std::string& name) const
+{
+	const auto it = std::find(std::begin(names), std::end(names), name);
+	if(it == std::end(names))
+	{
+		return invalid_index;
+	}
+	return std::uint32_t(std::distance(std::begin(names), it));
+}
+
+void skeleton::to_model_space(const std::vector<math::transform>& local,
+							  std::vector<math::transform>& model) const
+{
+	const auto count = std::min(local.size(), parents.size());
+	model.resize(count);
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		const auto parent = parents[i];
+		if(parent == invalid_index)
+		{
+			model[i] = local[i];
+		}
+		else
+		{
+			model[i] = model[parent] * local[i];
+		}
+	}
+}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <core/math/math_includes.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace runtime
+{
+/*
+ * skeleton; the nodes of an armature as flat arrays.
+ *
+ *      Every node comes after its parent, so the transforms of a pose are
+ *      brought to the space of the model in one pass from the first node to
+ *      the last. The bones of the skin are indices of their nodes.
+ */
+struct skeleton
+{
+	/// the parent of a root and the node of no name
+	static constexpr std::uint32_t invalid_index = std::uint32_t(-1);
+
+	//-----------------------------------------------------------------------------
+	//  Name : find_node ()
+	/// <summary>
+	/// The index of the node of the name, invalid_index when there is none.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint32_t find_node(const std::string& name) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : to_model_space ()
+	/// <summary>
+	/// Brings the local transforms of a pose of every node to the space of
+	/// the model.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void to_model_space(const std::vector<math::transform>& local, std::vector<math::transform>& model) const;
+
+	std::size_t size() const
+	{
+		return parents.size();
+	}
+
+	bool empty() const
+	{
+		return parents.empty();
+	}
+
+	std::vector<std::string> names;
+	/// the index of the parent of every node, before it
+	std::vector<std::uint32_t> parents;
+	/// the local transform of every node as it was imported
+	std::vector<math::transform> rest_pose;
+	/// the node of every bone of the skin, in the order of the skin data
+	std::vector<std::uint32_t> bones;
+};
+}
@@ -1,12 +1,16 @@
 #pragma once
 
+#include "asset_id.h"
+
+#include "../ecs/component_pool.h"
+
 #include <memory>
 #include <string>
 
 template <typename T>
 struct asset_link
 {
-	std::string id;
+	asset_id id;
 	std::shared_ptr<T> asset;
 };
 
@@ -71,7 +75,7 @@ struct asset_handle
 	//-----------------------------------------------------------------------------
 	const std::string& id() const
 	{
-		return link->id;
+		return link->id.str();
 	}
 
 	//-----------------------------------------------------------------------------
@@ -171,6 +175,7 @@ struct asset_handle
 		return get();
 	}
 
-	// Internal link to asset
-	std::shared_ptr<asset_link<T>> link = std::make_shared<asset_link<T>>();
+	// Internal link to asset, every handle makes one so they are pooled
+	std::shared_ptr<asset_link<T>> link =
+		runtime::ecs::detail::make_pooled<asset_link<T>>(runtime::ecs::detail::asset_pool);
 };
@@ -0,0 +1,80 @@
+#include "asset_id.h"
+
+#include <array>
+#include <mutex>
+#include <unordered_map>
+
+namespace
+{
+// fnv-1a, with the murmur3 finalizer since its top bits pick the shards and
+// barely change between short keys
+std::uint64_t hash_key(const std::string& key)
+{
+	std::uint64_t result = 0xcbf29ce484222325ull;
+	for(auto c : key)
+	{
+		result ^= std::uint8_t(c);
+		result *= 0x100000001b3ull;
+	}
+
+	result ^= result >> 33;
+	result *= 0xff51afd7ed558ccdull;
+	result ^= result >> 33;
+	result *= 0xc4ceb9fe1a85ec53ull;
+	result ^= result >> 33;
+	return result;
+}
+
+/*
+ * The keys by the top bits of their hash, behind a lock each. The nodes of
+ * the maps do not move, the ids point into them.
+ */
+struct table_shard
+{
+	std::unordered_map<std::string, std::uint64_t> keys;
+	std::mutex mutex;
+};
+
+constexpr std::size_t table_bits = 4;
+
+std::array<table_shard, std::size_t(1) << table_bits>& get_table()
+{
+	static std::array<table_shard, std::size_t(1) << table_bits> table;
+	return table;
+}
+
+const std::string& get_empty()
+{
+	static const std::string empty;
+	return empty;
+}
+}
+
+asset_id::asset_id(const std::string& key)
+{
+	if(key.empty())
+	{
+		return;
+	}
+
+	const auto key_hash = hash_key(key);
+	auto& s = get_table()[key_hash >> (64 - table_bits)];
+
+	std::lock_guard<std::mutex> lock(s.mutex);
+	entry_ = &*s.keys.emplace(key, key_hash).first;
+}
+
+asset_id::asset_id(const char* key)
+	: asset_id(std::string(key ? key : ""))
+{
+}
+
+const std::string& asset_id::str() const
+{
+	return entry_ ? entry_->first : get_empty();
+}
+
+std::uint64_t asset_id::hash() const
+{
+	return entry_ ? entry_->second : 0;
+}
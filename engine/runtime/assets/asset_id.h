@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * asset_id; an asset key interned once, it is the pointer to the one copy of
+ * the key in a table that is never emptied, with its hash.
+ *
+ *      Copies and compares are those of a pointer and the hash is computed
+ *      when the key is interned only. The string is there for the loaders
+ *      and the files, which keep the keys readable.
+ */
+class asset_id
+{
+public:
+	struct hasher
+	{
+		std::size_t operator()(const asset_id& id) const
+		{
+			return std::size_t(id.hash());
+		}
+	};
+
+	asset_id() = default;
+
+	//-----------------------------------------------------------------------------
+	//  Name : asset_id ()
+	/// <summary>
+	/// Interns the key, an empty key is the empty id. Safe to call from any
+	/// thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	asset_id(const std::string& key);
+	asset_id(const char* key);
+
+	const std::string& str() const;
+
+	operator const std::string&() const
+	{
+		return str();
+	}
+
+	/// the hash of the key, 0 for the empty id
+	std::uint64_t hash() const;
+
+	bool empty() const
+	{
+		return entry_ == nullptr;
+	}
+
+	void clear()
+	{
+		entry_ = nullptr;
+	}
+
+	bool operator==(const asset_id& rhs) const
+	{
+		return entry_ == rhs.entry_;
+	}
+
+	bool operator!=(const asset_id& rhs) const
+	{
+		return entry_ != rhs.entry_;
+	}
+
+private:
+	/// the key and its hash in the table
+	const std::pair<const std::string, std::uint64_t>* entry_ = nullptr;
+};
@@ -0,0 +1,190 @@
+#include "asset_load_stats.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+
+namespace runtime
+{
+namespace
+{
+double to_ms(std::uint64_t us)
+{
+	return double(us) / 1000.0;
+}
+
+std::uint64_t to_us(asset_load_stats::clock::duration d)
+{
+	return std::uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+}
+}
+
+asset_load_stats::stage_timer::stage_timer(std::shared_ptr<record> r, stage s, bool last)
+	: record_(std::move(r))
+	, start_(clock::now())
+	, stage_(s)
+	, last_(last)
+{
+}
+
+asset_load_stats::stage_timer::~stage_timer()
+{
+	if(!record_)
+	{
+		return;
+	}
+
+	const auto now = clock::now();
+	const auto i = std::size_t(stage_);
+	if(record_->stage_us[i].fetch_add(to_us(now - start_)) == 0)
+	{
+		record_->stage_start_us[i] = to_us(start_ - record_->start);
+	}
+	if(last_)
+	{
+		record_->total_us = to_us(now - record_->start);
+		record_->done = true;
+	}
+}
+
+asset_load_stats::asset_load_stats()
+	: epoch_(clock::now())
+{
+}
+
+std::shared_ptr<asset_load_stats::record> asset_load_stats::begin(const std::string& type,
+																	const std::string& key)
+{
+	if(!enabled_)
+	{
+		return nullptr;
+	}
+
+	auto r = std::make_shared<record>();
+	r->type = type;
+	r->key = key;
+	r->start = clock::now();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	records_.push_back(r);
+	while(records_.size() > max_records_)
+	{
+		records_.pop_front();
+	}
+	return r;
+}
+
+void asset_load_stats::add_bytes(const std::shared_ptr<record>& r, std::uint64_t bytes)
+{
+	if(r)
+	{
+		r->bytes += bytes;
+	}
+}
+
+std::vector<asset_load_stats::sample> asset_load_stats::get_samples() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	const auto now = clock::now();
+	std::vector<sample> samples;
+	samples.reserve(records_.size());
+	for(const auto& r : records_)
+	{
+		sample s;
+		s.type = r->type;
+		s.key = r->key;
+		s.start_ms = std::chrono::duration<double, std::milli>(r->start - epoch_).count();
+		for(std::size_t i = 0; i < s.stage_ms.size(); ++i)
+		{
+			s.stage_ms[i] = to_ms(r->stage_us[i]);
+			s.stage_start_ms[i] = to_ms(r->stage_start_us[i]);
+		}
+		s.done = r->done;
+		s.total_ms = s.done ? to_ms(r->total_us) : to_ms(to_us(now - r->start));
+		s.bytes = r->bytes;
+		samples.push_back(std::move(s));
+	}
+	return samples;
+}
+
+void asset_load_stats::write_report(std::ostream& os, std::size_t max_rows) const
+{
+	struct totals
+	{
+		std::size_t loads = 0;
+		std::array<double, std::size_t(stage::count)> stage_ms = {};
+		double total_ms = 0.0;
+		std::uint64_t bytes = 0;
+	};
+
+	auto samples = get_samples();
+	samples.erase(std::remove_if(std::begin(samples), std::end(samples),
+								 [](const sample& s) { return !s.done; }),
+				  std::end(samples));
+
+	std::map<std::string, totals> by_type;
+	for(const auto& s : samples)
+	{
+		auto& t = by_type[s.type];
+		++t.loads;
+		for(std::size_t i = 0; i < s.stage_ms.size(); ++i)
+		{
+			t.stage_ms[i] += s.stage_ms[i];
+		}
+		t.total_ms += s.total_ms;
+		t.bytes += s.bytes;
+	}
+
+	os << std::fixed << std::setprecision(2);
+	os << "type, loads, read ms, process ms, upload ms, total ms, KB\n";
+	for(const auto& pair : by_type)
+	{
+		const auto& t = pair.second;
+		os << pair.first << ", " << t.loads << ", " << t.stage_ms[0] << ", " << t.stage_ms[1] << ", "
+		   << t.stage_ms[2] << ", " << t.total_ms << ", " << double(t.bytes) / 1024.0 << "\n";
+	}
+
+	const auto rows = std::min(max_rows, samples.size());
+	std::partial_sort(std::begin(samples), std::begin(samples) + std::ptrdiff_t(rows), std::end(samples),
+					  [](const sample& a, const sample& b) { return a.total_ms > b.total_ms; });
+	os << "slowest, read ms, process ms, upload ms, total ms, KB\n";
+	for(std::size_t i = 0; i < rows; ++i)
+	{
+		const auto& s = samples[i];
+		os << s.key << ", " << s.stage_ms[0] << ", " << s.stage_ms[1] << ", " << s.stage_ms[2] << ", "
+		   << s.total_ms << ", " << double(s.bytes) / 1024.0 << "\n";
+	}
+}
+
+void asset_load_stats::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	records_.clear();
+	epoch_ = clock::now();
+}
+
+void asset_load_stats::set_max_records(std::size_t max_records)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	max_records_ = std::max<std::size_t>(max_records, 1);
+	while(records_.size() > max_records_)
+	{
+		records_.pop_front();
+	}
+}
+
+const char* asset_load_stats::get_stage_name(stage s)
+{
+	switch(s)
+	{
+		case stage::read:
+			return "read";
+		case stage::process:
+			return "process";
+		case stage::upload:
+			return "upload";
+		default:
+			return "";
+	}
+}
+}
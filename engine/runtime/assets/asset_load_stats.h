@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace runtime
+{
+/*
+ * asset_load_stats; where the time of the asset loads goes, kept for the
+ * last loads.
+ *
+ *      A load is timed in stages from the threads they run on: the read of
+ *      the compiled data, processing it e.g. deserializing on a worker, and
+ *      the upload on the owner thread, e.g. the gpu resources created from
+ *      it. The total is the wall time from the start of the load to the end
+ *      of its last stage. The compiled data is mapped, the pages touched
+ *      while processing are read from the disk then and count there.
+ */
+class asset_load_stats
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	enum class stage : std::uint8_t
+	{
+		read,
+		process,
+		upload,
+		count
+	};
+
+	/// a load the loaders time, every field is written from one thread at a time
+	struct record
+	{
+		std::string type;
+		std::string key;
+		clock::time_point start;
+		std::array<std::atomic<std::uint64_t>, std::size_t(stage::count)> stage_us = {};
+		/// when every stage first started, since the start of the load
+		std::array<std::atomic<std::uint64_t>, std::size_t(stage::count)> stage_start_us = {};
+		std::atomic<std::uint64_t> total_us = {0};
+		std::atomic<std::uint64_t> bytes = {0};
+		std::atomic<bool> done = {false};
+	};
+
+	struct sample
+	{
+		std::string type;
+		std::string key;
+		/// since the stats were cleared
+		double start_ms = 0.0;
+		std::array<double, std::size_t(stage::count)> stage_ms = {};
+		std::array<double, std::size_t(stage::count)> stage_start_ms = {};
+		/// of a load still in flight, the time so far
+		double total_ms = 0.0;
+		std::uint64_t bytes = 0;
+		bool done = false;
+	};
+
+	/*
+	 * stage_timer; adds the time it lives to a stage of a record, the last
+	 * stage finishes the load when done. Does nothing for a null record.
+	 */
+	class stage_timer
+	{
+	public:
+		stage_timer(std::shared_ptr<record> r, stage s, bool last = false);
+		~stage_timer();
+
+		stage_timer(const stage_timer&) = delete;
+		stage_timer& operator=(const stage_timer&) = delete;
+
+	private:
+		std::shared_ptr<record> record_;
+		clock::time_point start_;
+		stage stage_;
+		bool last_;
+	};
+
+	asset_load_stats();
+
+	//-----------------------------------------------------------------------------
+	//  Name : begin ()
+	/// <summary>
+	/// Starts timing a load, null when the stats are disabled. Safe to call
+	/// from any thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<record> begin(const std::string& type, const std::string& key);
+
+	static void add_bytes(const std::shared_ptr<record>& r, std::uint64_t bytes);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_samples ()
+	/// <summary>
+	/// The kept loads in the order they started.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::vector<sample> get_samples() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : write_report ()
+	/// <summary>
+	/// Writes the totals per type and the slowest finished loads, at most
+	/// max_rows of them.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void write_report(std::ostream& os, std::size_t max_rows) const;
+
+	void clear();
+
+	void set_enabled(bool enabled)
+	{
+		enabled_ = enabled;
+	}
+
+	bool is_enabled() const
+	{
+		return enabled_;
+	}
+
+	/// loads kept, the oldest are dropped
+	void set_max_records(std::size_t max_records);
+
+	static const char* get_stage_name(stage s);
+
+private:
+	mutable std::mutex mutex_;
+	std::deque<std::shared_ptr<record>> records_;
+	clock::time_point epoch_;
+	std::size_t max_records_ = 4096;
+	std::atomic<bool> enabled_ = {true};
+};
+}
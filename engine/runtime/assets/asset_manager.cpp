@@ -1,5 +1,10 @@
 #include "asset_manager.h"
 
+#include <algorithm>
+#include <iomanip>
+#include <iterator>
+#include <unordered_set>
+
 namespace runtime
 {
 asset_manager::asset_manager()
@@ -12,19 +17,319 @@ asset_manager::~asset_manager()
 
 void asset_manager::clear()
 {
+	{
+		std::lock_guard<std::mutex> lock(group_mutex_);
+		for(const auto& pair : group_tokens_)
+		{
+			pair.second.cancel();
+		}
+		group_tokens_.clear();
+	}
+
 	for(auto& pair : storages_)
 	{
 		auto& storage = pair.second;
 		storage->clear();
 	}
+	remove_dependents("");
+	// the compiled data given in memory goes with the assets
+	fs::unmount_memory("");
 }
 
 void asset_manager::clear(const std::string& group)
 {
+	{
+		// the groups within the cleared one are cancelled whole, the loads
+		// of a group partly cleared are cancelled one by one by the storages
+		std::lock_guard<std::mutex> lock(group_mutex_);
+		for(auto it = std::begin(group_tokens_); it != std::end(group_tokens_);)
+		{
+			if(string_utils::begins_with(it->first, group))
+			{
+				it->second.cancel();
+				it = group_tokens_.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
 	for(auto& pair : storages_)
 	{
 		auto& storage = pair.second;
 		storage->clear(group);
 	}
+	remove_dependents(group);
+	fs::unmount_memory(fs::replace(group, ":/data", ":/cache").string());
+}
+
+core::cancellation_token asset_manager::get_group_token(const std::string& key)
+{
+	// the protocol and the first directory, e.g. app:/data
+	auto end = key.find(":/");
+	end = end == std::string::npos ? 0 : key.find('/', end + 2);
+
+	const auto group = key.substr(0, end);
+	std::lock_guard<std::mutex> lock(group_mutex_);
+	auto& token = group_tokens_[group];
+	if(!token.valid())
+	{
+		token = core::cancellation_token::create();
+	}
+	return token;
+}
+
+void asset_manager::update()
+{
+	++frame_;
+
+	std::vector<stream_request> to_start;
+	{
+		std::lock_guard<std::mutex> lock(stream_mutex_);
+		loads_in_flight_.erase(std::remove_if(std::begin(loads_in_flight_), std::end(loads_in_flight_),
+											  [](const auto& is_done) { return is_done(); }),
+							   std::end(loads_in_flight_));
+
+		const auto free_loads =
+			max_loads_ > loads_in_flight_.size() ? max_loads_ - loads_in_flight_.size() : 0;
+		std::vector<std::unordered_map<std::string, stream_request>::iterator> queued;
+		queued.reserve(stream_requests_.size());
+		for(auto it = stream_requests_.begin(); it != stream_requests_.end(); ++it)
+		{
+			queued.push_back(it);
+		}
+
+		const auto count = std::min(free_loads, queued.size());
+		std::partial_sort(std::begin(queued), std::begin(queued) + std::ptrdiff_t(count), std::end(queued),
+						  [](const auto& a, const auto& b) {
+							  return a->second.priority > b->second.priority;
+						  });
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			to_start.push_back(std::move(queued[i]->second));
+			stream_requests_.erase(queued[i]);
+		}
+	}
+
+	// started outside the lock, a load may request what it depends on
+	std::vector<std::function<bool()>> started;
+	started.reserve(to_start.size());
+	for(auto& r : to_start)
+	{
+		started.push_back(r.start(r.priority));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(stream_mutex_);
+		loads_in_flight_.insert(std::end(loads_in_flight_), std::begin(started), std::end(started));
+	}
+
+	// run outside the lock, those still waiting are put back
+	std::unordered_map<std::string, std::function<bool()>> reloads;
+	{
+		std::lock_guard<std::mutex> lock(reload_mutex_);
+		reloads.swap(deferred_reloads_);
+	}
+	for(auto it = reloads.begin(); it != reloads.end();)
+	{
+		it = it->second() ? reloads.erase(it) : std::next(it);
+	}
+	if(!reloads.empty())
+	{
+		std::lock_guard<std::mutex> lock(reload_mutex_);
+		deferred_reloads_.insert(std::begin(reloads), std::end(reloads));
+	}
+
+	upload_queue_.update();
+
+	std::size_t used = 0;
+	for(auto& pair : storages_)
+	{
+		pair.second->enforce_budget(frame_);
+		used += pair.second->get_used_memory();
+	}
+
+	const bool pressure = sweep_threshold_ > 0 && used > sweep_threshold_;
+	if(sweep_requested_.exchange(false) || pressure)
+	{
+		sweep();
+	}
+}
+
+std::size_t asset_manager::sweep()
+{
+	// the assets held by those evicted are let go of by the next pass
+	std::size_t evicted = 0;
+	for(std::size_t pass = 0; pass <= storages_.size(); ++pass)
+	{
+		std::size_t evicted_in_pass = 0;
+		for(auto& pair : storages_)
+		{
+			evicted_in_pass += pair.second->sweep();
+		}
+		evicted += evicted_in_pass;
+		if(evicted_in_pass == 0)
+		{
+			break;
+		}
+	}
+	return evicted;
+}
+
+void asset_manager::write_usage_report(std::ostream& os, std::size_t max_rows)
+{
+	std::vector<asset_usage> usages;
+	for(auto& pair : storages_)
+	{
+		pair.second->collect_usage(usages);
+	}
+
+	// the owners by what they hold, a link or an asset
+	std::unordered_map<const void*, std::vector<const asset_usage*>> owners;
+	for(const auto& usage : usages)
+	{
+		for(const auto owned : usage.owned)
+		{
+			owners[owned].push_back(&usage);
+		}
+	}
+
+	std::vector<const asset_usage*> held;
+	std::size_t held_bytes = 0;
+	for(const auto& usage : usages)
+	{
+		if(usage.handles > 0 || usage.pointers > 0 || usage.pinned)
+		{
+			held.push_back(&usage);
+			held_bytes += usage.size;
+		}
+	}
+	std::sort(std::begin(held), std::end(held),
+			  [](const asset_usage* a, const asset_usage* b) { return a->size > b->size; });
+
+	os << std::fixed << std::setprecision(2);
+	os << held.size() << " of " << usages.size() << " loaded assets held, " << double(held_bytes) / 1024.0
+	   << " KB\n";
+	os << "type, key, handles, pointers, KB, owners\n";
+	const auto rows = std::min(max_rows, held.size());
+	for(std::size_t i = 0; i < rows; ++i)
+	{
+		const auto& usage = *held[i];
+		os << usage.type << ", " << usage.key << ", " << usage.handles << ", " << usage.pointers << ", "
+		   << double(usage.size) / 1024.0 << ",";
+
+		std::size_t by_assets = 0;
+		for(const auto owned : {usage.link, usage.asset})
+		{
+			auto it = owners.find(owned);
+			if(it == owners.end())
+			{
+				continue;
+			}
+			for(const auto owner : it->second)
+			{
+				os << " " << owner->type << " " << owner->key;
+				++by_assets;
+			}
+		}
+		if(usage.pinned)
+		{
+			os << " pinned";
+		}
+		if(usage.handles + usage.pointers > long(by_assets))
+		{
+			os << " outside the assets";
+		}
+		os << "\n";
+	}
+}
+
+void asset_manager::add_dependent(std::size_t type, const asset_id& key, const std::string& dependency)
+{
+	std::lock_guard<std::mutex> lock(dependents_mutex_);
+	auto& dependents = dependents_[dependency];
+	const bool recorded =
+		std::any_of(std::begin(dependents), std::end(dependents),
+					[type, &key](const dependent& d) { return d.type == type && d.key == key; });
+	if(!recorded)
+	{
+		dependents.push_back({type, key});
+	}
+}
+
+std::size_t asset_manager::get_dependents_count() const
+{
+	std::lock_guard<std::mutex> lock(dependents_mutex_);
+	std::size_t count = 0;
+	for(const auto& pair : dependents_)
+	{
+		count += pair.second.size();
+	}
+	return count;
+}
+
+std::size_t asset_manager::reload_dependents(const std::string& key)
+{
+	// breadth first, a dependent is reloaded after what it depends on that
+	// is reloaded too
+	std::vector<dependent> to_reload;
+	{
+		std::lock_guard<std::mutex> lock(dependents_mutex_);
+		std::unordered_set<std::string> visited;
+		std::vector<std::string> open = {key};
+		for(std::size_t i = 0; i < open.size(); ++i)
+		{
+			auto it = dependents_.find(open[i]);
+			if(it == std::end(dependents_))
+			{
+				continue;
+			}
+			for(const auto& d : it->second)
+			{
+				if(visited.insert(std::to_string(d.type) + d.key.str()).second)
+				{
+					to_reload.push_back(d);
+					open.push_back(d.key.str());
+				}
+			}
+		}
+	}
+
+	// outside the lock, the reloads record what the assets are made of again
+	for(const auto& d : to_reload)
+	{
+		reloaders_.at(d.type)(d.key);
+	}
+	return to_reload.size();
+}
+
+void asset_manager::remove_dependents(const std::string& group)
+{
+	std::lock_guard<std::mutex> lock(dependents_mutex_);
+	for(auto it = std::begin(dependents_); it != std::end(dependents_);)
+	{
+		auto& dependents = it->second;
+		dependents.erase(std::remove_if(std::begin(dependents), std::end(dependents),
+										[&group](const dependent& d) {
+											return string_utils::begins_with(d.key.str(), group);
+										}),
+						 std::end(dependents));
+		if(dependents.empty() || string_utils::begins_with(it->first, group))
+		{
+			it = dependents_.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+std::size_t asset_manager::get_queued_requests() const
+{
+	std::lock_guard<std::mutex> lock(stream_mutex_);
+	return stream_requests_.size();
 }
 }
@@ -1,11 +1,18 @@
 #pragma once
 
+#include <atomic>
 #include <functional>
+#include <mutex>
+#include <ostream>
 #include <unordered_map>
+#include <vector>
 
 #include "asset_flags.h"
+#include "asset_load_stats.h"
 #include "asset_storage.h"
+#include "upload_queue.h"
 #include <cassert>
+#include <core/tasks/cancellation_token.h>
 
 namespace runtime
 {
@@ -18,9 +25,8 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : clear ()
 	/// <summary>
-	///
-	///
-	///
+	/// Lets all assets go and cancels the loads in flight. Their tasks still
+	/// queued are dropped, the running ones finish.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void clear();
@@ -28,12 +34,21 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : clear ()
 	/// <summary>
-	///
-	///
-	///
+	/// Lets the assets whose keys begin with the group go and cancels their
+	/// loads in flight.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void clear(const std::string& group);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_group_token ()
+	/// <summary>
+	/// The token the tasks of the loads of the key carry, one for all keys of
+	/// a group such as app:/data. It is cancelled by clearing a group that
+	/// covers it, a new one is made for the loads after.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	core::cancellation_token get_group_token(const std::string& key);
 	//-----------------------------------------------------------------------------
 	//  Name : add_storage ()
 	/// <summary>
@@ -43,79 +58,295 @@ public:
 	template <typename S, typename... Args>
 	asset_storage<S>& add_storage(Args&&... args)
 	{
-		auto operation = storages_.emplace(rtti::type_id<asset_storage<S>>().hash_code(),
-										   std::make_unique<asset_storage<S>>(std::forward<Args>(args)...));
+		const auto type = rtti::type_id<asset_storage<S>>().hash_code();
+		auto operation =
+			storages_.emplace(type, std::make_unique<asset_storage<S>>(std::forward<Args>(args)...));
+		// the dependents let go of are not loaded again by a reload
+		reloaders_[type] = [this](const asset_id& key) {
+			if(find_asset_entry<S>(key).valid())
+			{
+				load<S>(key, load_flags::reload);
+			}
+		};
 
 		return static_cast<asset_storage<S>&>(*operation.first->second);
 	}
 
 	template <typename T>
-	core::task_future<asset_handle<T>> load(const std::string& key, load_flags flags = load_flags::standard)
+	core::task_future<asset_handle<T>> load(const asset_id& key, load_flags flags = load_flags::standard)
 	{
 		auto& storage = get_storage<T>();
-		return load_asset_from_file_impl<T>(key, flags, storage.container_mutex, storage.container,
-											storage.load_from_file);
+		return load_asset_from_file_impl<T>(key, flags, storage.get_shard(key), storage.load_from_file);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : reload ()
+	/// <summary>
+	/// Reloads the asset, then the loaded assets recorded to depend on it and
+	/// those depending on them, each once, in place of a clear of what may be
+	/// stale. Returns how many dependents were reloaded.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <typename T>
+	std::size_t reload(const asset_id& key)
+	{
+		load<T>(key, load_flags::reload);
+		return reload_dependents(key.str());
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : add_dependent ()
+	/// <summary>
+	/// Records that the asset of the key, of type T, is made from the asset
+	/// of the dependency, for the reloads of the dependency to reload it too.
+	/// Called by the loaders with what they find an asset is made of, a pair
+	/// recorded again is kept once. Safe to call from any thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <typename T>
+	void add_dependent(const asset_id& key, const std::string& dependency)
+	{
+		const auto type = rtti::type_id<asset_storage<T>>().hash_code();
+		add_dependent(type, key, dependency);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_dependents_count ()
+	/// <summary>
+	/// The pairs of an asset and one it is made of recorded, for the stats.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t get_dependents_count() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : request ()
+	/// <summary>
+	/// Queues a load to be started by update, the higher the priority the
+	/// sooner, e.g. by the distance or the screen size of what needs it.
+	/// Requesting a queued key again updates its priority, requesting a
+	/// loaded one marks it as used. The asset is found with find_asset_entry
+	/// or load once started.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <typename T>
+	void request(const asset_id& key, float priority)
+	{
+		auto& storage = get_storage<T>();
+		{
+			auto& shard = storage.get_shard(key);
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			auto it = shard.container.find(key);
+			if(it != shard.container.end())
+			{
+				shard.last_used[key] = frame_;
+				if(!it->second.is_ready())
+				{
+					upload_queue_.set_priority(key, priority);
+				}
+				return;
+			}
+		}
+
+		const auto type = rtti::type_id<asset_storage<T>>().hash_code();
+		std::lock_guard<std::mutex> lock(stream_mutex_);
+		auto& queued = stream_requests_[std::to_string(type) + key.str()];
+		queued.priority = priority;
+		if(!queued.start)
+		{
+			queued.start = [this, key](float start_priority) -> std::function<bool()> {
+				upload_queue_.begin_request(key, start_priority);
+				auto future = load<T>(key);
+				upload_queue_.end_request(key);
+				return [future]() { return future.is_ready(); };
+			};
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : update ()
+	/// <summary>
+	/// Starts the queued requests by priority while fewer than the max loads
+	/// are in flight and the reloads deferred whose loads are in, admits the
+	/// uploads for the frame and enforces the budgets of the storages. Once a
+	/// frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void update();
+
+	void set_max_loads(std::size_t max_loads)
+	{
+		max_loads_ = max_loads;
+	}
+
+	std::size_t get_max_loads() const
+	{
+		return max_loads_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_budget ()
+	/// <summary>
+	/// Bytes the unreferenced assets of a type are evicted down to, 0 for no
+	/// budget. The storage needs its size_of to have one.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <typename T>
+	void set_budget(std::size_t budget)
+	{
+		get_storage<T>().budget = budget;
+	}
+
+	template <typename T>
+	std::size_t get_used_memory()
+	{
+		return get_storage<T>().get_used_memory();
+	}
+
+	std::size_t get_queued_requests() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : sweep ()
+	/// <summary>
+	/// Evicts every loaded asset nothing but the manager references, those
+	/// held only by the evicted ones too. Returns how many were evicted.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t sweep();
+
+	//-----------------------------------------------------------------------------
+	//  Name : request_sweep ()
+	/// <summary>
+	/// Has the next update sweep, e.g. after a scene change once the entities
+	/// of the old scene are gone.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void request_sweep()
+	{
+		sweep_requested_ = true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_sweep_threshold ()
+	/// <summary>
+	/// Bytes of loaded assets past which the update sweeps, 0 to never.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_sweep_threshold(std::size_t bytes)
+	{
+		sweep_threshold_ = bytes;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : write_usage_report ()
+	/// <summary>
+	/// Writes the loaded assets something still holds, the largest first,
+	/// with the assets that hold them. What is held from outside the assets,
+	/// e.g. by components, is only counted.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void write_usage_report(std::ostream& os, std::size_t max_rows);
+
+	/// the timings of the loads, the loaders add to them
+	asset_load_stats& get_load_stats()
+	{
+		return load_stats_;
+	}
+
+	/// the gpu uploads of the loads, the loaders push to it
+	upload_queue& get_upload_queue()
+	{
+		return upload_queue_;
 	}
 
 	//-----------------------------------------------------------------------------
 	//  Name : create_asset_from_memory ()
 	/// <summary>
-	///
-	///
-	///
+	/// Loads the asset from its compiled data in memory, as the loader of its
+	/// files would from the compiled file. The data is read in place, the
+	/// textures and the deserializers are given the bytes of the range and
+	/// nothing is copied. The range is held until the group of the key is
+	/// cleared, it is what a reload or a refetch reads. An asset already
+	/// stored is returned as it is.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	template <typename T>
-	core::task_future<asset_handle<T>>
-	create_asset_from_memory(const std::string& key, const std::uint8_t* data, const std::uint32_t& size,
-							 load_flags flags = load_flags::standard)
+	core::task_future<asset_handle<T>> create_asset_from_memory(const asset_id& key, fs::mapped_range data)
 	{
 		auto& storage = get_storage<T>();
-		return create_asset_from_memory_impl<T>(key, data, size, flags, storage.container_mutex,
-												storage.container, storage.load_from_memory);
+		return create_asset_from_memory_impl<T>(key, std::move(data), storage.get_shard(key),
+												storage.load_from_memory);
+	}
+
+	/// takes the buffer, it is freed with the last use of the data
+	template <typename T>
+	core::task_future<asset_handle<T>> create_asset_from_memory(const asset_id& key,
+																std::vector<std::uint8_t> buffer)
+	{
+		return create_asset_from_memory<T>(key, fs::make_memory_range(std::move(buffer)));
+	}
+
+	/// the release is called with the last use of the data
+	template <typename T>
+	core::task_future<asset_handle<T>>
+	create_asset_from_memory(const asset_id& key, const std::uint8_t* data, std::size_t size,
+							 std::function<void()> release)
+	{
+		return create_asset_from_memory<T>(key, fs::make_memory_range(data, size, std::move(release)));
 	}
 
 	template <typename T>
-	core::task_future<asset_handle<T>> find_asset_entry(const std::string& key)
+	core::task_future<asset_handle<T>> find_asset_entry(const asset_id& key)
 	{
 		auto& storage = get_storage<T>();
-		return find_asset_impl<T>(key, storage.container_mutex, storage.container);
+		return find_asset_impl<T>(key, storage.get_shard(key));
 	}
 
 	template <typename T>
-	core::task_future<asset_handle<T>> load_asset_from_instance(const std::string& key,
+	core::task_future<asset_handle<T>> load_asset_from_instance(const asset_id& key,
 																std::shared_ptr<T> entry)
 	{
 		auto& storage = get_storage<T>();
-		return load_asset_from_instance_impl(key, entry, storage.container_mutex, storage.container,
-											 storage.load_from_instance);
+		return load_asset_from_instance_impl<T>(key, entry, storage.get_shard(key),
+												storage.load_from_instance);
 	}
 
 	template <typename T>
-	void rename_asset(const std::string& key, const std::string& new_key)
+	void rename_asset(const asset_id& key, const asset_id& new_key)
 	{
 		auto& storage = get_storage<T>();
 
-		std::lock_guard<std::recursive_mutex> lock(storage.container_mutex);
-		auto it = storage.container.find(key);
-		if(it != storage.container.end())
+		core::task_future<asset_handle<T>> future;
 		{
-			auto& future = it->second;
-			auto asset = future.get();
-			asset.link->id = new_key;
-			storage.container[new_key] = future;
-			storage.container.erase(it);
+			auto& shard = storage.get_shard(key);
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			auto it = shard.container.find(key);
+			if(it == shard.container.end())
+			{
+				return;
+			}
+
+			future = it->second;
+			shard.container.erase(it);
+			shard.last_used.erase(key);
 		}
+
+		// the keys may be in different shards, one is locked at a time
+		auto asset = future.get();
+		asset.link->id = new_key;
+		auto& new_shard = storage.get_shard(new_key);
+		std::lock_guard<std::mutex> lock(new_shard.mutex);
+		new_shard.container[new_key] = future;
 	}
 
 	template <typename T>
-	void clear_asset(const std::string& key)
+	void clear_asset(const asset_id& key)
 	{
 		auto& storage = get_storage<T>();
+		auto& shard = storage.get_shard(key);
 
-		std::lock_guard<std::recursive_mutex> lock(storage.container_mutex);
-		auto it = storage.container.find(key);
-		if(it != storage.container.end())
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		auto it = shard.container.find(key);
+		if(it != shard.container.end())
 		{
 			auto& future = it->second;
 
@@ -123,7 +354,9 @@ public:
 			asset.link->asset.reset();
 			asset.link->id.clear();
 
-			storage.container.erase(it);
+			shard.container.erase(it);
+			shard.last_used.erase(key);
+			shard.pinned.erase(key);
 		}
 	}
 
@@ -131,117 +364,139 @@ private:
 	//-----------------------------------------------------------------------------
 	//  Name : load_asset_from_file_impl ()
 	/// <summary>
-	///
-	///
-	///
+	/// The load is dispatched outside the lock of the shard. Two threads
+	/// loading the same new key at once may both dispatch it, the first one
+	/// stored is kept and the other is cancelled.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	template <typename T, typename F>
-	core::task_future<asset_handle<T>>
-	load_asset_from_file_impl(const std::string& key, load_flags flags, std::recursive_mutex& container_mutex,
-							  typename asset_storage<T>::request_container_t& container, F&& load_func)
+	core::task_future<asset_handle<T>> load_asset_from_file_impl(const asset_id& key, load_flags flags,
+																 typename asset_storage<T>::shard& shard,
+																 F&& load_func)
 	{
-		std::unique_lock<std::recursive_mutex> lock(container_mutex);
-		auto it = container.find(key);
-		if(it != std::end(container))
+		core::task_future<asset_handle<T>> future;
+		bool found = false;
 		{
-			auto& future = it->second;
-			if(flags == load_flags::reload && future.is_ready())
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			auto it = shard.container.find(key);
+			if(it != std::end(shard.container))
+			{
+				future = it->second;
+				found = true;
+			}
+		}
+
+		if(found)
+		{
+			if(!future.is_ready())
 			{
-				if(load_func)
+				// it may be waited on now
+				upload_queue_.promote(key);
+				if(flags == load_flags::reload)
 				{
-					// calling the function on a locked mutex is ok
-					// since we dont expect this to actually
-					// do much except add tasks to the executor
-					load_func(future, key);
+					defer_reload<T>(key);
 				}
 			}
-			auto future_copy = future;
+			else if(flags == load_flags::reload && load_func)
+			{
+				// the reload replaces the stored future if it is still there
+				{
+					core::scoped_cancellation cancellation(get_group_token(key));
+					load_func(future, key);
+				}
 
-			lock.unlock();
+				std::lock_guard<std::mutex> lock(shard.mutex);
+				auto it = shard.container.find(key);
+				if(it != std::end(shard.container))
+				{
+					it->second = future;
+				}
+			}
 
-			return future_copy;
+			return future;
 		}
 
-		auto& future = container[key];
 		// Dispatch the loading
 		if(load_func)
 		{
-			// calling the function on a locked mutex is ok
-			// since we dont expect this to actually
-			// do much except add tasks to the executor
+			core::scoped_cancellation cancellation(get_group_token(key));
 			load_func(future, key);
 		}
 
-		return future;
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		auto result = shard.container.emplace(key, future);
+		if(!result.second)
+		{
+			future.cancel();
+		}
+		return result.first->second;
 	}
 
 	//-----------------------------------------------------------------------------
 	//  Name : create_asset_from_memory_impl ()
 	/// <summary>
-	///
-	///
-	///
+	/// As load_asset_from_file_impl, a second range given for a key being
+	/// loaded is dropped.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	template <typename T, typename F>
-	core::task_future<asset_handle<T>>&
-	create_asset_from_memory_impl(const std::string& key, const std::uint8_t* data, const std::uint32_t& size,
-								  load_flags /*flags*/, std::recursive_mutex& container_mutex,
-								  typename asset_storage<T>::request_container_t& container, F&& load_func)
+	core::task_future<asset_handle<T>>
+	create_asset_from_memory_impl(const asset_id& key, fs::mapped_range data,
+								  typename asset_storage<T>::shard& shard, F&& load_func)
 	{
-
-		std::lock_guard<std::recursive_mutex> lock(container_mutex);
-		auto it = container.find(key);
-		if(it != std::end(container))
 		{
-			// If there is already a loading request.
-			auto& future = it->second;
-			return future;
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			auto it = shard.container.find(key);
+			if(it != std::end(shard.container))
+			{
+				// If there is already a loading request.
+				return it->second;
+			}
 		}
 
-		auto& future = container[key];
+		core::task_future<asset_handle<T>> future;
 		// Dispatch the loading
 		if(load_func)
 		{
-			// calling the function on a locked mutex is ok
-			// since we dont expect this to actually
-			// do much except add tasks to the executor
-			load_func(future, key, data, size);
+			core::scoped_cancellation cancellation(get_group_token(key));
+			load_func(future, key, data);
 		}
 
-		return future;
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		auto result = shard.container.emplace(key, future);
+		if(!result.second)
+		{
+			future.cancel();
+		}
+		return result.first->second;
 	}
 
 	template <typename T, typename F>
-	core::task_future<asset_handle<T>>&
-	load_asset_from_instance_impl(const std::string& key, std::shared_ptr<T> entry,
-								  std::recursive_mutex& container_mutex,
-								  typename asset_storage<T>::request_container_t& container, F&& load_func)
+	core::task_future<asset_handle<T>> load_asset_from_instance_impl(const asset_id& key,
+																	 std::shared_ptr<T> entry,
+																	 typename asset_storage<T>::shard& shard,
+																	 F&& load_func)
 	{
-		std::lock_guard<std::recursive_mutex> lock(container_mutex);
-		auto& future = container[key];
+		core::task_future<asset_handle<T>> future;
 		// Dispatch the loading
 		if(load_func)
 		{
-			// loading on a locked mutex is ok
-			// since we dont expect this to actually
-			// do much except add tasks to the
-			// executor
 			load_func(future, key, entry);
 		}
 
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		shard.container[key] = future;
+		shard.pinned.insert(key);
 		return future;
 	}
 
 	template <typename T>
-	core::task_future<asset_handle<T>>
-	find_asset_impl(const std::string& key, std::recursive_mutex& container_mutex,
-					typename asset_storage<T>::request_container_t& container)
+	core::task_future<asset_handle<T>> find_asset_impl(const asset_id& key,
+													   typename asset_storage<T>::shard& shard)
 	{
-		std::lock_guard<std::recursive_mutex> lock(container_mutex);
-		auto it = container.find(key);
-		if(it != container.end())
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		auto it = shard.container.find(key);
+		if(it != shard.container.end())
 		{
 			return it->second;
 		}
@@ -249,6 +504,63 @@ private:
 		return {};
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : defer_reload ()
+	/// <summary>
+	/// Reloads an asset once the load in flight is in, what it read may be
+	/// older than what was saved. The reloads asked for meanwhile are one.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <typename T>
+	void defer_reload(const asset_id& key)
+	{
+		const auto type = rtti::type_id<asset_storage<T>>().hash_code();
+		std::lock_guard<std::mutex> lock(reload_mutex_);
+		auto& reload = deferred_reloads_[std::to_string(type) + key.str()];
+		if(!reload)
+		{
+			reload = [this, key]() {
+				auto future = find_asset_entry<T>(key);
+				if(future.valid() && !future.is_ready())
+				{
+					return false;
+				}
+				if(future.valid())
+				{
+					load<T>(key, load_flags::reload);
+				}
+				return true;
+			};
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : add_dependent ()
+	/// <summary>
+	/// Records the dependent by the hash of its storage type, for the
+	/// reloads to find its storage. A pair recorded again is kept once.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void add_dependent(std::size_t type, const asset_id& key, const std::string& dependency);
+
+	//-----------------------------------------------------------------------------
+	//  Name : reload_dependents ()
+	/// <summary>
+	/// Reloads what depends on the key, through the dependents of the
+	/// dependents, those of every depth after the ones they depend on.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t reload_dependents(const std::string& key);
+
+	//-----------------------------------------------------------------------------
+	//  Name : remove_dependents ()
+	/// <summary>
+	/// Forgets the dependencies of the group and what depends on them, all
+	/// of them for an empty group.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void remove_dependents(const std::string& group);
+
 	//-----------------------------------------------------------------------------
 	//  Name : get_storage ()
 	/// <summary>
@@ -262,7 +574,43 @@ private:
 		assert(it != storages_.end());
 		return (static_cast<asset_storage<S>&>(*it->second.get()));
 	}
+	struct stream_request
+	{
+		float priority = 0.0f;
+		/// starts the load with the priority and returns whether it is done
+		std::function<std::function<bool()>(float)> start;
+	};
+
 	/// Different storages
 	std::unordered_map<std::size_t, std::unique_ptr<basic_storage>> storages_;
+	/// queued requests by their type and key
+	std::unordered_map<std::string, stream_request> stream_requests_;
+	/// whether the started requests are done
+	std::vector<std::function<bool()>> loads_in_flight_;
+	mutable std::mutex stream_mutex_;
+	/// an asset depending on another, by the type of its storage
+	struct dependent
+	{
+		std::size_t type = 0;
+		asset_id key;
+	};
+
+	/// what depends on every key, recorded by the loaders
+	std::unordered_map<std::string, std::vector<dependent>> dependents_;
+	mutable std::mutex dependents_mutex_;
+	/// reload a loaded asset of a storage, by its type
+	std::unordered_map<std::size_t, std::function<void(const asset_id&)>> reloaders_;
+	/// reloads waiting for the load in flight of their asset, by type and key
+	std::unordered_map<std::string, std::function<bool()>> deferred_reloads_;
+	std::mutex reload_mutex_;
+	std::size_t max_loads_ = 8;
+	std::atomic<std::uint64_t> frame_ = {0};
+	std::atomic<bool> sweep_requested_ = {false};
+	std::size_t sweep_threshold_ = 0;
+	asset_load_stats load_stats_;
+	upload_queue upload_queue_;
+	/// the tokens of the groups loaded since they were last cleared
+	std::unordered_map<std::string, core::cancellation_token> group_tokens_;
+	std::mutex group_mutex_;
 };
 }
@@ -0,0 +1,76 @@
+#include "asset_manifest.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace runtime
+{
+namespace
+{
+template <typename T>
+void write_value(std::ostream& stream, T value)
+{
+	stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool read_value(const std::uint8_t*& data, const std::uint8_t* end, T& value)
+{
+	if(std::size_t(end - data) < sizeof(value))
+	{
+		return false;
+	}
+	std::memcpy(&value, data, sizeof(value));
+	data += sizeof(value);
+	return true;
+}
+}
+
+constexpr std::uint32_t asset_manifest::magic;
+
+void asset_manifest::write(std::ostream& stream) const
+{
+	write_value(stream, magic);
+	write_value(stream, std::uint32_t(dependencies.size()));
+	for(const auto& dep : dependencies)
+	{
+		const auto key_size = std::uint16_t(std::min<std::size_t>(dep.key.size(), 0xffff));
+		write_value(stream, dep.type);
+		write_value(stream, key_size);
+		stream.write(dep.key.data(), key_size);
+	}
+}
+
+std::size_t asset_manifest::read(const std::uint8_t* data, std::size_t size)
+{
+	dependencies.clear();
+
+	const auto begin = data;
+	const auto end = data + size;
+	std::uint32_t value = 0;
+	std::uint32_t count = 0;
+	if(!read_value(data, end, value) || value != magic || !read_value(data, end, count))
+	{
+		return 0;
+	}
+
+	dependencies.reserve(std::min<std::size_t>(count, size));
+	for(std::uint32_t i = 0; i < count; ++i)
+	{
+		dependency dep;
+		std::uint16_t key_size = 0;
+		if(!read_value(data, end, dep.type) || !read_value(data, end, key_size) ||
+		   std::size_t(end - data) < key_size)
+		{
+			dependencies.clear();
+			return 0;
+		}
+
+		dep.key.assign(reinterpret_cast<const char*>(data), key_size);
+		data += key_size;
+		dependencies.push_back(std::move(dep));
+	}
+
+	return std::size_t(data - begin);
+}
+}
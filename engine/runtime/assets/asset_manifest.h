@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace runtime
+{
+/*
+ * asset_manifest; the assets a scene or a prefab references, written in
+ * front of its compiled data so that they can all be loaded at once before
+ * the entities are read.
+ *
+ *      The manifest is the magic, the count of the dependencies and then
+ *      every dependency as its type, the size of its key and the key. The
+ *      integers are little endian. Compiled data without the magic has no
+ *      manifest and is read whole.
+ */
+struct asset_manifest
+{
+	enum class asset_type : std::uint8_t
+	{
+		texture,
+		mesh,
+		material,
+		sound,
+		animation,
+	};
+
+	struct dependency
+	{
+		asset_type type = asset_type::texture;
+		std::string key;
+	};
+
+	static constexpr std::uint32_t magic = 0x4d504445; // EDPM
+
+	//-----------------------------------------------------------------------------
+	//  Name : write ()
+	/// <summary>
+	/// Writes the manifest, the compiled data is to follow it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void write(std::ostream& stream) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : read ()
+	/// <summary>
+	/// Reads the manifest from the front of the compiled data and returns the
+	/// bytes it took, 0 when the data does not start with one.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t read(const std::uint8_t* data, std::size_t size);
+
+	std::vector<dependency> dependencies;
+};
+}
@@ -1,9 +1,17 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <functional>
+#include <mutex>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include <core/common/nonstd/type_index.hpp>
+#include <core/filesystem/archive.h>
 #include <core/string_utils/string_utils.h>
 #include <core/tasks/task_system.h>
 
@@ -12,6 +20,22 @@
 
 namespace runtime
 {
+/// what holds a loaded asset, for the report of the assets kept
+struct asset_usage
+{
+	std::string key;
+	const char* type = "";
+	/// the handles and the pointers besides those of the storage
+	long handles = 0;
+	long pointers = 0;
+	std::size_t size = 0;
+	bool pinned = false;
+	/// the link and the asset, for the owners to tell what they hold
+	const void* link = nullptr;
+	const void* asset = nullptr;
+	/// the links or assets the asset holds
+	std::vector<const void*> owned;
+};
 
 struct basic_storage
 {
@@ -44,20 +68,81 @@ struct basic_storage
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	virtual void clear(const std::string& group) = 0;
+
+	//-----------------------------------------------------------------------------
+	//  Name : enforce_budget (virtual )
+	/// <summary>
+	/// Marks the referenced assets as used in the frame and evicts the
+	/// unreferenced ones least recently used first while over the budget.
+	/// Returns how many were evicted.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual std::size_t enforce_budget(std::uint64_t frame) = 0;
+
+	/// bytes the loaded assets took at the last enforce_budget
+	virtual std::size_t get_used_memory() const = 0;
+
+	//-----------------------------------------------------------------------------
+	//  Name : sweep (virtual )
+	/// <summary>
+	/// Evicts every loaded asset nothing but the storage references, whatever
+	/// the budget. Returns how many were evicted.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual std::size_t sweep() = 0;
+
+	//-----------------------------------------------------------------------------
+	//  Name : collect_usage (virtual )
+	/// <summary>
+	/// Adds what holds every loaded asset to the usages.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void collect_usage(std::vector<asset_usage>& usages) = 0;
+
+	/// the name of the type in the reports
+	const char* name = "asset";
 };
 
 template <typename T>
 struct asset_storage : public basic_storage
 {
 	/// aliases
-	using request_container_t = std::unordered_map<std::string, core::task_future<asset_handle<T>>>;
+	using request_container_t =
+		std::unordered_map<asset_id, core::task_future<asset_handle<T>>, asset_id::hasher>;
 	template <typename F>
 	using callable = std::function<F>;
-	using load_from_file_t = callable<bool(core::task_future<asset_handle<T>>&, const std::string&)>;
+	using load_from_file_t = callable<bool(core::task_future<asset_handle<T>>&, const asset_id&)>;
 	using load_from_instance_t =
-		callable<bool(core::task_future<asset_handle<T>>&, const std::string&, std::shared_ptr<T>)>;
+		callable<bool(core::task_future<asset_handle<T>>&, const asset_id&, std::shared_ptr<T>)>;
+	using load_from_memory_t =
+		callable<bool(core::task_future<asset_handle<T>>&, const asset_id&, const fs::mapped_range&)>;
 
 	using predicate_t = callable<bool(const typename request_container_t::value_type&)>;
+	using size_of_t = callable<std::size_t(const T&)>;
+	using visit_owned_t = callable<void(const T&, const callable<void(const void*)>&)>;
+
+	/*
+	 * shard; the assets of some of the key hashes behind a lock of their
+	 * own, so loads of different keys rarely wait on each other.
+	 */
+	struct shard
+	{
+		/// Storage container
+		request_container_t container;
+
+		/// the frame every asset was last seen referenced
+		std::unordered_map<asset_id, std::uint64_t, asset_id::hasher> last_used;
+
+		/// assets that can not be loaded again
+		std::unordered_set<asset_id, asset_id::hasher> pinned;
+
+		/// Mutex
+		std::mutex mutex;
+	};
+
+	static constexpr std::size_t shard_bits = 4;
+	static constexpr std::size_t shards_count = std::size_t(1) << shard_bits;
+
 	//-----------------------------------------------------------------------------
 	//  Name : ~storage ()
 	/// <summary>
@@ -68,18 +153,35 @@ struct asset_storage : public basic_storage
 	//-----------------------------------------------------------------------------
 	~asset_storage() override = default;
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_shard ()
+	/// <summary>
+	/// The shard of a key, by the top bits of its hash since the containers
+	/// bucket by the low ones.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	shard& get_shard(const asset_id& key)
+	{
+		return shards[key.hash() >> (64 - shard_bits)];
+	}
+
 	void clear_with_condition(const predicate_t& predicate)
 	{
-		std::lock_guard<std::recursive_mutex> lock(container_mutex);
-		for(auto it = container.cbegin(); it != container.cend();)
+		for(auto& s : shards)
 		{
-			if(predicate(*it))
+			std::lock_guard<std::mutex> lock(s.mutex);
+			for(auto it = s.container.cbegin(); it != s.container.cend();)
 			{
-				it = container.erase(it);
-			}
-			else
-			{
-				++it;
+				if(predicate(*it))
+				{
+					s.last_used.erase(it->first);
+					s.pinned.erase(it->first);
+					it = s.container.erase(it);
+				}
+				else
+				{
+					++it;
+				}
 			}
 		}
 	}
@@ -111,7 +213,7 @@ struct asset_storage : public basic_storage
 	void clear(const std::string& group) final
 	{
 		clear_with_condition([&group](const auto& it) {
-			const auto& id = it.first;
+			const auto& id = it.first.str();
 			const auto& task = it.second;
 
 			if(string_utils::begins_with(id, group))
@@ -123,16 +225,192 @@ struct asset_storage : public basic_storage
 		});
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : enforce_budget ()
+	/// <summary>
+	/// An asset is unreferenced when the storage holds the only handle and
+	/// the only pointer to it. The pinned ones, made from instances, can not
+	/// be loaded again and are never evicted. The shards are locked one at a
+	/// time, a candidate is checked again when it is evicted.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t enforce_budget(std::uint64_t frame) final
+	{
+		struct candidate
+		{
+			const asset_id* key = nullptr;
+			shard* owner = nullptr;
+			std::uint64_t last_used = 0;
+			std::size_t size = 0;
+		};
+
+		if(!size_of)
+		{
+			return 0;
+		}
+
+		const auto is_referenced = [](const asset_handle<T>& handle) {
+			return handle.use_count() > 1 || handle.link->asset.use_count() > 1;
+		};
+
+		std::size_t used = 0;
+		std::vector<asset_id> keys;
+		std::vector<candidate> candidates;
+		for(auto& s : shards)
+		{
+			std::lock_guard<std::mutex> lock(s.mutex);
+			for(const auto& pair : s.container)
+			{
+				const auto& future = pair.second;
+				if(!future.is_ready())
+				{
+					continue;
+				}
+
+				const auto& handle = future.get();
+				const auto& asset = handle.link->asset;
+				const auto size = asset ? size_of(*asset) : 0;
+				used += size;
+
+				if(is_referenced(handle) || s.pinned.count(pair.first) != 0)
+				{
+					s.last_used[pair.first] = frame;
+				}
+				else
+				{
+					candidates.push_back({nullptr, &s, s.last_used[pair.first], size});
+					keys.push_back(pair.first);
+				}
+			}
+		}
+
+		std::size_t evicted = 0;
+		const auto max_used = budget.load();
+		if(max_used > 0 && used > max_used)
+		{
+			for(std::size_t i = 0; i < candidates.size(); ++i)
+			{
+				candidates[i].key = &keys[i];
+			}
+			std::sort(std::begin(candidates), std::end(candidates),
+					  [](const candidate& a, const candidate& b) { return a.last_used < b.last_used; });
+			for(const auto& c : candidates)
+			{
+				if(used <= max_used)
+				{
+					break;
+				}
+
+				std::lock_guard<std::mutex> lock(c.owner->mutex);
+				auto it = c.owner->container.find(*c.key);
+				if(it == c.owner->container.end() || !it->second.is_ready() ||
+				   is_referenced(it->second.get()))
+				{
+					continue;
+				}
+
+				c.owner->container.erase(it);
+				c.owner->last_used.erase(*c.key);
+				used -= c.size;
+				++evicted;
+			}
+		}
+
+		used_memory = used;
+		return evicted;
+	}
+
+	std::size_t get_used_memory() const final
+	{
+		return used_memory;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : sweep ()
+	/// <summary>
+	/// The assets another asset of the storage holds are only let go of when
+	/// that one is, a sweep of the manager goes over the storages again.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t sweep() final
+	{
+		std::size_t evicted = 0;
+		clear_with_condition([this, &evicted](const auto& it) {
+			const auto& future = it.second;
+			if(!future.is_ready() || get_shard(it.first).pinned.count(it.first) != 0)
+			{
+				return false;
+			}
+			const auto& handle = future.get();
+			if(handle.use_count() > 1 || handle.link->asset.use_count() > 1)
+			{
+				return false;
+			}
+			++evicted;
+			return true;
+		});
+		return evicted;
+	}
+
+	void collect_usage(std::vector<asset_usage>& usages) final
+	{
+		for(auto& s : shards)
+		{
+			std::lock_guard<std::mutex> lock(s.mutex);
+			for(const auto& pair : s.container)
+			{
+				if(!pair.second.is_ready())
+				{
+					continue;
+				}
+
+				const auto& handle = pair.second.get();
+				const auto& asset = handle.link->asset;
+				asset_usage usage;
+				usage.key = pair.first.str();
+				usage.type = name;
+				usage.handles = handle.use_count() - 1;
+				usage.pointers = asset ? asset.use_count() - 1 : 0;
+				usage.size = asset && size_of ? size_of(*asset) : 0;
+				usage.pinned = s.pinned.count(pair.first) != 0;
+				usage.link = handle.link.get();
+				usage.asset = asset.get();
+				if(asset && visit_owned)
+				{
+					visit_owned(*asset, [&usage](const void* owned) { usage.owned.push_back(owned); });
+				}
+				usages.emplace_back(std::move(usage));
+			}
+		}
+	}
+
 	/// key, mode
 	load_from_file_t load_from_file;
 
 	/// key, mode
 	load_from_instance_t load_from_instance;
 
-	/// Storage container
-	request_container_t container;
+	/// key, the compiled data held in memory
+	load_from_memory_t load_from_memory;
+
+	/// memory of an asset, the storage has no budget without it
+	size_of_t size_of;
+
+	/// the links or assets an asset holds, for the report of their owners
+	visit_owned_t visit_owned;
 
-	/// Mutex
-	std::recursive_mutex container_mutex;
+	/// bytes the unreferenced assets are evicted down to, 0 for no budget
+	std::atomic<std::size_t> budget = {0};
+
+	/// bytes at the last enforce_budget
+	std::atomic<std::size_t> used_memory = {0};
+
+	/// the assets by the top bits of their key hash
+	std::array<shard, shards_count> shards;
 };
+
+template <typename T>
+constexpr std::size_t asset_storage<T>::shard_bits;
+template <typename T>
+constexpr std::size_t asset_storage<T>::shards_count;
 }
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+namespace runtime
+{
+namespace flat_layout
+{
+/// every section starts on a boundary of this
+constexpr std::uint64_t alignment = 16;
+
+/*
+ * writer; writes the sections of a flat layout one after the other, each
+ * on the alignment.
+ */
+class writer
+{
+public:
+	explicit writer(std::ostream& stream, std::uint64_t offset = 0)
+		: stream_(stream)
+		, offset_(offset)
+	{
+	}
+
+	/// pads to the alignment and returns the offset the section starts at
+	std::uint64_t begin_section()
+	{
+		static const char zeros[alignment] = {};
+		const auto padding = (alignment - offset_ % alignment) % alignment;
+		write(zeros, std::size_t(padding));
+		return offset_;
+	}
+
+	void write(const void* data, std::size_t size)
+	{
+		if(size > 0)
+		{
+			stream_.write(static_cast<const char*>(data), std::streamsize(size));
+			offset_ += size;
+		}
+	}
+
+	std::uint64_t get_offset() const
+	{
+		return offset_;
+	}
+
+	bool good() const
+	{
+		return bool(stream_);
+	}
+
+private:
+	std::ostream& stream_;
+	std::uint64_t offset_ = 0;
+};
+
+/// whether count elements of the size at the offset fit in the data
+inline bool in_range(std::uint64_t offset, std::uint64_t count, std::uint64_t element_size,
+					 std::uint64_t size)
+{
+	return offset <= size && (element_size == 0 || count <= (size - offset) / element_size);
+}
+
+/// reads a struct without assuming the data is aligned for it
+template <typename T>
+T read_at(const std::uint8_t* data, std::uint64_t offset)
+{
+	T result;
+	std::memcpy(&result, data + offset, sizeof(T));
+	return result;
+}
+
+/// appends a name to the names section and where it is in it
+inline void add_name(std::string& names, const std::string& name, std::uint32_t& offset,
+					 std::uint32_t& size)
+{
+	offset = std::uint32_t(names.size());
+	size = std::uint32_t(name.size());
+	names += name;
+}
+
+inline bool read_name(const char* names, std::uint64_t names_size, std::uint32_t offset,
+					  std::uint32_t size, std::string& name)
+{
+	if(!in_range(offset, size, 1, names_size))
+	{
+		return false;
+	}
+	name.assign(names + offset, size);
+	return true;
+}
+}
+}
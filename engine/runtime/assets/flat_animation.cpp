@@ -0,0 +1,337 @@
+#include "flat_animation.h"
+#include "detail/flat_layout.h"
+
+#include <string>
+#include <vector>
+
+namespace runtime
+{
+namespace
+{
+// before the keys were compressed
+struct header
+{
+	std::uint32_t magic = 0;
+	std::uint32_t version = 0;
+	std::uint32_t channels_count = 0;
+	std::uint32_t position_keys_count = 0;
+	std::uint32_t rotation_keys_count = 0;
+	std::uint32_t scaling_keys_count = 0;
+	std::uint32_t name_offset = 0;
+	std::uint32_t name_size = 0;
+	std::uint32_t names_size = 0;
+	float duration = 0.0f;
+	std::uint64_t channels_offset = 0;
+	std::uint64_t position_keys_offset = 0;
+	std::uint64_t rotation_keys_offset = 0;
+	std::uint64_t scaling_keys_offset = 0;
+	std::uint64_t names_offset = 0;
+};
+
+struct flat_channel
+{
+	std::uint32_t name_offset = 0;
+	std::uint32_t name_size = 0;
+	std::uint32_t first_position = 0;
+	std::uint32_t positions_count = 0;
+	std::uint32_t first_rotation = 0;
+	std::uint32_t rotations_count = 0;
+	std::uint32_t first_scaling = 0;
+	std::uint32_t scalings_count = 0;
+};
+
+struct flat_vec3_key
+{
+	float time = 0.0f;
+	float value[3] = {};
+};
+
+struct flat_quat_key
+{
+	float time = 0.0f;
+	float value[4] = {};
+};
+
+struct clip_header
+{
+	std::uint32_t magic = 0;
+	std::uint32_t version = 0;
+	std::uint32_t channels_count = 0;
+	std::uint32_t keys_count = 0;
+	std::uint32_t name_offset = 0;
+	std::uint32_t name_size = 0;
+	std::uint32_t names_size = 0;
+	float duration = 0.0f;
+	float time_scale = 0.0f;
+	std::uint32_t reserved = 0;
+	std::uint64_t channels_offset = 0;
+	std::uint64_t times_offset = 0;
+	std::uint64_t values_offset = 0;
+	std::uint64_t names_offset = 0;
+};
+
+struct flat_track
+{
+	std::uint32_t first = 0;
+	std::uint32_t count = 0;
+	float min[3] = {};
+	float scale[3] = {};
+};
+
+struct flat_clip_channel
+{
+	std::uint32_t name_offset = 0;
+	std::uint32_t name_size = 0;
+	flat_track position;
+	flat_track rotation;
+	flat_track scaling;
+};
+
+flat_track to_flat(const animation_clip::track& t)
+{
+	flat_track result;
+	result.first = t.first;
+	result.count = t.count;
+	result.min[0] = t.min.x;
+	result.min[1] = t.min.y;
+	result.min[2] = t.min.z;
+	result.scale[0] = t.scale.x;
+	result.scale[1] = t.scale.y;
+	result.scale[2] = t.scale.z;
+	return result;
+}
+
+// false when the keys are outside of the section
+bool from_flat(const flat_track& t, std::uint32_t keys_count, animation_clip::track& result)
+{
+	if(std::uint64_t(t.first) + t.count > keys_count)
+	{
+		return false;
+	}
+
+	result.first = t.first;
+	result.count = t.count;
+	result.min = math::vec4(t.min[0], t.min[1], t.min[2], 0.0f);
+	result.scale = math::vec4(t.scale[0], t.scale[1], t.scale[2], 0.0f);
+	return true;
+}
+
+void from_flat(const flat_vec3_key& k, node_animation::key<math::vec3>& result)
+{
+	result.time = node_animation::seconds_t(k.time);
+	result.value = math::vec3(k.value[0], k.value[1], k.value[2]);
+}
+
+void from_flat(const flat_quat_key& k, node_animation::key<math::quat>& result)
+{
+	result.time = node_animation::seconds_t(k.time);
+	result.value.x = k.value[0];
+	result.value.y = k.value[1];
+	result.value.z = k.value[2];
+	result.value.w = k.value[3];
+}
+
+// the range of the keys of a channel, false when outside of the section
+template <typename F, typename K>
+bool read_keys(const std::uint8_t* data, std::uint64_t offset, std::uint32_t total, std::uint32_t first,
+			   std::uint32_t count, std::vector<K>& keys)
+{
+	if(std::uint64_t(first) + count > total)
+	{
+		return false;
+	}
+
+	std::vector<F> flat(count);
+	std::memcpy(flat.data(), data + offset + first * sizeof(F), count * sizeof(F));
+	keys.resize(count);
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		from_flat(flat[i], keys[i]);
+	}
+	return true;
+}
+
+// the keys as they were compiled
+bool read_uncompressed(const std::uint8_t* data, std::size_t size, animation& anim)
+{
+	if(size < sizeof(header))
+	{
+		return false;
+	}
+
+	const auto h = flat_layout::read_at<header>(data, 0);
+
+	using flat_layout::in_range;
+	if(!in_range(h.channels_offset, h.channels_count, sizeof(flat_channel), size) ||
+	   !in_range(h.position_keys_offset, h.position_keys_count, sizeof(flat_vec3_key), size) ||
+	   !in_range(h.rotation_keys_offset, h.rotation_keys_count, sizeof(flat_quat_key), size) ||
+	   !in_range(h.scaling_keys_offset, h.scaling_keys_count, sizeof(flat_vec3_key), size) ||
+	   !in_range(h.names_offset, h.names_size, 1, size))
+	{
+		return false;
+	}
+
+	const auto names = reinterpret_cast<const char*>(data + h.names_offset);
+	if(!flat_layout::read_name(names, h.names_size, h.name_offset, h.name_size, anim.name))
+	{
+		return false;
+	}
+	anim.duration = animation::seconds_t(h.duration);
+
+	anim.channels.clear();
+	anim.channels.resize(h.channels_count);
+	for(std::uint32_t i = 0; i < h.channels_count; ++i)
+	{
+		const auto c =
+			flat_layout::read_at<flat_channel>(data, h.channels_offset + i * sizeof(flat_channel));
+		auto& channel = anim.channels[i];
+		if(!flat_layout::read_name(names, h.names_size, c.name_offset, c.name_size, channel.node_name) ||
+		   !read_keys<flat_vec3_key>(data, h.position_keys_offset, h.position_keys_count, c.first_position,
+									 c.positions_count, channel.position_keys) ||
+		   !read_keys<flat_quat_key>(data, h.rotation_keys_offset, h.rotation_keys_count, c.first_rotation,
+									 c.rotations_count, channel.rotation_keys) ||
+		   !read_keys<flat_vec3_key>(data, h.scaling_keys_offset, h.scaling_keys_count, c.first_scaling,
+									 c.scalings_count, channel.scaling_keys))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool read_compressed(const std::uint8_t* data, std::size_t size, animation& anim)
+{
+	if(size < sizeof(clip_header))
+	{
+		return false;
+	}
+
+	const auto h = flat_layout::read_at<clip_header>(data, 0);
+	using flat_layout::in_range;
+	if(!in_range(h.channels_offset, h.channels_count, sizeof(flat_clip_channel), size) ||
+	   !in_range(h.times_offset, h.keys_count, sizeof(std::uint16_t), size) ||
+	   !in_range(h.values_offset, h.keys_count, sizeof(animation_clip::packed_value), size) ||
+	   !in_range(h.names_offset, h.names_size, 1, size))
+	{
+		return false;
+	}
+
+	const auto names = reinterpret_cast<const char*>(data + h.names_offset);
+	if(!flat_layout::read_name(names, h.names_size, h.name_offset, h.name_size, anim.name))
+	{
+		return false;
+	}
+	anim.duration = animation::seconds_t(h.duration);
+
+	auto& clip = anim.clip;
+	clip.duration = h.duration;
+	clip.time_scale = h.time_scale;
+	clip.channels.clear();
+	clip.channels.resize(h.channels_count);
+	anim.channels.clear();
+	anim.channels.resize(h.channels_count);
+	for(std::uint32_t i = 0; i < h.channels_count; ++i)
+	{
+		const auto c =
+			flat_layout::read_at<flat_clip_channel>(data, h.channels_offset + i * sizeof(flat_clip_channel));
+		auto& channel = clip.channels[i];
+		if(!flat_layout::read_name(names, h.names_size, c.name_offset, c.name_size, channel.node_name) ||
+		   !from_flat(c.position, h.keys_count, channel.position) ||
+		   !from_flat(c.rotation, h.keys_count, channel.rotation) ||
+		   !from_flat(c.scaling, h.keys_count, channel.scaling))
+		{
+			return false;
+		}
+
+		// only the names, the keys are in the clip
+		anim.channels[i].node_name = channel.node_name;
+	}
+
+	clip.times.resize(h.keys_count);
+	std::memcpy(clip.times.data(), data + h.times_offset, clip.times.size() * sizeof(std::uint16_t));
+	clip.values.resize(h.keys_count);
+	std::memcpy(clip.values.data(), data + h.values_offset,
+				clip.values.size() * sizeof(animation_clip::packed_value));
+	return true;
+}
+}
+
+constexpr std::uint32_t flat_animation::magic;
+constexpr std::uint32_t flat_animation::version;
+constexpr std::uint32_t flat_animation::uncompressed_version;
+
+bool flat_animation::write(std::ostream& stream, const animation& anim)
+{
+	const auto& clip = anim.clip;
+	std::string names;
+	std::vector<flat_clip_channel> channels;
+
+	clip_header h;
+	h.magic = magic;
+	h.version = version;
+	h.duration = clip.duration;
+	h.time_scale = clip.time_scale;
+	flat_layout::add_name(names, anim.name, h.name_offset, h.name_size);
+	for(const auto& channel : clip.channels)
+	{
+		flat_clip_channel c;
+		flat_layout::add_name(names, channel.node_name, c.name_offset, c.name_size);
+		c.position = to_flat(channel.position);
+		c.rotation = to_flat(channel.rotation);
+		c.scaling = to_flat(channel.scaling);
+		channels.push_back(c);
+	}
+
+	h.channels_count = std::uint32_t(channels.size());
+	h.keys_count = std::uint32_t(clip.times.size());
+	h.names_size = std::uint32_t(names.size());
+
+	std::uint64_t offset = sizeof(clip_header);
+	const auto section = [&offset](std::uint64_t size) {
+		offset += (flat_layout::alignment - offset % flat_layout::alignment) % flat_layout::alignment;
+		const auto start = offset;
+		offset += size;
+		return start;
+	};
+	h.channels_offset = section(channels.size() * sizeof(flat_clip_channel));
+	h.times_offset = section(clip.times.size() * sizeof(std::uint16_t));
+	h.values_offset = section(clip.values.size() * sizeof(animation_clip::packed_value));
+	h.names_offset = section(names.size());
+
+	flat_layout::writer w(stream);
+	w.write(&h, sizeof(h));
+	w.begin_section();
+	w.write(channels.data(), channels.size() * sizeof(flat_clip_channel));
+	w.begin_section();
+	w.write(clip.times.data(), clip.times.size() * sizeof(std::uint16_t));
+	w.begin_section();
+	w.write(clip.values.data(), clip.values.size() * sizeof(animation_clip::packed_value));
+	w.begin_section();
+	w.write(names.data(), names.size());
+	return w.good();
+}
+
+bool flat_animation::read(const std::uint8_t* data, std::size_t size, animation& anim)
+{
+	if(data == nullptr || size < 2 * sizeof(std::uint32_t))
+	{
+		return false;
+	}
+
+	const auto file_magic = flat_layout::read_at<std::uint32_t>(data, 0);
+	const auto file_version = flat_layout::read_at<std::uint32_t>(data, sizeof(std::uint32_t));
+	if(file_magic != magic)
+	{
+		return false;
+	}
+	if(file_version == version)
+	{
+		return read_compressed(data, size, anim);
+	}
+	if(file_version == uncompressed_version)
+	{
+		return read_uncompressed(data, size, anim);
+	}
+	return false;
+}
+}
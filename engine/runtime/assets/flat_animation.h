@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../animation/animation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace runtime
+{
+/*
+ * flat_animation; the compiled data of an animation laid out flat, read
+ * with a copy per array instead of deserialized element by element.
+ *
+ *      The data is a header with the counts and the offsets of the sections,
+ *      then the sections each aligned to 16 bytes: the channels, the times
+ *      and the values of the keys of the compressed clip and the names. A
+ *      channel is the ranges of its keys and how its vectors are quantized.
+ *      The data of the version before, with the keys at full precision, is
+ *      read as well. The integers are little endian.
+ */
+struct flat_animation
+{
+	static constexpr std::uint32_t magic = 0x4d4e4145; // EANM
+	static constexpr std::uint32_t version = 2;
+	static constexpr std::uint32_t uncompressed_version = 1;
+
+	//-----------------------------------------------------------------------------
+	//  Name : write ()
+	/// <summary>
+	/// Writes the clip of the animation flat, it must have been built.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool write(std::ostream& stream, const animation& anim);
+
+	//-----------------------------------------------------------------------------
+	//  Name : read ()
+	/// <summary>
+	/// Reads the flat data into the animation, false when it is not flat, of
+	/// another version or damaged. The clip is read as it was compressed and
+	/// the channels only get their names. The keys of the uncompressed
+	/// version are read into the channels, the clip is left to be built.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool read(const std::uint8_t* data, std::size_t size, animation& anim);
+};
+}
@@ -0,0 +1,303 @@
+#include "flat_mesh.h"
+#include "detail/flat_layout.h"
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace runtime
+{
+namespace
+{
+struct header
+{
+	std::uint32_t magic = 0;
+	std::uint32_t version = 0;
+	std::uint32_t layout_size = 0;
+	std::uint32_t triangle_size = 0;
+	std::uint32_t vertex_count = 0;
+	std::uint32_t triangle_count = 0;
+	std::uint32_t material_count = 0;
+	std::uint32_t bones_count = 0;
+	std::uint32_t influences_count = 0;
+	std::uint32_t nodes_count = 0;
+	std::uint32_t names_size = 0;
+	/// 0 before version 2
+	std::uint32_t clusters_count = 0;
+	std::uint64_t layout_offset = 0;
+	std::uint64_t vertices_offset = 0;
+	std::uint64_t vertices_size = 0;
+	std::uint64_t triangles_offset = 0;
+	std::uint64_t bones_offset = 0;
+	std::uint64_t influences_offset = 0;
+	std::uint64_t nodes_offset = 0;
+	std::uint64_t names_offset = 0;
+	/// not there before version 2, only read with clusters
+	std::uint64_t clusters_offset = 0;
+	/// not there before version 3
+	std::uint32_t lod_count = 0;
+	std::uint32_t reserved = 0;
+};
+
+/// the first version, without clusters
+constexpr std::uint32_t unclustered_version = 1;
+/// the second version, without levels of detail
+constexpr std::uint32_t unlodded_version = 2;
+
+/// position, rotation as x y z w and scale
+using flat_transform = float[10];
+
+struct flat_bone
+{
+	std::uint32_t name_offset = 0;
+	std::uint32_t name_size = 0;
+	std::uint32_t first_influence = 0;
+	std::uint32_t influences_count = 0;
+	flat_transform bind_pose_transform = {};
+};
+
+struct flat_node
+{
+	std::uint32_t name_offset = 0;
+	std::uint32_t name_size = 0;
+	/// -1 for the root, before the node otherwise
+	std::int32_t parent = -1;
+	std::uint32_t reserved = 0;
+	flat_transform local_transform = {};
+};
+
+static_assert(std::is_trivially_copyable<gfx::vertex_layout>::value, "the layout is written as is");
+static_assert(std::is_trivially_copyable<mesh::triangle>::value, "the triangles are written as is");
+static_assert(std::is_trivially_copyable<skin_bind_data::vertex_influence>::value,
+			  "the influences are written as is");
+static_assert(std::is_trivially_copyable<mesh::cluster>::value, "the clusters are written as is");
+
+void to_flat(const math::transform& t, flat_transform& result)
+{
+	const auto& position = t.get_position();
+	const auto& rotation = t.get_rotation();
+	const auto& scale = t.get_scale();
+	const float values[10] = {position.x, position.y, position.z, rotation.x, rotation.y,
+							  rotation.z, rotation.w, scale.x, scale.y, scale.z};
+	std::memcpy(result, values, sizeof(values));
+}
+
+math::transform from_flat(const flat_transform& values)
+{
+	math::transform result;
+	math::quat rotation;
+	rotation.x = values[3];
+	rotation.y = values[4];
+	rotation.z = values[5];
+	rotation.w = values[6];
+	result.set_position({values[0], values[1], values[2]});
+	result.set_rotation(rotation);
+	result.set_scale({values[7], values[8], values[9]});
+	return result;
+}
+
+void flatten(const mesh::armature_node& node, std::int32_t parent, std::vector<flat_node>& nodes,
+			 std::string& names)
+{
+	flat_node n;
+	flat_layout::add_name(names, node.name, n.name_offset, n.name_size);
+	n.parent = parent;
+	to_flat(node.local_transform, n.local_transform);
+	nodes.push_back(n);
+
+	const auto index = std::int32_t(nodes.size() - 1);
+	for(const auto& child : node.children)
+	{
+		if(child)
+		{
+			flatten(*child, index, nodes, names);
+		}
+	}
+}
+}
+
+constexpr std::uint32_t flat_mesh::magic;
+constexpr std::uint32_t flat_mesh::version;
+
+bool flat_mesh::write(std::ostream& stream, const mesh::load_data& data)
+{
+	std::string names;
+	std::vector<flat_bone> bones;
+	std::vector<skin_bind_data::vertex_influence> influences;
+	for(const auto& bone : data.skin_data.get_bones())
+	{
+		flat_bone b;
+		flat_layout::add_name(names, bone.bone_id, b.name_offset, b.name_size);
+		b.first_influence = std::uint32_t(influences.size());
+		b.influences_count = std::uint32_t(bone.influences.size());
+		to_flat(bone.bind_pose_transform, b.bind_pose_transform);
+		bones.push_back(b);
+		influences.insert(std::end(influences), std::begin(bone.influences), std::end(bone.influences));
+	}
+
+	std::vector<flat_node> nodes;
+	if(data.root_node)
+	{
+		flatten(*data.root_node, -1, nodes, names);
+	}
+
+	header h;
+	h.magic = magic;
+	h.version = version;
+	h.layout_size = sizeof(gfx::vertex_layout);
+	h.triangle_size = sizeof(mesh::triangle);
+	h.vertex_count = data.vertex_count;
+	h.triangle_count = std::uint32_t(data.triangle_data.size());
+	h.material_count = data.material_count;
+	h.bones_count = std::uint32_t(bones.size());
+	h.influences_count = std::uint32_t(influences.size());
+	h.nodes_count = std::uint32_t(nodes.size());
+	h.names_size = std::uint32_t(names.size());
+	h.clusters_count = std::uint32_t(data.clusters.size());
+	h.lod_count = data.lod_count;
+	h.vertices_size = data.vertex_data.size();
+
+	// the offsets are known before anything is written
+	std::uint64_t offset = sizeof(header);
+	const auto section = [&offset](std::uint64_t size) {
+		offset += (flat_layout::alignment - offset % flat_layout::alignment) % flat_layout::alignment;
+		const auto start = offset;
+		offset += size;
+		return start;
+	};
+	h.layout_offset = section(sizeof(gfx::vertex_layout));
+	h.vertices_offset = section(h.vertices_size);
+	h.triangles_offset = section(std::uint64_t(h.triangle_count) * sizeof(mesh::triangle));
+	h.bones_offset = section(bones.size() * sizeof(flat_bone));
+	h.influences_offset = section(influences.size() * sizeof(skin_bind_data::vertex_influence));
+	h.nodes_offset = section(nodes.size() * sizeof(flat_node));
+	h.names_offset = section(names.size());
+	h.clusters_offset = section(data.clusters.size() * sizeof(mesh::cluster));
+
+	flat_layout::writer w(stream);
+	w.write(&h, sizeof(h));
+	w.begin_section();
+	w.write(&data.vertex_format, sizeof(gfx::vertex_layout));
+	w.begin_section();
+	w.write(data.vertex_data.data(), data.vertex_data.size());
+	w.begin_section();
+	w.write(data.triangle_data.data(), data.triangle_data.size() * sizeof(mesh::triangle));
+	w.begin_section();
+	w.write(bones.data(), bones.size() * sizeof(flat_bone));
+	w.begin_section();
+	w.write(influences.data(), influences.size() * sizeof(skin_bind_data::vertex_influence));
+	w.begin_section();
+	w.write(nodes.data(), nodes.size() * sizeof(flat_node));
+	w.begin_section();
+	w.write(names.data(), names.size());
+	w.begin_section();
+	w.write(data.clusters.data(), data.clusters.size() * sizeof(mesh::cluster));
+	return w.good();
+}
+
+bool flat_mesh::read(const std::uint8_t* data, std::size_t size)
+{
+	if(data == nullptr || size < sizeof(header))
+	{
+		return false;
+	}
+
+	auto h = flat_layout::read_at<header>(data, 0);
+	if(h.magic != magic ||
+	   (h.version != version && h.version != unclustered_version && h.version != unlodded_version) ||
+	   h.layout_size != sizeof(gfx::vertex_layout) || h.triangle_size != sizeof(mesh::triangle))
+	{
+		return false;
+	}
+
+	// the header of the first version ends before the offset of the clusters,
+	// that of the second before the levels of detail
+	if(h.version == unclustered_version)
+	{
+		h.clusters_count = 0;
+		h.clusters_offset = 0;
+	}
+	if(h.version != version)
+	{
+		h.lod_count = 0;
+	}
+
+	using flat_layout::in_range;
+	if(!in_range(h.layout_offset, 1, sizeof(gfx::vertex_layout), size) ||
+	   !in_range(h.vertices_offset, h.vertices_size, 1, size) ||
+	   !in_range(h.triangles_offset, h.triangle_count, sizeof(mesh::triangle), size) ||
+	   !in_range(h.bones_offset, h.bones_count, sizeof(flat_bone), size) ||
+	   !in_range(h.influences_offset, h.influences_count, sizeof(skin_bind_data::vertex_influence), size) ||
+	   !in_range(h.nodes_offset, h.nodes_count, sizeof(flat_node), size) ||
+	   !in_range(h.names_offset, h.names_size, 1, size) ||
+	   !in_range(h.clusters_offset, h.clusters_count, sizeof(mesh::cluster), size))
+	{
+		return false;
+	}
+
+	vertex_format = flat_layout::read_at<gfx::vertex_layout>(data, h.layout_offset);
+	if(std::uint64_t(h.vertex_count) * vertex_format.getStride() > h.vertices_size)
+	{
+		return false;
+	}
+	vertex_data = data + h.vertices_offset;
+	vertex_count = h.vertex_count;
+	material_count = h.material_count;
+	lod_count = h.lod_count;
+
+	triangle_data.resize(h.triangle_count);
+	std::memcpy(triangle_data.data(), data + h.triangles_offset,
+				triangle_data.size() * sizeof(mesh::triangle));
+
+	clusters.resize(h.clusters_count);
+	std::memcpy(clusters.data(), data + h.clusters_offset, clusters.size() * sizeof(mesh::cluster));
+
+	const auto names = reinterpret_cast<const char*>(data + h.names_offset);
+	auto& bones = skin_data.get_bones();
+	bones.clear();
+	bones.reserve(h.bones_count);
+	for(std::uint32_t i = 0; i < h.bones_count; ++i)
+	{
+		const auto b = flat_layout::read_at<flat_bone>(data, h.bones_offset + i * sizeof(flat_bone));
+		skin_bind_data::bone_influence bone;
+		if(std::uint64_t(b.first_influence) + b.influences_count > h.influences_count ||
+		   !flat_layout::read_name(names, h.names_size, b.name_offset, b.name_size, bone.bone_id))
+		{
+			return false;
+		}
+
+		bone.bind_pose_transform = from_flat(b.bind_pose_transform);
+		bone.influences.resize(b.influences_count);
+		std::memcpy(bone.influences.data(),
+					data + h.influences_offset + b.first_influence * sizeof(skin_bind_data::vertex_influence),
+					bone.influences.size() * sizeof(skin_bind_data::vertex_influence));
+		bones.push_back(std::move(bone));
+	}
+
+	root_node.reset();
+	std::vector<mesh::armature_node*> nodes;
+	nodes.reserve(h.nodes_count);
+	for(std::uint32_t i = 0; i < h.nodes_count; ++i)
+	{
+		const auto n = flat_layout::read_at<flat_node>(data, h.nodes_offset + i * sizeof(flat_node));
+		auto node = std::make_unique<mesh::armature_node>();
+		if(!flat_layout::read_name(names, h.names_size, n.name_offset, n.name_size, node->name) ||
+		   (i == 0) != (n.parent < 0) || n.parent >= std::int32_t(i))
+		{
+			return false;
+		}
+
+		node->local_transform = from_flat(n.local_transform);
+		nodes.push_back(node.get());
+		if(i == 0)
+		{
+			root_node = std::move(node);
+		}
+		else
+		{
+			nodes[std::size_t(n.parent)]->children.push_back(std::move(node));
+		}
+	}
+	return true;
+}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../rendering/mesh.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+
+namespace runtime
+{
+/*
+ * flat_mesh; the compiled data of a mesh laid out flat, read in place from
+ * the mapping instead of deserialized element by element.
+ *
+ *      The data is a header with the counts and the offsets of the sections,
+ *      then the sections each aligned to 16 bytes: the vertex layout, the
+ *      vertices, the triangles, the bones, the vertex influences of the
+ *      bones, the armature nodes, their names and the clusters of the
+ *      triangles. The vertices, triangles, influences and clusters are blobs
+ *      of their structs, a bone is the range of its influences, and the
+ *      armature is its nodes in depth first order with the index of their
+ *      parent. The header has the sizes of the structs, data written by a
+ *      build where they differ is not read. The integers are little endian.
+ *      The first version has no clusters, the second no count of the levels
+ *      of detail, both are still read.
+ */
+struct flat_mesh
+{
+	static constexpr std::uint32_t magic = 0x48534d45; // EMSH
+	static constexpr std::uint32_t version = 3;
+
+	//-----------------------------------------------------------------------------
+	//  Name : write ()
+	/// <summary>
+	/// Writes the mesh data flat.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool write(std::ostream& stream, const mesh::load_data& data);
+
+	//-----------------------------------------------------------------------------
+	//  Name : read ()
+	/// <summary>
+	/// Reads the flat data, false when it is not flat, of another version or
+	/// damaged. The vertices are kept in place, the data must outlive their
+	/// use.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool read(const std::uint8_t* data, std::size_t size);
+
+	gfx::vertex_layout vertex_format;
+	const std::uint8_t* vertex_data = nullptr;
+	std::uint32_t vertex_count = 0;
+	mesh::triangle_array_t triangle_data;
+	std::uint32_t material_count = 0;
+	skin_bind_data skin_data;
+	std::unique_ptr<mesh::armature_node> root_node;
+	mesh::cluster_array_t clusters;
+	std::uint32_t lod_count = 0;
+};
+}
@@ -5,16 +5,26 @@
 #include "../../meta/audio/sound.hpp"
 #include "../../meta/rendering/material.hpp"
 #include "../../meta/rendering/mesh.hpp"
+#include "../../rendering/texture_streaming.h"
+#include "../../rendering/virtual_texturing.h"
+#include "../asset_load_stats.h"
 #include "../asset_manager.h"
+#include "../asset_manifest.h"
+#include "../flat_animation.h"
+#include "../flat_mesh.h"
 
 #include <core/audio/sound.h>
+#include <core/filesystem/archive.h>
 #include <core/filesystem/filesystem.h>
 #include <core/graphics/index_buffer.h>
 #include <core/graphics/shader.h>
+#include <core/graphics/shader_pack.h>
 #include <core/graphics/texture.h>
 #include <core/graphics/uniform.h>
 #include <core/graphics/vertex_buffer.h>
 #include <core/logging/logging.h>
+#include <core/profiling/memory_tracker.h>
+#include <core/profiling/profiler.h>
 #include <core/serialization/associative_archive.h>
 #include <core/serialization/binary_archive.h>
 #include <core/serialization/serialization.h>
@@ -27,11 +37,178 @@ namespace runtime
 {
 namespace asset_reader
 {
+namespace
+{
+// the compiled data of an asset from the mounted archives, or else from the
+// loose file in the cache which is mapped with its reading started
+fs::mapped_range read_compiled(const std::string& compiled_key, const std::string& compiled_absolute_key)
+{
+	auto result = fs::find_mounted(compiled_key);
+	if(result)
+	{
+		return result;
+	}
+
+	auto file = std::make_shared<fs::mapped_file>(compiled_absolute_key);
+	if(!file->is_open())
+	{
+		return result;
+	}
+
+	file->prefetch();
+	result.data = file->data();
+	result.size = file->size();
+	result.owner = std::move(file);
+	return result;
+}
+
+// the read timed as the read stage of the load
+fs::mapped_range read_compiled(const std::string& compiled_key, const std::string& compiled_absolute_key,
+							   const std::shared_ptr<asset_load_stats::record>& record)
+{
+	asset_load_stats::stage_timer timer(record, asset_load_stats::stage::read);
+	PROFILE_SCOPE("asset_read");
+	core::scoped_memory_tag alloc_tag(core::memory_tag::assets);
+	auto result = read_compiled(compiled_key, compiled_absolute_key);
+	asset_load_stats::add_bytes(record, result.size);
+	return result;
+}
+
+std::shared_ptr<asset_load_stats::record> begin_load(const char* type, const std::string& key)
+{
+	return core::get_subsystem<asset_manager>().get_load_stats().begin(type, key);
+}
+
+std::shared_ptr<mesh> build_mesh(const gfx::vertex_layout& format, std::uint8_t* vertices,
+								 std::uint32_t vertex_count, const mesh::triangle_array_t& triangles,
+								 std::uint32_t material_count, const skin_bind_data& skin,
+								 std::unique_ptr<mesh::armature_node>& root,
+								 const mesh::cluster_array_t& clusters)
+{
+	auto loaded = std::make_shared<mesh>();
+	loaded->prepare_mesh(format);
+	loaded->set_vertex_source(vertices, vertex_count, format);
+	loaded->add_primitives(triangles);
+	loaded->set_subset_count(material_count);
+	loaded->bind_clusters(clusters);
+	loaded->bind_skin(skin);
+	loaded->bind_armature(root);
+	loaded->end_prepare(true, false, false, false);
+	return loaded;
+}
+
+// the mesh prepared from a compiled one, null when it cannot be read
+std::shared_ptr<mesh> read_mesh(const fs::mapped_range& compiled)
+{
+	// the mesh prepares from the vertices in the mapping, it is held
+	// until the mesh is built
+	flat_mesh flat;
+	if(flat.read(compiled.data, compiled.size))
+	{
+		auto loaded = build_mesh(flat.vertex_format, const_cast<std::uint8_t*>(flat.vertex_data),
+								 flat.vertex_count, flat.triangle_data, flat.material_count, flat.skin_data,
+								 flat.root_node, flat.clusters);
+		loaded->set_lod_count(flat.lod_count);
+		return loaded;
+	}
+
+	// compiled before the flat layout
+	mesh::load_data data;
+	{
+		cereal::iarchive_binary_t ar(compiled.data, compiled.size);
+
+		try_load(ar, cereal::make_nvp("mesh", data));
+	}
+
+	return build_mesh(data.vertex_format, &data.vertex_data[0], data.vertex_count, data.triangle_data,
+					  data.material_count, data.skin_data, data.root_node, data.clusters);
+}
+
+// the ticket of the gpu upload of an asset made from the data
+template <typename T, typename F>
+upload_queue::ticket begin_upload(const asset_id& id, const core::task_future<T>& data, F&& size_of)
+{
+	auto& queue = core::get_subsystem<asset_manager>().get_upload_queue();
+	return queue.push(id, data, std::forward<F>(size_of));
+}
+
+bool compiled_exists(const std::string& compiled_key, const std::string& compiled_absolute_key)
+{
+	fs::error_code err;
+	return fs::exists_mounted(compiled_key) || fs::exists(compiled_absolute_key, err);
+}
+
+using dependency_links = std::vector<std::shared_ptr<void>>;
+using links_future = core::task_future<std::shared_ptr<dependency_links>>;
+
+// starts the load of a dependency and chains it after the ones before it,
+// the links are gathered in order into the one vector
+template <typename T>
+links_future join_dependency(links_future all, const std::string& key)
+{
+	auto& ts = core::get_subsystem<core::task_system>();
+	auto& am = core::get_subsystem<asset_manager>();
+	return ts.push_on_worker_thread(
+		[](const std::shared_ptr<dependency_links>& links, const asset_handle<T>& handle) {
+			links->push_back(handle.link);
+			return links;
+		},
+		std::move(all), am.load<T>(key));
+}
+
+// the loads of every dependency of a manifest are started at once, the
+// future is ready when they all are
+links_future load_dependencies(const asset_manifest& manifest)
+{
+	auto& ts = core::get_subsystem<core::task_system>();
+	auto all = ts.push_or_execute_on_worker_thread([]() { return std::make_shared<dependency_links>(); });
+	for(const auto& dep : manifest.dependencies)
+	{
+		switch(dep.type)
+		{
+			case asset_manifest::asset_type::texture:
+				all = join_dependency<gfx::texture>(std::move(all), dep.key);
+				break;
+			case asset_manifest::asset_type::mesh:
+				all = join_dependency<mesh>(std::move(all), dep.key);
+				break;
+			case asset_manifest::asset_type::material:
+				all = join_dependency<material>(std::move(all), dep.key);
+				break;
+			case asset_manifest::asset_type::sound:
+				all = join_dependency<audio::sound>(std::move(all), dep.key);
+				break;
+			case asset_manifest::asset_type::animation:
+				all = join_dependency<runtime::animation>(std::move(all), dep.key);
+				break;
+		}
+	}
+	return all;
+}
+
+// what the manifest lists reloads the asset made of it
+template <typename T>
+void add_dependents(const asset_id& id, const asset_manifest& manifest)
+{
+	auto& am = core::get_subsystem<asset_manager>();
+	for(const auto& dep : manifest.dependencies)
+	{
+		am.add_dependent<T>(id, dep.key);
+	}
+}
+}
+
+void mount_compiled(const asset_id& id, const fs::mapped_range& data)
+{
+	auto cache_key = fs::replace(id.str(), ":/data", ":/cache");
+	fs::mount_memory(cache_key.string() + ".asset", data);
+}
 
 template <>
 bool load_from_file<gfx::texture>(core::task_future<asset_handle<gfx::texture>>& output,
-								  const std::string& key)
+								  const asset_id& id)
 {
+	const auto& key = id.str();
 	asset_handle<gfx::texture> original;
 	if(output.is_ready())
 	{
@@ -40,9 +217,9 @@ bool load_from_file<gfx::texture>(core::task_future<asset_handle<gfx::texture>>&
 
 	auto& ts = core::get_subsystem<core::task_system>();
 
-	auto create_resource_func_fallback = [ result = original, key ]() mutable
+	auto create_resource_func_fallback = [ result = original, id ]() mutable
 	{
-		result.link->id = key;
+		result.link->id = id;
 		return result;
 	};
 
@@ -55,70 +232,85 @@ bool load_from_file<gfx::texture>(core::task_future<asset_handle<gfx::texture>>&
 
 	auto cache_key = fs::replace(key, ":/data", ":/cache");
 	fs::path absolute_key = fs::absolute(fs::resolve_protocol(cache_key).string());
+	auto compiled_key = cache_key.string() + ".asset";
 	auto compiled_absolute_key = absolute_key.string() + ".asset";
 
-	fs::error_code err;
-	if(!fs::exists(compiled_absolute_key, err))
+	if(!compiled_exists(compiled_key, compiled_absolute_key))
 	{
 		APPLOG_ERROR("Asset with key {0} and absolute_path {1} does not exist!", key, compiled_absolute_key);
 		output = ts.push_or_execute_on_worker_thread(create_resource_func_fallback);
 		return true;
 	}
 
-	auto read_memory = std::make_shared<fs::byte_array_t>();
-	auto read_memory_func = [read_memory, compiled_absolute_key]() {
-		if(!read_memory)
-		{
-			return false;
-		}
-		auto stream = std::ifstream{compiled_absolute_key, std::ios::in | std::ios::binary};
-		*read_memory = fs::read_stream(stream);
+	auto record = begin_load("texture", key);
 
-		return true;
+	auto read_memory_func = [compiled_key, compiled_absolute_key, record]() {
+		return read_compiled(compiled_key, compiled_absolute_key, record);
 	};
 
-	auto create_resource_func = [ result = original, read_memory, key ](bool read_result) mutable
+	// the texture is made from the mapping without copying it, bgfx unmaps
+	// it once it is done with the memory.
+	auto create_resource_func = [ result = original, id, record ](const fs::mapped_range& data, bool) mutable
 	{
-		if(!read_result)
-		{
-			return result;
-		}
-		// if someone destroyed our memory
-		if(!read_memory)
+		asset_load_stats::stage_timer timer(record, asset_load_stats::stage::upload, true);
+		PROFILE_SCOPE("texture_upload");
+		core::scoped_memory_tag alloc_tag(core::memory_tag::assets);
+
+		// if nothing was read
+		if(!data)
 		{
 			return result;
 		}
-		// if nothing was read
-		if(read_memory->empty())
+
+		// a streamed texture starts with its tail mips
+		if(core::has_subsystems<texture_streaming>())
 		{
-			return result;
+			auto tex = core::get_subsystem<texture_streaming>().create(data, 0);
+			if(tex)
+			{
+				result.link->id = id;
+				result.link->asset = tex;
+				return result;
+			}
 		}
 
 		const gfx::memory_view* mem =
-			gfx::copy(read_memory->data(), static_cast<std::uint32_t>(read_memory->size()));
-
-		read_memory->clear();
-		read_memory.reset();
+			gfx::make_ref(data.data, static_cast<std::uint32_t>(data.size), data.owner);
 
 		if(nullptr != mem)
 		{
+			gfx::scoped_memory_category scope(gfx::memory_category::assets);
 			auto tex = std::make_shared<gfx::texture>(mem, 0, 0, nullptr);
-			result.link->id = key;
-			result.link->asset = tex;
+			result.link->id = id;
+			// a reload changes the texture in place, what holds it draws the
+			// new one and the old one goes with tex
+			if(result.link->asset && !core::has_subsystems<texture_streaming>())
+			{
+				result.link->asset->swap(*tex);
+			}
+			else
+			{
+				result.link->asset = tex;
+			}
 		}
 
 		return result;
 	};
 
-	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func);
-	output = ts.push_on_owner_thread(create_resource_func, ready_memory_task);
+	auto ready_memory_task = ts.push_on_io_thread(read_memory_func);
+	// gpu uploads are spread over several frames
+	auto upload = begin_upload(id, ready_memory_task, [](const fs::mapped_range& data) { return data.size; });
+	output = ts.push_on_owner_thread_with_priority(core::task_priority::background, create_resource_func,
+												   std::move(ready_memory_task), std::move(upload));
 	return true;
 }
 
 template <>
-bool load_from_file<gfx::shader>(core::task_future<asset_handle<gfx::shader>>& output, const std::string& key)
+bool load_from_file<virtual_texture>(core::task_future<asset_handle<virtual_texture>>& output,
+									 const asset_id& id)
 {
-	asset_handle<gfx::shader> original;
+	const auto& key = id.str();
+	asset_handle<virtual_texture> original;
 	if(output.is_ready())
 	{
 		original = output.get();
@@ -126,9 +318,9 @@ bool load_from_file<gfx::shader>(core::task_future<asset_handle<gfx::shader>>& o
 
 	auto& ts = core::get_subsystem<core::task_system>();
 
-	auto create_resource_func_fallback = [ result = original, key ]() mutable
+	auto create_resource_func_fallback = [ result = original, id ]() mutable
 	{
-		result.link->id = key;
+		result.link->id = id;
 		return result;
 	};
 
@@ -139,72 +331,164 @@ bool load_from_file<gfx::shader>(core::task_future<asset_handle<gfx::shader>>& o
 		return true;
 	}
 
+	// the compiled texture of the key, read in pages instead of uploaded
 	auto cache_key = fs::replace(key, ":/data", ":/cache");
-
 	fs::path absolute_key = fs::absolute(fs::resolve_protocol(cache_key).string());
-	const auto& renderer_extension = gfx::get_renderer_filename_extension();
-	auto compiled_absolute_key = absolute_key.string() + renderer_extension + ".asset";
+	auto compiled_key = cache_key.string() + ".asset";
+	auto compiled_absolute_key = absolute_key.string() + ".asset";
 
-	fs::error_code err;
-	if(!fs::exists(compiled_absolute_key, err))
+	if(!compiled_exists(compiled_key, compiled_absolute_key))
 	{
 		APPLOG_ERROR("Asset with key {0} and absolute_path {1} does not exist!", key, compiled_absolute_key);
 		output = ts.push_or_execute_on_worker_thread(create_resource_func_fallback);
 		return true;
 	}
 
-	auto read_memory = std::make_shared<fs::byte_array_t>();
-
-	auto read_memory_func = [read_memory, compiled_absolute_key]() {
-		if(!read_memory)
-		{
-			return false;
-		}
-		auto stream = std::ifstream{compiled_absolute_key, std::ios::in | std::ios::binary};
-		*read_memory = fs::read_stream(stream);
+	auto record = begin_load("virtual_texture", key);
 
-		return true;
+	auto read_memory_func = [compiled_key, compiled_absolute_key, record]() {
+		return read_compiled(compiled_key, compiled_absolute_key, record);
 	};
 
-	auto create_resource_func = [ result = original, read_memory, key ](bool read_result) mutable
+	// the texture keeps the mapping, the pages are copied out of it
+	auto create_resource_func = [ result = original, id, key, record ](const fs::mapped_range& data) mutable
 	{
-		if(!read_result)
+		asset_load_stats::stage_timer timer(record, asset_load_stats::stage::upload, true);
+		PROFILE_SCOPE("virtual_texture_create");
+
+		if(!data || !core::has_subsystems<virtual_texturing>())
 		{
 			return result;
 		}
-		// if someone destroyed our memory
-		if(!read_memory)
+
+		auto tex = core::get_subsystem<virtual_texturing>().create(data);
+		if(!tex)
 		{
+			APPLOG_ERROR("Texture {0} can't be virtual, it must be an uncompressed power of two of pages "
+						 "with its mips.",
+						 key);
 			return result;
 		}
+
+		result.link->id = id;
+		result.link->asset = tex;
+		return result;
+	};
+
+	auto ready_memory_task = ts.push_on_io_thread(read_memory_func);
+	output = ts.push_on_owner_thread(create_resource_func, std::move(ready_memory_task));
+	return true;
+}
+
+template <>
+bool load_from_file<gfx::shader>(core::task_future<asset_handle<gfx::shader>>& output, const asset_id& id)
+{
+	const auto& key = id.str();
+	asset_handle<gfx::shader> original;
+	if(output.is_ready())
+	{
+		original = output.get();
+	}
+
+	auto& ts = core::get_subsystem<core::task_system>();
+
+	auto create_resource_func_fallback = [ result = original, id ]() mutable
+	{
+		result.link->id = id;
+		return result;
+	};
+
+	if(!fs::has_known_protocol(key))
+	{
+		APPLOG_ERROR("Asset {0} has uknown protocol!", key);
+		output = ts.push_or_execute_on_worker_thread(create_resource_func_fallback);
+		return true;
+	}
+
+	// the defines of a variant follow the key of the source after a '#'
+	const auto variant_begin = key.find('#');
+	const auto source_key = key.substr(0, variant_begin);
+	const auto defines = variant_begin == std::string::npos ? std::string() : key.substr(variant_begin + 1);
+	auto cache_key = fs::replace(source_key, ":/data", ":/cache");
+
+	fs::path absolute_key = fs::absolute(fs::resolve_protocol(cache_key).string());
+	const auto& renderer_extension = gfx::get_renderer_filename_extension();
+	auto compiled_key = cache_key.string() + renderer_extension + ".asset";
+	auto compiled_absolute_key = absolute_key.string() + renderer_extension + ".asset";
+
+	if(!compiled_exists(compiled_key, compiled_absolute_key))
+	{
+		APPLOG_ERROR("Asset with key {0} and absolute_path {1} does not exist!", key, compiled_absolute_key);
+		output = ts.push_or_execute_on_worker_thread(create_resource_func_fallback);
+		return true;
+	}
+
+	auto record = begin_load("shader", key);
+
+	auto read_memory_func = [compiled_key, compiled_absolute_key, record]() {
+		return read_compiled(compiled_key, compiled_absolute_key, record);
+	};
+
+	auto create_resource_func = [ result = original, id, record,
+								  defines ](fs::mapped_range data, bool) mutable
+	{
+		asset_load_stats::stage_timer timer(record, asset_load_stats::stage::upload, true);
+		PROFILE_SCOPE("shader_upload");
+		core::scoped_memory_tag alloc_tag(core::memory_tag::assets);
+
 		// if nothing was read
-		if(read_memory->empty())
+		if(!data)
 		{
 			return result;
 		}
 
+		// the variants of a source are packed, the binary of one is used in
+		// place. A shader without variants has no features to define.
+		if(gfx::shader_pack::is_pack(data.data, data.size))
+		{
+			std::size_t offset = 0;
+			std::size_t length = 0;
+			if(!gfx::shader_pack::find(data.data, data.size, defines, offset, length))
+			{
+				APPLOG_ERROR("Shader {0} has no variant of the defines.", id.str());
+				return result;
+			}
+			data.data += offset;
+			data.size = length;
+		}
+
 		const gfx::memory_view* mem =
-			gfx::copy(read_memory->data(), static_cast<std::uint32_t>(read_memory->size()));
-		read_memory->clear();
-		read_memory.reset();
+			gfx::make_ref(data.data, static_cast<std::uint32_t>(data.size), data.owner);
 
 		if(nullptr != mem)
 		{
-			result.link->id = key;
-			result.link->asset = std::make_shared<gfx::shader>(mem);
+			result.link->id = id;
+			// a reload changes the shader in place, the programs see its new
+			// handle and are linked again
+			auto shader = std::make_shared<gfx::shader>(mem);
+			if(result.link->asset)
+			{
+				result.link->asset->swap(*shader);
+			}
+			else
+			{
+				result.link->asset = shader;
+			}
 		}
 
 		return result;
 	};
 
-	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func);
-	output = ts.push_on_owner_thread(create_resource_func, ready_memory_task);
+	auto ready_memory_task = ts.push_on_io_thread(read_memory_func);
+	auto upload = begin_upload(id, ready_memory_task, [](const fs::mapped_range& data) { return data.size; });
+	output = ts.push_on_owner_thread(create_resource_func, std::move(ready_memory_task), std::move(upload));
 	return true;
 }
 
 template <>
-bool load_from_file<mesh>(core::task_future<asset_handle<mesh>>& output, const std::string& key)
+bool load_from_file<mesh>(core::task_future<asset_handle<mesh>>& output, const asset_id& id)
 {
+	const auto& key = id.str();
 	asset_handle<mesh> original;
 	if(output.is_ready())
 	{
@@ -213,9 +497,9 @@ bool load_from_file<mesh>(core::task_future<asset_handle<mesh>>& output, const s
 
 	auto& ts = core::get_subsystem<core::task_system>();
 
-	auto create_resource_func_fallback = [ result = original, key ]() mutable
+	auto create_resource_func_fallback = [ result = original, id ]() mutable
 	{
-		result.link->id = key;
+		result.link->id = id;
 		return result;
 	};
 
@@ -229,75 +513,81 @@ bool load_from_file<mesh>(core::task_future<asset_handle<mesh>>& output, const s
 	auto cache_key = fs::replace(key, ":/data", ":/cache");
 	fs::path absolute_key = fs::absolute(fs::resolve_protocol(cache_key).string());
 
+	auto compiled_key = cache_key.string() + ".asset";
 	auto compiled_absolute_key = absolute_key.string() + ".asset";
 
-	fs::error_code err;
-	if(!fs::exists(compiled_absolute_key, err))
+	if(!compiled_exists(compiled_key, compiled_absolute_key))
 	{
 		APPLOG_ERROR("Asset with key {0} and absolute_path {1} does not exist!", key, compiled_absolute_key);
 		output = ts.push_or_execute_on_worker_thread(create_resource_func_fallback);
 		return true;
 	}
 
-	struct wrapper_t
-	{
-		std::shared_ptr<::mesh> mesh = std::make_shared<::mesh>();
-	};
+	auto record = begin_load("mesh", key);
 
-	auto wrapper = std::make_shared<wrapper_t>();
-	auto read_memory_func = [wrapper, compiled_absolute_key]() mutable {
-		mesh::load_data data;
+	auto read_memory_func = [compiled_key, compiled_absolute_key, record]() {
+		std::shared_ptr<::mesh> loaded;
+		auto compiled = read_compiled(compiled_key, compiled_absolute_key, record);
+		// the group may have been cleared while it was read
+		if(!compiled || core::get_current_cancellation().is_cancelled())
 		{
-			std::ifstream stream{compiled_absolute_key, std::ios::in | std::ios::binary};
-
-			if(stream.bad())
-			{
-				return false;
-			}
-
-			cereal::iarchive_binary_t ar(stream);
-
-			try_load(ar, cereal::make_nvp("mesh", data));
+			return loaded;
 		}
-		wrapper->mesh->prepare_mesh(data.vertex_format);
-		wrapper->mesh->set_vertex_source(&data.vertex_data[0], data.vertex_count, data.vertex_format);
-		wrapper->mesh->add_primitives(data.triangle_data);
-		wrapper->mesh->set_subset_count(data.material_count);
-		wrapper->mesh->bind_skin(data.skin_data);
-		wrapper->mesh->bind_armature(data.root_node);
-		wrapper->mesh->end_prepare(true, false, false, false);
 
-		return true;
+		asset_load_stats::stage_timer timer(record, asset_load_stats::stage::process);
+		PROFILE_SCOPE("mesh_process");
+		core::scoped_memory_tag alloc_tag(core::memory_tag::assets);
+		return read_mesh(compiled);
 	};
 
-	auto create_resource_func = [ result = original, wrapper, key ](bool read_result) mutable
+	auto create_resource_func = [ result = original, id, record, compiled_key, compiled_absolute_key ](
+		const std::shared_ptr<::mesh>& loaded, bool) mutable
 	{
+		asset_load_stats::stage_timer timer(record, asset_load_stats::stage::upload, true);
+		PROFILE_SCOPE("mesh_upload");
+		core::scoped_memory_tag alloc_tag(core::memory_tag::assets);
+
 		// Build the mesh
-		if(read_result)
+		if(loaded)
 		{
-			wrapper->mesh->build_vb();
-			wrapper->mesh->build_ib();
+			loaded->build_vb();
+			loaded->build_ib();
 
-			if(wrapper->mesh->get_status() == mesh_status::prepared)
+			if(loaded->get_status() == mesh_status::prepared)
 			{
-				result.link->id = key;
-				result.link->asset = wrapper->mesh;
+				// the copy in system memory is read again from the asset
+				// when it was let go
+				loaded->set_residency(mesh::get_default_residency(), [compiled_key, compiled_absolute_key]() {
+					PROFILE_SCOPE("mesh_refetch");
+					core::scoped_memory_tag alloc_tag(core::memory_tag::assets);
+					auto compiled = read_compiled(compiled_key, compiled_absolute_key);
+					return compiled ? read_mesh(compiled) : std::shared_ptr<::mesh>();
+				});
+				result.link->id = id;
+				result.link->asset = loaded;
 			}
-			wrapper.reset();
 		}
 
 		return result;
 	};
 
 	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func);
-	output = ts.push_on_owner_thread(create_resource_func, ready_memory_task);
+	// gpu uploads are spread over several frames
+	auto upload = begin_upload(id, ready_memory_task, [](const std::shared_ptr<::mesh>& loaded) {
+		return loaded ? std::size_t(loaded->get_vertex_count()) * loaded->get_vertex_format().getStride() +
+							std::size_t(loaded->get_face_count()) * 3 * sizeof(std::uint32_t)
+					  : std::size_t(0);
+	});
+	output = ts.push_on_owner_thread_with_priority(core::task_priority::background, create_resource_func,
+												   std::move(ready_memory_task), std::move(upload));
 	return true;
 }
 
 template <>
 bool load_from_file<audio::sound>(core::task_future<asset_handle<audio::sound>>& output,
-								  const std::string& key)
+								  const asset_id& id)
 {
+	const auto& key = id.str();
 	asset_handle<audio::sound> original;
 	if(output.is_ready())
 	{
@@ -306,9 +596,9 @@ bool load_from_file<audio::sound>(core::task_future<asset_handle<audio::sound>>&
 
 	auto& ts = core::get_subsystem<core::task_system>();
 
-	auto create_resource_func_fallback = [ result = original, key ]() mutable
+	auto create_resource_func_fallback = [ result = original, id ]() mutable
 	{
-		result.link->id = key;
+		result.link->id = id;
 		return result;
 	};
 
@@ -322,62 +612,74 @@ bool load_from_file<audio::sound>(core::task_future<asset_handle<audio::sound>>&
 	auto cache_key = fs::replace(key, ":/data", ":/cache");
 	fs::path absolute_key = fs::absolute(fs::resolve_protocol(cache_key).string());
 
+	auto compiled_key = cache_key.string() + ".asset";
 	auto compiled_absolute_key = absolute_key.string() + ".asset";
 
-	fs::error_code err;
-	if(!fs::exists(compiled_absolute_key, err))
+	if(!compiled_exists(compiled_key, compiled_absolute_key))
 	{
 		APPLOG_ERROR("Asset with key {0} and absolute_path {1} does not exist!", key, compiled_absolute_key);
 		output = ts.push_or_execute_on_worker_thread(create_resource_func_fallback);
 		return true;
 	}
 
-	struct wrapper_t
-	{
-		audio::sound_data data;
-	};
+	auto record = begin_load("sound", key);
 
-	auto wrapper = std::make_shared<wrapper_t>();
-	auto read_memory_func = [wrapper, compiled_absolute_key]() mutable {
+	// the buffers are filled here too, openal can be called from any thread so
+	// that the copy of the samples stays off the owner thread.
+	auto read_memory_func = [compiled_key, compiled_absolute_key, record]() {
+		std::shared_ptr<audio::sound> sound;
+		audio::sound_data data;
 		{
-			std::ifstream stream{compiled_absolute_key, std::ios::in | std::ios::binary};
-
-			if(stream.bad())
+			auto compiled = read_compiled(compiled_key, compiled_absolute_key, record);
+			if(!compiled || core::get_current_cancellation().is_cancelled())
 			{
-				return false;
+				return sound;
 			}
 
-			cereal::iarchive_binary_t ar(stream);
+			asset_load_stats::stage_timer timer(record, asset_load_stats::stage::process);
+			PROFILE_SCOPE("sound_process");
+			core::scoped_memory_tag alloc_tag(core::memory_tag::assets);
 
-			try_load(ar, cereal::make_nvp("sound", wrapper->data));
+			cereal::iarchive_binary_t ar(compiled.data, compiled.size);
+
+			try_load(ar, cereal::make_nvp("sound", data));
 		}
-		return true;
+
+		if(!data.data.empty() || !data.encoded.empty())
+		{
+			asset_load_stats::stage_timer timer(record, asset_load_stats::stage::upload);
+			PROFILE_SCOPE("sound_upload");
+			core::scoped_memory_tag alloc_tag(core::memory_tag::assets);
+			sound = std::make_shared<audio::sound>(std::move(data));
+		}
+		return sound;
 	};
 
-	auto create_resource_func = [ result = original, wrapper, key ](bool read_result) mutable
+	auto create_resource_func = [ result = original, id, record ](std::shared_ptr<audio::sound> sound) mutable
 	{
-		if(read_result)
+		asset_load_stats::stage_timer timer(record, asset_load_stats::stage::upload, true);
+		PROFILE_SCOPE("sound_upload");
+		core::scoped_memory_tag alloc_tag(core::memory_tag::assets);
+
+		if(sound)
 		{
-			if(!wrapper->data.data.empty())
-			{
-				result.link->id = key;
-				result.link->asset = std::make_shared<audio::sound>(std::move(wrapper->data));
-			}
-			wrapper.reset();
+			result.link->id = id;
+			result.link->asset = std::move(sound);
 		}
 
 		return result;
 	};
 
 	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func);
-	output = ts.push_on_owner_thread(create_resource_func, ready_memory_task);
+	output = ts.push_on_owner_thread(create_resource_func, std::move(ready_memory_task));
 	return true;
 }
 
 template <>
 bool load_from_file<runtime::animation>(core::task_future<asset_handle<runtime::animation>>& output,
-										const std::string& key)
+										const asset_id& id)
 {
+	const auto& key = id.str();
 	asset_handle<runtime::animation> original;
 	if(output.is_ready())
 	{
@@ -386,9 +688,9 @@ bool load_from_file<runtime::animation>(core::task_future<asset_handle<runtime::
 
 	auto& ts = core::get_subsystem<core::task_system>();
 
-	auto create_resource_func_fallback = [ result = original, key ]() mutable
+	auto create_resource_func_fallback = [ result = original, id ]() mutable
 	{
-		result.link->id = key;
+		result.link->id = id;
 		return result;
 	};
 
@@ -402,62 +704,84 @@ bool load_from_file<runtime::animation>(core::task_future<asset_handle<runtime::
 	auto cache_key = fs::replace(key, ":/data", ":/cache");
 	fs::path absolute_key = fs::absolute(fs::resolve_protocol(cache_key).string());
 
+	auto compiled_key = cache_key.string() + ".asset";
 	auto compiled_absolute_key = absolute_key.string() + ".asset";
 
-	fs::error_code err;
-	if(!fs::exists(compiled_absolute_key, err))
+	if(!compiled_exists(compiled_key, compiled_absolute_key))
 	{
 		APPLOG_ERROR("Asset with key {0} and absolute_path {1} does not exist!", key, compiled_absolute_key);
 		output = ts.push_or_execute_on_worker_thread(create_resource_func_fallback);
 		return true;
 	}
 
-	struct wrapper_t
-	{
-		std::shared_ptr<runtime::animation> anim = std::make_shared<runtime::animation>();
-	};
+	auto record = begin_load("animation", key);
 
-	auto wrapper = std::make_shared<wrapper_t>();
-	auto read_memory_func = [wrapper, compiled_absolute_key]() mutable {
-		auto& data = *wrapper->anim;
+	auto read_memory_func = [compiled_key, compiled_absolute_key, record]() {
+		std::shared_ptr<runtime::animation> anim;
 		{
-			std::ifstream stream{compiled_absolute_key, std::ios::in | std::ios::binary};
-
-			if(stream.bad())
+			auto compiled = read_compiled(compiled_key, compiled_absolute_key, record);
+			if(!compiled || core::get_current_cancellation().is_cancelled())
 			{
-				return false;
+				return anim;
 			}
 
-			cereal::iarchive_binary_t ar(stream);
+			asset_load_stats::stage_timer timer(record, asset_load_stats::stage::process);
+			PROFILE_SCOPE("animation_process");
+			core::scoped_memory_tag alloc_tag(core::memory_tag::assets);
+
+			anim = std::make_shared<runtime::animation>();
+			if(!flat_animation::read(compiled.data, compiled.size, *anim))
+			{
+				// compiled before the flat layout
+				cereal::iarchive_binary_t ar(compiled.data, compiled.size);
 
-			try_load(ar, cereal::make_nvp("animation", data));
+				try_load(ar, cereal::make_nvp("animation", *anim));
+			}
+
+			// compiled before the keys were compressed
+			if(anim->clip.empty())
+			{
+				anim->clip = runtime::animation_clip::build(*anim);
+				for(auto& channel : anim->channels)
+				{
+					channel.position_keys.clear();
+					channel.position_keys.shrink_to_fit();
+					channel.rotation_keys.clear();
+					channel.rotation_keys.shrink_to_fit();
+					channel.scaling_keys.clear();
+					channel.scaling_keys.shrink_to_fit();
+				}
+			}
 		}
 
-		return true;
+		return anim;
 	};
 
-	auto create_resource_func = [ result = original, wrapper, key ](bool read_result) mutable
+	auto create_resource_func = [ result = original, id, record ](
+		const std::shared_ptr<runtime::animation>& anim) mutable
 	{
-		// Build the mesh
-		if(read_result && wrapper->anim)
-		{
-			result.link->id = key;
-			result.link->asset = wrapper->anim;
+		asset_load_stats::stage_timer timer(record, asset_load_stats::stage::upload, true);
+		PROFILE_SCOPE("animation_upload");
+		core::scoped_memory_tag alloc_tag(core::memory_tag::assets);
 
-			wrapper.reset();
-		};
+		if(anim)
+		{
+			result.link->id = id;
+			result.link->asset = anim;
+		}
 
 		return result;
 	};
 
 	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func);
-	output = ts.push_on_owner_thread(create_resource_func, ready_memory_task);
+	output = ts.push_on_owner_thread(create_resource_func, std::move(ready_memory_task));
 	return true;
 }
 
 template <>
-bool load_from_file<material>(core::task_future<asset_handle<material>>& output, const std::string& key)
+bool load_from_file<material>(core::task_future<asset_handle<material>>& output, const asset_id& id)
 {
+	const auto& key = id.str();
 	asset_handle<material> original;
 	if(output.is_ready())
 	{
@@ -467,9 +791,9 @@ bool load_from_file<material>(core::task_future<asset_handle<material>>& output,
 	auto& ts = core::get_subsystem<core::task_system>();
 	auto& am = core::get_subsystem<asset_manager>();
 
-	auto create_resource_func_fallback = [ result = original, key ]() mutable
+	auto create_resource_func_fallback = [ result = original, id ]() mutable
 	{
-		result.link->id = key;
+		result.link->id = id;
 		return result;
 	};
 
@@ -484,57 +808,67 @@ bool load_from_file<material>(core::task_future<asset_handle<material>>& output,
 	auto cache_key = fs::replace(key, ":/data", ":/cache");
 	fs::path absolute_key = fs::absolute(fs::resolve_protocol(cache_key).string());
 
+	auto compiled_key = cache_key.string() + ".asset";
 	auto compiled_absolute_key = absolute_key.string() + ".asset";
 
-	fs::error_code err;
-	if(!fs::exists(compiled_absolute_key, err))
+	if(!compiled_exists(compiled_key, compiled_absolute_key))
 	{
 		APPLOG_ERROR("Asset with key {0} and absolute_path {1} does not exist!", key, compiled_absolute_key);
 		output = am.load<material>("embedded:/fallback");
 		return true;
 	}
 
-	struct wrapper_t
-	{
-		std::shared_ptr<::material> material = std::make_shared<::material>();
-	};
-
-	auto wrapper = std::make_shared<wrapper_t>();
+	auto record = begin_load("material", key);
 
-	auto read_memory_func = [wrapper, compiled_absolute_key]() mutable {
-		std::ifstream stream{compiled_absolute_key, std::ios::in | std::ios::binary};
-
-		if(stream.bad())
+	auto read_memory_func = [compiled_key, compiled_absolute_key, record]() {
+		std::shared_ptr<::material> loaded;
+		auto compiled = read_compiled(compiled_key, compiled_absolute_key, record);
+		if(!compiled || core::get_current_cancellation().is_cancelled())
 		{
-			return false;
+			return loaded;
 		}
-		cereal::iarchive_binary_t ar(stream);
 
-		try_load(ar, cereal::make_nvp("material", wrapper->material));
+		asset_load_stats::stage_timer timer(record, asset_load_stats::stage::process);
+		PROFILE_SCOPE("material_process");
+		core::scoped_memory_tag alloc_tag(core::memory_tag::assets);
 
-		return true;
+		cereal::iarchive_binary_t ar(compiled.data, compiled.size);
+
+		loaded = std::make_shared<::material>();
+		try_load(ar, cereal::make_nvp("material", loaded));
+
+		return loaded;
 	};
 
-	auto create_resource_func = [ result = original, wrapper, key ](bool read_result) mutable
+	auto create_resource_func = [ result = original, id, record ](
+		const std::shared_ptr<::material>& loaded) mutable
 	{
-		if(read_result)
+		asset_load_stats::stage_timer timer(record, asset_load_stats::stage::upload, true);
+		PROFILE_SCOPE("material_upload");
+		core::scoped_memory_tag alloc_tag(core::memory_tag::assets);
+
+		if(loaded)
 		{
-			result.link->id = key;
-			result.link->asset = wrapper->material;
-			wrapper.reset();
+			result.link->id = id;
+			result.link->asset = loaded;
+			// the maps reload the material
+			auto& am = core::get_subsystem<asset_manager>();
+			loaded->visit_asset_keys(
+				[&am, &id](const std::string& key) { am.add_dependent<material>(id, key); });
 		}
 
 		return result;
 	};
 
 	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func);
-	output = ts.push_on_owner_thread(create_resource_func, ready_memory_task);
+	output = ts.push_on_owner_thread(create_resource_func, std::move(ready_memory_task));
 	return true;
 }
 
 template <>
-bool load_from_file<prefab>(core::task_future<asset_handle<prefab>>& output, const std::string& key)
+bool load_from_file<prefab>(core::task_future<asset_handle<prefab>>& output, const asset_id& id)
 {
+	const auto& key = id.str();
 	asset_handle<prefab> original;
 	if(output.is_ready())
 	{
@@ -543,9 +877,9 @@ bool load_from_file<prefab>(core::task_future<asset_handle<prefab>>& output, con
 
 	auto& ts = core::get_subsystem<core::task_system>();
 
-	auto create_resource_func_fallback = [ result = original, key ]() mutable
+	auto create_resource_func_fallback = [ result = original, id ]() mutable
 	{
-		result.link->id = key;
+		result.link->id = id;
 		return result;
 	};
 
@@ -559,54 +893,62 @@ bool load_from_file<prefab>(core::task_future<asset_handle<prefab>>& output, con
 	auto cache_key = fs::replace(key, ":/data", ":/cache");
 	fs::path absolute_key = fs::absolute(fs::resolve_protocol(cache_key).string());
 
+	auto compiled_key = cache_key.string() + ".asset";
 	auto compiled_absolute_key = absolute_key.string() + ".asset";
 
-	fs::error_code err;
-	if(!fs::exists(compiled_absolute_key, err))
+	if(!compiled_exists(compiled_key, compiled_absolute_key))
 	{
 		APPLOG_ERROR("Asset with key {0} and absolute_path {1} does not exist!", key, compiled_absolute_key);
 		output = ts.push_or_execute_on_worker_thread(create_resource_func_fallback);
 		return true;
 	}
 
-	std::shared_ptr<std::istringstream> read_memory = std::make_shared<std::istringstream>();
-
-	auto read_memory_func = [read_memory, compiled_absolute_key]() {
-		if(!read_memory)
-		{
-			return false;
-		}
-
-		auto stream =
-			std::fstream{compiled_absolute_key, std::fstream::in | std::fstream::out | std::ios::binary};
-		auto mem = fs::read_stream(stream);
-		*read_memory = std::istringstream(std::string(mem.begin(), mem.end()));
-
-		return true;
+	auto record = begin_load("prefab", key);
+
+	// the manifest in front is read right away, so the dependencies load
+	// along with the rest of the data
+	auto compiled = read_compiled(compiled_key, compiled_absolute_key, record);
+	asset_manifest manifest;
+	const auto manifest_size = manifest.read(compiled.data, compiled.size);
+	add_dependents<prefab>(id, manifest);
+
+	auto read_memory_func = [compiled, manifest_size, record]() {
+		asset_load_stats::stage_timer timer(record, asset_load_stats::stage::process);
+		PROFILE_SCOPE("prefab_process");
+		core::scoped_memory_tag alloc_tag(core::memory_tag::assets);
+		auto begin = reinterpret_cast<const char*>(compiled.data);
+		auto end = begin + compiled.size;
+		return std::make_shared<std::istringstream>(std::string(begin + manifest_size, end));
 	};
 
-	auto create_resource_func = [ result = original, read_memory, key ](bool read_result) mutable
+	auto create_resource_func = [ result = original, id, record ](
+		const std::shared_ptr<std::istringstream>& read_memory,
+		const std::shared_ptr<dependency_links>& links) mutable
 	{
-		if(read_result)
-		{
-			auto pfab = std::make_shared<prefab>();
-			pfab->data = read_memory;
+		asset_load_stats::stage_timer timer(record, asset_load_stats::stage::upload, true);
+		PROFILE_SCOPE("prefab_upload");
+		core::scoped_memory_tag alloc_tag(core::memory_tag::assets);
 
-			result.link->id = key;
-			result.link->asset = pfab;
-		}
+		auto pfab = std::make_shared<prefab>();
+		pfab->data = read_memory;
+		pfab->dependencies = *links;
+
+		result.link->id = id;
+		result.link->asset = pfab;
 
 		return result;
 	};
 
-	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func);
-	output = ts.push_on_owner_thread(create_resource_func, ready_memory_task);
+	auto ready_memory_task = ts.push_on_io_thread(read_memory_func);
+	output = ts.push_on_owner_thread(create_resource_func, std::move(ready_memory_task),
+									 load_dependencies(manifest));
 	return true;
 }
 
 template <>
-bool load_from_file<scene>(core::task_future<asset_handle<scene>>& output, const std::string& key)
+bool load_from_file<scene>(core::task_future<asset_handle<scene>>& output, const asset_id& id)
 {
+	const auto& key = id.str();
 	asset_handle<scene> original;
 	if(output.is_ready())
 	{
@@ -615,9 +957,9 @@ bool load_from_file<scene>(core::task_future<asset_handle<scene>>& output, const
 
 	auto& ts = core::get_subsystem<core::task_system>();
 
-	auto create_resource_func_fallback = [ result = original, key ]() mutable
+	auto create_resource_func_fallback = [ result = original, id ]() mutable
 	{
-		result.link->id = key;
+		result.link->id = id;
 		return result;
 	};
 
@@ -631,48 +973,55 @@ bool load_from_file<scene>(core::task_future<asset_handle<scene>>& output, const
 	auto cache_key = fs::replace(key, ":/data", ":/cache");
 	fs::path absolute_key = fs::absolute(fs::resolve_protocol(cache_key).string());
 
+	auto compiled_key = cache_key.string() + ".asset";
 	auto compiled_absolute_key = absolute_key.string() + ".asset";
 
-	fs::error_code err;
-	if(!fs::exists(compiled_absolute_key, err))
+	if(!compiled_exists(compiled_key, compiled_absolute_key))
 	{
 		APPLOG_ERROR("Asset with key {0} and absolute_path {1} does not exist!", key, compiled_absolute_key);
 		output = ts.push_or_execute_on_worker_thread(create_resource_func_fallback);
 		return true;
 	}
 
-	std::shared_ptr<std::istringstream> read_memory = std::make_shared<std::istringstream>();
-
-	auto read_memory_func = [read_memory, compiled_absolute_key]() {
-		if(!read_memory)
-		{
-			return false;
-		}
-
-		auto stream =
-			std::fstream{compiled_absolute_key, std::fstream::in | std::fstream::out | std::ios::binary};
-		auto mem = fs::read_stream(stream);
-		*read_memory = std::istringstream(std::string(mem.begin(), mem.end()));
-
-		return true;
+	auto record = begin_load("scene", key);
+
+	// the manifest in front is read right away, so the dependencies load
+	// along with the rest of the data
+	auto compiled = read_compiled(compiled_key, compiled_absolute_key, record);
+	asset_manifest manifest;
+	const auto manifest_size = manifest.read(compiled.data, compiled.size);
+	add_dependents<scene>(id, manifest);
+
+	auto read_memory_func = [compiled, manifest_size, record]() {
+		asset_load_stats::stage_timer timer(record, asset_load_stats::stage::process);
+		PROFILE_SCOPE("scene_process");
+		core::scoped_memory_tag alloc_tag(core::memory_tag::assets);
+		auto begin = reinterpret_cast<const char*>(compiled.data);
+		auto end = begin + compiled.size;
+		return std::make_shared<std::istringstream>(std::string(begin + manifest_size, end));
 	};
 
-	auto create_resource_func = [ result = original, read_memory, key ](bool read_result) mutable
+	auto create_resource_func = [ result = original, id, record ](
+		const std::shared_ptr<std::istringstream>& read_memory,
+		const std::shared_ptr<dependency_links>& links) mutable
 	{
-		if(read_result)
-		{
-			auto sc = std::make_shared<scene>();
-			sc->data = read_memory;
+		asset_load_stats::stage_timer timer(record, asset_load_stats::stage::upload, true);
+		PROFILE_SCOPE("scene_upload");
+		core::scoped_memory_tag alloc_tag(core::memory_tag::assets);
 
-			result.link->id = key;
-			result.link->asset = sc;
-		}
+		auto sc = std::make_shared<scene>();
+		sc->data = read_memory;
+		sc->dependencies = *links;
+
+		result.link->id = id;
+		result.link->asset = sc;
 
 		return result;
 	};
 
-	auto ready_memory_task = ts.push_on_worker_thread(read_memory_func);
-	output = ts.push_on_owner_thread(create_resource_func, ready_memory_task);
+	auto ready_memory_task = ts.push_on_io_thread(read_memory_func);
+	output = ts.push_on_owner_thread(create_resource_func, std::move(ready_memory_task),
+									 load_dependencies(manifest));
 	return true;
 }
 }
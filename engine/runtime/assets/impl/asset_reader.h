@@ -1,6 +1,7 @@
 #pragma once
 #include "../asset_handle.h"
 
+#include <core/filesystem/archive.h>
 #include <core/filesystem/filesystem.h>
 #include <core/system/subsystem.h>
 #include <core/tasks/task_system.h>
@@ -11,22 +12,46 @@ namespace asset_reader
 {
 
 template <typename T>
-extern bool load_from_file(core::task_future<asset_handle<T>>& output, const std::string& key);
+extern bool load_from_file(core::task_future<asset_handle<T>>& output, const asset_id& id);
+
+//-----------------------------------------------------------------------------
+//  Name : mount_compiled ()
+/// <summary>
+/// Mounts the data in memory in place of the compiled file of the asset.
+/// </summary>
+//-----------------------------------------------------------------------------
+void mount_compiled(const asset_id& id, const fs::mapped_range& data);
+
+//-----------------------------------------------------------------------------
+//  Name : load_from_memory ()
+/// <summary>
+/// The loader of the files of the type reads the mounted data in place of
+/// the compiled file, so that what it makes refers to the bytes as it would
+/// to those of a mapping.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename T>
+inline bool load_from_memory(core::task_future<asset_handle<T>>& output, const asset_id& id,
+							 const fs::mapped_range& data)
+{
+	mount_compiled(id, data);
+	return load_from_file<T>(output, id);
+}
 
 template <typename T>
-inline bool load_from_instance(core::task_future<asset_handle<T>>& output, const std::string& key,
+inline bool load_from_instance(core::task_future<asset_handle<T>>& output, const asset_id& id,
 							   std::shared_ptr<T> instance)
 {
 	auto& ts = core::get_subsystem<core::task_system>();
 	output = ts.push_or_execute_on_owner_thread(
-		[](const std::string& key, std::shared_ptr<T> instance) {
+		[](const asset_id& id, std::shared_ptr<T> instance) {
 			asset_handle<T> handle;
-			handle.link->id = key;
+			handle.link->id = id;
 			handle.link->asset = instance;
 
 			return handle;
 		},
-		key, instance);
+		id, instance);
 
 	return true;
 }
@@ -0,0 +1,165 @@
+#include "upload_queue.h"
+
+#include <algorithm>
+
+namespace runtime
+{
+upload_queue::~upload_queue()
+{
+	// the owner tasks awaiting the tickets are let run
+	std::lock_guard<std::mutex> lock(mutex_);
+	for(auto& e : entries_)
+	{
+		admit(e);
+	}
+	entries_.clear();
+}
+
+upload_queue::ticket upload_queue::push_impl(const asset_id& key, std::function<bool()> is_ready,
+											 std::function<std::size_t()> size_of)
+{
+	entry e;
+	e.key = key;
+	e.is_ready = std::move(is_ready);
+	e.size_of = std::move(size_of);
+	e.state = core::detail::future_state_ptr<bool>::create();
+	auto result = ticket::from_state(e.state);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = requests_.find(key);
+	if(it == requests_.end())
+	{
+		// not requested, it may be waited on
+		admit(e);
+		return result;
+	}
+
+	e.priority = it->second;
+	e.order = next_order_++;
+	entries_.push_back(std::move(e));
+	return result;
+}
+
+void upload_queue::begin_request(const asset_id& key, float priority)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	requests_[key] = priority;
+}
+
+void upload_queue::end_request(const asset_id& key)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	requests_.erase(key);
+}
+
+void upload_queue::set_priority(const asset_id& key, float priority)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	for(auto& e : entries_)
+	{
+		if(e.key == key)
+		{
+			e.priority = priority;
+		}
+	}
+}
+
+void upload_queue::promote(const asset_id& key)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = std::find_if(std::begin(entries_), std::end(entries_),
+						   [&key](const entry& e) { return e.key == key; });
+	if(it != std::end(entries_))
+	{
+		frame_bytes_ += get_size(*it);
+		admit(*it);
+		entries_.erase(it);
+	}
+}
+
+void upload_queue::update()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	frame_bytes_ = 0;
+
+	std::vector<entry*> ready;
+	for(auto& e : entries_)
+	{
+		if(e.is_ready())
+		{
+			ready.push_back(&e);
+		}
+	}
+
+	std::sort(std::begin(ready), std::end(ready), [](const entry* a, const entry* b) {
+		return a->priority != b->priority ? a->priority > b->priority : a->order < b->order;
+	});
+
+	bool admitted = false;
+	for(auto e : ready)
+	{
+		const auto size = get_size(*e);
+		if(budget_ > 0 && admitted && frame_bytes_ + size > budget_)
+		{
+			break;
+		}
+
+		frame_bytes_ += size;
+		admit(*e);
+		admitted = true;
+	}
+
+	entries_.erase(std::remove_if(std::begin(entries_), std::end(entries_),
+								  [](const entry& e) { return !e.state; }),
+				   std::end(entries_));
+}
+
+upload_queue::backlog upload_queue::get_backlog() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	backlog result;
+	result.count = entries_.size();
+	for(const auto& e : entries_)
+	{
+		if(e.is_ready())
+		{
+			++result.ready_count;
+			result.ready_bytes += get_size(e);
+		}
+	}
+	return result;
+}
+
+std::size_t upload_queue::get_frame_bytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return frame_bytes_;
+}
+
+std::size_t upload_queue::get_size(const entry& e)
+{
+	if(!e.is_ready())
+	{
+		return 0;
+	}
+
+	// a failed read uploads nothing
+	try
+	{
+		return e.size_of();
+	}
+	catch(...)
+	{
+		return 0;
+	}
+}
+
+void upload_queue::admit(entry& e)
+{
+	if(e.state)
+	{
+		e.state->set_value(true);
+		e.state = {};
+	}
+}
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "asset_id.h"
+
+#include <core/tasks/task_system.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace runtime
+{
+/*
+ * upload_queue; spreads the creation of the gpu resources of the loads over
+ * the frames, under a budget of bytes per frame.
+ *
+ *      A loader pushes an upload with the future of the data it is made from
+ *      and gets a ticket, the owner task creating the resource awaits it
+ *      along with the data. Once a frame the uploads with their data ready
+ *      are admitted by priority while the bytes admitted that frame fit the
+ *      budget, at least one a frame. The priority is the one of the request
+ *      of the asset, an upload that was not requested may be waited on and
+ *      is admitted right away.
+ */
+class upload_queue
+{
+public:
+	using ticket = core::task_future<bool>;
+
+	/// uploads waiting for a ticket
+	struct backlog
+	{
+		std::size_t count = 0;
+		/// of the ones with their data ready
+		std::size_t ready_count = 0;
+		std::size_t ready_bytes = 0;
+	};
+
+	~upload_queue();
+
+	//-----------------------------------------------------------------------------
+	//  Name : push ()
+	/// <summary>
+	/// Queues the upload of an asset made from the data, size_of gives the
+	/// bytes it uploads from the data once it is ready. Safe to call from any
+	/// thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <typename T, typename F>
+	ticket push(const asset_id& key, const core::task_future<T>& data, F&& size_of)
+	{
+		return push_impl(key, [data]() { return data.is_ready(); },
+						 [ data, size_of = std::forward<F>(size_of) ]() { return size_of(data.get()); });
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : begin_request ()
+	/// <summary>
+	/// Marks the asset as requested with the priority until end_request, the
+	/// higher the sooner. The load of the request is started in between,
+	/// the uploads it pushes take the priority.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void begin_request(const asset_id& key, float priority);
+
+	void end_request(const asset_id& key);
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_priority ()
+	/// <summary>
+	/// Changes the priority of a queued upload, does nothing for one that is
+	/// not queued.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_priority(const asset_id& key, float priority);
+
+	//-----------------------------------------------------------------------------
+	//  Name : promote ()
+	/// <summary>
+	/// Admits the upload of the asset right away, for one about to be waited
+	/// on.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void promote(const asset_id& key);
+
+	//-----------------------------------------------------------------------------
+	//  Name : update ()
+	/// <summary>
+	/// Admits the ready uploads for the frame. Once a frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void update();
+
+	/// bytes admitted a frame, 0 for no budget
+	void set_budget(std::size_t budget)
+	{
+		budget_ = budget;
+	}
+
+	std::size_t get_budget() const
+	{
+		return budget_;
+	}
+
+	backlog get_backlog() const;
+
+	/// bytes admitted by the last update and promoted since
+	std::size_t get_frame_bytes() const;
+
+private:
+	struct entry
+	{
+		asset_id key;
+		float priority = 0.0f;
+		std::uint64_t order = 0;
+		std::function<bool()> is_ready;
+		std::function<std::size_t()> size_of;
+		core::detail::future_state_ptr<bool> state;
+	};
+
+	ticket push_impl(const asset_id& key, std::function<bool()> is_ready,
+					 std::function<std::size_t()> size_of);
+
+	static std::size_t get_size(const entry& e);
+	static void admit(entry& e);
+
+	mutable std::mutex mutex_;
+	std::vector<entry> entries_;
+	/// priorities of the requests being started
+	std::unordered_map<asset_id, float, asset_id::hasher> requests_;
+	std::uint64_t next_order_ = 0;
+	std::size_t budget_ = 0;
+	std::size_t frame_bytes_ = 0;
+};
+}
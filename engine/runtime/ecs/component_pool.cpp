@@ -0,0 +1,184 @@
+#include "component_pool.h"
+
+#include <algorithm>
+
+namespace runtime
+{
+namespace ecs
+{
+namespace detail
+{
+
+block_pool::block_pool(std::size_t block_size, std::size_t block_align, std::size_t blocks_per_chunk)
+	: blocks_per_chunk_(std::max<std::size_t>(blocks_per_chunk, 1))
+{
+	// every block must be able to hold the free list link
+	const auto align = std::max(block_align, alignof(free_block));
+	block_size_ = std::max(block_size, sizeof(free_block));
+	block_size_ = (block_size_ + align - 1) / align * align;
+}
+
+void* block_pool::allocate()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if(!free_)
+	{
+		chunks_.emplace_back(new unsigned char[block_size_ * blocks_per_chunk_]);
+		auto* chunk = chunks_.back().get();
+		// link the blocks so that the first one is handed out first
+		for(std::size_t i = blocks_per_chunk_; i > 0; --i)
+		{
+			auto* block = reinterpret_cast<free_block*>(chunk + (i - 1) * block_size_);
+			block->next = free_;
+			free_ = block;
+		}
+	}
+
+	auto* block = free_;
+	free_ = block->next;
+	++used_;
+	return block;
+}
+
+void block_pool::deallocate(void* block) noexcept
+{
+	if(!block)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto* freed = static_cast<free_block*>(block);
+	freed->next = free_;
+	free_ = freed;
+	--used_;
+}
+
+std::size_t block_pool::get_used_blocks() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return used_;
+}
+
+std::size_t block_pool::get_capacity_blocks() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return chunks_.size() * blocks_per_chunk_;
+}
+
+std::size_t block_pool::shrink()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if(chunks_.empty())
+	{
+		return 0;
+	}
+
+	// chunk indices sorted by address to find the chunk of a free block
+	std::vector<std::size_t> order(chunks_.size());
+	for(std::size_t i = 0; i < order.size(); ++i)
+	{
+		order[i] = i;
+	}
+	std::sort(std::begin(order), std::end(order),
+			  [this](std::size_t lhs, std::size_t rhs) { return chunks_[lhs].get() < chunks_[rhs].get(); });
+
+	const auto find_chunk = [this, &order](const free_block* block) {
+		const auto* address = reinterpret_cast<const unsigned char*>(block);
+		auto it = std::upper_bound(
+			std::begin(order), std::end(order), address,
+			[this](const unsigned char* a, std::size_t i) { return a < chunks_[i].get(); });
+		return *(it - 1);
+	};
+
+	std::vector<std::size_t> free_count(chunks_.size(), 0);
+	for(auto* block = free_; block; block = block->next)
+	{
+		++free_count[find_chunk(block)];
+	}
+
+	// relink the free blocks of the chunks that stay, in the same order
+	free_block* kept = nullptr;
+	free_block** tail = &kept;
+	for(auto* block = free_; block; block = block->next)
+	{
+		if(free_count[find_chunk(block)] != blocks_per_chunk_)
+		{
+			*tail = block;
+			tail = &block->next;
+		}
+	}
+	*tail = nullptr;
+	free_ = kept;
+
+	std::size_t released = 0;
+	for(std::size_t i = chunks_.size(); i > 0; --i)
+	{
+		if(free_count[i - 1] == blocks_per_chunk_)
+		{
+			chunks_.erase(std::begin(chunks_) + static_cast<std::ptrdiff_t>(i - 1));
+			++released;
+		}
+	}
+	chunks_.shrink_to_fit();
+	return released;
+}
+
+namespace
+{
+std::mutex& get_block_pools_mutex()
+{
+	static auto* mutex = new std::mutex();
+	return *mutex;
+}
+
+struct pool_entry
+{
+	block_pool* pool = nullptr;
+	std::size_t tag = untagged_pool;
+	std::size_t object_size = 0;
+};
+
+std::vector<pool_entry>& get_block_pools()
+{
+	static auto* pools = new std::vector<pool_entry>();
+	return *pools;
+}
+}
+
+block_pool* register_block_pool(block_pool* pool, std::size_t tag, std::size_t object_size)
+{
+	std::lock_guard<std::mutex> lock(get_block_pools_mutex());
+	get_block_pools().push_back({pool, tag, object_size});
+	return pool;
+}
+
+void shrink_block_pools()
+{
+	std::lock_guard<std::mutex> lock(get_block_pools_mutex());
+	for(const auto& entry : get_block_pools())
+	{
+		entry.pool->shrink();
+	}
+}
+
+std::vector<block_pool_stats> get_block_pools_stats()
+{
+	std::lock_guard<std::mutex> lock(get_block_pools_mutex());
+	std::vector<block_pool_stats> result;
+	result.reserve(get_block_pools().size());
+	for(const auto& entry : get_block_pools())
+	{
+		block_pool_stats stats;
+		stats.tag = entry.tag;
+		stats.object_size = entry.object_size;
+		stats.block_size = entry.pool->get_block_size();
+		stats.used_blocks = entry.pool->get_used_blocks();
+		stats.capacity_blocks = entry.pool->get_capacity_blocks();
+		result.push_back(stats);
+	}
+	return result;
+}
+}
+}
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace runtime
+{
+namespace ecs
+{
+namespace detail
+{
+
+/*
+ * block_pool; hands out fixed size blocks carved from big chunks.
+ *
+ *      Every component type gets its own pool so that the components of a
+ *      type are kept next to each other instead of being scattered among all
+ *      the other heap allocations. Blocks never move, so pointers and handles
+ *      to them stay valid until they are released. Released blocks are reused
+ *      before a new chunk is carved.
+ */
+class block_pool
+{
+public:
+	block_pool(std::size_t block_size, std::size_t block_align, std::size_t blocks_per_chunk = 256);
+	block_pool(const block_pool&) = delete;
+	block_pool& operator=(const block_pool&) = delete;
+
+	void* allocate();
+	void deallocate(void* block) noexcept;
+
+	std::size_t get_block_size() const
+	{
+		return block_size_;
+	}
+
+	/// blocks currently handed out
+	std::size_t get_used_blocks() const;
+
+	/// blocks in all the chunks, used or not
+	std::size_t get_capacity_blocks() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : shrink ()
+	/// <summary>
+	/// Releases the chunks that have no block in use. Returns the number of
+	/// released chunks.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t shrink();
+
+private:
+	struct free_block
+	{
+		free_block* next;
+	};
+
+	std::size_t block_size_ = 0;
+	std::size_t blocks_per_chunk_ = 0;
+	std::vector<std::unique_ptr<unsigned char[]>> chunks_;
+	free_block* free_ = nullptr;
+	std::size_t used_ = 0;
+	/// components may be released from any thread holding the last reference.
+	mutable std::mutex mutex_;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : shrink_block_pools ()
+/// <summary>
+/// Releases the unused chunks of every block pool.
+/// </summary>
+//-----------------------------------------------------------------------------
+void shrink_block_pools();
+
+/// tag of the pools that were not created for a component type
+constexpr std::size_t untagged_pool = ~std::size_t(0);
+/// tag of the pools of the asset links every asset handle holds
+constexpr std::size_t asset_pool = untagged_pool - 1;
+
+struct block_pool_stats
+{
+	/// component family the pool was created for, untagged_pool if none
+	std::size_t tag = untagged_pool;
+	/// size of the object stored in a block, the rest is control block and padding
+	std::size_t object_size = 0;
+	std::size_t block_size = 0;
+	std::size_t used_blocks = 0;
+	std::size_t capacity_blocks = 0;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : register_block_pool ()
+/// <summary>
+/// Adds a pool to the list walked by shrink_block_pools and
+/// get_block_pools_stats.
+/// </summary>
+//-----------------------------------------------------------------------------
+block_pool* register_block_pool(block_pool* pool, std::size_t tag, std::size_t object_size);
+
+//-----------------------------------------------------------------------------
+//  Name : get_block_pools_stats ()
+/// <summary>
+/// Returns the usage of every block pool.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::vector<block_pool_stats> get_block_pools_stats();
+
+//-----------------------------------------------------------------------------
+//  Name : get_block_pool ()
+/// <summary>
+/// Returns the pool of blocks for T. The pool is never destroyed, components
+/// may outlive every static object that could own it. The tag and object
+/// size of the first call are kept for the stats.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename T>
+inline block_pool& get_block_pool(std::size_t tag = untagged_pool, std::size_t object_size = 0)
+{
+	static auto* pool = register_block_pool(new block_pool(sizeof(T), alignof(T)), tag, object_size);
+	return *pool;
+}
+
+/*
+ * pool_allocator; allocator for std::allocate_shared that puts the object
+ * and its control block in the block pool of the type.
+ *
+ *      The tag and the object size survive the rebind to the control block
+ *      type so the pool can be told apart in the stats.
+ */
+template <typename T>
+struct pool_allocator
+{
+	using value_type = T;
+
+	pool_allocator() noexcept = default;
+
+	pool_allocator(std::size_t tag, std::size_t object_size) noexcept
+		: tag_(tag)
+		, object_size_(object_size)
+	{
+	}
+
+	template <typename U>
+	pool_allocator(const pool_allocator<U>& other) noexcept
+		: tag_(other.tag_)
+		, object_size_(other.object_size_)
+	{
+	}
+
+	T* allocate(std::size_t n)
+	{
+		if(n != 1 || alignof(T) > alignof(std::max_align_t))
+		{
+			return static_cast<T*>(::operator new(n * sizeof(T)));
+		}
+		return static_cast<T*>(get_block_pool<T>(tag_, object_size_).allocate());
+	}
+
+	void deallocate(T* p, std::size_t n) noexcept
+	{
+		if(n != 1 || alignof(T) > alignof(std::max_align_t))
+		{
+			::operator delete(p);
+			return;
+		}
+		get_block_pool<T>(tag_, object_size_).deallocate(p);
+	}
+
+	template <typename U>
+	bool operator==(const pool_allocator<U>& other) const noexcept
+	{
+		return tag_ == other.tag_ && object_size_ == other.object_size_;
+	}
+
+	template <typename U>
+	bool operator!=(const pool_allocator<U>& other) const noexcept
+	{
+		return !(*this == other);
+	}
+
+	std::size_t tag_ = untagged_pool;
+	std::size_t object_size_ = 0;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : make_pooled ()
+/// <summary>
+/// Creates a T with its control block in the block pool of the type, the
+/// tag tells the pool apart in the stats.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename T, typename... Args>
+inline std::shared_ptr<T> make_pooled(std::size_t tag, Args&&... args)
+{
+	const pool_allocator<T> allocator(tag, sizeof(T));
+	return std::allocate_shared<T>(allocator, std::forward<Args>(args)...);
+}
+}
+}
+}
@@ -0,0 +1,319 @@
+#include "animation_component.h"
+
+#include <algorithm>
+#include <cmath>
+
+void animation_component::set_animation(asset_handle<runtime::animation> anim)
+{
+	current_ = layer();
+	current_.anim = std::move(anim);
+	previous_ = layer();
+	reset_nodes();
+
+	set_autoplay(auto_play_);
+}
+
+asset_handle<runtime::animation> animation_component::get_animation() const
+{
+	return current_.anim;
+}
+
+void animation_component::set_autoplay(bool on)
+{
+	auto_play_ = on;
+	if(auto_play_ && !playing_)
+	{
+		play();
+	}
+}
+
+bool animation_component::get_autoplay() const
+{
+	return auto_play_;
+}
+
+void animation_component::set_loop(bool on)
+{
+	loop_ = on;
+}
+
+bool animation_component::is_looping() const
+{
+	return loop_;
+}
+
+void animation_component::set_speed(float speed)
+{
+	speed_ = speed;
+}
+
+float animation_component::get_speed() const
+{
+	return speed_;
+}
+
+void animation_component::set_time(seconds_t time)
+{
+	current_.time = time.count();
+	advance(current_, 0.0f);
+	snap_ = true;
+}
+
+animation_component::seconds_t animation_component::get_time() const
+{
+	return seconds_t(current_.time);
+}
+
+void animation_component::play()
+{
+	playing_ = true;
+}
+
+void animation_component::stop()
+{
+	playing_ = false;
+	current_.time = 0.0f;
+	previous_ = layer();
+}
+
+void animation_component::pause()
+{
+	playing_ = false;
+}
+
+bool animation_component::is_playing() const
+{
+	return playing_;
+}
+
+void animation_component::cross_fade(asset_handle<runtime::animation> anim, seconds_t duration)
+{
+	if(duration.count() <= 0.0f || !current_.anim)
+	{
+		set_animation(std::move(anim));
+		return;
+	}
+
+	previous_ = std::move(current_);
+	current_ = layer();
+	current_.anim = std::move(anim);
+	fade_time_ = 0.0f;
+	fade_duration_ = duration.count();
+	play();
+}
+
+bool animation_component::update(delta_t dt, const animation_lod& lod, const runtime::skeleton& skeleton,
+								 std::vector<math::transform>& pose)
+{
+	if(!playing_)
+	{
+		return false;
+	}
+
+	// the model changed or its mesh was reloaded
+	if(skeleton_ != &skeleton || rest_.size() != skeleton.size())
+	{
+		reset_nodes();
+		skeleton_ = &skeleton;
+		rest_.resize(skeleton.size());
+		for(std::size_t i = 0; i < skeleton.size(); ++i)
+		{
+			const auto& local = skeleton.rest_pose[i];
+			const auto& rotation = local.get_rotation();
+			auto& rest = rest_[i];
+			rest.position = math::vec4(local.get_position(), 0.0f);
+			rest.rotation = math::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+			rest.scale = math::vec4(local.get_scale(), 0.0f);
+		}
+		poses_ = rest_;
+		shown_ = rest_;
+		sampled_.assign(rest_.size(), 0);
+	}
+
+	const auto step = dt.count() * speed_;
+	advance(current_, step);
+	if(previous_.anim)
+	{
+		fade_time_ += dt.count();
+		if(fade_time_ < fade_duration_)
+		{
+			advance(previous_, step);
+		}
+		else
+		{
+			previous_ = layer();
+		}
+	}
+
+	// the last pose of an animation that stops is always sampled and shown
+	const bool last = is_finished();
+
+	// not seen, only the time goes on
+	bool written = false;
+	if(lod.interval == 0 && !last)
+	{
+		snap_ = true;
+	}
+	else if(bind(current_))
+	{
+		snap_ |= last;
+		if(snap_ || ++frames_ >= std::min(interval_, lod.interval))
+		{
+			const bool fading = previous_.anim && bind(previous_);
+
+			from_ = shown_;
+			sampled_.assign(poses_.size(), 0);
+			sample(current_, 1.0f, lod.nodes);
+			if(fading)
+			{
+				sample(previous_, 1.0f - fade_time_ / fade_duration_, lod.nodes);
+			}
+			frames_ = 0;
+			interval_ = std::max(lod.interval, 1u);
+		}
+
+		const auto weight = snap_ ? 1.0f : float(frames_ + 1) / float(interval_);
+		snap_ = false;
+
+		const auto count = std::min(poses_.size(), pose.size());
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			if(!sampled_[i])
+			{
+				continue;
+			}
+
+			auto& shown = shown_[i];
+			shown = from_[i];
+			runtime::blend(shown, poses_[i], weight);
+
+			const auto& rotation = shown.rotation;
+			auto& local = pose[i];
+			local.set_position(math::vec3(shown.position));
+			local.set_rotation(math::quat(rotation.w, rotation.x, rotation.y, rotation.z));
+			local.set_scale(math::vec3(shown.scale));
+			written = true;
+		}
+	}
+
+	// the last pose stays
+	if(last)
+	{
+		playing_ = false;
+	}
+	return written;
+}
+
+bool animation_component::is_finished() const
+{
+	if(loop_ || !current_.anim)
+	{
+		return false;
+	}
+
+	const auto duration = current_.anim->clip.duration;
+	return speed_ >= 0.0f ? current_.time >= duration : current_.time <= 0.0f;
+}
+
+void animation_component::advance(layer& l, float dt) const
+{
+	if(!l.anim)
+	{
+		return;
+	}
+
+	const auto duration = l.anim->clip.duration;
+	if(duration <= 0.0f)
+	{
+		l.time = 0.0f;
+		return;
+	}
+
+	l.time += dt;
+	if(loop_)
+	{
+		l.time = std::fmod(l.time, duration);
+		if(l.time < 0.0f)
+		{
+			l.time += duration;
+		}
+	}
+	else
+	{
+		l.time = math::clamp(l.time, 0.0f, duration);
+	}
+}
+
+bool animation_component::bind(layer& l)
+{
+	if(!l.anim || l.anim->clip.empty() || !skeleton_)
+	{
+		return false;
+	}
+
+	// bound until the asset is reloaded
+	const auto& clip = l.anim->clip;
+	if(l.clip == &clip)
+	{
+		return true;
+	}
+
+	l.slots.clear();
+	l.slots.reserve(clip.channels.size());
+	for(const auto& channel : clip.channels)
+	{
+		l.slots.emplace_back(skeleton_->find_node(channel.node_name));
+	}
+
+	l.cursors.assign(clip.channels.size(), {});
+	l.clip = &clip;
+	return true;
+}
+
+void animation_component::sample(layer& l, float weight, const std::vector<std::uint8_t>* nodes)
+{
+	const bool all_nodes = !nodes || nodes->size() != poses_.size();
+	const auto& clip = *l.clip;
+	for(std::size_t i = 0; i < clip.channels.size(); ++i)
+	{
+		const auto slot = l.slots[i];
+		if(slot >= poses_.size() || (!all_nodes && !(*nodes)[slot]))
+		{
+			continue;
+		}
+
+		auto pose = rest_[slot];
+		clip.sample(i, l.time, l.cursors[i], pose);
+		if(sampled_[slot])
+		{
+			runtime::blend(poses_[slot], pose, weight);
+		}
+		else
+		{
+			poses_[slot] = pose;
+			sampled_[slot] = 1;
+		}
+	}
+}
+
+void animation_component::reset_nodes()
+{
+	skeleton_ = nullptr;
+	rest_.clear();
+	poses_.clear();
+	shown_.clear();
+	from_.clear();
+	snap_ = true;
+	current_.clip = nullptr;
+	previous_.clip = nullptr;
+}
+
+std::shared_ptr<runtime::component> animation_component::clone(const runtime::clone_map& /*map*/) const
+{
+	auto copy = runtime::make_component<animation_component>();
+	copy->auto_play_ = auto_play_;
+	copy->loop_ = loop_;
+	copy->speed_ = speed_;
+	copy->set_animation(current_.anim);
+	return copy;
+}
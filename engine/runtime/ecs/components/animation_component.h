@@ -0,0 +1,148 @@
+#pragma once
+
+#include "../../animation/animation.h"
+#include "../../animation/skeleton.h"
+#include "../../assets/asset_handle.h"
+#include "../ecs.h"
+
+#include <core/common/basetypes.hpp>
+
+#include <vector>
+
+/// how much of an animation is updated in a frame, picked by the animation system
+struct animation_lod
+{
+	/// the frames from a sample to the next, the pose is interpolated in
+	/// between. 0 only advances the time.
+	std::uint32_t interval = 1;
+	/// the nodes sampled, all of them when empty
+	const std::vector<std::uint8_t>* nodes = nullptr;
+};
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : animation_component (Class)
+/// <summary>
+/// Plays an animation on the skeleton of the model of the entity, the nodes
+/// named as the channels of the animation.
+/// </summary>
+//-----------------------------------------------------------------------------
+class animation_component : public runtime::component_impl<animation_component>
+{
+	SERIALIZABLE(animation_component)
+	REFLECTABLEV(animation_component, component)
+
+public:
+	using seconds_t = runtime::animation::seconds_t;
+
+	//-------------------------------------------------------------------------
+	// Public Methods
+	//-------------------------------------------------------------------------
+	void set_animation(asset_handle<runtime::animation> anim);
+	asset_handle<runtime::animation> get_animation() const;
+
+	void set_autoplay(bool on);
+	bool get_autoplay() const;
+
+	void set_loop(bool on);
+	bool is_looping() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_speed ()
+	/// <summary>
+	/// Sets the multiplier of the time, negative plays backwards.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_speed(float speed);
+	float get_speed() const;
+
+	void set_time(seconds_t time);
+	seconds_t get_time() const;
+
+	void play();
+	void stop();
+	void pause();
+	bool is_playing() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : cross_fade ()
+	/// <summary>
+	/// Plays another animation from the start, blended in over the duration
+	/// while the current one keeps playing under it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void cross_fade(asset_handle<runtime::animation> anim, seconds_t duration);
+
+	//-----------------------------------------------------------------------------
+	//  Name : update ()
+	/// <summary>
+	/// Advances the time, samples the animations at it and sets the local
+	/// transforms of the nodes of the pose of the skeleton. Done by the
+	/// animation system, only the pose of the entity is written so the
+	/// entities can be updated concurrently. Between the samples of a lod
+	/// the pose moves from the one shown to the last sampled. False when the
+	/// pose wasn't written.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool update(delta_t dt, const animation_lod& lod, const runtime::skeleton& skeleton,
+				std::vector<math::transform>& pose);
+
+	//-----------------------------------------------------------------------------
+	//  Name : clone ()
+	/// <summary>
+	/// A new component playing the same animation the way this one is set to.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<runtime::component> clone(const runtime::clone_map& map) const override;
+
+private:
+	/// an animation being played with where its channels are at
+	struct layer
+	{
+		asset_handle<runtime::animation> anim;
+		float time = 0.0f;
+		/// the clip the cursors and slots were made for
+		const runtime::animation_clip* clip = nullptr;
+		std::vector<runtime::animation_clip::cursor> cursors;
+		/// the node of every channel, an index of the skeleton
+		std::vector<std::uint32_t> slots;
+	};
+
+	void advance(layer& l, float dt) const;
+	bool bind(layer& l);
+	void sample(layer& l, float weight, const std::vector<std::uint8_t>* nodes);
+	bool is_finished() const;
+	void reset_nodes();
+
+	//-------------------------------------------------------------------------
+	// Private Member Variables.
+	//-------------------------------------------------------------------------
+	bool auto_play_ = true;
+	bool loop_ = true;
+	float speed_ = 1.0f;
+
+	bool playing_ = false;
+	layer current_;
+	/// faded out while the current one is faded in
+	layer previous_;
+	float fade_time_ = 0.0f;
+	float fade_duration_ = 0.0f;
+
+	/// the skeleton the layers are bound to, the rest pose of its nodes and
+	/// the pose of the frame
+	const runtime::skeleton* skeleton_ = nullptr;
+	std::vector<runtime::node_pose> rest_;
+	std::vector<runtime::node_pose> poses_;
+	/// whether a layer sampled the pose of the node in the last sample
+	std::vector<std::uint8_t> sampled_;
+	/// the pose shown and where it was when the last sample was taken
+	std::vector<runtime::node_pose> shown_;
+	std::vector<runtime::node_pose> from_;
+	/// the frames shown since the last sample and the interval it was for
+	std::uint32_t frames_ = 0;
+	std::uint32_t interval_ = 1;
+	/// the next sample is shown at once, e.g. after the time jumped
+	bool snap_ = true;
+};
@@ -1,10 +1,49 @@
 #include "audio_listener_component.h"
 
-void audio_listener_component::update(const math::transform& t)
+void audio_listener_component::update(const math::transform& t, delta_t dt, std::uint32_t frame)
 {
-	auto pos = t.get_position();
-	auto forward = t.z_unit_axis();
-	auto up = t.y_unit_axis();
-	listener_.set_position({{pos.x, pos.y, pos.z}});
-	listener_.set_orientation({{forward.x, forward.y, forward.z}}, {{up.x, up.y, up.z}});
+	const auto pos = t.get_position();
+	const auto forward = t.z_unit_axis();
+	const auto up = t.y_unit_axis();
+
+	auto velocity = math::vec3(0.0f, 0.0f, 0.0f);
+	if(placed_ && dt.count() > 0.0f)
+	{
+		velocity = (pos - position_) / dt.count();
+	}
+
+	if(!placed_ || pos != position_)
+	{
+		listener_.set_position({{pos.x, pos.y, pos.z}});
+	}
+	if(!placed_ || forward != forward_ || up != up_)
+	{
+		listener_.set_orientation({{forward.x, forward.y, forward.z}}, {{up.x, up.y, up.z}});
+	}
+	if(!placed_ || velocity != velocity_)
+	{
+		listener_.set_velocity({{velocity.x, velocity.y, velocity.z}});
+	}
+
+	position_ = pos;
+	forward_ = forward;
+	up_ = up;
+	velocity_ = velocity;
+	placed_ = true;
+	placed_frame_ = frame;
+}
+
+void audio_listener_component::settle()
+{
+	const auto still = math::vec3(0.0f, 0.0f, 0.0f);
+	if(velocity_ != still)
+	{
+		velocity_ = still;
+		listener_.set_velocity({{0.0f, 0.0f, 0.0f}});
+	}
+}
+
+std::shared_ptr<runtime::component> audio_listener_component::clone(const runtime::clone_map& /*map*/) const
+{
+	return runtime::make_component<audio_listener_component>();
 }
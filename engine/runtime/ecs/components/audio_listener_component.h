@@ -3,6 +3,7 @@
 #include "../ecs.h"
 
 #include <core/audio/listener.h>
+#include <core/common/basetypes.hpp>
 #include <core/math/math_includes.h>
 
 //-----------------------------------------------------------------------------
@@ -27,16 +28,48 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : update ()
 	/// <summary>
-	///
-	///
-	///
+	/// Moves the listener to its world transform, with the velocity it moved
+	/// there at over dt. Only the changes are given to the device.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	void update(const math::transform& t);
+	void update(const math::transform& t, delta_t dt, std::uint32_t frame);
+
+	//-----------------------------------------------------------------------------
+	//  Name : settle ()
+	/// <summary>
+	/// The listener did not move in the frame, it has no velocity anymore.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void settle();
+
+	/// the frame the listener was last moved in
+	std::uint32_t get_placed_frame() const
+	{
+		return placed_frame_;
+	}
+
+	bool is_placed() const
+	{
+		return placed_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : clone ()
+	/// <summary>
+	/// A new listener, there is nothing to copy.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<runtime::component> clone(const runtime::clone_map& map) const override;
 
 private:
 	//-------------------------------------------------------------------------
 	// Private Member Variables.
 	//-------------------------------------------------------------------------
 	audio::listener listener_;
+	math::vec3 position_ = {0.0f, 0.0f, 0.0f};
+	math::vec3 forward_ = {0.0f, 0.0f, 1.0f};
+	math::vec3 up_ = {0.0f, 1.0f, 0.0f};
+	math::vec3 velocity_ = {0.0f, 0.0f, 0.0f};
+	bool placed_ = false;
+	std::uint32_t placed_frame_ = 0;
 };
@@ -1,40 +1,105 @@
 #include "audio_source_component.h"
+#include <cmath>
 #include <limits>
 
-void audio_source_component::update(const math::transform& t)
+audio_source_component::~audio_source_component()
 {
-	auto pos = t.get_position();
-	auto forward = t.z_unit_axis();
-	auto up = t.y_unit_axis();
-	source_.set_position({{pos.x, pos.y, pos.z}});
-	source_.set_orientation({{forward.x, forward.y, forward.z}}, {{up.x, up.y, up.z}});
+	// the voice goes back to the pool
+	if(voice_)
+	{
+		voice_->stop();
+	}
+}
+
+void audio_source_component::place(const math::transform& t, delta_t dt, std::uint32_t frame)
+{
+	const auto pos = t.get_position();
+	const auto forward = t.z_unit_axis();
+	const auto up = t.y_unit_axis();
+
+	// the first placement has nowhere to have moved from
+	auto velocity = math::vec3(0.0f, 0.0f, 0.0f);
+	if(placed_ && dt.count() > 0.0f)
+	{
+		velocity = (pos - position_) / dt.count();
+	}
+
+	// most sources don't move, skip the calls for them
+	if(pos != position_ || forward != forward_ || up != up_ || velocity != velocity_)
+	{
+		placement_changed_ = true;
+	}
+	position_ = pos;
+	forward_ = forward;
+	up_ = up;
+	velocity_ = velocity;
+	placed_ = true;
+	placed_frame_ = frame;
+}
+
+void audio_source_component::settle()
+{
+	const auto still = math::vec3(0.0f, 0.0f, 0.0f);
+	if(velocity_ != still)
+	{
+		velocity_ = still;
+		placement_changed_ = true;
+	}
+}
+
+void audio_source_component::apply_placement()
+{
+	if(!placement_changed_)
+	{
+		return;
+	}
+
+	placement_changed_ = false;
+	if(voice_)
+	{
+		voice_->set_position({{position_.x, position_.y, position_.z}});
+		voice_->set_velocity({{velocity_.x, velocity_.y, velocity_.z}});
+		voice_->set_orientation({{forward_.x, forward_.y, forward_.z}}, {{up_.x, up_.y, up_.z}});
+	}
 }
 
 void audio_source_component::set_loop(bool on)
 {
 	loop_ = on;
-	source_.set_loop(on);
+	if(voice_)
+	{
+		voice_->set_loop(on);
+	}
 }
 
 void audio_source_component::set_volume(float volume)
 {
 	math::clamp(volume, 0.0f, 1.0f);
 	volume_ = volume;
-	source_.set_volume(volume);
+	if(voice_)
+	{
+		voice_->set_volume(volume);
+	}
 }
 
 void audio_source_component::set_pitch(float pitch)
 {
 	math::clamp(pitch, 0.5f, 2.0f);
 	pitch_ = pitch;
-	source_.set_pitch(pitch);
+	if(voice_)
+	{
+		voice_->set_pitch(pitch);
+	}
 }
 
 void audio_source_component::set_volume_rolloff(float rolloff)
 {
 	math::clamp(rolloff, 0.0f, 10.0f);
 	volume_rolloff_ = rolloff;
-	source_.set_volume_rolloff(rolloff);
+	if(voice_)
+	{
+		voice_->set_volume_rolloff(rolloff);
+	}
 }
 
 void audio_source_component::set_range(const frange_t& range)
@@ -43,7 +108,10 @@ void audio_source_component::set_range(const frange_t& range)
 	math::clamp(range.max, range.min, std::numeric_limits<float>::max());
 
 	range_ = range;
-	source_.set_distance(range.min, range.max);
+	if(voice_)
+	{
+		voice_->set_distance(range.min, range.max);
+	}
 }
 
 void audio_source_component::set_autoplay(bool on)
@@ -84,46 +152,87 @@ const frange_t& audio_source_component::get_range() const
 
 void audio_source_component::set_playing_offset(audio::sound_info::duration_t offset)
 {
-	source_.set_playing_offset(offset);
+	offset_ = offset;
+	if(voice_)
+	{
+		voice_->set_playing_offset(offset);
+	}
 }
 
 audio::sound_info::duration_t audio_source_component::get_playing_offset() const
 {
-	return source_.get_playing_offset();
+	if(voice_)
+	{
+		return voice_->get_playing_offset();
+	}
+	return offset_;
 }
 
 audio::sound_info::duration_t audio_source_component::get_playing_duration() const
 {
-	return source_.get_playing_duration();
+	if(is_sound_valid())
+	{
+		return sound_->get_info().duration;
+	}
+	return audio::sound_info::duration_t(0);
 }
 
 void audio_source_component::play()
 {
 	if(sound_)
 	{
-		source_.bind(*sound_.get());
-		source_.play();
+		// playing again starts over, as a source does
+		if(state_ != playback::paused)
+		{
+			offset_ = audio::sound_info::duration_t(0);
+		}
+		state_ = playback::playing;
+
+		if(voice_)
+		{
+			// the sources of a clip share its buffers, they are queued once per bind
+			if(voice_->get_bound_sound_uid() != sound_->uid())
+			{
+				voice_->bind(*sound_.get());
+			}
+			voice_->play();
+		}
 	}
 }
 
 void audio_source_component::stop()
 {
-	source_.stop();
+	state_ = playback::stopped;
+	offset_ = audio::sound_info::duration_t(0);
+	if(voice_)
+	{
+		voice_->stop();
+	}
 }
 
 void audio_source_component::pause()
 {
-	source_.pause();
+	if(state_ != playback::playing)
+	{
+		return;
+	}
+
+	state_ = playback::paused;
+	if(voice_)
+	{
+		offset_ = voice_->get_playing_offset();
+		voice_->pause();
+	}
 }
 
 bool audio_source_component::is_playing() const
 {
-	return source_.is_playing();
+	return state_ == playback::playing;
 }
 
 bool audio_source_component::is_paused() const
 {
-	return source_.is_paused();
+	return state_ == playback::paused;
 }
 
 bool audio_source_component::is_looping() const
@@ -147,7 +256,123 @@ asset_handle<audio::sound> audio_source_component::get_sound() const
 
 bool audio_source_component::has_binded_sound() const
 {
-	return source_.has_binded_sound();
+	return is_sound_valid();
+}
+
+void audio_source_component::set_priority(int priority)
+{
+	priority_ = priority;
+}
+
+int audio_source_component::get_priority() const
+{
+	return priority_;
+}
+
+float audio_source_component::get_audibility(const math::vec3& listener) const
+{
+	if(state_ != playback::playing || !is_sound_valid())
+	{
+		return 0.0f;
+	}
+
+	// only mono sounds are attenuated
+	if(sound_->get_info().channels > 1)
+	{
+		return volume_;
+	}
+
+	// the linear distance model of the device
+	const auto span = range_.max - range_.min;
+	if(span <= 0.0f)
+	{
+		return volume_;
+	}
+	const auto distance = math::clamp(math::distance(position_, listener), range_.min, range_.max);
+	const auto gain = 1.0f - volume_rolloff_ * (distance - range_.min) / span;
+	return volume_ * math::clamp(gain, 0.0f, 1.0f);
+}
+
+void audio_source_component::advance(delta_t dt)
+{
+	if(state_ != playback::playing)
+	{
+		return;
+	}
+
+	if(voice_)
+	{
+		if(voice_->is_stopped())
+		{
+			state_ = playback::stopped;
+			offset_ = audio::sound_info::duration_t(0);
+		}
+		return;
+	}
+
+	const auto duration = get_playing_duration();
+	offset_ += audio::sound_info::duration_t(dt.count() * pitch_);
+	if(offset_ < duration)
+	{
+		return;
+	}
+
+	if(loop_ && duration.count() > 0.0)
+	{
+		offset_ = audio::sound_info::duration_t(std::fmod(offset_.count(), duration.count()));
+	}
+	else
+	{
+		stop();
+	}
+}
+
+void audio_source_component::set_voice(std::shared_ptr<audio::source> voice)
+{
+	if(voice_ == voice)
+	{
+		return;
+	}
+
+	if(voice_)
+	{
+		// keeps on virtually from where the voice was
+		if(state_ == playback::playing)
+		{
+			offset_ = voice_->get_playing_offset();
+		}
+		voice_->stop();
+	}
+
+	voice_ = std::move(voice);
+	if(!voice_ || !is_sound_valid())
+	{
+		return;
+	}
+
+	voice_->set_loop(loop_);
+	if(voice_->get_bound_sound_uid() != sound_->uid())
+	{
+		voice_->bind(*sound_.get());
+	}
+	voice_->set_volume(volume_);
+	voice_->set_pitch(pitch_);
+	voice_->set_volume_rolloff(volume_rolloff_);
+	voice_->set_distance(range_.min, range_.max);
+	voice_->set_position({{position_.x, position_.y, position_.z}});
+	voice_->set_velocity({{velocity_.x, velocity_.y, velocity_.z}});
+	voice_->set_orientation({{forward_.x, forward_.y, forward_.z}}, {{up_.x, up_.y, up_.z}});
+	voice_->set_playing_offset(offset_);
+
+	if(state_ == playback::playing)
+	{
+		voice_->play();
+	}
+}
+
+bool audio_source_component::is_virtual() const
+{
+	return !voice_;
 }
 
 void audio_source_component::apply_all()
@@ -164,3 +389,18 @@ bool audio_source_component::is_sound_valid() const
 {
 	return sound_ && sound_->is_valid();
 }
+
+std::shared_ptr<runtime::component> audio_source_component::clone(const runtime::clone_map& /*map*/) const
+{
+	auto copy = runtime::make_component<audio_source_component>();
+	copy->auto_play_ = auto_play_;
+	copy->loop_ = loop_;
+	copy->volume_ = volume_;
+	copy->pitch_ = pitch_;
+	copy->volume_rolloff_ = volume_rolloff_;
+	copy->range_ = range_;
+	copy->sound_ = sound_;
+	copy->priority_ = priority_;
+	copy->apply_all();
+	return copy;
+}
@@ -7,6 +7,8 @@
 #include <core/common/basetypes.hpp>
 #include <core/math/math_includes.h>
 
+#include <memory>
+
 //-----------------------------------------------------------------------------
 // Main Class Declarations
 //-----------------------------------------------------------------------------
@@ -23,6 +25,8 @@ class audio_source_component : public runtime::component_impl<audio_source_compo
 	REFLECTABLEV(audio_source_component, component)
 
 public:
+	~audio_source_component();
+
 	//-------------------------------------------------------------------------
 	// Public Virtual Methods (Override)
 
@@ -30,14 +34,43 @@ public:
 	// Public Methods
 	//-------------------------------------------------------------------------
 	//-----------------------------------------------------------------------------
-	//  Name : update ()
+	//  Name : place ()
 	/// <summary>
-	///
-	///
-	///
+	/// Takes where the source is from its world transform and how fast it
+	/// moved there over dt, for the next apply_placement. Makes no audio
+	/// calls, the sources can be placed concurrently.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	void update(const math::transform& t);
+	void place(const math::transform& t, delta_t dt, std::uint32_t frame);
+
+	//-----------------------------------------------------------------------------
+	//  Name : settle ()
+	/// <summary>
+	/// The source did not move in the frame, it has no velocity anymore.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void settle();
+
+	//-----------------------------------------------------------------------------
+	//  Name : apply_placement ()
+	/// <summary>
+	/// Gives the voice the placement taken since the last call, when it
+	/// changed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void apply_placement();
+
+	/// the frame the source was last placed in, a transform not touched since
+	/// does not need placing
+	std::uint32_t get_placed_frame() const
+	{
+		return placed_frame_;
+	}
+
+	bool is_placed() const
+	{
+		return placed_;
+	}
 
 	void set_loop(bool on);
 	void set_volume(float volume);
@@ -70,7 +103,62 @@ public:
 
 	bool has_binded_sound() const;
 
+	//-----------------------------------------------------------------------------
+	//  Name : set_priority ()
+	/// <summary>
+	/// Sets the priority of the source when the voices are given out, 0 is the
+	/// highest. Sources of the same priority are ranked by their audibility.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_priority(int priority);
+	int get_priority() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_audibility ()
+	/// <summary>
+	/// How loud the source is heard at the listener position, between 0 and
+	/// the volume, 0 when it doesn't play.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	float get_audibility(const math::vec3& listener) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : advance ()
+	/// <summary>
+	/// Moves the playing offset of a virtual source, and stops a source which
+	/// reached the end of its sound.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void advance(delta_t dt);
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_voice ()
+	/// <summary>
+	/// Gives the source the voice it is heard through, from where it is, or
+	/// takes it away, null, and keeps it playing virtually. Done by the audio
+	/// system.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_voice(std::shared_ptr<audio::source> voice);
+	bool is_virtual() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : clone ()
+	/// <summary>
+	/// A new source of the same sound with the same settings. It starts
+	/// stopped and gets a voice of its own.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<runtime::component> clone(const runtime::clone_map& map) const override;
+
 private:
+	enum class playback : std::uint8_t
+	{
+		stopped,
+		playing,
+		paused
+	};
+
 	void apply_all();
 	bool is_sound_valid() const;
 	//-------------------------------------------------------------------------
@@ -83,6 +171,20 @@ private:
 	float pitch_ = 1.0f;
 	float volume_rolloff_ = 1.0f;
 	frange_t range_ = {1.0f, 20.0f};
-	audio::source source_;
+	int priority_ = 128;
 	asset_handle<audio::sound> sound_;
+
+	playback state_ = playback::stopped;
+	/// where a virtual source is, the voice knows it otherwise
+	audio::sound_info::duration_t offset_ = audio::sound_info::duration_t(0);
+	math::vec3 position_ = {0.0f, 0.0f, 0.0f};
+	math::vec3 forward_ = {0.0f, 0.0f, 1.0f};
+	math::vec3 up_ = {0.0f, 1.0f, 0.0f};
+	math::vec3 velocity_ = {0.0f, 0.0f, 0.0f};
+	/// the voice has not been given the placement yet
+	bool placement_changed_ = false;
+	bool placed_ = false;
+	std::uint32_t placed_frame_ = 0;
+	/// null while virtual, shared with the pool of the audio system
+	std::shared_ptr<audio::source> voice_;
 };
@@ -2,6 +2,8 @@
 
 #include <core/graphics/graphics.h>
 
+#include <algorithm>
+
 camera_component::camera_component()
 {
 	camera_.set_viewport_size({640, 480});
@@ -13,12 +15,19 @@ camera_component::~camera_component()
 
 void camera_component::update(const math::transform& t)
 {
-	// Release the unused fbos and textures
-	render_view_.release_unused_resources();
 	// First update so the camera can cache the previous matrices
 	camera_.record_current_matrices();
+
+	const auto& m = t.get_matrix();
+	if(updated_version_ == camera_.get_version() && m == updated_transform_)
+	{
+		return;
+	}
+
 	// Set new transform
 	camera_.look_at(t.get_position(), t.get_position() + t.z_unit_axis(), t.y_unit_axis());
+	updated_transform_ = m;
+	updated_version_ = camera_.get_version();
 }
 
 bool camera_component::get_hdr() const
@@ -31,6 +40,49 @@ void camera_component::set_hdr(bool hdr)
 	hdr_ = hdr;
 }
 
+void camera_component::set_cull_mask(runtime::layer_mask mask)
+{
+	if(cull_mask_ == mask)
+	{
+		return;
+	}
+
+	touch();
+
+	cull_mask_ = mask;
+}
+
+void camera_component::present(float scale)
+{
+	const auto frame = ecs::get_frame();
+	if(presented_frame_ != frame)
+	{
+		presented_frame_ = frame;
+		present_scale_ = scale;
+		return;
+	}
+
+	present_scale_ = std::max(present_scale_, scale);
+}
+
+bool camera_component::is_presented(std::uint64_t frame) const
+{
+	return presented_frame_ != 0 && presented_frame_ + 1 >= frame;
+}
+
+void camera_component::set_render_interval(std::uint32_t interval)
+{
+	interval = std::max<std::uint32_t>(interval, 1);
+	if(render_interval_ == interval)
+	{
+		return;
+	}
+
+	touch();
+
+	render_interval_ = interval;
+}
+
 void camera_component::set_viewport_size(const usize32_t& size)
 {
 	camera_.set_viewport_size(size);
@@ -93,3 +145,13 @@ projection_mode camera_component::get_projection_mode() const
 {
 	return camera_.get_projection_mode();
 }
+
+std::shared_ptr<runtime::component> camera_component::clone(const runtime::clone_map& /*map*/) const
+{
+	auto copy = runtime::make_component<camera_component>();
+	copy->camera_ = camera_;
+	copy->hdr_ = hdr_;
+	copy->cull_mask_ = cull_mask_;
+	copy->render_interval_ = render_interval_;
+	return copy;
+}
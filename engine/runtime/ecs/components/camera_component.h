@@ -3,6 +3,7 @@
 // camera_component Header Includes
 //-----------------------------------------------------------------------------
 #include "../../rendering/camera.h"
+#include "../../rendering/layer_mask.h"
 #include "../ecs.h"
 
 #include <core/common/basetypes.hpp>
@@ -146,9 +147,9 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : update ()
 	/// <summary>
-	///
-	///
-	///
+	/// Moves the camera to the transform. Nothing is recomputed when neither
+	/// the transform nor the camera changed since the last update, so the
+	/// camera keeps its version.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void update(const math::transform& t);
@@ -223,6 +224,58 @@ public:
 	//-----------------------------------------------------------------------------
 	float get_ppu() const;
 
+	//-----------------------------------------------------------------------------
+	//  Name : set_cull_mask ()
+	/// <summary>
+	/// Sets the layers the camera draws, the models and the lights on none of
+	/// them are culled before their bounds are tested.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_cull_mask(runtime::layer_mask mask);
+
+	inline runtime::layer_mask get_cull_mask() const
+	{
+		return cull_mask_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : present ()
+	/// <summary>
+	/// Notes that the output of the camera is shown in this frame, drawn at
+	/// the scale of its viewport size. A camera shown more than once renders
+	/// at the largest of the scales.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void present(float scale = 1.0f);
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_presented ()
+	/// <summary>
+	/// Whether the output was shown in the frame or the one before it, a view
+	/// shows the output rendered before it in the frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool is_presented(std::uint64_t frame) const;
+
+	inline float get_present_scale() const
+	{
+		return present_scale_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_render_interval ()
+	/// <summary>
+	/// The frames between two renders of the camera, 1 renders it in every
+	/// frame. The output keeps the last render in the frames between.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_render_interval(std::uint32_t interval);
+
+	inline std::uint32_t get_render_interval() const
+	{
+		return render_interval_;
+	}
+
 	//-----------------------------------------------------------------------------
 	//  Name : get_render_view ()
 	/// <summary>
@@ -236,6 +289,15 @@ public:
 		return render_view_;
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : clone ()
+	/// <summary>
+	/// A new component with the camera and the settings of this one. The
+	/// render view is its own.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<runtime::component> clone(const runtime::clone_map& map) const override;
+
 private:
 	//-------------------------------------------------------------------------
 	// Private Member Variables.
@@ -246,4 +308,14 @@ private:
 	gfx::render_view render_view_;
 	/// Is the camera HDR?
 	bool hdr_ = true;
+	/// the layers the camera draws
+	runtime::layer_mask cull_mask_ = runtime::layers::all;
+	/// the frames between two renders
+	std::uint32_t render_interval_ = 1;
+	/// The last frame the output was shown in and the scale it was shown at.
+	std::uint64_t presented_frame_ = 0;
+	float present_scale_ = 1.0f;
+	/// The transform of the last update and the camera version it left.
+	math::mat4 updated_transform_ = math::mat4(0.0f);
+	std::uint64_t updated_version_ = 0;
 };
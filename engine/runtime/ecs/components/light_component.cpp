@@ -32,3 +32,23 @@ int light_component::compute_projected_sphere_rect(irect32_t& rect, const math::
 		return 1;
 	}
 }
+
+void light_component::set_layers(runtime::layer_mask layers)
+{
+	if(layers_ == layers)
+	{
+		return;
+	}
+
+	touch();
+
+	layers_ = layers;
+}
+
+std::shared_ptr<runtime::component> light_component::clone(const runtime::clone_map& /*map*/) const
+{
+	auto copy = runtime::make_component<light_component>();
+	copy->light_ = light_;
+	copy->layers_ = layers_;
+	return copy;
+}
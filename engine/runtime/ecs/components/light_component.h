@@ -2,7 +2,9 @@
 //-----------------------------------------------------------------------------
 // light_component Header Includes
 //-----------------------------------------------------------------------------
+#include "../../rendering/layer_mask.h"
 #include "../../rendering/light.h"
+#include "../../rendering/shadow_cascades.h"
 #include "../ecs.h"
 
 #include <core/common/basetypes.hpp>
@@ -52,6 +54,21 @@ public:
 	inline void set_light(const light& l)
 	{
 		light_ = l;
+		touch();
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_layers ()
+	/// <summary>
+	/// Sets the layers the light is on, it lights a view when the cull mask
+	/// of the view has one of them.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_layers(runtime::layer_mask layers);
+
+	inline runtime::layer_mask get_layers() const
+	{
+		return layers_;
 	}
 
 	//-----------------------------------------------------------------------------
@@ -66,10 +83,40 @@ public:
 									  const math::vec3& light_direction, const math::transform& view,
 									  const math::transform& proj);
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_cascades ()
+	/// <summary>
+	/// The shadow cascades of a directional light, fit to the view by the
+	/// shadow pass.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline shadow_cascades& get_cascades()
+	{
+		return cascades_;
+	}
+
+	inline const shadow_cascades& get_cascades() const
+	{
+		return cascades_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : clone ()
+	/// <summary>
+	/// A new component with the light of this one. The cascades are made
+	/// again.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<runtime::component> clone(const runtime::clone_map& map) const override;
+
 private:
 	//-------------------------------------------------------------------------
 	// Private Member Variables.
 	//-------------------------------------------------------------------------
 	/// The light object this component represents
 	light light_;
+	/// the layers the light is on
+	runtime::layer_mask layers_ = runtime::layers::default_layer;
+	/// Cascades of the light when it is directional, not serialized.
+	shadow_cascades cascades_;
 };
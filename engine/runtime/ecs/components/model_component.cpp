@@ -1,5 +1,10 @@
 #include "model_component.h"
 #include "transform_component.h"
+#include "../../rendering/mesh.h"
+
+#include <core/system/subsystem.h>
+
+#include <algorithm>
 
 void model_component::set_casts_shadow(bool cast_shadow)
 {
@@ -37,6 +42,23 @@ void model_component::set_casts_reflection(bool casts_reflection)
 	casts_reflection_ = casts_reflection;
 }
 
+void model_component::set_layers(runtime::layer_mask layers)
+{
+	if(layers_ == layers)
+	{
+		return;
+	}
+
+	touch();
+
+	layers_ = layers;
+}
+
+runtime::layer_mask model_component::get_layers() const
+{
+	return layers_;
+}
+
 bool model_component::casts_shadow() const
 {
 	return casts_shadow_;
@@ -59,31 +81,214 @@ void model_component::set_model(const model& model)
 	touch();
 }
 
-void model_component::set_bone_transforms(const std::vector<math::transform>& bone_transforms)
+bool model_component::bind_pose()
 {
-	bone_transforms_ = bone_transforms;
+	auto lod = model_.get_lod(0);
+	if(!lod || lod.get_asset()->get_skeleton().empty())
+	{
+		return false;
+	}
 
-	touch();
+	// bound until the mesh is reloaded
+	auto asset = lod.get_asset();
+	if(asset != pose_mesh_)
+	{
+		pose_mesh_ = std::move(asset);
+		local_pose_ = pose_mesh_->get_skeleton().rest_pose;
+		model_pose_.clear();
+		bone_transforms_.clear();
+		bone_entity_nodes_.clear();
+		lod_nodes_.clear();
+		pose_changed_ = true;
+		set_static(false);
+	}
+
+	bind_lod_nodes();
+	if(bone_entity_nodes_.size() == bone_entities_.size())
+	{
+		return true;
+	}
+
+	// entities of a scene saved before are looked up again by their names
+	bone_entity_nodes_.clear();
+	for(auto& e : bone_entities_)
+	{
+		bone_entity_nodes_.emplace_back(e.valid() ? pose_mesh_->get_skeleton().find_node(e.get_name())
+												  : runtime::skeleton::invalid_index);
+		auto transform = e.valid() ? e.get_component<transform_component>().lock() : nullptr;
+		if(transform && transform->get_parent() != get_entity())
+		{
+			transform->set_parent(get_entity());
+		}
+	}
+
+	return true;
 }
 
-const std::vector<math::transform>& model_component::get_bone_transforms() const
+const runtime::skeleton* model_component::get_skeleton() const
 {
-	return bone_transforms_;
+	return pose_mesh_ ? &pose_mesh_->get_skeleton() : nullptr;
+}
+
+void model_component::bind_lod_nodes()
+{
+	const auto& skeleton = pose_mesh_->get_skeleton();
+	const auto& lods = model_.get_lods();
+	lod_nodes_.resize(lods.size());
+	for(std::size_t i = 0; i < lods.size(); ++i)
+	{
+		auto& entry = lod_nodes_[i];
+		auto lod = lods[i] ? lods[i].get_asset() : nullptr;
+		if(lod == entry.lod)
+		{
+			continue;
+		}
+
+		entry.lod = std::move(lod);
+		entry.nodes.clear();
+		if(!entry.lod)
+		{
+			continue;
+		}
+
+		const auto& bones = entry.lod->get_skin_bind_data().get_bones();
+		if(bones.size() >= skeleton.bones.size())
+		{
+			continue;
+		}
+
+		entry.nodes.assign(skeleton.size(), 0);
+		for(const auto& bone : bones)
+		{
+			auto node = skeleton.find_node(bone.bone_id);
+			while(node != runtime::skeleton::invalid_index && !entry.nodes[node])
+			{
+				entry.nodes[node] = 1;
+				node = skeleton.parents[node];
+			}
+		}
+	}
+}
+
+const std::vector<std::uint8_t>& model_component::get_lod_nodes(std::uint32_t lod) const
+{
+	static const std::vector<std::uint8_t> all_nodes;
+	return lod < lod_nodes_.size() ? lod_nodes_[lod].nodes : all_nodes;
+}
+
+std::vector<math::transform>& model_component::get_local_pose()
+{
+	return local_pose_;
+}
+
+const std::vector<math::transform>& model_component::get_local_pose() const
+{
+	return local_pose_;
 }
 
-void model_component::set_bone_entities(const std::vector<runtime::entity>& bone_entities)
+void model_component::set_pose_changed()
 {
-	bone_entities_ = bone_entities;
+	pose_changed_ = true;
+}
+
+void model_component::update_pose(const math::transform& world)
+{
+	if(!pose_mesh_)
+	{
+		return;
+	}
+
+	// e.g. not animated or not seen
+	if(!pose_changed_ && world.get_matrix() == pose_world_.get_matrix())
+	{
+		return;
+	}
+	pose_changed_ = false;
+	pose_world_ = world;
+
+	const auto& skeleton = pose_mesh_->get_skeleton();
+	skeleton.to_model_space(local_pose_, model_pose_);
+
+	bone_transforms_.resize(skeleton.bones.size());
+	for(std::size_t i = 0; i < skeleton.bones.size(); ++i)
+	{
+		const auto node = skeleton.bones[i];
+		bone_transforms_[i] = node < model_pose_.size() ? world * model_pose_[node] : world;
+	}
+
+	// the node entities are children of the entity
+	const auto count = std::min(bone_entities_.size(), bone_entity_nodes_.size());
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		const auto node = bone_entity_nodes_[i];
+		auto transform = node < model_pose_.size() && bone_entities_[i].valid()
+							 ? bone_entities_[i].get_component<transform_component>().lock()
+							 : nullptr;
+		if(transform)
+		{
+			transform->set_local_transform(model_pose_[node]);
+		}
+	}
 
 	touch();
 }
 
+runtime::entity model_component::get_node_entity(const std::string& name)
+{
+	const auto* skeleton = bind_pose() ? get_skeleton() : nullptr;
+	const auto node = skeleton ? skeleton->find_node(name) : runtime::skeleton::invalid_index;
+	if(node == runtime::skeleton::invalid_index)
+	{
+		return {};
+	}
+
+	const auto count = std::min(bone_entities_.size(), bone_entity_nodes_.size());
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		if(bone_entity_nodes_[i] == node && bone_entities_[i].valid())
+		{
+			return bone_entities_[i];
+		}
+	}
+
+	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+	auto e = ecs.create();
+	e.set_name(name);
+	auto transform = e.assign<transform_component>().lock();
+	transform->set_parent(get_entity());
+	if(node < model_pose_.size())
+	{
+		transform->set_local_transform(model_pose_[node]);
+	}
+
+	bone_entities_.emplace_back(e);
+	bone_entity_nodes_.emplace_back(node);
+	return e;
+}
+
 const std::vector<runtime::entity>& model_component::get_bone_entities() const
 {
 	return bone_entities_;
 }
 
+const std::vector<math::transform>& model_component::get_bone_transforms() const
+{
+	return bone_transforms_;
+}
+
 bool model_component::casts_reflection() const
 {
 	return casts_reflection_;
 }
+
+std::shared_ptr<runtime::component> model_component::clone(const runtime::clone_map& map) const
+{
+	auto copy = runtime::make_component<model_component>();
+	copy->static_ = static_;
+	copy->casts_shadow_ = casts_shadow_;
+	copy->casts_reflection_ = casts_reflection_;
+	copy->layers_ = layers_;
+	copy->model_ = model_;
+	copy->bone_entities_ = map.get(bone_entities_);
+	return copy;
+}
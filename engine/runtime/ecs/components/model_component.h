@@ -1,9 +1,14 @@
 #pragma once
 
+#include "../../animation/skeleton.h"
+#include "../../rendering/layer_mask.h"
 #include "../../rendering/model.h"
 #include "../ecs.h"
 
+#include <memory>
+
 class material;
+class mesh;
 //-----------------------------------------------------------------------------
 // Main Class Declarations
 //-----------------------------------------------------------------------------
@@ -75,6 +80,17 @@ public:
 	//-----------------------------------------------------------------------------
 	bool casts_reflection() const;
 
+	//-----------------------------------------------------------------------------
+	//  Name : set_layers ()
+	/// <summary>
+	/// Sets the layers the model is on, a view draws it when its cull mask has
+	/// one of them.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_layers(runtime::layer_mask layers);
+
+	runtime::layer_mask get_layers() const;
+
 	//-----------------------------------------------------------------------------
 	//  Name : is_static ()
 	/// <summary>
@@ -105,12 +121,98 @@ public:
 	//-----------------------------------------------------------------------------
 	void set_model(const model& model);
 
-	void set_bone_entities(const std::vector<runtime::entity>& bone_entities);
+	//-----------------------------------------------------------------------------
+	//  Name : bind_pose ()
+	/// <summary>
+	/// Sets the pose to the rest pose of the skeleton when the skeleton of the
+	/// model changed, false when the model has none, e.g. while it loads.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool bind_pose();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_skeleton ()
+	/// <summary>
+	/// The skeleton of the bound pose, null before it is bound.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const runtime::skeleton* get_skeleton() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_lod_nodes ()
+	/// <summary>
+	/// Which nodes of the skeleton the skin of a lod moves, the bones and
+	/// their parents. Empty when it moves all of them or isn't loaded.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const std::vector<std::uint8_t>& get_lod_nodes(std::uint32_t lod) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_local_pose ()
+	/// <summary>
+	/// The local transform of every node of the skeleton, set by animations.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::vector<math::transform>& get_local_pose();
+	const std::vector<math::transform>& get_local_pose() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_pose_changed ()
+	/// <summary>
+	/// Marks the local pose written, the bones are only brought to the world
+	/// again when it or the world transform changed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_pose_changed();
+
+	//-----------------------------------------------------------------------------
+	//  Name : update_pose ()
+	/// <summary>
+	/// Brings the pose to the space of the model in one pass, then the bones
+	/// to the world for the skin, and moves the node entities.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void update_pose(const math::transform& world);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_node_entity ()
+	/// <summary>
+	/// The entity following a node of the skeleton, created under the entity
+	/// the first time, e.g. to attach something to a bone. Invalid when the
+	/// skeleton has no node of the name or isn't bound yet.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	runtime::entity get_node_entity(const std::string& name);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_bone_entities ()
+	/// <summary>
+	/// The entities following nodes of the skeleton.
+	/// </summary>
+	//-----------------------------------------------------------------------------
 	const std::vector<runtime::entity>& get_bone_entities() const;
-	void set_bone_transforms(const std::vector<math::transform>& bone_transforms);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_bone_transforms ()
+	/// <summary>
+	/// The world transform of every bone of the skin, in the order of the skin
+	/// data.
+	/// </summary>
+	//-----------------------------------------------------------------------------
 	const std::vector<math::transform>& get_bone_transforms() const;
 
+	//-----------------------------------------------------------------------------
+	//  Name : clone ()
+	/// <summary>
+	/// A new component with the model and the flags. The bone entities copied
+	/// along with it are the copies.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<runtime::component> clone(const runtime::clone_map& map) const override;
+
 private:
+	void bind_lod_nodes();
+
 	//-------------------------------------------------------------------------
 	// Private Member Variables.
 	//-------------------------------------------------------------------------
@@ -120,9 +222,29 @@ private:
 	bool casts_shadow_ = true;
 	///
 	bool casts_reflection_ = true;
+	/// the layers the model is on
+	runtime::layer_mask layers_ = runtime::layers::default_layer;
 	///
 	model model_;
-	///
+	/// the entities following nodes, only made when asked for
 	std::vector<runtime::entity> bone_entities_;
+	/// the node of every bone entity, looked up by name when bound
+	std::vector<std::uint32_t> bone_entity_nodes_;
+	///
 	std::vector<math::transform> bone_transforms_;
+	/// the mesh of the skeleton, kept while its pose is
+	std::shared_ptr<mesh> pose_mesh_;
+	/// the nodes moved by the skin of a lod, made when the lod is loaded
+	struct lod_nodes
+	{
+		std::shared_ptr<mesh> lod;
+		std::vector<std::uint8_t> nodes;
+	};
+	std::vector<lod_nodes> lod_nodes_;
+	/// the pose of the nodes, local and in the space of the model
+	std::vector<math::transform> local_pose_;
+	std::vector<math::transform> model_pose_;
+	/// the world transform the bones were brought to last
+	math::transform pose_world_;
+	bool pose_changed_ = true;
 };
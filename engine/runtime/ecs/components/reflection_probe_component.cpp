@@ -1,5 +1,13 @@
 #include "reflection_probe_component.h"
 
+reflection_probe_component::reflection_probe_component()
+{
+	for(auto& view : render_view_)
+	{
+		view.set_memory_category(gfx::memory_category::probes);
+	}
+}
+
 int reflection_probe_component::compute_projected_sphere_rect(irect32_t& rect, const math::vec3& position,
 															  const math::transform& view,
 															  const math::transform& proj)
@@ -44,6 +52,35 @@ std::shared_ptr<gfx::frame_buffer> reflection_probe_component::get_cubemap_fbo()
 	return render_view_[0].get_fbo("CUBEMAP", {get_cubemap()});
 }
 
+std::shared_ptr<gfx::texture> reflection_probe_component::get_prefiltered_cubemap()
+{
+	// the format the prefilter shader writes
+	static const bool supported =
+		gfx::is_format_supported(BGFX_CAPS_FORMAT_TEXTURE_CUBE | BGFX_CAPS_FORMAT_TEXTURE_IMAGE_WRITE,
+								 gfx::texture_format::RGBA16F);
+	if(!prefiltered_cubemap_ && supported)
+	{
+		const auto flags = gfx::get_default_rt_sampler_flags() | BGFX_TEXTURE_COMPUTE_WRITE;
+		const auto size = std::uint16_t(get_cubemap()->info.width);
+		prefiltered_cubemap_ = render_view_[0].get_texture("PREFILTERED", size, true, 1,
+															gfx::texture_format::RGBA16F, flags);
+	}
+	return prefiltered_cubemap_;
+}
+
+std::shared_ptr<gfx::texture> reflection_probe_component::get_irradiance()
+{
+	static const bool supported = gfx::is_format_supported(BGFX_CAPS_FORMAT_TEXTURE_IMAGE_WRITE,
+														   gfx::texture_format::RGBA32F);
+	if(!irradiance_ && supported)
+	{
+		const auto flags = BGFX_TEXTURE_COMPUTE_WRITE | BGFX_SAMPLER_POINT | BGFX_SAMPLER_UVW_CLAMP;
+		irradiance_ =
+			render_view_[0].get_texture("IRRADIANCE", 9, 1, false, 1, gfx::texture_format::RGBA32F, flags);
+	}
+	return irradiance_;
+}
+
 void reflection_probe_component::update()
 {
 	for(auto& view : render_view_)
@@ -61,3 +98,21 @@ void reflection_probe_component::set_probe(const reflection_probe& probe)
 
 	probe_ = probe;
 }
+
+void reflection_probe_component::set_cull_mask(runtime::layer_mask mask)
+{
+	if(cull_mask_ == mask)
+		return;
+
+	touch();
+
+	cull_mask_ = mask;
+}
+
+std::shared_ptr<runtime::component> reflection_probe_component::clone(const runtime::clone_map& /*map*/) const
+{
+	auto copy = runtime::make_component<reflection_probe_component>();
+	copy->probe_ = probe_;
+	copy->cull_mask_ = cull_mask_;
+	return copy;
+}
@@ -2,6 +2,7 @@
 //-----------------------------------------------------------------------------
 // reflection_probe_component Header Includes
 //-----------------------------------------------------------------------------
+#include "../../rendering/layer_mask.h"
 #include "../../rendering/reflection_probe.h"
 #include "../ecs.h"
 
@@ -28,6 +29,17 @@ class reflection_probe_component : public runtime::component_impl<reflection_pro
 	SERIALIZABLE(reflection_probe_component)
 	REFLECTABLEV(reflection_probe_component, runtime::component)
 public:
+	//-------------------------------------------------------------------------
+	// Constructors & Destructors
+	//-------------------------------------------------------------------------
+	//-----------------------------------------------------------------------------
+	//  Name : reflection_probe_component ()
+	/// <summary>
+	/// The targets of the faces are counted as probe memory.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	reflection_probe_component();
+
 	//-------------------------------------------------------------------------
 	// Public Methods
 	//-------------------------------------------------------------------------
@@ -54,6 +66,19 @@ public:
 	//-----------------------------------------------------------------------------
 	void set_probe(const reflection_probe& probe);
 
+	//-----------------------------------------------------------------------------
+	//  Name : set_cull_mask ()
+	/// <summary>
+	/// Sets the layers the probe captures, which has it captured again.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_cull_mask(runtime::layer_mask mask);
+
+	inline runtime::layer_mask get_cull_mask() const
+	{
+		return cull_mask_;
+	}
+
 	//-----------------------------------------------------------------------------
 	//  Name : compute_projected_sphere_rect ()
 	/// <summary>
@@ -98,14 +123,61 @@ public:
 	//-----------------------------------------------------------------------------
 	std::shared_ptr<gfx::frame_buffer> get_cubemap_fbo();
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_prefiltered_cubemap ()
+	/// <summary>
+	/// The cubemap the probe is lit with, its mips filtered from the capture
+	/// for the roughness they are picked by. Null where compute shaders
+	/// cannot write it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<gfx::texture> get_prefiltered_cubemap();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_irradiance ()
+	/// <summary>
+	/// The irradiance of the capture over pi as the 9 spherical harmonics of
+	/// its first three bands, a texel each in a row. Null where compute
+	/// shaders cannot write it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<gfx::texture> get_irradiance();
+
+	/// whether the prefiltered cubemap and the irradiance hold a capture
+	inline bool is_prefiltered() const
+	{
+		return prefiltered_;
+	}
+
+	inline void set_prefiltered(bool prefiltered)
+	{
+		prefiltered_ = prefiltered;
+	}
+
 	void update();
 
+	//-----------------------------------------------------------------------------
+	//  Name : clone ()
+	/// <summary>
+	/// A new component with the probe of this one. The render views are its
+	/// own.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<runtime::component> clone(const runtime::clone_map& map) const override;
+
 private:
 	//-------------------------------------------------------------------------
 	// Private Member Variables.
 	//-------------------------------------------------------------------------
 	/// The probe object this component represents
 	reflection_probe probe_;
+	/// the layers the probe captures
+	runtime::layer_mask cull_mask_ = runtime::layers::all;
 	/// The render view for this component
 	std::array<gfx::render_view, 6> render_view_;
+	/// kept apart from the use of the views, they outlive the frames
+	/// they go unsampled in
+	std::shared_ptr<gfx::texture> prefiltered_cubemap_;
+	std::shared_ptr<gfx::texture> irradiance_;
+	bool prefiltered_ = false;
 };
@@ -4,6 +4,12 @@
 
 #include <algorithm>
 
+namespace runtime
+{
+event<void(entity)> on_parent_changed;
+event<void(entity)> on_transform_dirty;
+}
+
 void transform_component::on_entity_set()
 {
 	for(auto& child : children_)
@@ -13,7 +19,7 @@ void transform_component::on_entity_set()
 			auto child_transform = child.get_component<transform_component>().lock();
 			if(child_transform)
 			{
-				child_transform->parent_ = get_entity();
+				child_transform->assign_parent(get_entity());
 			}
 		}
 	}
@@ -345,7 +351,7 @@ void transform_component::set_parent(runtime::entity parent, bool world_position
 		}
 	}
 
-	parent_ = parent;
+	assign_parent(parent);
 
 	if(parent_.valid())
 	{
@@ -370,6 +376,21 @@ void transform_component::set_parent(runtime::entity parent, bool world_position
 	set_dirty(is_dirty());
 }
 
+void transform_component::assign_parent(const runtime::entity& parent)
+{
+	if(parent_ == parent)
+	{
+		return;
+	}
+
+	parent_ = parent;
+	auto e = get_entity();
+	if(e.valid())
+	{
+		runtime::on_parent_changed(e);
+	}
+}
+
 const runtime::entity& transform_component::get_parent() const
 {
 	return parent_;
@@ -438,6 +459,58 @@ void transform_component::apply_local_transform(const math::transform& trans)
 	local_transform_ = trans;
 }
 
+void transform_component::batch_update(const transform_edit& edit)
+{
+	if(!edit.has_position && !edit.has_rotation && !edit.has_scale)
+	{
+		return;
+	}
+
+	auto m = edit.is_local ? local_transform_ : get_transform();
+	if(edit.has_scale)
+	{
+		m.set_scale(edit.scale);
+	}
+	if(edit.has_rotation)
+	{
+		m.set_rotation(edit.rotation);
+	}
+	if(edit.has_position)
+	{
+		m.set_position(edit.position);
+	}
+
+	if(edit.is_local)
+	{
+		set_local_transform(m);
+	}
+	else
+	{
+		apply_transform(m);
+	}
+}
+
+void transform_component::batch_update(const std::vector<runtime::entity>& entities,
+									   const std::vector<transform_edit>& edits)
+{
+	expects(entities.size() == edits.size());
+
+	for(std::size_t i = 0; i < entities.size(); ++i)
+	{
+		const auto& e = entities[i];
+		if(!e.valid())
+		{
+			continue;
+		}
+
+		auto transform_comp = e.get_component<transform_component>().lock();
+		if(transform_comp)
+		{
+			transform_comp->batch_update(edits[i]);
+		}
+	}
+}
+
 void transform_component::set_local_transform(const math::transform& trans)
 {
     const auto& this_matrix = local_transform_.get_matrix();
@@ -482,12 +555,22 @@ bool transform_component::is_dirty() const
 
 void transform_component::set_dirty(bool dirty)
 {
+	const bool was_dirty = dirty_;
 	dirty_ = dirty;
 
 	if(dirty_ == true)
 	{
 		touch();
 
+		if(!was_dirty)
+		{
+			auto e = get_entity();
+			if(e.valid())
+			{
+				runtime::on_transform_dirty(e);
+			}
+		}
+
 		for(const auto& child : children_)
 		{
 			if(child.valid())
@@ -506,3 +589,13 @@ const std::vector<runtime::entity>& transform_component::get_children() const
 {
 	return children_;
 }
+
+std::shared_ptr<runtime::component> transform_component::clone(const runtime::clone_map& map) const
+{
+	auto copy = runtime::make_component<transform_component>();
+	copy->local_transform_ = local_transform_;
+	// on_entity_set makes it the parent of the copies of the children, they
+	// are assigned first
+	copy->children_ = map.get(children_);
+	return copy;
+}
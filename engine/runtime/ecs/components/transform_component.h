@@ -4,6 +4,59 @@
 
 #include <core/math/math_includes.h>
 
+namespace runtime
+{
+class transform_system;
+
+/// <child> emitted after the parent of a transform changed
+extern event<void(entity)> on_parent_changed;
+/// <entity> emitted when a resolved transform becomes dirty
+extern event<void(entity)> on_transform_dirty;
+}
+
+/*
+ * transform_edit; the parts of a transform that batch_update applies
+ * together. The parts that are not set are kept.
+ */
+struct transform_edit
+{
+	transform_edit& set_position(const math::vec3& value)
+	{
+		position = value;
+		has_position = true;
+		return *this;
+	}
+
+	transform_edit& set_rotation(const math::quat& value)
+	{
+		rotation = value;
+		has_rotation = true;
+		return *this;
+	}
+
+	transform_edit& set_scale(const math::vec3& value)
+	{
+		scale = value;
+		has_scale = true;
+		return *this;
+	}
+
+	/// the parts are relative to the parent instead of the world
+	transform_edit& in_local_space()
+	{
+		is_local = true;
+		return *this;
+	}
+
+	math::vec3 position;
+	math::quat rotation;
+	math::vec3 scale{1.0f, 1.0f, 1.0f};
+	bool has_position = false;
+	bool has_rotation = false;
+	bool has_scale = false;
+	bool is_local = false;
+};
+
 //-----------------------------------------------------------------------------
 // Main Class Declarations
 //-----------------------------------------------------------------------------
@@ -19,6 +72,7 @@ class transform_component : public runtime::component_impl<transform_component>
 {
 	SERIALIZABLE(transform_component)
 	REFLECTABLEV(transform_component, runtime::component)
+	friend class runtime::transform_system;
 
 public:
 	//-------------------------------------------------------------------------
@@ -392,6 +446,25 @@ public:
 	//-----------------------------------------------------------------------------
 	void reset_pivot();
 
+	//-----------------------------------------------------------------------------
+	//  Name : batch_update ( )
+	/// <summary>
+	/// Applies the position, rotation and scale of the edit at once, so the
+	/// local transform is rebuilt and the subtree invalidated a single time.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void batch_update(const transform_edit& edit);
+
+	//-----------------------------------------------------------------------------
+	//  Name : batch_update ( )
+	/// <summary>
+	/// Applies edits[i] to the transform of entities[i]. Entities that are
+	/// invalid or have no transform are skipped.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void batch_update(const std::vector<runtime::entity>& entities,
+							 const std::vector<transform_edit>& edits);
+
 	//-----------------------------------------------------------------------------
 	//  Name : set_local_transform ( )
 	/// <summary>
@@ -532,7 +605,24 @@ public:
 	//-----------------------------------------------------------------------------
 	void cleanup_dead_children();
 
+	//-----------------------------------------------------------------------------
+	//  Name : clone ()
+	/// <summary>
+	/// A new component with the local transform. The children copied with it
+	/// become its children once it is assigned.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<runtime::component> clone(const runtime::clone_map& map) const override;
+
 protected:
+	//-----------------------------------------------------------------------------
+	//  Name : assign_parent ()
+	/// <summary>
+	/// Stores the parent handle and emits on_parent_changed if it differs.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void assign_parent(const runtime::entity& parent);
+
     void apply_transform(math::transform& trans);
     void apply_local_transform(const math::transform& trans);
 
@@ -4,11 +4,26 @@
 runtime::entity prefab::instantiate()
 {
 	std::vector<runtime::entity> out_data;
-	if(!data)
-		return {};
+	if(!instance_data.empty())
+	{
+		if(!ecs::utils::deserialize_binary(instance_data, out_data))
+			return {};
+	}
+	else
+	{
+		if(!data)
+			return {};
 
-	if(!ecs::utils::deserialize_data(*data, out_data))
-		return {};
+		if(!ecs::utils::deserialize_data(*data, out_data))
+			return {};
+
+		// nothing is parsed for the next ones
+		ecs::utils::serialize_binary(out_data, instance_data);
+		data.reset();
+
+		// the entities hold the ones they need now
+		dependencies.clear();
+	}
 
 	if(out_data.empty())
 		return {};
@@ -1,11 +1,27 @@
 #pragma once
 
 #include "../ecs.h"
+#include <cstdint>
 #include <fstream>
 #include <memory>
+#include <vector>
 
 struct prefab
 {
+	//-----------------------------------------------------------------------------
+	//  Name : instantiate ()
+	/// <summary>
+	/// Creates the entities of the prefab. The first instance is loaded from
+	/// the data, which is parsed once; the others are copied from it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
 	runtime::entity instantiate();
+
 	std::shared_ptr<std::istream> data;
+	/// the first instance as the binary archive writes it, right after it was
+	/// loaded, what the others are created from
+	std::vector<std::uint8_t> instance_data;
+	/// links of the assets of the manifest, loaded with the prefab and held
+	/// until it is first instantiated
+	std::vector<std::shared_ptr<void>> dependencies;
 };
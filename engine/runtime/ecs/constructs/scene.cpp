@@ -1,5 +1,6 @@
 #include "scene.h"
 #include "utils.h"
+#include "../../assets/asset_manager.h"
 
 #include <core/system/subsystem.h>
 
@@ -17,5 +18,13 @@ std::vector<runtime::entity> scene::instantiate(mode mod)
 
 	ecs::utils::deserialize_data(*data, out_vec);
 
+	// the entities hold the ones they need now
+	dependencies.clear();
+	if(mod == mode::standard)
+	{
+		// what only the last scene used is let go
+		core::get_subsystem<runtime::asset_manager>().request_sweep();
+	}
+
 	return out_vec;
 }
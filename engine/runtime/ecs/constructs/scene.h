@@ -3,6 +3,7 @@
 #include "../ecs.h"
 #include <fstream>
 #include <memory>
+#include <vector>
 
 struct scene
 {
@@ -13,4 +14,7 @@ struct scene
 	};
 	std::vector<runtime::entity> instantiate(mode mod);
 	std::shared_ptr<std::istream> data;
+	/// links of the assets of the manifest, loaded with the scene and held
+	/// until it is first instantiated
+	std::vector<std::shared_ptr<void>> dependencies;
 };
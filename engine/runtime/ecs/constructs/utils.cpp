@@ -1,9 +1,23 @@
 #include "utils.h"
 #include "../../meta/ecs/entity.hpp"
+#include "../components/transform_component.h"
 
 #include <core/serialization/associative_archive.h>
 #include <core/serialization/binary_archive.h>
+#include <core/serialization/compact_archive.h>
 #include <core/serialization/serialization.h>
+#include <core/filesystem/mapped_file.h>
+#include <core/system/subsystem.h>
+#include <core/tasks/task_group.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <tuple>
 
 namespace ecs
 {
@@ -20,26 +34,202 @@ static void serialize_t(std::ostream& stream, const std::vector<runtime::entity>
 	runtime::get_serialization_map().clear();
 }
 
+/// the roots serialized as one archive, with all their children
+static const std::size_t roots_per_chunk = 64;
+/// what a file of more than one chunk starts with, an archive starts with '{'
+static const char chunks_tag[] = "#entity_chunks";
+
+template <typename F>
+static void for_each_chunk(std::size_t count, F&& fn)
+{
+	if(core::has_subsystems<core::task_system>())
+	{
+		auto& ts = core::get_subsystem<core::task_system>();
+		core::parallel_for(ts, std::size_t(0), count, std::size_t(1), fn);
+	}
+	else
+	{
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			fn(i);
+		}
+	}
+}
+
+// the roots by chunks of roots_per_chunk, each one an archive of its own
+// serialized in parallel. The tag, the number of chunks and their sizes come
+// first, on one line, then the archives one after the other. Entities only
+// refer to their children, so a chunk does not need any other.
+static void serialize_chunks(std::ostream& stream, const std::vector<runtime::entity>& data)
+{
+	const auto count = (data.size() + roots_per_chunk - 1) / roots_per_chunk;
+	if(count <= 1)
+	{
+		serialize_t<cereal::oarchive_associative_t>(stream, data);
+		return;
+	}
+
+	std::vector<std::string> chunks(count);
+	for_each_chunk(count, [&](std::size_t i) {
+		const auto begin = std::begin(data) + std::ptrdiff_t(i * roots_per_chunk);
+		const auto end = std::begin(data) + std::ptrdiff_t(std::min(data.size(), (i + 1) * roots_per_chunk));
+
+		std::ostringstream chunk;
+		serialize_t<cereal::oarchive_associative_t>(chunk, std::vector<runtime::entity>(begin, end));
+		chunks[i] = chunk.str();
+	});
+
+	stream << chunks_tag << ' ' << count;
+	for(const auto& chunk : chunks)
+	{
+		stream << ' ' << chunk.size();
+	}
+	stream << '\n';
+	for(const auto& chunk : chunks)
+	{
+		stream.write(chunk.data(), std::streamsize(chunk.size()));
+	}
+}
+
+// the text of every chunk after the line in front of them
+static bool read_chunks(std::istream& stream, std::string& data, std::vector<std::size_t>& offsets,
+						std::vector<std::size_t>& sizes)
+{
+	std::string tag;
+	std::size_t count = 0;
+	stream >> tag >> count;
+
+	sizes.resize(count);
+	for(auto& size : sizes)
+	{
+		stream >> size;
+	}
+	stream.ignore(1);
+
+	data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+	stream.clear();
+	stream.seekg(0);
+
+	offsets.resize(count);
+	std::size_t offset = 0;
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		offsets[i] = offset;
+		offset += sizes[i];
+	}
+	return tag == chunks_tag && offset <= data.size();
+}
+
+// a part of the data, the entities in it are created from it on the calling
+// thread
 template <typename IArchive>
-static bool deserialize_t(std::istream& stream, std::vector<runtime::entity>& out_data)
+static void load_part(IArchive& ar, std::vector<runtime::entity>& out_data)
 {
-	// get length of file:
+	std::vector<runtime::entity> part_data;
 	runtime::get_serialization_map().clear();
-	stream.seekg(0, stream.end);
-	std::streampos length = stream.tellg();
-	stream.seekg(0, stream.beg);
-	if(length > 0)
+	try_load(ar, cereal::make_nvp("data", part_data));
+	runtime::get_serialization_map().clear();
+	out_data.insert(std::end(out_data), std::begin(part_data), std::end(part_data));
+}
+
+/// what data split into cells starts with, the compact form follows the table
+static const char cells_tag[] = "#entity_cells";
+
+static std::uint32_t find_member(const cereal::compact_tree& tree, std::uint32_t index, const char* name)
+{
+	const auto& n = tree.get_node(index);
+	for(auto i = n.first; i < n.first + n.count; ++i)
 	{
-		IArchive ar(stream);
+		const auto member = tree.get_node(i).name;
+		if(member != cereal::compact_tree::invalid_index && std::strcmp(tree.get_string(member), name) == 0)
+		{
+			return i;
+		}
+	}
+	return cereal::compact_tree::invalid_index;
+}
 
-		try_load(ar, cereal::make_nvp("data", out_data));
+// the local transform met first in the components of an entity, not going
+// into the children which have their own
+static std::uint32_t find_local_transform(const cereal::compact_tree& tree, std::uint32_t index)
+{
+	using node_type = cereal::compact_tree::node_type;
+	const auto& n = tree.get_node(index);
+	if(n.type != node_type::array && n.type != node_type::object)
+	{
+		return cereal::compact_tree::invalid_index;
+	}
+	for(auto i = n.first; i < n.first + n.count; ++i)
+	{
+		const auto member = tree.get_node(i).name;
+		const auto name = member != cereal::compact_tree::invalid_index ? tree.get_string(member) : "";
+		if(std::strcmp(name, "local_transform") == 0)
+		{
+			return i;
+		}
+		if(std::strcmp(name, "children") == 0)
+		{
+			continue;
+		}
+		const auto found = find_local_transform(tree, i);
+		if(found != cereal::compact_tree::invalid_index)
+		{
+			return found;
+		}
+	}
+	return cereal::compact_tree::invalid_index;
+}
 
-		stream.clear();
-		stream.seekg(0);
-		runtime::get_serialization_map().clear();
-		return true;
+static double get_number(const cereal::compact_tree& tree, std::uint32_t index)
+{
+	using node_type = cereal::compact_tree::node_type;
+	if(index == cereal::compact_tree::invalid_index)
+	{
+		return 0.0;
+	}
+	const auto& n = tree.get_node(index);
+	switch(n.type)
+	{
+		case node_type::int64:
+			return double(std::int64_t(n.bits));
+		case node_type::uint64:
+			return double(n.bits);
+		case node_type::real:
+		{
+			double real = 0.0;
+			std::memcpy(&real, &n.bits, sizeof(real));
+			return real;
+		}
+		default:
+			return 0.0;
+	}
+}
+
+static std::size_t count_nodes(const cereal::compact_tree& tree, std::uint32_t index)
+{
+	using node_type = cereal::compact_tree::node_type;
+	const auto& n = tree.get_node(index);
+	std::size_t count = 1;
+	if(n.type == node_type::array || n.type == node_type::object)
+	{
+		for(auto i = n.first; i < n.first + n.count; ++i)
+		{
+			count += count_nodes(tree, i);
+		}
+	}
+	return count;
+}
+
+// the array of the roots of a document, or invalid_index
+static std::uint32_t find_roots(const cereal::compact_tree& tree, std::size_t document)
+{
+	const auto data = find_member(tree, tree.get_document(document), "data");
+	if(data == cereal::compact_tree::invalid_index ||
+	   tree.get_node(data).type != cereal::compact_tree::node_type::array)
+	{
+		return cereal::compact_tree::invalid_index;
 	}
-	return false;
+	return data;
 }
 
 void save_entity_to_file(const fs::path& full_path, const runtime::entity& data)
@@ -62,33 +252,547 @@ bool try_load_entity_from_file(const fs::path& full_path, runtime::entity& out_d
 void save_entities_to_file(const fs::path& full_path, const std::vector<runtime::entity>& data)
 {
 	std::ofstream os(full_path.string(), std::fstream::binary | std::fstream::trunc);
-	serialize_t<cereal::oarchive_associative_t>(os, data);
+	serialize_chunks(os, data);
 }
 
 bool load_entities_from_file(const fs::path& full_path, std::vector<runtime::entity>& out_data)
 {
 	std::ifstream is(full_path.string(), std::fstream::binary);
-	return deserialize_t<cereal::iarchive_associative_t>(is, out_data);
+	return deserialize_data(is, out_data);
 }
 
-runtime::entity clone_entity(const runtime::entity& data)
+// the entity and every one under it, a parent before its children
+static std::vector<runtime::entity> gather_hierarchy(const runtime::entity& root)
+{
+	std::vector<runtime::entity> hierarchy{root};
+	for(std::size_t i = 0; i < hierarchy.size(); ++i)
+	{
+		const auto e = hierarchy[i];
+		auto transform = e.get_component<transform_component>().lock();
+		if(!transform)
+		{
+			continue;
+		}
+		for(const auto& child : transform->get_children())
+		{
+			if(child.valid())
+			{
+				hierarchy.emplace_back(child);
+			}
+		}
+	}
+	return hierarchy;
+}
+
+// a copy of the hierarchy through the clone of the components, false and
+// nothing made if one of them can't
+static bool clone_hierarchy(const std::vector<runtime::entity>& hierarchy, runtime::entity& out_data)
+{
+	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+	auto copies = ecs.create_many(hierarchy.size());
+	runtime::clone_map map;
+	for(std::size_t i = 0; i < hierarchy.size(); ++i)
+	{
+		copies[i].set_name(hierarchy[i].get_interned_name());
+		map.add(hierarchy[i], copies[i]);
+	}
+
+	// the children first, a transform takes the copies of its children as
+	// they are assigned
+	for(std::size_t i = hierarchy.size(); i-- > 0;)
+	{
+		for(const auto& component_ptr : hierarchy[i].all_components())
+		{
+			auto copy = component_ptr.lock()->clone(map);
+			if(!copy)
+			{
+				ecs.destroy_many(copies);
+				return false;
+			}
+			copies[i].assign(copy);
+			copy->touch();
+		}
+	}
+	out_data = copies.front();
+	return true;
+}
+
+// what the components of a snapshot refer to instead of its i-th entity. It
+// is never valid, a transform let go with the snapshot leaves the entities
+// it was copied from alone.
+static runtime::entity get_placeholder(std::size_t i)
+{
+	return runtime::entity(nullptr, runtime::entity::id_t(std::uint32_t(i), ~std::uint32_t(0)));
+}
+
+bool snapshot::take(const std::vector<runtime::entity>& roots)
+{
+	clear();
+
+	std::vector<runtime::entity> sources;
+	for(const auto& root : roots)
+	{
+		if(!root.valid())
+		{
+			continue;
+		}
+		roots_.emplace_back(sources.size());
+		const auto hierarchy = gather_hierarchy(root);
+		sources.insert(std::end(sources), std::begin(hierarchy), std::end(hierarchy));
+	}
+
+	runtime::clone_map placeholders;
+	for(std::size_t i = 0; i < sources.size(); ++i)
+	{
+		placeholders.add(sources[i], get_placeholder(i));
+	}
+
+	entities_.resize(sources.size());
+	for(std::size_t i = 0; i < sources.size(); ++i)
+	{
+		auto& en = entities_[i];
+		en.name = sources[i].get_interned_name();
+		for(const auto& component_ptr : sources[i].all_components())
+		{
+			auto copy = component_ptr.lock()->clone(placeholders);
+			if(!copy)
+			{
+				clear();
+				return false;
+			}
+			en.components.emplace_back(std::move(copy));
+		}
+	}
+	return true;
+}
+
+std::vector<runtime::entity> snapshot::restore() const
 {
-	std::stringstream stream;
-	serialize_t<cereal::oarchive_binary_t>(stream, {data});
+	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
+	auto copies = ecs.create_many(entities_.size());
+	runtime::clone_map map;
+	for(std::size_t i = 0; i < entities_.size(); ++i)
+	{
+		copies[i].set_name(entities_[i].name);
+		map.add(get_placeholder(i), copies[i]);
+	}
 
-	std::vector<runtime::entity> vec_data;
-	deserialize_t<cereal::iarchive_binary_t>(stream, vec_data);
+	// the children first, as for a clone
+	for(std::size_t i = entities_.size(); i-- > 0;)
+	{
+		for(const auto& component : entities_[i].components)
+		{
+			auto copy = component->clone(map);
+			copies[i].assign(copy);
+			copy->touch();
+		}
+	}
 
-	if(!vec_data.empty())
+	std::vector<runtime::entity> restored;
+	restored.reserve(roots_.size());
+	for(const auto root : roots_)
 	{
-		return vec_data.front();
+		restored.emplace_back(copies[root]);
+	}
+	return restored;
+}
+
+void snapshot::clear()
+{
+	entities_.clear();
+	roots_.clear();
+}
+
+runtime::entity clone_entity(const runtime::entity& data)
+{
+	const auto copies = clone_entities(data, 1);
+	if(!copies.empty())
+	{
+		return copies.front();
 	}
 	return {};
 }
 
+std::vector<runtime::entity> clone_entities(const runtime::entity& data, std::size_t count)
+{
+	std::vector<runtime::entity> out_data;
+	if(!data.valid() || count == 0)
+	{
+		return out_data;
+	}
+	out_data.reserve(count);
+
+	const auto hierarchy = gather_hierarchy(data);
+	runtime::entity copy;
+	while(out_data.size() < count && clone_hierarchy(hierarchy, copy))
+	{
+		out_data.emplace_back(copy);
+	}
+	if(out_data.size() == count)
+	{
+		return out_data;
+	}
+
+	// a component can't be copied directly, the rest go through the archive
+	std::vector<std::uint8_t> buffer;
+	serialize_binary({data}, buffer);
+	while(out_data.size() < count)
+	{
+		std::vector<runtime::entity> vec_data;
+		if(!deserialize_binary(buffer, vec_data) || vec_data.empty())
+		{
+			break;
+		}
+		out_data.emplace_back(vec_data.front());
+	}
+	return out_data;
+}
+
+void serialize_binary(const std::vector<runtime::entity>& data, std::vector<std::uint8_t>& out)
+{
+	// through memory, no stream in between
+	{
+		cereal::oarchive_binary_t ar(out);
+		try_save(ar, cereal::make_nvp("data", data));
+	}
+	runtime::get_serialization_map().clear();
+}
+
+bool deserialize_binary(const std::vector<std::uint8_t>& data, std::vector<runtime::entity>& out_data)
+{
+	if(data.empty())
+	{
+		return false;
+	}
+
+	runtime::get_serialization_map().clear();
+	bool loaded = false;
+	{
+		cereal::iarchive_binary_t ar(data.data(), data.size());
+		loaded = try_load(ar, cereal::make_nvp("data", out_data));
+	}
+	runtime::get_serialization_map().clear();
+	return loaded;
+}
+
 bool deserialize_data(std::istream& stream, std::vector<runtime::entity>& out_data)
 {
-	return deserialize_t<cereal::iarchive_associative_t>(stream, out_data);
+	std::string data(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>{});
+	stream.clear();
+	stream.seekg(0);
+
+	data_loader loader;
+	if(!loader.open(std::move(data)))
+	{
+		return false;
+	}
+	while(loader.load_next(out_data))
+	{
+	}
+	return true;
+}
+
+// the archives of a chunked file are parsed in parallel, the compact form
+// only needs its tree read
+bool data_loader::open(std::string data)
+{
+	parts_.clear();
+	next_ = 0;
+	if(data.empty())
+	{
+		return false;
+	}
+
+	struct archive
+	{
+		std::unique_ptr<fs::memory_streambuf> buffer;
+		std::unique_ptr<std::istream> stream;
+		std::unique_ptr<cereal::iarchive_associative_t> ar;
+	};
+	auto make_archive = [](const std::string& text, std::size_t offset, std::size_t size) {
+		auto a = std::make_shared<archive>();
+		a->buffer = std::make_unique<fs::memory_streambuf>(
+			reinterpret_cast<const std::uint8_t*>(text.data()) + offset, size);
+		a->stream = std::make_unique<std::istream>(a->buffer.get());
+		a->ar = std::make_unique<cereal::iarchive_associative_t>(*a->stream);
+		return a;
+	};
+
+	if(cell_data::is_partitioned(data))
+	{
+		auto cells = std::make_shared<cell_data>();
+		if(!cells->open(std::move(data)))
+		{
+			return false;
+		}
+		for(std::size_t i = 0; i < cells->get_cells().size(); ++i)
+		{
+			parts_.emplace_back(
+				[cells, i](std::vector<runtime::entity>& out_data) { cells->load_cell(i, out_data); });
+		}
+		return true;
+	}
+
+	const auto first = data.front();
+	if(first == cereal::compact_tag[0])
+	{
+		auto tree = std::make_shared<cereal::compact_tree>();
+		std::istringstream stream(std::move(data));
+		if(!tree->read(stream))
+		{
+			return false;
+		}
+		for(std::size_t i = 0; i < tree->get_documents_count(); ++i)
+		{
+			parts_.emplace_back([tree, i](std::vector<runtime::entity>& out_data) {
+				cereal::iarchive_compact_t ar(*tree, i);
+				load_part(ar, out_data);
+			});
+		}
+		return true;
+	}
+
+	auto text = std::make_shared<std::string>();
+	std::vector<std::size_t> offsets;
+	std::vector<std::size_t> sizes;
+	if(first == chunks_tag[0])
+	{
+		std::istringstream stream(std::move(data));
+		if(!read_chunks(stream, *text, offsets, sizes))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		*text = std::move(data);
+		offsets.push_back(0);
+		sizes.push_back(text->size());
+	}
+
+	std::vector<std::shared_ptr<archive>> archives(sizes.size());
+	for_each_chunk(sizes.size(),
+				   [&](std::size_t i) { archives[i] = make_archive(*text, offsets[i], sizes[i]); });
+	for(auto& a : archives)
+	{
+		// the archives read from the text, it lives as long as they do
+		parts_.emplace_back(
+			[text, a](std::vector<runtime::entity>& out_data) { load_part(*a->ar, out_data); });
+	}
+	return true;
+}
+
+bool data_loader::load_next(std::vector<runtime::entity>& out_data)
+{
+	if(is_done())
+	{
+		return false;
+	}
+	// a part is let go once loaded, with what it parsed
+	auto part = std::move(parts_[next_++]);
+	part(out_data);
+	return true;
+}
+bool compact_data(std::istream& stream, std::ostream& out)
+{
+	std::vector<std::string> documents;
+	if(stream.peek() == chunks_tag[0])
+	{
+		std::string data;
+		std::vector<std::size_t> offsets;
+		std::vector<std::size_t> sizes;
+		if(!read_chunks(stream, data, offsets, sizes))
+		{
+			return false;
+		}
+		for(std::size_t i = 0; i < sizes.size(); ++i)
+		{
+			documents.emplace_back(data, offsets[i], sizes[i]);
+		}
+	}
+	else
+	{
+		stream.clear();
+		documents.emplace_back(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+	}
+
+	return cereal::compact_tree::write(documents, out);
+}
+
+// the table is the tag, the cell size and the number of cells on one line,
+// then a line per cell: global, x, z, size and its roots by their document
+// and their index in it. The roots keep their order within a cell.
+bool partition_data(const std::string& compact, float cell_size, std::ostream& out)
+{
+	cereal::compact_tree tree;
+	std::istringstream stream(compact);
+	if(cell_size <= 0.0f || !tree.read(stream))
+	{
+		return false;
+	}
+
+	struct root
+	{
+		std::size_t document = 0;
+		std::uint32_t index = 0;
+	};
+	struct cell
+	{
+		cell_data::cell info;
+		std::vector<root> roots;
+	};
+	std::map<std::tuple<bool, std::int32_t, std::int32_t>, cell> cells;
+	for(std::size_t d = 0; d < tree.get_documents_count(); ++d)
+	{
+		const auto data = find_roots(tree, d);
+		if(data == cereal::compact_tree::invalid_index)
+		{
+			continue;
+		}
+		const auto& array = tree.get_node(data);
+		for(std::uint32_t i = 0; i < array.count; ++i)
+		{
+			const auto element = array.first + i;
+			const auto components = find_member(tree, element, "components");
+			const auto transform = components != cereal::compact_tree::invalid_index
+									   ? find_local_transform(tree, components)
+									   : cereal::compact_tree::invalid_index;
+			const auto position = transform != cereal::compact_tree::invalid_index
+									  ? find_member(tree, transform, "position")
+									  : cereal::compact_tree::invalid_index;
+
+			cell_data::cell info;
+			info.global = position == cereal::compact_tree::invalid_index;
+			if(!info.global)
+			{
+				const auto x = get_number(tree, find_member(tree, position, "x"));
+				const auto z = get_number(tree, find_member(tree, position, "z"));
+				info.x = std::int32_t(std::floor(x / double(cell_size)));
+				info.z = std::int32_t(std::floor(z / double(cell_size)));
+			}
+
+			auto& c = cells[std::make_tuple(info.global, info.x, info.z)];
+			if(c.roots.empty())
+			{
+				c.info = info;
+			}
+			c.info.size += count_nodes(tree, element);
+			c.roots.push_back({d, i});
+		}
+	}
+	if(cells.size() <= 1)
+	{
+		return false;
+	}
+
+	out << cells_tag << ' ' << cell_size << ' ' << cells.size() << '\n';
+	for(const auto& entry : cells)
+	{
+		const auto& c = entry.second;
+		out << int(c.info.global) << ' ' << c.info.x << ' ' << c.info.z << ' ' << c.info.size << ' '
+			<< c.roots.size();
+		for(const auto& r : c.roots)
+		{
+			out << ' ' << r.document << ' ' << r.index;
+		}
+		out << '\n';
+	}
+	out.write(compact.data(), std::streamsize(compact.size()));
+	return out.good();
+}
+
+bool cell_data::is_partitioned(const std::string& data)
+{
+	return data.compare(0, sizeof(cells_tag) - 1, cells_tag) == 0;
+}
+
+bool cell_data::open(std::string data)
+{
+	tree_.reset();
+	cells_.clear();
+	roots_.clear();
+	if(!is_partitioned(data))
+	{
+		return false;
+	}
+
+	std::istringstream stream(std::move(data));
+	std::string tag;
+	std::size_t count = 0;
+	stream >> tag >> cell_size_ >> count;
+	std::vector<std::vector<std::pair<std::size_t, std::uint32_t>>> roots(count);
+	cells_.resize(count);
+	for(std::size_t i = 0; i < count && stream.good(); ++i)
+	{
+		auto& c = cells_[i];
+		int global = 0;
+		std::size_t roots_count = 0;
+		stream >> global >> c.x >> c.z >> c.size >> roots_count;
+		c.global = global != 0;
+		roots[i].resize(roots_count);
+		for(auto& r : roots[i])
+		{
+			stream >> r.first >> r.second;
+		}
+	}
+	stream.ignore(1);
+
+	auto tree = std::make_shared<cereal::compact_tree>();
+	if(!stream.good() || !tree->read(stream))
+	{
+		cells_.clear();
+		return false;
+	}
+
+	// by their nodes, loading a cell does not search for them
+	std::vector<std::uint32_t> arrays(tree->get_documents_count());
+	for(std::size_t d = 0; d < arrays.size(); ++d)
+	{
+		arrays[d] = find_roots(*tree, d);
+	}
+	roots_.resize(count);
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		for(const auto& r : roots[i])
+		{
+			if(r.first >= arrays.size() || arrays[r.first] == cereal::compact_tree::invalid_index ||
+			   r.second >= tree->get_node(arrays[r.first]).count)
+			{
+				cells_.clear();
+				roots_.clear();
+				return false;
+			}
+			roots_[i].push_back(tree->get_node(arrays[r.first]).first + r.second);
+		}
+	}
+	tree_ = tree;
+	return true;
+}
+
+void cell_data::load_cell(std::size_t index, std::vector<runtime::entity>& out_data) const
+{
+	if(!tree_ || index >= roots_.size())
+	{
+		return;
+	}
+
+	runtime::get_serialization_map().clear();
+	for(const auto node : roots_[index])
+	{
+		runtime::entity root;
+		try
+		{
+			cereal::iarchive_compact_t ar(*tree_, node, 1);
+			ar(root);
+		}
+		catch(const cereal::Exception& e)
+		{
+			serialization::log_warning(e.what());
+			continue;
+		}
+		out_data.emplace_back(root);
+	}
+	runtime::get_serialization_map().clear();
 }
 }
 }
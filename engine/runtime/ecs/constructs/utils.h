@@ -4,15 +4,109 @@
 
 #include <core/filesystem/filesystem.h>
 
+#include <cstdint>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
 #include <vector>
 
+namespace cereal
+{
+class compact_tree;
+}
+
 namespace ecs
 {
 namespace utils
 {
 
+//-----------------------------------------------------------------------------
+//  Name : clone_entity ()
+/// <summary>
+/// A copy of the entity with its children, see clone_entities.
+/// </summary>
+//-----------------------------------------------------------------------------
 runtime::entity clone_entity(const runtime::entity& data);
+
+//-----------------------------------------------------------------------------
+//  Name : clone_entities ()
+/// <summary>
+/// Makes count copies of the entity with its children, each one a root.
+/// The components are copied with their clone, in memory. If a type can't
+/// be copied that way, the entities are copied through the binary archive.
+/// An entity referred to outside the hierarchy is referred to by the copies
+/// as well, it is not copied.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::vector<runtime::entity> clone_entities(const runtime::entity& data, std::size_t count);
+
+/*
+ * snapshot; a copy of entities kept out of the ecs, to bring them back as
+ * they were, e.g. the edited scene around play mode.
+ *
+ *      The components are copied with their clone, in memory, and are
+ *      cloned again for every restore. Asset handles are copied as they
+ *      are, nothing is looked up again. The restored entities are new ones
+ *      and the references between the entities of the snapshot move to them.
+ */
+class snapshot
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : take ()
+	/// <summary>
+	/// Copies the roots with their children. False, and the snapshot left
+	/// empty, if a component can't be cloned.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool take(const std::vector<runtime::entity>& roots);
+
+	//-----------------------------------------------------------------------------
+	//  Name : restore ()
+	/// <summary>
+	/// Creates the entities of the snapshot again, returns the roots.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::vector<runtime::entity> restore() const;
+
+	void clear();
+
+	bool empty() const
+	{
+		return entities_.empty();
+	}
+
+private:
+	struct entry
+	{
+		runtime::entity_name name;
+		std::vector<std::shared_ptr<runtime::component>> components;
+	};
+
+	/// every parent before its children, the components refer to them by
+	/// their index
+	std::vector<entry> entities_;
+	std::vector<std::size_t> roots_;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : serialize_binary ()
+/// <summary>
+/// Appends the entities with their children as the binary archive writes
+/// them, to be loaded in this run of the program.
+/// </summary>
+//-----------------------------------------------------------------------------
+void serialize_binary(const std::vector<runtime::entity>& data, std::vector<std::uint8_t>& out);
+
+//-----------------------------------------------------------------------------
+//  Name : deserialize_binary ()
+/// <summary>
+/// Creates new entities from what serialize_binary wrote.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool deserialize_binary(const std::vector<std::uint8_t>& data, std::vector<runtime::entity>& out_data);
+
 //-----------------------------------------------------------------------------
 //  Name : save_entity ()
 /// <summary>
@@ -62,5 +156,127 @@ bool load_entities_from_file(const fs::path& full_path, std::vector<runtime::ent
 /// </summary>
 //-----------------------------------------------------------------------------
 bool deserialize_data(std::istream& stream, std::vector<runtime::entity>& out_data);
+
+/*
+ * data_loader; creates the entities of saved data a part at a time, so that
+ * a large scene can be spread over frames.
+ *
+ *      open parses the data and may run on any thread, it does not touch the
+ *      ecs. Each load_next then creates the entities of one part on the
+ *      thread owning the ecs: a chunk of the roots of a file saved in chunks,
+ *      a document of the compact form or a cell of partitioned data. Data
+ *      saved as one archive is one part.
+ */
+class data_loader
+{
+public:
+	bool open(std::string data);
+
+	//-----------------------------------------------------------------------------
+	//  Name : load_next ()
+	/// <summary>
+	/// Appends the entities of the next part, false when all are loaded.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool load_next(std::vector<runtime::entity>& out_data);
+
+	bool is_done() const
+	{
+		return next_ >= parts_.size();
+	}
+
+	std::size_t get_parts_count() const
+	{
+		return parts_.size();
+	}
+
+	std::size_t get_parts_loaded() const
+	{
+		return next_;
+	}
+
+private:
+	std::vector<std::function<void(std::vector<runtime::entity>&)>> parts_;
+	std::size_t next_ = 0;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : compact_data ()
+/// <summary>
+/// Writes entities saved as associative archives in the compact binary form
+/// the compiled assets keep. False when they can't be read.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool compact_data(std::istream& stream, std::ostream& out);
+
+//-----------------------------------------------------------------------------
+//  Name : partition_data ()
+/// <summary>
+/// Splits the roots of data in the compact form into the square cells of a
+/// grid on the ground by their position, with the table of the cells written
+/// in front of the data, see cell_data. False, and nothing written, when all
+/// the roots are in one cell.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool partition_data(const std::string& compact, float cell_size, std::ostream& out);
+
+/*
+ * cell_data; the entities of data split by partition_data, created a cell at
+ * a time and in any order.
+ *
+ *      open parses the data and may run on any thread, load_cell creates the
+ *      entities of a cell on the thread owning the ecs. The roots without a
+ *      transform are in the global cell, which is not on the grid. A cell
+ *      holds whole hierarchies, a reference to an entity of another cell is
+ *      not kept.
+ */
+class cell_data
+{
+public:
+	struct cell
+	{
+		/// where on the grid, by the cell size along x and z
+		std::int32_t x = 0;
+		std::int32_t z = 0;
+		bool global = false;
+		/// the nodes of the data of its entities, what the cell weighs
+		std::size_t size = 0;
+	};
+
+	bool open(std::string data);
+
+	//-----------------------------------------------------------------------------
+	//  Name : load_cell ()
+	/// <summary>
+	/// Appends the roots of the cell, created again on every call.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void load_cell(std::size_t index, std::vector<runtime::entity>& out_data) const;
+
+	const std::vector<cell>& get_cells() const
+	{
+		return cells_;
+	}
+
+	float get_cell_size() const
+	{
+		return cell_size_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_partitioned ()
+	/// <summary>
+	/// If the data starts with the table of its cells.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool is_partitioned(const std::string& data);
+
+private:
+	std::shared_ptr<cereal::compact_tree> tree_;
+	std::vector<cell> cells_;
+	/// the nodes of the roots of every cell
+	std::vector<std::vector<std::uint32_t>> roots_;
+	float cell_size_ = 0.0f;
+};
 }
 }
@@ -1,5 +1,9 @@
 #include "ecs.h"
 
+#include <core/reflection/reflection.h>
+
+#include <iomanip>
+
 namespace runtime
 {
 
@@ -35,6 +39,10 @@ event<void(entity)> on_entity_destroyed;
 event<void(entity, chandle<component>)> on_component_added;
 event<void(entity, chandle<component>)> on_component_removed;
 
+constexpr std::uint32_t component_storage::invalid_slot;
+constexpr std::uint64_t component_storage::never_changed;
+constexpr std::uint64_t component_storage::history_frames;
+
 component_storage::component_storage(std::size_t size)
 {
 	expand(size);
@@ -42,38 +50,159 @@ component_storage::component_storage(std::size_t size)
 
 void component_storage::expand(std::size_t n)
 {
-	data.resize(n);
+	if(sparse_.size() < n)
+	{
+		sparse_.resize(n, invalid_slot);
+
+		std::lock_guard<std::mutex> lock(changes_mutex_);
+		last_changed_.resize(n, never_changed);
+	}
 }
 
 void component_storage::reserve(std::size_t n)
 {
-	data.reserve(n);
+	dense_entities_.reserve(n);
+	dense_.reserve(n);
+}
+
+void component_storage::shrink(std::size_t n)
+{
+	if(sparse_.size() > n)
+	{
+		sparse_.resize(n);
+	}
+	sparse_.shrink_to_fit();
+	dense_entities_.shrink_to_fit();
+	dense_.shrink_to_fit();
+
+	std::lock_guard<std::mutex> lock(changes_mutex_);
+	if(last_changed_.size() > n)
+	{
+		last_changed_.resize(n);
+	}
+	last_changed_.shrink_to_fit();
+	changes_.erase(std::remove_if(std::begin(changes_), std::end(changes_),
+								  [n](const change& c) { return c.index >= n; }),
+				   std::end(changes_));
+	changes_.shrink_to_fit();
+}
+
+std::size_t component_storage::get_storage_bytes() const
+{
+	std::lock_guard<std::mutex> lock(changes_mutex_);
+	return sparse_.capacity() * sizeof(std::uint32_t) + dense_entities_.capacity() * sizeof(std::uint32_t) +
+		   dense_.capacity() * sizeof(std::shared_ptr<component>) +
+		   last_changed_.capacity() * sizeof(std::uint64_t) + changes_.capacity() * sizeof(change);
 }
 
 std::shared_ptr<component> component_storage::get(std::size_t n) const
 {
 	expects(n < size());
-	return data[n];
+	const auto slot = sparse_[n];
+	if(slot == invalid_slot)
+	{
+		return nullptr;
+	}
+	return dense_[slot];
 }
 
 void component_storage::destroy(std::size_t n)
 {
 	expects(n < size());
-	auto& element = data[n];
+	const auto slot = sparse_[n];
+	if(slot == invalid_slot)
+	{
+		return;
+	}
+
+	// swap the last component in the freed slot
+	const auto last = static_cast<std::uint32_t>(dense_.size() - 1);
+	if(slot != last)
+	{
+		std::swap(dense_[slot], dense_[last]);
+		dense_entities_[slot] = dense_entities_[last];
+		sparse_[dense_entities_[slot]] = slot;
+	}
+	sparse_[n] = invalid_slot;
+	{
+		// older entries of the index must not be reported for the next component
+		std::lock_guard<std::mutex> lock(changes_mutex_);
+		last_changed_[n] = never_changed;
+	}
+	// the component may destroy others of its type, leave the storage consistent first
+	auto element = std::move(dense_.back());
+	dense_.pop_back();
+	dense_entities_.pop_back();
 	element.reset();
 }
 
 std::weak_ptr<component> component_storage::set(unsigned int index,
 												const std::shared_ptr<component>& component)
 {
-	data[index] = component;
+	expand(index + 1);
+	auto& slot = sparse_[index];
+	if(slot != invalid_slot)
+	{
+		dense_[slot] = component;
+		return component;
+	}
+
+	slot = static_cast<std::uint32_t>(dense_.size());
+	dense_.push_back(component);
+	dense_entities_.push_back(index);
 	return component;
 }
 
+void component_storage::mark_changed(std::size_t n, std::uint64_t frame)
+{
+	std::lock_guard<std::mutex> lock(changes_mutex_);
+	expects(n < last_changed_.size());
+	if(last_changed_[n] == frame)
+	{
+		return;
+	}
+
+	if(frame >= history_frames && history_begin_ < frame - history_frames)
+	{
+		history_begin_ = frame - history_frames;
+		const auto first_kept = std::find_if(std::begin(changes_), std::end(changes_),
+											 [this](const change& c) { return c.frame >= history_begin_; });
+		changes_.erase(std::begin(changes_), first_kept);
+	}
+
+	last_changed_[n] = frame;
+	change c;
+	c.index = static_cast<std::uint32_t>(n);
+	c.frame = frame;
+	changes_.push_back(c);
+}
+
+bool component_storage::get_changed(std::uint64_t from, std::uint64_t to,
+									std::vector<std::uint32_t>& changed) const
+{
+	std::lock_guard<std::mutex> lock(changes_mutex_);
+	if(from < history_begin_)
+	{
+		return false;
+	}
+
+	auto it = std::lower_bound(std::begin(changes_), std::end(changes_), from,
+							   [](const change& c, std::uint64_t frame) { return c.frame < frame; });
+	for(; it != std::end(changes_) && it->frame < to; ++it)
+	{
+		// an index changed again later is reported by its latest entry
+		if(last_changed_[it->index] == it->frame)
+		{
+			changed.push_back(it->index);
+		}
+	}
+	return true;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 const entity::id_t entity::INVALID;
 
-void entity::set_name(const std::string& name)
+void entity::set_name(const entity_name& name)
 {
 	expects(valid());
 	manager_->set_entity_name(id_, name);
@@ -85,6 +214,12 @@ const std::string& entity::get_name() const
 	return manager_->get_entity_name(id_);
 }
 
+const entity_name& entity::get_interned_name() const
+{
+	expects(valid());
+	return manager_->get_entity_interned_name(id_);
+}
+
 void entity::invalidate()
 {
 	id_ = INVALID;
@@ -98,6 +233,15 @@ void entity::destroy()
 	invalidate();
 }
 
+void component::touch()
+{
+	last_touched_ = static_cast<std::uint32_t>(ecs::get_frame());
+	if(entity_.valid())
+	{
+		entity_.manager_->mark_changed(entity_.id(), runtime_id());
+	}
+}
+
 entity_component_system::~entity_component_system()
 {
 	dispose();
@@ -130,7 +274,7 @@ entity entity_component_system::create()
 	{
 		index = index_counter_++;
 		accomodate_entity(index);
-		version = entity_version_[index] = 1;
+		version = entity_version_[index] = first_version_;
 	}
 	else
 	{
@@ -138,19 +282,335 @@ entity entity_component_system::create()
 		free_list_.pop_back();
 		version = entity_version_[index];
 	}
+	set_alive(index, true);
 	entity entity(this, entity::id_t(index, version));
 	on_entity_created(entity);
 	return entity;
 }
 
-void entity_component_system::set_entity_name(entity::id_t id, const std::string& name)
+std::vector<entity> entity_component_system::create_many(std::size_t n)
+{
+	std::vector<entity> entities;
+	entities.reserve(n);
+
+	const auto reused = std::min(n, free_list_.size());
+	if(n > reused)
+	{
+		accomodate_entity(static_cast<std::uint32_t>(index_counter_ + (n - reused) - 1));
+	}
+
+	for(std::size_t i = 0; i < n; ++i)
+	{
+		std::uint32_t index, version;
+		if(i < reused)
+		{
+			index = free_list_.back();
+			free_list_.pop_back();
+			version = entity_version_[index];
+		}
+		else
+		{
+			index = index_counter_++;
+			version = entity_version_[index] = first_version_;
+		}
+		set_alive(index, true);
+		entities.emplace_back(this, entity::id_t(index, version));
+	}
+
+	for(const auto& e : entities)
+	{
+		on_entity_created(e);
+	}
+	return entities;
+}
+
+void entity_component_system::destroy_many(const std::vector<entity>& entities)
+{
+	free_list_.reserve(free_list_.size() + entities.size());
+	for(const auto& e : entities)
+	{
+		// the handles are copies, an entity listed twice is stale the second time
+		if(valid(e.id()))
+		{
+			destroy(e.id());
+		}
+	}
+}
+
+void entity_component_system::reserve(std::size_t n)
+{
+	entity_component_mask_.reserve(n);
+	entity_version_.reserve(n);
+	entity_names_.reserve(n);
+	name_positions_.reserve(n);
+	alive_mask_.reserve(n / 64 + 1);
+	for(auto& pool : component_pools_)
+	{
+		if(pool)
+		{
+			pool->expand(n);
+		}
+	}
+}
+
+void entity_component_system::compact()
+{
+	// one past the last live entity
+	std::size_t used = 0;
+	for(std::size_t word = alive_mask_.size(); word > 0; --word)
+	{
+		const auto bits = alive_mask_[word - 1];
+		if(bits != 0)
+		{
+			std::size_t bit = 63;
+			while(((bits >> bit) & 1) == 0)
+			{
+				--bit;
+			}
+			used = (word - 1) * 64 + bit + 1;
+			break;
+		}
+	}
+
+	// handles to the dropped slots have older versions than the slots
+	for(std::size_t index = used; index < entity_version_.size(); ++index)
+	{
+		first_version_ = std::max(first_version_, entity_version_[index]);
+	}
+
+	free_list_.erase(std::remove_if(std::begin(free_list_), std::end(free_list_),
+									[used](std::uint32_t index) { return index >= used; }),
+					 std::end(free_list_));
+	free_list_.shrink_to_fit();
+	entity_component_mask_.resize(used);
+	entity_component_mask_.shrink_to_fit();
+	entity_version_.resize(used);
+	entity_version_.shrink_to_fit();
+	// the dropped slots are free, they have no names
+	entity_names_.resize(used);
+	entity_names_.shrink_to_fit();
+	name_positions_.resize(used);
+	name_positions_.shrink_to_fit();
+	alive_mask_.resize((used + 63) / 64);
+	alive_mask_.shrink_to_fit();
+	index_counter_ = static_cast<std::uint32_t>(used);
+
+	for(auto& pool : component_pools_)
+	{
+		if(pool)
+		{
+			pool->shrink(used);
+		}
+	}
+
+	ecs::detail::shrink_block_pools();
+	destroyed_since_compact_ = 0;
+}
+
+void entity_component_system::set_auto_compact(float occupancy_threshold)
+{
+	auto_compact_threshold_ = std::max(0.0f, std::min(occupancy_threshold, 1.0f));
+}
+
+void entity_component_system::maybe_compact()
+{
+	if(auto_compact_threshold_ <= 0.0f)
+	{
+		return;
+	}
+
+	// wait for a good share of the capacity to be destroyed so that a scene
+	// that keeps a live entity at the end doesn't compact every frame.
+	const auto slots = capacity();
+	if(destroyed_since_compact_ < slots / 4 || float(size()) >= auto_compact_threshold_ * float(slots))
+	{
+		return;
+	}
+
+	compact();
+}
+
+memory_report entity_component_system::get_memory_report() const
+{
+	memory_report report;
+	report.entities = size();
+	report.capacity = capacity();
+	report.mask_bytes = entity_component_mask_.capacity() * sizeof(component_mask_t);
+	report.version_bytes = entity_version_.capacity() * sizeof(std::uint32_t);
+	report.free_list_bytes = free_list_.capacity() * sizeof(std::uint32_t);
+	report.alive_mask_bytes = alive_mask_.capacity() * sizeof(std::uint64_t);
+	report.name_bytes = entity_names_.capacity() * sizeof(entity_name) +
+						name_positions_.capacity() * sizeof(std::uint32_t);
+	for(const auto& named : named_entities_)
+	{
+		report.name_bytes += sizeof(named) + named.second.capacity() * sizeof(std::uint32_t);
+	}
+
+	const auto pools_stats = ecs::detail::get_block_pools_stats();
+	for(const auto& pool_stats : pools_stats)
+	{
+		if(pool_stats.tag == ecs::detail::asset_pool)
+		{
+			report.asset_links += pool_stats.used_blocks;
+			report.asset_link_bytes += pool_stats.capacity_blocks * pool_stats.block_size;
+		}
+	}
+	for(std::size_t family = 0; family < component_pools_.size(); ++family)
+	{
+		const auto& pool = component_pools_[family];
+		if(!pool || pool->capacity() == 0)
+		{
+			continue;
+		}
+
+		component_memory_stats stats;
+		stats.family = family;
+		stats.count = pool->count();
+		stats.storage_bytes = pool->get_storage_bytes();
+		if(stats.count > 0)
+		{
+			const auto type = rttr::type::get(*pool->get_dense(0));
+			stats.name = type.get_name().to_string();
+			stats.object_bytes = stats.count * type.get_sizeof();
+		}
+
+		// a component type may have several pools, one per control block type
+		for(const auto& pool_stats : pools_stats)
+		{
+			if(pool_stats.tag != family)
+			{
+				continue;
+			}
+			if(!stats.pooled)
+			{
+				stats.object_bytes = 0;
+				stats.pooled = true;
+			}
+			const auto used = pool_stats.used_blocks;
+			const auto unused = pool_stats.capacity_blocks - used;
+			stats.object_bytes += used * pool_stats.object_size;
+			stats.control_block_bytes += used * (pool_stats.block_size - pool_stats.object_size);
+			stats.pool_slack_bytes += unused * pool_stats.block_size;
+		}
+
+		report.components.emplace_back(std::move(stats));
+	}
+
+	return report;
+}
+
+std::size_t memory_report::get_total_bytes() const
+{
+	auto total = mask_bytes + version_bytes + free_list_bytes + alive_mask_bytes + name_bytes;
+	for(const auto& stats : components)
+	{
+		total += stats.get_total_bytes();
+	}
+	return total;
+}
+
+void memory_report::write(std::ostream& out) const
+{
+	out << "entities " << entities << " / " << capacity << " slots, total " << get_total_bytes()
+		<< " bytes\n";
+	out << "  masks " << mask_bytes << ", versions " << version_bytes << ", free list " << free_list_bytes
+		<< ", alive mask " << alive_mask_bytes << ", names " << name_bytes << "\n";
+	out << "  asset links " << asset_links << ", " << asset_link_bytes << " bytes pooled\n";
+
+	out << std::left << std::setw(32) << "component" << std::right << std::setw(8) << "count" << std::setw(12)
+		<< "objects" << std::setw(12) << "control" << std::setw(12) << "slack" << std::setw(12) << "storage"
+		<< "\n";
+	for(const auto& stats : components)
+	{
+		out << std::left << std::setw(32) << (stats.name.empty() ? "<empty>" : stats.name) << std::right
+			<< std::setw(8) << stats.count << std::setw(12) << stats.object_bytes;
+		if(stats.pooled)
+		{
+			out << std::setw(12) << stats.control_block_bytes << std::setw(12) << stats.pool_slack_bytes;
+		}
+		else
+		{
+			out << std::setw(12) << "-" << std::setw(12) << "-";
+		}
+		out << std::setw(12) << stats.storage_bytes << "\n";
+	}
+}
+
+void entity_component_system::set_entity_name(entity::id_t id, const entity_name& name)
+{
+	assert_valid(id);
+	const auto index = id.index();
+	if(entity_names_[index] == name)
+	{
+		return;
+	}
+
+	unlink_name(index);
+	if(!name.empty())
+	{
+		auto& indices = named_entities_[name];
+		name_positions_[index] = static_cast<std::uint32_t>(indices.size());
+		indices.push_back(index);
+		entity_names_[index] = name;
+	}
+	++names_version_;
+}
+
+const std::string& entity_component_system::get_entity_name(entity::id_t id) const
+{
+	return get_entity_interned_name(id).str();
+}
+
+const entity_name& entity_component_system::get_entity_interned_name(entity::id_t id) const
+{
+	assert_valid(id);
+	return entity_names_[id.index()];
+}
+
+void entity_component_system::find_entities_named(const entity_name& name, std::vector<entity>& entities)
+{
+	auto it = named_entities_.find(name);
+	if(it == std::end(named_entities_))
+	{
+		return;
+	}
+
+	entities.reserve(entities.size() + it->second.size());
+	for(const auto index : it->second)
+	{
+		entities.emplace_back(this, entity::id_t(index, entity_version_[index]));
+	}
+}
+
+void entity_component_system::get_entity_names(std::vector<entity_name>& names) const
 {
-	entity_names_[id.id()] = name;
+	names.reserve(names.size() + named_entities_.size());
+	for(const auto& named : named_entities_)
+	{
+		names.push_back(named.first);
+	}
 }
 
-const std::string& entity_component_system::get_entity_name(entity::id_t id)
+void entity_component_system::unlink_name(std::uint32_t index)
 {
-	return entity_names_[id.id()];
+	auto& name = entity_names_[index];
+	if(name.empty())
+	{
+		return;
+	}
+
+	auto it = named_entities_.find(name);
+	auto& indices = it->second;
+	const auto position = name_positions_[index];
+	indices[position] = indices.back();
+	name_positions_[indices[position]] = position;
+	indices.pop_back();
+	// the index keeps the names in use only, for the searches to go through
+	if(indices.empty())
+	{
+		named_entities_.erase(it);
+	}
+	name.clear();
 }
 
 void entity_component_system::dispose()
@@ -161,10 +621,8 @@ void entity_component_system::dispose()
 	}
 
 	component_pools_.clear();
-	entity_component_mask_.clear();
-	entity_version_.clear();
-	free_list_.clear();
-	index_counter_ = 0;
+	// releases the arrays and keeps the versions past those of the old handles
+	compact();
 }
 
 void entity_component_system::remove(entity::id_t id, const std::shared_ptr<component>& component)
@@ -182,7 +640,9 @@ void entity_component_system::remove(entity::id_t id, rtti::type_index_sequentia
 	chandle<component> handle(pool->get(id.index()));
 	on_component_removed(get(id), handle);
 	// Remove component bit.
-	entity_component_mask_[id.index()].reset(family);
+	const auto before = entity_component_mask_[index];
+	entity_component_mask_[index].reset(family);
+	update_queries(index, before, entity_component_mask_[index]);
 
 	// Call destructor.
 	pool->destroy(index);
@@ -254,7 +714,10 @@ chandle<component> entity_component_system::assign(entity::id_t id, const std::s
 
 	auto ptr = pool.set(id.index(), comp);
 	// Set the bit for this component.
+	const auto before = entity_component_mask_[id.index()];
 	entity_component_mask_[id.index()].set(family);
+	update_queries(id.index(), before, entity_component_mask_[id.index()]);
+	pool.mark_changed(id.index(), ecs::get_frame());
 
 	// Create and return handle.
 	comp->entity_ = get(id);
@@ -266,9 +729,13 @@ chandle<component> entity_component_system::assign(entity::id_t id, const std::s
 
 void entity_component_system::destroy(entity::id_t id)
 {
-	entity_names_[id.id()].clear();
 	assert_valid(id);
 	std::uint32_t index = id.index();
+	if(!entity_names_[index].empty())
+	{
+		unlink_name(index);
+		++names_version_;
+	}
 	auto mask = entity_component_mask_[index];
 	for(size_t i = 0; i < component_pools_.size(); ++i)
 	{
@@ -284,9 +751,120 @@ void entity_component_system::destroy(entity::id_t id)
 	}
 
 	on_entity_destroyed(get(id));
+	// the components removed themselves above, this is what is left if any
+	const auto remaining = entity_component_mask_[index];
 	entity_component_mask_[index].reset();
+	update_queries(index, remaining, entity_component_mask_[index]);
 	entity_version_[index]++;
 	free_list_.push_back(index);
+	set_alive(index, false);
+	destroyed_since_compact_++;
+}
+
+bool entity_component_system::get_changed_since(std::uint64_t version, const component_mask_t& mask,
+												std::vector<entity>& changed)
+{
+	const auto frame = ecs::get_frame();
+	std::vector<std::uint32_t> indices;
+	for(std::size_t family = 0; family < component_pools_.size(); ++family)
+	{
+		const auto& pool = component_pools_[family];
+		if(!mask.test(family) || !pool)
+		{
+			continue;
+		}
+
+		if(!pool->get_changed(version, frame, indices))
+		{
+			return false;
+		}
+	}
+
+	std::sort(std::begin(indices), std::end(indices));
+	indices.erase(std::unique(std::begin(indices), std::end(indices)), std::end(indices));
+	for(const auto index : indices)
+	{
+		if((entity_component_mask_[index] & mask) == mask)
+		{
+			changed.emplace_back(this, create_id(index));
+		}
+	}
+	return true;
+}
+
+const entity_component_system::query_state& entity_component_system::find_query(const component_mask_t& mask)
+{
+	for(const auto& state : queries_)
+	{
+		if(state->mask == mask)
+		{
+			return *state;
+		}
+	}
+
+	auto state = std::make_unique<query_state>();
+	state->mask = mask;
+	queries_.push_back(std::move(state));
+
+	// filled as if every live entity had just got its components
+	const auto end = capacity();
+	for(auto index = find_alive(0, end); index < end; index = find_alive(index + 1, end))
+	{
+		if((entity_component_mask_[index] & mask) == mask)
+		{
+			auto& added = *queries_.back();
+			added.indices.push_back(index);
+			if(added.positions.size() <= index)
+			{
+				added.positions.resize(index + 1, 0);
+			}
+			added.positions[index] = static_cast<std::uint32_t>(added.indices.size());
+		}
+	}
+	return *queries_.back();
+}
+
+void entity_component_system::update_queries(std::uint32_t index, const component_mask_t& before,
+											 const component_mask_t& after)
+{
+	for(auto& state : queries_)
+	{
+		const bool was_in = (before & state->mask) == state->mask;
+		const bool is_in = (after & state->mask) == state->mask;
+		if(was_in == is_in)
+		{
+			continue;
+		}
+
+		auto& indices = state->indices;
+		auto& positions = state->positions;
+		if(is_in)
+		{
+			if(positions.size() <= index)
+			{
+				positions.resize(index + 1, 0);
+			}
+			indices.push_back(index);
+			positions[index] = static_cast<std::uint32_t>(indices.size());
+			continue;
+		}
+
+		// the last entity of the list takes its place
+		const auto position = positions[index] - 1;
+		const auto last = indices.back();
+		indices[position] = last;
+		positions[last] = position + 1;
+		indices.pop_back();
+		positions[index] = 0;
+	}
+}
+
+void entity_component_system::mark_changed(entity::id_t id, rtti::type_index_sequential_t::index_t family)
+{
+	if(family < component_pools_.size() && component_pools_[family])
+	{
+		component_pools_[family]->mark_changed(id.index(), ecs::get_frame());
+	}
 }
 
 entity entity_component_system::get(entity::id_t id)
@@ -2,13 +2,18 @@
 
 #pragma once
 
+#include "component_pool.h"
+#include "entity_name.h"
+
 #include <core/common/assert.hpp>
 #include <core/common/nonstd/type_index.hpp>
 #include <core/reflection/registration.h>
 #include <core/serialization/serialization.h>
 #include <core/signals/event.hpp>
+#include <core/tasks/task_group.h>
 
 #include <algorithm>
+#include <array>
 #include <bitset>
 #include <cstdint>
 #include <cstdlib>
@@ -23,6 +28,7 @@
 #include <string>
 #include <tuple>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -40,22 +46,60 @@ template <typename C>
 using chandle = std::weak_ptr<C>;
 
 class component;
+
+//-----------------------------------------------------------------------------
+//  Name : make_component ()
+/// <summary>
+/// Creates a component in the block pool of its type, so that the
+/// components of a type are allocated next to each other.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename T, typename... Args>
+inline std::shared_ptr<T> make_component(Args&&... args)
+{
+	return ecs::detail::make_pooled<T>(rtti::type_index_sequential_t::id<component, T>(),
+									   std::forward<Args>(args)...);
+}
+
+/*
+ * component_storage; a sparse set of the components of one type.
+ *
+ *      The components are kept densely packed together with the index of
+ *      their entity and a sparse array maps entity indices to the dense slots.
+ *      Iterating a type walks only the live components and removal is a swap
+ *      with the last one.
+ */
 class component_storage
 {
 public:
 	component_storage(std::size_t size = 100);
 
+	/// Number of entity slots the storage can map.
 	inline std::size_t size() const
 	{
-		return data.size();
+		return sparse_.size();
 	}
 	inline std::size_t capacity() const
 	{
-		return data.capacity();
+		return sparse_.capacity();
+	}
+	/// Number of components stored.
+	inline std::size_t count() const
+	{
+		return dense_.size();
 	}
 	/// Ensure at least n elements will fit in the pool.
 	void expand(std::size_t n);
 	void reserve(std::size_t n);
+
+	//-----------------------------------------------------------------------------
+	//  Name : shrink ()
+	/// <summary>
+	/// Drops the entity slots from n on, they must not hold components, and
+	/// releases the memory the arrays hold past their size.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void shrink(std::size_t n);
 	std::shared_ptr<component> get(std::size_t n) const;
 
 	template <typename T>
@@ -66,20 +110,105 @@ public:
 		return std::static_pointer_cast<T>(get(n));
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_ptr ()
+	/// <summary>
+	/// Gets the component of entity index n without touching its reference
+	/// count. The entity must have the component.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline component* get_ptr(std::size_t n) const
+	{
+		return dense_[sparse_[n]].get();
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_dense ()
+	/// <summary>
+	/// Gets the component in the i-th dense slot, i < count().
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline component* get_dense(std::size_t i) const
+	{
+		return dense_[i].get();
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_dense_entity ()
+	/// <summary>
+	/// Gets the entity index owning the i-th dense slot, i < count().
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline std::uint32_t get_dense_entity(std::size_t i) const
+	{
+		return dense_entities_[i];
+	}
+
 	void destroy(std::size_t n);
 
 	template <typename T, typename... Args>
 	std::weak_ptr<T> set(unsigned int index, Args&&... args)
 	{
-		auto element = std::make_shared<T>(std::forward<Args>(args)...);
-		data[index] = std::move(element);
-		return std::static_pointer_cast<T>(data[index]);
+		auto element = make_component<T>(std::forward<Args>(args)...);
+		set(index, element);
+		return element;
 	}
 
 	std::weak_ptr<component> set(unsigned int index, const std::shared_ptr<component>& component);
 
+	//-----------------------------------------------------------------------------
+	//  Name : mark_changed ()
+	/// <summary>
+	/// Records that the component of entity index n was written in the given
+	/// frame. Safe to call from any thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void mark_changed(std::size_t n, std::uint64_t frame);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_changed ()
+	/// <summary>
+	/// Appends the entity indices whose component was last written in the
+	/// frames [from, to). Returns false if the history doesn't reach back to
+	/// from, nothing is appended then.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool get_changed(std::uint64_t from, std::uint64_t to, std::vector<std::uint32_t>& changed) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_storage_bytes ()
+	/// <summary>
+	/// Bytes held by the arrays of the storage, the components excluded.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t get_storage_bytes() const;
+
+	/// frames of change history that are kept
+	static constexpr std::uint64_t history_frames = 16;
+
 private:
-	std::vector<std::shared_ptr<component>> data;
+	static constexpr std::uint32_t invalid_slot = ~std::uint32_t(0);
+	static constexpr std::uint64_t never_changed = ~std::uint64_t(0);
+
+	struct change
+	{
+		std::uint32_t index = 0;
+		std::uint64_t frame = 0;
+	};
+
+	/// entity index to dense slot, invalid_slot if there is no component
+	std::vector<std::uint32_t> sparse_;
+	std::vector<std::uint32_t> dense_entities_;
+	std::vector<std::shared_ptr<component>> dense_;
+
+	/// latest change frame per entity index
+	std::vector<std::uint64_t> last_changed_;
+	/// ordered by frame, at most one entry per entity index and frame
+	std::vector<change> changes_;
+	/// frames before this one were dropped from changes_
+	std::uint64_t history_begin_ = 0;
+	/// components are touched from the systems running concurrently
+	mutable std::mutex changes_mutex_;
 };
 
 class entity_component_system;
@@ -180,8 +309,10 @@ public:
 	{
 		return other.id_ < id_;
 	}
-	void set_name(const std::string& name);
+	void set_name(const entity_name& name);
 	const std::string& get_name() const;
+	/// the name as interned, to compare or copy to other entities
+	const entity_name& get_interned_name() const;
 	/**
 	 * Is this entity handle valid?
 	 *
@@ -242,10 +373,47 @@ public:
 	void destroy();
 
 private:
+	friend class component;
+
 	entity::id_t id_ = INVALID;
 	entity_component_system* manager_ = nullptr;
 };
 
+/*
+ * clone_map; the entities copied together and their copies.
+ *
+ *      A component cloned for a copy refers to the copies of the entities
+ *      copied along with it, the other entities it refers to stay the same.
+ */
+class clone_map
+{
+public:
+	void add(const entity& source, const entity& copy)
+	{
+		copies_[source.id().id()] = copy;
+	}
+
+	entity get(const entity& source) const
+	{
+		auto it = copies_.find(source.id().id());
+		return it == std::end(copies_) ? source : it->second;
+	}
+
+	std::vector<entity> get(const std::vector<entity>& sources) const
+	{
+		std::vector<entity> result;
+		result.reserve(sources.size());
+		for(const auto& source : sources)
+		{
+			result.emplace_back(get(source));
+		}
+		return result;
+	}
+
+private:
+	std::unordered_map<std::uint64_t, entity> copies_;
+};
+
 class component : public std::enable_shared_from_this<component>
 {
 	REFLECTABLEV(component)
@@ -292,15 +460,11 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : touch (virtual )
 	/// <summary>
-	///
-	///
-	///
+	/// Marks the component as written this frame and records it in the
+	/// change history of its type.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	void touch()
-	{
-		last_touched_ = static_cast<std::uint32_t>(ecs::get_frame());
-	}
+	void touch();
 
 	//-----------------------------------------------------------------------------
 	//  Name : is_dirty (virtual )
@@ -315,6 +479,17 @@ public:
 		return last_touched_ == static_cast<std::uint32_t>(ecs::get_frame()) - 1;
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_last_touched ()
+	/// <summary>
+	/// The frame in which the component was last touched, truncated to 32 bits.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint32_t get_last_touched() const
+	{
+		return last_touched_;
+	}
+
 	//-----------------------------------------------------------------------------
 	//  Name : on_entity_set (virtual )
 	/// <summary>
@@ -327,6 +502,19 @@ public:
 	{
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : clone (virtual )
+	/// <summary>
+	/// A new component with what this one saves, to be assigned to the copy
+	/// of its entity. Null when the type can't be copied directly, the
+	/// entities are then copied through serialization.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual std::shared_ptr<component> clone(const clone_map& /*map*/) const
+	{
+		return nullptr;
+	}
+
 	//-----------------------------------------------------------------------------
 	//  Name : get_entity ()
 	/// <summary>
@@ -386,6 +574,61 @@ extern event<void(entity)> on_entity_destroyed;
 extern event<void(entity, chandle<component>)> on_component_added;
 extern event<void(entity, chandle<component>)> on_component_removed;
 
+/*
+ * component_memory_stats; the memory used by the components of one type.
+ */
+struct component_memory_stats
+{
+	std::string name;
+	std::size_t family = 0;
+	std::size_t count = 0;
+	/// the component objects themselves
+	std::size_t object_bytes = 0;
+	/// the shared_ptr control blocks and their padding in the pool blocks
+	std::size_t control_block_bytes = 0;
+	/// blocks carved in the pool but not in use
+	std::size_t pool_slack_bytes = 0;
+	/// the sparse set and the change history of the type
+	std::size_t storage_bytes = 0;
+	/// false if the components were not made with make_component, their
+	/// control blocks and slack are unknown then.
+	bool pooled = false;
+
+	std::size_t get_total_bytes() const
+	{
+		return object_bytes + control_block_bytes + pool_slack_bytes + storage_bytes;
+	}
+};
+
+/*
+ * memory_report; the memory footprint of the entities and their components.
+ */
+struct memory_report
+{
+	std::vector<component_memory_stats> components;
+	std::size_t entities = 0;
+	/// entity slots, live or free
+	std::size_t capacity = 0;
+	std::size_t mask_bytes = 0;
+	std::size_t version_bytes = 0;
+	std::size_t free_list_bytes = 0;
+	std::size_t alive_mask_bytes = 0;
+	std::size_t name_bytes = 0;
+	/// the asset links of the asset handles, in their block pools
+	std::size_t asset_links = 0;
+	std::size_t asset_link_bytes = 0;
+
+	std::size_t get_total_bytes() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : write ()
+	/// <summary>
+	/// Writes the report as a human readable table.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void write(std::ostream& out) const;
+};
+
 /**
  * Manages entity::Id creation and component assignment.
  */
@@ -432,33 +675,28 @@ public:
 			: manager_(manager)
 			, i_(index)
 			, capacity_(manager_->capacity())
-			, free_cursor_(~0UL)
 		{
-			if(All)
-			{
-				std::sort(manager_->free_list_.begin(), manager_->free_list_.end());
-				free_cursor_ = 0;
-			}
 		}
 		view_iterator(entity_component_system* manager, const component_mask_t mask, std::uint32_t index)
 			: manager_(manager)
 			, mask_(mask)
 			, i_(index)
 			, capacity_(manager_->capacity())
-			, free_cursor_(~0UL)
 		{
-			if(All)
-			{
-				std::sort(manager_->free_list_.begin(), manager_->free_list_.end());
-				free_cursor_ = 0;
-			}
 		}
 
 		void next()
 		{
-			while(i_ < capacity_ && !predicate())
+			if(All)
 			{
-				++i_;
+				i_ = manager_->find_alive(i_, capacity_);
+			}
+			else
+			{
+				while(i_ < capacity_ && !predicate())
+				{
+					++i_;
+				}
 			}
 
 			if(i_ < capacity_)
@@ -470,25 +708,13 @@ public:
 
 		inline bool predicate()
 		{
-			return (All && valid_entity()) || (manager_->entity_component_mask_[i_] & mask_) == mask_;
-		}
-
-		inline bool valid_entity()
-		{
-			const std::vector<std::uint32_t>& free_list = manager_->free_list_;
-			if(free_cursor_ < free_list.size() && free_list[free_cursor_] == i_)
-			{
-				++free_cursor_;
-				return false;
-			}
-			return true;
+			return (manager_->entity_component_mask_[i_] & mask_) == mask_;
 		}
 
 		entity_component_system* manager_;
 		component_mask_t mask_;
 		std::uint32_t i_;
 		size_t capacity_;
-		size_t free_cursor_;
 	};
 
 	template <bool All>
@@ -666,6 +892,71 @@ public:
 		unpacker unpacker_;
 	};
 
+private:
+	/// the dense list of the live entities matching the mask of a query
+	struct query_state
+	{
+		component_mask_t mask;
+		std::vector<std::uint32_t> indices;
+		/// the position in indices plus one of every entity slot, 0 if not in it
+		std::vector<std::uint32_t> positions;
+	};
+
+public:
+	/**
+	 * The entities that have all of the components, in a dense list that
+	 * assign, remove and destroy keep up to date instead of every iteration
+	 * finding them. Copies share the list of the entity_component_system.
+	 */
+	template <typename... Components>
+	class query
+	{
+	public:
+		query() = default;
+
+		/**
+		 * Call f for every entity of the list with its components as plain
+		 * references, as each does. Entities matching after f assigns a
+		 * component are not visited. f must not remove components of the
+		 * iterated types or destroy entities, the list would move under it.
+		 */
+		template <typename F>
+		void each(F&& f) const
+		{
+			if(state_)
+			{
+				manager_->each_query<Components...>(*state_, f, std::index_sequence_for<Components...>());
+			}
+		}
+
+		std::size_t size() const
+		{
+			return state_ ? state_->indices.size() : 0;
+		}
+
+		bool empty() const
+		{
+			return size() == 0;
+		}
+
+		explicit operator bool() const
+		{
+			return state_ != nullptr;
+		}
+
+	private:
+		friend class entity_component_system;
+
+		query(entity_component_system* manager, const query_state* state)
+			: manager_(manager)
+			, state_(state)
+		{
+		}
+
+		entity_component_system* manager_ = nullptr;
+		const query_state* state_ = nullptr;
+	};
+
 	/**
 	 * Number of managed entities.
 	 */
@@ -692,6 +983,14 @@ public:
 	 */
 	entity create();
 
+	/**
+	 * Create n entities at once. The entity arrays and the component pools
+	 * grow once for the whole batch instead of once per entity.
+	 *
+	 * Emits EntityCreatedEvent for each of them after all are created.
+	 */
+	std::vector<entity> create_many(std::size_t n);
+
 	/**
 	 * Destroy an existing entity::Id and its associated Components.
 	 *
@@ -699,6 +998,46 @@ public:
 	 */
 	void destroy(entity::id_t id);
 
+	/**
+	 * Destroy several entities. Invalid or repeated ones are skipped.
+	 *
+	 * Emits EntityDestroyedEvent for each of them.
+	 */
+	void destroy_many(const std::vector<entity>& entities);
+
+	/**
+	 * Make room for n entities in the entity arrays and the component pools.
+	 */
+	void reserve(std::size_t n);
+
+	/**
+	 * Drop the free entity slots after the last live entity and release the
+	 * memory the entity arrays, the pools and the component blocks hold past
+	 * what is in use. Live entities keep their ids so every handle stays
+	 * valid, slots created later start past the versions of the dropped ones.
+	 *
+	 * Must not be called while iterating.
+	 */
+	void compact();
+
+	/**
+	 * Compact from maybe_compact once the live entities fall below the given
+	 * fraction of the capacity. 0 disables it.
+	 */
+	void set_auto_compact(float occupancy_threshold);
+
+	/**
+	 * Compact if the automatic mode is on and enough entities were destroyed
+	 * since the last time. Call it where nothing iterates, e.g. at frame end.
+	 */
+	void maybe_compact();
+
+	/**
+	 * Measure the memory held by the entity arrays and by every component
+	 * type. Must not be called while iterating.
+	 */
+	memory_report get_memory_report() const;
+
 	entity get(entity::id_t id);
 
 	/**
@@ -721,11 +1060,32 @@ public:
 	chandle<C> assign(entity::id_t id, Args&&... args)
 	{
 		return std::static_pointer_cast<C>(
-			assign(id, std::make_shared<C>(std::forward<Args>(args)...)).lock());
+			assign(id, make_component<C>(std::forward<Args>(args)...)).lock());
 	}
 
 	chandle<component> assign(entity::id_t id, const std::shared_ptr<component>& comp);
 
+	/**
+	 * Assign a component to each of the entities, constructed from the same
+	 * arguments. The pool is grown once for the whole batch.
+	 *
+	 *     auto transforms = em.assign_many<Transform>(em.create_many(100));
+	 */
+	template <typename C, typename... Args>
+	std::vector<chandle<C>> assign_many(const std::vector<entity>& entities, const Args&... args)
+	{
+		auto& pool = accomodate_component<C>();
+		pool.reserve(pool.count() + entities.size());
+
+		std::vector<chandle<C>> components;
+		components.reserve(entities.size());
+		for(const auto& e : entities)
+		{
+			components.emplace_back(assign<C>(e.id(), args...));
+		}
+		return components;
+	}
+
 	/**
 	 * Remove a component from an entity::Id
 	 *
@@ -810,10 +1170,138 @@ public:
 		using type = T;
 	};
 
+	/**
+	 * Call f for every entity that has all of the components. The matching
+	 * entities are taken from the smallest pool up front, so f may create or
+	 * destroy entities and assign or remove components. The components are
+	 * locked for the duration of each call.
+	 */
 	template <typename... Components>
 	void for_each(typename identity<std::function<void(entity e, Components&...)>>::type f)
 	{
-		return entities_with_components<Components...>().for_each(f);
+		const std::array<component_storage*, sizeof...(Components)> pools = {{find_pool<Components>()...}};
+		if(std::find(std::begin(pools), std::end(pools), nullptr) != std::end(pools))
+		{
+			return;
+		}
+
+		const auto& driver = get_smallest_pool(pools);
+		const auto mask = component_mask<Components...>();
+		std::vector<entity::id_t> matching;
+		matching.reserve(driver.count());
+		for(std::size_t i = 0; i < driver.count(); ++i)
+		{
+			const auto index = driver.get_dense_entity(i);
+			if((entity_component_mask_[index] & mask) == mask)
+			{
+				matching.emplace_back(create_id(index));
+			}
+		}
+
+		for(const auto id : matching)
+		{
+			// an earlier call may have destroyed it or removed a component
+			if(valid(id) && (entity_component_mask_[id.index()] & mask) == mask)
+			{
+				f(entity(this, id), *(get_component<Components>(id).lock().get())...);
+			}
+		}
+	}
+
+	/**
+	 * Find the entities that have all of the given components and had at
+	 * least one of them written (touched or assigned) in the frames
+	 * [version, current frame). Passing the current frame each time as the
+	 * next version reports every change exactly once.
+	 *
+	 * @returns false if the change history doesn't reach back to version,
+	 * every entity should be considered changed then.
+	 */
+	template <typename... Components>
+	bool get_changed_since(std::uint64_t version, std::vector<entity>& changed)
+	{
+		return get_changed_since(version, component_mask<Components...>(), changed);
+	}
+
+	bool get_changed_since(std::uint64_t version, const component_mask_t& mask, std::vector<entity>& changed);
+
+	/**
+	 * for_each without the std::function and the handle locking. The pools
+	 * are resolved once and the components are passed as plain references,
+	 * so the callback can be inlined into the loop. Only the dense entities
+	 * of the smallest pool are walked, the other pools are probed, so the
+	 * cost follows the rarest component and not the entity capacity.
+	 *
+	 * Entities created by f are not visited. f must not remove components of
+	 * the iterated types or destroy entities, nothing keeps them alive.
+	 *
+	 * @code
+	 * ecs.each<Position, Velocity>([](entity e, Position& p, Velocity& v) {});
+	 * @endcode
+	 */
+	template <typename... Components, typename F>
+	void each(F&& f)
+	{
+		static_assert(sizeof...(Components) > 0, "At least one component type is required.");
+
+		const std::array<component_storage*, sizeof...(Components)> pools = {{find_pool<Components>()...}};
+		if(std::find(std::begin(pools), std::end(pools), nullptr) != std::end(pools))
+		{
+			return;
+		}
+
+		each_impl<Components...>(f, pools, std::index_sequence_for<Components...>());
+	}
+
+	/**
+	 * Parallel each. The dense entities of the smallest pool are split in
+	 * chunks of grain entities which are processed on the task system
+	 * workers, the calling thread helps until all of them are done.
+	 *
+	 * f is called concurrently so it must not create or destroy entities nor
+	 * assign or remove components.
+	 *
+	 * @code
+	 * ecs.par_for_each<Position, Velocity>(ts, [](entity e, Position& p, Velocity& v) {});
+	 * @endcode
+	 */
+	template <typename... Components, typename F>
+	void par_for_each(core::task_system& ts, F&& f, std::size_t grain = 256)
+	{
+		const std::array<component_storage*, sizeof...(Components)> pools = {{find_pool<Components>()...}};
+		if(std::find(std::begin(pools), std::end(pools), nullptr) != std::end(pools))
+		{
+			return;
+		}
+
+		const auto& driver = get_smallest_pool(pools);
+		const auto mask = component_mask<Components...>();
+		core::parallel_for(ts, std::size_t(0), driver.count(), grain, [&](std::size_t i) {
+			const auto index = driver.get_dense_entity(i);
+			if((entity_component_mask_[index] & mask) == mask)
+			{
+				f(entity(this, create_id(index)), get_component_ref<Components>(index)...);
+			}
+		});
+	}
+
+	/**
+	 * The query of the entities with all of the components. The queries of
+	 * the same components share one list, filled the first time one is asked
+	 * for and kept up to date from then on, so the same query run every
+	 * frame only visits the matching entities. Ask for them up front, e.g.
+	 * in the constructor of a system, never from the workers.
+	 *
+	 * @code
+	 * auto moving = ecs.get_query<Position, Velocity>();
+	 * moving.each([](entity e, Position& p, Velocity& v) {});
+	 * @endcode
+	 */
+	template <typename... Components>
+	query<Components...> get_query()
+	{
+		static_assert(sizeof...(Components) > 0, "At least one component type is required.");
+		return query<Components...>(this, &find_query(component_mask<Components...>()));
 	}
 
 	/**
@@ -837,7 +1325,8 @@ public:
 	}
 
 	/**
-	 * Iterate over all *valid* entities (ie. not in the free list). Not fast
+	 * Iterate over all *valid* entities (ie. not in the free list). Skips
+	 * the free slots 64 at a time through the alive mask.
 	 *
 	 * @code
 	 * for (entity entity : entity_manager.all_entities()) {}
@@ -880,11 +1369,35 @@ public:
 	 */
 	void dispose();
 
-	void set_entity_name(entity::id_t id, const std::string& name);
-	const std::string& get_entity_name(entity::id_t id);
+	void set_entity_name(entity::id_t id, const entity_name& name);
+	const std::string& get_entity_name(entity::id_t id) const;
+	const entity_name& get_entity_interned_name(entity::id_t id) const;
+
+	/**
+	 * The entities of the name, from the index of the names, in no order.
+	 */
+	void find_entities_named(const entity_name& name, std::vector<entity>& entities);
+
+	/**
+	 * The names at least an entity has, each once, in no order.
+	 */
+	void get_entity_names(std::vector<entity_name>& names) const;
+
+	/**
+	 * Incremented each time an entity is named, for the caches of the names.
+	 */
+	std::uint64_t get_names_version() const
+	{
+		return names_version_;
+	}
 
 private:
 	friend class entity;
+	friend class component;
+
+	void mark_changed(entity::id_t id, rtti::type_index_sequential_t::index_t family);
+	// Takes the slot out of the list of its name and leaves it unnamed.
+	void unlink_name(std::uint32_t index);
 
 	inline void assert_valid(entity::id_t id) const
 	{
@@ -930,12 +1443,128 @@ private:
 		return component_mask<C1, Components...>();
 	}
 
+	template <typename C>
+	component_storage* find_pool() const
+	{
+		const auto family = rtti::type_index_sequential_t::id<component, C>();
+		return family < component_pools_.size() ? component_pools_[family].get() : nullptr;
+	}
+
+	template <typename... Components, typename F, std::size_t... Is>
+	void each_impl(F& f, const std::array<component_storage*, sizeof...(Components)>& pools,
+				   std::index_sequence<Is...> /*unused*/)
+	{
+		const auto& driver = get_smallest_pool(pools);
+		const auto mask = component_mask<Components...>();
+		// components assigned by f are appended, the first count entries stay put
+		const auto count = driver.count();
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			const auto index = driver.get_dense_entity(i);
+			if((entity_component_mask_[index] & mask) == mask)
+			{
+				f(entity(this, create_id(index)), static_cast<Components&>(*pools[Is]->get_ptr(index))...);
+			}
+		}
+	}
+
+	template <typename... Components, typename F, std::size_t... Is>
+	void each_query(const query_state& state, F& f, std::index_sequence<Is...> /*unused*/)
+	{
+		// the entities listed have the components, so their pools exist
+		const auto count = state.indices.size();
+		if(count == 0)
+		{
+			return;
+		}
+
+		const std::array<component_storage*, sizeof...(Components)> pools = {{find_pool<Components>()...}};
+		for(std::size_t i = 0; i < count; ++i)
+		{
+			const auto index = state.indices[i];
+			f(entity(this, create_id(index)), static_cast<Components&>(*pools[Is]->get_ptr(index))...);
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : find_query ()
+	/// <summary>
+	/// The list of the mask, made and filled from the live entities if no
+	/// query asked for it yet.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const query_state& find_query(const component_mask_t& mask);
+
+	//-----------------------------------------------------------------------------
+	//  Name : update_queries ()
+	/// <summary>
+	/// Adds the entity to the lists it matches with its new mask and removes
+	/// it from those it no longer does.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void update_queries(std::uint32_t index, const component_mask_t& before, const component_mask_t& after);
+
+	template <std::size_t N>
+	static const component_storage& get_smallest_pool(const std::array<component_storage*, N>& pools)
+	{
+		return **std::min_element(std::begin(pools), std::end(pools),
+								  [](const component_storage* lhs, const component_storage* rhs) {
+									  return lhs->count() < rhs->count();
+								  });
+	}
+
+	template <typename C>
+	inline C& get_component_ref(std::uint32_t index) const
+	{
+		const auto family = rtti::type_index_sequential_t::id<component, C>();
+		return static_cast<C&>(*component_pools_[family]->get_ptr(index));
+	}
+
+	inline void set_alive(std::uint32_t index, bool alive)
+	{
+		auto& word = alive_mask_[index / 64];
+		const auto bit = std::uint64_t(1) << (index % 64);
+		word = alive ? (word | bit) : (word & ~bit);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : find_alive ()
+	/// <summary>
+	/// Returns the first alive entity index in [from, end) or end if none.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint32_t find_alive(std::uint32_t from, std::size_t end) const
+	{
+		std::size_t i = from;
+		while(i < end)
+		{
+			auto word = alive_mask_[i / 64] >> (i % 64);
+			if(word == 0)
+			{
+				// rest of the word is free
+				i = (i / 64 + 1) * 64;
+				continue;
+			}
+
+			while((word & 1) == 0)
+			{
+				word >>= 1;
+				++i;
+			}
+			break;
+		}
+		return static_cast<std::uint32_t>(std::min(i, end));
+	}
+
 	inline void accomodate_entity(std::uint32_t index)
 	{
 		if(entity_component_mask_.size() <= index)
 		{
 			entity_component_mask_.resize(index + 1);
 			entity_version_.resize(index + 1);
+			entity_names_.resize(index + 1);
+			name_positions_.resize(index + 1);
+			alive_mask_.resize(index / 64 + 1);
 			for(auto& pool : component_pools_)
 			{
 				if(pool)
@@ -971,6 +1600,11 @@ private:
 	}
 
 	std::uint32_t index_counter_ = 0;
+	/// version of new entity slots, past the versions of compacted ones.
+	std::uint32_t first_version_ = 1;
+	/// occupancy below which maybe_compact compacts, 0 when disabled.
+	float auto_compact_threshold_ = 0.0f;
+	std::size_t destroyed_since_compact_ = 0;
 
 	// Each element in component_pools_ corresponds to a Pool for a component.
 	// The index into the vector is the component::family().
@@ -983,8 +1617,19 @@ private:
 	std::vector<std::uint32_t> entity_version_;
 	// List of available entity slots.
 	std::vector<std::uint32_t> free_list_;
-
-	std::unordered_map<std::uint64_t, std::string> entity_names_;
+	// One bit per entity slot, set while the slot holds a live entity.
+	std::vector<std::uint64_t> alive_mask_;
+
+	// The name of each entity slot, empty for the unnamed and free ones.
+	std::vector<entity_name> entity_names_;
+	// The slots of each name in use, and where each slot is in the list of
+	// its name, so that renaming and destroying remove it in constant time.
+	std::unordered_map<entity_name, std::vector<std::uint32_t>, entity_name::hasher> named_entities_;
+	std::vector<std::uint32_t> name_positions_;
+	std::uint64_t names_version_ = 0;
+	// The lists of the queries, never released so that the queries handed
+	// out stay valid.
+	std::vector<std::unique_ptr<query_state>> queries_;
 };
 
 template <typename C, typename... Args>
@@ -0,0 +1,60 @@
+#include "entity_name.h"
+
+#include <mutex>
+#include <unordered_set>
+
+namespace runtime
+{
+namespace
+{
+/*
+ * The nodes of the set do not move, the names point into them.
+ */
+struct name_pool
+{
+	std::unordered_set<std::string> names;
+	std::mutex mutex;
+};
+
+name_pool& get_pool()
+{
+	static name_pool pool;
+	return pool;
+}
+
+const std::string& get_empty()
+{
+	static const std::string empty;
+	return empty;
+}
+}
+
+entity_name::entity_name(const std::string& name)
+{
+	if(name.empty())
+	{
+		return;
+	}
+
+	auto& pool = get_pool();
+	std::lock_guard<std::mutex> lock(pool.mutex);
+	entry_ = &*pool.names.insert(name).first;
+}
+
+entity_name::entity_name(const char* name)
+	: entity_name(std::string(name ? name : ""))
+{
+}
+
+const std::string& entity_name::str() const
+{
+	return entry_ ? *entry_ : get_empty();
+}
+
+std::size_t entity_name::get_pool_size()
+{
+	auto& pool = get_pool();
+	std::lock_guard<std::mutex> lock(pool.mutex);
+	return pool.names.size();
+}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace runtime
+{
+/*
+ * entity_name; the name of an entity interned once, it is the pointer to the
+ * one copy of the name in a pool that is never emptied.
+ *
+ *      Entities of the same name share the copy, naming, cloning and
+ *      destroying them copies a pointer and allocates nothing once the name
+ *      is in the pool. The pool is apart from that of the asset keys, the
+ *      names of the entities are many and short lived.
+ */
+class entity_name
+{
+public:
+	struct hasher
+	{
+		std::size_t operator()(const entity_name& name) const
+		{
+			return std::hash<const void*>()(name.entry_);
+		}
+	};
+
+	entity_name() = default;
+
+	//-----------------------------------------------------------------------------
+	//  Name : entity_name ()
+	/// <summary>
+	/// Interns the name, an empty name is the empty one. Safe to call from
+	/// any thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	entity_name(const std::string& name);
+	entity_name(const char* name);
+
+	const std::string& str() const;
+
+	operator const std::string&() const
+	{
+		return str();
+	}
+
+	bool empty() const
+	{
+		return entry_ == nullptr;
+	}
+
+	void clear()
+	{
+		entry_ = nullptr;
+	}
+
+	bool operator==(const entity_name& rhs) const
+	{
+		return entry_ == rhs.entry_;
+	}
+
+	bool operator!=(const entity_name& rhs) const
+	{
+		return entry_ != rhs.entry_;
+	}
+
+	/// the names in the pool, with those no entity has anymore
+	static std::size_t get_pool_size();
+
+private:
+	/// the name in the pool
+	const std::string* entry_ = nullptr;
+};
+}
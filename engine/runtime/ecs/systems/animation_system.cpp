@@ -0,0 +1,121 @@
+#include "animation_system.h"
+#include "bounds_system.h"
+#include "system_scheduler.h"
+#include "../components/light_component.h"
+#include "../components/model_component.h"
+#include "../components/transform_component.h"
+
+#include <core/system/subsystem.h>
+#include <core/tasks/task_group.h>
+#include <core/tasks/task_system.h>
+
+namespace runtime
+{
+namespace
+{
+/// the entities a worker samples at once, a skeleton is a few dozen nodes
+constexpr std::size_t animation_grain = 16;
+}
+
+void animation_system::frame_update(delta_t dt)
+{
+	auto& ecs = core::get_subsystem<entity_component_system>();
+	auto& ts = core::get_subsystem<core::task_system>();
+
+	// binding the pose may reparent node entities of a loaded scene
+	jobs_.clear();
+	ecs.each<animation_component, model_component>(
+		[this](entity e, animation_component& anim, model_component& model) {
+			if(model.bind_pose() && anim.is_playing())
+			{
+				jobs_.push_back({&anim, &model, get_lod(e, model)});
+			}
+		});
+
+	core::parallel_for(ts, std::size_t(0), jobs_.size(), animation_grain, [this, dt](std::size_t i) {
+		auto& j = jobs_[i];
+		if(j.anim->update(dt, j.lod, *j.model->get_skeleton(), j.model->get_local_pose()))
+		{
+			j.model->set_pose_changed();
+		}
+	});
+}
+
+animation_lod animation_system::get_lod(const entity& e, const model_component& model)
+{
+	// drawn by the renderer in the last frame, all at full rate without one
+	if(!core::has_subsystems<bounds_system>())
+	{
+		return {};
+	}
+
+	auto& bounds = core::get_subsystem<bounds_system>();
+	const auto entry = bounds.find(e);
+	if(entry == bounds_system::no_entry)
+	{
+		return {};
+	}
+
+	// the models not drawn yet are shown right when they are
+	const auto& presence = bounds.get_on_screen(entry);
+	if(presence.frame == ~std::uint64_t(0))
+	{
+		return {};
+	}
+
+	animation_lod lod;
+	if(ecs::get_frame() - presence.frame <= 1)
+	{
+		lod.interval = rates_.empty() ? 1 : rates_.back().interval;
+		for(const auto& rate : rates_)
+		{
+			if(presence.percent >= rate.percent)
+			{
+				lod.interval = rate.interval;
+				break;
+			}
+		}
+		lod.nodes = &model.get_lod_nodes(presence.lod);
+		return lod;
+	}
+
+	// not drawn, only a shadow of it may be. The directional lights have no
+	// shadow maps yet, only the ranges of the others are looked at.
+	lod.interval = 0;
+	const auto spheres = bounds.get_spheres();
+	const math::vec3 center(spheres.center_x[entry], spheres.center_y[entry], spheres.center_z[entry]);
+	bounds.query_lights(center, spheres.radius[entry], lights_);
+	for(const auto light : lights_)
+	{
+		if(bounds.get_light(light)->get_light().type != light_type::directional)
+		{
+			lod.interval = rates_.empty() ? 1 : rates_.back().interval;
+			break;
+		}
+	}
+	return lod;
+}
+
+void animation_system::set_update_rates(const std::vector<update_rate>& rates)
+{
+	rates_ = rates;
+}
+
+const std::vector<animation_system::update_rate>& animation_system::get_update_rates() const
+{
+	return rates_;
+}
+
+animation_system::animation_system()
+{
+	system_access access;
+	access.write<animation_component, model_component, transform_component>();
+	core::get_subsystem<system_scheduler>().add_system(this, &animation_system::frame_update, access,
+														"animation_system");
+}
+
+animation_system::~animation_system()
+{
+	core::get_subsystem<system_scheduler>().remove_system(this);
+}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "../components/animation_component.h"
+
+#include <core/common/basetypes.hpp>
+
+#include <cstddef>
+#include <vector>
+
+class model_component;
+
+namespace runtime
+{
+/*
+ * animation_system; plays the animations of the entities.
+ *
+ *      The entities are updated in parallel on the task system, each
+ *      component samples its clips with the cursors it keeps per channel
+ *      and only writes the local pose of the skeleton of its own model. Runs
+ *      before the bone system brings the poses to the world.
+ *
+ *      How often an animation is sampled follows how large its model was
+ *      drawn in the last frame, the pose is interpolated in between. The
+ *      nodes the skin of the drawn lod doesn't move aren't sampled. A model
+ *      not drawn is only sampled, at the slowest rate, while it is in the
+ *      range of a point or spot light it may cast a shadow from, otherwise
+ *      only its time goes on.
+ */
+class animation_system
+{
+public:
+	animation_system();
+	~animation_system();
+	//-----------------------------------------------------------------------------
+	//  Name : frame_update (virtual )
+	/// <summary>
+	/// Picks the lod of every animation, then updates them in parallel.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void frame_update(delta_t dt);
+
+	/// the frames between the samples of a model at least percent of the
+	/// height of the screen, from the largest
+	struct update_rate
+	{
+		float percent = 0.0f;
+		std::uint32_t interval = 1;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_update_rates ()
+	/// <summary>
+	/// Sets the rates by the size on screen, sorted from the largest. Smaller
+	/// models than the last are sampled at its rate.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_update_rates(const std::vector<update_rate>& rates);
+	const std::vector<update_rate>& get_update_rates() const;
+
+private:
+	struct job
+	{
+		animation_component* anim = nullptr;
+		model_component* model = nullptr;
+		animation_lod lod;
+	};
+
+	animation_lod get_lod(const entity& e, const model_component& model);
+
+	std::vector<update_rate> rates_ = {{20.0f, 1}, {8.0f, 2}, {3.0f, 4}, {0.0f, 8}};
+	/// the animations updated in the frame, kept for the capacity
+	std::vector<job> jobs_;
+	std::vector<std::size_t> lights_;
+};
+}
@@ -1,34 +1,198 @@
 #include "audio_system.h"
-#include "../../system/events.h"
+#include "system_scheduler.h"
 #include "../components/audio_listener_component.h"
 #include "../components/audio_source_component.h"
 #include "../components/transform_component.h"
 
+#include <core/audio/device.h>
+#include <core/audio/exception.h>
+#include <core/audio/source.h>
+#include <core/logging/logging.h>
+#include <core/profiling/memory_tracker.h>
 #include <core/system/subsystem.h>
+#include <core/tasks/task_group.h>
+#include <core/tasks/task_system.h>
+
+#include <algorithm>
 
 namespace runtime
 {
+namespace
+{
+/// the sources a worker places at once, each is a few vector operations
+constexpr std::size_t placement_grain = 64;
+}
+
 void audio_system::frame_update(delta_t dt)
 {
+	core::scoped_memory_tag alloc_tag(core::memory_tag::audio);
 	auto& ecs = core::get_subsystem<entity_component_system>();
+	auto& device = core::get_subsystem<audio::device>();
+	const auto frame = static_cast<std::uint32_t>(ecs::get_frame());
 
-	ecs.for_each<transform_component, audio_source_component>(
-		[](entity e, transform_component& transform, audio_source_component& source) {
-			source.update(transform.get_transform());
+	// the listener calls of the frame are applied at once
+	device.suspend_updates();
+	math::vec3 listener_position(0.0f, 0.0f, 0.0f);
+	ecs.each<transform_component, audio_listener_component>(
+		[&listener_position, dt, frame](entity e, transform_component& transform,
+										audio_listener_component& listener) {
+			// touched in the frame it was placed in it may have moved after
+			if(listener.is_placed() && transform.get_last_touched() < listener.get_placed_frame())
+			{
+				listener.settle();
+			}
+			else
+			{
+				listener.update(transform.get_transform(), dt, frame);
+			}
+			listener_position = transform.get_transform().get_position();
 		});
-	ecs.for_each<transform_component, audio_listener_component>(
-		[](entity e, transform_component& transform, audio_listener_component& listener) {
-			listener.update(transform.get_transform());
+	device.process_updates();
+
+	// The world transforms are resolved here, they may walk up the parents,
+	// only the sources whose transform was touched since they were placed
+	// are placed again.
+	placements_.clear();
+	ecs.each<transform_component, audio_source_component>(
+		[this](entity e, transform_component& transform, audio_source_component& source) {
+			placement p;
+			p.source = &source;
+			if(!source.is_placed() || transform.get_last_touched() >= source.get_placed_frame())
+			{
+				p.world = &transform.get_transform();
+			}
+			placements_.push_back(p);
 		});
+
+	auto& ts = core::get_subsystem<core::task_system>();
+	core::parallel_for(ts, std::size_t(0), placements_.size(), placement_grain,
+					   [this, dt, frame](std::size_t i) {
+						   auto& p = placements_[i];
+						   if(p.world)
+						   {
+							   p.source->place(*p.world, dt, frame);
+						   }
+						   else
+						   {
+							   p.source->settle();
+						   }
+					   });
+
+	// the voices queue their calls to the audio thread from this one only,
+	// advancing a source may stop it so it is ranked after
+	candidates_.clear();
+	for(const auto& p : placements_)
+	{
+		auto& source = *p.source;
+		source.apply_placement();
+		source.advance(dt);
+
+		candidate c;
+		c.source = &source;
+		c.priority = source.get_priority();
+		c.audibility = source.get_audibility(listener_position);
+		if(c.audibility > 0.0f)
+		{
+			candidates_.push_back(c);
+		}
+		else
+		{
+			// stopped, paused or out of range
+			source.set_voice(nullptr);
+		}
+	}
+
+	const auto heard = std::min(candidates_.size(), max_voices_);
+	std::partial_sort(std::begin(candidates_), std::begin(candidates_) + std::ptrdiff_t(heard),
+					  std::end(candidates_), [](const candidate& lhs, const candidate& rhs) {
+						  if(lhs.priority != rhs.priority)
+						  {
+							  return lhs.priority < rhs.priority;
+						  }
+						  return lhs.audibility > rhs.audibility;
+					  });
+
+	// the voices of the virtual ones first, so that the heard ones can take them
+	for(auto it = std::begin(candidates_) + std::ptrdiff_t(heard); it != std::end(candidates_); ++it)
+	{
+		it->source->set_voice(nullptr);
+	}
+	for(auto it = std::begin(candidates_); it != std::begin(candidates_) + std::ptrdiff_t(heard); ++it)
+	{
+		if(it->source->is_virtual())
+		{
+			auto voice = get_free_voice();
+			if(!voice)
+			{
+				break;
+			}
+			it->source->set_voice(std::move(voice));
+		}
+	}
+
+	// the changes of the frame are applied by the audio thread
+	device.submit();
+}
+
+void audio_system::set_max_voices(std::size_t count)
+{
+	max_voices_ = count;
+
+	// the busy ones are released by the next update
+	voices_.erase(std::remove_if(std::begin(voices_), std::end(voices_),
+								 [](const auto& voice) { return voice.use_count() == 1; }),
+				  std::end(voices_));
+}
+
+std::size_t audio_system::get_max_voices() const
+{
+	return max_voices_;
+}
+
+std::shared_ptr<audio::source> audio_system::get_free_voice()
+{
+	auto it = std::find_if(std::begin(voices_), std::end(voices_),
+						   [](const auto& voice) { return voice.use_count() == 1; });
+	if(it != std::end(voices_))
+	{
+		return *it;
+	}
+
+	if(voices_.size() >= max_voices_)
+	{
+		return nullptr;
+	}
+
+	try
+	{
+		auto voice = std::make_shared<audio::source>();
+		voice->set_deferred(true);
+		voices_.push_back(std::move(voice));
+	}
+	catch(const audio::exception& e)
+	{
+		// the device has no more sources
+		APPLOG_WARNING("Audio voices limited to {0} : {1}", voices_.size(), e.what());
+		max_voices_ = voices_.size();
+		return nullptr;
+	}
+	return voices_.back();
 }
 
 audio_system::audio_system()
 {
-	on_frame_update.connect(this, &audio_system::frame_update);
+	// get_transform resolves the world transform lazily, so it counts as a write.
+	system_access access;
+	access.write<transform_component, audio_source_component, audio_listener_component>();
+	// the sources move between the updates by less than is heard
+	system_schedule schedule;
+	schedule.at_rate(30.0f);
+	core::get_subsystem<system_scheduler>().add_system(this, &audio_system::frame_update, access,
+														"audio_system", schedule);
 }
 
 audio_system::~audio_system()
 {
-	on_frame_update.disconnect(this, &audio_system::frame_update);
+	core::get_subsystem<system_scheduler>().remove_system(this);
 }
 }
@@ -1,9 +1,34 @@
 #pragma once
 
 #include <core/common/basetypes.hpp>
+#include <core/math/math_includes.h>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace audio
+{
+class source;
+}
+
+class audio_source_component;
 
 namespace runtime
 {
+/*
+ * audio_system; updates the listeners and the sources and gives out the
+ * voices.
+ *
+ *      Only the most audible playing sources are heard through one of a pool
+ *      of voices, ranked by their priority then by how loud they are at the
+ *      listener. The others play virtually, their offsets keep moving, and
+ *      they get a voice back from where they are once they rank high enough.
+ *      The parameters of the voices are queued to the audio thread of the
+ *      device, which applies the changes of a frame at once. Only the
+ *      sources whose transform was touched are placed again, on the workers,
+ *      with the velocity they moved at.
+ */
 class audio_system
 {
 public:
@@ -18,5 +43,40 @@ public:
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void frame_update(delta_t dt);
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_max_voices ()
+	/// <summary>
+	/// Sets how many sources are heard at once.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_max_voices(std::size_t count);
+	std::size_t get_max_voices() const;
+
+private:
+	struct candidate
+	{
+		audio_source_component* source = nullptr;
+		int priority = 0;
+		float audibility = 0.0f;
+	};
+
+	struct placement
+	{
+		audio_source_component* source = nullptr;
+		/// null when the source did not move
+		const math::transform* world = nullptr;
+	};
+
+	std::shared_ptr<audio::source> get_free_voice();
+
+	/// how many voices there can be, lowered when the device gives no more
+	std::size_t max_voices_ = 32;
+	/// every voice, the free ones are not held by a source
+	std::vector<std::shared_ptr<audio::source>> voices_;
+	/// the playing sources of the frame, kept for the memory
+	std::vector<candidate> candidates_;
+	/// the sources of the frame, kept for the memory
+	std::vector<placement> placements_;
 };
 }
@@ -1,6 +1,11 @@
 #pragma once
 
 #include <core/common/basetypes.hpp>
+#include <core/math/math_includes.h>
+
+#include <vector>
+
+class model_component;
 
 namespace runtime
 {
@@ -12,11 +17,20 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : frame_update (virtual )
 	/// <summary>
-	///
-	///
-	///
+	/// Brings the poses of the skinned models to the world, the skeletons in
+	/// parallel once the world transforms of the models are resolved.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void frame_update(delta_t dt);
+
+private:
+	struct posed_model
+	{
+		model_component* model = nullptr;
+		math::transform world;
+	};
+
+	/// the models posed in the frame, kept for the capacity
+	std::vector<posed_model> posed_;
 };
 }
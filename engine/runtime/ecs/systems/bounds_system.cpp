@@ -0,0 +1,553 @@
+#include "bounds_system.h"
+#include "../../rendering/mesh.h"
+#include "../../rendering/model.h"
+#include "../components/light_component.h"
+#include "../components/model_component.h"
+#include "../components/transform_component.h"
+
+#include <core/system/subsystem.h>
+
+#include <algorithm>
+
+namespace runtime
+{
+
+bounds_system::bounds_system()
+{
+	auto& ecs = core::get_subsystem<entity_component_system>();
+	models_query_ = ecs.get_query<transform_component, model_component>();
+	lights_query_ = ecs.get_query<transform_component, light_component>();
+}
+
+void bounds_system::refresh()
+{
+	const auto frame = static_cast<std::uint32_t>(ecs::get_frame());
+	++epoch_;
+	refresh_models(frame);
+	refresh_lights(frame);
+}
+
+void bounds_system::refresh_models(std::uint32_t frame)
+{
+	bool changed = false;
+	models_query_.each(
+		[&](entity e, transform_component& transform_comp, model_component& model_comp) {
+			// If mesh isnt loaded yet skip it, the entry is dropped below.
+			const auto& model = model_comp.get_model();
+			if(!model.is_valid())
+				return;
+
+			auto mesh = model.get_lod(0);
+			if(!mesh)
+				return;
+
+			const auto index = e.id().index();
+			if(index >= slots_.size())
+			{
+				slots_.resize(index + 1, invalid_slot);
+			}
+
+			// the slot may still hold a destroyed entity with the same index
+			std::size_t i = slots_[index];
+			const bool is_new = i == invalid_slot || entities_[i] != e;
+			if(is_new)
+			{
+				if(i != invalid_slot)
+				{
+					remove_entry(i);
+				}
+				i = add_entry(e);
+			}
+
+			seen_[i] = epoch_;
+			transforms_[i] = &transform_comp;
+			models_[i] = &model_comp;
+
+			// touched in the frame it was computed in it may have changed after
+			const auto computed = computed_[i];
+			if(!is_new && transform_comp.get_last_touched() < computed &&
+			   model_comp.get_last_touched() < computed)
+			{
+				return;
+			}
+
+			update_entry(i, mesh->get_bounds(), transform_comp.get_transform(), model_comp.get_layers());
+			computed_[i] = frame;
+			changed = true;
+		});
+
+	for(std::size_t i = entities_.size(); i > 0; --i)
+	{
+		if(seen_[i - 1] != epoch_)
+		{
+			remove_entry(i - 1);
+			changed = true;
+		}
+	}
+
+	if(changed)
+	{
+		++version_;
+	}
+}
+
+void bounds_system::refresh_lights(std::uint32_t frame)
+{
+	lights_query_.each(
+		[&](entity e, transform_component& transform_comp, light_component& light_comp) {
+			const auto index = e.id().index();
+			if(index >= light_slots_.size())
+			{
+				light_slots_.resize(index + 1, invalid_slot);
+			}
+
+			std::size_t i = light_slots_[index];
+			const bool is_new = i == invalid_slot || lights_[i].e != e;
+			if(is_new)
+			{
+				if(i != invalid_slot)
+				{
+					remove_light(i);
+				}
+				i = lights_.size();
+				light_slots_[index] = static_cast<std::uint32_t>(i);
+				lights_.emplace_back();
+				lights_[i].e = e;
+			}
+
+			auto& entry = lights_[i];
+			entry.seen = epoch_;
+			entry.transform = &transform_comp;
+			entry.light = &light_comp;
+
+			if(!is_new && transform_comp.get_last_touched() < entry.computed &&
+			   light_comp.get_last_touched() < entry.computed)
+			{
+				return;
+			}
+
+			update_light(entry);
+			entry.computed = frame;
+		});
+
+	for(std::size_t i = lights_.size(); i > 0; --i)
+	{
+		if(lights_[i - 1].seen != epoch_)
+		{
+			remove_light(i - 1);
+		}
+	}
+}
+
+void bounds_system::cull(const math::frustum& frustum, std::vector<std::uint64_t>& visible,
+						 cull_cache* cache, layer_mask mask) const
+{
+	visible.assign(math::get_visibility_words(size()), 0);
+	if(cache)
+	{
+		cache->entries.resize(size(), -1);
+	}
+
+	const auto set_visible = [&visible](std::size_t i) { visible[i / 64] |= std::uint64_t(1) << (i % 64); };
+	tree_.query(frustum,
+				[&](std::uint32_t i, unsigned int inside_bits) {
+					if(inside_bits == math::bvh::all_planes)
+					{
+						set_visible(i);
+						return;
+					}
+
+					// the leaf box is grown, test the entry itself on the planes left
+					int last_outside = cache ? cache->entries[i] : -1;
+					const auto result = frustum.classify_aabb(get_bounds(i), inside_bits, last_outside);
+					if(cache)
+					{
+						cache->entries[i] = std::int8_t(last_outside);
+					}
+
+					if(result != math::volume_query::outside)
+					{
+						set_visible(i);
+					}
+				},
+				cache ? &cache->nodes : nullptr, mask);
+}
+
+void bounds_system::cull_views(const math::frustum* frustums, std::size_t count,
+							   std::vector<view_hit>& hits, layer_mask mask) const
+{
+	hits.clear();
+	count = std::min(count, math::bvh::max_views);
+	tree_.query(frustums, count, [&](std::uint32_t i, std::uint32_t inside_views, std::uint32_t partial_views,
+									 const std::uint8_t* inside_bits) {
+		// the leaf box is grown, test the entry itself on the views it intersects
+		auto views = inside_views;
+		const auto box = get_bounds(i);
+		for(std::size_t v = 0; v < count; ++v)
+		{
+			if((partial_views & (1u << v)) == 0)
+			{
+				continue;
+			}
+
+			unsigned int bits = inside_bits[v];
+			int last_outside = -1;
+			if(frustums[v].classify_aabb(box, bits, last_outside) != math::volume_query::outside)
+			{
+				views |= 1u << v;
+			}
+		}
+
+		if(views != 0)
+		{
+			view_hit hit;
+			hit.entry = i;
+			hit.views = views;
+			hits.push_back(hit);
+		}
+	}, mask);
+}
+
+void bounds_system::query_sphere(const math::vec3& center, float radius,
+								 std::vector<std::size_t>& entries, layer_mask mask) const
+{
+	entries.clear();
+	const auto radius_sq = radius * radius;
+	tree_.query(center, radius, [&](std::uint32_t i) {
+		const auto offset = get_bounds(i).closest_point(center) - center;
+		if(math::dot(offset, offset) <= radius_sq)
+		{
+			entries.push_back(i);
+		}
+	}, mask);
+}
+
+void bounds_system::raycast(const math::vec3& origin, const math::vec3& direction, float max_distance,
+							std::vector<ray_hit>& hits) const
+{
+	hits.clear();
+	const auto segment = direction * max_distance;
+	tree_.raycast(origin, direction, max_distance, [&](std::uint32_t i, float) {
+		float t = 0.0f;
+		if(get_bounds(i).intersect(origin, segment, t, true))
+		{
+			ray_hit hit;
+			hit.entry = i;
+			hit.distance = t * max_distance;
+			hits.push_back(hit);
+		}
+	});
+
+	std::sort(std::begin(hits), std::end(hits),
+			  [](const ray_hit& lhs, const ray_hit& rhs) { return lhs.distance < rhs.distance; });
+}
+
+void bounds_system::cull_lights(const math::frustum& frustum, std::vector<std::size_t>& lights,
+								layer_mask mask) const
+{
+	lights.clear();
+	light_tree_.query(frustum, [&](std::uint32_t i, unsigned int inside_bits) {
+		const auto& entry = lights_[i];
+		if(inside_bits == math::bvh::all_planes || frustum.test_sphere(entry.center, entry.radius))
+		{
+			lights.push_back(i);
+		}
+	}, nullptr, mask);
+
+	if(directional_count_ > 0)
+	{
+		for(std::size_t i = 0; i < lights_.size(); ++i)
+		{
+			if(lights_[i].is_directional && (lights_[i].layers & mask) != 0)
+			{
+				lights.push_back(i);
+			}
+		}
+	}
+
+	// the entities in the order they were iterated before the tree
+	std::sort(std::begin(lights), std::end(lights));
+}
+
+void bounds_system::query_lights(const math::vec3& center, float radius,
+								 std::vector<std::size_t>& lights, layer_mask mask) const
+{
+	lights.clear();
+	light_tree_.query(center, radius, [&](std::uint32_t i) {
+		const auto& entry = lights_[i];
+		const auto reach = entry.radius + radius;
+		if(math::length2(entry.center - center) <= reach * reach)
+		{
+			lights.push_back(i);
+		}
+	}, mask);
+
+	if(directional_count_ > 0)
+	{
+		for(std::size_t i = 0; i < lights_.size(); ++i)
+		{
+			if(lights_[i].is_directional && (lights_[i].layers & mask) != 0)
+			{
+				lights.push_back(i);
+			}
+		}
+	}
+	std::sort(std::begin(lights), std::end(lights));
+}
+
+math::aabb_soa bounds_system::get_aabbs() const
+{
+	math::aabb_soa boxes;
+	boxes.center_x = center_x_.data();
+	boxes.center_y = center_y_.data();
+	boxes.center_z = center_z_.data();
+	boxes.extent_x = extent_x_.data();
+	boxes.extent_y = extent_y_.data();
+	boxes.extent_z = extent_z_.data();
+	boxes.count = size();
+	return boxes;
+}
+
+void bounds_system::set_on_screen(std::size_t i, float percent, std::uint32_t lod, std::uint64_t frame)
+{
+	auto& presence = presence_[i];
+	if(presence.frame != frame)
+	{
+		presence.percent = percent;
+		presence.lod = lod;
+		presence.frame = frame;
+		return;
+	}
+
+	presence.percent = std::max(presence.percent, percent);
+	presence.lod = std::min(presence.lod, lod);
+}
+
+math::sphere_soa bounds_system::get_spheres() const
+{
+	math::sphere_soa spheres;
+	spheres.center_x = center_x_.data();
+	spheres.center_y = center_y_.data();
+	spheres.center_z = center_z_.data();
+	spheres.radius = radius_.data();
+	spheres.count = size();
+	return spheres;
+}
+
+std::size_t bounds_system::add_entry(entity e)
+{
+	const auto i = entities_.size();
+	slots_[e.id().index()] = static_cast<std::uint32_t>(i);
+	entities_.push_back(e);
+	transforms_.push_back(nullptr);
+	models_.push_back(nullptr);
+	computed_.push_back(0);
+	seen_.push_back(0);
+	center_x_.push_back(0.0f);
+	center_y_.push_back(0.0f);
+	center_z_.push_back(0.0f);
+	extent_x_.push_back(0.0f);
+	extent_y_.push_back(0.0f);
+	extent_z_.push_back(0.0f);
+	radius_.push_back(0.0f);
+	presence_.emplace_back();
+	layers_.push_back(layers::default_layer);
+	proxies_.push_back(math::bvh::null_node);
+	return i;
+}
+
+void bounds_system::remove_entry(std::size_t i)
+{
+	const auto last = entities_.size() - 1;
+	const auto index = entities_[i].id().index();
+	if(slots_[index] == i)
+	{
+		slots_[index] = invalid_slot;
+	}
+
+	if(proxies_[i] != math::bvh::null_node)
+	{
+		tree_.remove(proxies_[i]);
+	}
+
+	if(i != last)
+	{
+		entities_[i] = entities_[last];
+		transforms_[i] = transforms_[last];
+		models_[i] = models_[last];
+		computed_[i] = computed_[last];
+		seen_[i] = seen_[last];
+		center_x_[i] = center_x_[last];
+		center_y_[i] = center_y_[last];
+		center_z_[i] = center_z_[last];
+		extent_x_[i] = extent_x_[last];
+		extent_y_[i] = extent_y_[last];
+		extent_z_[i] = extent_z_[last];
+		radius_[i] = radius_[last];
+		presence_[i] = presence_[last];
+		layers_[i] = layers_[last];
+		proxies_[i] = proxies_[last];
+		slots_[entities_[i].id().index()] = static_cast<std::uint32_t>(i);
+		if(proxies_[i] != math::bvh::null_node)
+		{
+			tree_.set_user_data(proxies_[i], static_cast<std::uint32_t>(i));
+		}
+	}
+
+	entities_.pop_back();
+	transforms_.pop_back();
+	models_.pop_back();
+	computed_.pop_back();
+	seen_.pop_back();
+	center_x_.pop_back();
+	center_y_.pop_back();
+	center_z_.pop_back();
+	extent_x_.pop_back();
+	extent_y_.pop_back();
+	extent_z_.pop_back();
+	radius_.pop_back();
+	presence_.pop_back();
+	layers_.pop_back();
+	proxies_.pop_back();
+}
+
+void bounds_system::update_entry(std::size_t i, const math::bbox& bounds, const math::transform& world,
+								 layer_mask layers)
+{
+	const auto& m = world.get_matrix();
+	const auto center = math::vec3(m * math::vec4(bounds.get_center(), 1.0f));
+	const auto extents = bounds.get_extents();
+
+	// the box around the transformed box, the extents go through the absolute
+	// value of the rotation and scale.
+	math::vec3 world_extents;
+	for(int row = 0; row < 3; ++row)
+	{
+		world_extents[row] = math::abs(m[0][row]) * extents.x + math::abs(m[1][row]) * extents.y +
+							 math::abs(m[2][row]) * extents.z;
+	}
+
+	const auto max_scale = std::max({math::length(math::vec3(m[0])), math::length(math::vec3(m[1])),
+									 math::length(math::vec3(m[2]))});
+
+	center_x_[i] = center.x;
+	center_y_[i] = center.y;
+	center_z_[i] = center.z;
+	extent_x_[i] = world_extents.x;
+	extent_y_[i] = world_extents.y;
+	extent_z_[i] = world_extents.z;
+	radius_[i] = math::length(extents) * max_scale;
+	layers_[i] = layers;
+
+	const auto entry_bounds = get_bounds(i);
+	if(proxies_[i] == math::bvh::null_node)
+	{
+		proxies_[i] = tree_.insert(entry_bounds, static_cast<std::uint32_t>(i), layers);
+	}
+	else
+	{
+		tree_.move(proxies_[i], entry_bounds);
+		tree_.set_mask(proxies_[i], layers);
+	}
+}
+
+math::bbox bounds_system::get_bounds(std::size_t i) const
+{
+	const math::vec3 center(center_x_[i], center_y_[i], center_z_[i]);
+	const math::vec3 extents(extent_x_[i], extent_y_[i], extent_z_[i]);
+	return math::bbox(center - extents, center + extents);
+}
+
+std::size_t bounds_system::find(const entity& e) const
+{
+	const auto index = e.id().index();
+	if(index >= slots_.size())
+	{
+		return no_entry;
+	}
+
+	const std::size_t i = slots_[index];
+	if(i == invalid_slot || entities_[i] != e)
+	{
+		return no_entry;
+	}
+	return i;
+}
+
+void bounds_system::remove_light(std::size_t i)
+{
+	auto& entry = lights_[i];
+	const auto index = entry.e.id().index();
+	if(light_slots_[index] == i)
+	{
+		light_slots_[index] = invalid_slot;
+	}
+
+	if(entry.proxy != math::bvh::null_node)
+	{
+		light_tree_.remove(entry.proxy);
+	}
+	if(entry.is_directional)
+	{
+		--directional_count_;
+	}
+
+	const auto last = lights_.size() - 1;
+	if(i != last)
+	{
+		lights_[i] = lights_[last];
+		light_slots_[lights_[i].e.id().index()] = static_cast<std::uint32_t>(i);
+		if(lights_[i].proxy != math::bvh::null_node)
+		{
+			light_tree_.set_user_data(lights_[i].proxy, static_cast<std::uint32_t>(i));
+		}
+	}
+	lights_.pop_back();
+}
+
+void bounds_system::update_light(light_entry& entry)
+{
+	const auto& light = entry.light->get_light();
+	entry.layers = entry.light->get_layers();
+	const bool is_directional = light.type == light_type::directional;
+	if(is_directional != entry.is_directional)
+	{
+		if(is_directional)
+		{
+			++directional_count_;
+		}
+		else
+		{
+			--directional_count_;
+		}
+		entry.is_directional = is_directional;
+	}
+
+	if(is_directional)
+	{
+		if(entry.proxy != math::bvh::null_node)
+		{
+			light_tree_.remove(entry.proxy);
+			entry.proxy = math::bvh::null_node;
+		}
+		return;
+	}
+
+	// the spot cone fits in the sphere of its range
+	entry.center = entry.transform->get_transform().get_position();
+	entry.radius = light.type == light_type::point ? light.point_data.range : light.spot_data.get_range();
+
+	math::bbox light_bounds;
+	light_bounds.from_sphere(entry.center, entry.radius);
+	if(entry.proxy == math::bvh::null_node)
+	{
+		const auto i = static_cast<std::uint32_t>(&entry - lights_.data());
+		entry.proxy = light_tree_.insert(light_bounds, i, entry.layers);
+	}
+	else
+	{
+		light_tree_.move(entry.proxy, light_bounds);
+		light_tree_.set_mask(entry.proxy, entry.layers);
+	}
+}
+}
@@ -0,0 +1,317 @@
+#pragma once
+
+#include "../../rendering/layer_mask.h"
+#include "../ecs.h"
+
+#include <core/math/bvh.h>
+#include <core/math/frustum.h>
+
+#include <cstdint>
+#include <vector>
+
+class transform_component;
+class model_component;
+class light_component;
+
+namespace runtime
+{
+/*
+ * bounds_system; world space bounds of the entities with a model or a light,
+ * indexed by a bounding volume hierarchy for the scene queries.
+ *
+ *      An entry is only recomputed when its transform, model or light was
+ *      touched since it was last computed, and moving it refits the tree
+ *      unless it left the grown box of its leaf. Entities whose mesh isn't
+ *      loaded yet are left out until it is. Directional lights have no
+ *      bounds and are kept out of the tree. The queries take the cull mask
+ *      of the view and leave out the entries on none of its layers, the
+ *      subtrees of the tree without them are not walked.
+ */
+class bounds_system
+{
+public:
+	/*
+	 * cull_cache; what cull learned about a view, the planes that rejected
+	 * the nodes and the entries in the last frame are tested first in the
+	 * next one. Keep one per view that is culled every frame. The result is
+	 * kept with the camera and entries versions and the mask it was culled
+	 * at, for the caller to reuse while none of them changes.
+	 */
+	struct cull_cache
+	{
+		math::bvh::plane_cache nodes;
+		std::vector<std::int8_t> entries;
+		std::vector<std::uint64_t> visible;
+		std::uint64_t camera_version = 0;
+		std::uint64_t entries_version = 0;
+		layer_mask mask = layers::all;
+	};
+
+	/// how large an entry was drawn, the largest of the views of a frame
+	struct screen_presence
+	{
+		/// height on screen in percent of the viewport
+		float percent = 0.0f;
+		/// the most detailed lod it was drawn with
+		std::uint32_t lod = 0;
+		/// frame it was last drawn in, ~0 when it never was
+		std::uint64_t frame = ~std::uint64_t(0);
+	};
+
+	/// an entry and the views it is in, bit v for frustum v
+	struct view_hit
+	{
+		std::size_t entry = 0;
+		std::uint32_t views = 0;
+	};
+
+	struct ray_hit
+	{
+		std::size_t entry = 0;
+		/// along the ray to where it enters the box
+		float distance = 0.0f;
+	};
+
+	bounds_system();
+
+	//-----------------------------------------------------------------------------
+	//  Name : refresh ()
+	/// <summary>
+	/// Brings the entries up to date with the entities. Cheap when nothing
+	/// changed, call it before reading the entries in a frame. The component
+	/// pointers of the entries are valid until entities or components are
+	/// destroyed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void refresh();
+
+	//-----------------------------------------------------------------------------
+	//  Name : cull ()
+	/// <summary>
+	/// Sets bit i of visible if the box of entry i is in the frustum. The
+	/// subtrees inside the frustum are accepted without testing their
+	/// entries, the planes a node is inside of are not tested again below it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void cull(const math::frustum& frustum, std::vector<std::uint64_t>& visible,
+			  cull_cache* cache = nullptr, layer_mask mask = layers::all) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : cull_views ()
+	/// <summary>
+	/// Fills hits with the entries whose box is in at least one of count
+	/// frustums, at most math::bvh::max_views, with the mask of the frustums
+	/// it is in. The tree is walked once for all of them, which is what the
+	/// faces of a cube map or the cascades of a shadow should use.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void cull_views(const math::frustum* frustums, std::size_t count, std::vector<view_hit>& hits,
+					layer_mask mask = layers::all) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : query_sphere ()
+	/// <summary>
+	/// Fills entries with the entries whose box touches the sphere, e.g. the
+	/// models lit by a light.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void query_sphere(const math::vec3& center, float radius, std::vector<std::size_t>& entries,
+					  layer_mask mask = layers::all) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : raycast ()
+	/// <summary>
+	/// Fills hits with the entries whose box the ray hits within
+	/// max_distance, nearest first. direction must be normalized.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void raycast(const math::vec3& origin, const math::vec3& direction, float max_distance,
+				 std::vector<ray_hit>& hits) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : cull_lights ()
+	/// <summary>
+	/// Fills lights with the light entries whose range is in the frustum.
+	/// Directional lights are always in when they are on a layer of the mask.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void cull_lights(const math::frustum& frustum, std::vector<std::size_t>& lights,
+					 layer_mask mask = layers::all) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : query_lights ()
+	/// <summary>
+	/// Fills lights with the light entries whose range touches the sphere.
+	/// Directional lights are always in when they are on a layer of the mask.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void query_lights(const math::vec3& center, float radius, std::vector<std::size_t>& lights,
+					  layer_mask mask = layers::all) const;
+
+	std::size_t size() const
+	{
+		return entities_.size();
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_version ()
+	/// <summary>
+	/// Changes with a refresh that adds, removes or moves an entry.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint64_t get_version() const
+	{
+		return version_;
+	}
+
+	math::aabb_soa get_aabbs() const;
+	math::sphere_soa get_spheres() const;
+
+	const entity& get_entity(std::size_t i) const
+	{
+		return entities_[i];
+	}
+
+	transform_component* get_transform(std::size_t i) const
+	{
+		return transforms_[i];
+	}
+
+	model_component* get_model(std::size_t i) const
+	{
+		return models_[i];
+	}
+
+	layer_mask get_layers(std::size_t i) const
+	{
+		return layers_[i];
+	}
+
+	/// world space box of an entry
+	math::bbox get_bounds(std::size_t i) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_on_screen ()
+	/// <summary>
+	/// Notes that an entry is drawn in a view of the frame, done by the
+	/// renderer when it picks the lods. Entries of a view can be set
+	/// concurrently.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_on_screen(std::size_t i, float percent, std::uint32_t lod, std::uint64_t frame);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_on_screen ()
+	/// <summary>
+	/// How large the entry was drawn in the last frame it was, e.g. to update
+	/// what is small on screen less often.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const screen_presence& get_on_screen(std::size_t i) const
+	{
+		return presence_[i];
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : find ()
+	/// <summary>
+	/// Returns the entry of the entity, no_entry if it has none.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t find(const entity& e) const;
+
+	static constexpr std::size_t no_entry = ~std::size_t(0);
+
+	std::size_t get_lights_count() const
+	{
+		return lights_.size();
+	}
+
+	const entity& get_light_entity(std::size_t i) const
+	{
+		return lights_[i].e;
+	}
+
+	transform_component* get_light_transform(std::size_t i) const
+	{
+		return lights_[i].transform;
+	}
+
+	light_component* get_light(std::size_t i) const
+	{
+		return lights_[i].light;
+	}
+
+	static bool is_visible(const std::vector<std::uint64_t>& visible, std::size_t i)
+	{
+		return ((visible[i / 64] >> (i % 64)) & 1) != 0;
+	}
+
+private:
+	struct light_entry
+	{
+		entity e;
+		transform_component* transform = nullptr;
+		light_component* light = nullptr;
+		/// null_node for directional lights
+		std::int32_t proxy = math::bvh::null_node;
+		math::vec3 center;
+		float radius = 0.0f;
+		layer_mask layers = layers::default_layer;
+		std::uint32_t computed = 0;
+		std::uint32_t seen = 0;
+		bool is_directional = false;
+	};
+
+	void refresh_models(std::uint32_t frame);
+	void refresh_lights(std::uint32_t frame);
+	std::size_t add_entry(entity e);
+	void remove_entry(std::size_t i);
+	void update_entry(std::size_t i, const math::bbox& bounds, const math::transform& world,
+					  layer_mask layers);
+	void remove_light(std::size_t i);
+	void update_light(light_entry& entry);
+
+	static constexpr std::uint32_t invalid_slot = ~std::uint32_t(0);
+
+	/// the entities refreshed, kept listed by the entity_component_system
+	entity_component_system::query<transform_component, model_component> models_query_;
+	entity_component_system::query<transform_component, light_component> lights_query_;
+
+	/// entity index to entry, invalid_slot if the entity has no entry
+	std::vector<std::uint32_t> slots_;
+
+	std::vector<entity> entities_;
+	std::vector<transform_component*> transforms_;
+	std::vector<model_component*> models_;
+	/// frame the entry was computed in
+	std::vector<std::uint32_t> computed_;
+	/// refresh that last saw the entity, entries not seen are removed
+	std::vector<std::uint32_t> seen_;
+	std::uint32_t epoch_ = 0;
+	/// starts at 1 so a zeroed cull_cache never matches
+	std::uint64_t version_ = 1;
+
+	std::vector<float> center_x_;
+	std::vector<float> center_y_;
+	std::vector<float> center_z_;
+	std::vector<float> extent_x_;
+	std::vector<float> extent_y_;
+	std::vector<float> extent_z_;
+	std::vector<float> radius_;
+	std::vector<screen_presence> presence_;
+	/// the layers of the model of the entry, the mask of its leaf
+	std::vector<layer_mask> layers_;
+	/// leaf of the entry in tree_
+	std::vector<std::int32_t> proxies_;
+	/// user data of a leaf is the index of its entry
+	math::bvh tree_;
+
+	/// entity index to light entry, invalid_slot if the entity has none
+	std::vector<std::uint32_t> light_slots_;
+	std::vector<light_entry> lights_;
+	/// lights without bounds, not in light_tree_
+	std::size_t directional_count_ = 0;
+	math::bvh light_tree_;
+};
+}
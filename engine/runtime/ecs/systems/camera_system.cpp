@@ -1,5 +1,5 @@
 #include "camera_system.h"
-#include "../../system/events.h"
+#include "system_scheduler.h"
 #include "../components/camera_component.h"
 #include "../components/transform_component.h"
 
@@ -9,21 +9,26 @@ namespace runtime
 {
 void camera_system::frame_update(delta_t)
 {
-	auto& ecs = core::get_subsystem<entity_component_system>();
-
-	ecs.for_each<transform_component, camera_component>(
-		[](entity e, transform_component& transform, camera_component& camera) {
-			camera.update(transform.get_transform());
-		});
+	cameras_.each([](entity e, transform_component& transform, camera_component& camera) {
+		camera.update(transform.get_transform());
+	});
 }
 
 camera_system::camera_system()
 {
-	on_frame_update.connect(this, &camera_system::frame_update);
+	auto& ecs = core::get_subsystem<entity_component_system>();
+	cameras_ = ecs.get_query<transform_component, camera_component>();
+
+	// get_transform resolves the world transform lazily, so it counts as a write.
+	// the render view releases graphics resources which is owner thread only.
+	system_access access;
+	access.write<transform_component, camera_component>().on_owner_thread();
+	core::get_subsystem<system_scheduler>().add_system(this, &camera_system::frame_update, access,
+														"camera_system");
 }
 
 camera_system::~camera_system()
 {
-	on_frame_update.disconnect(this, &camera_system::frame_update);
+	core::get_subsystem<system_scheduler>().remove_system(this);
 }
 }
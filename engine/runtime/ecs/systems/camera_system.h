@@ -1,7 +1,12 @@
 #pragma once
 
+#include "../ecs.h"
+
 #include <core/common/basetypes.hpp>
 
+class transform_component;
+class camera_component;
+
 namespace runtime
 {
 class camera_system
@@ -18,5 +23,8 @@ public:
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void frame_update(delta_t dt);
+
+private:
+	entity_component_system::query<transform_component, camera_component> cameras_;
 };
 }
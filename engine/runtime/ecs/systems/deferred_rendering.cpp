@@ -5,6 +5,8 @@
 #include "../../rendering/mesh.h"
 #include "../../rendering/model.h"
 #include "../../rendering/renderer.h"
+#include "../../rendering/texture_streaming.h"
+#include "../../rendering/virtual_texturing.h"
 #include "../../system/events.h"
 #include "../components/camera_component.h"
 #include "../components/light_component.h"
@@ -17,25 +19,72 @@
 #include <core/graphics/render_view.h>
 #include <core/graphics/texture.h>
 #include <core/graphics/vertex_buffer.h>
+#include <core/profiling/profiler.h>
 #include <core/system/subsystem.h>
+#include <core/tasks/task_group.h>
+#include <core/tasks/task_system.h>
+
+#include <algorithm>
+#include <array>
+#include <limits>
 
 namespace runtime
 {
 
-bool update_lod_data(lod_data& data, const std::vector<urange32_t>& lod_limits, std::size_t total_lods,
-					 float transition_time, float dt, asset_handle<mesh> mesh, const math::transform& world,
-					 const camera& cam)
+namespace
 {
-	if(!mesh)
-		return false;
+// a lod is only left once the screen size is out of its range by this much
+constexpr float lod_hysteresis = 0.1f;
 
-	if(total_lods <= 1)
-		return true;
+// the thresholds of a temporal lod fade over 8 frames, in a bayer order
+const std::array<float, 8> temporal_lod_fade = {
+	{0.5f / 8.0f, 4.5f / 8.0f, 2.5f / 8.0f, 6.5f / 8.0f, 1.5f / 8.0f, 5.5f / 8.0f, 3.5f / 8.0f, 7.5f / 8.0f}};
+
+// the roughness a mip of a prefiltered cubemap is filtered for, the probe
+// shaders take the mip mips * r * (1.7 - 0.7 * r) for a roughness r
+float get_mip_roughness(std::uint32_t mip, std::uint32_t mips)
+{
+	const auto lod = float(mip) / float(std::max(mips, 1u));
+	return (1.7f - std::sqrt(std::max(2.89f - 2.8f * lod, 0.0f))) / 1.4f;
+}
+
+// the size of the mip the irradiance is projected from, it is smooth enough
+// to need few texels
+constexpr std::uint32_t irradiance_size = 32;
+
+// the shadow views are only tracked for the shadow maps drawn from them,
+// which no pass renders yet, see the end of build_shadows_pass
+constexpr bool shadow_maps = false;
+}
+
+// height of the bounding sphere on screen, in percent of the viewport height
+float get_screen_percent(const math::vec3& center, float radius, const camera& cam)
+{
+	const auto& proj = cam.get_projection();
+	float extent = radius * proj[1][1];
+	if(cam.get_projection_mode() == projection_mode::perspective)
+	{
+		const auto distance = math::distance(center, cam.get_position());
+		if(distance <= radius)
+			return 100.0f;
+
+		extent /= distance;
+	}
 
-	const auto& viewport = cam.get_viewport_size();
-	irect32_t rect = mesh->calculate_screen_rect(world, cam);
+	return math::clamp(extent * 100.0f, 0.0f, 100.0f);
+}
 
-	float percent = math::clamp((float(rect.height()) / float(viewport.height)) * 100.0f, 0.0f, 100.0f);
+std::uint32_t select_lod(const std::vector<urange32_t>& lod_limits, std::size_t total_lods, float percent,
+						 std::uint32_t current_lod)
+{
+	if(current_lod < lod_limits.size())
+	{
+		const auto& range = lod_limits[current_lod];
+		const auto lower = float(range.min) * (1.0f - lod_hysteresis);
+		const auto upper = float(range.max) * (1.0f + lod_hysteresis);
+		if(percent >= lower && percent <= upper)
+			return std::min<std::uint32_t>(current_lod, std::uint32_t(total_lods - 1));
+	}
 
 	std::size_t lod = 0;
 	for(size_t i = 0; i < lod_limits.size(); ++i)
@@ -47,9 +96,27 @@ bool update_lod_data(lod_data& data, const std::vector<urange32_t>& lod_limits,
 		}
 	}
 
-	lod = math::clamp<std::size_t>(lod, 0, total_lods - 1);
+	return static_cast<std::uint32_t>(math::clamp<std::size_t>(lod, 0, total_lods - 1));
+}
+
+void update_lod_data(lod_data& data, const std::vector<urange32_t>& lod_limits, std::size_t total_lods,
+					 float transition_time, float dt, float percent,
+					 std::atomic<std::int32_t>& transitions_left)
+{
+	data.screen_percent = percent;
+	if(total_lods <= 1)
+	{
+		data.on_screen = true;
+		return;
+	}
+
+	const auto lod = select_lod(lod_limits, total_lods, percent, data.target_lod_index);
 	if(data.target_lod_index != lod && data.target_lod_index == data.current_lod_index)
-		data.target_lod_index = static_cast<std::uint32_t>(lod);
+	{
+		// out of the budget of the frame it is tried again in the next one
+		if(transitions_left.fetch_sub(1, std::memory_order_relaxed) > 0)
+			data.target_lod_index = lod;
+	}
 
 	if(data.current_lod_index != data.target_lod_index)
 		data.current_time += dt;
@@ -60,298 +127,980 @@ bool update_lod_data(lod_data& data, const std::vector<urange32_t>& lod_limits,
 		data.current_time = 0.0f;
 	}
 
-	if(percent < 1.0f)
-		return false;
-
-	return true;
+	data.on_screen = percent >= 1.0f;
 }
 
-bool should_rebuild_reflections(visibility_set_models_t& visibility_set, const reflection_probe& probe)
+// The world boxes of the models, tested by every probe against its faces.
+core::frame_vector<math::bbox> get_world_bounds(const visibility_set_models_t& models)
 {
-
-	if(probe.method == reflect_method::environment)
-		return false;
-
-	for(auto& element : visibility_set)
+	core::frame_vector<math::bbox> result;
+	result.reserve(models.size());
+	for(const auto& element : models)
 	{
-		auto& transform_comp_handle = std::get<1>(element);
-		auto& model_comp_handle = std::get<2>(element);
-		auto transform_comp_ptr = transform_comp_handle.lock();
-		auto model_comp_ptr = model_comp_handle.lock();
+		auto transform_comp_ptr = std::get<1>(element).lock();
+		auto model_comp_ptr = std::get<2>(element).lock();
 		if(!transform_comp_ptr || !model_comp_ptr)
 			continue;
 
-		auto& transform_comp_ref = *transform_comp_ptr.get();
-		auto& model_comp_ref = *model_comp_ptr.get();
-
-		const auto& model = model_comp_ref.get_model();
+		const auto& model = model_comp_ptr->get_model();
 		if(!model.is_valid())
 			continue;
 
 		const auto mesh = model.get_lod(0);
+		result.emplace_back(math::bbox::mul(mesh->get_bounds(), transform_comp_ptr->get_transform()));
+	}
+	return result;
+}
 
-		const auto& world_transform = transform_comp_ref.get_transform();
-
-		const auto& bounds = mesh->get_bounds();
-
-		bool result = false;
-
-		for(std::uint32_t i = 0; i < 6; ++i)
-		{
-			const auto& frustum = camera::get_face_camera(i, world_transform).get_frustum();
-			result |= math::frustum::test_obb(frustum, bounds, world_transform);
-		}
+bool should_rebuild_reflections(const core::frame_vector<math::bbox>& dirty_bounds,
+								const reflection_probe& probe, const face_camera_cache::frustums_t& faces)
+{
+	if(probe.method == reflect_method::environment)
+		return false;
 
-		if(result)
+	for(const auto& bounds : dirty_bounds)
+	{
+		if(math::frustum::get_view_mask(faces.data(), faces.size(), bounds) != 0)
 			return true;
 	}
 
 	return false;
 }
 
-bool should_rebuild_shadows(visibility_set_models_t& visibility_set, const light&)
+std::uint32_t get_shadow_views_count(const light& light)
 {
-	//	for(auto& element : visibility_set)
-	//	{
-	//		auto& transform_comp_handle = std::get<1>(element);
-	//		auto& model_comp_handle = std::get<2>(element);
-	//		auto transform_comp_ptr = transform_comp_handle.lock();
-	//		auto model_comp_ptr = model_comp_handle.lock();
-	//		if(!transform_comp_ptr || !model_comp_ptr)
-	//			continue;
-
-	//		auto& transform_comp_ref = *transform_comp_ptr.get();
-	//		auto& model_comp_ref = *model_comp_ptr.get();
-
-	//		const auto& model = model_comp_ref.get_model();
-	//		if(!model.is_valid())
-	//			continue;
-
-	//		const auto mesh = model.get_lod(0);
+	switch(light.type)
+	{
+		case light_type::point:
+			return 6;
+		case light_type::directional:
+			return std::min<std::uint32_t>(std::max<std::uint32_t>(light.directional_data.num_splits, 1),
+										   shadow_cache::max_views);
+		default:
+			return 1;
+	}
+}
 
-	//		const auto& world_transform = transform_comp_ref.get_transform();
-	//		const auto& bounds = mesh->get_bounds();
+float get_shadow_range(const light& light)
+{
+	return light.type == light_type::point ? light.point_data.range : light.spot_data.get_range();
+}
 
-	//		bool result = false;
+bool touches_sphere(const math::bbox& bounds, const math::vec3& center, float radius)
+{
+	float distance2 = 0.0f;
+	for(int i = 0; i < 3; ++i)
+	{
+		const float d = std::max(std::max(bounds.min[i] - center[i], center[i] - bounds.max[i]), 0.0f);
+		distance2 += d * d;
+	}
+	return distance2 <= radius * radius;
+}
 
-	//		// for(std::uint32_t i = 0; i < 6; ++i)
-	//		//{
-	//		//	const auto& frustum = camera::get_face_camera(i, world_transform).get_frustum();
-	//		//	result |= math::frustum::test_obb(frustum, bounds, world_transform);
-	//		//}
+// whether the sphere around the box reaches into the cone of a spot light,
+// half_angle from its axis in radians
+bool touches_cone(const math::bbox& bounds, const math::vec3& apex, const math::vec3& direction, float range,
+				  float half_angle)
+{
+	const auto center = bounds.get_center();
+	const auto radius = math::length(bounds.get_extents());
+	const auto offset = center - apex;
+	const float along = math::dot(offset, direction);
+	if(along < -radius || along > range + radius)
+		return false;
 
-	//		if(result)
-	//			return true;
-	//	}
+	// the distance of the center to the side of the cone, d the distance to the axis
+	const float d = math::sqrt(std::max(math::dot(offset, offset) - along * along, 0.0f));
+	return math::cos(half_angle) * d - math::sin(half_angle) * along <= radius;
+}
 
-	return false;
+// .xy scale and .zw offset from the texture coordinates of a view to the
+// part of its targets it rendered to
+math::vec4 get_render_uv(const usize32_t& render_size, const usize32_t& target_size)
+{
+	const float x = float(render_size.width) / float(std::max<std::uint32_t>(target_size.width, 1));
+	const float y = float(render_size.height) / float(std::max<std::uint32_t>(target_size.height, 1));
+	return math::vec4(x, y, 0.0f, gfx::is_origin_bottom_left() ? 1.0f - y : 0.0f);
 }
 
-visibility_set_models_t deferred_rendering::gather_visible_models(entity_component_system& ecs,
-																  camera* camera,
-																  bool dirty_only /* = false*/,
-																  bool static_only /*= true*/,
-																  bool require_reflection_caster /*= false*/)
+visibility_set_models_t deferred_rendering::gather_visible_models(
+	entity_component_system& /*ecs*/, camera* camera, bool dirty_only /* = false*/,
+	bool static_only /*= true*/, bool require_reflection_caster /*= false*/,
+	bounds_system::cull_cache* cull_cache /*= nullptr*/, const occlusion_buffer* occlusion /*= nullptr*/,
+	layer_mask mask /*= layers::all*/)
 {
+	PROFILE_SCOPE("gather_visible_models");
+	// the world bounds are cached and refreshed at the start of the frame
+	auto& bounds = core::get_subsystem<bounds_system>();
+	std::vector<std::uint64_t> visible;
+	if(camera && cull_cache && cull_cache->camera_version == camera->get_version() &&
+	   cull_cache->entries_version == bounds.get_version() && cull_cache->mask == mask)
+	{
+		// neither the view nor the boxes moved since the last cull
+		visible = cull_cache->visible;
+	}
+	else if(camera)
+	{
+		// the tree leaves the entries on none of the layers before their boxes
+		bounds.cull(camera->get_frustum(), visible, cull_cache, mask);
+		if(cull_cache)
+		{
+			cull_cache->visible = visible;
+			cull_cache->camera_version = camera->get_version();
+			cull_cache->entries_version = bounds.get_version();
+			cull_cache->mask = mask;
+		}
+	}
+
 	visibility_set_models_t result;
-	chandle<transform_component> transform_comp_handle;
-	chandle<model_component> model_comp_handle;
-	for(auto entity : ecs.entities_with_components(transform_comp_handle, model_comp_handle))
+	for(std::size_t i = 0; i < bounds.size(); ++i)
 	{
-		auto model_comp_ptr = model_comp_handle.lock();
-		auto transform_comp_ptr = transform_comp_handle.lock();
+		if(camera && !bounds_system::is_visible(visible, i))
+			continue;
 
-		if(static_only && !model_comp_ptr->is_static())
-		{
+		if((bounds.get_layers(i) & mask) == 0)
 			continue;
-		}
 
-		if(require_reflection_caster && !model_comp_ptr->casts_reflection())
-		{
+		auto& transform_comp = *bounds.get_transform(i);
+		auto& model_comp = *bounds.get_model(i);
+		if(static_only && !model_comp.is_static())
 			continue;
-		}
 
-		auto mesh = model_comp_ptr->get_model().get_lod(0);
+		if(require_reflection_caster && !model_comp.casts_reflection())
+			continue;
 
-		// If mesh isnt loaded yet skip it.
-		if(!mesh)
+		// Only dirty mesh components.
+		if(dirty_only && !transform_comp.is_touched() && !model_comp.is_touched())
 			continue;
 
-		if(camera)
-		{
-			const auto& frustum = camera->get_frustum();
+		if(camera && occlusion && occlusion->is_occluded(bounds.get_bounds(i)))
+			continue;
 
-			const auto& world_transform = transform_comp_ptr->get_transform();
+		result.emplace_back(
+			std::make_tuple(bounds.get_entity(i), transform_comp.handle(), model_comp.handle()));
+	}
+	return result;
+}
 
-			const auto& bounds = mesh->get_bounds();
+void deferred_rendering::frame_render(std::chrono::duration<float> dt)
+{
+	PROFILE_SCOPE("deferred_rendering");
+	auto& ecs = core::get_subsystem<entity_component_system>();
+	core::get_subsystem<bounds_system>().refresh();
+	render_graph_.begin_frame();
+
+	// the skinning of the frame is dispatched as the palettes are first drawn
+	const bool compute_skinning =
+		compute_skinning_ && skinning_program_ && gfx::is_supported(BGFX_CAPS_COMPUTE);
+	core::get_subsystem<renderer>().get_skinning_cache().set_compute_program(
+		compute_skinning ? skinning_program_.get() : nullptr);
+
+	// the gpu time of the last frame bgfx rendered sets the scale of this one
+	const auto stats = gfx::get_stats();
+	if(stats && stats->gpuTimerFreq > 0)
+	{
+		const double to_gpu_ms = 1000.0 / double(stats->gpuTimerFreq);
+		dynamic_resolution_.update(double(stats->gpuTimeEnd - stats->gpuTimeBegin) * to_gpu_ms);
+	}
 
-			// Test the bounding box of the mesh
-			if(math::frustum::test_obb(frustum, bounds, world_transform))
+	update_sky_view(ecs);
+	build_reflections_pass(ecs, dt);
+	if(shadow_maps)
+	{
+		build_shadows_pass(ecs, dt);
+	}
+	build_frame_snapshot(ecs);
+	camera_pass(ecs, dt);
+
+	changes_version_ = ecs::get_frame();
+}
+
+void deferred_rendering::update_sky_view(entity_component_system& /*ecs*/)
+{
+	// the first directional light is the sun
+	bool found_sun = false;
+	auto light_direction = math::normalize(math::vec3(0.2f, -0.8f, 1.0f));
+	lights_query_.each(
+		[&light_direction, &found_sun](entity /*e*/, transform_component& transform_comp_ref,
+									   light_component& light_comp_ref) {
+			if(found_sun || light_comp_ref.get_light().type != light_type::directional)
 			{
-				// Only dirty mesh components.
-				if(dirty_only)
-				{
-					if(transform_comp_ptr->is_touched() || model_comp_ptr->is_touched())
-					{
-						result.emplace_back(entity, transform_comp_handle, model_comp_handle);
-					}
-				} // End if dirty_only
-				else
-				{
-					result.emplace_back(std::make_tuple(entity, transform_comp_handle, model_comp_handle));
-				}
+				return;
+			}
+
+			found_sun = true;
+			light_direction = transform_comp_ref.get_transform().z_unit_axis();
+		});
+
+	sky_view_lut_.update(light_direction, atmospherics_lut_program_.get());
+}
 
-			} // Enf if visble
+void deferred_rendering::build_frame_snapshot(entity_component_system& ecs)
+{
+	PROFILE_SCOPE("build_frame_snapshot");
+	auto& bounds = core::get_subsystem<bounds_system>();
+
+	// the cameras whose view or boxes moved since their last cull
+	frame_cameras_.clear();
+	ecs.each<camera_component>([this, &bounds](entity ce, camera_component& camera_comp) {
+		if(!is_rendered(ce, camera_comp))
+			return;
+
+		auto& cull_caches = cull_caches_[ce];
+		cull_caches.resize(1);
+
+		const auto& camera = camera_comp.get_camera();
+		auto& cull_cache = cull_caches.front();
+		if(cull_cache.camera_version != camera.get_version() ||
+		   cull_cache.entries_version != bounds.get_version() ||
+		   cull_cache.mask != camera_comp.get_cull_mask())
+		{
+			frame_camera view;
+			view.view = &camera;
+			view.cache = &cull_cache;
+			view.mask = camera_comp.get_cull_mask();
+			frame_cameras_.push_back(view);
 		}
-		else
+	});
+
+	// a single camera keeps the plane cache of its own cull
+	if(frame_cameras_.size() > 1)
+	{
+		std::array<math::frustum, math::bvh::max_views> frustums;
+		for(std::size_t first = 0; first < frame_cameras_.size(); first += math::bvh::max_views)
 		{
-			// Only dirty mesh components.
-			if(dirty_only)
+			const auto count = std::min(frame_cameras_.size() - first, math::bvh::max_views);
+			// the walk is for the layers of any of them, each keeps its own
+			layer_mask masks = 0;
+			for(std::size_t v = 0; v < count; ++v)
 			{
-				if(transform_comp_ptr->is_touched() || model_comp_ptr->is_touched())
+				frustums[v] = frame_cameras_[first + v].view->get_frustum();
+				masks |= frame_cameras_[first + v].mask;
+			}
+
+			bounds.cull_views(frustums.data(), count, frame_hits_, masks);
+			for(std::size_t v = 0; v < count; ++v)
+			{
+				const auto& view = frame_cameras_[first + v];
+				auto& cull_cache = *view.cache;
+				cull_cache.visible.assign(math::get_visibility_words(bounds.size()), 0);
+				for(const auto& hit : frame_hits_)
 				{
-					result.emplace_back(std::make_tuple(entity, transform_comp_handle, model_comp_handle));
+					if((hit.views & (1u << v)) != 0 && (bounds.get_layers(hit.entry) & view.mask) != 0)
+						cull_cache.visible[hit.entry / 64] |= std::uint64_t(1) << (hit.entry % 64);
 				}
-			} // End if dirty_only
-			else
-			{
-				result.emplace_back(std::make_tuple(entity, transform_comp_handle, model_comp_handle));
+				cull_cache.camera_version = view.view->get_version();
+				cull_cache.entries_version = bounds.get_version();
+				cull_cache.mask = view.mask;
 			}
 		}
 	}
-	return result;
+
+	frame_probes_.clear();
+	probes_query_.each(
+		[this](entity /*e*/, transform_component& transform_comp_ref,
+			   reflection_probe_component& probe_comp_ref) {
+			const auto& probe = probe_comp_ref.get_probe();
+			const auto& world_transform = transform_comp_ref.get_transform();
+
+			probe_instance instance;
+			instance.probe = &probe_comp_ref;
+			instance.position = world_transform.get_position();
+			instance.cubemap = probe_comp_ref.is_prefiltered() ? probe_comp_ref.get_prefiltered_cubemap()
+																: probe_comp_ref.get_cubemap();
+			if(probe.type == probe_type::sphere)
+			{
+				instance.influence_radius = probe.sphere_data.range;
+			}
+
+			if(probe.type == probe_type::box)
+			{
+				math::transform t;
+				t.set_scale(probe.box_data.extents);
+				t = world_transform * t;
+				instance.inv_world = math::inverse(t).get_matrix();
+				instance.box_data = math::vec4(probe.box_data.extents, probe.box_data.transition_distance);
+				instance.influence_radius = math::length(t.get_scale() + probe.box_data.transition_distance);
+			}
+			frame_probes_.push_back(std::move(instance));
+		});
 }
 
-void deferred_rendering::frame_render(std::chrono::duration<float> dt)
+visibility_set_models_t deferred_rendering::gather_changed_models(entity_component_system& ecs)
 {
-	auto& ecs = core::get_subsystem<entity_component_system>();
+	std::vector<entity> changed;
+	if(!ecs.get_changed_since<transform_component, model_component>(changes_version_, changed))
+	{
+		// the history is gone, consider every model changed
+		return gather_visible_models(ecs, nullptr, false, true, true);
+	}
 
-	build_reflections_pass(ecs, dt);
-	build_shadows_pass(ecs, dt);
-	camera_pass(ecs, dt);
+	visibility_set_models_t result;
+	for(const auto& entity : changed)
+	{
+		auto transform_comp_handle = entity.get_component<transform_component>();
+		auto model_comp_handle = entity.get_component<model_component>();
+		auto model_comp_ptr = model_comp_handle.lock();
+
+		if(!model_comp_ptr->is_static() || !model_comp_ptr->casts_reflection())
+		{
+			continue;
+		}
+
+		// If mesh isnt loaded yet skip it.
+		if(!model_comp_ptr->get_model().get_lod(0))
+		{
+			continue;
+		}
+
+		result.emplace_back(std::make_tuple(entity, transform_comp_handle, model_comp_handle));
+	}
+	return result;
 }
 
 void deferred_rendering::build_reflections_pass(entity_component_system& ecs, std::chrono::duration<float> dt)
 {
-	auto dirty_models = gather_visible_models(ecs, nullptr, true, true, true);
-	ecs.for_each<transform_component, reflection_probe_component>(
-		[this, &ecs, dt, &dirty_models](entity ce, transform_component& transform_comp,
-										reflection_probe_component& reflection_probe_comp) {
-			const auto& world_tranform = transform_comp.get_transform();
-			const auto& probe = reflection_probe_comp.get_probe();
-
-			auto cubemap_fbo = reflection_probe_comp.get_cubemap_fbo();
-			bool should_rebuild = true;
+	PROFILE_SCOPE("build_reflections_pass");
+	const auto frame = ecs::get_frame();
+	const auto dirty_bounds = get_world_bounds(gather_changed_models(ecs));
+	std::vector<entity> changed_probes;
+	const bool all_changed =
+		!ecs.get_changed_since<transform_component, reflection_probe_component>(changes_version_, changed_probes);
+
+	std::vector<math::vec3> camera_positions;
+	ecs.each<camera_component>([this, &camera_positions](entity ce, camera_component& camera_comp) {
+		if(is_rendered(ce, camera_comp))
+			camera_positions.emplace_back(camera_comp.get_camera().get_position());
+	});
 
-			if(!transform_comp.is_touched() && !reflection_probe_comp.is_touched())
+	// Invalidate the probes that changed or that a changed model is in, they
+	// are rendered again a face at a time.
+	std::unordered_map<std::uint64_t, entity> probes;
+	probes_query_.each(
+		[&](entity ce, transform_component& transform_comp, reflection_probe_component& reflection_probe_comp) {
+			const auto id = ce.id().id();
+			const auto& position = transform_comp.get_transform().get_position();
+			float distance = camera_positions.empty() ? 0.0f : std::numeric_limits<float>::max();
+			for(const auto& camera_position : camera_positions)
 			{
-				// If reflections shouldn't be rebuilt - continue.
-				should_rebuild = should_rebuild_reflections(dirty_models, probe);
+				distance = std::min(distance, math::distance(camera_position, position));
 			}
+			probe_updates_.set_probe(id, distance, frame);
+			probes.emplace(id, ce);
 
-			if(!should_rebuild)
-				return;
+			bool should_rebuild = all_changed || std::find(std::begin(changed_probes), std::end(changed_probes),
+														   ce) != std::end(changed_probes);
 
-			// iterate trough each cube face
-			for(std::uint32_t i = 0; i < 6; ++i)
+			if(!should_rebuild && !dirty_bounds.empty())
 			{
-				auto camera = camera::get_face_camera(i, world_tranform);
-				camera.set_far_clip(reflection_probe_comp.get_probe().box_data.extents.r);
-				auto& render_view = reflection_probe_comp.get_render_view(i);
-				camera.set_viewport_size(usize32_t(cubemap_fbo->get_size()));
-				auto& camera_lods = lod_data_[ce];
-				visibility_set_models_t visibility_set;
-
-				if(probe.method != reflect_method::environment)
-					visibility_set = gather_visible_models(ecs, &camera, !should_rebuild, true, true);
-
-				std::shared_ptr<gfx::frame_buffer> output = nullptr;
-				output = g_buffer_pass(output, camera, render_view, visibility_set, camera_lods, dt);
-				output = lighting_pass(output, camera, render_view, ecs, dt);
-				output = atmospherics_pass(output, camera, render_view, ecs, dt);
-				output = tonemapping_pass(output, camera, render_view);
-
-				gfx::render_pass pass("cubemap_fill");
-				pass.touch();
-				gfx::blit(pass.id, cubemap_fbo->get_texture()->native_handle(), 0, 0, 0, std::uint16_t(i),
-						  output->get_texture()->native_handle());
+				const auto& probe = reflection_probe_comp.get_probe();
+				const auto& faces = probe_face_cameras_.get_frustums(id, transform_comp.get_transform(),
+																	 probe.box_data.extents.r);
+				should_rebuild = should_rebuild_reflections(dirty_bounds, probe, faces);
 			}
 
+			if(should_rebuild)
+				probe_updates_.invalidate(id, frame);
+		});
+	probe_updates_.prune();
+
+	const auto render_face = [this, &ecs, dt](entity ce, std::uint32_t face) {
+		auto transform_comp = ce.get_component<transform_component>().lock();
+		auto reflection_probe_comp = ce.get_component<reflection_probe_component>().lock();
+		const auto& world_tranform = transform_comp->get_transform();
+		const auto& probe = reflection_probe_comp->get_probe();
+
+		auto cubemap_fbo = reflection_probe_comp->get_cubemap_fbo();
+		auto& cull_caches = cull_caches_[ce];
+		cull_caches.resize(6);
+
+		auto& camera = probe_face_cameras_.get(ce.id().id(), world_tranform, probe.box_data.extents.r)[face];
+		auto& render_view = reflection_probe_comp->get_render_view(face);
+		camera.set_viewport_size(usize32_t(cubemap_fbo->get_size()));
+		auto& camera_lods = lod_data_[ce];
+		visibility_set_models_t visibility_set;
+
+		if(probe.method != reflect_method::environment)
+		{
+			const auto mask = reflection_probe_comp->get_cull_mask();
+			visibility_set =
+				gather_visible_models(ecs, &camera, false, true, true, &cull_caches[face], nullptr, mask);
+		}
+
+		// the probe faces skip the reflections of other probes
+		using graph = render_graph;
+		graph::resource g_buffer = graph::invalid_resource;
+		graph::resource l_buffer = graph::invalid_resource;
+		graph::resource output = graph::invalid_resource;
+
+		render_graph_.add_pass("probe_g_buffer",
+							   [&](graph::builder& builder) { g_buffer = builder.create("GBUFFER"); },
+							   [&](graph::context& context) {
+								   const auto fbo = g_buffer_pass(nullptr, camera, render_view,
+																  visibility_set, camera_lods, nullptr, dt);
+								   context.set(g_buffer, fbo);
+							   });
+
+		render_graph_.add_pass("probe_lighting",
+							   [&](graph::builder& builder) {
+								   builder.read(g_buffer);
+								   l_buffer = builder.create("LBUFFER");
+							   },
+							   [&](graph::context& context) {
+								   context.set(l_buffer, lighting_pass(context.get(g_buffer), camera,
+																	   render_view, ecs, dt));
+							   });
+
+		add_post_passes(l_buffer, output, camera, render_view, false);
+
+		render_graph_.add_pass("cubemap_fill",
+							   [&](graph::builder& builder) {
+								   builder.read(output);
+								   builder.set_side_effect();
+							   },
+							   [&](graph::context& context) {
+								   gfx::render_pass pass("cubemap_fill");
+								   pass.touch();
+								   const auto source = context.get(output)->get_texture();
+								   gfx::blit(pass.id, cubemap_fbo->get_texture()->native_handle(), 0, 0, 0,
+											 std::uint16_t(face), source->native_handle());
+							   });
+		render_graph_.execute();
+
+		// the faces rendered after this one share its g-buffer and light buffers
+		render_view.release_transient_textures();
+	};
+
+	// Only a few faces are rendered per frame, within the time budget of the
+	// queue. The mips are made and prefiltered once the last face of a probe
+	// is in.
+	const auto begin = std::chrono::steady_clock::now();
+	probe_updates_.begin(frame);
+	std::uint64_t id = 0;
+	std::uint32_t face = 0;
+	while(probe_updates_.next(std::chrono::steady_clock::now() - begin, id, face))
+	{
+		const auto ce = probes[id];
+		render_face(ce, face);
+
+		if(probe_updates_.is_complete(id))
+		{
+			auto reflection_probe_comp = ce.get_component<reflection_probe_component>().lock();
 			gfx::render_pass pass("cubemap_generate_mips");
-			pass.bind(cubemap_fbo.get());
+			pass.bind(reflection_probe_comp->get_cubemap_fbo().get());
 			pass.touch();
-		});
+
+			prefilter_probe(*reflection_probe_comp);
+		}
+	}
+}
+
+void deferred_rendering::prefilter_probe(reflection_probe_component& probe_comp)
+{
+	// without compute the capture is lit with as is, with its box filtered mips
+	if(!gfx::is_supported(BGFX_CAPS_COMPUTE) || !prefilter_program_ || !irradiance_program_)
+		return;
+
+	auto source = probe_comp.get_cubemap();
+	auto target = probe_comp.get_prefiltered_cubemap();
+	auto irradiance = probe_comp.get_irradiance();
+	if(!target || !irradiance || !prefilter_program_->begin() || !irradiance_program_->begin())
+		return;
+
+	// the dispatches follow each other in the view, every mip sampling the
+	// mips of the capture generated before it
+	gfx::render_pass pass("cubemap_prefilter");
+	pass.touch();
+
+	const auto source_size = float(source->info.width);
+	const auto source_mips = std::uint32_t(source->info.numMips);
+	const auto mips = std::uint32_t(target->info.numMips);
+	for(std::uint32_t mip = 0; mip < mips; ++mip)
+	{
+		const auto size = std::max(std::uint32_t(target->info.width) >> mip, 1u);
+		const auto groups = (size + 7) / 8;
+		prefilter_program_->set_texture(0, "s_source", source.get());
+		prefilter_program_->set_uniform("u_prefilter_params",
+										math::vec4(get_mip_roughness(mip, mips), float(size), source_size,
+												   float(source_mips)));
+		gfx::set_image(1, target->native_handle(), std::uint8_t(mip), gfx::access::Write,
+					   gfx::texture_format::RGBA16F);
+		gfx::dispatch(pass.id, prefilter_program_->native_handle(), groups, groups, 6);
+	}
+
+	std::uint32_t sh_mip = 0;
+	while(sh_mip + 1 < source_mips && (std::uint32_t(source->info.width) >> sh_mip) > irradiance_size)
+		++sh_mip;
+
+	const auto sh_size = std::max(std::uint32_t(source->info.width) >> sh_mip, 1u);
+	irradiance_program_->set_texture(0, "s_source", source.get());
+	irradiance_program_->set_uniform("u_sh_params", math::vec4(float(sh_size), float(sh_mip), 0.0f, 0.0f));
+	gfx::set_image(1, irradiance->native_handle(), 0, gfx::access::Write, gfx::texture_format::RGBA32F);
+	gfx::dispatch(pass.id, irradiance_program_->native_handle(), 1, 1, 1);
+
+	prefilter_program_->end();
+	irradiance_program_->end();
+	probe_comp.set_prefiltered(true);
 }
 
 void deferred_rendering::build_shadows_pass(entity_component_system& ecs, std::chrono::duration<float> dt)
 {
-	auto dirty_models = gather_visible_models(ecs, nullptr, true, true, true);
-	ecs.for_each<transform_component, light_component>(
-		[this, &ecs, dt, &dirty_models](entity ce, transform_component& transform_comp,
-										light_component& light_comp) {
-			// const auto& world_tranform = transform_comp.get_transform();
-			const auto& light = light_comp.get_light();
+	PROFILE_SCOPE("build_shadows_pass");
+	const auto frame = ecs::get_frame();
+	auto& bounds = core::get_subsystem<bounds_system>();
+
+	// The boxes the static casters left since the last frame, only the
+	// shadow views they or the casters that moved touch need their depth
+	// again.
+	std::vector<math::bbox> dirty_bounds;
+	dirty_bounds.swap(removed_static_bounds_);
+
+	std::vector<entity> changed_models;
+	const bool models_reset =
+		!ecs.get_changed_since<transform_component, model_component>(changes_version_, changed_models);
+	if(models_reset)
+	{
+		// the history is gone, every view is rebuilt and the boxes are taken again
+		static_caster_bounds_.clear();
+		for(std::size_t i = 0; i < bounds.size(); ++i)
+		{
+			const auto model_comp = bounds.get_model(i);
+			if(model_comp->is_static() && model_comp->casts_shadow())
+				static_caster_bounds_.emplace(bounds.get_entity(i), bounds.get_bounds(i));
+		}
+	}
 
-			bool should_rebuild = true;
+	// the static casters that moved invalidate the views they are in now,
+	// found with the casters of the lights
+	std::vector<char> moved(bounds.size(), 0);
+	for(const auto& e : changed_models)
+	{
+		auto it = static_caster_bounds_.find(e);
+		if(it != static_caster_bounds_.end())
+		{
+			dirty_bounds.push_back(it->second);
+			static_caster_bounds_.erase(it);
+		}
+
+		const auto i = bounds.find(e);
+		if(i == bounds_system::no_entry)
+			continue;
+
+		const auto model_comp = bounds.get_model(i);
+		if(!model_comp->is_static() || !model_comp->casts_shadow())
+			continue;
+
+		static_caster_bounds_.emplace(e, bounds.get_bounds(i));
+		moved[i] = 1;
+	}
 
-			if(!transform_comp.is_touched() && !light_comp.is_touched())
+	std::vector<entity> changed_lights;
+	const bool lights_reset =
+		models_reset ||
+		!ecs.get_changed_since<transform_component, light_component>(changes_version_, changed_lights);
+
+	// The cascades of the directional lights are fit to the first camera.
+	// A light out of the views of every camera has no shadow this frame.
+	const camera* view_camera = nullptr;
+	std::vector<char> seen_lights(bounds.get_lights_count(), 0);
+	std::vector<std::size_t> lights_in_view;
+	ecs.each<camera_component>([&](entity ce, camera_component& camera_comp) {
+		if(!is_rendered(ce, camera_comp))
+			return;
+
+		const auto& camera = camera_comp.get_camera();
+		if(view_camera == nullptr)
+			view_camera = &camera;
+
+		bounds.cull_lights(camera.get_frustum(), lights_in_view, camera_comp.get_cull_mask());
+		for(const auto i : lights_in_view)
+			seen_lights[i] = 1;
+	});
+
+	std::vector<std::size_t> lit;
+	std::vector<bounds_system::view_hit> view_hits;
+	light_interactions_.clear();
+	for(std::size_t l = 0; l < bounds.get_lights_count(); ++l)
+	{
+		// left out of the cache until it is seen again, which has all its
+		// views rendered again then
+		if(!seen_lights[l])
+			continue;
+
+		const auto ce = bounds.get_light_entity(l);
+		auto& light_comp = *bounds.get_light(l);
+		const auto& world_tranform = bounds.get_light_transform(l)->get_transform();
+		const auto& light = light_comp.get_light();
+		const auto id = ce.id().id();
+		const auto views_count = get_shadow_views_count(light);
+		const std::uint32_t all_views = (1u << views_count) - 1;
+
+		shadow_cache_.set_light(id, views_count, frame);
+
+		// A cascade that moved has to render its static depth again, the
+		// far ones move every few frames.
+		const math::frustum* cascades = nullptr;
+		if(light.type == light_type::directional && view_camera != nullptr)
+		{
+			auto& light_cascades = light_comp.get_cascades();
+			const auto& data = light.directional_data;
+			const auto direction = world_tranform.z_unit_axis();
+			const auto moved_cascades = light_cascades.update(*view_camera, direction, views_count,
+															  data.split_distribution, data.stabilize, frame);
+			shadow_cache_.invalidate(id, moved_cascades, frame);
+			cascades = light_cascades.get_frustums();
+		}
+
+		// The casters of the light with the views they are in. The cube
+		// faces or the cascades share one walk of the tree, the spot cone
+		// tests the boxes in the sphere of its range.
+		light_interactions_.begin_light(id);
+		const auto add_caster = [&](std::size_t i, std::uint32_t views) {
+			const auto model_comp = bounds.get_model(i);
+			if(views != 0 && model_comp->casts_shadow())
+				light_interactions_.add(i, views, model_comp->is_static());
+		};
+
+		const auto range = get_shadow_range(light);
+		const math::frustum* views = cascades;
+		if(light.type == light_type::point)
+		{
+			views = light_face_cameras_.get_frustums(id, world_tranform, range).data();
+		}
+		if(views != nullptr)
+		{
+			bounds.cull_views(views, views_count, view_hits);
+			for(const auto& hit : view_hits)
+				add_caster(hit.entry, hit.views);
+		}
+		else if(light.type == light_type::directional)
+		{
+			for(std::size_t i = 0; i < bounds.size(); ++i)
+				add_caster(i, all_views);
+		}
+		else
+		{
+			const auto position = world_tranform.get_position();
+			const auto direction = world_tranform.z_unit_axis();
+			const auto half_angle = math::radians(light.spot_data.get_outer_angle() * 0.5f);
+			bounds.query_sphere(position, range, lit);
+			for(const auto i : lit)
 			{
-				// If shadows shouldn't be rebuilt - continue.
-				should_rebuild = should_rebuild_shadows(dirty_models, light);
+				if(touches_cone(bounds.get_bounds(i), position, direction, range, half_angle))
+					add_caster(i, all_views);
 			}
+		}
 
-			if(!should_rebuild)
-				return;
+		// The cube faces are looked up once a box is in the range of a point light.
+		const auto get_view_mask = [&](const math::bbox& box) -> std::uint32_t {
+			if(light.type == light_type::directional)
+				return cascades ? math::frustum::get_view_mask(cascades, views_count, box) : all_views;
 
-		});
+			if(!touches_sphere(box, world_tranform.get_position(), range))
+				return 0;
+
+			if(light.type != light_type::point)
+				return all_views;
+
+			return math::frustum::get_view_mask(views, views_count, box);
+		};
+
+		const bool light_changed = lights_reset || std::find(std::begin(changed_lights),
+															 std::end(changed_lights),
+															 ce) != std::end(changed_lights);
+
+		// The dynamic casters are drawn in their views every frame, over
+		// the cached static depth.
+		std::uint32_t invalid = light_changed ? all_views : 0;
+		std::uint32_t dynamic = 0;
+		for(const auto& caster : light_interactions_.get_casters(id))
+		{
+			if(!caster.is_static)
+				dynamic |= caster.views;
+			else if(moved[caster.entry])
+				invalid |= caster.views;
+		}
+
+		// the boxes the static casters left are no entries anymore
+		for(const auto& box : dirty_bounds)
+		{
+			if(invalid == all_views)
+				break;
+
+			invalid |= get_view_mask(box);
+		}
+
+		shadow_cache_.invalidate(id, invalid, frame);
+		shadow_cache_.set_dynamic(id, dynamic);
+	}
+
+	shadow_cache_.prune();
+
+	// Only the budget of static views is refreshed in a frame, the others
+	// keep their stale depth until their turn.
+	shadow_cache_.schedule(shadow_refreshes_);
+
+	// There is no shadow map rendering yet, it goes here and turns on
+	// shadow_maps: the static casters of the scheduled views into their
+	// cached depth, then for the views with dynamic casters a copy of it with
+	// the dynamic casters on top, both taken from light_interactions_. The
+	// view of a cascade is the camera of light_component::get_cascades. The
+	// casters are drawn with the positions alone, see model::render.
+}
+
+bool deferred_rendering::is_rendered(entity ce, const camera_component& camera_comp) const
+{
+	const auto frame = ecs::get_frame();
+	if(presented_only_ && !camera_comp.is_presented(frame))
+		return false;
+
+	const auto interval = camera_comp.get_render_interval();
+	return interval <= 1 || (frame + ce.id().index()) % interval == 0;
 }
 
 void deferred_rendering::camera_pass(entity_component_system& ecs, std::chrono::duration<float> dt)
 {
-	ecs.for_each<camera_component>([this, &ecs, dt](entity ce, camera_component& camera_comp) {
+	ecs.each<camera_component>([this, &ecs, dt](entity ce, camera_component& camera_comp) {
+		// a camera not rendered keeps its targets and the output of its last render
+		if(!is_rendered(ce, camera_comp))
+			return;
+
 		auto& camera_lods = lod_data_[ce];
 		auto& camera = camera_comp.get_camera();
 		auto& render_view = camera_comp.get_render_view();
+		render_view.release_unused_resources();
+		auto scale = dynamic_resolution_.get_scale();
+		if(presented_only_)
+			scale *= camera_comp.get_present_scale();
+		render_view.set_render_scale(scale);
 
-		auto output = deferred_render_full(camera, render_view, ecs, camera_lods, dt);
+		auto& cull_caches = cull_caches_[ce];
+		cull_caches.resize(1);
+
+		auto& occlusion = occlusion_buffers_[ce];
+		auto& prepass = depth_prepasses_[ce];
+
+		const auto mask = camera_comp.get_cull_mask();
+		auto output = deferred_render_full(camera, render_view, ecs, camera_lods, cull_caches.front(),
+										   &occlusion, &prepass, mask, dt);
 	});
 }
 
 std::shared_ptr<gfx::frame_buffer> deferred_rendering::deferred_render_full(
 	camera& camera, gfx::render_view& render_view, entity_component_system& ecs,
-	std::unordered_map<entity, lod_data>& camera_lods, std::chrono::duration<float> dt)
+	std::unordered_map<entity, lod_data>& camera_lods, bounds_system::cull_cache& cull_cache,
+	occlusion_buffer* occlusion, depth_prepass_state* prepass, layer_mask mask,
+	std::chrono::duration<float> dt)
 {
-	std::shared_ptr<gfx::frame_buffer> output = nullptr;
+	PROFILE_SCOPE("deferred_render_full");
+	if(occlusion)
+	{
+		occlusion->update(core::get_subsystem<renderer>().get_render_frame());
+	}
 
-	auto visibility_set = gather_visible_models(ecs, &camera, false, false, false);
+	auto visibility_set =
+		gather_visible_models(ecs, &camera, false, false, false, &cull_cache, occlusion, mask);
 
-	output = g_buffer_pass(output, camera, render_view, visibility_set, camera_lods, dt);
+	using graph = render_graph;
+	graph::resource g_buffer = graph::invalid_resource;
+	graph::resource r_buffer = graph::invalid_resource;
+	graph::resource l_buffer = graph::invalid_resource;
+	graph::resource output = graph::invalid_resource;
 
-	output = reflection_probe_pass(output, camera, render_view, ecs, dt);
+	render_graph_.add_pass("g_buffer", [&](graph::builder& builder) { g_buffer = builder.create("GBUFFER"); },
+						   [&](graph::context& context) {
+							   const auto fbo = g_buffer_pass(nullptr, camera, render_view, visibility_set,
+															  camera_lods, prepass, dt);
+							   context.set(g_buffer, fbo);
+						   });
 
-	output = lighting_pass(output, camera, render_view, ecs, dt);
+	if(occlusion)
+	{
+		// the depth of this frame culls the frame the read back lands in, with
+		// the pre-pass it is the depth it drew
+		render_graph_.add_pass("occlusion_capture",
+							   [&](graph::builder& builder) {
+								   builder.read(g_buffer);
+								   builder.set_side_effect();
+							   },
+							   [&](graph::context& /*context*/) {
+								   const auto& size = camera.get_viewport_size();
+								   const auto depth = render_view.get_depth_buffer(size);
+								   occlusion->capture(camera, render_view, depth.get(),
+													  depth_downsample_program_.get());
+							   });
+	}
 
-	output = atmospherics_pass(output, camera, render_view, ecs, dt);
+	render_graph_.add_pass("reflection_probe",
+						   [&](graph::builder& builder) {
+							   builder.read(g_buffer);
+							   r_buffer = builder.create("RBUFFER");
+						   },
+						   [&](graph::context& context) {
+							   context.set(r_buffer, reflection_probe_pass(context.get(g_buffer), camera,
+																		   render_view, ecs, dt));
+						   });
+
+	render_graph_.add_pass("lighting",
+						   [&](graph::builder& builder) {
+							   builder.read(g_buffer);
+							   builder.read(r_buffer);
+							   l_buffer = builder.create("LBUFFER");
+						   },
+						   [&](graph::context& context) {
+							   const auto input = context.get(r_buffer);
+							   context.set(l_buffer, lighting_pass(input, camera, render_view, ecs, dt));
+						   });
+
+	add_post_passes(l_buffer, output, camera, render_view, true);
+	render_graph_.set_output(output);
+	render_graph_.execute();
+
+	// the g-buffer and the light buffers go to the views rendered after this one
+	render_view.release_transient_textures();
+
+	return render_graph_.get(output);
+}
 
-	output = tonemapping_pass(output, camera, render_view);
+void deferred_rendering::add_post_passes(render_graph::resource& l_buffer, render_graph::resource& output,
+										 camera& camera, gfx::render_view& render_view, bool sun_spot)
+{
+	using graph = render_graph;
+	render_graph_.add_pass("atmospherics",
+						   [&](graph::builder& builder) { l_buffer = builder.write(l_buffer); },
+						   [&l_buffer, &camera, &render_view, sun_spot, this](graph::context& context) {
+							   const auto input = context.get(l_buffer);
+							   context.set(l_buffer, atmospherics_pass(input, camera, render_view, sun_spot));
+						   });
+
+	render_graph_.add_pass("tonemapping",
+						   [&](graph::builder& builder) {
+							   builder.read(l_buffer);
+							   output = builder.create("OUTPUT");
+						   },
+						   [&l_buffer, &output, &camera, &render_view, this](graph::context& context) {
+							   const auto input = context.get(l_buffer);
+							   context.set(output, tonemapping_pass(input, camera, render_view));
+						   });
+}
 
-	return output;
+void deferred_rendering::select_lods(const visibility_set_models_t& visibility_set, const camera& camera,
+									 float render_scale, std::unordered_map<entity, lod_data>& camera_lods,
+									 std::chrono::duration<float> dt)
+{
+	PROFILE_SCOPE("select_lods");
+	struct lod_job
+	{
+		lod_data* data = nullptr;
+		std::size_t entry = 0;
+	};
+
+	// the map is only grown here, the workers write to the entries
+	const auto frame = ecs::get_frame();
+	auto& bounds = core::get_subsystem<bounds_system>();
+	core::frame_vector<lod_job> jobs;
+	jobs.reserve(visibility_set.size());
+	for(const auto& element : visibility_set)
+	{
+		const auto& e = std::get<0>(element);
+		auto& data = camera_lods[e];
+		if(data.frame == frame)
+			continue;
+
+		const auto entry = bounds.find(e);
+		if(entry == bounds_system::no_entry)
+			continue;
+
+		data.frame = frame;
+		jobs.push_back({&data, entry});
+	}
+
+	// shared by the cameras of the frame
+	if(lod_budget_frame_ != frame)
+	{
+		lod_budget_frame_ = frame;
+		lod_transitions_left_ = lod_transition_budget_ > 0 ? std::int32_t(lod_transition_budget_)
+														   : std::numeric_limits<std::int32_t>::max();
+	}
+
+	const auto bias = lod_bias_ * render_scale;
+	const auto spheres = bounds.get_spheres();
+	auto& ts = core::get_subsystem<core::task_system>();
+	core::parallel_for(ts, std::size_t(0), jobs.size(), std::size_t(64), [&](std::size_t i) {
+		const auto& job = jobs[i];
+		const auto& model = bounds.get_model(job.entry)->get_model();
+		const math::vec3 center(spheres.center_x[job.entry], spheres.center_y[job.entry],
+								spheres.center_z[job.entry]);
+		const auto percent = get_screen_percent(center, spheres.radius[job.entry], camera) * bias;
+		update_lod_data(*job.data, model.get_lod_limits(), model.get_lods().size(),
+						model.get_lod_transition_time(), dt.count(), std::min(percent, 100.0f),
+						lod_transitions_left_);
+
+		// for the systems of the next frame, the entries of the jobs are distinct
+		if(job.data->on_screen)
+			bounds.set_on_screen(job.entry, job.data->screen_percent, job.data->current_lod_index, frame);
+	});
 }
 
 std::shared_ptr<gfx::frame_buffer>
 deferred_rendering::g_buffer_pass(std::shared_ptr<gfx::frame_buffer> input, camera& camera,
 								  gfx::render_view& render_view, visibility_set_models_t& visibility_set,
 								  std::unordered_map<entity, lod_data>& camera_lods,
-								  std::chrono::duration<float> dt)
+								  depth_prepass_state* prepass, std::chrono::duration<float> dt)
 {
+	PROFILE_SCOPE("g_buffer_pass");
 	const auto& view = camera.get_view();
 	const auto& proj = camera.get_projection();
 	const auto& viewport_size = camera.get_viewport_size();
 	auto g_buffer_fbo = render_view.get_g_buffer_fbo(viewport_size);
+	const auto render_size = render_view.get_render_size(viewport_size);
+	const auto render_width = std::uint16_t(render_size.width);
+	const auto render_height = std::uint16_t(render_size.height);
+
+	// automatic goes by the overdraw of the last frame. The colors tested
+	// equal would be lost if the programs of the depth could not draw.
+	const bool wants_prepass =
+		prepass && (depth_prepass_mode_ == depth_prepass_mode::on ||
+					(depth_prepass_mode_ == depth_prepass_mode::automatic && prepass->enabled));
+	const bool depth_prepass = wants_prepass && depth_prepass_program_ && depth_prepass_instanced_program_ &&
+							   depth_prepass_program_->begin() && depth_prepass_instanced_program_->begin();
+
+	// the view of the pre-pass is taken first so that it runs first
+	gfx::view_id depth_view = 0;
+	if(depth_prepass)
+	{
+		gfx::render_pass depth_pass("depth_prepass");
+		depth_pass.clear();
+		depth_pass.set_view_proj(view, proj);
+		depth_pass.bind(g_buffer_fbo.get());
+		depth_pass.set_rect(0, 0, render_width, render_height);
+		depth_view = depth_pass.id;
+	}
+
 	gfx::render_pass pass("g_buffer_fill");
-	pass.clear();
+	if(!depth_prepass)
+		pass.clear();
 	pass.set_view_proj(view, proj);
 	pass.bind(g_buffer_fbo.get());
+	pass.set_rect(0, 0, render_width, render_height);
+
+	const auto camera_pos = camera.get_position();
+	const auto clip_planes = math::vec2(camera.get_near_clip(), camera.get_far_clip());
+
+	// the probe faces render at their full size, only the cameras are scaled
+	const auto render_scale = render_view.get_render_scale();
+	select_lods(visibility_set, camera, render_scale, camera_lods, dt);
+
+	auto streaming =
+		core::has_subsystems<texture_streaming>() ? &core::get_subsystem<texture_streaming>() : nullptr;
+	const auto frame = ecs::get_frame();
+
+	// the area of the sphere of a model over the area of the view, from its
+	// height in percent
+	const auto aspect = float(render_width) / float(std::max<std::uint16_t>(render_height, 1));
+	const auto percent_bias = std::max(lod_bias_ * render_scale, 0.01f);
+	const auto area_scale = math::pi<float>() * 0.25f / (aspect * percent_bias * percent_bias);
+	float overdraw = 0.0f;
 
 	for(auto& element : visibility_set)
 	{
@@ -371,81 +1120,166 @@ deferred_rendering::g_buffer_pass(std::shared_ptr<gfx::frame_buffer> input, came
 			continue;
 
 		const auto& world_transform = transform_comp_ref.get_transform();
-		const auto clip_planes = math::vec2(camera.get_near_clip(), camera.get_far_clip());
 
 		auto& lod_data = camera_lods[e];
 		const auto transition_time = model.get_lod_transition_time();
-		const auto lod_count = model.get_lods().size();
-		const auto& lod_limits = model.get_lod_limits();
 		const auto current_time = lod_data.current_time;
 		const auto current_lod_index = lod_data.current_lod_index;
 		const auto target_lod_index = lod_data.target_lod_index;
 
 		const auto current_mesh = model.get_lod(current_lod_index);
-		if(!current_mesh)
+		if(!current_mesh || !lod_data.on_screen)
 			continue;
 
-		if(false == update_lod_data(lod_data, lod_limits, lod_count, transition_time, dt.count(),
-									current_mesh, world_transform, camera))
-			continue;
+		const auto screen_part = lod_data.screen_percent * 0.01f;
+		overdraw += std::min(screen_part * screen_part * area_scale, 1.0f);
+
+		if(streaming)
+		{
+			// about a texel a pixel across the model
+			const auto texels = lod_data.screen_percent * 0.01f * float(render_height);
+			for(const auto& mat : model.get_materials())
+			{
+				if(mat)
+					mat->visit_textures([&](const gfx::texture& tex) { streaming->request(tex, texels); });
+			}
+		}
+
 		const auto params = math::vec3{0.0f, -1.0f, (transition_time - current_time) / transition_time};
 
 		const auto params_inv = math::vec3{1.0f, 1.0f, current_time / transition_time};
 
 		const auto& bone_transforms = model_comp_ref.get_bone_transforms();
 
-		model.render(pass.id, world_transform, bone_transforms, true, true, true, 0, current_lod_index,
-					 nullptr, [&camera, &clip_planes, &params](auto& p) {
-						 auto camera_pos = camera.get_position();
-						 p.set_uniform("u_camera_wpos", camera_pos);
-						 p.set_uniform("u_camera_clip_planes", clip_planes);
-						 p.set_uniform("u_lod_params", params);
-					 });
+		// front to back within a run of the same program and material
+		const auto depth =
+			math::distance(camera_pos, world_transform.get_position()) / camera.get_far_clip();
+
+		if(current_time != 0.0f && temporal_lod_fade_)
+		{
+			// the target in the share of the frames the fade has reached, the
+			// models at phases of their own so that they do not switch together
+			const auto phase = (frame + e.id().index()) % temporal_lod_fade.size();
+			const auto faded = temporal_lod_fade[phase] < current_time / transition_time;
+			const auto lod = faded ? target_lod_index : current_lod_index;
+			g_buffer_queue_.add(pass.id, model, world_transform, bone_transforms, true, true, true, 0, lod,
+								depth, math::vec4(0.0f, 0.0f, 1.0f, 0.0f), depth_prepass);
+			continue;
+		}
+
+		// both lods of a transition discard in their dither masks
+		g_buffer_queue_.add(pass.id, model, world_transform, bone_transforms, true, true, true, 0,
+							current_lod_index, depth, math::vec4(params, 0.0f),
+							depth_prepass && current_time == 0.0f);
 
 		if(current_time != 0.0f)
 		{
-			model.render(
-				pass.id, world_transform, bone_transforms, true, true, true, 0, target_lod_index, nullptr,
-				[&params_inv](auto& p) { p.set_uniform("u_lod_params", params_inv); });
+			g_buffer_queue_.add(pass.id, model, world_transform, bone_transforms, true, true, true, 0,
+								target_lod_index, depth, math::vec4(params_inv, 0.0f));
 		}
 	}
 
+	g_buffer_queue_.sort();
+
+	if(prepass)
+	{
+		// a margin below the threshold so that it does not flip every frame
+		prepass->overdraw = overdraw;
+		prepass->enabled = overdraw > depth_prepass_overdraw_ * (prepass->enabled ? 0.8f : 1.0f);
+	}
+
+	// the chunks recorded on the workers fill the g-buffer in the next views
+	std::vector<gfx::view_id> chunk_views;
+	for(std::size_t i = 1; i < g_buffer_queue_.get_chunks_count(); ++i)
+	{
+		gfx::render_pass chunk_pass("g_buffer_fill");
+		chunk_pass.set_view_proj(view, proj);
+		chunk_pass.bind(g_buffer_fbo.get());
+		chunk_pass.set_rect(0, 0, render_width, render_height);
+		chunk_views.push_back(chunk_pass.id);
+	}
+
+	// set on the workers for every chunk, hashed once here
+	constexpr gpu_program::uniform_id u_lod_params("u_lod_params");
+	constexpr gpu_program::uniform_id u_camera_wpos("u_camera_wpos");
+	constexpr gpu_program::uniform_id u_camera_clip_planes("u_camera_clip_planes");
+	if(depth_prepass)
+	{
+		g_buffer_queue_.submit_depth(depth_view, *depth_prepass_program_, *depth_prepass_instanced_program_,
+									 [&](auto& p) {
+										 p.set_uniform(u_camera_wpos, camera_pos);
+										 p.set_uniform(u_camera_clip_planes, clip_planes);
+									 });
+	}
+	g_buffer_queue_.submit_parallel(chunk_views, u_lod_params, [&](auto& p) {
+		p.set_uniform(u_camera_wpos, camera_pos);
+		p.set_uniform(u_camera_clip_planes, clip_planes);
+	});
+
+	// the cameras draw the pages their virtual textures sample, at a fraction
+	// of their size, for the cache to have them in a few frames
+	if(prepass && core::has_subsystems<virtual_texturing>())
+	{
+		auto& vt = core::get_subsystem<virtual_texturing>();
+		auto feedback_fbo = vt.begin_feedback(render_view, render_width, render_height);
+		if(feedback_fbo)
+		{
+			const auto& feedback = feedback_fbo->get_texture(0);
+			gfx::render_pass feedback_pass("virtual_texture_feedback");
+			feedback_pass.clear(BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH, 0, 1.0f, 0);
+			feedback_pass.set_view_proj(view, proj);
+			feedback_pass.bind(feedback_fbo.get());
+			feedback_pass.set_rect(0, 0, feedback->info.width, feedback->info.height);
+
+			constexpr gpu_program::uniform_id u_vt_feedback("u_vt_feedback");
+			const math::vec4 feedback_params(vt.get_feedback_bias(), 0.0f, 0.0f, 0.0f);
+			g_buffer_queue_.submit_feedback(feedback_pass.id, [&](auto& p) {
+				p.set_uniform(u_camera_wpos, camera_pos);
+				p.set_uniform(u_camera_clip_planes, clip_planes);
+				p.set_uniform(u_vt_feedback, feedback_params);
+			});
+			vt.end_feedback(*feedback_fbo);
+		}
+	}
+	g_buffer_queue_.clear();
+
 	return g_buffer_fbo;
 }
 
 std::shared_ptr<gfx::frame_buffer> deferred_rendering::lighting_pass(std::shared_ptr<gfx::frame_buffer> input,
 																	 camera& camera,
 																	 gfx::render_view& render_view,
-																	 entity_component_system& ecs,
+																	 entity_component_system& /*ecs*/,
 																	 std::chrono::duration<float> dt)
 {
+	PROFILE_SCOPE("lighting_pass");
 	const auto& view = camera.get_view();
 	const auto& proj = camera.get_projection();
 
 	const auto& viewport_size = camera.get_viewport_size();
 	auto g_buffer_fbo = render_view.get_g_buffer_fbo(viewport_size).get();
 
-	static auto light_buffer_format = gfx::get_best_format(
-		BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER, gfx::format_search_flags::four_channels |
-												  gfx::format_search_flags::requires_alpha |
-												  gfx::format_search_flags::half_precision_float);
+	const auto light_buffer_format = gfx::render_view::get_light_buffer_format();
 
-	auto light_buffer = render_view.get_texture("LBUFFER", viewport_size.width, viewport_size.height, false,
-												1, light_buffer_format);
+	auto light_buffer = render_view.get_transient_texture("LBUFFER", viewport_size.width,
+														  viewport_size.height, false, 1,
+														  light_buffer_format);
 	auto l_buffer_fbo = render_view.get_fbo("LBUFFER", {light_buffer});
-	const auto buffer_size = l_buffer_fbo->get_size();
+	const auto buffer_size = render_view.get_render_size(viewport_size);
+	const auto render_uv = get_render_uv(buffer_size, l_buffer_fbo->get_size());
 
 	gfx::render_pass pass("light_buffer_fill");
 	pass.bind(l_buffer_fbo.get());
+	pass.set_rect(0, 0, std::uint16_t(buffer_size.width), std::uint16_t(buffer_size.height));
 	pass.set_view_proj(view, proj);
 	pass.clear(BGFX_CLEAR_COLOR, 0, 0.0f, 0);
-	auto refl_buffer =
-		render_view
-			.get_texture("RBUFFER", viewport_size.width, viewport_size.height, false, 1, light_buffer_format)
-			.get();
+	auto refl_buffer = render_view
+						   .get_transient_texture("RBUFFER", viewport_size.width, viewport_size.height, false,
+												  1, light_buffer_format)
+						   .get();
 
-	ecs.for_each<transform_component, light_component>(
-		[this, &camera, &pass, &buffer_size, &view, &proj, g_buffer_fbo,
+	const auto draw_light =
+		[this, &camera, &pass, &buffer_size, &render_uv, &view, &proj, g_buffer_fbo,
 		 refl_buffer](entity e, transform_component& transform_comp_ref, light_component& light_comp_ref) {
 			const auto& light = light_comp_ref.get_light();
 			const auto& world_transform = transform_comp_ref.get_transform();
@@ -499,6 +1333,7 @@ std::shared_ptr<gfx::frame_buffer> deferred_rendering::lighting_pass(std::shared
 				auto camera_pos = camera.get_position();
 				program->set_uniform("u_light_color_intensity", light_color_intensity);
 				program->set_uniform("u_camera_position", camera_pos);
+				program->set_uniform("u_render_uv", render_uv);
 				program->set_texture(0, "s_tex0", g_buffer_fbo->get_texture(0).get());
 				program->set_texture(1, "s_tex1", g_buffer_fbo->get_texture(1).get());
 				program->set_texture(2, "s_tex2", g_buffer_fbo->get_texture(2).get());
@@ -515,7 +1350,78 @@ std::shared_ptr<gfx::frame_buffer> deferred_rendering::lighting_pass(std::shared
 
 				program->end();
 			}
-		});
+		};
+
+	// only the lights whose range reaches into the view
+	auto& bounds = core::get_subsystem<bounds_system>();
+	std::vector<std::size_t> visible_lights;
+	bounds.cull_lights(camera.get_frustum(), visible_lights, mask);
+
+	// Many point and spot lights are binned into clusters and shaded in one
+	// pass, their overlapping volumes would cost more in blending.
+	std::size_t local_lights = 0;
+	for(const auto i : visible_lights)
+	{
+		if(bounds.get_light(i)->get_light().type != light_type::directional)
+			++local_lights;
+	}
+	const bool clustered =
+		clustered_light_program_ && local_lights >= light_grid::min_lights && light_grid::is_supported();
+	if(clustered)
+		light_grid_.begin(camera);
+
+	for(const auto i : visible_lights)
+	{
+		auto& light_comp = *bounds.get_light(i);
+		auto& transform_comp = *bounds.get_light_transform(i);
+		if(clustered && light_comp.get_light().type != light_type::directional)
+		{
+			const auto& world_transform = transform_comp.get_transform();
+			const auto& light_position = world_transform.get_position();
+			const auto& light_direction = world_transform.z_unit_axis();
+
+			irect32_t tiles(0, 0, irect32_t::value_type(light_grid::tiles_x),
+							irect32_t::value_type(light_grid::tiles_y));
+			if(light_comp.compute_projected_sphere_rect(tiles, light_position, light_direction, view,
+														proj) == 0)
+				continue;
+
+			// a full grid leaves the rest to their volumes
+			if(light_grid_.add(light_comp.get_light(), light_position, light_direction, tiles))
+				continue;
+		}
+		draw_light(bounds.get_light_entity(i), transform_comp, light_comp);
+	}
+
+	if(clustered && light_grid_.size() > 0)
+	{
+		light_grid_.upload(render_view);
+
+		auto program = clustered_light_program_.get();
+		auto camera_pos = camera.get_position();
+		program->begin();
+		program->set_uniform("u_light_grid", light_grid_.get_grid_params());
+		program->set_uniform("u_light_grid_depth", light_grid_.get_depth_params());
+		program->set_uniform("u_light_grid_sizes", light_grid_.get_texture_sizes());
+		program->set_uniform("u_camera_position", camera_pos);
+		program->set_uniform("u_render_uv", render_uv);
+		program->set_texture(0, "s_tex0", g_buffer_fbo->get_texture(0).get());
+		program->set_texture(1, "s_tex1", g_buffer_fbo->get_texture(1).get());
+		program->set_texture(2, "s_tex2", g_buffer_fbo->get_texture(2).get());
+		program->set_texture(3, "s_tex3", g_buffer_fbo->get_texture(3).get());
+		program->set_texture(4, "s_tex4", g_buffer_fbo->get_texture(4).get());
+		program->set_texture(5, "s_tex5", refl_buffer);
+		program->set_texture(6, "s_tex6", ibl_brdf_lut_.get());
+		program->set_texture(7, "s_tex7", light_grid_.get_lights_texture());
+		program->set_texture(8, "s_tex8", light_grid_.get_clusters_texture());
+		program->set_texture(9, "s_tex9", light_grid_.get_indices_texture());
+
+		auto topology = gfx::clip_quad(1.0f);
+		gfx::set_state(topology | BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_BLEND_ADD);
+		gfx::submit(pass.id, program->native_handle());
+		gfx::set_state(BGFX_STATE_DEFAULT);
+		program->end();
+	}
 
 	return l_buffer_fbo;
 }
@@ -525,104 +1431,94 @@ deferred_rendering::reflection_probe_pass(std::shared_ptr<gfx::frame_buffer> inp
 										  gfx::render_view& render_view, entity_component_system& ecs,
 										  std::chrono::duration<float> dt)
 {
+	PROFILE_SCOPE("reflection_probe_pass");
 	const auto& view = camera.get_view();
 	const auto& proj = camera.get_projection();
 
 	const auto& viewport_size = camera.get_viewport_size();
 	auto g_buffer_fbo = render_view.get_g_buffer_fbo(viewport_size).get();
 
-	static auto refl_buffer_format = gfx::get_best_format(BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER,
-														  gfx::format_search_flags::four_channels |
-															  gfx::format_search_flags::requires_alpha |
-															  gfx::format_search_flags::half_precision_float);
+	const auto refl_buffer_format = gfx::render_view::get_light_buffer_format();
 
-	auto refl_buffer = render_view.get_texture("RBUFFER", viewport_size.width, viewport_size.height, false, 1,
-											   refl_buffer_format);
+	auto refl_buffer = render_view.get_transient_texture("RBUFFER", viewport_size.width,
+														 viewport_size.height, false, 1, refl_buffer_format);
 	auto r_buffer_fbo = render_view.get_fbo("RBUFFER", {refl_buffer});
-	const auto buffer_size = refl_buffer->get_size();
+	const auto buffer_size = render_view.get_render_size(viewport_size);
+	const auto render_uv = get_render_uv(buffer_size, r_buffer_fbo->get_size());
 
 	gfx::render_pass pass("refl_buffer_fill");
 	pass.bind(r_buffer_fbo.get());
+	pass.set_rect(0, 0, std::uint16_t(buffer_size.width), std::uint16_t(buffer_size.height));
 	pass.set_view_proj(view, proj);
 	pass.clear(BGFX_CLEAR_COLOR, 0, 0.0f, 0);
-	ecs.for_each<transform_component, reflection_probe_component>(
-		[this, &camera, &pass, &buffer_size, &view, &proj, g_buffer_fbo](
-			entity e, transform_component& transform_comp_ref, reflection_probe_component& probe_comp_ref) {
-			const auto& probe = probe_comp_ref.get_probe();
-			const auto& world_transform = transform_comp_ref.get_transform();
-			const auto& probe_position = world_transform.get_position();
-
-			irect32_t rect(0, 0, irect32_t::value_type(buffer_size.width),
-						   irect32_t::value_type(buffer_size.height));
-			if(probe_comp_ref.compute_projected_sphere_rect(rect, probe_position, view, proj) == 0)
-				return;
-
-			const auto cubemap = probe_comp_ref.get_cubemap();
-
-			gpu_program* program = nullptr;
-			float influence_radius = 0.0f;
-			if(probe.type == probe_type::sphere && sphere_ref_probe_program_)
-			{
-				program = sphere_ref_probe_program_.get();
-				program->begin();
-				influence_radius = probe.sphere_data.range;
-			}
-
-			if(probe.type == probe_type::box && box_ref_probe_program_)
-			{
-				math::transform t;
-				t.set_scale(probe.box_data.extents);
-				t = world_transform * t;
-				auto u_inv_world = math::inverse(t).get_matrix();
-				float data2[4] = {probe.box_data.extents.x, probe.box_data.extents.y,
-								  probe.box_data.extents.z, probe.box_data.transition_distance};
+	// the probes and their world data were gathered once for every view
+	for(const auto& instance : frame_probes_)
+	{
+		auto& probe_comp_ref = *instance.probe;
+		const auto& probe = probe_comp_ref.get_probe();
+		const auto& probe_position = instance.position;
 
-				program = box_ref_probe_program_.get();
-				program->begin();
-				program->set_uniform("u_inv_world", math::value_ptr(u_inv_world));
-				program->set_uniform("u_data2", data2);
+		irect32_t rect(0, 0, irect32_t::value_type(buffer_size.width),
+					   irect32_t::value_type(buffer_size.height));
+		if(probe_comp_ref.compute_projected_sphere_rect(rect, probe_position, view, proj) == 0)
+			continue;
 
-				influence_radius = math::length(t.get_scale() + probe.box_data.transition_distance);
-			}
+		const auto& cubemap = instance.cubemap;
 
-			if(program)
-			{
-				float mips = cubemap ? float(cubemap->info.numMips) : 1.0f;
-				float data0[4] = {
-					probe_position.x,
-					probe_position.y,
-					probe_position.z,
-					influence_radius,
-				};
-
-				float data1[4] = {mips, 0.0f, 0.0f, 0.0f};
+		gpu_program* program = nullptr;
+		if(probe.type == probe_type::sphere && sphere_ref_probe_program_)
+		{
+			program = sphere_ref_probe_program_.get();
+			program->begin();
+		}
 
-				program->set_uniform("u_data0", data0);
-				program->set_uniform("u_data1", data1);
+		if(probe.type == probe_type::box && box_ref_probe_program_)
+		{
+			program = box_ref_probe_program_.get();
+			program->begin();
+			program->set_uniform("u_inv_world", math::value_ptr(instance.inv_world));
+			program->set_uniform("u_data2", instance.box_data);
+		}
 
-				program->set_texture(0, "s_tex0", g_buffer_fbo->get_texture(0).get());
-				program->set_texture(1, "s_tex1", g_buffer_fbo->get_texture(1).get());
-				program->set_texture(2, "s_tex2", g_buffer_fbo->get_texture(2).get());
-				program->set_texture(3, "s_tex3", g_buffer_fbo->get_texture(3).get());
-				program->set_texture(4, "s_tex4", g_buffer_fbo->get_texture(4).get());
-				program->set_texture(5, "s_tex_cube", cubemap.get());
-				gfx::set_scissor(rect.left, rect.top, rect.width(), rect.height());
-				auto topology = gfx::clip_quad(1.0f);
-				gfx::set_state(topology | BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_BLEND_ALPHA);
-				gfx::submit(pass.id, program->native_handle());
-				gfx::set_state(BGFX_STATE_DEFAULT);
-				program->end();
-			}
-		});
+		if(program)
+		{
+			float mips = cubemap ? float(cubemap->info.numMips) : 1.0f;
+			float data0[4] = {
+				probe_position.x,
+				probe_position.y,
+				probe_position.z,
+				instance.influence_radius,
+			};
+
+			float data1[4] = {mips, 0.0f, 0.0f, 0.0f};
+
+			program->set_uniform("u_data0", data0);
+			program->set_uniform("u_data1", data1);
+			program->set_uniform("u_render_uv", render_uv);
+
+			program->set_texture(0, "s_tex0", g_buffer_fbo->get_texture(0).get());
+			program->set_texture(1, "s_tex1", g_buffer_fbo->get_texture(1).get());
+			program->set_texture(2, "s_tex2", g_buffer_fbo->get_texture(2).get());
+			program->set_texture(3, "s_tex3", g_buffer_fbo->get_texture(3).get());
+			program->set_texture(4, "s_tex4", g_buffer_fbo->get_texture(4).get());
+			program->set_texture(5, "s_tex_cube", cubemap.get());
+			gfx::set_scissor(rect.left, rect.top, rect.width(), rect.height());
+			auto topology = gfx::clip_quad(1.0f);
+			gfx::set_state(topology | BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_BLEND_ALPHA);
+			gfx::submit(pass.id, program->native_handle());
+			gfx::set_state(BGFX_STATE_DEFAULT);
+			program->end();
+		}
+	}
 
 	return r_buffer_fbo;
 }
 
 std::shared_ptr<gfx::frame_buffer>
 deferred_rendering::atmospherics_pass(std::shared_ptr<gfx::frame_buffer> input, camera& camera,
-									  gfx::render_view& render_view, entity_component_system& ecs,
-									  std::chrono::duration<float> dt)
+									  gfx::render_view& render_view, bool sun_spot)
 {
+	PROFILE_SCOPE("atmospherics_pass");
 	auto far_clip_cache = camera.get_far_clip();
 	camera.set_far_clip(10000.0f);
 	const auto& view = camera.get_view();
@@ -630,45 +1526,28 @@ deferred_rendering::atmospherics_pass(std::shared_ptr<gfx::frame_buffer> input,
 	camera.set_far_clip(far_clip_cache);
 	const auto& viewport_size = camera.get_viewport_size();
 
-	static auto light_buffer_format = gfx::get_best_format(
-		BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER, gfx::format_search_flags::four_channels |
-												  gfx::format_search_flags::requires_alpha |
-												  gfx::format_search_flags::half_precision_float);
+	const auto light_buffer_format = gfx::render_view::get_light_buffer_format();
 
-	auto light_buffer = render_view.get_texture("LBUFFER", viewport_size.width, viewport_size.height, false,
-												1, light_buffer_format, gfx::get_default_rt_sampler_flags());
+	auto light_buffer = render_view.get_transient_texture("LBUFFER", viewport_size.width,
+														  viewport_size.height, false, 1, light_buffer_format,
+														  gfx::get_default_rt_sampler_flags());
 	input = render_view.get_fbo("LBUFFER", {light_buffer, render_view.get_depth_buffer(viewport_size)});
 
 	const auto surface = input.get();
-	const auto output_size = surface->get_size();
+	const auto output_size = render_view.get_render_size(viewport_size);
 	gfx::render_pass pass("atmospherics_fill");
 	pass.set_view_proj(view, proj);
 	pass.bind(surface);
+	pass.set_rect(0, 0, std::uint16_t(output_size.width), std::uint16_t(output_size.height));
 
-	if((surface != nullptr) && atmospherics_program_)
+	const auto sky_view = sky_view_lut_.get_texture();
+	if((surface != nullptr) && atmospherics_program_ && sky_view)
 	{
-		bool found_sun = false;
-		auto light_direction = math::normalize(math::vec3(0.2f, -0.8f, 1.0f));
-		ecs.for_each<transform_component, light_component>(
-			[&light_direction, &found_sun](entity e, transform_component& transform_comp_ref,
-										   light_component& light_comp_ref) {
-				if(found_sun)
-				{
-					return;
-				}
-
-				const auto& light = light_comp_ref.get_light();
-
-				if(light.type == light_type::directional)
-				{
-					found_sun = true;
-					const auto& world_transform = transform_comp_ref.get_transform();
-					light_direction = world_transform.z_unit_axis();
-				}
-			});
-
 		atmospherics_program_->begin();
-		atmospherics_program_->set_uniform("u_light_direction", light_direction);
+		atmospherics_program_->set_texture(0, "s_sky_view", sky_view);
+		atmospherics_program_->set_uniform("u_light_direction", sky_view_lut_.get_sun_direction());
+		const auto sky_params = math::vec4(sun_spot ? 1.0f : 0.0f, 0.0f, 0.0f, 0.0f);
+		atmospherics_program_->set_uniform("u_sky_params", sky_params);
 
 		irect32_t rect(0, 0, irect32_t::value_type(output_size.width),
 					   irect32_t::value_type(output_size.height));
@@ -688,6 +1567,7 @@ std::shared_ptr<gfx::frame_buffer>
 deferred_rendering::tonemapping_pass(std::shared_ptr<gfx::frame_buffer> input, camera& camera,
 									 gfx::render_view& render_view)
 {
+	PROFILE_SCOPE("tonemapping_pass");
 	if(!input)
 		return nullptr;
 
@@ -703,6 +1583,18 @@ deferred_rendering::tonemapping_pass(std::shared_ptr<gfx::frame_buffer> input, c
 	if(surface && gamma_correction_program_)
 	{
 		gamma_correction_program_->begin();
+		// the input may cover a part of its texture, it is scaled up to the output
+		const auto input_size = input->get_size();
+		const auto render_size = render_view.get_render_size(viewport_size);
+		const auto render_uv = get_render_uv(render_size, input_size);
+		const auto half_texel = math::vec2(0.5f / float(std::max<std::uint32_t>(input_size.width, 1)),
+										   0.5f / float(std::max<std::uint32_t>(input_size.height, 1)));
+		const auto render_uv_min = math::vec2(render_uv.z, render_uv.w) + half_texel;
+		const auto render_uv_max =
+			math::vec2(render_uv.z + render_uv.x, render_uv.w + render_uv.y) - half_texel;
+		const auto render_uv_limits = math::vec4(render_uv_min, render_uv_max);
+		gamma_correction_program_->set_uniform("u_render_uv", render_uv);
+		gamma_correction_program_->set_uniform("u_render_uv_limits", render_uv_limits);
 		gamma_correction_program_->set_texture(0, "s_input", input->get_texture().get());
 		irect32_t rect(0, 0, irect32_t::value_type(output_size.width),
 					   irect32_t::value_type(output_size.height));
@@ -724,12 +1616,29 @@ void deferred_rendering::receive(entity e)
 	{
 		pair.second.erase(e);
 	}
+	cull_caches_.erase(e);
+	occlusion_buffers_.erase(e);
+	depth_prepasses_.erase(e);
+	probe_face_cameras_.remove(e.id().id());
+	light_face_cameras_.remove(e.id().id());
+
+	// the views a static caster was in have to lose its depth
+	auto it = static_caster_bounds_.find(e);
+	if(it != static_caster_bounds_.end())
+	{
+		removed_static_bounds_.push_back(it->second);
+		static_caster_bounds_.erase(it);
+	}
 }
 deferred_rendering::deferred_rendering()
 {
 	on_entity_destroyed.connect(this, &deferred_rendering::receive);
 	on_frame_render.connect(this, &deferred_rendering::frame_render);
 
+	auto& ecs = core::get_subsystem<entity_component_system>();
+	lights_query_ = ecs.get_query<transform_component, light_component>();
+	probes_query_ = ecs.get_query<transform_component, reflection_probe_component>();
+
 	auto& ts = core::get_subsystem<core::task_system>();
 	auto& am = core::get_subsystem<runtime::asset_manager>();
 	auto vs_clip_quad = am.load<gfx::shader>("engine:/data/shaders/vs_clip_quad.sc");
@@ -752,6 +1661,26 @@ deferred_rendering::deferred_rendering()
 	fs_box_reflection_probe.wait();
 	auto fs_atmospherics = am.load<gfx::shader>("engine:/data/shaders/fs_atmospherics.sc");
 	fs_atmospherics.wait();
+	auto fs_atmospherics_lut = am.load<gfx::shader>("engine:/data/shaders/fs_atmospherics_lut.sc");
+	fs_atmospherics_lut.wait();
+	auto fs_depth_downsample = am.load<gfx::shader>("engine:/data/shaders/fs_depth_downsample.sc");
+	fs_depth_downsample.wait();
+	auto fs_deferred_clustered_light =
+		am.load<gfx::shader>("engine:/data/shaders/fs_deferred_clustered_light.sc");
+	fs_deferred_clustered_light.wait();
+	auto cs_prefilter_cubemap = am.load<gfx::shader>("engine:/data/shaders/cs_prefilter_cubemap.sc");
+	cs_prefilter_cubemap.wait();
+	auto cs_irradiance_sh = am.load<gfx::shader>("engine:/data/shaders/cs_irradiance_sh.sc");
+	cs_irradiance_sh.wait();
+	auto cs_skinning = am.load<gfx::shader>("engine:/data/shaders/cs_skinning.sc");
+	cs_skinning.wait();
+	auto vs_depth_prepass = am.load<gfx::shader>("engine:/data/shaders/vs_depth_prepass.sc");
+	vs_depth_prepass.wait();
+	auto vs_depth_prepass_instanced =
+		am.load<gfx::shader>("engine:/data/shaders/vs_depth_prepass_instanced.sc");
+	vs_depth_prepass_instanced.wait();
+	auto fs_depth_prepass = am.load<gfx::shader>("engine:/data/shaders/fs_depth_prepass.sc");
+	fs_depth_prepass.wait();
 	ibl_brdf_lut_ = am.load<gfx::texture>("engine:/data/textures/ibl_brdf_lut.png").get();
 	ts.push_or_execute_on_owner_thread(
 		[this](asset_handle<gfx::shader> vs, asset_handle<gfx::shader> fs) {
@@ -766,6 +1695,12 @@ deferred_rendering::deferred_rendering()
 		},
 		vs_clip_quad, fs_deferred_spot_light);
 
+	ts.push_or_execute_on_owner_thread(
+		[this](asset_handle<gfx::shader> vs, asset_handle<gfx::shader> fs) {
+			clustered_light_program_ = std::make_unique<gpu_program>(vs, fs);
+		},
+		vs_clip_quad, fs_deferred_clustered_light);
+
 	ts.push_or_execute_on_owner_thread(
 		[this](asset_handle<gfx::shader> vs, asset_handle<gfx::shader> fs) {
 			directional_light_program_ = std::make_unique<gpu_program>(vs, fs);
@@ -800,11 +1735,51 @@ deferred_rendering::deferred_rendering()
 
 		},
 		vs_clip_quad_ex, fs_atmospherics);
+
+	ts.push_or_execute_on_owner_thread(
+		[this](asset_handle<gfx::shader> vs, asset_handle<gfx::shader> fs) {
+			atmospherics_lut_program_ = std::make_unique<gpu_program>(vs, fs);
+		},
+		vs_clip_quad, fs_atmospherics_lut);
+
+	ts.push_or_execute_on_owner_thread(
+		[this](asset_handle<gfx::shader> vs, asset_handle<gfx::shader> fs) {
+			depth_downsample_program_ = std::make_unique<gpu_program>(vs, fs);
+		},
+		vs_clip_quad, fs_depth_downsample);
+
+	ts.push_or_execute_on_owner_thread(
+		[this](asset_handle<gfx::shader> vs, asset_handle<gfx::shader> fs) {
+			depth_prepass_program_ = std::make_unique<gpu_program>(vs, fs);
+		},
+		vs_depth_prepass, fs_depth_prepass);
+
+	ts.push_or_execute_on_owner_thread(
+		[this](asset_handle<gfx::shader> vs, asset_handle<gfx::shader> fs) {
+			depth_prepass_instanced_program_ = std::make_unique<gpu_program>(vs, fs);
+		},
+		vs_depth_prepass_instanced, fs_depth_prepass);
+
+	ts.push_or_execute_on_owner_thread(
+		[this](asset_handle<gfx::shader> cs) { prefilter_program_ = std::make_unique<gpu_program>(cs); },
+		cs_prefilter_cubemap);
+
+	ts.push_or_execute_on_owner_thread(
+		[this](asset_handle<gfx::shader> cs) { irradiance_program_ = std::make_unique<gpu_program>(cs); },
+		cs_irradiance_sh);
+
+	ts.push_or_execute_on_owner_thread(
+		[this](asset_handle<gfx::shader> cs) { skinning_program_ = std::make_unique<gpu_program>(cs); },
+		cs_skinning);
 }
 
 deferred_rendering::~deferred_rendering()
 {
 	on_entity_destroyed.disconnect(this, &deferred_rendering::receive);
 	on_frame_render.disconnect(this, &deferred_rendering::frame_render);
+	if(core::has_subsystems<renderer>())
+	{
+		core::get_subsystem<renderer>().get_skinning_cache().set_compute_program(nullptr);
+	}
 }
 }
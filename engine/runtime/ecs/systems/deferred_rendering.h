@@ -1,18 +1,34 @@
 #pragma once
 
+#include "../../rendering/dynamic_resolution.h"
+#include "../../rendering/face_camera_cache.h"
 #include "../../rendering/gpu_program.h"
+#include "../../rendering/light_interactions.h"
+#include "../../rendering/light_grid.h"
+#include "../../rendering/occlusion_buffer.h"
+#include "../../rendering/probe_update_queue.h"
+#include "../../rendering/render_graph.h"
+#include "../../rendering/render_queue.h"
+#include "../../rendering/shadow_cache.h"
+#include "../../rendering/sky_view_lut.h"
 #include "../components/model_component.h"
 #include "../components/transform_component.h"
 #include "../ecs.h"
+#include "bounds_system.h"
 
 #include <core/common/basetypes.hpp>
+#include <core/memory/frame_arena.h>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <memory>
 #include <tuple>
 #include <vector>
 
 class camera;
+class camera_component;
+class reflection_probe_component;
 
 namespace gfx
 {
@@ -28,10 +44,35 @@ struct lod_data
 	std::uint32_t current_lod_index = 0;
 	std::uint32_t target_lod_index = 0;
 	float current_time = 0.0f;
+	/// frame the lod was selected in, the other views of the frame reuse it
+	std::uint64_t frame = ~std::uint64_t(0);
+	/// false when the model is too small on screen to be drawn
+	bool on_screen = false;
+	/// height on screen in percent of the viewport, with the lod bias
+	float screen_percent = 0.0f;
 };
 
+/// when the cameras draw the depth of their opaque models before the g-buffer
+enum class depth_prepass_mode : std::uint8_t
+{
+	off,
+	/// by the overdraw the last frame of the camera had
+	automatic,
+	on,
+};
+
+/// the depth pre-pass of a camera, kept between its frames
+struct depth_prepass_state
+{
+	/// screen area of the models drawn over the area of the view, an upper
+	/// bound from their spheres
+	float overdraw = 0.0f;
+	bool enabled = false;
+};
+
+/// allocated from the frame arena, only valid until the frame ends
 using visibility_set_models_t =
-	std::vector<std::tuple<entity, chandle<transform_component>, chandle<model_component>>>;
+	core::frame_vector<std::tuple<entity, chandle<transform_component>, chandle<model_component>>>;
 
 class deferred_rendering
 {
@@ -48,7 +89,32 @@ public:
 	//-----------------------------------------------------------------------------
 	visibility_set_models_t gather_visible_models(entity_component_system& ecs, camera* camera,
 												  bool dirty_only = false, bool static_only = true,
-												  bool require_reflection_caster = false);
+												  bool require_reflection_caster = false,
+												  bounds_system::cull_cache* cull_cache = nullptr,
+												  const occlusion_buffer* occlusion = nullptr,
+												  layer_mask mask = layers::all);
+
+	//-----------------------------------------------------------------------------
+	//  Name : gather_changed_models ()
+	/// <summary>
+	/// Static reflection casters whose transform or model changed since the
+	/// last rendered frame. Only walks the change history.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	visibility_set_models_t gather_changed_models(entity_component_system& ecs);
+	//-----------------------------------------------------------------------------
+	//  Name : select_lods ()
+	/// <summary>
+	/// Picks the lods of the visible models from the size of their bounding
+	/// sphere on screen, on the task system. The models a view of the same
+	/// owner already picked for in this frame keep their lod. render_scale is
+	/// the scale the view renders at, a lower one draws the models on fewer
+	/// pixels.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void select_lods(const visibility_set_models_t& visibility_set, const camera& camera, float render_scale,
+					 std::unordered_map<entity, lod_data>& camera_lods, delta_t dt);
+
 	//-----------------------------------------------------------------------------
 	//  Name : frame_render (virtual )
 	/// <summary>
@@ -69,12 +135,117 @@ public:
 	//-----------------------------------------------------------------------------
 	void receive(entity e);
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_dynamic_resolution ()
+	/// <summary>
+	/// The scale the cameras render at, off until it is enabled.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	dynamic_resolution& get_dynamic_resolution()
+	{
+		return dynamic_resolution_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_lod_bias ()
+	/// <summary>
+	/// Scales the screen size the lods are picked by, above 1 keeps the
+	/// detailed lods further away. The render scale multiplies it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_lod_bias(float bias)
+	{
+		lod_bias_ = std::max(bias, 0.0f);
+	}
+
+	float get_lod_bias() const
+	{
+		return lod_bias_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_presented_only ()
+	/// <summary>
+	/// Renders only the cameras whose output was shown in the last frame, at
+	/// the scale it was shown at, as the views of the editor present theirs.
+	/// Off renders every camera. The render interval of a camera holds in
+	/// both.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_presented_only(bool presented_only)
+	{
+		presented_only_ = presented_only;
+	}
+
+	bool is_presented_only() const
+	{
+		return presented_only_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_lod_transition_budget ()
+	/// <summary>
+	/// How many models may start a lod transition in a frame, the others
+	/// start theirs in the next ones. Zero for any.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_lod_transition_budget(std::uint32_t budget)
+	{
+		lod_transition_budget_ = budget;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_temporal_lod_fade ()
+	/// <summary>
+	/// Draws one of the two lods of a transition whole per frame, the target
+	/// in the share of the frames the fade has reached. Off draws both with
+	/// complementary dither masks in every frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_temporal_lod_fade(bool on)
+	{
+		temporal_lod_fade_ = on;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_depth_prepass ()
+	/// <summary>
+	/// Draws the depth of the opaque models that are not skinned, or skinned
+	/// by compute, from their positions before the g-buffer, which is then
+	/// tested equal to it and shaded once per pixel. Automatic turns it on for
+	/// the cameras whose models cover their view more than overdraw times.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_depth_prepass(depth_prepass_mode mode, float overdraw = 2.5f)
+	{
+		depth_prepass_mode_ = mode;
+		depth_prepass_overdraw_ = std::max(overdraw, 1.0f);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_compute_skinning ()
+	/// <summary>
+	/// Skins every palette drawn in a frame once by compute, before the views
+	/// of the frame, into vertices all the passes draw as those of the models
+	/// that are not skinned. Off, or where compute is not supported, every
+	/// pass skins them in its vertex shaders.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_compute_skinning(bool on)
+	{
+		compute_skinning_ = on;
+	}
+
+	bool get_compute_skinning() const
+	{
+		return compute_skinning_;
+	}
+
 	//-----------------------------------------------------------------------------
 	//  Name : build_reflections ()
 	/// <summary>
-	///
-	///
-	///
+	/// Invalidates the probes that changed or that a changed static model is
+	/// in and renders the faces the update queue hands out this frame.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void build_reflections_pass(entity_component_system& ecs, delta_t dt);
@@ -82,13 +253,44 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : build_shadows ()
 	/// <summary>
-	///
-	///
-	///
+	/// Gathers the casters of the lights seen by a camera once, then from them
+	/// invalidates the cached shadow views the changed static casters are in,
+	/// marks the views with dynamic casters and schedules the budget of the
+	/// invalid views to refresh. Not run until the shadow maps are rendered.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void build_shadows_pass(entity_component_system& ecs, delta_t dt);
 
+	//-----------------------------------------------------------------------------
+	//  Name : prefilter_probe ()
+	/// <summary>
+	/// Filters the mips of the prefiltered cubemap of a probe from its capture
+	/// with importance sampled GGX lobes, and projects its irradiance on the
+	/// spherical harmonics, with a chain of compute dispatches. The probe is
+	/// lit with the capture as is where they cannot run.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void prefilter_probe(reflection_probe_component& probe_comp);
+
+	//-----------------------------------------------------------------------------
+	//  Name : build_frame_snapshot ()
+	/// <summary>
+	/// The work every view of the frame shares, done once before the cameras
+	/// render: the cameras whose cull is stale are culled together in one
+	/// walk of the tree and the probes are gathered with their world data.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void build_frame_snapshot(entity_component_system& ecs);
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_rendered ()
+	/// <summary>
+	/// Whether the camera renders in this frame. The cameras of an interval
+	/// take their turns in different frames.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool is_rendered(entity ce, const camera_component& camera_comp) const;
+
 	//-----------------------------------------------------------------------------
 	//  Name : camera_pass ()
 	/// <summary>
@@ -110,6 +312,9 @@ public:
 	std::shared_ptr<gfx::frame_buffer> deferred_render_full(camera& camera, gfx::render_view& render_view,
 															entity_component_system& ecs,
 															std::unordered_map<entity, lod_data>& camera_lods,
+															bounds_system::cull_cache& cull_cache,
+															occlusion_buffer* occlusion,
+															depth_prepass_state* prepass, layer_mask mask,
 															delta_t dt);
 
 	//-----------------------------------------------------------------------------
@@ -124,7 +329,7 @@ public:
 													 gfx::render_view& render_view,
 													 visibility_set_models_t& visibility_set,
 													 std::unordered_map<entity, lod_data>& camera_lods,
-													 delta_t dt);
+													 depth_prepass_state* prepass, delta_t dt);
 
 	//-----------------------------------------------------------------------------
 	//  Name : lighting_pass ()
@@ -150,17 +355,25 @@ public:
 															 camera& camera, gfx::render_view& render_view,
 															 entity_component_system& ecs, delta_t dt);
 
+	//-----------------------------------------------------------------------------
+	//  Name : update_sky_view ()
+	/// <summary>
+	/// Renders the sky view texture again when the sun moved, before any view
+	/// of the frame samples it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void update_sky_view(entity_component_system& ecs);
+
 	//-----------------------------------------------------------------------------
 	//  Name : atmospherics_pass ()
 	/// <summary>
-	///
-	///
-	///
+	/// Adds the sky to the light buffer from the sky view texture, with the
+	/// sun spot on top of it when asked for.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	std::shared_ptr<gfx::frame_buffer> atmospherics_pass(std::shared_ptr<gfx::frame_buffer> input,
 														 camera& camera, gfx::render_view& render_view,
-														 entity_component_system& ecs, delta_t dt);
+														 bool sun_spot);
 
 	//-----------------------------------------------------------------------------
 	//  Name : tonemapping_pass ()
@@ -173,14 +386,103 @@ public:
 	std::shared_ptr<gfx::frame_buffer> tonemapping_pass(std::shared_ptr<gfx::frame_buffer> input,
 														camera& camera, gfx::render_view& render_view);
 
+	//-----------------------------------------------------------------------------
+	//  Name : add_post_passes ()
+	/// <summary>
+	/// Adds the atmospherics and the tonemapping over the light buffer to the
+	/// graph, output is set to the tonemapped resource. The probe faces go
+	/// without the sun spot.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void add_post_passes(render_graph::resource& l_buffer, render_graph::resource& output, camera& camera,
+						 gfx::render_view& render_view, bool sun_spot);
+
 private:
+	/// a reflection probe as the views of a frame draw it.
+	struct probe_instance
+	{
+		reflection_probe_component* probe = nullptr;
+		math::vec3 position;
+		/// radius of the sphere the probe affects
+		float influence_radius = 0.0f;
+		/// inverse of the box world transform and its extents with the
+		/// transition distance, for the box probes
+		math::mat4 inv_world;
+		math::vec4 box_data;
+		std::shared_ptr<gfx::texture> cubemap;
+	};
+
 	std::unordered_map<entity, std::unordered_map<entity, lod_data>> lod_data_;
+	/// plane caches of the views of every camera and probe entity, kept
+	/// between frames.
+	std::unordered_map<entity, std::vector<bounds_system::cull_cache>> cull_caches_;
+	/// depth pyramids of the camera entities, captured after their g-buffer.
+	/// Probes have none, their depth would be stale by the time they rebuild.
+	std::unordered_map<entity, occlusion_buffer> occlusion_buffers_;
+	/// depth pre-passes of the camera entities, probes draw none.
+	std::unordered_map<entity, depth_prepass_state> depth_prepasses_;
+	/// subsets of the g-buffer pass, kept to reuse its memory.
+	render_queue g_buffer_queue_;
+	/// point and spot lights of the lighting pass, kept to reuse its memory.
+	light_grid light_grid_;
+	/// passes of the view being rendered, and their times of the last frame.
+	render_graph render_graph_;
+	/// scale the cameras render at, from the gpu time of the frames.
+	dynamic_resolution dynamic_resolution_;
+	/// scale of the screen size the lods are picked by.
+	float lod_bias_ = 1.0f;
+	/// only the cameras whose output is shown render.
+	bool presented_only_ = false;
+	/// lod transitions that may start in a frame, zero for any.
+	std::uint32_t lod_transition_budget_ = 64;
+	/// what is left of the budget in lod_budget_frame_, taken on the workers.
+	std::atomic<std::int32_t> lod_transitions_left_ = {0};
+	std::uint64_t lod_budget_frame_ = ~std::uint64_t(0);
+	/// one lod per frame during a transition rather than both.
+	bool temporal_lod_fade_ = true;
+	depth_prepass_mode depth_prepass_mode_ = depth_prepass_mode::automatic;
+	bool compute_skinning_ = false;
+	/// overdraw the automatic pre-pass turns on above.
+	float depth_prepass_overdraw_ = 2.5f;
+	/// faces of the reflection probes waiting to be rendered again.
+	probe_update_queue probe_updates_;
+	/// cube face cameras of the reflection probes.
+	face_camera_cache probe_face_cameras_;
+	/// cube face cameras of the point lights, for their shadow views.
+	face_camera_cache light_face_cameras_;
+	/// the probes of the frame, gathered once for the views.
+	std::vector<probe_instance> frame_probes_;
+	/// the lights and the probes, kept listed by the entity_component_system.
+	entity_component_system::query<transform_component, light_component> lights_query_;
+	entity_component_system::query<transform_component, reflection_probe_component> probes_query_;
+	/// the cameras culled together in a frame and their hits, kept to reuse
+	/// their memory.
+	struct frame_camera
+	{
+		const camera* view = nullptr;
+		bounds_system::cull_cache* cache = nullptr;
+		layer_mask mask = layers::all;
+	};
+	std::vector<frame_camera> frame_cameras_;
+	std::vector<bounds_system::view_hit> frame_hits_;
+	/// shadow views of the lights whose static depth is up to date.
+	shadow_cache shadow_cache_;
+	/// the shadow casters of the lights seen in the frame.
+	light_interactions light_interactions_;
+	/// the shadow views refreshed in a frame, kept to reuse its memory.
+	std::vector<shadow_cache::refresh> shadow_refreshes_;
+	/// boxes of the static shadow casters as the cached depth has them.
+	std::unordered_map<entity, math::bbox> static_caster_bounds_;
+	/// boxes of the static shadow casters destroyed since the last frame.
+	std::vector<math::bbox> removed_static_bounds_;
 	/// Program that is responsible for rendering.
 	std::unique_ptr<gpu_program> directional_light_program_;
 	/// Program that is responsible for rendering.
 	std::unique_ptr<gpu_program> point_light_program_;
 	/// Program that is responsible for rendering.
 	std::unique_ptr<gpu_program> spot_light_program_;
+	/// Program that shades the point and spot lights of a light grid at once.
+	std::unique_ptr<gpu_program> clustered_light_program_;
 	/// Program that is responsible for rendering.
 	std::unique_ptr<gpu_program> box_ref_probe_program_;
 	/// Program that is responsible for rendering.
@@ -189,7 +491,24 @@ private:
 	std::unique_ptr<gpu_program> gamma_correction_program_;
 	/// Program that is responsible for rendering.
 	std::unique_ptr<gpu_program> atmospherics_program_;
+	/// Program that renders the scattering into the sky view texture.
+	std::unique_ptr<gpu_program> atmospherics_lut_program_;
+	/// the sky of the frame, sampled by all the views.
+	sky_view_lut sky_view_lut_;
+	/// Program that halves the depth for the occlusion buffers.
+	std::unique_ptr<gpu_program> depth_downsample_program_;
+	/// Programs drawing the depth of the pre-pass from the positions.
+	std::unique_ptr<gpu_program> depth_prepass_program_;
+	std::unique_ptr<gpu_program> depth_prepass_instanced_program_;
+	/// Compute programs prefiltering the probe cubemaps and projecting their
+	/// irradiance.
+	std::unique_ptr<gpu_program> prefilter_program_;
+	std::unique_ptr<gpu_program> irradiance_program_;
+	/// Compute program skinning the palettes of the frame.
+	std::unique_ptr<gpu_program> skinning_program_;
 	///
 	asset_handle<gfx::texture> ibl_brdf_lut_;
+	/// first frame whose component changes were not handled yet.
+	std::uint64_t changes_version_ = 0;
 };
 }
@@ -1,5 +1,5 @@
 #include "reflection_probe_system.h"
-#include "../../system/events.h"
+#include "system_scheduler.h"
 #include "../components/reflection_probe_component.h"
 
 #include <core/system/subsystem.h>
@@ -10,17 +10,24 @@ void reflection_probe_system::frame_update(delta_t dt)
 {
 	auto& ecs = core::get_subsystem<entity_component_system>();
 
-	ecs.for_each<reflection_probe_component>(
+	ecs.each<reflection_probe_component>(
 		[](entity e, reflection_probe_component& probe) { probe.update(); });
 }
 
 reflection_probe_system::reflection_probe_system()
 {
-	on_frame_update.connect(this, &reflection_probe_system::frame_update);
+	// the render views release graphics resources which is owner thread only.
+	system_access access;
+	access.write<reflection_probe_component>().on_owner_thread();
+	// releasing what the views no longer use can wait
+	system_schedule schedule;
+	schedule.at_rate(5.0f).deferrable();
+	core::get_subsystem<system_scheduler>().add_system(this, &reflection_probe_system::frame_update, access,
+														"reflection_probe_system", schedule);
 }
 
 reflection_probe_system::~reflection_probe_system()
 {
-	on_frame_update.disconnect(this, &reflection_probe_system::frame_update);
+	core::get_subsystem<system_scheduler>().remove_system(this);
 }
 }
@@ -1,5 +1,4 @@
 #include "scene_graph.h"
-#include "../../system/events.h"
 #include "../components/transform_component.h"
 
 #include <core/system/subsystem.h>
@@ -7,38 +6,112 @@
 namespace runtime
 {
 
-void scene_graph::frame_update(delta_t dt)
+scene_graph::scene_graph()
 {
+	runtime::on_entity_created.connect(this, &scene_graph::on_entity_created);
+	runtime::on_entity_destroyed.connect(this, &scene_graph::on_entity_destroyed);
+	runtime::on_component_added.connect(this, &scene_graph::on_component_added);
+	runtime::on_component_removed.connect(this, &scene_graph::on_component_removed);
+	runtime::on_parent_changed.connect(this, &scene_graph::on_parent_changed);
+
+	transform_component::static_id();
+
+	// pick up the entities created before the scene graph
 	auto& ecs = core::get_subsystem<runtime::entity_component_system>();
-	roots_.clear();
-	auto all_entities = ecs.all_entities();
-	for(const auto entity : all_entities)
+	for(const auto entity : ecs.all_entities())
+	{
+		update_root(entity);
+	}
+}
+
+scene_graph::~scene_graph()
+{
+	runtime::on_entity_created.disconnect(this, &scene_graph::on_entity_created);
+	runtime::on_entity_destroyed.disconnect(this, &scene_graph::on_entity_destroyed);
+	runtime::on_component_added.disconnect(this, &scene_graph::on_component_added);
+	runtime::on_component_removed.disconnect(this, &scene_graph::on_component_removed);
+	runtime::on_parent_changed.disconnect(this, &scene_graph::on_parent_changed);
+}
+
+const std::vector<entity>& scene_graph::get_roots() const
+{
+	if(roots_dirty_)
 	{
-		auto transform_comp = entity.get_component<transform_component>().lock();
-		if(transform_comp)
+		roots_.clear();
+		for(const auto& slot : root_slots_)
 		{
-			auto parent = transform_comp->get_parent();
-			if(parent.valid() == false)
+			if(slot)
 			{
-				roots_.push_back(entity);
+				roots_.push_back(slot);
 			}
 		}
-		else
-		{
-			roots_.push_back(entity);
-		}
+		roots_dirty_ = false;
 	}
+	return roots_;
 }
 
-scene_graph::scene_graph()
+void scene_graph::on_entity_created(entity e)
 {
-	runtime::on_frame_update.connect(this, &scene_graph::frame_update);
+	++version_;
+	update_root(e);
+}
 
-	transform_component::static_id();
+void scene_graph::on_entity_destroyed(entity e)
+{
+	++version_;
+	set_root(e, false);
 }
 
-scene_graph::~scene_graph()
+void scene_graph::on_component_added(entity e, chandle<component> c)
+{
+	if(std::dynamic_pointer_cast<transform_component>(c.lock()))
+	{
+		++version_;
+		update_root(e);
+	}
+}
+
+void scene_graph::on_component_removed(entity e, chandle<component> c)
+{
+	// the entity still has the transform while this is emitted
+	if(std::dynamic_pointer_cast<transform_component>(c.lock()))
+	{
+		++version_;
+		set_root(e, true);
+	}
+}
+
+void scene_graph::on_parent_changed(entity e)
+{
+	++version_;
+	update_root(e);
+}
+
+void scene_graph::update_root(entity e)
 {
-	runtime::on_frame_update.disconnect(this, &scene_graph::frame_update);
+	auto transform_comp = e.get_component<transform_component>().lock();
+	set_root(e, !transform_comp || !transform_comp->get_parent().valid());
+}
+
+void scene_graph::set_root(entity e, bool root)
+{
+	const auto index = e.id().index();
+	if(index >= root_slots_.size())
+	{
+		if(!root)
+		{
+			return;
+		}
+		root_slots_.resize(index + 1);
+	}
+
+	auto& slot = root_slots_[index];
+	if(root == bool(slot) && (!root || slot == e))
+	{
+		return;
+	}
+
+	slot = root ? e : entity();
+	roots_dirty_ = true;
 }
 }
@@ -4,40 +4,62 @@
 
 #include <core/common/basetypes.hpp>
 
+#include <cstdint>
 #include <vector>
 
 namespace runtime
 {
+/*
+ * scene_graph; keeps the entities that have no parent.
+ *
+ *      The roots are updated from the entity, component and parent change
+ *      events, so nothing is walked while the hierarchy stays the same.
+ */
 class scene_graph
 {
 public:
 	scene_graph();
 	~scene_graph();
+
 	//-----------------------------------------------------------------------------
-	//  Name : frame_update (virtual )
+	//  Name : getRoots ()
 	/// <summary>
-	///
-	///
-	///
+	/// Returns the entities without a parent ordered by their index. The list
+	/// is only rebuilt here after a change, so a reference stays valid until
+	/// the next call.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	void frame_update(delta_t dt);
+	const std::vector<entity>& get_roots() const;
 
 	//-----------------------------------------------------------------------------
-	//  Name : getRoots ()
+	//  Name : get_version ()
 	/// <summary>
-	///
-	///
-	///
+	/// Changes whenever an entity is created or destroyed or a parent is set,
+	/// for the views of the hierarchy to know when to rebuild what they keep.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	const std::vector<entity>& get_roots() const
+	std::uint64_t get_version() const
 	{
-		return roots_;
+		return version_;
 	}
 
 private:
+	void on_entity_created(entity e);
+	void on_entity_destroyed(entity e);
+	void on_component_added(entity e, chandle<component> c);
+	void on_component_removed(entity e, chandle<component> c);
+	void on_parent_changed(entity e);
+
+	/// updates the root slot of the entity from its transform
+	void update_root(entity e);
+	void set_root(entity e, bool root);
+
+	/// per entity index, the entity if it is a root or an invalid one.
+	std::vector<entity> root_slots_;
 	/// scene roots
-	std::vector<entity> roots_;
+	mutable std::vector<entity> roots_;
+	mutable bool roots_dirty_ = true;
+	/// bumped on every change of the hierarchy
+	std::uint64_t version_ = 0;
 };
 }
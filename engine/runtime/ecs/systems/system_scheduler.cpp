@@ -0,0 +1,252 @@
+#include "system_scheduler.h"
+#include "../../system/events.h"
+
+#include <core/logging/logging.h>
+#include <core/profiling/memory_tracker.h>
+#include <core/profiling/profiler.h>
+#include <core/system/subsystem.h>
+
+#include <algorithm>
+
+namespace runtime
+{
+
+bool system_access::conflicts_with(const system_access& other) const
+{
+	if(is_structural || other.is_structural)
+	{
+		return true;
+	}
+
+	return (writes & (other.reads | other.writes)).any() || (other.writes & reads).any();
+}
+
+system_scheduler::system_scheduler()
+{
+	on_frame_update.connect(this, &system_scheduler::frame_update);
+}
+
+system_scheduler::~system_scheduler()
+{
+	on_frame_update.disconnect(this, &system_scheduler::frame_update);
+}
+
+void system_scheduler::add_system(const void* key, update_t update, const system_access& access,
+								  const std::string& name, const system_schedule& schedule)
+{
+	expects(!graph_ || !graph_->is_running());
+
+	system_entry entry;
+	entry.key = key;
+	entry.update = std::move(update);
+	entry.access = access;
+	entry.schedule = schedule;
+	entry.name = name;
+	entry.profile_name = profiling::intern(name);
+	entry.stats.name = name;
+	entry.stats.rate = schedule.rate;
+	entry.stats.is_deferrable = schedule.is_deferrable;
+	systems_.emplace_back(std::move(entry));
+	sort_systems();
+	graph_dirty_ = true;
+}
+
+void system_scheduler::remove_system(const void* key)
+{
+	expects(!graph_ || !graph_->is_running());
+
+	systems_.erase(std::remove_if(std::begin(systems_), std::end(systems_),
+								  [key](const auto& entry) { return entry.key == key; }),
+				   std::end(systems_));
+	sort_systems();
+	graph_dirty_ = true;
+}
+
+std::vector<system_scheduler::system_stats> system_scheduler::get_stats() const
+{
+	std::vector<system_stats> stats;
+	stats.reserve(order_.size());
+	for(const auto index : order_)
+	{
+		stats.push_back(systems_[index].stats);
+	}
+	return stats;
+}
+
+void system_scheduler::sort_systems()
+{
+	const auto find_system = [this](const std::string& name) {
+		return std::find_if(std::begin(systems_), std::end(systems_),
+							[&name](const system_entry& entry) { return entry.name == name; });
+	};
+
+	// the first system added whose systems to run after are all placed
+	order_.clear();
+	std::vector<bool> placed(systems_.size(), false);
+	while(order_.size() < systems_.size())
+	{
+		std::size_t next = systems_.size();
+		std::size_t first = systems_.size();
+		for(std::size_t i = 0; i < systems_.size() && next == systems_.size(); ++i)
+		{
+			if(placed[i])
+			{
+				continue;
+			}
+			first = std::min(first, i);
+			const auto& after = systems_[i].schedule.after_systems;
+			const bool ready = std::all_of(std::begin(after), std::end(after), [&](const std::string& name) {
+				auto it = find_system(name);
+				return it == std::end(systems_) || placed[std::size_t(it - std::begin(systems_))];
+			});
+			if(ready)
+			{
+				next = i;
+			}
+		}
+
+		if(next == systems_.size())
+		{
+			APPLOG_WARNING("The system {0} is scheduled after systems that run after it, it runs first.",
+						   systems_[first].name);
+			next = first;
+		}
+		placed[next] = true;
+		order_.push_back(next);
+	}
+}
+
+void system_scheduler::select_systems(delta_t dt)
+{
+	clock_t::duration spent = clock_t::duration::zero();
+	std::vector<system_entry*> deferrable;
+	for(auto& entry : systems_)
+	{
+		entry.waited += dt;
+		const auto& schedule = entry.schedule;
+		const bool due = schedule.rate <= 0.0f || entry.waited.count() * schedule.rate >= 1.0f;
+		const bool may_wait = schedule.is_deferrable && entry.deferred_frames < max_deferred_frames;
+		entry.runs = due && !(may_wait && budget_ > clock_t::duration::zero());
+		if(entry.runs)
+		{
+			spent += entry.stats.average_cost;
+		}
+		else if(due)
+		{
+			deferrable.push_back(&entry);
+		}
+	}
+
+	// what waited the longest first, while the budget holds
+	std::stable_sort(std::begin(deferrable), std::end(deferrable),
+					 [](const system_entry* a, const system_entry* b) { return a->waited > b->waited; });
+	for(auto entry : deferrable)
+	{
+		if(spent + entry->stats.average_cost <= budget_)
+		{
+			entry->runs = true;
+			spent += entry->stats.average_cost;
+		}
+		else
+		{
+			++entry->deferred_frames;
+			++entry->stats.deferrals;
+		}
+	}
+
+	for(auto& entry : systems_)
+	{
+		if(entry.runs)
+		{
+			entry.dt = entry.waited;
+			entry.waited = delta_t::zero();
+			entry.deferred_frames = 0;
+		}
+	}
+}
+
+void system_scheduler::run_system(system_entry& entry)
+{
+	if(!entry.runs)
+	{
+		return;
+	}
+
+	PROFILE_SCOPE(entry.profile_name);
+	core::scoped_memory_tag alloc_tag(core::memory_tag::ecs);
+	const auto begin = clock_t::now();
+	entry.update(entry.dt);
+	auto& stats = entry.stats;
+	stats.last_cost = clock_t::now() - begin;
+	// a running average over about the last 8 runs
+	stats.average_cost = stats.runs == 0 ? stats.last_cost
+										 : stats.average_cost + (stats.last_cost - stats.average_cost) / 8;
+	++stats.runs;
+}
+
+void system_scheduler::frame_update(delta_t dt)
+{
+	PROFILE_SCOPE("systems");
+	select_systems(dt);
+	if(!parallel_)
+	{
+		for(const auto index : order_)
+		{
+			run_system(systems_[index]);
+		}
+		return;
+	}
+
+	if(graph_dirty_)
+	{
+		build_graph();
+	}
+
+	graph_->run();
+}
+
+void system_scheduler::build_graph()
+{
+	if(!graph_)
+	{
+		graph_ = std::make_unique<core::job_graph>(core::get_subsystem<core::task_system>());
+	}
+
+	// the nodes are in the order the systems run, a system that does not
+	// run in a frame returns at once and those after it still wait for it
+	graph_->clear();
+	for(const auto index : order_)
+	{
+		const auto& entry = systems_[index];
+		auto job = [this, index]() { run_system(systems_[index]); };
+		if(entry.access.is_structural || entry.access.is_owner_thread)
+		{
+			graph_->add_owner_node(job, entry.name);
+		}
+		else
+		{
+			graph_->add_node(job, entry.name);
+		}
+	}
+
+	// a conflicting pair runs in that order, as does a system scheduled
+	// after another
+	for(std::size_t after = 0; after < order_.size(); ++after)
+	{
+		const auto& later = systems_[order_[after]];
+		for(std::size_t before = 0; before < after; ++before)
+		{
+			const auto& earlier = systems_[order_[before]];
+			const auto& after_systems = later.schedule.after_systems;
+			const bool scheduled_after = std::find(std::begin(after_systems), std::end(after_systems),
+												   earlier.name) != std::end(after_systems);
+			if(scheduled_after || earlier.access.conflicts_with(later.access))
+			{
+				graph_->add_edge(before, after);
+			}
+		}
+	}
+
+	graph_dirty_ = false;
+}
+}
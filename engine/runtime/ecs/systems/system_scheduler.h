@@ -0,0 +1,280 @@
+#pragma once
+
+#include "../ecs.h"
+
+#include <core/common/basetypes.hpp>
+#include <core/tasks/job_graph.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace runtime
+{
+/*
+ * system_access; the components a system reads and writes in its update.
+ *
+ *      Two systems conflict when one of them writes a component type the
+ *      other one reads or writes. A structural system creates or destroys
+ *      entities or assigns and removes components, it conflicts with every
+ *      other system.
+ */
+struct system_access
+{
+	using component_mask_t = entity_component_system::component_mask_t;
+
+	template <typename... Components>
+	system_access& read()
+	{
+		reads |= get_mask<Components...>();
+		return *this;
+	}
+
+	template <typename... Components>
+	system_access& write()
+	{
+		writes |= get_mask<Components...>();
+		return *this;
+	}
+
+	system_access& structural()
+	{
+		is_structural = true;
+		return *this;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : on_owner_thread ()
+	/// <summary>
+	/// The system must run on the owner thread, e.g. because it creates or
+	/// destroys graphics resources.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	system_access& on_owner_thread()
+	{
+		is_owner_thread = true;
+		return *this;
+	}
+
+	bool conflicts_with(const system_access& other) const;
+
+	component_mask_t reads;
+	component_mask_t writes;
+	bool is_structural = false;
+	bool is_owner_thread = false;
+
+private:
+	template <typename... Components>
+	static component_mask_t get_mask()
+	{
+		component_mask_t mask;
+		using expand = int[];
+		(void)expand{0, (mask.set(rtti::type_index_sequential_t::id<component, Components>()), 0)...};
+		return mask;
+	}
+};
+
+/*
+ * system_schedule; when a system runs besides what it accesses: the systems
+ * it runs after, how often it runs and whether it may wait for a later
+ * frame when the systems are over their budget.
+ *
+ *      A system running at a rate is given the time since it last ran. A
+ *      deferrable one is run at the latest after max_deferred_frames frames.
+ */
+struct system_schedule
+{
+	//-----------------------------------------------------------------------------
+	//  Name : after ()
+	/// <summary>
+	/// The system runs after the named one, whatever they access and the
+	/// order they were added in.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	system_schedule& after(const std::string& name)
+	{
+		after_systems.push_back(name);
+		return *this;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : at_rate ()
+	/// <summary>
+	/// The system runs at most this many times a second, 0 for every frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	system_schedule& at_rate(float hz)
+	{
+		rate = hz;
+		return *this;
+	}
+
+	system_schedule& deferrable()
+	{
+		is_deferrable = true;
+		return *this;
+	}
+
+	std::vector<std::string> after_systems;
+	float rate = 0.0f;
+	bool is_deferrable = false;
+};
+
+/*
+ * system_scheduler; runs the frame update of the registered systems on the
+ * task system.
+ *
+ *      Systems that conflict keep the order in which they were added, unless
+ *      their schedules order them, the others run concurrently. Structural
+ *      and owner thread systems run on the owner thread while it waits for
+ *      the frame. The cost of every update is measured. With a budget, the
+ *      deferrable systems due in a frame run while the average costs of the
+ *      systems running stay within it, those that waited the longest first,
+ *      the others wait for a later frame.
+ */
+class system_scheduler
+{
+public:
+	using update_t = std::function<void(delta_t)>;
+	using clock_t = std::chrono::steady_clock;
+
+	/// the frames a deferrable system may wait for before it runs anyway
+	static constexpr std::uint32_t max_deferred_frames = 8;
+
+	struct system_stats
+	{
+		std::string name;
+		clock_t::duration last_cost{};
+		clock_t::duration average_cost{};
+		float rate = 0.0f;
+		bool is_deferrable = false;
+		std::uint64_t runs = 0;
+		/// the frames it was due and waited for the budget
+		std::uint64_t deferrals = 0;
+	};
+
+	system_scheduler();
+	~system_scheduler();
+
+	//-----------------------------------------------------------------------------
+	//  Name : add_system ()
+	/// <summary>
+	/// Registers the update of a system. The object is used as a key for
+	/// remove_system.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template <typename C>
+	void add_system(C* const object, void (C::*const method)(delta_t), const system_access& access,
+					const std::string& name, const system_schedule& schedule = {})
+	{
+		add_system(static_cast<const void*>(object), [object, method](delta_t dt) { (object->*method)(dt); },
+				   access, name, schedule);
+	}
+
+	void add_system(const void* key, update_t update, const system_access& access, const std::string& name,
+					const system_schedule& schedule = {});
+
+	//-----------------------------------------------------------------------------
+	//  Name : remove_system ()
+	/// <summary>
+	/// Removes every update registered with the given key.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void remove_system(const void* key);
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_parallel ()
+	/// <summary>
+	/// When disabled the systems run one after the other on the calling
+	/// thread in the order they were added. Useful to rule out races.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_parallel(bool parallel)
+	{
+		parallel_ = parallel;
+	}
+
+	bool is_parallel() const
+	{
+		return parallel_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_budget ()
+	/// <summary>
+	/// The time the updates of the systems of a frame should take, summed.
+	/// The deferrable systems wait while the others take it. 0 for none.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_budget(clock_t::duration budget)
+	{
+		budget_ = budget;
+	}
+
+	clock_t::duration get_budget() const
+	{
+		return budget_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_stats ()
+	/// <summary>
+	/// The measured costs of the systems, in the order they run.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::vector<system_stats> get_stats() const;
+
+	void frame_update(delta_t dt);
+
+private:
+	struct system_entry
+	{
+		const void* key = nullptr;
+		update_t update;
+		system_access access;
+		system_schedule schedule;
+		std::string name;
+		/// the name of the zone of its update
+		const char* profile_name = nullptr;
+		/// the time since it last ran, given to its next update
+		delta_t waited = delta_t::zero();
+		/// it runs in the frame, with the delta
+		bool runs = false;
+		delta_t dt = delta_t::zero();
+		std::uint32_t deferred_frames = 0;
+		system_stats stats;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : sort_systems ()
+	/// <summary>
+	/// The order the systems run in, the one they were added in but for the
+	/// systems their schedules put after others.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void sort_systems();
+
+	//-----------------------------------------------------------------------------
+	//  Name : select_systems ()
+	/// <summary>
+	/// Marks the systems that run in the frame, by their rates and the budget.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void select_systems(delta_t dt);
+
+	void run_system(system_entry& entry);
+	void build_graph();
+
+	std::vector<system_entry> systems_;
+	/// the indices of the systems in the order they run
+	std::vector<std::size_t> order_;
+	/// rebuilt lazily when the systems change.
+	std::unique_ptr<core::job_graph> graph_;
+	bool graph_dirty_ = true;
+	bool parallel_ = true;
+	clock_t::duration budget_ = clock_t::duration::zero();
+};
+}
@@ -0,0 +1,165 @@
+#include "transform_system.h"
+#include "system_scheduler.h"
+#include "../components/transform_component.h"
+
+#include <core/system/subsystem.h>
+#include <core/tasks/task_group.h>
+
+namespace runtime
+{
+
+transform_system::transform_system()
+{
+	on_transform_dirty.connect(this, &transform_system::on_transform_dirty);
+	on_component_added.connect(this, &transform_system::on_component_added);
+
+	system_access access;
+	access.write<transform_component>();
+	core::get_subsystem<system_scheduler>().add_system(this, &transform_system::frame_update, access,
+														"transform_system");
+}
+
+transform_system::~transform_system()
+{
+	core::get_subsystem<system_scheduler>().remove_system(this);
+
+	on_transform_dirty.disconnect(this, &transform_system::on_transform_dirty);
+	on_component_added.disconnect(this, &transform_system::on_component_added);
+}
+
+void transform_system::frame_update(delta_t)
+{
+	std::vector<entity> pending;
+	{
+		std::lock_guard<std::mutex> lock(pending_mutex_);
+		pending.swap(pending_);
+		for(const auto& e : pending)
+		{
+			const auto index = e.id().index();
+			pending_mask_[index / 64] &= ~(std::uint64_t(1) << (index % 64));
+		}
+	}
+
+	if(pending.empty())
+	{
+		return;
+	}
+
+	build_levels(pending);
+	propagate();
+}
+
+void transform_system::on_transform_dirty(entity e)
+{
+	const auto index = e.id().index();
+	const auto bit = std::uint64_t(1) << (index % 64);
+
+	std::lock_guard<std::mutex> lock(pending_mutex_);
+	if(pending_mask_.size() <= index / 64)
+	{
+		pending_mask_.resize(index / 64 + 1, 0);
+	}
+	auto& word = pending_mask_[index / 64];
+	if((word & bit) == 0)
+	{
+		word |= bit;
+		pending_.push_back(e);
+	}
+}
+
+void transform_system::on_component_added(entity e, chandle<component> c)
+{
+	// new transforms start dirty without going through set_dirty
+	if(std::dynamic_pointer_cast<transform_component>(c.lock()))
+	{
+		on_transform_dirty(e);
+	}
+}
+
+void transform_system::build_levels(const std::vector<entity>& pending)
+{
+	nodes_.clear();
+	parents_.clear();
+	locals_.clear();
+	worlds_.clear();
+	level_begins_.clear();
+
+	// the tops of the dirty subtrees, their parent is already resolved
+	for(const auto& e : pending)
+	{
+		if(!e.valid())
+		{
+			continue;
+		}
+
+		auto transform_comp = e.get_component<transform_component>().lock();
+		if(!transform_comp || !transform_comp->is_dirty())
+		{
+			continue;
+		}
+
+		const auto& parent = transform_comp->get_parent();
+		auto parent_transform = parent.valid() ? parent.get_component<transform_component>().lock() : nullptr;
+		if(parent_transform && parent_transform->is_dirty())
+		{
+			continue;
+		}
+
+		const auto parent_world =
+			parent_transform ? matrix_t(parent_transform->world_transform_.get_matrix()) : matrix_t(1.0f);
+		add_node(transform_comp.get(), no_parent, parent_world);
+	}
+
+	// the components are owned by their pools, the raw pointers stay valid
+	// for the pass since nothing else touches transforms meanwhile.
+	std::size_t level_begin = 0;
+	while(level_begin < nodes_.size())
+	{
+		level_begins_.push_back(level_begin);
+		const auto level_end = nodes_.size();
+		for(auto i = level_begin; i < level_end; ++i)
+		{
+			const auto* node = nodes_[i];
+			for(const auto& child : node->children_)
+			{
+				auto child_transform =
+					child.valid() ? child.get_component<transform_component>().lock() : nullptr;
+				if(child_transform)
+				{
+					add_node(child_transform.get(), static_cast<std::uint32_t>(i), matrix_t(1.0f));
+				}
+			}
+		}
+		level_begin = level_end;
+	}
+	level_begins_.push_back(nodes_.size());
+}
+
+void transform_system::add_node(transform_component* node, std::uint32_t parent,
+								const matrix_t& parent_world)
+{
+	nodes_.push_back(node);
+	parents_.push_back(parent);
+	// the local matrix is composed lazily, do it here and not in the parallel pass
+	locals_.emplace_back(node->local_transform_.get_matrix());
+	worlds_.push_back(parent_world);
+}
+
+void transform_system::propagate()
+{
+	auto& ts = core::get_subsystem<core::task_system>();
+	for(std::size_t level = 0; level + 1 < level_begins_.size(); ++level)
+	{
+		// decomposing the world matrix dominates, so the chunks can be small
+		core::parallel_for(ts, level_begins_[level], level_begins_[level + 1], std::size_t(64),
+						   [this](std::size_t i) {
+							   const auto parent = parents_[i];
+							   worlds_[i] = (parent == no_parent ? worlds_[i] : worlds_[parent]) * locals_[i];
+
+							   auto* node = nodes_[i];
+							   node->world_transform_ = math::transform(math::mat4(worlds_[i]));
+							   node->dirty_ = false;
+						   });
+	}
+}
+}
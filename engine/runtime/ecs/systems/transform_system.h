@@ -0,0 +1,81 @@
+#pragma once
+
+#include "../ecs.h"
+
+#include <core/common/basetypes.hpp>
+#include <core/math/math_includes.h>
+
+#if defined(GLM_FORCE_INTRINSICS) && defined(GLM_FORCE_ALIGNED_GENTYPES)
+#include <glm/gtc/type_aligned.hpp>
+#endif
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+class transform_component;
+
+namespace runtime
+{
+/*
+ * transform_system; resolves the world transforms of the dirty transforms
+ * once per frame.
+ *
+ *      The dirty subtrees are flattened breadth first into arrays of local
+ *      and world matrices sorted by depth. Every depth level is then a linear
+ *      pass that runs in parallel on the task system. Transforms read before
+ *      the pass still resolve lazily.
+ */
+class transform_system
+{
+public:
+#if defined(GLM_FORCE_INTRINSICS) && defined(GLM_FORCE_ALIGNED_GENTYPES)
+	/// lets glm use its simd matrix multiply.
+	using matrix_t = glm::aligned_mat4;
+#else
+	using matrix_t = math::mat4;
+#endif
+
+	transform_system();
+	~transform_system();
+	//-----------------------------------------------------------------------------
+	//  Name : frame_update (virtual )
+	/// <summary>
+	/// Resolves the transforms that became dirty since the last update.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void frame_update(delta_t dt);
+
+private:
+	void on_transform_dirty(entity e);
+	void on_component_added(entity e, chandle<component> c);
+
+	//-----------------------------------------------------------------------------
+	//  Name : build_levels ()
+	/// <summary>
+	/// Flattens the dirty subtrees of the pending entities by depth.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void build_levels(const std::vector<entity>& pending);
+	void add_node(transform_component* node, std::uint32_t parent, const matrix_t& parent_world);
+	void propagate();
+
+	static constexpr std::uint32_t no_parent = ~std::uint32_t(0);
+
+	/// transforms are dirtied from any thread
+	std::mutex pending_mutex_;
+	std::vector<entity> pending_;
+	/// one bit per entity index, set while the entity is in pending_
+	std::vector<std::uint64_t> pending_mask_;
+
+	/// the flattened hierarchy, each level follows its parent level.
+	std::vector<transform_component*> nodes_;
+	/// index of the parent node, no_parent for the top of a subtree
+	std::vector<std::uint32_t> parents_;
+	std::vector<matrix_t> locals_;
+	/// holds the resolved parent matrix of the top nodes until the pass
+	std::vector<matrix_t> worlds_;
+	/// first node of every level and one past the last node.
+	std::vector<std::size_t> level_begins_;
+};
+}
@@ -0,0 +1,248 @@
+#include "world_streaming.h"
+#include "../components/camera_component.h"
+#include "../constructs/scene.h"
+#include "../constructs/utils.h"
+#include "../../assets/asset_manager.h"
+#include "../../system/events.h"
+
+#include <core/logging/logging.h>
+#include <core/serialization/compact_archive.h>
+#include <core/system/subsystem.h>
+
+#include <iterator>
+#include <limits>
+
+namespace runtime
+{
+world_streaming::world_streaming()
+{
+	on_frame_update.connect(this, &world_streaming::frame_update);
+}
+
+world_streaming::~world_streaming()
+{
+	on_frame_update.disconnect(this, &world_streaming::frame_update);
+}
+
+void world_streaming::open(const std::string& key)
+{
+	close();
+
+	auto& am = core::get_subsystem<asset_manager>();
+	key_ = key;
+	scene_ = am.load<scene>(key);
+	stage_ = stage::assets;
+}
+
+void world_streaming::close()
+{
+	const bool was_streaming = stage_ == stage::streaming;
+	for(std::size_t i = 0; i < loaded_.size(); ++i)
+	{
+		unload(i);
+	}
+
+	stage_ = stage::idle;
+	scene_ = {};
+	parsed_ = {};
+	cells_.reset();
+	roots_.clear();
+	loaded_.clear();
+	memory_used_ = 0;
+
+	if(was_streaming)
+	{
+		// what only the cells used is let go
+		core::get_subsystem<asset_manager>().request_sweep();
+	}
+}
+
+std::size_t world_streaming::get_loaded_cells_count() const
+{
+	return std::size_t(std::count(std::begin(loaded_), std::end(loaded_), char(1)));
+}
+
+std::size_t world_streaming::get_cell_bytes(std::size_t index) const
+{
+	return cells_->get_cells()[index].size * sizeof(cereal::compact_tree::node);
+}
+
+void world_streaming::unload(std::size_t index)
+{
+	if(!loaded_[index])
+	{
+		return;
+	}
+
+	auto& ecs = core::get_subsystem<entity_component_system>();
+	ecs.destroy_many(roots_[index]);
+	roots_[index].clear();
+	loaded_[index] = 0;
+	memory_used_ -= get_cell_bytes(index);
+}
+
+void world_streaming::frame_update(delta_t /*dt*/)
+{
+	if(stage_ == stage::assets)
+	{
+		if(!scene_.is_ready())
+		{
+			return;
+		}
+
+		auto handle = scene_.get();
+		scene_ = {};
+		if(!handle || !handle->data)
+		{
+			APPLOG_ERROR("Failed to stream the scene {0}.", key_);
+			close();
+			return;
+		}
+		// the assets are loaded with the cells
+		handle->dependencies.clear();
+
+		// copied here, the stream of the asset is not for the workers to read
+		auto& stream = *handle->data;
+		std::string data(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>{});
+		stream.clear();
+		stream.seekg(0);
+
+		auto& ts = core::get_subsystem<core::task_system>();
+		parsed_ = ts.push_on_worker_thread([data]() mutable -> std::shared_ptr<ecs::utils::cell_data> {
+			auto cells = std::make_shared<ecs::utils::cell_data>();
+			if(!cells->open(std::move(data)))
+			{
+				return nullptr;
+			}
+			return cells;
+		});
+		stage_ = stage::parse;
+		return;
+	}
+
+	if(stage_ == stage::parse)
+	{
+		if(!parsed_.is_ready())
+		{
+			return;
+		}
+
+		cells_ = parsed_.get();
+		parsed_ = {};
+		if(!cells_)
+		{
+			APPLOG_ERROR("The scene {0} is not in cells, it can't be streamed.", key_);
+			close();
+			return;
+		}
+
+		const auto count = cells_->get_cells().size();
+		roots_.resize(count);
+		loaded_.assign(count, 0);
+		stage_ = stage::streaming;
+		APPLOG_INFO("Streaming the scene {0} in {1} cells.", key_, count);
+	}
+
+	if(stage_ == stage::streaming)
+	{
+		stream();
+	}
+}
+
+void world_streaming::stream()
+{
+	auto& ecs = core::get_subsystem<entity_component_system>();
+	std::vector<math::vec3> camera_positions;
+	ecs.each<camera_component>([&camera_positions](entity /*ce*/, camera_component& camera_comp) {
+		camera_positions.emplace_back(camera_comp.get_camera().get_position());
+	});
+
+	// the distance along the ground from the nearest camera to every cell
+	const auto& cells = cells_->get_cells();
+	const auto size = cells_->get_cell_size();
+	std::vector<float> distances(cells.size(), std::numeric_limits<float>::max());
+	for(std::size_t i = 0; i < cells.size(); ++i)
+	{
+		const auto& cell = cells[i];
+		if(cell.global)
+		{
+			distances[i] = 0.0f;
+			continue;
+		}
+
+		const math::vec2 min(float(cell.x) * size, float(cell.z) * size);
+		const math::vec2 max = min + math::vec2(size, size);
+		for(const auto& position : camera_positions)
+		{
+			const math::vec2 ground(position.x, position.z);
+			const auto nearest = math::clamp(ground, min, max);
+			distances[i] = math::min(distances[i], math::distance(ground, nearest));
+		}
+	}
+
+	bool unloaded = false;
+	const auto unload_radius = load_radius_ * hysteresis_;
+	for(std::size_t i = 0; i < cells.size(); ++i)
+	{
+		if(loaded_[i] && distances[i] > unload_radius)
+		{
+			unload(i);
+			unloaded = true;
+		}
+	}
+
+	std::vector<std::size_t> wanted;
+	for(std::size_t i = 0; i < cells.size(); ++i)
+	{
+		if(!loaded_[i] && distances[i] <= load_radius_)
+		{
+			wanted.push_back(i);
+		}
+	}
+	std::sort(std::begin(wanted), std::end(wanted),
+			  [&distances](std::size_t lhs, std::size_t rhs) { return distances[lhs] < distances[rhs]; });
+
+	const auto frame_start = std::chrono::steady_clock::now();
+	for(const auto index : wanted)
+	{
+		const auto bytes = get_cell_bytes(index);
+		// the furthest loaded cells make room for a nearer one
+		while(memory_budget_ > 0 && memory_used_ + bytes > memory_budget_)
+		{
+			auto furthest = cells.size();
+			for(std::size_t i = 0; i < cells.size(); ++i)
+			{
+				if(loaded_[i] && !cells[i].global && distances[i] > distances[index] &&
+				   (furthest == cells.size() || distances[i] > distances[furthest]))
+				{
+					furthest = i;
+				}
+			}
+			if(furthest == cells.size())
+			{
+				break;
+			}
+			unload(furthest);
+			unloaded = true;
+		}
+		if(memory_budget_ > 0 && memory_used_ + bytes > memory_budget_ && !cells[index].global)
+		{
+			break;
+		}
+
+		cells_->load_cell(index, roots_[index]);
+		loaded_[index] = 1;
+		memory_used_ += bytes;
+		if(std::chrono::steady_clock::now() - frame_start >= budget_)
+		{
+			break;
+		}
+	}
+
+	if(unloaded)
+	{
+		// what only the unloaded cells used is let go
+		core::get_subsystem<asset_manager>().request_sweep();
+	}
+}
+}
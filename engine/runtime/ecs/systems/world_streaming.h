@@ -0,0 +1,136 @@
+#pragma once
+
+#include "../ecs.h"
+
+#include <core/common/basetypes.hpp>
+#include <core/tasks/task_system.h>
+
+#include <runtime/assets/asset_handle.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct scene;
+
+namespace ecs
+{
+namespace utils
+{
+class cell_data;
+}
+}
+
+namespace runtime
+{
+/*
+ * world_streaming; keeps the cells of a scene compiled in cells loaded around
+ * the cameras, the rest of it is not in memory.
+ *
+ *      The scene asset loads in the background and its data is parsed on a
+ *      worker. Every frame the cells within the load radius of a camera are
+ *      created, the nearest first and for as long as the budget of a frame
+ *      allows, and those further than the unload radius are destroyed. The
+ *      unload radius is larger, so that a camera on the edge of a cell does
+ *      not load and unload it every frame. The loaded cells are kept within a
+ *      budget of their data, the furthest go first to make room for nearer
+ *      ones. The global cell, of the roots without a transform, is always
+ *      loaded.
+ */
+class world_streaming
+{
+public:
+	world_streaming();
+	~world_streaming();
+
+	//-----------------------------------------------------------------------------
+	//  Name : open ()
+	/// <summary>
+	/// Starts streaming the scene of the asset key, closing the one streamed
+	/// if any. The scene must have been compiled in cells.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void open(const std::string& key);
+
+	//-----------------------------------------------------------------------------
+	//  Name : close ()
+	/// <summary>
+	/// Destroys the entities of the loaded cells and lets the scene go.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void close();
+
+	bool is_open() const
+	{
+		return stage_ != stage::idle;
+	}
+
+	/// the distance from a camera to a cell within which it is loaded, along
+	/// the ground
+	void set_load_radius(float radius)
+	{
+		load_radius_ = radius;
+	}
+
+	float get_load_radius() const
+	{
+		return load_radius_;
+	}
+
+	/// the unload radius by the load radius, at least 1
+	void set_hysteresis(float hysteresis)
+	{
+		hysteresis_ = std::max(hysteresis, 1.0f);
+	}
+
+	/// the bytes of the compiled data of the loaded cells, 0 for no budget
+	void set_memory_budget(std::size_t bytes)
+	{
+		memory_budget_ = bytes;
+	}
+
+	std::size_t get_memory_used() const
+	{
+		return memory_used_;
+	}
+
+	/// the time of a frame spent creating entities, at least a cell is loaded
+	/// every frame
+	void set_frame_budget(std::chrono::microseconds budget)
+	{
+		budget_ = budget;
+	}
+
+	std::size_t get_loaded_cells_count() const;
+
+private:
+	enum class stage
+	{
+		idle,
+		assets,
+		parse,
+		streaming
+	};
+
+	void frame_update(delta_t dt);
+	void stream();
+	void unload(std::size_t index);
+	std::size_t get_cell_bytes(std::size_t index) const;
+
+	stage stage_ = stage::idle;
+	std::string key_;
+	float load_radius_ = 256.0f;
+	float hysteresis_ = 1.25f;
+	std::size_t memory_budget_ = 0;
+	std::size_t memory_used_ = 0;
+	std::chrono::microseconds budget_ = std::chrono::microseconds(4000);
+	core::task_future<asset_handle<scene>> scene_;
+	core::task_future<std::shared_ptr<ecs::utils::cell_data>> parsed_;
+	std::shared_ptr<ecs::utils::cell_data> cells_;
+	/// the roots of every cell while it is loaded
+	std::vector<std::vector<entity>> roots_;
+	std::vector<char> loaded_;
+};
+}
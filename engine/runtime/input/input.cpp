@@ -22,11 +22,11 @@ input::~input()
 
 void input::reset_state(delta_t /*unused*/)
 {
-	key_reset();
+	// the transitions are stamped with the frame, moving on to the next one
+	// is what resets them
+	++frame_;
 
 	mouse_reset();
-
-	joystick_reset();
 }
 
 void input::handle_event(const mml::platform_event& event)
@@ -49,109 +49,99 @@ void input::handle_event(const mml::platform_event& event)
 	}
 }
 
-bool input::is_key_pressed(mml::keyboard::key key)
+bool input::is_key_pressed(mml::keyboard::key key) const
 {
-	return keys_pressed_[key];
+	return keys_.is_pressed(static_cast<std::size_t>(key), frame_);
 }
 
-bool input::is_key_pressed(mml::keyboard::key key, mml::keyboard::key modifier)
+bool input::is_key_pressed(mml::keyboard::key key, mml::keyboard::key modifier) const
 {
 	return is_key_pressed(key) && is_key_down(modifier);
 }
 
-bool input::is_key_down(mml::keyboard::key key)
+bool input::is_key_down(mml::keyboard::key key) const
 {
-	return keys_down_[key];
+	return keys_.is_down(static_cast<std::size_t>(key), frame_);
 }
 
-bool input::is_key_released(mml::keyboard::key key)
+bool input::is_key_released(mml::keyboard::key key) const
 {
-	return keys_released_[key];
+	return keys_.is_released(static_cast<std::size_t>(key), frame_);
 }
 
-bool input::is_mouse_button_pressed(mml::mouse::button button)
+bool input::is_mouse_button_pressed(mml::mouse::button button) const
 {
-	return mouse_buttons_pressed_[button];
+	return mouse_buttons_.is_pressed(button, frame_);
 }
 
-bool input::is_mouse_button_down(mml::mouse::button button)
+bool input::is_mouse_button_down(mml::mouse::button button) const
 {
-	return mouse_buttons_down_[button];
+	return mouse_buttons_.is_down(button, frame_);
 }
 
-bool input::is_mouse_button_released(mml::mouse::button button)
+bool input::is_mouse_button_released(mml::mouse::button button) const
 {
-	return mouse_buttons_released_[button];
+	return mouse_buttons_.is_released(button, frame_);
 }
 
-bool input::is_joystick_connected(unsigned int joystick_id)
+bool input::is_joystick_connected(unsigned int joystick_id) const
 {
-	return joysticks_connected_[joystick_id];
+	return joysticks_.is_pressed(joystick_id, frame_);
 }
 
-bool input::is_joystick_active(unsigned int joystick_id)
+bool input::is_joystick_active(unsigned int joystick_id) const
 {
-	return joysticks_active_[joystick_id];
+	return joysticks_.is_down(joystick_id, frame_);
 }
 
-bool input::is_joystick_disconnected(unsigned int joystick_id)
+bool input::is_joystick_disconnected(unsigned int joystick_id) const
 {
-	return joysticks_disconnected_[joystick_id];
+	return joysticks_.is_released(joystick_id, frame_);
 }
 
-bool input::is_joystick_button_pressed(unsigned int joystick_id, unsigned int button)
+static std::size_t joystick_button_index(unsigned int joystick_id, unsigned int button)
 {
-	return joystick_buttons_pressed_[std::pair<unsigned int, unsigned int>(joystick_id, button)];
+	if(joystick_id >= mml::joystick::count || button >= mml::joystick::button_count)
+	{
+		return mml::joystick::count * mml::joystick::button_count;
+	}
+	return joystick_id * mml::joystick::button_count + button;
 }
 
-bool input::is_joystick_button_down(unsigned int joystick_id, unsigned int button)
+bool input::is_joystick_button_pressed(unsigned int joystick_id, unsigned int button) const
 {
-	return joystick_buttons_down_[std::pair<unsigned int, unsigned int>(joystick_id, button)];
+	return joystick_buttons_.is_pressed(joystick_button_index(joystick_id, button), frame_);
 }
 
-bool input::is_joystick_button_released(unsigned int joystick_id, unsigned int button)
+bool input::is_joystick_button_down(unsigned int joystick_id, unsigned int button) const
 {
-	return joystick_buttons_released_[std::pair<unsigned int, unsigned int>(joystick_id, button)];
+	return joystick_buttons_.is_down(joystick_button_index(joystick_id, button), frame_);
 }
 
-float input::get_joystick_axis_position(unsigned int joystick_id, mml::joystick::axis axis)
+bool input::is_joystick_button_released(unsigned int joystick_id, unsigned int button) const
 {
-	return joystick_axis_positions_[std::pair<unsigned int, unsigned int>(joystick_id, axis)];
+	return joystick_buttons_.is_released(joystick_button_index(joystick_id, button), frame_);
 }
 
-void input::key_reset()
+float input::get_joystick_axis_position(unsigned int joystick_id, mml::joystick::axis axis) const
 {
-	for(auto& it : keys_pressed_)
+	if(joystick_id >= mml::joystick::count || axis >= mml::joystick::axis_count)
 	{
-		if(it.second)
-		{
-			keys_down_[it.first] = true;
-			it.second = false;
-		}
-	}
-
-	for(auto& it : keys_released_)
-	{
-		if(it.second)
-		{
-			it.second = false;
-		}
+		return 0.0f;
 	}
+	return joystick_axis_positions_[joystick_id * mml::joystick::axis_count + axis];
 }
 
 bool input::key_event(const mml::platform_event& event)
 {
 	if(event.type == mml::platform_event::key_pressed)
 	{
-		keys_pressed_[event.key.code] = !keys_down_[event.key.code];
-		keys_released_[event.key.code] = false;
+		keys_.press(static_cast<std::size_t>(event.key.code), frame_);
 		return true;
 	}
 	if(event.type == mml::platform_event::key_released)
 	{
-		keys_pressed_[event.key.code] = false;
-		keys_down_[event.key.code] = false;
-		keys_released_[event.key.code] = true;
+		keys_.release(static_cast<std::size_t>(event.key.code), frame_);
 		return true;
 	}
 	return false;
@@ -161,22 +151,6 @@ void input::mouse_reset()
 {
 	mouse_move_event_ = false;
 	last_cursor_position_ = current_cursor_position_;
-	for(auto& it : mouse_buttons_pressed_)
-	{
-		if(it.second)
-		{
-			mouse_buttons_down_[it.first] = true;
-			it.second = false;
-		}
-	}
-
-	for(auto& it : mouse_buttons_released_)
-	{
-		if(it.second)
-		{
-			it.second = false;
-		}
-	}
 
 	if(mouse_wheel_scrolled_)
 	{
@@ -189,15 +163,12 @@ bool input::mouse_event(const mml::platform_event& event)
 {
 	if(event.type == mml::platform_event::mouse_button_pressed)
 	{
-		mouse_buttons_pressed_[event.mouse_button.button] = !mouse_buttons_down_[event.mouse_button.button];
-		mouse_buttons_released_[event.mouse_button.button] = false;
+		mouse_buttons_.press(event.mouse_button.button, frame_);
 		return true;
 	}
 	if(event.type == mml::platform_event::mouse_button_released)
 	{
-		mouse_buttons_pressed_[event.mouse_button.button] = false;
-		mouse_buttons_down_[event.mouse_button.button] = false;
-		mouse_buttons_released_[event.mouse_button.button] = true;
+		mouse_buttons_.release(event.mouse_button.button, frame_);
 		return true;
 	}
 	if(event.type == mml::platform_event::mouse_moved)
@@ -219,80 +190,39 @@ bool input::mouse_event(const mml::platform_event& event)
 	return false;
 }
 
-void input::joystick_reset()
-{
-	for(auto& it : joystick_buttons_pressed_)
-	{
-		if(it.second)
-		{
-			joystick_buttons_down_[it.first] = true;
-			it.second = false;
-		}
-	}
-
-	for(auto& it : joystick_buttons_released_)
-	{
-		if(it.second)
-		{
-			it.second = false;
-		}
-	}
-
-	for(auto& it : joysticks_connected_)
-	{
-		if(it.second)
-		{
-			joysticks_active_[it.first] = true;
-			it.second = false;
-		}
-	}
-
-	for(auto& it : joysticks_disconnected_)
-	{
-		if(it.second)
-		{
-			it.second = false;
-		}
-	}
-}
-
 bool input::joystick_event(const mml::platform_event& event)
 {
 	if(event.type == mml::platform_event::joystick_connected)
 	{
-		joysticks_connected_[event.joystick_connect.joystick_id] =
-			!joysticks_active_[event.joystick_connect.joystick_id];
-		joysticks_disconnected_[event.joystick_connect.joystick_id] = false;
+		joysticks_.press(event.joystick_connect.joystick_id, frame_);
 		return true;
 	}
 	if(event.type == mml::platform_event::joystick_disconnected)
 	{
-		joysticks_connected_[event.joystick_connect.joystick_id] = false;
-		joysticks_active_[event.joystick_connect.joystick_id] = false;
-		joysticks_disconnected_[event.joystick_connect.joystick_id] = true;
+		joysticks_.release(event.joystick_connect.joystick_id, frame_);
 		return true;
 	}
 	if(event.type == mml::platform_event::joystick_button_pressed)
 	{
-		std::pair<unsigned int, unsigned int> k(event.joystick_button.joystick_id,
-												event.joystick_button.button);
-		joystick_buttons_pressed_[k] = !joystick_buttons_down_[k];
-		joystick_buttons_released_[k] = false;
+		joystick_buttons_.press(
+			joystick_button_index(event.joystick_button.joystick_id, event.joystick_button.button), frame_);
 		return true;
 	}
 	if(event.type == mml::platform_event::joystick_button_released)
 	{
-		std::pair<unsigned int, unsigned int> k(event.joystick_button.joystick_id,
-												event.joystick_button.button);
-		joystick_buttons_pressed_[k] = false;
-		joystick_buttons_down_[k] = false;
-		joystick_buttons_released_[k] = true;
+		joystick_buttons_.release(
+			joystick_button_index(event.joystick_button.joystick_id, event.joystick_button.button), frame_);
 		return true;
 	}
 	if(event.type == mml::platform_event::joystick_moved)
 	{
-		std::pair<unsigned int, unsigned int> k(event.joystick_move.joystick_id, event.joystick_move.axis);
-		joystick_axis_positions_[k] = event.joystick_move.position;
+		if(event.joystick_move.joystick_id < mml::joystick::count &&
+		   event.joystick_move.axis < mml::joystick::axis_count)
+		{
+			const auto index = event.joystick_move.joystick_id * mml::joystick::axis_count +
+							   static_cast<unsigned int>(event.joystick_move.axis);
+			joystick_axis_positions_[index] = event.joystick_move.position;
+		}
 		return true;
 	}
 	return false;
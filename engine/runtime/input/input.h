@@ -4,13 +4,17 @@
 #include <core/common/basetypes.hpp>
 #include <core/signals/event.hpp>
 
-#include <map>
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace runtime
 {
-using action_map_t =
-	std::unordered_map<std::string, std::map<action_type, event<void(const mml::platform_event&)>>>;
+using action_event_t = event<void(const mml::platform_event&)>;
 
 struct action_mapper
 {
@@ -26,17 +30,50 @@ struct action_mapper
 	joystick_button_mapper joystick_button_map;
 	///
 	event_mapper event_map;
-	///
-	action_map_t actions;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_action_id ()
+	/// <summary>
+	/// The id of the named action, added the first time it is asked for. Meant
+	/// to be resolved once, the mappings and subscriptions go by the id.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	action_id get_action_id(const std::string& action)
+	{
+		auto it = ids_.find(action);
+		if(it != std::end(ids_))
+		{
+			return it->second;
+		}
+
+		const auto id = static_cast<action_id>(actions_.size());
+		ids_.emplace(action, id);
+		actions_.emplace_back(std::make_unique<action_events>());
+		return id;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_action ()
+	/// <summary>
+	/// The event of the action fired for the type of input.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	action_event_t& get_action(action_id action, action_type type)
+	{
+		return (*actions_[action])[static_cast<std::size_t>(type)];
+	}
 
 	void handle_event(const mml::platform_event& event)
 	{
-		auto trigger_callbacks = [this](auto& mapper, const mml::platform_event& event) {
-			auto mappings = mapper.get_mapping(event);
-			for(auto& action : mappings.actions)
+		auto trigger_callbacks = [this](const auto& mapper, const mml::platform_event& event) {
+			const auto mappings = mapper.get_mapping(event);
+			if(mappings.actions == nullptr)
+			{
+				return;
+			}
+			for(auto action : *mappings.actions)
 			{
-				auto& mapped_event = actions[action][mappings.type];
-				mapped_event(event);
+				get_action(action, mappings.type)(event);
 			}
 		};
 
@@ -47,24 +84,93 @@ struct action_mapper
 		trigger_callbacks(joystick_button_map, event);
 		trigger_callbacks(event_map, event);
 	}
+
+private:
+	using action_events = std::array<action_event_t, static_cast<std::size_t>(action_type::count)>;
+
+	/// the events of an action stay put when more actions are added
+	std::vector<std::unique_ptr<action_events>> actions_;
+	std::unordered_map<std::string, action_id> ids_;
+};
+
+/*
+ * button_states; the state of a fixed set of buttons indexed from 0.
+ *
+ *      A press or a release is stamped with the frame it came in, which is
+ *      what tells the pressed and released queries of that frame apart, so
+ *      nothing has to be cleared when the frame ends. A button pressed this
+ *      frame only counts as down from the next one on.
+ */
+template <std::size_t N>
+class button_states
+{
+public:
+	void press(std::size_t i, std::uint64_t frame)
+	{
+		if(i >= N)
+		{
+			return;
+		}
+		// a repeated press of a held button is not a new press
+		if(!down_[i])
+		{
+			down_.set(i);
+			pressed_[i] = frame;
+		}
+		released_[i] = 0;
+	}
+
+	void release(std::size_t i, std::uint64_t frame)
+	{
+		if(i >= N)
+		{
+			return;
+		}
+		down_.reset(i);
+		pressed_[i] = 0;
+		released_[i] = frame;
+	}
+
+	bool is_pressed(std::size_t i, std::uint64_t frame) const
+	{
+		return i < N && pressed_[i] == frame;
+	}
+
+	bool is_down(std::size_t i, std::uint64_t frame) const
+	{
+		return i < N && down_[i] && pressed_[i] != frame;
+	}
+
+	bool is_released(std::size_t i, std::uint64_t frame) const
+	{
+		return i < N && released_[i] == frame;
+	}
+
+private:
+	std::bitset<N> down_;
+	/// the frames of the last press and release, 0 for none
+	std::array<std::uint64_t, N> pressed_ = {};
+	std::array<std::uint64_t, N> released_ = {};
 };
 
 // 	auto& input = core::get_subsystem<runtime::input>();
 // 	auto& mappings = input.get_mappings();
 //
+//	// Resolve the action once and keep the id
+// 	auto some_action = mappings.get_action_id("some_action");
+//
 //	// You can map different type of events to the same action
-// 	mappings.event_map.map("some_action",
-//  mml::platform_event::text_entered);
-// 	mappings.mouse_button_map.map("some_action", mml::mouse::Right);
-// 	mappings.keyboard_map.map("some_action", mml::keyboard::Space);
+// 	mappings.event_map.map(some_action, mml::platform_event::text_entered);
+// 	mappings.mouse_button_map.map(some_action, mml::mouse::Right);
+// 	mappings.keyboard_map.map(some_action, mml::keyboard::Space);
 //
 // 	//you can subscribe to a callback for a specific event and action type
-// 	mappings.actions["some_action"][action_type::pressed].connect([](const
+// 	mappings.get_action(some_action, action_type::pressed).connect([](const
 //  mml::platform_event& e)
 // 	{
 // 		//do some stuff
 // 	});
-// 	mappings.actions["some_action"][action_type::changed].connect([](const
+// 	mappings.get_action(some_action, action_type::changed).connect([](const
 //  mml::platform_event& e)
 // 	{
 // 		//do some stuff
@@ -119,8 +225,8 @@ public:
 	///
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	bool is_key_pressed(mml::keyboard::key key);
-	bool is_key_pressed(mml::keyboard::key key, mml::keyboard::key modifier);
+	bool is_key_pressed(mml::keyboard::key key) const;
+	bool is_key_pressed(mml::keyboard::key key, mml::keyboard::key modifier) const;
 	//-----------------------------------------------------------------------------
 	//  Name : is_key_down ()
 	/// <summary>
@@ -129,7 +235,7 @@ public:
 	///
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	bool is_key_down(mml::keyboard::key key);
+	bool is_key_down(mml::keyboard::key key) const;
 
 	//-----------------------------------------------------------------------------
 	//  Name : is_key_released ()
@@ -139,7 +245,7 @@ public:
 	///
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	bool is_key_released(mml::keyboard::key key);
+	bool is_key_released(mml::keyboard::key key) const;
 
 	//-----------------------------------------------------------------------------
 	//  Name : mouseMoved ()
@@ -198,7 +304,7 @@ public:
 	///
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	bool is_mouse_button_pressed(mml::mouse::button button);
+	bool is_mouse_button_pressed(mml::mouse::button button) const;
 
 	//-----------------------------------------------------------------------------
 	//  Name : is_mouse_button_down ()
@@ -208,7 +314,7 @@ public:
 	///
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	bool is_mouse_button_down(mml::mouse::button button);
+	bool is_mouse_button_down(mml::mouse::button button) const;
 
 	//-----------------------------------------------------------------------------
 	//  Name : is_mouse_button_released ()
@@ -218,7 +324,7 @@ public:
 	///
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	bool is_mouse_button_released(mml::mouse::button button);
+	bool is_mouse_button_released(mml::mouse::button button) const;
 
 	//-----------------------------------------------------------------------------
 	//  Name : is_mouse_wheel_scrolled ()
@@ -254,7 +360,7 @@ public:
 	///
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	bool is_joystick_connected(unsigned int joystick_id);
+	bool is_joystick_connected(unsigned int joystick_id) const;
 
 	//-----------------------------------------------------------------------------
 	//  Name : is_joystick_active ()
@@ -264,7 +370,7 @@ public:
 	///
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	bool is_joystick_active(unsigned int joystick_id);
+	bool is_joystick_active(unsigned int joystick_id) const;
 
 	//-----------------------------------------------------------------------------
 	//  Name : is_joystick_disconnected ()
@@ -274,7 +380,7 @@ public:
 	///
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	bool is_joystick_disconnected(unsigned int joystick_id);
+	bool is_joystick_disconnected(unsigned int joystick_id) const;
 
 	//-----------------------------------------------------------------------------
 	//  Name : is_joystick_button_pressed ()
@@ -284,7 +390,7 @@ public:
 	///
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	bool is_joystick_button_pressed(unsigned int joystick_id, unsigned int button);
+	bool is_joystick_button_pressed(unsigned int joystick_id, unsigned int button) const;
 
 	//-----------------------------------------------------------------------------
 	//  Name : is_joystick_button_down ()
@@ -294,7 +400,7 @@ public:
 	///
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	bool is_joystick_button_down(unsigned int joystick_id, unsigned int button);
+	bool is_joystick_button_down(unsigned int joystick_id, unsigned int button) const;
 
 	//-----------------------------------------------------------------------------
 	//  Name : is_joystick_button_released ()
@@ -304,7 +410,7 @@ public:
 	///
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	bool is_joystick_button_released(unsigned int joystick_id, unsigned int button);
+	bool is_joystick_button_released(unsigned int joystick_id, unsigned int button) const;
 
 	//-----------------------------------------------------------------------------
 	//  Name : get_joystick_axis_position ()
@@ -314,7 +420,7 @@ public:
 	///
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	float get_joystick_axis_position(unsigned int joystick_id, mml::joystick::axis axis);
+	float get_joystick_axis_position(unsigned int joystick_id, mml::joystick::axis axis) const;
 
 
 	//-----------------------------------------------------------------------------
@@ -327,16 +433,6 @@ public:
 	//-----------------------------------------------------------------------------
 	bool mouse_event(const mml::platform_event& event);
 private:
-	//-----------------------------------------------------------------------------
-	//  Name : key_reset ()
-	/// <summary>
-	///
-	///
-	///
-	/// </summary>
-	//-----------------------------------------------------------------------------
-	void key_reset();
-
 	//-----------------------------------------------------------------------------
 	//  Name : key_event ()
 	/// <summary>
@@ -357,16 +453,6 @@ private:
 	//-----------------------------------------------------------------------------
 	void mouse_reset();
 
-	//-----------------------------------------------------------------------------
-	//  Name : joystick_reset ()
-	/// <summary>
-	///
-	///
-	///
-	/// </summary>
-	//-----------------------------------------------------------------------------
-	void joystick_reset();
-
 	//-----------------------------------------------------------------------------
 	//  Name : joystick_event ()
 	/// <summary>
@@ -389,31 +475,17 @@ private:
 	ipoint32_t current_cursor_position_;
 	///
 	ipoint32_t last_cursor_position_;
-	///
-	std::map<unsigned int, bool> mouse_buttons_pressed_;
-	///
-	std::map<unsigned int, bool> mouse_buttons_down_;
-	///
-	std::map<unsigned int, bool> mouse_buttons_released_;
-	///
-	std::map<mml::keyboard::key, bool> keys_pressed_;
-	///
-	std::map<mml::keyboard::key, bool> keys_down_;
-	///
-	std::map<mml::keyboard::key, bool> keys_released_;
-	///
-	std::map<unsigned int, bool> joysticks_connected_;
-	///
-	std::map<unsigned int, bool> joysticks_active_;
-	///
-	std::map<unsigned int, bool> joysticks_disconnected_;
-	///
-	std::map<std::pair<unsigned int, unsigned int>, bool> joystick_buttons_pressed_;
-	///
-	std::map<std::pair<unsigned int, unsigned int>, bool> joystick_buttons_down_;
-	///
-	std::map<std::pair<unsigned int, unsigned int>, bool> joystick_buttons_released_;
-	///
-	std::map<std::pair<unsigned int, unsigned int>, float> joystick_axis_positions_;
+	/// the frame the input is for, advanced by reset_state
+	std::uint64_t frame_ = 1;
+	///
+	button_states<mml::mouse::button_count> mouse_buttons_;
+	///
+	button_states<mml::keyboard::KeyCount> keys_;
+	/// connected is the press, active the down and disconnected the release
+	button_states<mml::joystick::count> joysticks_;
+	/// indexed by joystick_id * joystick::button_count + button
+	button_states<mml::joystick::count * mml::joystick::button_count> joystick_buttons_;
+	/// indexed by joystick_id * joystick::axis_count + axis
+	std::array<float, mml::joystick::count * mml::joystick::axis_count> joystick_axis_positions_ = {};
 };
 }
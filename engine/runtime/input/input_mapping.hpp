@@ -9,6 +9,7 @@
 #include <mml/window/sensor.hpp>
 #include <mml/window/touch.hpp>
 
+#include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
@@ -33,13 +34,18 @@ enum class action_type : unsigned int
 	not_mapped,
 	pressed,
 	changed,
-	released
+	released,
+	count
 };
 
+/// an action resolved once to its index by action_mapper::get_action_id
+using action_id = std::uint32_t;
+
 struct input_mapping
 {
 	action_type type = action_type::not_mapped;
-	std::vector<std::string> actions;
+	/// the actions bound to the input, null when there are none
+	const std::vector<action_id>* actions = nullptr;
 };
 
 template <typename T>
@@ -49,123 +55,115 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : map ()
 	/// <summary>
-	///
-	///
-	///
+	/// Binds the input to the action.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	void map(const std::string& action, T input)
+	void map(action_id action, T input)
 	{
 		bindings_[input].push_back(action);
 	}
 
 protected:
+	input_mapping find(const T& input, action_type type) const
+	{
+		input_mapping binds;
+		auto it = bindings_.find(input);
+		if(it != std::end(bindings_))
+		{
+			binds.actions = &it->second;
+			binds.type = type;
+		}
+		return binds;
+	}
+
 	/// mappings
-	std::map<T, std::vector<std::string>> bindings_;
+	std::map<T, std::vector<action_id>> bindings_;
 };
 
 struct keyboard_mapper : public input_mapper<mml::keyboard::key>
 {
-	input_mapping get_mapping(const mml::platform_event& e)
+	input_mapping get_mapping(const mml::platform_event& e) const
 	{
-		input_mapping binds;
 		if(e.type == mml::platform_event::event_type::key_pressed)
 		{
-			binds.actions = bindings_[e.key.code];
-			binds.type = action_type::pressed;
+			return find(e.key.code, action_type::pressed);
 		}
 		if(e.type == mml::platform_event::event_type::key_released)
 		{
-			binds.actions = bindings_[e.key.code];
-			binds.type = action_type::released;
+			return find(e.key.code, action_type::released);
 		}
-		return binds;
+		return {};
 	}
 };
 
 struct mouse_button_mapper : public input_mapper<mml::mouse::button>
 {
-	input_mapping get_mapping(const mml::platform_event& e)
+	input_mapping get_mapping(const mml::platform_event& e) const
 	{
-		input_mapping binds;
 		if(e.type == mml::platform_event::event_type::mouse_button_pressed)
 		{
-			binds.actions = bindings_[e.mouse_button.button];
-			binds.type = action_type::pressed;
+			return find(e.mouse_button.button, action_type::pressed);
 		}
 		if(e.type == mml::platform_event::event_type::mouse_button_released)
 		{
-			binds.actions = bindings_[e.mouse_button.button];
-			binds.type = action_type::released;
+			return find(e.mouse_button.button, action_type::released);
 		}
-		return binds;
+		return {};
 	}
 };
 
 struct mouse_wheel_mapper : public input_mapper<mml::mouse::wheel>
 {
-	input_mapping get_mapping(const mml::platform_event& e)
+	input_mapping get_mapping(const mml::platform_event& e) const
 	{
-		input_mapping binds;
 		if(e.type == mml::platform_event::event_type::mouse_wheel_scrolled)
 		{
-			binds.actions = bindings_[e.mouse_wheel_scroll.wheel];
-			binds.type = action_type::changed;
+			return find(e.mouse_wheel_scroll.wheel, action_type::changed);
 		}
-		return binds;
+		return {};
 	}
 };
 
 struct touch_finger_mapper : public input_mapper<unsigned int>
 {
-	input_mapping get_mapping(const mml::platform_event& e)
+	input_mapping get_mapping(const mml::platform_event& e) const
 	{
-		input_mapping binds;
 		if(e.type == mml::platform_event::event_type::touch_began)
 		{
-			binds.actions = bindings_[e.touch.finger];
-			binds.type = action_type::pressed;
+			return find(e.touch.finger, action_type::pressed);
 		}
 		if(e.type == mml::platform_event::event_type::touch_moved)
 		{
-			binds.actions = bindings_[e.touch.finger];
-			binds.type = action_type::changed;
+			return find(e.touch.finger, action_type::changed);
 		}
 		if(e.type == mml::platform_event::event_type::touch_ended)
 		{
-			binds.actions = bindings_[e.touch.finger];
-			binds.type = action_type::released;
+			return find(e.touch.finger, action_type::released);
 		}
-		return binds;
+		return {};
 	}
 };
 
 struct joystick_button_mapper : public input_mapper<std::pair<unsigned int, unsigned int>>
 {
-	input_mapping get_mapping(const mml::platform_event& e)
+	input_mapping get_mapping(const mml::platform_event& e) const
 	{
-		input_mapping binds;
 		if(e.type == mml::platform_event::event_type::joystick_button_pressed)
 		{
-			binds.actions = bindings_[{e.joystick_button.joystick_id, e.joystick_button.button}];
-			binds.type = action_type::pressed;
+			return find({e.joystick_button.joystick_id, e.joystick_button.button}, action_type::pressed);
 		}
 		if(e.type == mml::platform_event::event_type::joystick_button_released)
 		{
-			binds.actions = bindings_[{e.joystick_button.joystick_id, e.joystick_button.button}];
-			binds.type = action_type::released;
+			return find({e.joystick_button.joystick_id, e.joystick_button.button}, action_type::released);
 		}
-		return binds;
+		return {};
 	}
 };
 
 struct event_mapper : public input_mapper<mml::platform_event::event_type>
 {
-	input_mapping get_mapping(const mml::platform_event& e)
+	input_mapping get_mapping(const mml::platform_event& e) const
 	{
-		input_mapping binds;
-		binds.actions = bindings_[e.type];
-		binds.type = action_type::changed;
-		return binds;
+		return find(e.type, action_type::changed);
 	}
 };
@@ -0,0 +1,209 @@
+#include "input_recording.h"
+
+#include <core/logging/logging.h>
+#include <core/simulation/simulation.h>
+
+#include <algorithm>
+#include <numeric>
+
+namespace runtime
+{
+namespace
+{
+/// "INPR" at the start of a recording
+constexpr std::uint32_t recording_magic = 0x52504e49;
+
+template <typename T>
+void write_value(std::ostream& out, const T& value)
+{
+	out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool read_value(std::istream& in, T& value)
+{
+	return bool(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+std::int64_t to_ns(input_recording::clock_t::duration d)
+{
+	return std::int64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+}
+}
+
+input_recording::~input_recording()
+{
+	stop();
+}
+
+bool input_recording::record(const fs::path& path)
+{
+	stop();
+
+	out_.open(path.string(), std::ios::binary | std::ios::trunc);
+	if(!out_)
+	{
+		APPLOG_ERROR("Failed to record the input to {0}.", path.string());
+		return false;
+	}
+
+	write_value(out_, recording_magic);
+	write_value(out_, version);
+	write_value(out_, std::uint32_t(sizeof(mml::platform_event)));
+	start_ = clock_t::now();
+	frames_ = 0;
+	mode_ = mode::recording;
+	APPLOG_INFO("Recording the input to {0}.", path.string());
+	return true;
+}
+
+bool input_recording::replay(const fs::path& path, clock_t::duration fixed_step)
+{
+	stop();
+
+	in_.open(path.string(), std::ios::binary);
+	std::uint32_t magic = 0;
+	std::uint32_t file_version = 0;
+	std::uint32_t event_size = 0;
+	if(!in_ || !read_value(in_, magic) || !read_value(in_, file_version) || !read_value(in_, event_size) ||
+	   magic != recording_magic || file_version != version || event_size != sizeof(mml::platform_event))
+	{
+		in_.close();
+		APPLOG_ERROR("{0} is not an input recording of this build.", path.string());
+		return false;
+	}
+
+	start_ = clock_t::now();
+	fixed_step_ = fixed_step;
+	frames_ = 0;
+	frame_ms_.clear();
+	mode_ = mode::replaying;
+	APPLOG_INFO("Replaying the input of {0}.", path.string());
+	return true;
+}
+
+void input_recording::stop()
+{
+	if(mode_ == mode::recording)
+	{
+		out_.close();
+		APPLOG_INFO("Recorded {0} frames of input.", frames_);
+	}
+	else if(mode_ == mode::replaying)
+	{
+		in_.close();
+		APPLOG_INFO("Replayed {0} frames of input.", frames_);
+	}
+	events_.clear();
+	mode_ = mode::idle;
+}
+
+void input_recording::begin_frame(core::simulation& sim)
+{
+	if(mode_ == mode::replaying && !read_frame())
+	{
+		stop();
+	}
+
+	if(mode_ != mode::replaying)
+	{
+		if(holds_step_)
+		{
+			sim.set_fixed_delta(clock_t::duration::zero());
+			holds_step_ = false;
+		}
+		return;
+	}
+
+	sim.set_fixed_delta(fixed_step_ > clock_t::duration::zero() ? fixed_step_ : step_);
+	holds_step_ = true;
+}
+
+void input_recording::process_events(platform_event_queue& queue, const core::simulation& sim)
+{
+	if(mode_ == mode::recording)
+	{
+		queue.get_input_events(events_);
+		write_value(out_, to_ns(sim.get_frame_delta()));
+		write_value(out_, queue.get_focused_id());
+		write_value(out_, std::uint32_t(events_.size()));
+		for(const auto& e : events_)
+		{
+			write_value(out_, e.window_id);
+			write_value(out_, to_ns(e.time - start_));
+			write_value(out_, e.event);
+		}
+		++frames_;
+		return;
+	}
+
+	if(mode_ == mode::replaying)
+	{
+		// of the frame before, the work time is known once the next one starts
+		if(frames_ > 1)
+		{
+			frame_ms_.push_back(std::chrono::duration<double, std::milli>(sim.get_frame_work_time()).count());
+		}
+
+		// the events come in now, as far as the latency is concerned
+		const auto now = clock_t::now();
+		for(auto& e : events_)
+		{
+			e.time = now;
+		}
+		queue.replace_input_events(focused_id_, events_);
+	}
+}
+
+bool input_recording::read_frame()
+{
+	std::int64_t step = 0;
+	std::uint32_t count = 0;
+	if(!read_value(in_, step) || !read_value(in_, focused_id_) || !read_value(in_, count))
+	{
+		return false;
+	}
+
+	events_.resize(count);
+	for(auto& e : events_)
+	{
+		std::int64_t time = 0;
+		if(!read_value(in_, e.window_id) || !read_value(in_, time) || !read_value(in_, e.event))
+		{
+			return false;
+		}
+	}
+
+	step_ = std::chrono::duration_cast<clock_t::duration>(std::chrono::nanoseconds(step));
+	++frames_;
+	return true;
+}
+
+bool input_recording::write_frame_times(const fs::path& path) const
+{
+	std::ofstream out(path.string(), std::fstream::trunc);
+	if(!out)
+	{
+		APPLOG_ERROR("Failed to write the replay frame times to {0}.", path.string());
+		return false;
+	}
+
+	const double total = std::accumulate(std::begin(frame_ms_), std::end(frame_ms_), 0.0);
+	const double mean = frame_ms_.empty() ? 0.0 : total / double(frame_ms_.size());
+	const double max =
+		frame_ms_.empty() ? 0.0 : *std::max_element(std::begin(frame_ms_), std::end(frame_ms_));
+
+	// in the order of the frames, for two replays to be compared frame by frame
+	out << "{\n";
+	out << "\t\"frames\": " << frame_ms_.size() << ",\n";
+	out << "\t\"mean_ms\": " << mean << ",\n";
+	out << "\t\"max_ms\": " << max << ",\n";
+	out << "\t\"frame_ms\": [";
+	for(std::size_t i = 0; i < frame_ms_.size(); ++i)
+	{
+		out << (i == 0 ? "" : ", ") << frame_ms_[i];
+	}
+	out << "]\n}\n";
+	return bool(out);
+}
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "platform_event_queue.h"
+
+#include <core/filesystem/filesystem.h>
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+namespace core
+{
+struct simulation;
+}
+
+namespace runtime
+{
+/*
+ * input_recording; writes the events of the input and the step of every
+ * frame to a file, and plays them back in place of the input, for a session
+ * to be run again the same way, under the profiler or before and after a
+ * change.
+ *
+ *      A frame is recorded as the time it stepped by, the window that had
+ *      the focus and the events of the input dispatched in it, each with the
+ *      window it came to and its time since the recording started. The
+ *      events are written as they are in memory, a recording is played back
+ *      by a build of the same events. A replay steps every frame by the time
+ *      recorded for it, or by a fixed step, and the events of the input that
+ *      come meanwhile are dropped, so that every replay of a recording runs
+ *      the same frames. The work time of every frame played back is kept, to
+ *      compare two replays frame by frame.
+ */
+class input_recording
+{
+public:
+	using clock_t = std::chrono::steady_clock;
+
+	~input_recording();
+
+	//-----------------------------------------------------------------------------
+	//  Name : record ()
+	/// <summary>
+	/// Starts recording to the file, stopping what was recorded or played
+	/// back before.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool record(const fs::path& path);
+
+	//-----------------------------------------------------------------------------
+	//  Name : replay ()
+	/// <summary>
+	/// Starts playing back the file from its first frame, each frame stepping
+	/// by the fixed step or, when it is zero, by the time recorded for it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool replay(const fs::path& path, clock_t::duration fixed_step = clock_t::duration::zero());
+
+	//-----------------------------------------------------------------------------
+	//  Name : stop ()
+	/// <summary>
+	/// Closes the file, the next frames take the input and step by the time
+	/// that passed again.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void stop();
+
+	bool is_recording() const
+	{
+		return mode_ == mode::recording;
+	}
+
+	bool is_replaying() const
+	{
+		return mode_ == mode::replaying;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : begin_frame ()
+	/// <summary>
+	/// Reads the next frame of a replay and sets the step of the simulation
+	/// to it, before the simulation starts the frame. The replay stops after
+	/// the last frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void begin_frame(core::simulation& sim);
+
+	//-----------------------------------------------------------------------------
+	//  Name : process_events ()
+	/// <summary>
+	/// Before the dispatch of the events of the frame, writes those of the
+	/// input when recording, or puts those of the frame played back in their
+	/// place.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void process_events(platform_event_queue& queue, const core::simulation& sim);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_frames ()
+	/// <summary>
+	/// The frames recorded or played back so far.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint64_t get_frames() const
+	{
+		return frames_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : write_frame_times ()
+	/// <summary>
+	/// Writes the work time of every frame of the last replay as json.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool write_frame_times(const fs::path& path) const;
+
+	/// bumped when the file changes
+	static constexpr std::uint32_t version = 1;
+
+private:
+	enum class mode
+	{
+		idle,
+		recording,
+		replaying
+	};
+
+	bool read_frame();
+
+	mode mode_ = mode::idle;
+	std::ofstream out_;
+	std::ifstream in_;
+	clock_t::time_point start_;
+	clock_t::duration fixed_step_ = clock_t::duration::zero();
+	std::uint64_t frames_ = 0;
+	/// the step of the simulation was set by the replay
+	bool holds_step_ = false;
+	/// the frame played back, its step and its events
+	clock_t::duration step_ = clock_t::duration::zero();
+	std::uint32_t focused_id_ = 0;
+	std::vector<platform_event_queue::input_event> events_;
+	/// the work time of the frames played back
+	std::vector<double> frame_ms_;
+};
+}
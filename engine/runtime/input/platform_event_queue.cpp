@@ -0,0 +1,150 @@
+#include "platform_event_queue.h"
+#include "../rendering/render_window.h"
+#include "../system/events.h"
+
+#include <algorithm>
+
+namespace runtime
+{
+namespace
+{
+bool replaces(const mml::platform_event& last, const mml::platform_event& e)
+{
+	if(last.type != e.type)
+	{
+		return false;
+	}
+	if(e.type == mml::platform_event::mouse_moved)
+	{
+		return true;
+	}
+	if(e.type == mml::platform_event::joystick_moved)
+	{
+		return last.joystick_move.joystick_id == e.joystick_move.joystick_id &&
+			   last.joystick_move.axis == e.joystick_move.axis;
+	}
+	return false;
+}
+}
+
+void platform_event_queue::collect(const std::vector<std::unique_ptr<render_window>>& windows)
+{
+	const auto now = clock_t::now();
+	focused_id_ = 0;
+	for(const auto& window : windows)
+	{
+		const auto id = window->get_id();
+		if(window->has_focus())
+		{
+			focused_id_ = id;
+		}
+
+		mml::platform_event e;
+		while(window->poll_event(e))
+		{
+			auto& b = get_batch(id);
+			if(!b.events.empty() && replaces(b.events.back(), e))
+			{
+				// the time of the first is kept, it has waited since
+				b.events.back() = e;
+				continue;
+			}
+			b.events.emplace_back(e);
+			b.times.emplace_back(now);
+		}
+	}
+}
+
+void platform_event_queue::dispatch()
+{
+	const auto now = clock_t::now();
+	latency_ = clock_t::duration::zero();
+	for(auto& b : batches_)
+	{
+		if(b.events.empty())
+		{
+			continue;
+		}
+
+		latency_ = std::max(latency_, now - b.times.front());
+		std::pair<std::uint32_t, bool> info{b.window_id, (b.window_id == focused_id_)};
+		on_platform_events(info, b.events);
+		b.events.clear();
+		b.times.clear();
+	}
+}
+
+void platform_event_queue::get_input_events(std::vector<input_event>& events) const
+{
+	events.clear();
+	for(const auto& b : batches_)
+	{
+		for(std::size_t i = 0; i < b.events.size(); ++i)
+		{
+			if(is_input(b.events[i]))
+			{
+				events.push_back({b.window_id, b.times[i], b.events[i]});
+			}
+		}
+	}
+}
+
+void platform_event_queue::replace_input_events(std::uint32_t focused_id,
+												const std::vector<input_event>& events)
+{
+	for(auto& b : batches_)
+	{
+		std::size_t kept = 0;
+		for(std::size_t i = 0; i < b.events.size(); ++i)
+		{
+			if(!is_input(b.events[i]))
+			{
+				b.events[kept] = b.events[i];
+				b.times[kept] = b.times[i];
+				++kept;
+			}
+		}
+		b.events.resize(kept);
+		b.times.resize(kept);
+	}
+
+	for(const auto& e : events)
+	{
+		auto& b = get_batch(e.window_id);
+		b.events.emplace_back(e.event);
+		b.times.emplace_back(e.time);
+	}
+	focused_id_ = focused_id;
+}
+
+bool platform_event_queue::is_input(const mml::platform_event& e)
+{
+	switch(e.type)
+	{
+		case mml::platform_event::closed:
+		case mml::platform_event::resized:
+		case mml::platform_event::lost_focus:
+		case mml::platform_event::gained_focus:
+		case mml::platform_event::mouse_entered:
+		case mml::platform_event::mouse_left:
+			return false;
+		default:
+			return true;
+	}
+}
+
+platform_event_queue::batch& platform_event_queue::get_batch(std::uint32_t window_id)
+{
+	for(auto& b : batches_)
+	{
+		if(b.window_id == window_id)
+		{
+			return b;
+		}
+	}
+
+	batches_.emplace_back();
+	batches_.back().window_id = window_id;
+	return batches_.back();
+}
+}
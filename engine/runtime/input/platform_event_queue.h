@@ -0,0 +1,107 @@
+#pragma once
+
+#include <mml/window/event.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class render_window;
+
+namespace runtime
+{
+/*
+ * platform_event_queue; collects the events of the windows between frames
+ * and emits them as one batch per window.
+ *
+ *      The events are collected while the frame waits for the fps cap too,
+ *      with the time they were taken from the os at. A mouse move following
+ *      another one replaces it, as does the move of a joystick axis, so a
+ *      fast mouse adds one event to the batch rather than hundreds.
+ */
+class platform_event_queue
+{
+public:
+	using clock_t = std::chrono::steady_clock;
+
+	/// an event of the input with the window it came to and when
+	struct input_event
+	{
+		std::uint32_t window_id = 0;
+		clock_t::time_point time;
+		mml::platform_event event;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : collect ()
+	/// <summary>
+	/// Takes the pending events of the windows from the os. Called on the
+	/// thread that made the windows, which the os delivers their events to.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void collect(const std::vector<std::unique_ptr<render_window>>& windows);
+
+	//-----------------------------------------------------------------------------
+	//  Name : dispatch ()
+	/// <summary>
+	/// Emits the events collected since the last dispatch with on_platform_events.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void dispatch();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_latency ()
+	/// <summary>
+	/// How long the oldest event of the last dispatch waited for it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	clock_t::duration get_latency() const
+	{
+		return latency_;
+	}
+
+	std::uint32_t get_focused_id() const
+	{
+		return focused_id_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_input_events ()
+	/// <summary>
+	/// The events of the input collected since the last dispatch, those of the
+	/// keyboard, the text, the mouse, the joysticks, the touches and the
+	/// sensors, in the order they came per window.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void get_input_events(std::vector<input_event>& events) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : replace_input_events ()
+	/// <summary>
+	/// Drops the events of the input collected and puts these in their place,
+	/// with the window of the id having the focus. What the windows do, close
+	/// or resize, is kept.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void replace_input_events(std::uint32_t focused_id, const std::vector<input_event>& events);
+
+	static bool is_input(const mml::platform_event& e);
+
+private:
+	struct batch
+	{
+		std::uint32_t window_id = 0;
+		std::vector<mml::platform_event> events;
+		/// when each event was taken from the os
+		std::vector<clock_t::time_point> times;
+	};
+
+	batch& get_batch(std::uint32_t window_id);
+
+	/// kept between frames for their memory, cleared by the dispatch
+	std::vector<batch> batches_;
+	std::uint32_t focused_id_ = 0;
+	clock_t::duration latency_ = clock_t::duration::zero();
+};
+}
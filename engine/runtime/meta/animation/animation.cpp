@@ -4,6 +4,7 @@
 
 #include <core/serialization/associative_archive.h>
 #include <core/serialization/binary_archive.h>
+#include <core/serialization/compact_archive.h>
 
 namespace runtime
 {
@@ -39,6 +40,7 @@ LOAD(node_animation)
 	try_load(ar, cereal::make_nvp("scaling_keys", obj.scaling_keys));
 }
 LOAD_INSTANTIATE(node_animation, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(node_animation, cereal::iarchive_compact_t);
 LOAD_INSTANTIATE(node_animation, cereal::iarchive_binary_t);
 
 SAVE(animation)
@@ -57,5 +59,6 @@ LOAD(animation)
 	try_load(ar, cereal::make_nvp("ticks_per_second", obj.channels));
 }
 LOAD_INSTANTIATE(animation, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(animation, cereal::iarchive_compact_t);
 LOAD_INSTANTIATE(animation, cereal::iarchive_binary_t);
 }
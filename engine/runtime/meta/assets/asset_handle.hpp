@@ -20,13 +20,16 @@ namespace cereal
 template <typename Archive, typename T>
 inline void SAVE_FUNCTION_NAME(Archive& ar, asset_link<T> const& obj)
 {
-	try_save(ar, cereal::make_nvp("id", obj.id));
+	// the files keep the key, the id is interned again on load
+	try_save(ar, cereal::make_nvp("id", obj.id.str()));
 }
 
 template <typename Archive, typename T>
 inline void LOAD_FUNCTION_NAME(Archive& ar, asset_link<T>& obj)
 {
-	try_load(ar, cereal::make_nvp("id", obj.id));
+	std::string id;
+	try_load(ar, cereal::make_nvp("id", id));
+	obj.id = id;
 }
 
 template <typename Archive, typename T>
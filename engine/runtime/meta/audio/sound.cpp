@@ -41,6 +41,7 @@ SAVE(sound_data)
 {
 	try_save(ar, cereal::make_nvp("info", obj.info));
 	try_save(ar, cereal::make_nvp("data", obj.data));
+	try_save(ar, cereal::make_nvp("encoded", obj.encoded));
 }
 SAVE_INSTANTIATE(sound_data, cereal::oarchive_binary_t);
 
@@ -48,6 +49,7 @@ LOAD(sound_data)
 {
 	try_load(ar, cereal::make_nvp("info", obj.info));
 	try_load(ar, cereal::make_nvp("data", obj.data));
+	try_load(ar, cereal::make_nvp("encoded", obj.encoded));
 }
 LOAD_INSTANTIATE(sound_data, cereal::iarchive_binary_t);
 }
@@ -38,3 +38,30 @@ inline void SERIALIZE_FUNCTION_NAME(Archive& ar, math::color& obj)
 	try_serialize(ar, cereal::make_nvp("a", obj.value.a));
 }
 }
+
+namespace serialization
+{
+template <typename T, math::qualifier P>
+struct is_bulk_serializable<math::tvec2<T, P>>
+	: std::integral_constant<bool, std::is_arithmetic<T>::value && sizeof(math::tvec2<T, P>) == 2 * sizeof(T)>
+{
+};
+
+template <typename T, math::qualifier P>
+struct is_bulk_serializable<math::tvec3<T, P>>
+	: std::integral_constant<bool, std::is_arithmetic<T>::value && sizeof(math::tvec3<T, P>) == 3 * sizeof(T)>
+{
+};
+
+template <typename T, math::qualifier P>
+struct is_bulk_serializable<math::tvec4<T, P>>
+	: std::integral_constant<bool, std::is_arithmetic<T>::value && sizeof(math::tvec4<T, P>) == 4 * sizeof(T)>
+{
+};
+
+template <>
+struct is_bulk_serializable<math::color>
+	: std::integral_constant<bool, sizeof(math::color) == 4 * sizeof(float)>
+{
+};
+}
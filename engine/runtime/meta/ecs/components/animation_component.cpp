@@ -0,0 +1,48 @@
+#include "animation_component.hpp"
+#include "component.hpp"
+
+#include "../../animation/animation.hpp"
+#include "../../assets/asset_handle.hpp"
+
+REFLECT(animation_component)
+{
+	rttr::registration::class_<animation_component>("animation_component")(
+		rttr::metadata("category", "ANIMATION"), rttr::metadata("pretty_name", "Animation"))
+		.constructor<>()(rttr::policy::ctor::as_std_shared_ptr)
+		.property("auto_play", &animation_component::get_autoplay,
+				  &animation_component::set_autoplay)(rttr::metadata("pretty_name", "Auto Play"))
+		.property("loop", &animation_component::is_looping,
+				  &animation_component::set_loop)(rttr::metadata("pretty_name", "Loop"))
+		.property("speed", &animation_component::get_speed, &animation_component::set_speed)(
+			rttr::metadata("pretty_name", "Speed"),
+			rttr::metadata("tooltip", "A multiplier for the time, negative plays backwards."),
+			rttr::metadata("min", -10.0f), rttr::metadata("max", 10.0f))
+		.property("animation", &animation_component::get_animation,
+				  &animation_component::set_animation)(rttr::metadata("pretty_name", "Animation"));
+}
+
+SAVE(animation_component)
+{
+	try_save(ar, cereal::make_nvp("base_type", cereal::base_class<runtime::component>(&obj)));
+	try_save(ar, cereal::make_nvp("auto_play", obj.auto_play_));
+	try_save(ar, cereal::make_nvp("loop", obj.loop_));
+	try_save(ar, cereal::make_nvp("speed", obj.speed_));
+	try_save(ar, cereal::make_nvp("animation", obj.current_.anim));
+}
+SAVE_INSTANTIATE(animation_component, cereal::oarchive_associative_t);
+SAVE_INSTANTIATE(animation_component, cereal::oarchive_binary_t);
+
+LOAD(animation_component)
+{
+	asset_handle<runtime::animation> anim;
+	try_load(ar, cereal::make_nvp("base_type", cereal::base_class<runtime::component>(&obj)));
+	try_load(ar, cereal::make_nvp("auto_play", obj.auto_play_));
+	try_load(ar, cereal::make_nvp("loop", obj.loop_));
+	try_load(ar, cereal::make_nvp("speed", obj.speed_));
+	try_load(ar, cereal::make_nvp("animation", anim));
+
+	obj.set_animation(anim);
+}
+LOAD_INSTANTIATE(animation_component, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(animation_component, cereal::iarchive_compact_t);
+LOAD_INSTANTIATE(animation_component, cereal::iarchive_binary_t);
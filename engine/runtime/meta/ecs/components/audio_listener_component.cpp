@@ -25,4 +25,5 @@ LOAD(audio_listener_component)
 	try_load(ar, cereal::make_nvp("base_type", cereal::base_class<runtime::component>(&obj)));
 }
 LOAD_INSTANTIATE(audio_listener_component, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(audio_listener_component, cereal::iarchive_compact_t);
 LOAD_INSTANTIATE(audio_listener_component, cereal::iarchive_binary_t);
@@ -9,4 +9,5 @@ LOAD_EXTERN(audio_listener_component);
 
 #include <core/serialization/associative_archive.h>
 #include <core/serialization/binary_archive.h>
+#include <core/serialization/compact_archive.h>
 CEREAL_REGISTER_TYPE(audio_listener_component)
@@ -27,6 +27,10 @@ REFLECT(audio_source_component)
 			rttr::metadata("max", 10.0f))
 		.property("range", &audio_source_component::get_range,
 				  &audio_source_component::set_range)(rttr::metadata("pretty_name", "Range"))
+		.property("priority", &audio_source_component::get_priority, &audio_source_component::set_priority)(
+			rttr::metadata("pretty_name", "Priority"),
+			rttr::metadata("tooltip", "0 is the highest. The sources beyond the voice limit play virtually."),
+			rttr::metadata("min", 0), rttr::metadata("max", 256))
 		.property("sound", &audio_source_component::get_sound,
 				  &audio_source_component::set_sound)(rttr::metadata("pretty_name", "Sound"));
 	;
@@ -42,6 +46,7 @@ SAVE(audio_source_component)
 	try_save(ar, cereal::make_nvp("volume_rolloff", obj.volume_rolloff_));
 	try_save(ar, cereal::make_nvp("range", obj.range_));
 	try_save(ar, cereal::make_nvp("sound", obj.sound_));
+	try_save(ar, cereal::make_nvp("priority", obj.priority_));
 }
 SAVE_INSTANTIATE(audio_source_component, cereal::oarchive_associative_t);
 SAVE_INSTANTIATE(audio_source_component, cereal::oarchive_binary_t);
@@ -56,8 +61,10 @@ LOAD(audio_source_component)
 	try_load(ar, cereal::make_nvp("volume_rolloff", obj.volume_rolloff_));
 	try_load(ar, cereal::make_nvp("range", obj.range_));
 	try_load(ar, cereal::make_nvp("sound", obj.sound_));
+	try_load(ar, cereal::make_nvp("priority", obj.priority_));
 
 	obj.apply_all();
 }
 LOAD_INSTANTIATE(audio_source_component, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(audio_source_component, cereal::iarchive_compact_t);
 LOAD_INSTANTIATE(audio_source_component, cereal::iarchive_binary_t);
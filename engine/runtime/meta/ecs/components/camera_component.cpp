@@ -27,7 +27,13 @@ REFLECT(camera_component)
 		.property("far_clip_distance", &camera_component::get_far_clip,
 				  &camera_component::set_far_clip)(rttr::metadata("pretty_name", "Far Clip"))
 		.property("hdr", &camera_component::get_hdr,
-				  &camera_component::set_hdr)(rttr::metadata("pretty_name", "HDR"));
+				  &camera_component::set_hdr)(rttr::metadata("pretty_name", "HDR"))
+		.property("cull_mask", &camera_component::get_cull_mask,
+				  &camera_component::set_cull_mask)(rttr::metadata("pretty_name", "Cull Mask"))
+		.property("render_interval", &camera_component::get_render_interval,
+				  &camera_component::set_render_interval)(
+			rttr::metadata("pretty_name", "Render Interval"), rttr::metadata("min", 1),
+			rttr::metadata("tooltip", "The frames between two renders of the camera."));
 }
 
 SAVE(camera_component)
@@ -35,6 +41,8 @@ SAVE(camera_component)
 	try_save(ar, cereal::make_nvp("base_type", cereal::base_class<runtime::component>(&obj)));
 	try_save(ar, cereal::make_nvp("camera", obj.camera_));
 	try_save(ar, cereal::make_nvp("hdr", obj.hdr_));
+	try_save(ar, cereal::make_nvp("cull_mask", obj.cull_mask_));
+	try_save(ar, cereal::make_nvp("render_interval", obj.render_interval_));
 }
 SAVE_INSTANTIATE(camera_component, cereal::oarchive_associative_t);
 SAVE_INSTANTIATE(camera_component, cereal::oarchive_binary_t);
@@ -44,6 +52,9 @@ LOAD(camera_component)
 	try_load(ar, cereal::make_nvp("base_type", cereal::base_class<runtime::component>(&obj)));
 	try_load(ar, cereal::make_nvp("camera", obj.camera_));
 	try_load(ar, cereal::make_nvp("hdr", obj.hdr_));
+	try_load(ar, cereal::make_nvp("cull_mask", obj.cull_mask_));
+	try_load(ar, cereal::make_nvp("render_interval", obj.render_interval_));
 }
 LOAD_INSTANTIATE(camera_component, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(camera_component, cereal::iarchive_compact_t);
 LOAD_INSTANTIATE(camera_component, cereal::iarchive_binary_t);
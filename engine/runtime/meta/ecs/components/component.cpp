@@ -3,6 +3,7 @@
 
 #include <core/serialization/associative_archive.h>
 #include <core/serialization/binary_archive.h>
+#include <core/serialization/compact_archive.h>
 
 namespace runtime
 {
@@ -25,5 +26,6 @@ LOAD(component)
 	obj.touch();
 }
 LOAD_INSTANTIATE(component, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(component, cereal::iarchive_compact_t);
 LOAD_INSTANTIATE(component, cereal::iarchive_binary_t);
 }
@@ -8,13 +8,16 @@ REFLECT(light_component)
 {
 	rttr::registration::class_<light_component>("light_component")(rttr::metadata("category", "LIGHTING"),
 																   rttr::metadata("pretty_name", "Light"))
-		.constructor<>()(rttr::policy::ctor::as_std_shared_ptr);
+		.constructor<>()(rttr::policy::ctor::as_std_shared_ptr)
+		.property("layers", &light_component::get_layers,
+				  &light_component::set_layers)(rttr::metadata("pretty_name", "Layers"));
 }
 
 SAVE(light_component)
 {
 	try_save(ar, cereal::make_nvp("base_type", cereal::base_class<runtime::component>(&obj)));
 	try_save(ar, cereal::make_nvp("light", obj.light_));
+	try_save(ar, cereal::make_nvp("layers", obj.layers_));
 }
 SAVE_INSTANTIATE(light_component, cereal::oarchive_associative_t);
 SAVE_INSTANTIATE(light_component, cereal::oarchive_binary_t);
@@ -23,6 +26,8 @@ LOAD(light_component)
 {
 	try_load(ar, cereal::make_nvp("base_type", cereal::base_class<runtime::component>(&obj)));
 	try_load(ar, cereal::make_nvp("light", obj.light_));
+	try_load(ar, cereal::make_nvp("layers", obj.layers_));
 }
 LOAD_INSTANTIATE(light_component, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(light_component, cereal::iarchive_compact_t);
 LOAD_INSTANTIATE(light_component, cereal::iarchive_binary_t);
@@ -10,4 +10,5 @@ LOAD_EXTERN(light_component);
 
 #include <core/serialization/associative_archive.h>
 #include <core/serialization/binary_archive.h>
+#include <core/serialization/compact_archive.h>
 CEREAL_REGISTER_TYPE(light_component)
@@ -18,6 +18,8 @@ REFLECT(model_component)
 				  &model_component::set_casts_shadow)(rttr::metadata("pretty_name", "Casts Shadow"))
 		.property("casts_reflection", &model_component::casts_reflection,
 				  &model_component::set_casts_reflection)(rttr::metadata("pretty_name", "Casts Reflection"))
+		.property("layers", &model_component::get_layers,
+				  &model_component::set_layers)(rttr::metadata("pretty_name", "Layers"))
 		.property("model", &model_component::get_model,
 				  &model_component::set_model)(rttr::metadata("pretty_name", "Model"));
 }
@@ -30,6 +32,7 @@ SAVE(model_component)
 	try_save(ar, cereal::make_nvp("casts_reflection", obj.casts_reflection_));
 	try_save(ar, cereal::make_nvp("model", obj.model_));
 	try_save(ar, cereal::make_nvp("bone_entities", obj.bone_entities_));
+	try_save(ar, cereal::make_nvp("layers", obj.layers_));
 }
 SAVE_INSTANTIATE(model_component, cereal::oarchive_associative_t);
 SAVE_INSTANTIATE(model_component, cereal::oarchive_binary_t);
@@ -42,6 +45,8 @@ LOAD(model_component)
 	try_load(ar, cereal::make_nvp("casts_reflection", obj.casts_reflection_));
 	try_load(ar, cereal::make_nvp("model", obj.model_));
 	try_load(ar, cereal::make_nvp("bone_entities", obj.bone_entities_));
+	try_load(ar, cereal::make_nvp("layers", obj.layers_));
 }
 LOAD_INSTANTIATE(model_component, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(model_component, cereal::iarchive_compact_t);
 LOAD_INSTANTIATE(model_component, cereal::iarchive_binary_t);
@@ -7,13 +7,16 @@ REFLECT(reflection_probe_component)
 {
 	rttr::registration::class_<reflection_probe_component>("reflection_probe_component")(
 		rttr::metadata("category", "LIGHTING"), rttr::metadata("pretty_name", "Reflection Probe"))
-		.constructor<>()(rttr::policy::ctor::as_std_shared_ptr);
+		.constructor<>()(rttr::policy::ctor::as_std_shared_ptr)
+		.property("cull_mask", &reflection_probe_component::get_cull_mask,
+				  &reflection_probe_component::set_cull_mask)(rttr::metadata("pretty_name", "Cull Mask"));
 }
 
 SAVE(reflection_probe_component)
 {
 	try_save(ar, cereal::make_nvp("base_type", cereal::base_class<runtime::component>(&obj)));
 	try_save(ar, cereal::make_nvp("probe", obj.probe_));
+	try_save(ar, cereal::make_nvp("cull_mask", obj.cull_mask_));
 }
 SAVE_INSTANTIATE(reflection_probe_component, cereal::oarchive_associative_t);
 SAVE_INSTANTIATE(reflection_probe_component, cereal::oarchive_binary_t);
@@ -22,6 +25,8 @@ LOAD(reflection_probe_component)
 {
 	try_load(ar, cereal::make_nvp("base_type", cereal::base_class<runtime::component>(&obj)));
 	try_load(ar, cereal::make_nvp("probe", obj.probe_));
+	try_load(ar, cereal::make_nvp("cull_mask", obj.cull_mask_));
 }
 LOAD_INSTANTIATE(reflection_probe_component, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(reflection_probe_component, cereal::iarchive_compact_t);
 LOAD_INSTANTIATE(reflection_probe_component, cereal::iarchive_binary_t);
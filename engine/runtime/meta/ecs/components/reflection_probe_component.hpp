@@ -9,4 +9,5 @@ LOAD_EXTERN(reflection_probe_component);
 
 #include <core/serialization/associative_archive.h>
 #include <core/serialization/binary_archive.h>
+#include <core/serialization/compact_archive.h>
 CEREAL_REGISTER_TYPE(reflection_probe_component)
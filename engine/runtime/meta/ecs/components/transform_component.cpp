@@ -44,11 +44,12 @@ LOAD(transform_component)
 			auto child_transform = child.get_component<transform_component>().lock();
 			if(child_transform)
 			{
-				child_transform->parent_ = obj.get_entity();
+				child_transform->assign_parent(obj.get_entity());
 			}
 		}
 	}
 	obj.set_dirty(true);
 }
 LOAD_INSTANTIATE(transform_component, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(transform_component, cereal::iarchive_compact_t);
 LOAD_INSTANTIATE(transform_component, cereal::iarchive_binary_t);
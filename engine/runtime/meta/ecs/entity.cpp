@@ -2,6 +2,7 @@
 
 #include <core/serialization/associative_archive.h>
 #include <core/serialization/binary_archive.h>
+#include <core/serialization/compact_archive.h>
 #include <core/serialization/types/vector.hpp>
 #include <core/system/subsystem.h>
 
@@ -9,8 +10,9 @@ namespace runtime
 {
 std::map<std::uint64_t, runtime::entity>& get_serialization_map()
 {
-	/// Keep count of serialized entities
-	static std::map<std::uint64_t, runtime::entity> serialization_map;
+	/// Keep count of serialized entities, per thread as the chunks of a scene are
+	/// serialized in parallel
+	static thread_local std::map<std::uint64_t, runtime::entity> serialization_map;
 	return serialization_map;
 }
 
@@ -77,5 +79,6 @@ LOAD(entity)
 }
 
 LOAD_INSTANTIATE(entity, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(entity, cereal::iarchive_compact_t);
 LOAD_INSTANTIATE(entity, cereal::iarchive_binary_t);
 }
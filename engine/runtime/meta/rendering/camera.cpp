@@ -3,6 +3,7 @@
 
 #include <core/serialization/associative_archive.h>
 #include <core/serialization/binary_archive.h>
+#include <core/serialization/compact_archive.h>
 
 REFLECT(camera)
 {
@@ -47,4 +48,5 @@ LOAD(camera)
 	obj.frustum_dirty_ = true;
 }
 LOAD_INSTANTIATE(camera, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(camera, cereal::iarchive_compact_t);
 LOAD_INSTANTIATE(camera, cereal::iarchive_binary_t);
@@ -3,6 +3,7 @@
 
 #include <core/serialization/associative_archive.h>
 #include <core/serialization/binary_archive.h>
+#include <core/serialization/compact_archive.h>
 
 REFLECT(light)
 {
@@ -97,4 +98,5 @@ LOAD(light)
 	try_load(ar, cereal::make_nvp("color", obj.color));
 }
 LOAD_INSTANTIATE(light, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(light, cereal::iarchive_compact_t);
 LOAD_INSTANTIATE(light, cereal::iarchive_binary_t);
@@ -2,6 +2,7 @@
 
 #include <core/serialization/associative_archive.h>
 #include <core/serialization/binary_archive.h>
+#include <core/serialization/compact_archive.h>
 
 REFLECT(material)
 {
@@ -26,4 +27,5 @@ LOAD(material)
 	try_load(ar, cereal::make_nvp("cull_type", obj.cull_type_));
 }
 LOAD_INSTANTIATE(material, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(material, cereal::iarchive_compact_t);
 LOAD_INSTANTIATE(material, cereal::iarchive_binary_t);
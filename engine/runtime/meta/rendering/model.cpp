@@ -7,6 +7,7 @@
 
 #include <core/serialization/associative_archive.h>
 #include <core/serialization/binary_archive.h>
+#include <core/serialization/compact_archive.h>
 #include <core/serialization/types/vector.hpp>
 
 
@@ -48,4 +49,5 @@ LOAD(model)
 	try_load(ar, cereal::make_nvp("lod_limits", obj.lod_limits_));
 }
 LOAD_INSTANTIATE(model, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(model, cereal::iarchive_compact_t);
 LOAD_INSTANTIATE(model, cereal::iarchive_binary_t);
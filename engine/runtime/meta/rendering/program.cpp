@@ -3,6 +3,7 @@
 
 #include <core/serialization/associative_archive.h>
 #include <core/serialization/binary_archive.h>
+#include <core/serialization/compact_archive.h>
 #include <core/serialization/types/vector.hpp>
 
 SAVE(gpu_program)
@@ -25,4 +26,5 @@ LOAD(gpu_program)
 	obj.populate();
 }
 LOAD_INSTANTIATE(gpu_program, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(gpu_program, cereal::iarchive_compact_t);
 LOAD_INSTANTIATE(gpu_program, cereal::iarchive_binary_t);
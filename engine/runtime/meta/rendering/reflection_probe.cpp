@@ -3,6 +3,7 @@
 
 #include <core/serialization/associative_archive.h>
 #include <core/serialization/binary_archive.h>
+#include <core/serialization/compact_archive.h>
 
 REFLECT(reflection_probe)
 {
@@ -42,4 +43,5 @@ LOAD(reflection_probe)
 	try_load(ar, cereal::make_nvp("range", obj.sphere_data.range));
 }
 LOAD_INSTANTIATE(reflection_probe, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(reflection_probe, cereal::iarchive_compact_t);
 LOAD_INSTANTIATE(reflection_probe, cereal::iarchive_binary_t);
@@ -2,6 +2,7 @@
 #include "material.hpp"
 
 #include "../assets/asset_handle.hpp"
+#include "../../rendering/virtual_texturing.h"
 #include "../core/math/vector.hpp"
 
 #include <core/serialization/types/string.hpp>
@@ -61,6 +62,7 @@ SAVE(standard_material)
 	try_save(ar, cereal::make_nvp("tiling", obj.tiling_));
 	try_save(ar, cereal::make_nvp("dither_threshold", obj.dither_threshold_));
 	try_save(ar, cereal::make_nvp("maps", obj.maps_));
+	try_save(ar, cereal::make_nvp("virtual_color_map", obj.virtual_color_map_));
 }
 SAVE_INSTANTIATE(standard_material, cereal::oarchive_associative_t);
 SAVE_INSTANTIATE(standard_material, cereal::oarchive_binary_t);
@@ -75,6 +77,10 @@ LOAD(standard_material)
 	try_load(ar, cereal::make_nvp("tiling", obj.tiling_));
 	try_load(ar, cereal::make_nvp("dither_threshold", obj.dither_threshold_));
 	try_load(ar, cereal::make_nvp("maps", obj.maps_));
+	asset_handle<virtual_texture> virtual_color_map;
+	try_load(ar, cereal::make_nvp("virtual_color_map", virtual_color_map));
+	obj.set_virtual_color_map(virtual_color_map);
 }
 LOAD_INSTANTIATE(standard_material, cereal::iarchive_associative_t);
+LOAD_INSTANTIATE(standard_material, cereal::iarchive_compact_t);
 LOAD_INSTANTIATE(standard_material, cereal::iarchive_binary_t);
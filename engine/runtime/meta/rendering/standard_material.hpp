@@ -10,4 +10,5 @@ LOAD_EXTERN(standard_material);
 
 #include <core/serialization/associative_archive.h>
 #include <core/serialization/binary_archive.h>
+#include <core/serialization/compact_archive.h>
 CEREAL_REGISTER_TYPE(standard_material)
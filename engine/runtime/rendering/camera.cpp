@@ -2,6 +2,7 @@
 
 #include <core/graphics/graphics.h>
 
+#include <atomic>
 #include <limits>
 
 float camera::get_zoom_factor() const
@@ -21,6 +22,12 @@ float camera::get_ppu() const
 
 void camera::set_viewport_size(const usize32_t& viewport_size)
 {
+	if(viewport_size != viewport_size_)
+	{
+		// the orthographic projection is sized by the viewport
+		projection_dirty_ = true;
+		version_ = new_version();
+	}
 	viewport_size_ = viewport_size;
 	set_aspect_ratio(float(viewport_size.width) / float(viewport_size.height));
 }
@@ -132,6 +139,7 @@ void camera::set_aspect_ratio(float aspect, bool bLocked /* = false */)
 	aspect_dirty_ = true;
 	frustum_dirty_ = true;
 	projection_dirty_ = true;
+	version_ = new_version();
 }
 
 bool camera::is_aspect_locked() const
@@ -646,6 +654,7 @@ void camera::set_aa_data(const usize32_t& viewport_size, std::uint32_t current_s
 	}
 
 	projection_dirty_ = true;
+	version_ = new_version();
 }
 
 void camera::touch()
@@ -655,6 +664,13 @@ void camera::touch()
 	view_dirty_ = true;
 	projection_dirty_ = true;
 	frustum_dirty_ = true;
+	version_ = new_version();
+}
+
+std::uint64_t camera::new_version()
+{
+	static std::atomic<std::uint64_t> last = {0};
+	return ++last;
 }
 
 camera camera::get_face_camera(uint32_t face, const math::transform& transform)
@@ -246,7 +246,25 @@ public:
 	//-----------------------------------------------------------------------------
 	inline void lock_frustum(bool locked)
 	{
-		frustum_locked_ = locked;
+		if(frustum_locked_ != locked)
+		{
+			frustum_locked_ = locked;
+			version_ = new_version();
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_version ()
+	/// <summary>
+	/// Changes with every change of the view, the projection or the frustum
+	/// and is unique across cameras, so what was derived from a camera, like
+	/// the result of a cull, can be kept for as long as it stays the same.
+	/// Copies of a camera share it until they change.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline std::uint64_t get_version() const
+	{
+		return version_;
 	}
 
 	//-----------------------------------------------------------------------------
@@ -569,6 +587,8 @@ public:
 	static camera get_face_camera(std::uint32_t face, const math::transform& transform);
 
 protected:
+	static std::uint64_t new_version();
+
 	//-------------------------------------------------------------------------
 	// Protected Variables
 	//-------------------------------------------------------------------------
@@ -616,4 +636,6 @@ protected:
 	bool aspect_locked_ = false;
 	/// Is the frustum locked?
 	bool frustum_locked_ = false;
+	/// See get_version.
+	std::uint64_t version_ = new_version();
 };
@@ -0,0 +1,72 @@
+#include "dynamic_resolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+constexpr float dynamic_resolution::scale_step;
+constexpr std::uint32_t dynamic_resolution::cooldown_frames;
+
+namespace
+{
+// the average follows the gpu time over about ten frames
+constexpr double average_weight = 0.1;
+// the frame time aimed for, below the target to not bounce on it
+constexpr double headroom = 0.9;
+}
+
+void dynamic_resolution::update(double gpu_ms)
+{
+	if(!enabled_ || gpu_ms <= 0.0)
+	{
+		return;
+	}
+
+	average_ms_ = has_average_ ? average_ms_ + (gpu_ms - average_ms_) * average_weight : gpu_ms;
+	has_average_ = true;
+
+	if(++frames_since_change_ < cooldown_frames || target_ms_ <= 0.0)
+	{
+		return;
+	}
+
+	// the gpu time goes with the pixels, the square of the scale
+	const float wanted = scale_ * float(std::sqrt(target_ms_ * headroom / average_ms_));
+	float scale = scale_;
+	if(average_ms_ > target_ms_)
+	{
+		scale = std::floor(wanted / scale_step) * scale_step;
+	}
+	else if(wanted >= scale_ + scale_step)
+	{
+		scale = scale_ + scale_step;
+	}
+
+	scale = std::min(std::max(scale, min_scale_), max_scale_);
+	if(std::abs(scale - scale_) < scale_step * 0.5f)
+	{
+		return;
+	}
+
+	// the frames in flight still take the old time, guess the new one
+	average_ms_ *= double(scale * scale) / double(scale_ * scale_);
+	scale_ = scale;
+	frames_since_change_ = 0;
+}
+
+void dynamic_resolution::set_enabled(bool enabled)
+{
+	enabled_ = enabled;
+	scale_ = enabled ? max_scale_ : 1.0f;
+	has_average_ = false;
+	frames_since_change_ = 0;
+}
+
+void dynamic_resolution::set_scale_range(float min_scale, float max_scale)
+{
+	max_scale_ = std::min(std::max(max_scale, scale_step), 1.0f);
+	min_scale_ = std::min(std::max(min_scale, scale_step), max_scale_);
+	if(enabled_)
+	{
+		scale_ = std::min(std::max(scale_, min_scale_), max_scale_);
+	}
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * dynamic_resolution; the scale the cameras render their viewports at, made
+ * smaller when the gpu takes longer than the target frame time and bigger
+ * again when it has time to spare.
+ *
+ *      The gpu time is averaged over a few frames and the scale changes in
+ *      steps, at most once every few frames since the time measured lags the
+ *      frames rendered. The scale drops as far as the time needs at once and
+ *      rises a step at a time, the pixels rendered go with the square of it.
+ */
+class dynamic_resolution
+{
+public:
+	static constexpr float scale_step = 0.05f;
+	/// frames to wait after a change before the next one
+	static constexpr std::uint32_t cooldown_frames = 8;
+
+	//-----------------------------------------------------------------------------
+	//  Name : update ()
+	/// <summary>
+	/// Adds the gpu time of a frame and adjusts the scale. Call it once per
+	/// frame, before the cameras render.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void update(double gpu_ms);
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_enabled ()
+	/// <summary>
+	/// Disabled the scale stays 1.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_enabled(bool enabled);
+
+	bool is_enabled() const
+	{
+		return enabled_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_scale_range ()
+	/// <summary>
+	/// Limits of the scale, clamped to (0, 1].
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_scale_range(float min_scale, float max_scale);
+
+	void set_target_ms(double target_ms)
+	{
+		target_ms_ = target_ms;
+	}
+
+	double get_target_ms() const
+	{
+		return target_ms_;
+	}
+
+	float get_scale() const
+	{
+		return scale_;
+	}
+
+	/// the averaged gpu time of the last frames
+	double get_average_ms() const
+	{
+		return average_ms_;
+	}
+
+private:
+	bool enabled_ = false;
+	double target_ms_ = 1000.0 / 60.0;
+	float min_scale_ = 0.5f;
+	float max_scale_ = 1.0f;
+	float scale_ = 1.0f;
+	double average_ms_ = 0.0;
+	bool has_average_ = false;
+	std::uint32_t frames_since_change_ = 0;
+};
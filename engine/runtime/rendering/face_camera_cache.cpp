@@ -0,0 +1,41 @@
+#include "face_camera_cache.h"
+
+face_camera_cache::cameras_t& face_camera_cache::get(std::uint64_t source, const math::transform& world,
+													 float far_clip)
+{
+	return get_entry(source, world, far_clip).cameras;
+}
+
+const face_camera_cache::frustums_t& face_camera_cache::get_frustums(std::uint64_t source,
+																	 const math::transform& world,
+																	 float far_clip)
+{
+	return get_entry(source, world, far_clip).frustums;
+}
+
+void face_camera_cache::remove(std::uint64_t source)
+{
+	entries_.erase(source);
+}
+
+face_camera_cache::entry& face_camera_cache::get_entry(std::uint64_t source, const math::transform& world,
+														float far_clip)
+{
+	auto& e = entries_[source];
+	const auto& m = world.get_matrix();
+	if(e.valid && e.far_clip == far_clip && e.world == m)
+	{
+		return e;
+	}
+
+	for(std::uint32_t i = 0; i < 6; ++i)
+	{
+		e.cameras[i] = camera::get_face_camera(i, world);
+		e.cameras[i].set_far_clip(far_clip);
+		e.frustums[i] = e.cameras[i].get_frustum();
+	}
+	e.world = m;
+	e.far_clip = far_clip;
+	e.valid = true;
+	return e;
+}
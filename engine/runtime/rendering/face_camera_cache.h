@@ -0,0 +1,62 @@
+#pragma once
+
+#include "camera.h"
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+/*
+ * face_camera_cache; the six cube face cameras of the probes and point
+ * lights, kept between frames.
+ *
+ *      The cameras of a source are made again only when its transform or
+ *      its range changed, a static one keeps its cameras, and with them
+ *      their frustums and versions, for as long as it is kept.
+ */
+class face_camera_cache
+{
+public:
+	using cameras_t = std::array<camera, 6>;
+	using frustums_t = std::array<math::frustum, 6>;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get ()
+	/// <summary>
+	/// The face cameras of the source at the transform, reaching to far_clip.
+	/// They are valid until the next get or remove for the source.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	cameras_t& get(std::uint64_t source, const math::transform& world, float far_clip);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_frustums ()
+	/// <summary>
+	/// The frustums of the face cameras side by side, for the multi view
+	/// culls. Valid as long as the cameras.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const frustums_t& get_frustums(std::uint64_t source, const math::transform& world, float far_clip);
+
+	//-----------------------------------------------------------------------------
+	//  Name : remove ()
+	/// <summary>
+	/// Forgets the cameras of the source.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void remove(std::uint64_t source);
+
+private:
+	struct entry
+	{
+		math::mat4 world = math::mat4(0.0f);
+		float far_clip = 0.0f;
+		bool valid = false;
+		cameras_t cameras;
+		frustums_t frustums;
+	};
+
+	entry& get_entry(std::uint64_t source, const math::transform& world, float far_clip);
+
+	std::unordered_map<std::uint64_t, entry> entries_;
+};
@@ -0,0 +1,284 @@
+#include "gpu_capture.h"
+
+#include <core/common/platform/config.hpp>
+#include <core/logging/logging.h>
+#include <core/profiling/profiler.h>
+#include <core/simulation/simulation.h>
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <vector>
+
+#if ETH_ON(ETH_PLATFORM_WINDOWS)
+#include <Windows.h>
+#define RENDERDOC_CC __cdecl
+#else
+#include <dlfcn.h>
+#define RENDERDOC_CC
+#endif
+
+namespace runtime
+{
+/*
+ * api; the functions of RENDERDOC_API_1_2_0 in the order of renderdoc_app.h,
+ * those not used here typed loosely. Version 1.1.0 is the same without the
+ * comments.
+ */
+struct gpu_capture::api
+{
+	using any_fn = void(RENDERDOC_CC*)();
+
+	void(RENDERDOC_CC* get_api_version)(int* major, int* minor, int* patch);
+	any_fn set_capture_option_u32;
+	any_fn set_capture_option_f32;
+	any_fn get_capture_option_u32;
+	any_fn get_capture_option_f32;
+	any_fn set_focus_toggle_keys;
+	any_fn set_capture_keys;
+	any_fn get_overlay_bits;
+	any_fn mask_overlay_bits;
+	any_fn remove_hooks;
+	any_fn unload_crash_handler;
+	void(RENDERDOC_CC* set_capture_file_path_template)(const char* path_template);
+	any_fn get_capture_file_path_template;
+	std::uint32_t(RENDERDOC_CC* get_num_captures)();
+	std::uint32_t(RENDERDOC_CC* get_capture)(std::uint32_t index, char* path, std::uint32_t* path_length,
+											 std::uint64_t* timestamp);
+	void(RENDERDOC_CC* trigger_capture)();
+	any_fn is_target_control_connected;
+	any_fn launch_replay_ui;
+	any_fn set_active_window;
+	any_fn start_frame_capture;
+	any_fn is_frame_capturing;
+	any_fn end_frame_capture;
+	any_fn trigger_multi_frame_capture;
+	void(RENDERDOC_CC* set_capture_file_comments)(const char* path, const char* comments);
+};
+
+namespace
+{
+/// eRENDERDOC_API_Version_1_2_0 and 1_1_0
+constexpr int api_version_comments = 10200;
+constexpr int api_version = 10100;
+/// the zones listed in the comments
+constexpr std::size_t max_zones = 16;
+/// a capture not written by then is given up on
+constexpr auto write_timeout = std::chrono::seconds(30);
+
+using get_api_fn = int(RENDERDOC_CC*)(int version, void** api);
+
+get_api_fn find_get_api(bool load_library)
+{
+#if ETH_ON(ETH_PLATFORM_WINDOWS)
+	HMODULE module = GetModuleHandleA("renderdoc.dll");
+	if(module == nullptr && load_library)
+	{
+		module = LoadLibraryA("renderdoc.dll");
+	}
+	if(module == nullptr)
+	{
+		return nullptr;
+	}
+	return reinterpret_cast<get_api_fn>(GetProcAddress(module, "RENDERDOC_GetAPI"));
+#elif ETH_ON(ETH_PLATFORM_LINUX)
+	void* module = dlopen("librenderdoc.so", RTLD_NOW | RTLD_NOLOAD);
+	if(module == nullptr && load_library)
+	{
+		module = dlopen("librenderdoc.so", RTLD_NOW);
+	}
+	if(module == nullptr)
+	{
+		return nullptr;
+	}
+	return reinterpret_cast<get_api_fn>(dlsym(module, "RENDERDOC_GetAPI"));
+#else
+	(void)load_library;
+	return nullptr;
+#endif
+}
+
+// what a file name can have of the name of the scene
+std::string to_file_name(const std::string& scene)
+{
+	auto name = fs::path(scene).stem().string();
+	std::replace_if(std::begin(name), std::end(name),
+					[](char c) { return !std::isalnum(static_cast<unsigned char>(c)) && c != '-'; }, '_');
+	return name;
+}
+
+void write_zones(std::ostream& out, const char* title, profiling::clock_t::time_point begin,
+				 profiling::clock_t::time_point end)
+{
+	using ms_t = std::chrono::duration<double, std::milli>;
+	const auto totals = profiling::get_zone_totals(begin, end);
+	out << title << " (" << ms_t(end - begin).count() << "ms):\n";
+	for(std::size_t i = 0; i < totals.size() && i < max_zones; ++i)
+	{
+		out << "  " << totals[i].name << " " << ms_t(totals[i].time).count() << "ms x" << totals[i].count
+			<< "\n";
+	}
+	if(totals.empty())
+	{
+		out << "  no zones, the profiling was not enabled\n";
+	}
+}
+}
+
+bool gpu_capture::load(bool load_library)
+{
+	const auto get_api = find_get_api(load_library);
+	if(get_api == nullptr)
+	{
+		if(load_library)
+		{
+			APPLOG_WARNING("RenderDoc was not found, no gpu captures will be taken.");
+		}
+		return false;
+	}
+
+	void* table = nullptr;
+	if(get_api(api_version_comments, &table) != 1 && get_api(api_version, &table) != 1)
+	{
+		APPLOG_WARNING("The RenderDoc library has no api this app knows.");
+		return false;
+	}
+
+	api_ = static_cast<api*>(table);
+	int major = 0;
+	int minor = 0;
+	int patch = 0;
+	api_->get_api_version(&major, &minor, &patch);
+	if(major == 1 && minor < 2)
+	{
+		// the table of 1.1 ends before the comments
+		comments_supported_ = false;
+	}
+	set_path(dir_);
+	APPLOG_INFO("RenderDoc api {0}.{1}.{2} loaded, captures go to {3}.", major, minor, patch,
+				dir_.string());
+	return true;
+}
+
+void gpu_capture::set_path(const fs::path& dir)
+{
+	dir_ = dir;
+	if(api_ != nullptr)
+	{
+		fs::error_code err;
+		fs::create_directories(dir_, err);
+		api_->set_capture_file_path_template((dir_ / "capture").string().c_str());
+	}
+}
+
+void gpu_capture::set_hitch_captures(std::uint32_t max_captures, clock_t::duration cooldown)
+{
+	max_hitch_captures_ = max_captures;
+	cooldown_ = cooldown;
+}
+
+void gpu_capture::set_scene_getter(std::function<std::string()> getter)
+{
+	scene_getter_ = std::move(getter);
+}
+
+bool gpu_capture::capture(const std::string& label)
+{
+	if(api_ == nullptr || requested_ || state_ != state::idle)
+	{
+		return false;
+	}
+
+	requested_ = true;
+	label_ = label;
+	comments_.clear();
+	return true;
+}
+
+void gpu_capture::update(const core::simulation& sim)
+{
+	using ms_t = std::chrono::duration<double, std::milli>;
+	const auto now = clock_t::now();
+	if(api_ == nullptr)
+	{
+		return;
+	}
+
+	if(state_ == state::triggered)
+	{
+		// the frame of the capture is the one that just ended
+		std::ostringstream out;
+		write_zones(out, "captured frame zones", frame_begin_, now);
+		comments_ += out.str();
+		state_ = state::writing;
+		triggered_at_ = now;
+	}
+
+	if(state_ == state::writing)
+	{
+		const auto count = api_->get_num_captures();
+		if(count > captures_before_)
+		{
+			std::uint32_t length = 0;
+			api_->get_capture(count - 1, nullptr, &length, nullptr);
+			std::vector<char> path(length + 1, '\0');
+			api_->get_capture(count - 1, path.data(), &length, nullptr);
+			if(comments_supported_)
+			{
+				api_->set_capture_file_comments(path.data(), comments_.c_str());
+			}
+			++captures_;
+			state_ = state::idle;
+			APPLOG_INFO("Wrote the gpu capture {0}.", path.data());
+		}
+		else if(now - triggered_at_ > write_timeout)
+		{
+			APPLOG_WARNING("The gpu capture {0} was not written.", label_);
+			state_ = state::idle;
+		}
+	}
+
+	const auto hitches = sim.get_hitch_count();
+	if(hitches > seen_hitches_ && !sim.get_hitches().empty())
+	{
+		const auto& hitch = sim.get_hitches().back();
+		const bool cooled = hitch_captures_ == 0 || now - last_hitch_capture_ >= cooldown_;
+		if(hitch_captures_ < max_hitch_captures_ && cooled && capture("hitch_" + std::to_string(hitch.frame)))
+		{
+			++hitch_captures_;
+			last_hitch_capture_ = now;
+
+			std::ostringstream out;
+			out << "hitch at frame " << hitch.frame << ": " << ms_t(hitch.duration).count() << "ms\n";
+			write_zones(out, "hitch zones", hitch.begin, hitch.end);
+			comments_ = out.str();
+		}
+	}
+	seen_hitches_ = hitches;
+
+	if(requested_)
+	{
+		trigger();
+	}
+	frame_begin_ = now;
+}
+
+void gpu_capture::trigger()
+{
+	requested_ = false;
+	const auto scene = scene_getter_ ? scene_getter_() : std::string();
+	auto name = label_;
+	if(!scene.empty())
+	{
+		name += "_" + to_file_name(scene);
+	}
+
+	// the comments start with what took the capture
+	comments_ = "scene: " + (scene.empty() ? std::string("none") : scene) + "\ntrigger: " + label_ + "\n" +
+				comments_;
+	api_->set_capture_file_path_template((dir_ / name).string().c_str());
+	captures_before_ = api_->get_num_captures();
+	api_->trigger_capture();
+	state_ = state::triggered;
+}
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <core/filesystem/filesystem.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace core
+{
+struct simulation;
+}
+
+namespace runtime
+{
+/*
+ * gpu_capture; takes gpu captures of frames through the in-application api
+ * of RenderDoc, on demand or when the simulation sees a hitch, for what the
+ * gpu did in a slow frame to be looked at offline.
+ *
+ *      The api is taken from the RenderDoc library when the app was launched
+ *      from RenderDoc, or is loaded before the renderer when asked to, it has
+ *      to hook the graphics api before the device is made. A hitch is only
+ *      known once its frame ended, so the frame after it is captured. The
+ *      captures are named after what took them and the scene, and the capture
+ *      files are commented with the scene and the time in the profiling zones
+ *      of the frame captured, and of the hitch.
+ */
+class gpu_capture
+{
+public:
+	using clock_t = std::chrono::steady_clock;
+
+	//-----------------------------------------------------------------------------
+	//  Name : load ()
+	/// <summary>
+	/// Takes the api of the RenderDoc library of the process, or loads the
+	/// library first when told to. False when there is none, the captures
+	/// asked for are then ignored.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool load(bool load_library);
+
+	bool is_loaded() const
+	{
+		return api_ != nullptr;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_path ()
+	/// <summary>
+	/// The directory the captures are written to.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_path(const fs::path& dir);
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_hitch_captures ()
+	/// <summary>
+	/// The most captures taken on hitches, 0 takes none. Two of them are at
+	/// least the cooldown apart.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_hitch_captures(std::uint32_t max_captures,
+							clock_t::duration cooldown = std::chrono::seconds(5));
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_scene_getter ()
+	/// <summary>
+	/// Gives the name of the scene shown, for the name and the comments of
+	/// the captures.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_scene_getter(std::function<std::string()> getter);
+
+	//-----------------------------------------------------------------------------
+	//  Name : capture ()
+	/// <summary>
+	/// Captures the next frame, named after the label. Ignored while the last
+	/// capture is still taken.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool capture(const std::string& label);
+
+	//-----------------------------------------------------------------------------
+	//  Name : update ()
+	/// <summary>
+	/// Called at the start of every frame, after the simulation began it.
+	/// Takes a capture for a hitch of the frame before, and comments the
+	/// capture written since.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void update(const core::simulation& sim);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_captures ()
+	/// <summary>
+	/// The captures taken since the launch.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint32_t get_captures() const
+	{
+		return captures_;
+	}
+
+private:
+	/// the function table of RenderDoc
+	struct api;
+
+	enum class state
+	{
+		idle,
+		/// the capture is triggered, the frame it captures is running
+		triggered,
+		/// the frame is over, the capture file is being written
+		writing
+	};
+
+	void trigger();
+
+	api* api_ = nullptr;
+	/// the api is 1.2 or later
+	bool comments_supported_ = true;
+	fs::path dir_ = "captures";
+	std::function<std::string()> scene_getter_;
+	std::uint32_t max_hitch_captures_ = 0;
+	std::uint32_t hitch_captures_ = 0;
+	clock_t::duration cooldown_ = std::chrono::seconds(5);
+	clock_t::time_point last_hitch_capture_;
+	std::uint64_t seen_hitches_ = 0;
+	std::uint32_t captures_ = 0;
+
+	state state_ = state::idle;
+	/// the capture asked for, taken at the next update
+	bool requested_ = false;
+	std::string label_;
+	/// the comments of the capture, written with the file
+	std::string comments_;
+	/// the captures RenderDoc had when this one was triggered
+	std::uint32_t captures_before_ = 0;
+	clock_t::time_point triggered_at_;
+	/// the start of the frame, the begin of the frame captured when triggered
+	clock_t::time_point frame_begin_;
+};
+}
@@ -1,6 +1,8 @@
 #include "gpu_program.h"
 
 #include <core/graphics/shader.h>
+#include <core/graphics/texture.h>
+#include <core/graphics/uniform.h>
 
 #include <algorithm>
 
@@ -54,9 +56,26 @@ void gpu_program::populate()
 		{
 			shaders_cached_.push_back(shader->native_handle().idx);
 		}
+
+		uniforms_by_hash_.clear();
+		for(const auto& pair : program_->uniforms)
+		{
+			auto result = uniforms_by_hash_.emplace(hash_name(pair.first.c_str()), pair.second);
+			if(!result.second)
+				result.first->second = nullptr;
+		}
 	}
 }
 
+gfx::uniform* gpu_program::find_uniform(const uniform_id& _id) const
+{
+	auto it = uniforms_by_hash_.find(_id.hash);
+	if(it == uniforms_by_hash_.end())
+		return nullptr;
+
+	return it->second.get();
+}
+
 void gpu_program::set_texture(uint8_t _stage, const std::string& _sampler, gfx::frame_buffer* _fbo,
 							  uint8_t _attachment, uint32_t _flags)
 {
@@ -69,6 +88,24 @@ void gpu_program::set_texture(uint8_t _stage, const std::string& _sampler, gfx::
 	program_->set_texture(_stage, _sampler, _texture, _flags);
 }
 
+void gpu_program::set_texture(uint8_t _stage, const uniform_id& _sampler, gfx::texture* _texture,
+							  uint32_t _flags)
+{
+	if(_texture == nullptr)
+	{
+		return;
+	}
+
+	auto uniform = find_uniform(_sampler);
+	if(uniform == nullptr)
+	{
+		program_->set_texture(_stage, _sampler.name, _texture, _flags);
+		return;
+	}
+
+	gfx::set_texture(_stage, uniform->native_handle(), _texture->native_handle(), _flags);
+}
+
 void gpu_program::set_uniform(const std::string& _name, const void* _value, uint16_t _num)
 {
 	program_->set_uniform(_name, _value, _num);
@@ -89,6 +126,36 @@ void gpu_program::set_uniform(const std::string& _name, const glm::vec2& _value,
 	set_uniform(_name, math::vec4(_value, 0.0f, 0.0f), _num);
 }
 
+void gpu_program::set_uniform(const uniform_id& _id, const void* _value, uint16_t _num)
+{
+	auto it = uniforms_by_hash_.find(_id.hash);
+	if(it == uniforms_by_hash_.end())
+		return;
+
+	if(it->second == nullptr)
+	{
+		program_->set_uniform(_id.name, _value, _num);
+		return;
+	}
+
+	gfx::set_uniform(it->second->native_handle(), _value, _num);
+}
+
+void gpu_program::set_uniform(const uniform_id& _id, const math::vec4& _value, uint16_t _num)
+{
+	set_uniform(_id, math::value_ptr(_value), _num);
+}
+
+void gpu_program::set_uniform(const uniform_id& _id, const math::vec3& _value, uint16_t _num)
+{
+	set_uniform(_id, math::vec4(_value, 0.0f), _num);
+}
+
+void gpu_program::set_uniform(const uniform_id& _id, const math::vec2& _value, uint16_t _num)
+{
+	set_uniform(_id, math::vec4(_value, 0.0f, 0.0f), _num);
+}
+
 std::shared_ptr<gfx::uniform> gpu_program::get_uniform(const std::string& _name, bool texture)
 {
 	return program_->get_uniform(_name, texture);
@@ -13,6 +13,36 @@ public:
 	REFLECTABLE(gpu_program)
 	SERIALIZABLE(gpu_program)
 
+	//-----------------------------------------------------------------------------
+	//  Name : hash_name ()
+	/// <summary>
+	/// FNV-1a hash of a uniform name.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static constexpr std::uint32_t hash_name(const char* name)
+	{
+		std::uint32_t hash = 2166136261u;
+		for(; *name != 0; ++name)
+		{
+			hash = (hash ^ std::uint32_t(static_cast<unsigned char>(*name))) * 16777619u;
+		}
+		return hash;
+	}
+
+	/// A uniform name and its hash. Made constexpr from a literal the per draw
+	/// calls find the uniform without hashing a string.
+	struct uniform_id
+	{
+		constexpr explicit uniform_id(const char* _name)
+			: name(_name)
+			, hash(hash_name(_name))
+		{
+		}
+
+		const char* name = nullptr;
+		std::uint32_t hash = 0;
+	};
+
 	//-----------------------------------------------------------------------------
 	//  Name : gpu_program (Constructor)
 	/// <summary>
@@ -68,6 +98,16 @@ public:
 	void set_texture(std::uint8_t _stage, const std::string& _sampler, gfx::texture* _texture,
 					 std::uint32_t _flags = std::numeric_limits<std::uint32_t>::max());
 
+	//-----------------------------------------------------------------------------
+	//  Name : set_texture ()
+	/// <summary>
+	/// Sets a texture to a sampler found by its hash, falls back to the name
+	/// for a sampler the shaders don't list.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_texture(std::uint8_t _stage, const uniform_id& _sampler, gfx::texture* _texture,
+					 std::uint32_t _flags = std::numeric_limits<std::uint32_t>::max());
+
 	//-----------------------------------------------------------------------------
 	//  Name : set_uniform ()
 	/// <summary>
@@ -81,6 +121,18 @@ public:
 	void set_uniform(const std::string& _name, const math::vec3& _value, std::uint16_t _num = 1);
 	void set_uniform(const std::string& _name, const math::vec2& _value, std::uint16_t _num = 1);
 
+	//-----------------------------------------------------------------------------
+	//  Name : set_uniform ()
+	/// <summary>
+	/// Sets a uniform found by its hash. Only reads the program, so several
+	/// threads may set uniforms of the same program.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_uniform(const uniform_id& _id, const void* _value, std::uint16_t _num = 1);
+	void set_uniform(const uniform_id& _id, const math::vec4& _value, std::uint16_t _num = 1);
+	void set_uniform(const uniform_id& _id, const math::vec3& _value, std::uint16_t _num = 1);
+	void set_uniform(const uniform_id& _id, const math::vec2& _value, std::uint16_t _num = 1);
+
 	//-----------------------------------------------------------------------------
 	//  Name : get_uniform ()
 	/// <summary>
@@ -110,6 +162,7 @@ public:
 private:
 	void populate();
 	void attach_shader(asset_handle<gfx::shader> shader);
+	gfx::uniform* find_uniform(const uniform_id& _id) const;
 
 	/// Shaders that created this program.
 	std::vector<asset_handle<gfx::shader>> shaders_;
@@ -117,4 +170,7 @@ private:
 	std::vector<std::uint16_t> shaders_cached_;
 	/// program
 	std::unique_ptr<gfx::program> program_;
+	/// uniforms of the program by the hash of their names, null for a hash
+	/// two names share, those are found by name.
+	std::unordered_map<std::uint32_t, std::shared_ptr<gfx::uniform>> uniforms_by_hash_;
 };
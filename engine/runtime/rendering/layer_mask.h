@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+namespace runtime
+{
+/// the layers a model or a light is on, one bit each, and those a camera or
+/// a probe draws
+using layer_mask = std::uint32_t;
+
+namespace layers
+{
+/// what is on no layer of its own
+constexpr layer_mask default_layer = 1u << 0;
+/// every layer, what the views draw unless told otherwise
+constexpr layer_mask all = ~layer_mask(0);
+}
+}
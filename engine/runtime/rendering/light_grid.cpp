@@ -0,0 +1,223 @@
+#include "light_grid.h"
+#include "camera.h"
+#include "light.h"
+
+#include <core/graphics/format.h>
+#include <core/graphics/graphics.h>
+#include <core/graphics/render_view.h>
+#include <core/graphics/texture.h>
+
+#include <algorithm>
+#include <cmath>
+
+constexpr std::uint32_t light_grid::tiles_x;
+constexpr std::uint32_t light_grid::tiles_y;
+constexpr std::uint32_t light_grid::slices;
+constexpr std::uint32_t light_grid::light_texels;
+constexpr std::uint32_t light_grid::lights_width;
+constexpr std::uint32_t light_grid::max_lights;
+constexpr std::uint32_t light_grid::indices_width;
+constexpr std::uint32_t light_grid::max_indices;
+constexpr std::uint32_t light_grid::max_cluster_lights;
+constexpr std::uint32_t light_grid::min_lights;
+
+namespace
+{
+constexpr std::uint32_t clusters_count = light_grid::tiles_x * light_grid::tiles_y * light_grid::slices;
+constexpr std::uint32_t lights_height =
+	light_grid::max_lights * light_grid::light_texels / light_grid::lights_width;
+constexpr std::uint32_t indices_height = light_grid::max_indices / light_grid::indices_width;
+constexpr gfx::texture_format data_format = gfx::texture_format::RGBA32F;
+constexpr gfx::texture_format index_format = gfx::texture_format::R32F;
+constexpr std::uint64_t data_flags = BGFX_SAMPLER_MIN_POINT | BGFX_SAMPLER_MAG_POINT |
+									 BGFX_SAMPLER_MIP_POINT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP;
+
+std::uint32_t clamp_tile(std::int32_t v, std::uint32_t count)
+{
+	return std::uint32_t(std::min<std::int32_t>(std::max<std::int32_t>(v, 0), std::int32_t(count)));
+}
+
+// uploads the rows of data holding the first texels of a width wide texture
+void update_rows(gfx::texture& tex, const std::vector<float>& data, std::size_t texels,
+				 std::uint32_t components, std::uint32_t width)
+{
+	if(texels == 0)
+		return;
+
+	const auto rows = std::uint32_t((texels + width - 1) / width);
+	const auto size = std::uint32_t(rows * width * components * sizeof(float));
+	gfx::update_texture_2d(tex.native_handle(), 0, 0, 0, 0, std::uint16_t(width), std::uint16_t(rows),
+						   gfx::copy(data.data(), size));
+}
+}
+
+void light_grid::begin(const camera& cam)
+{
+	view_ = cam.get_view();
+	near_clip_ = std::max(cam.get_near_clip(), 0.001f);
+	const float far_clip = std::max(cam.get_far_clip(), near_clip_ * 2.0f);
+	depth_scale_ = float(slices) / std::log(far_clip / near_clip_);
+
+	lights_count_ = 0;
+	lights_.clear();
+	ranges_.clear();
+}
+
+std::uint32_t light_grid::get_slice(float depth) const
+{
+	if(depth <= near_clip_)
+		return 0;
+
+	const auto slice = std::floor(std::log(depth / near_clip_) * depth_scale_);
+	return std::uint32_t(std::min(slice, float(slices - 1)));
+}
+
+bool light_grid::add(const light& l, const math::vec3& position, const math::vec3& direction,
+					 const irect32_t& tiles)
+{
+	if(lights_count_ >= max_lights)
+		return false;
+
+	range r;
+	r.x0 = clamp_tile(tiles.left, tiles_x);
+	r.x1 = clamp_tile(tiles.right, tiles_x);
+	r.y0 = clamp_tile(tiles.top, tiles_y);
+	r.y1 = clamp_tile(tiles.bottom, tiles_y);
+	if(r.x0 >= r.x1 || r.y0 >= r.y1)
+		return true;
+
+	const bool is_spot = l.type == light_type::spot;
+	const float radius = is_spot ? l.spot_data.get_range() : l.point_data.range;
+	const float depth = view_.transform_coord(position).z;
+	if(depth + radius <= 0.0f)
+		return true;
+
+	// the sphere around the light bounds the cone of a spot light as well
+	r.z0 = get_slice(depth - radius);
+	r.z1 = get_slice(depth + radius) + 1;
+	ranges_.push_back(r);
+
+	float data[light_texels * 4] = {position.x,
+									position.y,
+									position.z,
+									radius,
+									l.color.value.r,
+									l.color.value.g,
+									l.color.value.b,
+									l.intensity,
+									direction.x,
+									direction.y,
+									direction.z,
+									is_spot ? 1.0f : 0.0f,
+									0.0f,
+									0.0f,
+									0.0f,
+									0.0f};
+	if(is_spot)
+	{
+		data[12] = math::cos(math::radians(l.spot_data.get_inner_angle() * 0.5f));
+		data[13] = math::cos(math::radians(l.spot_data.get_outer_angle() * 0.5f));
+	}
+	else
+	{
+		data[12] = l.point_data.exponent_falloff;
+	}
+	lights_.insert(lights_.end(), std::begin(data), std::end(data));
+	++lights_count_;
+	return true;
+}
+
+void light_grid::build_clusters()
+{
+	counts_.assign(clusters_count, 0);
+	for(const auto& r : ranges_)
+	{
+		for(auto z = r.z0; z < r.z1; ++z)
+		{
+			for(auto y = r.y0; y < r.y1; ++y)
+			{
+				for(auto x = r.x0; x < r.x1; ++x)
+				{
+					auto& count = counts_[(z * tiles_y + y) * tiles_x + x];
+					count = std::min(count + 1, max_cluster_lights);
+				}
+			}
+		}
+	}
+
+	// the clusters past the index space are left with fewer lights
+	clusters_.assign(std::size_t(clusters_count) * 4, 0.0f);
+	std::uint32_t offset = 0;
+	for(std::uint32_t i = 0; i < clusters_count; ++i)
+	{
+		counts_[i] = std::min(counts_[i], max_indices - offset);
+		clusters_[i * 4 + 0] = float(offset);
+		offset += counts_[i];
+	}
+
+	indices_.resize(std::max<std::size_t>(offset, 1));
+	for(std::uint32_t i = 0; i < std::uint32_t(ranges_.size()); ++i)
+	{
+		const auto& r = ranges_[i];
+		for(auto z = r.z0; z < r.z1; ++z)
+		{
+			for(auto y = r.y0; y < r.y1; ++y)
+			{
+				for(auto x = r.x0; x < r.x1; ++x)
+				{
+					const auto cluster = (z * tiles_y + y) * tiles_x + x;
+					auto& filled = clusters_[cluster * 4 + 1];
+					if(std::uint32_t(filled) >= counts_[cluster])
+						continue;
+
+					indices_[std::size_t(clusters_[cluster * 4 + 0] + filled)] = float(i);
+					filled += 1.0f;
+				}
+			}
+		}
+	}
+	indices_.resize(offset);
+}
+
+bool light_grid::is_supported()
+{
+	return gfx::is_format_supported(BGFX_CAPS_FORMAT_TEXTURE_2D, data_format) &&
+		   gfx::is_format_supported(BGFX_CAPS_FORMAT_TEXTURE_2D, index_format);
+}
+
+void light_grid::upload(gfx::render_view& render_view)
+{
+	build_clusters();
+
+	lights_texture_ = render_view.get_texture("LIGHT_GRID_LIGHTS", std::uint16_t(lights_width),
+											  std::uint16_t(lights_height), false, 1, data_format,
+											  data_flags);
+	clusters_texture_ = render_view.get_texture("LIGHT_GRID_CLUSTERS", std::uint16_t(tiles_x),
+												std::uint16_t(tiles_y * slices), false, 1, data_format,
+												data_flags);
+	indices_texture_ = render_view.get_texture("LIGHT_GRID_INDICES", std::uint16_t(indices_width),
+											   std::uint16_t(indices_height), false, 1, index_format,
+											   data_flags);
+
+	// the lights and the indices only up to the last row in use
+	lights_.resize(((lights_.size() / 4 + lights_width - 1) / lights_width) * lights_width * 4, 0.0f);
+	indices_.resize(((indices_.size() + indices_width - 1) / indices_width) * indices_width, 0.0f);
+	update_rows(*lights_texture_, lights_, lights_.size() / 4, 4, lights_width);
+	update_rows(*clusters_texture_, clusters_, clusters_count, 4, tiles_x);
+	update_rows(*indices_texture_, indices_, indices_.size(), 1, indices_width);
+}
+
+math::vec4 light_grid::get_grid_params() const
+{
+	return math::vec4(float(tiles_x), float(tiles_y), float(slices), 0.0f);
+}
+
+math::vec4 light_grid::get_depth_params() const
+{
+	return math::vec4(near_clip_, depth_scale_, 0.0f, 0.0f);
+}
+
+math::vec4 light_grid::get_texture_sizes() const
+{
+	return math::vec4(float(lights_width), float(lights_height), float(indices_width), float(indices_height));
+}
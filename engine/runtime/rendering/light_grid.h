@@ -0,0 +1,142 @@
+#pragma once
+
+#include <core/common/basetypes.hpp>
+#include <core/math/math_includes.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class camera;
+struct light;
+
+namespace gfx
+{
+struct texture;
+class render_view;
+}
+
+/*
+ * light_grid; the point and spot lights of a view binned into clusters, the
+ * screen tiles of a view split in depth slices, so they can all be shaded
+ * in one full screen pass that loops over the lights of its cluster.
+ *
+ *      The slices are spaced exponentially between the near and the far clip.
+ *      A light goes to every cluster of the screen rectangle and the depth
+ *      range of its bounding sphere. The lights, the clusters and the light
+ *      indices of the clusters go to three float textures of the view, the
+ *      shader reads them with point sampling.
+ */
+class light_grid
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : begin ()
+	/// <summary>
+	/// Starts binning the lights of the view of the camera.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void begin(const camera& cam);
+
+	//-----------------------------------------------------------------------------
+	//  Name : add ()
+	/// <summary>
+	/// Bins a point or spot light. tiles is the screen rectangle of it in
+	/// tiles, e.g. from light_component::compute_projected_sphere_rect with
+	/// a rectangle of tiles_x by tiles_y. Returns false when the grid is full
+	/// and the light is not added.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool add(const light& l, const math::vec3& position, const math::vec3& direction, const irect32_t& tiles);
+
+	//-----------------------------------------------------------------------------
+	//  Name : upload ()
+	/// <summary>
+	/// Builds the clusters and updates the textures of the render view with
+	/// them.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void upload(gfx::render_view& render_view);
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_supported ()
+	/// <summary>
+	/// Returns true when the float textures the grid is kept in can be sampled.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool is_supported();
+
+	std::size_t size() const
+	{
+		return lights_count_;
+	}
+
+	gfx::texture* get_lights_texture() const
+	{
+		return lights_texture_.get();
+	}
+
+	gfx::texture* get_clusters_texture() const
+	{
+		return clusters_texture_.get();
+	}
+
+	gfx::texture* get_indices_texture() const
+	{
+		return indices_texture_.get();
+	}
+
+	/// tiles_x, tiles_y, slices, 0
+	math::vec4 get_grid_params() const;
+	/// near clip and the scale from log(depth / near) to the slice
+	math::vec4 get_depth_params() const;
+	/// width and height of the lights and the indices textures
+	math::vec4 get_texture_sizes() const;
+
+	static constexpr std::uint32_t tiles_x = 16;
+	static constexpr std::uint32_t tiles_y = 8;
+	static constexpr std::uint32_t slices = 24;
+	/// texels of a light in the lights texture
+	static constexpr std::uint32_t light_texels = 4;
+	static constexpr std::uint32_t lights_width = 256;
+	static constexpr std::uint32_t max_lights = 1024;
+	static constexpr std::uint32_t indices_width = 256;
+	static constexpr std::uint32_t max_indices = 256 * 256;
+	/// lights shaded per cluster, the loop bound of the shader
+	static constexpr std::uint32_t max_cluster_lights = 64;
+	/// the fewest point and spot lights of a view worth a grid, below it the
+	/// light volumes drawn one by one are cheaper than the loop
+	static constexpr std::uint32_t min_lights = 32;
+
+private:
+	struct range
+	{
+		std::uint32_t x0 = 0;
+		std::uint32_t x1 = 0;
+		std::uint32_t y0 = 0;
+		std::uint32_t y1 = 0;
+		std::uint32_t z0 = 0;
+		std::uint32_t z1 = 0;
+	};
+
+	std::uint32_t get_slice(float depth) const;
+	void build_clusters();
+
+	math::transform view_;
+	float near_clip_ = 0.1f;
+	float depth_scale_ = 1.0f;
+
+	std::size_t lights_count_ = 0;
+	/// light_texels rgba texels per light
+	std::vector<float> lights_;
+	/// the clusters each light covers, inclusive
+	std::vector<range> ranges_;
+	/// offset and count of every cluster, as rgba texels
+	std::vector<float> clusters_;
+	std::vector<float> indices_;
+	std::vector<std::uint32_t> counts_;
+
+	std::shared_ptr<gfx::texture> lights_texture_;
+	std::shared_ptr<gfx::texture> clusters_texture_;
+	std::shared_ptr<gfx::texture> indices_texture_;
+};
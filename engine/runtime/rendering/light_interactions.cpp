@@ -0,0 +1,45 @@
+#include "light_interactions.h"
+
+void light_interactions::clear()
+{
+	casters_.clear();
+	ranges_.clear();
+	current_ = nullptr;
+}
+
+void light_interactions::begin_light(std::uint64_t light)
+{
+	// a light begun again drops what it had so far
+	current_ = &ranges_[light];
+	current_->first = casters_.size();
+	current_->last = casters_.size();
+}
+
+void light_interactions::add(std::size_t entry, std::uint32_t views, bool is_static)
+{
+	if(current_ == nullptr)
+	{
+		return;
+	}
+
+	caster c;
+	c.entry = entry;
+	c.views = views;
+	c.is_static = is_static;
+	casters_.push_back(c);
+	current_->last = casters_.size();
+}
+
+light_interactions::casters light_interactions::get_casters(std::uint64_t light) const
+{
+	casters result;
+	auto it = ranges_.find(light);
+	if(it == ranges_.end() || it->second.first == it->second.last)
+	{
+		return result;
+	}
+
+	result.first = casters_.data() + it->second.first;
+	result.last = casters_.data() + it->second.last;
+	return result;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * light_interactions; the shadow casters of every light in a frame, the
+ * models whose bounds are in its range, its cone or its cascades and the
+ * views of the light they are in.
+ *
+ *      Built once a frame for the lights seen by a camera, the lights out
+ *      of every view have none. The casters of a light are what its shadow
+ *      views are invalidated and drawn with.
+ */
+class light_interactions
+{
+public:
+	struct caster
+	{
+		/// the entry of the model in the bounds_system
+		std::size_t entry = 0;
+		/// bit v for the shadow view v of the light
+		std::uint32_t views = 0;
+		bool is_static = false;
+	};
+
+	struct casters
+	{
+		const caster* first = nullptr;
+		const caster* last = nullptr;
+
+		const caster* begin() const
+		{
+			return first;
+		}
+
+		const caster* end() const
+		{
+			return last;
+		}
+
+		bool empty() const
+		{
+			return first == last;
+		}
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : clear ()
+	/// <summary>
+	/// Forgets the lights of the last frame, keeping the memory.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void clear();
+
+	//-----------------------------------------------------------------------------
+	//  Name : begin_light ()
+	/// <summary>
+	/// Starts the casters of a light, those added until the next light is
+	/// begun are its own.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void begin_light(std::uint64_t light);
+
+	void add(std::size_t entry, std::uint32_t views, bool is_static);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_casters ()
+	/// <summary>
+	/// The casters of a light in this frame, none if it was not begun. Valid
+	/// until a caster is added or the interactions are cleared.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	casters get_casters(std::uint64_t light) const;
+
+	bool has_light(std::uint64_t light) const
+	{
+		return ranges_.find(light) != ranges_.end();
+	}
+
+	std::size_t get_lights_count() const
+	{
+		return ranges_.size();
+	}
+
+	std::size_t get_casters_count() const
+	{
+		return casters_.size();
+	}
+
+private:
+	struct range
+	{
+		std::size_t first = 0;
+		std::size_t last = 0;
+	};
+
+	/// the casters of all the lights, those of a light one after another
+	std::vector<caster> casters_;
+	std::unordered_map<std::uint64_t, range> ranges_;
+	/// the range casters are added to
+	range* current_ = nullptr;
+};
@@ -1,5 +1,8 @@
 #include "material.h"
 #include "gpu_program.h"
+#include "program_cache.h"
+#include "texture_arrays.h"
+#include "virtual_texturing.h"
 
 #include "../assets/asset_manager.h"
 
@@ -7,6 +10,21 @@
 #include <core/graphics/uniform.h>
 #include <core/system/subsystem.h>
 
+namespace
+{
+// uniforms of fs_deferred_geom, hashed once instead of per draw
+constexpr gpu_program::uniform_id u_material("u_material");
+constexpr gpu_program::uniform_id s_tex_color("s_tex_color");
+constexpr gpu_program::uniform_id s_tex_normal("s_tex_normal");
+constexpr gpu_program::uniform_id s_tex_roughness("s_tex_roughness");
+constexpr gpu_program::uniform_id s_tex_metalness("s_tex_metalness");
+constexpr gpu_program::uniform_id s_tex_ao("s_tex_ao");
+constexpr gpu_program::uniform_id s_vt_cache("s_vt_cache");
+constexpr gpu_program::uniform_id s_vt_color_table("s_vt_color_table");
+constexpr gpu_program::uniform_id u_vt_color("u_vt_color");
+constexpr gpu_program::uniform_id u_texture_layers("u_texture_layers");
+}
+
 material::material()
 {
 	auto& am = core::get_subsystem<runtime::asset_manager>();
@@ -39,9 +57,30 @@ void material::set_uniform(const std::string& _name, const void* _value, std::ui
 	get_program()->set_uniform(_name, _value, _num);
 }
 
+namespace
+{
+gpu_program* get_ready(const std::shared_ptr<cached_program>& program)
+{
+	return program ? program->get() : nullptr;
+}
+}
+
 gpu_program* material::get_program() const
 {
-	return skinned ? program_skinned_.get() : program_.get();
+	return get_ready(skinned ? program_skinned_ : program_);
+}
+
+void material::submit()
+{
+	if(auto program = get_program())
+	{
+		submit(*program);
+	}
+}
+
+gpu_program* material::get_instanced_program() const
+{
+	return skinned ? nullptr : get_ready(program_instanced_);
 }
 
 std::uint64_t material::get_render_states(bool apply_cull, bool depth_write, bool depth_test) const
@@ -69,67 +108,239 @@ std::uint64_t material::get_render_states(bool apply_cull, bool depth_write, boo
 
 standard_material::standard_material()
 {
-	auto& ts = core::get_subsystem<core::task_system>();
-	auto& am = core::get_subsystem<runtime::asset_manager>();
-	auto vs_deferred_geom = am.load<gfx::shader>("engine:/data/shaders/vs_deferred_geom.sc");
-	vs_deferred_geom.wait();
-	auto vs_deferred_geom_skinned = am.load<gfx::shader>("engine:/data/shaders/vs_deferred_geom_skinned.sc");
-	vs_deferred_geom_skinned.wait();
-	auto fs_deferred_geom = am.load<gfx::shader>("engine:/data/shaders/fs_deferred_geom.sc");
-	fs_deferred_geom.wait();
-	auto f = ts.push_or_execute_on_owner_thread(
-		[this](asset_handle<gfx::shader> vs, asset_handle<gfx::shader> fs) {
-			program_ = std::make_unique<gpu_program>(vs, fs);
+	update_programs();
+}
+
+void standard_material::update_programs()
+{
+	// every standard material draws with the same programs, those with a
+	// virtual color map with those of its variant
+	auto& cache = core::get_subsystem<program_cache>();
+	const std::string vs_deferred_geom = "engine:/data/shaders/vs_deferred_geom.sc";
+	const std::string vs_deferred_geom_instanced = "engine:/data/shaders/vs_deferred_geom_instanced.sc";
+	const std::string vs_deferred_geom_skinned = "engine:/data/shaders/vs_deferred_geom_skinned.sc";
+	const std::string fs_deferred_geom = "engine:/data/shaders/fs_deferred_geom.sc";
+	const std::string variant = virtual_color_map_ ? "VIRTUAL_COLOR" : color_array_ ? "TEXTURE_ARRAYS" : "";
+	program_ = cache.get(vs_deferred_geom, fs_deferred_geom, variant);
+	program_skinned_ = cache.get(vs_deferred_geom_skinned, fs_deferred_geom, variant);
+	program_instanced_ = cache.get(vs_deferred_geom_instanced, fs_deferred_geom, variant);
+
+	program_feedback_ = nullptr;
+	program_feedback_instanced_ = nullptr;
+	if(virtual_color_map_)
+	{
+		const std::string fs_vt_feedback = "engine:/data/shaders/fs_vt_feedback.sc";
+		program_feedback_ = cache.get(vs_deferred_geom, fs_vt_feedback);
+		program_feedback_instanced_ = cache.get(vs_deferred_geom_instanced, fs_vt_feedback);
+	}
+}
+
+void standard_material::set_virtual_color_map(asset_handle<virtual_texture> val)
+{
+	const bool had_map = bool(virtual_color_map_);
+	virtual_color_map_ = val;
+	if(had_map != bool(virtual_color_map_))
+	{
+		// looked up again, a virtual color map samples no arrays
+		arrays_version_ = 0;
+		color_array_ = {};
+		normal_array_ = {};
+		update_programs();
+	}
+}
+
+void standard_material::update_texture_arrays()
+{
+	const auto get_link = [this](const std::string& name) -> const void* {
+		auto it = maps_.find(name);
+		return it != maps_.end() && it->second ? it->second.link.get() : nullptr;
+	};
+
+	const auto color = get_link("color");
+	const auto normal = get_link("normal");
+	const auto version = core::has_subsystems<texture_arrays>()
+							 ? core::get_subsystem<texture_arrays>().get_version()
+							 : std::uint64_t(0);
+	if(version == arrays_version_ && color == arrays_color_map_ && normal == arrays_normal_map_)
+	{
+		return;
+	}
+	arrays_version_ = version;
+	arrays_color_map_ = color;
+	arrays_normal_map_ = normal;
+
+	const bool had_arrays = bool(color_array_);
+	color_array_ = {};
+	normal_array_ = {};
+	texture_layers_ = math::vec4(0.0f);
+
+	texture_arrays::layer color_layer;
+	texture_arrays::layer normal_layer;
+	if(version != 0 && color && normal && !virtual_color_map_)
+	{
+		const auto& arrays = core::get_subsystem<texture_arrays>();
+		if(arrays.find(maps_.at("color").id(), color_layer) &&
+		   arrays.find(maps_.at("normal").id(), normal_layer))
+		{
+			color_array_ = color_layer.array;
+			normal_array_ = normal_layer.array;
+			texture_layers_ = math::vec4(float(color_layer.index), float(normal_layer.index), 0.0f, 0.0f);
+		}
+	}
+
+	if(had_arrays != bool(color_array_))
+	{
+		update_programs();
+	}
+}
+
+const void* standard_material::get_batch_key() const
+{
+	return color_array_ ? static_cast<const void*>(color_array_.get()) : this;
+}
+
+bool standard_material::batches_with(const material& other) const
+{
+	if(&other == this)
+	{
+		return true;
+	}
+
+	const auto* rhs = dynamic_cast<const standard_material*>(&other);
+	if(!rhs || !color_array_ || rhs->color_array_ != color_array_ || rhs->normal_array_ != normal_array_ ||
+	   rhs->get_cull_type() != get_cull_type())
+	{
+		return false;
+	}
+
+	// the maps that are not in the arrays are bound once for all of them
+	for(const auto* name : {"roughness", "metalness", "ao"})
+	{
+		auto lhs_it = maps_.find(name);
+		auto rhs_it = rhs->maps_.find(name);
+		const auto* lhs_map = lhs_it != maps_.end() ? lhs_it->second.get() : nullptr;
+		const auto* rhs_map = rhs_it != rhs->maps_.end() ? rhs_it->second.get() : nullptr;
+		if(lhs_map != rhs_map)
+		{
+			return false;
+		}
+	}
+
+	return rhs->base_color_.value == base_color_.value &&
+		   rhs->subsurface_color_.value == subsurface_color_.value &&
+		   rhs->emissive_color_.value == emissive_color_.value && rhs->surface_data_ == surface_data_ &&
+		   rhs->tiling_ == tiling_ && rhs->dither_threshold_ == dither_threshold_;
+}
+
+gpu_program* standard_material::get_feedback_program(bool instanced) const
+{
+	return get_ready(instanced ? program_feedback_instanced_ : program_feedback_);
+}
+
+void standard_material::submit(gpu_program& program)
+{
+	// one upload for the block, laid out as u_material of fs_deferred_geom
+	const math::vec4 block[] = {base_color_.value, subsurface_color_.value, emissive_color_.value,
+								surface_data_, math::vec4(tiling_, dither_threshold_)};
+	program.set_uniform(u_material, block, std::uint16_t(sizeof(block) / sizeof(block[0])));
 
-		},
-		vs_deferred_geom, fs_deferred_geom);
+	// looked up without inserting, the material may be submitted from several threads
+	const auto get_map = [this](const std::string& name, const asset_handle<gfx::texture>& fallback) {
+		auto it = maps_.find(name);
+		return it != maps_.end() && it->second ? it->second : fallback;
+	};
 
-	auto f1 = ts.push_or_execute_on_owner_thread(
-		[this](asset_handle<gfx::shader> vs, asset_handle<gfx::shader> fs) {
-			program_skinned_ = std::make_unique<gpu_program>(vs, fs);
+	auto albedo = get_map("color", default_color_map_);
+	auto normal = get_map("normal", default_normal_map_);
+	auto roughness = get_map("roughness", default_color_map_);
+	auto metalness = get_map("metalness", default_color_map_);
+	auto ao = get_map("ao", default_color_map_);
 
-		},
-		vs_deferred_geom_skinned, fs_deferred_geom);
+	// the layers of an instanced copy come with its instance data
+	if(color_array_)
+	{
+		program.set_texture(0, s_tex_color, color_array_.get());
+		program.set_texture(1, s_tex_normal, normal_array_.get());
+		program.set_uniform(u_texture_layers, texture_layers_);
+	}
+	else
+	{
+		program.set_texture(0, s_tex_color, albedo.get());
+		program.set_texture(1, s_tex_normal, normal.get());
+	}
+	program.set_texture(2, s_tex_roughness, roughness.get());
+	program.set_texture(3, s_tex_metalness, metalness.get());
+	program.set_texture(4, s_tex_ao, ao.get());
 
-	futures_.emplace_back(std::move(f));
-	futures_.emplace_back(std::move(f1));
+	// the feedback program reads the params alone
+	if(virtual_color_map_)
+	{
+		const auto& vt = core::get_subsystem<virtual_texturing>();
+		math::vec4 params[2];
+		virtual_color_map_->get_params(params);
+		program.set_uniform(u_vt_color, params, 2);
+		program.set_texture(5, s_vt_cache, vt.get_cache());
+		program.set_texture(6, s_vt_color_table, virtual_color_map_->get_page_table());
+	}
 }
 
-standard_material::~standard_material()
+void standard_material::visit_textures(const std::function<void(const gfx::texture&)>& visitor) const
 {
-	for(auto& f : futures_)
+	for(const auto& pair : maps_)
 	{
-		f.wait();
+		if(pair.second)
+		{
+			visitor(*pair.second.get());
+		}
 	}
 }
 
-void standard_material::submit()
+void standard_material::visit_asset_keys(const std::function<void(const std::string&)>& visitor) const
 {
-	if(!is_valid())
-		return;
+	for(const auto& pair : maps_)
+	{
+		if(pair.second)
+		{
+			visitor(pair.second.id());
+		}
+	}
+	if(virtual_color_map_)
+	{
+		visitor(virtual_color_map_.id());
+	}
+}
+
+bool standard_material::is_opaque() const
+{
+	// the pages of a virtual color map are bgra8
+	if(base_color_.value.w < 1.0f || virtual_color_map_)
+	{
+		return false;
+	}
 
-	get_program()->set_uniform("u_base_color", &base_color_);
-	get_program()->set_uniform("u_subsurface_color", &subsurface_color_);
-	get_program()->set_uniform("u_emissive_color", &emissive_color_);
-	get_program()->set_uniform("u_surface_data", &surface_data_);
-	get_program()->set_uniform("u_tiling", &tiling_);
-	get_program()->set_uniform("u_dither_threshold", &dither_threshold_);
-
-	const auto& color_map = maps_["color"];
-	const auto& normal_map = maps_["normal"];
-	const auto& roughness_map = maps_["roughness"];
-	const auto& metalness_map = maps_["metalness"];
-	const auto& ao_map = maps_["ao"];
-
-	auto albedo = color_map ? color_map : default_color_map_;
-	auto normal = normal_map ? normal_map : default_normal_map_;
-	auto roughness = roughness_map ? roughness_map : default_color_map_;
-	auto metalness = metalness_map ? metalness_map : default_color_map_;
-	auto ao = ao_map ? ao_map : default_color_map_;
-
-	get_program()->set_texture(0, "s_tex_color", albedo.get());
-	get_program()->set_texture(1, "s_tex_normal", normal.get());
-	get_program()->set_texture(2, "s_tex_roughness", roughness.get());
-	get_program()->set_texture(3, "s_tex_metalness", metalness.get());
-	get_program()->set_texture(4, "s_tex_ao", ao.get());
+	// the default color map is opaque white
+	auto it = maps_.find("color");
+	if(it == maps_.end() || !it->second)
+	{
+		return true;
+	}
+
+	// the formats without alpha, bc1 as the encoder writes it for opaque maps
+	switch(it->second->info.format)
+	{
+		case gfx::texture_format::BC1:
+		case gfx::texture_format::BC4:
+		case gfx::texture_format::BC5:
+		case gfx::texture_format::BC6H:
+		case gfx::texture_format::ETC1:
+		case gfx::texture_format::ETC2:
+		case gfx::texture_format::R8:
+		case gfx::texture_format::RG8:
+		case gfx::texture_format::RGB8:
+		case gfx::texture_format::R5G6B5:
+		case gfx::texture_format::RG11B10F:
+			return true;
+		default:
+			return false;
+	}
 }
@@ -8,9 +8,12 @@
 #include <core/serialization/serialization.h>
 #include <core/tasks/task_system.h>
 
+#include <functional>
 #include <unordered_map>
 
 class gpu_program;
+class cached_program;
+class virtual_texture;
 namespace gfx
 {
 struct texture;
@@ -106,16 +109,127 @@ public:
 	//-----------------------------------------------------------------------------
 	gpu_program* get_program() const;
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_instanced_program ()
+	/// <summary>
+	/// Program drawing many copies in one submit with their world matrices in
+	/// the instance data, nullptr if the material has none or is skinned.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	gpu_program* get_instanced_program() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_feedback_program (virtual )
+	/// <summary>
+	/// Program drawing the pages of the virtual textures the material samples
+	/// to the feedback of virtual_texturing, nullptr if it samples none.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual gpu_program* get_feedback_program(bool /*instanced*/) const
+	{
+		return nullptr;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : submit ()
+	/// <summary>
+	/// Sets the uniforms and textures of the material on its program.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void submit();
+
 	//-----------------------------------------------------------------------------
 	//  Name : submit (virtual )
 	/// <summary>
-	///
-	///
-	///
+	/// Sets the uniforms and textures of the material on a program made from
+	/// its shaders. Only reads the material, so several threads may submit
+	/// it at once.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void submit(gpu_program& /*program*/)
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : visit_textures (virtual )
+	/// <summary>
+	/// Calls the function with every texture the material samples, not the
+	/// defaults it falls back to.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void visit_textures(const std::function<void(const gfx::texture&)>& /*visitor*/) const
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : visit_asset_keys (virtual )
+	/// <summary>
+	/// Calls the function with the key of every asset the material is made
+	/// of, for its reloads to reload the material.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void visit_asset_keys(const std::function<void(const std::string&)>& /*visitor*/) const
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_opaque (virtual )
+	/// <summary>
+	/// True when the material discards no fragments but those of the fade
+	/// near the camera, so that its depth can be drawn from the positions
+	/// alone ahead of the g-buffer.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual bool is_opaque() const
+	{
+		return false;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : update_texture_arrays (virtual )
+	/// <summary>
+	/// Looks the maps up in the texture arrays again when they or the arrays
+	/// changed. From the owner thread, before the material is drawn.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void update_texture_arrays()
+	{
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_batch_key (virtual )
+	/// <summary>
+	/// The same for the materials that may draw in one instanced submit, which
+	/// are sorted next to each other. Only the material itself by default.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual const void* get_batch_key() const
+	{
+		return this;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : batches_with (virtual )
+	/// <summary>
+	/// True when the copies drawn with the other material can be instanced
+	/// with those drawn with this one, bound once for all of them.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	virtual void submit()
+	virtual bool batches_with(const material& other) const
 	{
+		return &other == this;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_texture_layers (virtual )
+	/// <summary>
+	/// The layers of the texture arrays the material samples, that go to the
+	/// instance data of every copy. nullptr if it samples no arrays.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual const math::vec4* get_texture_layers() const
+	{
+		return nullptr;
 	}
 
 	//-----------------------------------------------------------------------------
@@ -158,18 +272,18 @@ public:
 	bool skinned = false;
 
 protected:
-	/// Program that is responsible for rendering.
-	std::unique_ptr<gpu_program> program_;
-	/// Program that is responsible for rendering.
-	std::unique_ptr<gpu_program> program_skinned_;
+	/// Program that is responsible for rendering, from the program cache.
+	std::shared_ptr<cached_program> program_;
+	/// Program that is responsible for rendering skinned meshes.
+	std::shared_ptr<cached_program> program_skinned_;
+	/// Program that is responsible for rendering instances.
+	std::shared_ptr<cached_program> program_instanced_;
 	/// Cull type for this material.
 	cull_type cull_type_ = cull_type::counter_clockwise;
 	/// Default color texture
 	asset_handle<gfx::texture> default_color_map_;
 	/// Default normal texture
 	asset_handle<gfx::texture> default_normal_map_;
-
-	std::vector<core::task_future<void>> futures_;
 };
 
 class standard_material : public material
@@ -187,7 +301,6 @@ public:
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	standard_material();
-	~standard_material();
 	//-----------------------------------------------------------------------------
 	//  Name : get_base_color ()
 	/// <summary>
@@ -552,6 +665,30 @@ public:
 		maps_["ao"] = val;
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_virtual_color_map ()
+	/// <summary>
+	/// The virtual texture sampled in place of the color map, if any.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline const asset_handle<virtual_texture>& get_virtual_color_map() const
+	{
+		return virtual_color_map_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_virtual_color_map ()
+	/// <summary>
+	/// Samples the virtual texture in place of the color map, the programs
+	/// switch to the variant that does.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_virtual_color_map(asset_handle<virtual_texture> val);
+
+	gpu_program* get_feedback_program(bool instanced) const override;
+
+	using material::submit;
+
 	//-----------------------------------------------------------------------------
 	//  Name : submit (virtual )
 	/// <summary>
@@ -560,9 +697,48 @@ public:
 	///
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	virtual void submit();
+	virtual void submit(gpu_program& program);
+
+	void visit_textures(const std::function<void(const gfx::texture&)>& visitor) const override;
+
+	void visit_asset_keys(const std::function<void(const std::string&)>& visitor) const override;
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_opaque ()
+	/// <summary>
+	/// True for an opaque base color and a color map without alpha.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool is_opaque() const override;
+
+	//-----------------------------------------------------------------------------
+	//  Name : update_texture_arrays ()
+	/// <summary>
+	/// Samples the color and normal maps from the texture arrays when both
+	/// are in one, and the programs switch to the variant that does.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void update_texture_arrays() override;
+
+	const void* get_batch_key() const override;
+
+	//-----------------------------------------------------------------------------
+	//  Name : batches_with ()
+	/// <summary>
+	/// True for a material sampling the same arrays and other maps, with the
+	/// same values, the layers alone may differ.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool batches_with(const material& other) const override;
+
+	const math::vec4* get_texture_layers() const override
+	{
+		return color_array_ ? &texture_layers_ : nullptr;
+	}
 
 private:
+	void update_programs();
+
 	/// Base color
 	math::color base_color_{
 		1.0f, 1.0f, 1.0f, /// Color
@@ -597,4 +773,18 @@ private:
 
 	/// Texture maps
 	std::unordered_map<std::string, asset_handle<gfx::texture>> maps_;
+	/// Virtual color map
+	asset_handle<virtual_texture> virtual_color_map_;
+	/// Programs of the virtual texture feedback
+	std::shared_ptr<cached_program> program_feedback_;
+	std::shared_ptr<cached_program> program_feedback_instanced_;
+	/// The arrays the color and normal maps are sampled from, empty when they
+	/// are sampled themselves, and their layers in .x and .y
+	asset_handle<gfx::texture> color_array_;
+	asset_handle<gfx::texture> normal_array_;
+	math::vec4 texture_layers_{0.0f};
+	/// What the arrays were looked up for
+	std::uint64_t arrays_version_ = 0;
+	const void* arrays_color_map_ = nullptr;
+	const void* arrays_normal_map_ = nullptr;
 };
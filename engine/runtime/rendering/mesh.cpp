@@ -1,15 +1,22 @@
 #include "mesh.h"
 #include "camera.h"
+#include "mesh_arena.h"
 #include "generator/generator.hpp"
 
+#include <core/common/hash.hpp>
 #include <core/graphics/index_buffer.h>
 #include <core/graphics/vertex_buffer.h>
 #include <core/logging/logging.h>
 #include <core/memory/checked_delete.h>
+#include <core/system/subsystem.h>
+#include <core/tasks/task_group.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstring>
+#include <limits>
+#include <unordered_map>
 //-----------------------------------------------------------------------------
 // Local Module Level Namespaces.
 //-----------------------------------------------------------------------------
@@ -23,6 +30,288 @@ const float ValenceBoostPower = 0.5f;
 const std::int32_t MaxVertexCacheSize = 32;
 };
 
+namespace
+{
+// the faces or vertices a worker prepares at once
+constexpr std::uint32_t prepare_grain = 4096;
+
+//-----------------------------------------------------------------------------
+//  Name : for_each_range ()
+/// <summary>
+/// Calls fn(begin, end) for ranges covering [0, count), on the workers when
+/// there is a task system and enough work to share.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename F>
+void for_each_range(std::uint32_t count, F&& fn)
+{
+	if(count <= prepare_grain || !core::has_subsystems<core::task_system>())
+	{
+		fn(std::uint32_t(0), count);
+		return;
+	}
+
+	const auto chunks = (count + prepare_grain - 1) / prepare_grain;
+	auto& ts = core::get_subsystem<core::task_system>();
+	core::parallel_for(ts, std::uint32_t(0), chunks, std::uint32_t(1), [&](std::uint32_t chunk) {
+		const auto begin = chunk * prepare_grain;
+		fn(begin, std::min(count, begin + prepare_grain));
+	});
+}
+
+std::atomic<std::uint8_t>& get_default_residency_value()
+{
+	static std::atomic<std::uint8_t> residency{std::uint8_t(mesh_residency::release)};
+	return residency;
+}
+
+math::vec3 get_position(const gfx::vertex_layout& format, const std::uint8_t* vertices, std::uint32_t index)
+{
+	float position[4] = {};
+	gfx::vertex_unpack(position, gfx::attribute::Position, format, vertices, index);
+	return math::vec3(position[0], position[1], position[2]);
+}
+
+const gfx::vertex_layout& get_position_format()
+{
+	static const gfx::vertex_layout format = []() {
+		gfx::vertex_layout result;
+		result.begin().add(gfx::attribute::Position, 3, gfx::attribute_type::Float).end();
+		return result;
+	}();
+	return format;
+}
+
+// the positions of the vertices as their own stream, null when they are all
+// the vertices hold
+std::shared_ptr<gfx::vertex_buffer> create_position_buffer(const gfx::vertex_layout& format,
+															const std::uint8_t* vertices,
+															std::uint32_t vertex_count)
+{
+	const auto& position_format = get_position_format();
+	if(vertex_count == 0 || format.getStride() <= position_format.getStride())
+	{
+		return nullptr;
+	}
+
+	const auto* mem = gfx::alloc(vertex_count * position_format.getStride());
+	auto* positions = reinterpret_cast<float*>(mem->data);
+	for(std::uint32_t i = 0; i < vertex_count; ++i)
+	{
+		const auto position = get_position(format, vertices, i);
+		positions[i * 3 + 0] = position.x;
+		positions[i * 3 + 1] = position.y;
+		positions[i * 3 + 2] = position.z;
+	}
+	return std::make_shared<gfx::vertex_buffer>(mem, position_format);
+}
+
+// the indices as 16 bit ones when every vertex fits, else as they are
+std::shared_ptr<gfx::index_buffer> create_index_buffer(const std::uint32_t* indices,
+													   std::uint32_t index_count, std::uint32_t vertex_count)
+{
+	if(vertex_count > std::numeric_limits<std::uint16_t>::max())
+	{
+		const auto* mem = gfx::copy(indices, index_count * std::uint32_t(sizeof(std::uint32_t)));
+		return std::make_shared<gfx::index_buffer>(mem, BGFX_BUFFER_INDEX32);
+	}
+
+	const auto* mem = gfx::alloc(index_count * std::uint32_t(sizeof(std::uint16_t)));
+	auto* narrow = reinterpret_cast<std::uint16_t*>(mem->data);
+	std::transform(indices, indices + index_count, narrow, [](std::uint32_t i) { return std::uint16_t(i); });
+	return std::make_shared<gfx::index_buffer>(mem);
+}
+
+/// the bits of a position, the same for the same positions
+struct position_key
+{
+	std::uint32_t bits[3] = {};
+
+	bool operator==(const position_key& other) const
+	{
+		return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+	}
+};
+
+struct position_key_hash
+{
+	std::size_t operator()(const position_key& key) const
+	{
+		std::size_t seed = 0;
+		utils::hash_combine(seed, key.bits[0]);
+		utils::hash_combine(seed, key.bits[1]);
+		utils::hash_combine(seed, key.bits[2]);
+		return seed;
+	}
+};
+
+position_key make_position_key(const math::vec3& position)
+{
+	position_key key;
+	for(int i = 0; i < 3; ++i)
+	{
+		// 0 and -0 are the same position
+		const float value = position[i] == 0.0f ? 0.0f : position[i];
+		std::memcpy(&key.bits[i], &value, sizeof(float));
+	}
+	return key;
+}
+
+/// a cell of the grid vertices are welded in
+struct weld_cell
+{
+	std::int64_t x = 0;
+	std::int64_t y = 0;
+	std::int64_t z = 0;
+
+	bool operator==(const weld_cell& other) const
+	{
+		return x == other.x && y == other.y && z == other.z;
+	}
+};
+
+struct weld_cell_hash
+{
+	std::size_t operator()(const weld_cell& cell) const
+	{
+		std::size_t seed = 0;
+		utils::hash_combine(seed, cell.x);
+		utils::hash_combine(seed, cell.y);
+		utils::hash_combine(seed, cell.z);
+		return seed;
+	}
+};
+
+/// the sum of the squared distances to planes, a x + b y + c z + d = 0, as
+/// the symmetric matrix of their outer products
+struct quadric
+{
+	double a2 = 0.0, b2 = 0.0, c2 = 0.0, d2 = 0.0;
+	double ab = 0.0, ac = 0.0, ad = 0.0, bc = 0.0, bd = 0.0, cd = 0.0;
+
+	void add_plane(const math::vec3& normal, double d, double weight)
+	{
+		const double a = normal.x, b = normal.y, c = normal.z;
+		a2 += weight * a * a;
+		b2 += weight * b * b;
+		c2 += weight * c * c;
+		d2 += weight * d * d;
+		ab += weight * a * b;
+		ac += weight * a * c;
+		ad += weight * a * d;
+		bc += weight * b * c;
+		bd += weight * b * d;
+		cd += weight * c * d;
+	}
+
+	quadric& operator+=(const quadric& other)
+	{
+		a2 += other.a2;
+		b2 += other.b2;
+		c2 += other.c2;
+		d2 += other.d2;
+		ab += other.ab;
+		ac += other.ac;
+		ad += other.ad;
+		bc += other.bc;
+		bd += other.bd;
+		cd += other.cd;
+		return *this;
+	}
+
+	double error(const math::vec3& p) const
+	{
+		const double x = p.x, y = p.y, z = p.z;
+		const double result = a2 * x * x + b2 * y * y + c2 * z * z + d2 +
+							  2.0 * (ab * x * y + ac * x * z + ad * x + bc * y * z + bd * y + cd * z);
+		return std::max(result, 0.0);
+	}
+};
+
+/// an attribute of a layout decoded once, stored floats are copied as they
+/// are instead of packed
+struct packed_attribute
+{
+	packed_attribute(const gfx::vertex_layout& format, gfx::attribute attr, bool normalized)
+		: attribute(attr)
+		, input_normalized(normalized)
+		, used(format.has(attr))
+	{
+		if(!used)
+			return;
+
+		std::uint8_t num = 0;
+		gfx::attribute_type type = gfx::attribute_type::Float;
+		bool as_int = false;
+		bool normalized_storage = false;
+		format.decode(attr, num, type, normalized_storage, as_int);
+		offset = format.getOffset(attr);
+		components = num;
+		as_float = type == gfx::attribute_type::Float;
+	}
+
+	void pack(const float* values, std::uint8_t count, const gfx::vertex_layout& format,
+			  std::uint8_t* vertices_ptr, std::uint32_t index) const
+	{
+		if(!used)
+			return;
+
+		if(as_float)
+		{
+			float* dst_ptr = reinterpret_cast<float*>(vertices_ptr + index * format.getStride() + offset);
+			const std::uint8_t copied = std::min(count, components);
+			std::memcpy(dst_ptr, values, copied * sizeof(float));
+			for(std::uint8_t i = copied; i < components; ++i)
+				dst_ptr[i] = 0.0f;
+			return;
+		}
+
+		float input[4] = {};
+		std::memcpy(input, values, std::min<std::uint8_t>(count, 4) * sizeof(float));
+		gfx::vertex_pack(input, input_normalized, attribute, format, vertices_ptr, index);
+	}
+
+	gfx::attribute attribute;
+	bool input_normalized = false;
+	bool used = false;
+	bool as_float = false;
+	std::uint8_t components = 0;
+	std::uint16_t offset = 0;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : vertices_match ()
+/// <summary>
+/// Every component of every attribute of the two vertices is within the
+/// tolerance.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool vertices_match(const gfx::vertex_layout& format, const std::uint8_t* vertex1,
+					const std::uint8_t* vertex2, float tolerance)
+{
+	if(std::memcmp(vertex1, vertex2, format.getStride()) == 0)
+		return true;
+
+	for(int i = 0; i < gfx::attribute::Count; ++i)
+	{
+		const auto attribute = gfx::attribute(i);
+		if(!format.has(attribute))
+			continue;
+
+		float value1[4] = {};
+		float value2[4] = {};
+		gfx::vertex_unpack(value1, attribute, format, vertex1);
+		gfx::vertex_unpack(value2, attribute, format, vertex2);
+		for(int j = 0; j < 4; ++j)
+		{
+			if(math::abs(value1[j] - value2[j]) > tolerance)
+				return false;
+		}
+	}
+	return true;
+}
+}
+
 mesh::mesh()
 	: hardware_vb_(std::make_shared<gfx::vertex_buffer>())
 	, hardware_ib_(std::make_shared<gfx::index_buffer>())
@@ -62,16 +351,24 @@ void mesh::dispose()
 	preparation_data_.vertex_flags.clear();
 	preparation_data_.vertex_records.clear();
 	preparation_data_.triangle_data.clear();
+	preparation_data_.clusters.clear();
 
 	// Release mesh data memory
 	checked_array_delete(system_vb_);
 	checked_array_delete(system_ib_);
 
 	triangle_data_.clear();
+	clusters_.clear();
 
 	// Release resources
 	hardware_vb_.reset();
 	hardware_ib_.reset();
+	hardware_position_vb_.reset();
+	arena_allocation_.reset();
+	triangle_bvh_.reset();
+	skinning_buffers_.reset();
+	residency_ = mesh_residency::keep;
+	system_source_ = nullptr;
 
 	// Clear variables
 	preparation_data_.vertex_source = nullptr;
@@ -139,12 +436,15 @@ bool mesh::bind_skin(const skin_bind_data& bind_data)
 			std::uint32_t vertex = tri_data[i].indices[j];
 
 			const auto& data = vertex_table[vertex];
-			// Add each influencing bone if unique.
-			for(const auto& influence : data.influences)
+			// Add each influencing bone if unique, the few of a face are kept
+			// sorted in place.
+			for(std::uint32_t k = 0; k < data.influence_count; ++k)
 			{
-				used_bones.bones[static_cast<std::uint32_t>(influence)] =
-					1; // Just set to any value, we're only using a key/value dictionary
-					   // for acceleration
+				const auto bone = static_cast<std::uint32_t>(data.influences[k]);
+				auto& bones = used_bones.bones;
+				auto it = std::lower_bound(std::begin(bones), std::end(bones), bone);
+				if(it == std::end(bones) || *it != bone)
+					bones.insert(it, bone);
 			}
 
 		} // Next Vertex
@@ -325,7 +625,7 @@ bool mesh::bind_skin(const skin_bind_data& bind_data)
 			{
 				auto& data = vertex_table[tri_data[face_index].indices[k]];
 
-				const auto blend_idx = static_cast<int>(data.influences.size() - 1);
+				const auto blend_idx = static_cast<int>(data.influence_count) - 1;
 				// Record the largest blend index necessary for processing this palette.
 				if(blend_idx > palette.get_maximum_blend_index())
 					palette.set_maximum_blend_index(std::min<int>(3, blend_idx));
@@ -445,7 +745,7 @@ bool mesh::bind_skin(const skin_bind_data& bind_data)
 		math::vec4 blend_indices(0.0f, 0.0f, 0.0f, 0.0f);
 
 		// std::uint32_t blend_indices = 0;
-		std::uint32_t max_bones = std::min<std::uint32_t>(4, std::uint32_t(data.influences.size()));
+		std::uint32_t max_bones = std::min<std::uint32_t>(4, data.influence_count);
 		for(std::uint32_t j = 0; j < max_bones; ++j)
 		{
 			// Store vertex indices and weights
@@ -472,9 +772,38 @@ bool mesh::bind_skin(const skin_bind_data& bind_data)
 	return true;
 }
 
+// the nodes depth first, every node after its parent
+static void add_skeleton_nodes(const mesh::armature_node& node, std::uint32_t parent,
+							   runtime::skeleton& result)
+{
+	const auto index = static_cast<std::uint32_t>(result.parents.size());
+	result.names.emplace_back(node.name);
+	result.parents.emplace_back(parent);
+	result.rest_pose.emplace_back(node.local_transform);
+	for(const auto& child : node.children)
+	{
+		if(child)
+		{
+			add_skeleton_nodes(*child, index, result);
+		}
+	}
+}
+
 bool mesh::bind_armature(std::unique_ptr<armature_node>& root)
 {
 	root_ = std::move(root);
+
+	skeleton_ = runtime::skeleton();
+	if(root_)
+	{
+		add_skeleton_nodes(*root_, runtime::skeleton::invalid_index, skeleton_);
+	}
+
+	// the bones of the skin bound before
+	for(const auto& bone : skin_bind_data_.get_bones())
+	{
+		skeleton_.bones.emplace_back(skeleton_.find_node(bone.bone_id));
+	}
 	return true;
 }
 
@@ -484,6 +813,448 @@ void mesh::set_subset_count(uint32_t count)
 		mesh_subsets_.resize(count);
 }
 
+bool mesh::bind_clusters(const cluster_array_t& clusters)
+{
+	// We can only do this if we are in the process of preparing the mesh
+	if(prepare_status_ != mesh_status::preparing)
+	{
+		APPLOG_ERROR("Attempting to bind mesh clusters without first calling "
+					 "'prepareMesh' is not allowed.\n");
+		return false;
+
+	} // End if not preparing
+
+	// The clusters must cover the triangles added one after the other, each
+	// within a data group.
+	preparation_data_.clusters.clear();
+	std::uint32_t face = 0;
+	for(const auto& cluster : clusters)
+	{
+		if(cluster.face_start != face || cluster.face_count > preparation_data_.triangle_count - face)
+			return false;
+
+		for(std::uint32_t i = face; i < face + cluster.face_count; ++i)
+		{
+			if(preparation_data_.triangle_data[i].data_group_id != cluster.data_group_id)
+				return false;
+
+		} // Next triangle
+		face += cluster.face_count;
+
+	} // Next cluster
+
+	if(face != preparation_data_.triangle_count)
+		return false;
+
+	preparation_data_.clusters = clusters;
+	return true;
+}
+
+void mesh::build_clusters(load_data& data, std::uint32_t max_faces /* = 124 */,
+						  std::uint32_t max_vertices /* = 64 */)
+{
+	data.clusters.clear();
+	const auto& triangles = data.triangle_data;
+	if(triangles.empty() || !data.vertex_format.has(gfx::attribute::Position))
+		return;
+
+	const std::uint8_t* vertices_ptr = data.vertex_data.data();
+	const auto add_cluster = [&](std::uint32_t data_group_id, std::uint32_t start, std::uint32_t end) {
+		cluster result;
+		result.data_group_id = data_group_id;
+		result.face_start = start;
+		result.face_count = end - start;
+
+		// The sphere around the box of the vertices.
+		math::bbox box;
+		for(auto i = start; i < end; ++i)
+		{
+			for(const auto index : triangles[i].indices)
+				box.add_point(get_position(data.vertex_format, vertices_ptr, index));
+		}
+		result.center = box.get_center();
+		for(auto i = start; i < end; ++i)
+		{
+			for(const auto index : triangles[i].indices)
+			{
+				const auto position = get_position(data.vertex_format, vertices_ptr, index);
+				result.radius = std::max(result.radius, math::distance(result.center, position));
+			}
+		}
+
+		// The cone around the normals of the faces, those all facing away from
+		// the eye are those making more than 90 degrees with the direction to
+		// it. The average of the normals is the axis and the widest angle to
+		// it the spread. Beyond one side of a plane nothing can be culled.
+		std::vector<math::vec3> normals;
+		normals.reserve(result.face_count);
+		math::vec3 axis(0.0f, 0.0f, 0.0f);
+		for(auto i = start; i < end; ++i)
+		{
+			const auto& tri = triangles[i];
+			const math::vec3 v1 = get_position(data.vertex_format, vertices_ptr, tri.indices[0]);
+			const math::vec3 v2 = get_position(data.vertex_format, vertices_ptr, tri.indices[1]);
+			const math::vec3 v3 = get_position(data.vertex_format, vertices_ptr, tri.indices[2]);
+			const math::vec3 normal = math::cross(v2 - v1, v3 - v1);
+			if(math::length2(normal) > 0.0f)
+			{
+				normals.push_back(math::normalize(normal));
+				axis += normals.back();
+			}
+		}
+
+		if(math::length2(axis) > 0.0f)
+		{
+			result.cone_axis = math::normalize(axis);
+			float min_dot = 1.0f;
+			for(const auto& normal : normals)
+				min_dot = std::min(min_dot, math::dot(result.cone_axis, normal));
+
+			if(min_dot > 0.1f)
+				result.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+		}
+
+		data.clusters.push_back(result);
+	};
+
+	// Walk the triangles in order, which import ordered for the vertex cache,
+	// and start a cluster where the data group changes or a limit is reached.
+	// A vertex is marked with the cluster it was last counted in.
+	std::vector<std::uint32_t> vertex_marks(data.vertex_count, 0xFFFFFFFF);
+	std::uint32_t cluster_start = 0;
+	std::uint32_t cluster_vertices = 0;
+	auto cluster_index = std::uint32_t(0);
+	for(std::uint32_t i = 0; i < std::uint32_t(triangles.size()); ++i)
+	{
+		const auto& tri = triangles[i];
+		std::uint32_t new_vertices = 0;
+		for(const auto index : tri.indices)
+		{
+			if(vertex_marks[index] != cluster_index)
+				new_vertices++;
+		}
+
+		const auto data_group_id = triangles[cluster_start].data_group_id;
+		if(i > cluster_start &&
+		   (tri.data_group_id != data_group_id || i - cluster_start == max_faces ||
+			cluster_vertices + new_vertices > max_vertices))
+		{
+			add_cluster(data_group_id, cluster_start, i);
+			cluster_start = i;
+			cluster_vertices = 0;
+			cluster_index++;
+		}
+
+		for(const auto index : tri.indices)
+		{
+			if(vertex_marks[index] != cluster_index)
+			{
+				vertex_marks[index] = cluster_index;
+				cluster_vertices++;
+			}
+		}
+
+	} // Next triangle
+	add_cluster(triangles[cluster_start].data_group_id, cluster_start, std::uint32_t(triangles.size()));
+}
+
+std::uint32_t mesh::simplify(load_data& data, std::uint32_t target_faces, float max_error /* = 0.05f */)
+{
+	auto& triangles = data.triangle_data;
+	if(triangles.size() <= target_faces || !data.vertex_format.has(gfx::attribute::Position))
+		return std::uint32_t(triangles.size());
+
+	const std::uint32_t vertex_count = data.vertex_count;
+	const std::uint8_t* vertices_ptr = data.vertex_data.data();
+	std::vector<math::vec3> positions(vertex_count);
+	math::bbox box;
+	for(std::uint32_t i = 0; i < vertex_count; ++i)
+	{
+		positions[i] = get_position(data.vertex_format, vertices_ptr, i);
+		box.add_point(positions[i]);
+	}
+
+	// The vertices of a position, more than one is a seam.
+	std::vector<std::uint32_t> position_ids(vertex_count);
+	std::vector<std::uint32_t> position_users;
+	{
+		std::unordered_map<position_key, std::uint32_t, position_key_hash> ids;
+		ids.reserve(vertex_count);
+		for(std::uint32_t i = 0; i < vertex_count; ++i)
+		{
+			const auto result = ids.emplace(make_position_key(positions[i]), std::uint32_t(ids.size()));
+			position_ids[i] = result.first->second;
+			if(result.second)
+				position_users.push_back(0);
+			position_users[position_ids[i]]++;
+		}
+	}
+
+	// A vertex stays when it is at a seam or on an edge of the positions
+	// that is not shared by exactly two faces.
+	std::vector<std::uint8_t> locked(vertex_count, 0);
+	{
+		std::unordered_map<std::uint64_t, std::uint32_t> edges;
+		edges.reserve(triangles.size() * 3);
+		for(const auto& tri : triangles)
+		{
+			for(std::uint32_t j = 0; j < 3; ++j)
+			{
+				auto p1 = position_ids[tri.indices[j]];
+				auto p2 = position_ids[tri.indices[(j + 1) % 3]];
+				if(p1 > p2)
+					std::swap(p1, p2);
+				edges[(std::uint64_t(p1) << 32) | p2]++;
+			}
+		}
+
+		for(const auto& tri : triangles)
+		{
+			for(std::uint32_t j = 0; j < 3; ++j)
+			{
+				const auto v1 = tri.indices[j];
+				const auto v2 = tri.indices[(j + 1) % 3];
+				auto p1 = position_ids[v1];
+				auto p2 = position_ids[v2];
+				if(p1 > p2)
+					std::swap(p1, p2);
+				if(edges[(std::uint64_t(p1) << 32) | p2] != 2)
+					locked[v1] = locked[v2] = 1;
+			}
+		}
+
+		for(std::uint32_t i = 0; i < vertex_count; ++i)
+		{
+			if(position_users[position_ids[i]] > 1)
+				locked[i] = 1;
+		}
+	}
+
+	// The bones influencing every vertex, a vertex collapses onto one with
+	// the same bones so the skin still deforms what is left the same way.
+	std::vector<std::vector<std::uint32_t>> vertex_bones(data.skin_data.has_bones() ? vertex_count : 0);
+	{
+		const auto& bones = data.skin_data.get_bones();
+		for(std::uint32_t i = 0; i < std::uint32_t(bones.size()); ++i)
+		{
+			for(const auto& influence : bones[i].influences)
+			{
+				if(influence.vertex_index < vertex_count && influence.weight > 0.0f)
+					vertex_bones[influence.vertex_index].push_back(i);
+			}
+		}
+	}
+
+	// The planes of the faces around every vertex, weighted by their area.
+	std::vector<quadric> quadrics(vertex_count);
+	for(const auto& tri : triangles)
+	{
+		const auto& p1 = positions[tri.indices[0]];
+		const auto normal = math::cross(positions[tri.indices[1]] - p1, positions[tri.indices[2]] - p1);
+		const auto area = math::length(normal);
+		if(area <= 0.0f)
+			continue;
+
+		const auto unit = normal / area;
+		const auto d = -double(math::dot(unit, p1));
+		for(const auto index : tri.indices)
+			quadrics[index].add_plane(unit, d, area * 0.5);
+	}
+
+	struct collapse
+	{
+		double error = 0.0;
+		std::uint32_t from = 0;
+		std::uint32_t to = 0;
+	};
+
+	const auto extent = double(math::length(box.get_dimensions()));
+	const auto error_limit = (extent * max_error) * (extent * max_error);
+	std::vector<std::uint32_t> face_offsets;
+	std::vector<std::uint32_t> vertex_faces;
+	std::vector<collapse> collapses;
+	std::vector<std::uint32_t> remap(vertex_count);
+	std::vector<std::uint8_t> touched(vertex_count);
+	std::vector<std::uint32_t> neighbours;
+	auto face_count = std::uint32_t(triangles.size());
+	while(face_count > target_faces)
+	{
+		// The faces around every vertex.
+		face_offsets.assign(vertex_count + 1, 0);
+		for(const auto& tri : triangles)
+		{
+			for(const auto index : tri.indices)
+				face_offsets[index + 1]++;
+		}
+		for(std::uint32_t i = 0; i < vertex_count; ++i)
+			face_offsets[i + 1] += face_offsets[i];
+		vertex_faces.resize(face_offsets[vertex_count]);
+		{
+			auto next = face_offsets;
+			for(std::uint32_t i = 0; i < face_count; ++i)
+			{
+				for(const auto index : triangles[i].indices)
+					vertex_faces[next[index]++] = i;
+			}
+		}
+
+		// Every edge in both directions, from a vertex that may move.
+		collapses.clear();
+		for(const auto& tri : triangles)
+		{
+			// the three edges, then the same edges from their other end
+			for(std::uint32_t j = 0; j < 6; ++j)
+			{
+				const auto from = tri.indices[j % 3];
+				const auto to = tri.indices[(j + 1 + j / 3) % 3];
+				if(locked[from] || (!vertex_bones.empty() && vertex_bones[from] != vertex_bones[to]))
+					continue;
+
+				const auto error = quadrics[from].error(positions[to]);
+				if(error <= error_limit)
+					collapses.push_back({error, from, to});
+			}
+		}
+		std::sort(std::begin(collapses), std::end(collapses),
+				  [](const collapse& c1, const collapse& c2) { return c1.error < c2.error; });
+
+		// The cheapest collapses are made while no face around them changed
+		// in this pass and none of the faces left would flip.
+		for(std::uint32_t i = 0; i < vertex_count; ++i)
+			remap[i] = i;
+		std::fill(std::begin(touched), std::end(touched), std::uint8_t(0));
+		std::uint32_t removed = 0;
+		for(const auto& c : collapses)
+		{
+			if(face_count - removed <= target_faces)
+				break;
+			if(touched[c.from] || touched[c.to])
+				continue;
+
+			bool flips = false;
+			std::uint32_t collapsed = 0;
+			for(auto f = face_offsets[c.from]; f < face_offsets[c.from + 1] && !flips; ++f)
+			{
+				const auto& tri = triangles[vertex_faces[f]];
+				if(tri.indices[0] == c.to || tri.indices[1] == c.to || tri.indices[2] == c.to)
+				{
+					collapsed++;
+					continue;
+				}
+
+				math::vec3 corners[3];
+				for(std::uint32_t j = 0; j < 3; ++j)
+					corners[j] = positions[tri.indices[j]];
+				const auto before = math::cross(corners[1] - corners[0], corners[2] - corners[0]);
+				for(std::uint32_t j = 0; j < 3; ++j)
+				{
+					if(tri.indices[j] == c.from)
+						corners[j] = positions[c.to];
+				}
+				const auto after = math::cross(corners[1] - corners[0], corners[2] - corners[0]);
+				flips = math::dot(before, after) <= 0.0f;
+			}
+			if(flips || collapsed == 0)
+				continue;
+
+			// The vertices around both ends are only those of the faces they
+			// share, or faces would be doubled.
+			neighbours.clear();
+			for(auto f = face_offsets[c.from]; f < face_offsets[c.from + 1]; ++f)
+			{
+				for(const auto index : triangles[vertex_faces[f]].indices)
+					neighbours.push_back(index);
+			}
+			std::sort(std::begin(neighbours), std::end(neighbours));
+			neighbours.erase(std::unique(std::begin(neighbours), std::end(neighbours)), std::end(neighbours));
+			std::uint32_t shared = 0;
+			for(auto f = face_offsets[c.to]; f < face_offsets[c.to + 1]; ++f)
+			{
+				for(const auto index : triangles[vertex_faces[f]].indices)
+				{
+					if(index != c.from && index != c.to &&
+					   std::binary_search(std::begin(neighbours), std::end(neighbours), index))
+						shared++;
+				}
+			}
+			// every vertex opposite the edge is counted from both of its faces
+			// around the end it collapses onto
+			if(shared != collapsed * 2)
+				continue;
+
+			remap[c.from] = c.to;
+			quadrics[c.to] += quadrics[c.from];
+			for(auto f = face_offsets[c.from]; f < face_offsets[c.from + 1]; ++f)
+			{
+				for(const auto index : triangles[vertex_faces[f]].indices)
+					touched[index] = 1;
+			}
+			removed += collapsed;
+		}
+		if(removed == 0)
+			break;
+
+		// Keep the faces in their order without those that collapsed.
+		std::uint32_t kept = 0;
+		for(std::uint32_t i = 0; i < face_count; ++i)
+		{
+			auto tri = triangles[i];
+			for(auto& index : tri.indices)
+				index = remap[index];
+			if(tri.indices[0] == tri.indices[1] || tri.indices[1] == tri.indices[2] ||
+			   tri.indices[0] == tri.indices[2])
+				continue;
+			triangles[kept++] = tri;
+		}
+		face_count = kept;
+		triangles.resize(face_count);
+	}
+
+	// The vertices left in the order of their first use.
+	std::vector<std::uint32_t> new_indices(vertex_count, 0xFFFFFFFF);
+	std::vector<std::uint8_t> vertex_data;
+	const std::uint16_t vertex_stride = data.vertex_format.getStride();
+	std::uint32_t used = 0;
+	for(auto& tri : triangles)
+	{
+		for(auto& index : tri.indices)
+		{
+			if(new_indices[index] == 0xFFFFFFFF)
+			{
+				new_indices[index] = used++;
+				vertex_data.insert(std::end(vertex_data), vertices_ptr + index * vertex_stride,
+								   vertices_ptr + (index + 1) * vertex_stride);
+			}
+			index = new_indices[index];
+		}
+	}
+
+	for(auto& bone : data.skin_data.get_bones())
+	{
+		auto& influences = bone.influences;
+		influences.erase(std::remove_if(std::begin(influences), std::end(influences),
+										[&](const skin_bind_data::vertex_influence& influence) {
+											return influence.vertex_index >= vertex_count ||
+												   new_indices[influence.vertex_index] == 0xFFFFFFFF;
+										}),
+						 std::end(influences));
+		for(auto& influence : influences)
+			influence.vertex_index = new_indices[influence.vertex_index];
+	}
+
+	data.vertex_data = std::move(vertex_data);
+	data.vertex_count = used;
+	data.triangle_count = face_count;
+	data.clusters.clear();
+	return face_count;
+}
+
+bool mesh::cluster::faces_away(const math::vec3& eye) const
+{
+	const math::vec3 to_center = center - eye;
+	return math::dot(to_center, cone_axis) >= cone_cutoff * math::length(to_center) + radius;
+}
+
 bool mesh::prepare_mesh(const gfx::vertex_layout& format)
 {
 	// If we are already in the process of preparing, this is a no-op.
@@ -493,6 +1264,11 @@ bool mesh::prepare_mesh(const gfx::vertex_layout& format)
 	// Should we roll back an earlier call to 'endPrepare' ?
 	if(prepare_status_ == mesh_status::prepared)
 	{
+		// It is rolled back from the system memory copy, which is then kept.
+		if(!acquire_system_copy())
+			return false;
+		residency_ = mesh_residency::keep;
+
 		// Reset required values.
 		preparation_data_.triangle_count = 0;
 		preparation_data_.triangle_data.clear();
@@ -511,6 +1287,9 @@ bool mesh::prepare_mesh(const gfx::vertex_layout& format)
 		// Release prior hardware buffers if they were constructed.
 		hardware_vb_.reset();
 		hardware_ib_.reset();
+		hardware_position_vb_.reset();
+		arena_allocation_.reset();
+		skinning_buffers_.reset();
 
 		// Set the size of the preparation buffer so that we can add
 		// the existing buffer data to it.
@@ -554,6 +1333,11 @@ bool mesh::prepare_mesh(const gfx::vertex_layout& format)
 		checked_array_delete(system_ib_);
 		face_count_ = 0;
 
+		// The triangles are back in the order of the index buffer, so are the
+		// faces of the clusters.
+		preparation_data_.clusters = std::move(clusters_);
+		clusters_.clear();
+
 		// Determine which components the original vertex data actually contained.
 		bool source_has_normals = vertex_format_.has(gfx::attribute::Normal);
 		bool source_has_binormal = vertex_format_.has(gfx::attribute::Bitangent);
@@ -693,13 +1477,11 @@ bool mesh::prepare_mesh(const gfx::vertex_layout& format, void* vertices_ptr, st
 	memcpy(&preparation_data_.vertex_data[0], vertices_ptr, vertex_count * format.getStride());
 
 	// Generate the bounding box data for the new geometry.
-	std::int32_t position_offset = format.getOffset(gfx::attribute::Position);
-	auto stride = static_cast<std::int32_t>(format.getStride());
 	if(format.has(gfx::attribute::Position))
 	{
-		std::uint8_t* src_ptr = reinterpret_cast<std::uint8_t*>(vertices_ptr) + position_offset;
-		for(std::uint32_t i = 0; i < vertex_count; ++i, src_ptr += stride)
-			bbox_.add_point(*(reinterpret_cast<math::vec3*>(src_ptr)));
+		const auto* src_ptr = reinterpret_cast<const std::uint8_t*>(vertices_ptr);
+		for(std::uint32_t i = 0; i < vertex_count; ++i)
+			bbox_.add_point(get_position(format, src_ptr, i));
 
 	} // End if has position
 
@@ -910,68 +1692,91 @@ bool mesh::add_primitives(const triangle_array_t& triangles)
 	return true;
 }
 
-static void create_mesh(const gfx::vertex_layout& format, const generator::any_mesh& mesh,
+//-----------------------------------------------------------------------------
+//  Name : create_mesh ()
+/// <summary>
+/// Fills the preparation data from a generated mesh in one walk over its
+/// vertices and one over its triangles. It is a template on the generator
+/// so the walks call the concrete generators directly rather than through
+/// any_mesh, and the attributes are decoded once for all the vertices.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename generator_mesh_t>
+static void create_mesh(const gfx::vertex_layout& format, const generator_mesh_t& mesh,
 						mesh::preparation_data& data, math::bbox& bbox)
 {
-
 	// Determine the correct offset to any relevant elements in the vertex
-	bool has_position = format.has(gfx::attribute::Position);
-	bool has_texcoord0 = format.has(gfx::attribute::TexCoord0);
-	bool has_normals = format.has(gfx::attribute::Normal);
+	const packed_attribute position_attribute(format, gfx::attribute::Position, false);
+	const packed_attribute normal_attribute(format, gfx::attribute::Normal, true);
+	const packed_attribute texcoord0_attribute(format, gfx::attribute::TexCoord0, true);
 	bool has_tangents = format.has(gfx::attribute::Tangent);
 	bool has_bitangents = format.has(gfx::attribute::Bitangent);
 	std::uint16_t vertex_stride = format.getStride();
 
-	auto triangle_count = generator::count(mesh.triangles());
-	auto vertex_count = generator::count(mesh.vertices());
-	data.triangle_count = std::uint32_t(triangle_count);
-	data.vertex_count = std::uint32_t(vertex_count);
-
-	// Allocate enough space for the new vertex and triangle data
-	data.vertex_data.resize(data.vertex_count * vertex_stride);
-	data.vertex_flags.resize(data.vertex_count);
-	data.triangle_data.resize(data.triangle_count);
-
-	std::uint8_t* current_vertex_ptr = &data.vertex_data[0];
-	size_t i = 0;
+	// The data grows as the vertices and triangles are generated.
+	data.vertex_data.clear();
+	data.triangle_data.clear();
+	std::uint32_t vertex_count = 0;
 	for(const auto& v : mesh.vertices())
 	{
+		data.vertex_data.resize(data.vertex_data.size() + vertex_stride);
 
 		math::vec3 position = v.position;
-		math::vec4 normal = math::vec4(v.normal, 0.0f);
+		math::vec3 normal = v.normal;
 		math::vec2 texcoords0 = v.tex_coord;
+
 		// Store vertex components
-		if(has_position)
-			gfx::vertex_pack(&position.x, false, gfx::attribute::Position, format, current_vertex_ptr,
-							 std::uint32_t(i));
-		if(has_normals)
-			gfx::vertex_pack(&normal.x, true, gfx::attribute::Normal, format, current_vertex_ptr,
-							 std::uint32_t(i));
-		if(has_texcoord0)
-			gfx::vertex_pack(&texcoords0.x, true, gfx::attribute::TexCoord0, format, current_vertex_ptr,
-							 std::uint32_t(i));
+		std::uint8_t* vertices_ptr = data.vertex_data.data();
+		position_attribute.pack(&position.x, 3, format, vertices_ptr, vertex_count);
+		normal_attribute.pack(&normal.x, 3, format, vertices_ptr, vertex_count);
+		texcoord0_attribute.pack(&texcoords0.x, 2, format, vertices_ptr, vertex_count);
 
 		bbox.add_point(position);
-		i++;
+		vertex_count++;
 	}
 
-	size_t tri_idx = 0;
 	for(const auto& triangle : mesh.triangles())
 	{
 		const auto& indices = triangle.vertices;
-		auto& tri = data.triangle_data[tri_idx];
+		mesh::triangle tri;
 		tri.indices[0] = std::uint32_t(indices[0]);
 		tri.indices[1] = std::uint32_t(indices[1]);
 		tri.indices[2] = std::uint32_t(indices[2]);
-
-		tri_idx++;
+		data.triangle_data.push_back(tri);
 	}
 
+	data.vertex_count = vertex_count;
+	data.triangle_count = std::uint32_t(data.triangle_data.size());
+	data.vertex_flags.resize(data.vertex_count);
+
 	// We need to generate binormals / tangents?
 	data.compute_binormals = has_bitangents;
 	data.compute_tangents = has_tangents;
 }
 
+core::task_future<std::shared_ptr<mesh>> mesh::create_async(std::function<bool(mesh&)> create)
+{
+	auto& ts = core::get_subsystem<core::task_system>();
+	auto created = ts.push_on_worker_thread([create = std::move(create)]() {
+		auto result = std::make_shared<mesh>();
+		if(!create(*result))
+			result.reset();
+		return result;
+	});
+
+	// The buffers are made where the renderer's resources are.
+	return ts.push_on_owner_thread(
+		[](const std::shared_ptr<mesh>& result) {
+			if(result)
+			{
+				result->build_vb();
+				result->build_ib();
+			}
+			return result;
+		},
+		created);
+}
+
 bool mesh::create_cylinder(const gfx::vertex_layout& format, float radius, float height, std::uint32_t stacks,
 						   std::uint32_t slices, mesh_create_origin origin, bool hardware_copy /* = true */)
 {
@@ -1209,30 +2014,21 @@ bool mesh::end_prepare(bool hardware_copy /* = true */, bool weld /* = true */,
 	} // End if previously preparing
 
 	// Scan the preparation data for degenerate triangles.
-	std::uint16_t position_offset = vertex_format_.getOffset(gfx::attribute::Position);
-	// std::uint16_t vertex_stride = _vertex_format.getStride();
-	std::uint8_t* src_vertices_ptr = &preparation_data_.vertex_data[0] + position_offset;
-	for(std::uint32_t i = 0; i < preparation_data_.triangle_count; ++i)
-	{
-		triangle& tri = preparation_data_.triangle_data[i];
-		math::vec3 v1;
-		float vf1[4];
-		gfx::vertex_unpack(vf1, gfx::attribute::Position, vertex_format_, src_vertices_ptr, tri.indices[0]);
-		math::vec3 v2;
-		float vf2[4];
-		gfx::vertex_unpack(vf2, gfx::attribute::Position, vertex_format_, src_vertices_ptr, tri.indices[1]);
-		math::vec3 v3;
-		float vf3[4];
-		gfx::vertex_unpack(vf3, gfx::attribute::Position, vertex_format_, src_vertices_ptr, tri.indices[2]);
-		memcpy(&v1[0], vf1, 3 * sizeof(float));
-		memcpy(&v2[0], vf2, 3 * sizeof(float));
-		memcpy(&v3[0], vf3, 3 * sizeof(float));
-
-		math::vec3 c = math::cross(v2 - v1, v3 - v1);
-		if(math::length2(c) < (4.0f * 0.000001f * 0.000001f))
-			tri.flags |= triangle_flags::degenerate;
+	const std::uint8_t* src_vertices_ptr = &preparation_data_.vertex_data[0];
+	for_each_range(preparation_data_.triangle_count, [&](std::uint32_t begin, std::uint32_t end) {
+		for(std::uint32_t i = begin; i < end; ++i)
+		{
+			triangle& tri = preparation_data_.triangle_data[i];
+			const math::vec3 v1 = get_position(vertex_format_, src_vertices_ptr, tri.indices[0]);
+			const math::vec3 v2 = get_position(vertex_format_, src_vertices_ptr, tri.indices[1]);
+			const math::vec3 v3 = get_position(vertex_format_, src_vertices_ptr, tri.indices[2]);
 
-	} // Next triangle
+			math::vec3 c = math::cross(v2 - v1, v3 - v1);
+			if(math::length2(c) < (4.0f * 0.000001f * 0.000001f))
+				tri.flags |= triangle_flags::degenerate;
+
+		} // Next triangle
+	});
 
 	// Process the vertex data in order to generate any additional components that
 	// may be necessary
@@ -1275,19 +2071,39 @@ bool mesh::end_prepare(bool hardware_copy /* = true */, bool weld /* = true */,
 	preparation_data_.triangle_count = 0;
 	preparation_data_.triangle_data.clear();
 
-	// Index data has been updated and potentially needs to be serialized.
-	if(build_buffers)
-		build_vb(hardware_copy);
-
 	// Skin binding data has potentially been updated and needs to be serialized.
 
-	// Finally perform the final sort of the mesh data in order
-	// to build the index buffer and subset tables.
+	// Finally perform the final sort of the mesh data in order to build the
+	// index buffer and subset tables, and the vertex buffer once the sort has
+	// ordered the vertices.
 	if(!sort_mesh_data(optimize, hardware_copy, build_buffers))
 		return false;
 
+	// The sort keeps the order of the triangles of every data group when it
+	// does not optimize, and the skin splits the groups in palettes, so only
+	// then the clusters follow their triangles to the index buffer.
+	clusters_.clear();
+	if(!optimize && bone_palettes_.empty() && !preparation_data_.clusters.empty())
+	{
+		std::map<std::uint32_t, std::uint32_t> next_faces;
+		for(auto subset : mesh_subsets_)
+			next_faces[subset->data_group_id] = static_cast<std::uint32_t>(subset->face_start);
+
+		clusters_ = std::move(preparation_data_.clusters);
+		for(auto& cluster : clusters_)
+		{
+			auto& next_face = next_faces[cluster.data_group_id];
+			cluster.face_start = next_face;
+			next_face += cluster.face_count;
+
+		} // Next cluster
+
+	} // End if clusters kept
+	preparation_data_.clusters.clear();
+
 	// The mesh is now prepared
 	prepare_status_ = mesh_status::prepared;
+	triangle_bvh_.reset();
 	hardware_mesh_ = hardware_copy;
 	optimize_mesh_ = optimize;
 
@@ -1300,12 +2116,33 @@ void mesh::build_vb(bool hardware_copy)
 	// A video memory copy of the mesh was requested?
 	if(hardware_copy)
 	{
+		gfx::scoped_memory_category scope(gfx::memory_category::assets);
+
+		// Take a range of the shared buffers if the arena is used. The depth
+		// passes draw the meshes of the arena with all of their vertices, its
+		// indices are those of the shared vertices.
+		arena_allocation_.reset();
+		hardware_position_vb_.reset();
+		if(core::has_subsystems<mesh_arena>())
+		{
+			auto& arena = core::get_subsystem<mesh_arena>();
+			arena_allocation_ = arena.allocate(vertex_format_, system_vb_, vertex_count_);
+			if(arena_allocation_)
+			{
+				hardware_vb_ = std::make_shared<gfx::vertex_buffer>();
+				return;
+			}
+		}
+
 		// Calculate the required size of the vertex buffer
 		std::uint32_t buffer_size = vertex_count_ * vertex_format_.getStride();
 
 		const gfx::memory_view* mem = gfx::copy(system_vb_, static_cast<std::uint32_t>(buffer_size));
 		hardware_vb_ = std::make_shared<gfx::vertex_buffer>(mem, vertex_format_);
 
+		// The depth passes read the positions alone.
+		hardware_position_vb_ = create_position_buffer(vertex_format_, system_vb_, vertex_count_);
+
 	} // End if video memory vertex buffer required
 }
 
@@ -1314,22 +2151,37 @@ void mesh::build_ib(bool hardware_copy)
 	// Hardware versions of the final buffer were required?
 	if(hardware_copy)
 	{
-		// Calculate the required size of the index buffer
-		std::uint32_t buffer_size = face_count_ * 3 * sizeof(std::uint32_t);
+		gfx::scoped_memory_category scope(gfx::memory_category::assets);
+
+		// The indices go to the arena with the vertices.
+		if(arena_allocation_)
+		{
+			auto& arena = core::get_subsystem<mesh_arena>();
+			if(arena.allocate_indices(*arena_allocation_, system_ib_, face_count_ * 3))
+			{
+				hardware_ib_ = std::make_shared<gfx::index_buffer>();
+				return;
+			}
+
+			// a mesh is drawn from the arena only with both
+			arena_allocation_.reset();
+			const gfx::memory_view* vb_mem =
+				gfx::copy(system_vb_, static_cast<std::uint32_t>(vertex_count_ * vertex_format_.getStride()));
+			hardware_vb_ = std::make_shared<gfx::vertex_buffer>(vb_mem, vertex_format_);
+			hardware_position_vb_ = create_position_buffer(vertex_format_, system_vb_, vertex_count_);
+		}
 
 		// Allocate hardware buffer if required (i.e. it does not already exist).
 		if(!hardware_ib_)
 		{
-			const gfx::memory_view* mem = gfx::copy(system_ib_, static_cast<std::uint32_t>(buffer_size));
-			hardware_ib_ = std::make_shared<gfx::index_buffer>(mem, BGFX_BUFFER_INDEX32);
+			hardware_ib_ = create_index_buffer(system_ib_, face_count_ * 3, vertex_count_);
 		} // End if not allocated
 		else
 		{
 			auto ib = std::static_pointer_cast<gfx::index_buffer>(hardware_ib_);
 			if(!ib->is_valid())
 			{
-				const gfx::memory_view* mem = gfx::copy(system_ib_, static_cast<std::uint32_t>(buffer_size));
-				hardware_ib_ = std::make_shared<gfx::index_buffer>(mem, BGFX_BUFFER_INDEX32);
+				hardware_ib_ = create_index_buffer(system_ib_, face_count_ * 3, vertex_count_);
 			}
 		}
 
@@ -1492,9 +2344,12 @@ bool mesh::sort_mesh_data(bool optimize, bool hardware_copy, bool build_buffer)
 		// still describes
 		// a 'max' vertex (not a count)... We're correcting this later.
 		if(optimize)
+		{
 			build_optimized_index_buffer(subset, src_indices_ptr + (subset->face_start * 3), dst_indices_ptr,
 										 static_cast<std::uint32_t>(subset->vertex_start),
 										 static_cast<std::uint32_t>(subset->vertex_count));
+			optimize_overdraw(dst_indices_ptr, subset->face_count, system_vb_, vertex_format_);
+		}
 		else
 			memcpy(dst_indices_ptr, src_indices_ptr + (subset->face_start * 3),
 				   static_cast<std::size_t>(subset->face_count) * 3 * sizeof(std::uint32_t));
@@ -1512,6 +2367,31 @@ bool mesh::sort_mesh_data(bool optimize, bool hardware_copy, bool build_buffer)
 	// Clean up.
 	checked_array_delete(src_indices_ptr);
 
+	// Order the vertices as the optimized faces use them. The vertex ranges
+	// of the subsets are then found again.
+	if(optimize)
+	{
+		optimize_vertex_fetch();
+		for(auto subset : new_subsets)
+		{
+			subset->vertex_start = 0x7FFFFFFF;
+			subset->vertex_count = 0;
+
+			const std::uint32_t* indices_ptr = system_ib_ + (subset->face_start * 3);
+			for(std::uint32_t j = 0; j < subset->face_count * 3; ++j)
+			{
+				index = indices_ptr[j];
+				if(static_cast<std::int32_t>(index) < subset->vertex_start)
+					subset->vertex_start = static_cast<std::int32_t>(index);
+				if(index > subset->vertex_count)
+					subset->vertex_count = index;
+
+			} // Next index
+
+		} // Next subset
+
+	} // End if optimize
+
 	// Rebuild the additional triangle data based on the newly sorted
 	// subset data, and also convert the previously recorded maximum
 	// vertex value (stored in "vertex_count") into its final form
@@ -1535,9 +2415,12 @@ bool mesh::sort_mesh_data(bool optimize, bool hardware_copy, bool build_buffer)
 	// the moment, but it could be useful?
 	checked_array_delete(face_remap_ptr);
 
-	// Hardware versions of the final buffer were required?
+	// Hardware versions of the final buffers were required?
 	if(build_buffer)
+	{
+		build_vb(hardware_copy);
 		build_ib(hardware_copy);
+	}
 	// Index data and subsets have been updated and potentially need to be
 	// serialized.
 
@@ -1780,53 +2663,230 @@ void mesh::build_optimized_index_buffer(const subset* subset, std::uint32_t* src
 
 			} // End if already in cache
 
-			// Update the cache position records for all vertices in the cache
-			for(std::uint32_t k = 0; k < vertex_cache_size; ++k)
-				vertex_info_ptr[vertex_cache_ptr[k]].cache_position = static_cast<std::int32_t>(k);
+			// Update the cache position records for all vertices in the cache
+			for(std::uint32_t k = 0; k < vertex_cache_size; ++k)
+				vertex_info_ptr[vertex_cache_ptr[k]].cache_position = static_cast<std::int32_t>(k);
+
+		} // Next Index
+
+		// Recalculate the of all vertices contained in the cache
+		for(std::uint32_t j = 0; j < vertex_cache_size; ++j)
+		{
+			optimizer_vertex_info* vert_ptr = &vertex_info_ptr[vertex_cache_ptr[j]];
+			vert_ptr->vertex_score = find_vertex_optimizer_score(vert_ptr);
+
+		} // Next entry in the vertex cache
+
+		// Update the score of the triangles which reference this vertex
+		// and record the highest scoring.
+		for(std::uint32_t j = 0; j < vertex_cache_size; ++j)
+		{
+			optimizer_vertex_info* vert_ptr = &vertex_info_ptr[vertex_cache_ptr[j]];
+
+			// For each triangle referenced
+			for(std::uint32_t k = 0; k < vert_ptr->unused_triangle_references; ++k)
+			{
+				triangle_index = vert_ptr->triangle_references[k];
+				tri_ptr = &triangle_info_ptr[triangle_index];
+				score = vertex_info_ptr[src_buffer_ptr[(triangle_index * 3)] - min_vertex].vertex_score;
+				score += vertex_info_ptr[src_buffer_ptr[(triangle_index * 3) + 1] - min_vertex].vertex_score;
+				score += vertex_info_ptr[src_buffer_ptr[(triangle_index * 3) + 2] - min_vertex].vertex_score;
+				tri_ptr->triangle_score = score;
+
+				// Highest scoring so far?
+				if(score > best_score)
+				{
+					best_score = score;
+					best_triangle = static_cast<std::int32_t>(triangle_index);
+
+				} // End if better than previous score
+
+			} // Next triangle
+
+		} // Next entry in the vertex cache
+
+	} // Next triangle to Add
+
+	// Destroy the temporary arrays
+	checked_array_delete(vertex_info_ptr);
+	checked_array_delete(triangle_info_ptr);
+}
+
+void mesh::optimize_overdraw(std::uint32_t* indices_ptr, std::uint32_t face_count,
+							 const std::uint8_t* vertices_ptr, const gfx::vertex_layout& format,
+							 float threshold /* = 1.05f */)
+{
+	if(face_count < 2 || !format.has(gfx::attribute::Position))
+		return;
+
+	std::uint32_t min_vertex = 0xFFFFFFFF;
+	std::uint32_t max_vertex = 0;
+	for(std::uint32_t i = 0; i < face_count * 3; ++i)
+	{
+		min_vertex = std::min(min_vertex, indices_ptr[i]);
+		max_vertex = std::max(max_vertex, indices_ptr[i]);
+
+	} // Next index
+
+	// Simulate a fifo vertex cache with the time each vertex went in, a vertex
+	// is a miss once the cache took as many others since. Moving the time on
+	// by more than the cache size empties it.
+	const std::uint32_t cache_size = 16;
+	std::vector<std::uint32_t> cache_times(max_vertex - min_vertex + 1, 0);
+	std::uint32_t time = cache_size + 1;
+	const auto get_misses = [&](std::uint32_t face) {
+		std::uint32_t misses = 0;
+		for(std::uint32_t j = 0; j < 3; ++j)
+		{
+			auto& cached = cache_times[indices_ptr[(face * 3) + j] - min_vertex];
+			if(time - cached > cache_size)
+			{
+				cached = time++;
+				misses++;
+			}
+		}
+		return misses;
+	};
+
+	// The cache restarts where a triangle misses all of its vertices. A
+	// cluster between two such triangles draws as well in any order.
+	std::vector<std::uint32_t> hard_clusters;
+	for(std::uint32_t i = 0; i < face_count; ++i)
+	{
+		if(get_misses(i) == 3 || i == 0)
+			hard_clusters.push_back(i);
+
+	} // Next triangle
+
+	// Split them further, starting a new cluster with an empty cache wherever
+	// the misses so far are within the threshold of the misses of the whole.
+	std::vector<std::uint32_t> clusters;
+	for(std::size_t i = 0; i < hard_clusters.size(); ++i)
+	{
+		const auto start = hard_clusters[i];
+		const auto end = (i + 1 < hard_clusters.size()) ? hard_clusters[i + 1] : face_count;
+
+		time += cache_size + 1;
+		std::uint32_t cluster_misses = 0;
+		for(auto j = start; j < end; ++j)
+			cluster_misses += get_misses(j);
+		const float cluster_threshold = threshold * float(cluster_misses) / float(end - start);
+
+		clusters.push_back(start);
+		time += cache_size + 1;
+		std::uint32_t running_misses = 0;
+		std::uint32_t running_faces = 0;
+		for(auto j = start; j + 1 < end; ++j)
+		{
+			running_misses += get_misses(j);
+			running_faces++;
+			if(float(running_misses) / float(running_faces) <= cluster_threshold)
+			{
+				clusters.push_back(j + 1);
+				time += cache_size + 1;
+				running_misses = 0;
+				running_faces = 0;
+			}
+		}
+
+	} // Next hard cluster
+
+	if(clusters.size() < 2)
+		return;
+
+	// The triangles of a cluster weighted by their area give its centre and
+	// direction. The clusters on the outside facing out go first.
+	std::vector<math::vec3> centres(clusters.size(), math::vec3(0.0f, 0.0f, 0.0f));
+	std::vector<math::vec3> normals(clusters.size(), math::vec3(0.0f, 0.0f, 0.0f));
+	math::vec3 mesh_centre(0.0f, 0.0f, 0.0f);
+	for(std::size_t i = 0; i < clusters.size(); ++i)
+	{
+		const auto end = (i + 1 < clusters.size()) ? clusters[i + 1] : face_count;
+
+		float cluster_area = 0.0f;
+		for(auto j = clusters[i]; j < end; ++j)
+		{
+			const math::vec3 v1 = get_position(format, vertices_ptr, indices_ptr[(j * 3)]);
+			const math::vec3 v2 = get_position(format, vertices_ptr, indices_ptr[(j * 3) + 1]);
+			const math::vec3 v3 = get_position(format, vertices_ptr, indices_ptr[(j * 3) + 2]);
+			const math::vec3 centre = (v1 + v2 + v3) / 3.0f;
+			const math::vec3 normal = math::cross(v2 - v1, v3 - v1);
+			const float area = math::length(normal);
+
+			centres[i] += centre * area;
+			normals[i] += normal;
+			cluster_area += area;
+			mesh_centre += centre;
+
+		} // Next triangle
+
+		if(cluster_area > 0.0f)
+			centres[i] /= cluster_area;
+		if(math::length2(normals[i]) > 0.0f)
+			normals[i] = math::normalize(normals[i]);
+
+	} // Next cluster
+	mesh_centre /= float(face_count);
+
+	std::vector<float> sort_keys(clusters.size());
+	std::vector<std::uint32_t> order(clusters.size());
+	for(std::size_t i = 0; i < clusters.size(); ++i)
+	{
+		sort_keys[i] = math::dot(centres[i] - mesh_centre, normals[i]);
+		order[i] = std::uint32_t(i);
 
-		} // Next Index
+	} // Next cluster
 
-		// Recalculate the of all vertices contained in the cache
-		for(std::uint32_t j = 0; j < vertex_cache_size; ++j)
-		{
-			optimizer_vertex_info* vert_ptr = &vertex_info_ptr[vertex_cache_ptr[j]];
-			vert_ptr->vertex_score = find_vertex_optimizer_score(vert_ptr);
+	std::stable_sort(order.begin(), order.end(), [&sort_keys](std::uint32_t lhs, std::uint32_t rhs) {
+		return sort_keys[lhs] > sort_keys[rhs];
+	});
 
-		} // Next entry in the vertex cache
+	// Write the triangles out in the order of their clusters
+	std::vector<std::uint32_t> sorted_indices;
+	sorted_indices.reserve(face_count * 3);
+	for(const auto cluster : order)
+	{
+		const auto start = clusters[cluster];
+		const auto end = (cluster + 1 < clusters.size()) ? clusters[cluster + 1] : face_count;
+		sorted_indices.insert(sorted_indices.end(), indices_ptr + (start * 3), indices_ptr + (end * 3));
 
-		// Update the score of the triangles which reference this vertex
-		// and record the highest scoring.
-		for(std::uint32_t j = 0; j < vertex_cache_size; ++j)
-		{
-			optimizer_vertex_info* vert_ptr = &vertex_info_ptr[vertex_cache_ptr[j]];
+	} // Next cluster
+	std::memcpy(indices_ptr, sorted_indices.data(), sorted_indices.size() * sizeof(std::uint32_t));
+}
 
-			// For each triangle referenced
-			for(std::uint32_t k = 0; k < vert_ptr->unused_triangle_references; ++k)
-			{
-				triangle_index = vert_ptr->triangle_references[k];
-				tri_ptr = &triangle_info_ptr[triangle_index];
-				score = vertex_info_ptr[src_buffer_ptr[(triangle_index * 3)] - min_vertex].vertex_score;
-				score += vertex_info_ptr[src_buffer_ptr[(triangle_index * 3) + 1] - min_vertex].vertex_score;
-				score += vertex_info_ptr[src_buffer_ptr[(triangle_index * 3) + 2] - min_vertex].vertex_score;
-				tri_ptr->triangle_score = score;
+void mesh::optimize_vertex_fetch()
+{
+	// Number the vertices in the order the faces first reference them.
+	std::vector<std::uint32_t> remap(vertex_count_, 0xFFFFFFFF);
+	std::uint32_t next_vertex = 0;
+	for(std::uint32_t i = 0; i < face_count_ * 3; ++i)
+	{
+		auto& vertex = remap[system_ib_[i]];
+		if(vertex == 0xFFFFFFFF)
+			vertex = next_vertex++;
+		system_ib_[i] = vertex;
 
-				// Highest scoring so far?
-				if(score > best_score)
-				{
-					best_score = score;
-					best_triangle = static_cast<std::int32_t>(triangle_index);
+	} // Next index
 
-				} // End if better than previous score
+	// Vertices no face references keep their order after the others.
+	for(auto& vertex : remap)
+	{
+		if(vertex == 0xFFFFFFFF)
+			vertex = next_vertex++;
 
-			} // Next triangle
+	} // Next vertex
 
-		} // Next entry in the vertex cache
+	std::uint16_t vertex_stride = vertex_format_.getStride();
+	auto* new_vertices_ptr = new std::uint8_t[vertex_count_ * vertex_stride];
+	for(std::uint32_t i = 0; i < vertex_count_; ++i)
+	{
+		memcpy(new_vertices_ptr + (remap[i] * vertex_stride), system_vb_ + (i * vertex_stride),
+			   vertex_stride);
 
-	} // Next triangle to Add
+	} // Next vertex
 
-	// Destroy the temporary arrays
-	checked_array_delete(vertex_info_ptr);
-	checked_array_delete(triangle_info_ptr);
+	checked_array_delete(system_vb_);
+	system_vb_ = new_vertices_ptr;
 }
 
 void mesh::bind_render_buffers()
@@ -1837,7 +2897,7 @@ void mesh::bind_render_buffers()
 	}
 }
 
-void mesh::bind_render_buffers_for_subset(std::uint32_t data_group_id)
+void mesh::bind_render_buffers_for_subset(std::uint32_t data_group_id, bool positions_only)
 {
 	// Attempt to find a matching subset.
 	auto it = subset_lookup_.find(mesh_subset_key(data_group_id));
@@ -1875,20 +2935,30 @@ void mesh::bind_render_buffers_for_subset(std::uint32_t data_group_id)
 
 	// Render any batched data.
 	if(face_count > 0)
-		bind_mesh_data(face_start, face_count, vertex_start, vertex_count);
+		bind_mesh_data(face_start, face_count, vertex_start, vertex_count, positions_only);
 }
 
 void mesh::bind_mesh_data(std::uint32_t face_start, std::uint32_t face_count, std::uint32_t vertex_start,
-						  std::uint32_t vertex_count)
+						  std::uint32_t vertex_count, bool positions_only)
 {
 	(void)vertex_start;
 	std::uint32_t index_start = face_start * 3;
 	std::uint32_t index_count = face_count * 3;
 	// Hardware or software rendering?
-	if(hardware_mesh_)
+	if(hardware_mesh_ && arena_allocation_ && arena_allocation_->has_indices())
+	{
+		// Render from the shared buffers, the indices are offset to the page
+		gfx::set_vertex_buffer(0, arena_allocation_->get_vertex_buffer(), 0,
+							   arena_allocation_->get_page_vertices());
+		gfx::set_index_buffer(arena_allocation_->get_index_buffer(),
+							  arena_allocation_->index_start + index_start, index_count);
+	}
+	else if(hardware_mesh_)
 	{
-		// Render using hardware streams
-		auto vb = std::static_pointer_cast<gfx::vertex_buffer>(hardware_vb_);
+		// Render using hardware streams, the positions alone if they are apart
+		auto vb = std::static_pointer_cast<gfx::vertex_buffer>(positions_only && hardware_position_vb_
+																	? hardware_position_vb_
+																	: hardware_vb_);
 		auto ib = std::static_pointer_cast<gfx::index_buffer>(hardware_ib_);
 
 		gfx::set_vertex_buffer(0, vb->native_handle(), 0, vertex_count);
@@ -1998,11 +3068,10 @@ bool mesh::generate_vertex_normals(std::uint32_t* adjacency_ptr,
 								   std::vector<std::uint32_t>* remap_array_ptr /* = nullptr */)
 {
 	std::uint32_t start_tri, previous_tri, current_tri;
-	math::vec3 vec_edge1, vec_edge2, vec_normal;
+	math::vec3 vec_normal;
 	std::uint32_t i, j, k, index;
 
 	// Get access to useful data offset information.
-	std::uint16_t position_offset = vertex_format_.getOffset(gfx::attribute::Position);
 	bool has_normals = vertex_format_.has(gfx::attribute::Normal);
 	std::uint16_t vertex_stride = vertex_format_.getStride();
 
@@ -2023,28 +3092,25 @@ bool mesh::generate_vertex_normals(std::uint32_t* adjacency_ptr,
 	// Pre-compute surface normals for each triangle
 	std::uint8_t* src_vertices_ptr = &preparation_data_.vertex_data[0];
 	auto* normals_ptr = new math::vec3[preparation_data_.triangle_count];
-	memset(normals_ptr, 0, preparation_data_.triangle_count * sizeof(math::vec3));
-	for(i = 0; i < preparation_data_.triangle_count; ++i)
-	{
-		// Retrieve positions of each referenced vertex.
-		const triangle& tri = preparation_data_.triangle_data[i];
-		const auto* v1 = reinterpret_cast<const math::vec3*>(
-			src_vertices_ptr + (tri.indices[0] * vertex_stride) + position_offset);
-		const auto* v2 = reinterpret_cast<const math::vec3*>(
-			src_vertices_ptr + (tri.indices[1] * vertex_stride) + position_offset);
-		const auto* v3 = reinterpret_cast<const math::vec3*>(
-			src_vertices_ptr + (tri.indices[2] * vertex_stride) + position_offset);
-
-		// Compute the two edge vectors required for generating our normal
-		// We normalize here to prevent problems when the triangles are very small.
-		vec_edge1 = math::normalize(*v2 - *v1);
-		vec_edge2 = math::normalize(*v3 - *v1);
-
-		// Generate the normal
-		vec_normal = math::cross(vec_edge1, vec_edge2);
-		normals_ptr[i] = math::normalize(vec_normal);
+	for_each_range(preparation_data_.triangle_count, [&](std::uint32_t begin, std::uint32_t end) {
+		for(std::uint32_t face = begin; face < end; ++face)
+		{
+			// Retrieve positions of each referenced vertex.
+			const triangle& tri = preparation_data_.triangle_data[face];
+			const math::vec3 v1 = get_position(vertex_format_, src_vertices_ptr, tri.indices[0]);
+			const math::vec3 v2 = get_position(vertex_format_, src_vertices_ptr, tri.indices[1]);
+			const math::vec3 v3 = get_position(vertex_format_, src_vertices_ptr, tri.indices[2]);
 
-	} // Next Face
+			// Compute the two edge vectors required for generating our normal
+			// We normalize here to prevent problems when the triangles are very small.
+			const math::vec3 edge1 = math::normalize(v2 - v1);
+			const math::vec3 edge2 = math::normalize(v3 - v1);
+
+			// Generate the normal
+			normals_ptr[face] = math::normalize(math::cross(edge1, edge2));
+
+		} // Next Face
+	});
 
 	// Now compute the actual VERTEX normals using face adjacency information
 	for(i = 0; i < preparation_data_.triangle_count; ++i)
@@ -2262,10 +3328,6 @@ bool mesh::generate_vertex_barycentrics(std::uint32_t* adjacency)
 
 bool mesh::generate_vertex_tangents()
 {
-	math::vec3 *tangents = nullptr, *bitangents = nullptr;
-	std::uint32_t i, i1, i2, i3, num_faces, num_verts;
-	math::vec3 P, Q, T, B, cross_vec, normal_vec;
-
 	// Get access to useful data offset information.
 	std::uint16_t vertex_stride = vertex_format_.getStride();
 
@@ -2280,159 +3342,145 @@ bool mesh::generate_vertex_tangents()
 	if(!force_tangent_generation_ && !requires_bitangents && !requires_tangents)
 		return true;
 
-	// Allocate storage space for the tangent and bitangent vectors
-	// that we will effectively need to average for shared vertices.
-	num_faces = preparation_data_.triangle_count;
-	num_verts = preparation_data_.vertex_count;
-	tangents = new math::vec3[num_verts];
-	bitangents = new math::vec3[num_verts];
-	memset(tangents, 0, sizeof(math::vec3) * num_verts);
-	memset(bitangents, 0, sizeof(math::vec3) * num_verts);
+	// Allocate storage space for the tangent and bitangent vectors of the faces
+	// and the ones that we will effectively need to average for shared vertices.
+	const std::uint32_t num_faces = preparation_data_.triangle_count;
+	const std::uint32_t num_verts = preparation_data_.vertex_count;
+	std::vector<math::vec3> face_tangents(num_faces, math::vec3(0.0f, 0.0f, 0.0f));
+	std::vector<math::vec3> face_bitangents(num_faces, math::vec3(0.0f, 0.0f, 0.0f));
+	std::vector<math::vec3> tangents(num_verts, math::vec3(0.0f, 0.0f, 0.0f));
+	std::vector<math::vec3> bitangents(num_verts, math::vec3(0.0f, 0.0f, 0.0f));
 
-	// Iterate through each triangle in the mesh
+	// Compute the vectors of each triangle in the mesh, the faces are independent.
 	std::uint8_t* src_vertices_ptr = &preparation_data_.vertex_data[0];
-	for(i = 0; i < num_faces; ++i)
-	{
-		triangle& tri = preparation_data_.triangle_data[i];
+	for_each_range(num_faces, [&](std::uint32_t begin, std::uint32_t end) {
+		for(std::uint32_t i = begin; i < end; ++i)
+		{
+			const triangle& tri = preparation_data_.triangle_data[i];
 
-		// Compute the three indices for the triangle
-		i1 = tri.indices[0];
-		i2 = tri.indices[1];
-		i3 = tri.indices[2];
-
-		// Retrieve references to the positions of the three vertices in the
-		// triangle.
-		math::vec3 E;
-		float fE[4];
-		gfx::vertex_unpack(fE, gfx::attribute::Position, vertex_format_, src_vertices_ptr, i1);
-		math::vec3 F;
-		float fF[4];
-		gfx::vertex_unpack(fF, gfx::attribute::Position, vertex_format_, src_vertices_ptr, i2);
-		math::vec3 G;
-		float fG[4];
-		gfx::vertex_unpack(fG, gfx::attribute::Position, vertex_format_, src_vertices_ptr, i3);
-		memcpy(&E[0], fE, 3 * sizeof(float));
-		memcpy(&F[0], fF, 3 * sizeof(float));
-		memcpy(&G[0], fG, 3 * sizeof(float));
-
-		// Retrieve references to the base texture coordinates of the three vertices
-		// in the triangle.
-		// TODO: Allow customization of which tex coordinates to generate from.
-		math::vec2 Et;
-		float fEt[4];
-		gfx::vertex_unpack(&fEt[0], gfx::attribute::TexCoord0, vertex_format_, src_vertices_ptr, i1);
-		math::vec2 Ft;
-		float fFt[4];
-		gfx::vertex_unpack(&fFt[0], gfx::attribute::TexCoord0, vertex_format_, src_vertices_ptr, i2);
-		math::vec2 Gt;
-		float fGt[4];
-		gfx::vertex_unpack(&fGt[0], gfx::attribute::TexCoord0, vertex_format_, src_vertices_ptr, i3);
-		memcpy(&Et[0], fEt, 2 * sizeof(float));
-		memcpy(&Ft[0], fFt, 2 * sizeof(float));
-		memcpy(&Gt[0], fGt, 2 * sizeof(float));
-
-		// Compute the known variables P & Q, where "P = F-E" and "Q = G-E"
-		// based on our original discussion of the tangent vector
-		// calculation.
-		P = F - E;
-		Q = G - E;
-
-		// Also compute the know variables <s1,t1> and <s2,t2>. Recall that
-		// these are the texture coordinate deltas similarly for "F-E"
-		// and "G-E".
-		float s1 = Ft.x - Et.x;
-		float t1 = Ft.y - Et.y;
-		float s2 = Gt.x - Et.x;
-		float t2 = Gt.y - Et.y;
-
-		// Next we can pre-compute part of the equation we developed
-		// earlier: "1/(s1 * t2 - s2 * t1)". We do this in two separate
-		// stages here in order to ensure that the texture coordinates
-		// are not invalid.
-		float r = (s1 * t2 - s2 * t1);
-		if(math::abs(r) < math::epsilon<float>())
-			continue;
-		r = 1.0f / r;
-
-		// All that's left for us to do now is to run the matrix
-		// multiplication and multiply the result by the scalar portion
-		// we precomputed earlier.
-		T.x = r * (t2 * P.x - t1 * Q.x);
-		T.y = r * (t2 * P.y - t1 * Q.y);
-		T.z = r * (t2 * P.z - t1 * Q.z);
-		B.x = r * (s1 * Q.x - s2 * P.x);
-		B.y = r * (s1 * Q.y - s2 * P.y);
-		B.z = r * (s1 * Q.z - s2 * P.z);
-
-		// Add the tangent and bitangent vectors (summed average) to
-		// any previous values computed for each vertex.
-		tangents[i1] += T;
-		tangents[i2] += T;
-		tangents[i3] += T;
-		bitangents[i1] += B;
-		bitangents[i2] += B;
-		bitangents[i3] += B;
+			// Compute the three indices for the triangle
+			const std::uint32_t i1 = tri.indices[0];
+			const std::uint32_t i2 = tri.indices[1];
+			const std::uint32_t i3 = tri.indices[2];
+
+			// Retrieve the positions of the three vertices in the triangle.
+			const math::vec3 E = get_position(vertex_format_, src_vertices_ptr, i1);
+			const math::vec3 F = get_position(vertex_format_, src_vertices_ptr, i2);
+			const math::vec3 G = get_position(vertex_format_, src_vertices_ptr, i3);
+
+			// Retrieve the base texture coordinates of the three vertices
+			// in the triangle.
+			// TODO: Allow customization of which tex coordinates to generate from.
+			float Et[4] = {};
+			gfx::vertex_unpack(Et, gfx::attribute::TexCoord0, vertex_format_, src_vertices_ptr, i1);
+			float Ft[4] = {};
+			gfx::vertex_unpack(Ft, gfx::attribute::TexCoord0, vertex_format_, src_vertices_ptr, i2);
+			float Gt[4] = {};
+			gfx::vertex_unpack(Gt, gfx::attribute::TexCoord0, vertex_format_, src_vertices_ptr, i3);
+
+			// Compute the known variables P & Q, where "P = F-E" and "Q = G-E"
+			// based on our original discussion of the tangent vector
+			// calculation.
+			const math::vec3 P = F - E;
+			const math::vec3 Q = G - E;
+
+			// Also compute the know variables <s1,t1> and <s2,t2>. Recall that
+			// these are the texture coordinate deltas similarly for "F-E"
+			// and "G-E".
+			float s1 = Ft[0] - Et[0];
+			float t1 = Ft[1] - Et[1];
+			float s2 = Gt[0] - Et[0];
+			float t2 = Gt[1] - Et[1];
+
+			// Next we can pre-compute part of the equation we developed
+			// earlier: "1/(s1 * t2 - s2 * t1)". We do this in two separate
+			// stages here in order to ensure that the texture coordinates
+			// are not invalid.
+			float r = (s1 * t2 - s2 * t1);
+			if(math::abs(r) < math::epsilon<float>())
+				continue;
+			r = 1.0f / r;
+
+			// All that's left for us to do now is to run the matrix
+			// multiplication and multiply the result by the scalar portion
+			// we precomputed earlier.
+			face_tangents[i] = r * (t2 * P - t1 * Q);
+			face_bitangents[i] = r * (s1 * Q - s2 * P);
+
+		} // Next triangle
+	});
+
+	// Add the tangent and bitangent vectors (summed average) to
+	// any previous values computed for each vertex. Faces share vertices,
+	// so this is the only part which is not split between the workers.
+	for(std::uint32_t i = 0; i < num_faces; ++i)
+	{
+		const triangle& tri = preparation_data_.triangle_data[i];
+		for(const auto index : tri.indices)
+		{
+			tangents[index] += face_tangents[i];
+			bitangents[index] += face_bitangents[i];
+		}
 
 	} // Next triangle
 
 	// Generate final tangent vectors
-	for(i = 0; i < num_verts; i++, src_vertices_ptr += vertex_stride)
-	{
-		// Skip if the original imported data already provided a bitangent /
-		// tangent.
-		bool has_bitangent =
-			((preparation_data_.vertex_flags[i] & preparation_data::source_contains_binormal) != 0);
-		bool has_tangent =
-			((preparation_data_.vertex_flags[i] & preparation_data::source_contains_tangent) != 0);
-		if(!force_tangent_generation_ && has_bitangent && has_tangent)
-			continue;
-
-		// Retrieve the normal vector from the vertex and the computed
-		// tangent vector.
-		float normal[4];
-		gfx::vertex_unpack(normal, gfx::attribute::Normal, vertex_format_, src_vertices_ptr);
-		memcpy(&normal_vec[0], normal, 3 * sizeof(float));
+	for_each_range(num_verts, [&](std::uint32_t begin, std::uint32_t end) {
+		for(std::uint32_t i = begin; i < end; ++i)
+		{
+			std::uint8_t* vertex_ptr = src_vertices_ptr + (i * vertex_stride);
+
+			// Skip if the original imported data already provided a bitangent /
+			// tangent.
+			bool has_bitangent =
+				((preparation_data_.vertex_flags[i] & preparation_data::source_contains_binormal) != 0);
+			bool has_tangent =
+				((preparation_data_.vertex_flags[i] & preparation_data::source_contains_tangent) != 0);
+			if(!force_tangent_generation_ && has_bitangent && has_tangent)
+				continue;
 
-		T = tangents[i];
+			// Retrieve the normal vector from the vertex and the computed
+			// tangent vector.
+			float normal[4];
+			gfx::vertex_unpack(normal, gfx::attribute::Normal, vertex_format_, vertex_ptr);
+			const math::vec3 normal_vec(normal[0], normal[1], normal[2]);
 
-		// GramSchmidt orthogonalize
-		T = T - (normal_vec * math::dot(normal_vec, T));
-		T = math::normalize(T);
+			math::vec3 T = tangents[i];
 
-		// Store tangent if required
-		if(force_tangent_generation_ || (!has_tangent && requires_tangents))
-			gfx::vertex_pack(&math::vec4(T, 1.0f)[0], true, gfx::attribute::Tangent, vertex_format_,
-							 src_vertices_ptr);
+			// GramSchmidt orthogonalize
+			T = T - (normal_vec * math::dot(normal_vec, T));
+			T = math::normalize(T);
 
-		// Compute and store bitangent if required
-		if(force_tangent_generation_ || (!has_bitangent && requires_bitangents))
-		{
-			// Calculate the new orthogonal bitangent
-			B = math::cross(normal_vec, T);
-			B = math::normalize(B);
+			// Store tangent if required
+			if(force_tangent_generation_ || (!has_tangent && requires_tangents))
+				gfx::vertex_pack(&math::vec4(T, 1.0f)[0], true, gfx::attribute::Tangent, vertex_format_,
+								 vertex_ptr);
 
-			// Compute the "handedness" of the tangent and bitangent. This
-			// ensures the inverted / mirrored texture coordinates still have
-			// an accurate matrix.
-			cross_vec = math::cross(normal_vec, T);
-			if(math::dot(cross_vec, bitangents[i]) < 0.0f)
+			// Compute and store bitangent if required
+			if(force_tangent_generation_ || (!has_bitangent && requires_bitangents))
 			{
-				// Flip the bitangent
-				B = -B;
-
-			} // End if coordinates inverted
+				// Calculate the new orthogonal bitangent
+				math::vec3 B = math::cross(normal_vec, T);
+				B = math::normalize(B);
+
+				// Compute the "handedness" of the tangent and bitangent. This
+				// ensures the inverted / mirrored texture coordinates still have
+				// an accurate matrix.
+				if(math::dot(B, bitangents[i]) < 0.0f)
+				{
+					// Flip the bitangent
+					B = -B;
 
-			// Store.
-			gfx::vertex_pack(&math::vec4(B, 1.0f)[0], true, gfx::attribute::Bitangent, vertex_format_,
-							 src_vertices_ptr);
+				} // End if coordinates inverted
 
-		} // End if requires bitangent
+				// Store.
+				gfx::vertex_pack(&math::vec4(B, 1.0f)[0], true, gfx::attribute::Bitangent, vertex_format_,
+								 vertex_ptr);
 
-	} // Next vertex
+			} // End if requires bitangent
 
-	// Cleanup
-	checked_array_delete(tangents);
-	checked_array_delete(bitangents);
+		} // Next vertex
+	});
 
 	// Return success
 	return true;
@@ -2440,206 +3488,88 @@ bool mesh::generate_vertex_tangents()
 
 bool mesh::generate_adjacency(std::vector<std::uint32_t>& adjacency)
 {
-	std::map<adjacent_edge_key, std::uint32_t> edge_tree;
-	std::map<adjacent_edge_key, std::uint32_t>::iterator it_edge;
-
 	// What is the status of the mesh?
-	if(prepare_status_ != mesh_status::prepared)
-	{
-		// Validate requirements
-		if(preparation_data_.triangle_count == 0)
-			return false;
-
-		// Retrieve useful data offset information.
-		std::uint16_t position_offset = vertex_format_.getOffset(gfx::attribute::Position);
-		std::uint16_t vertex_stride = vertex_format_.getStride();
-
-		// Insert all edges into the edge tree
-		std::uint8_t* src_vertices_ptr = &preparation_data_.vertex_data[0] + position_offset;
-		for(std::uint32_t i = 0; i < preparation_data_.triangle_count; ++i)
-		{
-			adjacent_edge_key edge;
-
-			// Degenerate triangles cannot participate.
-			const triangle& tri = preparation_data_.triangle_data[i];
-			if(tri.flags & triangle_flags::degenerate)
-				continue;
-
-			// Retrieve positions of each referenced vertex.
-			const math::vec3* v1 =
-				reinterpret_cast<const math::vec3*>(src_vertices_ptr + (tri.indices[0] * vertex_stride));
-			const math::vec3* v2 =
-				reinterpret_cast<const math::vec3*>(src_vertices_ptr + (tri.indices[1] * vertex_stride));
-			const math::vec3* v3 =
-				reinterpret_cast<const math::vec3*>(src_vertices_ptr + (tri.indices[2] * vertex_stride));
-
-			// edge 1
-			edge.vertex1 = v1;
-			edge.vertex2 = v2;
-			edge_tree[edge] = i;
-
-			// edge 2
-			edge.vertex1 = v2;
-			edge.vertex2 = v3;
-			edge_tree[edge] = i;
-
-			// edge 3
-			edge.vertex1 = v3;
-			edge.vertex2 = v1;
-			edge_tree[edge] = i;
-
-		} // Next Face
-
-		// Size the output array.
-		adjacency.resize(preparation_data_.triangle_count * 3, 0xFFFFFFFF);
-
-		// Now, find any adjacent edges for each triangle edge
-		for(std::uint32_t i = 0; i < preparation_data_.triangle_count; ++i)
-		{
-			adjacent_edge_key edge;
-
-			// Degenerate triangles cannot participate.
-			const triangle& tri = preparation_data_.triangle_data[i];
-			if(tri.flags & triangle_flags::degenerate)
-				continue;
-
-			// Retrieve positions of each referenced vertex.
-			const math::vec3* v1 =
-				reinterpret_cast<const math::vec3*>(src_vertices_ptr + (tri.indices[0] * vertex_stride));
-			const math::vec3* v2 =
-				reinterpret_cast<const math::vec3*>(src_vertices_ptr + (tri.indices[1] * vertex_stride));
-			const math::vec3* v3 =
-				reinterpret_cast<const math::vec3*>(src_vertices_ptr + (tri.indices[2] * vertex_stride));
-
-			// Note: Notice below that the order of the edge vertices
-			//       is swapped. This is because we want to find the
-			//       matching ADJACENT edge, rather than simply finding
-			//       the same edge that we're currently processing.
-
-			// edge 1
-			edge.vertex2 = v1;
-			edge.vertex1 = v2;
+	const bool prepared = prepare_status_ == mesh_status::prepared;
+	const std::uint32_t face_count = prepared ? face_count_ : preparation_data_.triangle_count;
+	const std::uint32_t vertex_count = prepared ? vertex_count_ : preparation_data_.vertex_count;
 
-			// Find the matching adjacent edge
-			it_edge = edge_tree.find(edge);
-			if(it_edge != edge_tree.end())
-				adjacency[(i * 3)] = it_edge->second;
+	// Validate requirements
+	if(face_count == 0 || (prepared && !acquire_system_copy()))
+		return false;
 
-			// edge 2
-			edge.vertex2 = v2;
-			edge.vertex1 = v3;
+	const std::uint8_t* src_vertices_ptr = prepared ? system_vb_ : &preparation_data_.vertex_data[0];
+	const auto get_indices = [&](std::uint32_t face) -> const std::uint32_t* {
+		if(prepared)
+			return system_ib_ + (face * 3);
 
-			// Find the matching adjacent edge
-			it_edge = edge_tree.find(edge);
-			if(it_edge != edge_tree.end())
-				adjacency[(i * 3) + 1] = it_edge->second;
+		// Degenerate triangles cannot participate.
+		const triangle& tri = preparation_data_.triangle_data[face];
+		return (tri.flags & triangle_flags::degenerate) ? nullptr : tri.indices;
+	};
 
-			// edge 3
-			edge.vertex2 = v3;
-			edge.vertex1 = v1;
+	// Vertices at the same position share an id, so that an edge is
+	// the pair of the ids of its vertices instead of their positions.
+	std::vector<position_key> position_keys(vertex_count);
+	for_each_range(vertex_count, [&](std::uint32_t begin, std::uint32_t end) {
+		for(std::uint32_t i = begin; i < end; ++i)
+			position_keys[i] = make_position_key(get_position(vertex_format_, src_vertices_ptr, i));
+	});
+
+	std::vector<std::uint32_t> position_ids(vertex_count);
+	std::unordered_map<position_key, std::uint32_t, position_key_hash> positions;
+	positions.reserve(vertex_count);
+	for(std::uint32_t i = 0; i < vertex_count; ++i)
+	{
+		const auto id = std::uint32_t(positions.size());
+		position_ids[i] = positions.emplace(position_keys[i], id).first->second;
 
-			// Find the matching adjacent edge
-			it_edge = edge_tree.find(edge);
-			if(it_edge != edge_tree.end())
-				adjacency[(i * 3) + 2] = it_edge->second;
+	} // Next Vertex
 
-		} // Next Face
+	const auto get_edge = [&position_ids](std::uint32_t from, std::uint32_t to) {
+		return (std::uint64_t(position_ids[from]) << 32) | position_ids[to];
+	};
 
-	} // End if not prepared
-	else
+	// Insert all edges into the edge table, the last face of an edge owns it
+	std::unordered_map<std::uint64_t, std::uint32_t> edges;
+	edges.reserve(face_count * 3);
+	for(std::uint32_t i = 0; i < face_count; ++i)
 	{
-		// Validate requirements
-		if(face_count_ == 0)
-			return false;
-
-		// Retrieve useful data offset information.
-		std::uint16_t position_offset = vertex_format_.getOffset(gfx::attribute::Position);
-		std::uint16_t vertex_stride = vertex_format_.getStride();
-
-		// Insert all edges into the edge tree
-		std::uint8_t* src_vertices_ptr = system_vb_ + position_offset;
-		std::uint32_t* src_indices_ptr = system_ib_;
-		for(std::uint32_t i = 0; i < face_count_; ++i, src_indices_ptr += 3)
-		{
-			adjacent_edge_key edge;
+		const std::uint32_t* indices = get_indices(i);
+		if(!indices)
+			continue;
 
-			// Retrieve positions of each referenced vertex.
-			const auto* v1 =
-				reinterpret_cast<const math::vec3*>(src_vertices_ptr + (src_indices_ptr[0] * vertex_stride));
-			const auto* v2 =
-				reinterpret_cast<const math::vec3*>(src_vertices_ptr + (src_indices_ptr[1] * vertex_stride));
-			const auto* v3 =
-				reinterpret_cast<const math::vec3*>(src_vertices_ptr + (src_indices_ptr[2] * vertex_stride));
-
-			// edge 1
-			edge.vertex1 = v1;
-			edge.vertex2 = v2;
-			edge_tree[edge] = i;
-
-			// edge 2
-			edge.vertex1 = v2;
-			edge.vertex2 = v3;
-			edge_tree[edge] = i;
-
-			// edge 3
-			edge.vertex1 = v3;
-			edge.vertex2 = v1;
-			edge_tree[edge] = i;
+		edges[get_edge(indices[0], indices[1])] = i;
+		edges[get_edge(indices[1], indices[2])] = i;
+		edges[get_edge(indices[2], indices[0])] = i;
 
-		} // Next Face
+	} // Next Face
 
-		// Size the output array.
-		adjacency.resize(face_count_ * 3, 0xFFFFFFFF);
+	// Size the output array.
+	adjacency.assign(face_count * 3, 0xFFFFFFFF);
 
-		// Now, find any adjacent edges for each triangle edge
-		src_indices_ptr = system_ib_;
-		for(std::uint32_t i = 0; i < face_count_; ++i, src_indices_ptr += 3)
+	// Now, find any adjacent edges for each triangle edge. The table is only
+	// read from here on, so the faces are split between the workers.
+	for_each_range(face_count, [&](std::uint32_t begin, std::uint32_t end) {
+		for(std::uint32_t i = begin; i < end; ++i)
 		{
-			adjacent_edge_key edge;
-
-			// Retrieve positions of each referenced vertex.
-			const math::vec3* v1 =
-				reinterpret_cast<const math::vec3*>(src_vertices_ptr + (src_indices_ptr[0] * vertex_stride));
-			const math::vec3* v2 =
-				reinterpret_cast<const math::vec3*>(src_vertices_ptr + (src_indices_ptr[1] * vertex_stride));
-			const math::vec3* v3 =
-				reinterpret_cast<const math::vec3*>(src_vertices_ptr + (src_indices_ptr[2] * vertex_stride));
+			const std::uint32_t* indices = get_indices(i);
+			if(!indices)
+				continue;
 
 			// Note: Notice below that the order of the edge vertices
 			//       is swapped. This is because we want to find the
 			//       matching ADJACENT edge, rather than simply finding
 			//       the same edge that we're currently processing.
+			for(std::uint32_t j = 0; j < 3; ++j)
+			{
+				const auto it_edge = edges.find(get_edge(indices[(j + 1) % 3], indices[j]));
+				if(it_edge != edges.end())
+					adjacency[(i * 3) + j] = it_edge->second;
 
-			// edge 1
-			edge.vertex2 = v1;
-			edge.vertex1 = v2;
-
-			// Find the matching adjacent edge
-			it_edge = edge_tree.find(edge);
-			if(it_edge != edge_tree.end())
-				adjacency[(i * 3)] = it_edge->second;
-
-			// edge 2
-			edge.vertex2 = v2;
-			edge.vertex1 = v3;
-
-			// Find the matching adjacent edge
-			it_edge = edge_tree.find(edge);
-			if(it_edge != edge_tree.end())
-				adjacency[(i * 3) + 1] = it_edge->second;
-
-			// edge 3
-			edge.vertex2 = v3;
-			edge.vertex1 = v1;
-
-			// Find the matching adjacent edge
-			it_edge = edge_tree.find(edge);
-			if(it_edge != edge_tree.end())
-				adjacency[(i * 3) + 2] = it_edge->second;
+			} // Next Edge
 
 		} // Next Face
-
-	} // End if prepared
+	});
 
 	// Success!
 	return true;
@@ -2647,41 +3577,83 @@ bool mesh::generate_adjacency(std::vector<std::uint32_t>& adjacency)
 
 bool mesh::weld_vertices(float tolerance, std::vector<std::uint32_t>* vertex_remap_ptr /* = nullptr */)
 {
-	weld_key key;
-	std::map<weld_key, std::uint32_t> vertex_tree;
-	std::map<weld_key, std::uint32_t>::const_iterator it_key;
 	byte_array_t new_vertex_data, new_vertex_flags;
 	std::uint32_t new_vertex_count = 0;
 
 	// Allocate enough space to build the remap array for the existing vertices
 	if(vertex_remap_ptr)
 		vertex_remap_ptr->resize(preparation_data_.vertex_count);
-	auto collapse_map = new std::uint32_t[preparation_data_.vertex_count];
+	std::vector<std::uint32_t> collapse_map(preparation_data_.vertex_count);
 
 	// Retrieve useful data offset information.
 	std::uint16_t vertex_stride = vertex_format_.getStride();
+	const std::uint8_t* src_vertices_ptr = &preparation_data_.vertex_data[0];
+	new_vertex_data.reserve(preparation_data_.vertex_data.size());
+	new_vertex_flags.reserve(preparation_data_.vertex_count);
+
+	// The welded vertices are kept in a grid of cells larger than the tolerance,
+	// so a vertex is only compared with the ones in its cell, or the neighbouring
+	// cells when it is closer to their border than the tolerance. Each cell holds
+	// the last vertex put in it, which links to the previous one.
+	tolerance = std::max(tolerance, 0.0f);
+	const double cell_size = std::max(double(tolerance) * 16.0, 0.000001);
+	std::unordered_map<weld_cell, std::uint32_t, weld_cell_hash> cells;
+	std::vector<std::uint32_t> next_in_cell;
+	cells.reserve(preparation_data_.vertex_count);
+	next_in_cell.reserve(preparation_data_.vertex_count);
+	const auto get_cell = [cell_size](float value) {
+		return std::int64_t(std::floor(double(value) / cell_size));
+	};
 
 	// For each vertex to be welded.
 	for(std::uint32_t i = 0; i < preparation_data_.vertex_count; ++i)
 	{
-		// Build a new key structure for inserting
-		key.vertex = (&preparation_data_.vertex_data[0]) + (i * vertex_stride);
-		key.format = vertex_format_;
-		key.tolerance = tolerance;
+		const std::uint8_t* vertex_ptr = src_vertices_ptr + (i * vertex_stride);
+		const math::vec3 position = get_position(vertex_format_, src_vertices_ptr, i);
+
+		// Does a vertex with matching details already exist in the grid.
+		std::uint32_t match = 0xFFFFFFFF;
+		const math::vec3 low = position - math::vec3(tolerance, tolerance, tolerance);
+		const math::vec3 high = position + math::vec3(tolerance, tolerance, tolerance);
+		const weld_cell first = {get_cell(low.x), get_cell(low.y), get_cell(low.z)};
+		const weld_cell last = {get_cell(high.x), get_cell(high.y), get_cell(high.z)};
+		weld_cell cell;
+		for(cell.x = first.x; match == 0xFFFFFFFF && cell.x <= last.x; ++cell.x)
+		{
+			for(cell.y = first.y; match == 0xFFFFFFFF && cell.y <= last.y; ++cell.y)
+			{
+				for(cell.z = first.z; match == 0xFFFFFFFF && cell.z <= last.z; ++cell.z)
+				{
+					const auto it_cell = cells.find(cell);
+					if(it_cell == cells.end())
+						continue;
+
+					for(auto welded = it_cell->second; welded != 0xFFFFFFFF; welded = next_in_cell[welded])
+					{
+						const auto* welded_ptr = &new_vertex_data[welded * vertex_stride];
+						if(vertices_match(vertex_format_, vertex_ptr, welded_ptr, tolerance))
+						{
+							match = welded;
+							break;
+						}
+					}
+				}
+			}
+		}
 
-		// Does a vertex with matching details already exist in the tree.
-		it_key = vertex_tree.find(key);
-		if(it_key == vertex_tree.end())
+		if(match == 0xFFFFFFFF)
 		{
-			// No matching vertex. Insert into the tree (value = NEW index of vertex).
-			vertex_tree[key] = new_vertex_count;
+			// No matching vertex. Insert into the grid (value = NEW index of vertex).
+			cell = {get_cell(position.x), get_cell(position.y), get_cell(position.z)};
+			auto it_cell = cells.emplace(cell, 0xFFFFFFFF).first;
+			next_in_cell.push_back(it_cell->second);
+			it_cell->second = new_vertex_count;
 			collapse_map[i] = new_vertex_count;
 			if(vertex_remap_ptr)
 				(*vertex_remap_ptr)[i] = new_vertex_count;
 
 			// Store the vertex in the new buffer
-			new_vertex_data.resize((new_vertex_count + 1) * vertex_stride);
-			memcpy(&new_vertex_data[new_vertex_count * vertex_stride], key.vertex, vertex_stride);
+			new_vertex_data.insert(new_vertex_data.end(), vertex_ptr, vertex_ptr + vertex_stride);
 			new_vertex_flags.push_back(preparation_data_.vertex_flags[i]);
 			new_vertex_count++;
 
@@ -2690,7 +3662,7 @@ bool mesh::weld_vertices(float tolerance, std::vector<std::uint32_t>* vertex_rem
 		{
 			// A vertex already existed at this location.
 			// Just mark the 'collapsed' index for this vertex in the remap array.
-			collapse_map[i] = it_key->second;
+			collapse_map[i] = match;
 			if(vertex_remap_ptr)
 				(*vertex_remap_ptr)[i] = 0xFFFFFFFF;
 
@@ -2701,8 +3673,6 @@ bool mesh::weld_vertices(float tolerance, std::vector<std::uint32_t>* vertex_rem
 	// If nothing was welded, just bail
 	if(preparation_data_.vertex_count == new_vertex_count)
 	{
-		checked_array_delete(collapse_map);
-
 		if(vertex_remap_ptr)
 			vertex_remap_ptr->clear();
 		return true;
@@ -2710,26 +3680,21 @@ bool mesh::weld_vertices(float tolerance, std::vector<std::uint32_t>* vertex_rem
 	} // End if nothing to do
 
 	// Otherwise, replace the old preparation vertices and remap
-	preparation_data_.vertex_data.clear();
-	preparation_data_.vertex_data.resize(new_vertex_data.size());
-	memcpy(&preparation_data_.vertex_data[0], &new_vertex_data[0], new_vertex_data.size());
-	preparation_data_.vertex_flags.clear();
-	preparation_data_.vertex_flags.resize(new_vertex_flags.size());
-	memcpy(&preparation_data_.vertex_flags[0], &new_vertex_flags[0], new_vertex_flags.size());
+	preparation_data_.vertex_data = std::move(new_vertex_data);
+	preparation_data_.vertex_flags = std::move(new_vertex_flags);
 	preparation_data_.vertex_count = new_vertex_count;
 
 	// Now remap all the triangle indices
-	for(std::uint32_t i = 0; i < preparation_data_.triangle_count; ++i)
-	{
-		triangle& tri = preparation_data_.triangle_data[i];
-		tri.indices[0] = collapse_map[tri.indices[0]];
-		tri.indices[1] = collapse_map[tri.indices[1]];
-		tri.indices[2] = collapse_map[tri.indices[2]];
-
-	} // Next triangle
+	for_each_range(preparation_data_.triangle_count, [&](std::uint32_t begin, std::uint32_t end) {
+		for(std::uint32_t i = begin; i < end; ++i)
+		{
+			triangle& tri = preparation_data_.triangle_data[i];
+			tri.indices[0] = collapse_map[tri.indices[0]];
+			tri.indices[1] = collapse_map[tri.indices[1]];
+			tri.indices[2] = collapse_map[tri.indices[2]];
 
-	// Clean up
-	checked_array_delete(collapse_map);
+		} // Next triangle
+	});
 
 	// Success!
 	return true;
@@ -2757,11 +3722,18 @@ std::uint32_t mesh::get_vertex_count() const
 
 std::uint8_t* mesh::get_system_vb()
 {
+	// held from now on, the pointer is the caller's to keep
+	if(!acquire_system_copy())
+		return nullptr;
+	residency_ = mesh_residency::keep;
 	return system_vb_;
 }
 
 std::uint32_t* mesh::get_system_ib()
 {
+	if(!acquire_system_copy())
+		return nullptr;
+	residency_ = mesh_residency::keep;
 	return system_ib_;
 }
 
@@ -2770,6 +3742,137 @@ const gfx::vertex_layout& mesh::get_vertex_format() const
 	return vertex_format_;
 }
 
+const math::triangle_bvh& mesh::get_triangle_bvh()
+{
+	if(triangle_bvh_)
+	{
+		return *triangle_bvh_;
+	}
+
+	triangle_bvh_ = std::make_unique<math::triangle_bvh>();
+	if(prepare_status_ != mesh_status::prepared || !acquire_system_copy())
+	{
+		return *triangle_bvh_;
+	}
+
+	std::vector<math::vec3> positions(vertex_count_);
+	for_each_range(vertex_count_, [&](std::uint32_t begin, std::uint32_t end) {
+		for(auto i = begin; i < end; ++i)
+		{
+			positions[i] = get_position(vertex_format_, system_vb_, i);
+		}
+	});
+	triangle_bvh_->build(positions, system_ib_, face_count_);
+	release_system_copy();
+	return *triangle_bvh_;
+}
+
+const mesh::skinning_buffers& mesh::get_skinning_buffers()
+{
+	if(skinning_buffers_)
+	{
+		return *skinning_buffers_;
+	}
+
+	skinning_buffers_ = std::make_unique<skinning_buffers>();
+	if(prepare_status_ != mesh_status::prepared || !skin_bind_data_.has_bones() || !acquire_system_copy())
+	{
+		return *skinning_buffers_;
+	}
+
+	static const gfx::vertex_layout format = []() {
+		gfx::vertex_layout result;
+		result.begin().add(gfx::attribute::TexCoord0, 4, gfx::attribute_type::Float).end();
+		return result;
+	}();
+
+	// the attributes the skinning reads, one float4 each in this order
+	static const gfx::attribute attributes[] = {gfx::attribute::Position,  gfx::attribute::Normal,
+												gfx::attribute::Tangent,   gfx::attribute::Bitangent,
+												gfx::attribute::TexCoord0, gfx::attribute::Weight,
+												gfx::attribute::Indices};
+	constexpr std::uint32_t stride = std::uint32_t(sizeof(attributes) / sizeof(attributes[0]));
+
+	const auto* mem = gfx::alloc(vertex_count_ * stride * format.getStride());
+	auto* values = reinterpret_cast<float*>(mem->data);
+	for_each_range(vertex_count_, [&](std::uint32_t begin, std::uint32_t end) {
+		for(auto i = begin; i < end; ++i)
+		{
+			for(std::uint32_t a = 0; a < stride; ++a)
+			{
+				auto* value = values + (std::size_t(i) * stride + a) * 4;
+				std::fill(value, value + 4, 0.0f);
+				if(vertex_format_.has(attributes[a]))
+				{
+					gfx::vertex_unpack(value, attributes[a], vertex_format_, system_vb_, i);
+				}
+			}
+		}
+	});
+
+	gfx::scoped_memory_category scope(gfx::memory_category::assets);
+	skinning_buffers_->vertices = std::make_shared<gfx::vertex_buffer>(mem, format, BGFX_BUFFER_COMPUTE_READ);
+	const auto* indices = gfx::copy(system_ib_, face_count_ * 3 * std::uint32_t(sizeof(std::uint32_t)));
+	skinning_buffers_->indices = std::make_shared<gfx::index_buffer>(indices, BGFX_BUFFER_INDEX32);
+	release_system_copy();
+	return *skinning_buffers_;
+}
+
+void mesh::set_residency(mesh_residency residency, std::function<std::shared_ptr<mesh>()> source)
+{
+	residency_ = residency;
+	system_source_ = std::move(source);
+	release_system_copy();
+}
+
+void mesh::set_default_residency(mesh_residency residency)
+{
+	get_default_residency_value() = std::uint8_t(residency);
+}
+
+mesh_residency mesh::get_default_residency()
+{
+	return mesh_residency(get_default_residency_value().load());
+}
+
+bool mesh::acquire_system_copy()
+{
+	if(system_vb_ != nullptr && system_ib_ != nullptr)
+	{
+		return true;
+	}
+
+	auto source = system_source_ ? system_source_() : nullptr;
+	if(!source || source->get_status() != mesh_status::prepared || source->vertex_count_ != vertex_count_ ||
+	   source->face_count_ != face_count_ || source->vertex_format_.m_hash != vertex_format_.m_hash ||
+	   source->system_vb_ == nullptr || source->system_ib_ == nullptr)
+	{
+		APPLOG_WARNING("The system memory copy of a mesh could not be prepared again.");
+		return false;
+	}
+
+	// the preparation is the same, so are the vertices and their order
+	std::swap(system_vb_, source->system_vb_);
+	std::swap(system_ib_, source->system_ib_);
+	return true;
+}
+
+void mesh::release_system_copy()
+{
+	// the buffers are drawn from and the source holds what they were built of
+	const auto ib = std::static_pointer_cast<gfx::index_buffer>(hardware_ib_);
+	const bool buffers_built =
+		(arena_allocation_ && arena_allocation_->has_indices()) || (ib && ib->is_valid());
+	if(residency_ != mesh_residency::release || !system_source_ || !hardware_mesh_ || !buffers_built ||
+	   prepare_status_ != mesh_status::prepared)
+	{
+		return;
+	}
+
+	checked_array_delete(system_vb_);
+	checked_array_delete(system_ib_);
+}
+
 const mesh::subset* mesh::get_subset(std::uint32_t data_group_id /* = 0 */) const
 {
 	auto it = subset_lookup_.find(mesh_subset_key(data_group_id));
@@ -2793,6 +3896,16 @@ const std::unique_ptr<mesh::armature_node>& mesh::get_armature() const
 	return root_;
 }
 
+const mesh::cluster_array_t& mesh::get_clusters() const
+{
+	return clusters_;
+}
+
+const runtime::skeleton& mesh::get_skeleton() const
+{
+	return skeleton_;
+}
+
 irect32_t mesh::calculate_screen_rect(const math::transform& world, const camera& cam) const
 {
 
@@ -2824,6 +3937,8 @@ irect32_t mesh::calculate_screen_rect(const math::transform& world, const camera
 ///////////////////////////////////////////////////////////////////////////////
 // skin_bind_data Member Definitions
 ///////////////////////////////////////////////////////////////////////////////
+constexpr std::uint32_t skin_bind_data::vertex_data::max_influences;
+
 void skin_bind_data::add_bone(const bone_influence& bone)
 {
 	bones_.push_back(bone);
@@ -2895,50 +4010,57 @@ void skin_bind_data::build_vertex_table(std::uint32_t vertex_count,
 										const std::vector<std::uint32_t>& vertex_remap,
 										vertex_data_array_t& table)
 {
-	std::uint32_t vertex;
-
 	// Initialize the vertex table with the required number of vertices.
-	table.reserve(vertex_count);
-	for(vertex = 0; vertex < vertex_count; ++vertex)
+	table.resize(vertex_count);
+	for(std::uint32_t vertex = 0; vertex < vertex_count; ++vertex)
 	{
-		vertex_data data;
-		data.palette = -1;
-		data.original_vertex = vertex;
-		table.push_back(data);
+		table[vertex].original_vertex = vertex;
 
 	} // Next Vertex
 
 	// Iterate through all bone information and populate the above array.
 	for(size_t i = 0; i < bones_.size(); ++i)
 	{
-		vertex_influence_array_t& influences = bones_[i].influences;
+		const vertex_influence_array_t& influences = bones_[i].influences;
 		for(size_t j = 0; j < influences.size(); ++j)
 		{
-
 			// Vertex data has been remapped?
+			std::uint32_t vertex = influences[j].vertex_index;
 			if(vertex_remap.size() > 0)
 			{
-				vertex = vertex_remap[influences[j].vertex_index];
+				vertex = vertex_remap[vertex];
 				if(vertex == 0xFFFFFFFF)
 					continue;
-				auto& data = table[vertex];
-				// Push influence data.
-				data.influences.push_back(static_cast<std::int32_t>(i));
-				data.weights.push_back(influences[j].weight);
+
 			} // End if remap
-			else
-			{
-				auto& data = table[influences[j].vertex_index];
-				// Push influence data.
-				data.influences.push_back(static_cast<std::int32_t>(i));
-				data.weights.push_back(influences[j].weight);
-			}
+
+			// Push influence data.
+			table[vertex].add_influence(static_cast<std::int32_t>(i), influences[j].weight);
 
 		} // Next Influence
 
 	} // Next Bone
 }
 
+void skin_bind_data::vertex_data::add_influence(std::int32_t bone, float weight)
+{
+	if(influence_count < max_influences)
+	{
+		influences[influence_count] = bone;
+		weights[influence_count] = weight;
+		influence_count++;
+		return;
+	}
+
+	const auto lightest = std::min_element(std::begin(weights), std::end(weights));
+	if(weight > *lightest)
+	{
+		const auto index = std::distance(std::begin(weights), lightest);
+		influences[index] = bone;
+		weights[index] = weight;
+	}
+}
+
 const std::vector<skin_bind_data::bone_influence>& skin_bind_data::get_bones() const
 {
 	return bones_;
@@ -3040,19 +4162,18 @@ bone_palette::get_skinning_matrices(const std::vector<math::transform>& node_tra
 	return transforms;
 }
 
-void bone_palette::assign_bones(bone_index_map_t& bones, std::vector<std::uint32_t>& faces)
+void bone_palette::assign_bones(const bone_set_t& bones, const std::vector<std::uint32_t>& faces)
 {
-	bone_index_map_t::iterator it_bone, it_bone2;
-
 	// Iterate through newly specified input bones and add any unique ones to the
 	// palette.
-	for(it_bone = bones.begin(); it_bone != bones.end(); ++it_bone)
+	for(const auto bone : bones)
 	{
-		it_bone2 = bones_lut_.find(it_bone->first);
-		if(it_bone2 == bones_lut_.end())
+		auto it_bone = std::lower_bound(std::begin(bones_lut_), std::end(bones_lut_),
+										bone_index_map_t::value_type(bone, 0));
+		if(it_bone == bones_lut_.end() || it_bone->first != bone)
 		{
-			bones_lut_[it_bone->first] = static_cast<std::uint32_t>(bones_.size());
-			bones_.push_back(it_bone->first);
+			bones_lut_.insert(it_bone, {bone, static_cast<std::uint32_t>(bones_.size())});
+			bones_.push_back(bone);
 
 		} // End if not already added
 
@@ -3064,8 +4185,6 @@ void bone_palette::assign_bones(bone_index_map_t& bones, std::vector<std::uint32
 
 void bone_palette::assign_bones(const std::vector<std::uint32_t>& bones)
 {
-	bone_index_map_t::iterator it_bone;
-
 	// Clear out prior data.
 	bones_.clear();
 	bones_lut_.clear();
@@ -3074,10 +4193,11 @@ void bone_palette::assign_bones(const std::vector<std::uint32_t>& bones)
 	// palette.
 	for(size_t i = 0; i < bones.size(); ++i)
 	{
-		it_bone = bones_lut_.find(bones[i]);
-		if(it_bone == bones_lut_.end())
+		auto it_bone = std::lower_bound(std::begin(bones_lut_), std::end(bones_lut_),
+										bone_index_map_t::value_type(bones[i], 0));
+		if(it_bone == bones_lut_.end() || it_bone->first != bones[i])
 		{
-			bones_lut_[bones[i]] = static_cast<std::uint32_t>(bones_.size());
+			bones_lut_.insert(it_bone, {bones[i], static_cast<std::uint32_t>(bones_.size())});
 			bones_.push_back(bones[i]);
 
 		} // End if not already added
@@ -3085,8 +4205,8 @@ void bone_palette::assign_bones(const std::vector<std::uint32_t>& bones)
 	} // Next Bone
 }
 
-void bone_palette::compute_palette_fit(bone_index_map_t& input, std::int32_t& current_space,
-									   std::int32_t& common_bones, std::int32_t& additional_bones)
+void bone_palette::compute_palette_fit(const bone_set_t& input, std::int32_t& current_space,
+									   std::int32_t& common_bones, std::int32_t& additional_bones) const
 {
 	// Reset values
 	current_space = static_cast<std::int32_t>(maximum_size_ - static_cast<std::uint32_t>(bones_.size()));
@@ -3106,13 +4226,15 @@ void bone_palette::compute_palette_fit(bone_index_map_t& input, std::int32_t& cu
 
 	} // End if no bones input
 
-	// Iterate through newly specified input bones and see how many
-	// indices it has in common with our existing set.
-	bone_index_map_t::iterator it_bone, it_bone2;
-	for(it_bone = input.begin(); it_bone != input.end(); ++it_bone)
+	// Both are sorted by bone index, so the indices in common are counted in
+	// one walk over the two.
+	auto it_bone = bones_lut_.begin();
+	for(const auto bone : input)
 	{
-		it_bone2 = bones_lut_.find(it_bone->first);
-		if(it_bone2 != bones_lut_.end())
+		while(it_bone != bones_lut_.end() && it_bone->first < bone)
+			++it_bone;
+
+		if(it_bone != bones_lut_.end() && it_bone->first == bone)
 			common_bones++;
 		else
 			additional_bones++;
@@ -3122,8 +4244,9 @@ void bone_palette::compute_palette_fit(bone_index_map_t& input, std::int32_t& cu
 
 std::uint32_t bone_palette::translate_bone_to_palette(std::uint32_t bone_index) const
 {
-	auto it_bone = bones_lut_.find(bone_index);
-	if(it_bone == bones_lut_.end())
+	auto it_bone = std::lower_bound(std::begin(bones_lut_), std::end(bones_lut_),
+									bone_index_map_t::value_type(bone_index, 0));
+	if(it_bone == bones_lut_.end() || it_bone->first != bone_index)
 		return 0xFFFFFFFF;
 	return it_bone->second;
 }
@@ -3171,46 +4294,11 @@ const std::vector<std::uint32_t>& bone_palette::get_bones() const
 ///////////////////////////////////////////////////////////////////////////////
 // Global Operator Definitions
 ///////////////////////////////////////////////////////////////////////////////
-bool operator<(const mesh::adjacent_edge_key& key1, const mesh::adjacent_edge_key& key2)
-{
-	// Test vertex positions.
-	if(math::epsilonNotEqual(key1.vertex1->x, key2.vertex1->x, math::epsilon<float>()))
-		return (key2.vertex1->x < key1.vertex1->x);
-	if(math::epsilonNotEqual(key1.vertex1->y, key2.vertex1->y, math::epsilon<float>()))
-		return (key2.vertex1->y < key1.vertex1->y);
-	if(math::epsilonNotEqual(key1.vertex1->z, key2.vertex1->z, math::epsilon<float>()))
-		return (key2.vertex1->z < key1.vertex1->z);
-
-	if(math::epsilonNotEqual(key1.vertex2->x, key2.vertex2->x, math::epsilon<float>()))
-		return (key2.vertex2->x < key1.vertex2->x);
-	if(math::epsilonNotEqual(key1.vertex2->y, key2.vertex2->y, math::epsilon<float>()))
-		return (key2.vertex2->y < key1.vertex2->y);
-	if(math::epsilonNotEqual(key1.vertex2->z, key2.vertex2->z, math::epsilon<float>()))
-		return (key2.vertex2->z < key1.vertex2->z);
-
-	// Exactly equal
-	return false;
-}
-
 bool operator<(const mesh::mesh_subset_key& key1, const mesh::mesh_subset_key& key2)
 {
 	return key1.data_group_id < key2.data_group_id;
 }
 
-bool operator<(const mesh::weld_key& key1, const mesh::weld_key& key2)
-{
-	float pos1[4];
-	gfx::vertex_unpack(pos1, gfx::attribute::Position, key1.format, key1.vertex);
-	math::vec3 v1(pos1[0], pos1[1], pos1[2]);
-
-	float pos2[4] = {0};
-	gfx::vertex_unpack(pos1, gfx::attribute::Position, key2.format, key2.vertex);
-	math::vec3 v2(pos2[0], pos2[1], pos2[2]);
-	float tolerance = key1.tolerance * key2.tolerance;
-
-	return math::distance2(v1, v2) > tolerance;
-}
-
 bool operator<(const mesh::bone_combination_key& key1, const mesh::bone_combination_key& key2)
 {
 	// Data group id must match.
@@ -3224,16 +4312,7 @@ bool operator<(const mesh::bone_combination_key& key1, const mesh::bone_combinat
 	if(p1->bones.size() != p2->bones.size())
 		return p1->bones.size() < p2->bones.size();
 
-	// Compare the bone indices in each list
-	auto it_bone1 = p1->bones.begin();
-	auto it_bone2 = p2->bones.begin();
-	for(; it_bone1 != p1->bones.end() && it_bone2 != p2->bones.end(); ++it_bone1, ++it_bone2)
-	{
-		if(it_bone1->first != it_bone2->first)
-			return it_bone1->first < it_bone2->first;
-
-	} // Next Bone
-
-	// Exact match (for the purposes of combining influences)
-	return false;
+	// Compare the bone indices in each list, an exact match is not less (for
+	// the purposes of combining influences)
+	return p1->bones < p2->bones;
 }
@@ -1,16 +1,27 @@
 #pragma once
 
+#include "../animation/skeleton.h"
+
 #include <core/common/basetypes.hpp>
 #include <core/graphics/graphics.h>
 #include <core/math/math_includes.h>
 #include <core/reflection/registration.h>
 #include <core/serialization/serialization.h>
+#include <core/tasks/task_system.h>
 
+#include <functional>
 #include <map>
 #include <memory>
+#include <utility>
 #include <vector>
 
 class camera;
+struct mesh_allocation;
+namespace gfx
+{
+struct index_buffer;
+struct vertex_buffer;
+}
 namespace triangle_flags
 {
 enum e
@@ -27,6 +38,18 @@ enum class mesh_status
 	prepared
 };
 
+/// what a mesh keeps of its vertices and indices in system memory once its
+/// buffers are built
+enum class mesh_residency
+{
+	/// all of them
+	keep,
+	/// none, they are prepared again from the asset when they are needed and
+	/// let go once what is made of them, e.g. the tree for the ray tests, is.
+	/// The default of the loaded meshes.
+	release,
+};
+
 enum class mesh_create_origin
 {
 	bottom,
@@ -83,17 +106,32 @@ public:
 		vertex_influence_array_t influences;
 	};
 	using bone_influence_array_t = std::vector<bone_influence>;
-	// Contains per-vertex influence and weight information.
+	// Contains per-vertex influence and weight information, inline so a table
+	// of them is a single allocation.
 	struct vertex_data
 	{
+		/// The most influences kept for a vertex, the heaviest ones.
+		static constexpr std::uint32_t max_influences = 8;
+
+		//-----------------------------------------------------------------------------
+		//  Name : add_influence()
+		/// <summary>
+		/// Adds the influence of a bone, in place of the lightest one when
+		/// there are already as many as can be kept and it is heavier.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void add_influence(std::int32_t bone, float weight);
+
 		/// List of bones that influence this vertex.
-		std::vector<std::int32_t> influences;
+		std::int32_t influences[max_influences] = {};
 		/// List of weights that describe how this vertex is influenced.
-		std::vector<float> weights;
+		float weights[max_influences] = {};
+		/// The number of influences and weights.
+		std::uint32_t influence_count = 0;
 		/// Index of the palette to which this vertex has been assigned.
-		std::int32_t palette;
+		std::int32_t palette = -1;
 		/// The index of the original vertex stored in the mesh.
-		std::uint32_t original_vertex;
+		std::uint32_t original_vertex = 0;
 	};
 	using vertex_data_array_t = std::vector<vertex_data>;
 	//-------------------------------------------------------------------------
@@ -207,7 +245,10 @@ public:
 	//-------------------------------------------------------------------------
 	// Public Typedefs, Structures & Enumerations
 	//-------------------------------------------------------------------------
-	using bone_index_map_t = std::map<std::uint32_t, std::uint32_t>;
+	/// Bone indices, sorted and unique.
+	using bone_set_t = std::vector<std::uint32_t>;
+	/// The index in the palette of every bone in it, sorted by bone index.
+	using bone_index_map_t = std::vector<std::pair<std::uint32_t, std::uint32_t>>;
 	//-------------------------------------------------------------------------
 	// Constructors & Destructors
 	//-------------------------------------------------------------------------
@@ -237,8 +278,8 @@ public:
 	/// this palette.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	void compute_palette_fit(bone_index_map_t& input, std::int32_t& current_space, std::int32_t& common_base,
-							 std::int32_t& additional_bones);
+	void compute_palette_fit(const bone_set_t& input, std::int32_t& current_space, std::int32_t& common_base,
+							 std::int32_t& additional_bones) const;
 
 	//-----------------------------------------------------------------------------
 	//  Name : assign_bones()
@@ -246,7 +287,7 @@ public:
 	/// Assign the specified bones (and faces) to this bone palette.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	void assign_bones(bone_index_map_t& bones, std::vector<std::uint32_t>& faces);
+	void assign_bones(const bone_set_t& bones, const std::vector<std::uint32_t>& faces);
 
 	//-----------------------------------------------------------------------------
 	//  Name : assign_bones()
@@ -400,6 +441,41 @@ public:
 
 	using triangle_array_t = std::vector<triangle>;
 	using subset_array_t = std::vector<subset*>;
+
+	/// the vertices of a skin as the compute skinning reads them, seven
+	/// float4 each, and the indices of the mesh local to its vertices
+	struct skinning_buffers
+	{
+		std::shared_ptr<gfx::vertex_buffer> vertices;
+		std::shared_ptr<gfx::index_buffer> indices;
+	};
+
+	/// a run of at most a few dozen triangles of a data group, with the bounds
+	/// to cull it on its own
+	struct cluster
+	{
+		std::uint32_t data_group_id = 0;
+		/// the faces in the index buffer, or in the triangles of the load data
+		/// before the mesh is prepared
+		std::uint32_t face_start = 0;
+		std::uint32_t face_count = 0;
+		/// the bounding sphere
+		math::vec3 center = {0.0f, 0.0f, 0.0f};
+		float radius = 0.0f;
+		/// the cone of the normals of the faces, a cutoff of 1 culls nothing
+		math::vec3 cone_axis = {0.0f, 0.0f, 1.0f};
+		float cone_cutoff = 1.0f;
+
+		//-----------------------------------------------------------------------------
+		//  Name : faces_away ()
+		/// <summary>
+		/// Every face of the cluster faces away from the eye, both in the space
+		/// of the mesh.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		bool faces_away(const math::vec3& eye) const;
+	};
+	using cluster_array_t = std::vector<cluster>;
 	using bone_palette_array_t = std::vector<bone_palette>;
 
 	struct armature_node
@@ -428,6 +504,10 @@ public:
 		skin_bind_data skin_data;
 		/// Imported nodes
 		std::unique_ptr<armature_node> root_node = nullptr;
+		/// Clusters of the triangles, in their order
+		cluster_array_t clusters;
+		/// Simplified levels of detail compiled next to this mesh
+		std::uint32_t lod_count = 0;
 	};
 
 	//-------------------------------------------------------------------------
@@ -460,10 +540,11 @@ public:
 	//  Name : draw_subset ()
 	/// <summary>
 	/// Draw an individual subset of the mesh based on the material AND
-	/// data group specified.
+	/// data group specified. The passes whose programs read only the
+	/// positions, i.e. the depth ones, bind the stream of the positions alone.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	void bind_render_buffers_for_subset(std::uint32_t data_group_id);
+	void bind_render_buffers_for_subset(std::uint32_t data_group_id, bool positions_only = false);
 
 	// mesh creation methods
 	//-----------------------------------------------------------------------------
@@ -522,6 +603,42 @@ public:
 	//-----------------------------------------------------------------------------
 	bool bind_armature(std::unique_ptr<armature_node>& root);
 
+	//-----------------------------------------------------------------------------
+	//  Name : bind_clusters ()
+	/// <summary>
+	/// Bind the clusters of the triangles added, built with build_clusters.
+	/// They are kept when the preparation keeps the order of the triangles of
+	/// every data group: all triangles were added, there is no skin and the
+	/// mesh is not optimized.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool bind_clusters(const cluster_array_t& clusters);
+
+	//-----------------------------------------------------------------------------
+	//  Name : build_clusters () (Static)
+	/// <summary>
+	/// Splits the triangles of every data group in runs, from the first to the
+	/// last, of at most the faces and the distinct vertices, and computes the
+	/// bounds of each.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void build_clusters(load_data& data, std::uint32_t max_faces = 124,
+							   std::uint32_t max_vertices = 64);
+
+	//-----------------------------------------------------------------------------
+	//  Name : simplify () (Static)
+	/// <summary>
+	/// Collapses the edges of the triangles by the least quadric error until
+	/// there are at most the target faces or no collapse is under the error,
+	/// a fraction of the size of the mesh. A vertex only collapses onto a
+	/// neighbour influenced by the same bones, and those sharing a position
+	/// with another vertex, at a seam of the attributes or a border of a
+	/// data group, and on an open border stay. The vertices no longer used
+	/// are removed. Returns the faces left.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static std::uint32_t simplify(load_data& data, std::uint32_t target_faces, float max_error = 0.05f);
+
 	//-----------------------------------------------------------------------------
 	//  Name : set_material_count ()
 	/// <summary>
@@ -628,6 +745,16 @@ public:
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	bool create_icosphere(const gfx::vertex_layout& format, int tesselation_level, bool hardware_copy = true);
+
+	//-----------------------------------------------------------------------------
+	//  Name : create_async () (Static)
+	/// <summary>
+	/// Creates a mesh with the function on a worker, e.g. one of the create
+	/// methods without a hardware copy, and builds its buffers on the owner
+	/// thread after. The mesh is null when the function fails.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static core::task_future<std::shared_ptr<mesh>> create_async(std::function<bool(mesh&)> create);
 	//-----------------------------------------------------------------------------
 	//  Name : end_prepare ()
 	/// <summary>
@@ -641,9 +768,8 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : build_vb ()
 	/// <summary>
-	/// Builds internal vertex buffer
-	///
-	///
+	/// Builds internal vertex buffer, or copies the vertices to the mesh
+	/// arena when there is one. The index buffer has to be built again after.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void build_vb(bool hardware_copy = true);
@@ -671,6 +797,20 @@ public:
 	//-----------------------------------------------------------------------------
 	bool generate_adjacency(std::vector<std::uint32_t>& adjacency);
 
+	//-----------------------------------------------------------------------------
+	//  Name : optimize_overdraw () (Static)
+	/// <summary>
+	/// Reorders triangles already ordered for the vertex cache so that the ones
+	/// likely to occlude the others are drawn first. They are split in clusters
+	/// where the simulated cache restarts, or where a cluster stays within the
+	/// threshold of the misses of the original order, and the clusters facing
+	/// away from the centre of the triangles go first.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void optimize_overdraw(std::uint32_t* indices, std::uint32_t face_count,
+								  const std::uint8_t* vertices, const gfx::vertex_layout& format,
+								  float threshold = 1.05f);
+
 	// Object access methods
 
 	//-----------------------------------------------------------------------------
@@ -698,7 +838,8 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : get_system_vb ()
 	/// <summary>
-	/// Retrieve the underlying vertex data from the mesh.
+	/// Retrieve the underlying vertex data from the mesh, prepared again from
+	/// its source and held from then on if it was let go. Null when it cannot.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	std::uint8_t* get_system_vb();
@@ -706,7 +847,7 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : get_system_ib ()
 	/// <summary>
-	/// Retrieve the underlying index data from the mesh.
+	/// Retrieve the underlying index data from the mesh, as get_system_vb.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	std::uint32_t* get_system_ib();
@@ -719,6 +860,61 @@ public:
 	//-----------------------------------------------------------------------------
 	const gfx::vertex_layout& get_vertex_format() const;
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_triangle_bvh ()
+	/// <summary>
+	/// The bounding volume hierarchy of the triangles of the prepared mesh, in
+	/// object space and the bind pose of a skin. Built from the system memory
+	/// copy the first time it is asked for and kept until the mesh is disposed;
+	/// to be called from the thread which owns the mesh.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const math::triangle_bvh& get_triangle_bvh();
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_residency ()
+	/// <summary>
+	/// What the prepared mesh keeps of its system memory copy, applied once
+	/// its buffers are built. The source returns the mesh prepared again from
+	/// the same data, the copy is taken from it when one is needed after it
+	/// was let go. Only the meshes with hardware buffers let it go.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_residency(mesh_residency residency, std::function<std::shared_ptr<mesh>()> source);
+
+	inline mesh_residency get_residency() const
+	{
+		return residency_;
+	}
+
+	/// whether the system memory copy is held now
+	inline bool has_system_copy() const
+	{
+		return system_vb_ != nullptr;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_default_residency () (Static)
+	/// <summary>
+	/// The residency the loaded meshes are given. Safe to call from any
+	/// thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void set_default_residency(mesh_residency residency);
+
+	static mesh_residency get_default_residency();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_skinning_buffers ()
+	/// <summary>
+	/// The buffers the vertices of the prepared skin are skinned from by
+	/// compute and drawn with once skinned. Built from the system memory copy
+	/// the first time they are asked for, empty when the mesh is no skin; to
+	/// be called from the thread which owns the mesh.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const skinning_buffers& get_skinning_buffers();
+
 	//-----------------------------------------------------------------------------
 	//  Name : get_skin_bind_data ()
 	/// <summary>
@@ -738,6 +934,23 @@ public:
 	const bone_palette_array_t& get_bone_palettes() const;
 
 	const std::unique_ptr<armature_node>& get_armature() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_skeleton ()
+	/// <summary>
+	/// The armature as flat arrays with the nodes of the bones of the skin,
+	/// built when the armature is bound after the skin.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const runtime::skeleton& get_skeleton() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_clusters ()
+	/// <summary>
+	/// The clusters of the faces of the prepared mesh, empty when it has none.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const cluster_array_t& get_clusters() const;
 	irect32_t calculate_screen_rect(const math::transform& world, const camera& cam) const;
 	//-----------------------------------------------------------------------------
 	//  Name : get_subset ()
@@ -784,6 +997,23 @@ public:
 		return mesh_subsets_.size();
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_lod_count ()
+	/// <summary>
+	/// The simplified levels of detail compiled next to this mesh, their keys
+	/// are its key with _lod and their level appended.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline std::uint32_t get_lod_count() const
+	{
+		return lod_count_;
+	}
+
+	inline void set_lod_count(std::uint32_t count)
+	{
+		lod_count_ = count;
+	}
+
 	//-------------------------------------------------------------------------
 	// Protected Structures, Typedefs and Enumerations
 	//-------------------------------------------------------------------------
@@ -833,6 +1063,8 @@ public:
 		/// Vertex barycentric should be computed (at least for any vertices where
 		/// none were supplied).
 		bool compute_barycentric = false;
+		/// The clusters of the triangles in the order they were added.
+		cluster_array_t clusters;
 
 	}; // End Struct preparation_data
 protected:
@@ -860,15 +1092,6 @@ protected:
 
 	}; // End Struct optimizer_triangle_info
 
-	struct adjacent_edge_key
-	{
-		/// Pointer to the first vertex in the edge
-		const math::vec3* vertex1 = nullptr;
-		/// Pointer to the second vertex in the edge
-		const math::vec3* vertex2 = nullptr;
-
-	}; // End Struct adjacent_edge_key
-
 	struct mesh_subset_key
 	{
 		/// The data group identifier for this subset.
@@ -887,23 +1110,9 @@ protected:
 	using subset_key_map_t = std::map<mesh_subset_key, subset*>;
 	using subset_key_array_t = std::vector<mesh_subset_key>;
 
-	// Simple structure to allow us to leverage the hierarchical properties of a
-	// map
-	// to accelerate the weld operation.
-	struct weld_key
-	{
-		// Pointer to the vertex for easy access.
-		std::uint8_t* vertex;
-		// Format of the above vertex for easy access.
-		gfx::vertex_layout format;
-		// The tolerance we're using to weld (transport only, these should be the
-		// same for every key).
-		float tolerance;
-	};
-
 	struct face_influences
 	{
-		bone_palette::bone_index_map_t bones; // List of unique bones that influence a given number of faces.
+		bone_palette::bone_set_t bones; // List of unique bones that influence a given number of faces.
 	};
 
 	// Simple structure to allow us to leverage the hierarchical properties of a
@@ -925,9 +1134,7 @@ protected:
 	//-------------------------------------------------------------------------
 	// Friend List
 	//-------------------------------------------------------------------------
-	friend bool operator<(const adjacent_edge_key& key1, const adjacent_edge_key& key2);
 	friend bool operator<(const mesh_subset_key& key1, const mesh_subset_key& key2);
-	friend bool operator<(const weld_key& key1, const weld_key& key2);
 	friend bool operator<(const bone_combination_key& key1, const bone_combination_key& key2);
 	//-------------------------------------------------------------------------
 	// Protected Methods
@@ -973,11 +1180,21 @@ protected:
 	//-----------------------------------------------------------------------------
 	//  Name : weld_vertices ()
 	/// <summary>
-	/// Weld all of the vertices together that can be combined.
+	/// Weld all of the vertices together that can be combined, those with every
+	/// component of every attribute within the tolerance.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	bool weld_vertices(float tolerance = 0.000001f, std::vector<std::uint32_t>* vertexRemap = nullptr);
 
+	//-----------------------------------------------------------------------------
+	//  Name : optimize_vertex_fetch () (Protected)
+	/// <summary>
+	/// Reorders the prepared vertices in the order the final index buffer first
+	/// references them, so that drawing reads the vertex buffer forward.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void optimize_vertex_fetch();
+
 	//-----------------------------------------------------------------------------
 	// Name : sort_mesh_data() (Protected)
 	/// <summary>
@@ -986,6 +1203,23 @@ protected:
 	//-----------------------------------------------------------------------------
 	bool sort_mesh_data(bool optimize, bool hardware_copy, bool build_buffer);
 
+	//-----------------------------------------------------------------------------
+	//  Name : acquire_system_copy () (Private)
+	/// <summary>
+	/// Takes the system memory copy from the mesh the source prepares if it
+	/// was let go. False when there is none after.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool acquire_system_copy();
+
+	//-----------------------------------------------------------------------------
+	//  Name : release_system_copy () (Private)
+	/// <summary>
+	/// Lets go of the system memory copy if the residency allows it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void release_system_copy();
+
 	//-----------------------------------------------------------------------------
 	//  Name : bind_mesh_data () (Private)
 	/// <summary>
@@ -994,7 +1228,7 @@ protected:
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void bind_mesh_data(std::uint32_t face_start, std::uint32_t face_count, std::uint32_t vertex_start,
-						std::uint32_t vertex_count);
+						std::uint32_t vertex_count, bool positions_only);
 
 	//-------------------------------------------------------------------------
 	// Protected Static Functions
@@ -1057,8 +1291,14 @@ protected:
 	/// buffer resource
 	std::shared_ptr<void> hardware_vb_;
 	/// After constructing the mesh, this will contain the actual hardware index
-	/// buffer resource
+	/// buffer resource, of 16 bit indices when the vertices are few enough
 	std::shared_ptr<void> hardware_ib_;
+	/// The positions alone, for the depth passes. Null when the vertices
+	/// hold nothing else.
+	std::shared_ptr<void> hardware_position_vb_;
+	/// The ranges of the mesh arena taken instead of the hardware buffers,
+	/// when the mesh_arena subsystem exists.
+	std::shared_ptr<mesh_allocation> arena_allocation_;
 
 	// mesh data look up tables
 	/// The actual list of subsets maintained by this mesh.
@@ -1081,6 +1321,14 @@ protected:
 	std::uint32_t face_count_ = 0;
 	/// Total number of vertices in the prepared mesh.
 	std::uint32_t vertex_count_ = 0;
+	/// The triangles for the ray tests, built when they are first needed.
+	std::unique_ptr<math::triangle_bvh> triangle_bvh_;
+	/// The skin for the compute skinning, built when it is first needed.
+	std::unique_ptr<skinning_buffers> skinning_buffers_;
+	/// What is kept of the system memory copy once the buffers are built.
+	mesh_residency residency_ = mesh_residency::keep;
+	/// Prepares the mesh again for the copy once it was let go.
+	std::function<std::shared_ptr<mesh>()> system_source_;
 
 	// mesh data preparation
 	/// Preparation status of the mesh (i.e. has it been constructed yet).
@@ -1096,4 +1344,10 @@ protected:
 	bone_palette_array_t bone_palettes_;
 	/// List of each of armature nodes
 	std::unique_ptr<armature_node> root_ = nullptr;
+	/// The armature nodes as flat arrays
+	runtime::skeleton skeleton_;
+	/// The clusters of the faces in the index buffer
+	cluster_array_t clusters_;
+	/// The levels of detail compiled next to this mesh
+	std::uint32_t lod_count_ = 0;
 };
@@ -0,0 +1,248 @@
+#include "mesh_arena.h"
+
+#include <core/graphics/destroy_queue.h>
+#include <core/graphics/gpu_memory.h>
+
+#include <algorithm>
+#include <iterator>
+
+struct mesh_allocation::page
+{
+	~page()
+	{
+		if(memory_size != 0)
+		{
+			gfx::gpu_memory::remove(gfx::memory_category::assets, memory_size);
+		}
+		if(bgfx::isValid(vertex_buffer))
+		{
+			gfx::destroy_queue::push(vertex_buffer);
+		}
+		if(bgfx::isValid(index_buffer))
+		{
+			gfx::destroy_queue::push(index_buffer);
+		}
+	}
+
+	// first fit, the free ranges are few and long
+	bool allocate(std::uint32_t count, std::uint32_t& start)
+	{
+		for(auto it = free_ranges.begin(); it != free_ranges.end(); ++it)
+		{
+			if(it->second < count)
+			{
+				continue;
+			}
+
+			start = it->first;
+			const auto left = it->second - count;
+			free_ranges.erase(it);
+			if(left > 0)
+			{
+				free_ranges.emplace(start + count, left);
+			}
+			used += count;
+			return true;
+		}
+		return false;
+	}
+
+	// merged with the free ranges around it
+	void free(std::uint32_t start, std::uint32_t count)
+	{
+		if(count == 0)
+		{
+			return;
+		}
+
+		used -= count;
+		auto next = free_ranges.lower_bound(start);
+		if(next != free_ranges.end() && start + count == next->first)
+		{
+			count += next->second;
+			next = free_ranges.erase(next);
+		}
+
+		if(next != free_ranges.begin())
+		{
+			auto prev = std::prev(next);
+			if(prev->first + prev->second == start)
+			{
+				prev->second += count;
+				return;
+			}
+		}
+		free_ranges.emplace(start, count);
+	}
+
+	gfx::dynamic_vertex_buffer_handle vertex_buffer = BGFX_INVALID_HANDLE;
+	gfx::dynamic_index_buffer_handle index_buffer = BGFX_INVALID_HANDLE;
+	std::uint32_t capacity = 0;
+	std::uint32_t used = 0;
+	std::uint64_t memory_size = 0;
+	/// start to count
+	std::map<std::uint32_t, std::uint32_t> free_ranges;
+};
+
+mesh_allocation::~mesh_allocation()
+{
+	if(vertices)
+	{
+		vertices->free(vertex_start, vertex_count);
+	}
+	if(indices)
+	{
+		indices->free(index_start, index_count);
+	}
+}
+
+gfx::dynamic_vertex_buffer_handle mesh_allocation::get_vertex_buffer() const
+{
+	return vertices->vertex_buffer;
+}
+
+gfx::dynamic_index_buffer_handle mesh_allocation::get_index_buffer() const
+{
+	return indices->index_buffer;
+}
+
+std::uint32_t mesh_allocation::get_page_vertices() const
+{
+	return vertices->capacity;
+}
+
+mesh_arena::mesh_arena(std::uint32_t page_vertices, std::uint32_t page_indices)
+	: page_vertices_(std::max<std::uint32_t>(page_vertices, 1))
+	, page_indices_(std::max<std::uint32_t>(page_indices, 1))
+{
+}
+
+std::shared_ptr<mesh_allocation::page>
+mesh_arena::find_page(page_list& pages, std::uint32_t count, std::uint32_t& start,
+					  const gfx::vertex_layout* layout)
+{
+	for(const auto& p : pages)
+	{
+		if(p->allocate(count, start))
+		{
+			return p;
+		}
+	}
+
+	auto p = std::make_shared<mesh_allocation::page>();
+	p->capacity = std::max(count, layout ? page_vertices_ : page_indices_);
+	if(layout)
+	{
+		p->vertex_buffer = gfx::create_dynamic_vertex_buffer(p->capacity, *layout);
+		if(!bgfx::isValid(p->vertex_buffer))
+		{
+			return nullptr;
+		}
+	}
+	else
+	{
+		p->index_buffer = gfx::create_dynamic_index_buffer(p->capacity, BGFX_BUFFER_INDEX32);
+		if(!bgfx::isValid(p->index_buffer))
+		{
+			return nullptr;
+		}
+	}
+
+	// the pages are counted with the meshes, in the assets
+	const std::uint32_t stride = layout ? layout->getStride() : sizeof(std::uint32_t);
+	p->memory_size = std::uint64_t(p->capacity) * stride;
+	gfx::gpu_memory::add(gfx::memory_category::assets, p->memory_size);
+
+	p->free_ranges.emplace(0, p->capacity);
+	p->allocate(count, start);
+	pages.push_back(p);
+	return p;
+}
+
+std::shared_ptr<mesh_allocation> mesh_arena::allocate(const gfx::vertex_layout& layout, const void* vertices,
+													  std::uint32_t vertex_count)
+{
+	if(!vertices || vertex_count == 0)
+	{
+		return nullptr;
+	}
+
+	auto allocation = std::make_shared<mesh_allocation>();
+	auto& pages = vertex_pages_[layout.m_hash];
+	allocation->vertices = find_page(pages, vertex_count, allocation->vertex_start, &layout);
+	if(!allocation->vertices)
+	{
+		return nullptr;
+	}
+	allocation->vertex_count = vertex_count;
+
+	const auto size = vertex_count * layout.getStride();
+	gfx::update(allocation->vertices->vertex_buffer, allocation->vertex_start, gfx::copy(vertices, size));
+	return allocation;
+}
+
+bool mesh_arena::allocate_indices(mesh_allocation& allocation, const std::uint32_t* indices,
+								  std::uint32_t index_count)
+{
+	if(allocation.indices)
+	{
+		allocation.indices->free(allocation.index_start, allocation.index_count);
+		allocation.indices.reset();
+		allocation.index_count = 0;
+	}
+
+	if(!indices || index_count == 0)
+	{
+		return false;
+	}
+
+	allocation.indices = find_page(index_pages_, index_count, allocation.index_start, nullptr);
+	if(!allocation.indices)
+	{
+		return false;
+	}
+	allocation.index_count = index_count;
+
+	const auto size = index_count * std::uint32_t(sizeof(std::uint32_t));
+	const auto mem = gfx::alloc(size);
+	auto dst = reinterpret_cast<std::uint32_t*>(mem->data);
+	for(std::uint32_t i = 0; i < index_count; ++i)
+	{
+		dst[i] = indices[i] + allocation.vertex_start;
+	}
+	gfx::update(allocation.indices->index_buffer, allocation.index_start, mem);
+	return true;
+}
+
+std::size_t mesh_arena::get_pages_count() const
+{
+	std::size_t count = index_pages_.size();
+	for(const auto& pair : vertex_pages_)
+	{
+		count += pair.second.size();
+	}
+	return count;
+}
+
+std::uint64_t mesh_arena::get_used_vertices() const
+{
+	std::uint64_t used = 0;
+	for(const auto& pair : vertex_pages_)
+	{
+		for(const auto& p : pair.second)
+		{
+			used += p->used;
+		}
+	}
+	return used;
+}
+
+std::uint64_t mesh_arena::get_used_indices() const
+{
+	std::uint64_t used = 0;
+	for(const auto& p : index_pages_)
+	{
+		used += p->used;
+	}
+	return used;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <core/graphics/graphics.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+/*
+ * mesh_arena; big vertex buffers, one set per vertex layout, and index
+ * buffers the meshes take ranges of instead of creating their own buffers.
+ *
+ *      The indices of a mesh are offset by where its vertices start in the
+ *      page, so every mesh of a page draws with the same vertex and index
+ *      buffer bound from the start of the page and only the index range
+ *      changes between them, bgfx keeps the buffers bound across the draws.
+ *      A mesh bigger than a page gets a page of its own. The ranges are
+ *      given back when the allocation is destroyed, the pages live as long
+ *      as an allocation or the arena holds them.
+ */
+struct mesh_allocation
+{
+	struct page;
+
+	~mesh_allocation();
+
+	bool has_indices() const
+	{
+		return indices != nullptr;
+	}
+
+	gfx::dynamic_vertex_buffer_handle get_vertex_buffer() const;
+	gfx::dynamic_index_buffer_handle get_index_buffer() const;
+	/// vertices of the page, bound whole
+	std::uint32_t get_page_vertices() const;
+
+	std::shared_ptr<page> vertices;
+	std::shared_ptr<page> indices;
+	std::uint32_t vertex_start = 0;
+	std::uint32_t vertex_count = 0;
+	std::uint32_t index_start = 0;
+	std::uint32_t index_count = 0;
+};
+
+class mesh_arena
+{
+public:
+	mesh_arena(std::uint32_t page_vertices = 1 << 20, std::uint32_t page_indices = 1 << 22);
+
+	//-----------------------------------------------------------------------------
+	//  Name : allocate ()
+	/// <summary>
+	/// Copies the vertices to a page of their layout, null if no page could
+	/// be created.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<mesh_allocation> allocate(const gfx::vertex_layout& layout, const void* vertices,
+											  std::uint32_t vertex_count);
+
+	//-----------------------------------------------------------------------------
+	//  Name : allocate_indices ()
+	/// <summary>
+	/// Copies the indices of the vertices of the allocation, offset by their
+	/// start in the page. Frees the indices it had before.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool allocate_indices(mesh_allocation& allocation, const std::uint32_t* indices,
+						  std::uint32_t index_count);
+
+	std::size_t get_pages_count() const;
+
+	/// vertices and indices taken from the pages
+	std::uint64_t get_used_vertices() const;
+	std::uint64_t get_used_indices() const;
+
+private:
+	using page_list = std::vector<std::shared_ptr<mesh_allocation::page>>;
+
+	/// a range of count in the pages or a new page, of vertices of the layout
+	/// or of indices without one
+	std::shared_ptr<mesh_allocation::page> find_page(page_list& pages, std::uint32_t count,
+													 std::uint32_t& start, const gfx::vertex_layout* layout);
+
+	std::uint32_t page_vertices_ = 0;
+	std::uint32_t page_indices_ = 0;
+	/// vertex pages by the hash of their layout
+	std::map<std::uint32_t, page_list> vertex_pages_;
+	page_list index_pages_;
+};
@@ -2,6 +2,7 @@
 #include "gpu_program.h"
 #include "material.h"
 #include "mesh.h"
+#include "renderer.h"
 
 #include "../assets/asset_manager.h"
 
@@ -52,6 +53,19 @@ asset_handle<mesh> model::get_lod(std::uint32_t lod) const
 
 void model::set_lod(asset_handle<mesh> mesh, std::uint32_t lod)
 {
+	// the simplified levels of detail compiled with a mesh come with it
+	if(lod == 0 && mesh && mesh->get_lod_count() > 0)
+	{
+		auto& am = core::get_subsystem<runtime::asset_manager>();
+		std::vector<asset_handle<::mesh>> lods = {mesh};
+		for(std::uint32_t i = 1; i <= mesh->get_lod_count(); ++i)
+		{
+			lods.push_back(am.load<::mesh>(mesh.id() + "_lod" + std::to_string(i)).get());
+		}
+		set_lods(lods);
+		return;
+	}
+
 	if(lod >= mesh_lods_.size())
 	{
 		mesh_lods_.resize(lod + 1);
@@ -133,7 +147,7 @@ void model::set_lod_limits(const std::vector<urange32_t>& limits)
 void model::render(gfx::view_id id, const math::transform& world_transform,
 				   const std::vector<math::transform>& bone_transforms, bool apply_cull, bool depth_write,
 				   bool depth_test, std::uint64_t extra_states, unsigned int lod, gpu_program* user_program,
-				   std::function<void(gpu_program&)> setup_params) const
+				   std::function<void(gpu_program&)> setup_params, bool positions_only) const
 {
 	const auto mesh = get_lod(lod);
 	if(!mesh)
@@ -141,19 +155,20 @@ void model::render(gfx::view_id id, const math::transform& world_transform,
 		return;
 	}
 
-	auto render_subset = [this, &mesh](gfx::view_id id, bool skinned, std::uint32_t group_id,
-									   const std::vector<math::transform>& matrices, bool apply_cull,
-									   bool depth_write, bool depth_test, std::uint64_t extra_states,
-									   gpu_program* user_program,
-									   std::function<void(gpu_program&)> setup_params) {
+	auto render_subset = [this, &mesh, &world_transform, positions_only](
+		gfx::view_id id, bool skinned, std::uint32_t group_id, skinning_cache::entry skin, bool apply_cull,
+		bool depth_write, bool depth_test, std::uint64_t extra_states, gpu_program* user_program,
+		std::function<void(gpu_program&)> setup_params) {
 
 		bool valid_program = false;
 		gpu_program* program = user_program;
 		asset_handle<material> mat = get_material_for_group(group_id);
 
+		// the vertices skinned by compute are drawn as those of the others
+		const bool computed = skinned && skin.is_computed();
 		if(mat)
 		{
-			mat->skinned = skinned;
+			mat->skinned = skinned && !computed;
 			if(user_program == nullptr)
 			{
 				program = mat->get_program();
@@ -181,21 +196,26 @@ void model::render(gfx::view_id id, const math::transform& world_transform,
 				extra_states |= mat->get_render_states(apply_cull, depth_write, depth_test);
 			}
 
-			if(!matrices.empty())
+			gfx::set_state(extra_states);
+
+			if(computed)
+			{
+				skinning_cache::bind(*mesh.get(), group_id, skin);
+			}
+			else
 			{
-				using mat_type = math::transform::mat4_t;
-				std::vector<mat_type> mats;
-				mats.reserve(matrices.size());
-				for(const auto& m : matrices)
+				if(skinned)
 				{
-					mats.emplace_back(m.get_matrix());
+					gfx::set_transform(skin.cache, skin.count);
+				}
+				else
+				{
+					gfx::set_transform(&world_transform.get_matrix());
 				}
-				gfx::set_transform(mats.data(), static_cast<std::uint16_t>(mats.size()));
-			}
-
-			gfx::set_state(extra_states);
 
-			mesh->bind_render_buffers_for_subset(group_id);
+				// the skinned ones need their bones
+				mesh->bind_render_buffers_for_subset(group_id, positions_only && !skinned);
+			}
 
 			gfx::submit(id, program->native_handle());
 		}
@@ -213,16 +233,20 @@ void model::render(gfx::view_id id, const math::transform& world_transform,
 	if(skin_data.has_bones() && !bone_transforms.empty())
 	{
 		// Process each palette in the skin with a matching attribute.
+		auto& cache = core::get_subsystem<runtime::renderer>().get_skinning_cache();
 		const auto& palettes = mesh->get_bone_palettes();
-		for(const auto& palette : palettes)
+		for(std::size_t i = 0; i < palettes.size(); ++i)
 		{
-			// Apply the bone palette.
-			auto skinning_matrices = palette.get_skinning_matrices(bone_transforms, skin_data, false);
-			// auto max_blend_index = palette.get_maximum_blend_index();
+			// Apply the bone palette, computed once in the frame.
+			const auto skin = cache.get(*mesh.get(), i, bone_transforms);
+			if(skin.count == 0)
+			{
+				continue;
+			}
 
-			auto data_group = palette.get_data_group();
-			render_subset(id, true, data_group, skinning_matrices, apply_cull, depth_write, depth_test,
-						  extra_states, user_program, setup_params);
+			auto data_group = palettes[i].get_data_group();
+			render_subset(id, true, data_group, skin, apply_cull, depth_write, depth_test, extra_states,
+						  user_program, setup_params);
 
 		} // Next Palette
 	}
@@ -230,8 +254,8 @@ void model::render(gfx::view_id id, const math::transform& world_transform,
 	{
 		for(std::size_t i = 0; i < mesh->get_subset_count(); ++i)
 		{
-			render_subset(id, false, std::uint32_t(i), {world_transform}, apply_cull, depth_write, depth_test,
-						  extra_states, user_program, setup_params);
+			render_subset(id, false, std::uint32_t(i), {}, apply_cull, depth_write, depth_test, extra_states,
+						  user_program, setup_params);
 		}
 	}
 }
@@ -70,9 +70,9 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : set_lod ()
 	/// <summary>
-	///
-	///
-	///
+	/// Sets the mesh of a level of detail. A first level compiled with
+	/// simplified levels of detail replaces all levels with them, and their
+	/// limits are recalculated when their count changes.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void set_lod(asset_handle<mesh> mesh, std::uint32_t lod);
@@ -180,13 +180,14 @@ public:
 	/// <summary>
 	/// Draws a mesh with a given program. If program is nullptr then the
 	/// materials are used instead. Extra states can be added to the material
-	/// ones.
+	/// ones. A program reading only the positions has the meshes that are not
+	/// skinned bind the positions alone, e.g. in the depth passes.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void render(gfx::view_id id, const math::transform& world_transform,
 				const std::vector<math::transform>& bone_transforms, bool apply_cull, bool depth_write,
 				bool depth_test, std::uint64_t extra_states, unsigned int lod, gpu_program* user_program,
-				std::function<void(gpu_program&)> setup_params) const;
+				std::function<void(gpu_program&)> setup_params, bool positions_only = false) const;
 
 private:
 	void recalulate_lod_limits();
@@ -0,0 +1,205 @@
+#include "occlusion_buffer.h"
+#include "camera.h"
+#include "gpu_program.h"
+
+#include <core/graphics/frame_buffer.h>
+#include <core/graphics/graphics.h>
+#include <core/graphics/render_pass.h>
+#include <core/graphics/render_view.h>
+#include <core/graphics/texture.h>
+
+#include <algorithm>
+#include <limits>
+#include <string>
+
+constexpr std::uint32_t occlusion_buffer::max_read_width;
+constexpr std::uint32_t occlusion_buffer::max_read_height;
+
+void occlusion_buffer::capture(const camera& cam, gfx::render_view& render_view, gfx::texture* depth,
+							   gpu_program* downsample_program)
+{
+	if(reading_ != 0 || !depth || !downsample_program)
+		return;
+
+	if(!gfx::is_supported(BGFX_CAPS_TEXTURE_BLIT) || !gfx::is_supported(BGFX_CAPS_TEXTURE_READ_BACK))
+		return;
+
+	static auto format = gfx::texture_format::R32F;
+	// the view may have rendered to a part of the depth only
+	const auto viewport_size = render_view.get_render_size(cam.get_viewport_size());
+	auto width = std::max<std::uint32_t>(viewport_size.width, 1);
+	auto height = std::max<std::uint32_t>(viewport_size.height, 1);
+	const auto depth_width = std::max<std::uint32_t>(depth->info.width, width);
+	const auto depth_height = std::max<std::uint32_t>(depth->info.height, height);
+	const float depth_offset_y = gfx::is_origin_bottom_left() ? float(depth_height - height) : 0.0f;
+
+	// halve until the level fits the read back, at least once
+	gfx::texture* input = depth;
+	std::shared_ptr<gfx::texture> output;
+	std::uint32_t i = 0;
+	for(; i == 0 || width > max_read_width || height > max_read_height; ++i)
+	{
+		const auto input_width = i == 0 ? depth_width : width;
+		const auto input_height = i == 0 ? depth_height : height;
+		const auto input_size = math::vec4(float(width), float(height), 1.0f / float(input_width),
+										   1.0f / float(input_height));
+		const auto input_offset = math::vec4(0.0f, i == 0 ? depth_offset_y : 0.0f, 0.0f, 0.0f);
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+
+		const auto id = "HIZ" + std::to_string(i);
+		output = render_view.get_texture(id, std::uint16_t(width), std::uint16_t(height), false, 1, format);
+		auto fbo = render_view.get_fbo(id, {output});
+
+		gfx::render_pass pass("hiz_downsample");
+		pass.bind(fbo.get());
+
+		downsample_program->begin();
+		downsample_program->set_texture(0, "s_input", input);
+		downsample_program->set_uniform("u_input_size", input_size);
+		downsample_program->set_uniform("u_input_offset", input_offset);
+		auto topology = gfx::clip_quad(1.0f);
+		gfx::set_state(topology | BGFX_STATE_WRITE_R);
+		gfx::submit(pass.id, downsample_program->native_handle());
+		gfx::set_state(BGFX_STATE_DEFAULT);
+		downsample_program->end();
+
+		input = output.get();
+	}
+
+	if(!read_texture_ || read_width_ != width || read_height_ != height)
+	{
+		read_texture_ = std::make_shared<gfx::texture>(
+			std::uint16_t(width), std::uint16_t(height), false, 1, format,
+			BGFX_TEXTURE_BLIT_DST | BGFX_TEXTURE_READ_BACK | BGFX_SAMPLER_MIN_POINT | BGFX_SAMPLER_MAG_POINT |
+				BGFX_SAMPLER_MIP_POINT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP);
+		read_width_ = width;
+		read_height_ = height;
+		read_data_.resize(std::size_t(width) * height);
+	}
+
+	gfx::render_pass pass("hiz_blit");
+	pass.touch();
+	gfx::blit(pass.id, read_texture_->native_handle(), 0, 0, output->native_handle());
+	reading_ = gfx::read_texture(read_texture_->native_handle(), read_data_.data());
+	read_view_proj_ = cam.get_view_projection().get_matrix();
+	read_viewport_width_ = std::max<std::uint32_t>(viewport_size.width, 1);
+	read_viewport_height_ = std::max<std::uint32_t>(viewport_size.height, 1);
+	read_shift_ = i;
+}
+
+void occlusion_buffer::update(std::uint32_t render_frame)
+{
+	if(reading_ == 0 || reading_ > render_frame)
+		return;
+
+	reading_ = 0;
+	view_proj_ = read_view_proj_;
+	viewport_width_ = read_viewport_width_;
+	viewport_height_ = read_viewport_height_;
+	shift_ = read_shift_;
+	build_levels();
+}
+
+void occlusion_buffer::build_levels()
+{
+	levels_.resize(1);
+	auto& top = levels_.front();
+	top.width = read_width_;
+	top.height = read_height_;
+	top.depth = read_data_;
+
+	// the same reduction as on the GPU down to a single texel
+	while(levels_.back().width > 1 || levels_.back().height > 1)
+	{
+		const auto& input = levels_.back();
+		level output;
+		output.width = (input.width + 1) / 2;
+		output.height = (input.height + 1) / 2;
+		output.depth.resize(std::size_t(output.width) * output.height);
+		for(std::uint32_t y = 0; y < output.height; ++y)
+		{
+			const auto y0 = std::size_t(y * 2);
+			const auto y1 = std::size_t(std::min(y * 2 + 1, input.height - 1));
+			for(std::uint32_t x = 0; x < output.width; ++x)
+			{
+				const auto x0 = std::size_t(x * 2);
+				const auto x1 = std::size_t(std::min(x * 2 + 1, input.width - 1));
+				const auto top_row =
+					std::max(input.depth[y0 * input.width + x0], input.depth[y0 * input.width + x1]);
+				const auto bottom_row =
+					std::max(input.depth[y1 * input.width + x0], input.depth[y1 * input.width + x1]);
+				output.depth[y * output.width + x] = std::max(top_row, bottom_row);
+			}
+		}
+		levels_.push_back(std::move(output));
+	}
+}
+
+bool occlusion_buffer::is_occluded(const math::bbox& bounds) const
+{
+	if(levels_.empty())
+		return false;
+
+	const bool homogeneous_depth = gfx::is_homogeneous_depth();
+	const bool origin_bottom_left = gfx::is_origin_bottom_left();
+
+	float min_x = std::numeric_limits<float>::max();
+	float min_y = std::numeric_limits<float>::max();
+	float max_x = std::numeric_limits<float>::lowest();
+	float max_y = std::numeric_limits<float>::lowest();
+	float nearest = std::numeric_limits<float>::max();
+	for(std::uint32_t i = 0; i < 8; ++i)
+	{
+		const math::vec4 corner((i & 1) ? bounds.max.x : bounds.min.x, (i & 2) ? bounds.max.y : bounds.min.y,
+								(i & 4) ? bounds.max.z : bounds.min.z, 1.0f);
+		const auto clip = view_proj_ * corner;
+
+		// crossing the near plane, its projection is unbounded
+		if(clip.w <= 0.0f)
+			return false;
+
+		const auto ndc = math::vec3(clip) / clip.w;
+		const auto depth = homogeneous_depth ? ndc.z * 0.5f + 0.5f : ndc.z;
+		// the rows of the read back follow the texture origin
+		const auto v = origin_bottom_left ? ndc.y * 0.5f + 0.5f : 0.5f - ndc.y * 0.5f;
+		min_x = std::min(min_x, ndc.x * 0.5f + 0.5f);
+		max_x = std::max(max_x, ndc.x * 0.5f + 0.5f);
+		min_y = std::min(min_y, v);
+		max_y = std::max(max_y, v);
+		nearest = std::min(nearest, depth);
+	}
+
+	// partly off screen is left to the frustum
+	if(min_x < 0.0f || min_y < 0.0f || max_x > 1.0f || max_y > 1.0f || nearest < 0.0f)
+		return false;
+
+	// in pixels of the viewport, texel x of a level covers the pixels
+	// x << shift to ((x + 1) << shift) - 1 as every level rounds its size up
+	const auto x0 = std::min(std::uint32_t(min_x * float(viewport_width_)), viewport_width_ - 1);
+	const auto x1 = std::min(std::uint32_t(max_x * float(viewport_width_)), viewport_width_ - 1);
+	const auto y0 = std::min(std::uint32_t(min_y * float(viewport_height_)), viewport_height_ - 1);
+	const auto y1 = std::min(std::uint32_t(max_y * float(viewport_height_)), viewport_height_ - 1);
+
+	// the level where the rectangle covers at most 2x2 texels
+	std::size_t index = 0;
+	auto shift = shift_;
+	while(index + 1 < levels_.size() &&
+		  ((x1 >> shift) - (x0 >> shift) > 1 || (y1 >> shift) - (y0 >> shift) > 1))
+	{
+		++index;
+		++shift;
+	}
+
+	const auto& l = levels_[index];
+	float farthest = 0.0f;
+	for(auto y = y0 >> shift; y <= (y1 >> shift); ++y)
+	{
+		for(auto x = x0 >> shift; x <= (x1 >> shift); ++x)
+		{
+			farthest = std::max(farthest, l.depth[std::size_t(y) * l.width + x]);
+		}
+	}
+
+	return nearest > farthest;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <core/math/bbox.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class camera;
+class gpu_program;
+
+namespace gfx
+{
+struct texture;
+class render_view;
+}
+
+/*
+ * occlusion_buffer; a hierarchical depth pyramid of a view, built from the
+ * depth of a frame the view already rendered, to skip the models that are
+ * behind what was drawn.
+ *
+ *      The depth is reduced to the farthest value of every 2x2 texels on the
+ *      GPU until it is small enough, read back and reduced further on the
+ *      CPU. The read back takes a couple of frames, the boxes are tested in
+ *      the view projection the depth was rendered with, so a model that just
+ *      came out from behind an occluder may show up a few frames late.
+ */
+class occlusion_buffer
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : capture ()
+	/// <summary>
+	/// Queues the reduction and the read back of the depth the camera just
+	/// rendered to. Does nothing while a read back is in flight.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void capture(const camera& cam, gfx::render_view& render_view, gfx::texture* depth,
+				 gpu_program* downsample_program);
+
+	//-----------------------------------------------------------------------------
+	//  Name : update ()
+	/// <summary>
+	/// Builds the pyramid once the read back of the last capture is done.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void update(std::uint32_t render_frame);
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_occluded ()
+	/// <summary>
+	/// Returns true when the world space box is behind the depth of the
+	/// pyramid everywhere it covers. Always false until a pyramid is built.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool is_occluded(const math::bbox& bounds) const;
+
+	bool is_ready() const
+	{
+		return !levels_.empty();
+	}
+
+	/// the largest size of the level read back, halved on the GPU until it fits
+	static constexpr std::uint32_t max_read_width = 256;
+	static constexpr std::uint32_t max_read_height = 128;
+
+private:
+	struct level
+	{
+		std::uint32_t width = 0;
+		std::uint32_t height = 0;
+		std::vector<float> depth;
+	};
+
+	void build_levels();
+
+	/// the pyramid, 0 is the level read back
+	std::vector<level> levels_;
+	math::mat4 view_proj_;
+	std::uint32_t viewport_width_ = 0;
+	std::uint32_t viewport_height_ = 0;
+	/// halvings of the viewport done on the GPU
+	std::uint32_t shift_ = 0;
+
+	/// read back target and data of the capture in flight
+	std::shared_ptr<gfx::texture> read_texture_;
+	std::vector<float> read_data_;
+	std::uint32_t read_width_ = 0;
+	std::uint32_t read_height_ = 0;
+	std::uint32_t reading_ = 0;
+	math::mat4 read_view_proj_;
+	std::uint32_t read_viewport_width_ = 0;
+	std::uint32_t read_viewport_height_ = 0;
+	std::uint32_t read_shift_ = 0;
+};
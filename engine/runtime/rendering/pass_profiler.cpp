@@ -0,0 +1,152 @@
+#include "pass_profiler.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace
+{
+pass_profiler::timing get_timing(const std::deque<double>& samples)
+{
+	pass_profiler::timing t;
+	if(samples.empty())
+	{
+		return t;
+	}
+
+	t.min_ms = samples.front();
+	t.max_ms = samples.front();
+	double sum = 0.0;
+	for(const auto sample : samples)
+	{
+		t.min_ms = std::min(t.min_ms, sample);
+		t.max_ms = std::max(t.max_ms, sample);
+		sum += sample;
+	}
+	t.avg_ms = sum / double(samples.size());
+	t.last_ms = samples.back();
+	return t;
+}
+
+// the names are written as they are unless they would break a field
+std::string to_csv_field(const std::string& value)
+{
+	if(value.find_first_of(",\"\n") == std::string::npos)
+	{
+		return value;
+	}
+
+	std::string result = "\"";
+	for(const auto c : value)
+	{
+		if(c == '"')
+		{
+			result += '"';
+		}
+		result += c;
+	}
+	result += '"';
+	return result;
+}
+}
+
+void pass_profiler::update(const gfx::stats* stats, std::uint32_t frame)
+{
+	if(!stats || (has_frame_ && frame == last_frame_))
+	{
+		return;
+	}
+	last_frame_ = frame;
+	has_frame_ = true;
+
+	if(stats->numViews == 0 || stats->cpuTimerFreq <= 0 || stats->gpuTimerFreq <= 0)
+	{
+		return;
+	}
+
+	const double to_cpu_ms = 1000.0 / double(stats->cpuTimerFreq);
+	const double to_gpu_ms = 1000.0 / double(stats->gpuTimerFreq);
+
+	struct frame_sample
+	{
+		double cpu_ms = 0.0;
+		double gpu_ms = 0.0;
+		std::uint32_t views = 0;
+	};
+	std::unordered_map<std::string, frame_sample> samples;
+	for(std::uint16_t i = 0; i < stats->numViews; ++i)
+	{
+		const auto& view_stats = stats->viewStats[i];
+		auto& sample = samples[view_stats.name];
+		sample.cpu_ms += double(view_stats.cpuTimeElapsed) * to_cpu_ms;
+		sample.gpu_ms += double(view_stats.gpuTimeElapsed) * to_gpu_ms;
+		++sample.views;
+	}
+
+	for(auto& pair : history_)
+	{
+		++pair.second.unseen;
+	}
+
+	for(const auto& pair : samples)
+	{
+		auto& h = history_[pair.first];
+		h.cpu_ms.push_back(pair.second.cpu_ms);
+		h.gpu_ms.push_back(pair.second.gpu_ms);
+		h.views = pair.second.views;
+		h.unseen = 0;
+		while(h.cpu_ms.size() > window_)
+		{
+			h.cpu_ms.pop_front();
+			h.gpu_ms.pop_front();
+		}
+	}
+
+	for(auto it = history_.begin(); it != history_.end();)
+	{
+		if(it->second.unseen >= window_)
+		{
+			it = history_.erase(it);
+			continue;
+		}
+		++it;
+	}
+
+	build_entries();
+}
+
+void pass_profiler::build_entries()
+{
+	entries_.clear();
+	entries_.reserve(history_.size());
+	for(const auto& pair : history_)
+	{
+		entry e;
+		e.name = pair.first;
+		e.views = pair.second.views;
+		e.samples = pair.second.gpu_ms.size();
+		e.cpu = get_timing(pair.second.cpu_ms);
+		e.gpu = get_timing(pair.second.gpu_ms);
+		entries_.emplace_back(std::move(e));
+	}
+
+	std::stable_sort(std::begin(entries_), std::end(entries_),
+					 [](const entry& a, const entry& b) { return a.gpu.avg_ms > b.gpu.avg_ms; });
+}
+
+void pass_profiler::clear()
+{
+	history_.clear();
+	entries_.clear();
+	has_frame_ = false;
+}
+
+void pass_profiler::write_csv(std::ostream& os) const
+{
+	os << "pass,views,samples,cpu_min_ms,cpu_avg_ms,cpu_max_ms,gpu_min_ms,gpu_avg_ms,gpu_max_ms\n";
+	for(const auto& e : entries_)
+	{
+		os << to_csv_field(e.name) << ',' << e.views << ',' << e.samples << ',' << e.cpu.min_ms << ','
+		   << e.cpu.avg_ms << ',' << e.cpu.max_ms << ',' << e.gpu.min_ms << ',' << e.gpu.avg_ms << ','
+		   << e.gpu.max_ms << '\n';
+	}
+}
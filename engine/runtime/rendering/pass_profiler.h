@@ -0,0 +1,104 @@
+#pragma once
+
+#include <core/graphics/graphics.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+ * pass_profiler; the gpu and cpu time bgfx measured for its views, summed by
+ * the names the render passes gave them and kept over the last frames.
+ *
+ *      Every gfx::render_pass names its view, the views of the passes sharing
+ *      a name in a frame add up to one sample of it. A name that is not seen
+ *      for as many frames as the window holds is dropped. bgfx measures the
+ *      views only with its profiler on and the times are of the frame it last
+ *      rendered.
+ */
+class pass_profiler
+{
+public:
+	struct timing
+	{
+		double min_ms = 0.0;
+		double avg_ms = 0.0;
+		double max_ms = 0.0;
+		/// the time of the last sample
+		double last_ms = 0.0;
+	};
+
+	struct entry
+	{
+		std::string name;
+		/// views that had the name in the last frame it was seen
+		std::uint32_t views = 0;
+		std::size_t samples = 0;
+		timing cpu;
+		timing gpu;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : update ()
+	/// <summary>
+	/// Adds the samples of the frame the stats are of. Call it once a frame,
+	/// frame tells the calls of the same frame apart.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void update(const gfx::stats* stats, std::uint32_t frame);
+
+	//-----------------------------------------------------------------------------
+	//  Name : clear ()
+	/// <summary>
+	/// Forgets every sample.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void clear();
+
+	//-----------------------------------------------------------------------------
+	//  Name : write_csv ()
+	/// <summary>
+	/// Writes the entries as comma separated values with a header line.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void write_csv(std::ostream& os) const;
+
+	/// the passes, the highest average gpu time first
+	const std::vector<entry>& get_entries() const
+	{
+		return entries_;
+	}
+
+	void set_window(std::size_t frames)
+	{
+		window_ = frames > 0 ? frames : 1;
+	}
+
+	std::size_t get_window() const
+	{
+		return window_;
+	}
+
+private:
+	struct history
+	{
+		std::deque<double> cpu_ms;
+		std::deque<double> gpu_ms;
+		std::uint32_t views = 0;
+		/// updates since the name was seen
+		std::size_t unseen = 0;
+	};
+
+	void build_entries();
+
+	std::map<std::string, history> history_;
+	std::vector<entry> entries_;
+	/// frames a sample is kept for
+	std::size_t window_ = 120;
+	std::uint32_t last_frame_ = 0;
+	bool has_frame_ = false;
+};
@@ -0,0 +1,99 @@
+#include "probe_update_queue.h"
+
+#include <algorithm>
+
+constexpr std::uint32_t probe_update_queue::faces_count;
+
+void probe_update_queue::set_probe(std::uint64_t probe, float distance, std::uint64_t frame)
+{
+	auto it = probes_.find(probe);
+	if(it == probes_.end())
+	{
+		it = probes_.emplace(probe, entry()).first;
+		invalidate(probe, frame);
+	}
+
+	it->second.distance = distance;
+	it->second.seen = true;
+}
+
+void probe_update_queue::invalidate(std::uint64_t probe, std::uint64_t frame)
+{
+	auto it = probes_.find(probe);
+	if(it == probes_.end())
+	{
+		return;
+	}
+
+	auto& e = it->second;
+	if(e.pending == 0)
+	{
+		e.invalidated = frame;
+	}
+	e.pending = (1u << faces_count) - 1;
+}
+
+void probe_update_queue::prune()
+{
+	for(auto it = probes_.begin(); it != probes_.end();)
+	{
+		if(!it->second.seen)
+		{
+			it = probes_.erase(it);
+			continue;
+		}
+		it->second.seen = false;
+		++it;
+	}
+}
+
+void probe_update_queue::begin(std::uint64_t frame)
+{
+	order_.clear();
+	handed_ = 0;
+	for(const auto& pair : probes_)
+	{
+		const auto& e = pair.second;
+		if(e.pending == 0)
+		{
+			continue;
+		}
+
+		// waiting longer and being nearer both make a probe more urgent
+		const float waited = float(frame - std::min(frame, e.invalidated) + 1);
+		order_.emplace_back(waited / (1.0f + std::max(e.distance, 0.0f)), pair.first);
+	}
+
+	std::sort(std::begin(order_), std::end(order_),
+			  [](const std::pair<float, std::uint64_t>& a, const std::pair<float, std::uint64_t>& b) {
+				  if(a.first != b.first)
+				  {
+					  return a.first > b.first;
+				  }
+				  return a.second < b.second;
+			  });
+}
+
+bool probe_update_queue::next(duration_t spent, std::uint64_t& probe, std::uint32_t& face)
+{
+	if(handed_ >= order_.size() || (handed_ > 0 && spent >= budget_))
+	{
+		return false;
+	}
+
+	probe = order_[handed_++].second;
+	auto& e = probes_[probe];
+	face = 0;
+	while(((e.pending >> face) & 1) == 0)
+	{
+		++face;
+	}
+	e.pending &= ~(1u << face);
+	return true;
+}
+
+bool probe_update_queue::is_complete(std::uint64_t probe) const
+{
+	auto it = probes_.find(probe);
+	return it == probes_.end() || it->second.pending == 0;
+}
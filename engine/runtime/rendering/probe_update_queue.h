@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * probe_update_queue; the faces of the reflection probes that wait to be
+ * rendered again, handed out a few per frame instead of all six faces of a
+ * probe in the frame it changed.
+ *
+ *      A probe gets at most one face per frame. The probes go from the most
+ *      urgent, the longest waiting and the nearest to a camera, and faces are
+ *      handed out while the time spent this frame is within the budget. The
+ *      first face of a frame is always handed out so every probe progresses.
+ */
+class probe_update_queue
+{
+public:
+	using duration_t = std::chrono::steady_clock::duration;
+
+	static constexpr std::uint32_t faces_count = 6;
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_probe ()
+	/// <summary>
+	/// Keeps a probe for this frame with its distance to the nearest camera.
+	/// A new probe has all its faces invalidated.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_probe(std::uint64_t probe, float distance, std::uint64_t frame);
+
+	//-----------------------------------------------------------------------------
+	//  Name : invalidate ()
+	/// <summary>
+	/// Marks every face of the probe to be rendered again. A probe already
+	/// waiting keeps the frame it started waiting in.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void invalidate(std::uint64_t probe, std::uint64_t frame);
+
+	//-----------------------------------------------------------------------------
+	//  Name : prune ()
+	/// <summary>
+	/// Forgets the probes that were not set since the last prune.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void prune();
+
+	//-----------------------------------------------------------------------------
+	//  Name : begin ()
+	/// <summary>
+	/// Orders the waiting probes for the faces of this frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void begin(std::uint64_t frame);
+
+	//-----------------------------------------------------------------------------
+	//  Name : next ()
+	/// <summary>
+	/// Hands out the next face to render given the time spent so far this
+	/// frame. Returns false when the budget is spent or nothing waits.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool next(duration_t spent, std::uint64_t& probe, std::uint32_t& face);
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_complete ()
+	/// <summary>
+	/// Returns true when no face of the probe waits.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool is_complete(std::uint64_t probe) const;
+
+	void set_budget(duration_t budget)
+	{
+		budget_ = budget;
+	}
+
+	duration_t get_budget() const
+	{
+		return budget_;
+	}
+
+	std::size_t size() const
+	{
+		return probes_.size();
+	}
+
+private:
+	struct entry
+	{
+		/// faces that wait, bit per face
+		std::uint32_t pending = 0;
+		float distance = 0.0f;
+		/// frame the probe started waiting in
+		std::uint64_t invalidated = 0;
+		bool seen = false;
+	};
+
+	std::unordered_map<std::uint64_t, entry> probes_;
+	/// time the faces of a frame may take
+	duration_t budget_ = std::chrono::milliseconds(2);
+	/// waiting probes of this frame, the most urgent first
+	std::vector<std::pair<float, std::uint64_t>> order_;
+	std::size_t handed_ = 0;
+};
@@ -0,0 +1,83 @@
+#include "program_cache.h"
+#include "gpu_program.h"
+
+#include "../assets/asset_manager.h"
+
+#include <core/graphics/shader.h>
+#include <core/system/subsystem.h>
+#include <core/tasks/task_system.h>
+
+#include <iterator>
+
+cached_program::~cached_program()
+{
+	delete program_.load();
+}
+
+program_cache::program_ptr program_cache::get(const std::string& vertex_shader,
+											  const std::string& fragment_shader, const std::string& variant)
+{
+	const auto key = vertex_shader + '|' + fragment_shader + '|' + variant;
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = programs_.find(key);
+	if(it != programs_.end())
+	{
+		if(auto program = it->second.lock())
+		{
+			++hits_;
+			return program;
+		}
+	}
+
+	// the programs nothing holds anymore go with the miss
+	for(auto entry = programs_.begin(); entry != programs_.end();)
+	{
+		entry = entry->second.expired() ? programs_.erase(entry) : std::next(entry);
+	}
+
+	++misses_;
+	auto program = create(vertex_shader, fragment_shader, variant);
+	programs_[key] = program;
+	return program;
+}
+
+program_cache::stats program_cache::get_stats() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	stats result;
+	for(const auto& pair : programs_)
+	{
+		result.programs += pair.second.expired() ? 0 : 1;
+	}
+	result.hits = hits_;
+	result.misses = misses_;
+	return result;
+}
+
+program_cache::program_ptr program_cache::create(const std::string& vertex_shader,
+												 const std::string& fragment_shader,
+												 const std::string& variant)
+{
+	auto& ts = core::get_subsystem<core::task_system>();
+	auto& am = core::get_subsystem<runtime::asset_manager>();
+	// the shaders compiled with variants pick theirs out of their pack, and
+	// are reloaded with their source
+	const auto suffix = variant.empty() ? variant : '#' + variant;
+	auto vs = am.load<gfx::shader>(vertex_shader + suffix);
+	auto fs = am.load<gfx::shader>(fragment_shader + suffix);
+	if(!suffix.empty())
+	{
+		am.add_dependent<gfx::shader>(vertex_shader + suffix, vertex_shader);
+		am.add_dependent<gfx::shader>(fragment_shader + suffix, fragment_shader);
+	}
+
+	// the task holds the program, it may be let go of before it is made
+	auto program = std::make_shared<cached_program>();
+	ts.push_or_execute_on_owner_thread(
+		[program](asset_handle<gfx::shader> vs, asset_handle<gfx::shader> fs) {
+			program->program_.store(new gpu_program(vs, fs), std::memory_order_release);
+		},
+		vs, fs);
+	return program;
+}
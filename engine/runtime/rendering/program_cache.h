@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class gpu_program;
+
+/*
+ * cached_program; a program of the cache, shared by everything drawing with
+ * the same shaders. Null until it is made on the owner thread.
+ */
+class cached_program
+{
+public:
+	~cached_program();
+
+	gpu_program* get() const
+	{
+		return program_.load(std::memory_order_acquire);
+	}
+
+	bool is_ready() const
+	{
+		return get() != nullptr;
+	}
+
+private:
+	friend class program_cache;
+
+	std::atomic<gpu_program*> program_ = {nullptr};
+};
+
+/*
+ * program_cache; the programs by their vertex shader, fragment shader and
+ * variant, the defines separated by ';' of the variants packed from the
+ * manifest of their sources.
+ *
+ *      get returns the program of a key at once, made the first time it is
+ *      asked for: the shaders load on the task system and the program is
+ *      created on the owner thread once they are in, so nothing waits. The
+ *      cache only keeps the programs something holds, the others go with
+ *      their last holder.
+ */
+class program_cache
+{
+public:
+	using program_ptr = std::shared_ptr<cached_program>;
+
+	struct stats
+	{
+		/// the programs alive
+		std::size_t programs = 0;
+		/// the gets that found their program and the ones that made it
+		std::uint64_t hits = 0;
+		std::uint64_t misses = 0;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : get ()
+	/// <summary>
+	/// The program of the shader assets and variant. The variant is ignored
+	/// by the shaders that do not have its features. Safe to call from any
+	/// thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	program_ptr get(const std::string& vertex_shader, const std::string& fragment_shader,
+					const std::string& variant = {});
+
+	stats get_stats() const;
+
+private:
+	program_ptr create(const std::string& vertex_shader, const std::string& fragment_shader,
+					   const std::string& variant);
+
+	mutable std::mutex mutex_;
+	std::unordered_map<std::string, std::weak_ptr<cached_program>> programs_;
+	std::uint64_t hits_ = 0;
+	std::uint64_t misses_ = 0;
+};
@@ -0,0 +1,200 @@
+#include "render_graph.h"
+
+#include <core/graphics/frame_buffer.h>
+#include <core/graphics/render_pass.h>
+
+#include <algorithm>
+
+constexpr render_graph::resource render_graph::invalid_resource;
+
+render_graph::builder::builder(render_graph& graph, std::uint32_t pass)
+	: graph_(graph)
+	, pass_(pass)
+{
+}
+
+render_graph::resource render_graph::builder::create(const std::string& name)
+{
+	const auto r = resource(graph_.resources_.size());
+	resource_entry entry;
+	entry.name = name;
+	entry.producer = pass_;
+	graph_.resources_.emplace_back(std::move(entry));
+	graph_.passes_[pass_].writes.push_back(r);
+	return r;
+}
+
+render_graph::resource render_graph::builder::write(resource r)
+{
+	const auto version = create(graph_.resources_[r].name);
+	graph_.resources_[version].parent = r;
+	return version;
+}
+
+render_graph::resource render_graph::builder::read(resource r)
+{
+	graph_.passes_[pass_].reads.push_back(r);
+	return r;
+}
+
+void render_graph::builder::set_side_effect()
+{
+	graph_.passes_[pass_].side_effect = true;
+}
+
+render_graph::context::context(render_graph& graph)
+	: graph_(graph)
+{
+}
+
+std::shared_ptr<gfx::frame_buffer> render_graph::context::get(resource r) const
+{
+	return graph_.get(r);
+}
+
+void render_graph::context::set(resource r, std::shared_ptr<gfx::frame_buffer> frame_buffer)
+{
+	graph_.resources_[r].frame_buffer = std::move(frame_buffer);
+}
+
+void render_graph::add_pass(const std::string& name, const setup_t& setup, execute_t execute)
+{
+	// the first pass of a new graph, the outputs of the last one go
+	if(passes_.empty())
+		resources_.clear();
+
+	pass p;
+	p.name = name;
+	p.execute = std::move(execute);
+	passes_.emplace_back(std::move(p));
+
+	builder b(*this, std::uint32_t(passes_.size() - 1));
+	setup(b);
+}
+
+void render_graph::set_output(resource r)
+{
+	outputs_.push_back(r);
+}
+
+std::shared_ptr<gfx::frame_buffer> render_graph::get(resource r) const
+{
+	if(r >= resources_.size())
+		return nullptr;
+
+	return resources_[r].frame_buffer;
+}
+
+void render_graph::execute()
+{
+	// Walk back from the outputs and the side effects, a pass is needed when
+	// a needed pass reads what it writes or writes over a version of it.
+	std::vector<bool> needed(passes_.size(), false);
+	std::vector<resource> stack = outputs_;
+	for(std::size_t i = 0; i < passes_.size(); ++i)
+	{
+		if(passes_[i].side_effect)
+		{
+			needed[i] = true;
+			stack.insert(stack.end(), passes_[i].reads.begin(), passes_[i].reads.end());
+			for(const auto w : passes_[i].writes)
+			{
+				if(resources_[w].parent != invalid_resource)
+					stack.push_back(resources_[w].parent);
+			}
+		}
+	}
+
+	while(!stack.empty())
+	{
+		const auto r = stack.back();
+		stack.pop_back();
+
+		const auto producer = resources_[r].producer;
+		if(resources_[r].parent != invalid_resource)
+			stack.push_back(resources_[r].parent);
+
+		if(needed[producer])
+			continue;
+
+		needed[producer] = true;
+		const auto& p = passes_[producer];
+		stack.insert(stack.end(), p.reads.begin(), p.reads.end());
+		for(const auto w : p.writes)
+		{
+			if(resources_[w].parent != invalid_resource)
+				stack.push_back(resources_[w].parent);
+		}
+	}
+
+	culled_ = std::size_t(std::count(needed.begin(), needed.end(), false));
+
+	// the passes were added after what they read, that order is kept
+	context ctx(*this);
+	for(std::size_t i = 0; i < passes_.size(); ++i)
+	{
+		if(!needed[i])
+			continue;
+
+		auto& p = passes_[i];
+		for(const auto w : p.writes)
+		{
+			const auto parent = resources_[w].parent;
+			if(parent != invalid_resource)
+				resources_[w].frame_buffer = resources_[parent].frame_buffer;
+		}
+
+		record rec;
+		rec.name = p.name;
+		rec.first = gfx::render_pass::get_next_id();
+		p.execute(ctx);
+		rec.last = gfx::render_pass::get_next_id();
+		// the ids ran out and started over, the views can't be told apart
+		if(rec.last >= rec.first)
+			records_.emplace_back(std::move(rec));
+	}
+
+	// only the outputs are read after the graph
+	for(resource r = 0; r < resource(resources_.size()); ++r)
+	{
+		if(std::find(outputs_.begin(), outputs_.end(), r) == outputs_.end())
+			resources_[r].frame_buffer.reset();
+	}
+	passes_.clear();
+	outputs_.clear();
+}
+
+void render_graph::clear()
+{
+	passes_.clear();
+	resources_.clear();
+	outputs_.clear();
+}
+
+void render_graph::begin_frame()
+{
+	clear();
+	timings_.clear();
+
+	const auto stats = gfx::get_stats();
+	if(stats && stats->gpuTimerFreq > 0 && stats->cpuTimerFreq > 0)
+	{
+		const double to_gpu_ms = 1000.0 / double(stats->gpuTimerFreq);
+		const double to_cpu_ms = 1000.0 / double(stats->cpuTimerFreq);
+		for(const auto& rec : records_)
+		{
+			auto& t = timings_[rec.name];
+			++t.count;
+			for(std::uint16_t i = 0; i < stats->numViews; ++i)
+			{
+				const auto& view_stats = stats->viewStats[i];
+				if(view_stats.view < rec.first || view_stats.view >= rec.last)
+					continue;
+
+				t.gpu_ms += double(view_stats.gpuTimeElapsed) * to_gpu_ms;
+				t.cpu_ms += double(view_stats.cpuTimeElapsed) * to_cpu_ms;
+			}
+		}
+	}
+	records_.clear();
+}
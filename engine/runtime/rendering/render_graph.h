@@ -0,0 +1,190 @@
+#pragma once
+
+#include <core/graphics/graphics.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gfx
+{
+class frame_buffer;
+}
+
+/*
+ * render_graph; the passes of a view declared with the resources they read
+ * and write, instead of calling them one after the other.
+ *
+ *      A pass is set up once its inputs exist, so the order the passes are
+ *      added in is an order they can run in, and it is kept: every view is
+ *      sequential and the bgfx view ids are taken in that order as the passes
+ *      record. The passes that nothing reaching an output or a side effect
+ *      reads are culled. Writing to a resource again makes a new version of
+ *      it, the passes reading the old one run before.
+ *
+ *      The view ids every pass took are kept to sum up the gpu and cpu time
+ *      bgfx measured for them, by pass name across every execute of the graph
+ *      in a frame. bgfx fills the times only with its profiler on.
+ */
+class render_graph
+{
+public:
+	using resource = std::uint32_t;
+	static constexpr resource invalid_resource = ~resource(0);
+
+	class builder
+	{
+	public:
+		//-----------------------------------------------------------------------------
+		//  Name : create ()
+		/// <summary>
+		/// A new resource the pass writes.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		resource create(const std::string& name);
+
+		//-----------------------------------------------------------------------------
+		//  Name : write ()
+		/// <summary>
+		/// A new version of the resource the pass writes over, it starts with
+		/// the frame buffer of the old one.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		resource write(resource r);
+
+		//-----------------------------------------------------------------------------
+		//  Name : read ()
+		/// <summary>
+		/// The pass reads the resource, it runs after the pass writing it.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		resource read(resource r);
+
+		//-----------------------------------------------------------------------------
+		//  Name : set_side_effect ()
+		/// <summary>
+		/// The pass does something outside the graph and is never culled.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void set_side_effect();
+
+	private:
+		friend class render_graph;
+		builder(render_graph& graph, std::uint32_t pass);
+
+		render_graph& graph_;
+		std::uint32_t pass_ = 0;
+	};
+
+	class context
+	{
+	public:
+		std::shared_ptr<gfx::frame_buffer> get(resource r) const;
+		void set(resource r, std::shared_ptr<gfx::frame_buffer> frame_buffer);
+
+	private:
+		friend class render_graph;
+		explicit context(render_graph& graph);
+
+		render_graph& graph_;
+	};
+
+	struct timing
+	{
+		/// executes of the pass in the frame
+		std::uint32_t count = 0;
+		double gpu_ms = 0.0;
+		double cpu_ms = 0.0;
+	};
+
+	using setup_t = std::function<void(builder&)>;
+	using execute_t = std::function<void(context&)>;
+
+	//-----------------------------------------------------------------------------
+	//  Name : add_pass ()
+	/// <summary>
+	/// Sets the pass up right away, execute is called by execute if the pass
+	/// is not culled.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void add_pass(const std::string& name, const setup_t& setup, execute_t execute);
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_output ()
+	/// <summary>
+	/// A resource read after the graph, the passes it needs are kept.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_output(resource r);
+
+	//-----------------------------------------------------------------------------
+	//  Name : execute ()
+	/// <summary>
+	/// Culls and runs the passes, then forgets them. The frame buffers of the
+	/// outputs stay readable with get until a pass of the next graph is added.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void execute();
+
+	std::shared_ptr<gfx::frame_buffer> get(resource r) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : begin_frame ()
+	/// <summary>
+	/// Sums up the times bgfx measured for the views of the last frame. Call
+	/// it once per frame before the first execute.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void begin_frame();
+
+	/// times of the passes of the last measured frame, by name
+	const std::unordered_map<std::string, timing>& get_timings() const
+	{
+		return timings_;
+	}
+
+	/// passes culled by the last execute
+	std::size_t get_culled_count() const
+	{
+		return culled_;
+	}
+
+private:
+	struct pass
+	{
+		std::string name;
+		execute_t execute;
+		std::vector<resource> reads;
+		std::vector<resource> writes;
+		bool side_effect = false;
+	};
+
+	struct resource_entry
+	{
+		std::string name;
+		std::uint32_t producer = 0;
+		/// the version written over, invalid_resource for a created one
+		resource parent = invalid_resource;
+		std::shared_ptr<gfx::frame_buffer> frame_buffer;
+	};
+
+	/// the views a pass took when it recorded
+	struct record
+	{
+		std::string name;
+		gfx::view_id first = 0;
+		gfx::view_id last = 0;
+	};
+
+	void clear();
+
+	std::vector<pass> passes_;
+	std::vector<resource_entry> resources_;
+	std::vector<resource> outputs_;
+	std::size_t culled_ = 0;
+	std::vector<record> records_;
+	std::unordered_map<std::string, timing> timings_;
+};
@@ -0,0 +1,576 @@
+#include "render_queue.h"
+#include "gpu_program.h"
+#include "material.h"
+#include "mesh.h"
+#include "model.h"
+#include "renderer.h"
+
+#include <core/system/subsystem.h>
+#include <core/tasks/task_group.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace
+{
+/// bits of every part of the key, from the highest
+constexpr std::uint32_t view_bits = 8;
+constexpr std::uint32_t program_bits = 12;
+constexpr std::uint32_t material_bits = 16;
+constexpr std::uint32_t mesh_bits = 12;
+constexpr std::uint32_t depth_bits = 16;
+
+constexpr std::uint32_t depth_shift = 0;
+constexpr std::uint32_t mesh_shift = depth_shift + depth_bits;
+constexpr std::uint32_t material_shift = mesh_shift + mesh_bits;
+constexpr std::uint32_t program_shift = material_shift + material_bits;
+constexpr std::uint32_t view_shift = program_shift + program_bits;
+static_assert(view_shift + view_bits == 64, "the parts must fill the key");
+
+/// a world matrix in the instance data
+constexpr std::uint16_t instance_stride = sizeof(math::transform::mat4_t);
+
+std::uint64_t get_part(std::uint64_t value, std::uint32_t bits, std::uint32_t shift)
+{
+	return (value & ((std::uint64_t(1) << bits) - 1)) << shift;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : get_id ()
+/// <summary>
+/// Dense id of an object, in the order they were first seen.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename M, typename K>
+std::uint32_t get_id(M& ids, const K& key)
+{
+	return ids.emplace(key, std::uint32_t(ids.size())).first->second;
+}
+}
+
+constexpr std::size_t render_queue::min_instances;
+constexpr std::size_t render_queue::min_chunk_size;
+constexpr std::size_t render_queue::max_chunks;
+
+void render_queue::add(gfx::view_id id, const model& mdl, const math::transform& world_transform,
+					   const std::vector<math::transform>& bone_transforms, bool apply_cull, bool depth_write,
+					   bool depth_test, std::uint64_t extra_states, unsigned int lod, float depth,
+					   const math::vec4& params, bool depth_prepass)
+{
+	const auto mesh_handle = mdl.get_lod(lod);
+	if(!mesh_handle)
+	{
+		return;
+	}
+
+	auto mesh_ptr = mesh_handle.get();
+	const auto depth_key = std::uint64_t(math::clamp(depth, 0.0f, 1.0f) * float((1 << depth_bits) - 1));
+
+	const auto add_subset = [&](std::uint32_t group_id, std::int32_t palette, skinning_cache::entry skin) {
+		const auto mat = mdl.get_material_for_group(group_id);
+		auto mat_ptr = mat.get();
+		if(!mat_ptr)
+		{
+			return;
+		}
+
+		// the program of a material depends on the skinning, the vertices
+		// skinned by compute are drawn as those of the others, and on the
+		// texture arrays it samples
+		mat_ptr->skinned = palette >= 0 && !skin.is_computed();
+		mat_ptr->update_texture_arrays();
+		auto program = mat_ptr->get_program();
+		if(!program)
+		{
+			return;
+		}
+
+		item it;
+		it.id = id;
+		it.mesh = mesh_ptr;
+		it.material = mat_ptr;
+		it.program = program;
+		it.world_transform = &world_transform;
+		it.palette = palette;
+		it.skin = skin;
+		it.group_id = group_id;
+		// the depth of the pre-pass is final, the fragments on it pass
+		it.depth_prepass = depth_prepass && !mat_ptr->skinned && mat_ptr->is_opaque();
+		it.states = it.depth_prepass
+						? extra_states | mat_ptr->get_render_states(apply_cull, false, false) |
+							  BGFX_STATE_DEPTH_TEST_EQUAL
+						: extra_states | mat_ptr->get_render_states(apply_cull, depth_write, depth_test);
+		it.params = params;
+		it.key = get_part(id, view_bits, view_shift) |
+				 get_part(program->native_handle().idx, program_bits, program_shift) |
+				 get_part(get_id(material_ids_, mat_ptr->get_batch_key()), material_bits, material_shift) |
+				 get_part(get_id(subset_ids_, std::make_pair(mesh_ptr, group_id)), mesh_bits, mesh_shift) |
+				 depth_key;
+		items_.push_back(it);
+	};
+
+	const auto& skin_data = mesh_ptr->get_skin_bind_data();
+	if(skin_data.has_bones() && !bone_transforms.empty())
+	{
+		auto& cache = core::get_subsystem<runtime::renderer>().get_skinning_cache();
+		const auto& palettes = mesh_ptr->get_bone_palettes();
+		for(std::size_t i = 0; i < palettes.size(); ++i)
+		{
+			const auto skin = cache.get(*mesh_ptr, i, bone_transforms);
+			if(skin.count > 0)
+			{
+				add_subset(palettes[i].get_data_group(), std::int32_t(i), skin);
+			}
+		}
+	}
+	else
+	{
+		for(std::size_t i = 0; i < mesh_ptr->get_subset_count(); ++i)
+		{
+			add_subset(std::uint32_t(i), -1, {});
+		}
+	}
+}
+
+void render_queue::sort()
+{
+	batches_built_ = false;
+	const auto count = items_.size();
+	sorted_.resize(count);
+	scratch_.resize(count);
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		sorted_[i].key = items_[i].key;
+		sorted_[i].index = std::uint32_t(i);
+	}
+
+	// least significant byte first, every pass is stable
+	std::array<std::array<std::uint32_t, 256>, 8> histograms{};
+	for(const auto& entry : sorted_)
+	{
+		for(std::uint32_t pass = 0; pass < 8; ++pass)
+		{
+			++histograms[pass][(entry.key >> (pass * 8)) & 0xff];
+		}
+	}
+
+	for(std::uint32_t pass = 0; pass < 8; ++pass)
+	{
+		auto& histogram = histograms[pass];
+
+		// a byte that is the same in every key leaves the order as is
+		const auto shift = pass * 8;
+		if(count == 0 || histogram[(sorted_.front().key >> shift) & 0xff] == count)
+		{
+			continue;
+		}
+
+		std::uint32_t offset = 0;
+		for(auto& bucket : histogram)
+		{
+			const auto bucket_count = bucket;
+			bucket = offset;
+			offset += bucket_count;
+		}
+
+		for(const auto& entry : sorted_)
+		{
+			scratch_[histogram[(entry.key >> shift) & 0xff]++] = entry;
+		}
+		sorted_.swap(scratch_);
+	}
+}
+
+void render_queue::submit(const gpu_program::uniform_id& params_uniform,
+						  const std::function<void(gpu_program&)>& setup_program)
+{
+	if(!batches_built_)
+	{
+		build_batches();
+	}
+	submits_ = batches_.size();
+	material_binds_ = 0;
+	submit_batches(0, batches_.size(), nullptr, params_uniform, setup_program, material_binds_);
+}
+
+void render_queue::submit_parallel(const std::vector<gfx::view_id>& chunk_views,
+								   const gpu_program::uniform_id& params_uniform,
+								   const std::function<void(gpu_program&)>& setup_program)
+{
+	if(!batches_built_)
+	{
+		build_batches();
+	}
+	submits_ = batches_.size();
+	material_binds_ = 0;
+
+	const auto chunks = std::min(chunk_views.size() + 1, batches_.size());
+	if(chunks <= 1)
+	{
+		submit_batches(0, batches_.size(), nullptr, params_uniform, setup_program, material_binds_);
+		return;
+	}
+
+	prepare_materials();
+
+	std::vector<std::size_t> material_binds(chunks, 0);
+	auto& ts = core::get_subsystem<core::task_system>();
+	core::parallel_for(ts, std::size_t(0), chunks, std::size_t(1), [&](std::size_t chunk) {
+		const auto begin = batches_.size() * chunk / chunks;
+		const auto end = batches_.size() * (chunk + 1) / chunks;
+		const auto view = chunk == 0 ? nullptr : &chunk_views[chunk - 1];
+
+		gfx::scoped_encoder encoder;
+		submit_batches(begin, end, view, params_uniform, setup_program, material_binds[chunk]);
+	});
+
+	for(const auto binds : material_binds)
+	{
+		material_binds_ += binds;
+	}
+}
+
+void render_queue::submit_depth(gfx::view_id id, gpu_program& program, gpu_program& instanced_program,
+								const std::function<void(gpu_program&)>& setup_program)
+{
+	build_batches();
+	if(!program.begin() || !instanced_program.begin())
+	{
+		return;
+	}
+
+	setup_program(program);
+	setup_program(instanced_program);
+
+	// only the depth is written, with the cull of the material
+	constexpr auto depth_states = BGFX_STATE_WRITE_Z | BGFX_STATE_DEPTH_TEST_LESS | BGFX_STATE_MSAA;
+	const item* last = nullptr;
+	for(std::size_t i = 0; i < batches_.size(); ++i)
+	{
+		auto& b = batches_[i];
+		const auto& it = items_[sorted_[b.begin].index];
+		if(!it.depth_prepass)
+		{
+			continue;
+		}
+
+		auto& depth_program = b.instanced_program ? instanced_program : program;
+		const auto states = (it.states & BGFX_STATE_CULL_MASK) | depth_states;
+
+		// the program reads the fade distance of the material alone
+		if(!last || last->material != it.material)
+		{
+			it.material->submit(depth_program);
+		}
+		last = &it;
+
+		if(b.instanced_program)
+		{
+			submit_instanced(b, it, id, depth_program, states, true);
+			last = nullptr;
+			continue;
+		}
+
+		const auto next = i + 1 < batches_.size() ? &batches_[i + 1] : nullptr;
+		const bool preserve_state = next && !next->instanced_program &&
+									items_[sorted_[next->begin].index].material == it.material &&
+									items_[sorted_[next->begin].index].depth_prepass;
+		submit_single(it, id, depth_program, states, true, preserve_state);
+		if(!preserve_state)
+		{
+			last = nullptr;
+		}
+	}
+
+	program.end();
+	instanced_program.end();
+}
+
+void render_queue::submit_feedback(gfx::view_id id, const std::function<void(gpu_program&)>& setup_program)
+{
+	if(!batches_built_)
+	{
+		build_batches();
+	}
+
+	constexpr auto feedback_states =
+		BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_WRITE_Z | BGFX_STATE_DEPTH_TEST_LESS;
+	std::vector<gpu_program*> begun;
+	gpu_program* program = nullptr;
+	for(auto& b : batches_)
+	{
+		const auto& it = items_[sorted_[b.begin].index];
+		if(it.palette >= 0 && !it.skin.is_computed())
+		{
+			continue;
+		}
+
+		auto feedback_program = it.material->get_feedback_program(b.instanced_program != nullptr);
+		if(!feedback_program)
+		{
+			continue;
+		}
+
+		if(feedback_program != program)
+		{
+			if(std::find(std::begin(begun), std::end(begun), feedback_program) == std::end(begun))
+			{
+				if(!feedback_program->begin())
+				{
+					continue;
+				}
+				begun.push_back(feedback_program);
+			}
+			program = feedback_program;
+			setup_program(*program);
+		}
+
+		// no state is kept between the subsets, they are few at this size
+		it.material->submit(*program);
+		const auto states = (it.states & BGFX_STATE_CULL_MASK) | feedback_states;
+		if(b.instanced_program)
+		{
+			submit_instanced(b, it, id, *program, states, false);
+			continue;
+		}
+		submit_single(it, id, *program, states, false, false);
+	}
+
+	for(auto begun_program : begun)
+	{
+		begun_program->end();
+	}
+}
+
+std::size_t render_queue::get_chunks_count() const
+{
+	return std::max<std::size_t>(1, std::min(max_chunks, items_.size() / min_chunk_size));
+}
+
+//-----------------------------------------------------------------------------
+//  Name : build_batches ()
+/// <summary>
+/// Groups the sorted subsets in submits. Everything that is not safe to do
+/// from the worker threads is done here: the programs are begun, which may
+/// reload them, and the instance data is allocated.
+/// </summary>
+//-----------------------------------------------------------------------------
+void render_queue::build_batches()
+{
+	batches_.clear();
+
+	const bool instancing = gfx::is_supported(BGFX_CAPS_INSTANCING);
+	gpu_program* program = nullptr;
+	bool valid_program = false;
+	for(std::size_t i = 0; i < sorted_.size();)
+	{
+		const auto& it = items_[sorted_[i].index];
+		if(it.program != program)
+		{
+			if(program)
+			{
+				program->end();
+			}
+
+			program = it.program;
+			valid_program = program->begin();
+		}
+
+		if(!valid_program)
+		{
+			++i;
+			continue;
+		}
+
+		// the run of copies of this subset that can share a submit
+		batch b;
+		auto end = i + 1;
+		auto instanced_program = instancing ? it.material->get_instanced_program() : nullptr;
+		if(instanced_program)
+		{
+			while(end < sorted_.size() && can_instance(it, items_[sorted_[end].index]))
+			{
+				++end;
+			}
+
+			const auto count = std::uint32_t(end - i);
+			if(count >= min_instances && instanced_program->begin() &&
+			   gfx::get_avail_instance_data_buffer(count, instance_stride) == count)
+			{
+				gfx::alloc_instance_data_buffer(&b.instance_data, count, instance_stride);
+				b.instanced_program = instanced_program;
+			}
+			else
+			{
+				end = i + 1;
+			}
+		}
+
+		b.begin = std::uint32_t(i);
+		b.end = std::uint32_t(end);
+		batches_.push_back(b);
+		i = end;
+	}
+
+	if(program)
+	{
+		program->end();
+	}
+	batches_built_ = true;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : prepare_materials ()
+/// <summary>
+/// Binds every material once on the calling thread so that the sampler
+/// uniforms a program lacks are created here and not on a worker thread,
+/// the state they set is discarded.
+/// </summary>
+//-----------------------------------------------------------------------------
+void render_queue::prepare_materials()
+{
+	const item* last = nullptr;
+	for(const auto& b : batches_)
+	{
+		const auto& it = items_[sorted_[b.begin].index];
+		if(!last || last->material != it.material || last->program != it.program)
+		{
+			it.material->submit(*it.program);
+			last = &it;
+		}
+	}
+	gfx::discard();
+}
+
+void render_queue::submit_batches(std::size_t begin, std::size_t end, const gfx::view_id* view,
+								  const gpu_program::uniform_id& params_uniform,
+								  const std::function<void(gpu_program&)>& setup_program,
+								  std::size_t& material_binds)
+{
+	gpu_program* program = nullptr;
+	// the material whose uniforms and textures are still bound
+	material* bound_material = nullptr;
+	bool params_set = false;
+	math::vec4 params;
+
+	for(auto i = begin; i < end; ++i)
+	{
+		auto& b = batches_[i];
+		const auto& it = items_[sorted_[b.begin].index];
+		const auto id = view ? *view : it.id;
+		if(it.program != program)
+		{
+			program = it.program;
+			setup_program(*program);
+			bound_material = nullptr;
+			params_set = false;
+		}
+
+		if(it.material != bound_material)
+		{
+			it.material->submit(*program);
+			bound_material = it.material;
+			++material_binds;
+		}
+
+		if(!params_set || it.params != params)
+		{
+			program->set_uniform(params_uniform, it.params);
+			params = it.params;
+			params_set = true;
+		}
+
+		// the instance data would be kept with the rest of the state
+		if(b.instanced_program)
+		{
+			submit_instanced(b, it, id, *b.instanced_program, it.states, false);
+			bound_material = nullptr;
+			continue;
+		}
+
+		// the bindings of the material are kept for the next subset using it
+		const auto next = i + 1 < end ? &items_[sorted_[batches_[i + 1].begin].index] : nullptr;
+		const bool preserve_state =
+			next && next->id == it.id && next->program == program && next->material == it.material;
+		submit_single(it, id, *program, it.states, false, preserve_state);
+
+		if(!preserve_state)
+		{
+			bound_material = nullptr;
+		}
+	}
+}
+
+bool render_queue::can_instance(const item& first, const item& other) const
+{
+	return other.id == first.id && other.program == first.program &&
+		   (other.material == first.material || first.material->batches_with(*other.material)) &&
+		   other.mesh == first.mesh && other.group_id == first.group_id && other.palette < 0 &&
+		   first.palette < 0 && other.states == first.states && other.params == first.params;
+}
+
+void render_queue::submit_single(const item& it, gfx::view_id id, gpu_program& program, std::uint64_t states,
+								 bool positions_only, bool preserve_state)
+{
+	using mat_type = math::transform::mat4_t;
+	gfx::set_state(states);
+
+	if(it.skin.is_computed())
+	{
+		skinning_cache::bind(*it.mesh, it.group_id, it.skin);
+	}
+	else
+	{
+		if(it.palette >= 0)
+		{
+			gfx::set_transform(it.skin.cache, it.skin.count);
+		}
+		else
+		{
+			const mat_type& world = it.world_transform->get_matrix();
+			gfx::set_transform(&world);
+		}
+
+		it.mesh->bind_render_buffers_for_subset(it.group_id, positions_only);
+	}
+
+	gfx::submit(id, program.native_handle(), 0, preserve_state);
+}
+
+void render_queue::submit_instanced(batch& b, const item& it, gfx::view_id id, gpu_program& program,
+									std::uint64_t states, bool positions_only)
+{
+	// the columns of the world matrices, one after the other. The programs
+	// read the columns without their w, the first two hold the layers of the
+	// texture arrays of the material of the copy.
+	auto data = b.instance_data.data;
+	for(auto i = b.begin; i < b.end; ++i)
+	{
+		const auto& copy = items_[sorted_[i].index];
+		const auto& world = copy.world_transform->get_matrix();
+		std::memcpy(data, &world, instance_stride);
+		if(const auto* layers = copy.material->get_texture_layers())
+		{
+			std::memcpy(data + 3 * sizeof(float), &layers->x, sizeof(float));
+			std::memcpy(data + 7 * sizeof(float), &layers->y, sizeof(float));
+		}
+		data += instance_stride;
+	}
+
+	gfx::set_instance_data_buffer(&b.instance_data, 0, b.end - b.begin);
+	gfx::set_state(states);
+
+	it.mesh->bind_render_buffers_for_subset(it.group_id, positions_only);
+
+	gfx::submit(id, program.native_handle());
+}
+
+void render_queue::clear()
+{
+	items_.clear();
+	sorted_.clear();
+	batches_built_ = false;
+	material_ids_.clear();
+	subset_ids_.clear();
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "gpu_program.h"
+#include "skinning_cache.h"
+
+#include <core/graphics/graphics.h>
+#include <core/math/math_includes.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class material;
+class mesh;
+class model;
+
+/*
+ * render_queue; the subsets of the models drawn in a pass, sorted before
+ * they are submitted.
+ *
+ *      Every subset gets a 64 bit key made of, from the highest bits, the
+ *      view, the program, the material, the mesh and the depth. Sorted on
+ *      it the subsets sharing a program and a material follow each other,
+ *      front to back, so the material is bound once per run: the uniforms
+ *      stay set and the textures are kept by preserving the draw state
+ *      between the submits. The passes are sequential, the order of the
+ *      queue is the order bgfx draws in.
+ *
+ *      A run of the same subset with the same params and states is drawn
+ *      with one instanced submit when the material has an instanced
+ *      program, the world matrices going to the instance data. The materials
+ *      that differ only in the layers of the texture arrays they sample are
+ *      sorted together and share the submit, the layers going to the
+ *      instance data with the matrices. Skinned subsets set the matrices of
+ *      their palette from the skinning cache, computed by the first pass
+ *      that drew it in the frame.
+ *
+ *      A big queue can be split in chunks recorded on the worker threads,
+ *      each on its own bgfx encoder and its own view. Each chunk binds its
+ *      programs and materials again as the draws of the encoders of one
+ *      view would interleave.
+ *
+ *      The opaque subsets may have their depth drawn first by a pre-pass
+ *      with the same batches, the colors are then only shaded once per
+ *      pixel by testing equal to it.
+ */
+class render_queue
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : add ()
+	/// <summary>
+	/// Adds the subsets of a lod of the model. depth is the distance from the
+	/// view divided by the far clip, params is set to the params uniform of
+	/// submit for every subset. The world transform must outlive the submit.
+	/// With depth_prepass the subsets of opaque materials that are not skinned,
+	/// or skinned by compute, are drawn by submit_depth too, and by submit
+	/// tested equal to that depth.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void add(gfx::view_id id, const model& mdl, const math::transform& world_transform,
+			 const std::vector<math::transform>& bone_transforms, bool apply_cull, bool depth_write,
+			 bool depth_test, std::uint64_t extra_states, unsigned int lod, float depth,
+			 const math::vec4& params, bool depth_prepass = false);
+
+	//-----------------------------------------------------------------------------
+	//  Name : sort ()
+	/// <summary>
+	/// Radix sorts the subsets on their keys.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void sort();
+
+	//-----------------------------------------------------------------------------
+	//  Name : submit ()
+	/// <summary>
+	/// Submits the subsets in the sorted order. setup_program is called once
+	/// every time the program changes.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void submit(const gpu_program::uniform_id& params_uniform,
+				const std::function<void(gpu_program&)>& setup_program);
+
+	//-----------------------------------------------------------------------------
+	//  Name : submit_parallel ()
+	/// <summary>
+	/// Submits the subsets in as many chunks as there are chunk views plus
+	/// one, the first chunk in the view of the subsets, which must all share
+	/// it. The chunk views must draw to the same target right after it.
+	/// setup_program may be called from several threads.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void submit_parallel(const std::vector<gfx::view_id>& chunk_views,
+						 const gpu_program::uniform_id& params_uniform,
+						 const std::function<void(gpu_program&)>& setup_program);
+
+	//-----------------------------------------------------------------------------
+	//  Name : submit_depth ()
+	/// <summary>
+	/// Submits the depth of the subsets added for the pre-pass to a view drawn
+	/// before those of submit, with the positions alone. They are batched as
+	/// submit batches them, the programs must compute the positions the same
+	/// way the instanced and the other programs of the materials do.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void submit_depth(gfx::view_id id, gpu_program& program, gpu_program& instanced_program,
+					  const std::function<void(gpu_program&)>& setup_program);
+
+	//-----------------------------------------------------------------------------
+	//  Name : submit_feedback ()
+	/// <summary>
+	/// Submits the subsets of the materials with a feedback program to a view
+	/// of the virtual texture feedback, batched as submit batches them. The
+	/// subsets skinned by their vertex shader are left out.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void submit_feedback(gfx::view_id id, const std::function<void(gpu_program&)>& setup_program);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_chunks_count ()
+	/// <summary>
+	/// Number of chunks worth recording in parallel for the queued subsets.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t get_chunks_count() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : clear ()
+	/// <summary>
+	/// Removes every subset, the memory is kept for the next frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void clear();
+
+	std::size_t size() const
+	{
+		return items_.size();
+	}
+
+	/// materials bound by the last submit, at most one per subset
+	std::size_t get_material_binds() const
+	{
+		return material_binds_;
+	}
+
+	/// submits done by the last submit, instanced or not
+	std::size_t get_submits() const
+	{
+		return submits_;
+	}
+
+	/// the fewest copies of a subset drawn with an instanced submit
+	static constexpr std::size_t min_instances = 2;
+	/// the fewest subsets in a chunk recorded on its own thread
+	static constexpr std::size_t min_chunk_size = 256;
+	/// at most as many chunks, bgfx has a handful of encoders
+	static constexpr std::size_t max_chunks = 4;
+
+private:
+	struct item
+	{
+		std::uint64_t key = 0;
+		gfx::view_id id = 0;
+		::mesh* mesh = nullptr;
+		::material* material = nullptr;
+		gpu_program* program = nullptr;
+		const math::transform* world_transform = nullptr;
+		/// index of the bone palette, -1 when not skinned
+		std::int32_t palette = -1;
+		/// the skinning matrices of the palette in the frame
+		skinning_cache::entry skin;
+		std::uint32_t group_id = 0;
+		std::uint64_t states = 0;
+		math::vec4 params;
+		/// drawn in the depth pre-pass as well
+		bool depth_prepass = false;
+	};
+
+	/// subsets drawn with one submit, from begin to end in the sorted order
+	struct batch
+	{
+		std::uint32_t begin = 0;
+		std::uint32_t end = 0;
+		/// the instanced program when the batch is instanced
+		gpu_program* instanced_program = nullptr;
+		gfx::instance_data_buffer instance_data;
+	};
+
+	bool can_instance(const item& first, const item& other) const;
+	void build_batches();
+	void prepare_materials();
+	void submit_batches(std::size_t begin, std::size_t end, const gfx::view_id* view,
+						const gpu_program::uniform_id& params_uniform,
+						const std::function<void(gpu_program&)>& setup_program, std::size_t& material_binds);
+	void submit_single(const item& it, gfx::view_id id, gpu_program& program, std::uint64_t states,
+					   bool positions_only, bool preserve_state);
+	void submit_instanced(batch& b, const item& it, gfx::view_id id, gpu_program& program,
+						  std::uint64_t states, bool positions_only);
+
+	struct sort_entry
+	{
+		std::uint64_t key = 0;
+		std::uint32_t index = 0;
+	};
+
+	std::vector<item> items_;
+	/// the items in the sorted order and the other buffer of the radix sort
+	std::vector<sort_entry> sorted_;
+	std::vector<sort_entry> scratch_;
+	/// the batches of the last submit, of valid programs only
+	std::vector<batch> batches_;
+	/// the batches are of the sorted order, kept for the submits that follow
+	/// submit_depth so that they are drawn the same way
+	bool batches_built_ = false;
+	/// dense ids of the materials and mesh subsets seen since the last clear
+	std::unordered_map<const void*, std::uint32_t> material_ids_;
+	std::map<std::pair<const ::mesh*, std::uint32_t>, std::uint32_t> subset_ids_;
+	std::size_t material_binds_ = 0;
+	std::size_t submits_ = 0;
+};
@@ -3,15 +3,43 @@
 #include "../system/events.h"
 
 #include <core/common/assert.hpp>
+#include <core/graphics/destroy_queue.h>
 #include <core/graphics/graphics.h>
 #include <core/graphics/render_pass.h>
+#include <core/graphics/render_view.h>
 #include <core/logging/logging.h>
+#include <core/profiling/profiler.h>
 
 #include <algorithm>
 #include <cstdarg>
+#include <thread>
 
 namespace runtime
 {
+namespace
+{
+/// frames in a row that miss or keep up with the display before the
+/// adaptive vsync switches
+constexpr std::uint32_t adaptive_vsync_frames = 30;
+/// ms the main thread is left waiting on the render thread when the input
+/// is sampled late, for the frames that take a little longer
+constexpr float late_input_margin_ms = 1.0f;
+
+std::uint32_t get_reset_flags(bool vsync, bool flush_after_render)
+{
+	std::uint32_t flags = BGFX_RESET_NONE;
+	if(vsync)
+	{
+		flags |= BGFX_RESET_VSYNC;
+	}
+	if(flush_after_render)
+	{
+		flags |= BGFX_RESET_FLUSH_AFTER_RENDER;
+	}
+	return flags;
+}
+}
+
 renderer::renderer(cmd_line::parser& parser)
 {
 	on_platform_events.connect(this, &renderer::platform_events);
@@ -37,6 +65,7 @@ renderer::~renderer()
 	on_frame_end.disconnect(this, &renderer::frame_end);
 	windows_.clear();
 	windows_pending_addition_.clear();
+	skinning_cache_.dispose();
 	gfx::shutdown();
 }
 
@@ -147,6 +176,16 @@ bool renderer::init_backend(cmd_line::parser& parser)
 
 	gfx::set_platform_data(pd);
 
+	// rendering a frame before init makes this thread the render thread, the
+	// draws are then issued in gfx::frame, for debugging or the targets
+	// without threads
+	bool single_threaded = false;
+	parser.try_get("single_threaded_render", single_threaded);
+	if(single_threaded)
+	{
+		gfx::render_frame();
+	}
+
 	// auto detect
 	auto preferred_renderer_type = gfx::renderer_type::Count;
 
@@ -169,20 +208,33 @@ bool renderer::init_backend(cmd_line::parser& parser)
 		{
 			preferred_renderer_type = gfx::renderer_type::Direct3D12;
 		}
+		else if(preferred_renderer == "noop")
+		{
+			// nothing is drawn, for the runs timing the cpu side only
+			preferred_renderer_type = gfx::renderer_type::Noop;
+		}
 	}
 
 	gfx::init_type init_data;
 	init_data.type = preferred_renderer_type;
 	init_data.resolution.width = sz[0];
 	init_data.resolution.height = sz[1];
-	init_data.resolution.reset = BGFX_RESET_VSYNC;
 
 	bool novsync = false;
 	parser.try_get("novsync", novsync);
-	if(novsync)
-	{
-		init_data.resolution.reset = 0;
-	}
+	present_.vsync = !novsync;
+	parser.try_get("adaptive_vsync", present_.adaptive_vsync);
+	parser.try_get("flush_after_render", present_.flush_after_render);
+	parser.try_get("late_input", present_.sample_input_late);
+	int max_frame_latency = 0;
+	parser.try_get("max_frame_latency", max_frame_latency);
+	present_.max_frame_latency = std::uint32_t(std::max(max_frame_latency, 0));
+
+	render_thread_stats_.vsync = present_.vsync;
+	init_data.resolution.reset = get_reset_flags(present_.vsync, present_.flush_after_render);
+	init_data.resolution.maxFrameLatency = std::uint8_t(std::min(present_.max_frame_latency, 255u));
+	reset_width_ = sz[0];
+	reset_height_ = sz[1];
 	if(!gfx::init(init_data))
 	{
 		APPLOG_ERROR("Could not initialize rendering backend!");
@@ -196,6 +248,10 @@ bool renderer::init_backend(cmd_line::parser& parser)
 
 	APPLOG_INFO("Using {0} rendering backend.", gfx::get_renderer_name(gfx::get_renderer_type()));
 
+	render_thread_stats_.threaded = gfx::is_supported(BGFX_CAPS_RENDERER_MULTITHREADED);
+	APPLOG_INFO("Issuing the draws on {0}.",
+				render_thread_stats_.threaded ? "a render thread" : "the main thread");
+
 	if(gfx::get_renderer_type() == gfx::renderer_type::Direct3D12)
 	{
 		APPLOG_WARNING("Directx 12 support is experimental and unstable.");
@@ -204,14 +260,118 @@ bool renderer::init_backend(cmd_line::parser& parser)
 	return true;
 }
 
+void renderer::set_present_settings(const present_settings& settings)
+{
+	present_ = settings;
+	render_thread_stats_.vsync = present_.vsync;
+	refresh_interval_ = std::chrono::steady_clock::duration::max();
+	mismatched_frames_ = 0;
+	late_input_wait_ms_ = 0.0f;
+	reset_backend();
+}
+
+void renderer::reset_backend()
+{
+	gfx::reset(reset_width_, reset_height_,
+			   get_reset_flags(render_thread_stats_.vsync, present_.flush_after_render));
+}
+
+void renderer::sample_input()
+{
+	if(present_.sample_input_late && render_thread_stats_.threaded)
+	{
+		// the wait moves from gfx::frame to here, a margin of it is left there
+		late_input_wait_ms_ += render_thread_stats_.wait_render_ms - late_input_margin_ms;
+		late_input_wait_ms_ = std::max(0.0f, std::min(late_input_wait_ms_, 100.0f));
+		if(late_input_wait_ms_ > 0.0f)
+		{
+			PROFILE_SCOPE("late_input_wait");
+			std::this_thread::sleep_for(std::chrono::duration<float, std::milli>(late_input_wait_ms_));
+		}
+	}
+
+	input_sampled_ = std::chrono::steady_clock::now();
+}
+
+void renderer::update_adaptive_vsync()
+{
+	const auto now = std::chrono::steady_clock::now();
+	const auto last = last_frame_end_;
+	last_frame_end_ = now;
+	if(!present_.adaptive_vsync || !present_.vsync || last == std::chrono::steady_clock::time_point{})
+	{
+		return;
+	}
+
+	const auto interval = now - last;
+	if(render_thread_stats_.vsync)
+	{
+		refresh_interval_ = std::min(refresh_interval_, interval);
+	}
+	if(refresh_interval_ == std::chrono::steady_clock::duration::max())
+	{
+		return;
+	}
+
+	// on the vertical blank a frame that misses it takes two refreshes, off
+	// it the frames that keep up come faster than the display
+	const bool mismatched = render_thread_stats_.vsync ? interval > refresh_interval_ * 3 / 2
+													   : interval < refresh_interval_ * 9 / 10;
+	mismatched_frames_ = mismatched ? mismatched_frames_ + 1 : 0;
+	if(mismatched_frames_ >= adaptive_vsync_frames)
+	{
+		mismatched_frames_ = 0;
+		render_thread_stats_.vsync = !render_thread_stats_.vsync;
+		reset_backend();
+	}
+}
+
 void renderer::frame_end(delta_t /*unused*/)
 {
 	gfx::render_pass pass("init_bb_update");
 	pass.bind();
 	pass.clear();
 
+	gfx::render_pass::submit_order();
+	const auto input_sampled = input_sampled_;
 	render_frame_ = gfx::frame();
+	gfx::destroy_queue::process(render_frame_);
+
+	// with a render thread the frame issued by now is the one before
+	auto issued_input_sampled = input_sampled;
+	if(render_thread_stats_.threaded)
+	{
+		issued_input_sampled = submitted_input_sampled_;
+		submitted_input_sampled_ = input_sampled;
+	}
+
+	const auto stats = gfx::get_stats();
+	if(stats && stats->cpuTimerFreq > 0)
+	{
+		const double to_cpu_ms = 1000.0 / double(stats->cpuTimerFreq);
+		render_thread_stats_.wait_render_ms = float(double(stats->waitRender) * to_cpu_ms);
+		render_thread_stats_.wait_submit_ms = float(double(stats->waitSubmit) * to_cpu_ms);
+
+		if(issued_input_sampled != std::chrono::steady_clock::time_point{})
+		{
+			const auto to_gpu_ms = stats->gpuTimerFreq > 0 ? 1000.0 / double(stats->gpuTimerFreq) : 0.0;
+			const auto gpu_ms = double(stats->gpuTimeEnd - stats->gpuTimeBegin) * to_gpu_ms;
+			const std::chrono::duration<double, std::milli> issued =
+				std::chrono::steady_clock::now() - issued_input_sampled;
+			render_thread_stats_.input_to_photon_ms = float(issued.count() + gpu_ms);
+		}
+	}
+	update_adaptive_vsync();
+	skinning_cache_.clear();
 
 	gfx::render_pass::reset();
+	const auto view_stats = gfx::render_pass::get_frame_stats();
+	if(view_stats.overflows > 0 && !views_overflowed_)
+	{
+		APPLOG_WARNING("The frame took {0} views, more than there are, it was submitted {1} more times.",
+					   view_stats.views, view_stats.overflows);
+	}
+	views_overflowed_ = view_stats.overflows > 0;
+	gfx::render_view::collect_transient_textures();
 }
 } // namespace runtime
@@ -1,14 +1,73 @@
 #pragma once
 #include "render_window.h"
+#include "skinning_cache.h"
 
 #include <core/cmd_line/parser.hpp>
 #include <core/common/basetypes.hpp>
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 namespace runtime
 {
+/*
+ * render_thread_stats; how the frames of the main thread and the render
+ * thread overlapped in the last frame.
+ */
+struct render_thread_stats
+{
+	/// false when the draws are issued on the main thread in gfx::frame
+	bool threaded = false;
+	/// ms the main thread waited in gfx::frame for the render thread to
+	/// finish issuing the frame before
+	float wait_render_ms = 0.0f;
+	/// ms the render thread waited for the main thread to submit a frame
+	float wait_submit_ms = 0.0f;
+	/// ms from the sampling of the input of the last frame issued to the end
+	/// of its gpu work, the wait for the display to scan it out is not in
+	float input_to_photon_ms = 0.0f;
+	/// whether the frames are presented on the vertical blank right now
+	bool vsync = false;
+};
+
+/*
+ * present_settings; how the frames are presented and how far the cpu may
+ * run ahead of the display.
+ *
+ *      The adaptive vsync presents on the vertical blank while the frames
+ *      keep up with the display, and right away while they do not, so that
+ *      a frame that misses the blank tears instead of waiting a whole
+ *      refresh. The backend has no swap that does it, the renderer switches
+ *      the vsync after a number of frames that kept up or missed. The late
+ *      input sampling makes the main thread wait, before the input of a
+ *      frame is sampled, for as long as it waited on the render thread the
+ *      frame before, so that the frame is recorded with the freshest input
+ *      and handed over just as the render thread can take it.
+ */
+struct present_settings
+{
+	bool vsync = true;
+	bool adaptive_vsync = false;
+	/// the backend flushes the command queue of the graphics api after every
+	/// frame, the gpu starts on it at once
+	bool flush_after_render = false;
+	/// frames the graphics api may queue ahead of the display, 0 is its
+	/// default. A change applies from the next start.
+	std::uint32_t max_frame_latency = 0;
+	bool sample_input_late = false;
+};
+
+/*
+ * renderer; the backend and the windows.
+ *
+ *      The frame is split between two threads. The main thread updates and
+ *      records the views into the command buffer of the backend, then
+ *      gfx::frame hands that buffer over as the snapshot of the frame. The
+ *      render thread issues it to the graphics api while the main thread
+ *      updates and records the next frame.
+ */
 struct renderer
 {
 	renderer(cmd_line::parser& parser);
@@ -47,6 +106,50 @@ struct renderer
 		return render_frame_;
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : get_render_thread_stats ()
+	/// <summary>
+	/// The waits of the main and the render thread in the last frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline const render_thread_stats& get_render_thread_stats() const
+	{
+		return render_thread_stats_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_present_settings ()
+	/// <summary>
+	/// Resets the backend with the flags of the settings.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_present_settings(const present_settings& settings);
+
+	inline const present_settings& get_present_settings() const
+	{
+		return present_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : sample_input ()
+	/// <summary>
+	/// Called right before the input of the frame is sampled. Waits first if
+	/// the input is sampled late, and notes the time for the latency.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void sample_input();
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_skinning_cache ()
+	/// <summary>
+	/// The skinning matrices computed in the frame, shared by its passes.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline skinning_cache& get_skinning_cache()
+	{
+		return skinning_cache_;
+	}
+
 	//-----------------------------------------------------------------------------
 	//  Name : register_window ()
 	/// <summary>
@@ -85,7 +188,31 @@ struct renderer
 						 const std::vector<mml::platform_event>& events);
 
 protected:
+	void reset_backend();
+	void update_adaptive_vsync();
+
 	std::uint32_t render_frame_ = 0;
+	render_thread_stats render_thread_stats_;
+	present_settings present_;
+	/// the size the backend was reset with, that of the init window
+	std::uint32_t reset_width_ = 0;
+	std::uint32_t reset_height_ = 0;
+	/// when the input of the frame being recorded and of the one submitted
+	/// before it were sampled
+	std::chrono::steady_clock::time_point input_sampled_{};
+	std::chrono::steady_clock::time_point submitted_input_sampled_{};
+	/// ms waited before the input is sampled late
+	float late_input_wait_ms_ = 0.0f;
+	/// the adaptive vsync: the last frame end, the shortest interval with the
+	/// vsync on taken as the refresh, and the frames in a row that did not
+	/// match the vsync as it is
+	std::chrono::steady_clock::time_point last_frame_end_{};
+	std::chrono::steady_clock::duration refresh_interval_ = std::chrono::steady_clock::duration::max();
+	std::uint32_t mismatched_frames_ = 0;
+	/// whether the views ran out in the last frame, warned about once
+	bool views_overflowed_ = false;
+	/// skinning matrices in the transform cache of the frame being recorded
+	skinning_cache skinning_cache_;
 
 	/// engine windows
 	std::unique_ptr<mml::window> init_window_;
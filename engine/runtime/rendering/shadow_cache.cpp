@@ -0,0 +1,128 @@
+#include "shadow_cache.h"
+
+#include <algorithm>
+
+constexpr std::uint32_t shadow_cache::max_views;
+
+void shadow_cache::set_light(std::uint64_t light, std::uint32_t views_count, std::uint64_t frame)
+{
+	if(views_count < 1)
+	{
+		views_count = 1;
+	}
+	if(views_count > max_views)
+	{
+		views_count = max_views;
+	}
+
+	auto& e = lights_[light];
+	e.seen = true;
+	if(e.views_count != views_count)
+	{
+		e.views_count = views_count;
+		e.invalid = 0;
+		invalidate(light, ~0u, frame);
+	}
+}
+
+void shadow_cache::invalidate(std::uint64_t light, std::uint32_t view_mask, std::uint64_t frame)
+{
+	auto it = lights_.find(light);
+	if(it == lights_.end())
+	{
+		return;
+	}
+
+	auto& e = it->second;
+	const std::uint32_t all = (1u << e.views_count) - 1;
+	// the views invalid already keep their frame so they are not starved
+	const std::uint32_t fresh = view_mask & all & ~e.invalid;
+	for(std::uint32_t view = 0; view < e.views_count; ++view)
+	{
+		if(fresh & (1u << view))
+		{
+			e.invalidated[view] = frame;
+		}
+	}
+	e.invalid |= fresh;
+}
+
+void shadow_cache::set_dynamic(std::uint64_t light, std::uint32_t view_mask)
+{
+	auto it = lights_.find(light);
+	if(it != lights_.end())
+	{
+		it->second.dynamic = view_mask & ((1u << it->second.views_count) - 1);
+	}
+}
+
+std::uint32_t shadow_cache::get_dynamic(std::uint64_t light) const
+{
+	auto it = lights_.find(light);
+	return it != lights_.end() ? it->second.dynamic : 0;
+}
+
+std::uint32_t shadow_cache::get_invalid(std::uint64_t light) const
+{
+	auto it = lights_.find(light);
+	return it != lights_.end() ? it->second.invalid : 0;
+}
+
+void shadow_cache::prune()
+{
+	for(auto it = lights_.begin(); it != lights_.end();)
+	{
+		if(!it->second.seen)
+		{
+			it = lights_.erase(it);
+			continue;
+		}
+		it->second.seen = false;
+		++it;
+	}
+}
+
+void shadow_cache::schedule(std::vector<refresh>& refreshes)
+{
+	refreshes.clear();
+	candidates_.clear();
+	for(const auto& pair : lights_)
+	{
+		const auto& e = pair.second;
+		for(std::uint32_t view = 0; view < e.views_count; ++view)
+		{
+			if(e.invalid & (1u << view))
+			{
+				refresh r;
+				r.light = pair.first;
+				r.view = view;
+				candidates_.emplace_back(e.invalidated[view], r);
+			}
+		}
+	}
+
+	// the oldest first, the light and the view break the ties so the order
+	// does not depend on the order of the map
+	const auto count = std::min(budget_, candidates_.size());
+	const auto less = [](const std::pair<std::uint64_t, refresh>& a,
+						 const std::pair<std::uint64_t, refresh>& b) {
+		if(a.first != b.first)
+		{
+			return a.first < b.first;
+		}
+		if(a.second.light != b.second.light)
+		{
+			return a.second.light < b.second.light;
+		}
+		return a.second.view < b.second.view;
+	};
+	std::partial_sort(candidates_.begin(), candidates_.begin() + std::ptrdiff_t(count), candidates_.end(),
+					  less);
+
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		const auto& r = candidates_[i].second;
+		lights_[r.light].invalid &= ~(1u << r.view);
+		refreshes.push_back(r);
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * shadow_cache; which shadow views of the lights are up to date and which
+ * are rendered in a frame.
+ *
+ *      A light has one view per cube face, per cascade or a single one. The
+ *      depth of the static casters of a view is kept until one of them
+ *      changes in it, only then is the view invalidated. The dynamic casters
+ *      are drawn over a copy of the static depth every frame they are in the
+ *      view. Refreshing the static depth is time sliced: at most the budget
+ *      of views is scheduled in a frame, those invalidated first go first.
+ */
+class shadow_cache
+{
+public:
+	static constexpr std::uint32_t max_views = 6;
+
+	struct refresh
+	{
+		std::uint64_t light = 0;
+		std::uint32_t view = 0;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_light ()
+	/// <summary>
+	/// Keeps a light with its number of views for this frame. A new light or
+	/// one whose number of views changed has all its views invalidated.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_light(std::uint64_t light, std::uint32_t views_count, std::uint64_t frame);
+
+	//-----------------------------------------------------------------------------
+	//  Name : invalidate ()
+	/// <summary>
+	/// Marks the static depth of the views in view_mask out of date. A view
+	/// that already is keeps the frame it was first invalidated in.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void invalidate(std::uint64_t light, std::uint32_t view_mask, std::uint64_t frame);
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_dynamic ()
+	/// <summary>
+	/// The views that have dynamic casters in this frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_dynamic(std::uint64_t light, std::uint32_t view_mask);
+
+	std::uint32_t get_dynamic(std::uint64_t light) const;
+	std::uint32_t get_invalid(std::uint64_t light) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : prune ()
+	/// <summary>
+	/// Forgets the lights that were not set since the last prune.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void prune();
+
+	//-----------------------------------------------------------------------------
+	//  Name : schedule ()
+	/// <summary>
+	/// Fills refreshes with at most budget of the invalid views, oldest first,
+	/// and marks them up to date.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void schedule(std::vector<refresh>& refreshes);
+
+	void set_budget(std::size_t budget)
+	{
+		budget_ = budget;
+	}
+
+	std::size_t get_budget() const
+	{
+		return budget_;
+	}
+
+	std::size_t size() const
+	{
+		return lights_.size();
+	}
+
+private:
+	struct entry
+	{
+		std::uint32_t views_count = 0;
+		std::uint32_t invalid = 0;
+		std::uint32_t dynamic = 0;
+		/// frame each invalid view was invalidated in
+		std::array<std::uint64_t, max_views> invalidated{};
+		bool seen = false;
+	};
+
+	std::unordered_map<std::uint64_t, entry> lights_;
+	/// shadow views refreshed in a frame
+	std::size_t budget_ = 4;
+	/// scratch of schedule
+	std::vector<std::pair<std::uint64_t, refresh>> candidates_;
+};
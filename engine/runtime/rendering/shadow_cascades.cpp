@@ -0,0 +1,132 @@
+#include "shadow_cascades.h"
+
+#include <algorithm>
+#include <cmath>
+
+constexpr std::uint32_t shadow_cascades::max_cascades;
+
+void shadow_cascades::compute_splits(float near_clip, float far_clip, std::uint32_t count, float distribution,
+									 float* splits)
+{
+	near_clip = std::max(near_clip, 0.001f);
+	far_clip = std::max(far_clip, near_clip);
+	const float ratio = far_clip / near_clip;
+	splits[0] = near_clip;
+	for(std::uint32_t i = 1; i < count; ++i)
+	{
+		const float t = float(i) / float(count);
+		const float logarithmic = near_clip * std::pow(ratio, t);
+		const float uniform = near_clip + (far_clip - near_clip) * t;
+		splits[i] = distribution * logarithmic + (1.0f - distribution) * uniform;
+	}
+	splits[count] = far_clip;
+}
+
+bool shadow_cascades::is_due(std::uint32_t i, std::uint64_t frame) const
+{
+	if(!settings_.staggered || i < 2 || (valid_ & (1u << i)) == 0)
+	{
+		return true;
+	}
+
+	// 2, 4, 8 frames for the third cascade on, offset so they don't all
+	// come due in the same frame
+	const std::uint64_t period = std::uint64_t(1) << (i - 1);
+	return (frame + i) % period == 0;
+}
+
+std::uint32_t shadow_cascades::update(const camera& view, const math::vec3& direction, std::uint32_t count,
+									  float distribution, bool stabilize, std::uint64_t frame)
+{
+	count = std::max<std::uint32_t>(1, std::min(count, max_cascades));
+	if(count != count_)
+	{
+		count_ = count;
+		valid_ = 0;
+	}
+
+	float splits[max_cascades + 1];
+	const float far_clip = std::min(view.get_far_clip(), settings_.max_distance);
+	compute_splits(view.get_near_clip(), far_clip, count, distribution, splits);
+
+	// the slices are along the view axis
+	const auto world = math::inverse(view.get_view());
+	const auto position = world.get_position();
+	const auto z_axis = world.z_unit_axis();
+	const bool perspective = view.get_projection_mode() == projection_mode::perspective;
+	const float tan_y = perspective ? std::tan(math::radians(view.get_fov()) * 0.5f) : 0.0f;
+	const float tan_x = tan_y * view.get_aspect_ratio();
+	const float ortho_y = view.get_ortho_size();
+	const float ortho_x = ortho_y * view.get_aspect_ratio();
+
+	const auto up =
+		std::abs(direction.y) > 0.99f ? math::vec3(0.0f, 0.0f, 1.0f) : math::vec3(0.0f, 1.0f, 0.0f);
+	const auto light_x = math::normalize(math::cross(up, direction));
+	const auto light_y = math::cross(direction, light_x);
+	const float resolution = float(std::max<std::uint32_t>(settings_.resolution, 1));
+
+	std::uint32_t moved = 0;
+	for(std::uint32_t i = 0; i < count; ++i)
+	{
+		auto& c = cascades_[i];
+		c.far_split = splits[i + 1];
+		if(!is_due(i, frame))
+		{
+			continue;
+		}
+
+		const float near_split = splits[i];
+		const float far_split = splits[i + 1];
+		const float near_x = perspective ? near_split * tan_x : ortho_x;
+		const float near_y = perspective ? near_split * tan_y : ortho_y;
+		const float far_x = perspective ? far_split * tan_x : ortho_x;
+		const float far_y = perspective ? far_split * tan_y : ortho_y;
+
+		// the sphere through the slice, its radius only depends on the
+		// distances and the projection so it holds while the view turns
+		const float near_sq = near_x * near_x + near_y * near_y;
+		const float far_sq = far_x * far_x + far_y * far_y;
+		const float depth = far_split - near_split;
+		const float offset = math::clamp((far_sq - near_sq + depth * depth) / (2.0f * depth), 0.0f, depth);
+		const float center_depth = near_split + offset;
+		const float far_offset = depth - offset;
+		float radius = std::sqrt(std::max(offset * offset + near_sq, far_offset * far_offset + far_sq));
+		// rounded up so the error of the math above does not change it
+		radius = std::ceil(radius * 16.0f) / 16.0f;
+
+		auto center = position + z_axis * center_depth;
+		if(stabilize)
+		{
+			// move the center in whole texels across the light
+			const float texel = 2.0f * radius / resolution;
+			const float x = math::dot(center, light_x);
+			const float y = math::dot(center, light_y);
+			center += light_x * (std::floor(x / texel) * texel - x);
+			center += light_y * (std::floor(y / texel) * texel - y);
+		}
+
+		const bool valid = (valid_ & (1u << i)) != 0;
+		if(valid && c.center == center && c.radius == radius && c.direction == direction)
+		{
+			continue;
+		}
+
+		c.center = center;
+		c.radius = radius;
+		c.direction = direction;
+
+		const float back = radius + settings_.caster_distance;
+		c.cam.set_projection_mode(projection_mode::orthographic);
+		c.cam.set_viewport_size({settings_.resolution, settings_.resolution});
+		c.cam.set_orthographic_size(radius);
+		c.cam.set_far_clip(back + radius);
+		c.cam.set_near_clip(0.0f);
+		c.cam.look_at(center - direction * back, center, light_y);
+		frustums_[i] = c.cam.get_frustum();
+
+		valid_ |= 1u << i;
+		moved |= 1u << i;
+	}
+
+	return moved;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "camera.h"
+
+#include <array>
+#include <cstdint>
+
+/*
+ * shadow_cascades; the cascades of a directional light over a view.
+ *
+ *      The view is split in depth by the practical scheme, a blend of the
+ *      logarithmic and the uniform split. Every slice is bounded by a
+ *      sphere, so the size of a cascade does not change when the view
+ *      turns, and its center is snapped to the texels of the shadow map in
+ *      light space, so a moving view does not make the edges shimmer. As a
+ *      result a cascade only really moves a texel at a time and keeps its
+ *      camera, with its version and frustum, while it does not. The far
+ *      cascades can be staggered: cascade i is updated every 2^(i - 1)
+ *      frames from the third on.
+ */
+class shadow_cascades
+{
+public:
+	static constexpr std::uint32_t max_cascades = 6;
+
+	struct settings
+	{
+		/// texels of a side of a cascade's shadow map
+		std::uint32_t resolution = 2048;
+		/// the view is shadowed to this distance or its far clip if nearer
+		float max_distance = 150.0f;
+		/// how far behind a slice the casters are still drawn
+		float caster_distance = 100.0f;
+		/// update the far cascades every few frames
+		bool staggered = true;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : compute_splits () (Static)
+	/// <summary>
+	/// Fills splits[0..count] with the distances the view is cut at, from
+	/// near to far. distribution blends the uniform split at 0 with the
+	/// logarithmic one at 1.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void compute_splits(float near_clip, float far_clip, std::uint32_t count, float distribution,
+							   float* splits);
+
+	//-----------------------------------------------------------------------------
+	//  Name : update ()
+	/// <summary>
+	/// Fits count cascades (at most max_cascades) of the light shining along
+	/// direction to the view. Returns the mask of the cascades that moved,
+	/// their shadow maps are out of date. Without stabilize the cascades are
+	/// fit to their slices every frame and only the snapping is skipped.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint32_t update(const camera& view, const math::vec3& direction, std::uint32_t count,
+						 float distribution, bool stabilize, std::uint64_t frame);
+
+	void set_settings(const settings& s)
+	{
+		settings_ = s;
+		valid_ = 0;
+	}
+
+	const settings& get_settings() const
+	{
+		return settings_;
+	}
+
+	std::uint32_t get_count() const
+	{
+		return count_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_camera ()
+	/// <summary>
+	/// The orthographic camera of cascade i, from the light.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const camera& get_camera(std::uint32_t i) const
+	{
+		return cascades_[i].cam;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_frustums ()
+	/// <summary>
+	/// The frustums of the cameras side by side, for the multi view culls.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const math::frustum* get_frustums() const
+	{
+		return frustums_.data();
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_split ()
+	/// <summary>
+	/// The view distance cascade i reaches to, for the lighting to pick it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	float get_split(std::uint32_t i) const
+	{
+		return cascades_[i].far_split;
+	}
+
+private:
+	struct cascade
+	{
+		camera cam;
+		math::vec3 center = {0.0f, 0.0f, 0.0f};
+		math::vec3 direction = {0.0f, 0.0f, 0.0f};
+		float radius = 0.0f;
+		float far_split = 0.0f;
+	};
+
+	bool is_due(std::uint32_t i, std::uint64_t frame) const;
+
+	settings settings_;
+	std::array<cascade, max_cascades> cascades_;
+	std::array<math::frustum, max_cascades> frustums_;
+	std::uint32_t count_ = 0;
+	/// the cascades fit at least once since the count or settings changed
+	std::uint32_t valid_ = 0;
+};
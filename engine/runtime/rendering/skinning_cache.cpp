@@ -0,0 +1,258 @@
+#include "skinning_cache.h"
+#include "gpu_program.h"
+#include "mesh.h"
+
+#include <core/graphics/destroy_queue.h>
+#include <core/graphics/index_buffer.h>
+#include <core/graphics/render_pass.h>
+#include <core/graphics/vertex_buffer.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace
+{
+// the float4 of a vertex the skinning writes, what vs_deferred_geom reads
+const gfx::vertex_layout& get_output_format()
+{
+	static const gfx::vertex_layout format = []() {
+		gfx::vertex_layout result;
+		result.begin()
+			.add(gfx::attribute::Position, 4, gfx::attribute_type::Float)
+			.add(gfx::attribute::Normal, 4, gfx::attribute_type::Float)
+			.add(gfx::attribute::Tangent, 4, gfx::attribute_type::Float)
+			.add(gfx::attribute::Bitangent, 4, gfx::attribute_type::Float)
+			.add(gfx::attribute::TexCoord0, 4, gfx::attribute_type::Float)
+			.end();
+		return result;
+	}();
+	return format;
+}
+
+const gfx::vertex_layout& get_matrix_format()
+{
+	static const gfx::vertex_layout format = []() {
+		gfx::vertex_layout result;
+		result.begin().add(gfx::attribute::TexCoord0, 4, gfx::attribute_type::Float).end();
+		return result;
+	}();
+	return format;
+}
+
+// the dispatches of the frame share one view, before the passes drawing them
+constexpr std::int32_t skinning_order = -1;
+constexpr std::uint64_t skinning_merge_key = 0x736b696e;
+constexpr std::uint32_t skinning_threads = 64;
+}
+
+std::size_t skinning_cache::key_hash::operator()(const key& k) const
+{
+	auto seed = std::hash<const void*>()(k.bone_transforms);
+	seed ^= std::hash<const void*>()(k.m) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	seed ^= std::hash<std::size_t>()(k.palette) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	return seed;
+}
+
+skinning_cache::entry skinning_cache::get(mesh& m, std::size_t palette,
+										  const std::vector<math::transform>& bone_transforms)
+{
+	const key k{&bone_transforms, &m, palette};
+	auto it = entries_.find(k);
+	if(it != entries_.end())
+	{
+		return it->second;
+	}
+
+	entry result = compute(m, palette, bone_transforms);
+	if(result.is_computed())
+	{
+		entries_.emplace(k, result);
+		return result;
+	}
+
+	const auto& palettes = m.get_bone_palettes();
+	if(palette < palettes.size() && !bone_transforms.empty())
+	{
+		const auto& bones = palettes[palette].get_bones();
+		const auto& bind_list = m.get_skin_bind_data().get_bones();
+		const auto count = static_cast<std::uint16_t>(bones.size());
+
+		// the transform cache may be full, the palette is not drawn then
+		gfx::transform cached;
+		if(count > 0 && bones.size() == count)
+		{
+			result.cache = gfx::alloc_transform(&cached, count);
+			if(cached.num == count)
+			{
+				using mat_type = math::transform::mat4_t;
+				for(std::uint16_t i = 0; i < count; ++i)
+				{
+					const auto bone = bones[i];
+					const mat_type skinning = bone_transforms[bone].get_matrix() *
+											  bind_list[bone].bind_pose_transform.get_matrix();
+					std::memcpy(cached.data + std::size_t(i) * 16, &skinning, sizeof(mat_type));
+				}
+				result.count = count;
+			}
+		}
+	}
+
+	entries_.emplace(k, result);
+	return result;
+}
+
+skinning_cache::entry skinning_cache::compute(mesh& m, std::size_t palette,
+											  const std::vector<math::transform>& bone_transforms)
+{
+	entry result;
+	const auto& palettes = m.get_bone_palettes();
+	if(compute_program_ == nullptr || palette >= palettes.size() || bone_transforms.empty())
+	{
+		return result;
+	}
+
+	const auto& bones = palettes[palette].get_bones();
+	const auto* subset = m.get_subset(palettes[palette].get_data_group());
+	const auto& buffers = m.get_skinning_buffers();
+	const auto count = static_cast<std::uint16_t>(bones.size());
+	if(count == 0 || bones.size() != count || subset == nullptr || subset->vertex_count == 0 ||
+	   !buffers.vertices || !buffers.indices)
+	{
+		return result;
+	}
+
+	if(!compute_program_->begin())
+	{
+		return result;
+	}
+
+	// a larger buffer for the rest of the frame, the palettes computed before
+	// keep reading the one they were dispatched with
+	if((matrices_used_ + count) * 4 > matrices_capacity_)
+	{
+		if(bgfx::isValid(matrices_))
+		{
+			gfx::destroy_queue::push(matrices_);
+		}
+		matrices_capacity_ = std::max((matrices_used_ + count) * 8, 1024u);
+		matrices_ = gfx::create_dynamic_vertex_buffer(matrices_capacity_, get_matrix_format(),
+													  BGFX_BUFFER_COMPUTE_READ);
+		matrices_used_ = 0;
+	}
+
+	using mat_type = math::transform::mat4_t;
+	const auto& bind_list = m.get_skin_bind_data().get_bones();
+	const auto* mem = gfx::alloc(std::uint32_t(count * sizeof(mat_type)));
+	for(std::uint16_t i = 0; i < count; ++i)
+	{
+		const auto bone = bones[i];
+		const mat_type skinning =
+			bone_transforms[bone].get_matrix() * bind_list[bone].bind_pose_transform.get_matrix();
+		std::memcpy(mem->data + std::size_t(i) * sizeof(mat_type), &skinning, sizeof(mat_type));
+	}
+	const auto first = matrices_used_;
+	gfx::update(matrices_, first * 4, mem);
+	matrices_used_ += count;
+
+	auto& out = outputs_[key{&bone_transforms, &m, 0}];
+	if(!bgfx::isValid(out.vertices) || out.vertex_count != m.get_vertex_count())
+	{
+		if(bgfx::isValid(out.vertices))
+		{
+			gfx::destroy_queue::push(out.vertices);
+		}
+		out.vertex_count = m.get_vertex_count();
+		out.vertices = gfx::create_dynamic_vertex_buffer(out.vertex_count, get_output_format(),
+														 BGFX_BUFFER_COMPUTE_WRITE);
+	}
+	out.used = true;
+
+	gfx::render_pass pass("skinning", skinning_order, skinning_merge_key);
+	pass.touch();
+	compute_program_->set_uniform("u_skinning_params", math::vec4(float(subset->vertex_start),
+																  float(subset->vertex_count),
+																  float(first), 0.0f));
+	gfx::set_buffer(0, buffers.vertices->native_handle(), gfx::access::Read);
+	gfx::set_buffer(1, matrices_, gfx::access::Read);
+	gfx::set_buffer(2, out.vertices, gfx::access::Write);
+	const auto groups = (subset->vertex_count + skinning_threads - 1) / skinning_threads;
+	gfx::dispatch(pass.id, compute_program_->native_handle(), groups, 1, 1);
+	compute_program_->end();
+
+	result.count = count;
+	result.vertices = out.vertices;
+	return result;
+}
+
+void skinning_cache::bind(mesh& m, std::uint32_t data_group_id, const entry& e)
+{
+	const auto* subset = m.get_subset(data_group_id);
+	const auto& buffers = m.get_skinning_buffers();
+	if(subset == nullptr || !buffers.indices)
+	{
+		return;
+	}
+
+	// the vertices are in the world already
+	static const math::transform::mat4_t identity(1.0f);
+	gfx::set_transform(&identity);
+	gfx::set_vertex_buffer(0, e.vertices, 0, m.get_vertex_count());
+	gfx::set_index_buffer(buffers.indices->native_handle(), std::uint32_t(subset->face_start) * 3,
+						  subset->face_count * 3);
+}
+
+void skinning_cache::set_compute_program(gpu_program* program)
+{
+	if(program == compute_program_)
+	{
+		return;
+	}
+
+	compute_program_ = program;
+	release_outputs();
+}
+
+void skinning_cache::clear()
+{
+	entries_.clear();
+	matrices_used_ = 0;
+
+	// the vertices of what was not drawn in the frame are let go
+	for(auto it = outputs_.begin(); it != outputs_.end();)
+	{
+		if(!it->second.used)
+		{
+			gfx::destroy_queue::push(it->second.vertices);
+			it = outputs_.erase(it);
+			continue;
+		}
+		it->second.used = false;
+		++it;
+	}
+}
+
+void skinning_cache::dispose()
+{
+	compute_program_ = nullptr;
+	release_outputs();
+	if(bgfx::isValid(matrices_))
+	{
+		gfx::destroy_queue::push(matrices_);
+		matrices_ = BGFX_INVALID_HANDLE;
+	}
+	matrices_capacity_ = 0;
+	matrices_used_ = 0;
+}
+
+void skinning_cache::release_outputs()
+{
+	// the entries of the frame may still point at the vertices, the queue
+	// keeps them until the frames in flight are done
+	for(const auto& output : outputs_)
+	{
+		gfx::destroy_queue::push(output.second.vertices);
+	}
+	outputs_.clear();
+	entries_.clear();
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <core/graphics/graphics.h>
+#include <core/math/math_includes.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class gpu_program;
+class mesh;
+
+/*
+ * skinning_cache; the skinning matrices of the palettes drawn in a frame.
+ *
+ *      The first pass drawing a palette of a set of bone transforms computes
+ *      its matrices into the transform cache of bgfx, which is uploaded once
+ *      with the frame. Any other pass drawing it in the frame, e.g. a probe
+ *      face or the picking, sets the same cached matrices by their index.
+ *      Cleared when the frame is submitted, the indices are only valid until
+ *      then.
+ *
+ *      With a compute program set the palettes are skinned once in the frame
+ *      instead, by a dispatch in a view running before the others, into
+ *      vertices in the world every pass draws as they are. The vertices of a
+ *      mesh skinned by a set of bone transforms are kept while it is drawn.
+ */
+class skinning_cache
+{
+public:
+	/// a range of the transform cache, no matrices when count is 0
+	struct entry
+	{
+		std::uint32_t cache = 0;
+		std::uint16_t count = 0;
+		/// the vertices skinned by compute, invalid when the vertex shader
+		/// skins them with the matrices of the cache
+		gfx::dynamic_vertex_buffer_handle vertices = BGFX_INVALID_HANDLE;
+
+		bool is_computed() const
+		{
+			return bgfx::isValid(vertices);
+		}
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : get ()
+	/// <summary>
+	/// The matrices of a palette of the mesh skinned by the bone transforms,
+	/// computed the first time they are asked for in the frame. Only called
+	/// from the thread submitting the frame, the entry can be set from any.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	entry get(mesh& m, std::size_t palette, const std::vector<math::transform>& bone_transforms);
+
+	//-----------------------------------------------------------------------------
+	//  Name : bind ()
+	/// <summary>
+	/// Sets the vertices a computed entry was skinned to and the indices of
+	/// the subset of the data group, drawn with the programs of the meshes
+	/// that are not skinned.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void bind(mesh& m, std::uint32_t data_group_id, const entry& e);
+
+	//-----------------------------------------------------------------------------
+	//  Name : set_compute_program ()
+	/// <summary>
+	/// The program skinning the palettes by compute, nullptr to skin them in
+	/// the vertex shaders. Not owned, it is set again before it is destroyed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void set_compute_program(gpu_program* program);
+
+	bool is_computing() const
+	{
+		return compute_program_ != nullptr;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : clear ()
+	/// <summary>
+	/// Forgets the entries once the frame is submitted.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void clear();
+
+	//-----------------------------------------------------------------------------
+	//  Name : dispose ()
+	/// <summary>
+	/// Lets go of the buffers of the compute skinning, before the shutdown.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void dispose();
+
+	/// palettes computed since the last clear
+	std::size_t size() const
+	{
+		return entries_.size();
+	}
+
+private:
+	struct key
+	{
+		const void* bone_transforms = nullptr;
+		const mesh* m = nullptr;
+		std::size_t palette = 0;
+
+		bool operator==(const key& other) const
+		{
+			return bone_transforms == other.bone_transforms && m == other.m && palette == other.palette;
+		}
+	};
+
+	struct key_hash
+	{
+		std::size_t operator()(const key& k) const;
+	};
+
+	/// the vertices of a mesh skinned by a set of bone transforms
+	struct output
+	{
+		gfx::dynamic_vertex_buffer_handle vertices = BGFX_INVALID_HANDLE;
+		std::uint32_t vertex_count = 0;
+		bool used = false;
+	};
+
+	entry compute(mesh& m, std::size_t palette, const std::vector<math::transform>& bone_transforms);
+	void release_outputs();
+
+	std::unordered_map<key, entry, key_hash> entries_;
+	gpu_program* compute_program_ = nullptr;
+	/// by the bone transforms and the mesh, the palette is 0
+	std::unordered_map<key, output, key_hash> outputs_;
+	/// the matrices of the palettes computed in the frame, four float4 each
+	gfx::dynamic_vertex_buffer_handle matrices_ = BGFX_INVALID_HANDLE;
+	std::uint32_t matrices_capacity_ = 0;
+	std::uint32_t matrices_used_ = 0;
+};
@@ -0,0 +1,60 @@
+#include "sky_view_lut.h"
+#include "gpu_program.h"
+
+#include <core/graphics/frame_buffer.h>
+#include <core/graphics/graphics.h>
+#include <core/graphics/render_pass.h>
+#include <core/graphics/texture.h>
+
+#include <vector>
+
+constexpr std::uint16_t sky_view_lut::width;
+constexpr std::uint16_t sky_view_lut::height;
+
+namespace
+{
+// a sun that turned less than about a quarter of a degree keeps the texture
+constexpr float min_sun_cos = 0.99999f;
+}
+
+bool sky_view_lut::update(const math::vec3& sun_direction, gpu_program* lut_program)
+{
+	if(!lut_program)
+		return false;
+
+	if(rendered_ && math::dot(sun_direction, sun_direction_) >= min_sun_cos)
+		return false;
+
+	if(!texture_)
+	{
+		static auto format = gfx::get_best_format(
+			BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER, gfx::format_search_flags::four_channels |
+													  gfx::format_search_flags::requires_alpha |
+													  gfx::format_search_flags::half_precision_float);
+
+		// the longitude wraps around, the latitude stops at the poles
+		texture_ = std::make_shared<gfx::texture>(width, height, false, 1, format,
+												   BGFX_TEXTURE_RT | BGFX_SAMPLER_V_CLAMP);
+		fbo_ = std::make_shared<gfx::frame_buffer>(std::vector<std::shared_ptr<gfx::texture>>{texture_});
+	}
+
+	gfx::render_pass pass("sky_view_lut");
+	pass.bind(fbo_.get());
+
+	lut_program->begin();
+	lut_program->set_uniform("u_light_direction", sun_direction);
+	auto topology = gfx::clip_quad(1.0f);
+	gfx::set_state(topology | BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A);
+	gfx::submit(pass.id, lut_program->native_handle());
+	gfx::set_state(BGFX_STATE_DEFAULT);
+	lut_program->end();
+
+	sun_direction_ = sun_direction;
+	rendered_ = true;
+	return true;
+}
+
+gfx::texture* sky_view_lut::get_texture() const
+{
+	return rendered_ ? texture_.get() : nullptr;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <core/math/math_includes.h>
+
+#include <cstdint>
+#include <memory>
+
+class gpu_program;
+
+namespace gfx
+{
+struct texture;
+class frame_buffer;
+}
+
+/*
+ * sky_view_lut; the scattering of the atmosphere for every direction around
+ * the viewer in a small texture, shared by the views of a frame.
+ *
+ *      The texture is latitude by longitude, with more of its rows near the
+ *      horizon where the sky changes the most. It only depends on the
+ *      direction of the sun, so it is rendered again when that moves and the
+ *      views sample it instead of marching the atmosphere per pixel. The sun
+ *      spot is too sharp for it and is added by the views that want it.
+ */
+class sky_view_lut
+{
+public:
+	static constexpr std::uint16_t width = 192;
+	static constexpr std::uint16_t height = 96;
+
+	//-----------------------------------------------------------------------------
+	//  Name : update ()
+	/// <summary>
+	/// Renders the texture for the direction of the sun when it moved since
+	/// the last time, or was never rendered. Returns true when it was.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool update(const math::vec3& sun_direction, gpu_program* lut_program);
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_texture ()
+	/// <summary>
+	/// The texture, null until rendered the first time.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	gfx::texture* get_texture() const;
+
+	const math::vec3& get_sun_direction() const
+	{
+		return sun_direction_;
+	}
+
+private:
+	std::shared_ptr<gfx::texture> texture_;
+	std::shared_ptr<gfx::frame_buffer> fbo_;
+	/// the direction the texture was rendered for
+	math::vec3 sun_direction_ = math::vec3(0.0f, -1.0f, 0.0f);
+	bool rendered_ = false;
+};
@@ -0,0 +1,123 @@
+#include "texture_arrays.h"
+#include "../assets/asset_manager.h"
+#include "../system/events.h"
+
+#include <core/filesystem/archive.h>
+#include <core/graphics/graphics.h>
+#include <core/logging/logging.h>
+#include <core/system/subsystem.h>
+
+#include <fstream>
+#include <sstream>
+
+const char* const texture_arrays::table_key = "app:/cache/texture_arrays.asset";
+constexpr std::uint32_t texture_arrays::table_version;
+
+namespace
+{
+// the table from the archives mounted over the cache, or from the cache
+std::string read_table(const std::string& key)
+{
+	const auto mounted = fs::find_mounted(key);
+	if(mounted)
+	{
+		return std::string(reinterpret_cast<const char*>(mounted.data), mounted.size);
+	}
+
+	std::ifstream stream(fs::resolve_protocol(key).string(), std::ios::binary);
+	std::stringstream buffer;
+	buffer << stream.rdbuf();
+	return buffer.str();
+}
+}
+
+texture_arrays::texture_arrays()
+{
+	runtime::on_frame_begin.connect(this, &texture_arrays::frame_begin);
+}
+
+texture_arrays::~texture_arrays()
+{
+	runtime::on_frame_begin.disconnect(this, &texture_arrays::frame_begin);
+}
+
+bool texture_arrays::load(const std::string& key)
+{
+	arrays_.clear();
+	entries_.clear();
+	pending_ = 0;
+	++version_;
+
+	if(!gfx::is_supported(BGFX_CAPS_TEXTURE_2D_ARRAY))
+	{
+		return false;
+	}
+
+	// the version, then every array as its key, its count of layers and the
+	// keys of the maps in its layers, a line each
+	std::istringstream table(read_table(key));
+	std::uint32_t version = 0;
+	if(!(table >> version) || version != table_version || !table.ignore())
+	{
+		return false;
+	}
+
+	auto& am = core::get_subsystem<runtime::asset_manager>();
+	std::string array_key;
+	std::uint32_t layers = 0;
+	while(std::getline(table, array_key) && table >> layers && table.ignore())
+	{
+		const auto array_index = std::uint32_t(arrays_.size());
+		std::string map_key;
+		for(std::uint32_t i = 0; i < layers && std::getline(table, map_key); ++i)
+		{
+			entries_[map_key] = {array_index, i};
+		}
+
+		array a;
+		a.load = am.load<gfx::texture>(array_key);
+		arrays_.emplace_back(std::move(a));
+		++pending_;
+	}
+
+	APPLOG_INFO("{0} maps of the materials are in {1} texture arrays.", entries_.size(), arrays_.size());
+	return true;
+}
+
+bool texture_arrays::find(const std::string& map_key, layer& result) const
+{
+	auto it = entries_.find(map_key);
+	if(it == std::end(entries_))
+	{
+		return false;
+	}
+
+	const auto& a = arrays_[it->second.array];
+	if(!a.texture)
+	{
+		return false;
+	}
+
+	result.array = a.texture;
+	result.index = it->second.index;
+	return true;
+}
+
+void texture_arrays::frame_begin(delta_t /*dt*/)
+{
+	if(pending_ == 0)
+	{
+		return;
+	}
+
+	for(auto& a : arrays_)
+	{
+		if(a.load.valid() && a.load.is_ready())
+		{
+			a.texture = a.load.get();
+			a.load = {};
+			--pending_;
+			++version_;
+		}
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "../assets/asset_handle.h"
+
+#include <core/common/basetypes.hpp>
+#include <core/graphics/texture.h>
+#include <core/tasks/task_system.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * texture_arrays; the texture arrays the asset compiler packed the maps of
+ * the materials into, and the layer every map is in them, for the materials
+ * that differ only in their maps to be drawn in one instanced submit.
+ *
+ *      The compiler groups the color and normal maps of the same size, format
+ *      and mips of the standard materials of a project in arrays, and writes
+ *      a table of the layers next to the arrays. The table is read when the
+ *      project is, the arrays load with the other assets. A map is found in
+ *      an array once the array is in, until then the materials draw with the
+ *      map itself. The version changes with the arrays found, the materials
+ *      look their maps up again when it does.
+ */
+class texture_arrays
+{
+public:
+	/// where the compiler writes the table, next to the arrays
+	static const char* const table_key;
+	/// bumped when the table changes
+	static constexpr std::uint32_t table_version = 1;
+
+	/// the layer of a map in its array
+	struct layer
+	{
+		asset_handle<gfx::texture> array;
+		std::uint32_t index = 0;
+	};
+
+	texture_arrays();
+	~texture_arrays();
+
+	//-----------------------------------------------------------------------------
+	//  Name : load ()
+	/// <summary>
+	/// Reads the table and starts loading its arrays, in place of those of
+	/// the table read before. False when there is no table, or the renderer
+	/// samples no arrays.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool load(const std::string& key = table_key);
+
+	//-----------------------------------------------------------------------------
+	//  Name : find ()
+	/// <summary>
+	/// The array and layer of the map of the key, false when it is in no
+	/// array or its array is still loading.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool find(const std::string& map_key, layer& result) const;
+
+	std::uint64_t get_version() const
+	{
+		return version_;
+	}
+
+	std::size_t get_arrays_count() const
+	{
+		return arrays_.size();
+	}
+
+private:
+	struct array
+	{
+		core::task_future<asset_handle<gfx::texture>> load;
+		asset_handle<gfx::texture> texture;
+	};
+
+	struct entry
+	{
+		std::uint32_t array = 0;
+		std::uint32_t index = 0;
+	};
+
+	void frame_begin(delta_t dt);
+
+	std::vector<array> arrays_;
+	/// the arrays still loading
+	std::size_t pending_ = 0;
+	std::unordered_map<std::string, entry> entries_;
+	std::uint64_t version_ = 1;
+};
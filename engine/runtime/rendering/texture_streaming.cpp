@@ -0,0 +1,239 @@
+#include "texture_streaming.h"
+#include "../system/events.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+std::uint32_t read_u32(const std::uint8_t* data)
+{
+	std::uint32_t value = 0;
+	std::memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+// the size and mips of a plain 2d ktx or dds, false for anything else
+bool read_header(const fs::mapped_range& data, std::uint32_t& width, std::uint32_t& height,
+				 std::uint32_t& mips)
+{
+	static const std::uint8_t ktx_identifier[] = {0xab, 0x4b, 0x54, 0x58, 0x20, 0x31,
+												  0x31, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a};
+	if(data.size >= 64 && std::memcmp(data.data, ktx_identifier, sizeof(ktx_identifier)) == 0)
+	{
+		const auto field = [&data](std::size_t i) { return read_u32(data.data + 12 + i * 4); };
+		const auto depth = field(8);
+		const auto array_elements = field(9);
+		const auto faces = field(10);
+		if(field(0) != 0x04030201 || depth > 1 || array_elements > 1 || faces > 1)
+		{
+			return false;
+		}
+
+		width = field(6);
+		height = field(7);
+		mips = field(11);
+		return true;
+	}
+
+	if(data.size >= 128 && std::memcmp(data.data, "DDS ", 4) == 0)
+	{
+		const std::uint32_t cubemap_or_volume = 0x200 | 0x200000;
+		if((read_u32(data.data + 112) & cubemap_or_volume) != 0)
+		{
+			return false;
+		}
+
+		height = read_u32(data.data + 12);
+		width = read_u32(data.data + 16);
+		mips = read_u32(data.data + 28);
+		return true;
+	}
+
+	return false;
+}
+}
+
+constexpr std::uint32_t texture_streaming::tail_size;
+constexpr std::uint64_t texture_streaming::keep_frames;
+
+texture_streaming::texture_streaming()
+{
+	runtime::on_frame_end.connect(this, &texture_streaming::frame_end);
+}
+
+texture_streaming::~texture_streaming()
+{
+	runtime::on_frame_end.disconnect(this, &texture_streaming::frame_end);
+}
+
+std::shared_ptr<gfx::texture> texture_streaming::create(const fs::mapped_range& data, std::uint64_t flags)
+{
+	entry e;
+	std::uint32_t mips = 0;
+	if(!data || !read_header(data, e.width, e.height, mips) || mips < 2)
+	{
+		return nullptr;
+	}
+
+	const auto top = std::max(e.width, e.height);
+	while(e.tail_skip + 1u < mips && (top >> e.tail_skip) > tail_size)
+	{
+		++e.tail_skip;
+	}
+	if(e.tail_skip == 0)
+	{
+		return nullptr;
+	}
+
+	gfx::scoped_memory_category scope(gfx::memory_category::assets);
+	const auto mem = gfx::make_ref(data.data, static_cast<std::uint32_t>(data.size), data.owner);
+	auto tex = std::make_shared<gfx::texture>(mem, flags, e.tail_skip, nullptr);
+	if(!tex->is_valid())
+	{
+		return nullptr;
+	}
+
+	e.tex = tex;
+	e.data = data;
+	e.flags = flags;
+	e.skip = e.tail_skip;
+	e.wanted_skip = e.tail_skip;
+	e.needed_frame = frame_;
+	e.size = tex->info.storageSize;
+	entries_[tex.get()] = std::move(e);
+	return tex;
+}
+
+void texture_streaming::request(const gfx::texture& tex, float texels)
+{
+	auto it = entries_.find(&tex);
+	if(it == entries_.end())
+	{
+		return;
+	}
+
+	// the smallest mip still as wide as asked for
+	auto& e = it->second;
+	const auto top = std::max(e.width, e.height);
+	std::uint8_t skip = 0;
+	while(skip < e.tail_skip && float(top >> (skip + 1)) >= texels)
+	{
+		++skip;
+	}
+
+	e.wanted_skip = std::min(e.wanted_skip, skip);
+	if(skip <= e.skip)
+	{
+		e.needed_frame = frame_;
+	}
+}
+
+bool texture_streaming::recreate(entry& e, std::uint8_t skip)
+{
+	auto tex = e.tex.lock();
+	if(!tex)
+	{
+		return false;
+	}
+
+	gfx::scoped_memory_category scope(gfx::memory_category::assets);
+	const auto mem = gfx::make_ref(e.data.data, static_cast<std::uint32_t>(e.data.size), e.data.owner);
+	gfx::texture next(mem, e.flags, skip, nullptr);
+	if(!next.is_valid())
+	{
+		return false;
+	}
+
+	// the old one is destroyed with next
+	tex->swap(next);
+	e.skip = skip;
+	e.size = tex->info.storageSize;
+	return true;
+}
+
+void texture_streaming::frame_end(delta_t)
+{
+	struct change
+	{
+		entry* e = nullptr;
+		std::uint8_t skip = 0;
+	};
+
+	++frame_;
+	resident_memory_ = 0;
+	std::vector<change> upgrades;
+	std::vector<entry*> droppable;
+	for(auto it = entries_.begin(); it != entries_.end();)
+	{
+		auto& e = it->second;
+		if(e.tex.expired())
+		{
+			it = entries_.erase(it);
+			continue;
+		}
+
+		resident_memory_ += e.size;
+		if(e.wanted_skip < e.skip)
+		{
+			upgrades.push_back({&e, e.wanted_skip});
+		}
+		else if(e.skip < e.tail_skip)
+		{
+			droppable.push_back(&e);
+		}
+		e.wanted_skip = e.tail_skip;
+		++it;
+	}
+
+	std::uint32_t updates = 0;
+
+	// unneeded top mips go first, then the least recently needed ones while
+	// over the budget
+	std::sort(std::begin(droppable), std::end(droppable),
+			  [](const entry* a, const entry* b) { return a->needed_frame < b->needed_frame; });
+	for(auto e : droppable)
+	{
+		const bool unneeded = frame_ - e->needed_frame > keep_frames;
+		const bool over_budget = budget_ > 0 && resident_memory_ > budget_;
+		if(updates >= max_updates_ || (!unneeded && !over_budget))
+		{
+			break;
+		}
+
+		const auto size = e->size;
+		if(recreate(*e, std::uint8_t(e->skip + 1)))
+		{
+			resident_memory_ = resident_memory_ - size + e->size;
+			e->needed_frame = frame_;
+			++updates;
+		}
+	}
+
+	// the most missing mips first, as long as the budget allows, a mip less
+	// skipped is about four times the size
+	std::sort(std::begin(upgrades), std::end(upgrades), [](const change& a, const change& b) {
+		return a.e->skip - a.skip > b.e->skip - b.skip;
+	});
+	for(auto& c : upgrades)
+	{
+		if(updates >= max_updates_)
+		{
+			break;
+		}
+
+		const auto estimate = c.e->size << (2 * (c.e->skip - c.skip));
+		if(budget_ > 0 && resident_memory_ - c.e->size + estimate > budget_)
+		{
+			continue;
+		}
+
+		const auto size = c.e->size;
+		if(recreate(*c.e, c.skip))
+		{
+			resident_memory_ = resident_memory_ - size + c.e->size;
+			++updates;
+		}
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <core/common/basetypes.hpp>
+#include <core/filesystem/archive.h>
+#include <core/graphics/texture.h>
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+/*
+ * texture_streaming; mips of the compiled textures made resident as the
+ * renderer needs them, smallest first.
+ *
+ *      A texture is created with its tail mips only, so a material can draw
+ *      with it as soon as it is loaded, and is made again with more of its
+ *      top mips skipped or not as the requests change. The swap keeps the
+ *      texture object, the handles to it see the new one. The compiled data
+ *      stays mapped to make the texture again, the mapped pages cost
+ *      nothing once the system drops them. Under the budget the textures
+ *      needed least recently lose their top mips first.
+ */
+class texture_streaming
+{
+public:
+	texture_streaming();
+	~texture_streaming();
+
+	//-----------------------------------------------------------------------------
+	//  Name : create ()
+	/// <summary>
+	/// Creates a texture from a compiled ktx or dds with its tail mips, null
+	/// for one that is not streamed, e.g. a cube map or one without mips.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<gfx::texture> create(const fs::mapped_range& data, std::uint64_t flags);
+
+	//-----------------------------------------------------------------------------
+	//  Name : request ()
+	/// <summary>
+	/// Asks for the texture to have as many texels across as it is drawn on
+	/// pixels. From the owner thread, textures that are not streamed are
+	/// ignored.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void request(const gfx::texture& tex, float texels);
+
+	/// bytes of the resident mips the textures are kept under, 0 for none
+	void set_budget(std::size_t budget)
+	{
+		budget_ = budget;
+	}
+
+	/// textures made again per frame at most
+	void set_max_updates(std::uint32_t max_updates)
+	{
+		max_updates_ = max_updates;
+	}
+
+	std::size_t get_resident_memory() const
+	{
+		return resident_memory_;
+	}
+
+	std::size_t get_textures_count() const
+	{
+		return entries_.size();
+	}
+
+private:
+	struct entry
+	{
+		std::weak_ptr<gfx::texture> tex;
+		fs::mapped_range data;
+		std::uint64_t flags = 0;
+		std::uint32_t width = 0;
+		std::uint32_t height = 0;
+		/// top mips skipped, now and with only the tail resident
+		std::uint8_t skip = 0;
+		std::uint8_t tail_skip = 0;
+		/// least skipped the requests asked for since the last update
+		std::uint8_t wanted_skip = 0;
+		/// last frame the resident mips were needed
+		std::uint64_t needed_frame = 0;
+		/// bytes of the resident mips
+		std::size_t size = 0;
+	};
+
+	void frame_end(delta_t);
+
+	/// makes the texture again with the skip, false if it could not be
+	bool recreate(entry& e, std::uint8_t skip);
+
+	std::unordered_map<const gfx::texture*, entry> entries_;
+	std::size_t budget_ = 0;
+	std::size_t resident_memory_ = 0;
+	std::uint32_t max_updates_ = 4;
+	std::uint64_t frame_ = 0;
+
+	/// the tail mips are the ones this wide and smaller
+	static constexpr std::uint32_t tail_size = 64;
+	/// frames without a request before a texture loses a top mip
+	static constexpr std::uint64_t keep_frames = 120;
+};
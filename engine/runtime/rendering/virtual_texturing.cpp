@@ -0,0 +1,526 @@
+#include "virtual_texturing.h"
+#include "renderer.h"
+#include "../system/events.h"
+
+#include <core/graphics/frame_buffer.h>
+#include <core/graphics/graphics.h>
+#include <core/graphics/render_pass.h>
+#include <core/graphics/render_view.h>
+#include <core/system/subsystem.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+std::uint32_t read_u32(const std::uint8_t* data)
+{
+	std::uint32_t value = 0;
+	std::memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+bool is_power_of_two(std::uint32_t value)
+{
+	return value != 0 && (value & (value - 1)) == 0;
+}
+
+// the size, mips and channel order of a plain 2d ktx of bgra8 or rgba8, false
+// for anything else
+bool read_header(const fs::mapped_range& data, std::uint32_t& width, std::uint32_t& height,
+				 std::uint32_t& mips, bool& swap_red_blue, std::size_t& offset)
+{
+	static const std::uint8_t ktx_identifier[] = {0xab, 0x4b, 0x54, 0x58, 0x20, 0x31,
+												  0x31, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a};
+	if(data.size < 64 || std::memcmp(data.data, ktx_identifier, sizeof(ktx_identifier)) != 0)
+	{
+		return false;
+	}
+
+	const auto field = [&data](std::size_t i) { return read_u32(data.data + 12 + i * 4); };
+	if(field(0) != 0x04030201 || field(8) > 1 || field(9) > 1 || field(10) > 1)
+	{
+		return false;
+	}
+
+	// GL_BGRA, GL_RGBA8 and GL_SRGB8_ALPHA8
+	const auto internal_format = field(4);
+	if(internal_format == 0x80E1)
+	{
+		swap_red_blue = false;
+	}
+	else if(internal_format == 0x8058 || internal_format == 0x8C43)
+	{
+		swap_red_blue = true;
+	}
+	else
+	{
+		return false;
+	}
+
+	width = field(6);
+	height = field(7);
+	mips = std::max<std::uint32_t>(field(11), 1);
+	offset = 64 + std::size_t(field(12));
+	return true;
+}
+
+// the texels of a page and its border, clamped to the edges of the mip
+std::vector<std::uint8_t> copy_slot(const std::uint8_t* texels, std::uint32_t texel_width,
+									std::uint32_t texel_height, std::uint32_t x, std::uint32_t y,
+									bool swap_red_blue)
+{
+	const auto size = virtual_texturing::slot_size;
+	const auto border = std::int32_t(virtual_texturing::border);
+	std::vector<std::uint8_t> result(std::size_t(size) * size * 4);
+	auto out = result.data();
+	for(std::int32_t ty = 0; ty < std::int32_t(size); ++ty)
+	{
+		const auto sy = std::min(std::max(std::int32_t(y) + ty - border, 0), std::int32_t(texel_height) - 1);
+		const auto row = texels + std::size_t(sy) * texel_width * 4;
+		for(std::int32_t tx = 0; tx < std::int32_t(size); ++tx, out += 4)
+		{
+			const auto sx =
+				std::min(std::max(std::int32_t(x) + tx - border, 0), std::int32_t(texel_width) - 1);
+			const auto texel = row + std::size_t(sx) * 4;
+			out[0] = texel[swap_red_blue ? 2 : 0];
+			out[1] = texel[1];
+			out[2] = texel[swap_red_blue ? 0 : 2];
+			out[3] = texel[3];
+		}
+	}
+	return result;
+}
+}
+
+constexpr std::uint32_t virtual_texturing::page_size;
+constexpr std::uint32_t virtual_texturing::border;
+constexpr std::uint32_t virtual_texturing::slot_size;
+constexpr std::uint32_t virtual_texturing::feedback_shift;
+
+void virtual_texture::get_params(math::vec4 (&params)[2]) const
+{
+	params[0] = math::vec4(float(levels_.front().width), float(levels_.front().height),
+						   float(virtual_texturing::page_size), float(levels_.size() - 1));
+	params[1] = cache_params_;
+}
+
+virtual_texturing::virtual_texturing(std::uint32_t slots_across)
+{
+	// the slot coordinates are bytes of the page table, the cache is within
+	// the texture size limit
+	slots_across = std::min(std::max(slots_across, 1u), 4096u / slot_size);
+	const auto size = slots_across * slot_size;
+	const auto flags = BGFX_SAMPLER_MIP_POINT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP;
+	cache_ = std::make_shared<gfx::texture>(std::uint16_t(size), std::uint16_t(size), false, 1,
+											gfx::texture_format::BGRA8, flags);
+	slots_.resize(std::size_t(slots_across) * slots_across);
+	textures_.resize(256);
+
+	runtime::on_frame_end.connect(this, &virtual_texturing::frame_end);
+}
+
+virtual_texturing::~virtual_texturing()
+{
+	runtime::on_frame_end.disconnect(this, &virtual_texturing::frame_end);
+}
+
+std::shared_ptr<virtual_texture> virtual_texturing::create(const fs::mapped_range& data)
+{
+	auto tex = std::make_shared<virtual_texture>();
+	std::uint32_t mips = 0;
+	std::size_t offset = 0;
+	if(!data || !read_header(data, tex->width_, tex->height_, mips, tex->swap_red_blue_, offset))
+	{
+		return nullptr;
+	}
+
+	// the page coordinates are bytes of the feedback
+	const auto width = tex->width_;
+	const auto height = tex->height_;
+	if(!is_power_of_two(width) || !is_power_of_two(height) || width < page_size || height < page_size ||
+	   width / page_size > 256 || height / page_size > 256)
+	{
+		return nullptr;
+	}
+
+	for(std::uint32_t i = 0; i < mips && (width >> i) >= page_size && (height >> i) >= page_size; ++i)
+	{
+		if(offset + 4 > data.size)
+		{
+			return nullptr;
+		}
+
+		virtual_texture::level lvl;
+		lvl.texel_width = width >> i;
+		lvl.texel_height = height >> i;
+		lvl.width = lvl.texel_width / page_size;
+		lvl.height = lvl.texel_height / page_size;
+		const auto image_size = std::size_t(read_u32(data.data + offset));
+		if(image_size != std::size_t(lvl.texel_width) * lvl.texel_height * 4 ||
+		   offset + 4 + image_size > data.size)
+		{
+			return nullptr;
+		}
+		lvl.texels = data.data + offset + 4;
+		lvl.pages.resize(std::size_t(lvl.width) * lvl.height);
+		tex->levels_.emplace_back(std::move(lvl));
+		offset += 4 + ((image_size + 3) & ~std::size_t(3));
+	}
+
+	// the coarsest level must be the one whose smaller side is a page
+	if(tex->levels_.empty() || (tex->levels_.back().width != 1 && tex->levels_.back().height != 1))
+	{
+		return nullptr;
+	}
+	const auto& coarsest = tex->levels_.back();
+
+	auto id = std::find_if(std::begin(textures_) + 1, std::end(textures_),
+						   [](const std::weak_ptr<virtual_texture>& t) { return t.expired(); });
+	std::size_t free_slots = 0;
+	for(const auto& s : slots_)
+	{
+		free_slots += s.pinned ? 0 : 1;
+	}
+	if(id == std::end(textures_) || coarsest.pages.size() > free_slots)
+	{
+		return nullptr;
+	}
+
+	*id = tex;
+	tex->id_ = std::uint8_t(std::distance(std::begin(textures_), id));
+	tex->data_ = data;
+	tex->cache_params_ = math::vec4(float(slot_size), float(border), 1.0f / float(cache_->info.width),
+									float(tex->id_) / 255.0f);
+
+	const auto pages_x = std::uint16_t(tex->levels_.front().width);
+	const auto pages_y = std::uint16_t(tex->levels_.front().height);
+	tex->page_table_ = std::make_shared<gfx::texture>(
+		pages_x, pages_y, true, 1, gfx::texture_format::RGBA8,
+		BGFX_SAMPLER_MIN_POINT | BGFX_SAMPLER_MAG_POINT | BGFX_SAMPLER_MIP_POINT | BGFX_SAMPLER_U_CLAMP |
+			BGFX_SAMPLER_V_CLAMP);
+
+	// the coarsest level is what is drawn while nothing else is resident
+	const auto level = std::uint32_t(tex->levels_.size() - 1);
+	for(std::uint32_t p = 0; p < coarsest.pages.size(); ++p)
+	{
+		const auto slot = acquire_slot(true);
+		const auto x = (p % coarsest.width) * page_size;
+		const auto y = (p / coarsest.width) * page_size;
+		const auto texels = copy_slot(coarsest.texels, coarsest.texel_width, coarsest.texel_height, x, y,
+									  tex->swap_red_blue_);
+		upload(*tex, level, p, slot, texels);
+		slots_[std::size_t(slot)].pinned = true;
+	}
+	update_page_table(*tex);
+	return tex;
+}
+
+std::shared_ptr<gfx::frame_buffer>
+virtual_texturing::begin_feedback(gfx::render_view& render_view, std::uint32_t width, std::uint32_t height)
+{
+	if(reading_ != 0)
+	{
+		return nullptr;
+	}
+
+	if(!gfx::is_supported(BGFX_CAPS_TEXTURE_BLIT) || !gfx::is_supported(BGFX_CAPS_TEXTURE_READ_BACK))
+	{
+		return nullptr;
+	}
+
+	const auto w = std::uint16_t(std::max<std::uint32_t>(width >> feedback_shift, 1));
+	const auto h = std::uint16_t(std::max<std::uint32_t>(height >> feedback_shift, 1));
+	auto color = render_view.get_texture("VT_FEEDBACK", w, h, false, 1, gfx::texture_format::RGBA8);
+	auto depth = render_view.get_texture("VT_FEEDBACK_DEPTH", w, h, false, 1, gfx::texture_format::D24);
+	return render_view.get_fbo("VT_FEEDBACK", {color, depth});
+}
+
+void virtual_texturing::end_feedback(const gfx::frame_buffer& target)
+{
+	const auto& color = target.get_texture(0);
+	const auto width = std::uint32_t(color->info.width);
+	const auto height = std::uint32_t(color->info.height);
+	if(!read_texture_ || read_width_ != width || read_height_ != height)
+	{
+		read_texture_ = std::make_shared<gfx::texture>(
+			std::uint16_t(width), std::uint16_t(height), false, 1, gfx::texture_format::RGBA8,
+			BGFX_TEXTURE_BLIT_DST | BGFX_TEXTURE_READ_BACK | BGFX_SAMPLER_MIN_POINT | BGFX_SAMPLER_MAG_POINT |
+				BGFX_SAMPLER_MIP_POINT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP);
+		read_width_ = width;
+		read_height_ = height;
+		read_data_.resize(std::size_t(width) * height * 4);
+	}
+
+	gfx::render_pass pass("virtual_texture_blit");
+	pass.touch();
+	gfx::blit(pass.id, read_texture_->native_handle(), 0, 0, color->native_handle());
+	reading_ = gfx::read_texture(read_texture_->native_handle(), read_data_.data());
+}
+
+std::size_t virtual_texturing::get_resident_pages() const
+{
+	return std::size_t(std::count_if(std::begin(slots_), std::end(slots_),
+									 [](const slot& s) { return !s.owner.expired(); }));
+}
+
+void virtual_texturing::frame_end(delta_t)
+{
+	release_expired();
+
+	const auto render_frame = core::get_subsystem<runtime::renderer>().get_render_frame();
+	if(reading_ != 0 && reading_ <= render_frame)
+	{
+		reading_ = 0;
+		read_feedback();
+	}
+
+	start_loads();
+	finish_loads();
+
+	for(const auto& t : textures_)
+	{
+		auto tex = t.lock();
+		if(tex && tex->table_dirty_)
+		{
+			update_page_table(*tex);
+		}
+	}
+}
+
+void virtual_texturing::release_expired()
+{
+	for(auto& s : slots_)
+	{
+		if(s.owner.expired())
+		{
+			s = {};
+		}
+	}
+}
+
+void virtual_texturing::read_feedback()
+{
+	const auto current = ++feedbacks_;
+	std::vector<std::shared_ptr<virtual_texture>> locked(textures_.size());
+	bool queued = false;
+	for(std::size_t i = 0; i + 3 < read_data_.size(); i += 4)
+	{
+		const auto texel = read_data_.data() + i;
+		const auto id = texel[3];
+		if(id == 0)
+		{
+			continue;
+		}
+
+		auto& tex = locked[id];
+		if(!tex)
+		{
+			tex = textures_[id].lock();
+			if(!tex)
+			{
+				continue;
+			}
+		}
+
+		const std::uint32_t first = texel[2];
+		if(first >= tex->levels_.size() || texel[0] >= tex->levels_[first].width ||
+		   texel[1] >= tex->levels_[first].height)
+		{
+			continue;
+		}
+
+		// the page and the coarser ones under it, for a page to fall back to
+		for(auto level = first; level < tex->levels_.size(); ++level)
+		{
+			auto& lvl = tex->levels_[level];
+			const auto shift = level - first;
+			const auto x = std::uint32_t(texel[0]) >> shift;
+			const auto y = std::uint32_t(texel[1]) >> shift;
+			const auto index = y * lvl.width + x;
+			auto& p = lvl.pages[index];
+			if(p.used == current)
+			{
+				break;
+			}
+
+			p.used = current;
+			if(p.slot < 0 && !p.loading)
+			{
+				p.loading = true;
+				load l;
+				l.owner = tex;
+				l.level = level;
+				l.page = index;
+				queued_.emplace_back(std::move(l));
+				queued = true;
+			}
+		}
+	}
+
+	if(queued)
+	{
+		std::stable_sort(std::begin(queued_), std::end(queued_),
+						 [](const load& lhs, const load& rhs) { return lhs.level > rhs.level; });
+	}
+}
+
+void virtual_texturing::start_loads()
+{
+	// pages the last feedbacks no longer ask for are not loaded
+	queued_.erase(std::remove_if(std::begin(queued_), std::end(queued_),
+								 [this](const load& l) {
+									 auto tex = l.owner.lock();
+									 if(!tex)
+									 {
+										 return true;
+									 }
+									 auto& p = tex->levels_[l.level].pages[l.page];
+									 if(p.used + 2 < feedbacks_)
+									 {
+										 p.loading = false;
+										 return true;
+									 }
+									 return false;
+								 }),
+				  std::end(queued_));
+
+	auto& ts = core::get_subsystem<core::task_system>();
+	std::size_t taken = 0;
+	for(; taken < queued_.size() && loads_.size() < max_loads_; ++taken)
+	{
+		auto& l = queued_[taken];
+		auto tex = l.owner.lock();
+		const auto& lvl = tex->levels_[l.level];
+		const auto x = (l.page % lvl.width) * page_size;
+		const auto y = (l.page / lvl.width) * page_size;
+		// the texture keeps the mapping alive while the worker reads it
+		l.texels = ts.push_on_worker_thread([tex, x, y, texels = lvl.texels, texel_width = lvl.texel_width,
+											  texel_height = lvl.texel_height]() {
+			return copy_slot(texels, texel_width, texel_height, x, y, tex->swap_red_blue_);
+		});
+		loads_.emplace_back(std::move(l));
+	}
+	queued_.erase(std::begin(queued_), std::begin(queued_) + std::ptrdiff_t(taken));
+}
+
+void virtual_texturing::finish_loads()
+{
+	std::uint32_t uploads = 0;
+	for(auto it = loads_.begin(); it != loads_.end() && uploads < max_uploads_;)
+	{
+		if(!it->texels.is_ready())
+		{
+			++it;
+			continue;
+		}
+
+		auto tex = it->owner.lock();
+		auto texels = it->texels.get();
+		if(tex)
+		{
+			auto& p = tex->levels_[it->level].pages[it->page];
+			p.loading = false;
+			const auto slot = p.slot < 0 ? acquire_slot() : -1;
+			// with no slot to spare the next feedback asks for it again
+			if(slot >= 0)
+			{
+				upload(*tex, it->level, it->page, slot, texels);
+				++uploads;
+			}
+		}
+		it = loads_.erase(it);
+	}
+}
+
+std::int32_t virtual_texturing::acquire_slot(bool any_unpinned)
+{
+	std::int32_t result = -1;
+	std::uint64_t oldest = any_unpinned ? std::numeric_limits<std::uint64_t>::max() : feedbacks_;
+	for(std::size_t i = 0; i < slots_.size(); ++i)
+	{
+		auto& s = slots_[i];
+		auto owner = s.owner.lock();
+		if(!owner)
+		{
+			s = {};
+			return std::int32_t(i);
+		}
+
+		const auto used = owner->levels_[s.level].pages[s.page].used;
+		if(!s.pinned && used < oldest)
+		{
+			oldest = used;
+			result = std::int32_t(i);
+		}
+	}
+
+	if(result >= 0)
+	{
+		auto& s = slots_[std::size_t(result)];
+		auto owner = s.owner.lock();
+		owner->levels_[s.level].pages[s.page].slot = -1;
+		owner->table_dirty_ = true;
+		s = {};
+	}
+	return result;
+}
+
+void virtual_texturing::upload(virtual_texture& tex, std::uint32_t level, std::uint32_t page,
+							   std::int32_t slot, const std::vector<std::uint8_t>& texels)
+{
+	const auto across = std::uint32_t(cache_->info.width) / slot_size;
+	const auto x = std::uint16_t((std::uint32_t(slot) % across) * slot_size);
+	const auto y = std::uint16_t((std::uint32_t(slot) / across) * slot_size);
+	gfx::update_texture_2d(cache_->native_handle(), 0, 0, x, y, std::uint16_t(slot_size),
+						   std::uint16_t(slot_size), gfx::copy(texels.data(), std::uint32_t(texels.size())));
+
+	auto& s = slots_[std::size_t(slot)];
+	s.owner = textures_[tex.id_];
+	s.level = level;
+	s.page = page;
+	tex.levels_[level].pages[page].slot = slot;
+	tex.table_dirty_ = true;
+}
+
+void virtual_texturing::update_page_table(virtual_texture& tex)
+{
+	// every texel is the slot and the level of the page, or those of the
+	// entry of the page under it while it is not resident
+	const auto across = std::uint32_t(cache_->info.width) / slot_size;
+	std::vector<std::uint8_t> coarser;
+	std::uint32_t coarser_width = 0;
+	for(auto level = std::int32_t(tex.levels_.size()) - 1; level >= 0; --level)
+	{
+		const auto& lvl = tex.levels_[std::size_t(level)];
+		std::vector<std::uint8_t> entries(lvl.pages.size() * 4);
+		for(std::uint32_t y = 0; y < lvl.height; ++y)
+		{
+			for(std::uint32_t x = 0; x < lvl.width; ++x)
+			{
+				const auto index = y * lvl.width + x;
+				const auto& p = lvl.pages[index];
+				auto entry = entries.data() + index * 4;
+				if(p.slot >= 0)
+				{
+					entry[0] = std::uint8_t(std::uint32_t(p.slot) % across);
+					entry[1] = std::uint8_t(std::uint32_t(p.slot) / across);
+					entry[2] = std::uint8_t(level);
+					entry[3] = 255;
+				}
+				else if(!coarser.empty())
+				{
+					std::memcpy(entry, coarser.data() + ((y / 2) * coarser_width + x / 2) * 4, 4);
+				}
+			}
+		}
+
+		gfx::update_texture_2d(tex.page_table_->native_handle(), 0, std::uint8_t(level), 0, 0,
+							   std::uint16_t(lvl.width), std::uint16_t(lvl.height),
+							   gfx::copy(entries.data(), std::uint32_t(entries.size())));
+		coarser = std::move(entries);
+		coarser_width = lvl.width;
+	}
+	tex.table_dirty_ = false;
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <core/common/basetypes.hpp>
+#include <core/filesystem/archive.h>
+#include <core/graphics/texture.h>
+#include <core/math/math_includes.h>
+#include <core/tasks/task_system.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace gfx
+{
+struct frame_buffer;
+class render_view;
+}
+
+/*
+ * virtual_texture; a large texture of which only the pages drawn are in
+ * video memory, in the page cache of virtual_texturing.
+ *
+ *      The texture is cut into square pages at every level of its mips down
+ *      to the level whose smaller side is one page. The pages of that level
+ *      are always resident, the others come and go as the feedback asks for
+ *      them. The page table has a texel per page of every level, pointing at
+ *      the slot of the cache that holds the page, or the nearest coarser one
+ *      resident while it is not.
+ */
+class virtual_texture
+{
+public:
+	std::uint32_t get_width() const
+	{
+		return width_;
+	}
+
+	std::uint32_t get_height() const
+	{
+		return height_;
+	}
+
+	gfx::texture* get_page_table() const
+	{
+		return page_table_.get();
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : get_params ()
+	/// <summary>
+	/// The two vec4 shaders sample the texture with: the pages across and
+	/// down at the top level, the page size and the coarsest level, then the
+	/// slot size, the border, the inverse of the cache size and the id the
+	/// feedback writes.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void get_params(math::vec4 (&params)[2]) const;
+
+private:
+	friend class virtual_texturing;
+
+	struct page
+	{
+		/// the slot of the cache holding it, -1 for none
+		std::int32_t slot = -1;
+		/// the last feedback that asked for it
+		std::uint64_t used = 0;
+		bool loading = false;
+	};
+
+	struct level
+	{
+		/// the pages across and down, and the texels of the mip
+		std::uint32_t width = 0;
+		std::uint32_t height = 0;
+		std::uint32_t texel_width = 0;
+		std::uint32_t texel_height = 0;
+		/// where the texels of the mip start in the data
+		const std::uint8_t* texels = nullptr;
+		std::vector<page> pages;
+	};
+
+	fs::mapped_range data_;
+	std::uint32_t width_ = 0;
+	std::uint32_t height_ = 0;
+	std::vector<level> levels_;
+	std::shared_ptr<gfx::texture> page_table_;
+	std::uint8_t id_ = 0;
+	/// the source is rgba, the cache is bgra
+	bool swap_red_blue_ = false;
+	bool table_dirty_ = true;
+	math::vec4 cache_params_;
+};
+
+/*
+ * virtual_texturing; the page cache of the virtual textures, filled from
+ * the feedback of what the views draw.
+ *
+ *      The views draw their virtual textured models again at a fraction of
+ *      their size, writing the page and the level every pixel samples. The
+ *      feedback is read back a few frames later, the pages it asks for that
+ *      are not resident are queued, the coarser ones first, and copied from
+ *      the mapped compiled textures on the workers. A page is uploaded to a
+ *      free slot of the cache or to the one asked for least recently, never
+ *      to one the last feedback asked for. The cache is bgra8 without mips,
+ *      every slot is a page with a border of the texels around it for the
+ *      bilinear filter.
+ */
+class virtual_texturing
+{
+public:
+	virtual_texturing(std::uint32_t slots_across = 16);
+	~virtual_texturing();
+
+	//-----------------------------------------------------------------------------
+	//  Name : create ()
+	/// <summary>
+	/// Creates a virtual texture from a compiled ktx of bgra8 or rgba8 with
+	/// its mips, null for anything else, a size not a power of two of pages,
+	/// or when the cache can't hold its coarsest level. From the owner thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<virtual_texture> create(const fs::mapped_range& data);
+
+	//-----------------------------------------------------------------------------
+	//  Name : begin_feedback ()
+	/// <summary>
+	/// The target the view of the size draws its feedback to, null while the
+	/// read back of an earlier one is in flight.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<gfx::frame_buffer> begin_feedback(gfx::render_view& render_view, std::uint32_t width,
+													  std::uint32_t height);
+
+	//-----------------------------------------------------------------------------
+	//  Name : end_feedback ()
+	/// <summary>
+	/// Queues the read back of the feedback drawn to the target.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void end_feedback(const gfx::frame_buffer& target);
+
+	/// the log2 of the size of a view over that of its feedback, for the
+	/// levels the feedback writes to be those the view samples
+	float get_feedback_bias() const
+	{
+		return -float(feedback_shift);
+	}
+
+	gfx::texture* get_cache() const
+	{
+		return cache_.get();
+	}
+
+	/// pages copied on the workers at once at most
+	void set_max_loads(std::uint32_t max_loads)
+	{
+		max_loads_ = max_loads;
+	}
+
+	/// pages uploaded per frame at most
+	void set_max_uploads(std::uint32_t max_uploads)
+	{
+		max_uploads_ = max_uploads;
+	}
+
+	std::size_t get_resident_pages() const;
+
+	std::size_t get_slots_count() const
+	{
+		return slots_.size();
+	}
+
+	/// the texels of a page and those of its border on every side
+	static constexpr std::uint32_t page_size = 128;
+	static constexpr std::uint32_t border = 1;
+	static constexpr std::uint32_t slot_size = page_size + 2 * border;
+	/// the halvings of a view for its feedback
+	static constexpr std::uint32_t feedback_shift = 3;
+
+private:
+	struct slot
+	{
+		std::weak_ptr<virtual_texture> owner;
+		std::uint32_t level = 0;
+		std::uint32_t page = 0;
+		bool pinned = false;
+	};
+
+	struct load
+	{
+		std::weak_ptr<virtual_texture> owner;
+		std::uint32_t level = 0;
+		std::uint32_t page = 0;
+		core::task_future<std::vector<std::uint8_t>> texels;
+	};
+
+	void frame_end(delta_t);
+	void read_feedback();
+	void start_loads();
+	void finish_loads();
+	void release_expired();
+	/// a free slot or the one asked for least recently, never one the last
+	/// feedback asked for unless any unpinned will do, -1 for none
+	std::int32_t acquire_slot(bool any_unpinned = false);
+	void upload(virtual_texture& tex, std::uint32_t level, std::uint32_t page, std::int32_t slot,
+				const std::vector<std::uint8_t>& texels);
+	void update_page_table(virtual_texture& tex);
+
+	std::shared_ptr<gfx::texture> cache_;
+	std::vector<slot> slots_;
+	/// the textures by their id, 0 is the id of no texture
+	std::vector<std::weak_ptr<virtual_texture>> textures_;
+	/// the pages asked for and not resident, coarser ones first
+	std::vector<load> queued_;
+	std::vector<load> loads_;
+	std::uint32_t max_loads_ = 8;
+	std::uint32_t max_uploads_ = 8;
+	/// the feedbacks read so far
+	std::uint64_t feedbacks_ = 1;
+
+	/// read back target and data of the feedback in flight
+	std::shared_ptr<gfx::texture> read_texture_;
+	std::vector<std::uint8_t> read_data_;
+	std::uint32_t read_width_ = 0;
+	std::uint32_t read_height_ = 0;
+	std::uint32_t reading_ = 0;
+};
@@ -1,21 +1,39 @@
 #include "app.h"
 #include "app_setup.h"
+#include "benchmarks.h"
+#include "scene_benchmark.h"
+#include "startup_phases.h"
 #include "events.h"
 
 #include "../assets/asset_manager.h"
 #include "../ecs/ecs.h"
+#include "../ecs/systems/animation_system.h"
 #include "../ecs/systems/audio_system.h"
 #include "../ecs/systems/bone_system.h"
+#include "../ecs/systems/bounds_system.h"
 #include "../ecs/systems/camera_system.h"
 #include "../ecs/systems/deferred_rendering.h"
 #include "../ecs/systems/reflection_probe_system.h"
 #include "../ecs/systems/scene_graph.h"
+#include "../ecs/systems/system_scheduler.h"
+#include "../ecs/systems/transform_system.h"
+#include "../ecs/systems/world_streaming.h"
 #include "../input/input.h"
+#include "../rendering/mesh_arena.h"
+#include "../rendering/program_cache.h"
 #include "../rendering/render_window.h"
 #include "../rendering/renderer.h"
+#include "../rendering/texture_arrays.h"
+#include "../rendering/texture_streaming.h"
+#include "../rendering/virtual_texturing.h"
 
 #include <core/audio/library.h>
+#include <core/filesystem/archive.h>
+#include <core/graphics/render_view.h>
 #include <core/logging/logging.h>
+#include <core/memory/frame_arena.h>
+#include <core/profiling/memory_tracker.h>
+#include <core/profiling/profiler.h>
 #include <core/serialization/serialization.h>
 #include <core/simulation/simulation.h>
 #include <core/tasks/task_system.h>
@@ -29,7 +47,9 @@ void app::setup(cmd_line::parser& parser)
 {
 	auto logging_container = logging::get_mutable_logging_container();
 	logging_container->add_sink(std::make_shared<logging::sinks::platform_sink_mt>());
-	logging_container->add_sink(std::make_shared<logging::sinks::simple_file_sink_mt>("Log.txt", true));
+	// written from a thread of its own, the threads logging do not wait on the disk
+	log_file_ = std::make_shared<logging::async_file_sink>("Log.txt", true);
+	logging_container->add_sink(log_file_);
 
 	logging::create(APPLOG, logging_container);
 
@@ -46,82 +66,340 @@ void app::setup(cmd_line::parser& parser)
 
 	parser.set_optional<std::string>("r", "renderer", "auto", "Select preferred renderer.");
 	parser.set_optional<bool>("n", "novsync", false, "Disable vsync.");
+	parser.set_optional<bool>("av", "adaptive_vsync", false,
+							  "Present right away the frames that miss the vertical blank.");
+	parser.set_optional<bool>("fa", "flush_after_render", false,
+							  "Flush the graphics api after every frame.");
+	parser.set_optional<int>("fl", "max_frame_latency", 0,
+							 "Frames the graphics api may queue ahead, 0 for its default.");
+	parser.set_optional<bool>("li", "late_input", false,
+							  "Wait on the render thread before sampling the input of a frame.");
+	parser.set_optional<std::string>("rt", "render_tier", "high",
+									 "low packs the g-buffer and the light buffers.");
+	parser.set_optional<bool>("y", "single_threaded_render", false,
+							  "Issue the draws on the main thread instead of a render thread.");
+	parser.set_optional<bool>("b", "adaptive_budget", false,
+							  "Adapt the owner thread tasks budget to the remaining frame time.");
+	parser.set_optional<int>("w", "workers", -1, "Number of compute worker threads. -1 for automatic.");
+	parser.set_optional<int>("i", "io_workers", 2, "Number of worker threads dedicated to file io.");
+	parser.set_optional<bool>("p", "pin_workers", false, "Pin the compute worker threads to cpu cores.");
+	parser.set_optional<bool>("s", "serial_systems", false, "Run the ecs systems one after the other.");
+	parser.set_optional<float>("sb", "systems_budget_ms", 0.0f,
+							   "Milliseconds past which the deferrable ecs systems wait. 0 to disable.");
+	parser.set_optional<float>("c", "ecs_compact_threshold", 0.0f,
+							   "Compact the ecs below this fraction of live entities. 0 to disable.");
+	parser.set_optional<bool>("m", "mesh_arena", false,
+							  "Put the vertices and indices of the meshes in shared buffers.");
+	parser.set_optional<std::string>("a", "archive", "",
+									 "Mount a packed asset archive over the app:/cache directory.");
+	parser.set_optional<int>("l", "asset_loads", 8, "Number of requested asset loads in flight at once.");
+	parser.set_optional<int>("t", "texture_budget", 0,
+							 "Megabytes of textures to evict the unused ones down to. 0 to disable.");
+	parser.set_optional<int>("as", "asset_sweep", 0,
+							 "Megabytes of loaded assets past which the unused are unloaded. 0 to disable.");
+	parser.set_optional<int>("g", "mesh_budget", 0,
+							 "Megabytes of meshes to evict the unused ones down to. 0 to disable.");
+	parser.set_optional<bool>("x", "texture_streaming", false,
+							  "Load the textures with their small mips first and stream in the rest.");
+	parser.set_optional<int>("k", "stream_budget", 0,
+							 "Megabytes the streamed texture mips are kept under. 0 to disable.");
+	parser.set_optional<bool>("vt", "virtual_texturing", false,
+							  "Keep the pages the views draw of the virtual textures in a cache.");
+	parser.set_optional<bool>("ta", "texture_arrays", false,
+							  "Sample the material maps the compiler packed into texture arrays.");
+	parser.set_optional<int>("u", "upload_budget", 0,
+							 "Megabytes of requested gpu uploads created per frame. 0 to disable.");
+	parser.set_optional<std::string>("ws", "stream_scene", "",
+									 "Stream the cells of this scene compiled in cells around the cameras.");
+	parser.set_optional<bool>("gc", "gpu_capture", false,
+							  "Load RenderDoc for gpu captures, F11 captures a frame.");
+	parser.set_optional<int>("gh", "capture_hitches", 0,
+							 "Most gpu captures taken on the hitches of --hitch_ms.");
+	parser.set_optional<std::string>("gp", "capture_path", "captures",
+									 "Directory the gpu captures are written to.");
+	parser.set_optional<bool>("ld", "log_drop", false,
+							  "Drop the log messages when the log file falls behind instead of waiting.");
+	parser.set_optional<float>("f", "hitch_ms", 0.0f,
+							   "Keep the frames longer than this with their profiling zones. 0 to disable.");
+	parser.set_optional<int>("e", "fixed_hz", 0,
+							 "Update in fixed steps this many times a second. 0 to disable.");
+	parser.set_optional<int>("o", "max_fixed_steps", 5, "Most fixed steps a frame catches up with.");
+	parser.set_optional<bool>("j", "precise_pacing", false,
+							  "Wait for the fps cap with a sleep and a spin instead of sleeping only.");
+	parser.set_optional<std::string>("z", "benchmark", "",
+									 "Run the engine benchmarks, write their json to this file and quit.");
+	parser.set_optional<std::string>("bs", "benchmark_scene", "",
+									 "Fly a camera through this scene, write the frame timings and quit.");
+	parser.set_optional<std::string>("bp", "benchmark_path", "",
+									 "Keyframes of the benchmark camera. Empty to circle the origin.");
+	parser.set_optional<std::string>("bo", "benchmark_output", "benchmark_scene.json",
+									 "File the scene benchmark writes its json to.");
+	parser.set_optional<int>("bu", "benchmark_warmup", 60, "Frames the scene benchmark does not measure.");
+	parser.set_optional<int>("bf", "benchmark_frames", 600, "Frames the scene benchmark measures.");
+	parser.set_optional<std::string>("ir", "record_input", "",
+									 "Record the input and the step of every frame to this file.");
+	parser.set_optional<std::string>("ip", "replay_input", "",
+									 "Play back the input recorded to this file in place of the input.");
+	parser.set_optional<float>("id", "replay_step_ms", 0.0f,
+							   "Step every frame of the replay by this. 0 for the recorded steps.");
+	parser.set_optional<std::string>("io", "replay_output", "",
+									 "Write the frame times of the replay to this file and quit after it.");
 }
 
 void app::start(cmd_line::parser& parser)
 {
+	bool log_drop = false;
+	parser.try_get("log_drop", log_drop);
+	if(log_file_)
+	{
+		log_file_->set_overflow_policy(log_drop ? logging::overflow_policy::drop
+												: logging::overflow_policy::block);
+	}
+
+	startup_phases phases;
+	phases.next("simulation");
+
 	// this order is important
-	core::add_subsystem<core::simulation>();
-	core::add_subsystem<renderer>(parser);
+	auto& sim = core::add_subsystem<core::simulation>();
+	bool precise_pacing = false;
+	parser.try_get("precise_pacing", precise_pacing);
+	if(precise_pacing)
+	{
+		sim.set_frame_pacing(core::simulation::frame_pacing::precise);
+	}
+	int fixed_hz = 0;
+	parser.try_get("fixed_hz", fixed_hz);
+	if(fixed_hz > 0)
+	{
+		int max_fixed_steps = 5;
+		parser.try_get("max_fixed_steps", max_fixed_steps);
+		sim.set_fixed_timestep(std::chrono::duration_cast<core::simulation::duration_t>(
+			std::chrono::duration<double>(1.0 / fixed_hz)));
+		sim.set_max_fixed_steps(static_cast<std::uint32_t>(std::max(max_fixed_steps, 1)));
+	}
+	float hitch_ms = 0.0f;
+	parser.try_get("hitch_ms", hitch_ms);
+	if(hitch_ms > 0.0f)
+	{
+		// the zones of the frame are kept with the hitch
+		profiling::set_enabled(true);
+		sim.set_hitch_threshold(std::chrono::duration_cast<core::simulation::duration_t>(
+			std::chrono::duration<float, std::milli>(hitch_ms)));
+	}
+
+	core::task_system::thread_config tasks_config;
+	int workers = -1;
+	parser.try_get("workers", workers);
+	if(workers >= 0)
+	{
+		tasks_config.compute_workers = static_cast<std::size_t>(workers);
+	}
+	int io_workers = 2;
+	parser.try_get("io_workers", io_workers);
+	tasks_config.io_workers = static_cast<std::size_t>(std::max(io_workers, 0));
+	parser.try_get("pin_workers", tasks_config.pin_compute_workers);
+	// made before the renderer so that the startup work overlaps its init, it
+	// is registered at its place below to be torn down before the others.
+	phases.next("task_system");
+	auto tasks = std::make_shared<core::task_system>(false, tasks_config);
+	// opening the audio device needs nothing of the renderer
+	auto audio_device =
+		tasks->push_or_execute_on_worker_thread([]() { return std::make_shared<audio::device>(); });
+
+	// before the device is made for RenderDoc to hook it
+	bool load_gpu_capture = false;
+	parser.try_get("gpu_capture", load_gpu_capture);
+	if(gpu_capture_.load(load_gpu_capture))
+	{
+		std::string capture_path;
+		parser.try_get("capture_path", capture_path);
+		gpu_capture_.set_path(capture_path);
+		int capture_hitches = 0;
+		parser.try_get("capture_hitches", capture_hitches);
+		gpu_capture_.set_hitch_captures(static_cast<std::uint32_t>(std::max(capture_hitches, 0)));
+	}
+
+	phases.next("renderer");
+	auto& rend = core::add_subsystem<renderer>(parser);
+	std::string render_tier;
+	parser.try_get("render_tier", render_tier);
+	if(render_tier == "low")
+	{
+		gfx::render_view::set_render_tier(gfx::render_tier::low);
+	}
+	// the events are taken from the os while the frame waits, when they came
+	sim.set_wait_work([this, &rend]() { platform_events_.collect(rend.get_windows()); });
+	bool use_mesh_arena = false;
+	parser.try_get("mesh_arena", use_mesh_arena);
+	if(use_mesh_arena)
+	{
+		// before the assets, the meshes give their ranges back as they unload
+		core::add_subsystem<mesh_arena>();
+	}
+	bool use_texture_streaming = false;
+	parser.try_get("texture_streaming", use_texture_streaming);
+	if(use_texture_streaming)
+	{
+		int stream_budget = 0;
+		parser.try_get("stream_budget", stream_budget);
+		auto& streaming = core::add_subsystem<texture_streaming>();
+		streaming.set_budget(static_cast<std::size_t>(std::max(stream_budget, 0)) * 1024 * 1024);
+	}
 	core::add_subsystem<input>();
-	core::add_subsystem<audio::device>();
-	core::add_subsystem<asset_manager>();
-	core::add_subsystem<core::task_system>(false);
+	phases.next("audio");
+	core::insert_subsystem(std::move(audio_device).get());
+	phases.next("asset_manager");
+	auto& am = core::add_subsystem<asset_manager>();
+	int asset_sweep = 0;
+	parser.try_get("asset_sweep", asset_sweep);
+	am.set_sweep_threshold(static_cast<std::size_t>(std::max(asset_sweep, 0)) * 1024 * 1024);
+	std::string archive;
+	parser.try_get("archive", archive);
+	if(!archive.empty() && !fs::mount_archive("app:/cache", archive))
+	{
+		APPLOG_ERROR("Could not mount the asset archive {0}", archive);
+	}
+
+	core::insert_subsystem(std::move(tasks));
+	parser.try_get("adaptive_budget", adaptive_owner_tasks_budget_);
+	phases.next("engine_assets");
 	setup_asset_manager();
-	core::add_subsystem<entity_component_system>();
+	setup_asset_streaming(parser);
+	scene_benchmark_ = setup_scene_benchmark(parser);
+	phases.next("systems");
+	// the materials share their programs through it
+	core::add_subsystem<program_cache>();
+	bool use_virtual_texturing = false;
+	parser.try_get("virtual_texturing", use_virtual_texturing);
+	if(use_virtual_texturing)
+	{
+		// before the materials load their virtual textures from it
+		core::add_subsystem<virtual_texturing>();
+	}
+	bool use_texture_arrays = false;
+	parser.try_get("texture_arrays", use_texture_arrays);
+	if(use_texture_arrays)
+	{
+		// the materials look their maps up in it before they are drawn
+		core::add_subsystem<texture_arrays>().load();
+	}
+	float compact_threshold = 0.0f;
+	parser.try_get("ecs_compact_threshold", compact_threshold);
+	core::add_subsystem<entity_component_system>().set_auto_compact(compact_threshold);
 	core::add_subsystem<scene_graph>();
+	bool serial_systems = false;
+	parser.try_get("serial_systems", serial_systems);
+	auto& scheduler = core::add_subsystem<system_scheduler>();
+	scheduler.set_parallel(!serial_systems);
+	float systems_budget_ms = 0.0f;
+	parser.try_get("systems_budget_ms", systems_budget_ms);
+	scheduler.set_budget(std::chrono::duration_cast<system_scheduler::clock_t::duration>(
+		std::chrono::duration<float, std::milli>(std::max(systems_budget_ms, 0.0f))));
+	// the poses are animated before the bones are brought to the world
+	core::add_subsystem<animation_system>();
 	core::add_subsystem<bone_system>();
+	// after the systems that move transforms, before the ones reading them
+	core::add_subsystem<transform_system>();
+	core::add_subsystem<bounds_system>();
 	core::add_subsystem<camera_system>();
 	core::add_subsystem<reflection_probe_system>();
 	core::add_subsystem<deferred_rendering>();
 	core::add_subsystem<audio_system>();
+	// a scene compiled in cells streamed around the cameras
+	auto& world = core::add_subsystem<world_streaming>();
+	std::string stream_scene;
+	if(parser.try_get("stream_scene", stream_scene) && !stream_scene.empty())
+	{
+		world.open(stream_scene);
+		gpu_capture_.set_scene_getter([stream_scene]() { return stream_scene; });
+	}
+
+	std::string replay_input;
+	std::string record_input;
+	if(parser.try_get("replay_input", replay_input) && !replay_input.empty())
+	{
+		float replay_step_ms = 0.0f;
+		parser.try_get("replay_step_ms", replay_step_ms);
+		parser.try_get("replay_output", replay_output_);
+		const auto replay_step = std::chrono::duration_cast<core::simulation::duration_t>(
+			std::chrono::duration<float, std::milli>(std::max(replay_step_ms, 0.0f)));
+		input_recording_.replay(replay_input, replay_step);
+	}
+	else if(parser.try_get("record_input", record_input) && !record_input.empty())
+	{
+		input_recording_.record(record_input);
+	}
+	phases.log("Engine started");
 }
 
 void app::stop()
 {
+	core::get_subsystem<core::simulation>().set_wait_work(nullptr);
+	input_recording_.stop();
+	scene_benchmark_.reset();
+	fs::unmount_archives();
 }
 
-void poll_events()
+void app::run_one_frame()
 {
-	auto& renderer = core::get_subsystem<runtime::renderer>();
-	const auto& windows = renderer.get_windows();
+	using namespace std::literals;
 
-	std::uint32_t focused_id = 0;
-	std::map<std::uint32_t, std::vector<mml::platform_event>> collected_events;
-	for(const auto& window : windows)
+	auto& sim = core::get_subsystem<core::simulation>();
+	auto& tasks = core::get_subsystem<core::task_system>();
+	auto& renderer = core::get_subsystem<runtime::renderer>();
+	const bool is_active = renderer.get_focused_window() != nullptr;
+	const bool was_replaying = input_recording_.is_replaying();
+	input_recording_.begin_frame(sim);
+	if(was_replaying && !input_recording_.is_replaying() && !replay_output_.empty())
 	{
-		const auto id = window->get_id();
-		std::vector<mml::platform_event> events;
-		mml::platform_event e;
-		while(window->poll_event(e))
-		{
-			events.emplace_back(e);
-		}
-
-		if(window->has_focus())
-		{
-			focused_id = id;
-		}
+		quit(input_recording_.write_frame_times(replay_output_) ? 0 : -1);
+		return;
+	}
+	sim.run_one_frame(is_active);
+	// after the wait for the frame
+	PROFILE_SCOPE("frame");
+	gpu_capture_.update(sim);
 
-		if(!events.empty())
+	if(adaptive_owner_tasks_budget_)
+	{
+		// the frame work time includes the owner tasks of the previous frame so
+		// they are given back together with whatever time the frame had left.
+		const auto target = sim.get_target_frame_time();
+		if(target > core::simulation::duration_t::zero())
 		{
-			collected_events.emplace(id, std::move(events));
+			const auto min_budget = std::min<core::simulation::duration_t>(1ms, target);
+			owner_tasks_budget_ =
+				std::max(min_budget, std::min(target, owner_tasks_time_ + sim.get_frame_time_left()));
 		}
 	}
 
-	for(const auto& event_pair : collected_events)
+	const auto owner_tasks_begin = core::simulation::clock_t::now();
 	{
-		const auto id = event_pair.first;
-		const auto& events = event_pair.second;
-		std::pair<std::uint32_t, bool> info{id, (id == focused_id)};
-		on_platform_events(info, events);
+		PROFILE_SCOPE("owner_tasks");
+		tasks.run_on_owner_thread(owner_tasks_budget_);
 	}
-}
+	owner_tasks_time_ = core::simulation::clock_t::now() - owner_tasks_begin;
 
-void app::run_one_frame()
-{
-	using namespace std::literals;
+	{
+		PROFILE_SCOPE("asset_manager");
+		core::scoped_memory_tag alloc_tag(core::memory_tag::assets);
+		core::get_subsystem<asset_manager>().update();
+	}
 
-	auto& sim = core::get_subsystem<core::simulation>();
-	auto& tasks = core::get_subsystem<core::task_system>();
-	auto& renderer = core::get_subsystem<runtime::renderer>();
-	const bool is_active = renderer.get_focused_window() != nullptr;
-	sim.run_one_frame(is_active);
-	tasks.run_on_owner_thread(5ms);
+	// what the workers posted to the events is emitted here
+	signals::dispatch_posted_events();
 
 	auto dt = sim.get_delta_time();
 
-	poll_events();
+	// as late as it can be, what came in while the frame waited is in too
+	renderer.sample_input();
+	platform_events_.collect(renderer.get_windows());
+	input_recording_.process_events(platform_events_, sim);
+	platform_events_.dispatch();
+	if(gpu_capture_.is_loaded() && core::get_subsystem<input>().is_key_pressed(mml::keyboard::F11))
+	{
+		gpu_capture_.capture("key");
+	}
 
 	renderer.process_pending_windows();
 
@@ -134,15 +412,62 @@ void app::run_one_frame()
 		return;
 	}
 
-	on_frame_begin(dt);
+	{
+		PROFILE_SCOPE("on_frame_begin");
+		on_frame_begin(dt);
+	}
 
-	on_frame_update(dt);
+	if(sim.is_fixed_timestep())
+	{
+		// the update costs the same at any frame rate, the rendering blends
+		// between the last two steps with the interpolation alpha
+		const auto fixed_dt = sim.get_fixed_delta_time();
+		for(std::uint32_t step = 0; step < sim.get_fixed_steps(); ++step)
+		{
+			PROFILE_SCOPE("on_frame_update");
+			on_frame_update(fixed_dt);
+		}
+	}
+	else
+	{
+		PROFILE_SCOPE("on_frame_update");
+		on_frame_update(dt);
+	}
+
+	{
+		PROFILE_SCOPE("on_frame_render");
+		core::scoped_memory_tag alloc_tag(core::memory_tag::rendering);
+		on_frame_render(dt);
+	}
+
+	{
+		PROFILE_SCOPE("on_frame_ui_render");
+		core::scoped_memory_tag alloc_tag(core::memory_tag::editor);
+		on_frame_ui_render(dt);
+	}
 
-	on_frame_render(dt);
+	{
+		PROFILE_SCOPE("on_frame_end");
+		on_frame_end(dt);
+	}
 
-	on_frame_ui_render(dt);
+	if(scene_benchmark_ && scene_benchmark_->is_finished())
+	{
+		quit(scene_benchmark_->write() ? 0 : -1);
+		scene_benchmark_.reset();
+	}
 
-	on_frame_end(dt);
+	// the frame memory of every thread is reused by the next frame
+	core::frame_arena::next_frame();
+
+	if(core::memory_tracker::next_frame())
+	{
+		const auto stats = core::memory_tracker::get_stats();
+		APPLOG_WARNING("Allocation spike: {0} allocations, {1} bytes in the frame, {2:.0f} on average.",
+					   stats.frame_allocations, stats.frame_bytes, stats.average_allocations);
+	}
+
+	core::get_subsystem<entity_component_system>().maybe_compact();
 }
 
 int app::run(int argc, char* argv[])
@@ -182,6 +507,24 @@ int app::run(int argc, char* argv[])
 		return exitcode_;
 	}
 
+	std::string benchmark;
+	parser.try_get("benchmark", benchmark);
+	if(!benchmark.empty())
+	{
+		APPLOG_INFO("Running the benchmarks...");
+		const auto results = benchmarks::run();
+		for(const auto& result : results)
+		{
+			APPLOG_INFO("{0}: {1:.3f} ms median, {2:.3f} ms min over {3} runs of {4} items.", result.name,
+						result.median_ms, result.min_ms, result.runs, result.items);
+		}
+		if(!benchmarks::write(benchmark, results))
+		{
+			quit_with_error("Failed to write the benchmarks to " + benchmark);
+		}
+		running_ = false;
+	}
+
 	APPLOG_INFO("Starting...");
 	while(running_)
 		run_one_frame();
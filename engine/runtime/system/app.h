@@ -1,11 +1,25 @@
 #pragma once
 
+#include "../input/input_recording.h"
+#include "../input/platform_event_queue.h"
+#include "../rendering/gpu_capture.h"
+
 #include <core/cmd_line/parser.hpp>
 #include <core/common/basetypes.hpp>
 #include <core/system/subsystem.h>
 
+#include <chrono>
+#include <memory>
+
+namespace logging
+{
+class async_file_sink;
+}
+
 namespace runtime
 {
+class scene_benchmark;
+
 struct app
 {
 	virtual ~app() = default;
@@ -71,5 +85,23 @@ protected:
 	/// exit code of the application
 	int exitcode_ = 0;
 	bool running_ = true;
+	/// time given to the owner thread tasks every frame
+	std::chrono::steady_clock::duration owner_tasks_budget_ = std::chrono::milliseconds(5);
+	/// time the owner thread tasks took last frame
+	std::chrono::steady_clock::duration owner_tasks_time_ = std::chrono::steady_clock::duration::zero();
+	/// recompute the budget from the frame time left every frame
+	bool adaptive_owner_tasks_budget_ = false;
+	/// the sink writing Log.txt
+	std::shared_ptr<logging::async_file_sink> log_file_;
+	/// flies the camera through a scene and quits, with --benchmark_scene
+	std::shared_ptr<scene_benchmark> scene_benchmark_;
+	/// the events of the windows, also collected while the frame waits
+	platform_event_queue platform_events_;
+	/// records the input or plays it back, with --record_input or --replay_input
+	input_recording input_recording_;
+	/// where the frame times of the replay are written, the app quits after it
+	std::string replay_output_;
+	/// gpu captures through RenderDoc, when the app runs with it
+	gpu_capture gpu_capture_;
 };
 }
@@ -1,4 +1,5 @@
 #include "app_setup.h"
+#include "scene_benchmark.h"
 
 #include "../assets/asset_manager.h"
 #include "../assets/impl/asset_reader.h"
@@ -8,11 +9,18 @@
 #include "../ecs/constructs/scene.h"
 #include "../rendering/material.h"
 #include "../rendering/mesh.h"
+#include "../rendering/virtual_texturing.h"
 
 #include <core/audio/sound.h>
 #include <core/graphics/shader.h>
 #include <core/graphics/texture.h>
 
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
 namespace runtime
 {
 
@@ -21,118 +29,134 @@ void setup_asset_manager()
 	auto& manager = core::get_subsystem<asset_manager>();
 	{
 		auto& storage = manager.add_storage<gfx::shader>();
+		storage.name = "shader";
 		storage.load_from_file = asset_reader::load_from_file<gfx::shader>;
 		storage.load_from_instance = asset_reader::load_from_instance<gfx::shader>;
+		// compiled per renderer, shaders are not given in memory
 	}
 	{
 		auto& storage = manager.add_storage<gfx::texture>();
+		storage.name = "texture";
 		storage.load_from_file = asset_reader::load_from_file<gfx::texture>;
 		storage.load_from_instance = asset_reader::load_from_instance<gfx::texture>;
+		storage.load_from_memory = asset_reader::load_from_memory<gfx::texture>;
+		storage.size_of = [](const gfx::texture& tex) { return std::size_t(tex.info.storageSize); };
+	}
+	{
+		auto& storage = manager.add_storage<virtual_texture>();
+		storage.name = "virtual_texture";
+		storage.load_from_file = asset_reader::load_from_file<virtual_texture>;
+		storage.load_from_instance = asset_reader::load_from_instance<virtual_texture>;
+		storage.load_from_memory = asset_reader::load_from_memory<virtual_texture>;
 	}
 	{
 		auto& storage = manager.add_storage<mesh>();
+		storage.name = "mesh";
 		storage.load_from_file = asset_reader::load_from_file<mesh>;
 		storage.load_from_instance = asset_reader::load_from_instance<mesh>;
+		storage.load_from_memory = asset_reader::load_from_memory<mesh>;
+		storage.size_of = [](const mesh& m) {
+			return std::size_t(m.get_vertex_count()) * m.get_vertex_format().getStride() +
+				   std::size_t(m.get_face_count()) * 3 * sizeof(std::uint32_t);
+		};
 	}
 	{
 		auto& storage = manager.add_storage<audio::sound>();
+		storage.name = "sound";
 		storage.load_from_file = asset_reader::load_from_file<audio::sound>;
 		storage.load_from_instance = asset_reader::load_from_instance<audio::sound>;
+		storage.load_from_memory = asset_reader::load_from_memory<audio::sound>;
+		storage.size_of = [](const audio::sound& snd) { return snd.get_memory_size(); };
 	}
 	{
 		auto& storage = manager.add_storage<material>();
+		storage.name = "material";
 		storage.load_from_file = asset_reader::load_from_file<material>;
 		storage.load_from_instance = asset_reader::load_from_instance<material>;
+		storage.load_from_memory = asset_reader::load_from_memory<material>;
+		storage.visit_owned = [](const material& mat, const std::function<void(const void*)>& visitor) {
+			mat.visit_textures([&visitor](const gfx::texture& tex) { visitor(&tex); });
+		};
 	}
 	{
 		auto& storage = manager.add_storage<animation>();
+		storage.name = "animation";
 		storage.load_from_file = asset_reader::load_from_file<animation>;
 		storage.load_from_instance = asset_reader::load_from_instance<animation>;
+		storage.load_from_memory = asset_reader::load_from_memory<animation>;
+		storage.size_of = [](const animation& anim) { return anim.clip.get_memory_size(); };
 	}
 	{
 		auto& storage = manager.add_storage<prefab>();
+		storage.name = "prefab";
 		storage.load_from_file = asset_reader::load_from_file<prefab>;
 		storage.load_from_instance = asset_reader::load_from_instance<prefab>;
+		storage.load_from_memory = asset_reader::load_from_memory<prefab>;
+		storage.visit_owned = [](const prefab& asset, const std::function<void(const void*)>& visitor) {
+			for(const auto& link : asset.dependencies)
+			{
+				visitor(link.get());
+			}
+		};
 	}
 	{
 		auto& storage = manager.add_storage<scene>();
+		storage.name = "scene";
 		storage.load_from_file = asset_reader::load_from_file<scene>;
 		storage.load_from_instance = asset_reader::load_from_instance<scene>;
+		storage.load_from_memory = asset_reader::load_from_memory<scene>;
+		storage.visit_owned = [](const scene& asset, const std::function<void(const void*)>& visitor) {
+			for(const auto& link : asset.dependencies)
+			{
+				visitor(link.get());
+			}
+		};
 	}
 
+	// The shapes are generated on the workers at once, the layout is read
+	// here before they start.
+	const auto layout = gfx::mesh_vertex::get_layout();
+	std::vector<std::pair<std::string, core::task_future<std::shared_ptr<mesh>>>> shapes;
+	const auto add_shape = [&shapes](std::string id, std::function<bool(mesh&)> create) {
+		shapes.emplace_back(std::move(id), mesh::create_async(std::move(create)));
+	};
+	add_shape("embedded:/sphere", [layout](mesh& m) {
+		return m.create_sphere(layout, 0.5f, 20, 20, mesh_create_origin::center, false);
+	});
+	add_shape("embedded:/cube", [layout](mesh& m) {
+		return m.create_cube(layout, 1.0f, 1.0f, 1.0f, 1, 1, 1, mesh_create_origin::center, false);
+	});
+	add_shape("embedded:/plane", [layout](mesh& m) {
+		return m.create_plane(layout, 10.0f, 10.0f, 1, 1, mesh_create_origin::center, false);
+	});
+	add_shape("embedded:/cylinder", [layout](mesh& m) {
+		return m.create_cylinder(layout, 0.5f, 2.0f, 20, 20, mesh_create_origin::center, false);
+	});
+	add_shape("embedded:/capsule", [layout](mesh& m) {
+		return m.create_capsule(layout, 0.5f, 2.0f, 20, 20, mesh_create_origin::center, false);
+	});
+	add_shape("embedded:/cone", [layout](mesh& m) {
+		return m.create_cone(layout, 0.5f, 0.0f, 2, 20, 20, mesh_create_origin::bottom, false);
+	});
+	add_shape("embedded:/torus", [layout](mesh& m) {
+		return m.create_torus(layout, 1.0f, 0.5f, 20, 20, mesh_create_origin::center, false);
+	});
+	add_shape("embedded:/teapot", [layout](mesh& m) { return m.create_teapot(layout, false); });
+	add_shape("embedded:/icosahedron", [layout](mesh& m) { return m.create_icosahedron(layout, false); });
+	add_shape("embedded:/dodecahedron", [layout](mesh& m) { return m.create_dodecahedron(layout, false); });
+	for(int i = 0; i < 20; ++i)
 	{
-		const auto id = "embedded:/sphere";
-		auto instance = std::make_shared<mesh>();
-		instance->create_sphere(gfx::mesh_vertex::get_layout(), 0.5f, 20, 20, mesh_create_origin::center);
-		manager.load_asset_from_instance(id, instance);
-	}
-	{
-		const auto id = "embedded:/cube";
-		auto instance = std::make_shared<mesh>();
-		instance->create_cube(gfx::mesh_vertex::get_layout(), 1.0f, 1.0f, 1.0f, 1, 1, 1,
-							  mesh_create_origin::center);
-		manager.load_asset_from_instance(id, instance);
-	}
-	{
-		const auto id = "embedded:/plane";
-		auto instance = std::make_shared<mesh>();
-		instance->create_plane(gfx::mesh_vertex::get_layout(), 10.0f, 10.0f, 1, 1,
-							   mesh_create_origin::center);
-		manager.load_asset_from_instance(id, instance);
-	}
-	{
-		const auto id = "embedded:/cylinder";
-		auto instance = std::make_shared<mesh>();
-		instance->create_cylinder(gfx::mesh_vertex::get_layout(), 0.5f, 2.0f, 20, 20,
-								  mesh_create_origin::center);
-		manager.load_asset_from_instance(id, instance);
-	}
-	{
-		const auto id = "embedded:/capsule";
-		auto instance = std::make_shared<mesh>();
-		instance->create_capsule(gfx::mesh_vertex::get_layout(), 0.5f, 2.0f, 20, 20,
-								 mesh_create_origin::center);
-		manager.load_asset_from_instance(id, instance);
-	}
-	{
-		const auto id = "embedded:/cone";
-		auto instance = std::make_shared<mesh>();
-		instance->create_cone(gfx::mesh_vertex::get_layout(), 0.5f, 0.0f, 2, 20, 20,
-							  mesh_create_origin::bottom);
-		manager.load_asset_from_instance(id, instance);
-	}
-	{
-		const auto id = "embedded:/torus";
-		auto instance = std::make_shared<mesh>();
-		instance->create_torus(gfx::mesh_vertex::get_layout(), 1.0f, 0.5f, 20, 20,
-							   mesh_create_origin::center);
-		manager.load_asset_from_instance(id, instance);
-	}
-	{
-		const auto id = "embedded:/teapot";
-		auto instance = std::make_shared<mesh>();
-		instance->create_teapot(gfx::mesh_vertex::get_layout());
-		manager.load_asset_from_instance(id, instance);
-	}
-	{
-		const auto id = "embedded:/icosahedron";
-		auto instance = std::make_shared<mesh>();
-		instance->create_icosahedron(gfx::mesh_vertex::get_layout());
-		manager.load_asset_from_instance(id, instance);
-	}
-	{
-		const auto id = "embedded:/dodecahedron";
-		auto instance = std::make_shared<mesh>();
-		instance->create_dodecahedron(gfx::mesh_vertex::get_layout());
-		manager.load_asset_from_instance(id, instance);
+		add_shape(std::string("embedded:/icosphere") + std::to_string(i),
+				  [layout, i](mesh& m) { return m.create_icosphere(layout, i, false); });
 	}
 
-	for(int i = 0; i < 20; ++i)
+	for(auto& shape : shapes)
 	{
-		const auto id = std::string("embedded:/icosphere") + std::to_string(i);
-		auto instance = std::make_shared<mesh>();
-		instance->create_icosphere(gfx::mesh_vertex::get_layout(), i);
-		manager.load_asset_from_instance(id, instance);
+		auto instance = shape.second.get();
+		if(instance)
+		{
+			manager.load_asset_from_instance(shape.first, instance);
+		}
 	}
 
 	{
@@ -149,4 +173,47 @@ void setup_asset_manager()
 		manager.load_asset_from_instance<material>(id, instance);
 	}
 }
+
+void setup_asset_streaming(cmd_line::parser& parser)
+{
+	auto& am = core::get_subsystem<asset_manager>();
+	int asset_loads = 8;
+	parser.try_get("asset_loads", asset_loads);
+	am.set_max_loads(static_cast<std::size_t>(std::max(asset_loads, 1)));
+
+	const std::size_t megabyte = 1024 * 1024;
+	int texture_budget = 0;
+	parser.try_get("texture_budget", texture_budget);
+	am.set_budget<gfx::texture>(static_cast<std::size_t>(std::max(texture_budget, 0)) * megabyte);
+	int mesh_budget = 0;
+	parser.try_get("mesh_budget", mesh_budget);
+	am.set_budget<mesh>(static_cast<std::size_t>(std::max(mesh_budget, 0)) * megabyte);
+	int upload_budget = 0;
+	parser.try_get("upload_budget", upload_budget);
+	am.get_upload_queue().set_budget(static_cast<std::size_t>(std::max(upload_budget, 0)) * megabyte);
+}
+
+std::shared_ptr<scene_benchmark> setup_scene_benchmark(cmd_line::parser& parser)
+{
+	scene_benchmark::settings settings;
+	parser.try_get("benchmark_scene", settings.scene);
+	if(settings.scene.empty())
+	{
+		return nullptr;
+	}
+
+	std::string camera_path;
+	parser.try_get("benchmark_path", camera_path);
+	settings.camera_path = camera_path;
+	std::string output = "benchmark_scene.json";
+	parser.try_get("benchmark_output", output);
+	settings.output = output;
+	int warmup_frames = 60;
+	parser.try_get("benchmark_warmup", warmup_frames);
+	settings.warmup_frames = static_cast<std::uint32_t>(std::max(warmup_frames, 0));
+	int frames = 600;
+	parser.try_get("benchmark_frames", frames);
+	settings.frames = static_cast<std::uint32_t>(std::max(frames, 1));
+	return std::make_shared<scene_benchmark>(settings);
+}
 }
@@ -1,6 +1,30 @@
 #pragma once
 
+#include <core/cmd_line/parser.hpp>
+
+#include <memory>
+
 namespace runtime
 {
+class scene_benchmark;
+
 void setup_asset_manager();
+
+//-----------------------------------------------------------------------------
+//  Name : setup_asset_streaming ()
+/// <summary>
+/// Sets the loads in flight and the budgets of the asset manager from the
+/// command line.
+/// </summary>
+//-----------------------------------------------------------------------------
+void setup_asset_streaming(cmd_line::parser& parser);
+
+//-----------------------------------------------------------------------------
+//  Name : setup_scene_benchmark ()
+/// <summary>
+/// Creates the scene benchmark when the command line names a scene, null
+/// otherwise.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::shared_ptr<scene_benchmark> setup_scene_benchmark(cmd_line::parser& parser);
 }
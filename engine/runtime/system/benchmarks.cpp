@@ -0,0 +1,302 @@
+#include "benchmarks.h"
+
+#include "../ecs/components/transform_component.h"
+#include "../ecs/constructs/utils.h"
+#include "../ecs/ecs.h"
+#include "../ecs/systems/transform_system.h"
+
+#include <core/math/frustum.h>
+#include <core/system/subsystem.h>
+#include <core/tasks/task_group.h>
+#include <core/tasks/task_system.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <random>
+
+namespace runtime
+{
+namespace benchmarks
+{
+namespace
+{
+using steady_clock = std::chrono::steady_clock;
+
+constexpr std::size_t runs = 10;
+constexpr std::size_t entities_count = 10000;
+/// the roots of the hierarchy and the depth of the chain under each
+constexpr std::size_t roots_count = 1000;
+constexpr std::size_t chain_depth = 10;
+constexpr std::size_t boxes_count = 65536;
+constexpr std::size_t tasks_count = 10000;
+constexpr std::size_t parallel_count = 1 << 20;
+
+double get_elapsed_ms(steady_clock::time_point begin)
+{
+	return std::chrono::duration<double, std::milli>(steady_clock::now() - begin).count();
+}
+
+//-----------------------------------------------------------------------------
+//  Name : measure ()
+/// <summary>
+/// Calls run the given number of times, it returns the milliseconds of the
+/// part it wants measured so that its setup is left out.
+/// </summary>
+//-----------------------------------------------------------------------------
+template <typename F>
+benchmark_result measure(const char* name, std::size_t items, F&& run)
+{
+	std::vector<double> samples;
+	samples.reserve(runs);
+	for(std::size_t i = 0; i < runs; ++i)
+	{
+		samples.push_back(run());
+	}
+	std::sort(std::begin(samples), std::end(samples));
+
+	benchmark_result result;
+	result.name = name;
+	result.items = items;
+	result.runs = runs;
+	result.min_ms = samples.front();
+	result.median_ms = samples[samples.size() / 2];
+	result.mean_ms = std::accumulate(std::begin(samples), std::end(samples), 0.0) / double(samples.size());
+	return result;
+}
+
+std::vector<entity> create_entities(entity_component_system& ecs, std::size_t count)
+{
+	std::vector<entity> entities;
+	entities.reserve(count);
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		auto e = ecs.create();
+		e.assign<transform_component>().lock()->set_local_position(
+			math::vec3(float(i % 100), float(i / 100 % 100), float(i / 10000)));
+		entities.emplace_back(e);
+	}
+	return entities;
+}
+
+void run_ecs(std::vector<benchmark_result>& results)
+{
+	auto& ecs = core::get_subsystem<entity_component_system>();
+
+	results.emplace_back(measure("ecs_create", entities_count, [&]() {
+		const auto begin = steady_clock::now();
+		const auto entities = create_entities(ecs, entities_count);
+		const auto elapsed = get_elapsed_ms(begin);
+		ecs.destroy_many(entities);
+		return elapsed;
+	}));
+
+	results.emplace_back(measure("ecs_destroy", entities_count, [&]() {
+		const auto entities = create_entities(ecs, entities_count);
+		const auto begin = steady_clock::now();
+		ecs.destroy_many(entities);
+		return get_elapsed_ms(begin);
+	}));
+
+	const auto entities = create_entities(ecs, entities_count);
+	results.emplace_back(measure("ecs_each", entities_count, [&]() {
+		const auto begin = steady_clock::now();
+		math::vec3 sum(0.0f);
+		ecs.each<transform_component>([&sum](entity /*e*/, transform_component& transform) {
+			sum += transform.get_local_position();
+		});
+		const auto elapsed = get_elapsed_ms(begin);
+		// keeps the loop from being optimized away
+		volatile float keep = sum.x;
+		(void)keep;
+		return elapsed;
+	}));
+	ecs.destroy_many(entities);
+}
+
+void run_transforms(std::vector<benchmark_result>& results)
+{
+	auto& ecs = core::get_subsystem<entity_component_system>();
+	auto& transforms = core::get_subsystem<transform_system>();
+
+	std::vector<entity> entities;
+	std::vector<entity> roots;
+	entities.reserve(roots_count * chain_depth);
+	roots.reserve(roots_count);
+	for(std::size_t i = 0; i < roots_count; ++i)
+	{
+		auto parent = ecs.create();
+		parent.assign<transform_component>();
+		roots.emplace_back(parent);
+		entities.emplace_back(parent);
+		for(std::size_t depth = 1; depth < chain_depth; ++depth)
+		{
+			auto child = ecs.create();
+			auto transform = child.assign<transform_component>().lock();
+			transform->set_parent(parent);
+			transform->set_local_position(math::vec3(0.0f, 1.0f, 0.0f));
+			entities.emplace_back(child);
+			parent = child;
+		}
+	}
+	transforms.frame_update(delta_t(0.0f));
+
+	float offset = 0.0f;
+	results.emplace_back(measure("transform_hierarchy", entities.size(), [&]() {
+		offset += 1.0f;
+		for(auto& root : roots)
+		{
+			auto transform = root.get_component<transform_component>().lock();
+			transform->set_local_position(math::vec3(offset, 0.0f, 0.0f));
+		}
+		const auto begin = steady_clock::now();
+		transforms.frame_update(delta_t(0.0f));
+		return get_elapsed_ms(begin);
+	}));
+	ecs.destroy_many(entities);
+}
+
+void run_culling(std::vector<benchmark_result>& results)
+{
+	std::mt19937 generator(1234);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> extent(0.5f, 2.0f);
+
+	std::vector<float> data(boxes_count * 6);
+	for(std::size_t i = 0; i < boxes_count * 3; ++i)
+	{
+		data[i] = position(generator);
+		data[boxes_count * 3 + i] = extent(generator);
+	}
+	math::aabb_soa boxes;
+	boxes.center_x = data.data();
+	boxes.center_y = data.data() + boxes_count;
+	boxes.center_z = data.data() + boxes_count * 2;
+	boxes.extent_x = data.data() + boxes_count * 3;
+	boxes.extent_y = data.data() + boxes_count * 4;
+	boxes.extent_z = data.data() + boxes_count * 5;
+	boxes.count = boxes_count;
+
+	const math::frustum frustum(math::bbox(-50.0f, -50.0f, -50.0f, 50.0f, 50.0f, 50.0f));
+	std::vector<std::uint64_t> visible(math::get_visibility_words(boxes_count));
+
+	results.emplace_back(measure("frustum_cull", boxes_count, [&]() {
+		const auto begin = steady_clock::now();
+		frustum.test_aabbs(boxes, visible.data());
+		return get_elapsed_ms(begin);
+	}));
+
+	results.emplace_back(measure("frustum_cull_scalar", boxes_count, [&]() {
+		const auto begin = steady_clock::now();
+		frustum.test_aabbs_scalar(boxes, visible.data());
+		return get_elapsed_ms(begin);
+	}));
+}
+
+void run_tasks(std::vector<benchmark_result>& results)
+{
+	auto& ts = core::get_subsystem<core::task_system>();
+
+	results.emplace_back(measure("task_push", tasks_count, [&]() {
+		std::vector<core::task_future<void>> futures;
+		futures.reserve(tasks_count);
+		const auto begin = steady_clock::now();
+		for(std::size_t i = 0; i < tasks_count; ++i)
+		{
+			futures.emplace_back(ts.push_or_execute_on_worker_thread([]() {}));
+		}
+		for(const auto& future : futures)
+		{
+			future.wait();
+		}
+		return get_elapsed_ms(begin);
+	}));
+
+	std::vector<float> values(parallel_count);
+	results.emplace_back(measure("parallel_for", parallel_count, [&]() {
+		const auto begin = steady_clock::now();
+		core::parallel_for(ts, std::size_t(0), parallel_count, std::size_t(4096),
+						   [&values](std::size_t i) { values[i] = std::sqrt(float(i)); });
+		return get_elapsed_ms(begin);
+	}));
+}
+
+void run_serialization(std::vector<benchmark_result>& results)
+{
+	auto& ecs = core::get_subsystem<entity_component_system>();
+	const auto entities = create_entities(ecs, entities_count);
+
+	std::vector<std::uint8_t> binary;
+	results.emplace_back(measure("scene_serialize", entities_count, [&]() {
+		binary.clear();
+		const auto begin = steady_clock::now();
+		::ecs::utils::serialize_binary(entities, binary);
+		return get_elapsed_ms(begin);
+	}));
+
+	results.emplace_back(measure("scene_deserialize", entities_count, [&]() {
+		std::vector<entity> loaded;
+		const auto begin = steady_clock::now();
+		::ecs::utils::deserialize_binary(binary, loaded);
+		const auto elapsed = get_elapsed_ms(begin);
+		ecs.destroy_many(loaded);
+		return elapsed;
+	}));
+
+	fs::error_code err;
+	const auto scene_path = fs::temp_directory_path(err) / "benchmark.scene";
+	results.emplace_back(measure("scene_save", entities_count, [&]() {
+		const auto begin = steady_clock::now();
+		::ecs::utils::save_entities_to_file(scene_path, entities);
+		return get_elapsed_ms(begin);
+	}));
+
+	results.emplace_back(measure("scene_load", entities_count, [&]() {
+		std::vector<entity> loaded;
+		const auto begin = steady_clock::now();
+		::ecs::utils::load_entities_from_file(scene_path, loaded);
+		const auto elapsed = get_elapsed_ms(begin);
+		ecs.destroy_many(loaded);
+		return elapsed;
+	}));
+	fs::remove(scene_path, err);
+
+	ecs.destroy_many(entities);
+}
+}
+
+std::vector<benchmark_result> run()
+{
+	std::vector<benchmark_result> results;
+	run_ecs(results);
+	run_transforms(results);
+	run_culling(results);
+	run_tasks(results);
+	run_serialization(results);
+	return results;
+}
+
+bool write(const fs::path& path, const std::vector<benchmark_result>& results)
+{
+	std::ofstream out(path.string(), std::fstream::trunc);
+	if(!out)
+	{
+		return false;
+	}
+
+	out << "{\n\t\"benchmarks\": [";
+	for(std::size_t i = 0; i < results.size(); ++i)
+	{
+		const auto& result = results[i];
+		out << (i == 0 ? "\n" : ",\n");
+		out << "\t\t{\"name\": \"" << result.name << "\", \"items\": " << result.items
+			<< ", \"runs\": " << result.runs << ", \"min_ms\": " << result.min_ms
+			<< ", \"median_ms\": " << result.median_ms << ", \"mean_ms\": " << result.mean_ms << "}";
+	}
+	out << "\n\t]\n}\n";
+	return bool(out);
+}
+}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <core/filesystem/filesystem.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace runtime
+{
+struct benchmark_result
+{
+	std::string name;
+	/// the entities, boxes or tasks a run goes through
+	std::size_t items = 0;
+	std::size_t runs = 0;
+	double min_ms = 0.0;
+	double median_ms = 0.0;
+	double mean_ms = 0.0;
+};
+
+/*
+ * benchmarks; timed runs of the engine hot paths.
+ *
+ *      The ecs, the transform hierarchy, the frustum culling, the task system
+ *      and the scene serialization are each run a few times on generated
+ *      data through the subsystems of the running app, so a change can be
+ *      compared against the numbers of an earlier build on the same machine.
+ */
+namespace benchmarks
+{
+//-----------------------------------------------------------------------------
+//  Name : run ()
+/// <summary>
+/// Runs every benchmark. The subsystems have to be started, the entities
+/// created are destroyed again.
+/// </summary>
+//-----------------------------------------------------------------------------
+std::vector<benchmark_result> run();
+
+//-----------------------------------------------------------------------------
+//  Name : write ()
+/// <summary>
+/// Writes the results as a json document. Returns false if the file could
+/// not be written.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool write(const fs::path& path, const std::vector<benchmark_result>& results);
+}
+}
@@ -0,0 +1,263 @@
+#include "scene_benchmark.h"
+#include "events.h"
+
+#include "../assets/asset_manager.h"
+#include "../ecs/components/camera_component.h"
+#include "../ecs/components/transform_component.h"
+#include "../ecs/constructs/scene.h"
+#include "../rendering/renderer.h"
+
+#include <core/graphics/graphics.h>
+#include <core/logging/logging.h>
+#include <core/system/subsystem.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+
+namespace runtime
+{
+namespace
+{
+/// the keyframes of the circle flown without a path
+constexpr std::size_t circle_keyframes = 64;
+constexpr float circle_radius = 20.0f;
+constexpr float circle_height = 5.0f;
+
+std::vector<scene_benchmark::keyframe> read_path(const fs::path& path)
+{
+	std::vector<scene_benchmark::keyframe> keyframes;
+	std::ifstream in(path.string());
+	std::string line;
+	while(std::getline(in, line))
+	{
+		const auto comment = line.find('#');
+		if(comment != std::string::npos)
+		{
+			line.erase(comment);
+		}
+
+		std::istringstream fields(line);
+		scene_benchmark::keyframe k;
+		if(fields >> k.eye.x >> k.eye.y >> k.eye.z >> k.target.x >> k.target.y >> k.target.z)
+		{
+			keyframes.emplace_back(k);
+		}
+	}
+	return keyframes;
+}
+
+std::vector<scene_benchmark::keyframe> get_circle()
+{
+	std::vector<scene_benchmark::keyframe> keyframes;
+	for(std::size_t i = 0; i <= circle_keyframes; ++i)
+	{
+		const float angle = math::two_pi<float>() * float(i) / float(circle_keyframes);
+		scene_benchmark::keyframe k;
+		k.eye = math::vec3(std::cos(angle) * circle_radius, circle_height, std::sin(angle) * circle_radius);
+		k.target = math::vec3(0.0f, 0.0f, 0.0f);
+		keyframes.emplace_back(k);
+	}
+	return keyframes;
+}
+
+/// the nearest rank percentile of sorted samples
+double get_percentile(const std::vector<double>& sorted, double percentile)
+{
+	if(sorted.empty())
+	{
+		return 0.0;
+	}
+	const auto rank = static_cast<std::size_t>(std::ceil(percentile / 100.0 * double(sorted.size())));
+	return sorted[std::min(sorted.size(), std::max<std::size_t>(rank, 1)) - 1];
+}
+
+std::string to_json_string(const std::string& value)
+{
+	std::string result = "\"";
+	for(const auto c : value)
+	{
+		if(c == '"' || c == '\\')
+		{
+			result += '\\';
+		}
+		result += c;
+	}
+	result += '"';
+	return result;
+}
+}
+
+scene_benchmark::scene_benchmark(const settings& s)
+	: settings_(s)
+{
+	// the first frame loads the scene, it is never measured
+	settings_.warmup_frames = std::max<std::uint32_t>(settings_.warmup_frames, 1);
+	settings_.frames = std::max<std::uint32_t>(settings_.frames, 1);
+	frame_ms_.reserve(settings_.frames);
+	passes_.set_window(settings_.frames);
+
+	on_frame_begin.connect(this, &scene_benchmark::frame_begin);
+	on_frame_end.connect(this, &scene_benchmark::frame_end);
+}
+
+scene_benchmark::~scene_benchmark()
+{
+	on_frame_begin.disconnect(this, &scene_benchmark::frame_begin);
+	on_frame_end.disconnect(this, &scene_benchmark::frame_end);
+	if(loaded_)
+	{
+		gfx::set_debug(BGFX_DEBUG_NONE);
+	}
+}
+
+bool scene_benchmark::load()
+{
+	auto& am = core::get_subsystem<asset_manager>();
+	auto scene = am.load<::scene>(settings_.scene).get();
+	if(!scene)
+	{
+		APPLOG_ERROR("Failed to load the benchmark scene {0}.", settings_.scene);
+		return false;
+	}
+	scene->instantiate(::scene::mode::standard);
+
+	path_ = settings_.camera_path.empty() ? get_circle() : read_path(settings_.camera_path);
+	if(path_.empty())
+	{
+		APPLOG_ERROR("No keyframes in the camera path {0}.", settings_.camera_path.string());
+		return false;
+	}
+
+	auto& ecs = core::get_subsystem<entity_component_system>();
+	ecs.each<camera_component>([this](entity e, camera_component& /*camera_comp*/) {
+		if(!camera_)
+		{
+			camera_ = e;
+		}
+	});
+	if(!camera_)
+	{
+		camera_ = ecs.create();
+		camera_.set_name("BENCHMARK CAMERA");
+		camera_.assign<transform_component>();
+		camera_.assign<camera_component>();
+	}
+	camera_.get_component<camera_component>().lock()->set_viewport_size({1280, 720});
+
+	// bgfx only times the views with its profiler on
+	gfx::set_debug(BGFX_DEBUG_PROFILER);
+	APPLOG_INFO("Benchmarking {0} over {1} frames.", settings_.scene, settings_.frames);
+	return true;
+}
+
+scene_benchmark::keyframe scene_benchmark::get_keyframe(std::uint32_t frame) const
+{
+	if(path_.size() == 1 || settings_.frames == 1)
+	{
+		return path_.front();
+	}
+
+	const float t = float(frame) / float(settings_.frames - 1) * float(path_.size() - 1);
+	const auto index = std::min(static_cast<std::size_t>(t), path_.size() - 2);
+	const float alpha = t - float(index);
+	keyframe k;
+	k.eye = math::lerp(path_[index].eye, path_[index + 1].eye, alpha);
+	k.target = math::lerp(path_[index].target, path_[index + 1].target, alpha);
+	return k;
+}
+
+void scene_benchmark::frame_begin(delta_t /*dt*/)
+{
+	if(finished_)
+	{
+		return;
+	}
+
+	if(!loaded_)
+	{
+		loaded_ = true;
+		if(!load())
+		{
+			failed_ = true;
+			finished_ = true;
+			return;
+		}
+	}
+
+	if(!camera_.valid())
+	{
+		APPLOG_ERROR("The benchmark camera was destroyed.");
+		failed_ = true;
+		finished_ = true;
+		return;
+	}
+
+	const auto measured = frame_ < settings_.warmup_frames ? 0 : frame_ - settings_.warmup_frames;
+	const auto k = get_keyframe(measured);
+	camera_.get_component<transform_component>().lock()->look_at(k.eye, k.target);
+}
+
+void scene_benchmark::frame_end(delta_t /*dt*/)
+{
+	if(finished_ || !loaded_)
+	{
+		return;
+	}
+
+	const auto now = clock_t::now();
+	if(frame_ >= settings_.warmup_frames)
+	{
+		frame_ms_.push_back(std::chrono::duration<double, std::milli>(now - last_frame_end_).count());
+		const auto& rend = core::get_subsystem<renderer>();
+		passes_.update(gfx::get_stats(), rend.get_render_frame());
+	}
+	last_frame_end_ = now;
+
+	++frame_;
+	finished_ = frame_ >= settings_.warmup_frames + settings_.frames;
+}
+
+bool scene_benchmark::write() const
+{
+	if(failed_)
+	{
+		return false;
+	}
+
+	std::ofstream out(settings_.output.string(), std::fstream::trunc);
+	if(!out)
+	{
+		APPLOG_ERROR("Failed to write the benchmark to {0}.", settings_.output.string());
+		return false;
+	}
+
+	auto sorted = frame_ms_;
+	std::sort(std::begin(sorted), std::end(sorted));
+	const double total = std::accumulate(std::begin(sorted), std::end(sorted), 0.0);
+	const double mean = sorted.empty() ? 0.0 : total / double(sorted.size());
+
+	out << "{\n";
+	out << "\t\"scene\": " << to_json_string(settings_.scene) << ",\n";
+	out << "\t\"renderer\": " << to_json_string(gfx::get_renderer_name(gfx::get_renderer_type())) << ",\n";
+	out << "\t\"frames\": " << sorted.size() << ",\n";
+	out << "\t\"frame_ms\": {\"min\": " << (sorted.empty() ? 0.0 : sorted.front()) << ", \"mean\": " << mean
+		<< ", \"p50\": " << get_percentile(sorted, 50.0) << ", \"p90\": " << get_percentile(sorted, 90.0)
+		<< ", \"p95\": " << get_percentile(sorted, 95.0) << ", \"p99\": " << get_percentile(sorted, 99.0)
+		<< ", \"max\": " << (sorted.empty() ? 0.0 : sorted.back()) << "},\n";
+	out << "\t\"passes\": [";
+	const auto& entries = passes_.get_entries();
+	for(std::size_t i = 0; i < entries.size(); ++i)
+	{
+		const auto& e = entries[i];
+		out << (i == 0 ? "\n" : ",\n");
+		out << "\t\t{\"name\": " << to_json_string(e.name) << ", \"views\": " << e.views
+			<< ", \"cpu_avg_ms\": " << e.cpu.avg_ms << ", \"cpu_max_ms\": " << e.cpu.max_ms
+			<< ", \"gpu_avg_ms\": " << e.gpu.avg_ms << ", \"gpu_max_ms\": " << e.gpu.max_ms << "}";
+	}
+	out << "\n\t]\n}\n";
+	return bool(out);
+}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "../ecs/ecs.h"
+#include "../rendering/pass_profiler.h"
+
+#include <core/common/basetypes.hpp>
+#include <core/filesystem/filesystem.h>
+#include <core/math/math_includes.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace runtime
+{
+/*
+ * scene_benchmark; renders a scene from a camera flying a fixed path and
+ * writes the frame times and the time of the render passes as json.
+ *
+ *      The camera is moved by the frame number, not by the time, so every
+ *      run renders the same frames. The path is read from a text file with a
+ *      keyframe per line, the eye and the point looked at as "x y z x y z",
+ *      and '#' starting a comment. Without one the camera circles the origin.
+ *      The scene is loaded at the first frame so that the app is done
+ *      starting. The first frames only load and warm up and are not measured.
+ */
+class scene_benchmark
+{
+public:
+	using clock_t = std::chrono::steady_clock;
+
+	struct settings
+	{
+		/// the asset id of the scene
+		std::string scene;
+		/// the keyframes of the camera, the circle when empty
+		fs::path camera_path;
+		fs::path output;
+		std::uint32_t warmup_frames = 60;
+		std::uint32_t frames = 600;
+	};
+
+	struct keyframe
+	{
+		math::vec3 eye;
+		math::vec3 target;
+	};
+
+	explicit scene_benchmark(const settings& s);
+	~scene_benchmark();
+
+	scene_benchmark(const scene_benchmark&) = delete;
+	scene_benchmark& operator=(const scene_benchmark&) = delete;
+
+	//-----------------------------------------------------------------------------
+	//  Name : is_finished ()
+	/// <summary>
+	/// True once the frames are measured or the scene could not be loaded.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool is_finished() const
+	{
+		return finished_;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : write ()
+	/// <summary>
+	/// Writes the results to the output of the settings. Returns false if the
+	/// benchmark failed or the file could not be written.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool write() const;
+
+private:
+	void frame_begin(delta_t dt);
+	void frame_end(delta_t dt);
+	bool load();
+	keyframe get_keyframe(std::uint32_t frame) const;
+
+	settings settings_;
+	std::vector<keyframe> path_;
+	entity camera_;
+	pass_profiler passes_;
+	/// the wall time of the measured frames
+	std::vector<double> frame_ms_;
+	clock_t::time_point last_frame_end_;
+	std::uint32_t frame_ = 0;
+	bool loaded_ = false;
+	bool failed_ = false;
+	bool finished_ = false;
+};
+}
@@ -0,0 +1,44 @@
+#include "startup_phases.h"
+
+#include <core/logging/logging.h>
+
+#include <iomanip>
+#include <sstream>
+
+namespace runtime
+{
+void startup_phases::next(const char* name)
+{
+	end_phase();
+	running_ = name;
+}
+
+void startup_phases::log(const std::string& title)
+{
+	end_phase();
+	const auto total = std::chrono::duration<double, std::milli>(clock_t::now() - begin_).count();
+
+	std::ostringstream report;
+	report << std::fixed << std::setprecision(1) << title << " in " << total << " ms";
+	for(std::size_t i = 0; i < phases_.size(); ++i)
+	{
+		report << (i == 0 ? ": " : ", ") << phases_[i].name << " " << phases_[i].ms << " ms";
+	}
+	APPLOG_INFO(report.str());
+	phases_.clear();
+}
+
+void startup_phases::end_phase()
+{
+	const auto now = clock_t::now();
+	if(running_ != nullptr)
+	{
+		phase p;
+		p.name = running_;
+		p.ms = std::chrono::duration<double, std::milli>(now - phase_begin_).count();
+		phases_.emplace_back(p);
+		running_ = nullptr;
+	}
+	phase_begin_ = now;
+}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace runtime
+{
+/*
+ * startup_phases; how long each part of the startup took, logged together
+ * once it is done so that the slow ones stand out.
+ */
+class startup_phases
+{
+public:
+	using clock_t = std::chrono::steady_clock;
+
+	//-----------------------------------------------------------------------------
+	//  Name : next ()
+	/// <summary>
+	/// Ends the running phase and starts the one named.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void next(const char* name);
+
+	//-----------------------------------------------------------------------------
+	//  Name : log ()
+	/// <summary>
+	/// Ends the running phase and logs the time of every phase.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void log(const std::string& title);
+
+private:
+	struct phase
+	{
+		const char* name = "";
+		double ms = 0.0;
+	};
+
+	void end_phase();
+
+	std::vector<phase> phases_;
+	const char* running_ = nullptr;
+	clock_t::time_point begin_ = clock_t::now();
+	clock_t::time_point phase_begin_ = begin_;
+};
+}
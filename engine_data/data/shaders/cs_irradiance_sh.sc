@@ -0,0 +1,72 @@
+#include <bgfx_compute.sh>
+#include "common.sh"
+#include "cubemap.sh"
+
+SAMPLERCUBE(s_source, 0);
+IMAGE2D_WR(s_target, rgba32f, 1);
+
+// x = size of the mip projected, y = the mip
+uniform vec4 u_sh_params;
+
+#define THREADS 64
+
+SHARED vec3 s_sums[THREADS * 9];
+
+NUM_THREADS(THREADS, 1, 1)
+void main()
+{
+	int thread = int(gl_LocalInvocationIndex);
+	int size = int(u_sh_params.x);
+	int texels = size * size * 6;
+
+	vec3 sh[9];
+	for(int c = 0; c < 9; ++c)
+	{
+		sh[c] = vec3(0.0f, 0.0f, 0.0f);
+	}
+
+	for(int i = thread; i < texels; i += THREADS)
+	{
+		int face = i / (size * size);
+		int index = i - face * size * size;
+		vec2 uv = (vec2(float(index - (index / size) * size), float(index / size)) + 0.5f) / float(size);
+		uv = uv * 2.0f - 1.0f;
+
+		vec3 n = cubemapDirection(face, uv);
+		float solid_angle = cubemapTexelSolidAngle(uv, float(size));
+		vec3 color = toLinear(textureCubeLod(s_source, n, u_sh_params.y).xyz) * solid_angle;
+
+		// the real spherical harmonics of the first three bands
+		sh[0] += color * 0.282095f;
+		sh[1] += color * 0.488603f * n.y;
+		sh[2] += color * 0.488603f * n.z;
+		sh[3] += color * 0.488603f * n.x;
+		sh[4] += color * 1.092548f * n.x * n.y;
+		sh[5] += color * 1.092548f * n.y * n.z;
+		sh[6] += color * 0.315392f * (3.0f * n.z * n.z - 1.0f);
+		sh[7] += color * 1.092548f * n.x * n.z;
+		sh[8] += color * 0.546274f * (n.x * n.x - n.y * n.y);
+	}
+
+	for(int c = 0; c < 9; ++c)
+	{
+		s_sums[thread * 9 + c] = sh[c];
+	}
+	// the exact solid angles of the texels sum to the 4 pi of the sphere,
+	// nothing is left to normalize
+	barrier();
+
+	if(thread < 9)
+	{
+		vec3 sum = vec3(0.0f, 0.0f, 0.0f);
+		for(int t = 0; t < THREADS; ++t)
+		{
+			sum += s_sums[t * 9 + thread];
+		}
+
+		// convolved with the clamped cosine, the irradiance over pi is the
+		// sum of the coefficients times the harmonics at the normal
+		float band = thread == 0 ? 1.0f : (thread < 4 ? 2.0f / 3.0f : 0.25f);
+		imageStore(s_target, ivec2(thread, 0), vec4(sum * band, 1.0f));
+	}
+}
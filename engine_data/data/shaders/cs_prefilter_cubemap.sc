@@ -0,0 +1,89 @@
+#include <bgfx_compute.sh>
+#include "common.sh"
+#include "cubemap.sh"
+
+SAMPLERCUBE(s_source, 0);
+IMAGE2D_ARRAY_WR(s_target, rgba16f, 1);
+
+// x = roughness of the mip, y = size of the mip, z = size of the source,
+// w = mips of the source
+uniform vec4 u_prefilter_params;
+
+#define SAMPLES 64
+
+vec2 hammersley(int i, int count)
+{
+	// the bits of i reversed, over 2^32
+	uint bits = uint(i);
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+	return vec2(float(i) / float(count), float(bits) * 2.3283064365386963e-10);
+}
+
+NUM_THREADS(8, 8, 1)
+void main()
+{
+	int size = int(u_prefilter_params.y);
+	ivec3 texel = ivec3(gl_GlobalInvocationID.xyz);
+	if(texel.x >= size || texel.y >= size)
+	{
+		return;
+	}
+
+	vec2 uv = (vec2(texel.xy) + 0.5f) / float(size) * 2.0f - 1.0f;
+	vec3 N = cubemapDirection(texel.z, uv);
+
+	// the first mip is the mirror, a copy of the capture
+	float roughness = u_prefilter_params.x;
+	if(roughness == 0.0f)
+	{
+		imageStore(s_target, texel, vec4(textureCubeLod(s_source, N, 0.0f).xyz, 1.0f));
+		return;
+	}
+
+	// the view and the reflection are taken along the normal, as the
+	// probes are looked up with the reflection vector alone
+	float a = roughness * roughness;
+	float a2 = a * a;
+	vec3 up = abs(N.z) < 0.999f ? vec3(0.0f, 0.0f, 1.0f) : vec3(1.0f, 0.0f, 0.0f);
+	vec3 tangent_x = normalize(cross(up, N));
+	vec3 tangent_y = cross(N, tangent_x);
+
+	float source_size = u_prefilter_params.z;
+	float texel_solid_angle = 4.0f * 3.14159265f / (6.0f * source_size * source_size);
+	float max_lod = u_prefilter_params.w - 1.0f;
+
+	vec3 color = vec3(0.0f, 0.0f, 0.0f);
+	float weight = 0.0f;
+	for(int i = 0; i < SAMPLES; ++i)
+	{
+		vec2 xi = hammersley(i, SAMPLES);
+		float phi = 2.0f * 3.14159265f * xi.x;
+		float cos_theta = sqrt((1.0f - xi.y) / (1.0f + (a2 - 1.0f) * xi.y));
+		float sin_theta = sqrt(1.0f - cos_theta * cos_theta);
+		vec3 H = tangent_x * (sin_theta * cos(phi)) + tangent_y * (sin_theta * sin(phi)) + N * cos_theta;
+		vec3 L = 2.0f * dot(N, H) * H - N;
+
+		float NoL = dot(N, L);
+		if(NoL > 0.0f)
+		{
+			// the mip whose texels are as large as the solid angle of the
+			// sample, so that few samples do not alias
+			float NoH = saturate(dot(N, H));
+			float d = NoH * NoH * (a2 - 1.0f) + 1.0f;
+			float pdf = a2 / (3.14159265f * d * d) * 0.25f;
+			float sample_solid_angle = 1.0f / (float(SAMPLES) * pdf + 0.0001f);
+			float lod = 0.5f * log2(sample_solid_angle / texel_solid_angle) + 1.0f;
+
+			color += toLinear(textureCubeLod(s_source, L, clamp(lod, 0.0f, max_lod)).xyz) * NoL;
+			weight += NoL;
+		}
+	}
+
+	// stored as the captures are, the probes read it the same way
+	color = toGamma(color / max(weight, 0.0001f));
+	imageStore(s_target, texel, vec4(color, 1.0f));
+}
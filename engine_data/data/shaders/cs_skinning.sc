@@ -0,0 +1,58 @@
+#include <bgfx_compute.sh>
+#include "common.sh"
+
+// per vertex the position, normal, tangent, bitangent, texcoord, weights and
+// the indices in the palette, the normals as they are stored in [0, 1]
+BUFFER_RO(b_source, vec4, 0);
+// the skinning matrices of the palettes, by columns
+BUFFER_RO(b_bones, vec4, 1);
+// per vertex the position, normal, tangent, bitangent and texcoord in the
+// world, what vs_deferred_geom reads
+BUFFER_WR(b_output, vec4, 2);
+
+// x = first vertex of the palette, y = its vertices, z = its first matrix
+uniform vec4 u_skinning_params;
+
+#define SOURCE_STRIDE 7
+#define OUTPUT_STRIDE 5
+
+mat4 boneMatrix(float index)
+{
+	int first = (int(u_skinning_params.z) + int(index)) * 4;
+	return mtxFromCols(b_bones[first], b_bones[first + 1], b_bones[first + 2], b_bones[first + 3]);
+}
+
+vec4 skinDirection(mat3 modelIT, vec4 direction)
+{
+	vec3 world = normalize(mul(modelIT, direction.xyz * 2.0f - 1.0f));
+	return vec4(world * 0.5f + 0.5f, direction.w);
+}
+
+NUM_THREADS(64, 1, 1)
+void main()
+{
+	int local = int(gl_GlobalInvocationID.x);
+	if(local >= int(u_skinning_params.y))
+	{
+		return;
+	}
+
+	int vertex = int(u_skinning_params.x) + local;
+	int source = vertex * SOURCE_STRIDE;
+	vec4 weights = b_source[source + 5];
+	vec4 indices = b_source[source + 6];
+
+	// the same blend as vs_deferred_geom_skinned
+	mat4 model = weights.x * boneMatrix(indices.x) +
+				 weights.y * boneMatrix(indices.y) +
+				 weights.z * boneMatrix(indices.z) +
+				 weights.w * boneMatrix(indices.w);
+	mat3 modelIT = calculateInverseTranspose(model);
+
+	int target = vertex * OUTPUT_STRIDE;
+	b_output[target + 0] = vec4(mul(model, vec4(b_source[source].xyz, 1.0f)).xyz, 1.0f);
+	b_output[target + 1] = skinDirection(modelIT, b_source[source + 1]);
+	b_output[target + 2] = skinDirection(modelIT, b_source[source + 2]);
+	b_output[target + 3] = skinDirection(modelIT, b_source[source + 3]);
+	b_output[target + 4] = b_source[source + 4];
+}
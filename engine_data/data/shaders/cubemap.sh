@@ -0,0 +1,47 @@
+#ifndef __CUBEMAP_SH__
+#define __CUBEMAP_SH__
+
+// the direction through a texel of a cubemap face, uv in [-1, 1] with v
+// down the rows, as both the samplers and the images address the faces
+vec3 cubemapDirection(int face, vec2 uv)
+{
+	vec3 dir = vec3(-uv.x, -uv.y, -1.0f);
+	if(face == 0)
+	{
+		dir = vec3(1.0f, -uv.y, -uv.x);
+	}
+	else if(face == 1)
+	{
+		dir = vec3(-1.0f, -uv.y, uv.x);
+	}
+	else if(face == 2)
+	{
+		dir = vec3(uv.x, 1.0f, uv.y);
+	}
+	else if(face == 3)
+	{
+		dir = vec3(uv.x, -1.0f, -uv.y);
+	}
+	else if(face == 4)
+	{
+		dir = vec3(uv.x, -uv.y, 1.0f);
+	}
+	return normalize(dir);
+}
+
+// the solid angle of a texel of a face size texels wide
+float cubemapTexelSolidAngle(vec2 uv, float size)
+{
+	float texel = 1.0f / size;
+	vec2 a = uv - texel;
+	vec2 b = uv + texel;
+	// the areas on the unit sphere of the rectangles from the center of the
+	// face to the corners of the texel, after Driscoll
+	vec4 corners = vec4(a.x, a.y, b.x, b.y);
+	return atan2(corners.x * corners.y, sqrt(dot(corners.xy, corners.xy) + 1.0f)) -
+		   atan2(corners.x * corners.w, sqrt(dot(corners.xw, corners.xw) + 1.0f)) -
+		   atan2(corners.z * corners.y, sqrt(dot(corners.zy, corners.zy) + 1.0f)) +
+		   atan2(corners.z * corners.w, sqrt(dot(corners.zw, corners.zw) + 1.0f));
+}
+
+#endif // __CUBEMAP_SH__
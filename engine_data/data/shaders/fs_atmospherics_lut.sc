@@ -0,0 +1,12 @@
+$input v_texcoord0
+
+#include "common.sh"
+#include "atmospherics.sh"
+
+uniform vec4 u_light_direction;
+
+void main()
+{
+	vec3 eye_dir = sky_view_direction(v_texcoord0);
+	gl_FragColor = sky_scattering(eye_dir, u_light_direction.xyz);
+}
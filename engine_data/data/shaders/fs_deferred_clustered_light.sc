@@ -0,0 +1,84 @@
+$input v_texcoord0
+
+#define CLUSTERED_LIGHT 1
+#include "fs_pbr_lighting.sh"
+
+// must match light_grid::max_cluster_lights
+#define MAX_CLUSTER_LIGHTS 64
+
+SAMPLER2D(s_tex7, 7); // lights, 4 texels each
+SAMPLER2D(s_tex8, 8); // clusters, offset and count
+SAMPLER2D(s_tex9, 9); // light indices of the clusters
+
+uniform vec4 u_light_grid;       // tiles x, tiles y, slices
+uniform vec4 u_light_grid_depth; // near clip, log depth to slice scale
+uniform vec4 u_light_grid_sizes; // lights width and height, indices width and height
+
+vec4 fetch_texel(float index, float width, float height)
+{
+	vec2 coord = vec2(mod(index, width), floor(index / width));
+	return texture2DLod(s_tex7, (coord + 0.5) / vec2(width, height), 0.0);
+}
+
+void main()
+{
+	vec2 texcoord0 = v_texcoord0;
+	vec2 render_texcoord = renderTexcoord(texcoord0);
+	GBufferData data = decodeGBuffer(render_texcoord, s_tex0, s_tex1, s_tex2, s_tex3, s_tex4);
+	vec3 indirect_specular = texture2D(s_tex5, render_texcoord).xyz;
+	vec3 world_position = pbr_world_position(texcoord0, data.depth);
+
+	// the cluster of the pixel, the tiles go top down as the light rectangles
+	vec4 clip = mul(u_viewProj, vec4(world_position, 1.0));
+	vec2 screen = vec2(clip.x, -clip.y) / clip.w * 0.5 + 0.5;
+	vec2 tile = clamp(floor(screen * u_light_grid.xy), vec2(0.0, 0.0), u_light_grid.xy - 1.0);
+	float depth = mul(u_view, vec4(world_position, 1.0)).z;
+	float slice = floor(log(max(depth, u_light_grid_depth.x) / u_light_grid_depth.x) * u_light_grid_depth.y);
+	slice = clamp(slice, 0.0, u_light_grid.z - 1.0);
+	vec2 cluster_coord = vec2(tile.x, slice * u_light_grid.y + tile.y);
+	vec4 cluster = texture2DLod(s_tex8, (cluster_coord + 0.5) / vec2(u_light_grid.x, u_light_grid.y * u_light_grid.z), 0.0);
+
+	vec3 indirect_diffuse = vec3(0.0f, 0.0f, 0.0f);
+	vec3 lighting = vec3(0.0f, 0.0f, 0.0f);
+	for(int i = 0; i < MAX_CLUSTER_LIGHTS; ++i)
+	{
+		if(float(i) >= cluster.y)
+		{
+			break;
+		}
+
+		float index = cluster.x + float(i);
+		vec2 index_coord = vec2(mod(index, u_light_grid_sizes.z), floor(index / u_light_grid_sizes.z));
+		float light = texture2DLod(s_tex9, (index_coord + 0.5) / u_light_grid_sizes.zw, 0.0).x;
+
+		float texel = light * 4.0;
+		vec4 position_range = fetch_texel(texel, u_light_grid_sizes.x, u_light_grid_sizes.y);
+		vec4 color_intensity = fetch_texel(texel + 1.0, u_light_grid_sizes.x, u_light_grid_sizes.y);
+		vec4 direction_type = fetch_texel(texel + 2.0, u_light_grid_sizes.x, u_light_grid_sizes.y);
+		vec4 light_data = fetch_texel(texel + 3.0, u_light_grid_sizes.x, u_light_grid_sizes.y);
+
+		vec3 vector_to_light = position_range.xyz - world_position;
+		vec3 vector_to_light_over_radius = vector_to_light / position_range.w;
+		float light_radius_mask = 0.0f;
+		float spot_falloff = 1.0f;
+		if(direction_type.w > 0.5)
+		{
+			light_radius_mask = RadialAttenuation(vector_to_light_over_radius, 1.0f);
+			spot_falloff = SpotAttenuation(vector_to_light_over_radius, normalize(direction_type.xyz), vec2(light_data.y, 1.0f / (light_data.x - light_data.y)));
+		}
+		else
+		{
+			light_radius_mask = RadialAttenuation(vector_to_light_over_radius, light_data.x);
+		}
+
+		lighting += pbr_shade(data, world_position, indirect_specular, indirect_diffuse, vector_to_light, color_intensity.xyz, color_intensity.w, light_radius_mask, spot_falloff);
+	}
+
+	// the emissive goes once per pixel lit by the grid
+	if(cluster.y > 0.0)
+	{
+		lighting += data.emissive_color;
+	}
+
+	gl_FragColor = vec4(lighting, 1.0f);
+}
@@ -1,30 +1,50 @@
-$input v_wpos, v_pos, v_wnormal, v_wtangent, v_wbitangent, v_texcoord0
+$input v_wpos, v_pos, v_wnormal, v_wtangent, v_wbitangent, v_texcoord0, v_layers
 
 #include "common.sh"
 #include "lighting.sh"
 
+// variants: VIRTUAL_COLOR TEXTURE_ARRAYS
+// exclusive: VIRTUAL_COLOR TEXTURE_ARRAYS
+
+#ifdef TEXTURE_ARRAYS
+// the arrays the color and normal maps are layers of, v_layers picks them
+SAMPLER2DARRAY(s_tex_color,  0);
+SAMPLER2DARRAY(s_tex_normal, 1);
+#else
 SAMPLER2D(s_tex_color,  0);
 SAMPLER2D(s_tex_normal, 1);
+#endif
 SAMPLER2D(s_tex_roughness, 2);
 SAMPLER2D(s_tex_metalness, 3);
 SAMPLER2D(s_tex_ao, 4);
 
+#ifdef VIRTUAL_COLOR
+#include "vt.sh"
+// the page cache and the page table of the virtual color map
+SAMPLER2D(s_vt_cache, 5);
+SAMPLER2D(s_vt_color_table, 6);
+uniform vec4 u_vt_color[2];
+#endif
+
 // per frame
 uniform vec4 u_camera_wpos;
 uniform vec4 u_camera_clip_planes; //.x = near, .y = far
 
+// per material, set in one upload
+uniform vec4 u_material[5];
+#define u_base_color u_material[0]
+#define u_subsurface_color u_material[1]
+#define u_emissive_color u_material[2]
+#define u_surface_data u_material[3]
+#define u_tiling u_material[4].xy
+#define u_dither_threshold u_material[4].zw //.x = alpha threshold .y = distance threshold
+
 // per instance
-uniform vec4 u_base_color;
-uniform vec4 u_subsurface_color;
-uniform vec4 u_emissive_color;
-uniform vec4 u_surface_data;
-uniform vec4 u_tiling;
-uniform vec4 u_dither_threshold; //.x = alpha threshold .y = distance threshold
 uniform vec4 u_lod_params;
 
 void main()
 {
-	vec2 texcoords = v_texcoord0.xy * u_tiling.xy;
+	vec2 texcoords = v_texcoord0.xy * u_tiling;
 
 	float roughness = texture2D(s_tex_roughness, texcoords).x * clamp(u_surface_data.x, 0.05f, 1.0f);
 	float metalness = texture2D(s_tex_metalness, texcoords).x * u_surface_data.y;
@@ -33,13 +53,26 @@ void main()
 	float alpha_test_value = u_surface_data.w;
 
 	vec3 view_direction = u_camera_wpos.xyz - v_wpos;
+#ifdef TEXTURE_ARRAYS
+	vec2 layers = floor(v_layers + 0.5);
+	vec3 normal_sample = texture2DArray(s_tex_normal, vec3(texcoords, layers.y)).xyz;
+	vec3 tangent_space_normal = decodeTangentSpaceNormal( normal_sample, bumpiness );
+#else
 	vec3 tangent_space_normal = getTangentSpaceNormal( s_tex_normal, texcoords, bumpiness );
+#endif
 
 	mat3 tangent_to_world_space = computeTangentToWorldSpaceMatrix(normalize(v_wnormal), normalize(view_direction), texcoords.xy);
 	//mat3 tangent_to_world_space = constructTangentToWorldSpaceMatrix(normalize(v_wtangent), normalize(v_wbitangent), normalize(v_wnormal));
 
 	vec3 wnormal = normalize( mul( tangent_to_world_space, tangent_space_normal ).xyz );
+#ifdef VIRTUAL_COLOR
+	vec4 albedo_color = sampleVirtual(s_vt_cache, s_vt_color_table, texcoords, u_vt_color[0], u_vt_color[1]);
+	albedo_color *= u_base_color;
+#elif defined(TEXTURE_ARRAYS)
+	vec4 albedo_color = texture2DArray(s_tex_color, vec3(texcoords, layers.x)) * u_base_color;
+#else
 	vec4 albedo_color = texture2D(s_tex_color, texcoords) * u_base_color;
+#endif
 
 	float distance = length(view_direction) - u_camera_clip_planes.x * 2.0f;
 	float distance_factor = saturate(distance / u_dither_threshold.y);
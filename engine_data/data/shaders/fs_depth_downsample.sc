@@ -0,0 +1,29 @@
+$input v_texcoord0
+
+#include "common.sh"
+
+SAMPLER2D(s_input, 0);
+
+// xy is the size of the part of the input read in texels, zw the inverse
+// size of the input texture
+uniform vec4 u_input_size;
+// xy is the texel the part read starts at
+uniform vec4 u_input_offset;
+
+void main()
+{
+	// the 2x2 input texels under this one, the last row and column of an odd
+	// sized input are clamped so that every input texel is covered
+	vec2 first = u_input_offset.xy + floor(gl_FragCoord.xy) * 2.0 + 0.5;
+	vec2 last = u_input_offset.xy + u_input_size.xy - 0.5;
+	vec2 uv0 = min(first, last) * u_input_size.zw;
+	vec2 uv1 = min(first + 1.0, last) * u_input_size.zw;
+
+	float d0 = texture2DLod(s_input, vec2(uv0.x, uv0.y), 0.0).x;
+	float d1 = texture2DLod(s_input, vec2(uv1.x, uv0.y), 0.0).x;
+	float d2 = texture2DLod(s_input, vec2(uv0.x, uv1.y), 0.0).x;
+	float d3 = texture2DLod(s_input, vec2(uv1.x, uv1.y), 0.0).x;
+
+	// the farthest depth, an object behind it is behind all four
+	gl_FragColor = vec4_splat(max(max(d0, d1), max(d2, d3)));
+}
@@ -0,0 +1,26 @@
+$input v_wpos
+
+#include "common.sh"
+
+// per frame
+uniform vec4 u_camera_wpos;
+uniform vec4 u_camera_clip_planes; //.x = near, .y = far
+
+// per material, laid out as in fs_deferred_geom
+uniform vec4 u_material[5];
+#define u_dither_threshold u_material[4].zw //.x = alpha threshold .y = distance threshold
+
+void main()
+{
+	// the fade near the camera of fs_deferred_geom, the depth must not be
+	// written where it discards
+	float distance = length(u_camera_wpos.xyz - v_wpos) - u_camera_clip_planes.x * 2.0f;
+	float distance_factor = saturate(distance / u_dither_threshold.y);
+	float dither = dither16x16(gl_FragCoord.xy);
+	if(distance_factor + dither < 1.0f)
+	{
+		discard;
+	}
+
+	gl_FragColor = vec4_splat(0.0);
+}
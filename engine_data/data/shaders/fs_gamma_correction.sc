@@ -4,9 +4,16 @@ $input v_texcoord0
 
 SAMPLER2D(s_input, 0);
 
+// .xy scale, .zw offset from the texture coordinates of the view to the
+// part of the input rendered to, and the texture coordinates it covers
+uniform vec4 u_render_uv;
+uniform vec4 u_render_uv_limits;
+
 void main()
 {
-	vec4 data0 = texture2D(s_input, v_texcoord0);
+	vec2 texcoord = v_texcoord0 * u_render_uv.xy + u_render_uv.zw;
+	texcoord = clamp(texcoord, u_render_uv_limits.xy, u_render_uv_limits.zw);
+	vec4 data0 = texture2D(s_input, texcoord);
 	gl_FragColor.xyz = toGamma(data0.xyz);
 	gl_FragColor.w = 1.0;
 }
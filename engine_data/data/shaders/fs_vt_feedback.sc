@@ -0,0 +1,31 @@
+$input v_wpos, v_texcoord0
+
+#include "common.sh"
+#include "vt.sh"
+
+// per frame
+uniform vec4 u_camera_wpos;
+uniform vec4 u_camera_clip_planes; //.x = near, .y = far
+uniform vec4 u_vt_feedback; //.x = level bias of the feedback size
+
+// per material, laid out as in fs_deferred_geom
+uniform vec4 u_material[5];
+#define u_tiling u_material[4].xy
+#define u_dither_threshold u_material[4].zw //.x = alpha threshold .y = distance threshold
+uniform vec4 u_vt_color[2];
+
+void main()
+{
+	// the fade near the camera of fs_deferred_geom, no page is asked for
+	// where it discards
+	float distance = length(u_camera_wpos.xyz - v_wpos) - u_camera_clip_planes.x * 2.0f;
+	float distance_factor = saturate(distance / u_dither_threshold.y);
+	float dither = dither16x16(gl_FragCoord.xy);
+	if(distance_factor + dither < 1.0f)
+	{
+		discard;
+	}
+
+	vec2 texcoords = v_texcoord0.xy * u_tiling;
+	gl_FragColor = encodeVirtualFeedback(texcoords, u_vt_color[0], u_vt_color[1], u_vt_feedback.x);
+}
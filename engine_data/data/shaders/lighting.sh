@@ -14,13 +14,21 @@ struct GBufferData
 	float depth;
 };
 
+// .xy scale, .zw offset from the texture coordinates of the view to the
+// part of the g-buffer it rendered to
+uniform vec4 u_render_uv;
+
+vec2 renderTexcoord(vec2 texcoord)
+{
+	return texcoord * u_render_uv.xy + u_render_uv.zw;
+}
 
 
 void encodeGBuffer(in GBufferData data, inout vec4 result[4])
 {
 	result[0] = vec4(data.base_color, data.ambient_occlusion);
-	//result[1] = vec4(encodeNormalOctahedron(data.world_normal), 0.0f, data.roughness);
-	result[1] = vec4(encodeNormalUint(data.world_normal), data.roughness);
+	// unorm in [0, 1], fits the 10 bit channels of the low tier as well
+	result[1] = vec4(encodeNormalOctahedron(data.world_normal), data.roughness, 0.0f);
 	result[2] = vec4(data.emissive_color, data.metalness);
 	result[3] = vec4(data.subsurface_color, data.subsurface_opacity);
 }
@@ -37,9 +45,8 @@ GBufferData decodeGBuffer(vec2 texcoord, sampler2D tex0, sampler2D tex1, sampler
 
 	data.base_color = data0.xyz;
 	data.ambient_occlusion = data0.w;
-	//data.world_normal = decodeNormalOctahedron(data1.xy);
-	data.world_normal = decodeNormalUint(data1.xyz);
-	data.roughness = data1.w;
+	data.world_normal = decodeNormalOctahedron(data1.xy);
+	data.roughness = data1.z;
 	data.emissive_color = data2.xyz;
 	data.metalness = data2.w;
 	data.subsurface_color = data3.xyz;
@@ -373,9 +373,8 @@ vec3 fixCubeLookup(vec3 _v, float _lod, float _topLevelCubeSize)
 	return _v;
 }
 
-vec3 getTangentSpaceNormal( sampler2D bumpTexture, vec2 texCoords, float bumpiness )
+vec3 decodeTangentSpaceNormal( vec3 normal, float bumpiness )
 {
-    vec3 normal = texture2D(bumpTexture, texCoords).xyz;
   	normal = normal * 2.0f - 1.0f;
 
 #ifdef NORMAL_MAP_2CHANNEL
@@ -387,6 +386,11 @@ vec3 getTangentSpaceNormal( sampler2D bumpTexture, vec2 texCoords, float bumpine
     return normalize(normal);
 }
 
+vec3 getTangentSpaceNormal( sampler2D bumpTexture, vec2 texCoords, float bumpiness )
+{
+    return decodeTangentSpaceNormal(texture2D(bumpTexture, texCoords).xyz, bumpiness);
+}
+
 float dither5x5(vec2 fragCoord)
 {
 float aa = 0.0f;
@@ -1,8 +1,15 @@
 $input a_position, a_normal, a_tangent, a_bitangent, a_texcoord0
-$output v_wpos, v_pos, v_wnormal, v_wtangent, v_wbitangent, v_texcoord0
+$output v_wpos, v_pos, v_wnormal, v_wtangent, v_wbitangent, v_texcoord0, v_layers
 
 #include "common.sh"
 
+// variants: TEXTURE_ARRAYS
+
+#ifdef TEXTURE_ARRAYS
+// the layers of the color and normal maps in their arrays
+uniform vec4 u_texture_layers;
+#endif
+
 void main()
 {
 
@@ -28,4 +35,9 @@ void main()
 
 	v_texcoord0 = a_texcoord0;
 
+#ifdef TEXTURE_ARRAYS
+	v_layers = u_texture_layers.xy;
+#else
+	v_layers = vec2(0.0, 0.0);
+#endif
 }
@@ -0,0 +1,50 @@
+$input a_position, a_normal, a_tangent, a_bitangent, a_texcoord0, i_data0, i_data1, i_data2, i_data3
+$output v_wpos, v_pos, v_wnormal, v_wtangent, v_wbitangent, v_texcoord0, v_layers
+
+#include "common.sh"
+
+// variants: TEXTURE_ARRAYS
+
+void main()
+{
+	// the instance data holds the columns of the world matrix, the matrix is
+	// rebuilt from them so it does not depend on the matrix layout of the backend
+	vec3 c0 = i_data0.xyz;
+	vec3 c1 = i_data1.xyz;
+	vec3 c2 = i_data2.xyz;
+	vec3 c3 = i_data3.xyz;
+
+	vec3 wpos = c0 * a_position.x + c1 * a_position.y + c2 * a_position.z + c3;
+	gl_Position = mul(u_viewProj, vec4(wpos, 1.0) );
+
+	vec4 normal = a_normal * 2.0 - 1.0;
+	vec4 tangent = a_tangent * 2.0 - 1.0;
+	vec4 bitangent = a_bitangent * 2.0 - 1.0;
+
+	// the columns of the inverse transpose, scaled by the determinant whose
+	// sign is kept for the mirrored instances
+	vec3 it0 = cross(c1, c2);
+	vec3 it1 = cross(c2, c0);
+	vec3 it2 = cross(c0, c1);
+	float det_sign = sign(dot(c0, it0));
+
+	vec3 wnormal = normalize((it0 * normal.x + it1 * normal.y + it2 * normal.z) * det_sign);
+	vec3 wtangent = normalize((it0 * tangent.x + it1 * tangent.y + it2 * tangent.z) * det_sign);
+	vec3 wbitangent = normalize((it0 * bitangent.x + it1 * bitangent.y + it2 * bitangent.z) * det_sign);
+
+	v_wpos = wpos;
+	v_pos = gl_Position.xyz/gl_Position.w;
+
+	v_wnormal   = wnormal;
+	v_wtangent   = wtangent;
+	v_wbitangent = wbitangent;
+
+	v_texcoord0 = a_texcoord0;
+
+#ifdef TEXTURE_ARRAYS
+	// the layers of the copy are in the w of the first two columns
+	v_layers = vec2(i_data0.w, i_data1.w);
+#else
+	v_layers = vec2(0.0, 0.0);
+#endif
+}
@@ -1,9 +1,16 @@
 $input a_position, a_normal, a_tangent, a_bitangent, a_texcoord0, a_weight, a_indices
-$output v_wpos, v_pos, v_wnormal, v_wtangent, v_wbitangent, v_texcoord0
+$output v_wpos, v_pos, v_wnormal, v_wtangent, v_wbitangent, v_texcoord0, v_layers
 
 #define BGFX_CONFIG_MAX_BONES 128
 #include "common.sh"
 
+// variants: TEXTURE_ARRAYS
+
+#ifdef TEXTURE_ARRAYS
+// the layers of the color and normal maps in their arrays
+uniform vec4 u_texture_layers;
+#endif
+
 void main()
 {
 	//u_model should already be in the right space
@@ -35,4 +42,9 @@ void main()
 
 	v_texcoord0 = a_texcoord0;
 
+#ifdef TEXTURE_ARRAYS
+	v_layers = u_texture_layers.xy;
+#else
+	v_layers = vec2(0.0, 0.0);
+#endif
 }
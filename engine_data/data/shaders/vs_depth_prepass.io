@@ -0,0 +1,3 @@
+vec3 a_position  : POSITION;
+
+vec3 v_wpos      : TEXCOORD2 = vec3(0.0, 0.0, 0.0);
\ No newline at end of file
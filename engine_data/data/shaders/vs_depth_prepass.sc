@@ -0,0 +1,13 @@
+$input a_position
+$output v_wpos
+
+#include "common.sh"
+
+void main()
+{
+	// the same math as vs_deferred_geom, the g-buffer is tested equal to it
+	vec3 wpos = mul(u_model[0], vec4(a_position, 1.0) ).xyz;
+	gl_Position = mul(u_viewProj, vec4(wpos, 1.0) );
+
+	v_wpos = wpos;
+}
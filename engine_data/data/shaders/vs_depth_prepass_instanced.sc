@@ -0,0 +1,19 @@
+$input a_position, i_data0, i_data1, i_data2, i_data3
+$output v_wpos
+
+#include "common.sh"
+
+void main()
+{
+	// the same math as vs_deferred_geom_instanced, the g-buffer is tested
+	// equal to it
+	vec3 c0 = i_data0.xyz;
+	vec3 c1 = i_data1.xyz;
+	vec3 c2 = i_data2.xyz;
+	vec3 c3 = i_data3.xyz;
+
+	vec3 wpos = c0 * a_position.x + c1 * a_position.y + c2 * a_position.z + c3;
+	gl_Position = mul(u_viewProj, vec4(wpos, 1.0) );
+
+	v_wpos = wpos;
+}
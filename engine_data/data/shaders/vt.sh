@@ -0,0 +1,39 @@
+#ifndef __VT_SH__
+#define __VT_SH__
+
+// the virtual textures of virtual_texturing, sampled through their page
+// table out of the page cache
+//     vt0 = pages across and down at the top level, page size, coarsest level
+//     vt1 = slot size, border, 1 / cache size, id of the texture / 255
+
+// the level the texels of uv are sampled from, from the top one
+float vtLevel(vec2 uv, vec4 vt0, float bias)
+{
+	vec2 texels = uv * vt0.xy * vt0.z;
+	vec2 dx = dFdx(texels);
+	vec2 dy = dFdy(texels);
+	float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8)) + bias;
+	return clamp(floor(lod), 0.0, vt0.w);
+}
+
+vec4 sampleVirtual(sampler2D cache, sampler2D table, vec2 uv, vec4 vt0, vec4 vt1)
+{
+	float level = vtLevel(uv, vt0, 0.0);
+	vec2 wrapped = fract(uv);
+
+	// the slot of the page or of the coarser one standing in for it
+	vec3 entry = floor(texture2DLod(table, wrapped, level).xyz * 255.0 + 0.5);
+	vec2 pages = vt0.xy / exp2(entry.z);
+	vec2 texel = entry.xy * vt1.x + vt1.y + fract(wrapped * pages) * vt0.z;
+	return texture2DLod(cache, texel * vt1.z, 0.0);
+}
+
+// the page, level and texture the feedback asks for
+vec4 encodeVirtualFeedback(vec2 uv, vec4 vt0, vec4 vt1, float bias)
+{
+	float level = vtLevel(uv, vt0, bias);
+	vec2 page = floor(fract(uv) * vt0.xy / exp2(level));
+	return vec4(page, level, 0.0) / 255.0 + vec4(0.0, 0.0, 0.0, vt1.w);
+}
+
+#endif // __VT_SH__